@@ -1,35 +1,20 @@
 TOP_PATH := $(call my-dir)
 
+# Build profile, both can be given on the ndk-build command line.
+# HAMLIB_RIG_BACKENDS lists the rig backends built into libhamlib, e.g.
+# HAMLIB_RIG_BACKENDS="icom kenwood" for a small library that starts fast;
+# dummy is always built.  HAMLIB_DEBUG_LEVEL is the highest rig_debug level
+# compiled in, 0 (none) .. 6 (cache), see configure --with-debug-level.
+HAMLIB_ALL_RIG_BACKENDS := adat alinco aor barrett codan dorji drake dummy \
+        elad flexradio gomspace icmarine icom jrc kachina kenwood kit lowe \
+        pcr prm80 racal rft rs skanti tapr tentec tuner uniden wj yaesu
+HAMLIB_RIG_BACKENDS ?= $(HAMLIB_ALL_RIG_BACKENDS)
+HAMLIB_DEBUG_LEVEL ?= 6
+
 include $(TOP_PATH)/src/Android.mk
 
-include $(TOP_PATH)/rigs/adat/Android.mk
-include $(TOP_PATH)/rigs/alinco/Android.mk
-include $(TOP_PATH)/rigs/aor/Android.mk
-include $(TOP_PATH)/rigs/barrett/Android.mk
-include $(TOP_PATH)/rigs/dorji/Android.mk
-include $(TOP_PATH)/rigs/drake/Android.mk
 include $(TOP_PATH)/rigs/dummy/Android.mk
-include $(TOP_PATH)/rigs/elad/Android.mk
-include $(TOP_PATH)/rigs/flexradio/Android.mk
-include $(TOP_PATH)/rigs/icmarine/Android.mk
-include $(TOP_PATH)/rigs/icom/Android.mk
-include $(TOP_PATH)/rigs/jrc/Android.mk
-include $(TOP_PATH)/rigs/kachina/Android.mk
-include $(TOP_PATH)/rigs/kenwood/Android.mk
-include $(TOP_PATH)/rigs/kit/Android.mk
-include $(TOP_PATH)/rigs/lowe/Android.mk
-include $(TOP_PATH)/rigs/pcr/Android.mk
-include $(TOP_PATH)/rigs/prm80/Android.mk
-include $(TOP_PATH)/rigs/racal/Android.mk
-include $(TOP_PATH)/rigs/rft/Android.mk
-include $(TOP_PATH)/rigs/rs/Android.mk
-include $(TOP_PATH)/rigs/skanti/Android.mk
-include $(TOP_PATH)/rigs/tapr/Android.mk
-include $(TOP_PATH)/rigs/tentec/Android.mk
-include $(TOP_PATH)/rigs/tuner/Android.mk
-include $(TOP_PATH)/rigs/uniden/Android.mk
-include $(TOP_PATH)/rigs/wj/Android.mk
-include $(TOP_PATH)/rigs/yaesu/Android.mk
+include $(foreach be,$(filter-out dummy,$(HAMLIB_RIG_BACKENDS)),$(TOP_PATH)/rigs/$(be)/Android.mk)
 include $(TOP_PATH)/rotators/amsat/Android.mk
 include $(TOP_PATH)/rotators/ars/Android.mk
 include $(TOP_PATH)/rotators/celestron/Android.mk
@@ -4,6 +4,8 @@ using Newtonsoft.Json.Serialization;
 using System;
 using System.Collections.Generic;
 using System.IO;
+using System.Net;
+using System.Net.Sockets;
 
 namespace HamlibMultiCast
 {
@@ -51,8 +53,48 @@ namespace HamlibMultiCast
     }
     class Program
     {
+        // multicast listen [addr [port]]: print the binary spectrum lines
+        // rigctld publishes with --set-conf=multicast_spectrum=Binary.  The
+        // receive buffer is reused and the lines are decoded in place.
+        static int Listen(string addr, int port)
+        {
+            var socket = new Socket(AddressFamily.InterNetwork, SocketType.Dgram, ProtocolType.Udp);
+            var buffer = new byte[65536];
+            var decoder = new SpectrumDecoder();
+
+            socket.SetSocketOption(SocketOptionLevel.Socket, SocketOptionName.ReuseAddress, true);
+            socket.Bind(new IPEndPoint(IPAddress.Any, port));
+            socket.SetSocketOption(SocketOptionLevel.IP, SocketOptionName.AddMembership,
+                new MulticastOption(IPAddress.Parse(addr)));
+
+            while (true)
+            {
+                int n = socket.Receive(buffer.AsSpan());
+
+                if (!decoder.TryDecode(new ReadOnlySpan<byte>(buffer, 0, n), out SpectrumLine line))
+                {
+                    continue;
+                }
+
+                int peak = 0;
+
+                foreach (byte b in line.Data)
+                {
+                    peak = Math.Max(peak, b);
+                }
+
+                Console.WriteLine($"scope {line.Id} seq {line.Seq} center {line.CenterFreq} span {line.Span} bins {line.Data.Length} peak {peak}");
+            }
+        }
+
         static int Main(string[] args)
         {
+            if (args.Length > 0 && args[0] == "listen")
+            {
+                return Listen(args.Length > 1 ? args[1] : "224.0.1.1",
+                    args.Length > 2 ? int.Parse(args[2]) : 4532);
+            }
+
             Console.WriteLine("HamlibMultiCast Test Json Deserialize");
             ITraceWriter traceWriter = new MemoryTraceWriter();
             try
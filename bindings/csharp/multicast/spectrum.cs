@@ -0,0 +1,153 @@
+using System;
+using System.Buffers.Binary;
+
+namespace HamlibMultiCast
+{
+    // One binary spectrum packet ("HLSP", see README.multicast) read in
+    // place.  Data is a slice of the received datagram for a raw line, or of
+    // the decoder's buffer for the scope for a delta line, so it is only
+    // valid until the next packet is received or decoded.
+    public readonly ref struct SpectrumLine
+    {
+        public readonly int Id;
+        public readonly int Mode;
+        public readonly uint Seq;
+        public readonly int MinLevel;
+        public readonly int MaxLevel;
+        public readonly double MinStrength;
+        public readonly double MaxStrength;
+        public readonly ulong CenterFreq;
+        public readonly ulong Span;
+        public readonly ulong LowFreq;
+        public readonly ulong HighFreq;
+        public readonly ReadOnlySpan<byte> Data;
+
+        public SpectrumLine(ReadOnlySpan<byte> header, ReadOnlySpan<byte> data)
+        {
+            Id = header[6];
+            Mode = header[7];
+            Seq = BinaryPrimitives.ReadUInt32BigEndian(header.Slice(8));
+            MinLevel = BinaryPrimitives.ReadInt16BigEndian(header.Slice(20));
+            MaxLevel = BinaryPrimitives.ReadInt16BigEndian(header.Slice(22));
+            MinStrength = BinaryPrimitives.ReadInt16BigEndian(header.Slice(24)) / 10.0;
+            MaxStrength = BinaryPrimitives.ReadInt16BigEndian(header.Slice(26)) / 10.0;
+            CenterFreq = BinaryPrimitives.ReadUInt64BigEndian(header.Slice(28));
+            Span = BinaryPrimitives.ReadUInt64BigEndian(header.Slice(36));
+            LowFreq = BinaryPrimitives.ReadUInt64BigEndian(header.Slice(44));
+            HighFreq = BinaryPrimitives.ReadUInt64BigEndian(header.Slice(52));
+            Data = data;
+        }
+    }
+
+    // Undoes the delta coding of the binary spectrum packets.  It keeps the
+    // last line of each scope in a buffer allocated on the scope's first
+    // line, so decoding does not allocate.
+    public class SpectrumDecoder
+    {
+        public const int HeaderSize = 60;
+
+        private readonly byte[][] last = new byte[256][];
+        private readonly int[] lastLength = new int[256];
+        private readonly uint[] lastSeq = new uint[256];
+        private readonly bool[] have = new bool[256];
+
+        public static bool IsSpectrum(ReadOnlySpan<byte> packet)
+        {
+            return packet.Length >= HeaderSize
+                && packet[0] == 'H' && packet[1] == 'L'
+                && packet[2] == 'S' && packet[3] == 'P'
+                && packet[4] == 1;
+        }
+
+        // False for anything that is not a spectrum packet, and for a delta
+        // line whose base was lost; the next raw line resynchronises.
+        public bool TryDecode(ReadOnlySpan<byte> packet, out SpectrumLine line)
+        {
+            line = default;
+
+            if (!IsSpectrum(packet))
+            {
+                return false;
+            }
+
+            int encoding = packet[5];
+            int id = packet[6];
+            uint seq = BinaryPrimitives.ReadUInt32BigEndian(packet.Slice(8));
+            uint baseSeq = BinaryPrimitives.ReadUInt32BigEndian(packet.Slice(12));
+            int dataLength = BinaryPrimitives.ReadUInt16BigEndian(packet.Slice(16));
+            int payloadLength = BinaryPrimitives.ReadUInt16BigEndian(packet.Slice(18));
+
+            if (packet.Length < HeaderSize + payloadLength)
+            {
+                return false;
+            }
+
+            ReadOnlySpan<byte> payload = packet.Slice(HeaderSize, payloadLength);
+
+            if (last[id] == null || last[id].Length < dataLength)
+            {
+                last[id] = new byte[Math.Max(dataLength, 2048)];
+                have[id] = false;
+            }
+
+            byte[] buf = last[id];
+
+            if (encoding == 0)
+            {
+                if (payloadLength != dataLength)
+                {
+                    return false;
+                }
+
+                payload.CopyTo(buf);
+                line = new SpectrumLine(packet, payload);
+            }
+            else if (encoding == 1)
+            {
+                if (!have[id] || lastSeq[id] != baseSeq || lastLength[id] != dataLength)
+                {
+                    have[id] = false;
+                    return false;
+                }
+
+                int i = 0;
+
+                for (int n = 0; n < payloadLength; n++)
+                {
+                    if (payload[n] == 0)
+                    {
+                        if (++n == payloadLength)
+                        {
+                            break;
+                        }
+
+                        i += payload[n];
+                    }
+                    else if (i < dataLength)
+                    {
+                        buf[i++] += payload[n];
+                    }
+                }
+
+                if (i != dataLength)
+                {
+                    // corrupt, wait for the next raw line
+                    have[id] = false;
+                    return false;
+                }
+
+                line = new SpectrumLine(packet, new ReadOnlySpan<byte>(buf, 0, dataLength));
+            }
+            else
+            {
+                return false;
+            }
+
+            have[id] = true;
+            lastSeq[id] = seq;
+            lastLength[id] = dataLength;
+
+            return true;
+        }
+    }
+}
@@ -1,6 +1,7 @@
 #!/usr/bin/env python3
 # -*- coding: utf-8 -*-
 import sys
+import array
 # Change this path to match your "make install" path
 sys.path.append('/usr/lib/python3.9/site-packages')
 
@@ -83,6 +84,8 @@ def StartUp():
     print("get_channel status:\t%s" % my_rig.error_status)
     print("VFO:\t\t\t%s, %s" % (Hamlib.rig_strvfo(chan.vfo), chan.freq))
     print("Attenuators:\t\t%s" % my_rig.caps.attenuator)
+    print("get_bulk:\t\t%s" % my_rig.get_bulk())
+    print("Memory channels:\t%s" % len(my_rig.get_chan_all_list()))
     # Can't seem to get get_vfo_info to work
     #(freq, width, mode, split) = my_rig.get_vfo_info(Hamlib.RIG_VFO_A,freq,width,mode,split)
     #print("Rig vfo_info:\t\tfreq=%s, mode=%s, width=%s, split=%s" % (freq, mode, width, split))
@@ -107,6 +110,15 @@ def StartUp():
     print("Distance:\t%.3f km, azimuth %.2f, long path:\t%.3f km" \
           % (dist, az, longpath))
 
+    # the same for many pairs at once, numpy float64 arrays work as well
+    dists = array.array('d', [0.0, 0.0])
+    azs = array.array('d', [0.0, 0.0])
+    Hamlib.qrb_batch_buffer(array.array('d', [lon1, lon2]),
+                            array.array('d', [lat1, lat2]),
+                            array.array('d', [lon2, lon1]),
+                            array.array('d', [lat2, lat1]), dists, azs)
+    print("Batch:\t\t%s km, azimuth %s" % (list(dists), list(azs)))
+
     # dec2dms expects values from 180 to -180
     # sw is 1 when deg is negative (west or south) as 0 cannot be signed
     err, deg1, mins1, sec1, sw1 = Hamlib.dec2dms(lon1)
@@ -0,0 +1,88 @@
+/*
+ * Hamlib rigcoro.h test: one loop drives the dummy rig, rotator and
+ * amplifier at once
+ */
+
+#include <iostream>
+#include <hamlib/rigcoro.h>
+
+static int failures;
+static int finished;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::cerr << __LINE__ << ": " #cond << std::endl; failures++; } } while (0)
+
+static hamlib::task tune(hamlib::AsyncRig &rig, hamlib::event_loop &loop)
+{
+    for (int i = 0; i < 5; i++)
+    {
+        EXPECT(co_await rig.setFreq(MHz(14) + i * 1000));
+        hamlib::result<freq_t> f = co_await rig.getFreq();
+        EXPECT(f && *f == MHz(14) + i * 1000);
+        co_await loop.sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EXPECT(co_await rig.setMode(RIG_MODE_CW, 500));
+    hamlib::result<hamlib::mode_width> m = co_await rig.getMode();
+    EXPECT(m && m->mode == RIG_MODE_CW);
+
+    finished++;
+}
+
+static hamlib::task track(hamlib::AsyncRotator &rot, hamlib::event_loop &loop)
+{
+    for (int az = 10; az <= 50; az += 10)
+    {
+        EXPECT(co_await rot.setPosition(az, 20));
+        co_await loop.sleep_for(std::chrono::milliseconds(10));
+    }
+
+    hamlib::result<hamlib::az_el> pos = co_await rot.getPosition();
+    EXPECT(pos);
+    EXPECT(co_await rot.stop());
+
+    finished++;
+}
+
+static hamlib::task follow(hamlib::AsyncAmplifier &amp)
+{
+    EXPECT(co_await amp.setFreq(MHz(7)));
+    hamlib::result<freq_t> f = co_await amp.getFreq();
+    EXPECT(f);
+
+    finished++;
+}
+
+int main()
+{
+    rig_set_debug(RIG_DEBUG_NONE);
+
+    hamlib::Rig rig(RIG_MODEL_DUMMY);
+    hamlib::Rotator rot(ROT_MODEL_DUMMY);
+    hamlib::Amplifier amp(AMP_MODEL_DUMMY);
+
+    EXPECT(rig.open());
+    EXPECT(rot.open());
+    EXPECT(amp.open());
+
+    {
+        hamlib::event_loop loop;
+        hamlib::AsyncRig arig(rig, loop);
+        hamlib::AsyncRotator arot(rot, loop);
+        hamlib::AsyncAmplifier aamp(amp, loop);
+
+        tune(arig, loop);
+        track(arot, loop);
+        follow(aamp);
+
+        loop.run();
+    }
+
+    EXPECT(finished == 3);
+
+    rig.close();
+    rot.close();
+    amp.close();
+
+    return failures ? 1 : 0;
+}
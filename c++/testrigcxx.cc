@@ -0,0 +1,61 @@
+/*
+ * Hamlib rigcxx.h test against the dummy rig
+ */
+
+#include <iostream>
+#include <hamlib/rigcxx.h>
+
+static int failures;
+
+#define EXPECT(cond) \
+    do { if (!(cond)) { std::cerr << __LINE__ << ": " #cond << std::endl; failures++; } } while (0)
+
+int main()
+{
+    rig_set_debug(RIG_DEBUG_NONE);
+
+    hamlib::Rig rig(RIG_MODEL_DUMMY);
+    EXPECT(rig.valid());
+
+    EXPECT(rig.setConf("rig_pathname", std::string("/dev/null")));
+    EXPECT(rig.setConf("no_such_conf", "1").error() == RIG_EINVAL);
+
+    // ownership moves, the moved from handle is empty
+    hamlib::Rig other(std::move(rig));
+    EXPECT(!rig.valid());
+    EXPECT(other.valid());
+    rig = std::move(other);
+    EXPECT(rig.valid());
+
+    EXPECT(rig.open());
+
+    EXPECT(rig.setFreq(MHz(14.074)));
+    hamlib::result<freq_t> f = rig.getFreq();
+    EXPECT(f && *f == MHz(14.074));
+
+    EXPECT(rig.setMode(RIG_MODE_USB, 2400));
+    hamlib::result<hamlib::mode_width> m = rig.getMode();
+    EXPECT(m && m->mode == RIG_MODE_USB && m->width == 2400);
+
+    // an error comes back as a value
+    hamlib::result<vfo_t> bad = hamlib::result<vfo_t>::failure(-RIG_ETIMEOUT);
+    EXPECT(!bad && bad.error() == RIG_ETIMEOUT);
+    EXPECT(bad.value_or(RIG_VFO_B) == RIG_VFO_B);
+
+    char val[64];
+    EXPECT(rig.getConf("rig_pathname", val, sizeof(val)));
+
+    std::future<hamlib::result<void> > s = rig.setFreqAsync(MHz(7.074));
+    std::future<hamlib::result<freq_t> > g = rig.getFreqAsync();
+    EXPECT(s.get());
+    f = g.get();
+    EXPECT(f && *f == MHz(7.074));
+
+    EXPECT(rig.close());
+
+    // the result of a call on an empty handle is an error too
+    hamlib::Rig none;
+    EXPECT(!none.getFreq());
+
+    return failures ? 1 : 0;
+}
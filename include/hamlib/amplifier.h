@@ -261,6 +261,32 @@ struct amp_caps
 };
 
 
+/**
+ * \brief Last readings from the amplifier.
+ *
+ * \struct amp_cache
+ *
+ * amp_get_level(), amp_get_freq() and amp_get_powerstat() answer from here
+ * while a reading is younger than the cache timeout.  With \a poll_ms set,
+ * a background thread keeps the readings fresh, one query every \a poll_ms.
+ */
+struct amp_cache
+{
+  int timeout_ms;                   /*!< How long readings stay fresh, 0 always asks the amplifier unless polled. */
+  int poll_ms;                      /*!< Milliseconds between two poller queries, 0 for no poller. */
+  freq_t freq;                      /*!< Last frequency read. */
+  struct timespec time_freq;        /*!< When freq was read. */
+  powerstat_t powerstat;            /*!< Last power status read. */
+  struct timespec time_powerstat;   /*!< When powerstat was read. */
+  value_t level[RIG_SETTING_MAX];   /*!< Last level values read, by rig_setting2idx(). */
+  struct timespec time_level[RIG_SETTING_MAX]; /*!< When each level was read. */
+  char fault[64];                   /*!< Copy of the last AMP_LEVEL_FAULT string. */
+  unsigned int freq_seq;            /*!< Bumped on every frequency read from the amplifier. */
+  unsigned int powerstat_seq;       /*!< Bumped on every power status read. */
+  unsigned int level_seq[RIG_SETTING_MAX]; /*!< Bumped on every read of each level. */
+};
+
+
 /**
  * \brief Amplifier state structure.
  *
@@ -292,6 +318,13 @@ struct amp_state
   gran_t level_gran[RIG_SETTING_MAX]; /*!< Level granularity. */
   gran_t parm_gran[RIG_SETTING_MAX];  /*!< Parameter granularity. */
   hamlib_port_t ampport;  /*!< Amplifier port (internal use). */
+  struct amp_cache cache; /*!< Level, frequency and power status cache. */
+  pthread_mutex_t lock;   /*!< One amplifier query or command at a time (internal use). */
+  pthread_mutex_t cache_lock; /*!< Guards cache updates (internal use). */
+  void *poller;           /*!< Background poller, see amplifier.c (internal use). */
+  void *follow;           /*!< Link to the rig whose band is followed, see band_follow.c (internal use). */
+  void *conf_index;       /*!< Hashed cfgparams, see conf_index.c (internal use). */
+  void *ext_index;        /*!< Hashed extlevels/extparms (internal use). */
 };
 
 
@@ -343,6 +376,10 @@ amp_set_powerstat HAMLIB_PARAMS((AMP *amp,
 extern HAMLIB_EXPORT(int)
 amp_get_powerstat HAMLIB_PARAMS((AMP *amp,
                                  powerstat_t *status));
+extern HAMLIB_EXPORT(int)
+amp_get_metrics HAMLIB_PARAMS((AMP *amp,
+                               char *buf,
+                               int len));
 
 
 /*
@@ -356,6 +393,12 @@ extern HAMLIB_EXPORT(int)
 amp_set_freq HAMLIB_PARAMS((AMP *amp,
                             freq_t freq));
 
+extern HAMLIB_EXPORT(int)
+amp_follow_rig HAMLIB_PARAMS((AMP *amp,
+                              RIG *rig,
+                              int debounce_ms,
+                              freq_t segment));
+
 extern HAMLIB_EXPORT(int)
 amp_reset HAMLIB_PARAMS((AMP *amp,
                          amp_reset_t reset));
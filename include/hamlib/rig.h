@@ -1732,6 +1732,79 @@ struct rig_spectrum_line
     unsigned char *spectrum_data; /*!< 8-bit spectrum data covering bandwidth of either the span_freq in center mode or from low edge to high edge in fixed mode. A higher value represents higher signal strength. */
 };
 
+/**
+ * \brief What rig_sweep_start() steps through
+ *
+ * Every pass is reported as one RIG_SPECTRUM_MODE_FIXED rig_spectrum_line
+ * of one byte per step, so (stop - start) / step + 1 must not exceed
+ * HAMLIB_MAX_SPECTRUM_DATA.
+ */
+struct rig_sweep_cfg {
+    freq_t start;   /*!< First frequency in Hz */
+    freq_t stop;    /*!< Last frequency in Hz, swept when it falls on a step */
+    freq_t step;    /*!< Step size in Hz */
+    int dwell_ms;   /*!< Time from tuning a step to reading its level */
+    int id;         /*!< rig_spectrum_line id the passes are reported under */
+    int passes;     /*!< Times through the range, 0 until stopped */
+};
+
+/**
+ * \brief Selection bits for rig_get_bulk()
+ */
+typedef unsigned int rig_bulk_t;
+
+#define RIG_BULK_NONE       0
+#define RIG_BULK_FREQ_A     (1<<0)  /*!< freq of VFOA/Main */
+#define RIG_BULK_FREQ_B     (1<<1)  /*!< freq of VFOB/Sub */
+#define RIG_BULK_MODE_A     (1<<2)  /*!< mode and width of VFOA/Main */
+#define RIG_BULK_MODE_B     (1<<3)  /*!< mode and width of VFOB/Sub */
+#define RIG_BULK_PTT        (1<<4)  /*!< PTT status */
+#define RIG_BULK_SPLIT      (1<<5)  /*!< split status and split TX VFO */
+#define RIG_BULK_STRENGTH   (1<<6)  /*!< RIG_LEVEL_STRENGTH */
+#define RIG_BULK_RFPOWER    (1<<7)  /*!< RIG_LEVEL_RFPOWER */
+#define RIG_BULK_SWR        (1<<8)  /*!< RIG_LEVEL_SWR */
+#define RIG_BULK_ALL        0x1ff
+
+/**
+ * \brief One setting of a rig_set_bulk() call
+ */
+struct rig_setting {
+    int type;           /*!< RIG_SETTING_LEVEL or RIG_SETTING_FUNC */
+    setting_t setting;  /*!< The RIG_LEVEL_* or RIG_FUNC_* to set */
+    value_t val;        /*!< The level value, or the func status in val.i */
+    int retval;         /*!< Result of this setting, filled in by rig_set_bulk() */
+};
+
+#define RIG_SETTING_LEVEL   0
+#define RIG_SETTING_FUNC    1
+
+//! @cond Doxygen_Suppress
+struct rig_clone_layout;
+//! @endcond
+
+/**
+ * \brief Result of a rig_get_bulk() query
+ *
+ * Set \a mask to the RIG_BULK_* values wanted before calling.  On return
+ * \a valid tells which of the fields below were actually retrieved.
+ */
+struct rig_bulk {
+    rig_bulk_t mask;    /*!< What the caller asked for */
+    rig_bulk_t valid;   /*!< What was retrieved, subset of mask */
+    freq_t freqA;       /*!< VFOA/Main frequency */
+    freq_t freqB;       /*!< VFOB/Sub frequency */
+    rmode_t modeA;      /*!< VFOA/Main mode */
+    pbwidth_t widthA;   /*!< VFOA/Main passband */
+    rmode_t modeB;      /*!< VFOB/Sub mode */
+    pbwidth_t widthB;   /*!< VFOB/Sub passband */
+    ptt_t ptt;          /*!< PTT status */
+    split_t split;      /*!< Split status */
+    vfo_t split_vfo;    /*!< Split TX VFO */
+    value_t strength;   /*!< S-meter, dB relative to S9 */
+    value_t rfpower;    /*!< RF power 0.0-1.0 */
+    value_t swr;        /*!< SWR */
+};
+
 /**
  * \brief Rig data structure.
  *
@@ -2051,6 +2124,12 @@ struct rig_caps {
     int (*password)(RIG *rig, const char *key1); /*< Send encrypted password if rigctld is secured with -A/--password */
     int (*set_lock_mode)(RIG *rig, int mode);
     int (*get_lock_mode)(RIG *rig, int *mode);
+    int (*get_bulk)(RIG *rig, struct rig_bulk *bulk); /*< Fill as much of bulk->mask as one exchange allows, setting bulk->valid */
+    int (*clone_read)(RIG *rig, unsigned char *image, size_t len); /*< Read the whole memory image in clone mode */
+    int (*clone_write)(RIG *rig, const unsigned char *image, size_t len); /*< Write a whole memory image in clone mode */
+    const struct rig_clone_layout *clone_layout; /*< Where the channels are in that image, \sa src/clone.h */
+    int (*get_sweep)(RIG *rig, vfo_t vfo, const struct rig_sweep_cfg *cfg, unsigned char *data, size_t count); /*< Measure one pass of cfg, a byte per step scaled as for rig_sweep_start() */
+    int (*set_bulk)(RIG *rig, vfo_t vfo, struct rig_setting *settings, int count); /*< Apply the settings whose retval is still -RIG_ENIMPL in as few exchanges as possible, setting their retval */
 };
 //! @endcond
 
@@ -2149,6 +2228,8 @@ enum rig_function_e {
     RIG_FUNCTION_IS_ASYNC_FRAME,
     RIG_FUNCTION_PROCESS_ASYNC_FRAME,
     RIG_FUNCTION_GET_CONF2,
+    RIG_FUNCTION_GET_BULK,
+    RIG_FUNCTION_SET_BULK,
 };
 
 /**
@@ -2262,6 +2343,7 @@ typedef struct hamlib_port {
         struct {
             int on_value;   /*!< GPIO: 1 == normal, GPION: 0 == inverted */
             int value;      /*!< Toggle PTT ON or OFF */
+            int lines;      /*!< Lines requested from a gpiochip, 0 for sysfs */
         } gpio;             /*!< GPIO attributes */
     } parm;                 /*!< Port parameter union */
     int client_port;      /*!< client socket port for tcp connection */
@@ -2336,6 +2418,7 @@ typedef struct hamlib_port_deprecated {
         struct {
             int on_value;   /*!< GPIO: 1 == normal, GPION: 0 == inverted */
             int value;      /*!< Toggle PTT ON or OFF */
+            int lines;      /*!< Lines requested from a gpiochip, 0 for sysfs */
         } gpio;             /*!< GPIO attributes */
     } parm;                 /*!< Port parameter union */
     int client_port;      /*!< client socket port for tcp connection */
@@ -2361,7 +2444,9 @@ typedef enum {
     HAMLIB_CACHE_MODE,
     HAMLIB_CACHE_PTT,
     HAMLIB_CACHE_SPLIT,
-    HAMLIB_CACHE_WIDTH
+    HAMLIB_CACHE_WIDTH,
+    HAMLIB_CACHE_LEVEL,
+    HAMLIB_CACHE_FUNC
 } hamlib_cache_t;
 
 typedef enum {
@@ -2448,6 +2533,180 @@ struct rig_cache {
     int satmode; // if rig is in satellite mode
 };
 
+/**
+ * \brief Adaptive cache TTL state for one cache slot -- see cache.c
+ */
+struct rig_cache_adapt {
+    int ttl_ms;         // current TTL, between cache.timeout_ms and cache_adaptive_max_ms
+    uint64_t value;     // value seen at the last refresh
+    double seen_ms;     // when the value seen at the last refresh was stored
+};
+
+/**
+ * \brief How the generic layer reaches a VFO that may not be the current one
+ */
+typedef enum {
+    RIG_VFO_PLAN_DIRECT = 0,    /*!< the VFO asked for is the current one */
+    RIG_VFO_PLAN_TARGETED,      /*!< the backend addresses the VFO itself */
+    RIG_VFO_PLAN_SWAP,          /*!< set_vfo, the operation, set_vfo back */
+} rig_vfo_plan_t;
+
+/**
+ * \brief Classes the per-RIG API lock is handed out in, most urgent first
+ *
+ * A thread waiting for the lock goes ahead of every waiter of a later
+ * class.  See RIG_LOCK() in misc.h.
+ */
+typedef enum {
+    RIG_PRIO_SAFETY = 0,    /*!< PTT off, stop morse */
+    RIG_PRIO_SET,           /*!< setters and other operator actions */
+    RIG_PRIO_GET,           /*!< getters */
+    RIG_PRIO_BACKGROUND,    /*!< meters and the poll routine */
+} rig_prio_t;
+
+//! @cond Doxygen_Suppress
+#define RIG_PRIO_N (RIG_PRIO_BACKGROUND + 1)
+//! @endcond
+
+/**
+ * \brief CAT transaction statistics -- see rig_get_stats()
+ */
+struct rig_stats {
+    uint64_t transactions;      // backend transactions completed
+    uint64_t errors;            // transactions that ended in an error
+    uint64_t timeouts;          // read timeouts on the rig port
+    uint64_t retries;           // transaction retries
+    uint64_t bytes_out;         // bytes written to the rig port
+    uint64_t bytes_in;          // bytes read from the rig port
+    uint64_t latency_total_us;  // sum of transaction latencies
+    uint64_t latency_max_us;    // slowest transaction
+    uint64_t latency_hist[24];  // bucket n counts latencies of 2^n..2^(n+1)-1 us
+    uint64_t cache_hit[HAMLIB_CACHE_FUNC + 1];  // indexed by hamlib_cache_t
+    uint64_t cache_miss[HAMLIB_CACHE_FUNC + 1]; // indexed by hamlib_cache_t
+    uint64_t vfo_plan[RIG_VFO_PLAN_SWAP + 1];   // indexed by rig_vfo_plan_t
+    uint64_t lock_calls[RIG_PRIO_N];    // API lock acquisitions, indexed by rig_prio_t
+    uint64_t lock_wait_total_us[RIG_PRIO_N]; // time spent waiting for the API lock
+    uint64_t lock_wait_max_us[RIG_PRIO_N];   // longest wait for the API lock
+    uint64_t lock_preemptions;  // calls that let a PTT off through mid-call
+};
+
+/**
+ * \brief Operations that can be queued with rig_submit()
+ */
+typedef enum {
+    RIG_REQ_SET_FREQ = 1,   /*!< rig_set_freq(vfo, freq) */
+    RIG_REQ_GET_FREQ,       /*!< rig_get_freq(vfo, &freq) */
+    RIG_REQ_SET_MODE,       /*!< rig_set_mode(vfo, mode, width) */
+    RIG_REQ_GET_MODE,       /*!< rig_get_mode(vfo, &mode, &width) */
+    RIG_REQ_SET_VFO,        /*!< rig_set_vfo(vfo) */
+    RIG_REQ_GET_VFO,        /*!< rig_get_vfo(&vfo) */
+    RIG_REQ_SET_PTT,        /*!< rig_set_ptt(vfo, ptt) */
+    RIG_REQ_GET_PTT,        /*!< rig_get_ptt(vfo, &ptt) */
+    RIG_REQ_SET_SPLIT_VFO,  /*!< rig_set_split_vfo(vfo, split, tx_vfo) */
+    RIG_REQ_GET_SPLIT_VFO,  /*!< rig_get_split_vfo(vfo, &split, &tx_vfo) */
+    RIG_REQ_SET_SPLIT_FREQ, /*!< rig_set_split_freq(vfo, freq) */
+    RIG_REQ_SET_LEVEL,      /*!< rig_set_level(vfo, setting, val) */
+    RIG_REQ_GET_LEVEL,      /*!< rig_get_level(vfo, setting, &val) */
+    RIG_REQ_SET_FUNC,       /*!< rig_set_func(vfo, setting, status) */
+    RIG_REQ_GET_FUNC,       /*!< rig_get_func(vfo, setting, &status) */
+    RIG_REQ_VERIFY_PTT,     /*!< rig_get_ptt(vfo, &ptt) read from the rig, not the cache */
+} rig_request_t;
+
+struct rig_request;
+
+/**
+ * \brief Completion callback for rig_submit()
+ *
+ * Called once per request, normally from the queue's I/O thread.
+ * req->retcode holds the result and the get fields hold the values read.
+ */
+typedef void (*rig_request_cb_t)(RIG *rig, struct rig_request *req,
+                                 rig_ptr_t arg);
+
+/**
+ * \brief Queued rig operation -- see rig_submit()
+ *
+ * The caller owns the storage, which must stay valid until the completion
+ * callback has run.  Only the fields used by \a type need to be filled in.
+ */
+struct rig_request {
+    rig_request_t type;     /*!< operation */
+    vfo_t vfo;              /*!< target VFO, RIG_VFO_CURR is fine */
+    freq_t freq;            /*!< SET/GET_FREQ, SET_SPLIT_FREQ */
+    rmode_t mode;           /*!< SET/GET_MODE */
+    pbwidth_t width;        /*!< SET/GET_MODE */
+    ptt_t ptt;              /*!< SET/GET_PTT */
+    split_t split;          /*!< SET/GET_SPLIT_VFO */
+    vfo_t tx_vfo;           /*!< SET/GET_SPLIT_VFO */
+    setting_t setting;      /*!< SET/GET_LEVEL, SET/GET_FUNC */
+    value_t val;            /*!< SET/GET_LEVEL */
+    int status;             /*!< SET/GET_FUNC */
+    int retcode;            /*!< result, filled in before the callback */
+    int coalesced;          /*!< set when a newer request made this one redundant */
+    /* internal use by the queue */
+    rig_request_cb_t cb;
+    rig_ptr_t cb_arg;
+    struct rig_request *next;
+};
+
+
+/**
+ * \brief Range rate of a satellite at one time -- see rig_add_doppler()
+ */
+struct rig_doppler_sample {
+    double time;        /*!< Seconds since the Unix epoch. */
+    double range_rate;  /*!< How fast the satellite moves away, in m/s, negative while it approaches. */
+};
+
+/**
+ * \brief Range rate of the satellite at \a time, in m/s -- see rig_set_doppler()
+ */
+typedef double (*rig_doppler_cb_t)(RIG *rig, double time, rig_ptr_t arg);
+
+/**
+ * \brief Doppler correction of a satellite pass -- see rig_set_doppler()
+ *
+ * Zeroed fields take the defaults.
+ */
+struct rig_doppler {
+    freq_t downlink;            /*!< Nominal downlink frequency, 0 to leave the receiver alone. */
+    freq_t uplink;              /*!< Nominal uplink frequency, 0 to leave the transmitter alone. */
+    vfo_t downlink_vfo;         /*!< VFO receiving the downlink, RIG_VFO_NONE for Main or the current VFO. */
+    vfo_t uplink_vfo;           /*!< VFO sending the uplink, RIG_VFO_NONE for Sub or RIG_VFO_TX, the split TX VFO. */
+    int period_ms;              /*!< Time between corrections, 0 for 200 ms. */
+    shortfreq_t min_step;       /*!< Smallest change sent to a VFO, 0 for its tuning step. */
+    rig_doppler_cb_t range_rate_cb; /*!< Range rate at a given time, for instance from a TLE, NULL to use rig_add_doppler() samples. */
+    rig_ptr_t arg;              /*!< Passed to \a range_rate_cb. */
+};
+
+
+/**
+ * \brief What an ALE or selcall message of the rig reports
+ *
+ * \sa rig_set_ale_callback(), rig_get_ale_event()
+ */
+enum rig_ale_event_e {
+    RIG_ALE_CALL = 1,   /*!< An ALE call from \a from to \a to arrived. */
+    RIG_ALE_LINK,       /*!< The ALE link with \a from is established. */
+    RIG_ALE_UNLINK,     /*!< The ALE link with \a from ended. */
+    RIG_ALE_CHANNEL,    /*!< The rig went to \a channel, or to \a freq. */
+    RIG_ALE_SELCALL,    /*!< A selective call from \a from to \a to arrived. */
+    RIG_ALE_EVENT_MAX
+};
+
+/**
+ * \brief One ALE or selcall message, as far as the rig told
+ */
+struct rig_ale_event {
+    enum rig_ale_event_e type;  /*!< What happened. */
+    int64_t ms;                 /*!< CLOCK_REALTIME milliseconds it was received. */
+    char from[32];              /*!< Address of the calling station, "" if not given. */
+    char to[32];                /*!< Address called, "" if not given. */
+    int channel;                /*!< Channel number, -1 if not given. */
+    freq_t freq;                /*!< Frequency, 0 if not given. */
+    char text[64];              /*!< The message as the rig sent it. */
+};
+
 
 /**
  * \brief Rig state containing live data and customized fields.
@@ -2575,6 +2834,74 @@ struct rig_state {
     int use_cached_ptt;  /*<! flag instructing rig_get_ptt to use cached values when asyncio is in use */
     int depth; /*<! a depth counter to use for debug indentation and such */
     int lock_mode; /*<! flag that prevents mode changes if ~= 0 -- see set/get_lock_mode */
+    volatile unsigned int cache_seqlock; /*<! cache sequence counter, odd while the cache is being written -- see cache.c */
+    int cache_adaptive_max_ms; /*<! ceiling for adaptive cache TTL in ms, 0 keeps the fixed cache.timeout_ms */
+    struct rig_cache_adapt cache_adapt[8]; /*<! adaptive TTL per cache slot -- see cache.c */
+    struct rig_stats stats; /*<! CAT transaction statistics -- see stats.c */
+    void *submit_queue; /*<! async request queue -- see rigqueue.c */
+    int coalesce_ms; /*<! set_freq/set_mode coalescing window in ms, 0 disables -- see rigqueue.c */
+    int multicast_spectrum; /*<! multicast spectrum lines as 0 JSON, 1 binary, 2 both, 3 compressed binary -- see snapshot_data.c */
+    int spectrum_lines; /*<! spectrum lines combined into one, 0 or 1 for none -- see spectrum_proc.c */
+    int spectrum_reduce; /*<! 0 average, 1 peak when combining spectrum lines or bins */
+    int spectrum_width; /*<! maximum bins per spectrum line, 0 for no limit */
+    int spectrum_db; /*<! rescale spectrum data to 1 dB per step */
+    void *spectrum_proc; /*<! spectrum processing state -- see spectrum_proc.c */
+    int spectrum_history_lines; /*<! spectrum lines kept per scope, 0 for none */
+    void *spectrum_history; /*<! recent spectrum lines -- see spectrum_history.c */
+    struct timespec time_push; /*<! last update pushed by the rig -- see rig_cache_push() */
+    int push_timeout_ms; /*<! how long pushed cache entries stay fresh, 0 for ever */
+    int multicast_batch_ms; /*<! state updates within this window go out as one multicast packet */
+    int multicast_keyframe; /*<! multicast state packets per full snapshot, the rest are deltas; 0 or 1 for full only */
+    int cache_level_timeout_ms; /*<! how long rig_get_level answers from the level cache, 0 disables */
+    int cache_func_timeout_ms; /*<! how long rig_get_func answers from the func cache, 0 disables */
+    void *cache_settings; /*<! level and func cache -- see cache.c */
+    int paced_writer; /*<! write_delay paced output is sent by a thread of its own -- see port_writer_start() */
+    int open_cache; /*<! replay facts discovered by earlier opens from disk -- see rigfacts.c */
+    void *rig_facts; /*<! facts loaded for this model and port -- see rigfacts.c */
+    int open_fast; /*<! rig_open leaves the freq/mode warm-up to the first getters */
+    void *dcd_watch; /*<! interrupt driven DCD state -- see dcd_watch.c */
+    int cw_key; /*<! line rig_send_morse keys itself, KEYER_NONE leaves CW to the backend -- see keyer.c */
+    int cw_wpm; /*<! speed of the CW keyed by Hamlib */
+    int cw_ptt_lead_ms; /*<! PTT to first CW element delay */
+    int cw_ptt_tail_ms; /*<! PTT hang time after the last CW element */
+    void *keyer; /*<! CW keying thread -- see keyer.c */
+    int ptt_fast; /*<! rig_set_ptt goes through rig_set_ptt_fast */
+    void *amp_follow; /*<! amplifier following this rig's band -- see band_follow.c */
+    int serial_low_latency; /*<! ask for ASYNC_LOW_LATENCY and a 1 ms USB latency timer on the rig port */
+    int serial_latency_timer; /*<! USB serial latency timer of the open rig port in ms, -1 if it has none */
+    int serial_async_low_latency; /*<! ASYNC_LOW_LATENCY is set on the open rig port */
+    void *capture; /*<! CAT traffic capture and replay -- see capture.c */
+    void *doppler; /*<! Doppler correction thread -- see doppler.c */
+    int targetable_vfo; /*<! caps->targetable_vfo plus what the backend found at open -- see vfo_plan.c */
+    void *conf_index;   /*<! Hashed cfgparams for rig_confparam_lookup, see conf_index.c (internal use) */
+    void *ext_index;    /*<! Hashed extlevels/extfuncs/extparms for rig_ext_lookup (internal use) */
+    void *cal;          /*<! Compiled meter calibration tables -- see cal.c (internal use) */
+    void *caps_index;   /*<! Range, filter and channel list index -- see caps_index.c (internal use) */
+    setting_t poll_levels; /*<! levels the poll routine reads, the poll_levels conf -- see event.c */
+    void *shm_cache;    /*<! Shared memory copy of the cache, the shm_cache conf -- see shmcache.c (internal use) */
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t mutex_state; /*<! guards the per-RIG API lock fields below -- see RIG_LOCK() in misc.h */
+    pthread_cond_t cond_state;   /*<! signalled when the API lock is given back */
+    pthread_t lock_owner;        /*<! thread holding the API lock while lock_depth > 0 */
+#endif
+    int lock_depth;              /*<! API lock nesting of lock_owner, 0 while free */
+    rig_prio_t lock_prio;        /*<! class lock_owner took the API lock at */
+    int lock_waiting[RIG_PRIO_N]; /*<! threads waiting for the API lock, by class */
+    unsigned int swr_pending;    /*<! cache refreshes queued by rig_get_freq_swr() and friends -- see cache.c */
+    void *rig_info;     /*<! rig_get_rig_info() text as last built -- see riginfo.c (internal use) */
+    int morse_queue;    /*<! rig_send_morse queues the message and returns, the morse_queue conf */
+    void *morse_queue_thread; /*<! CW queue handing messages to the rig -- see morse_queue.c (internal use) */
+    struct timespec cache_reset; /*<! cache entries stamped up to this time are stale -- see rig_cache_reset() */
+    void *journal;      /*<! File the cache changes are appended to, the journal_file conf -- see journal.c (internal use) */
+    struct rig_ale_event ale_last[RIG_ALE_EVENT_MAX]; /*<! Last ALE message of each type -- see rig_get_ale_event() */
+    int timeout_adaptive; /*<! rig port reads wait for what the rig's round trip times suggest -- see rto.c */
+    int timeout_floor;  /*<! shortest adaptive timeout in ms */
+    void *rto;          /*<! round trip estimates of the rig port -- see rto.c (internal use) */
+    int chan_cache;     /*<! read-only memory channel queries answered from the last read, the chan_cache conf */
+    void *chancache;    /*<! memory channels as last read -- see chancache.c (internal use) */
+    void *multicast_subscriber_priv_data; /*<! what a multicast publisher sent -- see network.c (internal use) */
+    void *rig_follow;   /*<! frequency follow link this rig is in -- see rig_follow.c (internal use) */
+    int async_shared;   /*<! async data read by the one shared reader thread, the async_shared conf */
 };
 
 //! @cond Doxygen_Suppress
@@ -2596,6 +2923,11 @@ typedef int (*pltune_cb_t)(RIG *,
 typedef int (*spectrum_cb_t)(RIG *,
                              struct rig_spectrum_line *,
                              rig_ptr_t);
+typedef int (*error_cb_t)(RIG *, int, const char *, rig_ptr_t);
+typedef int (*status_cb_t)(RIG *, vfo_t, const char *, rig_ptr_t);
+typedef int (*morse_cb_t)(RIG *, vfo_t, const char *, int, int, rig_ptr_t);
+typedef int (*ale_cb_t)(RIG *, const struct rig_ale_event *, rig_ptr_t);
+typedef int (*dtmf_cb_t)(RIG *, vfo_t, const char *, rig_ptr_t);
 
 //! @endcond
 
@@ -2614,7 +2946,7 @@ typedef int (*spectrum_cb_t)(RIG *,
  * really appropriate in a GUI.
  *
  * \sa rig_set_freq_callback(), rig_set_mode_callback(), rig_set_vfo_callback(),
- *     rig_set_ptt_callback(), rig_set_dcd_callback()
+ *     rig_set_ptt_callback(), rig_set_dcd_callback(), rig_set_dtmf_callback()
  */
 struct rig_callbacks {
     freq_cb_t freq_event;   /*!< Frequency change event */
@@ -2631,6 +2963,16 @@ struct rig_callbacks {
     rig_ptr_t pltune_arg;   /*!< Pipeline tuning argument */
     spectrum_cb_t spectrum_event; /*!< Spectrum line reception event */
     rig_ptr_t spectrum_arg; /*!< Spectrum line reception argument */
+    error_cb_t error_event; /*!< Late error of an earlier command */
+    rig_ptr_t error_arg;    /*!< Late error argument */
+    status_cb_t status_event; /*!< Receiver status text change event */
+    rig_ptr_t status_arg;   /*!< Status text change argument */
+    morse_cb_t morse_event; /*!< CW queue progress event */
+    rig_ptr_t morse_arg;    /*!< CW queue progress argument */
+    ale_cb_t ale_event;     /*!< ALE and selcall message event */
+    rig_ptr_t ale_arg;      /*!< ALE message argument */
+    dtmf_cb_t dtmf_event;   /*!< DTMF digits received event */
+    rig_ptr_t dtmf_arg;     /*!< DTMF digits argument */
     /* etc.. */
 };
 
@@ -2650,6 +2992,30 @@ struct s_rig {
     struct rig_callbacks callbacks; /*!< registered event callbacks */
 };
 
+/**
+ * \brief Parts of a rig handle returned by rig_data_pointer()
+ */
+typedef enum rig_ptrx_e {
+    RIG_PTRX_NONE = 0,
+    RIG_PTRX_RIGPORT,   /*!< hamlib_port_t of the rig */
+    RIG_PTRX_PTTPORT,   /*!< hamlib_port_t of PTT */
+    RIG_PTRX_DCDPORT,   /*!< hamlib_port_t of DCD */
+    RIG_PTRX_CACHE,     /*!< struct rig_cache */
+    RIG_PTRX_STATE,     /*!< struct rig_state */
+    RIG_PTRX_CALLBACKS, /*!< struct rig_callbacks */
+    RIG_PTRX_MAXIMUM
+} rig_ptrx_t;
+
+extern HAMLIB_EXPORT(void *) rig_data_pointer(RIG *rig, rig_ptrx_t idx);
+
+//! @cond Doxygen_Suppress
+#define HAMLIB_RIGPORT(r) ((hamlib_port_t *)rig_data_pointer((r), RIG_PTRX_RIGPORT))
+#define HAMLIB_PTTPORT(r) ((hamlib_port_t *)rig_data_pointer((r), RIG_PTRX_PTTPORT))
+#define HAMLIB_DCDPORT(r) ((hamlib_port_t *)rig_data_pointer((r), RIG_PTRX_DCDPORT))
+#define HAMLIB_CACHE(r) ((struct rig_cache *)rig_data_pointer((r), RIG_PTRX_CACHE))
+#define HAMLIB_STATE(r) ((struct rig_state *)rig_data_pointer((r), RIG_PTRX_STATE))
+//! @endcond
+
 
 
 /* --------------- API function prototypes -----------------*/
@@ -2680,6 +3046,10 @@ rig_get_freq HAMLIB_PARAMS((RIG *rig,
                             vfo_t vfo,
                             freq_t *freq));
 
+extern HAMLIB_EXPORT(int)
+rig_get_bulk HAMLIB_PARAMS((RIG *rig,
+                            struct rig_bulk *bulk));
+
 extern HAMLIB_EXPORT(int)
 rig_set_mode HAMLIB_PARAMS((RIG *rig,
                             vfo_t vfo,
@@ -2729,6 +3099,15 @@ rig_get_ptt HAMLIB_PARAMS((RIG *rig,
                            vfo_t vfo,
                            ptt_t *ptt));
 
+extern HAMLIB_EXPORT(int)
+rig_set_ptt_fast HAMLIB_PARAMS((RIG *rig,
+                                ptt_t ptt));
+
+extern HAMLIB_EXPORT(int)
+rig_set_gpio_lines HAMLIB_PARAMS((RIG *rig,
+                                  unsigned int mask,
+                                  unsigned int bits));
+
 extern HAMLIB_EXPORT(int)
 rig_get_dcd HAMLIB_PARAMS((RIG *rig,
                            vfo_t vfo,
@@ -3054,6 +3433,12 @@ rig_get_func HAMLIB_PARAMS((RIG *rig,
                             setting_t func,
                             int *status));
 
+extern HAMLIB_EXPORT(int)
+rig_set_bulk HAMLIB_PARAMS((RIG *rig,
+                            vfo_t vfo,
+                            struct rig_setting *settings,
+                            int count));
+
 extern HAMLIB_EXPORT(int)
 rig_send_dtmf HAMLIB_PARAMS((RIG *rig,
                              vfo_t vfo,
@@ -3115,6 +3500,71 @@ extern HAMLIB_EXPORT(scan_t)
 rig_has_scan HAMLIB_PARAMS((RIG *rig,
                             scan_t scan));
 
+/**
+ * \brief Signal found by rig_sw_scan()
+ */
+struct rig_scan_hit {
+    int index;          /*!< Position of the entry in the scan list */
+    int channel_num;    /*!< Memory channel, -1 when scanning frequencies */
+    freq_t freq;        /*!< Frequency, 0 when scanning channels */
+    int active;         /*!< 1 when the signal shows up, 0 once it is gone */
+    int strength;       /*!< Last STRENGTH read, 0 when detecting with DCD */
+    int duration_ms;    /*!< Time spent on the signal, when active is 0 */
+};
+
+/**
+ * \brief rig_sw_scan() callback, anything but RIG_OK stops the scan
+ */
+typedef int (*rig_scan_hit_cb_t)(RIG *, const struct rig_scan_hit *, rig_ptr_t);
+
+/**
+ * \brief What rig_sw_scan() goes through and how long it stays
+ */
+struct rig_scan_cfg {
+    const freq_t *freqs;    /*!< Frequencies to scan, or NULL for channels */
+    const int *channels;    /*!< Memory channels to scan when freqs is NULL */
+    int count;              /*!< Number of entries in the list */
+    int settle_ms;          /*!< Wait after tuning before looking for a signal */
+    int hang_ms;            /*!< Keep listening this long after a signal drops */
+    int max_hold_ms;        /*!< Leave a busy entry after this long, 0 to wait it out */
+    int threshold;          /*!< STRENGTH in dB for busy, on rigs without DCD */
+    int passes;             /*!< Times through the list, 0 until stopped */
+};
+
+/**
+ * \brief Background scan handle, see rig_sw_scan_start()
+ */
+typedef struct rig_sw_scan rig_sw_scan_t;
+
+extern HAMLIB_EXPORT(int)
+rig_sw_scan HAMLIB_PARAMS((RIG *rig,
+                           vfo_t vfo,
+                           const struct rig_scan_cfg *cfg,
+                           rig_scan_hit_cb_t cb,
+                           rig_ptr_t arg));
+extern HAMLIB_EXPORT(int)
+rig_sw_scan_start HAMLIB_PARAMS((RIG *rig,
+                                 vfo_t vfo,
+                                 const struct rig_scan_cfg *cfg,
+                                 rig_scan_hit_cb_t cb,
+                                 rig_ptr_t arg,
+                                 rig_sw_scan_t **scan));
+extern HAMLIB_EXPORT(int)
+rig_sw_scan_stop HAMLIB_PARAMS((rig_sw_scan_t *scan));
+
+/**
+ * \brief Background sweep handle, see rig_sweep_start()
+ */
+typedef struct rig_sweep rig_sweep_t;
+
+extern HAMLIB_EXPORT(int)
+rig_sweep_start HAMLIB_PARAMS((RIG *rig,
+                               vfo_t vfo,
+                               const struct rig_sweep_cfg *cfg,
+                               rig_sweep_t **sweep));
+extern HAMLIB_EXPORT(int)
+rig_sweep_stop HAMLIB_PARAMS((rig_sweep_t *sweep));
+
 extern HAMLIB_EXPORT(int)
 rig_set_channel HAMLIB_PARAMS((RIG *rig,
                                vfo_t vfo,
@@ -3124,11 +3574,25 @@ rig_get_channel HAMLIB_PARAMS((RIG *rig,
                                vfo_t vfo,
                                channel_t *chan, int read_only));
 
+extern HAMLIB_EXPORT(int)
+rig_get_channel_by_freq HAMLIB_PARAMS((RIG *rig,
+                                       vfo_t vfo,
+                                       freq_t freq,
+                                       channel_t *chan));
+extern HAMLIB_EXPORT(int)
+rig_chan_cache_invalidate HAMLIB_PARAMS((RIG *rig, int ch));
+
 extern HAMLIB_EXPORT(int)
 rig_set_chan_all HAMLIB_PARAMS((RIG *rig,
                                 vfo_t vfo,
                                 const channel_t chans[]));
 extern HAMLIB_EXPORT(int)
+rig_set_chan_all_delta HAMLIB_PARAMS((RIG *rig,
+                                      vfo_t vfo,
+                                      const channel_t chans[],
+                                      const channel_t current[],
+                                      int *nwritten));
+extern HAMLIB_EXPORT(int)
 rig_get_chan_all HAMLIB_PARAMS((RIG *rig,
                                 vfo_t vfo,
                                 channel_t chans[]));
@@ -3144,6 +3608,47 @@ rig_get_chan_all_cb HAMLIB_PARAMS((RIG *rig,
                                    chan_cb_t chan_cb,
                                    rig_ptr_t));
 
+extern HAMLIB_EXPORT(size_t)
+rig_clone_size HAMLIB_PARAMS((RIG *rig));
+extern HAMLIB_EXPORT(int)
+rig_clone_read HAMLIB_PARAMS((RIG *rig,
+                              unsigned char *image,
+                              size_t len));
+extern HAMLIB_EXPORT(int)
+rig_clone_write HAMLIB_PARAMS((RIG *rig,
+                               const unsigned char *image,
+                               size_t len));
+
+/**
+ * \brief Packed set of memory channels, see rig_chan_set_new()
+ */
+typedef struct rig_chan_set rig_chan_set_t;
+
+extern HAMLIB_EXPORT(rig_chan_set_t *)
+rig_chan_set_new HAMLIB_PARAMS((int capacity));
+extern HAMLIB_EXPORT(void)
+rig_chan_set_free HAMLIB_PARAMS((rig_chan_set_t *set));
+extern HAMLIB_EXPORT(int)
+rig_chan_set_count HAMLIB_PARAMS((const rig_chan_set_t *set));
+extern HAMLIB_EXPORT(int)
+rig_chan_set_add HAMLIB_PARAMS((rig_chan_set_t *set,
+                                const channel_t *chan));
+extern HAMLIB_EXPORT(int)
+rig_chan_set_get HAMLIB_PARAMS((const rig_chan_set_t *set,
+                                int idx,
+                                channel_t *chan));
+extern HAMLIB_EXPORT(freq_t)
+rig_chan_set_freq HAMLIB_PARAMS((const rig_chan_set_t *set,
+                                 int idx));
+extern HAMLIB_EXPORT(int)
+rig_get_chan_set HAMLIB_PARAMS((RIG *rig,
+                                vfo_t vfo,
+                                rig_chan_set_t *set));
+extern HAMLIB_EXPORT(int)
+rig_set_chan_set HAMLIB_PARAMS((RIG *rig,
+                                vfo_t vfo,
+                                const rig_chan_set_t *set));
+
 extern HAMLIB_EXPORT(int)
 rig_set_mem_all_cb HAMLIB_PARAMS((RIG *rig,
                                   vfo_t vfo,
@@ -3218,6 +3723,39 @@ rig_set_spectrum_callback HAMLIB_PARAMS((RIG *,
                                          spectrum_cb_t,
                                          rig_ptr_t));
 
+extern HAMLIB_EXPORT(int)
+rig_set_error_callback HAMLIB_PARAMS((RIG *,
+                                      error_cb_t,
+                                      rig_ptr_t));
+
+extern HAMLIB_EXPORT(int)
+rig_set_status_callback HAMLIB_PARAMS((RIG *,
+                                       status_cb_t,
+                                       rig_ptr_t));
+
+extern HAMLIB_EXPORT(int)
+rig_set_morse_callback HAMLIB_PARAMS((RIG *,
+                                      morse_cb_t,
+                                      rig_ptr_t));
+
+extern HAMLIB_EXPORT(int)
+rig_set_ale_callback HAMLIB_PARAMS((RIG *,
+                                    ale_cb_t,
+                                    rig_ptr_t));
+
+extern HAMLIB_EXPORT(int)
+rig_set_dtmf_callback HAMLIB_PARAMS((RIG *,
+                                     dtmf_cb_t,
+                                     rig_ptr_t));
+
+extern HAMLIB_EXPORT(int)
+rig_get_ale_event HAMLIB_PARAMS((RIG *rig,
+                                 enum rig_ale_event_e type,
+                                 struct rig_ale_event *ev));
+
+extern HAMLIB_EXPORT(const char *)
+rig_strale HAMLIB_PARAMS((enum rig_ale_event_e type));
+
 extern HAMLIB_EXPORT(int)
 rig_set_twiddle HAMLIB_PARAMS((RIG *rig,
                                  int seconds));
@@ -3230,6 +3768,15 @@ extern HAMLIB_EXPORT(int)
 rig_set_uplink HAMLIB_PARAMS((RIG *rig,
                                  int val));
 
+extern HAMLIB_EXPORT(int)
+rig_set_doppler HAMLIB_PARAMS((RIG *rig,
+                               const struct rig_doppler *conf));
+
+extern HAMLIB_EXPORT(int)
+rig_add_doppler HAMLIB_PARAMS((RIG *rig,
+                               const struct rig_doppler_sample *samples,
+                               int n));
+
 extern HAMLIB_EXPORT(const char *)
 rig_get_info HAMLIB_PARAMS((RIG *rig));
 
@@ -3271,6 +3818,15 @@ rig_set_debug HAMLIB_PARAMS((enum rig_debug_level_e debug_level));
 extern HAMLIB_EXPORT(void)
 rig_set_debug_time_stamp HAMLIB_PARAMS((int flag));
 
+extern HAMLIB_EXPORT(int)
+rig_set_debug_async HAMLIB_PARAMS((int flag));
+
+extern HAMLIB_EXPORT(int)
+rig_set_thread_affinity HAMLIB_PARAMS((const char *cpus));
+
+extern HAMLIB_EXPORT(int)
+rig_set_thread_sched HAMLIB_PARAMS((const char *policy, int priority));
+
 #define rig_set_debug_level(level) rig_set_debug(level)
 
 extern HAMLIB_EXPORT(int)
@@ -3283,10 +3839,14 @@ extern HAMLIB_EXPORT_VAR(char) debugmsgsave[DEBUGMSGSAVE_SIZE];  // last debug m
 extern HAMLIB_EXPORT_VAR(char) debugmsgsave2[DEBUGMSGSAVE_SIZE];  // last-1 debug msg
 // debugmsgsave3 is deprecated
 extern HAMLIB_EXPORT_VAR(char) debugmsgsave3[DEBUGMSGSAVE_SIZE];  // last-2 debug msg
+// rig_debug calls above this level are compiled out, arguments and all -- see --with-debug-level
+#ifndef HAMLIB_DEBUG_LEVEL_MAX
+#define HAMLIB_DEBUG_LEVEL_MAX RIG_DEBUG_CACHE
+#endif
 #ifndef __cplusplus
 #ifdef __GNUC__
 // doing the debug macro with a dummy sprintf allows gcc to check the format string
-#define rig_debug(debug_level,fmt,...) do { snprintf(debugmsgsave2,sizeof(debugmsgsave2),fmt,__VA_ARGS__);rig_debug(debug_level,fmt,##__VA_ARGS__); add2debugmsgsave(debugmsgsave2); } while(0)
+#define rig_debug(debug_level,fmt,...) do { if ((debug_level) <= HAMLIB_DEBUG_LEVEL_MAX) { snprintf(debugmsgsave2,sizeof(debugmsgsave2),fmt,__VA_ARGS__);rig_debug(debug_level,fmt,##__VA_ARGS__); add2debugmsgsave(debugmsgsave2); } } while(0)
 #endif
 #endif
 
@@ -3331,6 +3891,13 @@ rig_check_backend HAMLIB_PARAMS((rig_model_t rig_model));
 extern HAMLIB_EXPORT(int)
 rig_load_all_backends HAMLIB_PARAMS((void));
 
+extern HAMLIB_EXPORT(int)
+rig_caps_to_json HAMLIB_PARAMS((const struct rig_caps *caps, char *buf,
+                                int len));
+
+extern HAMLIB_EXPORT(int)
+rig_caps_export_json HAMLIB_PARAMS((FILE *fout, int threads));
+
 typedef int (*rig_probe_func_t)(const hamlib_port_t *, rig_model_t, rig_ptr_t);
 
 extern HAMLIB_EXPORT(int)
@@ -3341,6 +3908,54 @@ rig_probe_all HAMLIB_PARAMS((hamlib_port_t *p,
 extern HAMLIB_EXPORT(rig_model_t)
 rig_probe HAMLIB_PARAMS((hamlib_port_t *p));
 
+extern HAMLIB_EXPORT(int)
+rig_probe_all_ports HAMLIB_PARAMS((hamlib_port_t ports[],
+                                   int count,
+                                   rig_probe_func_t,
+                                   rig_ptr_t));
+
+/**
+ * \brief A USB serial port and the rig its descriptors identify
+ *
+ * \sa rig_usb_identify(), rig_usb_identify_port()
+ */
+struct rig_usb_device
+{
+    char path[HAMLIB_FILPATHLEN];   /*!< Device to open, e.g. /dev/ttyUSB0 */
+    unsigned short vid;             /*!< USB vendor id */
+    unsigned short pid;             /*!< USB product id */
+    int interface;                  /*!< USB interface of the port, -1 if unknown */
+    char manufacturer[64];          /*!< Manufacturer string */
+    char product[64];               /*!< Product string */
+    char serial[64];                /*!< Serial number string */
+    rig_model_t model;              /*!< Rig model, RIG_MODEL_NONE when it has to be probed */
+    int serial_rate;                /*!< Rate to open it at, 0 for the backend's default */
+    int cat;                        /*!< 0 for the data port of a rig whose CAT port is another */
+};
+
+typedef int (*rig_usb_device_func_t)(const struct rig_usb_device *, rig_ptr_t);
+
+extern HAMLIB_EXPORT(int)
+rig_usb_identify HAMLIB_PARAMS((rig_usb_device_func_t cfunc,
+                                rig_ptr_t data));
+
+extern HAMLIB_EXPORT(int)
+rig_usb_identify_port HAMLIB_PARAMS((const char *pathname,
+                                     struct rig_usb_device *dev));
+
+/** \brief rig_follow_rig() maps the master's frequency to offset - freq */
+#define RIG_FOLLOW_INVERT   (1<<0)
+/** \brief rig_follow_rig() also sets the master from the slave */
+#define RIG_FOLLOW_BOTH     (1<<1)
+
+extern HAMLIB_EXPORT(int)
+rig_follow_rig HAMLIB_PARAMS((RIG *slave,
+                              RIG *master,
+                              vfo_t vfo,
+                              freq_t offset,
+                              int coalesce_ms,
+                              int flags));
+
 
 /* Misc calls */
 extern HAMLIB_EXPORT(const char *) rig_strrmode(rmode_t mode);
@@ -3382,7 +3997,28 @@ extern HAMLIB_EXPORT(int) rig_set_cache_timeout_ms(RIG *rig, hamlib_cache_t sele
 extern HAMLIB_EXPORT(int) rig_set_vfo_opt(RIG *rig, int status);
 extern HAMLIB_EXPORT(int) rig_get_vfo_info(RIG *rig, vfo_t vfo, freq_t *freq, rmode_t *mode, pbwidth_t *width, split_t *split, int *satmode);
 extern HAMLIB_EXPORT(int) rig_get_rig_info(RIG *rig, char *response, int max_response_len);
+extern HAMLIB_EXPORT(int) rig_wait_rig_info(RIG *rig, char *response, int max_response_len, unsigned int *generation, int timeout_ms);
 extern HAMLIB_EXPORT(int) rig_get_cache(RIG *rig, vfo_t vfo, freq_t *freq, int * cache_ms_freq, rmode_t *mode, int *cache_ms_mode, pbwidth_t *width, int *cache_ms_width);
+extern HAMLIB_EXPORT(int) rig_get_freq_swr(RIG *rig, vfo_t vfo, freq_t *freq, int *age_ms, int *stale);
+extern HAMLIB_EXPORT(int) rig_get_mode_swr(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width, int *age_ms, int *stale);
+extern HAMLIB_EXPORT(int) rig_get_ptt_swr(RIG *rig, vfo_t vfo, ptt_t *ptt, int *age_ms, int *stale);
+
+extern HAMLIB_EXPORT(void) rig_set_deadline(int ms);
+extern HAMLIB_EXPORT(int) rig_get_deadline(void);
+extern HAMLIB_EXPORT(int) rig_deadline_stale(void);
+
+extern HAMLIB_EXPORT(int) rig_get_stats(RIG *rig, struct rig_stats *stats);
+extern HAMLIB_EXPORT(int) rig_reset_stats(RIG *rig);
+extern HAMLIB_EXPORT(int) rig_get_stats_info(RIG *rig, char *response, int max_response_len);
+extern HAMLIB_EXPORT(int) rig_get_metrics(RIG *rig, char *buf, int len);
+
+typedef int (*spectrum_history_cb_t)(RIG *, struct rig_spectrum_line *, int age_ms, rig_ptr_t);
+extern HAMLIB_EXPORT(int) rig_get_spectrum_history(RIG *rig, int id, int max_age_ms, spectrum_history_cb_t cb, rig_ptr_t arg);
+extern HAMLIB_EXPORT(struct rig_spectrum_line *) rig_spectrum_line_hold(const struct rig_spectrum_line *line);
+extern HAMLIB_EXPORT(void) rig_spectrum_line_release(struct rig_spectrum_line *line);
+
+extern HAMLIB_EXPORT(int) rig_submit(RIG *rig, struct rig_request *req, rig_request_cb_t cb, rig_ptr_t arg);
+extern HAMLIB_EXPORT(int) rig_submit_wait(RIG *rig);
 
 extern HAMLIB_EXPORT(int) rig_set_clock(RIG *rig, int year, int month, int day, int hour, int min, int sec, double msec, int utc_offset);
 extern HAMLIB_EXPORT(int) rig_get_clock(RIG *rig, int *year, int *month, int *day, int *hour, int *min, int *sec, double *msec, int *utc_offset);
@@ -3396,6 +4032,7 @@ extern HAMLIB_EXPORT(int) rig_password(RIG *rig, const char *key1);
 extern HAMLIB_EXPORT(void) rig_password_generate_secret(char *pass,
         char result[HAMLIB_SECRET_LENGTH + 1]);
 extern HAMLIB_EXPORT(int) rig_send_raw(RIG *rig, const unsigned char* send, int send_len, unsigned char* reply, int reply_len, unsigned char *term);
+extern HAMLIB_EXPORT(int) rig_transaction_batch(RIG *rig, const char *cmds[], int ncmds, char *replies[], int reply_len, char term);
 
 extern HAMLIB_EXPORT(int)
 longlat2locator HAMLIB_PARAMS((double longitude,
@@ -0,0 +1,147 @@
+/*
+ *  Hamlib Interface - rig state journal
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _RIG_JOURNAL_H
+#define _RIG_JOURNAL_H 1
+
+#include <stdint.h>
+#include <hamlib/rig.h>
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file rig_journal.h
+ * \brief History of frequency, mode, PTT and the like kept in a file.
+ *
+ * With the "journal_file" conf set to a path, the process owning the
+ * #RIG appends a record to that file for every change the rig cache sees:
+ * a new frequency, mode or passband on any VFO, PTT, split, the current
+ * VFO, and DCD as the rig reports it.  Nothing is asked of the rig for
+ * it, the records come from what was read or set anyway.
+ *
+ * The file is a #rig_journal_header followed by \a capacity fixed size
+ * #rig_journal_record slots used as a ring: record number n (counting
+ * from 0 since the file was created) goes to slot n % capacity, so the
+ * oldest records are overwritten once the ring is full.  The file is
+ * memory mapped, both by the owner and by readers, and survives the
+ * owner: the next owner with the same "journal_size" carries on where
+ * the last one stopped.
+ *
+ * Record n is complete when its \a seq is (uint32_t)(n + 1); \a seq is
+ * 0 while the slot is being written.  A reader copies a record, then
+ * checks \a seq did not change.  rig_get_journal() and rig_journal_read()
+ * do exactly that; programs that map the file themselves must do the
+ * same.
+ *
+ * Frequency, mode and passband are journalled for VFO A, B and C and
+ * Sub A, B and C, the way the cache keeps them: Main is recorded as VFO
+ * A and Sub as VFO B.  All stamps are CLOCK_REALTIME milliseconds.
+ */
+
+__BEGIN_DECLS
+
+/** \brief "HLJR", the first four bytes of a journal file */
+#define RIG_JOURNAL_MAGIC 0x524a4c48u
+
+/** \brief Layout version, bumped on any change to the records or header */
+#define RIG_JOURNAL_VERSION 1
+
+/**
+ * \brief What a record holds, rig_journal_record.field
+ */
+enum rig_journal_field_e
+{
+    RIG_JOURNAL_FREQ = 1,   /*!< Frequency of \a vfo, Hz in value.f. */
+    RIG_JOURNAL_MODE,       /*!< #rmode_t of \a vfo in value.i. */
+    RIG_JOURNAL_WIDTH,      /*!< Passband of \a vfo, Hz in value.i. */
+    RIG_JOURNAL_PTT,        /*!< #ptt_t in value.i. */
+    RIG_JOURNAL_SPLIT,      /*!< #split_t in value.i, the transmit VFO in \a vfo. */
+    RIG_JOURNAL_VFO,        /*!< Current VFO, the #vfo_t in \a vfo and value.i. */
+    RIG_JOURNAL_DCD         /*!< #dcd_t of \a vfo in value.i. */
+};
+
+/**
+ * \brief One change, 32 bytes
+ */
+struct rig_journal_record
+{
+    int64_t ms;         /*!< Stamp of the change. */
+    uint32_t seq;       /*!< Record number + 1, 0 while being written. */
+    uint32_t vfo;       /*!< #vfo_t the change applies to. */
+    uint32_t field;     /*!< #rig_journal_field_e. */
+    uint32_t reserved;  /*!< 0. */
+    union
+    {
+        double f;       /*!< Frequencies. */
+        int64_t i;      /*!< Everything else. */
+    } value;            /*!< The new value. */
+};
+
+/**
+ * \brief Start of the file, 64 bytes
+ */
+struct rig_journal_header
+{
+    uint32_t magic;         /*!< #RIG_JOURNAL_MAGIC once the file is set up. */
+    uint32_t version;       /*!< #RIG_JOURNAL_VERSION. */
+    uint32_t header_size;   /*!< sizeof(struct rig_journal_header), where slot 0 starts. */
+    uint32_t record_size;   /*!< sizeof(struct rig_journal_record). */
+    uint32_t capacity;      /*!< Number of slots. */
+    uint32_t pid;           /*!< Process id of the last owner. */
+    uint32_t rig_model;     /*!< #rig_model_t of the last owner's rig. */
+    uint32_t reserved0;     /*!< 0. */
+    uint64_t head;          /*!< Records written since the file was created. */
+    int64_t created_ms;     /*!< Stamp of the file's creation. */
+    uint32_t reserved[4];   /*!< 0. */
+};
+
+/**
+ * \typedef typedef struct rig_journal rig_journal_t
+ * \brief Reader handle, returned by rig_journal_attach().
+ */
+typedef struct rig_journal rig_journal_t;
+
+extern HAMLIB_EXPORT(int)
+rig_get_journal HAMLIB_PARAMS((RIG *rig, int64_t since_ms, int64_t until_ms,
+                               struct rig_journal_record *recs, int max));
+
+extern HAMLIB_EXPORT(rig_journal_t *)
+rig_journal_attach HAMLIB_PARAMS((const char *path));
+
+extern HAMLIB_EXPORT(int)
+rig_journal_read HAMLIB_PARAMS((rig_journal_t *journal, int64_t since_ms,
+                                int64_t until_ms,
+                                struct rig_journal_record *recs, int max));
+
+extern HAMLIB_EXPORT(void)
+rig_journal_detach HAMLIB_PARAMS((rig_journal_t *journal));
+
+extern HAMLIB_EXPORT(const char *)
+rig_strjournal HAMLIB_PARAMS((enum rig_journal_field_e field));
+
+__END_DECLS
+
+#endif /* _RIG_JOURNAL_H */
+
+/** @} */
@@ -0,0 +1,160 @@
+/*
+ *  Hamlib Interface - shared memory rig state
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _RIG_SHM_H
+#define _RIG_SHM_H 1
+
+#include <stdint.h>
+#include <hamlib/rig.h>
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file rig_shm.h
+ * \brief Rig state published in shared memory for local processes.
+ *
+ * With the "shm_cache" conf set to a name, the process owning the #RIG
+ * (rigctld, typically) keeps a copy of the rig cache and the latest meter
+ * readings in a shared memory segment of that name: POSIX shm_open() on
+ * Unix, a named file mapping ("Local\" prefixed) on Windows.  Every cache
+ * update lands in the segment, so readers on the same machine see what
+ * the owner would answer from its cache without a socket round trip.
+ *
+ * The segment is one #rig_shm_state, written under a sequence counter:
+ * \a seq is odd while an update is in progress.  A reader copies the
+ * struct, then checks that \a seq was even and did not change, and tries
+ * again otherwise.  rig_shm_read() does exactly that; programs that map
+ * the segment themselves must do the same.
+ *
+ * All stamps are CLOCK_REALTIME milliseconds, 0 for never.  An entry
+ * younger than the owner's \a cache_timeout_ms (or
+ * \a cache_level_timeout_ms for meters) is what the owner would have
+ * answered from its cache right now.
+ */
+
+__BEGIN_DECLS
+
+/** \brief "HLSH", the first four bytes of a segment */
+#define RIG_SHM_MAGIC 0x48534c48u
+
+/** \brief Layout version, bumped on any change to #rig_shm_state */
+#define RIG_SHM_VERSION 1
+
+/**
+ * \brief Index into rig_shm_state.vfos, one per rig cache slot
+ */
+enum rig_shm_slot_e
+{
+    RIG_SHM_CURR = 0,   /*!< The current VFO. */
+    RIG_SHM_OTHER,      /*!< The other VFO. */
+    RIG_SHM_MAIN_A,     /*!< VFO A, Main and Main A. */
+    RIG_SHM_MAIN_B,     /*!< VFO B, Sub and Main B. */
+    RIG_SHM_MAIN_C,     /*!< VFO C and Main C. */
+    RIG_SHM_SUB_A,      /*!< Sub A. */
+    RIG_SHM_SUB_B,      /*!< Sub B. */
+    RIG_SHM_SUB_C,      /*!< Sub C. */
+    RIG_SHM_MEM,        /*!< The memory channel last used. */
+    RIG_SHM_VFOS        /*!< Number of slots. */
+};
+
+/** \brief Number of rig_shm_state.meters entries */
+#define RIG_SHM_METERS 10
+
+/**
+ * \brief Frequency, mode and passband of one VFO
+ */
+struct rig_shm_vfo
+{
+    double freq;        /*!< Hz. */
+    uint64_t mode;      /*!< #rmode_t. */
+    int64_t width;      /*!< Passband, Hz. */
+    int64_t freq_ms;    /*!< Stamp of \a freq. */
+    int64_t mode_ms;    /*!< Stamp of \a mode. */
+    int64_t width_ms;   /*!< Stamp of \a width. */
+};
+
+/**
+ * \brief One meter reading of the current VFO
+ */
+struct rig_shm_meter
+{
+    uint64_t level;     /*!< RIG_LEVEL_xxx, 0 for an unused entry. */
+    double value;       /*!< Integer levels (STRENGTH, RAWSTR) as a whole number. */
+    int64_t ms;         /*!< Stamp of \a value, 0 while never read. */
+};
+
+/**
+ * \brief The whole segment
+ */
+struct rig_shm_state
+{
+    uint32_t magic;             /*!< #RIG_SHM_MAGIC once the segment is set up. */
+    uint32_t version;           /*!< #RIG_SHM_VERSION. */
+    uint32_t size;              /*!< sizeof(struct rig_shm_state) of the owner. */
+    uint32_t seq;               /*!< Sequence counter, odd during an update. */
+    uint32_t pid;               /*!< Process id of the owner. */
+    uint32_t rig_model;         /*!< #rig_model_t of the rig. */
+    int32_t cache_timeout_ms;   /*!< The owner's cache timeout. */
+    int32_t cache_level_timeout_ms; /*!< The owner's level cache timeout. */
+    uint64_t updates;           /*!< Updates since the segment was created. */
+    int64_t update_ms;          /*!< Stamp of the last update. */
+    uint32_t vfo;               /*!< Current #vfo_t, as rig_get_vfo() answers. */
+    uint32_t curr_vfo;          /*!< #vfo_t the owner takes RIG_VFO_CURR for. */
+    int64_t vfo_ms;             /*!< Stamp of \a vfo. */
+    int32_t ptt;                /*!< #ptt_t. */
+    int32_t split;              /*!< #split_t. */
+    uint32_t split_vfo;         /*!< Transmit #vfo_t while split. */
+    int32_t satmode;            /*!< Satellite mode. */
+    int64_t ptt_ms;             /*!< Stamp of \a ptt. */
+    int64_t split_ms;           /*!< Stamp of \a split and \a split_vfo. */
+    struct rig_shm_vfo vfos[RIG_SHM_VFOS];      /*!< By #rig_shm_slot_e. */
+    struct rig_shm_meter meters[RIG_SHM_METERS]; /*!< STRENGTH, SWR, ALC... */
+};
+
+/**
+ * \typedef typedef struct rig_shm rig_shm_t
+ * \brief Reader handle, returned by rig_shm_attach().
+ */
+typedef struct rig_shm rig_shm_t;
+
+extern HAMLIB_EXPORT(rig_shm_t *)
+rig_shm_attach HAMLIB_PARAMS((const char *name));
+
+extern HAMLIB_EXPORT(int)
+rig_shm_read HAMLIB_PARAMS((rig_shm_t *shm, struct rig_shm_state *state));
+
+extern HAMLIB_EXPORT(void)
+rig_shm_detach HAMLIB_PARAMS((rig_shm_t *shm));
+
+extern HAMLIB_EXPORT(int)
+rig_shm_age HAMLIB_PARAMS((int64_t stamp_ms));
+
+extern HAMLIB_EXPORT(int)
+rig_shm_slot HAMLIB_PARAMS((const struct rig_shm_state *state, vfo_t vfo));
+
+__END_DECLS
+
+#endif /* _RIG_SHM_H */
+
+/** @} */
@@ -0,0 +1,642 @@
+/*
+ *  Hamlib C++ bindings - C++20 coroutines
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _RIGCORO_H
+#define _RIGCORO_H 1
+
+/*
+ * Awaitable rig, rotator and amplifier operations for the rigcxx.h
+ * classes.  Coroutines are resumed by a hamlib::event_loop on the thread
+ * that calls its run(), so one thread can drive any number of devices,
+ * each one's serial round trips overlapping the others':
+ *
+ *   hamlib::task doppler(hamlib::AsyncRig &rig, hamlib::AsyncRotator &rot,
+ *                        hamlib::event_loop &loop)
+ *   {
+ *       for (;;)
+ *       {
+ *           co_await rig.setFreq(uplink());
+ *           co_await rot.setPosition(az(), el());
+ *           co_await loop.sleep_for(std::chrono::milliseconds(100));
+ *       }
+ *   }
+ *
+ *   doppler(rig, rot, loop);    // runs up to its first co_await
+ *   loop.run();
+ *
+ * Rig operations go through the rig's rig_submit() queue.  Rotators and
+ * amplifiers have no queue in the library, so each AsyncRotator and
+ * AsyncAmplifier keeps a thread of its own that makes the blocking call.
+ * An operation allocates nothing beyond the coroutine frame it is
+ * awaited from.  While a device is driven here no other thread should
+ * call it directly.
+ *
+ * Only available when built as C++20 with <coroutine>.
+ */
+
+#include <hamlib/rigcxx.h>
+
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<coroutine>)
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
+namespace hamlib
+{
+
+//! @cond Doxygen_Suppress
+namespace detail
+{
+
+// an operation waiting to be resumed, linked into the loop's ready list
+struct op_node
+{
+    op_node *next = nullptr;
+    std::coroutine_handle<> h;
+};
+
+} // namespace detail
+//! @endcond
+
+
+/**
+ * \brief A detached coroutine
+ *
+ * Starts running when called and frees itself when it returns.
+ */
+struct task
+{
+    struct promise_type
+    {
+        task get_return_object() noexcept { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+};
+
+
+/**
+ * \brief Resumes the coroutines waiting on operations and timers
+ */
+class event_loop
+{
+public:
+    typedef std::chrono::steady_clock clock;
+
+    event_loop() = default;
+    event_loop(const event_loop &) = delete;
+    event_loop &operator=(const event_loop &) = delete;
+
+    /**
+     * Resume coroutines as their operations complete, until none is
+     * outstanding and no timer is set, or until stop().
+     */
+    void run()
+    {
+        std::unique_lock<std::mutex> lk(lock_);
+
+        stop_ = false;
+
+        while (!stop_)
+        {
+            clock::time_point now = clock::now();
+
+            while (timers_ && static_cast<timer *>(timers_)->when <= now)
+            {
+                detail::op_node *t = timers_;
+                timers_ = t->next;
+                push(t);
+            }
+
+            if (head_)
+            {
+                detail::op_node *n = head_;
+
+                head_ = n->next;
+
+                if (!head_) { tail_ = nullptr; }
+
+                lk.unlock();
+                n->h.resume();
+                lk.lock();
+                continue;
+            }
+
+            if (!timers_ && in_flight_ == 0) { break; }
+
+            if (timers_) { cv_.wait_until(lk, static_cast<timer *>(timers_)->when); }
+            else { cv_.wait(lk); }
+        }
+    }
+
+    /** Make run() return, from any thread */
+    void stop()
+    {
+        std::lock_guard<std::mutex> lk(lock_);
+        stop_ = true;
+        cv_.notify_one();
+    }
+
+    //! @cond Doxygen_Suppress
+    class timer : public detail::op_node
+    {
+    public:
+        timer(event_loop &loop, clock::time_point when) noexcept
+            : when(when), loop_(loop) {}
+
+        bool await_ready() const noexcept { return when <= clock::now(); }
+
+        void await_suspend(std::coroutine_handle<> h)
+        {
+            this->h = h;
+            loop_.add_timer(this);
+        }
+
+        void await_resume() const noexcept {}
+
+        clock::time_point when;
+
+    private:
+        event_loop &loop_;
+    };
+    //! @endcond
+
+    timer sleep_until(clock::time_point when) noexcept { return timer(*this, when); }
+
+    timer sleep_for(clock::duration d) noexcept { return timer(*this, clock::now() + d); }
+
+    //! @cond Doxygen_Suppress
+    // an operation was started for a coroutine about to suspend
+    void begin()
+    {
+        std::lock_guard<std::mutex> lk(lock_);
+        in_flight_++;
+    }
+
+    // the operation is done; n is not touched once this returns
+    void post(detail::op_node *n)
+    {
+        std::lock_guard<std::mutex> lk(lock_);
+        push(n);
+        in_flight_--;
+        cv_.notify_one();
+    }
+    //! @endcond
+
+private:
+    // called with lock_ held
+    void push(detail::op_node *n)
+    {
+        n->next = nullptr;
+
+        if (tail_) { tail_->next = n; }
+        else { head_ = n; }
+
+        tail_ = n;
+    }
+
+    void add_timer(timer *t)
+    {
+        std::lock_guard<std::mutex> lk(lock_);
+        detail::op_node **p = &timers_;
+
+        while (*p && static_cast<timer *>(*p)->when <= t->when) { p = &(*p)->next; }
+
+        t->next = *p;
+        *p = t;
+        cv_.notify_one();
+    }
+
+    std::mutex lock_;
+    std::condition_variable cv_;
+    detail::op_node *head_ = nullptr;
+    detail::op_node *tail_ = nullptr;
+    detail::op_node *timers_ = nullptr;  // timers, soonest first
+    int in_flight_ = 0;
+    bool stop_ = false;
+};
+
+
+//! @cond Doxygen_Suppress
+namespace detail
+{
+
+// a rig_request in the coroutine frame, completed by the rig's queue
+template <class T>
+class rig_awaiter : public op_node
+{
+public:
+    rig_awaiter(event_loop &loop, RIG *rig, const struct rig_request &req,
+                T (*get)(const struct rig_request &)) noexcept
+        : loop_(loop), rig_(rig), req_(req), get_(get) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        int ret;
+
+        this->h = h;
+        loop_.begin();
+
+        ret = rig_submit(rig_, &req_, done, this);
+
+        if (ret != RIG_OK)
+        {
+            req_.retcode = ret;
+            loop_.post(this);
+        }
+    }
+
+    result<T> await_resume() noexcept
+    {
+        if constexpr (std::is_void_v<T>)
+        {
+            return result<void>::from(req_.retcode);
+        }
+        else
+        {
+            return req_.retcode == RIG_OK ? result<T>(get_(req_))
+                   : result<T>::failure(req_.retcode);
+        }
+    }
+
+private:
+    static void done(RIG *, struct rig_request *, rig_ptr_t arg)
+    {
+        rig_awaiter *a = static_cast<rig_awaiter *>(arg);
+        a->loop_.post(a);
+    }
+
+    event_loop &loop_;
+    RIG *rig_;
+    struct rig_request req_;
+    T (*get_)(const struct rig_request &);
+};
+
+
+// a blocking call handed to a worker thread
+struct job : op_node
+{
+    void (*run)(job *);
+};
+
+// one thread making the calls of one device, in order
+class worker
+{
+public:
+    worker() : thread_([this] { loop(); }) {}
+
+    ~worker()
+    {
+        {
+            std::lock_guard<std::mutex> lk(lock_);
+            quit_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    worker(const worker &) = delete;
+    worker &operator=(const worker &) = delete;
+
+    void push(job *j)
+    {
+        std::lock_guard<std::mutex> lk(lock_);
+
+        j->next = nullptr;
+
+        if (tail_) { tail_->next = j; }
+        else { head_ = j; }
+
+        tail_ = j;
+        cv_.notify_one();
+    }
+
+private:
+    void loop()
+    {
+        std::unique_lock<std::mutex> lk(lock_);
+
+        for (;;)
+        {
+            job *j;
+
+            while (!head_ && !quit_) { cv_.wait(lk); }
+
+            if (!head_) { return; }
+
+            j = static_cast<job *>(head_);
+            head_ = j->next;
+
+            if (!head_) { tail_ = nullptr; }
+
+            lk.unlock();
+            j->run(j);
+            lk.lock();
+        }
+    }
+
+    std::mutex lock_;
+    std::condition_variable cv_;
+    op_node *head_ = nullptr;
+    op_node *tail_ = nullptr;
+    bool quit_ = false;
+    std::thread thread_;
+};
+
+// F is int(T &) filling in the value, or int() when T is void
+template <class T, class F>
+class call_awaiter : public job
+{
+public:
+    call_awaiter(event_loop &loop, worker &w, F fn) noexcept
+        : loop_(loop), worker_(w), fn_(fn) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> h)
+    {
+        this->h = h;
+        this->run = run_job;
+        loop_.begin();
+        worker_.push(this);
+    }
+
+    result<T> await_resume() noexcept
+    {
+        if constexpr (std::is_void_v<T>)
+        {
+            return result<void>::from(ret_);
+        }
+        else
+        {
+            return detail::make(ret_, val_);
+        }
+    }
+
+private:
+    struct no_value {};
+    typedef std::conditional_t<std::is_void_v<T>, no_value, T> value_type;
+
+    static void run_job(job *j)
+    {
+        call_awaiter *a = static_cast<call_awaiter *>(j);
+
+        if constexpr (std::is_void_v<T>) { a->ret_ = a->fn_(); }
+        else { a->ret_ = a->fn_(a->val_); }
+
+        a->loop_.post(a);
+    }
+
+    event_loop &loop_;
+    worker &worker_;
+    F fn_;
+    int ret_ = RIG_OK;
+    value_type val_ {};
+};
+
+template <class T, class F>
+inline call_awaiter<T, F> make_call(event_loop &loop, worker &w, F fn) noexcept
+{
+    return call_awaiter<T, F>(loop, w, fn);
+}
+
+} // namespace detail
+//! @endcond
+
+
+/**
+ * \brief Awaitable operations on a Rig, through its rig_submit() queue
+ *
+ * The Rig must be open and outlive this object.
+ */
+class AsyncRig
+{
+public:
+    AsyncRig(Rig &rig, event_loop &loop) noexcept : rig_(rig), loop_(loop) {}
+
+    detail::rig_awaiter<void> setFreq(freq_t freq, vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        struct rig_request req = request(RIG_REQ_SET_FREQ, vfo);
+        req.freq = freq;
+        return detail::rig_awaiter<void>(loop_, rig_.get(), req, nullptr);
+    }
+
+    detail::rig_awaiter<freq_t> getFreq(vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        return detail::rig_awaiter<freq_t>(loop_, rig_.get(),
+                                           request(RIG_REQ_GET_FREQ, vfo), detail::req_freq);
+    }
+
+    detail::rig_awaiter<void> setMode(rmode_t mode,
+                                      pbwidth_t width = RIG_PASSBAND_NOCHANGE,
+                                      vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        struct rig_request req = request(RIG_REQ_SET_MODE, vfo);
+        req.mode = mode;
+        req.width = width;
+        return detail::rig_awaiter<void>(loop_, rig_.get(), req, nullptr);
+    }
+
+    detail::rig_awaiter<mode_width> getMode(vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        return detail::rig_awaiter<mode_width>(loop_, rig_.get(),
+                                               request(RIG_REQ_GET_MODE, vfo), detail::req_mode);
+    }
+
+    detail::rig_awaiter<void> setPTT(ptt_t ptt, vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        struct rig_request req = request(RIG_REQ_SET_PTT, vfo);
+        req.ptt = ptt;
+        return detail::rig_awaiter<void>(loop_, rig_.get(), req, nullptr);
+    }
+
+    detail::rig_awaiter<ptt_t> getPTT(vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        return detail::rig_awaiter<ptt_t>(loop_, rig_.get(),
+                                          request(RIG_REQ_GET_PTT, vfo), detail::req_ptt);
+    }
+
+    detail::rig_awaiter<void> setSplitFreq(freq_t tx_freq,
+                                           vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        struct rig_request req = request(RIG_REQ_SET_SPLIT_FREQ, vfo);
+        req.freq = tx_freq;
+        return detail::rig_awaiter<void>(loop_, rig_.get(), req, nullptr);
+    }
+
+    detail::rig_awaiter<void> setLevel(setting_t level, value_t val,
+                                       vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        struct rig_request req = request(RIG_REQ_SET_LEVEL, vfo);
+        req.setting = level;
+        req.val = val;
+        return detail::rig_awaiter<void>(loop_, rig_.get(), req, nullptr);
+    }
+
+    detail::rig_awaiter<value_t> getLevel(setting_t level,
+                                          vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        struct rig_request req = request(RIG_REQ_GET_LEVEL, vfo);
+        req.setting = level;
+        return detail::rig_awaiter<value_t>(loop_, rig_.get(), req, detail::req_val);
+    }
+
+private:
+    static struct rig_request request(rig_request_t type, vfo_t vfo) noexcept
+    {
+        struct rig_request req;
+
+        std::memset(&req, 0, sizeof(req));
+        req.type = type;
+        req.vfo = vfo;
+
+        return req;
+    }
+
+    Rig &rig_;
+    event_loop &loop_;
+};
+
+
+/**
+ * \brief Awaitable operations on a Rotator, made on a thread of its own
+ *
+ * The Rotator must be open and outlive this object.
+ */
+class AsyncRotator
+{
+public:
+    AsyncRotator(Rotator &rot, event_loop &loop) : rot_(rot.get()), loop_(loop) {}
+
+    auto setPosition(azimuth_t az, elevation_t el) noexcept
+    {
+        ROT *rot = rot_;
+        return detail::make_call<void>(loop_, worker_, [rot, az, el]
+        {
+            return rot_set_position(rot, az, el);
+        });
+    }
+
+    auto getPosition() noexcept
+    {
+        ROT *rot = rot_;
+        return detail::make_call<az_el>(loop_, worker_, [rot](az_el & pos)
+        {
+            return rot_get_position(rot, &pos.az, &pos.el);
+        });
+    }
+
+    auto stop() noexcept
+    {
+        ROT *rot = rot_;
+        return detail::make_call<void>(loop_, worker_, [rot] { return rot_stop(rot); });
+    }
+
+    auto park() noexcept
+    {
+        ROT *rot = rot_;
+        return detail::make_call<void>(loop_, worker_, [rot] { return rot_park(rot); });
+    }
+
+private:
+    ROT *rot_;
+    event_loop &loop_;
+    detail::worker worker_;
+};
+
+
+/**
+ * \brief Awaitable operations on an Amplifier, made on a thread of its own
+ *
+ * The Amplifier must be open and outlive this object.
+ */
+class AsyncAmplifier
+{
+public:
+    AsyncAmplifier(Amplifier &amp, event_loop &loop) : amp_(amp.get()), loop_(loop) {}
+
+    auto setFreq(freq_t freq) noexcept
+    {
+        AMP *amp = amp_;
+        return detail::make_call<void>(loop_, worker_, [amp, freq]
+        {
+            return amp_set_freq(amp, freq);
+        });
+    }
+
+    auto getFreq() noexcept
+    {
+        AMP *amp = amp_;
+        return detail::make_call<freq_t>(loop_, worker_, [amp](freq_t & freq)
+        {
+            return amp_get_freq(amp, &freq);
+        });
+    }
+
+    auto getLevel(setting_t level) noexcept
+    {
+        AMP *amp = amp_;
+        return detail::make_call<value_t>(loop_, worker_, [amp, level](value_t & val)
+        {
+            return amp_get_level(amp, level, &val);
+        });
+    }
+
+    auto setPowerstat(powerstat_t status) noexcept
+    {
+        AMP *amp = amp_;
+        return detail::make_call<void>(loop_, worker_, [amp, status]
+        {
+            return amp_set_powerstat(amp, status);
+        });
+    }
+
+    auto getPowerstat() noexcept
+    {
+        AMP *amp = amp_;
+        return detail::make_call<powerstat_t>(loop_, worker_, [amp](powerstat_t & status)
+        {
+            return amp_get_powerstat(amp, &status);
+        });
+    }
+
+private:
+    AMP *amp_;
+    event_loop &loop_;
+    detail::worker worker_;
+};
+
+} // namespace hamlib
+
+#endif /* __has_include(<coroutine>) */
+#endif /* C++20 */
+
+#endif /* _RIGCORO_H */
@@ -0,0 +1,803 @@
+/*
+ *  Hamlib C++ bindings - header only API without exceptions
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _RIGCXX_H
+#define _RIGCXX_H 1
+
+/*
+ * hamlib::Rig wraps a RIG handle the way rigclass.h does, but reports
+ * errors in its return values instead of throwing: every call gives a
+ * hamlib::result<T> holding either the value or the rig_errcode_e.  A
+ * timeout during polling is then as cheap as a successful read; the
+ * synchronous calls neither throw nor allocate.
+ *
+ *   hamlib::Rig rig(RIG_MODEL_DUMMY);
+ *
+ *   if (rig.setConf("rig_pathname", "/dev/ttyUSB0") && rig.open())
+ *   {
+ *       hamlib::result<freq_t> f = rig.getFreq();
+ *
+ *       if (f) { use(*f); }
+ *       else if (f.error() != RIG_ETIMEOUT) { report(f.message()); }
+ *   }
+ *
+ * The *Async() calls queue the operation with rig_submit() and return a
+ * std::future; they allocate the request, and the future's shared state,
+ * once per call.  submit() passes a caller owned rig_request straight
+ * through for code that wants the queue without any allocation.
+ *
+ * hamlib::Rotator and hamlib::Amplifier do the same for ROT and AMP
+ * handles.  rigcoro.h adds C++20 coroutines on top of all three.
+ *
+ * Needs C++11; std::string_view is accepted wherever a name is taken
+ * when built as C++17.
+ */
+
+#include <hamlib/rig.h>
+#include <hamlib/rotator.h>
+#include <hamlib/amplifier.h>
+
+#include <cstring>
+#include <future>
+#include <new>
+#include <string>
+#include <utility>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+namespace hamlib
+{
+
+#if __cplusplus >= 201703L
+typedef std::string_view string_view;
+#else
+//! @cond Doxygen_Suppress
+// the part of std::string_view the API needs, for C++11 and C++14
+class string_view
+{
+public:
+    string_view(const char *s) noexcept : s_(s), n_(s ? std::strlen(s) : 0) {}
+    string_view(const char *s, size_t n) noexcept : s_(s), n_(n) {}
+    string_view(const std::string &s) noexcept : s_(s.data()), n_(s.size()) {}
+
+    const char *data() const noexcept { return s_; }
+    size_t size() const noexcept { return n_; }
+
+private:
+    const char *s_;
+    size_t n_;
+};
+//! @endcond
+#endif
+
+
+/**
+ * \brief A value, or the reason there is none
+ *
+ * Shaped after std::expected<T, rig_errcode_e>.  value() and operator*
+ * must only be used when the result holds a value; value_or() is safe
+ * either way.  T must be default constructible.
+ */
+template <class T>
+class result
+{
+public:
+    result(const T &v) : val_(v), err_(RIG_OK) {}
+    result(T &&v) noexcept : val_(std::move(v)), err_(RIG_OK) {}
+
+    /** A result holding the error in a Hamlib return code, -RIG_E* or RIG_E* */
+    static result failure(int retcode) noexcept
+    {
+        result r;
+        r.err_ = static_cast<rig_errcode_e>(retcode < 0 ? -retcode : retcode);
+        return r;
+    }
+
+    bool has_value() const noexcept { return err_ == RIG_OK; }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    const T &value() const & noexcept { return val_; }
+    T &value() & noexcept { return val_; }
+    T &&value() && noexcept { return std::move(val_); }
+    const T &operator*() const & noexcept { return val_; }
+    T &operator*() & noexcept { return val_; }
+    const T *operator->() const noexcept { return &val_; }
+    T *operator->() noexcept { return &val_; }
+
+    T value_or(const T &dflt) const { return has_value() ? val_ : dflt; }
+
+    /** RIG_OK when there is a value */
+    rig_errcode_e error() const noexcept { return err_; }
+
+    /** One line description of error(), from rigerror2() */
+    const char *message() const noexcept { return rigerror2(-err_); }
+
+private:
+    result() : val_(), err_(RIG_OK) {}
+
+    T val_;
+    rig_errcode_e err_;
+};
+
+
+/**
+ * \brief Outcome of a call with nothing to return
+ */
+template <>
+class result<void>
+{
+public:
+    result() noexcept : err_(RIG_OK) {}
+
+    /** The outcome of a Hamlib return code */
+    static result from(int retcode) noexcept
+    {
+        result r;
+        r.err_ = static_cast<rig_errcode_e>(retcode < 0 ? -retcode : retcode);
+        return r;
+    }
+
+    static result failure(int retcode) noexcept { return from(retcode); }
+
+    bool has_value() const noexcept { return err_ == RIG_OK; }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    rig_errcode_e error() const noexcept { return err_; }
+    const char *message() const noexcept { return rigerror2(-err_); }
+
+private:
+    rig_errcode_e err_;
+};
+
+
+/** Mode and passband, as rig_get_mode() returns them */
+struct mode_width
+{
+    rmode_t mode;
+    pbwidth_t width;
+};
+
+/** Rotator position, as rot_get_position() returns it */
+struct az_el
+{
+    azimuth_t az;
+    elevation_t el;
+};
+
+/** Split state, as rig_get_split_vfo() returns it */
+struct split_vfo
+{
+    split_t split;
+    vfo_t tx_vfo;
+};
+
+
+//! @cond Doxygen_Suppress
+namespace detail
+{
+
+template <class T>
+inline result<T> make(int retcode, const T &v)
+{
+    return retcode == RIG_OK ? result<T>(v) : result<T>::failure(retcode);
+}
+
+// NUL terminated copy of a string_view, on the stack
+class cstr
+{
+public:
+    explicit cstr(string_view s) noexcept : ok_(s.size() < sizeof(buf_))
+    {
+        size_t n = ok_ ? s.size() : 0;
+
+        if (n) { std::memcpy(buf_, s.data(), n); }
+
+        buf_[n] = '\0';
+    }
+
+    bool ok() const noexcept { return ok_; }
+    const char *c_str() const noexcept { return buf_; }
+
+private:
+    char buf_[HAMLIB_FILPATHLEN];
+    bool ok_;
+};
+
+// a queued request and the promise its completion fulfils
+template <class T>
+struct pending
+{
+    struct rig_request req;
+    std::promise<result<T> > promise;
+    T (*get)(const struct rig_request &);
+
+    static void done(RIG *, struct rig_request *req, rig_ptr_t arg)
+    {
+        pending *p = static_cast<pending *>(arg);
+
+        p->promise.set_value(req->retcode == RIG_OK ? result<T>(p->get(*req))
+                             : result<T>::failure(req->retcode));
+        delete p;
+    }
+};
+
+template <>
+struct pending<void>
+{
+    struct rig_request req;
+    std::promise<result<void> > promise;
+
+    static void done(RIG *, struct rig_request *req, rig_ptr_t arg)
+    {
+        pending *p = static_cast<pending *>(arg);
+
+        p->promise.set_value(result<void>::from(req->retcode));
+        delete p;
+    }
+};
+
+inline freq_t req_freq(const struct rig_request &r) { return r.freq; }
+inline ptt_t req_ptt(const struct rig_request &r) { return r.ptt; }
+inline value_t req_val(const struct rig_request &r) { return r.val; }
+
+inline mode_width req_mode(const struct rig_request &r)
+{
+    mode_width mw = { r.mode, r.width };
+    return mw;
+}
+
+template <class T>
+inline std::future<result<T> > ready(int retcode)
+{
+    std::promise<result<T> > p;
+    p.set_value(result<T>::failure(retcode));
+    return p.get_future();
+}
+
+} // namespace detail
+//! @endcond
+
+
+/**
+ * \brief Move only owner of a RIG handle
+ *
+ * The handle is created by the constructor and rig_cleanup()'d, after a
+ * rig_close() if still open, by the destructor.  Check valid() after
+ * construction: rig_init() fails for an unknown model.
+ */
+class Rig
+{
+public:
+    Rig() noexcept : rig_(nullptr) {}
+    explicit Rig(rig_model_t model) noexcept : rig_(rig_init(model)) {}
+
+    /** Take ownership of a handle from rig_init() */
+    explicit Rig(RIG *rig) noexcept : rig_(rig) {}
+
+    ~Rig() { reset(); }
+
+    Rig(const Rig &) = delete;
+    Rig &operator=(const Rig &) = delete;
+
+    Rig(Rig &&other) noexcept : rig_(other.release()) {}
+
+    Rig &operator=(Rig &&other) noexcept
+    {
+        if (this != &other) { reset(other.release()); }
+
+        return *this;
+    }
+
+    bool valid() const noexcept { return rig_ != nullptr; }
+    explicit operator bool() const noexcept { return valid(); }
+
+    /** The C handle, for calls this class does not wrap */
+    RIG *get() const noexcept { return rig_; }
+
+    RIG *release() noexcept
+    {
+        RIG *r = rig_;
+        rig_ = nullptr;
+        return r;
+    }
+
+    void reset(RIG *rig = nullptr) noexcept
+    {
+        if (rig_) { rig_cleanup(rig_); }
+
+        rig_ = rig;
+    }
+
+    const struct rig_caps *caps() const noexcept { return rig_ ? rig_->caps : nullptr; }
+
+    result<void> open() noexcept { return result<void>::from(rig_open(rig_)); }
+    result<void> close() noexcept { return result<void>::from(rig_close(rig_)); }
+
+    result<token_t> tokenLookup(string_view name) noexcept
+    {
+        detail::cstr n(name);
+        token_t token;
+
+        if (!n.ok() || !rig_) { return result<token_t>::failure(RIG_EINVAL); }
+
+        token = rig_token_lookup(rig_, n.c_str());
+
+        return token == RIG_CONF_END ? result<token_t>::failure(RIG_EINVAL)
+               : result<token_t>(token);
+    }
+
+    result<void> setConf(string_view name, string_view val) noexcept
+    {
+        result<token_t> token = tokenLookup(name);
+        detail::cstr v(val);
+
+        if (!token) { return result<void>::failure(token.error()); }
+
+        if (!v.ok()) { return result<void>::failure(RIG_EINVAL); }
+
+        return result<void>::from(rig_set_conf(rig_, *token, v.c_str()));
+    }
+
+    /** Copies the value, NUL terminated, into \a buf of \a len bytes */
+    result<void> getConf(string_view name, char *buf, int len) noexcept
+    {
+        result<token_t> token = tokenLookup(name);
+
+        if (!token) { return result<void>::failure(token.error()); }
+
+        return result<void>::from(rig_get_conf2(rig_, *token, buf, len));
+    }
+
+    result<void> setFreq(freq_t freq, vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        return result<void>::from(rig_set_freq(rig_, vfo, freq));
+    }
+
+    result<freq_t> getFreq(vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        freq_t freq = 0;
+        int ret = rig_get_freq(rig_, vfo, &freq);
+        return detail::make(ret, freq);
+    }
+
+    result<void> setMode(rmode_t mode, pbwidth_t width = RIG_PASSBAND_NOCHANGE,
+                         vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        return result<void>::from(rig_set_mode(rig_, vfo, mode, width));
+    }
+
+    result<mode_width> getMode(vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        mode_width mw = { RIG_MODE_NONE, 0 };
+        int ret = rig_get_mode(rig_, vfo, &mw.mode, &mw.width);
+        return detail::make(ret, mw);
+    }
+
+    result<void> setVFO(vfo_t vfo) noexcept
+    {
+        return result<void>::from(rig_set_vfo(rig_, vfo));
+    }
+
+    result<vfo_t> getVFO() noexcept
+    {
+        vfo_t vfo = RIG_VFO_NONE;
+        int ret = rig_get_vfo(rig_, &vfo);
+        return detail::make(ret, vfo);
+    }
+
+    result<void> setPTT(ptt_t ptt, vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        return result<void>::from(rig_set_ptt(rig_, vfo, ptt));
+    }
+
+    result<ptt_t> getPTT(vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        ptt_t ptt = RIG_PTT_OFF;
+        int ret = rig_get_ptt(rig_, vfo, &ptt);
+        return detail::make(ret, ptt);
+    }
+
+    result<dcd_t> getDCD(vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        dcd_t dcd = RIG_DCD_OFF;
+        int ret = rig_get_dcd(rig_, vfo, &dcd);
+        return detail::make(ret, dcd);
+    }
+
+    result<void> setSplitVFO(split_t split, vfo_t tx_vfo,
+                             vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        return result<void>::from(rig_set_split_vfo(rig_, vfo, split, tx_vfo));
+    }
+
+    result<split_vfo> getSplitVFO(vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        split_vfo s = { RIG_SPLIT_OFF, RIG_VFO_NONE };
+        int ret = rig_get_split_vfo(rig_, vfo, &s.split, &s.tx_vfo);
+        return detail::make(ret, s);
+    }
+
+    result<void> setSplitFreq(freq_t tx_freq, vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        return result<void>::from(rig_set_split_freq(rig_, vfo, tx_freq));
+    }
+
+    result<freq_t> getSplitFreq(vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        freq_t freq = 0;
+        int ret = rig_get_split_freq(rig_, vfo, &freq);
+        return detail::make(ret, freq);
+    }
+
+    result<void> setLevel(setting_t level, value_t val,
+                          vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        return result<void>::from(rig_set_level(rig_, vfo, level, val));
+    }
+
+    result<value_t> getLevel(setting_t level, vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        value_t val;
+        int ret;
+
+        val.i = 0;
+        ret = rig_get_level(rig_, vfo, level, &val);
+
+        return detail::make(ret, val);
+    }
+
+    result<void> setFunc(setting_t func, bool status,
+                         vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        return result<void>::from(rig_set_func(rig_, vfo, func, status ? 1 : 0));
+    }
+
+    result<bool> getFunc(setting_t func, vfo_t vfo = RIG_VFO_CURR) noexcept
+    {
+        int status = 0;
+        int ret = rig_get_func(rig_, vfo, func, &status);
+        return detail::make(ret, status != 0);
+    }
+
+    /**
+     * Queue a caller owned request, see rig_submit().  \a req must stay
+     * valid until \a cb has run.
+     */
+    result<void> submit(struct rig_request &req, rig_request_cb_t cb,
+                        rig_ptr_t arg) noexcept
+    {
+        return result<void>::from(rig_submit(rig_, &req, cb, arg));
+    }
+
+    /** Wait for everything queued so far, see rig_submit_wait() */
+    result<void> submitWait() noexcept
+    {
+        return result<void>::from(rig_submit_wait(rig_));
+    }
+
+    std::future<result<void> > setFreqAsync(freq_t freq, vfo_t vfo = RIG_VFO_CURR)
+    {
+        struct rig_request req = request(RIG_REQ_SET_FREQ, vfo);
+        req.freq = freq;
+        return queue(req);
+    }
+
+    std::future<result<freq_t> > getFreqAsync(vfo_t vfo = RIG_VFO_CURR)
+    {
+        return queue<freq_t>(request(RIG_REQ_GET_FREQ, vfo), detail::req_freq);
+    }
+
+    std::future<result<void> > setModeAsync(rmode_t mode,
+                                            pbwidth_t width = RIG_PASSBAND_NOCHANGE,
+                                            vfo_t vfo = RIG_VFO_CURR)
+    {
+        struct rig_request req = request(RIG_REQ_SET_MODE, vfo);
+        req.mode = mode;
+        req.width = width;
+        return queue(req);
+    }
+
+    std::future<result<mode_width> > getModeAsync(vfo_t vfo = RIG_VFO_CURR)
+    {
+        return queue<mode_width>(request(RIG_REQ_GET_MODE, vfo), detail::req_mode);
+    }
+
+    std::future<result<void> > setPTTAsync(ptt_t ptt, vfo_t vfo = RIG_VFO_CURR)
+    {
+        struct rig_request req = request(RIG_REQ_SET_PTT, vfo);
+        req.ptt = ptt;
+        return queue(req);
+    }
+
+    std::future<result<ptt_t> > getPTTAsync(vfo_t vfo = RIG_VFO_CURR)
+    {
+        return queue<ptt_t>(request(RIG_REQ_GET_PTT, vfo), detail::req_ptt);
+    }
+
+    std::future<result<void> > setLevelAsync(setting_t level, value_t val,
+                                             vfo_t vfo = RIG_VFO_CURR)
+    {
+        struct rig_request req = request(RIG_REQ_SET_LEVEL, vfo);
+        req.setting = level;
+        req.val = val;
+        return queue(req);
+    }
+
+    std::future<result<value_t> > getLevelAsync(setting_t level,
+                                                vfo_t vfo = RIG_VFO_CURR)
+    {
+        struct rig_request req = request(RIG_REQ_GET_LEVEL, vfo);
+        req.setting = level;
+        return queue<value_t>(req, detail::req_val);
+    }
+
+private:
+    static struct rig_request request(rig_request_t type, vfo_t vfo) noexcept
+    {
+        struct rig_request req;
+
+        std::memset(&req, 0, sizeof(req));
+        req.type = type;
+        req.vfo = vfo;
+
+        return req;
+    }
+
+    template <class T>
+    std::future<result<T> > queue(const struct rig_request &req,
+                                  T (*get)(const struct rig_request &))
+    {
+        detail::pending<T> *p = new (std::nothrow) detail::pending<T>;
+        std::future<result<T> > f;
+        int ret;
+
+        if (!p) { return detail::ready<T>(RIG_ENOMEM); }
+
+        p->req = req;
+        p->get = get;
+        // before rig_submit(), which may complete a request at once
+        f = p->promise.get_future();
+
+        ret = rig_submit(rig_, &p->req, detail::pending<T>::done, p);
+
+        if (ret != RIG_OK)
+        {
+            p->promise.set_value(result<T>::failure(ret));
+            delete p;
+        }
+
+        return f;
+    }
+
+    std::future<result<void> > queue(const struct rig_request &req)
+    {
+        detail::pending<void> *p = new (std::nothrow) detail::pending<void>;
+        std::future<result<void> > f;
+        int ret;
+
+        if (!p) { return detail::ready<void>(RIG_ENOMEM); }
+
+        p->req = req;
+        f = p->promise.get_future();
+
+        ret = rig_submit(rig_, &p->req, detail::pending<void>::done, p);
+
+        if (ret != RIG_OK)
+        {
+            p->promise.set_value(result<void>::from(ret));
+            delete p;
+        }
+
+        return f;
+    }
+
+    RIG *rig_;
+};
+
+/**
+ * \brief Move only owner of a ROT handle, see Rig
+ */
+class Rotator
+{
+public:
+    Rotator() noexcept : rot_(nullptr) {}
+    explicit Rotator(rot_model_t model) noexcept : rot_(rot_init(model)) {}
+    explicit Rotator(ROT *rot) noexcept : rot_(rot) {}
+
+    ~Rotator() { reset(); }
+
+    Rotator(const Rotator &) = delete;
+    Rotator &operator=(const Rotator &) = delete;
+
+    Rotator(Rotator &&other) noexcept : rot_(other.release()) {}
+
+    Rotator &operator=(Rotator &&other) noexcept
+    {
+        if (this != &other) { reset(other.release()); }
+
+        return *this;
+    }
+
+    bool valid() const noexcept { return rot_ != nullptr; }
+    explicit operator bool() const noexcept { return valid(); }
+
+    ROT *get() const noexcept { return rot_; }
+
+    ROT *release() noexcept
+    {
+        ROT *r = rot_;
+        rot_ = nullptr;
+        return r;
+    }
+
+    void reset(ROT *rot = nullptr) noexcept
+    {
+        if (rot_) { rot_cleanup(rot_); }
+
+        rot_ = rot;
+    }
+
+    result<void> open() noexcept { return result<void>::from(rot_open(rot_)); }
+    result<void> close() noexcept { return result<void>::from(rot_close(rot_)); }
+
+    result<void> setConf(string_view name, string_view val) noexcept
+    {
+        detail::cstr n(name), v(val);
+        token_t token;
+
+        if (!n.ok() || !v.ok() || !rot_) { return result<void>::failure(RIG_EINVAL); }
+
+        token = rot_token_lookup(rot_, n.c_str());
+
+        if (token == RIG_CONF_END) { return result<void>::failure(RIG_EINVAL); }
+
+        return result<void>::from(rot_set_conf(rot_, token, v.c_str()));
+    }
+
+    result<void> setPosition(azimuth_t az, elevation_t el) noexcept
+    {
+        return result<void>::from(rot_set_position(rot_, az, el));
+    }
+
+    result<az_el> getPosition() noexcept
+    {
+        az_el pos = { 0, 0 };
+        int ret = rot_get_position(rot_, &pos.az, &pos.el);
+        return detail::make(ret, pos);
+    }
+
+    result<void> stop() noexcept { return result<void>::from(rot_stop(rot_)); }
+    result<void> park() noexcept { return result<void>::from(rot_park(rot_)); }
+
+    result<void> move(int direction, int speed) noexcept
+    {
+        return result<void>::from(rot_move(rot_, direction, speed));
+    }
+
+private:
+    ROT *rot_;
+};
+
+
+/**
+ * \brief Move only owner of an AMP handle, see Rig
+ */
+class Amplifier
+{
+public:
+    Amplifier() noexcept : amp_(nullptr) {}
+    explicit Amplifier(amp_model_t model) noexcept : amp_(amp_init(model)) {}
+    explicit Amplifier(AMP *amp) noexcept : amp_(amp) {}
+
+    ~Amplifier() { reset(); }
+
+    Amplifier(const Amplifier &) = delete;
+    Amplifier &operator=(const Amplifier &) = delete;
+
+    Amplifier(Amplifier &&other) noexcept : amp_(other.release()) {}
+
+    Amplifier &operator=(Amplifier &&other) noexcept
+    {
+        if (this != &other) { reset(other.release()); }
+
+        return *this;
+    }
+
+    bool valid() const noexcept { return amp_ != nullptr; }
+    explicit operator bool() const noexcept { return valid(); }
+
+    AMP *get() const noexcept { return amp_; }
+
+    AMP *release() noexcept
+    {
+        AMP *a = amp_;
+        amp_ = nullptr;
+        return a;
+    }
+
+    void reset(AMP *amp = nullptr) noexcept
+    {
+        if (amp_) { amp_cleanup(amp_); }
+
+        amp_ = amp;
+    }
+
+    result<void> open() noexcept { return result<void>::from(amp_open(amp_)); }
+    result<void> close() noexcept { return result<void>::from(amp_close(amp_)); }
+
+    result<void> setConf(string_view name, string_view val) noexcept
+    {
+        detail::cstr n(name), v(val);
+        token_t token;
+
+        if (!n.ok() || !v.ok() || !amp_) { return result<void>::failure(RIG_EINVAL); }
+
+        token = amp_token_lookup(amp_, n.c_str());
+
+        if (token == RIG_CONF_END) { return result<void>::failure(RIG_EINVAL); }
+
+        return result<void>::from(amp_set_conf(amp_, token, v.c_str()));
+    }
+
+    result<void> setFreq(freq_t freq) noexcept
+    {
+        return result<void>::from(amp_set_freq(amp_, freq));
+    }
+
+    result<freq_t> getFreq() noexcept
+    {
+        freq_t freq = 0;
+        int ret = amp_get_freq(amp_, &freq);
+        return detail::make(ret, freq);
+    }
+
+    result<value_t> getLevel(setting_t level) noexcept
+    {
+        value_t val;
+        int ret;
+
+        val.i = 0;
+        ret = amp_get_level(amp_, level, &val);
+
+        return detail::make(ret, val);
+    }
+
+    result<void> setPowerstat(powerstat_t status) noexcept
+    {
+        return result<void>::from(amp_set_powerstat(amp_, status));
+    }
+
+    result<powerstat_t> getPowerstat() noexcept
+    {
+        powerstat_t status = RIG_POWER_OFF;
+        int ret = amp_get_powerstat(amp_, &status);
+        return detail::make(ret, status);
+    }
+
+private:
+    AMP *amp_;
+};
+
+} // namespace hamlib
+
+#endif /* _RIGCXX_H */
@@ -71,6 +71,11 @@
 #define RIG_MODEL_TRXMANAGER_RIG RIG_MAKE_MODEL(RIG_DUMMY, 5)
 #define RIG_MODEL_DUMMY_NOVFO RIG_MAKE_MODEL(RIG_DUMMY, 6)
 #define RIG_MODEL_TCI1X RIG_MAKE_MODEL(RIG_DUMMY, 7)
+#define RIG_MODEL_NETMCAST RIG_MAKE_MODEL(RIG_DUMMY, 8)
+/*! \def RIG_MODEL_IS_NETRIGCTL
+ *  \brief The models that are a rigctld at the other end of the network
+ */
+#define RIG_MODEL_IS_NETRIGCTL(m) ((m) == RIG_MODEL_NETRIGCTL || (m) == RIG_MODEL_NETMCAST)
 
 
 /*
@@ -531,6 +536,7 @@
 #define RIG_MODEL_SDR1000RFE RIG_MAKE_MODEL(RIG_FLEXRADIO, 2)
 #define RIG_MODEL_DTTSP RIG_MAKE_MODEL(RIG_FLEXRADIO, 3)
 #define RIG_MODEL_DTTSP_UDP RIG_MAKE_MODEL(RIG_FLEXRADIO, 4)
+#define RIG_MODEL_SMARTSDR RIG_MAKE_MODEL(RIG_FLEXRADIO, 5)
 
 
 /*
@@ -62,6 +62,18 @@ struct rot_state;
 typedef struct s_rot ROT;
 
 
+/**
+ * \typedef typedef struct rot_group ROT_GROUP
+ * \brief Group of rotators steered together.
+ *
+ * The #ROT_GROUP handle is returned by rot_group_init() and is passed to the
+ * rot_group_*() calls, which act on all the member rotators at once.
+ *
+ * rot_group_cleanup() must be called when this handle is no longer needed.
+ */
+typedef struct rot_group ROT_GROUP;
+
+
 /**
  * \typedef typedef float elevation_t
  * \brief Type definition for elevation.
@@ -454,12 +466,67 @@ struct rot_caps {
 
     const char *macro_name;                    /*!< Rotator model macro name. */
     int (*get_conf2)(ROT *rot, token_t token, char *val, int val_len);       /*!< Pointer to backend implementation of ::rot_get_conf2(). */
+    int (*get_state)(ROT *rot, azimuth_t *azimuth, elevation_t *elevation, rot_status_t *status); /*!< Pointer to backend implementation of ::rot_get_state(). */
 };
 //! @cond Doxygen_Suppress
 #define ROT_MODEL(arg) .rot_model=arg,.macro_name=#arg
 //! @endcond
 
 
+/**
+ * \struct rot_point
+ * \brief One timestamped point of a trajectory
+ *
+ * \sa rot_set_trajectory()
+ */
+struct rot_point {
+    double time;        /*!< When to be there, in seconds since the Unix epoch. */
+    azimuth_t az;       /*!< Azimuth in decimal degrees. */
+    elevation_t el;     /*!< Elevation in decimal degrees. */
+};
+
+
+/**
+ * \struct rot_cache
+ * \brief Last position and status read from the rotator
+ *
+ * rot_get_position() and rot_get_status() answer from here while the
+ * reading is younger than \a timeout_ms.  Position is kept as the
+ * controller reported it, before south_zero and offsets are applied.
+ */
+struct rot_cache {
+    int timeout_ms;                 /*!< How long readings stay fresh, 0 always asks the controller. */
+    azimuth_t az;                   /*!< Last azimuth read. */
+    elevation_t el;                 /*!< Last elevation read. */
+    struct timespec time_position;  /*!< When az/el were read. */
+    unsigned int position_seq;      /*!< Bumped on every position read from the controller. */
+    rot_status_t status;            /*!< Last status flags read. */
+    struct timespec time_status;    /*!< When status was read. */
+    unsigned int status_seq;        /*!< Bumped on every status read from the controller. */
+};
+
+
+/**
+ * \struct rot_move_filter
+ * \brief Last position sent to the rotator, to squash useless moves
+ *
+ * rot_set_position() skips a target the controller cannot act on: one
+ * closer than \a deadband to the last one sent, or the same once rounded to
+ * \a min_step.  It also waits until \a min_interval_ms has passed since the
+ * previous position went out.  Targets are compared as sent, after offsets
+ * and south_zero.
+ */
+struct rot_move_filter {
+    float deadband;             /*!< Degrees a target must differ from the last one sent, 0 sends all. */
+    float min_step;             /*!< Resolution in degrees targets are rounded to, 0 leaves them. */
+    int min_interval_ms;        /*!< Shortest time between two positions sent, 0 no limit. */
+    azimuth_t az;               /*!< Last azimuth sent. */
+    elevation_t el;             /*!< Last elevation sent. */
+    int valid;                  /*!< az/el hold, nothing else has moved the rotator since. */
+    struct timespec time_sent;  /*!< When the last position was sent. */
+};
+
+
 /**
  * \struct rot_state
  * \brief Rotator state structure
@@ -507,6 +574,12 @@ struct rot_state {
     int current_speed;      /*!< Current speed 1-100, to be used when no change to speed is requested. */
     hamlib_port_t rotport;  /*!< Rotator port (internal use). */
     hamlib_port_t rotport2;  /*!< 2nd Rotator port (internal use). */
+    struct rot_cache cache; /*!< Position and status cache. */
+    pthread_mutex_t cache_lock; /*!< Serializes controller queries and motion commands (internal use). */
+    void *trajectory;       /*!< Trajectory scheduler, see rot_track.c (internal use). */
+    struct rot_move_filter move_filter; /*!< Last position sent and the deadband settings. */
+    void *conf_index; /*!< Hashed cfgparams, see conf_index.c (internal use). */
+    void *ext_index;  /*!< Hashed extlevels/extfuncs/extparms (internal use). */
 };
 
 
@@ -570,6 +643,15 @@ rot_get_position HAMLIB_PARAMS((ROT *rot,
                                 azimuth_t *azimuth,
                                 elevation_t *elevation));
 
+extern HAMLIB_EXPORT(int)
+rot_set_trajectory HAMLIB_PARAMS((ROT *rot,
+                                  const struct rot_point *pts,
+                                  int n));
+extern HAMLIB_EXPORT(int)
+rot_add_trajectory HAMLIB_PARAMS((ROT *rot,
+                                  const struct rot_point *pts,
+                                  int n));
+
 extern HAMLIB_EXPORT(int)
 rot_stop HAMLIB_PARAMS((ROT *rot));
 
@@ -667,6 +749,43 @@ extern HAMLIB_EXPORT(int)
 rot_get_status HAMLIB_PARAMS((ROT *rot,
         rot_status_t *status));
 
+extern HAMLIB_EXPORT(int)
+rot_get_state HAMLIB_PARAMS((ROT *rot,
+                             azimuth_t *azimuth,
+                             elevation_t *elevation,
+                             rot_status_t *status));
+
+extern HAMLIB_EXPORT(int)
+rot_get_metrics HAMLIB_PARAMS((ROT *rot,
+                               char *buf,
+                               int len));
+
+extern HAMLIB_EXPORT(ROT_GROUP *)
+rot_group_init HAMLIB_PARAMS((ROT *const rots[],
+                              int n));
+extern HAMLIB_EXPORT(int)
+rot_group_open HAMLIB_PARAMS((ROT_GROUP *grp));
+extern HAMLIB_EXPORT(int)
+rot_group_close HAMLIB_PARAMS((ROT_GROUP *grp));
+extern HAMLIB_EXPORT(int)
+rot_group_cleanup HAMLIB_PARAMS((ROT_GROUP *grp));
+
+extern HAMLIB_EXPORT(int)
+rot_group_set_position HAMLIB_PARAMS((ROT_GROUP *grp,
+                                      azimuth_t azimuth,
+                                      elevation_t elevation));
+extern HAMLIB_EXPORT(int)
+rot_group_get_position HAMLIB_PARAMS((ROT_GROUP *grp,
+                                      azimuth_t *azimuth,
+                                      elevation_t *elevation));
+extern HAMLIB_EXPORT(int)
+rot_group_get_status HAMLIB_PARAMS((ROT_GROUP *grp,
+                                    rot_status_t *status));
+extern HAMLIB_EXPORT(int)
+rot_group_stop HAMLIB_PARAMS((ROT_GROUP *grp));
+extern HAMLIB_EXPORT(int)
+rot_group_park HAMLIB_PARAMS((ROT_GROUP *grp));
+
 extern HAMLIB_EXPORT(int)
 rot_register HAMLIB_PARAMS((const struct rot_caps *caps));
 
@@ -751,6 +870,43 @@ distance_long_path HAMLIB_PARAMS((double distance));
 extern HAMLIB_EXPORT(double)
 azimuth_long_path HAMLIB_PARAMS((double azimuth));
 
+/**
+ * \brief Home QTH prepared for qrb_home_batch(), see qrb_home_init()
+ */
+struct qrb_home {
+    double lon;         /*!< Longitude in radians. */
+    double sin_lat;     /*!< Sine of the latitude. */
+    double cos_lat;     /*!< Cosine of the latitude. */
+};
+
+extern HAMLIB_EXPORT(int)
+qrb_home_init HAMLIB_PARAMS((struct qrb_home *home,
+                             double lon,
+                             double lat));
+
+extern HAMLIB_EXPORT(int)
+qrb_batch HAMLIB_PARAMS((const double *lon1,
+                         const double *lat1,
+                         const double *lon2,
+                         const double *lat2,
+                         size_t n,
+                         double *dist,
+                         double *az));
+
+extern HAMLIB_EXPORT(int)
+qrb_home_batch HAMLIB_PARAMS((const struct qrb_home *home,
+                              const double *lon2,
+                              const double *lat2,
+                              size_t n,
+                              double *dist,
+                              double *az));
+
+extern HAMLIB_EXPORT(int)
+locator2longlat_batch HAMLIB_PARAMS((const char *locators,
+                                     double *lon,
+                                     double *lat,
+                                     size_t n));
+
 #if 0
 extern HAMLIB_EXPORT(int)
 longlat2locator HAMLIB_PARAMS((double longitude,
@@ -0,0 +1,151 @@
+/*
+ *  Hamlib Interface - station event bus
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _STATION_H
+#define _STATION_H 1
+
+#include <hamlib/rig.h>
+#include <hamlib/rotator.h>
+#include <hamlib/amplifier.h>
+
+/**
+ * \addtogroup station
+ * @{
+ */
+
+/**
+ * \file station.h
+ * \brief Station event bus: one feed of changes from a rig, rotator and
+ * amplifier hosted in the same process.
+ *
+ * A station watches the #RIG, #ROT and #AMP handles given to
+ * station_init() from one thread.  Whenever a value changes it builds a
+ * #station_event, hands it to the event callback, and sends its text line
+ * to the TCP subscribers and the multicast group.  Lines look like
+ *
+ *     !rig freq 14074000
+ *     !rig mode USB 2400
+ *     !rig ptt 1
+ *     !rot pos 180.0 10.0
+ *     !amp powerstat 1
+ *     !amp SWR 1.30
+ *
+ * A TCP subscriber first gets a line for every known value, then the
+ * changes as they happen.
+ *
+ * Values are read through the handles' own caches: the rig cache (fed by
+ * transceive where the rig has it), the rotator position cache and the
+ * amplifier cache and poller.  Setting the handles' cache timeouts keeps
+ * the station from adding load on the ports.
+ */
+
+__BEGIN_DECLS
+
+/**
+ * \typedef typedef struct station STATION
+ * \brief Station handle, returned by station_init().
+ */
+typedef struct station STATION;
+
+/**
+ * \brief Device a #station_event comes from
+ */
+enum station_device_e
+{
+    STATION_RIG = 1,    /*!< The rig. */
+    STATION_ROT,        /*!< The rotator. */
+    STATION_AMP         /*!< The amplifier. */
+};
+
+/**
+ * \brief What changed
+ */
+enum station_item_e
+{
+    STATION_FREQ = 1,   /*!< Frequency, in \a freq. */
+    STATION_MODE,       /*!< Mode and passband, in \a mode and \a width. */
+    STATION_PTT,        /*!< PTT, in \a ptt. */
+    STATION_POSITION,   /*!< Azimuth and elevation, in \a az and \a el. */
+    STATION_POWERSTAT,  /*!< Power status, in \a powerstat. */
+    STATION_LEVEL       /*!< Amplifier level \a level, in \a val. */
+};
+
+/**
+ * \brief One change seen on the station
+ */
+struct station_event
+{
+    enum station_device_e device;   /*!< Where it happened. */
+    enum station_item_e item;       /*!< What changed. */
+    freq_t freq;                    /*!< New frequency. */
+    rmode_t mode;                   /*!< New mode. */
+    pbwidth_t width;                /*!< New passband. */
+    ptt_t ptt;                      /*!< New PTT state. */
+    azimuth_t az;                   /*!< New azimuth. */
+    elevation_t el;                 /*!< New elevation. */
+    powerstat_t powerstat;          /*!< New power status. */
+    setting_t level;                /*!< Which amplifier level. */
+    value_t val;                    /*!< New level value. */
+    const char *line;               /*!< The event as sent to subscribers, without newline. */
+};
+
+/**
+ * \brief Station event callback, called from the station thread
+ */
+typedef int (*station_cb_t)(STATION *, const struct station_event *, rig_ptr_t);
+
+/**
+ * \brief Amplifier frequency follows the rig whenever it changes band.
+ * \sa station_set_follow()
+ */
+#define STATION_FOLLOW_AMP_FREQ (1 << 0)
+
+extern HAMLIB_EXPORT(STATION *)
+station_init HAMLIB_PARAMS((RIG *rig, ROT *rot, AMP *amp));
+
+extern HAMLIB_EXPORT(int)
+station_set_callback HAMLIB_PARAMS((STATION *st,
+                                    station_cb_t cb,
+                                    rig_ptr_t arg));
+
+extern HAMLIB_EXPORT(int)
+station_set_follow HAMLIB_PARAMS((STATION *st, int flags));
+
+extern HAMLIB_EXPORT(int)
+station_listen HAMLIB_PARAMS((STATION *st, const char *addr, int port));
+
+extern HAMLIB_EXPORT(int)
+station_multicast HAMLIB_PARAMS((STATION *st, const char *addr, int port));
+
+extern HAMLIB_EXPORT(int)
+station_start HAMLIB_PARAMS((STATION *st, int interval_ms));
+
+extern HAMLIB_EXPORT(int)
+station_stop HAMLIB_PARAMS((STATION *st));
+
+extern HAMLIB_EXPORT(int)
+station_cleanup HAMLIB_PARAMS((STATION *st));
+
+__END_DECLS
+
+#endif /* _STATION_H */
+
+/** @} */
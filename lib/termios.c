@@ -86,6 +86,10 @@ struct termios_list
     int fd;
     struct termios_list *next;
     struct termios_list *prev;
+    /* the WaitCommEvent() of wait_rx(), armed between calls */
+    OVERLAPPED eol;
+    int eol_pending;
+    unsigned long eol_mask;
 };
 struct termios_list *first_tl = NULL;
 
@@ -806,6 +810,17 @@ int win32_serial_close(int fd)
         first_tl = NULL;
     }
 
+    if (index->eol_pending)
+    {
+        unsigned long n;
+
+        /* completes the wait before eol goes away with index */
+        SetCommMask(index->hComm, 0);
+        GetOverlappedResult(index->hComm, &index->eol, &n, TRUE);
+    }
+
+    if (index->eol.hEvent) { CloseHandle(index->eol.hEvent); }
+
     if (index->rol.hEvent) { CloseHandle(index->rol.hEvent); }
 
     if (index->wol.hEvent) { CloseHandle(index->wol.hEvent); }
@@ -1053,6 +1068,8 @@ static int open_port(struct termios_list *port)
     memset(&port->rol, 0, sizeof(OVERLAPPED));
     memset(&port->wol, 0, sizeof(OVERLAPPED));
     memset(&port->sol, 0, sizeof(OVERLAPPED));
+    memset(&port->eol, 0, sizeof(OVERLAPPED));
+    port->eol_pending = 0;
 
     port->rol.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
 
@@ -1081,6 +1098,15 @@ static int open_port(struct termios_list *port)
         goto fail;
     }
 
+    port->eol.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+
+    if (!port->eol.hEvent)
+    {
+        YACK();
+        report("Could not create receive overlapped\n");
+        goto fail;
+    }
+
     LEAVE("open_port");
     return (0);
 fail:
@@ -1471,6 +1497,96 @@ int win32_serial_open(const char *filename, int flags, ...)
 }
 
 
+/*----------------------------------------------------------
+wait_rx()
+
+   accept:      port, COMSTAT to fill, bytes wanted and the ms to
+                wait for them, INFINITE for no limit
+   perform:     wait until the input queue holds want bytes
+   return:      1 when it does, 0 on timeout, -1 on error
+   exceptions:
+   win32api:    WaitCommEvent(), WaitForSingleObject(),
+                GetOverlappedResult(), ClearCommError()
+   comments:    Rather than polling ClearCommError() every few ms, an
+                overlapped WaitCommEvent() on eol wakes us as a byte
+                arrives.  It stays armed between calls; a wakeup for
+                something else, EV_TXEMPTY after a write or a
+                SetCommMask(), only rearms it.
+----------------------------------------------------------*/
+static int wait_rx(struct termios_list *index, COMSTAT *Stat,
+                   unsigned long want, unsigned long ms)
+{
+    unsigned long start = GetTickCount();
+
+    if (!(index->event_flag & EV_RXCHAR))
+    {
+        index->event_flag |= EV_RXCHAR;
+        SetCommMask(index->hComm, index->event_flag);
+    }
+
+    for (;;)
+    {
+        unsigned long elapsed, wait, n;
+
+        if (!index->eol_pending)
+        {
+            ResetEvent(index->eol.hEvent);
+
+            if (!WaitCommEvent(index->hComm, &index->eol_mask, &index->eol))
+            {
+                if (GetLastError() != ERROR_IO_PENDING)
+                {
+                    YACK();
+                    return -1;
+                }
+
+                index->eol_pending = 1;
+            }
+        }
+
+        /* only now, or a byte coming in before the wait was armed is missed */
+        if (!ClearErrors(index, Stat))
+        {
+            return -1;
+        }
+
+        if (Stat->cbInQue >= want)
+        {
+            return 1;
+        }
+
+        elapsed = GetTickCount() - start;
+
+        if (ms != INFINITE && elapsed >= ms)
+        {
+            return 0;
+        }
+
+        if (!index->eol_pending)
+        {
+            /* WaitCommEvent() had an event at hand already */
+            continue;
+        }
+
+        wait = WaitForSingleObject(index->eol.hEvent,
+                                   ms == INFINITE ? INFINITE : ms - elapsed);
+
+        if (wait == WAIT_TIMEOUT)
+        {
+            return 0;
+        }
+
+        if (wait != WAIT_OBJECT_0)
+        {
+            YACK();
+            return -1;
+        }
+
+        GetOverlappedResult(index->hComm, &index->eol, &n, FALSE);
+        index->eol_pending = 0;
+    }
+}
+
 /*----------------------------------------------------------
 serial_write()
 
@@ -1586,7 +1702,6 @@ int win32_serial_read(int fd, void *vb, int size)
     struct termios_list *index;
 //    char message[80];
     COMSTAT stat;
-    clock_t c;
     unsigned char *dest = vb;
 
     start = GetTickCount();
@@ -1614,36 +1729,25 @@ int win32_serial_read(int fd, void *vb, int size)
 
     if (index->open_flags & O_NONBLOCK)
     {
-        /* pull mucho-cpu here? */
-        do
-        {
 #ifdef DEBUG_VERBOSE
-            report("vmin=0\n");
+        report("vmin=0\n");
 #endif /* DEBUG_VERBOSE */
-            ClearErrors(index, &stat);
+        ClearErrors(index, &stat);
 
-            if (stat.cbInQue < index->ttyset->c_cc[VMIN])
-            {
-                /*
-                  hl_usleep(50);
-                */
-                hl_usleep(100);     /* don't hog the CPU while waiting */
+        if (size > 1 && stat.cbInQue < index->ttyset->c_cc[VMIN])
+        {
+            /* we should use -1 instead of 0 for disabled timeout */
+            long left = index->ttyset->c_cc[VTIME] * 100;
 
-                /* we should use -1 instead of 0 for disabled timeout */
-                now = GetTickCount();
+            now = GetTickCount();
+            left = left > now - start ? left - (now - start) : 0;
 
-                if (index->ttyset->c_cc[VTIME] &&
-                        now - start >= (index->ttyset->c_cc[VTIME] * 100))
-                {
-                    /*
-                      SNPRINTF( message, sizeof(message), "now = %i start = %i time = %i total =%i\n", now, start, index->ttyset->c_cc[VTIME]*100, total);
-                      report( message );
-                    */
-                    return total; /* read timeout */
-                }
+            if (wait_rx(index, &stat, index->ttyset->c_cc[VMIN],
+                        index->ttyset->c_cc[VTIME] ? left : INFINITE) == 0)
+            {
+                return total; /* read timeout */
             }
         }
-        while (size > 1 && stat.cbInQue < index->ttyset->c_cc[VMIN]);
     }
     else
     {
@@ -1652,17 +1756,8 @@ int win32_serial_read(int fd, void *vb, int size)
 #ifdef DEBUG_VERBOSE
         report("vmin!=0\n");
 #endif /* DEBUG_VERBOSE */
-        /* vmin = index->ttyset->c_cc[VMIN]; */
-
-        c = clock() + index->ttyset->c_cc[VTIME] * CLOCKS_PER_SEC / 10;
-
-        do
-        {
-            ClearErrors(index, &stat);
-            hl_usleep(1000);
-        }
-        while (stat.cbInQue < index->ttyset->c_cc[VMIN] && c > clock());
-
+        wait_rx(index, &stat, index->ttyset->c_cc[VMIN],
+                index->ttyset->c_cc[VTIME] * 100);
     }
 
     total = 0;
@@ -3757,7 +3852,8 @@ int  win32_serial_select(int  n,  fd_set  *readfds,  fd_set  *writefds,
 #define DATA_AVAILABLE     1
 
     //nativeSetEventFlag( fd, SerialPortEvent.DATA_AVAILABLE, enable );
-    if (readfds)
+    /* SetCommMask() would cut short the wait wait_rx() keeps armed */
+    if (readfds && !(index->event_flag & EV_RXCHAR))
     {
         int eventflags[12];
         memset(eventflags, 0, sizeof(eventflags));
@@ -3793,35 +3889,18 @@ int  win32_serial_select(int  n,  fd_set  *readfds,  fd_set  *writefds,
     /* look only after read */
     if (readfds && !writefds && !exceptfds)
     {
-        int timeout_usec = timeout ? timeout->tv_sec * 1000000 + timeout->tv_usec :
-                           INT_MAX;
-
-        while (timeout_usec > 0)
+        switch (wait_rx(index, &Stat, 1, timeout ? timeout->tv_sec * 1000
+                        + (timeout->tv_usec + 999) / 1000 : INFINITE))
         {
-            SNPRINTF(message, sizeof(message), "wait for data in read buffer%d\n",
-                     (int)Stat.cbInQue);
-            report(message);
-
-            if (Stat.cbInQue != 0)
-            {
-                goto end;
-            }
-
-            hl_usleep(10000);
-            /* FIXME: not very accurate wrt process time */
-            timeout_usec -= 10000;
-
-            report("sleep...\n");
+        case 1:
+            goto end;
 
-            ret = ClearErrors(index, &Stat);
+        case 0:
+            goto timeout;
 
-            if (ret == 0)
-            {
-                goto fail;
-            }
+        default:
+            goto fail;
         }
-
-        goto timeout;
     }
 
 #endif
@@ -499,6 +499,19 @@ static adat_cmd_list_t adat_cmd_list_get_ptt =
     }
 };
 
+// -- GET BULK --
+
+static adat_cmd_list_t adat_cmd_list_get_bulk =
+{
+    4,
+    {
+        &adat_cmd_display_off,
+        &adat_cmd_get_freq,
+        &adat_cmd_get_mode,
+        &adat_cmd_get_ptt
+    }
+};
+
 // -- GET POWER STATUS --
 
 static adat_cmd_list_t adat_cmd_list_get_powerstatus =
@@ -1618,6 +1631,10 @@ int adat_cmd_recover_from_error(RIG *pRig, int nError)
 
         pPriv->nRC = RIG_OK;
 
+        elapsed_ms(&pPriv->tFreq, HAMLIB_ELAPSED_INVALIDATE);
+        elapsed_ms(&pPriv->tMode, HAMLIB_ELAPSED_INVALIDATE);
+        elapsed_ms(&pPriv->tPTT, HAMLIB_ELAPSED_INVALIDATE);
+
         // Execute recovery commands
 
         (void) adat_transaction(pRig, &adat_cmd_list_recover_from_error);
@@ -2085,6 +2102,11 @@ int adat_cmd_fn_get_mode(RIG *pRig)
                 nRC = adat_parse_mode(pPriv->pcResult,
                                       &(pPriv->nRIGMode),
                                       pPriv->acADATMode);
+
+                if (nRC == RIG_OK)
+                {
+                    elapsed_ms(&pPriv->tMode, HAMLIB_ELAPSED_SET);
+                }
             }
         }
     }
@@ -2208,6 +2230,11 @@ int adat_cmd_fn_get_freq(RIG *pRig)
                     nRC = adat_vfo_anr2rnr(pPriv->nCurrentVFO,
                                            &(pPriv->nRIGVFONr));
                 }
+
+                if (nRC == RIG_OK)
+                {
+                    elapsed_ms(&pPriv->tFreq, HAMLIB_ELAPSED_SET);
+                }
             }
         }
     }
@@ -2385,6 +2412,11 @@ int adat_cmd_fn_get_ptt(RIG *pRig)
                     nRC = adat_ptt_anr2rnr(pPriv->nADATPTTStatus,
                                            &(pPriv->nRIGPTTStatus));
                 }
+
+                if (nRC == RIG_OK)
+                {
+                    elapsed_ms(&pPriv->tPTT, HAMLIB_ELAPSED_SET);
+                }
             }
         }
     }
@@ -2601,8 +2633,12 @@ int adat_transaction(RIG                *pRig,
             }
 
             // sleep between cmds - ADAT needs time to act upoon cmds
+            // (not after the last one, the next call may be a while off)
 
-            hl_usleep(ADAT_SLEEP_MICROSECONDS_BETWEEN_CMDS);
+            if ((nRC == RIG_OK) && (nFini == 0) && (nI < pCmdList->nNrCmds))
+            {
+                hl_usleep(ADAT_SLEEP_MICROSECONDS_BETWEEN_CMDS);
+            }
         }
     }
 
@@ -2644,6 +2680,10 @@ adat_priv_data_ptr adat_new_priv_data(RIG *pRig)
             char acBuf[ ADAT_BUFSZ + 1 ];
             memset(acBuf, 0, ADAT_BUFSZ + 1);
 
+            elapsed_ms(&pPriv->tFreq, HAMLIB_ELAPSED_INVALIDATE);
+            elapsed_ms(&pPriv->tMode, HAMLIB_ELAPSED_INVALIDATE);
+            elapsed_ms(&pPriv->tPTT, HAMLIB_ELAPSED_INVALIDATE);
+
             // FIXME: pointless code at init time
 #if 0
             nRC = adat_get_conf(pRig, TOKEN_ADAT_PRODUCT_NAME, acBuf);
@@ -2924,11 +2964,19 @@ const char *adat_get_info(RIG *pRig)
 
     if (pRig != NULL)
     {
-        int nRC = adat_transaction(pRig, &adat_cmd_list_get_info);
+        adat_priv_data_ptr pPriv = (adat_priv_data_ptr) pRig->state.priv;
+        int nRC = RIG_OK;
+
+        // Serial number, versions and options stay put: read them once
+
+        if (!pPriv->nInfoValid)
+        {
+            nRC = adat_transaction(pRig, &adat_cmd_list_get_info);
+            pPriv->nInfoValid = (nRC == RIG_OK);
+        }
 
         if (nRC == RIG_OK)
         {
-            adat_priv_data_ptr pPriv = (adat_priv_data_ptr) pRig->state.priv;
 
             SNPRINTF(acBuf, sizeof(acBuf),
                      "ADAT ADT-200A, Callsign: %s, S/N: %s, ID Code: %s, Options: %s, FW: %s, GUI FW: %s, HW: %s",
@@ -2977,6 +3025,8 @@ int adat_set_freq(RIG *pRig, vfo_t vfo, freq_t freq)
 
         pPriv->nFreq = freq;
 
+        elapsed_ms(&pPriv->tFreq, HAMLIB_ELAPSED_INVALIDATE);
+
         nRC = adat_transaction(pRig, &adat_cmd_list_set_freq);
     }
 
@@ -3013,7 +3063,10 @@ int adat_get_freq(RIG *pRig, vfo_t vfo, freq_t *freq)
     {
         adat_priv_data_ptr pPriv = (adat_priv_data_ptr) pRig->state.priv;
 
-        nRC = adat_transaction(pRig, &adat_cmd_list_get_freq);
+        if (elapsed_ms(&pPriv->tFreq, HAMLIB_ELAPSED_GET) >= ADAT_CACHE_TTL_MS)
+        {
+            nRC = adat_transaction(pRig, &adat_cmd_list_get_freq);
+        }
 
         *freq = pPriv->nFreq;
     }
@@ -3134,6 +3187,9 @@ int adat_set_mode(RIG *pRig, vfo_t vfo, rmode_t mode, pbwidth_t width)
             pPriv->nWidth = width;
         }
 
+        elapsed_ms(&pPriv->tFreq, HAMLIB_ELAPSED_INVALIDATE);
+        elapsed_ms(&pPriv->tMode, HAMLIB_ELAPSED_INVALIDATE);
+
         nRC = adat_transaction(pRig, &adat_cmd_list_set_mode);
     }
 
@@ -3170,7 +3226,10 @@ int adat_get_mode(RIG *pRig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
     {
         adat_priv_data_ptr pPriv = (adat_priv_data_ptr) pRig->state.priv;
 
-        nRC =  adat_transaction(pRig, &adat_cmd_list_get_mode);
+        if (elapsed_ms(&pPriv->tMode, HAMLIB_ELAPSED_GET) >= ADAT_CACHE_TTL_MS)
+        {
+            nRC = adat_transaction(pRig, &adat_cmd_list_get_mode);
+        }
 
         if (nRC == RIG_OK)
         {
@@ -3212,7 +3271,10 @@ int adat_get_vfo(RIG *pRig, vfo_t *vfo)
     {
         adat_priv_data_ptr pPriv = (adat_priv_data_ptr) pRig->state.priv;
 
-        nRC = adat_transaction(pRig, &adat_cmd_list_get_vfo);
+        if (elapsed_ms(&pPriv->tFreq, HAMLIB_ELAPSED_GET) >= ADAT_CACHE_TTL_MS)
+        {
+            nRC = adat_transaction(pRig, &adat_cmd_list_get_vfo);
+        }
 
         *vfo = pPriv->nRIGVFONr;
     }
@@ -3254,6 +3316,9 @@ int adat_set_vfo(RIG *pRig, vfo_t vfo)
 
         if (nRC == RIG_OK)
         {
+            elapsed_ms(&pPriv->tFreq, HAMLIB_ELAPSED_INVALIDATE);
+            elapsed_ms(&pPriv->tMode, HAMLIB_ELAPSED_INVALIDATE);
+
             nRC = adat_transaction(pRig, &adat_cmd_list_set_vfo);
         }
     }
@@ -3291,7 +3356,10 @@ int adat_get_ptt(RIG *pRig, vfo_t vfo, ptt_t *ptt)
     {
         adat_priv_data_ptr pPriv = (adat_priv_data_ptr) pRig->state.priv;
 
-        nRC = adat_transaction(pRig, &adat_cmd_list_get_ptt);
+        if (elapsed_ms(&pPriv->tPTT, HAMLIB_ELAPSED_GET) >= ADAT_CACHE_TTL_MS)
+        {
+            nRC = adat_transaction(pRig, &adat_cmd_list_get_ptt);
+        }
 
         *ptt = pPriv->nRIGPTTStatus;
     }
@@ -3346,6 +3414,8 @@ int adat_set_ptt(RIG *pRig, vfo_t vfo, ptt_t ptt)
 
         if (nRC == RIG_OK)
         {
+            elapsed_ms(&pPriv->tPTT, HAMLIB_ELAPSED_INVALIDATE);
+
             nRC = adat_transaction(pRig, &adat_cmd_list_set_ptt);
         }
     }
@@ -3483,6 +3553,104 @@ int adat_get_powerstat(RIG *pRig, powerstat_t *status)
 }
 
 
+// ---------------------------------------------------------------------------
+// Function adat_get_bulk
+// ---------------------------------------------------------------------------
+// Status: RELEASED
+
+// Frequency, mode and PTT in one paced burst: display off is sent once for
+// all three queries. The frequency and mode are those of the current VFO,
+// so they answer FREQ/MODE of VFO A or B, whichever that is.
+int adat_get_bulk(RIG *pRig, struct rig_bulk *bulk)
+{
+    int nRC = RIG_OK;
+
+    gFnLevel++;
+
+    rig_debug(RIG_DEBUG_TRACE,
+              "*** ADAT: %d %s (%s:%d): ENTRY. Params: pRig = %p\n",
+              gFnLevel, __func__, __FILE__, __LINE__, pRig);
+
+    // Check Params
+
+    if ((pRig == NULL) || (bulk == NULL))
+    {
+        nRC = -RIG_EARG;
+    }
+    else
+    {
+        adat_priv_data_ptr pPriv = (adat_priv_data_ptr) pRig->state.priv;
+        int nFresh = 1;
+
+        if ((bulk->mask & (RIG_BULK_FREQ_A | RIG_BULK_FREQ_B))
+                && (elapsed_ms(&pPriv->tFreq, HAMLIB_ELAPSED_GET) >= ADAT_CACHE_TTL_MS))
+        {
+            nFresh = 0;
+        }
+
+        if ((bulk->mask & (RIG_BULK_MODE_A | RIG_BULK_MODE_B))
+                && (elapsed_ms(&pPriv->tMode, HAMLIB_ELAPSED_GET) >= ADAT_CACHE_TTL_MS))
+        {
+            nFresh = 0;
+        }
+
+        if ((bulk->mask & RIG_BULK_PTT)
+                && (elapsed_ms(&pPriv->tPTT, HAMLIB_ELAPSED_GET) >= ADAT_CACHE_TTL_MS))
+        {
+            nFresh = 0;
+        }
+
+        if (!nFresh)
+        {
+            nRC = adat_transaction(pRig, &adat_cmd_list_get_bulk);
+        }
+
+        if (elapsed_ms(&pPriv->tFreq, HAMLIB_ELAPSED_GET) < ADAT_CACHE_TTL_MS)
+        {
+            if (pPriv->nRIGVFONr == RIG_VFO_A)
+            {
+                bulk->freqA  = pPriv->nFreq;
+                bulk->valid |= RIG_BULK_FREQ_A;
+            }
+            else if (pPriv->nRIGVFONr == RIG_VFO_B)
+            {
+                bulk->freqB  = pPriv->nFreq;
+                bulk->valid |= RIG_BULK_FREQ_B;
+            }
+
+            if (elapsed_ms(&pPriv->tMode, HAMLIB_ELAPSED_GET) < ADAT_CACHE_TTL_MS)
+            {
+                if (pPriv->nRIGVFONr == RIG_VFO_A)
+                {
+                    bulk->modeA  = pPriv->nRIGMode;
+                    bulk->widthA = pPriv->nWidth;
+                    bulk->valid |= RIG_BULK_MODE_A;
+                }
+                else if (pPriv->nRIGVFONr == RIG_VFO_B)
+                {
+                    bulk->modeB  = pPriv->nRIGMode;
+                    bulk->widthB = pPriv->nWidth;
+                    bulk->valid |= RIG_BULK_MODE_B;
+                }
+            }
+        }
+
+        if (elapsed_ms(&pPriv->tPTT, HAMLIB_ELAPSED_GET) < ADAT_CACHE_TTL_MS)
+        {
+            bulk->ptt    = pPriv->nRIGPTTStatus;
+            bulk->valid |= RIG_BULK_PTT;
+        }
+    }
+
+    rig_debug(RIG_DEBUG_TRACE,
+              "*** ADAT: %d %s (%s:%d): EXIT. Return Code = %d\n",
+              gFnLevel, __func__, __FILE__, __LINE__, nRC);
+    gFnLevel--;
+
+    return nRC;
+}
+
+
 // ---------------------------------------------------------------------------
 // Function adat_set_conf
 // ---------------------------------------------------------------------------
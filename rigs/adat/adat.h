@@ -71,6 +71,7 @@
 #define TOKEN_ADAT_PRODUCT_NAME    TOKEN_BACKEND(1)
 
 #define ADAT_SLEEP_MICROSECONDS_BETWEEN_CMDS (11*1000) // = 11 ms
+#define ADAT_CACHE_TTL_MS          250 // replies younger than this are reused
 #define ADAT_SLEEP_AFTER_RIG_CLOSE  2 // unit: seconds
 #define ADAT_SLEEP_AFTER_RIG_OPEN   2 // unit: seconds
 
@@ -375,6 +376,13 @@ typedef struct _adat_priv_data
     value_t       mIFShift;
     value_t       mRawStr;
 
+    // ADAT Response Cache: when the values above were last read
+
+    struct timespec tFreq;      // nFreq, nCurrentVFO, nRIGVFONr
+    struct timespec tMode;      // nRIGMode, acADATMode
+    struct timespec tPTT;       // nADATPTTStatus, nRIGPTTStatus
+    int           nInfoValid;   // device info read, it does not change
+
     // ADAT Command-related Values
 
     char         *pcCmd;
@@ -598,6 +606,8 @@ int adat_power2mW(RIG *, unsigned int *, float, freq_t, rmode_t);
 
 int adat_get_powerstat(RIG *, powerstat_t *);
 
+int adat_get_bulk(RIG *, struct rig_bulk *);
+
 extern const struct rig_caps adt_200a_caps;
 
 // ---------------------------------------------------------------------------
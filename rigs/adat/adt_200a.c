@@ -205,6 +205,8 @@ const struct rig_caps adt_200a_caps =
     .mW2power           =  adat_mW2power,
 
     .get_powerstat      =  adat_get_powerstat,
+
+    .get_bulk           =  adat_get_bulk,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
 
@@ -33,6 +33,8 @@
 #include "misc.h"
 #include "register.h"
 #include "idx_builtin.h"
+#include "cal.h"
+#include "sweep.h"
 
 #include "aor.h"
 
@@ -1348,20 +1350,28 @@ int aor_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
 
 #define LINES_PER_MA    10
 
+/*
+ * aor_get_chan_all_cb
+ *
+ * Reads the memory with the MA listing instead of one MR/RX pair per
+ * channel: "MA<bank>" answers the first LINES_PER_MA channels of a bank,
+ * one per line, and each following "MA" the next ones.  With the 50/50
+ * bank split of aor_get_channel() a bank holds 50 channels, else 100.
+ * Empty channels are skipped, as get_chan_all_cb_generic() does.
+ */
 int aor_get_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb, rig_ptr_t arg)
 {
     struct aor_priv_caps *priv = (struct aor_priv_caps *)rig->caps->priv;
-    int i, j, retval;
+    int retval;
     chan_t *chan_list = rig->state.chan_list;
     channel_t *chan;
-    int chan_count;
+    int bank_size;
+    int ch;
     char aorcmd[BUFSZ];
     int chan_len;
     char chanbuf[BUFSZ];
-    int chan_next = chan_list[0].startc;
 
-
-    chan_count = chan_list[0].endc - chan_list[0].startc + 1;
+    bank_size = priv->bank_base1 != priv->bank_base2 ? 50 : 100;
 
     /*
      * setting chan to NULL means the application
@@ -1369,7 +1379,7 @@ int aor_get_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb, rig_ptr_t arg)
      * future data for channel channel_num
      */
     chan = NULL;
-    retval = chan_cb(rig, &chan, chan_next, chan_list, arg);
+    retval = chan_cb(rig, &chan, chan_list[0].startc, chan_list, arg);
 
     if (retval != RIG_OK)
     {
@@ -1381,30 +1391,24 @@ int aor_get_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb, rig_ptr_t arg)
         return -RIG_ENOMEM;
     }
 
-    SNPRINTF(aorcmd, sizeof(aorcmd), "MA%c" EOM,
-             priv->bank_base1);
-
-    for (i = 0; i < chan_count / LINES_PER_MA; i++)
+    for (ch = chan_list[0].startc; ch <= chan_list[0].endc; ch += bank_size)
     {
+        char bank_base = ch % 100 >= 50 && bank_size == 50 ?
+                         priv->bank_base2 : priv->bank_base1;
+        int i;
 
-        retval = aor_transaction(rig, aorcmd, strlen(aorcmd), chanbuf, &chan_len);
-
-        if (retval != RIG_OK)
-        {
-            return retval;
-        }
+        SNPRINTF(aorcmd, sizeof(aorcmd), "MA%c" EOM, bank_base + ch / 100);
 
-        for (j = 0; j < LINES_PER_MA; j++)
+        for (i = 0; i < bank_size / LINES_PER_MA; i++)
         {
+            int j;
 
-            chan->vfo = RIG_VFO_MEM;
-            chan->channel_num = i * LINES_PER_MA + j;
-
-            retval = parse_chan_line(rig, chan, chanbuf, &chan_list[0].mem_caps);
+            retval = aor_transaction(rig, aorcmd, strlen(aorcmd), chanbuf, &chan_len);
 
-            if (retval == -RIG_ENAVAIL)
+            /* no such bank on this unit */
+            if (retval == -RIG_EPROTO && chanbuf[0] == '?')
             {
-                retval = RIG_OK;
+                break;
             }
 
             if (retval != RIG_OK)
@@ -1412,33 +1416,108 @@ int aor_get_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb, rig_ptr_t arg)
                 return retval;
             }
 
-            /* notify the end? */
-            chan_next = chan_next < chan_list[i].endc ? chan_next + 1 : chan_next;
-
-            /*
-             * provide application with channel data,
-             * and ask for a new channel structure
-             */
-            chan_cb(rig, &chan, chan_next, chan_list, arg);
-
-            if (j >= LINES_PER_MA - 1)
+            for (j = 0; j < LINES_PER_MA; j++)
             {
-                break;
+                int num = ch + i * LINES_PER_MA + j;
+
+                if (j > 0)
+                {
+                    retval = read_string(&rig->state.rigport, (unsigned char *) chanbuf,
+                                         BUFSZ, EOM, strlen(EOM), 0, 1);
+
+                    if (retval < 0)
+                    {
+                        return retval;
+                    }
+
+                    chan_len = retval < BUFSZ ? retval : BUFSZ - 1;
+                    chanbuf[chan_len] = '\0';
+                }
+
+                if (num > chan_list[0].endc)
+                {
+                    continue;
+                }
+
+                chan->vfo = RIG_VFO_MEM;
+                chan->channel_num = num;
+
+                retval = parse_chan_line(rig, chan, chanbuf, &chan_list[0].mem_caps);
+
+                if (retval == -RIG_ENAVAIL)
+                {
+                    continue;
+                }
+
+                if (retval != RIG_OK)
+                {
+                    return retval;
+                }
+
+                /*
+                 * provide application with channel data,
+                 * and ask for a new channel structure
+                 */
+                chan_cb(rig, &chan, num < chan_list[0].endc ? num + 1 : num,
+                        chan_list, arg);
             }
 
-            /*
-             * get next line
-             */
-            retval = read_string(&rig->state.rigport, (unsigned char *) chanbuf, BUFSZ,
-                                 EOM, strlen(EOM), 0, 1);
+            SNPRINTF(aorcmd, sizeof(aorcmd), "MA" EOM);
+        }
+    }
 
-            if (retval < 0)
-            {
-                return retval;
-            }
+    return RIG_OK;
+}
+
+/*
+ * aor_get_sweep
+ *
+ * The bandscope of the AR8600 and AR5000 cannot be read back over the
+ * serial port, so a sweep tunes with RF and reads LM at each step, the
+ * raw reading converted through str_cal.  This skips the frontend work
+ * of rig_set_freq()/rig_get_level() that the generic sweep pays per step.
+ */
+int aor_get_sweep(RIG *rig, vfo_t vfo, const struct rig_sweep_cfg *cfg,
+                  unsigned char *data, size_t count)
+{
+    size_t i;
+
+    if (rig->state.str_cal.size == 0)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        struct timespec tuned;
+        value_t val;
+        double left;
+        int retval;
+
+        elapsed_ms(&tuned, HAMLIB_ELAPSED_SET);
+
+        retval = aor_set_freq(rig, vfo, cfg->start + i * cfg->step);
+
+        if (retval != RIG_OK)
+        {
+            return retval;
+        }
+
+        left = cfg->dwell_ms - elapsed_ms(&tuned, HAMLIB_ELAPSED_GET);
+
+        if (left > 0)
+        {
+            hl_usleep((rig_useconds_t)(left * 1000));
+        }
+
+        retval = aor_get_level(rig, vfo, RIG_LEVEL_RAWSTR, &val);
+
+        if (retval != RIG_OK)
+        {
+            return retval;
         }
 
-        SNPRINTF(aorcmd, sizeof(aorcmd), "MA" EOM);
+        data[i] = rig_sweep_level((int)rig_raw2val(val.i, &rig->state.str_cal));
     }
 
     return RIG_OK;
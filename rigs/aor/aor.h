@@ -63,6 +63,8 @@ int aor_set_bank(RIG *rig, vfo_t vfo, int bank);
 int aor_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only);
 int aor_set_channel(RIG *rig, vfo_t vfo, const channel_t *chan);
 int aor_get_chan_all_cb (RIG * rig, vfo_t vfo, chan_cb_t chan_cb, rig_ptr_t);
+int aor_get_sweep(RIG *rig, vfo_t vfo, const struct rig_sweep_cfg *cfg,
+                  unsigned char *data, size_t count);
 
 extern const struct rig_caps ar2700_caps;
 extern const struct rig_caps ar8200_caps;
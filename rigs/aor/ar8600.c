@@ -209,6 +209,7 @@ const struct rig_caps ar8600_caps =
     .get_channel = aor_get_channel,
 
     .get_chan_all_cb = aor_get_chan_all_cb,
+    .get_sweep = aor_get_sweep,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
 
@@ -181,5 +181,10 @@ const struct rig_caps barrett4050_caps =
     .set_split_freq =   barrett_set_split_freq,
     .set_split_vfo =    barrett_set_split_vfo,
     .get_split_vfo =    barrett_get_split_vfo,
+
+    .async_data_supported = 1,
+    .read_frame_direct = barrett_read_frame_direct,
+    .is_async_frame = barrett_is_async_frame,
+    .process_async_frame = barrett_process_async_frame,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
@@ -32,6 +32,8 @@
 #include "cal.h"
 #include "token.h"
 #include "register.h"
+#include "iofunc.h"
+#include "event.h"
 
 #include "barrett.h"
 
@@ -175,6 +177,127 @@ int barrett_transaction(RIG *rig, char *cmd, int expected, char **result)
 }
 
 
+/*
+ * ALE and selcall messages the radio sends unasked, framed like replies.
+ * After the keyword the fields are comma separated: calling and called
+ * address, then the channel; for a channel change the channel, then the
+ * receive frequency in Hz.  LINK END goes before LINK, first match wins.
+ */
+static const struct
+{
+    const char *key;
+    enum rig_ale_event_e type;
+} barrett_ale_msgs[] =
+{
+    { "ALE CALL", RIG_ALE_CALL },
+    { "ALE LINK END", RIG_ALE_UNLINK },
+    { "ALE LINK", RIG_ALE_LINK },
+    { "SELCALL", RIG_ALE_SELCALL },
+    { "CHANNEL", RIG_ALE_CHANNEL },
+};
+
+/* index in barrett_ale_msgs of the message in frame, -1 for a reply */
+static int barrett_ale_msg(const unsigned char *frame, size_t len)
+{
+    const char *p = (const char *) frame;
+    int i;
+
+    if (len > 0 && *p == 0x13)
+    {
+        p++;
+        len--;
+    }
+
+    for (i = 0; i < sizeof(barrett_ale_msgs) / sizeof(barrett_ale_msgs[0]); i++)
+    {
+        size_t n = strlen(barrett_ale_msgs[i].key);
+
+        if (len > n && strncmp(p, barrett_ale_msgs[i].key, n) == 0
+                && strchr(": \r", p[n]))
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * With the "async" conf set the frontend's reader takes every frame off
+ * the port, 0x13 to 0x11; the replies go on to barrett_transaction().
+ */
+int barrett_read_frame_direct(RIG *rig, size_t buffer_length,
+                              const unsigned char *buffer)
+{
+    return read_string_direct(&rig->state.rigport, (unsigned char *) buffer,
+                              buffer_length, "\x11", 1, 0, 1);
+}
+
+int barrett_is_async_frame(RIG *rig, size_t frame_length,
+                           const unsigned char *frame)
+{
+    return barrett_ale_msg(frame, frame_length) >= 0;
+}
+
+int barrett_process_async_frame(RIG *rig, size_t frame_length,
+                                 const unsigned char *frame)
+{
+    struct rig_ale_event ev;
+    char msg[BARRETT_DATA_LEN];
+    char *fields[4] = { "", "", "", "" };
+    char *p, *save = NULL;
+    int i = barrett_ale_msg(frame, frame_length);
+    int n;
+
+    if (i < 0)
+    {
+        return -RIG_EPROTO;
+    }
+
+    if (frame_length > 0 && frame[0] == 0x13)
+    {
+        frame++;
+        frame_length--;
+    }
+
+    if (frame_length >= sizeof(msg)) { frame_length = sizeof(msg) - 1; }
+
+    memcpy(msg, frame, frame_length);
+    msg[frame_length] = '\0';
+    msg[strcspn(msg, "\r\n\x11")] = '\0';
+
+    memset(&ev, 0, sizeof(ev));
+    ev.type = barrett_ale_msgs[i].type;
+    ev.channel = -1;
+    SNPRINTF(ev.text, sizeof(ev.text), "%s", msg);
+
+    p = msg + strlen(barrett_ale_msgs[i].key);
+    p += strspn(p, ": ");
+
+    for (n = 0, p = strtok_r(p, ",", &save); p && n < 4;
+            n++, p = strtok_r(NULL, ",", &save))
+    {
+        fields[n] = p + strspn(p, " ");
+    }
+
+    if (ev.type == RIG_ALE_CHANNEL)
+    {
+        if (*fields[0]) { ev.channel = atoi(fields[0]); }
+
+        ev.freq = atof(fields[1]);
+    }
+    else
+    {
+        SNPRINTF(ev.from, sizeof(ev.from), "%s", fields[0]);
+        SNPRINTF(ev.to, sizeof(ev.to), "%s", fields[1]);
+
+        if (*fields[2]) { ev.channel = atoi(fields[2]); }
+    }
+
+    return rig_fire_ale_event(rig, &ev);
+}
+
+
 int barrett_init(RIG *rig)
 {
     rig_debug(RIG_DEBUG_VERBOSE, "%s version %s\n", __func__,
@@ -852,5 +975,10 @@ const struct rig_caps barrett_caps =
 //  .get_trn =    dummy_get_trn,
 //  .power2mW =   dummy_power2mW,
 //  .mW2power =   dummy_mW2power,
+
+    .async_data_supported = 1,
+    .read_frame_direct = barrett_read_frame_direct,
+    .is_async_frame = barrett_is_async_frame,
+    .process_async_frame = barrett_process_async_frame,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
@@ -70,6 +70,13 @@ extern int barrett_set_split_vfo(RIG *rig, vfo_t rxvfo, split_t split,
 extern int barrett_get_split_vfo(RIG *rig, vfo_t rxvfo, split_t *split,
                                  vfo_t *txvfo);
 
+extern int barrett_read_frame_direct(RIG *rig, size_t buffer_length,
+                                     const unsigned char *buffer);
+extern int barrett_is_async_frame(RIG *rig, size_t frame_length,
+                                  const unsigned char *frame);
+extern int barrett_process_async_frame(RIG *rig, size_t frame_length,
+                                       const unsigned char *frame);
+
 
 
 
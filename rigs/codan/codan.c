@@ -32,6 +32,8 @@
 #include "cal.h"
 #include "token.h"
 #include "register.h"
+#include "iofunc.h"
+#include "event.h"
 
 #include "codan.h"
 
@@ -137,6 +139,119 @@ int codan_transaction(RIG *rig, char *cmd, int expected, char **result)
     return RIG_OK;
 }
 
+/*
+ * Messages CICS sends unasked, one line each, "KEYWORD: field, field".
+ * The fields are the calling and called address, then the channel; for a
+ * channel change the channel, then the frequency in kHz.  LEVELS lines
+ * are taken too, only to keep them from the replies.
+ */
+static const struct
+{
+    const char *key;
+    enum rig_ale_event_e type;
+} codan_ale_msgs[] =
+{
+    { "ALE-CALL", RIG_ALE_CALL },
+    { "ALE-LINK-END", RIG_ALE_UNLINK },
+    { "ALE-LINK", RIG_ALE_LINK },
+    { "SELCALL", RIG_ALE_SELCALL },
+    { "CHAN", RIG_ALE_CHANNEL },
+    { "LEVELS", 0 },
+};
+
+/* index in codan_ale_msgs of the message in frame, -1 for a reply */
+static int codan_ale_msg(const unsigned char *frame, size_t len)
+{
+    int i;
+
+    for (i = 0; i < sizeof(codan_ale_msgs) / sizeof(codan_ale_msgs[0]); i++)
+    {
+        size_t n = strlen(codan_ale_msgs[i].key);
+
+        if (len > n && strncmp((const char *) frame, codan_ale_msgs[i].key, n) == 0
+                && frame[n] == ':')
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+/*
+ * With the "async" conf set the frontend's reader takes every line off
+ * the port; the replies go on to codan_transaction().
+ */
+int codan_read_frame_direct(RIG *rig, size_t buffer_length,
+                            const unsigned char *buffer)
+{
+    return read_string_direct(&rig->state.rigport, (unsigned char *) buffer,
+                              buffer_length, "\x0a", 1, 0, 1);
+}
+
+int codan_is_async_frame(RIG *rig, size_t frame_length,
+                         const unsigned char *frame)
+{
+    return codan_ale_msg(frame, frame_length) >= 0;
+}
+
+int codan_process_async_frame(RIG *rig, size_t frame_length,
+                              const unsigned char *frame)
+{
+    struct rig_ale_event ev;
+    char msg[CODAN_DATA_LEN];
+    char *fields[4] = { "", "", "", "" };
+    char *p, *save = NULL;
+    int i = codan_ale_msg(frame, frame_length);
+    int n;
+
+    if (i < 0)
+    {
+        return -RIG_EPROTO;
+    }
+
+    if (codan_ale_msgs[i].type == 0)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: %.*s", __func__, (int) frame_length, frame);
+        return RIG_OK;
+    }
+
+    if (frame_length >= sizeof(msg)) { frame_length = sizeof(msg) - 1; }
+
+    memcpy(msg, frame, frame_length);
+    msg[frame_length] = '\0';
+    msg[strcspn(msg, "\r\n")] = '\0';
+
+    memset(&ev, 0, sizeof(ev));
+    ev.type = codan_ale_msgs[i].type;
+    ev.channel = -1;
+    SNPRINTF(ev.text, sizeof(ev.text), "%s", msg);
+
+    p = msg + strlen(codan_ale_msgs[i].key) + 1;
+
+    for (n = 0, p = strtok_r(p, ",", &save); p && n < 4;
+            n++, p = strtok_r(NULL, ",", &save))
+    {
+        fields[n] = p + strspn(p, " ");
+    }
+
+    if (ev.type == RIG_ALE_CHANNEL)
+    {
+        if (*fields[0]) { ev.channel = atoi(fields[0]); }
+
+        ev.freq = atof(fields[1]) * 1000;
+    }
+    else
+    {
+        SNPRINTF(ev.from, sizeof(ev.from), "%s", fields[0]);
+        SNPRINTF(ev.to, sizeof(ev.to), "%s", fields[1]);
+
+        if (*fields[2]) { ev.channel = atoi(fields[2]); }
+    }
+
+    return rig_fire_ale_event(rig, &ev);
+}
+
 int codan_init(RIG *rig)
 {
     rig_debug(RIG_DEBUG_VERBOSE, "%s version %s\n", __func__,
@@ -477,6 +592,11 @@ const struct rig_caps envoy_caps =
 
     .set_ptt =      codan_set_ptt,
     .get_ptt =      codan_get_ptt,
+
+    .async_data_supported = 1,
+    .read_frame_direct = codan_read_frame_direct,
+    .is_async_frame = codan_is_async_frame,
+    .process_async_frame = codan_process_async_frame,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
 
@@ -540,6 +660,11 @@ const struct rig_caps ngs_caps =
 
     .set_ptt =      codan_set_ptt,
     .get_ptt =      codan_get_ptt,
+
+    .async_data_supported = 1,
+    .read_frame_direct = codan_read_frame_direct,
+    .is_async_frame = codan_is_async_frame,
+    .process_async_frame = codan_process_async_frame,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
 
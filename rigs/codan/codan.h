@@ -56,5 +56,11 @@ extern int codan_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width);
 extern int codan_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
                             pbwidth_t *width);
 extern int codan_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt);
+extern int codan_read_frame_direct(RIG *rig, size_t buffer_length,
+                                   const unsigned char *buffer);
+extern int codan_is_async_frame(RIG *rig, size_t frame_length,
+                                const unsigned char *frame);
+extern int codan_process_async_frame(RIG *rig, size_t frame_length,
+                                     const unsigned char *frame);
 
 #endif /* _CODAN_H */
@@ -33,6 +33,9 @@
 #include <math.h>
 // cppcheck-suppress *
 #include <time.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #include "hamlib/rig.h"
 #include "dummy_common.h"
@@ -44,6 +47,7 @@
 #include "tones.h"
 #include "idx_builtin.h"
 #include "register.h"
+#include "event.h"
 
 #include "dummy.h"
 
@@ -85,6 +89,14 @@ struct dummy_priv_data
     char *magic_conf;
     int static_data;
 
+    int perf;           /* load test mode, see dummy_perf_chan() */
+    int latency_us;     /* simulated latency of each call, -1 for the default */
+    int event_rate;     /* frequency events per second, 0 for none */
+#ifdef HAVE_PTHREAD
+    pthread_t event_thread;
+    int event_thread_run;
+#endif
+
     //freq_t freq_vfoa;
     //freq_t freq_vfob;
 };
@@ -141,6 +153,18 @@ static const struct confparams dummy_cfg_params[] =
         TOK_CFG_STATIC_DATA, "static_data", "Static data", "Output only static data, no randomization of meter values",
         "0", RIG_CONF_CHECKBUTTON, { }
     },
+    {
+        TOK_CFG_PERF, "perf", "Performance mode", "No simulated delay and no backend logging, a baseline for daemon and library benchmarks",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_CFG_LATENCY, "latency_us", "Latency", "Simulated latency of each call in microseconds, -1 for 20 ms, or none in performance mode",
+        "-1", RIG_CONF_NUMERIC, { .n = { -1, 10000000, 1 } }
+    },
+    {
+        TOK_CFG_EVENT_RATE, "event_rate", "Event rate", "Frequency change events per second on VFO A, 0 for none",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 100000, 1 } }
+    },
     { RIG_CONF_END, NULL, }
 };
 
@@ -218,6 +242,76 @@ static void copy_chan(channel_t *dest, const channel_t *src)
     dest->ext_levels = saved_ext_levels;
 }
 
+/* the time a real rig would take to answer */
+static void dummy_delay(const struct dummy_priv_data *priv)
+{
+    int us = priv->latency_us;
+
+    if (us < 0)
+    {
+        us = priv->perf ? 0 : CMDSLEEP;
+    }
+
+    if (us > 0)
+    {
+        hl_usleep(us);
+    }
+}
+
+/*
+ * With perf=1, what load tests call the most (frequency, mode, VFO and
+ * PTT of VFO A and B) is answered by the dummy_perf_ paths: no logging,
+ * no ENTERFUNC/RETURNFUNC bookkeeping, no delay unless latency_us asks
+ * for one, and atomic loads and stores, so the event thread can move
+ * VFO A while clients read it.  Anything else takes the regular path.
+ */
+static channel_t *dummy_perf_chan(struct dummy_priv_data *priv, vfo_t vfo)
+{
+    if (vfo == RIG_VFO_CURR)
+    {
+        vfo = __atomic_load_n(&priv->curr_vfo, __ATOMIC_RELAXED);
+    }
+
+    switch (vfo)
+    {
+    case RIG_VFO_A:
+    case RIG_VFO_MAIN:
+        return &priv->vfo_a;
+
+    case RIG_VFO_B:
+    case RIG_VFO_SUB:
+        return &priv->vfo_b;
+
+    default:
+        return NULL;
+    }
+}
+
+#ifdef HAVE_PTHREAD
+/* moves VFO A by 10 Hz event_rate times a second and fires the event */
+static void *dummy_event_thread(void *arg)
+{
+    RIG *rig = arg;
+    struct dummy_priv_data *priv = (struct dummy_priv_data *)rig->state.priv;
+    rig_useconds_t period = 1000000 / priv->event_rate;
+    int step = 0;
+
+    while (__atomic_load_n(&priv->event_thread_run, __ATOMIC_ACQUIRE))
+    {
+        freq_t freq;
+
+        __atomic_load(&priv->vfo_a.freq, &freq, __ATOMIC_RELAXED);
+        freq += (step++ & 1) ? -10 : 10;
+        __atomic_store(&priv->vfo_a.freq, &freq, __ATOMIC_RELAXED);
+        rig_fire_freq_event(rig, RIG_VFO_A, freq);
+
+        hl_usleep(period > 0 ? period : 1);
+    }
+
+    return NULL;
+}
+#endif
+
 static int dummy_init(RIG *rig)
 {
     struct dummy_priv_data *priv;
@@ -302,6 +396,12 @@ static int dummy_init(RIG *rig)
     }
 
     priv->magic_conf = strdup("DX");
+    priv->perf = 0;
+    priv->latency_us = -1;
+    priv->event_rate = 0;
+#ifdef HAVE_PTHREAD
+    priv->event_thread_run = 0;
+#endif
 
     RETURNFUNC(RIG_OK);
 }
@@ -336,6 +436,8 @@ static int dummy_cleanup(RIG *rig)
 
 static int dummy_open(RIG *rig)
 {
+    struct dummy_priv_data *priv = (struct dummy_priv_data *)rig->state.priv;
+
     ENTERFUNC;
 
     if (rig->caps->rig_model == RIG_MODEL_DUMMY_NOVFO)
@@ -347,16 +449,43 @@ static int dummy_open(RIG *rig)
         rig->caps->get_vfo = NULL;
     }
 
-    usleep(CMDSLEEP);
+    dummy_delay(priv);
+
+#ifdef HAVE_PTHREAD
+
+    if (priv->event_rate > 0)
+    {
+        priv->event_thread_run = 1;
+
+        if (pthread_create(&priv->event_thread, NULL, dummy_event_thread, rig))
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: cannot start the event thread\n", __func__);
+            priv->event_thread_run = 0;
+        }
+    }
+
+#endif
 
     RETURNFUNC(RIG_OK);
 }
 
 static int dummy_close(RIG *rig)
 {
+    struct dummy_priv_data *priv = (struct dummy_priv_data *)rig->state.priv;
+
     ENTERFUNC;
 
-    usleep(CMDSLEEP);
+#ifdef HAVE_PTHREAD
+
+    if (priv->event_thread_run)
+    {
+        __atomic_store_n(&priv->event_thread_run, 0, __ATOMIC_RELEASE);
+        pthread_join(priv->event_thread, NULL);
+    }
+
+#endif
+
+    dummy_delay(priv);
 
     RETURNFUNC(RIG_OK);
 }
@@ -383,6 +512,18 @@ static int dummy_set_conf(RIG *rig, token_t token, const char *val)
         priv->static_data = atoi(val) ? 1 : 0;
         break;
 
+    case TOK_CFG_PERF:
+        priv->perf = atoi(val) ? 1 : 0;
+        break;
+
+    case TOK_CFG_LATENCY:
+        priv->latency_us = atoi(val) < 0 ? -1 : atoi(val);
+        break;
+
+    case TOK_CFG_EVENT_RATE:
+        priv->event_rate = atoi(val) < 0 ? 0 : atoi(val);
+        break;
+
     default:
         RETURNFUNC(-RIG_EINVAL);
     }
@@ -403,6 +544,22 @@ static int dummy_get_conf(RIG *rig, token_t token, char *val)
         strcpy(val, priv->magic_conf);
         break;
 
+    case TOK_CFG_STATIC_DATA:
+        sprintf(val, "%d", priv->static_data);
+        break;
+
+    case TOK_CFG_PERF:
+        sprintf(val, "%d", priv->perf);
+        break;
+
+    case TOK_CFG_LATENCY:
+        sprintf(val, "%d", priv->latency_us);
+        break;
+
+    case TOK_CFG_EVENT_RATE:
+        sprintf(val, "%d", priv->event_rate);
+        break;
+
     default:
         RETURNFUNC(-RIG_EINVAL);
     }
@@ -414,6 +571,20 @@ static int dummy_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
 {
     struct dummy_priv_data *priv = (struct dummy_priv_data *)rig->state.priv;
     char fstr[20];
+    channel_t *chan;
+
+    if (priv->perf && (chan = dummy_perf_chan(priv, vfo)))
+    {
+        dummy_delay(priv);
+        __atomic_store(&chan->freq, &freq, __ATOMIC_RELAXED);
+
+        if (!priv->split)
+        {
+            __atomic_store(&priv->curr->tx_freq, &freq, __ATOMIC_RELAXED);
+        }
+
+        return RIG_OK;
+    }
 
     ENTERFUNC;
 
@@ -424,7 +595,7 @@ static int dummy_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
     // we emulate a rig with 100Hz set freq interval limits -- truncation
     freq = freq - fmod(freq, 100);
 #endif
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     sprintf_freq(fstr, sizeof(fstr), freq);
     rig_debug(RIG_DEBUG_VERBOSE, "%s called: %s %s\n", __func__,
               rig_strvfo(vfo), fstr);
@@ -463,6 +634,14 @@ static int dummy_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
 static int dummy_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
 {
     struct dummy_priv_data *priv = (struct dummy_priv_data *)rig->state.priv;
+    channel_t *chan;
+
+    if (priv->perf && !rig->state.uplink && (chan = dummy_perf_chan(priv, vfo)))
+    {
+        dummy_delay(priv);
+        __atomic_load(&chan->freq, freq, __ATOMIC_RELAXED);
+        return RIG_OK;
+    }
 
     ENTERFUNC;
 
@@ -476,7 +655,7 @@ static int dummy_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
         RETURNFUNC(RIG_OK);
     }
 
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     rig_debug(RIG_DEBUG_VERBOSE, "%s called: %s\n", __func__, rig_strvfo(vfo));
 
     switch (vfo)
@@ -510,9 +689,28 @@ static int dummy_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
     struct dummy_priv_data *priv = (struct dummy_priv_data *)rig->state.priv;
     channel_t *curr = priv->curr;
     char buf[16];
+    channel_t *chan;
+
+    if (priv->perf && (chan = dummy_perf_chan(priv, vfo)))
+    {
+        dummy_delay(priv);
+
+        if (width == RIG_PASSBAND_NOCHANGE)
+        {
+            width = __atomic_load_n(&chan->width, __ATOMIC_RELAXED);
+        }
+        else if (width == RIG_PASSBAND_NORMAL)
+        {
+            width = rig_passband_normal(rig, mode);
+        }
+
+        __atomic_store_n(&chan->mode, mode, __ATOMIC_RELAXED);
+        __atomic_store_n(&chan->width, width, __ATOMIC_RELAXED);
+        return RIG_OK;
+    }
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     sprintf_freq(buf, sizeof(buf), width);
     rig_debug(RIG_DEBUG_VERBOSE, "%s called: %s %s %s\n", __func__,
               rig_strvfo(vfo), rig_strrmode(mode), buf);
@@ -573,9 +771,18 @@ static int dummy_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 static int dummy_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
 {
     struct dummy_priv_data *priv = (struct dummy_priv_data *)rig->state.priv;
+    channel_t *chan;
+
+    if (priv->perf && (chan = dummy_perf_chan(priv, vfo)))
+    {
+        dummy_delay(priv);
+        *mode = __atomic_load_n(&chan->mode, __ATOMIC_RELAXED);
+        *width = __atomic_load_n(&chan->width, __ATOMIC_RELAXED);
+        return RIG_OK;
+    }
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     rig_debug(RIG_DEBUG_VERBOSE, "%s called: %s\n", __func__, rig_strvfo(vfo));
 
     if (vfo == RIG_VFO_CURR) { vfo = rig->state.current_vfo; }
@@ -599,9 +806,20 @@ static int dummy_set_vfo(RIG *rig, vfo_t vfo)
 {
     struct dummy_priv_data *priv = (struct dummy_priv_data *)rig->state.priv;
     channel_t *curr = priv->curr;
+    channel_t *chan;
+
+    if (priv->perf && vfo != RIG_VFO_CURR && (chan = dummy_perf_chan(priv, vfo)))
+    {
+        dummy_delay(priv);
+        priv->last_vfo = priv->curr_vfo;
+        __atomic_store_n(&priv->curr_vfo, vfo, __ATOMIC_RELAXED);
+        priv->curr = chan;
+        rig->state.current_vfo = vfo;
+        return RIG_OK;
+    }
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     rig_debug(RIG_DEBUG_VERBOSE, "%s called: %s\n", __func__, rig_strvfo(vfo));
 
     if (vfo == RIG_VFO_CURR) { vfo = rig->state.current_vfo; }
@@ -663,8 +881,15 @@ static int dummy_get_vfo(RIG *rig, vfo_t *vfo)
 {
     struct dummy_priv_data *priv = (struct dummy_priv_data *)rig->state.priv;
 
+    if (priv->perf)
+    {
+        dummy_delay(priv);
+        *vfo = __atomic_load_n(&priv->curr_vfo, __ATOMIC_RELAXED);
+        return RIG_OK;
+    }
+
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     *vfo = priv->curr_vfo;
 
     RETURNFUNC(RIG_OK);
@@ -675,6 +900,13 @@ static int dummy_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 {
     struct dummy_priv_data *priv = (struct dummy_priv_data *)rig->state.priv;
 
+    if (priv->perf)
+    {
+        dummy_delay(priv);
+        __atomic_store_n(&priv->ptt, ptt, __ATOMIC_RELAXED);
+        return RIG_OK;
+    }
+
     ENTERFUNC;
     priv->ptt = ptt;
 
@@ -688,8 +920,16 @@ static int dummy_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
     int rc;
     int status = 0;
 
+    if (priv->perf && (rig->state.pttport.type.ptt == RIG_PTT_RIG
+                       || rig->state.pttport.type.ptt == RIG_PTT_NONE))
+    {
+        dummy_delay(priv);
+        *ptt = __atomic_load_n(&priv->ptt, __ATOMIC_RELAXED);
+        return RIG_OK;
+    }
+
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
 
     // sneak a look at the hardware PTT and OR that in with our result
     // as if it had keyed us
@@ -762,7 +1002,7 @@ static int dummy_get_dcd(RIG *rig, vfo_t vfo, dcd_t *dcd)
     static int twiddle = 0;
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     *dcd = (twiddle++ & 1) ? RIG_DCD_ON : RIG_DCD_OFF;
 
     RETURNFUNC(RIG_OK);
@@ -775,7 +1015,7 @@ static int dummy_set_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t rptr_shift)
     channel_t *curr = priv->curr;
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     curr->rptr_shift = rptr_shift;
 
     RETURNFUNC(RIG_OK);
@@ -788,7 +1028,7 @@ static int dummy_get_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t *rptr_shift)
     channel_t *curr = priv->curr;
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     *rptr_shift = curr->rptr_shift;
 
     RETURNFUNC(RIG_OK);
@@ -801,7 +1041,7 @@ static int dummy_set_rptr_offs(RIG *rig, vfo_t vfo, shortfreq_t rptr_offs)
     channel_t *curr = priv->curr;
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     curr->rptr_offs = rptr_offs;
 
     RETURNFUNC(RIG_OK);
@@ -826,7 +1066,7 @@ static int dummy_set_ctcss_tone(RIG *rig, vfo_t vfo, tone_t tone)
     channel_t *curr = priv->curr;
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     curr->ctcss_tone = tone;
 
     RETURNFUNC(RIG_OK);
@@ -839,7 +1079,7 @@ static int dummy_get_ctcss_tone(RIG *rig, vfo_t vfo, tone_t *tone)
     channel_t *curr = priv->curr;
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     *tone = curr->ctcss_tone;
 
     RETURNFUNC(RIG_OK);
@@ -852,7 +1092,7 @@ static int dummy_set_dcs_code(RIG *rig, vfo_t vfo, tone_t code)
     channel_t *curr = priv->curr;
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     curr->dcs_code = code;
 
     RETURNFUNC(RIG_OK);
@@ -865,7 +1105,7 @@ static int dummy_get_dcs_code(RIG *rig, vfo_t vfo, tone_t *code)
     channel_t *curr = priv->curr;
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     *code = curr->dcs_code;
 
     RETURNFUNC(RIG_OK);
@@ -878,7 +1118,7 @@ static int dummy_set_ctcss_sql(RIG *rig, vfo_t vfo, tone_t tone)
     channel_t *curr = priv->curr;
 
     ENTERFUNC;
-    usleep(CMDSLEEP);
+    dummy_delay(rig->state.priv);
     curr->ctcss_sql = tone;
 
     RETURNFUNC(RIG_OK);
@@ -2094,6 +2334,9 @@ static int dummy_send_dtmf(RIG *rig, vfo_t vfo, const char *digits)
     ENTERFUNC;
     rig_debug(RIG_DEBUG_VERBOSE, "%s called: %s\n", __func__, digits);
 
+    /* hears its own tones, so the DTMF callback can be tried without a rig */
+    rig_fire_dtmf_event(rig, vfo, digits);
+
     RETURNFUNC(RIG_OK);
 }
 
@@ -2661,9 +2904,10 @@ DECLARE_INITRIG_BACKEND(dummy)
 
     rig_register(&dummy_caps);
     rig_register(&netrigctl_caps);
+    rig_register(&netmcast_caps);
     rig_register(&flrig_caps);
     rig_register(&trxmanager_caps);
     rig_register(&dummy_no_vfo_caps);
-//    rig_register(&tci1x_caps);
+    rig_register(&tci1x_caps);
     return RIG_OK;
 }
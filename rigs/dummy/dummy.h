@@ -28,6 +28,9 @@
 /* backend conf */
 #define TOK_CFG_MAGICCONF    TOKEN_BACKEND(1)
 #define TOK_CFG_STATIC_DATA  TOKEN_BACKEND(2)
+#define TOK_CFG_PERF         TOKEN_BACKEND(3)
+#define TOK_CFG_LATENCY      TOKEN_BACKEND(4)
+#define TOK_CFG_EVENT_RATE   TOKEN_BACKEND(5)
 
 
 /* ext_level's and ext_parm's tokens */
@@ -42,10 +45,14 @@
 extern struct rig_caps dummy_caps;
 extern struct rig_caps dummy_no_vfo_caps;
 extern struct rig_caps netrigctl_caps;
+extern struct rig_caps netmcast_caps;
 extern const struct rig_caps flrig_caps;
 extern const struct rig_caps trxmanager_caps;
 extern const struct rig_caps tci1x_caps;
 
 int netrigctl_get_vfo_mode(RIG *);
+int parse_array_int(const char *s, const char *delim, int *array, int array_len);
+int parse_array_double(const char *s, const char *delim, double *array,
+                       int array_len);
 
 #endif /* _DUMMY_H */
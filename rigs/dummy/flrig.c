@@ -90,6 +90,7 @@ static int flrig_get_split_freq_mode(RIG *rig, vfo_t vfo, freq_t *freq,
                                      rmode_t *mode, pbwidth_t *width);
 static int flrig_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val);
 static int flrig_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val);
+static int flrig_get_bulk(RIG *rig, struct rig_bulk *bulk);
 
 static int flrig_set_ext_parm(RIG *rig, token_t token, value_t val);
 static int flrig_get_ext_parm(RIG *rig, token_t token, value_t *val);
@@ -118,6 +119,8 @@ struct flrig_priv_data
     int has_get_bwA; /* True if this function is available */
     int has_set_bwA; /* True if this function is available */
     int has_verify_cmds; // has the verify cmd in FLRig 1.3.54.1 or higher
+    int has_multicall; /* True until system.multicall fails */
+    int reconnect; /* flrig did not keep the connection alive */
     float powermeter_scale;  /* So we can scale power meter to 0-1 */
     value_t parms[RIG_SETTING_MAX];
     struct ext_list *ext_parms;
@@ -208,6 +211,7 @@ const struct rig_caps flrig_caps =
     .get_split_freq_mode = flrig_get_split_freq_mode,
     .set_level = flrig_set_level,
     .get_level = flrig_get_level,
+    .get_bulk = flrig_get_bulk,
     .set_ext_parm =  flrig_set_ext_parm,
     .get_ext_parm =  flrig_get_ext_parm,
     .power2mW =   flrig_power2mW,
@@ -271,13 +275,13 @@ static int check_vfo(vfo_t vfo)
 /*Rather than use some huge XML library we only need a few things
 * So we'll hand craft them
 * xml_build takes a value and return an xml string for FLRig
+* The connection is kept alive between requests, see read_transaction
 */
-static char *xml_build(RIG *rig, char *cmd, char *value, char *xmlbuf,
-                       int xmlbuflen)
+static char *xml_build(RIG *rig, const char *cmd, const char *value,
+                       char *xmlbuf, int xmlbuflen)
 {
-    char xml[4096]; // we shouldn't need more the 4096 bytes for this
-    char tmp[32];
-    char *header;
+    char xml[MAXXMLLEN];
+    int len;
 
     // We want at least a 4K buf to play with
     if (xmlbuflen < 4096)
@@ -286,91 +290,133 @@ static char *xml_build(RIG *rig, char *cmd, char *value, char *xmlbuf,
         return NULL;
     }
 
-    header =
-        "POST /RPC2 HTTP/1.1\r\n" "User-Agent: XMLRPC++ 0.8\r\n"
-        "Host: 127.0.0.1:12345\r\n" "Content-type: text/xml\r\n";
-    SNPRINTF(xmlbuf, xmlbuflen, "%s", header);
+    len = snprintf(xml, sizeof(xml),
+                   "<?xml version=\"1.0\"?>\r\n<?clientid=\"hamlib(%d)\"?>\r\n"
+                   "<methodCall><methodName>%s</methodName>\r\n%s</methodCall>\r\n",
+                   rig->state.rigport.client_port, cmd, value ? value : "");
 
-    SNPRINTF(xml, sizeof(xml),
-             "<?xml version=\"1.0\"?>\r\n<?clientid=\"hamlib(%d)\"?>\r\n",
-             rig->state.rigport.client_port);
+    if (len < 0 || len >= (int)sizeof(xml))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s request too long\n", __func__, cmd);
+        return NULL;
+    }
 
-    strncat(xml, "<methodCall><methodName>", sizeof(xml) - 1);
-    strncat(xml, cmd, sizeof(xml) - strlen(xml) - 1);
-    strncat(xml, "</methodName>\r\n", sizeof(xml) - strlen(xml) - 1);
+    len = snprintf(xmlbuf, xmlbuflen,
+                   "POST /RPC2 HTTP/1.1\r\n" "User-Agent: XMLRPC++ 0.8\r\n"
+                   "Host: 127.0.0.1:12345\r\n" "Connection: keep-alive\r\n"
+                   "Content-type: text/xml\r\n" "Content-length: %d\r\n\r\n%s",
+                   len, xml);
 
-    if (value && strlen(value) > 0)
+    if (len < 0 || len >= xmlbuflen)
     {
-        strncat(xml, value, sizeof(xml) - 1);
+        rig_debug(RIG_DEBUG_ERR, "%s: %s request too long\n", __func__, cmd);
+        return NULL;
     }
 
-    strncat(xml, "</methodCall>\r\n", sizeof(xml) - 1);
-    strncat(xmlbuf, "Content-length: ", xmlbuflen - 1);
-    SNPRINTF(tmp, sizeof(tmp), "%d\r\n\r\n", (int)strlen(xml));
-    strncat(xmlbuf, tmp, xmlbuflen - 1);
-    strncat(xmlbuf, xml, xmlbuflen - 1);
     return xmlbuf;
 }
 
+/*
+* xml_value_next
+* Finds the next <value> element in [xml, end) and the matching </value>,
+* skipping the ones nested in it.  Returns its contents in *start and
+* *stop, or NULL if there is no complete element, else where to continue.
+*/
+static char *xml_value_next(char *xml, const char *end, char **start,
+                            char **stop)
+{
+    char *p;
+    int depth = 1;
+
+    for (p = xml; p + 7 <= end; p++)
+    {
+        if (*p == '<' && strncmp(p, "<value>", 7) == 0) { break; }
+    }
+
+    if (p + 7 > end) { return NULL; }
+
+    *start = p += 7;
+
+    for (; p + 8 <= end; p++)
+    {
+        if (*p != '<') { continue; }
+
+        if (strncmp(p, "<value>", 7) == 0)
+        {
+            depth++;
+        }
+        else if (strncmp(p, "</value>", 8) == 0 && --depth == 0)
+        {
+            *stop = p;
+            return p + 8;
+        }
+    }
+
+    return NULL;
+}
+
 /*This is a very crude xml parse specific to what we need from FLRig
 * This works for strings, doubles, I4-type values, and arrays
-* Arrays are returned pipe delimited
+* Arrays, and structs, are returned pipe delimited
+* It scans xml in place, no copy is made
 */
-static char *xml_parse2(char *xml, char *value, int valueLen)
+static char *xml_parse2(const char *xml, char *value, int valueLen)
 {
-    char *delims = "<>\r\n ";
-    char *xmltmp = strdup(xml);
-    //rig_debug(RIG_DEBUG_TRACE, "%s: xml='%s'\n", __func__,xml);
-    char *pr = xml;
-    char *p = strtok_r(xmltmp, delims, &pr);
+    const char *p = xml;
+    int len = 0;
+
     value[0] = 0;
 
-    while (p)
+    while ((p = strstr(p, "<value>")) != NULL)
     {
-        if (streq(p, "value"))
+        const char *s = p + 7;
+        const char *e;
+
+        // skip the type tag, arrays and structs have their own <value>s
+        while (*s == '<' && (strncmp(s, "<i4>", 4) == 0
+                             || strncmp(s, "<int>", 5) == 0
+                             || strncmp(s, "<double>", 8) == 0
+                             || strncmp(s, "<string>", 8) == 0
+                             || strncmp(s, "<boolean>", 9) == 0))
         {
-            p = strtok_r(NULL, delims, &pr);
+            s = strchr(s, '>') + 1;
+        }
 
-            if (streq(p, "array")) { continue; }
+        p = s;
 
-            if (streq(p, "/value")) { continue; } // empty value
+        if (*s == '<') { continue; } // empty value, array or struct
 
-            if (streq(p, "i4") || streq(p, "double") || streq(p, "int")
-                    || streq(p, " string"))
-            {
-                p = strtok_r(NULL, delims, &pr);
-            }
-            else if (streq(p, "array"))
-            {
-                strtok_r(NULL, delims, &pr);
-                p = strtok_r(NULL, delims, &pr);
-            }
+        while (*s == ' ' || *s == '\r' || *s == '\n' || *s == '\t') { s++; }
 
-            if (strlen(value) + strlen(p) + 1 < valueLen)
-            {
-                if (value[0] != 0) { strcat(value, "|"); }
+        for (e = s; *e && *e != '<'; e++) {}
 
-                strcat(value, p);
-            }
-            else   // we'll just stop adding stuff
-            {
-                rig_debug(RIG_DEBUG_ERR, "%s: max value length exceeded\n", __func__);
-            }
+        while (e > s && (e[-1] == ' ' || e[-1] == '\r' || e[-1] == '\n'
+                         || e[-1] == '\t')) { e--; }
+
+        if (e == s) { continue; }
+
+        if (len + (e - s) + 2 < valueLen)
+        {
+            if (len) { value[len++] = '|'; }
+
+            memcpy(value + len, s, e - s);
+            len += e - s;
+            value[len] = 0;
         }
-        else
+        else   // we'll just stop adding stuff
         {
-            p = strtok_r(NULL, delims, &pr);
+            rig_debug(RIG_DEBUG_ERR, "%s: max value length exceeded\n", __func__);
+            break;
         }
     }
 
     rig_debug(RIG_DEBUG_TRACE, "%s: value returned='%s'\n", __func__, value);
 
-    if (rig_need_debug(RIG_DEBUG_WARN) && value != NULL && strlen(value) == 0)
+    if (rig_need_debug(RIG_DEBUG_WARN) && len == 0)
     {
         rig_debug(RIG_DEBUG_ERR, "%s: xml='%s'\n", __func__, xml);
     }
 
-    free(xmltmp);
     return value;
 }
 
@@ -402,31 +448,70 @@ static char *xml_parse(char *xml, char *value, int value_len)
 
     next = strchr(pxml + 1, '<');
 
-    if (value != NULL)
+    if (next && strstr(next, "faultString"))
     {
-        xml_parse2(next, value, value_len);
+        rig_debug(RIG_DEBUG_ERR, "%s error:\n%s\n", __func__, next);
+        value[0] = 0; /* give empty response */
+        return (value);
     }
 
-    if (value && strstr(value, "faultString"))
+    if (next)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s error:\n%s\n", __func__, value);
-        value[0] = 0; /* truncate to give empty response */
+        xml_parse2(next, value, value_len);
     }
 
     return (value);
 }
 
+/*
+* flrig_reconnect
+* flrig closes the connection when it does not want to keep it alive, open
+* a new one for the next request
+*/
+static int flrig_reconnect(RIG *rig)
+{
+    struct flrig_priv_data *priv = (struct flrig_priv_data *) rig->state.priv;
+    hamlib_port_t *rp = &rig->state.rigport;
+
+    priv->reconnect = 0;
+
+    if (rp->type.rig != RIG_PORT_NETWORK)
+    {
+        return RIG_OK;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: reopening %s\n", __func__, rp->pathname);
+
+    /* not network_close(), which would tear down Winsock */
+    if (rp->fd > 0)
+    {
+#ifdef __MINGW32__
+        closesocket(rp->fd);
+#else
+        close(rp->fd);
+#endif
+        rp->fd = 0;
+    }
+
+    return network_open(rp, 12345);
+}
+
 /*
 * read_transaction
 * Assumes rig!=NULL, xml!=NULL, xml_len>=MAXXMLLEN
+* Reads the response headers line by line, then the body in one read of
+* its Content-length, all into xml
 */
 static int read_transaction(RIG *rig, char *xml, int xml_len)
 {
-    int retval;
     int retry;
     char *delims;
     char *terminator = "</methodResponse>";
     struct rig_state *rs = &rig->state;
+    struct flrig_priv_data *priv = (struct flrig_priv_data *) rs->priv;
+    int len = 0;
+    int content_length = -1;
+    int keep_alive = 1;
 
     ENTERFUNC;
 
@@ -434,70 +519,110 @@ static int read_transaction(RIG *rig, char *xml, int xml_len)
     delims = "\n";
     xml[0] = 0;
 
-    do
+    // the status line and headers up to the empty line
+    while (1)
     {
-        char tmp_buf[MAXXMLLEN];        // plenty big for expected flrig responses hopefully
+        char *line = xml + len;
+        int n = read_string(&rs->rigport, (unsigned char *) line, xml_len - len,
+                            delims, strlen(delims), 0, 1);
 
-        if (retry < 2)
+        if (n <= 0)
         {
-            rig_debug(RIG_DEBUG_WARN, "%s: retry needed? retry=%d\n", __func__, retry);
+            rig_debug(RIG_DEBUG_ERR, "%s: read_string error=%d\n", __func__, n);
+
+            if (retry-- > 0 && len == 0) { continue; }
+
+            line[0] = 0;
+            priv->reconnect = 1;
+            RETURNFUNC(n < 0 ? n : -RIG_ETIMEOUT);
         }
 
-        int len = read_string(&rs->rigport, (unsigned char *) tmp_buf, sizeof(tmp_buf),
-                              delims,
-                              strlen(delims), 0, 1);
-        rig_debug(RIG_DEBUG_TRACE, "%s: string='%s'\n", __func__, tmp_buf);
+        rig_debug(RIG_DEBUG_TRACE, "%s: string='%s'\n", __func__, line);
 
-        // if our first response we should see the HTTP header
-        if (strlen(xml) == 0 && strstr(tmp_buf, "HTTP/1.1 200 OK") == NULL)
+        if (len == 0)
         {
-            rig_debug(RIG_DEBUG_ERR, "%s: Expected 'HTTP/1.1 200 OK', got '%s'\n", __func__,
-                      tmp_buf);
-            continue; // we'll try again
-        }
+            // if our first response we should see the HTTP header
+            if (strstr(line, " 200 OK") == NULL)
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: Expected 'HTTP/1.1 200 OK', got '%s'\n",
+                          __func__, line);
 
-        if (len > 0) { retry = 3; }
+                if (retry-- > 0) { continue; }
 
-        if (len <= 0)
+                line[0] = 0;
+                RETURNFUNC(-RIG_EPROTO);
+            }
+
+            keep_alive = strncmp(line, "HTTP/1.0", 8) != 0;
+        }
+        else if (strcmp(line, "\r\n") == 0 || strcmp(line, "\n") == 0)
         {
-            rig_debug(RIG_DEBUG_ERR, "%s: read_string error=%d\n", __func__, len);
-            continue;
+            len += n;
+            break;
         }
-
-        if (strlen(xml) + strlen(tmp_buf) < xml_len - 1)
+        else if (strncasecmp(line, "Content-length:", 15) == 0)
         {
-            strncat(xml, tmp_buf, xml_len - 1);
+            content_length = atoi(line + 15);
         }
-        else
+        else if (strncasecmp(line, "Connection:", 11) == 0)
         {
-            rig_debug(RIG_DEBUG_ERR,
-                      "%s: xml buffer overflow!!\nTrying to add len=%d\nTo len=%d\n", __func__,
-                      (int)strlen(tmp_buf), (int)strlen(xml));
+            keep_alive = strstr(line, "lose") == NULL;
+        }
+
+        len += n;
+
+        if (len >= xml_len - 1)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: xml buffer overflow!!\n", __func__);
+            priv->reconnect = 1;
             RETURNFUNC(-RIG_EPROTO);
         }
     }
-    while (retry-- > 0 && strstr(xml, terminator) == NULL);
 
-    if (retry == 0)
+    if (content_length >= 0 && content_length < xml_len - len)
     {
-        rig_debug(RIG_DEBUG_WARN, "%s: retry timeout\n", __func__);
-        RETURNFUNC(-RIG_ETIMEOUT);
-    }
+        int n = read_block(&rs->rigport, (unsigned char *) xml + len,
+                           content_length);
 
-    if (strstr(xml, terminator))
-    {
-        rig_debug(RIG_DEBUG_TRACE, "%s: got %s\n", __func__, terminator);
-        // Slow down just a bit -- not sure this is needed anymore but not a big deal here
-        hl_usleep(2 * 1000);
-        retval = RIG_OK;
+        if (n < 0)
+        {
+            xml[len] = 0;
+            priv->reconnect = 1;
+            RETURNFUNC(n);
+        }
+
+        len += n;
+        xml[len] = 0;
     }
     else
+    {
+        // no usable Content-length, read lines up to the terminator
+        rig_debug(RIG_DEBUG_WARN, "%s: Content-length=%d\n", __func__,
+                  content_length);
+        keep_alive = 0;
+
+        while (strstr(xml, terminator) == NULL && len < xml_len - 1)
+        {
+            int n = read_string(&rs->rigport, (unsigned char *) xml + len,
+                                xml_len - len, delims, strlen(delims), 0, 1);
+
+            if (n <= 0) { break; }
+
+            len += n;
+        }
+    }
+
+    if (!keep_alive) { priv->reconnect = 1; }
+
+    if (strstr(xml, terminator) == NULL)
     {
         rig_debug(RIG_DEBUG_VERBOSE, "%s: did not get %s\n", __func__, terminator);
-        retval = -(101 + RIG_EPROTO);
+        priv->reconnect = 1;
+        RETURNFUNC(-(101 + RIG_EPROTO));
     }
 
-    RETURNFUNC(retval);
+    rig_debug(RIG_DEBUG_TRACE, "%s: got %s\n", __func__, terminator);
+    RETURNFUNC(RIG_OK);
 }
 
 /*
@@ -540,6 +665,58 @@ static int write_transaction(RIG *rig, char *xml, int xml_len)
     RETURNFUNC(retval);
 }
 
+/*
+* flrig_call
+* One request and its response, read into xml
+*/
+static int flrig_call(RIG *rig, const char *cmd, const char *cmd_arg,
+                      char *xml, int xml_len)
+{
+    struct flrig_priv_data *priv = (struct flrig_priv_data *) rig->state.priv;
+    char *pxml;
+    int retval;
+
+    xml[0] = 0;
+
+    if (priv->reconnect && flrig_reconnect(rig) != RIG_OK)
+    {
+        priv->reconnect = 1;
+        return -RIG_EIO;
+    }
+
+    pxml = xml_build(rig, cmd, cmd_arg, xml, xml_len);
+
+    if (pxml == NULL) { return -RIG_EINVAL; }
+
+    retval = write_transaction(rig, pxml, strlen(pxml));
+
+    if (retval == -RIG_EIO)
+    {
+        // flrig may have dropped an idle connection, try a new one once
+        if (flrig_reconnect(rig) != RIG_OK)
+        {
+            priv->reconnect = 1;
+            return retval;
+        }
+
+        pxml = xml_build(rig, cmd, cmd_arg, xml, xml_len);
+        retval = write_transaction(rig, pxml, strlen(pxml));
+    }
+
+    if (retval != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: write_transaction error=%d\n", __func__, retval);
+
+        // if we get RIG_EIO the socket has probably disappeared
+        // so bubble up the error so port can re re-opened
+        if (retval == -RIG_EIO) { return retval; }
+
+        hl_usleep(50 * 1000); // 50ms sleep if error
+    }
+
+    return read_transaction(rig, xml, xml_len); // this might time out -- that's OK
+}
+
 static int flrig_transaction(RIG *rig, char *cmd, char *cmd_arg, char *value,
                              int value_len)
 {
@@ -558,7 +735,6 @@ static int flrig_transaction(RIG *rig, char *cmd, char *cmd_arg, char *value,
 
     do
     {
-        char *pxml;
         int retval;
 
         if (retry != 3)
@@ -566,21 +742,9 @@ static int flrig_transaction(RIG *rig, char *cmd, char *cmd_arg, char *value,
             rig_debug(RIG_DEBUG_VERBOSE, "%s: cmd=%s, retry=%d\n", __func__, cmd, retry);
         }
 
-        pxml = xml_build(rig, cmd, cmd_arg, xml, sizeof(xml));
-        retval = write_transaction(rig, pxml, strlen(pxml));
+        retval = flrig_call(rig, cmd, cmd_arg, xml, sizeof(xml));
 
-        if (retval != RIG_OK)
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s: write_transaction error=%d\n", __func__, retval);
-
-            // if we get RIG_EIO the socket has probably disappeared
-            // so bubble up the error so port can re re-opened
-            if (retval == -RIG_EIO) { set_transaction_inactive(rig); RETURNFUNC(retval); }
-
-            hl_usleep(50 * 1000); // 50ms sleep if error
-        }
-
-        read_transaction(rig, xml, sizeof(xml)); // this might time out -- that's OK
+        if (retval == -RIG_EIO) { set_transaction_inactive(rig); RETURNFUNC(retval); }
 
         // we get an uknown response if function does not exist
         if (strstr(xml, "unknown")) { set_transaction_inactive(rig); RETURNFUNC(RIG_ENAVAIL); }
@@ -604,6 +768,84 @@ static int flrig_transaction(RIG *rig, char *cmd, char *cmd_arg, char *value,
     RETURNFUNC(RIG_OK);
 }
 
+/*
+* flrig_multicall
+* Sends cmds[0..n-1], none taking arguments, in one system.multicall
+* request.  values[i] gets the value of cmds[i], empty if it failed.
+* Returns -RIG_ENAVAIL if flrig does not know system.multicall.
+*/
+static int flrig_multicall(RIG *rig, const char *const cmds[], int n,
+                           char values[][MAXARGLEN])
+{
+    char arg[MAXXMLLEN];
+    char xml[MAXXMLLEN];
+    char *p;
+    char *end;
+    char *start;
+    char *stop;
+    int len;
+    int i;
+    int retval;
+
+    ENTERFUNC;
+
+    len = snprintf(arg, sizeof(arg), "<params><param><value><array><data>");
+
+    for (i = 0; i < n; i++)
+    {
+        len += snprintf(arg + len, sizeof(arg) - len,
+                        "<value><struct><member><name>methodName</name>"
+                        "<value>%s</value></member><member><name>params</name>"
+                        "<value><array><data></data></array></value></member>"
+                        "</struct></value>", cmds[i]);
+        values[i][0] = 0;
+    }
+
+    len += snprintf(arg + len, sizeof(arg) - len,
+                    "</data></array></value></param></params>\r\n");
+
+    if (len >= (int)sizeof(arg)) { RETURNFUNC(-RIG_EINVAL); }
+
+    set_transaction_active(rig);
+    retval = flrig_call(rig, "system.multicall", arg, xml, sizeof(xml));
+    set_transaction_inactive(rig);
+
+    if (retval != RIG_OK) { RETURNFUNC(retval); }
+
+    if (strstr(xml, " 200 OK") == NULL || (p = strstr(xml, "<params>")) == NULL)
+    {
+        // a fault for the multicall itself, not for one of its calls
+        RETURNFUNC(strstr(xml, "faultString") ? -RIG_ENAVAIL : -RIG_EPROTO);
+    }
+
+    end = xml + strlen(xml);
+
+    // the array of results, each a one value array or a fault struct
+    if (xml_value_next(p, end, &start, &stop) == NULL) { RETURNFUNC(-RIG_EPROTO); }
+
+    p = start;
+
+    for (i = 0; i < n && (p = xml_value_next(p, stop, &start, &end)) != NULL; i++)
+    {
+        char c = *end;
+
+        *end = 0;
+
+        if (strstr(start, "faultString"))
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: %s failed\n", __func__, cmds[i]);
+        }
+        else
+        {
+            xml_parse2(start, values[i], MAXARGLEN);
+        }
+
+        *end = c;
+    }
+
+    RETURNFUNC(i == n ? RIG_OK : -RIG_EPROTO);
+}
+
 /*
 * flrig_init
 * Assumes rig!=NULL
@@ -638,6 +880,7 @@ static int flrig_init(RIG *rig)
     priv->curr_modeB = -1;
     priv->curr_widthA = -1;
     priv->curr_widthB = -1;
+    priv->has_multicall = 1;
 
     if (!rig->caps)
     {
@@ -1292,7 +1535,6 @@ static int flrig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 static int flrig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
 {
     char value[MAXCMDLEN];
-    char xml[MAXXMLLEN];
     struct flrig_priv_data *priv = (struct flrig_priv_data *) rig->state.priv;
 
     ENTERFUNC;
@@ -1308,7 +1550,6 @@ static int flrig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
         RETURNFUNC(retval);
     }
 
-    xml_parse(xml, value, sizeof(value));
     *ptt = atoi(value);
     rig_debug(RIG_DEBUG_TRACE, "%s: '%s'\n", __func__, value);
 
@@ -2184,6 +2425,137 @@ static int flrig_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
     RETURNFUNC(RIG_OK);
 }
 
+/*
+* flrig_get_bulk
+* assumes rig!=NULL, rig->state.priv!=NULL
+* One system.multicall for everything asked for; the generic fallback
+* takes over if flrig does not know system.multicall
+*/
+static int flrig_get_bulk(RIG *rig, struct rig_bulk *bulk)
+{
+    const char *cmds[10];
+    rig_bulk_t bits[10];
+    char values[10][MAXARGLEN];
+    int n = 0;
+    int i;
+    int retval;
+    struct flrig_priv_data *priv = (struct flrig_priv_data *) rig->state.priv;
+
+    ENTERFUNC;
+
+    if (!priv->has_multicall) { RETURNFUNC(-RIG_ENIMPL); }
+
+    if (bulk->mask & RIG_BULK_FREQ_A) { bits[n] = RIG_BULK_FREQ_A; cmds[n++] = "rig.get_vfoA"; }
+
+    if (bulk->mask & RIG_BULK_FREQ_B) { bits[n] = RIG_BULK_FREQ_B; cmds[n++] = "rig.get_vfoB"; }
+
+    // without get_modeA/get_bwA mode B needs a VFO swap, and the cached mode
+    // is used while transmitting, leave those to get_mode
+    if (priv->has_get_modeA && priv->has_get_bwA && !priv->ptt)
+    {
+        if (bulk->mask & RIG_BULK_MODE_A)
+        {
+            bits[n] = RIG_BULK_MODE_A; cmds[n++] = "rig.get_modeA";
+            bits[n] = RIG_BULK_MODE_A; cmds[n++] = "rig.get_bwA";
+        }
+
+        if (bulk->mask & RIG_BULK_MODE_B)
+        {
+            bits[n] = RIG_BULK_MODE_B; cmds[n++] = "rig.get_modeB";
+            bits[n] = RIG_BULK_MODE_B; cmds[n++] = "rig.get_bwB";
+        }
+    }
+
+    if (bulk->mask & RIG_BULK_PTT) { bits[n] = RIG_BULK_PTT; cmds[n++] = "rig.get_ptt"; }
+
+    if (bulk->mask & RIG_BULK_SPLIT) { bits[n] = RIG_BULK_SPLIT; cmds[n++] = "rig.get_split"; }
+
+    if (bulk->mask & RIG_BULK_STRENGTH) { bits[n] = RIG_BULK_STRENGTH; cmds[n++] = "rig.get_smeter"; }
+
+    if (bulk->mask & RIG_BULK_RFPOWER) { bits[n] = RIG_BULK_RFPOWER; cmds[n++] = "rig.get_power"; }
+
+    if (n == 0) { RETURNFUNC(RIG_OK); }
+
+    retval = flrig_multicall(rig, cmds, n, values);
+
+    if (retval == -RIG_ENAVAIL)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: system.multicall is not available\n",
+                  __func__);
+        priv->has_multicall = 0;
+        RETURNFUNC(-RIG_ENIMPL);
+    }
+
+    if (retval != RIG_OK) { RETURNFUNC(retval); }
+
+    for (i = 0; i < n; i++)
+    {
+        const char *value = values[i];
+
+        if (value[0] == 0) { continue; }
+
+        switch (bits[i])
+        {
+        case RIG_BULK_FREQ_A:
+            bulk->freqA = priv->curr_freqA = atof(value);
+            break;
+
+        case RIG_BULK_FREQ_B:
+            bulk->freqB = priv->curr_freqB = atof(value);
+            break;
+
+        case RIG_BULK_MODE_A:
+        case RIG_BULK_MODE_B:
+            // the mode, then its bandwidth
+            if (i + 1 >= n || values[i + 1][0] == 0) { i++; continue; }
+
+            {
+                const char *p = strchr(values[i + 1], '|');
+                rmode_t mode = modeMapGetHamlib(value);
+                pbwidth_t width = atoi(p ? p + 1 : values[i + 1]);
+
+                if (bits[i] == RIG_BULK_MODE_A)
+                {
+                    bulk->modeA = priv->curr_modeA = mode;
+                    bulk->widthA = priv->curr_widthA = width;
+                }
+                else
+                {
+                    bulk->modeB = priv->curr_modeB = mode;
+                    bulk->widthB = priv->curr_widthB = width;
+                }
+            }
+
+            i++;
+            break;
+
+        case RIG_BULK_PTT:
+            bulk->ptt = priv->ptt = atoi(value);
+            break;
+
+        case RIG_BULK_SPLIT:
+            bulk->split = priv->split = atoi(value);
+            bulk->split_vfo = bulk->split ? RIG_VFO_B : RIG_VFO_A;
+            break;
+
+        case RIG_BULK_STRENGTH:
+            bulk->strength.i = atoi(value) - 54;
+            break;
+
+        case RIG_BULK_RFPOWER:
+            bulk->rfpower.f = atof(value) / 100.0 * priv->powermeter_scale;
+            break;
+
+        default:
+            continue;
+        }
+
+        bulk->valid |= bits[i];
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
 /*
 * flrig_get_info
 * assumes rig!=NULL
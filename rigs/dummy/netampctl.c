@@ -30,6 +30,7 @@
 #include "hamlib/amplifier.h"
 #include "iofunc.h"
 #include "misc.h"
+#include "network.h"
 
 #include "amp_dummy.h"
 
@@ -43,15 +44,9 @@ static int netampctl_transaction(AMP *amp, char *cmd, int len, char *buf)
 {
     int ret;
 
-    ret = write_block(&amp->state.ampport, (unsigned char *) cmd, len);
-
-    if (ret != RIG_OK)
-    {
-        return ret;
-    }
-
-    ret = read_string(&amp->state.ampport, (unsigned char *) buf, BUF_MAX, "\n",
-                      sizeof("\n"), 0, 1);
+    /* reopens a dropped connection, replaying getters */
+    ret = network_transaction(&amp->state.ampport, cmd, len, buf, BUF_MAX, "\n",
+                              network_rigctl_getter(cmd));
 
     if (ret < 0)
     {
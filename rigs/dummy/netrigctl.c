@@ -28,19 +28,34 @@
 #include <math.h>
 #include <time.h>
 #include <errno.h>
+#include <ctype.h>
+#include <pthread.h>
 
 #include "hamlib/rig.h"
+#include "hamlib/rig_shm.h"
 #include "network.h"
 #include "serial.h"
 #include "iofunc.h"
 #include "misc.h"
 #include "num_stdio.h"
+#include "rigfacts.h"
+#include "snapshot_data.h"
 
 #include "dummy.h"
 
 #define CMD_MAX 64
 #define BUF_MAX 1024
 
+/* a setter that changed nothing makes rigctld send no multicast packet */
+#define MCAST_HOLD_MS 1000
+
+/* backend conf */
+#define TOK_CFG_LOCAL_SHM    TOKEN_BACKEND(1)
+#define TOK_CFG_VFO_PUSH     TOKEN_BACKEND(2)
+#define TOK_CFG_MCAST_ADDR   TOKEN_BACKEND(3)
+#define TOK_CFG_MCAST_PORT   TOKEN_BACKEND(4)
+#define TOK_CFG_MCAST_TIMEOUT TOKEN_BACKEND(5)
+
 #define CHKSCN1ARG(a) if ((a) != 1) return -RIG_EPROTO; else do {} while(0)
 
 struct netrigctl_priv_data
@@ -49,6 +64,66 @@ struct netrigctl_priv_data
     int rigctld_vfo_mode;
     vfo_t rx_vfo;
     vfo_t tx_vfo;
+    hamlib_port_t slow_port;    /* 2nd connection for CW/voice, see netrigctl_slow_port() */
+    int slow_port_failed;
+    char password[65];
+    char shm_name[64];          /* rigctld's shm_cache, see netrigctl_shm() */
+    rig_shm_t *shm;
+    time_t shm_tried;
+    int vfo_push;               /* ask rigctld to push VFO changes, see netrigctl_push() */
+    int vfo_subscribed;         /* it agreed to */
+    int vfo_pushed;             /* vfo_curr came from a push */
+    char mcast_addr[64];        /* group rigctld -M sends to, see netrigctl_mcast() */
+    int mcast_port;
+    int mcast_timeout;          /* ms, 0 for no limit */
+    int mcast_set;              /* a setter went to rigctld at... */
+    struct timespec mcast_set_time;
+    unsigned int mcast_packets; /* ...when the multicast packet count was this */
+};
+
+static const struct confparams netrigctl_cfg_params[] =
+{
+    {
+        TOK_CFG_LOCAL_SHM, "local_shm", "Local shared memory cache",
+        "shm_cache of a rigctld on this machine; fresh cache entries are read from it instead of asked over the network",
+        "", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_CFG_VFO_PUSH, "vfo_push", "Pushed VFO",
+        "Have rigctld push VFO and split changes, so get_vfo needs no round trip",
+        "1", RIG_CONF_CHECKBUTTON, { }
+    },
+    { RIG_CONF_END, NULL, }
+};
+
+static const struct confparams netmcast_cfg_params[] =
+{
+    {
+        TOK_CFG_LOCAL_SHM, "local_shm", "Local shared memory cache",
+        "shm_cache of a rigctld on this machine; fresh cache entries are read from it instead of asked over the network",
+        "", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_CFG_VFO_PUSH, "vfo_push", "Pushed VFO",
+        "Have rigctld push VFO and split changes, so get_vfo needs no round trip",
+        "1", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_CFG_MCAST_ADDR, "multicast_addr", "Multicast address",
+        "Group rigctld publishes its state to (rigctld -M); freq, mode, PTT and split are answered from what it sent",
+        "224.0.1.1", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_CFG_MCAST_PORT, "multicast_port", "Multicast port",
+        "UDP port of the multicast group (rigctld -n)",
+        "4532", RIG_CONF_NUMERIC, { .n = { 1, 65535, 1 } }
+    },
+    {
+        TOK_CFG_MCAST_TIMEOUT, "multicast_timeout", "Multicast timeout",
+        "Ask rigctld when the last multicast packet is older than this many ms, 0 for no limit; rigctld only sends when something changes",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 3600000, 1 } }
+    },
+    { RIG_CONF_END, NULL, }
 };
 
 int netrigctl_get_vfo_mode(RIG *rig)
@@ -58,41 +133,240 @@ int netrigctl_get_vfo_mode(RIG *rig)
     return priv->rigctld_vfo_mode;
 }
 
+/*
+ * Protocol return code of a reply, or its length if it carries none
+ */
+static int netrigctl_reply(const char *buf, int len)
+{
+    if (strncmp(buf, NETRIGCTL_RET, strlen(NETRIGCTL_RET)) == 0)
+    {
+        return atoi(buf + strlen(NETRIGCTL_RET));
+    }
+
+    return len;
+}
+
 /*
  * Helper function with protocol return code parsing
+ * Goes through the network connection manager, so a dropped rigctld
+ * connection is reopened and getters are replayed on the new one.
  */
-static int netrigctl_transaction(RIG *rig, char *cmd, int len, char *buf)
+static int netrigctl_port_transaction(hamlib_port_t *port, char *cmd, int len,
+                                      char *buf)
 {
     int ret;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s: called len=%d\n", __func__, len);
 
-    /* flush anything in the read buffer before command is sent */
-    rig_flush(&rig->state.rigport);
-
-    ret = write_block(&rig->state.rigport, (unsigned char *) cmd, len);
+    ret = network_transaction(port, cmd, len, buf, BUF_MAX, "\n",
+                              network_rigctl_getter(cmd));
 
-    if (ret != RIG_OK)
+    if (ret < 0)
     {
         return ret;
     }
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    return netrigctl_reply(buf, ret);
+}
 
-    if (ret < 0)
+/*
+ * Restores the rigctld session on a new connection, i.e. the password and
+ * the VFO mode.  Runs on the reconnect thread while the link still counts
+ * as down, so it talks to the port directly.
+ */
+static int netrigctl_resume(hamlib_port_t *port, void *arg)
+{
+    RIG *rig = arg;
+    struct netrigctl_priv_data *priv = rig->state.priv;
+    char cmd[CMD_MAX + 80];
+    char buf[BUF_MAX];
+    int ret;
+
+    cmd[0] = '\0';
+
+    if (priv->password[0])
     {
-        return ret;
+        SNPRINTF(cmd, sizeof(cmd), "\\password %s\n", priv->password);
     }
 
-    if (strncmp(buf, NETRIGCTL_RET, strlen(NETRIGCTL_RET)) == 0)
+    if (rig->state.vfo_opt && !priv->rigctld_vfo_mode)
     {
-        return atoi(buf + strlen(NETRIGCTL_RET));
+        SNPRINTF(cmd + strlen(cmd), sizeof(cmd) - strlen(cmd), "\\set_vfo_opt 1\n");
+    }
+
+    /* the current values are pushed again first, nothing is missed */
+    priv->vfo_pushed = 0;
+
+    if (priv->vfo_subscribed)
+    {
+        SNPRINTF(cmd + strlen(cmd), sizeof(cmd) - strlen(cmd),
+                 "\\subscribe vfo,split\n");
+    }
+
+    for (ret = RIG_OK; cmd[0] && ret >= 0;)
+    {
+        char *eol = strchr(cmd, '\n');
+
+        ret = write_block(port, (unsigned char *) cmd, eol + 1 - cmd);
+
+        if (ret == RIG_OK)
+        {
+            ret = read_string(port, (unsigned char *) buf, BUF_MAX, "\n", 1, 0, 1);
+        }
+
+        if (ret >= 0)
+        {
+            ret = netrigctl_reply(buf, ret);
+        }
+
+        memmove(cmd, eol + 1, strlen(eol + 1) + 1);
+    }
+
+    return ret < 0 ? ret : RIG_OK;
+}
+
+static int netrigctl_transaction(RIG *rig, char *cmd, int len, char *buf)
+{
+    struct netrigctl_priv_data *priv = rig->state.priv;
+    int ret = netrigctl_port_transaction(&rig->state.rigport, cmd, len, buf);
+    struct snapshot_mirror m;
+
+    // what the multicast group said is behind this until it says more
+    if (priv->mcast_addr[0] && !network_rigctl_getter(cmd))
+    {
+        memset(&m, 0, sizeof(m));
+        network_multicast_subscriber_read(rig, &m, NULL);
+        priv->mcast_set = 1;
+        priv->mcast_packets = m.packets;
+        elapsed_ms(&priv->mcast_set_time, HAMLIB_ELAPSED_SET);
     }
 
     return ret;
 }
 
+/*
+ * "!vfo" and "!split" lines rigctld sends after \subscribe.  With them
+ * the current VFO is known here, so get_vfo, and the VFO check set_vfo
+ * does first, are answered without asking, and the VFO sent for
+ * RIG_VFO_CURR and RIG_VFO_TX follows other clients' changes.
+ */
+static void netrigctl_push(hamlib_port_t *port, const char *line, void *arg)
+{
+    RIG *rig = arg;
+    struct netrigctl_priv_data *priv = rig->state.priv;
+    char vfostr[16];
+    int split;
+
+    if (sscanf(line, "!vfo %15s", vfostr) == 1)
+    {
+        priv->vfo_curr = rig_parse_vfo(vfostr);
+        priv->vfo_pushed = 1;
+    }
+    else if (sscanf(line, "!split %d %15s", &split, vfostr) == 2)
+    {
+        if (split) { priv->tx_vfo = rig_parse_vfo(vfostr); }
+    }
+    else
+    {
+        return;
+    }
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: %s", __func__, line);
+}
+
+/*
+ * Ask for the pushes netrigctl_push() takes.  A rigctld that cannot push
+ * (rigctl, a second rig, no subscribe support) says so, one that does not
+ * know the command at all is not asked: the caller only gets here when it
+ * answered dump_state_hash, which came later.
+ */
+static void netrigctl_subscribe(RIG *rig)
+{
+    struct netrigctl_priv_data *priv = rig->state.priv;
+    char cmd[] = "\\subscribe vfo,split\n";
+    char buf[BUF_MAX];
+
+    priv->vfo_subscribed = 0;
+    priv->vfo_pushed = 0;
+
+    if (!priv->vfo_push)
+    {
+        return;
+    }
+
+    network_set_push(&rig->state.rigport, netrigctl_push, rig);
+
+    if (netrigctl_transaction(rig, cmd, strlen(cmd), buf) == RIG_OK)
+    {
+        priv->vfo_subscribed = 1;
+    }
+    else
+    {
+        network_set_push(&rig->state.rigport, NULL, NULL);
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: VFO pushed=%d\n", __func__,
+              priv->vfo_subscribed);
+}
+
+/*
+ * send_morse and friends can keep rigctld busy for a while, so they get a
+ * connection of their own, opened on first use.  get_freq and the other
+ * polling from another thread then never queue behind a CW message.  Falls
+ * back to the main connection if rigctld will not take a second one.
+ */
+static hamlib_port_t *netrigctl_slow_port(RIG *rig)
+{
+    struct netrigctl_priv_data *priv = rig->state.priv;
+    hamlib_port_t *rp = &rig->state.rigport;
+    hamlib_port_t *sp = &priv->slow_port;
+    char cmd[CMD_MAX + 80];
+    char buf[BUF_MAX];
+
+    if (sp->fd > 0)
+    {
+        return sp;
+    }
+
+    if (priv->slow_port_failed || rp->type.rig != RIG_PORT_NETWORK)
+    {
+        return rp;
+    }
+
+    memset(sp, 0, sizeof(*sp));
+    sp->type.rig = rp->type.rig;
+    sp->timeout = rp->timeout;
+    sp->retry = rp->retry;
+    memcpy(sp->pathname, rp->pathname, sizeof(sp->pathname));
+
+    if (network_open(sp, 4532) != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: no 2nd connection to %s, sharing the main one\n",
+                  __func__, rp->pathname);
+        priv->slow_port_failed = 1;
+        return rp;
+    }
+
+    if (priv->password[0])
+    {
+        SNPRINTF(cmd, sizeof(cmd), "\\password %s\n", priv->password);
+        netrigctl_port_transaction(sp, cmd, strlen(cmd), buf);
+    }
+
+    if (rig->state.vfo_opt && !priv->rigctld_vfo_mode)
+    {
+        SNPRINTF(cmd, sizeof(cmd), "\\set_vfo_opt 1\n");
+        netrigctl_port_transaction(sp, cmd, strlen(cmd), buf);
+    }
+
+    network_set_resume(sp, netrigctl_resume, rig);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: opened 2nd connection to %s\n", __func__,
+              rp->pathname);
+
+    return sp;
+}
+
 /* this will fill vfostr with the vfo value if the vfo mode is enabled
  * otherwise string will be null terminated
  * this allows us to use the string in snprintf in either mode
@@ -160,6 +434,145 @@ static int netrigctl_vfostr(RIG *rig, char *vfostr, int len, vfo_t vfo)
     return RIG_OK;
 }
 
+/*
+ * A copy of the state rigctld publishes with shm_cache, RIG_OK when
+ * local_shm names one.  A segment gone away (rigctld restarted) is looked
+ * for again once a second, the network carries the answers meanwhile.
+ */
+static int netrigctl_shm(RIG *rig, struct rig_shm_state *st)
+{
+    struct netrigctl_priv_data *priv = rig->state.priv;
+    int ret;
+
+    if (!priv->shm_name[0])
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    if (!priv->shm)
+    {
+        time_t now = time(NULL);
+
+        if (now == priv->shm_tried)
+        {
+            return -RIG_ENAVAIL;
+        }
+
+        priv->shm_tried = now;
+        priv->shm = rig_shm_attach(priv->shm_name);
+
+        if (!priv->shm)
+        {
+            return -RIG_ENAVAIL;
+        }
+    }
+
+    ret = rig_shm_read(priv->shm, st);
+
+    if (ret == -RIG_EPROTO)
+    {
+        rig_shm_detach(priv->shm);
+        priv->shm = NULL;
+    }
+
+    return ret;
+}
+
+/* commands with no VFO given answer for rigctld's current VFO */
+static vfo_t netrigctl_shm_vfo(RIG *rig, vfo_t vfo)
+{
+    const struct netrigctl_priv_data *priv = rig->state.priv;
+
+    if (!rig->state.vfo_opt && !priv->rigctld_vfo_mode)
+    {
+        return RIG_VFO_CURR;
+    }
+
+    if (vfo == RIG_VFO_CURR) { vfo = priv->vfo_curr; }
+    else if (vfo == RIG_VFO_RX) { vfo = priv->rx_vfo; }
+    else if (vfo == RIG_VFO_TX) { vfo = priv->tx_vfo; }
+
+    return (vfo == RIG_VFO_NONE) ? RIG_VFO_A : vfo;
+}
+
+/* an entry rigctld would have answered from its own cache */
+static int netrigctl_shm_fresh(const struct rig_shm_state *st, int64_t ms)
+{
+    return st->cache_timeout_ms > 0 && rig_shm_age(ms) < st->cache_timeout_ms;
+}
+
+/*
+ * The state rigctld publishes with -M, RIG_OK when multicast_addr names
+ * its group and what was heard is current: a full snapshot and every
+ * delta since, a packet more after the last setter went to rigctld (or
+ * MCAST_HOLD_MS without one), and no older than multicast_timeout.
+ */
+static int netrigctl_mcast(RIG *rig, struct snapshot_mirror *m)
+{
+    struct netrigctl_priv_data *priv = rig->state.priv;
+    int age;
+
+    if (!priv->mcast_addr[0]
+            || network_multicast_subscriber_read(rig, m, &age) != RIG_OK
+            || !m->synced
+            || (priv->mcast_timeout > 0 && age > priv->mcast_timeout))
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    if (priv->mcast_set)
+    {
+        if (m->packets == priv->mcast_packets
+                && elapsed_ms(&priv->mcast_set_time, HAMLIB_ELAPSED_GET) < MCAST_HOLD_MS)
+        {
+            return -RIG_ENAVAIL;
+        }
+
+        priv->mcast_set = 0;
+    }
+
+    return RIG_OK;
+}
+
+/* the multicast VFO a command for vfo is about, NULL if its freq is unknown */
+static const struct snapshot_vfo_values *netrigctl_mcast_vfo(RIG *rig,
+        const struct snapshot_mirror *m, vfo_t vfo)
+{
+    const struct netrigctl_priv_data *priv = rig->state.priv;
+    int i;
+
+    if (vfo == RIG_VFO_CURR || vfo == RIG_VFO_RX || vfo == RIG_VFO_TX)
+    {
+        vfo_t which = vfo;
+
+        vfo = (which == RIG_VFO_TX) ? priv->tx_vfo :
+              (which == RIG_VFO_RX) ? priv->rx_vfo : priv->vfo_curr;
+
+        // the packets say which VFO receives and which transmits
+        for (i = 0; i < SNAPSHOT_VFO_COUNT; i++)
+        {
+            if (m->vfo[i].vfo != RIG_VFO_NONE
+                    && (which == RIG_VFO_TX ? m->vfo[i].tx : m->vfo[i].rx))
+            {
+                vfo = m->vfo[i].vfo;
+                break;
+            }
+        }
+    }
+    else if (vfo == RIG_VFO_MAIN) { vfo = RIG_VFO_A; }
+    else if (vfo == RIG_VFO_SUB) { vfo = RIG_VFO_B; }
+
+    for (i = 0; i < SNAPSHOT_VFO_COUNT; i++)
+    {
+        if (m->vfo[i].vfo == vfo && m->vfo[i].cached)
+        {
+            return &m->vfo[i];
+        }
+    }
+
+    return NULL;
+}
+
 static int netrigctl_init(RIG *rig)
 {
     // cppcheck says leak here but it's freed in cleanup
@@ -189,152 +602,437 @@ static int netrigctl_init(RIG *rig)
      */
     priv->vfo_curr = RIG_VFO_A;
     priv->rigctld_vfo_mode = 0;
+    priv->vfo_push = 1;
+    priv->mcast_port = 4532;
+
+    if (rig->caps->rig_model == RIG_MODEL_NETMCAST)
+    {
+        strcpy(priv->mcast_addr, "224.0.1.1");
+    }
 
     return RIG_OK;
 }
 
 static int netrigctl_cleanup(RIG *rig)
 {
-    if (rig->state.priv) { free(rig->state.priv); }
+    struct netrigctl_priv_data *priv = rig->state.priv;
+
+    if (priv)
+    {
+        rig_shm_detach(priv->shm);
+        free(priv);
+    }
 
     rig->state.priv = NULL;
     return RIG_OK;
 }
 
+static int netrigctl_set_conf(RIG *rig, token_t token, const char *val)
+{
+    struct netrigctl_priv_data *priv = rig->state.priv;
+
+    switch (token)
+    {
+    case TOK_CFG_LOCAL_SHM:
+        if (strlen(val) >= sizeof(priv->shm_name)) { return -RIG_EINVAL; }
+
+        strcpy(priv->shm_name, val);
+        rig_shm_detach(priv->shm);
+        priv->shm = NULL;
+        priv->shm_tried = 0;
+        break;
+
+    case TOK_CFG_VFO_PUSH:
+        priv->vfo_push = atoi(val) ? 1 : 0;
+        break;
+
+    case TOK_CFG_MCAST_ADDR:
+        if (strlen(val) >= sizeof(priv->mcast_addr)) { return -RIG_EINVAL; }
+
+        strcpy(priv->mcast_addr, strcmp(val, "0.0.0.0") == 0 ? "" : val);
+        break;
+
+    case TOK_CFG_MCAST_PORT:
+        priv->mcast_port = atoi(val);
+        break;
+
+    case TOK_CFG_MCAST_TIMEOUT:
+        priv->mcast_timeout = atoi(val);
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+static int netrigctl_get_conf(RIG *rig, token_t token, char *val)
+{
+    const struct netrigctl_priv_data *priv = rig->state.priv;
+
+    switch (token)
+    {
+    case TOK_CFG_LOCAL_SHM:
+        strcpy(val, priv->shm_name);
+        break;
+
+    case TOK_CFG_VFO_PUSH:
+        sprintf(val, "%d", priv->vfo_push);
+        break;
+
+    case TOK_CFG_MCAST_ADDR:
+        strcpy(val, priv->mcast_addr[0] ? priv->mcast_addr : "0.0.0.0");
+        break;
+
+    case TOK_CFG_MCAST_PORT:
+        sprintf(val, "%d", priv->mcast_port);
+        break;
+
+    case TOK_CFG_MCAST_TIMEOUT:
+        sprintf(val, "%d", priv->mcast_timeout);
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+/*
+ * Next delim separated item of *s copied to buf, NULL when there is none.
+ * Works on the caller's string, the dump_state lists are parsed in place.
+ */
+static const char *parse_array_next(const char **s, const char *delim,
+                                    char *buf, size_t buf_len)
+{
+    const char *p = *s + strspn(*s, delim);
+    size_t n = strcspn(p, delim);
+
+    if (n == 0)
+    {
+        return NULL;
+    }
+
+    *s = p + n;
+
+    if (n >= buf_len) { n = buf_len - 1; }
+
+    memcpy(buf, p, n);
+    buf[n] = '\0';
+
+    return buf;
+}
+
 int parse_array_int(const char *s, const char *delim, int *array, int array_len)
 {
-    char *p;
-    char *dup = strdup(s);
-    char *rest = dup;
+    char item[32];
     int n = 0;
 
-    while ((p = strtok_r(rest, delim, &rest)))
+    while (n < array_len && parse_array_next(&s, delim, item, sizeof(item)))
     {
-        if (n == array_len)   // too many items
-        {
-            return n;
-        }
-
-        array[n] = atoi(p);
-        //printf("%d\n", array[n]);
-        ++n;
+        array[n++] = atoi(item);
     }
 
-    free(dup);
     return n;
 }
 
 int parse_array_double(const char *s, const char *delim, double *array,
                        int array_len)
 {
-    char *p;
-    char *dup = strdup(s);
-    char *rest = dup;
+    char item[64];
     int n = 0;
 
-    while ((p = strtok_r(rest, delim, &rest)))
+    while (n < array_len && parse_array_next(&s, delim, item, sizeof(item)))
+    {
+        array[n++] = atof(item);
+    }
+
+    return n;
+}
+
+
+
+
+/*
+ * dump_state answers kept from earlier connects, keyed by the hash rigctld
+ * gives for them (\dump_state_hash), so a reconnect to the same rigctld
+ * reads one line instead of the hundred or so of a full dump_state.
+ * With open_cache set they are also kept in the cache dir across runs.
+ */
+#define NETRIGCTL_STATES 4
+#define NETRIGCTL_STATE_PATHLEN (HAMLIB_FILPATHLEN + 32)
+
+static struct
+{
+    char hash[17];
+    char *text;
+} netrigctl_states[NETRIGCTL_STATES];
+static int netrigctl_states_next;
+static pthread_mutex_t netrigctl_states_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Where the dump_state lines come from: a kept answer or the wire */
+struct netrigctl_state_src
+{
+    hamlib_port_t *port;
+    const char *text;       /* kept answer being replayed, or NULL */
+    size_t pos;
+    int record;             /* keep what is read, rigctld gave a hash */
+    char *rec;              /* answer read from the wire so far */
+    size_t rec_len, rec_size;
+};
+
+/* Same FNV-1a as rigctld's dump_state_hash */
+static void netrigctl_state_hash(const char *text, size_t len, char *hash)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        h ^= (unsigned char) text[i];
+        h *= 1099511628211ULL;
+    }
+
+    SNPRINTF(hash, 17, "%016llx", h);
+}
+
+static int netrigctl_state_file(const char *hash, char *path, size_t len)
+{
+    char dir[HAMLIB_FILPATHLEN];
+    int ret = rig_cache_dir(dir, sizeof(dir));
+
+    if (ret == RIG_OK)
     {
-        if (n == array_len)   // too many items
+        SNPRINTF(path, len, "%s/netrigctl-%s.state", dir, hash);
+    }
+
+    return ret;
+}
+
+/* Copy of the kept answer for hash, or NULL */
+static char *netrigctl_state_find(RIG *rig, const char *hash)
+{
+    char path[NETRIGCTL_STATE_PATHLEN];
+    char check[17];
+    char *text = NULL;
+    long len;
+    FILE *fp;
+    int i;
+
+    pthread_mutex_lock(&netrigctl_states_lock);
+
+    for (i = 0; i < NETRIGCTL_STATES; i++)
+    {
+        if (netrigctl_states[i].text && strcmp(netrigctl_states[i].hash, hash) == 0)
         {
-            return n;
+            text = strdup(netrigctl_states[i].text);
+            break;
         }
+    }
+
+    pthread_mutex_unlock(&netrigctl_states_lock);
 
-        array[n] = atof(p);
-        //printf("%f\n", array[n]);
-        ++n;
+    if (text || !rig->state.open_cache
+            || netrigctl_state_file(hash, path, sizeof(path)) != RIG_OK)
+    {
+        return text;
     }
 
-    free(dup);
-    return n;
-}
+    fp = fopen(path, "rb");
 
+    if (!fp) { return NULL; }
 
+    if (fseek(fp, 0, SEEK_END) == 0 && (len = ftell(fp)) > 0
+            && fseek(fp, 0, SEEK_SET) == 0 && (text = malloc(len + 1)) != NULL)
+    {
+        if (fread(text, 1, len, fp) != (size_t) len)
+        {
+            len = 0;
+        }
 
-static int netrigctl_open(RIG *rig)
+        text[len] = '\0';
+        netrigctl_state_hash(text, len, check);
+
+        /* a stale or truncated file is just a miss */
+        if (len == 0 || strcmp(check, hash) != 0)
+        {
+            free(text);
+            text = NULL;
+        }
+    }
+
+    fclose(fp);
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: %s %s\n", __func__, path,
+              text ? "loaded" : "ignored");
+
+    return text;
+}
+
+/* Keep text, a full answer read from the wire, if it matches hash */
+static void netrigctl_state_keep(RIG *rig, const char *hash, const char *text,
+                                 size_t len)
 {
-    int ret, i;
-    struct rig_state *rs = &rig->state;
-    int prot_ver;
-    char cmd[CMD_MAX];
-    char buf[BUF_MAX];
-    struct netrigctl_priv_data *priv;
+    char path[NETRIGCTL_STATE_PATHLEN];
+    char check[17];
+    char *copy;
+    FILE *fp;
+    int i;
+
+    netrigctl_state_hash(text, len, check);
 
+    if (strcmp(check, hash) != 0)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: dump_state does not match its hash %s\n",
+                  __func__, hash);
+        return;
+    }
+
+    copy = strdup(text);
+
+    if (!copy) { return; }
+
+    pthread_mutex_lock(&netrigctl_states_lock);
+
+    for (i = 0; i < NETRIGCTL_STATES; i++)
+    {
+        if (netrigctl_states[i].text && strcmp(netrigctl_states[i].hash, hash) == 0)
+        {
+            break;
+        }
+    }
 
-    ENTERFUNC;
+    if (i == NETRIGCTL_STATES)
+    {
+        i = netrigctl_states_next;
+        netrigctl_states_next = (netrigctl_states_next + 1) % NETRIGCTL_STATES;
+    }
 
-    priv = (struct netrigctl_priv_data *)rig->state.priv;
-    priv->rx_vfo = RIG_VFO_A;
-    priv->tx_vfo = RIG_VFO_B;
+    free(netrigctl_states[i].text);
+    netrigctl_states[i].text = copy;
+    memcpy(netrigctl_states[i].hash, hash, sizeof(netrigctl_states[i].hash));
 
-    SNPRINTF(cmd, sizeof(cmd), "\\chk_vfo\n");
-    ret = netrigctl_transaction(rig, cmd, strlen(cmd), buf);
+    pthread_mutex_unlock(&netrigctl_states_lock);
 
-    if (sscanf(buf, "CHKVFO %d", &priv->rigctld_vfo_mode) == 1)
+    if (!rig->state.open_cache
+            || netrigctl_state_file(hash, path, sizeof(path)) != RIG_OK)
     {
-        rig->state.vfo_opt = 1;
-        rig_debug(RIG_DEBUG_TRACE, "%s: chkvfo=%d\n", __func__, priv->rigctld_vfo_mode);
+        return;
     }
-    else if (ret == 2)
+
+    fp = fopen(path, "wb");
+
+    if (fp)
     {
-        if (buf[0]) { sscanf(buf, "%d", &priv->rigctld_vfo_mode); }
+        fwrite(text, 1, len, fp);
+        fclose(fp);
     }
-    else if (ret < 0)
+}
+
+/* Recording a line read from the wire, BUF_MAX at most */
+static int netrigctl_state_rec(struct netrigctl_state_src *src,
+                               const char *buf, int len)
+{
+    if (src->rec_len + len + 1 > src->rec_size)
     {
-        rig_debug(RIG_DEBUG_WARN, "%s: chk_vfo error: %s\n", __func__,
-                  rigerror(ret));
+        size_t size = src->rec_size ? src->rec_size * 2 : 8192;
+        char *rec;
+
+        while (size < src->rec_len + len + 1) { size *= 2; }
+
+        rec = realloc(src->rec, size);
+
+        if (!rec) { return -RIG_ENOMEM; }
+
+        src->rec = rec;
+        src->rec_size = size;
     }
-    else
+
+    memcpy(src->rec + src->rec_len, buf, len);
+    src->rec_len += len;
+    src->rec[src->rec_len] = '\0';
+
+    return RIG_OK;
+}
+
+/* Next dump_state line into buf, like read_string() */
+static int netrigctl_state_line(struct netrigctl_state_src *src, char *buf)
+{
+    int ret;
+
+    if (src->text)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s:  unknown return from netrigctl_transaction=%d\n",
-                  __func__, ret);
-    }
+        const char *p = src->text + src->pos;
+        const char *nl = strchr(p, '\n');
+        size_t len = nl ? (size_t)(nl - p) + 1 : strlen(p);
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: vfo_mode=%d\n", __func__,
-              priv->rigctld_vfo_mode);
+        if (len == 0) { return -RIG_EPROTO; }
 
-    SNPRINTF(cmd, sizeof(cmd), "\\dump_state\n");
+        if (len > BUF_MAX - 1) { len = BUF_MAX - 1; }
 
-    ret = netrigctl_transaction(rig, cmd, strlen(cmd), buf);
+        memcpy(buf, p, len);
+        buf[len] = '\0';
+        src->pos += len;
 
-    if (ret <= 0)
+        return (int) len;
+    }
+
+    ret = read_string(src->port, (unsigned char *) buf, BUF_MAX, "\n", 1, 0, 1);
+
+    if (ret > 0 && src->record)
     {
-        RETURNFUNC( (ret < 0) ? ret : -RIG_EPROTO);
+        int err = netrigctl_state_rec(src, buf, ret);
+
+        if (err != RIG_OK) { return err; }
     }
 
+    return ret;
+}
+
+/*
+ * Parse a dump_state answer, buf holding its first line (the protocol
+ * version) and the rest coming from src
+ */
+static int netrigctl_parse_state(RIG *rig, struct netrigctl_state_src *src,
+                                 char *buf)
+{
+    int ret, i;
+    struct rig_state *rs = &rig->state;
+    int prot_ver;
+
     prot_ver = atoi(buf);
 #define RIGCTLD_PROT_VER 0
 
     if (prot_ver < RIGCTLD_PROT_VER)
     {
-        RETURNFUNC( -RIG_EPROTO);
+        return -RIG_EPROTO;
     }
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     rs->deprecated_itu_region = atoi(buf);
 
     for (i = 0; i < HAMLIB_FRQRANGESIZ; i++)
     {
-        ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                          0, 1);
+        ret = netrigctl_state_line(src, buf);
 
         if (ret <= 0)
         {
-            RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+            return (ret < 0) ? ret : -RIG_EPROTO;
         }
 
         ret = num_sscanf(buf, "%"SCNfreq"%"SCNfreq"%"SCNXll"%d%d%x%x",
@@ -349,7 +1047,7 @@ static int netrigctl_open(RIG *rig)
 
         if (ret != 7)
         {
-            RETURNFUNC(-RIG_EPROTO);
+            return -RIG_EPROTO;
         }
 
         if (RIG_IS_FRNG_END(rs->rx_range_list[i]))
@@ -360,12 +1058,11 @@ static int netrigctl_open(RIG *rig)
 
     for (i = 0; i < HAMLIB_FRQRANGESIZ; i++)
     {
-        ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                          0, 1);
+        ret = netrigctl_state_line(src, buf);
 
         if (ret <= 0)
         {
-            RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+            return (ret < 0) ? ret : -RIG_EPROTO;
         }
 
         ret = num_sscanf(buf, "%"SCNfreq"%"SCNfreq"%"SCNXll"%d%d%x%x",
@@ -380,7 +1077,7 @@ static int netrigctl_open(RIG *rig)
 
         if (ret != 7)
         {
-            RETURNFUNC(-RIG_EPROTO);
+            return -RIG_EPROTO;
         }
 
         if (RIG_IS_FRNG_END(rs->tx_range_list[i]))
@@ -403,12 +1100,11 @@ static int netrigctl_open(RIG *rig)
 
     for (i = 0; i < HAMLIB_TSLSTSIZ; i++)
     {
-        ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                          0, 1);
+        ret = netrigctl_state_line(src, buf);
 
         if (ret <= 0)
         {
-            RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+            return (ret < 0) ? ret : -RIG_EPROTO;
         }
 
         ret = sscanf(buf, "%"SCNXll"%ld",
@@ -417,7 +1113,7 @@ static int netrigctl_open(RIG *rig)
 
         if (ret != 2)
         {
-            RETURNFUNC(-RIG_EPROTO);
+            return -RIG_EPROTO;
         }
 
         if (RIG_IS_TS_END(rs->tuning_steps[i]))
@@ -428,12 +1124,11 @@ static int netrigctl_open(RIG *rig)
 
     for (i = 0; i < HAMLIB_FLTLSTSIZ; i++)
     {
-        ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                          0, 1);
+        ret = netrigctl_state_line(src, buf);
 
         if (ret <= 0)
         {
-            RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+            return (ret < 0) ? ret : -RIG_EPROTO;
         }
 
         ret = sscanf(buf, "%"SCNXll"%ld",
@@ -442,7 +1137,7 @@ static int netrigctl_open(RIG *rig)
 
         if (ret != 2)
         {
-            RETURNFUNC(-RIG_EPROTO);
+            return -RIG_EPROTO;
         }
 
         if (RIG_IS_FLT_END(rs->filters[i]))
@@ -456,52 +1151,47 @@ static int netrigctl_open(RIG *rig)
     chan_t chan_list[HAMLIB_CHANLSTSIZ]; /*!< Channel list, zero ended */
 #endif
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     rig->caps->max_rit = rs->max_rit = atol(buf);
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     rig->caps->max_xit = rs->max_xit = atol(buf);
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     rig->caps->max_ifshift = rs->max_ifshift = atol(buf);
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     rs->announces = atoi(buf);
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     ret = sscanf(buf, "%d%d%d%d%d%d%d",
@@ -524,12 +1214,11 @@ static int netrigctl_open(RIG *rig)
 
     rig->caps->preamp[ret] = rs->preamp[ret] = RIG_DBLST_END;
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     ret = sscanf(buf, "%d%d%d%d%d%d%d",
@@ -552,32 +1241,29 @@ static int netrigctl_open(RIG *rig)
 
     rig->caps->attenuator[ret] = rs->attenuator[ret] = RIG_DBLST_END;
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     rig->caps->has_get_func = rs->has_get_func = strtoll(buf, NULL, 0);
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     rig->caps->has_set_func = rs->has_set_func = strtoll(buf, NULL, 0);
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     rig->caps->has_get_level = rs->has_get_level = strtoll(buf, NULL, 0);
@@ -595,32 +1281,29 @@ static int netrigctl_open(RIG *rig)
 
 #endif
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     rig->caps->has_set_level = rs->has_set_level = strtoll(buf, NULL, 0);
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     rs->has_get_parm = strtoll(buf, NULL, 0);
 
-    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                      0, 1);
+    ret = netrigctl_state_line(src, buf);
 
     if (ret <= 0)
     {
-        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+        return (ret < 0) ? ret : -RIG_EPROTO;
     }
 
     rig->caps->has_set_parm = rs->has_set_parm = strtoll(buf, NULL, 0);
@@ -651,7 +1334,7 @@ static int netrigctl_open(RIG *rig)
         rs->vfo_list = RIG_VFO_A | RIG_VFO_B;
     }
 
-    if (prot_ver == 0) { RETURNFUNC(RIG_OK); }
+    if (prot_ver == 0) { return RIG_OK; }
 
     // otherwise we continue reading protocol 1 fields
 
@@ -659,16 +1342,15 @@ static int netrigctl_open(RIG *rig)
     do
     {
         char setting[32], value[1024];
-        ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
-                          0, 1);
+        ret = netrigctl_state_line(src, buf);
         strtok(buf, "\r\n"); // chop the EOL
 
         if (ret <= 0)
         {
-            RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+            return (ret < 0) ? ret : -RIG_EPROTO;
         }
 
-        if (strncmp(buf, "done", 4) == 0) { RETURNFUNC(RIG_OK); }
+        if (strncmp(buf, "done", 4) == 0) { return RIG_OK; }
 
         if (sscanf(buf, "%31[^=]=%1023[^\t\n]", setting, value) == 2)
         {
@@ -740,17 +1422,10 @@ static int netrigctl_open(RIG *rig)
 
                 if (!has) { rig->caps->get_freq = NULL; }
             }
-            else if (strcmp(setting, "has_set_conf") == 0)
-            {
-                int has = strtol(value, NULL, 0);
-
-                if (!has) { rig->caps->set_conf = NULL; }
-            }
-            else if (strcmp(setting, "has_get_conf") == 0)
+            else if (strcmp(setting, "has_set_conf") == 0
+                     || strcmp(setting, "has_get_conf") == 0)
             {
-                int has = strtol(value, NULL, 0);
-
-                if (!has) { rig->caps->get_conf = NULL; }
+                // our set_conf/get_conf are local_shm, not rigctld's
             }
 
 #if 0 // for the future
@@ -834,16 +1509,166 @@ static int netrigctl_open(RIG *rig)
     }
     while (1);
 
-    RETURNFUNC(RIG_OK);
+    return RIG_OK;
+}
+
+
+static int netrigctl_open(RIG *rig)
+{
+    int ret;
+    struct rig_state *rs = &rig->state;
+    char cmd[CMD_MAX];
+    char buf[BUF_MAX];
+    char hash[17] = "";
+    int knows_hash = 0;
+    char *text = NULL;
+    struct netrigctl_state_src src;
+    struct netrigctl_priv_data *priv;
+
+
+    ENTERFUNC;
+
+    priv = (struct netrigctl_priv_data *)rig->state.priv;
+    priv->rx_vfo = RIG_VFO_A;
+    priv->tx_vfo = RIG_VFO_B;
+
+    network_set_resume(&rs->rigport, netrigctl_resume, rig);
+
+    /*
+     * A rigctld that does not know dump_state_hash says nothing back to
+     * it, so chk_vfo goes in the same write and answers either way.
+     */
+    SNPRINTF(cmd, sizeof(cmd), "\\dump_state_hash\n\\chk_vfo\n");
+    ret = netrigctl_transaction(rig, cmd, strlen(cmd), buf);
+
+    if (ret == 17 && buf[16] == '\n')
+    {
+        int n;
+
+        for (n = 0; n < 16 && isxdigit((unsigned char) buf[n]); n++) {}
+
+        if (n == 16)
+        {
+            memcpy(hash, buf, 16);
+            hash[16] = '\0';
+        }
+    }
+
+    if (hash[0] || (ret < 0 && strncmp(buf, NETRIGCTL_RET,
+                                       strlen(NETRIGCTL_RET)) == 0))
+    {
+        knows_hash = 1;
+
+        /* that was the hash (or a refusal of it), chk_vfo answers next */
+        ret = read_string(&rs->rigport, (unsigned char *) buf, BUF_MAX, "\n", 1, 0,
+                          1);
+
+        if (ret > 0) { ret = netrigctl_reply(buf, ret); }
+    }
+
+    if (sscanf(buf, "CHKVFO %d", &priv->rigctld_vfo_mode) == 1)
+    {
+        rig->state.vfo_opt = 1;
+        rig_debug(RIG_DEBUG_TRACE, "%s: chkvfo=%d\n", __func__, priv->rigctld_vfo_mode);
+    }
+    else if (ret == 2)
+    {
+        if (buf[0]) { sscanf(buf, "%d", &priv->rigctld_vfo_mode); }
+    }
+    else if (ret < 0)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: chk_vfo error: %s\n", __func__,
+                  rigerror(ret));
+    }
+    else
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s:  unknown return from netrigctl_transaction=%d\n",
+                  __func__, ret);
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: vfo_mode=%d\n", __func__,
+              priv->rigctld_vfo_mode);
+
+    memset(&src, 0, sizeof(src));
+    src.port = &rs->rigport;
+
+    if (hash[0] && (text = netrigctl_state_find(rig, hash)) != NULL)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: dump_state %s already known\n", __func__,
+                  hash);
+        src.text = text;
+        ret = netrigctl_state_line(&src, buf);
+    }
+    else
+    {
+        SNPRINTF(cmd, sizeof(cmd), "\\dump_state\n");
+
+        ret = netrigctl_transaction(rig, cmd, strlen(cmd), buf);
+
+        if (ret > 0 && hash[0])
+        {
+            src.record = 1;
+            ret = netrigctl_state_rec(&src, buf, strlen(buf));
+
+            if (ret == RIG_OK) { ret = strlen(buf); }
+        }
+    }
+
+    if (ret <= 0)
+    {
+        free(text);
+        free(src.rec);
+        RETURNFUNC((ret < 0) ? ret : -RIG_EPROTO);
+    }
+
+    ret = netrigctl_parse_state(rig, &src, buf);
+
+    if (ret == RIG_OK && src.record)
+    {
+        netrigctl_state_keep(rig, hash, src.rec, src.rec_len);
+    }
+
+    free(text);
+    free(src.rec);
+
+    if (ret == RIG_OK && knows_hash)
+    {
+        netrigctl_subscribe(rig);
+    }
+
+    // without the group everything is asked over the network, as netrigctl does
+    if (ret == RIG_OK && priv->mcast_addr[0]
+            && network_multicast_subscriber_start(rig, priv->mcast_addr,
+                    priv->mcast_port) != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: not listening to %s port %d\n", __func__,
+                  priv->mcast_addr, priv->mcast_port);
+    }
+
+    RETURNFUNC(ret);
 }
 
 static int netrigctl_close(RIG *rig)
 {
+    struct netrigctl_priv_data *priv = rig->state.priv;
     int ret;
     char buf[BUF_MAX];
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
+    if (priv->slow_port.fd > 0)
+    {
+        netrigctl_port_transaction(&priv->slow_port, "q\n", 2, buf);
+        network_close(&priv->slow_port);
+    }
+
+    priv->slow_port_failed = 0;
+
+    rig_shm_detach(priv->shm);
+    priv->shm = NULL;
+
+    network_multicast_subscriber_stop(rig);
+
     ret = netrigctl_transaction(rig, "q\n", 2, buf);
 
     if (ret != RIG_OK)
@@ -903,6 +1728,31 @@ static int netrigctl_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     rig_debug(RIG_DEBUG_VERBOSE, "%s called, vfo=%s\n", __func__,
               rig_strvfo(vfo));
 
+    {
+        struct rig_shm_state st;
+        int slot;
+
+        if (netrigctl_shm(rig, &st) == RIG_OK
+                && (slot = rig_shm_slot(&st, netrigctl_shm_vfo(rig, vfo))) >= 0
+                && netrigctl_shm_fresh(&st, st.vfos[slot].freq_ms))
+        {
+            *freq = st.vfos[slot].freq;
+            return RIG_OK;
+        }
+    }
+
+    {
+        struct snapshot_mirror m;
+        const struct snapshot_vfo_values *v;
+
+        if (netrigctl_mcast(rig, &m) == RIG_OK
+                && (v = netrigctl_mcast_vfo(rig, &m, vfo)) != NULL)
+        {
+            *freq = v->freq;
+            return RIG_OK;
+        }
+    }
+
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), vfo);
 
     if (ret != RIG_OK) { return ret; }
@@ -976,6 +1826,33 @@ static int netrigctl_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called, vfo=%s\n", __func__, rig_strvfo(vfo));
 
+    {
+        struct rig_shm_state st;
+        int slot;
+
+        if (netrigctl_shm(rig, &st) == RIG_OK
+                && (slot = rig_shm_slot(&st, netrigctl_shm_vfo(rig, vfo))) >= 0
+                && netrigctl_shm_fresh(&st, st.vfos[slot].mode_ms))
+        {
+            *mode = st.vfos[slot].mode;
+            *width = st.vfos[slot].width;
+            return RIG_OK;
+        }
+    }
+
+    {
+        struct snapshot_mirror m;
+        const struct snapshot_vfo_values *v;
+
+        if (netrigctl_mcast(rig, &m) == RIG_OK
+                && (v = netrigctl_mcast_vfo(rig, &m, vfo)) != NULL)
+        {
+            *mode = v->mode;
+            *width = v->width;
+            return RIG_OK;
+        }
+    }
+
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), vfo);
 
     if (ret != RIG_OK) { return ret; }
@@ -1045,6 +1922,27 @@ static int netrigctl_get_vfo(RIG *rig, vfo_t *vfo)
 
     priv = (struct netrigctl_priv_data *)rig->state.priv;
 
+    {
+        struct rig_shm_state st;
+
+        if (netrigctl_shm(rig, &st) == RIG_OK && netrigctl_shm_fresh(&st, st.vfo_ms))
+        {
+            *vfo = priv->vfo_curr = st.vfo;
+            return RIG_OK;
+        }
+    }
+
+    if (priv->vfo_subscribed)
+    {
+        network_push_poll(&rig->state.rigport);
+
+        if (priv->vfo_pushed)
+        {
+            *vfo = priv->vfo_curr;
+            return RIG_OK;
+        }
+    }
+
     SNPRINTF(cmd, sizeof(cmd), "v\n");
 
     ret = netrigctl_transaction(rig, cmd, strlen(cmd), buf);
@@ -1109,7 +2007,28 @@ static int netrigctl_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
     char buf[BUF_MAX];
     char vfostr[16] = "";
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    {
+        struct rig_shm_state st;
+
+        if (netrigctl_shm(rig, &st) == RIG_OK && netrigctl_shm_fresh(&st, st.ptt_ms))
+        {
+            *ptt = st.ptt;
+            return RIG_OK;
+        }
+    }
+
+    {
+        struct snapshot_mirror m;
+
+        // every VFO of a packet carries the one PTT state
+        if (netrigctl_mcast(rig, &m) == RIG_OK && m.vfo[0].vfo != RIG_VFO_NONE)
+        {
+            *ptt = m.vfo[0].ptt ? RIG_PTT_ON : RIG_PTT_OFF;
+            return RIG_OK;
+        }
+    }
 
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), RIG_VFO_A);
 
@@ -1623,6 +2542,7 @@ static int netrigctl_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *tx_mode,
 static int netrigctl_set_split_vfo(RIG *rig, vfo_t vfo, split_t split,
                                    vfo_t tx_vfo)
 {
+    struct netrigctl_priv_data *priv = rig->state.priv;
     int ret;
     char cmd[CMD_MAX];
     char buf[BUF_MAX];
@@ -1643,16 +2563,20 @@ static int netrigctl_set_split_vfo(RIG *rig, vfo_t vfo, split_t split,
     {
         return -RIG_EPROTO;
     }
-    else
+
+    if (ret == RIG_OK && split && tx_vfo != RIG_VFO_CURR && tx_vfo != RIG_VFO_TX)
     {
-        return ret;
+        priv->tx_vfo = tx_vfo;
     }
+
+    return ret;
 }
 
 
 static int netrigctl_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split,
                                    vfo_t *tx_vfo)
 {
+    struct netrigctl_priv_data *priv = rig->state.priv;
     int ret;
     char cmd[CMD_MAX];
     char buf[BUF_MAX];
@@ -1660,6 +2584,31 @@ static int netrigctl_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split,
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
+    {
+        struct rig_shm_state st;
+
+        if (netrigctl_shm(rig, &st) == RIG_OK && netrigctl_shm_fresh(&st, st.split_ms))
+        {
+            *split = st.split;
+            *tx_vfo = st.split_vfo;
+            return RIG_OK;
+        }
+    }
+
+    {
+        struct snapshot_mirror m;
+
+        if (netrigctl_mcast(rig, &m) == RIG_OK && m.split_vfo != RIG_VFO_NONE)
+        {
+            *split = m.split ? RIG_SPLIT_ON : RIG_SPLIT_OFF;
+            *tx_vfo = m.split_vfo;
+
+            if (*split) { priv->tx_vfo = *tx_vfo; }
+
+            return RIG_OK;
+        }
+    }
+
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), RIG_VFO_A);
 
     if (ret != RIG_OK) { return ret; }
@@ -1688,9 +2637,197 @@ static int netrigctl_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split,
 
     *tx_vfo = rig_parse_vfo(buf);
 
+    if (*split) { priv->tx_vfo = *tx_vfo; }
+
     return RIG_OK;
 }
 
+/*
+ * Read one reply line of a pipelined batch.  Returns the length, or the
+ * RPRT code (<= 0) when rigctld answered that command with an error, in
+ * which case no further lines follow for it.
+ */
+static int netrigctl_bulk_line(RIG *rig, char *buf)
+{
+    int ret;
+
+    ret = read_string(&rig->state.rigport, (unsigned char *) buf, BUF_MAX, "\n", 1,
+                      0, 1);
+
+    if (ret <= 0)
+    {
+        return (ret < 0) ? ret : -RIG_EPROTO;
+    }
+
+    if (strncmp(buf, NETRIGCTL_RET, strlen(NETRIGCTL_RET)) == 0)
+    {
+        ret = atoi(buf + strlen(NETRIGCTL_RET));
+        return ret == RIG_OK ? -RIG_EPROTO : ret;
+    }
+
+    if (buf[ret - 1] == '\n') { buf[ret - 1] = '\0'; } /* chomp */
+
+    return ret;
+}
+
+/*
+ * Write all the getters a poll wants in one go and read the replies back
+ * in order, so a round of rig_get_bulk() costs one network round trip
+ * instead of one per value.
+ */
+static int netrigctl_get_bulk(RIG *rig, struct rig_bulk *bulk)
+{
+    struct netrigctl_priv_data *priv = rig->state.priv;
+    static const struct
+    {
+        rig_bulk_t bit;
+        char cmd;
+        vfo_t vfo;
+        setting_t level;
+    } steps[] =
+    {
+        { RIG_BULK_FREQ_A, 'f', RIG_VFO_A, 0 },
+        { RIG_BULK_FREQ_B, 'f', RIG_VFO_B, 0 },
+        { RIG_BULK_MODE_A, 'm', RIG_VFO_A, 0 },
+        { RIG_BULK_MODE_B, 'm', RIG_VFO_B, 0 },
+        { RIG_BULK_PTT, 't', RIG_VFO_A, 0 },
+        { RIG_BULK_SPLIT, 's', RIG_VFO_A, 0 },
+        { RIG_BULK_STRENGTH, 'l', RIG_VFO_CURR, RIG_LEVEL_STRENGTH },
+        { RIG_BULK_RFPOWER, 'l', RIG_VFO_CURR, RIG_LEVEL_RFPOWER },
+        { RIG_BULK_SWR, 'l', RIG_VFO_CURR, RIG_LEVEL_SWR },
+    };
+    const int nsteps = sizeof(steps) / sizeof(steps[0]);
+    rig_bulk_t sent = RIG_BULK_NONE;
+    char cmd[BUF_MAX];
+    char buf[BUF_MAX];
+    char vfostr[16];
+    size_t len = 0;
+    int retcode = RIG_OK;
+    int ret;
+    int i;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called, mask=0x%x\n", __func__, bulk->mask);
+
+    for (i = 0; i < nsteps; i++)
+    {
+        if (!(bulk->mask & steps[i].bit)) { continue; }
+
+        /* without VFO arguments f/m only see the current VFO */
+        if ((steps[i].cmd == 'f' || steps[i].cmd == 'm')
+                && !rig->state.vfo_opt && !priv->rigctld_vfo_mode
+                && steps[i].vfo != RIG_VFO_A)
+        {
+            continue;
+        }
+
+        if (steps[i].level && !rig_has_get_level(rig, steps[i].level)) { continue; }
+
+        vfostr[0] = '\0';
+        ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), steps[i].vfo);
+
+        if (ret != RIG_OK) { return ret; }
+
+        if (steps[i].level)
+        {
+            len += snprintf(cmd + len, sizeof(cmd) - len, "l%s %s\n", vfostr,
+                            rig_strlevel(steps[i].level));
+        }
+        else
+        {
+            len += snprintf(cmd + len, sizeof(cmd) - len, "%c%s\n", steps[i].cmd,
+                            vfostr);
+        }
+
+        sent |= steps[i].bit;
+    }
+
+    if (sent == RIG_BULK_NONE) { return RIG_OK; }
+
+    rig_flush(&rig->state.rigport);
+
+    ret = write_block(&rig->state.rigport, (unsigned char *) cmd, len);
+
+    if (ret != RIG_OK) { return ret; }
+
+    for (i = 0; i < nsteps; i++)
+    {
+        if (!(sent & steps[i].bit)) { continue; }
+
+        ret = netrigctl_bulk_line(rig, buf);
+
+        if (ret == -RIG_EIO || ret == -RIG_ETIMEOUT)
+        {
+            /* stream is out of step, leave the rest to the caller */
+            return ret;
+        }
+
+        if (ret <= 0)
+        {
+            if (retcode == RIG_OK) { retcode = ret; }
+
+            continue;
+        }
+
+        switch (steps[i].bit)
+        {
+        case RIG_BULK_FREQ_A:
+        case RIG_BULK_FREQ_B:
+            if (num_sscanf(buf, "%"SCNfreq,
+                           steps[i].bit == RIG_BULK_FREQ_A ? &bulk->freqA : &bulk->freqB) != 1)
+            {
+                ret = -RIG_EPROTO;
+            }
+
+            break;
+
+        case RIG_BULK_MODE_A:
+        case RIG_BULK_MODE_B:
+            if (steps[i].bit == RIG_BULK_MODE_A) { bulk->modeA = rig_parse_mode(buf); }
+            else { bulk->modeB = rig_parse_mode(buf); }
+
+            ret = netrigctl_bulk_line(rig, buf);
+
+            if (ret <= 0) { return ret; } /* second line missing */
+
+            if (steps[i].bit == RIG_BULK_MODE_A) { bulk->widthA = atoi(buf); }
+            else { bulk->widthB = atoi(buf); }
+
+            break;
+
+        case RIG_BULK_PTT:
+            bulk->ptt = atoi(buf);
+            break;
+
+        case RIG_BULK_SPLIT:
+            bulk->split = atoi(buf);
+
+            ret = netrigctl_bulk_line(rig, buf);
+
+            if (ret <= 0) { return ret; }
+
+            bulk->split_vfo = rig_parse_vfo(buf);
+            break;
+
+        case RIG_BULK_STRENGTH:
+            bulk->strength.i = atoi(buf);
+            break;
+
+        case RIG_BULK_RFPOWER:
+            bulk->rfpower.f = atof(buf);
+            break;
+
+        case RIG_BULK_SWR:
+            bulk->swr.f = atof(buf);
+            break;
+        }
+
+        if (ret > 0) { bulk->valid |= steps[i].bit; }
+        else if (retcode == RIG_OK) { retcode = ret; }
+    }
+
+    return retcode;
+}
+
 static int netrigctl_set_rit(RIG *rig, vfo_t vfo, shortfreq_t rit)
 {
     int ret;
@@ -1966,6 +3103,31 @@ static int netrigctl_get_level(RIG *rig, vfo_t vfo, setting_t level,
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
+    {
+        struct rig_shm_state st;
+        int i;
+
+        // meters are published for the current VFO only
+        if (netrigctl_shm(rig, &st) == RIG_OK && st.cache_level_timeout_ms > 0
+                && rig_shm_slot(&st, netrigctl_shm_vfo(rig, vfo))
+                == rig_shm_slot(&st, RIG_VFO_CURR))
+        {
+            for (i = 0; i < RIG_SHM_METERS; i++)
+            {
+                if (st.meters[i].level != level
+                        || rig_shm_age(st.meters[i].ms) >= st.cache_level_timeout_ms)
+                {
+                    continue;
+                }
+
+                if (RIG_LEVEL_IS_FLOAT(level)) { val->f = st.meters[i].value; }
+                else { val->i = (int) st.meters[i].value; }
+
+                return RIG_OK;
+            }
+        }
+    }
+
     ret = netrigctl_vfostr(rig, vfostr, sizeof(vfostr), vfo);
 
     if (ret != RIG_OK) { return ret; }
@@ -2455,7 +3617,8 @@ static int netrigctl_send_voice_mem(RIG *rig, vfo_t vfo, int ch)
 
     SNPRINTF(cmd, sizeof(cmd), "\\send_voice_mem %d\n", ch);
 
-    ret = netrigctl_transaction(rig, cmd, strlen(cmd), buf);
+    ret = netrigctl_port_transaction(netrigctl_slow_port(rig), cmd, strlen(cmd),
+                                     buf);
 
     if (ret > 0)
     {
@@ -2486,7 +3649,8 @@ static int netrigctl_send_morse(RIG *rig, vfo_t vfo, const char *msg)
 
     SNPRINTF(cmdp, len, "%s%s\n", cmd, msg);
 
-    ret = netrigctl_transaction(rig, cmdp, strlen(cmdp), buf);
+    ret = netrigctl_port_transaction(netrigctl_slow_port(rig), cmdp, strlen(cmdp),
+                                     buf);
     free(cmdp);
 
     if (ret > 0)
@@ -2507,7 +3671,8 @@ static int netrigctl_stop_morse(RIG *rig, vfo_t vfo)
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
-    ret = netrigctl_transaction(rig, cmd, strlen(cmd), buf);
+    ret = netrigctl_port_transaction(netrigctl_slow_port(rig), cmd, strlen(cmd),
+                                     buf);
 
     if (ret > 0)
     {
@@ -2645,6 +3810,13 @@ int netrigctl_password(RIG *rig, const char *key1)
     retval = netrigctl_transaction(rig, cmdbuf, strlen(cmdbuf), buf);
 
     if (retval != RIG_OK) { retval = -RIG_EPROTO; }
+    else
+    {
+        struct netrigctl_priv_data *priv = rig->state.priv;
+
+        /* for the 2nd connection */
+        strncpy(priv->password, key1, sizeof(priv->password) - 1);
+    }
 
     RETURNFUNC(retval);
 }
@@ -2725,10 +3897,142 @@ struct rig_caps netrigctl_caps =
     .max_ifshift = 0,
     .priv =  NULL,
 
+    .cfgparams =    netrigctl_cfg_params,
+
+    .rig_init =     netrigctl_init,
+    .rig_cleanup =  netrigctl_cleanup,
+    .rig_open =     netrigctl_open,
+    .rig_close =    netrigctl_close,
+    .set_conf =     netrigctl_set_conf,
+    .get_conf =     netrigctl_get_conf,
+
+    .set_freq =     netrigctl_set_freq,
+    .get_freq =     netrigctl_get_freq,
+    .set_mode =     netrigctl_set_mode,
+    .get_mode =     netrigctl_get_mode,
+    .set_vfo =      netrigctl_set_vfo,
+    .get_vfo =      netrigctl_get_vfo,
+
+    .set_powerstat =  netrigctl_set_powerstat,
+    .get_powerstat =  netrigctl_get_powerstat,
+    .set_level =     netrigctl_set_level,
+    .get_level =     netrigctl_get_level,
+    .set_func =      netrigctl_set_func,
+    .get_func =      netrigctl_get_func,
+    .set_parm =      netrigctl_set_parm,
+    .get_parm =      netrigctl_get_parm,
+
+    .get_info =      netrigctl_get_info,
+
+
+    .set_ptt =    netrigctl_set_ptt,
+    .get_ptt =    netrigctl_get_ptt,
+    .get_dcd =    netrigctl_get_dcd,
+    .set_rptr_shift =     netrigctl_set_rptr_shift,
+    .get_rptr_shift =     netrigctl_get_rptr_shift,
+    .set_rptr_offs =  netrigctl_set_rptr_offs,
+    .get_rptr_offs =  netrigctl_get_rptr_offs,
+    .set_ctcss_tone =     netrigctl_set_ctcss_tone,
+    .get_ctcss_tone =     netrigctl_get_ctcss_tone,
+    .set_dcs_code =   netrigctl_set_dcs_code,
+    .get_dcs_code =   netrigctl_get_dcs_code,
+    .set_ctcss_sql =  netrigctl_set_ctcss_sql,
+    .get_ctcss_sql =  netrigctl_get_ctcss_sql,
+    .set_dcs_sql =    netrigctl_set_dcs_sql,
+    .get_dcs_sql =    netrigctl_get_dcs_sql,
+    .set_split_freq =     netrigctl_set_split_freq,
+    .get_split_freq =     netrigctl_get_split_freq,
+    .set_split_mode =     netrigctl_set_split_mode,
+    .get_split_mode =     netrigctl_get_split_mode,
+    .set_split_vfo =  netrigctl_set_split_vfo,
+    .get_split_vfo =  netrigctl_get_split_vfo,
+    .set_rit =    netrigctl_set_rit,
+    .get_rit =    netrigctl_get_rit,
+    .set_xit =    netrigctl_set_xit,
+    .get_xit =    netrigctl_get_xit,
+    .set_ts =     netrigctl_set_ts,
+    .get_ts =     netrigctl_get_ts,
+    .set_ant =    netrigctl_set_ant,
+    .get_ant =    netrigctl_get_ant,
+    .set_bank =   netrigctl_set_bank,
+    .set_mem =    netrigctl_set_mem,
+    .get_mem =    netrigctl_get_mem,
+    .vfo_op =     netrigctl_vfo_op,
+    .scan =       netrigctl_scan,
+    .send_dtmf =  netrigctl_send_dtmf,
+    .recv_dtmf =  netrigctl_recv_dtmf,
+    .send_morse =  netrigctl_send_morse,
+    .send_voice_mem =  netrigctl_send_voice_mem,
+    .stop_morse =  netrigctl_stop_morse,
+    .set_channel =    netrigctl_set_channel,
+    .get_channel =    netrigctl_get_channel,
+    .set_vfo_opt = netrigctl_set_vfo_opt,
+    .get_bulk = netrigctl_get_bulk,
+    //.set_trn =    netrigctl_set_trn,
+    //.get_trn =    netrigctl_get_trn,
+    .power2mW =   netrigctl_power2mW,
+    .mW2power =   netrigctl_mW2power,
+    .password =   netrigctl_password,
+    .set_lock_mode = netrigctl_set_lock_mode,
+    .get_lock_mode = netrigctl_get_lock_mode,
+
+    .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
+};
+
+/*
+ * netrigctl that also listens to the multicast group rigctld -M publishes
+ * to: the getters it covers are answered from the packets, everything else
+ * still goes to rigctld.  Any number of applications can follow one rig
+ * this way at no cost to rigctld.
+ */
+struct rig_caps netmcast_caps =
+{
+    RIG_MODEL(RIG_MODEL_NETMCAST),
+    .model_name =     "NET rigctl multicast",
+    .mfg_name =       "Hamlib",
+    .version =        "20261015.0",
+    .copyright =      "LGPL",
+    .status =         RIG_STATUS_BETA,
+    .rig_type =       RIG_TYPE_OTHER,
+    .targetable_vfo =      0,
+    .ptt_type =       RIG_PTT_RIG_MICDATA,
+    .dcd_type =       RIG_DCD_RIG,
+    .port_type =      RIG_PORT_NETWORK,
+    .timeout = 10000,  /* enough for the worst rig we have */
+    .retry =   5,
+
+    /* following fields updated in rig_state at opening time */
+    .has_get_func =   RIG_FUNC_NONE,
+    .has_set_func =   RIG_FUNC_NONE,
+    .has_get_level =  RIG_LEVEL_NONE,
+    .has_set_level =  RIG_LEVEL_NONE,
+    .has_get_parm =    RIG_PARM_NONE,
+    .has_set_parm =    RIG_PARM_NONE,
+
+    .level_gran =      { },
+    .ctcss_list =      NULL,
+    .dcs_list =        NULL,
+    .chan_list =   { },
+    .transceive =     RIG_TRN_OFF,
+    .attenuator =     { },
+    .preamp =          { },
+    .rx_range_list2 =  { RIG_FRNG_END, },
+    .tx_range_list2 =  { RIG_FRNG_END, },
+    .tuning_steps =  { },
+    .filters =  { RIG_FLT_END, },
+    .max_rit = 0,
+    .max_xit = 0,
+    .max_ifshift = 0,
+    .priv =  NULL,
+
+    .cfgparams =    netmcast_cfg_params,
+
     .rig_init =     netrigctl_init,
     .rig_cleanup =  netrigctl_cleanup,
     .rig_open =     netrigctl_open,
     .rig_close =    netrigctl_close,
+    .set_conf =     netrigctl_set_conf,
+    .get_conf =     netrigctl_get_conf,
 
     .set_freq =     netrigctl_set_freq,
     .get_freq =     netrigctl_get_freq,
@@ -2791,6 +4095,7 @@ struct rig_caps netrigctl_caps =
     .set_channel =    netrigctl_set_channel,
     .get_channel =    netrigctl_get_channel,
     .set_vfo_opt = netrigctl_set_vfo_opt,
+    .get_bulk = netrigctl_get_bulk,
     //.set_trn =    netrigctl_set_trn,
     //.get_trn =    netrigctl_get_trn,
     .power2mW =   netrigctl_power2mW,
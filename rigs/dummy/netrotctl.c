@@ -38,6 +38,11 @@
 #define CMD_MAX 32
 #define BUF_MAX 64
 
+struct netrotctl_priv_data
+{
+    int prot_ver;   /* rotctld protocol version, from dump_state */
+};
+
 /*
  * Helper function with protocol return code parsing
  */
@@ -45,18 +50,9 @@ static int netrotctl_transaction(ROT *rot, char *cmd, int len, char *buf)
 {
     int ret;
 
-    /* flush anything in the read buffer before command is sent */
-    rig_flush(&rot->state.rotport);
-
-    ret = write_block(&rot->state.rotport, (unsigned char *) cmd, len);
-
-    if (ret != RIG_OK)
-    {
-        return ret;
-    }
-
-    ret = read_string(&rot->state.rotport, (unsigned char *) buf, BUF_MAX, "\n",
-                      sizeof("\n"), 0, 1);
+    /* reopens a dropped connection, replaying getters */
+    ret = network_transaction(&rot->state.rotport, cmd, len, buf, BUF_MAX, "\n",
+                              network_rigctl_getter(cmd));
 
     if (ret < 0)
     {
@@ -71,6 +67,30 @@ static int netrotctl_transaction(ROT *rot, char *cmd, int len, char *buf)
     return ret;
 }
 
+static int netrotctl_init(ROT *rot)
+{
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    rot->state.priv = calloc(1, sizeof(struct netrotctl_priv_data));
+
+    if (!rot->state.priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    return RIG_OK;
+}
+
+static int netrotctl_cleanup(ROT *rot)
+{
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    free(rot->state.priv);
+    rot->state.priv = NULL;
+
+    return RIG_OK;
+}
+
 static int netrotctl_open(ROT *rot)
 {
     int ret;
@@ -99,6 +119,8 @@ static int netrotctl_open(ROT *rot)
         return -RIG_EPROTO;
     }
 
+    ((struct netrotctl_priv_data *) rs->priv)->prot_ver = prot_ver;
+
     ret = read_string(&rot->state.rotport, (unsigned char *) buf, BUF_MAX, "\n",
                       sizeof("\n"), 0, 1);
 
@@ -216,6 +238,106 @@ static int netrotctl_get_position(ROT *rot, azimuth_t *az, elevation_t *el)
 }
 
 
+/* status flags come back by name, as rot_sprintf_status() prints them */
+static rot_status_t netrotctl_parse_status(char *buf)
+{
+    rot_status_t status = ROT_STATUS_NONE;
+    char *tok, *saveptr = NULL;
+
+    for (tok = strtok_r(buf, " \r\n", &saveptr); tok;
+            tok = strtok_r(NULL, " \r\n", &saveptr))
+    {
+        unsigned int i;
+
+        for (i = 0; i < 8 * sizeof(rot_status_t); i++)
+        {
+            if (!strcmp(tok, rot_strstatus(ROT_STATUS_N(i))))
+            {
+                status |= ROT_STATUS_N(i);
+                break;
+            }
+        }
+    }
+
+    return status;
+}
+
+static int netrotctl_get_status(ROT *rot, rot_status_t *status)
+{
+    int ret;
+    char cmd[CMD_MAX];
+    char buf[BUF_MAX];
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    SNPRINTF(cmd, sizeof(cmd), "s\n");
+
+    ret = netrotctl_transaction(rot, cmd, strlen(cmd), buf);
+
+    if (ret <= 0)
+    {
+        return (ret < 0) ? ret : -RIG_EPROTO;
+    }
+
+    buf[ret] = '\0';
+    *status = netrotctl_parse_status(buf);
+
+    return RIG_OK;
+}
+
+/* one round trip instead of get_pos then get_status, rotctld 1 and later */
+static int netrotctl_get_state(ROT *rot, azimuth_t *az, elevation_t *el,
+                               rot_status_t *status)
+{
+    struct netrotctl_priv_data *priv = (struct netrotctl_priv_data *)
+                                       rot->state.priv;
+    int ret;
+    char cmd[CMD_MAX];
+    char buf[BUF_MAX];
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (priv->prot_ver < 1)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    SNPRINTF(cmd, sizeof(cmd), "\\get_state\n");
+
+    ret = netrotctl_transaction(rot, cmd, strlen(cmd), buf);
+
+    if (ret <= 0)
+    {
+        return (ret < 0) ? ret : -RIG_EPROTO;
+    }
+
+    *az = atof(buf);
+
+    ret = read_string(&rot->state.rotport, (unsigned char *) buf, BUF_MAX, "\n",
+                      sizeof("\n"), 0, 1);
+
+    if (ret <= 0)
+    {
+        return (ret < 0) ? ret : -RIG_EPROTO;
+    }
+
+    *el = atof(buf);
+
+    ret = read_string(&rot->state.rotport, (unsigned char *) buf, BUF_MAX, "\n",
+                      sizeof("\n"), 0, 1);
+
+    if (ret <= 0)
+    {
+        return (ret < 0) ? ret : -RIG_EPROTO;
+    }
+
+    buf[ret] = '\0';
+    *status = netrotctl_parse_status(buf);
+
+    return RIG_OK;
+}
+
+
 static int netrotctl_stop(ROT *rot)
 {
     int ret;
@@ -338,7 +460,7 @@ struct rot_caps netrotctl_caps =
     ROT_MODEL(ROT_MODEL_NETROTCTL),
     .model_name =     "NET rotctl",
     .mfg_name =       "Hamlib",
-    .version =        "20200528.0",
+    .version =        "20261014.0",
     .copyright =      "LGPL",
     .status =         RIG_STATUS_STABLE,
     .rot_type =       ROT_TYPE_OTHER,
@@ -353,8 +475,8 @@ struct rot_caps netrotctl_caps =
 
     .priv =  NULL,    /* priv */
 
-    /* .rot_init =     netrotctl_init, */
-    /* .rot_cleanup =  netrotctl_cleanup, */
+    .rot_init =     netrotctl_init,
+    .rot_cleanup =  netrotctl_cleanup,
     .rot_open =     netrotctl_open,
     .rot_close =    netrotctl_close,
 
@@ -366,5 +488,7 @@ struct rot_caps netrotctl_caps =
     .move =     netrotctl_move,
 
     .get_info =      netrotctl_get_info,
+    .get_status =    netrotctl_get_status,
+    .get_state =     netrotctl_get_state,
 };
 
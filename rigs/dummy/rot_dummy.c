@@ -921,6 +921,28 @@ static int dummy_rot_get_status(ROT *rot, rot_status_t *status)
 }
 
 
+/* position and status come from the same simulation step */
+static int dummy_rot_get_state(ROT *rot, azimuth_t *az, elevation_t *el,
+                               rot_status_t *status)
+{
+    struct dummy_rot_priv_data *priv = (struct dummy_rot_priv_data *)
+                                       rot->state.priv;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (simulating)
+    {
+        dummy_rot_simulate_rotation(rot);
+    }
+
+    *az = priv->az;
+    *el = priv->el;
+    *status = priv->status;
+
+    return RIG_OK;
+}
+
+
 /*
  * Dummy rotator capabilities.
  */
@@ -989,6 +1011,7 @@ struct rot_caps dummy_rot_caps =
 
     .get_info = dummy_rot_get_info,
     .get_status = dummy_rot_get_status,
+    .get_state = dummy_rot_get_state,
 };
 
 DECLARE_INITROT_BACKEND(dummy)
@@ -18,57 +18,104 @@
 *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
 *
 */
+
+/*
+ * TCI (ExpertSDR) runs over a WebSocket: text frames of ';' terminated
+ * "name:arg,arg,...;" commands, and binary frames carrying the IQ and
+ * audio streams.  The server pushes every change of state, starting with
+ * the whole state up to "ready;" when a client connects.
+ *
+ * tci1x_open() reads that initial state, then a reader thread takes every
+ * later push into the state kept here and into the rig cache, firing the
+ * freq/mode/ptt events, so the getters never wait on the network.  Setters
+ * send the command and the server's echo confirms it.  Without threads the
+ * getters ask again and read frames until the answer arrives.
+ *
+ * With tci_spectrum=1 the IQ stream of receiver 0 is turned into
+ * spectrum lines for rig_fire_spectrum_event().
+ */
+
 #include <hamlib/config.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>             /* String function definitions */
-#include <unistd.h>             /* UNIX standard function definitions */
+#include <ctype.h>
+#include <errno.h>
 #include <math.h>
+#include <time.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>             /* UNIX standard function definitions */
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #include <hamlib/rig.h>
-#include <serial.h>
 #include <misc.h>
-#include <cal.h>
 #include <token.h>
 #include <register.h>
-#include <network.h>
+#include <iofunc.h>
+#include <event.h>
+#include <spectrum_pool.h>
 
 #include "dummy_common.h"
 
-#define DEBUG 1
-#define DEBUG_TRACE DEBUG_VERBOSE
-
-#define MAXCMDLEN 8192
-#define MAXBUFLEN 8192
-#define MAXARGLEN 128
-#define MAXBANDWIDTHLEN 4096
+#define MAXCMDLEN 1024
+#define MAXARGS 8
 
 #define DEFAULTPATH "127.0.0.1:50001"
 
-#define FALSE 0
-#define TRUE (!FALSE)
-
 #define TCI_VFOS (RIG_VFO_A|RIG_VFO_B)
 
-#define TCI1X_MODES (RIG_MODE_USB | RIG_MODE_LSB | RIG_MODE_FM | RIG_MODE_AM)
-
-#define TCI1X_LEVELS (RIG_LEVEL_AF | RIG_LEVEL_RF | RIG_LEVEL_MICGAIN | RIG_LEVEL_STRENGTH | RIG_LEVEL_RFPOWER_METER | RIG_LEVEL_RFPOWER_METER_WATTS | RIG_LEVEL_RFPOWER)
-
-#define TCI1X_PARM (TOK_TCI1X_VERIFY_FREQ|TOK_TCI1X_VERIFY_PTT)
-
-#define streq(s1,s2) (strcmp(s1,s2)==0)
+#define TCI1X_MODES (RIG_MODE_AM | RIG_MODE_SAM | RIG_MODE_DSB |\
+                     RIG_MODE_LSB | RIG_MODE_USB | RIG_MODE_CW |\
+                     RIG_MODE_FM | RIG_MODE_WFM |\
+                     RIG_MODE_PKTLSB | RIG_MODE_PKTUSB | RIG_MODE_SPEC)
+
+#define TCI1X_LEVELS (RIG_LEVEL_AF | RIG_LEVEL_RFPOWER | RIG_LEVEL_STRENGTH |\
+                      RIG_LEVEL_RFPOWER_METER_WATTS | RIG_LEVEL_SWR)
+#define TCI1X_SET_LEVELS (RIG_LEVEL_AF | RIG_LEVEL_RFPOWER)
+
+/* WebSocket opcodes, RFC 6455 */
+#define WS_CONT   0x0
+#define WS_TEXT   0x1
+#define WS_BINARY 0x2
+#define WS_CLOSE  0x8
+#define WS_PING   0x9
+#define WS_PONG   0xa
+
+/* messages up to this size are kept, larger ones (audio) are read through */
+#define TCI1X_MAX_FRAME 65536
+#define TCI1X_MAX_MESSAGE (16 * 1024 * 1024)
+
+/* binary stream frames start with 16 little-endian uint32 */
+#define TCI1X_STREAM_HEADER 64
+#define TCI1X_STREAM_IQ 0
+#define TCI1X_FORMAT_INT16 0
+#define TCI1X_FORMAT_INT32 2
+#define TCI1X_FORMAT_FLOAT32 3
+
+#define TCI1X_TRX_MAX 2
+#define TCI1X_FFT_SIZE 1024
+#define TCI1X_IQ_RATE 48000
+#define TCI1X_SPECTRUM_INTERVAL 100 /* ms between spectrum lines */
+#define TCI1X_DB_MIN -140.0     /* dBFS of spectrum level 0 */
+#define TCI1X_DB_MAX 0.0        /* dBFS of spectrum level 255 */
+#define TCI1X_SMETER_AGE 250    /* ms before the S-meter is asked for again */
+#define TCI1X_SSB_LOW 100       /* Hz, near edge of a sideband filter */
+
+#define TOK_TCI1X_SPECTRUM TOKEN_BACKEND(1)
 
 static int tci1x_init(RIG *rig);
 static int tci1x_open(RIG *rig);
 static int tci1x_close(RIG *rig);
 static int tci1x_cleanup(RIG *rig);
+static int tci1x_set_conf(RIG *rig, token_t token, const char *val);
+static int tci1x_get_conf(RIG *rig, token_t token, char *val);
 static int tci1x_set_freq(RIG *rig, vfo_t vfo, freq_t freq);
 static int tci1x_get_freq(RIG *rig, vfo_t vfo, freq_t *freq);
-static int tci1x_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt);
 static int tci1x_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width);
-static int tci1x_set_split_mode(RIG *rig, vfo_t vfo, rmode_t mode,
-                                pbwidth_t width);
 static int tci1x_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width);
 static int tci1x_get_vfo(RIG *rig, vfo_t *vfo);
 static int tci1x_set_vfo(RIG *rig, vfo_t vfo);
@@ -76,22 +123,17 @@ static int tci1x_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt);
 static int tci1x_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt);
 static int tci1x_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq);
 static int tci1x_get_split_freq(RIG *rig, vfo_t vfo, freq_t *tx_freq);
+static int tci1x_set_split_mode(RIG *rig, vfo_t vfo, rmode_t mode,
+                                pbwidth_t width);
+static int tci1x_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
+                                pbwidth_t *width);
 static int tci1x_set_split_vfo(RIG *rig, vfo_t vfo, split_t split,
                                vfo_t tx_vfo);
 static int tci1x_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split,
                                vfo_t *tx_vfo);
-static int tci1x_set_split_freq_mode(RIG *rig, vfo_t vfo, freq_t freq,
-                                     rmode_t mode, pbwidth_t width);
-static int tci1x_get_split_freq_mode(RIG *rig, vfo_t vfo, freq_t *freq,
-                                     rmode_t *mode, pbwidth_t *width);
-#ifdef XXNOTIMPLEMENTED
 static int tci1x_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val);
 static int tci1x_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val);
 
-static int tci1x_set_ext_parm(RIG *rig, token_t token, value_t val);
-static int tci1x_get_ext_parm(RIG *rig, token_t token, value_t *val);
-#endif
-
 static const char *tci1x_get_info(RIG *rig);
 static int tci1x_power2mW(RIG *rig, unsigned int *mwpower, float power,
                           freq_t freq, rmode_t mode);
@@ -100,53 +142,96 @@ static int tci1x_mW2power(RIG *rig, float *power, unsigned int mwpower,
 
 struct tci1x_priv_data
 {
-    vfo_t curr_vfo;
-    char bandwidths[MAXBANDWIDTHLEN]; /* pipe delimited set returned from tci1x */
-    int nbandwidths;
-    char info[8192];
+    char info[128];
+    int proto_major;
+    int proto_minor;
+    int trx_count;
+    int receive_only;
+    int ready;
+    /* receiver 0; VFO A and B are its channels 0 and 1 */
+    freq_t freq[2];
+    freq_t dds[TCI1X_TRX_MAX];  /* center of each receiver's IQ stream */
+    rmode_t mode;               /* TCI has one modulation per receiver */
+    int filter_lo;
+    int filter_hi;
     ptt_t ptt;
     split_t split;
-    rmode_t curr_modeA;
-    rmode_t curr_modeB;
-    freq_t curr_freqA;
-    freq_t curr_freqB;
-    pbwidth_t curr_widthA;
-    pbwidth_t curr_widthB;
-    int has_get_modeA; /* True if this function is available */
-    int has_get_bwA; /* True if this function is available */
-    int has_verify_cmds; // has the verify cmd in FLRig 1.3.54.1 or higher
-    float powermeter_scale;  /* So we can scale power meter to 0-1 */
-    value_t parms[RIG_SETTING_MAX];
-    struct ext_list *ext_parms;
+    float smeter;               /* dBm */
+    struct timespec smeter_time;
+    float drive;                /* 0-100 */
+    float volume;               /* dB, -60-0 */
+    float tx_power;             /* W */
+    float tx_swr;
+    const char *wait_for;       /* command tci1x_refresh() waits for */
+    int got;
+    int spectrum;               /* tci_spectrum */
+    int running;
+    unsigned int mask_seed;
+#ifdef HAVE_PTHREAD
+    pthread_t thread;
+    pthread_mutex_t state_lock;
+    pthread_mutex_t write_lock;
+#endif
+    struct timespec spectrum_time;
+    int iq_fill;
+    float re[TCI1X_FFT_SIZE];
+    float im[TCI1X_FFT_SIZE];
+    float window[TCI1X_FFT_SIZE];
+    unsigned char data[TCI1X_FFT_SIZE]; /* used if the pool is empty */
+    unsigned char frame[TCI1X_MAX_FRAME + 1];
 };
 
-/* level's and parm's tokens */
-#define TOK_TCI1X_VERIFY_FREQ    TOKEN_BACKEND(1)
-#define TOK_TCI1X_VERIFY_PTT     TOKEN_BACKEND(2)
+#ifdef HAVE_PTHREAD
+#define TCI1X_LOCK(priv) pthread_mutex_lock(&(priv)->state_lock)
+#define TCI1X_UNLOCK(priv) pthread_mutex_unlock(&(priv)->state_lock)
+#else
+#define TCI1X_LOCK(priv)
+#define TCI1X_UNLOCK(priv)
+#endif
 
-static const struct confparams tci1x_ext_parms[] =
+static const struct confparams tci1x_cfg_params[] =
 {
     {
-        TOK_TCI1X_VERIFY_FREQ, "VERIFY_FREQ", "Verify set_freq", "If true will verify set_freq otherwise is fire and forget", "0", RIG_CONF_CHECKBUTTON, {}
-    },
-    {
-        TOK_TCI1X_VERIFY_PTT, "VERIFY_PTT", "Verify set_ptt", "If true will verify set_ptt otherwise set_ptt is fire and forget", "0", RIG_CONF_CHECKBUTTON, {}
+        TOK_TCI1X_SPECTRUM, "tci_spectrum", "Spectrum from IQ",
+        "Start the IQ stream of receiver 0 and turn it into spectrum lines",
+        "0", RIG_CONF_CHECKBUTTON, { }
     },
     { RIG_CONF_END, NULL, }
 };
 
+/* TCI modulations, as in modulations_list */
+static const struct
+{
+    const char *name;
+    rmode_t mode;
+} tci1x_mode_map[] =
+{
+    { "AM", RIG_MODE_AM },
+    { "SAM", RIG_MODE_SAM },
+    { "DSB", RIG_MODE_DSB },
+    { "LSB", RIG_MODE_LSB },
+    { "USB", RIG_MODE_USB },
+    { "CW", RIG_MODE_CW },
+    { "NFM", RIG_MODE_FM },
+    { "WFM", RIG_MODE_WFM },
+    { "DIGL", RIG_MODE_PKTLSB },
+    { "DIGU", RIG_MODE_PKTUSB },
+    { "SPEC", RIG_MODE_SPEC },
+    { NULL, RIG_MODE_NONE }
+};
+
 const struct rig_caps tci1x_caps =
 {
     RIG_MODEL(RIG_MODEL_TCI1X),
     .model_name = "TCI1.X",
     .mfg_name = "Expert Elec",
-    .version = "20211125.0",
+    .version = "20261014.0",
     .copyright = "LGPL",
     .status = RIG_STATUS_ALPHA,
     .rig_type = RIG_TYPE_TRANSCEIVER,
     .targetable_vfo =  RIG_TARGETABLE_FREQ | RIG_TARGETABLE_MODE,
     .ptt_type = RIG_PTT_RIG,
-    .port_type = RIG_PORT_SERIAL,
+    .port_type = RIG_PORT_NETWORK,
     .write_delay = 0,
     .post_write_delay = 0,
     .timeout = 1000,
@@ -155,11 +240,14 @@ const struct rig_caps tci1x_caps =
     .has_get_func = RIG_FUNC_NONE,
     .has_set_func = RIG_FUNC_NONE,
     .has_get_level = TCI1X_LEVELS,
-    .has_set_level = RIG_LEVEL_SET(TCI1X_LEVELS),
-    .has_get_parm =    TCI1X_PARM,
-    .has_set_parm =    RIG_PARM_SET(TCI1X_PARM),
+    .has_set_level = TCI1X_SET_LEVELS,
 
     .filters =  {
+        {RIG_MODE_SSB | RIG_MODE_PKTLSB | RIG_MODE_PKTUSB, kHz(2.7)},
+        {RIG_MODE_CW, 500},
+        {RIG_MODE_AM | RIG_MODE_SAM | RIG_MODE_DSB, kHz(6)},
+        {RIG_MODE_FM, kHz(12)},
+        {RIG_MODE_WFM, kHz(150)},
         RIG_FLT_END
     },
 
@@ -180,12 +268,14 @@ const struct rig_caps tci1x_caps =
     .tuning_steps =  { {TCI1X_MODES, 1}, {TCI1X_MODES, RIG_TS_ANY}, RIG_TS_END, },
     .priv = NULL,               /* priv */
 
-    .extparms =     tci1x_ext_parms,
+    .cfgparams =    tci1x_cfg_params,
 
     .rig_init = tci1x_init,
     .rig_open = tci1x_open,
     .rig_close = tci1x_close,
     .rig_cleanup = tci1x_cleanup,
+    .set_conf = tci1x_set_conf,
+    .get_conf = tci1x_get_conf,
 
     .set_freq = tci1x_set_freq,
     .get_freq = tci1x_get_freq,
@@ -197,1421 +287,1456 @@ const struct rig_caps tci1x_caps =
     .set_ptt = tci1x_set_ptt,
     .get_ptt = tci1x_get_ptt,
     .set_split_mode = tci1x_set_split_mode,
+    .get_split_mode = tci1x_get_split_mode,
     .set_split_freq = tci1x_set_split_freq,
     .get_split_freq = tci1x_get_split_freq,
     .set_split_vfo = tci1x_set_split_vfo,
     .get_split_vfo = tci1x_get_split_vfo,
-    .set_split_freq_mode = tci1x_set_split_freq_mode,
-    .get_split_freq_mode = tci1x_get_split_freq_mode,
-#ifdef XXNOTIMPLEMENTED
     .set_level = tci1x_set_level,
     .get_level = tci1x_get_level,
-    .set_ext_parm =  tci1x_set_ext_parm,
-    .get_ext_parm =  tci1x_get_ext_parm,
-#endif
     .power2mW =   tci1x_power2mW,
     .mW2power =   tci1x_mW2power,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
 
-//Structure for mapping tci1x dynmamic modes to hamlib modes
-//tci1x displays modes as the rig displays them
-struct s_modeMap
+static rmode_t tci1x_mode(const char *name)
 {
-    rmode_t mode_hamlib;
-    char *mode_tci1x;
-};
-
-//FLRig will provide us the modes for the selected rig
-//We will then put them in this struct
-static struct s_modeMap modeMap[] =
-{
-    {RIG_MODE_USB, NULL},
-    {RIG_MODE_LSB, NULL},
-    {RIG_MODE_PKTUSB, NULL},
-    {RIG_MODE_PKTLSB, NULL},
-    {RIG_MODE_AM, NULL},
-    {RIG_MODE_FM, NULL},
-    {RIG_MODE_FMN, NULL},
-    {RIG_MODE_WFM, NULL},
-    {RIG_MODE_CW, NULL},
-    {RIG_MODE_CWR, NULL},
-    {RIG_MODE_RTTY, NULL},
-    {RIG_MODE_RTTYR, NULL},
-    {RIG_MODE_C4FM, NULL},
-    {0, NULL}
-};
+    char upper[16];
+    int i;
 
-/*
-* check_vfo
-* No assumptions
-*/
-static int check_vfo(vfo_t vfo)
-{
-    switch (vfo)
+    for (i = 0; name[i] && i < (int)sizeof(upper) - 1; i++)
     {
-    case RIG_VFO_A:
-        break;
-
-    case RIG_VFO_TX:
-    case RIG_VFO_B:
-        break;
+        upper[i] = toupper((unsigned char) name[i]);
+    }
 
-    case RIG_VFO_CURR:
-        break;                  // will default to A in which_vfo
+    upper[i] = '\0';
 
-    default:
-        return (FALSE);
+    for (i = 0; tci1x_mode_map[i].name; i++)
+    {
+        if (strcmp(tci1x_mode_map[i].name, upper) == 0)
+        {
+            return tci1x_mode_map[i].mode;
+        }
     }
 
-    return (TRUE);
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: no mapping for mode %s\n", __func__, name);
+    return RIG_MODE_NONE;
 }
 
-/*
-*
-* read_transaction
-* Assumes rig!=NULL, buf!=NULL, buf_len big enough to hold response
-*/
-static int read_transaction(RIG *rig, unsigned char *buf, int buf_len)
+static const char *tci1x_mode_name(rmode_t mode)
 {
-    int retry;
-    struct rig_state *rs = &rig->state;
-    char *delims = ";";
-
-    ENTERFUNC;
-
-    retry = 0;
+    int i;
 
-    do
+    for (i = 0; tci1x_mode_map[i].name; i++)
     {
-        if (retry < 2)
-        {
-            rig_debug(RIG_DEBUG_WARN, "%s: retry needed? retry=%d\n", __func__, retry);
-        }
-
-        int len = read_string(&rs->rigport, buf, buf_len, delims,
-                              strlen(delims), 0, 1);
-        rig_debug(RIG_DEBUG_TRACE, "%s: string='%s'\n", __func__, buf);
-
-        if (len <= 0)
+        if (tci1x_mode_map[i].mode == mode)
         {
-            rig_debug(RIG_DEBUG_ERR, "%s: read_string error=%d\n", __func__, len);
-            continue;
+            return tci1x_mode_map[i].name;
         }
-
     }
-    while (retry-- > 0 && strlen((char *) buf) == 0);
 
-    if (retry == 0)
-    {
-        rig_debug(RIG_DEBUG_WARN, "%s: retry timeout\n", __func__);
-        RETURNFUNC(-RIG_ETIMEOUT);
-    }
+    return NULL;
+}
 
-    RETURNFUNC(RIG_OK);
+static int tci1x_bool(const char *s)
+{
+    return tolower((unsigned char) s[0]) == 't';
 }
 
 /*
-* write_transaction
-* Assumes rig!=NULL, xml!=NULL, xml_len=total size of xml for response
+* tci1x_ws_send
+* Sends one masked WebSocket frame, as a client must
 */
-static int write_transaction(RIG *rig, unsigned char *buf, int buf_len)
+static int tci1x_ws_send(RIG *rig, int opcode, const unsigned char *payload,
+                         size_t len)
 {
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    unsigned char frame[MAXCMDLEN + 8];
+    unsigned char *mask;
+    size_t n = 0;
+    size_t i;
+    int retval;
 
-    int try = rig->caps->retry;
-
-    int retval = -RIG_EPROTO;
-
-    struct rig_state *rs = &rig->state;
-
-    ENTERFUNC;
-
-    // This shouldn't ever happen...but just in case
-    // We need to avoid an empty write as rigctld replies with blank line
-    if (buf_len == 0)
+    if (len > MAXCMDLEN)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: len==0??\n", __func__);
-        RETURNFUNC(retval);
+        return -RIG_EINVAL;
     }
 
-    // appears we can lose sync if we don't clear things out
-    // shouldn't be anything for us now anyways
-    rig_flush(&rig->state.rigport);
-
-    while (try-- >= 0 && retval != RIG_OK)
-        {
-            retval = write_block(&rs->rigport, buf, buf_len);
-
-            if (retval  < 0)
-            {
-                RETURNFUNC(-RIG_EIO);
-            }
-        }
-
-    RETURNFUNC(retval);
-}
-
-static int tci1x_transaction(RIG *rig, char *cmd, char *cmd_arg, char *value,
-                             int value_len)
-{
-    int retry = 0;
-    unsigned char frame[1024];
-
-    ENTERFUNC;
-
-    memset(frame, 0, sizeof(frame));
+    frame[n++] = 0x80 | opcode;
 
-    if (value)
+    if (len < 126)
     {
-        value[0] = 0;
+        frame[n++] = 0x80 | len;
     }
-
-    frame[0] = 0x81;
-    frame[1] = strlen(cmd);
-    frame[2] = 0x00;
-    frame[3] = 0x00;
-    frame[4] = 0x00;
-    frame[5] = 0x00;
-    frame[6] = 0x00;
-    frame[7] = 0x00;
-    frame[8] = 0x00;
-    frame[9] = 0x00;
-    frame[10] = 0x00;
-    frame[11] = 0x00;
-    strcat((char *) &frame[12], cmd);
-
-    do
+    else
     {
-        int retval;
-
-        if (retry < 2)
-        {
-            rig_debug(RIG_DEBUG_VERBOSE, "%s: cmd=%s, retry=%d\n", __func__, cmd, retry);
-        }
-
-        retval = write_transaction(rig, frame, strlen(cmd) + 12);
-
-        if (retval != RIG_OK)
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s: write_transaction error=%d\n", __func__, retval);
+        frame[n++] = 0x80 | 126;
+        frame[n++] = len >> 8;
+        frame[n++] = len & 0xff;
+    }
 
-            // if we get RIG_EIO the socket has probably disappeared
-            // so bubble up the error so port can re re-opened
-            if (retval == -RIG_EIO) { RETURNFUNC(retval); }
+    mask = frame + n;
 
-            hl_usleep(50 * 1000); // 50ms sleep if error
-        }
+    for (i = 0; i < 4; i++)
+    {
+        priv->mask_seed = priv->mask_seed * 1103515245 + 12345;
+        frame[n++] = priv->mask_seed >> 16;
+    }
 
-        read_transaction(rig, (unsigned char *) value, value_len);
+    for (i = 0; i < len; i++)
+    {
+        frame[n++] = payload[i] ^ mask[i & 3];
+    }
 
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: value=%s\n", __func__, value);
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&priv->write_lock);
+#endif
+    retval = write_block(&rig->state.rigport, frame, n);
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&priv->write_lock);
+#endif
 
-    }
-    while ((value && (strlen(value) == 0))
-            && retry--); // we'll do retries if needed
+    return retval < 0 ? -RIG_EIO : RIG_OK;
+}
 
-    if (value && strlen(value) == 0) { RETURNFUNC(RIG_EPROTO); }
+/*
+* tci1x_send
+* Sends one or more ';' terminated TCI commands
+*/
+static int tci1x_send(RIG *rig, const char *cmd)
+{
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s\n", __func__, cmd);
 
-    RETURNFUNC(RIG_OK);
+    return tci1x_ws_send(rig, WS_TEXT, (const unsigned char *) cmd, strlen(cmd));
 }
 
 /*
-* tci1x_init
-* Assumes rig!=NULL
+* tci1x_read_rest
+* Reads the rest of a frame whose header is in: stopping there would leave
+* the stream misaligned, so a timeout is as fatal as any other error
 */
-static int tci1x_init(RIG *rig)
+static int tci1x_read_rest(hamlib_port_t *rp, unsigned char *buf, size_t len)
 {
-    struct tci1x_priv_data *priv;
+    int retval = read_block(rp, buf, len);
 
-    ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s version %s\n", __func__, rig->caps->version);
+    return retval == -RIG_ETIMEOUT ? -RIG_EIO : retval;
+}
 
-    rig->state.priv  = (struct tci1x_priv_data *)malloc(sizeof(
-                           struct tci1x_priv_data));
+static int tci1x_read_payload(hamlib_port_t *rp, unsigned char *buf,
+                              size_t len, const unsigned char *mask)
+{
+    size_t i;
+    int retval = tci1x_read_rest(rp, buf, len);
 
-    if (!rig->state.priv)
+    if (retval < 0)
     {
-        RETURNFUNC(-RIG_ENOMEM);
+        return retval;
     }
 
-    priv = rig->state.priv;
-
-    memset(priv, 0, sizeof(struct tci1x_priv_data));
-    memset(priv->parms, 0, RIG_SETTING_MAX * sizeof(value_t));
-
-    /*
-     * set arbitrary initial status
-     */
-    rig->state.current_vfo = RIG_VFO_A;
-    priv->split = 0;
-    priv->ptt = 0;
-    priv->curr_modeA = -1;
-    priv->curr_modeB = -1;
-    priv->curr_widthA = -1;
-    priv->curr_widthB = -1;
-
-    if (!rig->caps)
+    if (mask)
     {
-        RETURNFUNC(-RIG_EINVAL);
+        for (i = 0; i < len; i++)
+        {
+            buf[i] ^= mask[i & 3];
+        }
     }
 
-    strncpy(rig->state.rigport.pathname, DEFAULTPATH,
-            sizeof(rig->state.rigport.pathname));
+    return RIG_OK;
+}
 
-    priv->ext_parms = alloc_init_ext(tci1x_ext_parms);
+/*
+* tci1x_ws_fail
+* A frame whose payload is not read leaves the stream misaligned, so the
+* connection is closed with code instead of reading on
+*/
+static int tci1x_ws_fail(RIG *rig, int code, const char *what,
+                         unsigned long long n)
+{
+    unsigned char status[2];
 
-    if (!priv->ext_parms)
-    {
-        RETURNFUNC(-RIG_ENOMEM);
-    }
+    rig_debug(RIG_DEBUG_ERR, "%s: %llu byte %s, closing\n", __func__, n, what);
 
+    status[0] = code >> 8;
+    status[1] = code & 0xff;
+    tci1x_ws_send(rig, WS_CLOSE, status, sizeof(status));
 
-    RETURNFUNC(RIG_OK);
+    return -RIG_EIO;
 }
 
 /*
-* modeMapGetTCI
-* Assumes mode!=NULL
-* Return the string for TCI for the given hamlib mode
+* tci1x_read_frame
+* Reads one message, joining fragments, into priv->frame and answers the
+* control frames in between.  Returns its opcode, or a negative error.
+* *len is 0 for a message too large for priv->frame, which is dropped.
+* A frame that cannot be read through closes the connection, -RIG_EIO.
 */
-static const char *modeMapGetTCI(rmode_t modeHamlib)
+static int tci1x_read_frame(RIG *rig, size_t *len)
 {
-    int i;
-
-    rig_debug(RIG_DEBUG_TRACE, "%s: called\n", __func__);
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    hamlib_port_t *rp = &rig->state.rigport;
+    int opcode = -1;
+    size_t total = 0;
+    int drop = 0;
 
-    for (i = 0; modeMap[i].mode_hamlib != 0; ++i)
+    while (1)
     {
-        if (modeMap[i].mode_tci1x == NULL) { continue; }
+        unsigned char hdr[8];
+        unsigned char mask[4];
+        unsigned long long n;
+        int fin, op, masked;
+        int retval;
+        int i;
 
-        rig_debug(RIG_DEBUG_TRACE,
-                  "%s: checking modeMap[%d]=%.0f to modeHamlib=%.0f, mode_tci1x='%s'\n", __func__,
-                  i, (double)modeMap[i].mode_hamlib, (double)modeHamlib, modeMap[i].mode_tci1x);
+        retval = read_block(rp, hdr, 2);
 
-        if (modeMap[i].mode_hamlib == modeHamlib && strlen(modeMap[i].mode_tci1x) > 0)
+        if (retval < 0)
         {
-            rig_debug(RIG_DEBUG_TRACE, "%s matched mode=%.0f, returning '%s'\n", __func__,
-                      (double)modeHamlib, modeMap[i].mode_tci1x);
-            return (modeMap[i].mode_tci1x);
+            return retval;
         }
-    }
 
-    rig_debug(RIG_DEBUG_ERR, "%s: FlRig does not have mode: %s\n", __func__,
-              rig_strrmode(modeHamlib));
-    return ("ERROR");
-}
+        fin = hdr[0] & 0x80;
+        op = hdr[0] & 0x0f;
+        masked = hdr[1] & 0x80;
+        n = hdr[1] & 0x7f;
 
-/*
-* modeMapGetHamlib
-* Assumes mode!=NULL
-* Return the hamlib mode from the given TCI string
-*/
-static rmode_t modeMapGetHamlib(const char *modeTCI)
-{
-    int i;
-    char modeTCICheck[MAXBUFLEN + 2];
+        if (n >= 126)
+        {
+            int bytes = n == 126 ? 2 : 8;
 
-    SNPRINTF(modeTCICheck, sizeof(modeTCICheck), "|%s|", modeTCI);
+            retval = tci1x_read_rest(rp, hdr, bytes);
 
-    for (i = 0; modeMap[i].mode_hamlib != 0; ++i)
-    {
-        rig_debug(RIG_DEBUG_TRACE, "%s: find '%s' in '%s'\n", __func__,
-                  modeTCICheck, modeMap[i].mode_tci1x);
+            if (retval < 0)
+            {
+                return retval;
+            }
+
+            for (i = 0, n = 0; i < bytes; i++)
+            {
+                n = (n << 8) | hdr[i];
+            }
+        }
 
-        if (modeMap[i].mode_tci1x
-                && strcmp(modeMap[i].mode_tci1x, modeTCICheck) == 0)
+        if (masked && (retval = tci1x_read_rest(rp, mask, 4)) < 0)
         {
-            return (modeMap[i].mode_hamlib);
+            return retval;
         }
-    }
 
-    rig_debug(RIG_DEBUG_TRACE, "%s: mode requested: %s, not in modeMap\n", __func__,
-              modeTCI);
-    return (RIG_MODE_NONE);
-}
+        if (op >= WS_CLOSE)
+        {
+            unsigned char ctl[125];
 
+            if (n > sizeof(ctl))
+            {
+                return tci1x_ws_fail(rig, 1002, "control frame", n);
+            }
 
-/*
-* modeMapAdd
-* Assumes modes!=NULL
-*/
-static void modeMapAdd(rmode_t *modes, rmode_t mode_hamlib, char *mode_tci1x)
-{
-    int i;
-    int len1;
+            retval = tci1x_read_payload(rp, ctl, n, masked ? mask : NULL);
+
+            if (retval < 0)
+            {
+                return retval;
+            }
+
+            if (op == WS_PING)
+            {
+                tci1x_ws_send(rig, WS_PONG, ctl, n);
+            }
+            else if (op == WS_CLOSE)
+            {
+                rig_debug(RIG_DEBUG_VERBOSE, "%s: server closed the connection\n",
+                          __func__);
+                tci1x_ws_send(rig, WS_CLOSE, ctl, n < 2 ? n : 2);
+                return -RIG_EIO;
+            }
 
-    rig_debug(RIG_DEBUG_TRACE, "%s:mode_tci1x=%s\n", __func__, mode_tci1x);
+            continue;
+        }
 
-    // if we already have it just return
-    // We get ERROR if the mode is not known so non-ERROR is OK
-    if (modeMapGetHamlib(mode_tci1x) != RIG_MODE_NONE) { return; }
+        if (n > TCI1X_MAX_MESSAGE)
+        {
+            return tci1x_ws_fail(rig, 1009, "frame", n);
+        }
 
-    len1 = strlen(mode_tci1x) + 3; /* bytes needed for allocating */
+        if (op != WS_CONT)
+        {
+            opcode = op;
+            total = 0;
+            drop = 0;
+        }
+        else if (opcode < 0)
+        {
+            drop = 1;       /* continuation of a message we did not see */
+        }
 
-    for (i = 0; modeMap[i].mode_hamlib != 0; ++i)
-    {
-        if (modeMap[i].mode_hamlib == mode_hamlib)
+        if (drop || total + n > TCI1X_MAX_FRAME)
         {
-            int len2;
-            *modes |= modeMap[i].mode_hamlib;
+            /* read through it in chunks */
+            drop = 1;
 
-            /* we will pipe delimit all the entries for easier matching */
-            /* all entries will have pipe symbol on both sides */
-            if (modeMap[i].mode_tci1x == NULL)
+            while (n > 0)
             {
-                modeMap[i].mode_tci1x = calloc(1, len1);
+                size_t chunk = n < TCI1X_MAX_FRAME ? n : TCI1X_MAX_FRAME;
 
-                if (modeMap[i].mode_tci1x == NULL)
+                retval = tci1x_read_rest(rp, priv->frame, chunk);
+
+                if (retval < 0)
                 {
-                    rig_debug(RIG_DEBUG_ERR, "%s: error allocating memory for modeMap\n",
-                              __func__);
-                    return;
+                    return retval;
                 }
+
+                n -= chunk;
             }
+        }
+        else
+        {
+            retval = tci1x_read_payload(rp, priv->frame + total, n,
+                                        masked ? mask : NULL);
 
-            len2 = strlen(modeMap[i].mode_tci1x); /* current len w/o null */
-            modeMap[i].mode_tci1x = realloc(modeMap[i].mode_tci1x,
-                                            strlen(modeMap[i].mode_tci1x) + len1);
+            if (retval < 0)
+            {
+                return retval;
+            }
 
-            if (strlen(modeMap[i].mode_tci1x) == 0) { modeMap[i].mode_tci1x[0] = '|'; }
+            total += n;
+        }
 
-            strncat(modeMap[i].mode_tci1x, mode_tci1x, len1 + len2);
-            strncat(modeMap[i].mode_tci1x, "|", len1 + len2);
-            rig_debug(RIG_DEBUG_TRACE, "%s: Adding mode=%s, index=%d, result=%s\n",
-                      __func__, mode_tci1x, i, modeMap[i].mode_tci1x);
-            return;
+        if (fin && opcode >= 0)
+        {
+            *len = drop ? 0 : total;
+            priv->frame[*len] = '\0';
+            return opcode;
         }
     }
 }
 
 /*
-* tci1x_open
-* Assumes rig!=NULL, rig->state.priv!=NULL
+* tci1x_process_cmd
+* Takes one command pushed by the server into the state, and fires the
+* events for it once the state is unlocked
 */
-static int tci1x_open(RIG *rig)
+static void tci1x_process_cmd(RIG *rig, char *cmd)
 {
-    int retval;
-    int trx_count = 0;
-    char value[MAXBUFLEN];
-    char arg[MAXBUFLEN];
-    rmode_t modes;
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    char *args[MAXARGS];
     char *p;
-    char *pr;
-    //struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
-
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: version %s\n", __func__, rig->caps->version);
-    char *websocket =
-        "GET / HTTP/1.1\r\nHost: localhost:50001\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: TnwnvtFT6akIBYQC7nh3vA==\r\nSec-WebSocket-Version: 13\r\n\r\n";
+    int nargs = 0;
+    int trx;
+    int fire_freq = -1;
+    int fire_mode = 0;
+    int fire_ptt = 0;
+    freq_t freq = 0;
+    rmode_t mode;
+    pbwidth_t width;
+    ptt_t ptt;
 
-    write_transaction(rig, (unsigned char *) websocket, strlen(websocket));
+    p = strchr(cmd, ':');
 
-    do
+    if (p)
     {
-        retval = read_transaction(rig, (unsigned char *) value, sizeof(value));
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: value=%s\n", __func__, value);
-    }
-    while (retval == RIG_OK && strlen(value) > 0);
+        *p++ = '\0';
+
+        while (nargs < MAXARGS)
+        {
+            args[nargs++] = p;
+            p = strchr(p, ',');
 
-    retval = tci1x_transaction(rig, "device;", NULL, value, sizeof(value));
-    dump_hex((unsigned char *)value, strlen(value));
+            if (!p) { break; }
 
-    if (retval != RIG_OK)
+            *p++ = '\0';
+        }
+    }
+
+    for (p = cmd; *p; p++)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: DEVICE failed: %s\n", __func__,
-                  rigerror(retval));
-        // we fall through and assume old version
+        *p = tolower((unsigned char) * p);
     }
 
-    sscanf(&value[2], "device:%s", value);
+    rig_debug(RIG_DEBUG_TRACE, "%s: %.64s, %d args\n", __func__, cmd, nargs);
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: TCI Device is %s\n", __func__, arg);
+    trx = nargs > 0 ? atoi(args[0]) : -1;
 
-    // Receive only
-    retval = tci1x_transaction(rig, "receive_only;", NULL, value, sizeof(value));
+    TCI1X_LOCK(priv);
 
-    if (retval != RIG_OK)
+    if (priv->wait_for && strcmp(cmd, priv->wait_for) == 0)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: RECEIVE_ONLY failed: %s\n", __func__,
-                  rigerror(retval));
+        priv->got = 1;
     }
 
-    sscanf(&value[2], "receive_only:%s", value);
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: readonly is %s\n", __func__, arg);
-
-    // TRX count
-    retval = tci1x_transaction(rig, "trx_count;", NULL, value, sizeof(value));
+    if (strcmp(cmd, "vfo") == 0 && nargs >= 3 && trx == 0)
+    {
+        int channel = atoi(args[1]);
 
-    if (retval != RIG_OK)
+        if (channel == 0 || channel == 1)
+        {
+            freq = priv->freq[channel] = atof(args[2]);
+            fire_freq = channel;
+        }
+    }
+    else if (strcmp(cmd, "dds") == 0 && nargs >= 2 && trx >= 0
+             && trx < TCI1X_TRX_MAX)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: TRX_COUNT failed..not fatal: %s\n", __func__,
-                  rigerror(retval));
+        priv->dds[trx] = atof(args[1]);
     }
+    else if (strcmp(cmd, "modulation") == 0 && nargs >= 2 && trx == 0)
+    {
+        priv->mode = tci1x_mode(args[1]);
+        fire_mode = 1;
+    }
+    else if (strcmp(cmd, "rx_filter_band") == 0 && nargs >= 3 && trx == 0)
+    {
+        priv->filter_lo = atoi(args[1]);
+        priv->filter_hi = atoi(args[2]);
+        fire_mode = 1;
+    }
+    else if (strcmp(cmd, "trx") == 0 && nargs >= 2 && trx == 0)
+    {
+        priv->ptt = tci1x_bool(args[1]) ? RIG_PTT_ON : RIG_PTT_OFF;
+        fire_ptt = 1;
+    }
+    else if (strcmp(cmd, "split_enable") == 0 && nargs >= 2 && trx == 0)
+    {
+        priv->split = tci1x_bool(args[1]) ? RIG_SPLIT_ON : RIG_SPLIT_OFF;
+    }
+    else if (strcmp(cmd, "rx_smeter") == 0 && nargs >= 3 && trx == 0
+             && atoi(args[1]) == 0)
+    {
+        priv->smeter = atof(args[2]);
+        elapsed_ms(&priv->smeter_time, HAMLIB_ELAPSED_SET);
+    }
+    else if (strcmp(cmd, "drive") == 0 && nargs >= 1)
+    {
+        /* "drive:value;" before TCI 1.5, "drive:trx,value;" since */
+        if (nargs == 1 || trx == 0) { priv->drive = atof(args[nargs - 1]); }
+    }
+    else if (strcmp(cmd, "volume") == 0 && nargs >= 1)
+    {
+        priv->volume = atof(args[0]);
+    }
+    else if (strcmp(cmd, "tx_power") == 0 && nargs >= 1)
+    {
+        priv->tx_power = atof(args[0]);
+    }
+    else if (strcmp(cmd, "tx_swr") == 0 && nargs >= 1)
+    {
+        priv->tx_swr = atof(args[0]);
+    }
+    else if (strcmp(cmd, "tx_sensors") == 0 && nargs >= 5 && trx == 0)
+    {
+        /* trx, mic dB, rms power, peak power, swr */
+        priv->tx_power = atof(args[2]);
+        priv->tx_swr = atof(args[4]);
+    }
+    else if (strcmp(cmd, "protocol") == 0 && nargs >= 2)
+    {
+        sscanf(args[1], "%d.%d", &priv->proto_major, &priv->proto_minor);
+        SNPRINTF(priv->info, sizeof(priv->info), "%s %s", args[0], args[1]);
+    }
+    else if (strcmp(cmd, "device") == 0 && nargs >= 1)
+    {
+        size_t len = strlen(priv->info);
 
-    sscanf(&value[2], "trx_count:%d", &trx_count);
-    rig_debug(RIG_DEBUG_VERBOSE, "Trx count=%d\n", trx_count);
-
-    freq_t freq;
-    retval = tci1x_get_freq(rig, RIG_VFO_CURR, &freq);
-
-    if (retval != RIG_OK)
+        snprintf(priv->info + len, sizeof(priv->info) - len, "%s%s",
+                 len ? " " : "", args[0]);
+    }
+    else if (strcmp(cmd, "receive_only") == 0 && nargs >= 1)
+    {
+        priv->receive_only = tci1x_bool(args[0]);
+    }
+    else if (strcmp(cmd, "trx_count") == 0 && nargs >= 1)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: tci1x_get_freq not working!!\n", __func__);
+        priv->trx_count = atoi(args[0]);
     }
+    else if (strcmp(cmd, "modulations_list") == 0)
+    {
+        rmode_t modes = RIG_MODE_NONE;
+        int i;
 
-    rig->state.current_vfo = RIG_VFO_A;
-    rig_debug(RIG_DEBUG_TRACE, "%s: currvfo=%s value=%s\n", __func__,
-              rig_strvfo(rig->state.current_vfo), value);
-    //tci1x_get_split_vfo(rig, vfo, &priv->split, &vfo_tx);
-    RETURNFUNC2(RIG_OK);
-
-    /* find out available widths and modes */
-    retval = tci1x_transaction(rig, "modulations_list;", NULL, value,
-                               sizeof(value));
-
-    if (retval != RIG_OK) { RETURNFUNC2(retval); }
-
-    sscanf(&value[2], "modulations_list:%s", arg);
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: modes=%s\n", __func__, arg);
-    modes = 0;
-    pr = value;
-
-    /* The following modes in TCI are not implemented yet
-        A1A
-        AM-2
-        AM6.0
-        AM-D1 -- doesn't appear to be read/set
-        AM-D2 -- doesn't appear to be read/set
-        AM-D3 -- doesn't appear to be read/set
-        AMW -- don't have mode in rig.h
-        CW2.4 -- could be CW
-        CW500 -- could be CWN but CWN not in rig.h
-        CW-N -- could be CWN but CWN not in rig.h
-        CWN -- dcould be CWN but CWN not in rig.h
-        CW-NR -- don't have mode in rig.h
-        DATA2-LSB
-        DV
-        DV-R
-        F1B
-        FM-D1 -- doesn't appear to be read/set
-        FM-D2 -- doesn't appear to be read/set
-        FM-D3 -- doesn't appear to be read/set
-        H3E
-        M11
-        USB-D -- doesn't appear to be read/set
-        USB-D1 -- doesn't appear to be read/set
-        USB-D2 -- doesn't appear to be read/set
-        USB-D3 -- doesn't appear to be read/set
-        USER-L -- doesn't appear to be read/set
-        USER-U -- doesn't appear to be read/set
-    */
-
-    for (p = strtok_r(value, ",", &pr); p != NULL; p = strtok_r(NULL, ",", &pr))
-    {
-        if (streq(p, "AM-D")) { modeMapAdd(&modes, RIG_MODE_PKTAM, p); }
-        else if (streq(p, "AM")) { modeMapAdd(&modes, RIG_MODE_AM, p); }
-        else if (streq(p, "AM-N")) { modeMapAdd(&modes, RIG_MODE_AMN, p); }
-        else if (streq(p, "AMN")) { modeMapAdd(&modes, RIG_MODE_AMN, p); }
-        else if (streq(p, "CW")) { modeMapAdd(&modes, RIG_MODE_CW, p); }
-        else if (streq(p, "CW-L")) { modeMapAdd(&modes, RIG_MODE_CWR, p); }
-        else if (streq(p, "CW-LSB")) { modeMapAdd(&modes, RIG_MODE_CWR, p); }
-        else if (streq(p, "CW-R")) { modeMapAdd(&modes, RIG_MODE_CWR, p); }
-        else if (streq(p, "CW-U")) { modeMapAdd(&modes, RIG_MODE_CW, p); }
-        else if (streq(p, "CW-USB")) { modeMapAdd(&modes, RIG_MODE_CW, p); }
-        else if (streq(p, "CWL")) { modeMapAdd(&modes, RIG_MODE_CWR, p); }
-        else if (streq(p, "CWU")) { modeMapAdd(&modes, RIG_MODE_CW, p); }
-        else if (streq(p, "D-LSB")) { modeMapAdd(&modes, RIG_MODE_PKTLSB, p); }
-        else if (streq(p, "D-USB")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "DATA")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "DATA-FM")) { modeMapAdd(&modes, RIG_MODE_PKTFM, p); }
-        else if (streq(p, "DATA-L")) { modeMapAdd(&modes, RIG_MODE_PKTLSB, p); }
-        else if (streq(p, "DATA-R")) { modeMapAdd(&modes, RIG_MODE_PKTLSB, p); }
-        else if (streq(p, "DATA-LSB")) { modeMapAdd(&modes, RIG_MODE_PKTLSB, p); }
-        else if (streq(p, "DATA-USB")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "DATA-U")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "DIG")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "DIGI")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "DIGL")) { modeMapAdd(&modes, RIG_MODE_PKTLSB, p); }
-        else if (streq(p, "DIGU")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "DSB")) { modeMapAdd(&modes, RIG_MODE_DSB, p); }
-        else if (streq(p, "FM")) { modeMapAdd(&modes, RIG_MODE_FM, p); }
-        else if (streq(p, "FM-D")) { modeMapAdd(&modes, RIG_MODE_PKTFM, p); }
-        else if (streq(p, "FMN")) { modeMapAdd(&modes, RIG_MODE_FMN, p); }
-        else if (streq(p, "FM-N")) { modeMapAdd(&modes, RIG_MODE_FMN, p); }
-        else if (streq(p, "FMW")) { modeMapAdd(&modes, RIG_MODE_WFM, p); }
-        else if (streq(p, "FSK")) { modeMapAdd(&modes, RIG_MODE_RTTY, p); }
-        else if (streq(p, "FSK-R")) { modeMapAdd(&modes, RIG_MODE_RTTYR, p); }
-        else if (streq(p, "LCW")) { modeMapAdd(&modes, RIG_MODE_CWR, p); }
-        else if (streq(p, "LSB")) { modeMapAdd(&modes, RIG_MODE_LSB, p); }
-        else if (streq(p, "LSB-D")) { modeMapAdd(&modes, RIG_MODE_PKTLSB, p); }
-        else if (streq(p, "LSB-D1")) { modeMapAdd(&modes, RIG_MODE_PKTLSB, p); }
-        else if (streq(p, "LSB-D2")) { modeMapAdd(&modes, RIG_MODE_PKTLSB, p); }
-        else if (streq(p, "LSB-D3")) { modeMapAdd(&modes, RIG_MODE_PKTLSB, p); }
-        else if (streq(p, "NFM")) { modeMapAdd(&modes, RIG_MODE_FMN, p); }
-        else if (streq(p, "PKT")) { modeMapAdd(&modes, RIG_MODE_RTTY, p); }
-        else if (streq(p, "PKT-FM")) { modeMapAdd(&modes, RIG_MODE_PKTFM, p); }
-        else if (streq(p, "PKT-L")) { modeMapAdd(&modes, RIG_MODE_RTTYR, p); }
-        else if (streq(p, "PKT-U")) { modeMapAdd(&modes, RIG_MODE_RTTY, p); }
-        else if (streq(p, "PKT(L)")) { modeMapAdd(&modes, RIG_MODE_RTTYR, p); }
-        else if (streq(p, "PKT(U)")) { modeMapAdd(&modes, RIG_MODE_RTTY, p); }
-        else if (streq(p, "PSK")) { modeMapAdd(&modes, RIG_MODE_RTTY, p); }
-        else if (streq(p, "PSK-L")) { modeMapAdd(&modes, RIG_MODE_RTTYR, p); }
-        else if (streq(p, "PSK-R")) { modeMapAdd(&modes, RIG_MODE_RTTYR, p); }
-        else if (streq(p, "PSK-U")) { modeMapAdd(&modes, RIG_MODE_RTTY, p); }
-        else if (streq(p, "RTTY")) { modeMapAdd(&modes, RIG_MODE_RTTY, p); }
-        else if (streq(p, "RTTY-L")) { modeMapAdd(&modes, RIG_MODE_RTTYR, p); }
-        else if (streq(p, "RTTY-R")) { modeMapAdd(&modes, RIG_MODE_RTTYR, p); }
-        else if (streq(p, "RTTY-U")) { modeMapAdd(&modes, RIG_MODE_RTTY, p); }
-        else if (streq(p, "RTTY(U)")) { modeMapAdd(&modes, RIG_MODE_RTTY, p); }
-        else if (streq(p, "RTTY(R")) { modeMapAdd(&modes, RIG_MODE_RTTYR, p); }
-        else if (streq(p, "SAH")) { modeMapAdd(&modes, RIG_MODE_SAH, p); }
-        else if (streq(p, "SAL")) { modeMapAdd(&modes, RIG_MODE_SAL, p); }
-        else if (streq(p, "SAM")) { modeMapAdd(&modes, RIG_MODE_SAM, p); }
-        else if (streq(p, "USB")) { modeMapAdd(&modes, RIG_MODE_USB, p); }
-        else if (streq(p, "USB-D")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "USB-D1")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "USB-D2")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "USB-D3")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "USER-U")) { modeMapAdd(&modes, RIG_MODE_PKTUSB, p); }
-        else if (streq(p, "USER-L")) { modeMapAdd(&modes, RIG_MODE_PKTLSB, p); }
-        else if (streq(p, "W-FM")) { modeMapAdd(&modes, RIG_MODE_WFM, p); }
-        else if (streq(p, "WFM")) { modeMapAdd(&modes, RIG_MODE_WFM, p); }
-        else if (streq(p, "UCW")) { modeMapAdd(&modes, RIG_MODE_CW, p); }
-        else if (streq(p, "C4FM")) { modeMapAdd(&modes, RIG_MODE_C4FM, p); }
-        else if (streq(p, "SPEC")) { modeMapAdd(&modes, RIG_MODE_SPEC, p); }
-        else if (streq(p, "DRM")) // we don't support DRM yet (or maybe ever)
+        for (i = 0; i < nargs; i++)
         {
-            rig_debug(RIG_DEBUG_VERBOSE, "%s: no mapping for mode %s\n", __func__, p);
+            modes |= tci1x_mode(args[i]);
         }
-        else { rig_debug(RIG_DEBUG_ERR, "%s: Unknown mode (new?) for this rig='%s'\n", __func__, p); }
-    }
 
-    rig->state.mode_list = modes;
+        rig->state.mode_list = modes;
+    }
+    else if (strcmp(cmd, "ready") == 0)
+    {
+        priv->ready = 1;
+    }
+
+    mode = priv->mode;
+    width = priv->filter_hi - priv->filter_lo;
+    ptt = priv->ptt;
 
-    retval = rig_strrmodes(modes, value, sizeof(value));
+    TCI1X_UNLOCK(priv);
 
-    if (retval != RIG_OK)   // we might get TRUNC but we can still print the debug
+    if (fire_freq >= 0)
     {
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: %s\n", __func__, rigerror(retval));
+        rig_fire_freq_event(rig, fire_freq ? RIG_VFO_B : RIG_VFO_A, freq);
     }
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: hamlib modes=%s\n", __func__, value);
+    if (fire_mode)
+    {
+        rig_fire_mode_event(rig, RIG_VFO_A, mode, width);
+        rig_fire_mode_event(rig, RIG_VFO_B, mode, width);
+    }
 
-    RETURNFUNC2(retval);
+    if (fire_ptt)
+    {
+        rig_fire_ptt_event(rig, RIG_VFO_CURR, ptt);
+    }
 }
 
-/*
-* tci1x_close
-* Assumes rig!=NULL
-*/
-static int tci1x_close(RIG *rig)
+static void tci1x_process_text(RIG *rig, char *text)
 {
-    ENTERFUNC;
+    char *cmd = text;
 
-    RETURNFUNC(RIG_OK);
+    while (*cmd)
+    {
+        char *next = strchr(cmd, ';');
+
+        if (next)
+        {
+            *next++ = '\0';
+        }
+        else
+        {
+            next = cmd + strlen(cmd);
+        }
+
+        while (isspace((unsigned char) *cmd)) { cmd++; }
+
+        if (*cmd)
+        {
+            tci1x_process_cmd(rig, cmd);
+        }
+
+        cmd = next;
+    }
 }
 
-/*
-* tci1x_cleanup
-* Assumes rig!=NULL, rig->state.priv!=NULL
-*/
-static int tci1x_cleanup(RIG *rig)
+static unsigned long tci1x_get_u32(const unsigned char *p)
 {
-    struct tci1x_priv_data *priv;
+    return (unsigned long)p[0] | ((unsigned long)p[1] << 8)
+           | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
 
-    ENTERFUNC;
+/* in-place radix-2 FFT, n a power of 2 */
+static void tci1x_fft(float *re, float *im, int n)
+{
+    int i, j, m;
 
-    if (!rig)
+    for (i = 1, j = 0; i < n; i++)
     {
-        RETURNFUNC(-RIG_EINVAL);
+        int bit = n >> 1;
+
+        for (; j & bit; bit >>= 1)
+        {
+            j ^= bit;
+        }
+
+        j ^= bit;
+
+        if (i < j)
+        {
+            float t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
     }
 
-    priv = (struct tci1x_priv_data *)rig->state.priv;
+    for (m = 2; m <= n; m <<= 1)
+    {
+        double a = -2 * M_PI / m;
+        float wr = cos(a);
+        float wi = sin(a);
+        int k;
 
-    free(priv->ext_parms);
-    free(rig->state.priv);
+        for (k = 0; k < n; k += m)
+        {
+            float cr = 1, ci = 0;
 
-    rig->state.priv = NULL;
+            for (i = 0; i < m / 2; i++)
+            {
+                int u = k + i, v = k + i + m / 2;
+                float tr = re[v] * cr - im[v] * ci;
+                float ti = re[v] * ci + im[v] * cr;
+                float t;
+
+                re[v] = re[u] - tr;
+                im[v] = im[u] - ti;
+                re[u] += tr;
+                im[u] += ti;
+
+                t = cr * wr - ci * wi;
+                ci = cr * wi + ci * wr;
+                cr = t;
+            }
+        }
+    }
+}
 
-    RETURNFUNC(RIG_OK);
+static float tci1x_sample(const unsigned char *p, int format)
+{
+    unsigned long u = tci1x_get_u32(p);
+    float f;
+
+    switch (format)
+    {
+    case TCI1X_FORMAT_INT16:
+        return (short)(p[0] | (p[1] << 8)) / 32768.0f;
+
+    case TCI1X_FORMAT_INT32:
+        return (int32_t) u / 2147483648.0f;
+
+    default:
+        memcpy(&f, &u, sizeof(f));
+        return f;
+    }
 }
 
 /*
-* tci1x_get_freq
-* Assumes rig!=NULL, rig->state.priv!=NULL, freq!=NULL
+* tci1x_process_iq
+* Collects TCI1X_FFT_SIZE IQ samples of receiver 0 every
+* TCI1X_SPECTRUM_INTERVAL and fires their spectrum as a line centred on
+* the receiver's dds frequency
 */
-static int tci1x_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
+static void tci1x_process_iq(RIG *rig, const unsigned char *frame, size_t len)
 {
-    char value[MAXARGLEN];
     struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    unsigned long receiver, rate, format;
+    int size, count, i;
+    const unsigned char *p;
+    struct spectrum_pool_line *pl;
+    struct rig_spectrum_line stack_line;
+    struct rig_spectrum_line *line;
+    unsigned char *data;
+    float wsum = 0;
+    freq_t center;
 
-    ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s\n", __func__,
-              rig_strvfo(vfo));
+    receiver = tci1x_get_u32(frame);
+    rate = tci1x_get_u32(frame + 4);
+    format = tci1x_get_u32(frame + 8);
 
+    if (receiver != 0 || rate == 0)
+    {
+        return;
+    }
 
-    if (check_vfo(vfo) == FALSE)
+    if (format == TCI1X_FORMAT_INT16) { size = 2; }
+    else if (format == TCI1X_FORMAT_INT32 || format == TCI1X_FORMAT_FLOAT32) { size = 4; }
+    else
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n",
-                  __func__, rig_strvfo(vfo));
-        RETURNFUNC(-RIG_EINVAL);
+        rig_debug(RIG_DEBUG_TRACE, "%s: IQ format %lu not handled\n", __func__, format);
+        return;
     }
 
-    if (vfo == RIG_VFO_CURR)
+    if (priv->iq_fill == 0
+            && elapsed_ms(&priv->spectrum_time, HAMLIB_ELAPSED_GET)
+            < TCI1X_SPECTRUM_INTERVAL)
     {
-        vfo = rig->state.current_vfo;
-        rig_debug(RIG_DEBUG_TRACE, "%s: get_freq2 vfo=%s\n",
-                  __func__, rig_strvfo(vfo));
+        return;
     }
 
-    char *cmd = vfo == RIG_VFO_A ? "vfo:0:0;" : "vfo:0:1:";
-    int retval;
-    int n;
+    p = frame + TCI1X_STREAM_HEADER;
+    count = (len - TCI1X_STREAM_HEADER) / (2 * size);
 
-    retval = tci1x_transaction(rig, cmd, NULL, value, sizeof(value));
+    for (i = 0; i < count && priv->iq_fill < TCI1X_FFT_SIZE; i++, p += 2 * size)
+    {
+        priv->re[priv->iq_fill] = tci1x_sample(p, format);
+        priv->im[priv->iq_fill] = tci1x_sample(p + size, format);
+        priv->iq_fill++;
+    }
 
-    if (retval != RIG_OK)
+    if (priv->iq_fill < TCI1X_FFT_SIZE)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: tci1x_transaction failed retval=%s\n", __func__,
-                  rigerror(retval));
-        RETURNFUNC(retval);
+        return;
     }
 
-    n = sscanf(&value[2], "vfo:%*d,%*d,%lf", freq);
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: got '%s', scanned %d items\n", __func__,
-              value, n);
+    priv->iq_fill = 0;
+    elapsed_ms(&priv->spectrum_time, HAMLIB_ELAPSED_SET);
 
-    if (*freq == 0)
+    for (i = 0; i < TCI1X_FFT_SIZE; i++)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: freq==0??\nvalue=%s\n", __func__,
-                  value);
-        RETURNFUNC(-RIG_EPROTO);
+        priv->re[i] *= priv->window[i];
+        priv->im[i] *= priv->window[i];
+        wsum += priv->window[i];
     }
-    else
+
+    tci1x_fft(priv->re, priv->im, TCI1X_FFT_SIZE);
+
+    pl = spectrum_pool_get();
+    line = pl ? &pl->line : &stack_line;
+    data = pl ? pl->data : priv->data;
+
+    /* negative frequencies first, so the line runs low to high */
+    for (i = 0; i < TCI1X_FFT_SIZE; i++)
     {
-        rig_debug(RIG_DEBUG_TRACE, "%s: freq=%.0f\n", __func__, *freq);
+        int k = (i + TCI1X_FFT_SIZE / 2) % TCI1X_FFT_SIZE;
+        float mag = sqrtf(priv->re[k] * priv->re[k] + priv->im[k] * priv->im[k]);
+        double db = 20 * log10(mag / wsum + 1e-12);
+        double level = (db - TCI1X_DB_MIN) * 255 / (TCI1X_DB_MAX - TCI1X_DB_MIN);
+
+        data[i] = level < 0 ? 0 : level > 255 ? 255 : (unsigned char) level;
     }
 
-    if (vfo == RIG_VFO_A)
+    TCI1X_LOCK(priv);
+    center = priv->dds[0] ? priv->dds[0] : priv->freq[0];
+    TCI1X_UNLOCK(priv);
+
+    *line = (struct rig_spectrum_line)
     {
-        priv->curr_freqA = *freq;
-    }
-    else
+        .id = 0,
+        .data_level_min = 0,
+        .data_level_max = 255,
+        .signal_strength_min = TCI1X_DB_MIN,
+        .signal_strength_max = TCI1X_DB_MAX,
+        .spectrum_mode = RIG_SPECTRUM_MODE_CENTER,
+        .center_freq = center,
+        .span_freq = rate,
+        .low_edge_freq = center - (freq_t)rate / 2,
+        .high_edge_freq = center + (freq_t)rate / 2,
+        .spectrum_data_length = TCI1X_FFT_SIZE,
+        .spectrum_data = data,
+    };
+
+    rig_fire_spectrum_event(rig, line);
+
+    if (pl)
     {
-        priv->curr_freqB = *freq;
+        spectrum_pool_put(pl);
     }
-
-    RETURNFUNC(RIG_OK);
 }
 
 /*
-* tci1x_set_freq
-* assumes rig!=NULL, rig->state.priv!=NULL
+* tci1x_poll
+* Reads and handles one message from the server
 */
-static int tci1x_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
+static int tci1x_poll(RIG *rig)
 {
-    int retval;
-    char cmd_arg[MAXARGLEN];
-    char *cmd;
     struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    size_t len = 0;
+    int opcode = tci1x_read_frame(rig, &len);
 
-    ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s freq=%.0f\n", __func__,
-              rig_strvfo(vfo), freq);
-
-    if (check_vfo(vfo) == FALSE)
+    if (opcode < 0)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n",
-                  __func__, rig_strvfo(vfo));
-        RETURNFUNC(-RIG_EINVAL);
+        return opcode;
     }
 
-    if (vfo == RIG_VFO_CURR)
+    if (opcode == WS_TEXT && len > 0)
     {
-        vfo = rig->state.current_vfo;
+        rig_debug(RIG_DEBUG_TRACE, "%s: '%.*s'\n", __func__,
+                  (int)(len < 256 ? len : 256), priv->frame);
+        tci1x_process_text(rig, (char *) priv->frame);
     }
-    else if (vfo == RIG_VFO_TX && priv->split)
+    else if (opcode == WS_BINARY && len >= TCI1X_STREAM_HEADER)
     {
-        vfo = RIG_VFO_B; // if split always TX on VFOB
-    }
+        unsigned long type = tci1x_get_u32(priv->frame + 24);
 
-    SNPRINTF(cmd_arg, sizeof(cmd_arg),
-             "<params><param><value><double>%.0f</double></value></param></params>", freq);
+        if (type == TCI1X_STREAM_IQ && priv->spectrum)
+        {
+            tci1x_process_iq(rig, priv->frame, len);
+        }
+    }
 
-    value_t val;
-    rig_get_ext_parm(rig, TOK_TCI1X_VERIFY_FREQ, &val);
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: set_verify_vfoA/B=%d\n", __func__, val.i);
+    return RIG_OK;
+}
 
-    if (vfo == RIG_VFO_A)
-    {
-        cmd = "rig.set_vfoA";
+#ifdef HAVE_PTHREAD
+static void *tci1x_thread(void *arg)
+{
+    RIG *rig = arg;
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
 
-        if (val.i) { cmd = "rig.set_verify_vfoA"; }
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: started\n", __func__);
 
-        rig_debug(RIG_DEBUG_TRACE, "%s %.0f\n", cmd, freq);
-        priv->curr_freqA = freq;
-    }
-    else
+    while (priv->running)
     {
-        cmd = "rig.set_vfoB";
+        int retval = tci1x_poll(rig);
 
-        if (val.i) { cmd = "rig.set_verify_vfoB"; }
-
-        rig_debug(RIG_DEBUG_TRACE, "%s %.0f\n", cmd, freq);
-        priv->curr_freqB = freq;
-    }
+        if (retval == RIG_OK || retval == -RIG_ETIMEOUT)
+        {
+            continue;
+        }
 
-    retval = tci1x_transaction(rig, cmd, cmd_arg, NULL, 0);
+        if (priv->running)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: connection lost: %s\n", __func__,
+                      rigerror(retval));
+        }
 
-    if (retval != RIG_OK)
-    {
-        RETURNFUNC(retval);
+        break;
     }
 
-    RETURNFUNC(RIG_OK);
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: stopped\n", __func__);
+
+    return NULL;
 }
+#endif
 
 /*
-* tci1x_set_ptt
-* Assumes rig!=NULL
+* tci1x_refresh
+* Without the reader thread, sends query and reads what the server sends
+* until it answers with a "name" command.  With the thread the state is
+* already current and this does nothing.
 */
-static int tci1x_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
+static int tci1x_refresh(RIG *rig, const char *query, const char *name)
 {
-    int retval;
-    char cmd_arg[MAXARGLEN];
     struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    int retval;
 
-    ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: ptt=%d\n", __func__, ptt);
+    if (priv->running)
+    {
+        return RIG_OK;
+    }
 
+    retval = tci1x_send(rig, query);
 
-    if (check_vfo(vfo) == FALSE)
+    if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n",
-                  __func__, rig_strvfo(vfo));
-        RETURNFUNC(-RIG_EINVAL);
+        return retval;
     }
 
-    SNPRINTF(cmd_arg, sizeof(cmd_arg),
-             "<params><param><value><i4>%d</i4></value></param></params>",
-             ptt);
+    priv->wait_for = name;
+    priv->got = 0;
 
-    value_t val;
-    char *cmd = "rig.set_ptt";
-    rig_get_ext_parm(rig, TOK_TCI1X_VERIFY_FREQ, &val);
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: fast_set_ptt=%d\n", __func__, val.i);
+    do
+    {
+        retval = tci1x_poll(rig);
+    }
+    while (retval == RIG_OK && !priv->got);
+
+    priv->wait_for = NULL;
 
-    if (val.i) { cmd = "rig.set_ptt_fast"; }
+    return retval;
+}
 
-    retval = tci1x_transaction(rig, cmd, cmd_arg, NULL, 0);
+static void tci1x_base64(const unsigned char *in, size_t len, char *out)
+{
+    static const char b64[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i;
 
-    if (retval != RIG_OK)
+    for (i = 0; i < len; i += 3)
     {
-        RETURNFUNC(retval);
-    }
+        unsigned long v = in[i] << 16;
 
-    priv->ptt = ptt;
+        if (i + 1 < len) { v |= in[i + 1] << 8; }
 
-    RETURNFUNC(RIG_OK);
+        if (i + 2 < len) { v |= in[i + 2]; }
+
+        *out++ = b64[(v >> 18) & 63];
+        *out++ = b64[(v >> 12) & 63];
+        *out++ = i + 1 < len ? b64[(v >> 6) & 63] : '=';
+        *out++ = i + 2 < len ? b64[v & 63] : '=';
+    }
+
+    *out = '\0';
 }
 
 /*
-* tci1x_get_ptt
-* Assumes rig!=NUL, ptt!=NULL
+* tci1x_handshake
+* Upgrades the connection to a WebSocket
 */
-static int tci1x_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
+static int tci1x_handshake(RIG *rig)
 {
-    char value[MAXCMDLEN];
     struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    hamlib_port_t *rp = &rig->state.rigport;
+    unsigned char nonce[16];
+    char key[32];
+    char buf[MAXCMDLEN];
+    int i;
+    int retval;
 
-    ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s\n", __func__,
-              rig_strvfo(vfo));
+    for (i = 0; i < (int)sizeof(nonce); i++)
+    {
+        priv->mask_seed = priv->mask_seed * 1103515245 + 12345;
+        nonce[i] = priv->mask_seed >> 16;
+    }
 
-    int retval;
+    tci1x_base64(nonce, sizeof(nonce), key);
 
-    retval = tci1x_transaction(rig, "rig.get_ptt", NULL, value, sizeof(value));
+    SNPRINTF(buf, sizeof(buf),
+             "GET / HTTP/1.1\r\nHost: %s\r\nUpgrade: websocket\r\n"
+             "Connection: Upgrade\r\nSec-WebSocket-Key: %s\r\n"
+             "Sec-WebSocket-Version: 13\r\n\r\n", rp->pathname, key);
 
-    if (retval != RIG_OK)
+    retval = write_block(rp, (unsigned char *) buf, strlen(buf));
+
+    if (retval < 0)
     {
-        RETURNFUNC(retval);
+        return -RIG_EIO;
     }
 
-    *ptt = atoi(value);
-    rig_debug(RIG_DEBUG_TRACE, "%s: '%s'\n", __func__, value);
+    for (i = 0; ; i++)
+    {
+        retval = read_string(rp, (unsigned char *) buf, sizeof(buf), "\n", 1, 0, 1);
+
+        if (retval <= 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: no WebSocket handshake\n", __func__);
+            return retval < 0 ? retval : -RIG_ETIMEOUT;
+        }
 
-    priv->ptt = *ptt;
+        rig_debug(RIG_DEBUG_TRACE, "%s: '%s'\n", __func__, buf);
 
-    RETURNFUNC(RIG_OK);
+        if (i == 0 && strstr(buf, " 101") == NULL)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: upgrade refused: %s\n", __func__, buf);
+            return -RIG_EPROTO;
+        }
+
+        if (strcmp(buf, "\r\n") == 0 || strcmp(buf, "\n") == 0)
+        {
+            return RIG_OK;
+        }
+    }
 }
 
 /*
-* tci1x_set_split_mode
+* tci1x_init
 * Assumes rig!=NULL
 */
-static int tci1x_set_split_mode(RIG *rig, vfo_t vfo, rmode_t mode,
-                                pbwidth_t width)
+static int tci1x_init(RIG *rig)
 {
-    int retval;
-    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    struct tci1x_priv_data *priv;
+    int i;
 
     ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s mode=%s width=%d\n",
-              __func__, rig_strvfo(vfo), rig_strrmode(mode), (int)width);
+    rig_debug(RIG_DEBUG_TRACE, "%s version %s\n", __func__, rig->caps->version);
 
-    switch (vfo)
+    if (!rig->caps)
     {
-    case RIG_VFO_CURR:
-        vfo = rig->state.current_vfo;
-        break;
+        RETURNFUNC(-RIG_EINVAL);
+    }
 
-    case RIG_VFO_TX:
-        vfo = RIG_VFO_B;
-        break;
+    rig->state.priv = calloc(1, sizeof(struct tci1x_priv_data));
+
+    if (!rig->state.priv)
+    {
+        RETURNFUNC(-RIG_ENOMEM);
     }
 
-    // If no change don't do it...modes are kept up to date by client calls
-    // to get_mode and set_mode so should be current here
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfoa privmode=%s\n", __func__,
-              rig_strrmode(priv->curr_modeA));
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfob privmode=%s\n", __func__,
-              rig_strrmode(priv->curr_modeB));
+    priv = rig->state.priv;
+
+    /*
+     * set arbitrary initial status
+     */
+    rig->state.current_vfo = RIG_VFO_A;
+    priv->mode = RIG_MODE_NONE;
+    priv->volume = -60;
+    priv->mask_seed = (unsigned int) time(NULL) ^ (unsigned int)(size_t) priv;
+
+    for (i = 0; i < TCI1X_FFT_SIZE; i++)
+    {
+        priv->window[i] = 0.5f - 0.5f * cosf(2 * M_PI * i / TCI1X_FFT_SIZE);
+    }
 
-    // save some VFO swapping .. may replace with VFO specific calls that won't cause VFO change
-    if (vfo == RIG_VFO_A && mode == priv->curr_modeA) { RETURNFUNC(RIG_OK); }
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init(&priv->state_lock, NULL);
+    pthread_mutex_init(&priv->write_lock, NULL);
+#endif
 
-    if (vfo == RIG_VFO_B && mode == priv->curr_modeB) { RETURNFUNC(RIG_OK); }
+    strncpy(rig->state.rigport.pathname, DEFAULTPATH,
+            sizeof(rig->state.rigport.pathname));
 
-    retval = tci1x_set_mode(rig, vfo, mode, width);
-    rig_debug(RIG_DEBUG_TRACE, "%s: set mode=%s\n", __func__,
-              rig_strrmode(mode));
-    RETURNFUNC(retval);
+    RETURNFUNC(RIG_OK);
 }
 
 /*
-* tci1x_set_mode
-* Assumes rig!=NULL
+* tci1x_open
+* Assumes rig!=NULL, rig->state.priv!=NULL
 */
-static int tci1x_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
+static int tci1x_open(RIG *rig)
 {
-    int retval;
-    int needBW;
-    int vfoSwitched;
-    char cmd_arg[MAXCMDLEN];
-    char *p;
-    char *pttmode;
-    char *ttmode;
     struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    int retval;
 
     ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s mode=%s width=%d\n",
-              __func__, rig_strvfo(vfo), rig_strrmode(mode), (int)width);
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: version %s\n", __func__, rig->caps->version);
 
+    priv->ready = 0;
+    priv->info[0] = '\0';
 
-    // if ptt is on do not set mode
-    if (priv->ptt)
-    {
-        rig_debug(RIG_DEBUG_TRACE, "%s: returning because priv->ptt=%d\n", __func__,
-                  (int)priv->ptt);
-        RETURNFUNC(RIG_OK);
-    }
+    retval = tci1x_handshake(rig);
 
-    if (vfo == RIG_VFO_CURR)
+    if (retval != RIG_OK)
     {
-        vfo = rig->state.current_vfo;
+        RETURNFUNC(retval);
     }
 
-    if (check_vfo(vfo) == FALSE)
+    /* the server sends its whole state, then "ready;" */
+    do
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n",
-                  __func__, rig_strvfo(vfo));
-        RETURNFUNC(-RIG_EINVAL);
+        retval = tci1x_poll(rig);
     }
+    while (retval == RIG_OK && !priv->ready);
 
-    if (priv->ptt)
+    if (!priv->ready)
     {
-        rig_debug(RIG_DEBUG_VERBOSE, "%s set_mode call not made as PTT=1\n", __func__);
-        RETURNFUNC(RIG_OK);  // just return OK and ignore this
+        rig_debug(RIG_DEBUG_ERR, "%s: no \"ready\" from the TCI server: %s\n",
+                  __func__, rigerror(retval));
+        RETURNFUNC(retval == RIG_OK ? -RIG_EPROTO : retval);
     }
 
-    // Switch to VFOB if appropriate since we can't set mode directly
-    // MDB
-    vfoSwitched = 0;
-    rig_debug(RIG_DEBUG_TRACE, "%s: curr_vfo = %s\n", __func__,
-              rig_strvfo(rig->state.current_vfo));
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s, protocol %d.%d, %d transceivers%s\n",
+              __func__, priv->info, priv->proto_major, priv->proto_minor,
+              priv->trx_count, priv->receive_only ? ", receive only" : "");
 
-    // If we don't have the get_bwA call we have to switch VFOs ourself
-    if (!priv->has_get_bwA && vfo == RIG_VFO_B
-            && rig->state.current_vfo != RIG_VFO_B)
-    {
-        vfoSwitched = 1;
-        rig_debug(RIG_DEBUG_TRACE, "%s: switch to VFOB = %d\n", __func__,
-                  vfoSwitched);
-    }
+    rig->state.current_vfo = RIG_VFO_A;
+    rig->state.tx_vfo = priv->split ? RIG_VFO_B : RIG_VFO_A;
 
-    if (vfoSwitched)   // swap to B and we'll swap back later
+    if (priv->spectrum)
     {
-        rig_debug(RIG_DEBUG_TRACE, "%s: switching to VFOB = %d\n", __func__,
-                  vfoSwitched);
-        retval = tci1x_set_vfo(rig, RIG_VFO_B);
+        char cmd[64];
 
-        if (retval < 0)
-        {
-            RETURNFUNC(retval);
-        }
+        SNPRINTF(cmd, sizeof(cmd), "iq_samplerate:%d;iq_start:0;", TCI1X_IQ_RATE);
+        tci1x_send(rig, cmd);
     }
 
-    // Set the mode
-    if (modeMapGetTCI(mode))
-    {
-        ttmode = strdup(modeMapGetTCI(mode));
-    }
-    else
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s: modeMapGetFlRig failed on mode=%d\n", __func__,
-                  (int)mode);
-        RETURNFUNC(-RIG_EINVAL);
-    }
+#ifdef HAVE_PTHREAD
+    priv->running = 1;
 
-    rig_debug(RIG_DEBUG_TRACE, "%s: got ttmode = %s\n", __func__,
-              ttmode == NULL ? "NULL" : ttmode);
-
-    if (ttmode == NULL)
+    if (pthread_create(&priv->thread, NULL, tci1x_thread, rig))
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: strdup failed\n", __func__);
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        priv->running = 0;
         RETURNFUNC(-RIG_EINTERNAL);
     }
 
-//   if (strncmp(ttmode,"ERROR",5)==0) RETURNFUNC(-RIG_EINTERN);
+#endif
+
+    RETURNFUNC(RIG_OK);
+}
 
-    pttmode = ttmode;
+/*
+* tci1x_close
+* Assumes rig!=NULL
+*/
+static int tci1x_close(RIG *rig)
+{
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
 
-    if (ttmode[0] == '|') { pttmode = &ttmode[1]; } // remove first pipe symbol
+    ENTERFUNC;
 
-    p = strchr(pttmode, '|');
+    if (priv->spectrum)
+    {
+        tci1x_send(rig, "iq_stop:0;");
+    }
 
-    if (p) { *p = 0; } // remove any other pipe
+    /* the server answers by closing, which ends the reader thread's read */
+    tci1x_ws_send(rig, WS_CLOSE, (const unsigned char *) "\x03\xe8", 2);
 
-    SNPRINTF(cmd_arg, sizeof(cmd_arg),
-             "<params><param><value>%s</value></param></params>", pttmode);
-    free(ttmode);
+#ifdef HAVE_PTHREAD
 
-    if (!priv->has_get_modeA)
+    if (priv->running)
     {
-        retval = tci1x_transaction(rig, "rig.set_mode", cmd_arg, NULL, 0);
+        priv->running = 0;
+        pthread_join(priv->thread, NULL);
     }
-    else
-    {
-        char *cmd = "rig.set_modeA";
 
-        if (vfo == RIG_VFO_B)
-        {
-            cmd = "rig.set_modeB";
-        }
-        else
-        {
-            // we make VFO_B mode unknown so it expires the cache
-            priv->curr_modeB = RIG_MODE_NONE;
-        }
+#endif
 
-        retval = tci1x_transaction(rig, cmd, cmd_arg, NULL, 0);
-    }
+    RETURNFUNC(RIG_OK);
+}
 
+/*
+* tci1x_cleanup
+* Assumes rig!=NULL, rig->state.priv!=NULL
+*/
+static int tci1x_cleanup(RIG *rig)
+{
+    struct tci1x_priv_data *priv;
 
-    if (retval != RIG_OK)
+    ENTERFUNC;
+
+    if (!rig)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: failed: %s\n", __func__,
-                  rigerror(retval));
-        RETURNFUNC(retval);
+        RETURNFUNC(-RIG_EINVAL);
     }
 
-    // Determine if we need to update the bandwidth
-    needBW = 0;
+    priv = (struct tci1x_priv_data *)rig->state.priv;
 
-    if (vfo == RIG_VFO_A)
+    if (priv)
     {
-        needBW = priv->curr_widthA != width;
-        rig_debug(RIG_DEBUG_TRACE, "%s: bw change on VFOA, curr width=%d  needBW=%d\n",
-                  __func__, (int)width, needBW);
-    }
-    else if (vfo == RIG_VFO_B)
-    {
-        needBW = priv->curr_widthB != width;
-        rig_debug(RIG_DEBUG_TRACE, "%s: bw change on VFOB, curr width=%d  needBW=%d\n",
-                  __func__, (int)width, needBW);
-    }
-    else
-    {
-        rig_debug(RIG_DEBUG_TRACE, "%s: needBW unknown vfo=%s\n", __func__,
-                  rig_strvfo(vfo));
+#ifdef HAVE_PTHREAD
+        pthread_mutex_destroy(&priv->state_lock);
+        pthread_mutex_destroy(&priv->write_lock);
+#endif
+        free(priv);
     }
 
-    // Need to update the bandwidth
-    if (width > 0 && needBW)
-    {
-        SNPRINTF(cmd_arg, sizeof(cmd_arg),
-                 "<params><param><value><i4>%ld</i4></value></param></params>",
-                 width);
-
-        retval = tci1x_transaction(rig, "rig.set_bandwidth", cmd_arg, NULL, 0);
+    rig->state.priv = NULL;
 
-        if (retval < 0)
-        {
-            RETURNFUNC(retval);
-        }
-    }
+    RETURNFUNC(RIG_OK);
+}
 
-    // Return to VFOA if needed
-    rig_debug(RIG_DEBUG_TRACE, "%s: switch to VFOA? = %d\n", __func__,
-              vfoSwitched);
+static int tci1x_set_conf(RIG *rig, token_t token, const char *val)
+{
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
 
-    if (vfoSwitched)
+    switch (token)
     {
-        rig_debug(RIG_DEBUG_TRACE, "%s: switching to VFOA\n", __func__);
-        retval = tci1x_set_vfo(rig, RIG_VFO_A);
+    case TOK_TCI1X_SPECTRUM:
+        priv->spectrum = atoi(val) ? 1 : 0;
+        break;
 
-        if (retval < 0)
-        {
-            RETURNFUNC(retval);
-        }
+    default:
+        return -RIG_EINVAL;
     }
 
-    if (vfo == RIG_VFO_A)
+    return RIG_OK;
+}
+
+static int tci1x_get_conf(RIG *rig, token_t token, char *val)
+{
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+
+    switch (token)
     {
-        priv->curr_modeA = mode;
-        priv->curr_widthA = width;
+    case TOK_TCI1X_SPECTRUM:
+        sprintf(val, "%d", priv->spectrum);
+        break;
+
+    default:
+        return -RIG_EINVAL;
     }
-    else
+
+    return RIG_OK;
+}
+
+/* VFO A and B are channels 0 and 1, RIG_VFO_TX the one split transmits on */
+static int tci1x_channel(RIG *rig, vfo_t vfo)
+{
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+
+    switch (vfo)
     {
-        priv->curr_modeB = mode;
-        priv->curr_widthB = width;
-    }
+    case RIG_VFO_CURR:
+        return rig->state.current_vfo == RIG_VFO_B;
 
-    rig_debug(RIG_DEBUG_TRACE,
-              "%s: return modeA=%s, widthA=%d\n,modeB=%s, widthB=%d\n", __func__,
-              rig_strrmode(priv->curr_modeA), (int)priv->curr_widthA,
-              rig_strrmode(priv->curr_modeB), (int)priv->curr_widthB);
-    RETURNFUNC(RIG_OK);
+    case RIG_VFO_A:
+    case RIG_VFO_MAIN:
+        return 0;
+
+    case RIG_VFO_B:
+    case RIG_VFO_SUB:
+        return 1;
+
+    case RIG_VFO_TX:
+        return priv->split ? 1 : 0;
+
+    default:
+        return -1;
+    }
 }
 
 /*
-* tci1x_get_mode
-* Assumes rig!=NULL, rig->state.priv!=NULL, mode!=NULL
+* tci1x_get_freq
+* Assumes rig!=NULL, rig->state.priv!=NULL, freq!=NULL
 */
-static int tci1x_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
+static int tci1x_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
 {
-    int retval;
-    int vfoSwitched;
-    char value[MAXCMDLEN];
-    char *cmdp;
-    vfo_t curr_vfo;
-    rmode_t my_mode;
     struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    int channel = tci1x_channel(rig, vfo);
+    char cmd[32];
+    int retval;
 
     ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s\n", __func__,
-              rig_strvfo(vfo));
 
-    if (check_vfo(vfo) == FALSE)
+    if (channel < 0)
     {
         rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n",
                   __func__, rig_strvfo(vfo));
         RETURNFUNC(-RIG_EINVAL);
     }
 
-    curr_vfo = rig->state.current_vfo;
-
-    if (vfo == RIG_VFO_CURR)
-    {
-        vfo = rig->state.current_vfo;
-    }
-
-    rig_debug(RIG_DEBUG_TRACE, "%s: using vfo=%s\n", __func__,
-              rig_strvfo(vfo));
+    SNPRINTF(cmd, sizeof(cmd), "vfo:0,%d;", channel);
+    retval = tci1x_refresh(rig, cmd, "vfo");
 
-    if (priv->ptt)
+    if (retval != RIG_OK)
     {
-        if (vfo == RIG_VFO_A) { *mode = priv->curr_modeA; }
-        else { *mode = priv->curr_modeB; }
-
-        rig_debug(RIG_DEBUG_VERBOSE, "%s call not made as PTT=1\n", __func__);
-        RETURNFUNC(RIG_OK);  // just return OK and ignore this
+        RETURNFUNC(retval);
     }
 
-    // Switch to VFOB if appropriate
-    vfoSwitched = 0;
+    TCI1X_LOCK(priv);
+    *freq = priv->freq[channel];
+    TCI1X_UNLOCK(priv);
 
-    if (priv->has_get_modeA == 0 && vfo == RIG_VFO_B && curr_vfo != RIG_VFO_B)
+    if (*freq == 0)
     {
-        vfoSwitched = 1;
+        rig_debug(RIG_DEBUG_ERR, "%s: no frequency from the server for %s\n",
+                  __func__, rig_strvfo(vfo));
+        RETURNFUNC(-RIG_EPROTO);
     }
 
-    if (vfoSwitched)
-    {
-        rig_debug(RIG_DEBUG_TRACE, "%s switch to VFOB=%d\n", __func__,
-                  priv->has_get_modeA);
-        retval = tci1x_set_vfo(rig, RIG_VFO_B);
+    RETURNFUNC(RIG_OK);
+}
 
-        if (retval < 0)
-        {
-            RETURNFUNC(retval);
-        }
-    }
+/*
+* tci1x_set_freq
+* assumes rig!=NULL, rig->state.priv!=NULL
+*/
+static int tci1x_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
+{
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    int channel = tci1x_channel(rig, vfo);
+    char cmd[64];
 
-    cmdp = "rig.get_mode"; /* default to old way */
+    ENTERFUNC;
+    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s freq=%.0f\n", __func__,
+              rig_strvfo(vfo), freq);
 
-    if (priv->has_get_modeA)   /* change to new way if we can */
+    if (channel < 0)
     {
-        /* calling this way reduces VFO swapping */
-        /* we get the cached value in tci1x */
-        /* vfo B may not be getting polled though in TCI */
-        /* so we may not be 100% accurate if op is twiddling knobs */
-        cmdp = "rig.get_modeA";
-
-        if (vfo == RIG_VFO_B) { cmdp = "rig.get_modeB"; }
+        rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n",
+                  __func__, rig_strvfo(vfo));
+        RETURNFUNC(-RIG_EINVAL);
     }
 
-    retval = tci1x_transaction(rig, cmdp, NULL, value, sizeof(value));
-
-    if (retval != RIG_OK)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s: %s failed: %s\n", __func__, cmdp,
-                  rigerror(retval));
-        RETURNFUNC(retval);
-    }
+    SNPRINTF(cmd, sizeof(cmd), "vfo:0,%d,%.0f;", channel, freq);
 
-    my_mode = modeMapGetHamlib(value);
-    *mode = my_mode;
-    rig_debug(RIG_DEBUG_TRACE, "%s: mode='%s'\n", __func__,
-              rig_strrmode(*mode));
+    TCI1X_LOCK(priv);
+    priv->freq[channel] = freq;
+    TCI1X_UNLOCK(priv);
 
-    if (vfo == RIG_VFO_A)
-    {
-        priv->curr_modeA = *mode;
-    }
-    else
-    {
-        priv->curr_modeB = *mode;
-    }
+    RETURNFUNC(tci1x_send(rig, cmd));
+}
 
+/*
+* tci1x_set_ptt
+* Assumes rig!=NULL
+*/
+static int tci1x_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
+{
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    char cmd[32];
 
-    /* Get the bandwidth */
-    cmdp = "rig.get_bw"; /* default to old way */
+    ENTERFUNC;
+    rig_debug(RIG_DEBUG_TRACE, "%s: ptt=%d\n", __func__, ptt);
 
-    if (priv->has_get_bwA)   /* change to new way if we can */
+    if (priv->receive_only && ptt != RIG_PTT_OFF)
     {
-        /* calling this way reduces VFO swapping */
-        /* we get the cached value in tci1x */
-        /* vfo B may not be getting polled though in TCI */
-        /* so we may not be 100% accurate if op is twiddling knobs */
-        cmdp = "rig.get_bwA";
-
-        if (vfo == RIG_VFO_B) { cmdp = "rig.get_bwB"; }
+        RETURNFUNC(-RIG_ENAVAIL);
     }
 
-    retval = tci1x_transaction(rig, cmdp, NULL, value, sizeof(value));
+    SNPRINTF(cmd, sizeof(cmd), "trx:0,%s;", ptt != RIG_PTT_OFF ? "true" : "false");
 
-    if (retval != RIG_OK)
-    {
-        RETURNFUNC(retval);
-    }
+    TCI1X_LOCK(priv);
+    priv->ptt = ptt;
+    TCI1X_UNLOCK(priv);
 
-    rig_debug(RIG_DEBUG_TRACE, "%s: mode=%s width='%s'\n", __func__,
-              rig_strrmode(*mode), value);
+    RETURNFUNC(tci1x_send(rig, cmd));
+}
 
-    // we get 2 entries pipe separated for bandwidth, lower and upper
-    if (strlen(value) > 0)
-    {
-        char *p = value;
+/*
+* tci1x_get_ptt
+* Assumes rig!=NUL, ptt!=NULL
+*/
+static int tci1x_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
+{
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    int retval;
 
-        /* we might get two values and then we want the 2nd one */
-        if (strchr(value, '|') != NULL) { p = strchr(value, '|') + 1; }
+    ENTERFUNC;
 
-        *width = atoi(p);
-    }
+    retval = tci1x_refresh(rig, "trx:0;", "trx");
 
-    if (vfo == RIG_VFO_A)
-    {
-        priv->curr_widthA = *width;
-    }
-    else
+    if (retval != RIG_OK)
     {
-        priv->curr_widthB = *width;
+        RETURNFUNC(retval);
     }
 
-    // Return to VFOA if needed
-    if (vfoSwitched)
-    {
-        retval = tci1x_set_vfo(rig, RIG_VFO_A);
-
-        if (retval != RIG_OK)
-        {
-            RETURNFUNC(retval);
-        }
-    }
+    TCI1X_LOCK(priv);
+    *ptt = priv->ptt;
+    TCI1X_UNLOCK(priv);
 
     RETURNFUNC(RIG_OK);
 }
 
 /*
-* tci1x_set_vfo
-* assumes rig!=NULL
+* tci1x_set_mode
+* Assumes rig!=NULL
+* The modulation is that of receiver 0, so of both VFOs
 */
-static int tci1x_set_vfo(RIG *rig, vfo_t vfo)
+static int tci1x_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 {
-    int retval;
-    char cmd_arg[MAXBUFLEN];
-    struct rig_state *rs = &rig->state;
     struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    const char *name = tci1x_mode_name(mode);
+    char cmd[128];
+    size_t len;
+    int i;
 
     ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s\n", __func__,
-              rig_strvfo(vfo));
-
+    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s mode=%s width=%d\n",
+              __func__, rig_strvfo(vfo), rig_strrmode(mode), (int)width);
 
-    if (check_vfo(vfo) == FALSE)
+    if (tci1x_channel(rig, vfo) < 0)
     {
         rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n",
                   __func__, rig_strvfo(vfo));
         RETURNFUNC(-RIG_EINVAL);
     }
 
-    if (vfo == RIG_VFO_TX)
+    if (mode == RIG_MODE_NONE)
     {
-        rig_debug(RIG_DEBUG_TRACE, "%s: RIG_VFO_TX used\n", __func__);
-        vfo = RIG_VFO_B; // always TX on VFOB
+        name = NULL;
     }
-
-    if (vfo == RIG_VFO_CURR)
+    else if (name == NULL)
     {
-        vfo = rig->state.current_vfo;
+        rig_debug(RIG_DEBUG_ERR, "%s: TCI does not have mode %s\n", __func__,
+                  rig_strrmode(mode));
+        RETURNFUNC(-RIG_EINVAL);
     }
 
-    SNPRINTF(cmd_arg, sizeof(cmd_arg),
-             "<params><param><value>%s</value></param></params>",
-             vfo == RIG_VFO_A ? "A" : "B");
-    retval = tci1x_transaction(rig, "rig.set_AB", cmd_arg, NULL, 0);
+    cmd[0] = '\0';
 
-    if (retval != RIG_OK)
+    if (name)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: rig.set_AB failed: %s\n", __func__,
-                  rigerror(retval));
-        RETURNFUNC(retval);
+        SNPRINTF(cmd, sizeof(cmd), "modulation:0,%s;", name);
+
+        for (i = 0; cmd[i]; i++)
+        {
+            cmd[i] = tolower((unsigned char) cmd[i]);
+        }
+    }
+    else
+    {
+        mode = priv->mode;
     }
 
-    rig->state.current_vfo = vfo;
-    rs->tx_vfo = RIG_VFO_B; // always VFOB
+    if (width == RIG_PASSBAND_NORMAL)
+    {
+        width = rig_passband_normal(rig, mode);
+    }
 
-    /* for some rigs TCI turns off split when VFOA is selected */
-    /* so if we are in split and asked for A we have to turn split back on */
-    if (priv->split && vfo == RIG_VFO_A)
+    if (width > 0)
     {
-        SNPRINTF(cmd_arg, sizeof(cmd_arg),
-                 "<params><param><value><i4>%d</i4></value></param></params>",
-                 priv->split);
-        retval = tci1x_transaction(rig, "rig.set_split", cmd_arg, NULL, 0);
+        int lo, hi;
 
-        if (retval < 0)
+        if (mode & (RIG_MODE_USB | RIG_MODE_PKTUSB))
+        {
+            lo = TCI1X_SSB_LOW;
+            hi = TCI1X_SSB_LOW + width;
+        }
+        else if (mode & (RIG_MODE_LSB | RIG_MODE_PKTLSB))
+        {
+            lo = -TCI1X_SSB_LOW - width;
+            hi = -TCI1X_SSB_LOW;
+        }
+        else
         {
-            RETURNFUNC(retval);
+            lo = -width / 2;
+            hi = width / 2;
         }
+
+        len = strlen(cmd);
+        snprintf(cmd + len, sizeof(cmd) - len, "rx_filter_band:0,%d,%d;", lo, hi);
+
+        TCI1X_LOCK(priv);
+        priv->filter_lo = lo;
+        priv->filter_hi = hi;
+        TCI1X_UNLOCK(priv);
     }
 
-    RETURNFUNC(RIG_OK);
+    if (cmd[0] == '\0')
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
+    TCI1X_LOCK(priv);
+    priv->mode = mode;
+    TCI1X_UNLOCK(priv);
+
+    RETURNFUNC(tci1x_send(rig, cmd));
 }
 
 /*
-* tci1x_get_vfo
-* assumes rig!=NULL, vfo != NULL
+* tci1x_get_mode
+* Assumes rig!=NULL, rig->state.priv!=NULL, mode!=NULL
 */
-static int tci1x_get_vfo(RIG *rig, vfo_t *vfo)
+static int tci1x_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
 {
-    char value[MAXCMDLEN];
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    int retval;
 
     ENTERFUNC;
 
-
-    int retval;
-    retval = tci1x_transaction(rig, "rig.get_AB", NULL, value, sizeof(value));
-
-    if (retval < 0)
+    if (tci1x_channel(rig, vfo) < 0)
     {
-        RETURNFUNC(retval);
+        rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n",
+                  __func__, rig_strvfo(vfo));
+        RETURNFUNC(-RIG_EINVAL);
     }
 
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo value=%s\n", __func__, value);
+    retval = tci1x_refresh(rig, "modulation:0;", "modulation");
 
-    switch (value[0])
+    if (retval == RIG_OK)
     {
-    case 'A':
-        *vfo = RIG_VFO_A;
-        break;
-
-    case 'B':
-        *vfo = RIG_VFO_B;
-        break;
-
-    default:
-        *vfo = RIG_VFO_CURR;
-        RETURNFUNC(-RIG_EINVAL);
+        retval = tci1x_refresh(rig, "rx_filter_band:0;", "rx_filter_band");
     }
 
-    if (check_vfo(*vfo) == FALSE)
+    if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n",
-                  __func__, rig_strvfo(*vfo));
-        RETURNFUNC(-RIG_EINVAL);
+        RETURNFUNC(retval);
     }
 
-    rig->state.current_vfo = *vfo;
-
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s\n", __func__,
-              rig_strvfo(*vfo));
+    TCI1X_LOCK(priv);
+    *mode = priv->mode;
+    *width = priv->filter_hi - priv->filter_lo;
+    TCI1X_UNLOCK(priv);
 
     RETURNFUNC(RIG_OK);
 }
 
 /*
-* tci1x_set_split_freq
+* tci1x_set_vfo
 * assumes rig!=NULL
+* TCI has no VFO selection, this only picks what RIG_VFO_CURR means
 */
-static int tci1x_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
-{
-    int retval;
-    char cmd_arg[MAXBUFLEN];
-    freq_t qtx_freq;
-    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
-
+static int tci1x_set_vfo(RIG *rig, vfo_t vfo)
+{
     ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s freq=%.1f\n", __func__,
-              rig_strvfo(vfo), tx_freq);
 
-    if (check_vfo(vfo) == FALSE)
+    if (vfo == RIG_VFO_CURR)
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
+    if (tci1x_channel(rig, vfo) < 0)
     {
         rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n",
                   __func__, rig_strvfo(vfo));
         RETURNFUNC(-RIG_EINVAL);
     }
 
-    // we always split on VFOB so if no change just return
-    retval = tci1x_get_freq(rig, RIG_VFO_B, &qtx_freq);
+    rig->state.current_vfo = tci1x_channel(rig, vfo) ? RIG_VFO_B : RIG_VFO_A;
 
-    if (retval != RIG_OK) { RETURNFUNC(retval); }
+    RETURNFUNC(RIG_OK);
+}
 
-    if (tx_freq == qtx_freq) { RETURNFUNC(RIG_OK); }
+/*
+* tci1x_get_vfo
+* assumes rig!=NULL, vfo != NULL
+*/
+static int tci1x_get_vfo(RIG *rig, vfo_t *vfo)
+{
+    ENTERFUNC;
 
-    SNPRINTF(cmd_arg, sizeof(cmd_arg),
-             "<params><param><value><double>%.6f</double></value></param></params>",
-             tx_freq);
-    retval = tci1x_transaction(rig, "rig.set_vfoB", cmd_arg, NULL, 0);
+    *vfo = rig->state.current_vfo;
 
-    if (retval < 0)
-    {
-        RETURNFUNC(retval);
-    }
+    RETURNFUNC(RIG_OK);
+}
 
-    priv->curr_freqB = tx_freq;
+/*
+* tci1x_set_split_freq
+* assumes rig!=NULL
+*/
+static int tci1x_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
+{
+    ENTERFUNC;
 
-    RETURNFUNC(RIG_OK);
+    // we always split on VFOB
+    RETURNFUNC(tci1x_set_freq(rig, RIG_VFO_B, tx_freq));
 }
 
 /*
@@ -1620,211 +1745,137 @@ static int tci1x_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
 */
 static int tci1x_get_split_freq(RIG *rig, vfo_t vfo, freq_t *tx_freq)
 {
-    int retval;
-    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
-
     ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s\n", __func__,
-              rig_strvfo(vfo));
 
-    retval = tci1x_get_freq(rig, RIG_VFO_B, tx_freq);
-    priv->curr_freqB = *tx_freq;
-    RETURNFUNC(retval);
+    RETURNFUNC(tci1x_get_freq(rig, RIG_VFO_B, tx_freq));
 }
 
 /*
-* tci1x_set_split_vfo
-* assumes rig!=NULL, tx_freq!=NULL
+* tci1x_set_split_mode
+* assumes rig!=NULL
+* Both VFOs share the modulation, so only a change is sent
 */
-static int tci1x_set_split_vfo(RIG *rig, vfo_t vfo, split_t split, vfo_t tx_vfo)
+static int tci1x_set_split_mode(RIG *rig, vfo_t vfo, rmode_t mode,
+                                pbwidth_t width)
 {
-    int retval;
-    vfo_t qtx_vfo;
-    split_t qsplit;
     struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
-    char cmd_arg[MAXBUFLEN];
+    rmode_t curr_mode;
 
     ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: tx_vfo=%s\n", __func__,
-              rig_strvfo(tx_vfo));
-
-    retval = tci1x_get_split_vfo(rig, RIG_VFO_A, &qsplit, &qtx_vfo);
-
-    if (retval != RIG_OK) { RETURNFUNC(retval); }
-
-    if (split == qsplit) { RETURNFUNC(RIG_OK); }
 
-    if (priv->ptt)
-    {
-        rig_debug(RIG_DEBUG_VERBOSE, "%s call not made as PTT=1\n", __func__);
-        RETURNFUNC(RIG_OK);  // just return OK and ignore this
-    }
+    TCI1X_LOCK(priv);
+    curr_mode = priv->mode;
+    TCI1X_UNLOCK(priv);
 
-    SNPRINTF(cmd_arg, sizeof(cmd_arg),
-             "<params><param><value><i4>%d</i4></value></param></params>",
-             split);
-    retval = tci1x_transaction(rig, "rig.set_split", cmd_arg, NULL, 0);
-
-    if (retval < 0)
+    if (mode == curr_mode && width == RIG_PASSBAND_NOCHANGE)
     {
-        RETURNFUNC(retval);
+        RETURNFUNC(RIG_OK);
     }
 
-    priv->split = split;
-
-    RETURNFUNC(RIG_OK);
+    RETURNFUNC(tci1x_set_mode(rig, RIG_VFO_B, mode, width));
 }
 
 /*
-* tci1x_get_split_vfo
-* assumes rig!=NULL, tx_freq!=NULL
+* tci1x_get_split_mode
+* assumes rig!=NULL, mode!=NULL, width!=NULL
 */
-static int tci1x_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split,
-                               vfo_t *tx_vfo)
+static int tci1x_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
+                                pbwidth_t *width)
 {
-    char value[MAXCMDLEN];
-    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
-
     ENTERFUNC;
 
-    int retval;
-    retval = tci1x_transaction(rig, "rig.get_split", NULL, value, sizeof(value));
-
-    if (retval < 0)
-    {
-        RETURNFUNC(retval);
-    }
-
-    *tx_vfo = RIG_VFO_B;
-    *split = atoi(value);
-    priv->split = *split;
-    rig_debug(RIG_DEBUG_TRACE, "%s tx_vfo=%s, split=%d\n", __func__,
-              rig_strvfo(*tx_vfo), *split);
-    RETURNFUNC(RIG_OK);
+    RETURNFUNC(tci1x_get_mode(rig, RIG_VFO_B, mode, width));
 }
 
 /*
-* tci1x_set_split_freq_mode
+* tci1x_set_split_vfo
 * assumes rig!=NULL
 */
-static int tci1x_set_split_freq_mode(RIG *rig, vfo_t vfo, freq_t freq,
-                                     rmode_t mode, pbwidth_t width)
+static int tci1x_set_split_vfo(RIG *rig, vfo_t vfo, split_t split, vfo_t tx_vfo)
 {
-    int retval;
-    rmode_t qmode;
-    pbwidth_t qwidth;
     struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    char cmd[32];
 
     ENTERFUNC;
+    rig_debug(RIG_DEBUG_TRACE, "%s: split=%d tx_vfo=%s\n", __func__, split,
+              rig_strvfo(tx_vfo));
 
-    // we alway do split on VFOB
-    retval = tci1x_set_freq(rig, RIG_VFO_B, freq);
-
-    if (retval != RIG_OK)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s tci1x_set_freq failed\n", __func__);
-        RETURNFUNC(retval);
-    }
-
-    // Make VFOB mode match VFOA mode, keep VFOB width
-    retval = tci1x_get_mode(rig, RIG_VFO_B, &qmode, &qwidth);
-
-    if (retval != RIG_OK) { RETURNFUNC(retval); }
-
-    if (qmode == priv->curr_modeA) { RETURNFUNC(RIG_OK); }
-
-    if (priv->ptt)
-    {
-        rig_debug(RIG_DEBUG_VERBOSE, "%s set_mode call not made as PTT=1\n", __func__);
-        RETURNFUNC(RIG_OK);  // just return OK and ignore this
-    }
-
-    retval = tci1x_set_mode(rig, RIG_VFO_B, priv->curr_modeA, width);
+    SNPRINTF(cmd, sizeof(cmd), "split_enable:0,%s;", split ? "true" : "false");
 
-    if (retval != RIG_OK)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s tci1x_set_mode failed\n", __func__);
-        RETURNFUNC(retval);
-    }
+    TCI1X_LOCK(priv);
+    priv->split = split;
+    TCI1X_UNLOCK(priv);
 
-    retval = tci1x_set_vfo(rig, RIG_VFO_A);
+    rig->state.tx_vfo = split ? RIG_VFO_B : RIG_VFO_A;
 
-    RETURNFUNC(retval);
+    RETURNFUNC(tci1x_send(rig, cmd));
 }
 
 /*
-* tci1x_get_split_freq_mode
-* assumes rig!=NULL, freq!=NULL, mode!=NULL, width!=NULL
+* tci1x_get_split_vfo
+* assumes rig!=NULL, split!=NULL, tx_vfo!=NULL
 */
-static int tci1x_get_split_freq_mode(RIG *rig, vfo_t vfo, freq_t *freq,
-                                     rmode_t *mode, pbwidth_t *width)
+static int tci1x_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split,
+                               vfo_t *tx_vfo)
 {
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
     int retval;
 
     ENTERFUNC;
 
-    if (vfo != RIG_VFO_CURR && vfo != RIG_VFO_TX)
+    retval = tci1x_refresh(rig, "split_enable:0;", "split_enable");
+
+    if (retval != RIG_OK)
     {
-        RETURNFUNC(-RIG_ENTARGET);
+        RETURNFUNC(retval);
     }
 
-    retval = tci1x_get_freq(rig, RIG_VFO_B, freq);
+    TCI1X_LOCK(priv);
+    *split = priv->split;
+    TCI1X_UNLOCK(priv);
 
-    if (RIG_OK == retval)
-    {
-        retval = tci1x_get_mode(rig, vfo, mode, width);
-    }
+    *tx_vfo = *split ? RIG_VFO_B : RIG_VFO_A;
 
-    RETURNFUNC(retval);
+    RETURNFUNC(RIG_OK);
 }
 
-#ifdef XXNOTIMPLEMENTED
+/*
+* tci1x_set_level
+* assumes rig!=NULL
+*/
 static int tci1x_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
 {
-    int retval;
-    char cmd_arg[MAXARGLEN];
-    char *cmd;
-    char *param_type = "i4";
+    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    char cmd[64];
 
     ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s level=%d, val=%f\n", __func__,
-              rig_strvfo(vfo), (int)level, val.f);
-
-    if (check_vfo(vfo) == FALSE)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n",
-                  __func__, rig_strvfo(vfo));
-        RETURNFUNC(-RIG_EINVAL);
-    }
 
     switch (level)
     {
-    case RIG_LEVEL_RF: cmd = "rig.set_rfgain"; val.f *= 100; break;
-
-    case RIG_LEVEL_AF: cmd = "rig.set_volume"; val.f *= 100; break;
+    case RIG_LEVEL_AF:
+        /* 0-1 on -60-0 dB */
+        SNPRINTF(cmd, sizeof(cmd), "volume:%d;", (int)lrintf(val.f * 60 - 60));
+        break;
 
-    case RIG_LEVEL_MICGAIN: cmd = "rig.set_micgain"; val.f *= 100; break;
+    case RIG_LEVEL_RFPOWER:
+        if (priv->proto_major > 1 || priv->proto_minor >= 5)
+        {
+            SNPRINTF(cmd, sizeof(cmd), "drive:0,%d;", (int)lrintf(val.f * 100));
+        }
+        else
+        {
+            SNPRINTF(cmd, sizeof(cmd), "drive:%d;", (int)lrintf(val.f * 100));
+        }
 
-    case RIG_LEVEL_RFPOWER: cmd = "rig.set_power"; val.f *= 100; break;
+        break;
 
     default:
-        rig_debug(RIG_DEBUG_ERR, "%s: invalid level=%d\n", __func__, (int)level);
+        rig_debug(RIG_DEBUG_ERR, "%s: unsupported level %s\n", __func__,
+                  rig_strlevel(level));
         RETURNFUNC(-RIG_EINVAL);
     }
 
-    SNPRINTF(cmd_arg, sizeof(cmd_arg),
-             "<params><param><value><%s>%d</%s></value></param></params>",
-             param_type, (int)val.f, param_type);
-
-
-    retval = tci1x_transaction(rig, cmd, cmd_arg, NULL, 0);
-
-    if (retval < 0)
-    {
-        RETURNFUNC(retval);
-    }
-
-    RETURNFUNC(RIG_OK);
+    RETURNFUNC(tci1x_send(rig, cmd));
 }
 
 /*
@@ -1833,78 +1884,85 @@ static int tci1x_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
 */
 static int tci1x_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
 {
-    char value[MAXARGLEN];
-    char *cmd;
-    int retval;
     struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
+    int retval = RIG_OK;
 
     ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s\n", __func__,
-              rig_strvfo(vfo));
-
 
     switch (level)
     {
-    case RIG_LEVEL_AF: cmd = "rig.get_volume"; break;
-
-    case RIG_LEVEL_RF: cmd = "rig.get_rfgain"; break;
+    case RIG_LEVEL_STRENGTH:
+        if (priv->running)
+        {
+            /* not every server pushes the S-meter, ask for the next one */
+            if (elapsed_ms(&priv->smeter_time, HAMLIB_ELAPSED_GET)
+                    >= TCI1X_SMETER_AGE)
+            {
+                tci1x_send(rig, "rx_smeter:0,0;");
+            }
+        }
+        else
+        {
+            retval = tci1x_refresh(rig, "rx_smeter:0,0;", "rx_smeter");
+        }
 
-    case RIG_LEVEL_MICGAIN: cmd = "rig.get_micgain"; break;
+        break;
 
-    case RIG_LEVEL_STRENGTH: cmd = "rig.get_smeter"; break;
+    case RIG_LEVEL_AF:
+        retval = tci1x_refresh(rig, "volume;", "volume");
+        break;
 
-    case RIG_LEVEL_RFPOWER: cmd = "rig.get_power"; break;
+    case RIG_LEVEL_RFPOWER:
+        retval = tci1x_refresh(rig, priv->proto_major > 1 || priv->proto_minor >= 5
+                               ? "drive:0;" : "drive;", "drive");
+        break;
 
     case RIG_LEVEL_RFPOWER_METER_WATTS:
-    case RIG_LEVEL_RFPOWER_METER: cmd = "rig.get_pwrmeter"; break;
+    case RIG_LEVEL_SWR:
+        /* pushed while transmitting */
+        break;
 
     default:
-        rig_debug(RIG_DEBUG_ERR, "%s: unknown level=%d\n", __func__, (int)level);
+        rig_debug(RIG_DEBUG_ERR, "%s: unsupported level %s\n", __func__,
+                  rig_strlevel(level));
         RETURNFUNC(-RIG_EINVAL);
     }
 
-    retval = tci1x_transaction(rig, cmd, NULL, value, sizeof(value));
-
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: tci1x_transaction failed retval=%s\n", __func__,
-                  rigerror(retval));
         RETURNFUNC(retval);
     }
 
-    // most levels are 0-100 -- may have to allow for different ranges
+    TCI1X_LOCK(priv);
+
     switch (level)
     {
     case RIG_LEVEL_STRENGTH:
-        val->i = atoi(value) - 54;
-        //if (val->i > 0) val->i /= 10;
-        rig_debug(RIG_DEBUG_TRACE, "%s: val.i='%s'(%d)\n", __func__, value, val->i);
+        /* dB over S9, -73 dBm */
+        val->i = (int)lrintf(priv->smeter + 73);
         break;
 
-    case RIG_LEVEL_RFPOWER:
-        val->f = atof(value) / 100.0 * priv->powermeter_scale;
-        rig_debug(RIG_DEBUG_TRACE, "%s: val.f='%s'(%g)\n", __func__, value, val->f);
+    case RIG_LEVEL_AF:
+        val->f = (priv->volume + 60) / 60;
         break;
 
-    case RIG_LEVEL_RFPOWER_METER:
-        val->f = atof(value) / 100.0 * priv->powermeter_scale;
-        rig_debug(RIG_DEBUG_TRACE, "%s: val.f='%s'(%g)\n", __func__, value, val->f);
+    case RIG_LEVEL_RFPOWER:
+        val->f = priv->drive / 100;
         break;
 
     case RIG_LEVEL_RFPOWER_METER_WATTS:
-        val->f = atof(value) * priv->powermeter_scale;
-        rig_debug(RIG_DEBUG_TRACE, "%s: val.f='%s'(%g)\n", __func__, value, val->f);
+        val->f = priv->ptt ? priv->tx_power : 0;
         break;
 
-    default:
-        val->f = atof(value) / 100;
-        rig_debug(RIG_DEBUG_TRACE, "%s: val.f='%s'(%f)\n", __func__, value, val->f);
+    case RIG_LEVEL_SWR:
+        val->f = priv->ptt && priv->tx_swr >= 1 ? priv->tx_swr : 1;
+        break;
     }
 
+    TCI1X_UNLOCK(priv);
 
     RETURNFUNC(RIG_OK);
 }
-#endif
 
 /*
 * tci1x_get_info
@@ -1920,14 +1978,12 @@ static const char *tci1x_get_info(RIG *rig)
 static int tci1x_power2mW(RIG *rig, unsigned int *mwpower, float power,
                           freq_t freq, rmode_t mode)
 {
-    struct tci1x_priv_data *priv = (struct tci1x_priv_data *) rig->state.priv;
     ENTERFUNC;
     rig_debug(RIG_DEBUG_TRACE, "%s: passed power = %f\n", __func__, power);
     rig_debug(RIG_DEBUG_TRACE, "%s: passed freq = %"PRIfreq" Hz\n", __func__, freq);
     rig_debug(RIG_DEBUG_TRACE, "%s: passed mode = %s\n", __func__,
               rig_strrmode(mode));
 
-    power *= priv->powermeter_scale;
     *mwpower = (power * 100000);
 
     RETURNFUNC(RIG_OK);
@@ -1947,175 +2003,3 @@ static int tci1x_mW2power(RIG *rig, float *power, unsigned int mwpower,
     RETURNFUNC(RIG_OK);
 
 }
-
-#ifdef XXNOTIMPLEMENTED
-static int tci1x_set_ext_parm(RIG *rig, token_t token, value_t val)
-{
-    struct tci1x_priv_data *priv = (struct tci1x_priv_data *)rig->state.priv;
-    char lstr[64];
-    const struct confparams *cfp;
-    struct ext_list *epp;
-
-    ENTERFUNC;
-    cfp = rig_ext_lookup_tok(rig, token);
-
-    if (!cfp)
-    {
-        RETURNFUNC(-RIG_EINVAL);
-    }
-
-    switch (token)
-    {
-    case TOK_TCI1X_VERIFY_FREQ:
-    case TOK_TCI1X_VERIFY_PTT:
-        if (val.i && !priv->has_verify_cmds)
-        {
-            rig_debug(RIG_DEBUG_ERR,
-                      "%s: FLRig version 1.3.54.18 or higher needed to support fast functions\n",
-                      __func__);
-            RETURNFUNC(-RIG_EINVAL);
-        }
-
-        break;
-
-    default:
-        RETURNFUNC(-RIG_EINVAL);
-    }
-
-    switch (cfp->type)
-    {
-    case RIG_CONF_STRING:
-        strcpy(lstr, val.s);
-        break;
-
-
-    case RIG_CONF_COMBO:
-        SNPRINTF(lstr, sizeof(lstr), "%d", val.i);
-        break;
-
-    case RIG_CONF_NUMERIC:
-        SNPRINTF(lstr, sizeof(lstr), "%f", val.f);
-        break;
-
-    case RIG_CONF_CHECKBUTTON:
-        SNPRINTF(lstr, sizeof(lstr), "%s", val.i ? "ON" : "OFF");
-        break;
-
-    case RIG_CONF_BUTTON:
-        lstr[0] = '\0';
-        break;
-
-    default:
-        RETURNFUNC(-RIG_EINTERNAL);
-    }
-
-    epp = find_ext(priv->ext_parms, token);
-
-    if (!epp)
-    {
-        RETURNFUNC(-RIG_EINTERNAL);
-    }
-
-    /* store value */
-    epp->val = val;
-
-
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called: %s %s\n", __func__,
-              cfp->name, lstr);
-
-    RETURNFUNC(RIG_OK);
-}
-
-static int tci1x_get_ext_parm(RIG *rig, token_t token, value_t *val)
-{
-    struct tci1x_priv_data *priv = (struct tci1x_priv_data *)rig->state.priv;
-    const struct confparams *cfp;
-    struct ext_list *epp;
-
-    ENTERFUNC;
-    /* TODO: load value from priv->ext_parms */
-
-    cfp = rig_ext_lookup_tok(rig, token);
-
-    if (!cfp)
-    {
-        RETURNFUNC(-RIG_EINVAL);
-    }
-
-    switch (token)
-    {
-    case TOK_TCI1X_VERIFY_FREQ:
-    case TOK_TCI1X_VERIFY_PTT:
-        break;
-
-    default:
-        RETURNFUNC(-RIG_EINVAL);
-    }
-
-    epp = find_ext(priv->ext_parms, token);
-
-    if (!epp)
-    {
-        RETURNFUNC(-RIG_EINTERNAL);
-    }
-
-    /* load value */
-    *val = epp->val;
-
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called: %s\n", __func__,
-              cfp->name);
-
-    RETURNFUNC(RIG_OK);
-}
-
-
-static int tci1x_set_ext_parm(RIG *rig, setting_t parm, value_t val)
-{
-    struct tci1x_priv_data *priv = (struct tci1x_priv_data *)rig->state.priv;
-    int idx;
-    char pstr[32];
-
-    ENTERFUNC;
-    idx = rig_setting2idx(parm);
-
-    if (idx >= RIG_SETTING_MAX)
-    {
-        RETURNFUNC(-RIG_EINVAL);
-    }
-
-    if (RIG_PARM_IS_FLOAT(parm))
-    {
-        SNPRINTF(pstr, sizeof(pstr), "%f", val.f);
-    }
-    else
-    {
-        SNPRINTF(pstr, sizeof(pstr), "%d", val.i);
-    }
-
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called: %s %s\n", __func__,
-              rig_strparm(parm), pstr);
-    priv->parms[idx] = val;
-
-    RETURNFUNC(RIG_OK);
-}
-
-static int tci1x_get_ext_parm(RIG *rig, setting_t parm, value_t *val)
-{
-    struct tci1x_priv_data *priv = (struct tci1x_priv_data *)rig->state.priv;
-    int idx;
-
-    ENTERFUNC;
-    idx = rig_setting2idx(parm);
-
-    if (idx >= RIG_SETTING_MAX)
-    {
-        RETURNFUNC(-RIG_EINVAL);
-    }
-
-    *val = priv->parms[idx];
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called %s\n", __func__,
-              rig_strparm(parm));
-
-    RETURNFUNC(RIG_OK);
-}
-#endif
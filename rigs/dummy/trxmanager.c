@@ -1,5 +1,5 @@
 /*
- i  Hamlib TRXManager backend - main file
+ *  Hamlib TRXManager backend - main file
  *  Copyright (c) 2018 by Michael Black W9MDB
  *  Derived from flrig.c
  *
@@ -19,13 +19,41 @@
  *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  *
  */
+
+/*
+ * TRX-Manager answers each ';' terminated command with a line starting
+ * with the command's two letters, and with "AI1;" also sends a line for
+ * every change made on its side.  Every line, answer or not, goes into
+ * the state kept here and through the freq/mode/ptt events into the rig
+ * cache.  What has been pushed since the connection was made is answered
+ * from that state without asking again.
+ *
+ * With threads a reader thread owns the connection: it takes every line,
+ * hands answers to the waiting transaction, and when the link drops
+ * reconnects with exponential backoff.  A transaction meanwhile waits for
+ * the reconnect if the next attempt is due within its timeout, else fails
+ * at once instead of blocking for the whole timeout.  Without threads the
+ * transaction reads and reconnects itself.
+ */
+
 #include <hamlib/config.h>
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>             /* String function definitions */
+#include <ctype.h>
+#include <errno.h>
 #include <unistd.h>             /* UNIX standard function definitions */
 #include <math.h>
+#include <sys/time.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#if defined (HAVE_SYS_SOCKET_H)
+#include <sys/socket.h>
+#elif HAVE_WS2TCPIP_H
+#include <ws2tcpip.h>
+#endif
 
 #include <hamlib/rig.h>
 #include <serial.h>
@@ -34,6 +62,8 @@
 #include <token.h>
 #include <register.h>
 #include <network.h>
+#include <iofunc.h>
+#include <event.h>
 
 #include "trxmanager.h"
 
@@ -42,6 +72,13 @@
 #define MAXCMDLEN 64
 
 #define DEFAULTPATH "127.0.0.1:1003"
+#define TRXMANAGER_PORT 1003
+
+/* reconnect delays after a dropped link, doubling from MIN up to MAX */
+#define TRXMANAGER_BACKOFF_MIN 250
+#define TRXMANAGER_BACKOFF_MAX 8000
+/* how long a reconnect may take to connect and say hello */
+#define TRXMANAGER_CONNECT_TIME 1000
 
 #define TRXMANAGER_VFOS (RIG_VFO_A|RIG_VFO_B)
 
@@ -110,8 +147,40 @@ struct trxmanager_priv_data
     vfo_t vfo_curr;
     char info[100];
     split_t split;
+    /* state from answers and pushes, the *_pushed ones kept current by AI1 */
+    int ai;                     /* TRX-Manager accepted AI1 */
+    freq_t freq[2];             /* RX (VFO A) and TX (VFO B) */
+    int freq_pushed[2];
+    rmode_t mode;
+    int mode_pushed;
+    ptt_t ptt;
+    int ptt_pushed;
+    int split_pushed;
+    /* connection */
+    int connected;
+    int backoff;                /* ms before the next reconnect attempt */
+    struct timespec last_attempt;
+    /* transaction in flight */
+    char wait_for[3];
+    int replied;
+    char reply[MAXCMDLEN];
+    int running;
+#ifdef HAVE_PTHREAD
+    pthread_t thread;
+    pthread_mutex_t lock;       /* everything above */
+    pthread_mutex_t cmd_lock;   /* one transaction at a time */
+    pthread_cond_t cond;        /* a reply, or the connection changing */
+#endif
 };
 
+#ifdef HAVE_PTHREAD
+#define TRXMANAGER_LOCK(priv) pthread_mutex_lock(&(priv)->lock)
+#define TRXMANAGER_UNLOCK(priv) pthread_mutex_unlock(&(priv)->lock)
+#else
+#define TRXMANAGER_LOCK(priv)
+#define TRXMANAGER_UNLOCK(priv)
+#endif
+
 struct rig_caps trxmanager_caps =
 {
     RIG_MODEL(RIG_MODEL_TRXMANAGER_RIG),
@@ -229,11 +298,41 @@ static int vfo_curr(RIG *rig, vfo_t vfo)
 }
 #endif
 
+static rmode_t trxmanager_mode(char tmode)
+{
+    switch (tmode)
+    {
+    case FLRIG_MODE_LSB: return RIG_MODE_LSB;
+
+    case FLRIG_MODE_USB: return RIG_MODE_USB;
+
+    case FLRIG_MODE_CW: return RIG_MODE_CW;
+
+    case FLRIG_MODE_FM: return RIG_MODE_FM;
+
+    case FLRIG_MODE_AM: return RIG_MODE_AM;
+
+    case FLRIG_MODE_RTTY: return RIG_MODE_RTTY;
+
+    case FLRIG_MODE_CWR: return RIG_MODE_CWR;
+
+    case FLRIG_MODE_RTTYR: return RIG_MODE_RTTYR;
+
+    case FLRIG_MODE_PKTLSB: return RIG_MODE_PKTLSB;
+
+    case FLRIG_MODE_PKTUSB: return RIG_MODE_PKTUSB;
+
+    default: return RIG_MODE_NONE;
+    }
+}
+
 /*
  * read_transaction
  * Assumes rig!=NULL, response!=NULL, response_len>=MAXCMDLEN
+ * idle is set where a quiet line is no error, so no timeout is logged
  */
-static int read_transaction(RIG *rig, char *response, int response_len)
+static int read_transaction(RIG *rig, char *response, int response_len,
+                            int idle)
 {
     struct rig_state *rs = &rig->state;
     char *delims = "\n";
@@ -243,16 +342,526 @@ static int read_transaction(RIG *rig, char *response, int response_len)
 
     len = read_string(&rs->rigport, (unsigned char *) response, response_len,
                       delims,
-                      strlen(delims), 0, 1);
+                      strlen(delims), idle, 1);
+
+    if (len == -RIG_ETIMEOUT)
+    {
+        return len;
+    }
 
     if (len <= 0)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: read_string error=%d\n", __func__, len);
-        return -RIG_EPROTO;
+        if (!idle)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: read_string error=%d\n", __func__, len);
+        }
+
+        return -RIG_EIO;
+    }
+
+    return RIG_OK;
+}
+
+/*
+ * trxmanager_process_line
+ * Takes an answer or a push into the state, fires the events for what
+ * changed, and hands an answer to the transaction waiting for it
+ */
+static void trxmanager_process_line(RIG *rig, char *line)
+{
+    struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
+                                        rig->state.priv;
+    int len;
+    int is_reply;
+    int freq_vfo = -1;
+    int mode_changed = 0;
+    int ptt_changed = 0;
+    freq_t freq = 0;
+    rmode_t mode;
+    ptt_t ptt;
+
+    /* answers end in ";\r\n", pushes may not */
+    len = strcspn(line, "\r\n");
+    line[len] = '\0';
+
+    if (len < 2)
+    {
+        return;
+    }
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: '%s'\n", __func__, line);
+
+    TRXMANAGER_LOCK(priv);
+
+    is_reply = priv->wait_for[0] && !priv->replied
+               && strncmp(line, priv->wait_for, 2) == 0;
+
+    if ((line[0] == 'X' && (line[1] == 'R' || line[1] == 'T'))
+            || (line[0] == 'F' && (line[1] == 'A' || line[1] == 'B')))
+    {
+        int n = line[1] == 'R' || line[1] == 'A' ? 0 : 1;
+
+        if (sscanf(line + 2, "%lf", &freq) == 1 && freq > 0)
+        {
+            if (freq != priv->freq[n]) { freq_vfo = n; }
+
+            priv->freq[n] = freq;
+            priv->freq_pushed[n] |= !is_reply && priv->ai;
+        }
+    }
+    else if (line[0] == 'M' && line[1] == 'D' && len >= 4)
+    {
+        rmode_t m = trxmanager_mode(line[2]);
+
+        if (m != RIG_MODE_NONE)
+        {
+            mode_changed = m != priv->mode;
+            priv->mode = m;
+            priv->mode_pushed |= !is_reply && priv->ai;
+        }
+    }
+    else if (line[0] == 'I' && line[1] == 'F' && len >= 30)
+    {
+        ptt_t p = line[28] == '0' ? RIG_PTT_OFF : RIG_PTT_ON;
+        rmode_t m = trxmanager_mode(line[29]);
+
+        ptt_changed = p != priv->ptt;
+        priv->ptt = p;
+        priv->ptt_pushed |= !is_reply && priv->ai;
+
+        if (m != RIG_MODE_NONE)
+        {
+            mode_changed = m != priv->mode;
+            priv->mode = m;
+        }
+    }
+    else if ((streq(line, "TX;") || streq(line, "RX;")))
+    {
+        ptt_t p = line[0] == 'T' ? RIG_PTT_ON : RIG_PTT_OFF;
+
+        ptt_changed = p != priv->ptt;
+        priv->ptt = p;
+        priv->ptt_pushed |= !is_reply && priv->ai;
+    }
+    else if (line[0] == 'S' && line[1] == 'P' && isdigit((unsigned char)line[2]))
+    {
+        priv->split = line[2] != '0';
+        priv->split_pushed |= !is_reply && priv->ai;
+    }
+
+    mode = priv->mode;
+    ptt = priv->ptt;
+
+    if (is_reply)
+    {
+        SNPRINTF(priv->reply, sizeof(priv->reply), "%s", line);
+        priv->replied = 1;
+#ifdef HAVE_PTHREAD
+        pthread_cond_broadcast(&priv->cond);
+#endif
+    }
+
+    TRXMANAGER_UNLOCK(priv);
+
+    if (freq_vfo >= 0)
+    {
+        rig_fire_freq_event(rig, freq_vfo ? RIG_VFO_B : RIG_VFO_A, freq);
+    }
+
+    if (mode_changed)
+    {
+        rig_fire_mode_event(rig, RIG_VFO_A, mode, RIG_PASSBAND_NOCHANGE);
+    }
+
+    if (ptt_changed)
+    {
+        rig_fire_ptt_event(rig, RIG_VFO_CURR, ptt);
+    }
+}
+
+/*
+ * trxmanager_hello
+ * Reads the greeting of a new connection and turns on the pushes
+ * Only called while nothing else reads the connection
+ */
+static int trxmanager_hello(RIG *rig)
+{
+    int retval;
+    char *cmd;
+    char *saveptr;
+    char response[MAXCMDLEN] = "";
+    struct rig_state *rs = &rig->state;
+    struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
+                                        rig->state.priv;
+
+    retval = read_transaction(rig, response, sizeof(response), 0);
+
+    if (retval != RIG_OK || strlen(response) == 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s no greeting\n", __func__);
+        return retval == RIG_OK ? -RIG_EPROTO : retval;
+    }
+
+    // Should have rig info now
+    strtok_r(response, ";\r\n", &saveptr);
+    strncpy(priv->info, &response[2], sizeof(priv->info) - 1);
+    rig_debug(RIG_DEBUG_VERBOSE, "%s connected to %s\n", __func__, priv->info);
+
+    // Turn on active messages
+    cmd = "AI1;";
+    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
+
+    if (retval < 0)
+    {
+        return -RIG_EIO;
+    }
+
+    retval = read_transaction(rig, response, sizeof(response), 0);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    TRXMANAGER_LOCK(priv);
+    priv->ai = strncmp("AI1;", response, 4) == 0;
+    memset(priv->freq_pushed, 0, sizeof(priv->freq_pushed));
+    priv->mode_pushed = priv->ptt_pushed = priv->split_pushed = 0;
+    TRXMANAGER_UNLOCK(priv);
+
+    if (!priv->ai)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: no active messages, AI response=%s\n",
+                  __func__, response);
+    }
+
+    return RIG_OK;
+}
+
+/*
+ * trxmanager_reconnect
+ * Opens the connection again unless the backoff since the last failed
+ * attempt has not run out, which returns -RIG_EIO at once
+ */
+static int trxmanager_reconnect(RIG *rig)
+{
+    struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
+                                        rig->state.priv;
+    hamlib_port_t *rp = &rig->state.rigport;
+    int retval;
+
+    if (priv->backoff > 0
+            && elapsed_ms(&priv->last_attempt, HAMLIB_ELAPSED_GET) < priv->backoff)
+    {
+        return -RIG_EIO;
+    }
+
+    elapsed_ms(&priv->last_attempt, HAMLIB_ELAPSED_SET);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: reopening %s\n", __func__, rp->pathname);
+
+    /* not network_close(), which would tear down Winsock */
+    if (rp->fd > 0)
+    {
+#ifdef __MINGW32__
+        closesocket(rp->fd);
+#else
+        close(rp->fd);
+#endif
+        rp->fd = 0;
+    }
+
+    port_rxbuf_discard(rp);
+
+    retval = network_open(rp, TRXMANAGER_PORT);
+
+    if (retval == RIG_OK)
+    {
+        retval = trxmanager_hello(rig);
+    }
+
+    TRXMANAGER_LOCK(priv);
+
+    if (retval == RIG_OK)
+    {
+        priv->connected = 1;
+        priv->backoff = 0;
+    }
+    else
+    {
+        priv->backoff = priv->backoff ? priv->backoff * 2 : TRXMANAGER_BACKOFF_MIN;
+
+        if (priv->backoff > TRXMANAGER_BACKOFF_MAX)
+        {
+            priv->backoff = TRXMANAGER_BACKOFF_MAX;
+        }
+
+        rig_debug(RIG_DEBUG_WARN, "%s: reconnect failed, next try in %d ms\n",
+                  __func__, priv->backoff);
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_cond_broadcast(&priv->cond);
+#endif
+    TRXMANAGER_UNLOCK(priv);
+
+    return retval == RIG_OK ? RIG_OK : -RIG_EIO;
+}
+
+static void trxmanager_link_down(RIG *rig)
+{
+    struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
+                                        rig->state.priv;
+
+    TRXMANAGER_LOCK(priv);
+
+    if (priv->connected)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: connection to TRX-Manager lost\n", __func__);
+        priv->connected = 0;
+        priv->backoff = 0;
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_cond_broadcast(&priv->cond);
+#endif
+    TRXMANAGER_UNLOCK(priv);
+}
+
+#ifdef HAVE_PTHREAD
+static void trxmanager_deadline(struct timespec *ts, int ms)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    ts->tv_sec = now.tv_sec + ms / 1000;
+    ts->tv_nsec = now.tv_usec * 1000L + (ms % 1000) * 1000000L;
+
+    if (ts->tv_nsec >= 1000000000L)
+    {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+static void *trxmanager_thread(void *arg)
+{
+    RIG *rig = arg;
+    struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
+                                        rig->state.priv;
+    char line[MAXCMDLEN * 2];
+
+    while (priv->running)
+    {
+        int retval;
+
+        if (!priv->connected)
+        {
+            if (trxmanager_reconnect(rig) != RIG_OK)
+            {
+                hl_usleep(100 * 1000);
+            }
+
+            continue;
+        }
+
+        retval = read_transaction(rig, line, sizeof(line), 1);
+
+        if (retval == RIG_OK)
+        {
+            trxmanager_process_line(rig, line);
+        }
+        else if (retval != -RIG_ETIMEOUT && priv->running)
+        {
+            trxmanager_link_down(rig);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * trxmanager_wait_connected
+ * Waits for the reader thread to reconnect if its next attempt is due
+ * within the rig timeout, lock held
+ */
+static int trxmanager_wait_connected(RIG *rig)
+{
+    struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
+                                        rig->state.priv;
+    struct timespec deadline;
+    int due;
+
+    if (priv->connected)
+    {
+        return RIG_OK;
+    }
+
+    due = priv->backoff - (int)elapsed_ms(&priv->last_attempt, HAMLIB_ELAPSED_GET);
+
+    if (due < 0) { due = 0; }
+
+    if (due + TRXMANAGER_CONNECT_TIME > rig->state.rigport.timeout)
+    {
+        return -RIG_EIO;
+    }
+
+    trxmanager_deadline(&deadline, due + TRXMANAGER_CONNECT_TIME);
+
+    while (!priv->connected)
+    {
+        if (pthread_cond_timedwait(&priv->cond, &priv->lock, &deadline) != 0)
+        {
+            return -RIG_EIO;
+        }
     }
 
     return RIG_OK;
 }
+#endif
+
+/*
+ * trxmanager_transaction
+ * Sends cmd and returns the line answering it in response
+ * Retried once over a new connection if the link drops
+ */
+static int trxmanager_transaction(RIG *rig, const char *cmd, char *response,
+                                  int response_len)
+{
+    struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
+                                        rig->state.priv;
+    struct rig_state *rs = &rig->state;
+    int retval = -RIG_EIO;
+    int attempt;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: cmd=%s\n", __func__, cmd);
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&priv->cmd_lock);
+#endif
+
+    for (attempt = 0; attempt < 2; attempt++)
+    {
+        TRXMANAGER_LOCK(priv);
+#ifdef HAVE_PTHREAD
+
+        if (priv->running)
+        {
+            retval = trxmanager_wait_connected(rig);
+        }
+        else
+#endif
+        {
+            retval = RIG_OK;
+        }
+
+        priv->wait_for[0] = cmd[0];
+        priv->wait_for[1] = cmd[1];
+        priv->wait_for[2] = '\0';
+        priv->replied = 0;
+        TRXMANAGER_UNLOCK(priv);
+
+        if (retval != RIG_OK)
+        {
+            break;
+        }
+
+        if (!priv->running && !priv->connected)
+        {
+            retval = trxmanager_reconnect(rig);
+
+            if (retval != RIG_OK)
+            {
+                break;
+            }
+        }
+
+        if (write_block(&rs->rigport, (const unsigned char *) cmd, strlen(cmd)) < 0)
+        {
+            retval = -RIG_EIO;
+
+            if (!priv->running)
+            {
+                trxmanager_link_down(rig);
+            }
+
+            continue;
+        }
+
+#ifdef HAVE_PTHREAD
+
+        if (priv->running)
+        {
+            struct timespec deadline;
+
+            trxmanager_deadline(&deadline, rs->rigport.timeout);
+            TRXMANAGER_LOCK(priv);
+
+            while (!priv->replied && priv->connected)
+            {
+                if (pthread_cond_timedwait(&priv->cond, &priv->lock, &deadline) != 0)
+                {
+                    break;
+                }
+            }
+
+            retval = priv->replied ? RIG_OK : priv->connected ? -RIG_ETIMEOUT : -RIG_EIO;
+            TRXMANAGER_UNLOCK(priv);
+        }
+        else
+#endif
+        {
+            char line[MAXCMDLEN * 2];
+
+            do
+            {
+                retval = read_transaction(rig, line, sizeof(line), 0);
+
+                if (retval == RIG_OK)
+                {
+                    trxmanager_process_line(rig, line);
+                }
+            }
+            while (retval == RIG_OK && !priv->replied);
+
+            if (retval == -RIG_EIO)
+            {
+                trxmanager_link_down(rig);
+            }
+        }
+
+        if (retval != -RIG_EIO)
+        {
+            break;
+        }
+    }
+
+    TRXMANAGER_LOCK(priv);
+
+    if (retval == RIG_OK)
+    {
+        SNPRINTF(response, response_len, "%s", priv->reply);
+    }
+    else
+    {
+        response[0] = '\0';
+    }
+
+    priv->wait_for[0] = '\0';
+    TRXMANAGER_UNLOCK(priv);
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&priv->cmd_lock);
+#endif
+
+    if (retval != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s failed: %s\n", __func__, cmd,
+                  rigerror(retval));
+    }
+
+    return retval;
+}
 
 /*
  * trxmanager_init
@@ -282,6 +891,12 @@ static int trxmanager_init(RIG *rig)
     priv->vfo_curr = RIG_VFO_A;
     priv->split = 0;
 
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init(&priv->lock, NULL);
+    pthread_mutex_init(&priv->cmd_lock, NULL);
+    pthread_cond_init(&priv->cond, NULL);
+#endif
+
     if (!rig->caps)
     {
         return -RIG_EINVAL;
@@ -300,8 +915,6 @@ static int trxmanager_init(RIG *rig)
 static int trxmanager_open(RIG *rig)
 {
     int retval;
-    char *cmd;
-    char *saveptr;
     char response[MAXCMDLEN] = "";
     struct rig_state *rs = &rig->state;
     struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
@@ -310,67 +923,41 @@ static int trxmanager_open(RIG *rig)
     rig_debug(RIG_DEBUG_VERBOSE, "%s version %s\n", __func__, BACKEND_VER);
 
     rs->rigport.timeout = 10000; // long timeout for antenna switching/tuning
-    retval = read_transaction(rig, response, sizeof(response));
-
-    if (retval != RIG_OK)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
-    }
-
-    if (strlen(response) == 0)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s response len==0\n", __func__);
-        return -RIG_EPROTO;
-    }
-
-    // Should have rig info now
-    strtok_r(response, ";\r\n", &saveptr);
-    strncpy(priv->info, &response[2], sizeof(priv->info));
-    rig_debug(RIG_DEBUG_VERBOSE, "%s connected to %s\n", __func__, priv->info);
-
-    // Turn off active messages
-    cmd = "AI0;";
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
-
-    if (retval < 0)
-    {
-        return retval;
-    }
 
-    retval = read_transaction(rig, response, sizeof(response));
+    retval = trxmanager_hello(rig);
 
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
-    }
-
-    if (strncmp("AI0;", response, 4) != 0)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s AI invalid response=%s\n", __func__, response);
-        return -RIG_EINVAL;
+        return retval;
     }
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s AI response=%s\n", __func__, response);
+    priv->connected = 1;
+    priv->backoff = 0;
 
-    cmd = "FN;";
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
+    retval = trxmanager_transaction(rig, "FN;", response, sizeof(response));
 
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s FN; write failed\n", __func__);
+        rig_debug(RIG_DEBUG_ERR, "%s FN; failed\n", __func__);
+        return retval;
     }
 
-    retval = read_transaction(rig, response, sizeof(response));
+    rig_debug(RIG_DEBUG_VERBOSE, "%s FN response=%s\n", __func__, response);
+    priv->vfo_curr = RIG_VFO_A;
+
+#ifdef HAVE_PTHREAD
+    priv->running = 1;
 
-    if (retval != RIG_OK)
+    if (pthread_create(&priv->thread, NULL, trxmanager_thread, rig))
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        priv->running = 0;
     }
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s FN response=%s\n", __func__, response);
-    priv->vfo_curr = RIG_VFO_A;
+#endif
 
-    return retval;
+    return RIG_OK;
 }
 
 /*
@@ -379,7 +966,30 @@ static int trxmanager_open(RIG *rig)
  */
 static int trxmanager_close(RIG *rig)
 {
+    struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
+                                        rig->state.priv;
+
     rig_debug(RIG_DEBUG_TRACE, "%s\n", __func__);
+
+#ifdef HAVE_PTHREAD
+
+    if (priv->running)
+    {
+        priv->running = 0;
+
+        /* wakes the reader thread out of its read */
+        if (priv->connected && rig->state.rigport.fd > 0)
+        {
+            shutdown(rig->state.rigport.fd, 2);
+        }
+
+        pthread_join(priv->thread, NULL);
+    }
+
+#endif
+
+    priv->connected = 0;
+
     return RIG_OK;
 }
 
@@ -389,13 +999,25 @@ static int trxmanager_close(RIG *rig)
  */
 static int trxmanager_cleanup(RIG *rig)
 {
+    struct trxmanager_priv_data *priv;
 
     if (!rig)
     {
         return -RIG_EINVAL;
     }
 
-    free(rig->state.priv);
+    priv = (struct trxmanager_priv_data *) rig->state.priv;
+
+    if (priv)
+    {
+#ifdef HAVE_PTHREAD
+        pthread_mutex_destroy(&priv->lock);
+        pthread_mutex_destroy(&priv->cmd_lock);
+        pthread_cond_destroy(&priv->cond);
+#endif
+        free(priv);
+    }
+
     rig->state.priv = NULL;
 
     return RIG_OK;
@@ -412,7 +1034,6 @@ static int trxmanager_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     char vfoab;
     char cmd[MAXCMDLEN];
     char response[MAXCMDLEN] = "";
-    struct rig_state *rs = &rig->state;
     struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
                                         rig->state.priv;
 
@@ -439,20 +1060,26 @@ static int trxmanager_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
                   __func__, rig_strvfo(vfo));
     }
 
-    vfoab = vfo == RIG_VFO_A ? 'R' : 'T';
-    SNPRINTF(cmd, sizeof(cmd), "X%c;", vfoab);
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
+    n = vfo == RIG_VFO_A ? 0 : 1;
 
-    if (retval < 0)
+    TRXMANAGER_LOCK(priv);
+
+    if (priv->freq_pushed[n] && priv->connected)
     {
-        return retval;
+        *freq = priv->freq[n];
+        TRXMANAGER_UNLOCK(priv);
+        return RIG_OK;
     }
 
-    retval = read_transaction(rig, response, sizeof(response));
+    TRXMANAGER_UNLOCK(priv);
+
+    vfoab = vfo == RIG_VFO_A ? 'R' : 'T';
+    SNPRINTF(cmd, sizeof(cmd), "X%c;", vfoab);
+    retval = trxmanager_transaction(rig, cmd, response, sizeof(response));
 
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
+        return retval;
     }
 
     *freq = 0;
@@ -482,7 +1109,6 @@ static int trxmanager_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
     char vfoab;
     char cmd[MAXCMDLEN];
     char response[MAXCMDLEN] = "";
-    struct rig_state *rs = &rig->state;
     struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
                                         rig->state.priv;
 
@@ -511,21 +1137,19 @@ static int trxmanager_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
 
     vfoab = vfo == RIG_VFO_A ? 'A' : 'B';
     SNPRINTF(cmd, sizeof(cmd), "F%c%011lu;", vfoab, (unsigned long)freq);
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
 
-    if (retval < 0)
-    {
-        return retval;
-    }
-
-    retval = read_transaction(rig, response,
-                              sizeof(response)); // get response but don't care
+    // get response but don't care
+    retval = trxmanager_transaction(rig, cmd, response, sizeof(response));
 
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
+        return retval;
     }
 
+    TRXMANAGER_LOCK(priv);
+    priv->freq[vfo == RIG_VFO_A ? 0 : 1] = freq;
+    TRXMANAGER_UNLOCK(priv);
+
     return RIG_OK;
 }
 
@@ -538,7 +1162,6 @@ static int trxmanager_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
     int retval;
     char cmd[MAXCMDLEN];
     char response[MAXCMDLEN] = "";
-    struct rig_state *rs = &rig->state;
 
     rig_debug(RIG_DEBUG_TRACE, "%s: ptt=%d\n", __func__, ptt);
 
@@ -550,21 +1173,14 @@ static int trxmanager_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
     }
 
     SNPRINTF(cmd, sizeof(cmd), "%s;", ptt == 1 ? "TX" : "RX");
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
-
-    if (retval < 0)
-    {
-        return retval;
-    }
-
-    retval = read_transaction(rig, response, sizeof(response));
+    retval = trxmanager_transaction(rig, cmd, response, sizeof(response));
 
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
+        return retval;
     }
 
-    if (strlen(response) != 5 || strstr(response, cmd) == NULL)
+    if (strstr(response, cmd) == NULL)
     {
         rig_debug(RIG_DEBUG_ERR, "%s invalid response='%s'\n", __func__, response);
         return -RIG_EPROTO;
@@ -581,29 +1197,32 @@ static int trxmanager_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
 {
     int retval;
     char cptt;
-    char cmd[MAXCMDLEN];
     char response[MAXCMDLEN] = "";
-    struct rig_state *rs = &rig->state;
+    struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
+                                        rig->state.priv;
 
     rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s\n", __func__,
               rig_strvfo(vfo));
 
-    SNPRINTF(cmd, sizeof(cmd), "IF;");
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
+    TRXMANAGER_LOCK(priv);
 
-    if (retval < 0)
+    if (priv->ptt_pushed && priv->connected)
     {
-        return retval;
+        *ptt = priv->ptt;
+        TRXMANAGER_UNLOCK(priv);
+        return RIG_OK;
     }
 
-    retval = read_transaction(rig, response, sizeof(response));
+    TRXMANAGER_UNLOCK(priv);
+
+    retval = trxmanager_transaction(rig, "IF;", response, sizeof(response));
 
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
+        return retval;
     }
 
-    if (strlen(response) != 40)
+    if (strlen(response) != 38)
     {
         rig_debug(RIG_DEBUG_ERR, "%s: invalid response='%s'\n", __func__, response);
         return -RIG_EPROTO;
@@ -642,7 +1261,6 @@ static int trxmanager_set_mode(RIG *rig, vfo_t vfo, rmode_t mode,
     char ttmode;
     char cmd[MAXCMDLEN];
     char response[MAXCMDLEN] = "";
-    struct rig_state *rs = &rig->state;
 
     rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s mode=%s width=%d\n",
               __func__, rig_strvfo(vfo), rig_strrmode(mode), (int)width);
@@ -659,11 +1277,11 @@ static int trxmanager_set_mode(RIG *rig, vfo_t vfo, rmode_t mode,
     switch (mode)
     {
     case RIG_MODE_LSB:
-        ttmode = RIG_MODE_LSB;
+        ttmode = FLRIG_MODE_LSB;
         break;
 
     case RIG_MODE_USB:
-        ttmode = RIG_MODE_USB;
+        ttmode = FLRIG_MODE_USB;
         break;
 
     case RIG_MODE_CW:
@@ -714,19 +1332,13 @@ static int trxmanager_set_mode(RIG *rig, vfo_t vfo, rmode_t mode,
     }
 
     SNPRINTF(cmd, sizeof(cmd), "MD%c;", ttmode);
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
-
-    if (retval < 0)
-    {
-        return retval;
-    }
 
     // Get the response
-    retval = read_transaction(rig, response, sizeof(response));
+    retval = trxmanager_transaction(rig, cmd, response, sizeof(response));
 
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
+        return retval;
     }
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s: response=%s\n", __func__, response);
@@ -739,6 +1351,7 @@ static int trxmanager_set_mode(RIG *rig, vfo_t vfo, rmode_t mode,
 /*
  * trxmanager_get_mode
  * Assumes rig!=NULL, rig->state.priv!=NULL, mode!=NULL
+ * The bandwidth is never pushed, so it is always asked for
  */
 static int trxmanager_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
                                pbwidth_t *width)
@@ -747,9 +1360,7 @@ static int trxmanager_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
     int n;
     long iwidth = 0;
     char tmode;
-    char cmd[MAXCMDLEN];
     char response[MAXCMDLEN] = "";
-    struct rig_state *rs = &rig->state;
     struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
                                         rig->state.priv;
 
@@ -776,92 +1387,49 @@ static int trxmanager_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
     rig_debug(RIG_DEBUG_TRACE, "%s: using vfo=%s\n", __func__,
               rig_strvfo(vfo));
 
-    SNPRINTF(cmd, sizeof(cmd), "MD;");
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
+    TRXMANAGER_LOCK(priv);
 
-    if (retval < 0)
+    if (priv->mode_pushed && priv->connected)
     {
-        return retval;
+        *mode = priv->mode;
+        TRXMANAGER_UNLOCK(priv);
     }
-
-    retval = read_transaction(rig, response, sizeof(response));
-
-    if (retval != RIG_OK)
+    else
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
-    }
+        TRXMANAGER_UNLOCK(priv);
 
-    n = sscanf(response, "MD%c;", &tmode);
+        retval = trxmanager_transaction(rig, "MD;", response, sizeof(response));
 
-    if (n != 1 || strlen(response) != 6)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s: invalid response='%s'\n", __func__, response);
-        return -RIG_EPROTO;
-    }
-
-    switch (tmode)
-    {
-    case FLRIG_MODE_LSB:
-        *mode = RIG_MODE_LSB;
-        break;
-
-    case FLRIG_MODE_USB:
-        *mode = RIG_MODE_USB;
-        break;
-
-    case FLRIG_MODE_CW:
-        *mode = RIG_MODE_CW;
-        break;
-
-    case FLRIG_MODE_FM:
-        *mode = RIG_MODE_FM;
-        break;
-
-    case FLRIG_MODE_AM:
-        *mode = RIG_MODE_AM;
-        break;
-
-    case FLRIG_MODE_RTTY:
-        *mode = RIG_MODE_RTTY;
-        break;
+        if (retval != RIG_OK)
+        {
+            return retval;
+        }
 
-    case FLRIG_MODE_CWR:
-        *mode = RIG_MODE_CWR;
-        break;
+        n = sscanf(response, "MD%c;", &tmode);
 
-    case FLRIG_MODE_RTTYR:
-        *mode = RIG_MODE_RTTYR;
-        break;
+        if (n != 1 || strlen(response) != 4)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: invalid response='%s'\n", __func__, response);
+            return -RIG_EPROTO;
+        }
 
-    case FLRIG_MODE_PKTLSB:
-        *mode = RIG_MODE_PKTLSB;
-        break;
+        *mode = trxmanager_mode(tmode);
 
-    case FLRIG_MODE_PKTUSB:
-        *mode = RIG_MODE_PKTUSB;
-        break;
-
-    default:
-        rig_debug(RIG_DEBUG_ERR, "%s: unknown mode='%c'\n", __func__, tmode);
-        return -RIG_ENIMPL;
+        if (*mode == RIG_MODE_NONE)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: unknown mode='%c'\n", __func__, tmode);
+            return -RIG_ENIMPL;
+        }
     }
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s: mode='%s'\n", __func__, rig_strrmode(*mode));
 
     // now get the bandwidth
-    SNPRINTF(cmd, sizeof(cmd), "BW;");
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
-
-    if (retval < 0)
-    {
-        return retval;
-    }
-
-    retval = read_transaction(rig, response, sizeof(response));
+    retval = trxmanager_transaction(rig, "BW;", response, sizeof(response));
 
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
+        return retval;
     }
 
     if (strncmp(response, "BW", 2) != 0)
@@ -874,14 +1442,13 @@ static int trxmanager_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
 
     if (n != 1)
     {
-        char *saveptr;
         rig_debug(RIG_DEBUG_ERR, "%s bandwidth scan failed '%s'\n", __func__,
-                  strtok_r(response, "\r\n", &saveptr));
+                  response);
         return -RIG_EPROTO;
     }
 
     *width = iwidth;
-    printf("Bandwidth=%ld\n", *width);
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: bandwidth=%ld\n", __func__, *width);
     return RIG_OK;
 }
 
@@ -917,21 +1484,15 @@ static int trxmanager_set_vfo(RIG *rig, vfo_t vfo)
     }
 
     SNPRINTF(cmd, sizeof(cmd), "FN%d;", vfo == RIG_VFO_A ? 0 : 1);
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
+    retval = trxmanager_transaction(rig, cmd, response, sizeof(response));
 
-    if (retval < 0)
+    if (retval != RIG_OK)
     {
         return retval;
     }
 
     priv->vfo_curr = vfo;
     rs->tx_vfo = RIG_VFO_B; // always VFOB
-    retval = read_transaction(rig, response, sizeof(response));
-
-    if (retval != RIG_OK)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
-    }
 
     return RIG_OK;
 }
@@ -986,10 +1547,8 @@ static int trxmanager_get_vfo(RIG *rig, vfo_t *vfo)
  */
 static int trxmanager_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
 {
-    int retval;
     char cmd[MAXCMDLEN];
     char response[MAXCMDLEN] = "";
-    struct rig_state *rs = &rig->state;
 
     rig_debug(RIG_DEBUG_TRACE, "%s: vfo=%s freq=%.1f\n", __func__,
               rig_strvfo(vfo), tx_freq);
@@ -1002,22 +1561,9 @@ static int trxmanager_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
     }
 
     SNPRINTF(cmd, sizeof(cmd), "XT%011lu;", (unsigned long) tx_freq);
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
-
-    if (retval < 0)
-    {
-        return retval;
-    }
-
-    retval = read_transaction(rig, response,
-                              sizeof(response)); // get response but don't care
-
-    if (retval != RIG_OK)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
-    }
 
-    return RIG_OK;
+    // get response but don't care
+    return trxmanager_transaction(rig, cmd, response, sizeof(response));
 }
 
 /*
@@ -1045,7 +1591,6 @@ static int trxmanager_set_split_vfo(RIG *rig, vfo_t vfo, split_t split,
     char response[MAXCMDLEN] = "";
     split_t tsplit;
     vfo_t ttx_vfo;
-    struct rig_state *rs = &rig->state;
 
     rig_debug(RIG_DEBUG_TRACE, "%s: tx_vfo=%s\n", __func__,
               rig_strvfo(tx_vfo));
@@ -1070,22 +1615,15 @@ static int trxmanager_set_split_vfo(RIG *rig, vfo_t vfo, split_t split,
     if (tsplit == split) { return RIG_OK; } // don't need to change it
 
     SNPRINTF(cmd, sizeof(cmd), "SP%c;", split ? '1' : '0');
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
-
-    if (retval < 0)
-    {
-        return retval;
-    }
 
-    retval = read_transaction(rig, response,
-                              sizeof(response)); // get response but don't care
+    retval = trxmanager_transaction(rig, cmd, response, sizeof(response));
 
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
+        return retval;
     }
 
-    if (strlen(response) != 6 || strstr(response, cmd) == NULL)
+    if (strlen(response) != 4 || strstr(response, cmd) == NULL)
     {
         rig_debug(RIG_DEBUG_ERR, "%s invalid response='%s'\n", __func__, response);
         return -RIG_EPROTO;
@@ -1104,30 +1642,32 @@ static int trxmanager_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split,
     int retval;
     int tsplit = 0;
     int n;
-    char cmd[MAXCMDLEN];
     char response[MAXCMDLEN] = "";
-    struct rig_state *rs = &rig->state;
     struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
                                         rig->state.priv;
 
     rig_debug(RIG_DEBUG_TRACE, "%s\n", __func__);
-    SNPRINTF(cmd, sizeof(cmd), "SP;");
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
 
-    if (retval < 0)
+    *tx_vfo = RIG_VFO_B;
+
+    TRXMANAGER_LOCK(priv);
+
+    if (priv->split_pushed && priv->connected)
     {
-        return retval;
+        *split = priv->split;
+        TRXMANAGER_UNLOCK(priv);
+        return RIG_OK;
     }
 
-    retval = read_transaction(rig, response,
-                              sizeof(response)); // get response but don't care
+    TRXMANAGER_UNLOCK(priv);
+
+    retval = trxmanager_transaction(rig, "SP;", response, sizeof(response));
 
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
+        return retval;
     }
 
-    *tx_vfo = RIG_VFO_B;
     n = sscanf(response, "SP%d", &tsplit);
 
     if (n == 0)
@@ -1151,7 +1691,6 @@ static int trxmanager_set_split_freq_mode(RIG *rig, vfo_t vfo, freq_t freq,
     int retval;
     char cmd[MAXCMDLEN];
     char response[MAXCMDLEN] = "";
-    struct rig_state *rs = &rig->state;
     struct trxmanager_priv_data *priv = (struct trxmanager_priv_data *)
                                         rig->state.priv;
 
@@ -1165,27 +1704,16 @@ static int trxmanager_set_split_freq_mode(RIG *rig, vfo_t vfo, freq_t freq,
     // assume split is on B
     //
     SNPRINTF(cmd, sizeof(cmd), "XT%011lu;", (unsigned long)freq);
-    retval = write_block(&rs->rigport, (unsigned char *) cmd, strlen(cmd));
-
-    if (retval < 0)
-    {
-        return retval;
-    }
-
-    retval = read_transaction(rig, response, sizeof(response));
+    retval = trxmanager_transaction(rig, cmd, response, sizeof(response));
 
     if (retval != RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s read_transaction failed\n", __func__);
+        return retval;
     }
 
-    if (strlen(response) != 16 || strstr(response, cmd) == NULL)
+    if (strlen(response) != 14 || strstr(response, cmd) == NULL)
     {
-        FILE *fp;
         rig_debug(RIG_DEBUG_ERR, "%s invalid response='%s'\n", __func__, response);
-        fp = fopen("debug.txt", "w+");
-        fprintf(fp, "XT response=%s\n", response);
-        fclose(fp);
         return -RIG_EPROTO;
     }
 
@@ -1227,4 +1755,3 @@ static const char *trxmanager_get_info(RIG *rig)
 
     return priv->info;
 }
-
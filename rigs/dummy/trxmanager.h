@@ -30,7 +30,7 @@
 #include <sys/time.h>
 #endif
 
-#define BACKEND_VER "20210613"
+#define BACKEND_VER "20261014"
 
 #define EOM "\r"
 #define TRUE 1
@@ -28,5 +28,6 @@ extern const struct rig_caps sdr1k_rig_caps;
 extern const struct rig_caps sdr1krfe_rig_caps;
 extern const struct rig_caps dttsp_rig_caps;
 extern const struct rig_caps dttsp_udp_rig_caps;
+extern const struct rig_caps smartsdr_rig_caps;
 
 #endif /* _FLEXRADIO_H */
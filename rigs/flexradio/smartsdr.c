@@ -0,0 +1,1954 @@
+/*
+ *  Hamlib FlexRadio backend - SmartSDR native API
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The FLEX-6000/8000 API on TCP port 4992 is line based:
+ *
+ *   V<version>                       sent by the radio on connect
+ *   H<handle>                        our client handle, hex
+ *   C<seq>|<command>                 a command
+ *   R<seq>|<hex code>|<message>      its reply, code 0 on success
+ *   S<handle>|<object> key=val ...   status, pushed for subscribed objects
+ *   M<code>|<text>                   a message
+ *
+ * This backend subscribes to slice, transmit and meter status and keeps
+ * its state, and through the freq/mode/ptt events the rig cache, current
+ * from the pushes, so the getters do not talk to the radio at all.
+ * Meter values and panadapter FFT data come as VITA-49 packets on a UDP
+ * port of ours, given to the radio with "client udpport".  With
+ * flex_spectrum=1 the backend registers as a GUI client, creates its own
+ * panadapter on VFO A and turns its FFT frames into spectrum lines.
+ *
+ * VFO A and B are slices 0 and 1; split is "slice 1 is the TX slice".
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+#ifdef HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+#ifdef HAVE_ARPA_INET_H
+#include <arpa/inet.h>
+#endif
+#if defined (HAVE_SYS_SOCKET_H)
+#include <sys/socket.h>
+#elif HAVE_WS2TCPIP_H
+#include <ws2tcpip.h>
+#endif
+
+#include "hamlib/rig.h"
+#include "iofunc.h"
+#include "misc.h"
+#include "token.h"
+#include "event.h"
+#include "spectrum_pool.h"
+#include "flexradio.h"
+
+#define SMARTSDR_DEFAULT_PATH "127.0.0.1:4992"
+#define SMARTSDR_LINE_LEN 1024
+#define SMARTSDR_SLICES 8
+#define SMARTSDR_VITA_MAX 16384
+#define SMARTSDR_UDP_POLL 200 /* ms the UDP thread waits for a packet */
+
+/* VITA-49 packet class codes used by the radio */
+#define SMARTSDR_OUI 0x001c2d
+#define SMARTSDR_CLASS_METER 0x8002
+#define SMARTSDR_CLASS_FFT 0x8003
+
+#define SMARTSDR_PAN_X 1024
+#define SMARTSDR_PAN_Y 256
+#define SMARTSDR_SSB_LOW 100 /* Hz, near edge of a sideband filter */
+
+#define TOK_SMARTSDR_UDP_PORT TOKEN_BACKEND(1)
+#define TOK_SMARTSDR_SPECTRUM TOKEN_BACKEND(2)
+
+#define SMARTSDR_VFOS (RIG_VFO_A|RIG_VFO_B)
+
+#define SMARTSDR_MODES (RIG_MODE_AM | RIG_MODE_SAM | RIG_MODE_LSB |\
+                        RIG_MODE_USB | RIG_MODE_CW | RIG_MODE_FM |\
+                        RIG_MODE_FMN | RIG_MODE_PKTLSB | RIG_MODE_PKTUSB |\
+                        RIG_MODE_RTTY)
+
+#define SMARTSDR_LEVELS (RIG_LEVEL_AF | RIG_LEVEL_RFPOWER | RIG_LEVEL_STRENGTH |\
+                         RIG_LEVEL_RFPOWER_METER_WATTS | RIG_LEVEL_SWR)
+#define SMARTSDR_SET_LEVELS (RIG_LEVEL_AF | RIG_LEVEL_RFPOWER)
+
+struct smartsdr_slice
+{
+    int in_use;
+    freq_t freq;
+    rmode_t mode;
+    int filter_lo;
+    int filter_hi;
+    int tx;
+    int rit_on;
+    int rit;
+    int xit_on;
+    int xit;
+    int audio_level;
+};
+
+struct smartsdr_priv_data
+{
+    char info[64];
+    unsigned long handle;
+    struct smartsdr_slice slice[SMARTSDR_SLICES];
+    ptt_t ptt;
+    int rfpower;
+    /* meter ids from the meter status, -1 until known */
+    int level_meter;            /* S-meter of slice 0, dBm */
+    int fwd_meter;              /* forward power, dBm */
+    int swr_meter;
+    float level_dbm;
+    float fwd_dbm;
+    float swr;
+    /* our panadapter */
+    unsigned long pan;
+    int pan_creating;           /* its status comes before the create reply */
+    freq_t pan_center;
+    freq_t pan_bandwidth;
+    float pan_min_dbm;
+    float pan_max_dbm;
+    int pan_y;
+    unsigned long frame_index;
+    int bins_filled;
+    unsigned short bins[HAMLIB_MAX_SPECTRUM_DATA];
+    unsigned char data[HAMLIB_MAX_SPECTRUM_DATA]; /* used if the pool is empty */
+    /* command in flight */
+    unsigned int seq;
+    unsigned int wait_seq;
+    int replied;
+    unsigned long reply_code;
+    char reply[128];
+    /* conf */
+    int udp_port;
+    int spectrum;
+    int udp_fd;
+    int running;
+#ifdef HAVE_PTHREAD
+    pthread_t tcp_thread;
+    pthread_t udp_thread;
+    pthread_mutex_t state_lock;
+    pthread_mutex_t cmd_lock;
+    pthread_cond_t reply_cond;
+#endif
+    unsigned char packet[SMARTSDR_VITA_MAX];
+};
+
+#ifdef HAVE_PTHREAD
+#define SMARTSDR_LOCK(priv) pthread_mutex_lock(&(priv)->state_lock)
+#define SMARTSDR_UNLOCK(priv) pthread_mutex_unlock(&(priv)->state_lock)
+#else
+#define SMARTSDR_LOCK(priv)
+#define SMARTSDR_UNLOCK(priv)
+#endif
+
+static const struct confparams smartsdr_cfg_params[] =
+{
+    {
+        TOK_SMARTSDR_UDP_PORT, "flex_udp_port", "UDP port",
+        "Local UDP port the radio sends meter and panadapter data to, 0 for none",
+        "4993", RIG_CONF_NUMERIC, { .n = { 0, 65535, 1 } }
+    },
+    {
+        TOK_SMARTSDR_SPECTRUM, "flex_spectrum", "Panadapter",
+        "Create a panadapter on VFO A and deliver it as spectrum lines",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    { RIG_CONF_END, NULL, }
+};
+
+static const struct
+{
+    const char *name;
+    rmode_t mode;
+} smartsdr_mode_map[] =
+{
+    { "USB", RIG_MODE_USB },
+    { "LSB", RIG_MODE_LSB },
+    { "CW", RIG_MODE_CW },
+    { "AM", RIG_MODE_AM },
+    { "SAM", RIG_MODE_SAM },
+    { "FM", RIG_MODE_FM },
+    { "NFM", RIG_MODE_FMN },
+    { "DIGU", RIG_MODE_PKTUSB },
+    { "DIGL", RIG_MODE_PKTLSB },
+    { "RTTY", RIG_MODE_RTTY },
+    { NULL, RIG_MODE_NONE }
+};
+
+static rmode_t smartsdr_mode(const char *name)
+{
+    int i;
+
+    for (i = 0; smartsdr_mode_map[i].name; i++)
+    {
+        if (strcmp(smartsdr_mode_map[i].name, name) == 0)
+        {
+            return smartsdr_mode_map[i].mode;
+        }
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: no mapping for mode %s\n", __func__, name);
+    return RIG_MODE_NONE;
+}
+
+static const char *smartsdr_mode_name(rmode_t mode)
+{
+    int i;
+
+    for (i = 0; smartsdr_mode_map[i].name; i++)
+    {
+        if (smartsdr_mode_map[i].mode == mode)
+        {
+            return smartsdr_mode_map[i].name;
+        }
+    }
+
+    return NULL;
+}
+
+static int smartsdr_vfo_slice(RIG *rig, vfo_t vfo)
+{
+    if (vfo == RIG_VFO_CURR)
+    {
+        vfo = rig->state.current_vfo;
+    }
+
+    switch (vfo)
+    {
+    case RIG_VFO_A:
+    case RIG_VFO_MAIN:
+        return 0;
+
+    case RIG_VFO_B:
+    case RIG_VFO_SUB:
+        return 1;
+
+    case RIG_VFO_TX:
+        return rig->state.tx_vfo == RIG_VFO_B;
+
+    default:
+        rig_debug(RIG_DEBUG_ERR, "%s: unsupported VFO %s\n", __func__,
+                  rig_strvfo(vfo));
+        return -1;
+    }
+}
+
+static void smartsdr_close_udp(struct smartsdr_priv_data *priv)
+{
+    if (priv->udp_fd >= 0)
+    {
+#ifdef __MINGW32__
+        closesocket(priv->udp_fd);
+#else
+        close(priv->udp_fd);
+#endif
+        priv->udp_fd = -1;
+    }
+}
+
+/*
+ * Status of one slice: "slice <n> RF_frequency=14.074000 mode=USB
+ * filter_lo=100 filter_hi=2800 tx=1 ..."
+ */
+static void smartsdr_slice_status(RIG *rig, char **words, int nwords)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    struct smartsdr_slice *s;
+    int n, i;
+    int freq_changed = 0;
+    int mode_changed = 0;
+    freq_t freq;
+    rmode_t mode;
+    pbwidth_t width;
+
+    if (nwords < 2)
+    {
+        return;
+    }
+
+    n = atoi(words[1]);
+
+    if (n < 0 || n >= SMARTSDR_SLICES)
+    {
+        return;
+    }
+
+    SMARTSDR_LOCK(priv);
+    s = &priv->slice[n];
+
+    for (i = 2; i < nwords; i++)
+    {
+        char *val = strchr(words[i], '=');
+
+        if (!val)
+        {
+            continue;
+        }
+
+        *val++ = '\0';
+
+        if (strcmp(words[i], "RF_frequency") == 0)
+        {
+            freq_t f = atof(val) * 1e6;
+
+            f = floor(f + 0.5);
+            freq_changed = f != s->freq;
+            s->freq = f;
+        }
+        else if (strcmp(words[i], "mode") == 0)
+        {
+            rmode_t m = smartsdr_mode(val);
+
+            mode_changed |= m != s->mode;
+            s->mode = m;
+        }
+        else if (strcmp(words[i], "filter_lo") == 0)
+        {
+            int lo = atoi(val);
+
+            mode_changed |= lo != s->filter_lo;
+            s->filter_lo = lo;
+        }
+        else if (strcmp(words[i], "filter_hi") == 0)
+        {
+            int hi = atoi(val);
+
+            mode_changed |= hi != s->filter_hi;
+            s->filter_hi = hi;
+        }
+        else if (strcmp(words[i], "in_use") == 0)
+        {
+            s->in_use = atoi(val);
+        }
+        else if (strcmp(words[i], "tx") == 0)
+        {
+            s->tx = atoi(val);
+        }
+        else if (strcmp(words[i], "rit_on") == 0)
+        {
+            s->rit_on = atoi(val);
+        }
+        else if (strcmp(words[i], "rit_freq") == 0)
+        {
+            s->rit = atoi(val);
+        }
+        else if (strcmp(words[i], "xit_on") == 0)
+        {
+            s->xit_on = atoi(val);
+        }
+        else if (strcmp(words[i], "xit_freq") == 0)
+        {
+            s->xit = atoi(val);
+        }
+        else if (strcmp(words[i], "audio_level") == 0)
+        {
+            s->audio_level = atoi(val);
+        }
+    }
+
+    freq = s->freq;
+    mode = s->mode;
+    width = s->filter_hi - s->filter_lo;
+
+    if (n < 2 && priv->slice[1].tx == 1)
+    {
+        rig->state.tx_vfo = RIG_VFO_B;
+    }
+    else if (n < 2 && priv->slice[0].tx == 1)
+    {
+        rig->state.tx_vfo = RIG_VFO_A;
+    }
+
+    SMARTSDR_UNLOCK(priv);
+
+    if (n < 2 && freq_changed)
+    {
+        rig_fire_freq_event(rig, n ? RIG_VFO_B : RIG_VFO_A, freq);
+    }
+
+    if (n < 2 && mode_changed)
+    {
+        rig_fire_mode_event(rig, n ? RIG_VFO_B : RIG_VFO_A, mode, width);
+    }
+}
+
+struct smartsdr_meter
+{
+    int id;
+    int num;
+    char src[16];
+    char nam[16];
+};
+
+static void smartsdr_meter_found(struct smartsdr_priv_data *priv,
+                                 const struct smartsdr_meter *m)
+{
+    if (m->id < 0)
+    {
+        return;
+    }
+
+    SMARTSDR_LOCK(priv);
+
+    if (strcmp(m->src, "SLC") == 0 && m->num == 0 && strcmp(m->nam, "LEVEL") == 0)
+    {
+        priv->level_meter = m->id;
+    }
+    else if (strncmp(m->src, "TX", 2) == 0 && strcmp(m->nam, "FWDPWR") == 0)
+    {
+        priv->fwd_meter = m->id;
+    }
+    else if (strncmp(m->src, "TX", 2) == 0 && strcmp(m->nam, "SWR") == 0)
+    {
+        priv->swr_meter = m->id;
+    }
+
+    SMARTSDR_UNLOCK(priv);
+}
+
+/*
+ * Meter definitions: "meter 8.src=SLC#8.num=0#8.nam=LEVEL#8.unit=dBm#..."
+ * Only the ids of the meters the levels use are kept.
+ */
+static void smartsdr_meter_status(RIG *rig, char *list)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    struct smartsdr_meter m = { -1 };
+    char *field = list;
+
+    while (field)
+    {
+        char *next = strchr(field, '#');
+        char *key, *val;
+        int id;
+
+        if (next)
+        {
+            *next++ = '\0';
+        }
+
+        id = (int)strtol(field, &key, 10);
+        val = strchr(key, '=');
+
+        if (key != field && *key == '.' && val)
+        {
+            *val++ = '\0';
+
+            if (id != m.id)
+            {
+                smartsdr_meter_found(priv, &m);
+                memset(&m, 0, sizeof(m));
+                m.id = id;
+                m.num = -1;
+            }
+
+            if (strcmp(key + 1, "src") == 0) { SNPRINTF(m.src, sizeof(m.src), "%s", val); }
+            else if (strcmp(key + 1, "nam") == 0) { SNPRINTF(m.nam, sizeof(m.nam), "%s", val); }
+            else if (strcmp(key + 1, "num") == 0) { m.num = atoi(val); }
+        }
+
+        field = next;
+    }
+
+    smartsdr_meter_found(priv, &m);
+}
+
+static void smartsdr_status(RIG *rig, char *status)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    char *words[64];
+    int nwords = 0;
+    char *p = status;
+    int i;
+
+    if (strncmp(status, "meter ", 6) == 0)
+    {
+        if (strstr(status, " removed") == NULL)
+        {
+            smartsdr_meter_status(rig, status + 6);
+        }
+
+        return;
+    }
+
+    while (*p && nwords < (int)(sizeof(words) / sizeof(words[0])))
+    {
+        while (*p == ' ') { p++; }
+
+        if (!*p) { break; }
+
+        words[nwords++] = p;
+
+        while (*p && *p != ' ') { p++; }
+
+        if (*p) { *p++ = '\0'; }
+    }
+
+    if (nwords == 0)
+    {
+        return;
+    }
+
+    if (strcmp(words[0], "slice") == 0)
+    {
+        smartsdr_slice_status(rig, words, nwords);
+    }
+    else if (strcmp(words[0], "interlock") == 0)
+    {
+        ptt_t ptt = RIG_PTT_OFF;
+        int found = 0;
+
+        for (i = 1; i < nwords; i++)
+        {
+            if (strncmp(words[i], "state=", 6) == 0)
+            {
+                found = 1;
+                ptt = strcmp(words[i] + 6, "TRANSMITTING") == 0
+                      || strcmp(words[i] + 6, "PTT_REQUESTED") == 0 ? RIG_PTT_ON : RIG_PTT_OFF;
+            }
+        }
+
+        if (found)
+        {
+            int changed;
+
+            SMARTSDR_LOCK(priv);
+            changed = ptt != priv->ptt;
+            priv->ptt = ptt;
+            SMARTSDR_UNLOCK(priv);
+
+            if (changed)
+            {
+                rig_fire_ptt_event(rig, RIG_VFO_CURR, ptt);
+            }
+        }
+    }
+    else if (strcmp(words[0], "transmit") == 0)
+    {
+        for (i = 1; i < nwords; i++)
+        {
+            if (strncmp(words[i], "rfpower=", 8) == 0)
+            {
+                SMARTSDR_LOCK(priv);
+                priv->rfpower = atoi(words[i] + 8);
+                SMARTSDR_UNLOCK(priv);
+            }
+        }
+    }
+    else if (strcmp(words[0], "display") == 0 && nwords > 2
+             && strcmp(words[1], "pan") == 0
+             && (priv->pan ? strtoul(words[2], NULL, 16) == priv->pan
+                 : priv->pan_creating))
+    {
+        SMARTSDR_LOCK(priv);
+
+        for (i = 3; i < nwords; i++)
+        {
+            char *val = strchr(words[i], '=');
+
+            if (!val) { continue; }
+
+            *val++ = '\0';
+
+            if (strcmp(words[i], "center") == 0) { priv->pan_center = atof(val) * 1e6; }
+            else if (strcmp(words[i], "bandwidth") == 0) { priv->pan_bandwidth = atof(val) * 1e6; }
+            else if (strcmp(words[i], "min_dbm") == 0) { priv->pan_min_dbm = atof(val); }
+            else if (strcmp(words[i], "max_dbm") == 0) { priv->pan_max_dbm = atof(val); }
+            else if (strcmp(words[i], "y_pixels") == 0) { priv->pan_y = atoi(val); }
+        }
+
+        SMARTSDR_UNLOCK(priv);
+    }
+}
+
+static void smartsdr_process_line(RIG *rig, char *line)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    char *p;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: '%s'\n", __func__, line);
+
+    switch (line[0])
+    {
+    case 'V':
+        SNPRINTF(priv->info, sizeof(priv->info), "SmartSDR API %s", line + 1);
+        break;
+
+    case 'H':
+        priv->handle = strtoul(line + 1, NULL, 16);
+        break;
+
+    case 'R':
+    {
+        unsigned int seq = strtoul(line + 1, &p, 10);
+        unsigned long code = 0;
+
+        if (*p == '|')
+        {
+            code = strtoul(p + 1, &p, 16);
+        }
+
+        SMARTSDR_LOCK(priv);
+
+        if (seq == priv->wait_seq && !priv->replied)
+        {
+            priv->reply_code = code;
+            SNPRINTF(priv->reply, sizeof(priv->reply), "%s", *p == '|' ? p + 1 : "");
+            priv->replied = 1;
+#ifdef HAVE_PTHREAD
+            pthread_cond_broadcast(&priv->reply_cond);
+#endif
+        }
+
+        SMARTSDR_UNLOCK(priv);
+        break;
+    }
+
+    case 'S':
+        p = strchr(line, '|');
+
+        if (p)
+        {
+            smartsdr_status(rig, p + 1);
+        }
+
+        break;
+
+    case 'M':
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: radio message %s\n", __func__, line + 1);
+        break;
+    }
+}
+
+/* idle is set where a quiet radio is no error, so no timeout is logged */
+static int smartsdr_read_line(RIG *rig, char *line, size_t len, int idle)
+{
+    int retval = read_string(&rig->state.rigport, (unsigned char *) line, len,
+                             "\n", 1, idle, 1);
+
+    if (retval < 0)
+    {
+        return retval;
+    }
+
+    while (retval > 0 && (line[retval - 1] == '\n' || line[retval - 1] == '\r'))
+    {
+        line[--retval] = '\0';
+    }
+
+    return retval;
+}
+
+/*
+ * smartsdr_command
+ * Sends a command and waits for its reply, whose message is copied to
+ * reply if not NULL.  Status arriving meanwhile is processed as always.
+ */
+static int smartsdr_command(RIG *rig, const char *cmd, char *reply,
+                            size_t reply_len)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    char buf[SMARTSDR_LINE_LEN];
+    unsigned long code;
+    int retval = RIG_OK;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s\n", __func__, cmd);
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&priv->cmd_lock);
+#endif
+
+    SMARTSDR_LOCK(priv);
+    priv->wait_seq = ++priv->seq;
+    priv->replied = 0;
+    SNPRINTF(buf, sizeof(buf), "C%u|%s\n", priv->seq, cmd);
+    SMARTSDR_UNLOCK(priv);
+
+    if (write_block(&rig->state.rigport, (unsigned char *) buf, strlen(buf)) < 0)
+    {
+        retval = -RIG_EIO;
+    }
+#ifdef HAVE_PTHREAD
+    else if (priv->running)
+    {
+        struct timespec deadline;
+        struct timeval now;
+
+        gettimeofday(&now, NULL);
+        deadline.tv_sec = now.tv_sec + rig->state.rigport.timeout / 1000;
+        deadline.tv_nsec = now.tv_usec * 1000L
+                           + (rig->state.rigport.timeout % 1000) * 1000000L;
+
+        if (deadline.tv_nsec >= 1000000000L)
+        {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        SMARTSDR_LOCK(priv);
+
+        while (!priv->replied && retval == RIG_OK)
+        {
+            if (pthread_cond_timedwait(&priv->reply_cond, &priv->state_lock,
+                                       &deadline) != 0)
+            {
+                retval = -RIG_ETIMEOUT;
+            }
+        }
+
+        SMARTSDR_UNLOCK(priv);
+    }
+#endif
+    else
+    {
+        while (!priv->replied)
+        {
+            retval = smartsdr_read_line(rig, buf, sizeof(buf), 0);
+
+            if (retval < 0)
+            {
+                break;
+            }
+
+            smartsdr_process_line(rig, buf);
+            retval = RIG_OK;
+        }
+    }
+
+    SMARTSDR_LOCK(priv);
+    code = priv->reply_code;
+
+    if (retval == RIG_OK && reply)
+    {
+        SNPRINTF(reply, reply_len, "%s", priv->reply);
+    }
+
+    priv->wait_seq = 0;
+    SMARTSDR_UNLOCK(priv);
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&priv->cmd_lock);
+#endif
+
+    if (retval != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: no reply to '%s': %s\n", __func__, cmd,
+                  rigerror(retval));
+        return retval;
+    }
+
+    if (code != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: '%s' failed with 0x%08lx\n", __func__, cmd,
+                  code);
+        return -RIG_ERJCTED;
+    }
+
+    return RIG_OK;
+}
+
+static unsigned long smartsdr_get_be32(const unsigned char *p)
+{
+    return ((unsigned long)p[0] << 24) | ((unsigned long)p[1] << 16)
+           | ((unsigned long)p[2] << 8) | (unsigned long)p[3];
+}
+
+/*
+ * smartsdr_vita_parse
+ * Locates the payload of a VITA-49 packet and its stream id and packet
+ * class code; returns -RIG_EPROTO for anything not from a FlexRadio.
+ */
+static int smartsdr_vita_parse(const unsigned char *pkt, size_t len,
+                               unsigned long *stream_id, unsigned int *class_code,
+                               const unsigned char **payload, size_t *payload_len)
+{
+    unsigned long hdr;
+    size_t size, off = 4;
+    int type;
+
+    if (len < 4)
+    {
+        return -RIG_EPROTO;
+    }
+
+    hdr = smartsdr_get_be32(pkt);
+    type = hdr >> 28;
+    size = (hdr & 0xffff) * 4;
+
+    if (size > len || !(hdr & (1UL << 27)))
+    {
+        return -RIG_EPROTO;
+    }
+
+    *stream_id = 0;
+
+    if (type == 1 || type == 3)
+    {
+        *stream_id = smartsdr_get_be32(pkt + off);
+        off += 4;
+    }
+
+    if (off + 8 > size || (smartsdr_get_be32(pkt + off) & 0xffffff) != SMARTSDR_OUI)
+    {
+        return -RIG_EPROTO;
+    }
+
+    *class_code = smartsdr_get_be32(pkt + off + 4) & 0xffff;
+    off += 8;
+
+    if ((hdr >> 22) & 3) { off += 4; }  /* integer timestamp */
+
+    if ((hdr >> 20) & 3) { off += 8; }  /* fractional timestamp */
+
+    if ((hdr >> 26) & 1) { size -= 4; } /* trailer */
+
+    if (off > size)
+    {
+        return -RIG_EPROTO;
+    }
+
+    *payload = pkt + off;
+    *payload_len = size - off;
+
+    return RIG_OK;
+}
+
+/* pairs of u16 meter id, i16 value; dBm and SWR are in 1/128 */
+static void smartsdr_meters(RIG *rig, const unsigned char *p, size_t len)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+
+    SMARTSDR_LOCK(priv);
+
+    for (; len >= 4; p += 4, len -= 4)
+    {
+        int id = (p[0] << 8) | p[1];
+        float value = (short)((p[2] << 8) | p[3]) / 128.0f;
+
+        if (id == priv->level_meter) { priv->level_dbm = value; }
+        else if (id == priv->fwd_meter) { priv->fwd_dbm = value; }
+        else if (id == priv->swr_meter) { priv->swr = value; }
+    }
+
+    SMARTSDR_UNLOCK(priv);
+}
+
+/*
+ * One packet of a panadapter frame: u16 start bin, u16 bin count,
+ * u16 bin size, u16 bins in the frame, u32 frame index, u16 bins[].
+ * A bin counts pixels down from max_dbm.  The line is fired once the
+ * frame is complete.
+ */
+static void smartsdr_fft(RIG *rig, const unsigned char *p, size_t len)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    struct spectrum_pool_line *pl;
+    struct rig_spectrum_line stack_line;
+    struct rig_spectrum_line *line;
+    unsigned char *data;
+    unsigned int start, count, total, i;
+    unsigned long frame;
+    freq_t center, span;
+    float min_dbm, max_dbm;
+    int y;
+
+    if (len < 12)
+    {
+        return;
+    }
+
+    start = (p[0] << 8) | p[1];
+    count = (p[2] << 8) | p[3];
+    total = (p[6] << 8) | p[7];
+    frame = smartsdr_get_be32(p + 8);
+
+    if (total == 0 || total > HAMLIB_MAX_SPECTRUM_DATA || start + count > total
+            || 12 + count * 2 > len)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: bad FFT packet %u+%u of %u\n", __func__,
+                  start, count, total);
+        return;
+    }
+
+    if (frame != priv->frame_index)
+    {
+        priv->frame_index = frame;
+        priv->bins_filled = 0;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        priv->bins[start + i] = (p[12 + 2 * i] << 8) | p[13 + 2 * i];
+    }
+
+    priv->bins_filled += count;
+
+    if (priv->bins_filled < (int)total)
+    {
+        return;
+    }
+
+    priv->bins_filled = 0;
+
+    SMARTSDR_LOCK(priv);
+    center = priv->pan_center;
+    span = priv->pan_bandwidth;
+    min_dbm = priv->pan_min_dbm;
+    max_dbm = priv->pan_max_dbm;
+    y = priv->pan_y > 1 ? priv->pan_y : SMARTSDR_PAN_Y;
+    SMARTSDR_UNLOCK(priv);
+
+    pl = spectrum_pool_get();
+    line = pl ? &pl->line : &stack_line;
+    data = pl ? pl->data : priv->data;
+
+    for (i = 0; i < total; i++)
+    {
+        int level = priv->bins[i] >= y ? 0 : (y - 1 - priv->bins[i]) * 255 / (y - 1);
+
+        data[i] = level;
+    }
+
+    *line = (struct rig_spectrum_line)
+    {
+        .id = 0,
+        .data_level_min = 0,
+        .data_level_max = 255,
+        .signal_strength_min = min_dbm,
+        .signal_strength_max = max_dbm,
+        .spectrum_mode = RIG_SPECTRUM_MODE_CENTER,
+        .center_freq = center,
+        .span_freq = span,
+        .low_edge_freq = center - span / 2,
+        .high_edge_freq = center + span / 2,
+        .spectrum_data_length = total,
+        .spectrum_data = data,
+    };
+
+    rig_fire_spectrum_event(rig, line);
+
+    if (pl)
+    {
+        spectrum_pool_put(pl);
+    }
+}
+
+static void smartsdr_process_packet(RIG *rig, const unsigned char *pkt,
+                                    size_t len)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    const unsigned char *payload;
+    size_t payload_len;
+    unsigned long stream_id;
+    unsigned int class_code;
+
+    if (smartsdr_vita_parse(pkt, len, &stream_id, &class_code, &payload,
+                            &payload_len) != RIG_OK)
+    {
+        return;
+    }
+
+    if (class_code == SMARTSDR_CLASS_METER)
+    {
+        smartsdr_meters(rig, payload, payload_len);
+    }
+    else if (class_code == SMARTSDR_CLASS_FFT && priv->pan
+             && stream_id == priv->pan)
+    {
+        smartsdr_fft(rig, payload, payload_len);
+    }
+}
+
+#ifdef HAVE_PTHREAD
+static void *smartsdr_tcp_thread(void *arg)
+{
+    RIG *rig = arg;
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    char line[SMARTSDR_LINE_LEN];
+
+    while (priv->running)
+    {
+        int retval = smartsdr_read_line(rig, line, sizeof(line), 1);
+
+        if (retval > 0)
+        {
+            smartsdr_process_line(rig, line);
+        }
+        else if (retval < 0 && retval != -RIG_ETIMEOUT)
+        {
+            if (priv->running)
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: connection lost: %s\n", __func__,
+                          rigerror(retval));
+            }
+
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+static void *smartsdr_udp_thread(void *arg)
+{
+    RIG *rig = arg;
+    struct smartsdr_priv_data *priv = rig->state.priv;
+
+    while (priv->running)
+    {
+        struct timeval tv = { 0, SMARTSDR_UDP_POLL * 1000 };
+        fd_set rfds;
+        int n;
+
+        FD_ZERO(&rfds);
+        FD_SET(priv->udp_fd, &rfds);
+
+        if (select(priv->udp_fd + 1, &rfds, NULL, NULL, &tv) <= 0)
+        {
+            continue;
+        }
+
+        n = recv(priv->udp_fd, (char *) priv->packet, sizeof(priv->packet), 0);
+
+        if (n > 0)
+        {
+            smartsdr_process_packet(rig, priv->packet, n);
+        }
+    }
+
+    return NULL;
+}
+#endif
+
+static int smartsdr_open_udp(RIG *rig)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    struct sockaddr_in addr;
+    char cmd[64];
+
+    priv->udp_fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (priv->udp_fd < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: socket: %s\n", __func__, strerror(errno));
+        return -RIG_EIO;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(priv->udp_port);
+
+    if (bind(priv->udp_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: bind UDP port %d: %s\n", __func__,
+                  priv->udp_port, strerror(errno));
+        smartsdr_close_udp(priv);
+        return -RIG_EIO;
+    }
+
+    SNPRINTF(cmd, sizeof(cmd), "client udpport %d", priv->udp_port);
+
+    return smartsdr_command(rig, cmd, NULL, 0);
+}
+
+/* Creates our panadapter, centred on VFO A */
+static int smartsdr_open_pan(RIG *rig)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    char cmd[128];
+    char reply[128];
+    int retval;
+
+    retval = smartsdr_command(rig, "client gui", NULL, 0);
+
+    if (retval == RIG_OK)
+    {
+        SNPRINTF(cmd, sizeof(cmd), "display pan create x=%d y=%d", SMARTSDR_PAN_X,
+                 SMARTSDR_PAN_Y);
+        priv->pan_creating = 1;
+        retval = smartsdr_command(rig, cmd, reply, sizeof(reply));
+        priv->pan_creating = 0;
+    }
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    priv->pan = strtoul(reply, NULL, 16);
+    priv->pan_y = SMARTSDR_PAN_Y;
+
+    SNPRINTF(cmd, sizeof(cmd), "display pan set 0x%08lx xpixels=%d ypixels=%d",
+             priv->pan, SMARTSDR_PAN_X, SMARTSDR_PAN_Y);
+    smartsdr_command(rig, cmd, NULL, 0);
+
+    if (priv->slice[0].freq > 0)
+    {
+        SNPRINTF(cmd, sizeof(cmd), "display pan set 0x%08lx center=%.6f",
+                 priv->pan, priv->slice[0].freq / 1e6);
+        smartsdr_command(rig, cmd, NULL, 0);
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: panadapter 0x%08lx\n", __func__, priv->pan);
+
+    return RIG_OK;
+}
+
+/*
+ * Without the reader threads, reads what the radio has sent so far; the
+ * reply to a ping comes after all of it.
+ */
+static int smartsdr_refresh(RIG *rig)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+
+    if (priv->running)
+    {
+        return RIG_OK;
+    }
+
+    return smartsdr_command(rig, "ping", NULL, 0);
+}
+
+static int smartsdr_init(RIG *rig)
+{
+    struct smartsdr_priv_data *priv;
+
+    ENTERFUNC;
+
+    rig->state.priv = calloc(1, sizeof(struct smartsdr_priv_data));
+
+    if (!rig->state.priv)
+    {
+        RETURNFUNC(-RIG_ENOMEM);
+    }
+
+    priv = rig->state.priv;
+    priv->udp_port = 4993;
+    priv->udp_fd = -1;
+    priv->level_meter = priv->fwd_meter = priv->swr_meter = -1;
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init(&priv->state_lock, NULL);
+    pthread_mutex_init(&priv->cmd_lock, NULL);
+    pthread_cond_init(&priv->reply_cond, NULL);
+#endif
+
+    rig->state.current_vfo = RIG_VFO_A;
+
+    strncpy(rig->state.rigport.pathname, SMARTSDR_DEFAULT_PATH,
+            sizeof(rig->state.rigport.pathname) - 1);
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_cleanup(RIG *rig)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+
+    ENTERFUNC;
+
+    if (priv)
+    {
+#ifdef HAVE_PTHREAD
+        pthread_mutex_destroy(&priv->state_lock);
+        pthread_mutex_destroy(&priv->cmd_lock);
+        pthread_cond_destroy(&priv->reply_cond);
+#endif
+        free(priv);
+    }
+
+    rig->state.priv = NULL;
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_open(RIG *rig)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    static const char *const subs[] =
+    {
+        "sub slice all", "sub tx all", "sub radio all", "sub meter all", NULL
+    };
+    char line[SMARTSDR_LINE_LEN];
+    int retval;
+    int i;
+
+    ENTERFUNC;
+
+    priv->handle = 0;
+    priv->pan = 0;
+    memset(priv->slice, 0, sizeof(priv->slice));
+
+    /* the radio sends its version, then our handle */
+    while (priv->handle == 0)
+    {
+        retval = smartsdr_read_line(rig, line, sizeof(line), 0);
+
+        if (retval < 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: no handle from the radio: %s\n", __func__,
+                      rigerror(retval));
+            RETURNFUNC(retval);
+        }
+
+        smartsdr_process_line(rig, line);
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s, handle 0x%08lx\n", __func__, priv->info,
+              priv->handle);
+
+    /* each sub is answered after the status of everything it covers */
+    for (i = 0; subs[i]; i++)
+    {
+        retval = smartsdr_command(rig, subs[i], NULL, 0);
+
+        /* a firmware without some object refuses its sub, not the rest */
+        if (retval != RIG_OK && retval != -RIG_ERJCTED)
+        {
+            RETURNFUNC(retval);
+        }
+    }
+
+    if (priv->udp_port > 0)
+    {
+        retval = smartsdr_open_udp(rig);
+
+        if (retval != RIG_OK)
+        {
+            RETURNFUNC(retval);
+        }
+
+        if (priv->spectrum && smartsdr_open_pan(rig) != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: no panadapter, spectrum disabled\n",
+                      __func__);
+        }
+    }
+
+    rig->state.current_vfo = RIG_VFO_A;
+    rig->state.tx_vfo = priv->slice[1].tx ? RIG_VFO_B : RIG_VFO_A;
+
+#ifdef HAVE_PTHREAD
+    priv->running = 1;
+
+    if (pthread_create(&priv->tcp_thread, NULL, smartsdr_tcp_thread, rig))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        priv->running = 0;
+        smartsdr_close_udp(priv);
+        RETURNFUNC(-RIG_EINTERNAL);
+    }
+
+    if (priv->udp_fd >= 0
+            && pthread_create(&priv->udp_thread, NULL, smartsdr_udp_thread, rig))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        smartsdr_close_udp(priv);
+    }
+
+#endif
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_close(RIG *rig)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+
+    ENTERFUNC;
+
+    if (priv->pan)
+    {
+        char cmd[64];
+
+        SNPRINTF(cmd, sizeof(cmd), "display pan remove 0x%08lx", priv->pan);
+        smartsdr_command(rig, cmd, NULL, 0);
+        priv->pan = 0;
+    }
+
+#ifdef HAVE_PTHREAD
+
+    if (priv->running)
+    {
+        priv->running = 0;
+        pthread_join(priv->tcp_thread, NULL);
+
+        if (priv->udp_fd >= 0)
+        {
+            pthread_join(priv->udp_thread, NULL);
+        }
+    }
+
+#endif
+
+    smartsdr_close_udp(priv);
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_set_conf(RIG *rig, token_t token, const char *val)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+
+    switch (token)
+    {
+    case TOK_SMARTSDR_UDP_PORT:
+        priv->udp_port = atoi(val);
+        break;
+
+    case TOK_SMARTSDR_SPECTRUM:
+        priv->spectrum = atoi(val) ? 1 : 0;
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+static int smartsdr_get_conf(RIG *rig, token_t token, char *val)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+
+    switch (token)
+    {
+    case TOK_SMARTSDR_UDP_PORT:
+        sprintf(val, "%d", priv->udp_port);
+        break;
+
+    case TOK_SMARTSDR_SPECTRUM:
+        sprintf(val, "%d", priv->spectrum);
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+static int smartsdr_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    int n = smartsdr_vfo_slice(rig, vfo);
+    char cmd[64];
+    int retval;
+
+    ENTERFUNC;
+
+    if (n < 0)
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    SNPRINTF(cmd, sizeof(cmd), "slice tune %d %.6f", n, freq / 1e6);
+    retval = smartsdr_command(rig, cmd, NULL, 0);
+
+    if (retval == RIG_OK)
+    {
+        SMARTSDR_LOCK(priv);
+        priv->slice[n].freq = freq;
+        SMARTSDR_UNLOCK(priv);
+
+        if (n == 0 && priv->pan)
+        {
+            SNPRINTF(cmd, sizeof(cmd), "display pan set 0x%08lx center=%.6f",
+                     priv->pan, freq / 1e6);
+            smartsdr_command(rig, cmd, NULL, 0);
+        }
+    }
+
+    RETURNFUNC(retval);
+}
+
+static int smartsdr_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    int n = smartsdr_vfo_slice(rig, vfo);
+    int retval;
+
+    ENTERFUNC;
+
+    if (n < 0)
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    retval = smartsdr_refresh(rig);
+
+    if (retval != RIG_OK)
+    {
+        RETURNFUNC(retval);
+    }
+
+    SMARTSDR_LOCK(priv);
+    *freq = priv->slice[n].freq;
+    SMARTSDR_UNLOCK(priv);
+
+    if (*freq == 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: slice %d is not open\n", __func__, n);
+        RETURNFUNC(-RIG_ENAVAIL);
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    int n = smartsdr_vfo_slice(rig, vfo);
+    char cmd[64];
+    int retval = RIG_OK;
+
+    ENTERFUNC;
+
+    if (n < 0)
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    if (mode != RIG_MODE_NONE)
+    {
+        const char *name = smartsdr_mode_name(mode);
+
+        if (!name)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: unsupported mode %s\n", __func__,
+                      rig_strrmode(mode));
+            RETURNFUNC(-RIG_EINVAL);
+        }
+
+        SNPRINTF(cmd, sizeof(cmd), "slice set %d mode=%s", n, name);
+        retval = smartsdr_command(rig, cmd, NULL, 0);
+
+        if (retval != RIG_OK)
+        {
+            RETURNFUNC(retval);
+        }
+
+        SMARTSDR_LOCK(priv);
+        priv->slice[n].mode = mode;
+        SMARTSDR_UNLOCK(priv);
+    }
+    else
+    {
+        SMARTSDR_LOCK(priv);
+        mode = priv->slice[n].mode;
+        SMARTSDR_UNLOCK(priv);
+    }
+
+    if (width == RIG_PASSBAND_NORMAL)
+    {
+        width = rig_passband_normal(rig, mode);
+    }
+
+    if (width > 0)
+    {
+        int lo, hi;
+
+        if (mode & (RIG_MODE_USB | RIG_MODE_PKTUSB))
+        {
+            lo = SMARTSDR_SSB_LOW;
+            hi = SMARTSDR_SSB_LOW + width;
+        }
+        else if (mode & (RIG_MODE_LSB | RIG_MODE_PKTLSB))
+        {
+            lo = -SMARTSDR_SSB_LOW - width;
+            hi = -SMARTSDR_SSB_LOW;
+        }
+        else
+        {
+            lo = -width / 2;
+            hi = width / 2;
+        }
+
+        SNPRINTF(cmd, sizeof(cmd), "filt %d %d %d", n, lo, hi);
+        retval = smartsdr_command(rig, cmd, NULL, 0);
+
+        if (retval == RIG_OK)
+        {
+            SMARTSDR_LOCK(priv);
+            priv->slice[n].filter_lo = lo;
+            priv->slice[n].filter_hi = hi;
+            SMARTSDR_UNLOCK(priv);
+        }
+    }
+
+    RETURNFUNC(retval);
+}
+
+static int smartsdr_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
+                             pbwidth_t *width)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    int n = smartsdr_vfo_slice(rig, vfo);
+    int retval;
+
+    ENTERFUNC;
+
+    if (n < 0)
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    retval = smartsdr_refresh(rig);
+
+    if (retval != RIG_OK)
+    {
+        RETURNFUNC(retval);
+    }
+
+    SMARTSDR_LOCK(priv);
+    *mode = priv->slice[n].mode;
+    *width = priv->slice[n].filter_hi - priv->slice[n].filter_lo;
+    SMARTSDR_UNLOCK(priv);
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_set_vfo(RIG *rig, vfo_t vfo)
+{
+    ENTERFUNC;
+
+    if (vfo == RIG_VFO_CURR)
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
+    if (smartsdr_vfo_slice(rig, vfo) < 0)
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    rig->state.current_vfo = smartsdr_vfo_slice(rig, vfo) ? RIG_VFO_B : RIG_VFO_A;
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_get_vfo(RIG *rig, vfo_t *vfo)
+{
+    ENTERFUNC;
+
+    *vfo = rig->state.current_vfo;
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
+{
+    ENTERFUNC;
+
+    RETURNFUNC(smartsdr_command(rig, ptt == RIG_PTT_OFF ? "xmit 0" : "xmit 1",
+                                NULL, 0));
+}
+
+static int smartsdr_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    int retval;
+
+    ENTERFUNC;
+
+    retval = smartsdr_refresh(rig);
+
+    if (retval != RIG_OK)
+    {
+        RETURNFUNC(retval);
+    }
+
+    SMARTSDR_LOCK(priv);
+    *ptt = priv->ptt;
+    SMARTSDR_UNLOCK(priv);
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_set_split_vfo(RIG *rig, vfo_t vfo, split_t split,
+                                  vfo_t tx_vfo)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    char cmd[32];
+    int n = split == RIG_SPLIT_ON ? 1 : 0;
+    int retval;
+
+    ENTERFUNC;
+
+    SNPRINTF(cmd, sizeof(cmd), "slice set %d tx=1", n);
+    retval = smartsdr_command(rig, cmd, NULL, 0);
+
+    if (retval == RIG_OK)
+    {
+        SMARTSDR_LOCK(priv);
+        priv->slice[n].tx = 1;
+        priv->slice[!n].tx = 0;
+        SMARTSDR_UNLOCK(priv);
+        rig->state.tx_vfo = n ? RIG_VFO_B : RIG_VFO_A;
+    }
+
+    RETURNFUNC(retval);
+}
+
+static int smartsdr_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split,
+                                  vfo_t *tx_vfo)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    int retval;
+
+    ENTERFUNC;
+
+    retval = smartsdr_refresh(rig);
+
+    if (retval != RIG_OK)
+    {
+        RETURNFUNC(retval);
+    }
+
+    SMARTSDR_LOCK(priv);
+    *split = priv->slice[1].tx ? RIG_SPLIT_ON : RIG_SPLIT_OFF;
+    SMARTSDR_UNLOCK(priv);
+
+    *tx_vfo = *split ? RIG_VFO_B : RIG_VFO_A;
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
+{
+    ENTERFUNC;
+
+    RETURNFUNC(smartsdr_set_freq(rig, RIG_VFO_B, tx_freq));
+}
+
+static int smartsdr_get_split_freq(RIG *rig, vfo_t vfo, freq_t *tx_freq)
+{
+    ENTERFUNC;
+
+    RETURNFUNC(smartsdr_get_freq(rig, RIG_VFO_B, tx_freq));
+}
+
+static int smartsdr_set_split_mode(RIG *rig, vfo_t vfo, rmode_t mode,
+                                   pbwidth_t width)
+{
+    ENTERFUNC;
+
+    RETURNFUNC(smartsdr_set_mode(rig, RIG_VFO_B, mode, width));
+}
+
+static int smartsdr_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *mode,
+                                   pbwidth_t *width)
+{
+    ENTERFUNC;
+
+    RETURNFUNC(smartsdr_get_mode(rig, RIG_VFO_B, mode, width));
+}
+
+static int smartsdr_set_it(RIG *rig, vfo_t vfo, const char *it, shortfreq_t freq)
+{
+    int n = smartsdr_vfo_slice(rig, vfo);
+    char cmd[64];
+
+    if (n < 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    SNPRINTF(cmd, sizeof(cmd), "slice set %d %s_on=%d %s_freq=%d", n, it,
+             freq != 0, it, (int)freq);
+
+    return smartsdr_command(rig, cmd, NULL, 0);
+}
+
+static int smartsdr_set_rit(RIG *rig, vfo_t vfo, shortfreq_t rit)
+{
+    ENTERFUNC;
+
+    RETURNFUNC(smartsdr_set_it(rig, vfo, "rit", rit));
+}
+
+static int smartsdr_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    int n = smartsdr_vfo_slice(rig, vfo);
+    int retval;
+
+    ENTERFUNC;
+
+    if (n < 0)
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    retval = smartsdr_refresh(rig);
+
+    if (retval != RIG_OK)
+    {
+        RETURNFUNC(retval);
+    }
+
+    SMARTSDR_LOCK(priv);
+    *rit = priv->slice[n].rit_on ? priv->slice[n].rit : 0;
+    SMARTSDR_UNLOCK(priv);
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_set_xit(RIG *rig, vfo_t vfo, shortfreq_t xit)
+{
+    ENTERFUNC;
+
+    RETURNFUNC(smartsdr_set_it(rig, vfo, "xit", xit));
+}
+
+static int smartsdr_get_xit(RIG *rig, vfo_t vfo, shortfreq_t *xit)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    int n = smartsdr_vfo_slice(rig, vfo);
+    int retval;
+
+    ENTERFUNC;
+
+    if (n < 0)
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    retval = smartsdr_refresh(rig);
+
+    if (retval != RIG_OK)
+    {
+        RETURNFUNC(retval);
+    }
+
+    SMARTSDR_LOCK(priv);
+    *xit = priv->slice[n].xit_on ? priv->slice[n].xit : 0;
+    SMARTSDR_UNLOCK(priv);
+
+    RETURNFUNC(RIG_OK);
+}
+
+static int smartsdr_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
+{
+    int n = smartsdr_vfo_slice(rig, vfo);
+    char cmd[64];
+
+    ENTERFUNC;
+
+    switch (level)
+    {
+    case RIG_LEVEL_AF:
+        if (n < 0)
+        {
+            RETURNFUNC(-RIG_EINVAL);
+        }
+
+        SNPRINTF(cmd, sizeof(cmd), "slice set %d audio_level=%d", n,
+                 (int)lrintf(val.f * 100));
+        break;
+
+    case RIG_LEVEL_RFPOWER:
+        SNPRINTF(cmd, sizeof(cmd), "transmit set rfpower=%d",
+                 (int)lrintf(val.f * 100));
+        break;
+
+    default:
+        rig_debug(RIG_DEBUG_ERR, "%s: unsupported level %s\n", __func__,
+                  rig_strlevel(level));
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    RETURNFUNC(smartsdr_command(rig, cmd, NULL, 0));
+}
+
+static int smartsdr_get_level(RIG *rig, vfo_t vfo, setting_t level,
+                              value_t *val)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+    int n = smartsdr_vfo_slice(rig, vfo);
+    int retval;
+
+    ENTERFUNC;
+
+    retval = smartsdr_refresh(rig);
+
+    if (retval != RIG_OK)
+    {
+        RETURNFUNC(retval);
+    }
+
+    SMARTSDR_LOCK(priv);
+
+    switch (level)
+    {
+    case RIG_LEVEL_AF:
+        val->f = n < 0 ? 0 : priv->slice[n].audio_level / 100.0f;
+        break;
+
+    case RIG_LEVEL_RFPOWER:
+        val->f = priv->rfpower / 100.0f;
+        break;
+
+    case RIG_LEVEL_STRENGTH:
+        /* dB over S9, -73 dBm */
+        val->i = (int)lrintf(priv->level_dbm + 73);
+        break;
+
+    case RIG_LEVEL_RFPOWER_METER_WATTS:
+        val->f = priv->ptt ? pow(10, (priv->fwd_dbm - 30) / 10) : 0;
+        break;
+
+    case RIG_LEVEL_SWR:
+        val->f = priv->ptt && priv->swr >= 1 ? priv->swr : 1;
+        break;
+
+    default:
+        SMARTSDR_UNLOCK(priv);
+        rig_debug(RIG_DEBUG_ERR, "%s: unsupported level %s\n", __func__,
+                  rig_strlevel(level));
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    SMARTSDR_UNLOCK(priv);
+
+    RETURNFUNC(RIG_OK);
+}
+
+static const char *smartsdr_get_info(RIG *rig)
+{
+    struct smartsdr_priv_data *priv = rig->state.priv;
+
+    return priv->info;
+}
+
+/*
+ * FLEX-6000/8000 over the SmartSDR API
+ */
+const struct rig_caps smartsdr_rig_caps =
+{
+    RIG_MODEL(RIG_MODEL_SMARTSDR),
+    .model_name =       "SmartSDR",
+    .mfg_name =         "FlexRadio",
+    .version =          "20261014.0",
+    .copyright =        "LGPL",
+    .status =           RIG_STATUS_ALPHA,
+    .rig_type =         RIG_TYPE_TRANSCEIVER,
+    .targetable_vfo =   RIG_TARGETABLE_FREQ | RIG_TARGETABLE_MODE,
+    .ptt_type =         RIG_PTT_RIG,
+    .dcd_type =         RIG_DCD_NONE,
+    .port_type =        RIG_PORT_NETWORK,
+    .write_delay =      0,
+    .post_write_delay = 0,
+    .timeout =          1000,
+    .retry =            0,
+
+    .has_get_func =     RIG_FUNC_NONE,
+    .has_set_func =     RIG_FUNC_NONE,
+    .has_get_level =    SMARTSDR_LEVELS,
+    .has_set_level =    SMARTSDR_SET_LEVELS,
+    .has_get_parm =     RIG_PARM_NONE,
+    .has_set_parm =     RIG_PARM_NONE,
+    .level_gran =       {},
+    .parm_gran =        {},
+    .max_rit =          Hz(99999),
+    .max_xit =          Hz(99999),
+    .max_ifshift =      Hz(0),
+
+    .rx_range_list1 =   {
+        {kHz(30), MHz(54), SMARTSDR_MODES, -1, -1, SMARTSDR_VFOS, RIG_ANT_1},
+        RIG_FRNG_END,
+    },
+    .tx_range_list1 =   {
+        {kHz(1800), MHz(54), SMARTSDR_MODES, W(1), W(100), SMARTSDR_VFOS, RIG_ANT_1},
+        RIG_FRNG_END,
+    },
+    .rx_range_list2 =   {
+        {kHz(30), MHz(54), SMARTSDR_MODES, -1, -1, SMARTSDR_VFOS, RIG_ANT_1},
+        RIG_FRNG_END,
+    },
+    .tx_range_list2 =   {
+        {kHz(1800), MHz(54), SMARTSDR_MODES, W(1), W(100), SMARTSDR_VFOS, RIG_ANT_1},
+        RIG_FRNG_END,
+    },
+    .tuning_steps =     { {SMARTSDR_MODES, 1}, {SMARTSDR_MODES, RIG_TS_ANY}, RIG_TS_END, },
+
+    .filters =  {
+        {RIG_MODE_SSB | RIG_MODE_PKTLSB | RIG_MODE_PKTUSB, kHz(2.7)},
+        {RIG_MODE_CW | RIG_MODE_RTTY, 500},
+        {RIG_MODE_AM | RIG_MODE_SAM, kHz(6)},
+        {RIG_MODE_FM | RIG_MODE_FMN, kHz(12)},
+        RIG_FLT_END
+    },
+
+    .cfgparams =        smartsdr_cfg_params,
+
+    .rig_init =         smartsdr_init,
+    .rig_cleanup =      smartsdr_cleanup,
+    .rig_open =         smartsdr_open,
+    .rig_close =        smartsdr_close,
+    .set_conf =         smartsdr_set_conf,
+    .get_conf =         smartsdr_get_conf,
+
+    .set_freq =         smartsdr_set_freq,
+    .get_freq =         smartsdr_get_freq,
+    .set_mode =         smartsdr_set_mode,
+    .get_mode =         smartsdr_get_mode,
+    .set_vfo =          smartsdr_set_vfo,
+    .get_vfo =          smartsdr_get_vfo,
+    .set_ptt =          smartsdr_set_ptt,
+    .get_ptt =          smartsdr_get_ptt,
+    .set_split_vfo =    smartsdr_set_split_vfo,
+    .get_split_vfo =    smartsdr_get_split_vfo,
+    .set_split_freq =   smartsdr_set_split_freq,
+    .get_split_freq =   smartsdr_get_split_freq,
+    .set_split_mode =   smartsdr_set_split_mode,
+    .get_split_mode =   smartsdr_get_split_mode,
+    .set_rit =          smartsdr_set_rit,
+    .get_rit =          smartsdr_get_rit,
+    .set_xit =          smartsdr_set_xit,
+    .get_xit =          smartsdr_get_xit,
+    .set_level =        smartsdr_set_level,
+    .get_level =        smartsdr_get_level,
+    .get_info =         smartsdr_get_info,
+    .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
+};
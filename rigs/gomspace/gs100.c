@@ -29,6 +29,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <unistd.h>
 #include <math.h>
 #include <time.h>
@@ -43,6 +44,7 @@
 #include "tones.h"
 #include "idx_builtin.h"
 #include "register.h"
+#include "cache.h"
 
 #include "gs100.h"
 
@@ -62,6 +64,12 @@
 #define GOM_PROMPT         "\x1B[1;32mnanocom-ax\x1B[1;30m # \x1B[0m\x1B[0m"
 // Maximum number of lines parsed from GS100 response
 #define GOM_MAXLINES                                                      20
+// Maximum number of commands sent to the GS100 in one write
+#define GOM_PIPELINE                                                       8
+// Number of parameters cached for each configuration table
+#define GOM_CACHE_SIZE                                                    64
+// Default lifetime of cached parameter values in ms
+#define GOM_CACHE_MS                                                    1000
 
 // RIG's parametric table number for receive
 #define GOM_CONFIG_TAB_RX                                                  1
@@ -70,6 +78,28 @@
 
 /* Private Typedefs ----------------------------------------------------------*/
 
+/**
+ * Cached value of one GS100 configuration table variable
+ */
+struct gomx_param
+{
+    char name[32];          ///< variable name
+    char value[64];         ///< last value read or written
+    struct timespec stamp;  ///< when the value was read or written
+};
+
+/**
+ * Cache of one GS100 configuration table
+ */
+struct gomx_table
+{
+    int count;                                  ///< used entries of param
+    struct gomx_param param[GOM_CACHE_SIZE];    ///< cached variables
+    struct timespec listed;                     ///< last whole table read
+    int is_listed;                              ///< listed is valid
+    char *pending;                              ///< bulk set waiting for open
+};
+
 /**
  * GS100 rig private data structure
  */
@@ -78,8 +108,16 @@ struct gs100_priv_data
     freq_t freq_rx;     ///< currently just for backup and TRX emulation
     freq_t freq_tx;     ///< currently just for backup and TRX emulation
     int param_mem;      ///< last value of configuration table selection
+    int cache_ms;       ///< lifetime of cached variables, 0 disables the cache
+    struct gomx_table tab_rx;   ///< cache of GOM_CONFIG_TAB_RX
+    struct gomx_table tab_tx;   ///< cache of GOM_CONFIG_TAB_TX
 };
 
+/**
+ * Called for every response line of a command, except its echo
+ */
+typedef void (*gomx_line_t)(RIG *rig, int cmd, const char *line, void *arg);
+
 /* Imported Functions --------------------------------------------------------*/
 
 struct ext_list *alloc_init_ext(const struct confparams *cfp);
@@ -97,11 +135,27 @@ static int gomx_set(RIG *rig, int table, char *varname, char *varvalue);
  */
 static int gomx_get(RIG *rig, int table, char *varname, char *varvalue);
 
+/**
+ * Set several variables of one GS100 configuration table at once
+ */
+static int gomx_set_bulk(RIG *rig, int table, const char *list);
+
+/**
+ * Read a whole GS100 configuration table into the cache
+ */
+static int gomx_list(RIG *rig, int table);
+
 /**
  * Sends a message to the GS100 and parses response lines
  */
 static int gomx_transaction(RIG *rig, char *message, char *response);
 
+/**
+ * Sends ncmds pipelined commands to the GS100 and hands over response lines
+ */
+static int gomx_exchange(RIG *rig, const char *message, int ncmds,
+                         int maxlines, gomx_line_t handler, void *arg);
+
 /* Functions -----------------------------------------------------------------*/
 
 /* GS100 transceiver control init */
@@ -117,7 +171,7 @@ static int gs100_init(RIG *rig)
         RETURNFUNC(-RIG_EINVAL);
     }
 
-    priv = (struct gs100_priv_data *)malloc(sizeof(struct gs100_priv_data));
+    priv = (struct gs100_priv_data *)calloc(1, sizeof(struct gs100_priv_data));
 
     if (!priv)
     {
@@ -133,6 +187,7 @@ static int gs100_init(RIG *rig)
 #endif
 
     priv->param_mem = -1;  // means undefined last selection
+    priv->cache_ms = GOM_CACHE_MS;
 
     RETURNFUNC(RIG_OK);
 }
@@ -148,6 +203,8 @@ static int gs100_cleanup(RIG *rig)
 
     if (rig->state.priv)
     {
+        free(priv->tab_rx.pending);
+        free(priv->tab_tx.pending);
         free(rig->state.priv);
     }
 
@@ -160,6 +217,9 @@ static int gs100_cleanup(RIG *rig)
 /* GS100 transceiver open */
 static int gs100_open(RIG *rig)
 {
+    struct gs100_priv_data *priv = (struct gs100_priv_data *)rig->state.priv;
+    int retval = RIG_OK;
+
     ENTERFUNC;
 
     if (rig->caps->rig_model == RIG_MODEL_GS100)
@@ -167,7 +227,28 @@ static int gs100_open(RIG *rig)
         rig_debug(RIG_DEBUG_VERBOSE, "%s: OPENING'\n", __func__);
     }
 
-    RETURNFUNC(RIG_OK);
+    // the shell may have been left on any table
+    priv->param_mem = -1;
+    priv->tab_rx.count = priv->tab_tx.count = 0;
+    priv->tab_rx.is_listed = priv->tab_tx.is_listed = 0;
+
+    // tables set up before the port was open
+    if (priv->tab_rx.pending)
+    {
+        retval = gomx_set_bulk(rig, GOM_CONFIG_TAB_RX, priv->tab_rx.pending);
+        free(priv->tab_rx.pending);
+        priv->tab_rx.pending = NULL;
+    }
+
+    if (retval == RIG_OK && priv->tab_tx.pending)
+    {
+        retval = gomx_set_bulk(rig, GOM_CONFIG_TAB_TX, priv->tab_tx.pending);
+    }
+
+    free(priv->tab_tx.pending);
+    priv->tab_tx.pending = NULL;
+
+    RETURNFUNC(retval);
 }
 
 
@@ -185,22 +266,77 @@ static int gs100_close(RIG *rig)
 }
 
 
+/* GS100 transceiver configuration parameters */
+static const struct confparams gs100_cfg_params[] =
+{
+    {
+        TOK_CFG_PARAM_RX, "param_rx", "RX table",
+        "Variables of the receive configuration table, name=value,name=value",
+        "", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_CFG_PARAM_TX, "param_tx", "TX table",
+        "Variables of the transmit configuration table, name=value,name=value",
+        "", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_CFG_PARAM_CACHE, "param_cache", "Table cache",
+        "Lifetime of cached configuration table variables in ms, 0 disables",
+        "1000", RIG_CONF_NUMERIC, { .n = { 0, 3600000, 1 } }
+    },
+    { RIG_CONF_END, NULL, }
+};
+
+
+/* Table cache of a configuration table number */
+static struct gomx_table *gomx_cache(struct gs100_priv_data *priv, int table)
+{
+    return (table == GOM_CONFIG_TAB_TX ? &priv->tab_tx : &priv->tab_rx);
+}
+
+
 /* GS100 transceiver set configuration */
 static int gs100_set_conf(RIG *rig, token_t token, const char *val)
 {
-    __attribute__((unused)) struct gs100_priv_data *priv = (struct gs100_priv_data
-            *)rig->state.priv;
+    struct gs100_priv_data *priv = (struct gs100_priv_data *)rig->state.priv;
+    struct gomx_table *tab;
+    int table;
 
     ENTERFUNC;
 
-    priv = (struct gs100_priv_data *)rig->state.priv;
-
     switch (token)
     {
-    case 0:
+    case TOK_CFG_PARAM_RX:
+    case TOK_CFG_PARAM_TX:
+        table = token == TOK_CFG_PARAM_TX ? GOM_CONFIG_TAB_TX : GOM_CONFIG_TAB_RX;
+
+        if (rig->state.comm_state)
+        {
+            RETURNFUNC(gomx_set_bulk(rig, table, val));
+        }
+
+        // not open yet, the whole batch goes out in gs100_open
+        tab = gomx_cache(priv, table);
+
+        if (tab->pending)
+        {
+            char *p = realloc(tab->pending, strlen(tab->pending) + strlen(val) + 2);
+
+            if (!p) { RETURNFUNC(-RIG_ENOMEM); }
+
+            strcat(p, ",");
+            strcat(p, val);
+            tab->pending = p;
+        }
+        else if ((tab->pending = strdup(val)) == NULL)
+        {
+            RETURNFUNC(-RIG_ENOMEM);
+        }
+
         break;
 
-    case 1:
+    case TOK_CFG_PARAM_CACHE:
+        priv->cache_ms = atoi(val);
         break;
 
     default:
@@ -212,18 +348,42 @@ static int gs100_set_conf(RIG *rig, token_t token, const char *val)
 
 
 /* GS100 transceiver get configuration */
-static int gs100_get_conf(RIG *rig, token_t token, char *val)
+static int gs100_get_conf2(RIG *rig, token_t token, char *val, int val_len)
 {
-    __attribute__((unused)) struct gs100_priv_data *priv = (struct gs100_priv_data
-            *)rig->state.priv;
+    struct gs100_priv_data *priv = (struct gs100_priv_data *)rig->state.priv;
+    struct gomx_table *tab;
+    int table, retval, i, len = 0;
 
     ENTERFUNC;
 
-    priv = (struct gs100_priv_data *)rig->state.priv;
-
     switch (token)
     {
-    case 0:
+    case TOK_CFG_PARAM_RX:
+    case TOK_CFG_PARAM_TX:
+        table = token == TOK_CFG_PARAM_TX ? GOM_CONFIG_TAB_TX : GOM_CONFIG_TAB_RX;
+        tab = gomx_cache(priv, table);
+
+        // one "param list" instead of a "param get" per variable
+        if (!tab->is_listed || priv->cache_ms <= 0
+                || elapsed_ms(&tab->listed, HAMLIB_ELAPSED_GET) >= priv->cache_ms)
+        {
+            retval = gomx_list(rig, table);
+
+            if (retval != RIG_OK) { RETURNFUNC(retval); }
+        }
+
+        *val = '\0';
+
+        for (i = 0; i < tab->count && len < val_len; i++)
+        {
+            len += snprintf(val + len, val_len - len, "%s%s=%s", i ? "," : "",
+                            tab->param[i].name, tab->param[i].value);
+        }
+
+        break;
+
+    case TOK_CFG_PARAM_CACHE:
+        SNPRINTF(val, val_len, "%d", priv->cache_ms);
         break;
 
     default:
@@ -234,6 +394,13 @@ static int gs100_get_conf(RIG *rig, token_t token, char *val)
 }
 
 
+/* GS100 transceiver get configuration */
+static int gs100_get_conf(RIG *rig, token_t token, char *val)
+{
+    return gs100_get_conf2(rig, token, val, 128);
+}
+
+
 /* GS100 transceiver set receiver frequency */
 static int gs100_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
 {
@@ -429,8 +596,10 @@ struct rig_caps GS100_caps =
     .rig_cleanup = gs100_cleanup,
     .rig_open = gs100_open,
     .rig_close = gs100_close,
+    .cfgparams = gs100_cfg_params,
     .set_conf = gs100_set_conf,
     .get_conf = gs100_get_conf,
+    .get_conf2 = gs100_get_conf2,
     .set_freq = gs100_set_freq,
     .get_freq = gs100_get_freq,
     .set_split_freq = gs100_set_tx_freq,
@@ -440,6 +609,70 @@ struct rig_caps GS100_caps =
 
 /* Private functions ---------------------------------------------------------*/
 
+/* Store a variable value in the table cache */
+static void gomx_cache_put(struct gomx_table *tab, const char *varname,
+                           const char *varvalue)
+{
+    struct gomx_param *p = NULL;
+    int i;
+
+    for (i = 0; i < tab->count; i++)
+    {
+        if (strcmp(tab->param[i].name, varname) == 0) { p = &tab->param[i]; break; }
+    }
+
+    if (p == NULL)
+    {
+        if (tab->count >= GOM_CACHE_SIZE) { return; }
+
+        p = &tab->param[tab->count++];
+        SNPRINTF(p->name, sizeof(p->name), "%s", varname);
+    }
+
+    SNPRINTF(p->value, sizeof(p->value), "%s", varvalue);
+    elapsed_ms(&p->stamp, HAMLIB_ELAPSED_SET);
+}
+
+
+/* Fresh cached value of a variable, NULL if there is none */
+static const char *gomx_cache_get(struct gs100_priv_data *priv,
+                                  struct gomx_table *tab, const char *varname)
+{
+    int i;
+
+    if (priv->cache_ms <= 0) { return (NULL); }
+
+    for (i = 0; i < tab->count; i++)
+    {
+        if (strcmp(tab->param[i].name, varname) != 0) { continue; }
+
+        if (elapsed_ms(&tab->param[i].stamp, HAMLIB_ELAPSED_GET) >= priv->cache_ms)
+        {
+            return (NULL);
+        }
+
+        return (tab->param[i].value);
+    }
+
+    return (NULL);
+}
+
+
+/* Prefix a message with the table selection when needed, returns commands added */
+static int gomx_select(struct gs100_priv_data *priv, int table, char *msg,
+                       size_t len)
+{
+    if (PARAM_MEM_MINIMAL && table == priv->param_mem)
+    {
+        *msg = '\0';
+        return (0);
+    }
+
+    priv->param_mem = table;
+    snprintf(msg, len, "param mem %d\n", table);
+    return (1);
+}
+
 /* Set variable in the GS100 configuration table */
 static int gomx_set(RIG *rig, int table, char *varname, char *varvalue)
 {
@@ -474,6 +707,8 @@ static int gomx_set(RIG *rig, int table, char *varname, char *varvalue)
     // check response
     if (strlen(resp) > 0) { return (-RIG_EPROTO); }
 
+    gomx_cache_put(gomx_cache(priv, table), varname, varvalue);
+
     return (RIG_OK);
 }
 
@@ -485,6 +720,7 @@ static int gomx_get(RIG *rig, int table, char *varname, char *varvalue)
             *)rig->state.priv;
     int retval;
     char msg[BUFSZ], resp[BUFSZ], *c;
+    const char *cached;
 
     assert(rig != NULL);
     assert(varname != NULL);
@@ -492,6 +728,12 @@ static int gomx_get(RIG *rig, int table, char *varname, char *varvalue)
 
     rig_debug(RIG_DEBUG_TRACE, "%s: table=%d, '%s'\n", __func__, table, varname);
 
+    if ((cached = gomx_cache_get(priv, gomx_cache(priv, table), varname)) != NULL)
+    {
+        strcpy(varvalue, cached);
+        return (RIG_OK);
+    }
+
     if (!PARAM_MEM_MINIMAL || table != priv->param_mem)
     {
         // select the configuration table
@@ -513,61 +755,286 @@ static int gomx_get(RIG *rig, int table, char *varname, char *varvalue)
 
     if (sscanf(c + 1, "%s", varvalue) != 1) { return (-RIG_EPROTO); }
 
+    gomx_cache_put(gomx_cache(priv, table), varname, varvalue);
+
     return (RIG_OK);
 }
 
 
-/* Sends a message to the GS100 and parses response lines */
-static int gomx_transaction(RIG *rig, char *message, char *response)
+/* Response of a bulk set, any output after a "param set" is an error */
+static void gomx_set_line(RIG *rig, int cmd, const char *line, void *arg)
+{
+    int *failed = (int *)arg;
+
+    if (cmd >= failed[1] && *line != '\0')
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: command %d: '%s'\n", __func__, cmd, line);
+        failed[0] = 1;
+    }
+}
+
+
+/* Set several variables of one GS100 configuration table at once */
+static int gomx_set_bulk(RIG *rig, int table, const char *list)
+{
+    struct gs100_priv_data *priv = (struct gs100_priv_data *)rig->state.priv;
+    struct gomx_table *tab = gomx_cache(priv, table);
+    char names[GOM_PIPELINE][32], values[GOM_PIPELINE][64];
+    char msg[GOM_PIPELINE * BUFSZ];
+    const char *p = list;
+    int retval, i, n, len, failed[2];
+
+    assert(rig != NULL);
+    assert(list != NULL);
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: table=%d, '%s'\n", __func__, table, list);
+
+    while (*p != '\0')
+    {
+        // one write of up to GOM_PIPELINE commands
+        failed[0] = 0;
+        failed[1] = gomx_select(priv, table, msg, sizeof(msg));
+        len = strlen(msg);
+
+        for (n = 0; n < GOM_PIPELINE && *p != '\0';)
+        {
+            size_t l = strcspn(p, ",");
+            const char *eq = memchr(p, '=', l);
+
+            if (l > 0)
+            {
+                if (eq == NULL || eq == p || eq - p >= (int)sizeof(names[n])
+                        || l - (eq - p) - 1 >= sizeof(values[n]))
+                {
+                    rig_debug(RIG_DEBUG_ERR, "%s: bad variable '%.*s'\n", __func__,
+                              (int)l, p);
+
+                    if (failed[1]) { priv->param_mem = -1; }
+
+                    return (-RIG_EINVAL);
+                }
+
+                snprintf(names[n], sizeof(names[n]), "%.*s", (int)(eq - p), p);
+                snprintf(values[n], sizeof(values[n]), "%.*s", (int)(l - (eq - p) - 1),
+                         eq + 1);
+                len += snprintf(msg + len, sizeof(msg) - len, "param set %s %s\n",
+                                names[n], values[n]);
+                n++;
+            }
+
+            p += l;
+
+            if (*p == ',') { p++; }
+        }
+
+        if (n == 0) { break; }
+
+        retval = gomx_exchange(rig, msg, failed[1] + n, GOM_MAXLINES,
+                               gomx_set_line, failed);
+
+        if (retval != RIG_OK || failed[0])
+        {
+            // no telling which variables made it
+            priv->param_mem = -1;
+            tab->count = 0;
+            tab->is_listed = 0;
+            return (retval != RIG_OK ? retval : -RIG_EPROTO);
+        }
+
+        for (i = 0; i < n; i++)
+        {
+            gomx_cache_put(tab, names[i], values[i]);
+
+            // the frontend must not keep the old frequency around
+            if (table == GOM_CONFIG_TAB_RX && strcmp(names[i], "freq") == 0)
+            {
+                rig_set_cache_freq(rig, RIG_VFO_A, 0);
+            }
+        }
+    }
+
+    return (RIG_OK);
+}
+
+
+/* One line of "param list", either "name = value" or "0xaddr name type value" */
+static void gomx_list_line(RIG *rig, int cmd, const char *line, void *arg)
+{
+    struct gs100_priv_data *priv = (struct gs100_priv_data *)rig->state.priv;
+    struct gomx_table *tab = gomx_cache(priv, priv->param_mem);
+    char name[32], value[64];
+    const char *c;
+
+    // the "param list" is always the last command
+    if (cmd != *(int *)arg) { return; }
+
+    if ((c = strchr(line, '=')) != NULL)
+    {
+        if (sscanf(line, "%31[^= \t]", name) != 1) { return; }
+
+        if (sscanf(c + 1, "%63s", value) != 1) { return; }
+    }
+    else
+    {
+        char addr[16], type[16];
+
+        if (sscanf(line, "%15s %31s %15s", addr, name, type) != 3
+                || strncmp(addr, "0x", 2) != 0) { return; }
+
+        c = line + strlen(line);
+
+        while (c > line && isspace((unsigned char)c[-1])) { c--; }
+
+        while (c > line && !isspace((unsigned char)c[-1])) { c--; }
+
+        if (sscanf(c, "%63s", value) != 1) { return; }
+    }
+
+    gomx_cache_put(tab, name, value);
+}
+
+
+/* Read a whole GS100 configuration table into the cache */
+static int gomx_list(RIG *rig, int table)
+{
+    struct gs100_priv_data *priv = (struct gs100_priv_data *)rig->state.priv;
+    struct gomx_table *tab = gomx_cache(priv, table);
+    char msg[BUFSZ];
+    int retval, last;
+
+    assert(rig != NULL);
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: table=%d\n", __func__, table);
+
+    last = gomx_select(priv, table, msg, sizeof(msg));
+    strcat(msg, "param list\n");
+
+    retval = gomx_exchange(rig, msg, last + 1, GOM_CACHE_SIZE + GOM_MAXLINES,
+                           gomx_list_line, &last);
+
+    if (retval != RIG_OK)
+    {
+        priv->param_mem = -1;
+        return (retval);
+    }
+
+    elapsed_ms(&tab->listed, HAMLIB_ELAPSED_SET);
+    tab->is_listed = 1;
+
+    return (RIG_OK);
+}
+
+
+/* Reads one response line, or the prompt which ends every response */
+static int gomx_read_line(RIG *rig, char *buf, int *prompt)
+{
+    struct rig_state *rs = &rig->state;
+    size_t len = 0, plen = strlen(GOM_PROMPT);
+    int retval;
+
+    *prompt = 0;
+    *buf = '\0';
+
+    while (len < BUFSZ - 1)
+    {
+        // the prompt has no line end, 'm' closes its escape sequences
+        retval = read_string(&rs->rigport, (unsigned char *)buf + len, BUFSZ - len,
+                             GOM_STOPSET "m", strlen(GOM_STOPSET) + 1, 0, 0);
+
+        if (retval < 0) { return (retval); }
+
+        if (retval == 0) { return (-RIG_ETIMEOUT); }
+
+        len += retval;
+
+        if (buf[len - 1] == '\n')
+        {
+            while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == '\r')) { len--; }
+
+            buf[len] = '\0';
+            return (RIG_OK);
+        }
+
+        if (len >= plen && memcmp(buf + len - plen, GOM_PROMPT, plen) == 0)
+        {
+            buf[len - plen] = '\0';
+            *prompt = 1;
+            return (RIG_OK);
+        }
+    }
+
+    return (-RIG_EPROTO);
+}
+
+
+/* Sends ncmds pipelined commands to the GS100 and hands over response lines */
+static int gomx_exchange(RIG *rig, const char *message, int ncmds,
+                         int maxlines, gomx_line_t handler, void *arg)
 {
-    __attribute__((unused)) struct gs100_priv_data *priv = (struct gs100_priv_data
-            *)rig->state.priv;
     struct rig_state *rs;
-    int retval, n = 0;
+    int retval, cmd, n, prompt;
     char buf[BUFSZ];
 
     assert(rig != NULL);
     assert(message != NULL);
-    assert(response != NULL);
 
-    rig_debug(RIG_DEBUG_TRACE, "%s: msg='%s'\n", __func__,
-              message == NULL ? "NULL" : message);
+    rig_debug(RIG_DEBUG_TRACE, "%s: msg='%s'\n", __func__, message);
 
-    // access to private variables
     rs = &rig->state;
-    priv = (struct gs100_priv_data *)rs->priv;
 
-    // send message to the transceiver
+    // send all the commands to the transceiver in one go
     rig_flush(&rs->rigport);
     retval = write_block(&rs->rigport, (uint8_t *)message, strlen(message));
 
     if (retval != RIG_OK) { return (retval); }
 
-    while (1)
+    // each command answers with its echo, its output and the prompt
+    for (cmd = 0; cmd < ncmds; cmd++)
     {
-        // read the response line
-        retval = read_string(&rs->rigport, (unsigned char *)buf, BUFSZ,
-                             (const char *)GOM_STOPSET, 0, strlen(GOM_STOPSET), 0);
+        for (n = 0; ; )
+        {
+            retval = gomx_read_line(rig, buf, &prompt);
 
-        if (retval < 0) { return (retval); }
+            if (retval != RIG_OK) { return (retval); }
 
-        if (retval == 0) { return (-RIG_ETIMEOUT); }
+            if (prompt) { break; }
 
-        n++;
+            // don't return command echo
+            if (++n > 1 && handler) { handler(rig, cmd, buf, arg); }
 
-        // prompt is always the last line
-        if (strcmp(buf, GOM_PROMPT) == 0) { break; }
+            if (n > maxlines) { return (-RIG_EPROTO); }
+        }
+    }
 
-        // before last line would be the response
-        if (n > 1) { strcpy(response, buf); }
-        else { *response = '\0'; }  // don't return command echo
+    return (RIG_OK);
+}
 
-        if (n > GOM_MAXLINES) { return (-RIG_EPROTO); }
-    }
+
+/* Keeps the last response line of a single command */
+static void gomx_last_line(RIG *rig, int cmd, const char *line, void *arg)
+{
+    strcpy((char *)arg, line);
+}
+
+
+/* Sends a message to the GS100 and parses response lines */
+static int gomx_transaction(RIG *rig, char *message, char *response)
+{
+    int retval;
+
+    assert(rig != NULL);
+    assert(message != NULL);
+    assert(response != NULL);
+
+    *response = '\0';
+    retval = gomx_exchange(rig, message, 1, GOM_MAXLINES, gomx_last_line,
+                           response);
+
+    if (retval != RIG_OK) { return (retval); }
 
     // report the response
     rig_debug(RIG_DEBUG_VERBOSE, "%s: returning response='%s'\n", __func__,
-              response == NULL ? "NULL" : response);
+              response);
     return (RIG_OK);
 }
 
@@ -33,6 +33,9 @@
 /* backend conf */
 #define TOK_CFG_MAGICCONF    TOKEN_BACKEND(1)
 #define TOK_CFG_STATIC_DATA  TOKEN_BACKEND(2)
+#define TOK_CFG_PARAM_RX     TOKEN_BACKEND(3)
+#define TOK_CFG_PARAM_TX     TOKEN_BACKEND(4)
+#define TOK_CFG_PARAM_CACHE  TOKEN_BACKEND(5)
 
 /* ext_level's and ext_parm's tokens */
 #define TOK_EL_MAGICLEVEL    TOKEN_BACKEND(1)
@@ -21,11 +21,18 @@
 
 #include <hamlib/config.h>
 
+#include <stdlib.h>
 #include <string.h>  /* String function definitions */
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 #include "hamlib/rig.h"
 #include "serial.h"
 #include "misc.h"
+#include "stats.h"
+#include "event.h"
 #include "icom.h"
 #include "icom_defs.h"
 #include "frame.h"
@@ -109,298 +116,804 @@ int icom_frame_fix_preamble(int frame_len, unsigned char *frame)
 }
 
 /*
- * icom_one_transaction
+ * CI-V demultiplexer
  *
- * We assume that rig!=NULL, rig->state!= NULL, payload!=NULL, data!=NULL, data_len!=NULL
- * Otherwise, you'll get a nice seg fault. You've been warned!
- * payload can be NULL if payload_len == 0
- * subcmd can be equal to -1 (no subcmd wanted)
- * if no answer is to be expected, data_len must be set to NULL to tell so
+ * In half duplex everything on the bus comes back to us: the echo of our
+ * own command, the reply, transceive broadcasts, scope data and whatever
+ * other controllers and radios say to each other.  Rather than reading the
+ * echo and the reply in separate steps, and failing the transaction (to be
+ * retried) when anything else turns up in between, a transaction reads
+ * the stream one frame at a time and sorts each frame here until its own
+ * reply arrives.  Async frames go to the event path on the way.
+ */
+enum icom_frame_kind
+{
+    ICOM_FRAME_REPLY,       /* answer to the pending command */
+    ICOM_FRAME_ECHO,        /* our own command looped back */
+    ICOM_FRAME_ASYNC,       /* transceive or scope data */
+    ICOM_FRAME_FOREIGN,     /* traffic between other stations */
+    ICOM_FRAME_COLLISION,   /* jammed or garbled on the bus */
+    ICOM_FRAME_LATE_ACK,    /* answer to an earlier fast set */
+    ICOM_FRAME_BROKEN       /* no preamble or no end of message */
+};
+
+/*
+ * Resynchronize a frame on its preamble: drop anything before the first
+ * 0xfe, including the 0xfe run a rig sends on power up, and put back a
+ * missing second preamble byte.  Returns the new length, or -RIG_EPROTO if
+ * there is no preamble at all.
+ */
+static int icom_frame_sync(unsigned char *frame, int frame_len,
+                           size_t frame_size)
+{
+    int i = 0;
+
+    while (i < frame_len && frame[i] != PR)
+    {
+        i++;
+    }
+
+    if (i == frame_len)
+    {
+        return -RIG_EPROTO;
+    }
+
+    while (i + 2 < frame_len && frame[i + 1] == PR && frame[i + 2] == PR)
+    {
+        i++;
+    }
+
+    if (i > 0)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: skipped %d bytes before preamble\n",
+                  __func__, i);
+        frame_len -= i;
+        memmove(frame, frame + i, frame_len);
+    }
+
+    if (frame_len > 1 && frame[1] != PR && frame_len < (int)frame_size)
+    {
+        // Sometimes the second preamble byte is missing
+        memmove(frame + 1, frame, frame_len);
+        frame_len++;
+    }
+
+    return frame_len;
+}
+
+/*
+ * Fast set, the fast_set conf
  *
- * return RIG_OK if transaction completed,
- * or a negative value otherwise indicating the error.
+ * A set command answered by a bare FB/FA normally holds the port until
+ * that answer is in, two round trips per command on a looped bus.  With
+ * fast_set, icom_set_transaction() returns as soon as the command is out
+ * (and its echo back, if any), leaving the answer to turn up later.  The
+ * answers come in the order the commands went out, so until they have all
+ * arrived a bare ACK or NAK is taken for the oldest fast set still waiting
+ * rather than for the reply to the command at hand, wherever it is read:
+ * in icom_read_reply() during a later transaction, or icom_decode_event().
+ * A NAK is reported through the error callback.  Answers not in within
+ * rigport.timeout of the last fast set are given up on.
  */
-int icom_one_transaction(RIG *rig, unsigned char cmd, int subcmd,
-                         const unsigned char *payload, int payload_len, unsigned char *data,
-                         int *data_len)
+static int icom_fast_set_pending(RIG *rig)
 {
-    struct icom_priv_data *priv;
-    const struct icom_priv_caps *priv_caps;
-    struct rig_state *rs;
-    struct timeval start_time, current_time, elapsed_time;
-    // this buf needs to be large enough for 0xfe strings for power up
-    // at 115,200 this is now at least 150
-    unsigned char buf[200];
-    unsigned char sendbuf[MAXFRAMELEN];
-    int frm_len, frm_data_len, retval;
-    unsigned char ctrl_id;
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
 
-    ENTERFUNC;
-    memset(buf, 0, 200);
-    memset(sendbuf, 0, MAXFRAMELEN);
-    rs = &rig->state;
-    priv = (struct icom_priv_data *)rs->priv;
-    priv_caps = (struct icom_priv_caps *)rig->caps->priv;
+    if (priv->fast_pending > 0
+            && elapsed_ms(&priv->fast_time, HAMLIB_ELAPSED_GET)
+            > rig->state.rigport.timeout)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: %d fast set answers lost\n", __func__,
+                  priv->fast_pending);
+        priv->fast_pending = 0;
+    }
 
-    ctrl_id = priv_caps->serial_full_duplex == 0 ? CTRLID : 0x80;
+    return priv->fast_pending;
+}
 
-    frm_len = make_cmd_frame(sendbuf, priv->re_civ_addr, ctrl_id, cmd,
-                             subcmd, payload, payload_len);
+/*
+ * Take frame as the answer to the oldest fast set if it is a bare ACK or
+ * NAK from our rig while one is pending.  Returns 1 if it was.
+ */
+int icom_fast_set_ack(RIG *rig, const unsigned char *frame, int frame_len)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    char name[16];
+    int cmd;
 
-    /*
-     * should check return code and that write wrote cmd_len chars!
-     */
-    set_transaction_active(rig);
+    if (frame_len != ACKFRMLEN || frame[3] != priv->re_civ_addr
+            || (frame[4] != ACK && frame[4] != NAK)
+            || icom_fast_set_pending(rig) == 0)
+    {
+        return 0;
+    }
 
-    rig_flush(&rs->rigport);
+    cmd = priv->fast_cmd[priv->fast_head];
+    priv->fast_head = (priv->fast_head + 1) % ICOM_FAST_SET_MAX;
+    priv->fast_pending--;
 
-    if (data_len) { *data_len = 0; }
+    if (frame[4] == NAK)
+    {
+        priv->fast_naks++;
 
-    retval = write_block(&rs->rigport, sendbuf, frm_len);
+        if (priv->fast_bulk)
+        {
+            // icom_set_bulk() finds out which itself
+            return 1;
+        }
 
-    if (retval != RIG_OK)
+        if ((cmd & 0xff) == 0xff)
+        {
+            SNPRINTF(name, sizeof(name), "CI-V %02x", cmd >> 8);
+        }
+        else
+        {
+            SNPRINTF(name, sizeof(name), "CI-V %02x %02x", cmd >> 8, cmd & 0xff);
+        }
+
+        rig_debug(RIG_DEBUG_ERR, "%s: %s refused\n", __func__, name);
+        rig_fire_error_event(rig, -RIG_ERJCTED, name);
+    }
+
+    return 1;
+}
+
+/*
+ * Another controller writing or clearing a memory of our rig, seen on the
+ * bus or by the async reader.  Memory write and clear act on the channel
+ * selected, which we may not know, so the whole channel cache goes.
+ * A memory contents frame longer than a channel number is a write.
+ */
+void icom_watch_mem_write(RIG *rig, const unsigned char *frame, int frame_len)
+{
+    const struct icom_priv_data *priv = (struct icom_priv_data *)
+                                        rig->state.priv;
+
+    if (frame_len < 6 || frame[2] != priv->re_civ_addr
+            || frame[3] == priv->re_civ_addr)
     {
-        set_transaction_inactive(rig);
-        RETURNFUNC(retval);
+        return;
     }
 
-    if (!priv_caps->serial_full_duplex && !priv->serial_USB_echo_off)
+    if (frame[4] == C_WR_MEM || frame[4] == C_CLR_MEM
+            || (frame[4] == C_CTL_MEM && frame[5] == S_MEM_CNTNT && frame_len > 10))
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: %#x wrote memory, cmd %#x\n", __func__,
+                  frame[3], frame[4]);
+        rig_chan_cache_invalidate(rig, -1);
+    }
+}
+
+static enum icom_frame_kind icom_frame_classify(RIG *rig,
+        const unsigned char *frame, int frame_len,
+        const unsigned char *sent, int sent_len, int echo_pending,
+        unsigned char ctrl_id)
+{
+    const struct icom_priv_data *priv = (struct icom_priv_data *)
+                                        rig->state.priv;
+
+    if (frame[frame_len - 1] == COL)
+    {
+        return ICOM_FRAME_COLLISION;
+    }
+
+    if (frame[frame_len - 1] == PR)
+    {
+        // the run of 0xfe sent to wake a rig up, longer than our buffer
+        return ICOM_FRAME_FOREIGN;
+    }
+
+    if (frame[frame_len - 1] != FI || frame_len < ACKFRMLEN)
+    {
+        return ICOM_FRAME_BROKEN;
+    }
+
+    // an echo is skipped even when none was expected, it is never a reply
+    if (frame_len == sent_len && memcmp(frame, sent, sent_len) == 0)
+    {
+        return ICOM_FRAME_ECHO;
+    }
+
+    if (frame[3] == ctrl_id || frame[3] == CTRLID)
+    {
+        // a command on the bus that is not the one we sent
+        return echo_pending && frame[2] == priv->re_civ_addr ?
+               ICOM_FRAME_COLLISION : ICOM_FRAME_FOREIGN;
+    }
+
+    if (frame[3] != priv->re_civ_addr)
+    {
+        // another radio on the bus
+        return ICOM_FRAME_FOREIGN;
+    }
+
+    if (icom_is_async_frame(rig, frame_len, frame))
+    {
+        return ICOM_FRAME_ASYNC;
+    }
+
+    if (frame_len == ACKFRMLEN && (frame[4] == ACK || frame[4] == NAK)
+            && icom_fast_set_pending(rig) > 0)
     {
+        return ICOM_FRAME_LATE_ACK;
+    }
 
-        /*
-         * read what we just sent, because TX and RX are looped,
-         * and discard it...
-         * - if what we read is not what we sent, then it means
-         *          a collision on the CI-V bus occurred!
-         *      - if we get a timeout, then retry to send the frame,
-         *          up to rs->retry times.
-         */
+    return ICOM_FRAME_REPLY;
+}
 
-        retval = read_icom_frame(&rs->rigport, buf, sizeof(buf));
+/*
+ * Shared CI-V bus
+ *
+ * With the shared_bus conf set, every rig opened on the same port pathname
+ * joins one bus and does all its I/O through the port of the first rig to
+ * join, one transaction at a time, so two radios on a CT-17 or a USB hub
+ * can be driven from one process without talking over each other.  Frames
+ * a transaction reads from the other radios on the bus are handed to their
+ * own RIG, see icom_bus_route().  The other rigs' ports are still opened
+ * by rig_open() but are left idle until the rig owning the bus port is
+ * closed, when the next open one takes over.
+ */
+#define ICOM_BUS_MAX        4   /* buses per process */
+#define ICOM_BUS_RIGS       8   /* rigs per bus */
+#define ICOM_BUS_SLOT_US    5000 /* about one short frame at 19200 bps */
 
-        if (retval == -RIG_ETIMEOUT || retval == 0)
+struct icom_bus
+{
+    char pathname[HAMLIB_FILPATHLEN];
+    RIG *rig[ICOM_BUS_RIGS];
+    int count;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t lock;       /* held for a whole transaction */
+#endif
+};
+
+static struct icom_bus icom_buses[ICOM_BUS_MAX];
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t icom_buses_lock = PTHREAD_MUTEX_INITIALIZER;
+#define BUSES_LOCK()    pthread_mutex_lock(&icom_buses_lock)
+#define BUSES_UNLOCK()  pthread_mutex_unlock(&icom_buses_lock)
+#define BUS_LOCK(b)     pthread_mutex_lock(&(b)->lock)
+#define BUS_UNLOCK(b)   pthread_mutex_unlock(&(b)->lock)
+#else
+#define BUSES_LOCK()
+#define BUSES_UNLOCK()
+#define BUS_LOCK(b)
+#define BUS_UNLOCK(b)
+#endif
+
+int icom_bus_attach(RIG *rig)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    const char *pathname = rig->state.rigport.pathname;
+    struct icom_bus *bus = NULL;
+    int i;
+
+    BUSES_LOCK();
+
+    for (i = 0; i < ICOM_BUS_MAX; i++)
+    {
+        if (icom_buses[i].count > 0
+                && !strcmp(icom_buses[i].pathname, pathname))
         {
-            /* Nothing received, CI-V interface is not echoing */
-            set_transaction_inactive(rig);
-            RETURNFUNC(-RIG_BUSERROR);
+            bus = &icom_buses[i];
+            break;
         }
+    }
+
+    if (!bus)
+    {
+        for (i = 0; i < ICOM_BUS_MAX && icom_buses[i].count > 0; i++) {}
 
-        if (retval < 0)
+        if (i == ICOM_BUS_MAX)
         {
-            set_transaction_inactive(rig);
-            /* Other error, return it */
-            RETURNFUNC(retval);
+            BUSES_UNLOCK();
+            rig_debug(RIG_DEBUG_ERR, "%s: too many shared buses\n", __func__);
+            return -RIG_ENOMEM;
         }
 
-        if (retval < 1)
+        bus = &icom_buses[i];
+        memset(bus, 0, sizeof(*bus));
+        SNPRINTF(bus->pathname, sizeof(bus->pathname), "%s", pathname);
+#ifdef HAVE_PTHREAD
         {
-            set_transaction_inactive(rig);
-            RETURNFUNC(-RIG_EPROTO);
+            /* event callbacks run under the lock may call back into the rig */
+            pthread_mutexattr_t attr;
+
+            pthread_mutexattr_init(&attr);
+            pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+            pthread_mutex_init(&bus->lock, &attr);
+            pthread_mutexattr_destroy(&attr);
         }
+#endif
+    }
+    else if (bus->count == ICOM_BUS_RIGS)
+    {
+        BUSES_UNLOCK();
+        rig_debug(RIG_DEBUG_ERR, "%s: too many rigs on %s\n", __func__, pathname);
+        return -RIG_ENOMEM;
+    }
+
+    BUS_LOCK(bus);
+    bus->rig[bus->count++] = rig;
+    BUS_UNLOCK(bus);
 
-        // we might have 0xfe string during rig wakeup
-        rig_debug(RIG_DEBUG_TRACE, "%s: DEBUG retval=%d, frm_len=%d, cmd=0x%02x\n",
-                  __func__, retval, frm_len, cmd);
+    priv->bus = bus;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: CI-V %#x joined %s, %d rig(s)\n", __func__,
+              priv->re_civ_addr, pathname, bus->count);
+
+    BUSES_UNLOCK();
+
+    return RIG_OK;
+}
+
+void icom_bus_detach(RIG *rig)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    struct icom_bus *bus = priv->bus;
+    int i;
+
+    if (!bus)
+    {
+        return;
+    }
 
-        if (retval != frm_len && cmd == C_SET_PWR)
+    BUSES_LOCK();
+    BUS_LOCK(bus);
+
+    for (i = 0; i < bus->count && bus->rig[i] != rig; i++) {}
+
+    if (i < bus->count)
+    {
+        memmove(&bus->rig[i], &bus->rig[i + 1],
+                (bus->count - i - 1) * sizeof(bus->rig[0]));
+        bus->count--;
+    }
+
+    BUS_UNLOCK(bus);
+
+    if (bus->count == 0)
+    {
+#ifdef HAVE_PTHREAD
+        pthread_mutex_destroy(&bus->lock);
+#endif
+        bus->pathname[0] = '\0';
+    }
+
+    BUSES_UNLOCK();
+
+    priv->bus = NULL;
+}
+
+/* The port all I/O on the bus goes through, called with the bus locked */
+static hamlib_port_t *icom_bus_port(struct icom_bus *bus, RIG *rig)
+{
+    int i;
+
+    for (i = 0; i < bus->count; i++)
+    {
+        if (bus->rig[i]->state.comm_state)
         {
-            rig_debug(RIG_DEBUG_TRACE, "%s: removing 0xfe power up echo, len=%d", __func__,
-                      frm_len);
+            return &bus->rig[i]->state.rigport;
+        }
+    }
+
+    return &rig->state.rigport;
+}
+
+/*
+ * Hand a frame from another radio on the bus to its own RIG.
+ * Called with the bus locked.
+ */
+static void icom_bus_route(struct icom_bus *bus, const unsigned char *frame,
+                           int frame_len)
+{
+    int i;
 
-            while (buf[2] == 0xfe)
+    for (i = 0; i < bus->count; i++)
+    {
+        RIG *other = bus->rig[i];
+        const struct icom_priv_data *priv = (struct icom_priv_data *)
+                                            other->state.priv;
+
+        if (priv->re_civ_addr == frame[3])
+        {
+            if (icom_is_async_frame(other, frame_len, frame))
             {
-                memmove(buf, &buf[1], frm_len--);
+                icom_process_async_frame(other, frame_len, frame);
             }
 
-            dump_hex(buf, frm_len);
+            return;
+        }
+    }
+}
+
+/*
+ * Pause before retrying after a collision: a random number of slots, up
+ * to twice as many on each attempt, so that the stations that collided
+ * do not just collide again.
+ */
+static void icom_bus_backoff(int attempt)
+{
+    int slots = 1 << (attempt < 4 ? attempt : 4);
+
+    hl_usleep((1 + rand() % slots) * ICOM_BUS_SLOT_US);
+}
+
+/*
+ * Wait for the reply to the command in sent[], or only for its echo when
+ * want_reply is 0, sorting whatever else turns up on the way.  Returns the
+ * length of the reply frame left in buf, 0 for a bare echo, or a negative
+ * error code.
+ */
+static int icom_read_reply(RIG *rig, hamlib_port_t *port,
+                           const unsigned char *sent, int sent_len,
+                           int echo_pending, int want_reply,
+                           unsigned char *buf, size_t buf_size,
+                           unsigned char ctrl_id)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    struct timeval start_time, current_time, elapsed_time;
+    int len;
+
+    gettimeofday(&start_time, NULL);
+
+    for (;;)
+    {
+        enum icom_frame_kind kind;
+        int elapsed_ms;
+
+        len = read_icom_frame(port, buf, buf_size);
+
+        if (len == -RIG_ETIMEOUT || len == 0)
+        {
+            /* Nothing received, CI-V interface is not echoing? */
+            return echo_pending ? -RIG_BUSERROR :
+                   len == 0 ? -RIG_EPROTO : -RIG_ETIMEOUT;
+        }
+
+        if (len < 0)
+        {
+            /* Other error, return it */
+            return len;
+        }
+
+        len = icom_frame_sync(buf, len, buf_size);
+
+        if (len < 0)
+        {
+            return echo_pending ? -RIG_BUSERROR : len;
         }
 
-        switch (buf[retval - 1])
+        kind = icom_frame_classify(rig, buf, len, sent, sent_len, echo_pending,
+                                   ctrl_id);
+
+        if (kind == ICOM_FRAME_REPLY && !echo_pending)
         {
-        case COL:
-            /* Collision */
-            set_transaction_inactive(rig);
-            RETURNFUNC(-RIG_BUSBUSY);
+            return len;
+        }
 
-        case FI:
-            /* Ok, normal frame */
+        switch (kind)
+        {
+        case ICOM_FRAME_REPLY:
+            /* cannot be ours before the echo, left over from an earlier command */
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: skipping stale reply\n", __func__);
             break;
 
+        case ICOM_FRAME_ECHO:
+            if (!echo_pending && priv->serial_USB_echo_off)
+            {
+                /* see icom_get_usb_echo_off() */
+                rig_debug(RIG_DEBUG_VERBOSE, "%s: USB echo is on\n", __func__);
+                priv->serial_USB_echo_off = 0;
+            }
+
+            echo_pending = 0;
+
+            if (!want_reply)
+            {
+                return 0;
+            }
+
+            break;
+
+        case ICOM_FRAME_ASYNC:
+            icom_process_async_frame(rig, len, buf);
+            break;
+
+        case ICOM_FRAME_LATE_ACK:
+            icom_fast_set_ack(rig, buf, len);
+            break;
+
+        case ICOM_FRAME_FOREIGN:
+            icom_watch_mem_write(rig, buf, len);
+
+            if (priv->bus)
+            {
+                icom_bus_route(priv->bus, buf, len);
+            }
+
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: skipping frame %#x -> %#x\n",
+                      __func__, buf[3], buf[2]);
+            break;
+
+        case ICOM_FRAME_COLLISION:
+            return -RIG_BUSBUSY;
+
         default:
             /* Timeout after reading at least one character */
             /* Problem on ci-v bus? */
-            set_transaction_inactive(rig);
-            RETURNFUNC(-RIG_BUSERROR);
-        }
+            if (echo_pending && priv->bus)
+            {
+                /* someone else was sending too */
+                return -RIG_BUSBUSY;
+            }
 
-        if (retval != frm_len)
-        {
-            /* Not the same length??? */
-            /* Problem on ci-v bus? */
-            /* Someone else got a packet in? */
-            set_transaction_inactive(rig);
-            RETURNFUNC(-RIG_EPROTO);
+            return echo_pending ? -RIG_BUSERROR : -RIG_EPROTO;
         }
 
-        if (memcmp(buf, sendbuf, frm_len) != 0)
+        gettimeofday(&current_time, NULL);
+        timersub(&current_time, &start_time, &elapsed_time);
+
+        elapsed_ms = (int)(elapsed_time.tv_sec * 1000 + elapsed_time.tv_usec / 1000);
+
+        if (elapsed_ms > port->timeout || rig_get_deadline() == 0)
         {
-            /* Frames are different? */
-            /* Problem on ci-v bus? */
-            /* Someone else got a packet in? */
-            set_transaction_inactive(rig);
-            RETURNFUNC(-RIG_EPROTO);
+            return -RIG_ETIMEOUT;
         }
     }
+}
 
-    /*
-     * expect an answer?
-     */
-    if (data_len == NULL)
+/* copy the data of a reply frame out as icom_transaction() does */
+static int icom_reply_data(const unsigned char *buf, int len,
+                           unsigned char *data, int *data_len)
+{
+    // if we send a bad command we will get back a NAK packet
+    // e.g. fe fe e0 50 fa fd
+    if (len == ACKFRMLEN && NAK == buf[len - 2])
     {
-        set_transaction_inactive(rig);
-        RETURNFUNC(RIG_OK);
+        return -RIG_ERJCTED;
     }
 
-    gettimeofday(&start_time, NULL);
+    rig_debug(RIG_DEBUG_TRACE, "%s: frm_len=%d, frm_len-1=%02x, frm_len-2=%02x\n",
+              __func__, len, buf[len - 1], buf[len - 2]);
+
+    *data_len = len - (ACKFRMLEN - 1);
+
+    if (data != NULL) { memcpy(data, buf + 4, *data_len); }
+
+    return RIG_OK;
+}
+
+/*
+ * icom_one_transaction
+ *
+ * We assume that rig!=NULL, rig->state!= NULL, payload!=NULL, data!=NULL, data_len!=NULL
+ * Otherwise, you'll get a nice seg fault. You've been warned!
+ * payload can be NULL if payload_len == 0
+ * subcmd can be equal to -1 (no subcmd wanted)
+ * if no answer is to be expected, data_len must be set to NULL to tell so
+ *
+ * return RIG_OK if transaction completed,
+ * or a negative value otherwise indicating the error.
+ */
+static int icom_port_transaction(RIG *rig, hamlib_port_t *port,
+                                 unsigned char cmd, int subcmd,
+                                 const unsigned char *payload, int payload_len,
+                                 unsigned char *data, int *data_len)
+{
+    struct icom_priv_data *priv;
+    const struct icom_priv_caps *priv_caps;
+    struct rig_state *rs;
+    // this buf needs to be large enough for 0xfe strings for power up
+    // at 115,200 this is now at least 150
+    unsigned char buf[200];
+    unsigned char sendbuf[MAXFRAMELEN];
+    int frm_len, len, retval;
+    int echo_pending;
+    unsigned char ctrl_id;
+
+    ENTERFUNC;
+    memset(buf, 0, 200);
+    memset(sendbuf, 0, MAXFRAMELEN);
+    rs = &rig->state;
+    priv = (struct icom_priv_data *)rs->priv;
+    priv_caps = (struct icom_priv_caps *)rig->caps->priv;
+
+    ctrl_id = priv_caps->serial_full_duplex == 0 ? CTRLID : 0x80;
+
+    frm_len = make_cmd_frame(sendbuf, priv->re_civ_addr, ctrl_id, cmd,
+                             subcmd, payload, payload_len);
 
-read_another_frame:
     /*
-     * wait for ACK ...
-     * FIXME: handle padding/collisions
-     * ACKFRMLEN is the smallest frame we can expect from the rig
+     * should check return code and that write wrote cmd_len chars!
      */
-    buf[0] = 0;
-    frm_len = read_icom_frame(&rs->rigport, buf, sizeof(buf));
-
-#if 0
+    set_transaction_active(rig);
 
-    // this was causing rigctld to fail on IC706 and WSJT-X
-    // This dynamic detection is therefore disabled for now
-    if (memcmp(buf, sendbuf, frm_len) == 0 && priv->serial_USB_echo_off)
+    if (!priv->bus && icom_fast_set_pending(rig) == 0)
     {
-        // Hmmm -- got an echo back when not expected so let's change
-        priv->serial_USB_echo_off = 0;
-        // And try again
-        frm_len = read_icom_frame(&rs->rigport, buf, sizeof(buf));
+        /* on a shared bus this could drop frames for the other rigs */
+        rig_flush(port);
     }
 
-#endif
+    if (data_len) { *data_len = 0; }
 
-    if (frm_len < 0)
-    {
-        set_transaction_inactive(rig);
-        /* RIG_TIMEOUT: timeout getting response, return timeout */
-        /* other error: return it */
-        RETURNFUNC(frm_len);
-    }
+    retval = write_block(port, sendbuf, frm_len);
 
-    if (frm_len < 1)
+    if (retval != RIG_OK)
     {
         set_transaction_inactive(rig);
-        RETURNFUNC(-RIG_EPROTO);
+        RETURNFUNC(retval);
     }
 
-    retval = icom_frame_fix_preamble(frm_len, buf);
+    /*
+     * TX and RX are looped unless the interface is full duplex or the
+     * USB echo is off, so we first see what we just sent.  A garbled
+     * copy of it means a collision on the CI-V bus occurred.
+     */
+    echo_pending = !priv_caps->serial_full_duplex && !priv->serial_USB_echo_off;
 
-    if (retval < 0)
+    /*
+     * expect an answer?
+     */
+    if (data_len == NULL && !echo_pending)
     {
         set_transaction_inactive(rig);
-        RETURNFUNC(retval);
+        RETURNFUNC(RIG_OK);
     }
 
-    frm_len = retval;
+    len = icom_read_reply(rig, port, sendbuf, frm_len, echo_pending,
+                          data_len != NULL, buf, sizeof(buf), ctrl_id);
 
-    if (frm_len < 1)
+    set_transaction_inactive(rig);
+
+    if (len <= 0)
     {
-        rig_debug(RIG_DEBUG_ERR, "Unexpected frame len=%d\n", frm_len);
-        RETURNFUNC(-RIG_EPROTO);
+        RETURNFUNC(len);
     }
 
-    switch (buf[frm_len - 1])
-    {
-    case COL:
-        set_transaction_inactive(rig);
-        /* Collision */
-        RETURNFUNC(-RIG_BUSBUSY);
+    RETURNFUNC(icom_reply_data(buf, len, data, data_len));
+}
 
-    case FI:
-        /* Ok, normal frame */
-        break;
+/*
+ * Send all the commands in one write and collect the replies in order.
+ * Only used when the rig does not echo: on a looped CI-V bus the replies
+ * would collide with the rest of the burst.
+ */
+static int icom_port_batch(RIG *rig, hamlib_port_t *port,
+                           struct icom_cmd *cmds, int ncmds)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    const struct icom_priv_caps *priv_caps = (struct icom_priv_caps *)
+            rig->caps->priv;
+    unsigned char sendbuf[ICOM_BATCH_MAX * MAXFRAMELEN];
+    unsigned char buf[200];
+    int offset[ICOM_BATCH_MAX + 1];
+    unsigned char ctrl_id = priv_caps->serial_full_duplex == 0 ? CTRLID : 0x80;
+    int i, retval;
 
-    case NAK:
-        set_transaction_inactive(rig);
-        RETURNFUNC(-RIG_ERJCTED);
+    ENTERFUNC;
 
-    default:
-        set_transaction_inactive(rig);
-        /* Timeout after reading at least one character */
-        /* Problem on ci-v bus? */
-        RETURNFUNC(-RIG_EPROTO);
-    }
+    offset[0] = 0;
 
-    if (frm_len < ACKFRMLEN)
+    for (i = 0; i < ncmds; i++)
     {
-        set_transaction_inactive(rig);
-        RETURNFUNC(-RIG_EPROTO);
+        cmds[i].retval = -RIG_ETIMEOUT;
+        cmds[i].reply_len = 0;
+        offset[i + 1] = offset[i] + make_cmd_frame(sendbuf + offset[i],
+                        priv->re_civ_addr, ctrl_id, cmds[i].cmd, cmds[i].subcmd,
+                        cmds[i].payload, cmds[i].payload_len);
     }
 
-    // if we send a bad command we will get back a NAK packet
-    // e.g. fe fe e0 50 fa fd
-    if (frm_len == 6 && NAK == buf[frm_len - 2])
+    set_transaction_active(rig);
+
+    if (!priv->bus && icom_fast_set_pending(rig) == 0)
     {
-        set_transaction_inactive(rig);
-        RETURNFUNC(-RIG_ERJCTED);
+        rig_flush(port);
     }
 
-    rig_debug(RIG_DEBUG_TRACE, "%s: frm_len=%d, frm_len-1=%02x, frm_len-2=%02x\n",
-              __func__, frm_len, buf[frm_len - 1], buf[frm_len - 2]);
+    retval = write_block(port, sendbuf, offset[ncmds]);
 
-    // has to be one of these two now or frame is corrupt
-    if (FI != buf[frm_len - 1] && ACK != buf[frm_len - 1])
+    for (i = 0; retval == RIG_OK && i < ncmds; i++)
     {
-        set_transaction_inactive(rig);
-        RETURNFUNC(-RIG_BUSBUSY);
+        int len = icom_read_reply(rig, port, sendbuf + offset[i],
+                                  offset[i + 1] - offset[i], 0, 1, buf,
+                                  sizeof(buf), ctrl_id);
+
+        if (len <= 0)
+        {
+            /* the rest of the replies cannot be matched up any more */
+            retval = len < 0 ? len : -RIG_EPROTO;
+            cmds[i].retval = retval;
+            break;
+        }
+
+        cmds[i].retval = icom_reply_data(buf, len, cmds[i].reply,
+                                         &cmds[i].reply_len);
     }
 
-    frm_data_len = frm_len - (ACKFRMLEN - 1);
+    set_transaction_inactive(rig);
+
+    RETURNFUNC(retval);
+}
+
+int icom_one_transaction(RIG *rig, unsigned char cmd, int subcmd,
+                         const unsigned char *payload, int payload_len, unsigned char *data,
+                         int *data_len)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    struct icom_bus *bus = priv->bus;
+    int retval;
 
-    if (frm_data_len <= 0)
+    if (!bus)
     {
-        set_transaction_inactive(rig);
-        RETURNFUNC(-RIG_EPROTO);
+        return icom_port_transaction(rig, &rig->state.rigport, cmd, subcmd,
+                                     payload, payload_len, data, data_len);
     }
 
-    // TODO: Does ctrlid (detected by icom_is_async_frame) vary (seeing some code above using 0x80 for non-full-duplex)?
-    if (icom_is_async_frame(rig, frm_len, buf))
-    {
-        int elapsed_ms;
-        icom_process_async_frame(rig, frm_len, buf);
+    BUS_LOCK(bus);
+    retval = icom_port_transaction(rig, icom_bus_port(bus, rig), cmd, subcmd,
+                                   payload, payload_len, data, data_len);
+    BUS_UNLOCK(bus);
 
-        gettimeofday(&current_time, NULL);
-        timersub(&current_time, &start_time, &elapsed_time);
+    return retval;
+}
 
-        elapsed_ms = (int)(elapsed_time.tv_sec * 1000 + elapsed_time.tv_usec / 1000);
+/*
+ * icom_transaction_batch
+ *
+ * Runs up to ICOM_BATCH_MAX commands that all expect an answer, leaving
+ * each reply and status in its icom_cmd.  Without USB echo the commands
+ * go out in one burst and everything costs a single round trip, otherwise
+ * they are run one by one through icom_transaction().
+ *
+ * return RIG_OK if the exchange itself went fine, each command may still
+ * have been rejected, see icom_cmd.retval.
+ */
+int icom_transaction_batch(RIG *rig, struct icom_cmd *cmds, int ncmds)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    const struct icom_priv_caps *priv_caps = (struct icom_priv_caps *)
+            rig->caps->priv;
+    struct icom_bus *bus = priv->bus;
+    struct timespec stats_start;
+    int i, retval;
+
+    if (ncmds < 1 || ncmds > ICOM_BATCH_MAX)
+    {
+        return -RIG_EINVAL;
+    }
 
-        if (elapsed_ms > rs->rigport.timeout)
+    if (!priv_caps->serial_full_duplex && !priv->serial_USB_echo_off)
+    {
+        for (i = 0; i < ncmds; i++)
         {
-            set_transaction_inactive(rig);
-            RETURNFUNC(-RIG_ETIMEOUT);
+            cmds[i].reply_len = sizeof(cmds[i].reply);
+            cmds[i].retval = icom_transaction(rig, cmds[i].cmd, cmds[i].subcmd,
+                                              cmds[i].payload, cmds[i].payload_len,
+                                              cmds[i].reply, &cmds[i].reply_len);
         }
 
-        goto read_another_frame;
+        return RIG_OK;
     }
 
-    set_transaction_inactive(rig);
-
-    *data_len = frm_data_len;
+    rig_stats_begin(rig, &stats_start);
 
-    if (data != NULL && data_len != NULL) { memcpy(data, buf + 4, *data_len); }
+    if (bus)
+    {
+        BUS_LOCK(bus);
+        retval = icom_port_batch(rig, icom_bus_port(bus, rig), cmds, ncmds);
+        BUS_UNLOCK(bus);
+    }
+    else
+    {
+        retval = icom_port_batch(rig, &rig->state.rigport, cmds, ncmds);
+    }
 
-    /*
-     * TODO: check addresses in reply frame
-     */
+    rig_stats_end(rig, &stats_start, retval, 0);
 
-    RETURNFUNC(RIG_OK);
+    return retval;
 }
 
 /*
@@ -421,6 +934,7 @@ int icom_transaction(RIG *rig, int cmd, int subcmd,
                      int *data_len)
 {
     int retval, retry;
+    struct timespec stats_start;
 
     ENTERFUNC;
     rig_debug(RIG_DEBUG_VERBOSE,
@@ -428,6 +942,7 @@ int icom_transaction(RIG *rig, int cmd, int subcmd,
               cmd, subcmd, payload_len);
 
     retry = rig->state.rigport.retry;
+    rig_stats_begin(rig, &stats_start);
 
     do
     {
@@ -442,11 +957,31 @@ int icom_transaction(RIG *rig, int cmd, int subcmd,
         rig_debug(RIG_DEBUG_WARN, "%s: retry=%d: %s\n", __func__, retry,
                   rigerror(retval));
 
+        // no retry once the caller's deadline has passed, see rig_set_deadline()
+        if (rig_get_deadline() == 0)
+        {
+            retval = -RIG_ETIMEOUT;
+            break;
+        }
+
+        if (retval == -RIG_BUSBUSY)
+        {
+            icom_bus_backoff(rig->state.rigport.retry - retry);
+            continue;
+        }
+
         // On some serial errors we may need a bit of time
-        hl_usleep(100 * 1000); // pause just a bit
+        {
+            int left = rig_get_deadline();
+
+            hl_usleep((left > 0 && left < 100 ? left : 100) * 1000); // pause just a bit
+        }
     }
     while (retry-- > 0);
 
+    rig_stats_end(rig, &stats_start, retval,
+                  rig->state.rigport.retry - (retry < 0 ? 0 : retry));
+
     if (retval != RIG_OK)
     {
         rig_debug(RIG_DEBUG_VERBOSE, "%s: failed: %s\n", __func__, rigerror(retval));
@@ -455,6 +990,94 @@ int icom_transaction(RIG *rig, int cmd, int subcmd,
     RETURNFUNC(retval);
 }
 
+/*
+ * Read the answers still due to fast sets.  Returns -RIG_ETIMEOUT, or
+ * another error, if they did not all come.
+ */
+int icom_fast_set_wait(RIG *rig)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    unsigned char buf[200];
+    int len, retval = RIG_OK;
+
+    set_transaction_active(rig);
+
+    while (icom_fast_set_pending(rig) > 0)
+    {
+        len = read_icom_frame(&rig->state.rigport, buf, sizeof(buf));
+
+        if (len <= 0)
+        {
+            priv->fast_pending = 0;
+            retval = len < 0 ? len : -RIG_EPROTO;
+            break;
+        }
+
+        len = icom_frame_sync(buf, len, sizeof(buf));
+
+        if (len < ACKFRMLEN || icom_fast_set_ack(rig, buf, len))
+        {
+            continue;
+        }
+
+        if (buf[len - 1] == FI && icom_is_async_frame(rig, len, buf))
+        {
+            icom_process_async_frame(rig, len, buf);
+        }
+    }
+
+    set_transaction_inactive(rig);
+
+    return retval;
+}
+
+/*
+ * icom_set_transaction
+ *
+ * icom_transaction() for a set command answered by a bare ACK or NAK.
+ * With the fast_set conf, or during icom_set_bulk(), it does not wait for the answer, see above, and
+ * puts an ACK in data as if it had.  It does wait when ICOM_FAST_SET_MAX
+ * answers are already outstanding, and always on a shared bus where the
+ * answer could be read by another rig's transaction.
+ */
+int icom_set_transaction(RIG *rig, int cmd, int subcmd,
+                         const unsigned char *payload, int payload_len,
+                         unsigned char *data, int *data_len)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    struct timespec stats_start;
+    int retval;
+
+    if (!(priv->fast_set || priv->fast_bulk) || priv->bus
+            || icom_fast_set_pending(rig) >= ICOM_FAST_SET_MAX)
+    {
+        return icom_transaction(rig, cmd, subcmd, payload, payload_len, data,
+                                data_len);
+    }
+
+    rig_stats_begin(rig, &stats_start);
+
+    retval = icom_port_transaction(rig, &rig->state.rigport, cmd, subcmd,
+                                   payload, payload_len, NULL, NULL);
+
+    rig_stats_end(rig, &stats_start, retval, 0);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    priv->fast_cmd[(priv->fast_head + priv->fast_pending) % ICOM_FAST_SET_MAX] =
+        (cmd << 8) | (subcmd & 0xff);
+    priv->fast_pending++;
+    elapsed_ms(&priv->fast_time, HAMLIB_ELAPSED_SET);
+
+    data[0] = ACK;
+    *data_len = 1;
+
+    return RIG_OK;
+}
+
 /* used in read_icom_frame as end of block */
 static const char icom_block_end[2] = { FI, COL};
 #define icom_block_end_length 2
@@ -545,33 +1168,36 @@ int read_icom_frame_direct(hamlib_port_t *p, const unsigned char rxbuffer[],
  * TODO: be more exhaustive
  * assumes rig!=NULL
  */
-int rig2icom_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width,
-                  unsigned char *md, signed char *pd)
+/* index of the single bit set in mode, -1 for none or several */
+static int icom_mode_bit(rmode_t mode)
 {
-    unsigned char icmode;
-    signed char icmode_ext;
-    pbwidth_t width_tmp = width;
-    struct icom_priv_data *priv_data = (struct icom_priv_data *) rig->state.priv;
-
-    ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: mode=%d, width=%d\n", __func__, (int)mode,
-              (int)width);
-    icmode_ext = -1;
+    int bit = 0;
 
-    if (width == RIG_PASSBAND_NOCHANGE) // then we read width so we can reuse it
+    if (mode == RIG_MODE_NONE || (mode & (mode - 1)))
     {
-        rig_debug(RIG_DEBUG_TRACE, "%s: width==RIG_PASSBAND_NOCHANGE\n", __func__);
-        rmode_t tmode;
-        int ret = rig_get_mode(rig, vfo, &tmode, &width);
-
-        if (ret != RIG_OK)
-        {
-            rig_debug(RIG_DEBUG_WARN,
-                      "%s: Failed to get width for passband nochange err=%s\n", __func__,
-                      rigerror(ret));
-        }
+        return -1;
     }
 
+    if (!(mode & 0xffffffffULL)) { bit += 32; mode >>= 32; }
+
+    if (!(mode & 0xffff)) { bit += 16; mode >>= 16; }
+
+    if (!(mode & 0xff)) { bit += 8; mode >>= 8; }
+
+    if (!(mode & 0xf)) { bit += 4; mode >>= 4; }
+
+    if (!(mode & 0x3)) { bit += 2; mode >>= 2; }
+
+    if (!(mode & 0x1)) { bit += 1; }
+
+    return bit;
+}
+
+/* CI-V mode byte for mode, -1 if unsupported */
+static int icom_rmode_to_civ(RIG *rig, rmode_t mode)
+{
+    int icmode;
+
     switch (mode)
     {
     case RIG_MODE_AM:   icmode = S_AM; break;
@@ -638,16 +1264,66 @@ int rig2icom_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width,
 
     case RIG_MODE_DD:   icmode = S_DD; break;
 
-    default:
+    default: return -1;
+    }
+
+    return icmode;
+}
+
+int rig2icom_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width,
+                  unsigned char *md, signed char *pd)
+{
+    unsigned char icmode;
+    signed char icmode_ext;
+    int civ, bit;
+    pbwidth_t width_tmp = width;
+    struct icom_priv_data *priv_data = (struct icom_priv_data *) rig->state.priv;
+
+    ENTERFUNC;
+    rig_debug(RIG_DEBUG_TRACE, "%s: mode=%d, width=%d\n", __func__, (int)mode,
+              (int)width);
+    icmode_ext = -1;
+
+    if (width == RIG_PASSBAND_NOCHANGE) // then we read width so we can reuse it
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: width==RIG_PASSBAND_NOCHANGE\n", __func__);
+        rmode_t tmode;
+        int ret = rig_get_mode(rig, vfo, &tmode, &width);
+
+        if (ret != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_WARN,
+                      "%s: Failed to get width for passband nochange err=%s\n", __func__,
+                      rigerror(ret));
+        }
+    }
+
+    bit = icom_mode_bit(mode);
+
+    if (priv_data->mode_tables && bit >= 0 && (rig->state.mode_list & mode))
+    {
+        civ = priv_data->mode_to_civ[bit] == 0xff ? -1 : priv_data->mode_to_civ[bit];
+    }
+    else
+    {
+        bit = -1;
+        civ = icom_rmode_to_civ(rig, mode);
+    }
+
+    if (civ < 0)
+    {
         rig_debug(RIG_DEBUG_ERR, "%s: Unsupported Hamlib mode %s\n", __func__,
                   rig_strrmode(mode));
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    icmode = civ;
+
     if (width_tmp != RIG_PASSBAND_NOCHANGE)
     {
         rig_debug(RIG_DEBUG_TRACE, "%s: width_tmp=%ld\n", __func__, width_tmp);
-        pbwidth_t medium_width = rig_passband_normal(rig, mode);
+        pbwidth_t medium_width = bit >= 0 ? priv_data->mode_normal[bit] :
+                                 rig_passband_normal(rig, mode);
 
         if (width == RIG_PASSBAND_NORMAL)
         {
@@ -692,14 +1368,10 @@ int rig2icom_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width,
     RETURNFUNC(RIG_OK);
 }
 
-/*
- * assumes rig!=NULL, mode!=NULL, width!=NULL
- */
-void icom2rig_mode(RIG *rig, unsigned char md, int pd, rmode_t *mode,
-                   pbwidth_t *width)
+/* the uncached icom2rig_mode(), only complains when verbose */
+static void icom_civ_to_rmode(RIG *rig, unsigned char md, int pd,
+                              rmode_t *mode, pbwidth_t *width, int verbose)
 {
-    ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: mode=0x%02x, pd=%d\n", __func__, md, pd);
     *width = RIG_PASSBAND_NORMAL;
 
     switch (md)
@@ -776,8 +1448,12 @@ void icom2rig_mode(RIG *rig, unsigned char md, int pd, rmode_t *mode,
     case 0xff:  *mode = RIG_MODE_NONE; break;   /* blank mem channel */
 
     default:
-        rig_debug(RIG_DEBUG_ERR, "icom: Unsupported Icom mode %#.2x\n",
-                  md);
+        if (verbose)
+        {
+            rig_debug(RIG_DEBUG_ERR, "icom: Unsupported Icom mode %#.2x\n",
+                      md);
+        }
+
         *mode = RIG_MODE_NONE;
     }
 
@@ -823,8 +1499,95 @@ void icom2rig_mode(RIG *rig, unsigned char md, int pd, rmode_t *mode,
         break;        /* no passband data */
 
     default:
-        rig_debug(RIG_DEBUG_ERR, "icom: Unsupported Icom mode width %#.2x\n", pd);
+        if (verbose)
+        {
+            rig_debug(RIG_DEBUG_ERR, "icom: Unsupported Icom mode width %#.2x\n", pd);
+        }
+    }
+
+}
+
+/*
+ * assumes rig!=NULL, mode!=NULL, width!=NULL
+ */
+void icom2rig_mode(RIG *rig, unsigned char md, int pd, rmode_t *mode,
+                   pbwidth_t *width)
+{
+    const struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: mode=0x%02x, pd=%d\n", __func__, md, pd);
+
+    if (priv->mode_tables && md < ICOM_MODE_TABLE_SIZE && pd >= -1 && pd <= 3
+            && pd != 0)
+    {
+        const struct icom_mode_entry *e = &priv->civ_to_mode[md][pd < 0 ? 0 : pd];
+
+        if (e->mode != RIG_MODE_NONE)
+        {
+            *mode = e->mode;
+            *width = e->width;
+            return;
+        }
+    }
+
+    icom_civ_to_rmode(rig, md, pd, mode, width, 1);
+}
+
+/*
+ * Fill the mode tables in icom_priv_data so that rig2icom_mode() and
+ * icom2rig_mode() become lookups.  Only modes in the rig's mode_list are
+ * entered, anything else still takes the long way and gets reported.
+ * Needs rig->state.filters, i.e. call it from the backend's rig_init.
+ */
+void icom_mode_tables_init(RIG *rig)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    rmode_t modes = rig->state.mode_list;
+    int bit, md, slot;
+
+    memset(priv->mode_to_civ, 0xff, sizeof(priv->mode_to_civ));
+    memset(priv->mode_normal, 0, sizeof(priv->mode_normal));
+    memset(priv->civ_to_mode, 0, sizeof(priv->civ_to_mode));
+
+    for (bit = 0; bit < 64; bit++)
+    {
+        rmode_t mode = (rmode_t)1 << bit;
+        int civ;
+
+        if (!(modes & mode) || (civ = icom_rmode_to_civ(rig, mode)) < 0)
+        {
+            continue;
+        }
+
+        priv->mode_to_civ[bit] = civ;
+        priv->mode_normal[bit] = rig_passband_normal(rig, mode);
+    }
+
+    for (md = 0; md < ICOM_MODE_TABLE_SIZE; md++)
+    {
+        for (slot = 0; slot < 4; slot++)
+        {
+            struct icom_mode_entry *e = &priv->civ_to_mode[md][slot];
+            int pd = slot == 0 ? -1 : slot;
+
+            /* the passband lookups are only worth it for a mode we can have */
+            icom_civ_to_rmode(rig, md, -1, &e->mode, &e->width, 0);
+
+            if (!(modes & e->mode))
+            {
+                e->mode = RIG_MODE_NONE;
+                continue;
+            }
+
+            icom_civ_to_rmode(rig, md, pd, &e->mode, &e->width, 0);
+
+            if (!(modes & e->mode))
+            {
+                e->mode = RIG_MODE_NONE;
+            }
+        }
     }
 
+    priv->mode_tables = 1;
 }
 
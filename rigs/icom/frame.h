@@ -37,7 +37,38 @@ int icom_transaction (RIG *rig, int cmd, int subcmd, const unsigned char *payloa
 int read_icom_frame(hamlib_port_t *p, const unsigned char rxbuffer[], size_t rxbuffer_len);
 int read_icom_frame_direct(hamlib_port_t *p, const unsigned char rxbuffer[], size_t rxbuffer_len);
 
+/* one command of icom_transaction_batch() */
+#define ICOM_BATCH_MAX 8
+
+struct icom_cmd
+{
+    int cmd;
+    int subcmd;
+    unsigned char payload[8];
+    int payload_len;
+    unsigned char reply[MAXFRAMELEN];   /* as data in icom_transaction() */
+    int reply_len;
+    int retval;
+};
+
+int icom_transaction_batch(RIG *rig, struct icom_cmd *cmds, int ncmds);
+
+/* fast_set conf, see frame.c */
+int icom_set_transaction(RIG *rig, int cmd, int subcmd, const unsigned char *payload, int payload_len, unsigned char *data, int *data_len);
+int icom_fast_set_ack(RIG *rig, const unsigned char *frame, int frame_len);
+void icom_watch_mem_write(RIG *rig, const unsigned char *frame, int frame_len);
+int icom_fast_set_wait(RIG *rig);
+
+/* shared CI-V bus, see frame.c */
+int icom_bus_attach(RIG *rig);
+void icom_bus_detach(RIG *rig);
+
+/* Icom LAN (RS-BA1) transport, see icomlan.c */
+int icom_lan_open(RIG *rig);
+void icom_lan_close(RIG *rig);
+
 int rig2icom_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width, unsigned char *md, signed char *pd);
 void icom2rig_mode(RIG *rig, unsigned char md, int pd, rmode_t *mode, pbwidth_t *width);
+void icom_mode_tables_init(RIG *rig);
 
 #endif /* _FRAME_H */
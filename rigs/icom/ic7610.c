@@ -567,6 +567,8 @@ const struct rig_caps ic7610_caps =
     .scan =  icom_scan,
     .set_ptt =  icom_set_ptt,
     .get_ptt =  icom_get_ptt,
+    .get_bulk =  icom_get_bulk,
+    .set_bulk =  icom_set_bulk,
     .get_dcd =  icom_get_dcd,
     .set_ts =  icom_set_ts,
     .get_ts =  icom_get_ts,
@@ -578,6 +580,7 @@ const struct rig_caps ic7610_caps =
     .get_split_freq =  icom_get_split_freq,
     .set_split_mode =  icom_set_split_mode,
     .get_split_mode =  icom_get_split_mode,
+    .set_split_freq_mode =  icom_set_split_freq_mode_x25,
     .set_split_vfo =  icom_set_split_vfo,
     .get_split_vfo =  icom_get_split_vfo,
     .set_powerstat = icom_set_powerstat,
@@ -43,6 +43,8 @@
 #include "frame.h"
 #include "misc.h"
 #include "event.h"
+#include "cache.h"
+#include "spectrum_pool.h"
 
 // we automatically determine availability of the 1A 03 command
 enum { ENUM_1A_03_UNK, ENUM_1A_03_YES, ENUM_1A_03_NO };
@@ -52,6 +54,18 @@ static int icom_set_default_vfo(RIG *rig);
 static int icom_get_spectrum_vfo(RIG *rig, vfo_t vfo);
 static int icom_get_spectrum_edge_frequency_range(RIG *rig, vfo_t vfo,
         int *range_id);
+static struct icom_spectrum_settings *icom_spectrum_settings(RIG *rig,
+        vfo_t vfo);
+static int icom_get_spectrum_cache(RIG *rig, vfo_t vfo, setting_t level,
+                                   value_t *val);
+static void icom_set_spectrum_cache(RIG *rig, vfo_t vfo, setting_t level,
+                                    value_t val, int range_id);
+static void icom_set_spectrum_edge_number(RIG *rig, vfo_t vfo, int edge_number);
+
+#define ICOM_SPECTRUM_EDGES (RIG_LEVEL_SPECTRUM_EDGE_LOW | RIG_LEVEL_SPECTRUM_EDGE_HIGH)
+#define ICOM_SPECTRUM_LEVELS (RIG_LEVEL_SPECTRUM_MODE | RIG_LEVEL_SPECTRUM_SPAN | \
+        RIG_LEVEL_SPECTRUM_SPEED | RIG_LEVEL_SPECTRUM_REF | RIG_LEVEL_SPECTRUM_ATT | \
+        ICOM_SPECTRUM_EDGES)
 
 const cal_table_float_t icom_default_swr_cal =
 {
@@ -428,6 +442,10 @@ struct icom_addr
 #define TOK_CIVADDR TOKEN_BACKEND(1)
 #define TOK_MODE731 TOKEN_BACKEND(2)
 #define TOK_NOXCHG TOKEN_BACKEND(3)
+#define TOK_SHARED_BUS TOKEN_BACKEND(4)
+#define TOK_LAN_USER TOKEN_BACKEND(5)
+#define TOK_LAN_PASSWORD TOKEN_BACKEND(6)
+#define TOK_FAST_SET TOKEN_BACKEND(7)
 
 const struct confparams icom_cfg_params[] =
 {
@@ -445,6 +463,28 @@ const struct confparams icom_cfg_params[] =
         "Don't Use VFO XCHG to set other VFO mode and Frequency",
         "0", RIG_CONF_CHECKBUTTON
     },
+    {
+        TOK_SHARED_BUS, "shared_bus", "Shared CI-V bus",
+        "Share the port with the other rigs opened on it, each with its own civaddr",
+        "0", RIG_CONF_CHECKBUTTON
+    },
+    {
+        TOK_LAN_USER, "lan_user", "LAN user",
+        "Network user name set in the radio, logs in with the Icom LAN protocol "
+        "when rig_pathname is host:port",
+        "", RIG_CONF_STRING,
+    },
+    {
+        TOK_LAN_PASSWORD, "lan_password", "LAN password",
+        "Network password set in the radio",
+        "", RIG_CONF_STRING,
+    },
+    {
+        TOK_FAST_SET, "fast_set", "Fast set",
+        "Don't wait for the ACK of set freq, mode, level and func, a NAK "
+        "is reported through the error callback",
+        "0", RIG_CONF_CHECKBUTTON
+    },
     {RIG_CONF_END, NULL,}
 };
 
@@ -690,6 +730,16 @@ int icom_init(RIG *rig)
         priv->x25cmdfails = 1;
     }
 
+    icom_mode_tables_init(rig);
+
+    // meters without a table of their own in the caps
+    rig_cal_default(rig, RIG_LEVEL_ALC, &icom_default_alc_cal);
+    rig_cal_default(rig, RIG_LEVEL_SWR, &icom_default_swr_cal);
+    rig_cal_default(rig, RIG_LEVEL_RFPOWER_METER, &icom_default_rfpower_meter_cal);
+    rig_cal_default(rig, RIG_LEVEL_COMP_METER, &icom_default_comp_meter_cal);
+    rig_cal_default(rig, RIG_LEVEL_VD_METER, &icom_default_vd_meter_cal);
+    rig_cal_default(rig, RIG_LEVEL_ID_METER, &icom_default_id_meter_cal);
+
     rig_debug(RIG_DEBUG_TRACE, "%s: done\n", __func__);
 
     RETURNFUNC(RIG_OK);
@@ -713,8 +763,18 @@ int icom_cleanup(RIG *rig)
 
     priv = rig->state.priv;
 
+    icom_bus_detach(rig);
+
+    icom_lan_close(rig);
+
     for (i = 0; rig->caps->spectrum_scopes[i].name != NULL; i++)
     {
+        if (priv->spectrum_scope_cache[i].pool_line)
+        {
+            spectrum_pool_put(priv->spectrum_scope_cache[i].pool_line);
+            priv->spectrum_scope_cache[i].pool_line = NULL;
+        }
+
         if (priv->spectrum_scope_cache[i].spectrum_data)
         {
             free(priv->spectrum_scope_cache[i].spectrum_data);
@@ -757,21 +817,15 @@ int icom_get_usb_echo_off(RIG *rig)
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s: ack_len=%d\n", __func__, ack_len);
 
-    if (ack_len == 1) // then we got an echo of the cmd
+    // the transaction clears serial_USB_echo_off when it sees its echo
+    if (priv->serial_USB_echo_off)
     {
-        unsigned char buf[16];
-        priv->serial_USB_echo_off = 0;
-        // we should have a freq response so we'll read it and don't really care
-        // flushing doesn't always work as it depends on timing
-        retval = read_icom_frame(&rs->rigport, buf, sizeof(buf));
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: USB echo on detected, get freq retval=%d\n",
-                  __func__, retval);
-
-        if (retval <= 0) { RETURNFUNC(-RIG_ETIMEOUT); }
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: USB echo off detected\n", __func__);
     }
     else
     {
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: USB echo off detected\n", __func__);
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: USB echo on detected, get freq retval=%d\n",
+                  __func__, retval);
     }
 
     RETURNFUNC(priv->serial_USB_echo_off);
@@ -936,6 +990,7 @@ icom_rig_open(RIG *rig)
 {
     int retval, retval_echo;
     int satmode = 0;
+    int i;
     struct rig_state *rs = &rig->state;
     struct icom_priv_data *priv = (struct icom_priv_data *) rs->priv;
     int retry_flag = 1;
@@ -943,10 +998,38 @@ icom_rig_open(RIG *rig)
 
     ENTERFUNC;
 
+    if (priv->lan_user[0] && !priv->lan)
+    {
+        retval = icom_lan_open(rig);
+
+        if (retval != RIG_OK)
+        {
+            RETURNFUNC(retval);
+        }
+    }
+
+    if (priv->shared_bus && !priv->bus)
+    {
+        retval = icom_bus_attach(rig);
+
+        if (retval != RIG_OK)
+        {
+            icom_lan_close(rig);
+            RETURNFUNC(retval);
+        }
+    }
+
     rs->rigport.retry = 0;
 
     priv->no_1a_03_cmd = ENUM_1A_03_UNK;
 
+    // the scope may have been set up from the front panel meanwhile
+    for (i = 0; i < priv->spectrum_scope_count; i++)
+    {
+        memset(&priv->spectrum_scope_cache[i].settings, 0,
+               sizeof(priv->spectrum_scope_cache[i].settings));
+    }
+
     rig_debug(RIG_DEBUG_VERBOSE, "%s: %s v%s\n", __func__, rig->caps->model_name,
               rig->caps->version);
 retry_open:
@@ -1005,9 +1088,14 @@ retry_open:
             {
                 rig_debug(RIG_DEBUG_ERR, "%s: rig_set_powerstat not implemented for rig\n",
                           __func__);
+                icom_bus_detach(rig);
+                icom_lan_close(rig);
                 RETURNFUNC(-RIG_ECONF);
             }
 
+            icom_bus_detach(rig);
+
+            icom_lan_close(rig);
             RETURNFUNC(retval);
         }
 
@@ -1018,6 +1106,8 @@ retry_open:
         {
             rig_debug(RIG_DEBUG_ERR, "%s: Unable to determine USB echo status\n", __func__);
             rs->rigport.retry = retry_save;
+            icom_bus_detach(rig);
+            icom_lan_close(rig);
             RETURNFUNC(retval_echo);
         }
     }
@@ -1042,6 +1132,13 @@ retry_open:
         rig->state.current_vfo = icom_current_vfo(rig);
     }
 
+    // icom_get_freq reads the unselected VFO with 0x25 when the rig answers
+    // it, so the frontend does not have to swap VFOs to read it
+    if (priv->poweron && !priv->x25cmdfails)
+    {
+        rs->targetable_vfo |= RIG_TARGETABLE_FREQ;
+    }
+
     if (rig->caps->has_get_func & RIG_FUNC_SATMODE)
     {
         // retval is important here -- used below
@@ -1099,11 +1196,17 @@ icom_rig_close(RIG *rig)
 
             rig_debug(RIG_DEBUG_WARN, "%s: rig_set_powerstat failed: =%s\n", __func__,
                       rigerror(retval));
+            icom_bus_detach(rig);
+            icom_lan_close(rig);
             RETURNFUNC(retval);
         }
 
     }
 
+    icom_bus_detach(rig);
+
+    icom_lan_close(rig);
+
     RETURNFUNC(RIG_OK);
 }
 
@@ -1312,18 +1415,21 @@ int icom_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
         }
 
         cmd = 0x25;
-        retval = icom_transaction(rig, cmd, subcmd, freqbuf, freq_len, ackbuf,
-                                  &ack_len);
+        retval = icom_set_transaction(rig, cmd, subcmd, freqbuf, freq_len, ackbuf,
+                                      &ack_len);
     }
     else
     {
         cmd = C_SET_FREQ;
         subcmd = -1;
-        retval = icom_transaction(rig, cmd, subcmd, freqbuf, freq_len, ackbuf,
-                                  &ack_len);
+        retval = icom_set_transaction(rig, cmd, subcmd, freqbuf, freq_len, ackbuf,
+                                      &ack_len);
     }
 
-    hl_usleep(50 * 1000); // pause for transceive message and we'll flush it
+    if (!priv->fast_set)
+    {
+        hl_usleep(50 * 1000); // pause for transceive message and we'll flush it
+    }
 
     if (retval != RIG_OK)
     {
@@ -1584,6 +1690,8 @@ int icom_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
         if (retval != RIG_OK)
         {
             priv->x25cmdfails = 1;
+            rig->state.targetable_vfo = (rig->state.targetable_vfo & ~RIG_TARGETABLE_FREQ)
+                                        | (rig->caps->targetable_vfo & RIG_TARGETABLE_FREQ);
             rig_debug(RIG_DEBUG_WARN,
                       "%s: rig probe shows 0x25 CI-V cmd not available\n", __func__);
         }
@@ -2161,7 +2269,10 @@ int icom_set_mode_with_data(RIG *rig, vfo_t vfo, rmode_t mode,
         retval = RIG_OK;
     }
 
-    hl_usleep(50 * 1000); // pause for possible transceive message which we'll flush
+    if (!((struct icom_priv_data *) rig->state.priv)->fast_set)
+    {
+        hl_usleep(50 * 1000); // pause for possible transceive message which we'll flush
+    }
 
     if (RIG_OK == retval)
     {
@@ -2320,9 +2431,9 @@ int icom_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s: #2 icmode=%d, icmode_ext=%d\n", __func__,
               icmode, icmode_ext);
-    retval = icom_transaction(rig, C_SET_MODE, icmode,
-                              (unsigned char *) &icmode_ext,
-                              (icmode_ext == -1 ? 0 : 1), ackbuf, &ack_len);
+    retval = icom_set_transaction(rig, C_SET_MODE, icmode,
+                                  (unsigned char *) &icmode_ext,
+                                  (icmode_ext == -1 ? 0 : 1), ackbuf, &ack_len);
 
     if (swapvfos)
     {
@@ -3192,6 +3303,8 @@ int icom_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
     int lvl_cn, lvl_sc;       /* Command Number, Subcommand */
     int icom_val;
     int i, retval;
+    int scope_range_id = 0;
+    value_t scope_opposite_edge = { .i = 0 };
     const struct icom_priv_caps *priv_caps =
         (const struct icom_priv_caps *) rig->caps->priv;
 
@@ -3550,6 +3663,7 @@ int icom_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
         cmdbuf[0] = icom_get_spectrum_vfo(rig, vfo);
         // Spectrum span is represented as a +/- value for Icom rigs
         to_bcd(cmdbuf + 1, val.i / 2, 5 * 2);
+        val.i = val.i / 2 * 2;
         break;
 
     case RIG_LEVEL_SPECTRUM_SPEED:
@@ -3600,6 +3714,7 @@ int icom_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
 
         // Sign
         cmdbuf[3] = (icom_db < 0) ? 1 : 0;
+        val.f = (float)((int) icom_db) / 100.0f;
         break;
     }
 
@@ -3643,6 +3758,9 @@ int icom_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
             RETURNFUNC(retval);
         }
 
+        scope_range_id = range_id;
+        scope_opposite_edge = opposite_edge_value;
+
         to_bcd(cmdbuf, range_id, 1 * 2);
         to_bcd(cmdbuf + 1, edge_number_value.i + 1, 1 * 2);
 
@@ -3691,8 +3809,16 @@ int icom_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
         RETURNFUNC(-RIG_EINVAL);
     }
 
-    retval = icom_transaction(rig, lvl_cn, lvl_sc, cmdbuf, cmd_len, ackbuf,
-                              &ack_len);
+    if (level & ICOM_SPECTRUM_LEVELS)
+    {
+        // unknown until the rig has taken it
+        struct icom_spectrum_settings *s = icom_spectrum_settings(rig, vfo);
+
+        if (s) { s->valid &= ~level; }
+    }
+
+    retval = icom_set_transaction(rig, lvl_cn, lvl_sc, cmdbuf, cmd_len, ackbuf,
+                                  &ack_len);
 
     if (retval != RIG_OK)
     {
@@ -3713,6 +3839,17 @@ int icom_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
         RETURNFUNC(-RIG_ERJCTED);
     }
 
+    if (level & ICOM_SPECTRUM_LEVELS)
+    {
+        icom_set_spectrum_cache(rig, vfo, level, val, scope_range_id);
+
+        if (level & ICOM_SPECTRUM_EDGES)
+        {
+            icom_set_spectrum_cache(rig, vfo, ICOM_SPECTRUM_EDGES & ~level,
+                                    scope_opposite_edge, scope_range_id);
+        }
+    }
+
     RETURNFUNC(RIG_OK);
 }
 
@@ -3730,6 +3867,7 @@ int icom_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
     int icom_val;
     int cmdhead;
     int retval;
+    int scope_range_id = 0;
     const struct icom_priv_caps *priv_caps =
         (const struct icom_priv_caps *) rig->caps->priv;
 
@@ -3750,6 +3888,13 @@ int icom_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
 
     rig_debug(RIG_DEBUG_TRACE, "%s: no extcmd found\n", __func__);
 
+    // scope UIs poll the scope configuration all the time
+    if ((level & ICOM_SPECTRUM_LEVELS)
+            && icom_get_spectrum_cache(rig, vfo, level, val) == RIG_OK)
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
     rs = &rig->state;
 
     cmd_len = 0;
@@ -3999,6 +4144,7 @@ int icom_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
 
         to_bcd(cmdbuf, range_id, 1 * 2);
         to_bcd(cmdbuf + 1, edge_number_value.i + 1, 1 * 2);
+        scope_range_id = range_id;
         break;
     }
 
@@ -4047,7 +4193,7 @@ int icom_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
     switch (level)
     {
     case RIG_LEVEL_STRENGTH:
-        val->i = round(rig_raw2val(icom_val, &rig->caps->str_cal));
+        val->i = round(rig_cal_value(rig, level, icom_val, NULL));
         break;
 
     case RIG_LEVEL_RAWSTR:
@@ -4108,100 +4254,37 @@ int icom_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
         break;
 
     case RIG_LEVEL_ALC:
-        if (rig->caps->alc_cal.size == 0)
-        {
-            val->f = rig_raw2val_float(icom_val, &icom_default_alc_cal);
-        }
-        else
-        {
-            val->f = rig_raw2val_float(icom_val, &rig->caps->alc_cal);
-        }
-
+        val->f = rig_cal_value(rig, level, icom_val, &icom_default_alc_cal);
         break;
 
     case RIG_LEVEL_SWR:
-        if (rig->caps->swr_cal.size == 0)
-        {
-            val->f = rig_raw2val_float(icom_val, &icom_default_swr_cal);
-        }
-        else
-        {
-            val->f = rig_raw2val_float(icom_val, &rig->caps->swr_cal);
-        }
-
+        val->f = rig_cal_value(rig, level, icom_val, &icom_default_swr_cal);
         break;
 
     case RIG_LEVEL_RFPOWER_METER:
-
         // rig table in Watts needs to be divided by 100
-        if (rig->caps->rfpower_meter_cal.size == 0)
-        {
-            val->f =
-                rig_raw2val_float(icom_val, &icom_default_rfpower_meter_cal) * 0.01;
-        }
-        else
-        {
-            val->f =
-                rig_raw2val_float(icom_val, &rig->caps->rfpower_meter_cal) * 0.01;
-        }
-
+        val->f = rig_cal_value(rig, level, icom_val,
+                               &icom_default_rfpower_meter_cal) * 0.01;
         break;
 
     case RIG_LEVEL_RFPOWER_METER_WATTS:
-
         // All Icom backends should be in Watts now
-        if (rig->caps->rfpower_meter_cal.size == 0)
-        {
-            val->f =
-                rig_raw2val_float(icom_val, &icom_default_rfpower_meter_cal);
-            rig_debug(RIG_DEBUG_TRACE, "%s: using rig table to convert %d to %.01f\n",
-                      __func__, icom_val, val->f);
-        }
-        else
-        {
-            val->f =
-                rig_raw2val_float(icom_val, &rig->caps->rfpower_meter_cal);
-            rig_debug(RIG_DEBUG_TRACE,
-                      "%s: using default icom table to convert %d to %.01f\n", __func__, icom_val,
-                      val->f);
-        }
-
+        val->f = rig_cal_value(rig, level, icom_val,
+                               &icom_default_rfpower_meter_cal);
+        rig_debug(RIG_DEBUG_TRACE, "%s: converted %d to %.01f W\n",
+                  __func__, icom_val, val->f);
         break;
 
     case RIG_LEVEL_COMP_METER:
-        if (rig->caps->comp_meter_cal.size == 0)
-        {
-            val->f = rig_raw2val_float(icom_val, &icom_default_comp_meter_cal);
-        }
-        else
-        {
-            val->f = rig_raw2val_float(icom_val, &rig->caps->comp_meter_cal);
-        }
-
+        val->f = rig_cal_value(rig, level, icom_val, &icom_default_comp_meter_cal);
         break;
 
     case RIG_LEVEL_VD_METER:
-        if (rig->caps->vd_meter_cal.size == 0)
-        {
-            val->f = rig_raw2val_float(icom_val, &icom_default_vd_meter_cal);
-        }
-        else
-        {
-            val->f = rig_raw2val_float(icom_val, &rig->caps->vd_meter_cal);
-        }
-
+        val->f = rig_cal_value(rig, level, icom_val, &icom_default_vd_meter_cal);
         break;
 
     case RIG_LEVEL_ID_METER:
-        if (rig->caps->id_meter_cal.size == 0)
-        {
-            val->f = rig_raw2val_float(icom_val, &icom_default_id_meter_cal);
-        }
-        else
-        {
-            val->f = rig_raw2val_float(icom_val, &rig->caps->id_meter_cal);
-        }
-
+        val->f = rig_cal_value(rig, level, icom_val, &icom_default_id_meter_cal);
         break;
 
     case RIG_LEVEL_CWPITCH:
@@ -4303,12 +4386,19 @@ int icom_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
     }
 
     case RIG_LEVEL_SPECTRUM_EDGE_LOW:
-        val->i = (int) from_bcd(respbuf + cmdhead, 5 * 2);
-        break;
-
     case RIG_LEVEL_SPECTRUM_EDGE_HIGH:
-        val->i = (int) from_bcd(respbuf + cmdhead + 5, 5 * 2);
+    {
+        // both edges come back, keep the one not asked for too
+        value_t low = { .i = (int) from_bcd(respbuf + cmdhead, 5 * 2) };
+        value_t high = { .i = (int) from_bcd(respbuf + cmdhead + 5, 5 * 2) };
+
+        icom_set_spectrum_cache(rig, vfo, RIG_LEVEL_SPECTRUM_EDGE_LOW, low,
+                                scope_range_id);
+        icom_set_spectrum_cache(rig, vfo, RIG_LEVEL_SPECTRUM_EDGE_HIGH, high,
+                                scope_range_id);
+        *val = level == RIG_LEVEL_SPECTRUM_EDGE_LOW ? low : high;
         break;
+    }
 
     /* RIG_LEVEL_ATT/RIG_LEVEL_SPECTRUM_ATT: returned value is already an integer in dB (coded in BCD) */
     default:
@@ -4349,6 +4439,11 @@ int icom_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
         }
     }
 
+    if (level & (ICOM_SPECTRUM_LEVELS & ~ICOM_SPECTRUM_EDGES))
+    {
+        icom_set_spectrum_cache(rig, vfo, level, *val, 0);
+    }
+
     rig_debug(RIG_DEBUG_TRACE, "%s: %d %d %d %f\n", __func__, resp_len,
               icom_val, val->i, val->f);
 
@@ -4479,6 +4574,13 @@ int icom_set_ext_level(RIG *rig, vfo_t vfo, token_t token, value_t val)
         RETURNFUNC2(-RIG_EINVAL);
     }
 
+    if (token == TOK_SCOPE_EDG)
+    {
+        struct icom_spectrum_settings *s = icom_spectrum_settings(rig, vfo);
+
+        if (s) { s->edge_number_valid = 0; }
+    }
+
     retval = icom_transaction(rig, lvl_cn, lvl_sc, cmdbuf, cmd_len, ackbuf,
                               &ack_len);
 
@@ -4501,6 +4603,11 @@ int icom_set_ext_level(RIG *rig, vfo_t vfo, token_t token, value_t val)
         RETURNFUNC2(-RIG_ERJCTED);
     }
 
+    if (token == TOK_SCOPE_EDG)
+    {
+        icom_set_spectrum_edge_number(rig, vfo, val.i);
+    }
+
     RETURNFUNC2(RIG_OK);
 }
 
@@ -4544,11 +4651,21 @@ int icom_get_ext_level(RIG *rig, vfo_t vfo, token_t token, value_t *val)
         break;
 
     case TOK_SCOPE_EDG:
+    {
+        const struct icom_spectrum_settings *s = icom_spectrum_settings(rig, vfo);
+
+        if (s && s->edge_number_valid)
+        {
+            val->i = s->edge_number;
+            RETURNFUNC(RIG_OK);
+        }
+
         lvl_cn = C_CTL_SCP;
         lvl_sc = S_SCP_EDG;
         cmd_len = 1;
         cmdbuf[0] = icom_get_spectrum_vfo(rig, vfo);
         break;
+    }
 
     case TOK_SCOPE_VBW:
         lvl_cn = C_CTL_SCP;
@@ -4611,6 +4728,7 @@ int icom_get_ext_level(RIG *rig, vfo_t vfo, token_t token, value_t *val)
     {
     case TOK_SCOPE_EDG:
         val->i = icom_val - 1;
+        icom_set_spectrum_edge_number(rig, vfo, val->i);
         break;
 
     default:
@@ -4837,6 +4955,22 @@ int icom_set_conf(RIG *rig, token_t token, const char *val)
         priv->no_xchg = atoi(val) ? 1 : 0;
         break;
 
+    case TOK_SHARED_BUS:
+        priv->shared_bus = atoi(val) ? 1 : 0;
+        break;
+
+    case TOK_LAN_USER:
+        strncpy(priv->lan_user, val, sizeof(priv->lan_user) - 1);
+        break;
+
+    case TOK_LAN_PASSWORD:
+        strncpy(priv->lan_password, val, sizeof(priv->lan_password) - 1);
+        break;
+
+    case TOK_FAST_SET:
+        priv->fast_set = atoi(val) ? 1 : 0;
+        break;
+
     default:
         RETURNFUNC(-RIG_EINVAL);
     }
@@ -4870,6 +5004,18 @@ int icom_get_conf2(RIG *rig, token_t token, char *val, int val_len)
     case TOK_NOXCHG: SNPRINTF(val, val_len, "%d", priv->no_xchg);
         break;
 
+    case TOK_SHARED_BUS: SNPRINTF(val, val_len, "%d", priv->shared_bus);
+        break;
+
+    case TOK_LAN_USER: SNPRINTF(val, val_len, "%s", priv->lan_user);
+        break;
+
+    case TOK_LAN_PASSWORD: SNPRINTF(val, val_len, "%s", priv->lan_password);
+        break;
+
+    case TOK_FAST_SET: SNPRINTF(val, val_len, "%d", priv->fast_set);
+        break;
+
     default: RETURNFUNC(-RIG_EINVAL);
     }
 
@@ -4955,6 +5101,205 @@ int icom_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
     RETURNFUNC(RIG_OK);
 }
 
+/*
+ * icom_get_bulk
+ * Reads frequencies and modes of both VFOs with 0x25/0x26 and the PTT
+ * status in one icom_transaction_batch().  0x25/0x26 address the selected
+ * and unselected VFO, so current_vfo has to be known to tell A from B.
+ * Split and meters are left to the generic code.
+ */
+int icom_get_bulk(RIG *rig, struct rig_bulk *bulk)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    const struct icom_priv_caps *priv_caps = (const struct icom_priv_caps *)
+            rig->caps->priv;
+    struct icom_cmd cmds[5];
+    rig_bulk_t bits[5];
+    vfo_t curr = rig->state.current_vfo;
+    int n = 0;
+    int retval;
+    int i;
+
+    ENTERFUNC;
+
+    if (curr != RIG_VFO_A && curr != RIG_VFO_B)
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
+    memset(cmds, 0, sizeof(cmds));
+
+#define BULK_ADD(bit, c, sc) \
+    if (bulk->mask & (bit)) \
+    { \
+        bits[n] = (bit); \
+        cmds[n].cmd = (c); \
+        cmds[n].subcmd = (sc); \
+        n++; \
+    }
+
+    if (!priv->x25cmdfails)
+    {
+        BULK_ADD(RIG_BULK_FREQ_A, 0x25, curr == RIG_VFO_A ? 0x00 : 0x01);
+        BULK_ADD(RIG_BULK_FREQ_B, 0x25, curr == RIG_VFO_B ? 0x00 : 0x01);
+    }
+
+    if (!priv->x26cmdfails && (rig->caps->targetable_vfo & RIG_TARGETABLE_MODE)
+            && rig->caps->rig_model != RIG_MODEL_IC7800)
+    {
+        BULK_ADD(RIG_BULK_MODE_A, 0x26, curr == RIG_VFO_A ? 0x00 : 0x01);
+        BULK_ADD(RIG_BULK_MODE_B, 0x26, curr == RIG_VFO_B ? 0x00 : 0x01);
+    }
+
+    BULK_ADD(RIG_BULK_PTT, C_CTL_PTT, S_PTT);
+#undef BULK_ADD
+
+    if (n == 0) { RETURNFUNC(RIG_OK); }
+
+    retval = icom_transaction_batch(rig, cmds, n);
+
+    for (i = 0; i < n; i++)
+    {
+        const unsigned char *reply = cmds[i].reply;
+        rmode_t mode;
+        pbwidth_t width;
+
+        if (cmds[i].retval != RIG_OK || reply[0] != cmds[i].cmd
+                || reply[1] != cmds[i].subcmd)
+        {
+            continue;
+        }
+
+        switch (bits[i])
+        {
+        case RIG_BULK_FREQ_A:
+        case RIG_BULK_FREQ_B:
+            // Cn,Sc + 5 bytes of BCD, 4 in 731 mode
+            if (cmds[i].reply_len != 7 && cmds[i].reply_len != 6) { continue; }
+
+            if (bits[i] == RIG_BULK_FREQ_A)
+            {
+                bulk->freqA = from_bcd(reply + 2, (cmds[i].reply_len - 2) * 2);
+            }
+            else
+            {
+                bulk->freqB = from_bcd(reply + 2, (cmds[i].reply_len - 2) * 2);
+            }
+
+            break;
+
+        case RIG_BULK_MODE_A:
+        case RIG_BULK_MODE_B:
+            // Cn,Sc,mode,datamode,filter
+            if (cmds[i].reply_len != 5) { continue; }
+
+            if (priv_caps->i2r_mode != NULL)
+            {
+                priv_caps->i2r_mode(rig, reply[2], reply[4], &mode, &width);
+            }
+            else
+            {
+                icom2rig_mode(rig, reply[2], reply[4], &mode, &width);
+            }
+
+            if (reply[3])       /* data mode, as icom_get_mode_with_data() */
+            {
+                switch (mode)
+                {
+                case RIG_MODE_USB: mode = RIG_MODE_PKTUSB; break;
+
+                case RIG_MODE_LSB: mode = RIG_MODE_PKTLSB; break;
+
+                case RIG_MODE_AM: mode = RIG_MODE_PKTAM; break;
+
+                case RIG_MODE_FM: mode = RIG_MODE_PKTFM; break;
+
+                default: break;
+                }
+            }
+
+            if (bits[i] == RIG_BULK_MODE_A)
+            {
+                bulk->modeA = mode;
+                bulk->widthA = width;
+            }
+            else
+            {
+                bulk->modeB = mode;
+                bulk->widthB = width;
+            }
+
+            break;
+
+        case RIG_BULK_PTT:
+            if (cmds[i].reply_len != 3) { continue; }
+
+            bulk->ptt = reply[2] == 1 ? RIG_PTT_ON : RIG_PTT_OFF;
+            break;
+        }
+
+        bulk->valid |= bits[i];
+    }
+
+    RETURNFUNC(retval);
+}
+
+/*
+ * icom_set_bulk
+ * The settings go out back to back the fast set way, see frame.c, and
+ * their answers are read in one go at the end.  If one was refused, the
+ * ones that looked fine are redone one at a time by rig_set_bulk() to
+ * find out which.  A shared bus is left to the generic code.
+ */
+int icom_set_bulk(RIG *rig, vfo_t vfo, struct rig_setting *settings,
+                  int count)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    int i, naks, retval;
+
+    ENTERFUNC;
+
+    if (priv->bus)
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
+    // earlier fast sets are not ours to count
+    icom_fast_set_wait(rig);
+    naks = priv->fast_naks;
+    priv->fast_bulk = 1;
+
+    for (i = 0; i < count; i++)
+    {
+        struct rig_setting *s = &settings[i];
+
+        if (s->retval != -RIG_ENIMPL)
+        {
+            continue;
+        }
+
+        s->retval = s->type == RIG_SETTING_FUNC ?
+                    rig->caps->set_func(rig, vfo, s->setting, s->val.i) :
+                    rig->caps->set_level(rig, vfo, s->setting, s->val);
+    }
+
+    retval = icom_fast_set_wait(rig);
+    priv->fast_bulk = 0;
+
+    if (retval != RIG_OK || priv->fast_naks != naks)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: %d refused, %s, going one at a time\n",
+                  __func__, priv->fast_naks - naks, rigerror(retval));
+
+        for (i = 0; i < count; i++)
+        {
+            if (settings[i].retval == RIG_OK) { settings[i].retval = -RIG_ENIMPL; }
+        }
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
 /*
  * icom_get_dcd
  * Assumes rig!=NULL, rig->state.priv!=NULL, ptt!=NULL
@@ -5976,6 +6321,132 @@ int icom_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *tx_mode,
     RETURNFUNC(retval);
 }
 
+/*
+ * Sets the frequency and mode of the TX VFO with 0x25 and 0x26 in a single
+ * icom_transaction_batch(), no VFO swap and no transceive pause.  Returns
+ * -RIG_ENAVAIL when the rig or the request needs the slow path: no
+ * 0x25/0x26, satmode, or an explicit width, which 0x26 cannot carry.
+ */
+static int icom_set_split_freq_mode_batch(RIG *rig, vfo_t tx_vfo,
+        freq_t tx_freq, rmode_t tx_mode, pbwidth_t tx_width)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    const struct icom_priv_caps *priv_caps = (const struct icom_priv_caps *)
+            rig->caps->priv;
+    struct icom_cmd cmds[2];
+    vfo_t curr = rig->state.current_vfo;
+    unsigned char mode_icom;
+    signed char width_icom;
+    int freq_len, subcmd, retval, i;
+
+    if (priv->x25cmdfails || priv->x26cmdfails || rig->state.cache.satmode
+            || !(rig->caps->targetable_vfo & RIG_TARGETABLE_MODE)
+            || rig->caps->rig_model == RIG_MODEL_IC7800
+            || (tx_width != RIG_PASSBAND_NOCHANGE && tx_width != RIG_PASSBAND_NORMAL))
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    if (!(tx_vfo & (RIG_VFO_A | RIG_VFO_B | RIG_VFO_MAIN | RIG_VFO_SUB))
+            || !(curr & (RIG_VFO_A | RIG_VFO_B | RIG_VFO_MAIN | RIG_VFO_SUB)))
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    if (priv_caps->r2i_mode != NULL)
+    {
+        retval = priv_caps->r2i_mode(rig, tx_vfo, tx_mode, tx_width, &mode_icom,
+                                     &width_icom);
+    }
+    else
+    {
+        retval = rig2icom_mode(rig, tx_vfo, tx_mode, tx_width, &mode_icom,
+                               &width_icom);
+    }
+
+    if (retval < 0) { return retval; }
+
+    // 0x00 is the selected VFO, 0x01 the unselected one
+    subcmd = (tx_vfo == curr) ? 0x00 : 0x01;
+
+    memset(cmds, 0, sizeof(cmds));
+    freq_len = priv->civ_731_mode ? 4 : 5;
+    cmds[0].cmd = C_SEND_SEL_FREQ;
+    cmds[0].subcmd = subcmd;
+    to_bcd(cmds[0].payload, tx_freq, freq_len * 2);
+    cmds[0].payload_len = freq_len;
+
+    cmds[1].cmd = C_SEND_SEL_MODE;
+    cmds[1].subcmd = subcmd;
+    cmds[1].payload[0] = mode_icom;
+    cmds[1].payload[1] = (tx_mode & (RIG_MODE_PKTUSB | RIG_MODE_PKTLSB
+                                     | RIG_MODE_PKTFM | RIG_MODE_PKTAM)) ? 0x01 : 0x00;
+    cmds[1].payload[2] = 1; // filter 1, as icom_set_mode_x26() does
+    cmds[1].payload_len = 3;
+
+    retval = icom_transaction_batch(rig, cmds, 2);
+
+    if (retval != RIG_OK) { return retval; }
+
+    for (i = 0; i < 2; i++)
+    {
+        if (cmds[i].retval == RIG_OK && cmds[i].reply_len == 1
+                && cmds[i].reply[0] == ACK)
+        {
+            continue;
+        }
+
+        rig_debug(RIG_DEBUG_WARN, "%s: 0x%02x rejected (%s), using the VFO path\n",
+                  __func__, cmds[i].cmd, rigerror(cmds[i].retval));
+
+        if (cmds[i].retval == -RIG_ETIMEOUT) { return cmds[i].retval; }
+
+        if (i == 0) { priv->x25cmdfails = 1; }
+        else { priv->x26cmdfails = 1; }
+
+        return -RIG_ENAVAIL;
+    }
+
+    rig_set_cache_freq(rig, tx_vfo, tx_freq);
+    rig_set_cache_mode(rig, tx_vfo, tx_mode, RIG_PASSBAND_NOCHANGE);
+
+    return RIG_OK;
+}
+
+/*
+ * icom_set_split_freq_mode_x25
+ * For rigs with 0x25/0x26: the TX VFO in one round trip, otherwise the
+ * same set_split_freq plus set_split_mode the frontend would do.
+ */
+int icom_set_split_freq_mode_x25(RIG *rig, vfo_t vfo, freq_t tx_freq,
+                                 rmode_t tx_mode, pbwidth_t tx_width)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    vfo_t tx_vfo = vfo;
+    int retval;
+
+    ENTERFUNC;
+
+    if (tx_vfo == RIG_VFO_TX || tx_vfo == RIG_VFO_CURR)
+    {
+        tx_vfo = priv->tx_vfo != RIG_VFO_NONE ? priv->tx_vfo : rig->state.tx_vfo;
+    }
+
+    retval = icom_set_split_freq_mode_batch(rig, tx_vfo, tx_freq, tx_mode,
+                                            tx_width);
+
+    if (retval != -RIG_ENAVAIL) { RETURNFUNC(retval); }
+
+    retval = rig_set_split_freq(rig, vfo, tx_freq);
+
+    if (retval == RIG_OK)
+    {
+        retval = rig_set_split_mode(rig, vfo, tx_mode, tx_width);
+    }
+
+    RETURNFUNC(retval);
+}
+
 /*
  * icom_set_split_freq_mode
  * Assumes rig!=NULL, rig->state.priv!=NULL,
@@ -6997,8 +7468,8 @@ int icom_set_func(RIG *rig, vfo_t vfo, setting_t func, int status)
         RETURNFUNC(-RIG_EINVAL);
     }
 
-    retval = icom_transaction(rig, fct_cn, fct_sc, fctbuf, fct_len, ackbuf,
-                              &ack_len);
+    retval = icom_set_transaction(rig, fct_cn, fct_sc, fctbuf, fct_len, ackbuf,
+                                  &ack_len);
 
     if (retval != RIG_OK)
     {
@@ -8616,130 +9087,228 @@ int icom_mW2power(RIG *rig, float *power, unsigned int mwpower, freq_t freq,
     RETURNFUNC(RIG_OK);
 }
 
-static int icom_parse_spectrum_frame(RIG *rig, size_t length,
-                                     const unsigned char *frame_data)
+/*
+ * icom_decode_spectrum_frame
+ *  Decodes one scope data frame, the payload after 27 00, of a rig with
+ *  the given scope caps.  Needs no rig state, so recorded frames can be
+ *  run through it, and checks everything a corrupt frame could get wrong.
+ */
+int icom_decode_spectrum_frame(const struct icom_spectrum_scope_caps *caps,
+                               size_t length, const unsigned char *frame_data,
+                               struct icom_spectrum_frame *f)
 {
-    struct rig_caps *caps = rig->caps;
-    struct icom_priv_caps *priv_caps = (struct icom_priv_caps *) caps->priv;
-    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
-    struct icom_spectrum_scope_cache *cache;
+    int data_frame_index;
 
-    int division = (int) from_bcd(frame_data + 1, 1 * 2);
-    int max_division = (int) from_bcd(frame_data + 2, 1 * 2);
+    memset(f, 0, sizeof(*f));
 
-    size_t spectrum_data_length_in_frame;
-    const unsigned char *spectrum_data_start_in_frame;
-
-    ENTERFUNC;
+    if (length < 3)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: short spectrum scope frame: %d bytes\n",
+                  __func__, (int) length);
+        return -RIG_EPROTO;
+    }
 
     // The first byte indicates spectrum scope ID/VFO: 0 = Main, 1 = Sub
-    int spectrum_id = frame_data[0];
+    f->id = frame_data[0];
+    f->division = (int) from_bcd(frame_data + 1, 1 * 2);
+    f->max_division = (int) from_bcd(frame_data + 2, 1 * 2);
 
-    if (spectrum_id >= priv->spectrum_scope_count)
+    if (f->division < 1 || f->division > f->max_division)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: invalid spectrum scope ID from CI-V frame: %d\n",
-                  __func__, spectrum_id);
-        RETURNFUNC(-RIG_EPROTO);
+        rig_debug(RIG_DEBUG_ERR, "%s: invalid spectrum scope division %d of %d\n",
+                  __func__, f->division, f->max_division);
+        return -RIG_EPROTO;
     }
 
-    cache = &priv->spectrum_scope_cache[spectrum_id];
-
-    if (division == 1)
+    if (f->division == 1)
     {
-        int spectrum_scope_mode = frame_data[3];
-        int out_of_range = frame_data[14];
+        int spectrum_scope_mode;
+        unsigned long long edge[2];
+
+        if (length < 15)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: short spectrum scope header: %d bytes\n",
+                      __func__, (int) length);
+            return -RIG_EPROTO;
+        }
 
-        cache->spectrum_mode = RIG_SPECTRUM_MODE_NONE;
+        spectrum_scope_mode = frame_data[3];
+        f->out_of_range = frame_data[14];
+
+        // center and half span, or lower and upper edge, back to back
+        from_bcd_list(frame_data + 4, 5 * 2, edge, 2);
 
         switch (spectrum_scope_mode)
         {
         case SCOPE_MODE_CENTER:
-            cache->spectrum_mode = RIG_SPECTRUM_MODE_CENTER;
-            cache->spectrum_center_freq = (freq_t) from_bcd(frame_data + 4, 5 * 2);
-            cache->spectrum_span_freq = (freq_t) from_bcd(frame_data + 9, 5 * 2) * 2;
-            cache->spectrum_low_edge_freq = cache->spectrum_center_freq -
-                                            cache->spectrum_span_freq / 2;
-            cache->spectrum_high_edge_freq = cache->spectrum_center_freq +
-                                             cache->spectrum_span_freq / 2;
+            f->mode = RIG_SPECTRUM_MODE_CENTER;
+            f->center_freq = (freq_t) edge[0];
+            f->span_freq = (freq_t) edge[1] * 2;
+            f->low_edge_freq = f->center_freq - f->span_freq / 2;
+            f->high_edge_freq = f->center_freq + f->span_freq / 2;
             break;
 
         case SCOPE_MODE_FIXED:
-            cache->spectrum_mode = RIG_SPECTRUM_MODE_FIXED;
-
         case SCOPE_MODE_SCROLL_C:
-            if (cache->spectrum_mode == RIG_SPECTRUM_MODE_NONE)
-            {
-                cache->spectrum_mode = RIG_SPECTRUM_MODE_CENTER_SCROLL;
-            }
-
         case SCOPE_MODE_SCROLL_F:
-            if (cache->spectrum_mode == RIG_SPECTRUM_MODE_NONE)
-            {
-                cache->spectrum_mode = RIG_SPECTRUM_MODE_FIXED_SCROLL;
-            }
-
-            cache->spectrum_low_edge_freq = (freq_t) from_bcd(frame_data + 4, 5 * 2);
-            cache->spectrum_high_edge_freq = (freq_t) from_bcd(frame_data + 9, 5 * 2);
-            cache->spectrum_span_freq = (cache->spectrum_high_edge_freq -
-                                         cache->spectrum_low_edge_freq);
-            cache->spectrum_center_freq = cache->spectrum_high_edge_freq -
-                                          cache->spectrum_span_freq / 2;
+            f->mode = spectrum_scope_mode == SCOPE_MODE_FIXED ? RIG_SPECTRUM_MODE_FIXED
+                      : spectrum_scope_mode == SCOPE_MODE_SCROLL_C ?
+                      RIG_SPECTRUM_MODE_CENTER_SCROLL : RIG_SPECTRUM_MODE_FIXED_SCROLL;
+            f->low_edge_freq = (freq_t) edge[0];
+            f->high_edge_freq = (freq_t) edge[1];
+            f->span_freq = f->high_edge_freq - f->low_edge_freq;
+            f->center_freq = f->high_edge_freq - f->span_freq / 2;
             break;
 
         default:
             rig_debug(RIG_DEBUG_ERR, "%s: unknown Icom spectrum scope mode: %d\n", __func__,
                       spectrum_scope_mode);
-            RETURNFUNC(-RIG_EPROTO);
+            return -RIG_EPROTO;
+        }
+
+        f->data_length = length - 15;
+        f->data = frame_data + 15;
+    }
+    else
+    {
+        f->data_length = length - 3;
+        f->data = frame_data + 3;
+    }
+
+    if (f->data_length == 0)
+    {
+        return RIG_OK;
+    }
+
+    data_frame_index = (f->max_division > 1) ? (f->division - 2) :
+                       (f->division - 1);
+
+    if (data_frame_index < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: spectrum scope data in the header frame\n",
+                  __func__);
+        return -RIG_EPROTO;
+    }
+
+    f->offset = (size_t) data_frame_index * caps->single_frame_data_length;
+
+    if (f->offset + f->data_length > caps->spectrum_line_length)
+    {
+        rig_debug(RIG_DEBUG_ERR,
+                  "%s: too much spectrum scope data received: %d bytes > %d bytes expected\n",
+                  __func__, (int)(f->offset + f->data_length),
+                  caps->spectrum_line_length);
+        return -RIG_EPROTO;
+    }
+
+    return RIG_OK;
+}
+
+static int icom_parse_spectrum_frame(RIG *rig, size_t length,
+                                     const unsigned char *frame_data)
+{
+    struct rig_caps *caps = rig->caps;
+    struct icom_priv_caps *priv_caps = (struct icom_priv_caps *) caps->priv;
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    struct icom_spectrum_scope_cache *cache;
+    struct icom_spectrum_frame f;
+    unsigned char *line_data;
+    int retval;
+
+    ENTERFUNC;
+
+    retval = icom_decode_spectrum_frame(&priv_caps->spectrum_scope_caps, length,
+                                        frame_data, &f);
+
+    if (retval != RIG_OK)
+    {
+        RETURNFUNC(retval);
+    }
+
+    if (f.id >= priv->spectrum_scope_count)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: invalid spectrum scope ID from CI-V frame: %d\n",
+                  __func__, f.id);
+        RETURNFUNC(-RIG_EPROTO);
+    }
+
+    cache = &priv->spectrum_scope_cache[f.id];
+
+    if (f.division == 1)
+    {
+        struct icom_spectrum_settings *s = &cache->settings;
+
+        cache->spectrum_mode = f.mode;
+        cache->spectrum_center_freq = f.center_freq;
+        cache->spectrum_span_freq = f.span_freq;
+        cache->spectrum_low_edge_freq = f.low_edge_freq;
+        cache->spectrum_high_edge_freq = f.high_edge_freq;
+
+        // the header tells the scope configuration for free
+        s->mode.i = f.mode;
+        s->valid |= RIG_LEVEL_SPECTRUM_MODE;
+
+        if (f.mode == RIG_SPECTRUM_MODE_CENTER
+                || f.mode == RIG_SPECTRUM_MODE_CENTER_SCROLL)
+        {
+            s->span.i = (int) f.span_freq;
+            s->valid |= RIG_LEVEL_SPECTRUM_SPAN;
+        }
+        else if (!f.out_of_range)
+        {
+            s->edge_low.i = (int) f.low_edge_freq;
+            s->edge_high.i = (int) f.high_edge_freq;
+            s->edge_range_id = 0;
+            s->valid |= ICOM_SPECTRUM_EDGES;
         }
 
-        spectrum_data_length_in_frame = length - 15;
-        spectrum_data_start_in_frame = frame_data + 15;
+        // assemble straight into a pool line the publisher can take as is
+        if (cache->pool_line)
+        {
+            spectrum_pool_put(cache->pool_line);
+            cache->pool_line = NULL;
+        }
 
-        memset(cache->spectrum_data, 0,
-               priv_caps->spectrum_scope_caps.spectrum_line_length);
+        if (priv_caps->spectrum_scope_caps.spectrum_line_length <=
+                HAMLIB_MAX_SPECTRUM_DATA)
+        {
+            cache->pool_line = spectrum_pool_get();
+        }
+
+        line_data = cache->pool_line ? cache->pool_line->data : cache->spectrum_data;
+
+        memset(line_data, 0, priv_caps->spectrum_scope_caps.spectrum_line_length);
 
         cache->spectrum_data_length = 0;
         cache->spectrum_metadata_valid = 1;
 
         rig_debug(RIG_DEBUG_TRACE,
                   "%s: Spectrum line start: id=%d division=%d max_division=%d mode=%d center=%.0f span=%.0f low_edge=%.0f high_edge=%.0f oor=%d data_length=%d\n",
-                  __func__, spectrum_id, division, max_division, spectrum_scope_mode,
+                  __func__, f.id, f.division, f.max_division, f.mode,
                   cache->spectrum_center_freq, cache->spectrum_span_freq,
-                  cache->spectrum_low_edge_freq, cache->spectrum_high_edge_freq, out_of_range,
-                  (int)spectrum_data_length_in_frame);
+                  cache->spectrum_low_edge_freq, cache->spectrum_high_edge_freq, f.out_of_range,
+                  (int) f.data_length);
     }
     else
     {
-        spectrum_data_length_in_frame = length - 3;
-        spectrum_data_start_in_frame = frame_data + 3;
+        line_data = cache->pool_line ? cache->pool_line->data : cache->spectrum_data;
     }
 
-    if (spectrum_data_length_in_frame > 0)
+    if (f.data_length > 0)
     {
-        int frame_length = priv_caps->spectrum_scope_caps.single_frame_data_length;
-        int data_frame_index = (max_division > 1) ? (division - 2) : (division - 1);
-        int offset = data_frame_index * frame_length;
-
-        if (offset + spectrum_data_length_in_frame >
-                priv_caps->spectrum_scope_caps.spectrum_line_length)
-        {
-            rig_debug(RIG_DEBUG_ERR,
-                      "%s: too much spectrum scope data received: %d bytes > %d bytes expected\n",
-                      __func__, (int)(offset + spectrum_data_length_in_frame),
-                      priv_caps->spectrum_scope_caps.spectrum_line_length);
-            RETURNFUNC(-RIG_EPROTO);
-        }
-
-        memcpy(cache->spectrum_data + offset, spectrum_data_start_in_frame,
-               spectrum_data_length_in_frame);
-        cache->spectrum_data_length = offset + spectrum_data_length_in_frame;
+        memcpy(line_data + f.offset, f.data, f.data_length);
+        cache->spectrum_data_length = f.offset + f.data_length;
     }
 
-    if (cache->spectrum_metadata_valid && division == max_division)
+    if (cache->spectrum_metadata_valid && f.division == f.max_division)
     {
-        struct rig_spectrum_line spectrum_line =
+        struct rig_spectrum_line stack_line;
+        struct rig_spectrum_line *spectrum_line = cache->pool_line ?
+                &cache->pool_line->line : &stack_line;
+
+        *spectrum_line = (struct rig_spectrum_line)
         {
-            .id = spectrum_id,
+            .id = f.id,
             .data_level_min = priv_caps->spectrum_scope_caps.data_level_min,
             .data_level_max = priv_caps->spectrum_scope_caps.data_level_max,
             .signal_strength_min = priv_caps->spectrum_scope_caps.signal_strength_min,
@@ -8750,10 +9319,16 @@ static int icom_parse_spectrum_frame(RIG *rig, size_t length,
             .low_edge_freq = cache->spectrum_low_edge_freq,
             .high_edge_freq = cache->spectrum_high_edge_freq,
             .spectrum_data_length = cache->spectrum_data_length,
-            .spectrum_data = cache->spectrum_data,
+            .spectrum_data = line_data,
         };
 
-        rig_fire_spectrum_event(rig, &spectrum_line);
+        rig_fire_spectrum_event(rig, spectrum_line);
+
+        if (cache->pool_line)
+        {
+            spectrum_pool_put(cache->pool_line);
+            cache->pool_line = NULL;
+        }
 
         cache->spectrum_metadata_valid = 0;
     }
@@ -8797,20 +9372,29 @@ int icom_process_async_frame(RIG *rig, size_t frame_length,
     case C_SND_FREQ:
     {
         // TODO: The freq length might be less than 4 or 5 bytes on older rigs!
-        // TODO: Disable cache timeout for frequency after first transceive packet once we figure out how to get active VFO reliably with transceive updates
-        // TODO: rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_FREQ, HAMLIB_CACHE_ALWAYS);
         freq_t freq = (freq_t) from_bcd(frame + 5, (priv->civ_731_mode ? 4 : 5) * 2);
         rig_fire_freq_event(rig, RIG_VFO_CURR, freq);
+        // transceive keeps the cache current, see rig_cache_push()
         rs->use_cached_freq = 1;
+        rig_cache_push(rig);
         break;
     }
 
     case C_SND_MODE:
-        // TODO: Disable cache timeout for frequency after first transceive packet once we figure out how to get active VFO reliably with transceive updates
-        // TODO: rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_MODE, HAMLIB_CACHE_ALWAYS);
         icom2rig_mode(rig, frame[5], frame[6], &mode, &width);
         rig_fire_mode_event(rig, RIG_VFO_CURR, mode, width);
         rs->use_cached_mode = 1;
+        rig_cache_push(rig);
+        break;
+
+    case C_CTL_PTT:
+        if (frame[5] == S_PTT && frame_length > 7)
+        {
+            rig_fire_ptt_event(rig, RIG_VFO_CURR, frame[6] ? RIG_PTT_ON : RIG_PTT_OFF);
+            rs->use_cached_ptt = 1;
+            rig_cache_push(rig);
+        }
+
         break;
 
     case C_CTL_SCP:
@@ -8893,6 +9477,13 @@ int icom_decode_event(RIG *rig)
         RETURNFUNC(-RIG_EPROTO);
     }
 
+    if (icom_fast_set_ack(rig, buf, frm_len))
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
+    icom_watch_mem_write(rig, buf, frm_len);
+
     if (!icom_is_async_frame(rig, frm_len, buf))
     {
         rig_debug(RIG_DEBUG_WARN, "%s: CI-V %#x called for %#x!\n", __func__,
@@ -9264,6 +9855,146 @@ static int icom_get_spectrum_vfo(RIG *rig, vfo_t vfo)
     RETURNFUNC2(0);
 }
 
+/*
+ * Scope configuration of the scope serving vfo, NULL when there is no such scope
+ * or the rig cache is turned off
+ */
+static struct icom_spectrum_settings *icom_spectrum_settings(RIG *rig,
+        vfo_t vfo)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    int id = icom_get_spectrum_vfo(rig, vfo);
+
+    if (rig->state.cache.timeout_ms == 0 || id >= priv->spectrum_scope_count)
+    {
+        return NULL;
+    }
+
+    return &priv->spectrum_scope_cache[id].settings;
+}
+
+static value_t *icom_spectrum_setting(struct icom_spectrum_settings *s,
+                                      setting_t level)
+{
+    switch (level)
+    {
+    case RIG_LEVEL_SPECTRUM_MODE: return &s->mode;
+
+    case RIG_LEVEL_SPECTRUM_SPAN: return &s->span;
+
+    case RIG_LEVEL_SPECTRUM_SPEED: return &s->speed;
+
+    case RIG_LEVEL_SPECTRUM_REF: return &s->ref;
+
+    case RIG_LEVEL_SPECTRUM_ATT: return &s->att;
+
+    case RIG_LEVEL_SPECTRUM_EDGE_LOW: return &s->edge_low;
+
+    case RIG_LEVEL_SPECTRUM_EDGE_HIGH: return &s->edge_high;
+
+    default: return NULL;
+    }
+}
+
+/*
+ * Answer a RIG_LEVEL_SPECTRUM_* read from the scope configuration cache.
+ * Fixed edges seen in data frames hold while the scope stays in a fixed mode,
+ * edges set or read hold for the edge frequency range they were set or read in.
+ */
+static int icom_get_spectrum_cache(RIG *rig, vfo_t vfo, setting_t level,
+                                   value_t *val)
+{
+    struct icom_spectrum_settings *s = icom_spectrum_settings(rig, vfo);
+    value_t *v;
+
+    if (!s || !(s->valid & level) || !(v = icom_spectrum_setting(s, level)))
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    if (level & ICOM_SPECTRUM_EDGES)
+    {
+        if (s->edge_range_id == 0)
+        {
+            if (!(s->valid & RIG_LEVEL_SPECTRUM_MODE)
+                    || (s->mode.i != RIG_SPECTRUM_MODE_FIXED
+                        && s->mode.i != RIG_SPECTRUM_MODE_FIXED_SCROLL))
+            {
+                return -RIG_ENAVAIL;
+            }
+        }
+        else
+        {
+            int range_id;
+
+            if (icom_get_spectrum_edge_frequency_range(rig, vfo, &range_id) != RIG_OK
+                    || range_id != s->edge_range_id)
+            {
+                return -RIG_ENAVAIL;
+            }
+        }
+    }
+
+    *val = *v;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: %s from cache\n", __func__,
+              rig_strlevel(level));
+
+    return RIG_OK;
+}
+
+/*
+ * Keep a RIG_LEVEL_SPECTRUM_* value set or read, range_id is the edge frequency
+ * range of the edge levels
+ */
+static void icom_set_spectrum_cache(RIG *rig, vfo_t vfo, setting_t level,
+                                    value_t val, int range_id)
+{
+    struct icom_spectrum_settings *s = icom_spectrum_settings(rig, vfo);
+    value_t *v;
+
+    if (!s || !(v = icom_spectrum_setting(s, level)))
+    {
+        return;
+    }
+
+    if ((level & ICOM_SPECTRUM_EDGES) && s->edge_range_id != range_id)
+    {
+        // the other edge belongs to another range
+        s->valid &= ~ICOM_SPECTRUM_EDGES;
+        s->edge_range_id = range_id;
+    }
+
+    if (level == RIG_LEVEL_SPECTRUM_MODE && s->edge_range_id == 0
+            && (!(s->valid & level) || s->mode.i != val.i))
+    {
+        // edges from data frames of the previous mode
+        s->valid &= ~ICOM_SPECTRUM_EDGES;
+    }
+
+    *v = val;
+    s->valid |= level;
+}
+
+/* Keep TOK_SCOPE_EDG, the cached edges go with the edge number they were seen for */
+static void icom_set_spectrum_edge_number(RIG *rig, vfo_t vfo, int edge_number)
+{
+    struct icom_spectrum_settings *s = icom_spectrum_settings(rig, vfo);
+
+    if (!s)
+    {
+        return;
+    }
+
+    if (!s->edge_number_valid || s->edge_number != edge_number)
+    {
+        s->valid &= ~ICOM_SPECTRUM_EDGES;
+    }
+
+    s->edge_number = edge_number;
+    s->edge_number_valid = 1;
+}
+
 static int icom_get_spectrum_edge_frequency_range(RIG *rig, vfo_t vfo,
         int *range_id)
 {
@@ -166,6 +166,42 @@ struct icom_spectrum_edge_frequency_range
     freq_t high_freq; /*!< The high edge frequency if the range in Hz */
 };
 
+/* CI-V mode bytes covered by the decode table in icom_priv_data */
+#define ICOM_MODE_TABLE_SIZE 0x40
+
+/* ACKs of fast sets that may be outstanding, see icom_set_transaction() */
+#define ICOM_FAST_SET_MAX 8
+
+/**
+ * \brief One decoded CI-V mode byte and passband data, see icom_mode_tables_init().
+ */
+struct icom_mode_entry
+{
+    rmode_t mode;
+    pbwidth_t width;
+};
+
+/**
+ * \brief Cached Icom spectrum scope configuration.
+ *
+ * Kept from the set and get paths and from the headers of spectrum scope data frames,
+ * so that RIG_LEVEL_SPECTRUM_* reads do not cost CI-V transactions. Reset on open.
+ */
+struct icom_spectrum_settings
+{
+    setting_t valid; /*!< RIG_LEVEL_SPECTRUM_* levels held below */
+    value_t mode; /*!< RIG_LEVEL_SPECTRUM_MODE */
+    value_t span; /*!< RIG_LEVEL_SPECTRUM_SPAN */
+    value_t speed; /*!< RIG_LEVEL_SPECTRUM_SPEED */
+    value_t ref; /*!< RIG_LEVEL_SPECTRUM_REF */
+    value_t att; /*!< RIG_LEVEL_SPECTRUM_ATT */
+    value_t edge_low; /*!< RIG_LEVEL_SPECTRUM_EDGE_LOW */
+    value_t edge_high; /*!< RIG_LEVEL_SPECTRUM_EDGE_HIGH */
+    int edge_range_id; /*!< Edge frequency range the edges belong to, 0 if they came from a fixed mode data frame */
+    int edge_number_valid; /*!< Boolean value telling edge_number is known */
+    int edge_number; /*!< TOK_SCOPE_EDG, the edges are always those of this edge number */
+};
+
 /**
  * \brief Cached Icom spectrum scope data.
  *
@@ -183,6 +219,27 @@ struct icom_spectrum_scope_cache
     freq_t spectrum_high_edge_freq; /*!< The high edge frequency of the current spectrum scope line being received */
     size_t spectrum_data_length;     /*!< Number of bytes of 8-bit spectrum data in the data buffer. The amount of data may vary if the rig has multiple spectrum scopes, depending on the scope. */
     unsigned char *spectrum_data; /*!< Dynamically allocated buffer for raw spectrum data */
+    struct spectrum_pool_line *pool_line; /*!< Pool buffer the current line is assembled in, NULL to use spectrum_data */
+    struct icom_spectrum_settings settings; /*!< Scope configuration, see icom_spectrum_settings */
+};
+
+/**
+ * \brief One spectrum scope data frame decoded by icom_decode_spectrum_frame().
+ */
+struct icom_spectrum_frame
+{
+    int id; /*!< Spectrum scope ID, 0 = Main, 1 = Sub */
+    int division; /*!< Number of this frame in the line, from 1 */
+    int max_division; /*!< Number of frames in the line */
+    enum rig_spectrum_mode_e mode; /*!< Division 1 only: the line's spectrum mode */
+    freq_t center_freq; /*!< Division 1 only */
+    freq_t span_freq; /*!< Division 1 only */
+    freq_t low_edge_freq; /*!< Division 1 only */
+    freq_t high_edge_freq; /*!< Division 1 only */
+    int out_of_range; /*!< Division 1 only: the rig flags the edges out of range */
+    const unsigned char *data; /*!< This frame's part of the line, in the frame */
+    size_t data_length; /*!< Bytes at data */
+    size_t offset; /*!< Where data goes in the line */
 };
 
 struct icom_priv_caps
@@ -267,6 +324,22 @@ struct icom_priv_data
     struct icom_spectrum_scope_cache spectrum_scope_cache[HAMLIB_MAX_SPECTRUM_SCOPES]; /*!< Cached Icom spectrum scope data used during reception of the data. The array index must match the scope ID. */
     freq_t other_freq; /*!< Our other freq depending on which vfo is selected */
     int vfo_flag; // used to skip vfo check when frequencies are equal
+    int shared_bus; /*!< Share the port with other rigs on the same CI-V bus */
+    struct icom_bus *bus; /*!< The shared bus once open, see frame.c */
+    char lan_user[17]; /*!< Icom LAN login, empty for a plain serial or UDP port */
+    char lan_password[17];
+    struct icom_lan *lan; /*!< The LAN streams once logged in, see icomlan.c */
+    int mode_tables; /*!< The mode tables below have been built by icom_mode_tables_init() */
+    unsigned char mode_to_civ[64]; /*!< CI-V mode byte by rmode_t bit, 0xff if unsupported */
+    pbwidth_t mode_normal[64]; /*!< rig_passband_normal() by rmode_t bit */
+    struct icom_mode_entry civ_to_mode[ICOM_MODE_TABLE_SIZE][4]; /*!< icom2rig_mode() result by mode byte and passband data -1, 1, 2, 3 */
+    int fast_set; /*!< Don't wait for the ACK of set freq/mode/level/func, see icom_set_transaction() */
+    int fast_cmd[ICOM_FAST_SET_MAX]; /*!< cmd << 8 | subcmd of the fast sets still to be ACKed, oldest at fast_head */
+    int fast_head;
+    int fast_pending;
+    struct timespec fast_time; /*!< When the last fast set went out */
+    int fast_bulk; /*!< icom_set_bulk() is running, its sets go the fast way */
+    int fast_naks; /*!< Fast sets refused so far */
 };
 
 extern const struct ts_sc_list r8500_ts_sc_list[];
@@ -326,6 +399,8 @@ int icom_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *tx_mode,
                         pbwidth_t *tx_width);
 int icom_set_split_freq_mode(RIG *rig, vfo_t vfo, freq_t tx_freq,
                              rmode_t tx_mode, pbwidth_t tx_width);
+int icom_set_split_freq_mode_x25(RIG *rig, vfo_t vfo, freq_t tx_freq,
+                                 rmode_t tx_mode, pbwidth_t tx_width);
 int icom_get_split_freq_mode(RIG *rig, vfo_t vfo, freq_t *tx_freq,
                              rmode_t *tx_mode, pbwidth_t *tx_width);
 int icom_set_split_vfo(RIG *rig, vfo_t vfo, split_t split, vfo_t tx_vfo);
@@ -335,6 +410,9 @@ int icom_set_ts(RIG *rig, vfo_t vfo, shortfreq_t ts);
 int icom_get_ts(RIG *rig, vfo_t vfo, shortfreq_t *ts);
 int icom_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt);
 int icom_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt);
+int icom_get_bulk(RIG *rig, struct rig_bulk *bulk);
+int icom_set_bulk(RIG *rig, vfo_t vfo, struct rig_setting *settings,
+                  int count);
 int icom_get_dcd(RIG *rig, vfo_t vfo, dcd_t *dcd);
 int icom_set_ctcss_tone(RIG *rig, vfo_t vfo, tone_t tone);
 int icom_get_ctcss_tone(RIG *rig, vfo_t vfo, tone_t *tone);
@@ -400,6 +478,9 @@ int icom_get_custom_parm_time(RIG *rig, int parmbuflen, unsigned char *parmbuf,
 int icom_get_freq_range(RIG *rig);
 int icom_is_async_frame(RIG *rig, size_t frame_length, const unsigned char *frame);
 int icom_process_async_frame(RIG *rig, size_t frame_length, const unsigned char *frame);
+int icom_decode_spectrum_frame(const struct icom_spectrum_scope_caps *caps,
+                               size_t length, const unsigned char *frame_data,
+                               struct icom_spectrum_frame *f);
 int icom_read_frame_direct(RIG *rig, size_t buffer_length, const unsigned char *buffer);
 
 extern const struct confparams icom_cfg_params[];
@@ -0,0 +1,1121 @@
+/*
+ *  Hamlib CI-V backend - Icom LAN (RS-BA1) transport
+ *  Copyright (c) 2026 by the Hamlib group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The IC-705, IC-7610, IC-9700, IC-R8600 and friends speak CI-V over UDP
+ * the way RS-BA1 does.  The control stream, usually on port 50001, logs in
+ * and asks for a CI-V stream on a second port, usually 50002.  Both
+ * streams number their packets, answer pings, send idle packets to stay
+ * alive and resend whatever the other side reports lost.  The layout used
+ * here follows the wfview reverse engineering of the protocol.
+ *
+ * icom_lan_open() does the handshake on the UDP socket rig_open() made
+ * for rigport, then hands rigport one end of a local stream socket and
+ * keeps the other end for a thread that runs both streams.  CI-V frames
+ * the radio sends come out of rigport as if from a serial line, and
+ * frames written to rigport go out as CI-V data packets, so icom.c and
+ * the demultiplexer in frame.c work unchanged.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/time.h>
+#include <sys/types.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#ifdef HAVE_NETINET_IN_H
+#include <netinet/in.h>
+#endif
+
+#if defined (HAVE_SYS_SOCKET_H)
+#include <sys/socket.h>
+#elif HAVE_WS2TCPIP_H
+#include <ws2tcpip.h>
+#endif
+
+#include "hamlib/rig.h"
+#include "misc.h"
+#include "iofunc.h"
+#include "icom.h"
+#include "icom_defs.h"
+#include "frame.h"
+
+#if defined(HAVE_PTHREAD) && defined(HAVE_SYS_SOCKET_H) && !defined(_WIN32)
+
+#define LAN_PKT_MAX         1500
+#define LAN_TX_HISTORY      64      /* packets kept for resending */
+#define LAN_RX_HISTORY      64      /* sequence numbers kept to drop repeats */
+#define LAN_IDLE_MS         100     /* longest silence on a stream */
+#define LAN_PING_MS         500
+#define LAN_TOKEN_MS        60000   /* token renewal */
+#define LAN_WATCHDOG_MS     5000    /* radio silent this long is gone */
+#define LAN_HANDSHAKE_MS    2000    /* per handshake step */
+
+/* packet types */
+#define LAN_T_DATA          0x00    /* idle packets too */
+#define LAN_T_RETRANSMIT    0x01
+#define LAN_T_ARE_YOU_THERE 0x03
+#define LAN_T_I_AM_HERE     0x04
+#define LAN_T_DISCONNECT    0x05
+#define LAN_T_READY         0x06
+#define LAN_T_PING          0x07
+
+/* lengths of the packets with a fixed layout */
+#define LAN_LEN_CONTROL     0x10
+#define LAN_LEN_PING        0x15
+#define LAN_LEN_OPENCLOSE   0x16
+#define LAN_LEN_TOKEN       0x40
+#define LAN_LEN_STATUS      0x50
+#define LAN_LEN_LOGIN_REPLY 0x60
+#define LAN_LEN_LOGIN       0x80
+#define LAN_LEN_CONNINFO    0x90
+#define LAN_LEN_CAP         0x42    /* plus LAN_LEN_RADIO_CAP per radio */
+#define LAN_LEN_RADIO_CAP   0x66
+#define LAN_CIV_HDR         0x15
+
+/* requesttype of the login family of packets */
+#define LAN_REQ_LOGIN       0x00
+#define LAN_REQ_TOKEN_DEL   0x01
+#define LAN_REQ_TOKEN_ACK   0x02
+#define LAN_REQ_STREAM      0x03
+#define LAN_REQ_TOKEN_RENEW 0x05
+
+struct icom_lan_stream
+{
+    const char *name;
+    int fd;
+    uint32_t my_id;
+    uint32_t remote_id;
+    uint16_t seq;               /* next tracked sequence number */
+    uint16_t ping_seq;
+    int rx_started;
+    uint16_t rx_next;           /* next sequence number expected */
+    uint16_t rx_seen[LAN_RX_HISTORY];
+    int rx_seen_count;
+    struct
+    {
+        int len;
+        uint16_t seq;
+        unsigned char data[LAN_PKT_MAX];
+    } tx[LAN_TX_HISTORY];
+    struct timespec last_tx;
+    struct timespec last_rx;
+    struct timespec last_ping;
+};
+
+struct icom_lan
+{
+    struct icom_lan_stream ctrl;
+    struct icom_lan_stream civ;
+    int app_fd;                 /* our end of the stream socket rigport uses */
+    uint16_t auth_seq;
+    uint16_t tok_request;
+    uint32_t token;
+    uint16_t civ_seq;           /* CI-V payload counter, separate from seq */
+    unsigned char guid[16];
+    char radio_name[33];
+    unsigned char radio_civ;
+    unsigned char out[LAN_PKT_MAX]; /* bytes from rigport not yet framed */
+    int out_len;
+    struct timespec last_token;
+    pthread_t thread;
+    volatile int running;
+};
+
+/*
+ * The radio wants user name and password scrambled with this table,
+ * indexed by character plus position
+ */
+static const unsigned char icom_lan_passcode[128] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0x47, 0x5d, 0x4c, 0x42, 0x66, 0x20, 0x23, 0x46, 0x4e, 0x57, 0x45, 0x3d,
+    0x67, 0x76, 0x60, 0x41, 0x62, 0x39, 0x59, 0x2d, 0x68, 0x7e, 0x7c, 0x65,
+    0x7d, 0x49, 0x29, 0x72, 0x73, 0x78, 0x21, 0x6e, 0x5a, 0x5e, 0x4a, 0x3e,
+    0x71, 0x2c, 0x2a, 0x54, 0x3c, 0x3a, 0x63, 0x4f, 0x43, 0x75, 0x27, 0x79,
+    0x5b, 0x35, 0x70, 0x48, 0x6b, 0x56, 0x6f, 0x34, 0x32, 0x6c, 0x30, 0x61,
+    0x6d, 0x7b, 0x2f, 0x4b, 0x64, 0x38, 0x2b, 0x2e, 0x50, 0x40, 0x3f, 0x55,
+    0x33, 0x37, 0x25, 0x77, 0x24, 0x26, 0x74, 0x6a, 0x28, 0x53, 0x4d, 0x69,
+    0x22, 0x5c, 0x44, 0x31, 0x36, 0x58, 0x3b, 0x7a, 0x51, 0x5f, 0x52, 0
+};
+
+static void icom_lan_encode(unsigned char out[16], const char *in)
+{
+    int i;
+
+    memset(out, 0, 16);
+
+    for (i = 0; i < 16 && in[i]; i++)
+    {
+        int p = (unsigned char) in[i] + i;
+
+        if (p > 126)
+        {
+            p = 32 + p % 127;
+        }
+
+        out[i] = icom_lan_passcode[p];
+    }
+}
+
+static void put16le(unsigned char *p, uint16_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = v >> 8;
+}
+
+static void put32le(unsigned char *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = v >> 24;
+}
+
+static void put16be(unsigned char *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xff;
+}
+
+static uint16_t get16le(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32le(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint16_t get16be(const unsigned char *p)
+{
+    return (p[0] << 8) | p[1];
+}
+
+/* common header: length, type, sequence and both ids */
+static void icom_lan_header(struct icom_lan_stream *s, unsigned char *pkt,
+                            int len, uint16_t type, uint16_t seq)
+{
+    memset(pkt, 0, len);
+    put32le(pkt, len);
+    put16le(pkt + 4, type);
+    put16le(pkt + 6, seq);
+    put32le(pkt + 8, s->my_id);
+    put32le(pkt + 12, s->remote_id);
+}
+
+static int icom_lan_send_raw(struct icom_lan_stream *s,
+                             const unsigned char *pkt, int len)
+{
+    if (send(s->fd, pkt, len, 0) != len)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s: %s\n", __func__, s->name, strerror(errno));
+        return -RIG_EIO;
+    }
+
+    elapsed_ms(&s->last_tx, HAMLIB_ELAPSED_SET);
+
+    return RIG_OK;
+}
+
+/* send pkt with the next sequence number, keeping it for resending */
+static int icom_lan_send_tracked(struct icom_lan_stream *s,
+                                 unsigned char *pkt, int len)
+{
+    int slot = s->seq % LAN_TX_HISTORY;
+
+    put16le(pkt + 6, s->seq);
+
+    if (len <= LAN_PKT_MAX)
+    {
+        memcpy(s->tx[slot].data, pkt, len);
+        s->tx[slot].len = len;
+        s->tx[slot].seq = s->seq;
+    }
+
+    s->seq++;
+
+    return icom_lan_send_raw(s, pkt, len);
+}
+
+static int icom_lan_send_control(struct icom_lan_stream *s, uint16_t type,
+                                 uint16_t seq)
+{
+    unsigned char pkt[LAN_LEN_CONTROL];
+
+    icom_lan_header(s, pkt, sizeof(pkt), type, seq);
+
+    return icom_lan_send_raw(s, pkt, sizeof(pkt));
+}
+
+static int icom_lan_send_idle(struct icom_lan_stream *s)
+{
+    unsigned char pkt[LAN_LEN_CONTROL];
+
+    icom_lan_header(s, pkt, sizeof(pkt), LAN_T_DATA, 0);
+
+    return icom_lan_send_tracked(s, pkt, sizeof(pkt));
+}
+
+static int icom_lan_send_ping(struct icom_lan_stream *s)
+{
+    unsigned char pkt[LAN_LEN_PING];
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+    icom_lan_header(s, pkt, sizeof(pkt), LAN_T_PING, s->ping_seq++);
+    pkt[0x10] = 0x00;
+    put32le(pkt + 0x11, (uint32_t)(now.tv_sec * 1000 + now.tv_usec / 1000));
+    elapsed_ms(&s->last_ping, HAMLIB_ELAPSED_SET);
+
+    return icom_lan_send_raw(s, pkt, sizeof(pkt));
+}
+
+/*
+ * Packets of the login family: header, then payload size, request kind,
+ * a sequence of their own and the token
+ */
+static void icom_lan_auth_header(struct icom_lan *lan, unsigned char *pkt,
+                                 int len, uint8_t reqtype)
+{
+    icom_lan_header(&lan->ctrl, pkt, len, LAN_T_DATA, 0);
+    put16be(pkt + 0x12, len - 0x10);
+    pkt[0x14] = 0x01;
+    pkt[0x15] = reqtype;
+    put16be(pkt + 0x16, lan->auth_seq++);
+    put16le(pkt + 0x1a, lan->tok_request);
+    put32le(pkt + 0x1c, lan->token);
+}
+
+static int icom_lan_send_token(struct icom_lan *lan, uint8_t reqtype)
+{
+    unsigned char pkt[LAN_LEN_TOKEN];
+
+    icom_lan_auth_header(lan, pkt, sizeof(pkt), reqtype);
+    put16le(pkt + 0x20, 0x0798);
+    elapsed_ms(&lan->last_token, HAMLIB_ELAPSED_SET);
+
+    return icom_lan_send_tracked(&lan->ctrl, pkt, sizeof(pkt));
+}
+
+static int icom_lan_send_civ(struct icom_lan *lan, const unsigned char *frame,
+                             int len)
+{
+    unsigned char pkt[LAN_PKT_MAX];
+
+    if (len > LAN_PKT_MAX - LAN_CIV_HDR)
+    {
+        return -RIG_EINVAL;
+    }
+
+    icom_lan_header(&lan->civ, pkt, LAN_CIV_HDR + len, LAN_T_DATA, 0);
+    pkt[0x10] = 0xc1;
+    put16le(pkt + 0x11, len);
+    put16be(pkt + 0x13, lan->civ_seq++);
+    memcpy(pkt + LAN_CIV_HDR, frame, len);
+
+    return icom_lan_send_tracked(&lan->civ, pkt, LAN_CIV_HDR + len);
+}
+
+static int icom_lan_send_openclose(struct icom_lan *lan, int open)
+{
+    unsigned char pkt[LAN_LEN_OPENCLOSE];
+
+    icom_lan_header(&lan->civ, pkt, sizeof(pkt), LAN_T_DATA, 0);
+    put16le(pkt + 0x10, 0x01c0);
+    put16be(pkt + 0x13, lan->civ_seq++);
+    pkt[0x15] = open ? 0x04 : 0x00;
+
+    return icom_lan_send_tracked(&lan->civ, pkt, sizeof(pkt));
+}
+
+/* wait up to ms for a packet, 0 on timeout */
+static int icom_lan_recv(struct icom_lan_stream *s, unsigned char *pkt,
+                         int size, int ms)
+{
+    fd_set rfds;
+    struct timeval tv;
+    int len;
+
+    FD_ZERO(&rfds);
+    FD_SET(s->fd, &rfds);
+    tv.tv_sec = ms / 1000;
+    tv.tv_usec = (ms % 1000) * 1000;
+
+    if (select(s->fd + 1, &rfds, NULL, NULL, &tv) <= 0)
+    {
+        return 0;
+    }
+
+    len = recv(s->fd, pkt, size, 0);
+
+    if (len < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s: %s\n", __func__, s->name, strerror(errno));
+        return -RIG_EIO;
+    }
+
+    if (len < LAN_LEN_CONTROL || (int) get32le(pkt) != len)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: %s: dropping %d byte runt\n", __func__,
+                  s->name, len);
+        return 0;
+    }
+
+    elapsed_ms(&s->last_rx, HAMLIB_ELAPSED_SET);
+
+    return len;
+}
+
+/* resend a packet the radio asked for, or an idle one in its place */
+static void icom_lan_resend(struct icom_lan_stream *s, uint16_t seq)
+{
+    int slot = seq % LAN_TX_HISTORY;
+
+    if (s->tx[slot].len > 0 && s->tx[slot].seq == seq)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: %s: resending %u\n", __func__, s->name, seq);
+        icom_lan_send_raw(s, s->tx[slot].data, s->tx[slot].len);
+    }
+    else
+    {
+        unsigned char pkt[LAN_LEN_CONTROL];
+
+        icom_lan_header(s, pkt, sizeof(pkt), LAN_T_DATA, seq);
+        icom_lan_send_raw(s, pkt, sizeof(pkt));
+    }
+}
+
+/*
+ * Handling every stream needs: pings, resend requests and the sequence
+ * numbers of incoming packets.  Returns 1 if the packet is dealt with,
+ * 0 if its content is for the caller, -1 for a repeat to drop.
+ */
+static int icom_lan_common(struct icom_lan_stream *s, unsigned char *pkt,
+                           int len)
+{
+    uint16_t type = get16le(pkt + 4);
+    uint16_t seq = get16le(pkt + 6);
+    int i;
+
+    if (type == LAN_T_PING && len == LAN_LEN_PING)
+    {
+        if (pkt[0x10] == 0x00)
+        {
+            /* the radio's ping, answered with its own sequence and time */
+            unsigned char reply[LAN_LEN_PING];
+
+            memcpy(reply, pkt, sizeof(reply));
+            put32le(reply + 8, s->my_id);
+            put32le(reply + 12, s->remote_id);
+            reply[0x10] = 0x01;
+            icom_lan_send_raw(s, reply, sizeof(reply));
+        }
+
+        return 1;
+    }
+
+    if (type == LAN_T_RETRANSMIT)
+    {
+        if (len == LAN_LEN_CONTROL)
+        {
+            icom_lan_resend(s, seq);
+        }
+        else
+        {
+            for (i = LAN_LEN_CONTROL; i + 1 < len; i += 2)
+            {
+                icom_lan_resend(s, get16le(pkt + i));
+            }
+        }
+
+        return 1;
+    }
+
+    if (type != LAN_T_DATA)
+    {
+        return 0;
+    }
+
+    for (i = 0; i < s->rx_seen_count; i++)
+    {
+        if (s->rx_seen[i] == seq)
+        {
+            return -1;
+        }
+    }
+
+    s->rx_seen[s->rx_seen_count % LAN_RX_HISTORY] = seq;
+
+    if (s->rx_seen_count < LAN_RX_HISTORY)
+    {
+        s->rx_seen_count++;
+    }
+
+    if (s->rx_started)
+    {
+        uint16_t gap = seq - s->rx_next;
+
+        /* ask for what went missing, unless it looks like a restart */
+        if (gap > 0 && gap < 16)
+        {
+            uint16_t missing;
+
+            for (missing = s->rx_next; missing != seq; missing++)
+            {
+                rig_debug(RIG_DEBUG_TRACE, "%s: %s: asking again for %u\n", __func__,
+                          s->name, missing);
+                icom_lan_send_control(s, LAN_T_RETRANSMIT, missing);
+            }
+        }
+
+        if (gap < 0x8000)
+        {
+            s->rx_next = seq + 1;
+        }
+    }
+    else
+    {
+        s->rx_started = 1;
+        s->rx_next = seq + 1;
+    }
+
+    return 0;
+}
+
+/*
+ * "Are you there", "I am here", "are you ready", "I am ready": learns the
+ * radio's id for the stream
+ */
+static int icom_lan_connect(struct icom_lan_stream *s)
+{
+    unsigned char pkt[LAN_PKT_MAX];
+    int attempt;
+    int len;
+
+    for (attempt = 0; attempt < 3; attempt++)
+    {
+        struct timespec start;
+
+        icom_lan_send_control(s, LAN_T_ARE_YOU_THERE, 0);
+        elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+        while (elapsed_ms(&start, HAMLIB_ELAPSED_GET) < LAN_HANDSHAKE_MS / 2)
+        {
+            len = icom_lan_recv(s, pkt, sizeof(pkt), 100);
+
+            if (len < 0)
+            {
+                return len;
+            }
+
+            if (len == LAN_LEN_CONTROL && get16le(pkt + 4) == LAN_T_I_AM_HERE)
+            {
+                s->remote_id = get32le(pkt + 8);
+                goto here;
+            }
+        }
+    }
+
+    rig_debug(RIG_DEBUG_ERR, "%s: %s: no answer from the radio\n", __func__,
+              s->name);
+    return -RIG_ETIMEOUT;
+
+here:
+    icom_lan_send_control(s, LAN_T_READY, 1);
+    s->seq = 1;
+
+    for (attempt = 0; attempt < LAN_HANDSHAKE_MS / 100; attempt++)
+    {
+        len = icom_lan_recv(s, pkt, sizeof(pkt), 100);
+
+        if (len < 0)
+        {
+            return len;
+        }
+
+        if (len == LAN_LEN_CONTROL && get16le(pkt + 4) == LAN_T_READY)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: %s: radio id %08x\n", __func__,
+                      s->name, s->remote_id);
+            return RIG_OK;
+        }
+    }
+
+    rig_debug(RIG_DEBUG_ERR, "%s: %s: radio not ready\n", __func__, s->name);
+    return -RIG_ETIMEOUT;
+}
+
+/*
+ * Wait on the control stream for a login family packet of length want,
+ * or for the capabilities packet, whose length depends on the radio count
+ */
+static int icom_lan_wait(struct icom_lan *lan, unsigned char *pkt, int size,
+                         int want)
+{
+    struct timespec start;
+    int len;
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+    while (elapsed_ms(&start, HAMLIB_ELAPSED_GET) < LAN_HANDSHAKE_MS)
+    {
+        len = icom_lan_recv(&lan->ctrl, pkt, size, 100);
+
+        if (len < 0)
+        {
+            return len;
+        }
+
+        if (len == 0 || icom_lan_common(&lan->ctrl, pkt, len) != 0)
+        {
+            continue;
+        }
+
+        if (want == LAN_LEN_CAP ? len >= LAN_LEN_CAP + LAN_LEN_RADIO_CAP
+                && (len - LAN_LEN_CAP) % LAN_LEN_RADIO_CAP == 0 : len == want)
+        {
+            return len;
+        }
+    }
+
+    rig_debug(RIG_DEBUG_ERR, "%s: no %#x byte packet from the radio\n", __func__,
+              want);
+    return -RIG_ETIMEOUT;
+}
+
+static int icom_lan_login(struct icom_lan *lan, const char *user,
+                          const char *password)
+{
+    unsigned char pkt[LAN_PKT_MAX];
+    char host[64] = "hamlib";
+    int len;
+    uint32_t error;
+
+    lan->tok_request = (uint16_t) rand();
+
+    icom_lan_auth_header(lan, pkt, LAN_LEN_LOGIN, LAN_REQ_LOGIN);
+    icom_lan_encode(pkt + 0x40, user);
+    icom_lan_encode(pkt + 0x50, password);
+    gethostname(host, sizeof(host) - 1);
+    /* the name field is 16 bytes, NUL terminated */
+    snprintf((char *) pkt + 0x60, 16, "%.15s", host);
+
+    if (icom_lan_send_tracked(&lan->ctrl, pkt, LAN_LEN_LOGIN) != RIG_OK)
+    {
+        return -RIG_EIO;
+    }
+
+    len = icom_lan_wait(lan, pkt, sizeof(pkt), LAN_LEN_LOGIN_REPLY);
+
+    if (len < 0)
+    {
+        return len;
+    }
+
+    error = get32le(pkt + 0x30);
+
+    if (error == 0xfeffffff)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: radio rejected user %s\n", __func__, user);
+        return -RIG_ESECURITY;
+    }
+
+    lan->token = get32le(pkt + 0x1c);
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: logged in as %s, connection '%.16s'\n",
+              __func__, user, (char *) pkt + 0x40);
+
+    if (icom_lan_send_token(lan, LAN_REQ_TOKEN_ACK) != RIG_OK)
+    {
+        return -RIG_EIO;
+    }
+
+    /* what the radio can do, with the guid the stream request quotes */
+    len = icom_lan_wait(lan, pkt, sizeof(pkt), LAN_LEN_CAP);
+
+    if (len < 0)
+    {
+        return len;
+    }
+
+    memcpy(lan->guid, pkt + LAN_LEN_CAP, sizeof(lan->guid));
+    memcpy(lan->radio_name, pkt + LAN_LEN_CAP + 0x10, 32);
+    lan->radio_name[32] = '\0';
+    lan->radio_civ = pkt[LAN_LEN_CAP + 0x52];
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: radio '%s', CI-V address %#x\n", __func__,
+              lan->radio_name, lan->radio_civ);
+
+    return RIG_OK;
+}
+
+/* ask for the CI-V stream, returns the radio's port for it */
+static int icom_lan_request_stream(struct icom_lan *lan, const char *user,
+                                   int local_port)
+{
+    unsigned char pkt[LAN_PKT_MAX];
+    int len;
+
+    icom_lan_auth_header(lan, pkt, LAN_LEN_CONNINFO, LAN_REQ_STREAM);
+    memcpy(pkt + 0x20, lan->guid, sizeof(lan->guid));
+    memcpy(pkt + 0x40, lan->radio_name, 32);
+    icom_lan_encode(pkt + 0x60, user);
+    pkt[0x70] = 0x00;           /* no audio */
+    pkt[0x71] = 0x00;
+    pkt[0x72] = 0x04;           /* codecs, in case it wants them anyway */
+    pkt[0x73] = 0x04;
+    put32le(pkt + 0x74, 0);
+    put32le(pkt + 0x78, 0);
+    put32le(pkt + 0x7c, 0);
+    put16be(pkt + 0x7e, local_port);
+    put32le(pkt + 0x84, 150);
+    pkt[0x88] = 0x01;
+
+    if (icom_lan_send_tracked(&lan->ctrl, pkt, LAN_LEN_CONNINFO) != RIG_OK)
+    {
+        return -RIG_EIO;
+    }
+
+    len = icom_lan_wait(lan, pkt, sizeof(pkt), LAN_LEN_STATUS);
+
+    if (len < 0)
+    {
+        return len;
+    }
+
+    if (get32le(pkt + 0x30) == 0xffffffff)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: radio refused the CI-V stream, busy?\n",
+                  __func__);
+        return -RIG_EIO;
+    }
+
+    return get16be(pkt + 0x42);
+}
+
+/*
+ * Cut whole CI-V frames out of buf: skip anything before a preamble and
+ * send every frame ending in 0xfd, keeping an unfinished one
+ */
+static int icom_lan_frames(const unsigned char *buf, int len,
+                           int (*deliver)(struct icom_lan *, const unsigned char *, int),
+                           struct icom_lan *lan)
+{
+    int start = 0;
+    int i;
+
+    while (start < len)
+    {
+        while (start < len && buf[start] != PR)
+        {
+            start++;
+        }
+
+        for (i = start; i < len && buf[i] != FI; i++) {}
+
+        if (i == len)
+        {
+            break;
+        }
+
+        deliver(lan, buf + start, i + 1 - start);
+        start = i + 1;
+    }
+
+    return start;
+}
+
+static int icom_lan_to_rig(struct icom_lan *lan, const unsigned char *frame,
+                           int len)
+{
+    return icom_lan_send_civ(lan, frame, len);
+}
+
+static int icom_lan_to_app(struct icom_lan *lan, const unsigned char *frame,
+                           int len)
+{
+    return send(lan->app_fd, frame, len, 0) == len ? RIG_OK : -RIG_EIO;
+}
+
+static void icom_lan_ctrl_packet(struct icom_lan *lan, unsigned char *pkt,
+                                 int len)
+{
+    if (icom_lan_common(&lan->ctrl, pkt, len) != 0)
+    {
+        return;
+    }
+
+    if (get16le(pkt + 4) == LAN_T_DISCONNECT)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: radio closed the connection\n", __func__);
+        lan->running = 0;
+    }
+    else if (len == LAN_LEN_TOKEN && get32le(pkt + 0x30) == 0xffffffff)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: token renewal refused\n", __func__);
+    }
+}
+
+static void icom_lan_civ_packet(struct icom_lan *lan, unsigned char *pkt,
+                                int len)
+{
+    int datalen;
+
+    if (icom_lan_common(&lan->civ, pkt, len) != 0)
+    {
+        return;
+    }
+
+    if (get16le(pkt + 4) == LAN_T_DISCONNECT)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: radio closed the CI-V stream\n", __func__);
+        lan->running = 0;
+        return;
+    }
+
+    if (len <= LAN_CIV_HDR || pkt[0x10] != 0xc1)
+    {
+        return;
+    }
+
+    datalen = get16le(pkt + 0x11);
+
+    if (datalen > len - LAN_CIV_HDR)
+    {
+        datalen = len - LAN_CIV_HDR;
+    }
+
+    /* frames never straddle packets, a partial one is dropped */
+    icom_lan_frames(pkt + LAN_CIV_HDR, datalen, icom_lan_to_app, lan);
+}
+
+static void icom_lan_timers(struct icom_lan *lan, struct icom_lan_stream *s)
+{
+    if (elapsed_ms(&s->last_ping, HAMLIB_ELAPSED_GET) >= LAN_PING_MS)
+    {
+        icom_lan_send_ping(s);
+    }
+
+    if (elapsed_ms(&s->last_tx, HAMLIB_ELAPSED_GET) >= LAN_IDLE_MS)
+    {
+        icom_lan_send_idle(s);
+    }
+
+    if (elapsed_ms(&s->last_rx, HAMLIB_ELAPSED_GET) >= LAN_WATCHDOG_MS)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s: radio silent for %d ms\n", __func__,
+                  s->name, LAN_WATCHDOG_MS);
+        lan->running = 0;
+    }
+}
+
+static void *icom_lan_thread(void *arg)
+{
+    struct icom_lan *lan = arg;
+    unsigned char pkt[LAN_PKT_MAX];
+
+    while (lan->running)
+    {
+        fd_set rfds;
+        struct timeval tv = { 0, 20 * 1000 };
+        int maxfd = lan->app_fd;
+        int len;
+
+        FD_ZERO(&rfds);
+        FD_SET(lan->ctrl.fd, &rfds);
+        FD_SET(lan->civ.fd, &rfds);
+        FD_SET(lan->app_fd, &rfds);
+
+        if (lan->ctrl.fd > maxfd) { maxfd = lan->ctrl.fd; }
+
+        if (lan->civ.fd > maxfd) { maxfd = lan->civ.fd; }
+
+        if (select(maxfd + 1, &rfds, NULL, NULL, &tv) < 0 && errno != EINTR)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: select: %s\n", __func__, strerror(errno));
+            break;
+        }
+
+        if (FD_ISSET(lan->ctrl.fd, &rfds)
+                && (len = icom_lan_recv(&lan->ctrl, pkt, sizeof(pkt), 0)) > 0)
+        {
+            icom_lan_ctrl_packet(lan, pkt, len);
+        }
+
+        if (FD_ISSET(lan->civ.fd, &rfds)
+                && (len = icom_lan_recv(&lan->civ, pkt, sizeof(pkt), 0)) > 0)
+        {
+            icom_lan_civ_packet(lan, pkt, len);
+        }
+
+        if (FD_ISSET(lan->app_fd, &rfds))
+        {
+            int used;
+
+            len = recv(lan->app_fd, lan->out + lan->out_len,
+                       sizeof(lan->out) - lan->out_len, 0);
+
+            if (len <= 0)
+            {
+                /* rigport closed */
+                break;
+            }
+
+            lan->out_len += len;
+            used = icom_lan_frames(lan->out, lan->out_len, icom_lan_to_rig, lan);
+
+            if (used == 0 && lan->out_len == sizeof(lan->out))
+            {
+                /* no end of frame in a whole buffer, garbage */
+                used = lan->out_len;
+            }
+
+            memmove(lan->out, lan->out + used, lan->out_len - used);
+            lan->out_len -= used;
+        }
+
+        icom_lan_timers(lan, &lan->ctrl);
+        icom_lan_timers(lan, &lan->civ);
+
+        if (elapsed_ms(&lan->last_token, HAMLIB_ELAPSED_GET) >= LAN_TOKEN_MS)
+        {
+            icom_lan_send_token(lan, LAN_REQ_TOKEN_RENEW);
+        }
+    }
+
+    /* rigport reads now see end of file instead of waiting for the timeout */
+    shutdown(lan->app_fd, SHUT_RDWR);
+    lan->running = 0;
+
+    return NULL;
+}
+
+static void icom_lan_free(struct icom_lan *lan)
+{
+    if (lan->civ.fd > 0) { close(lan->civ.fd); }
+
+    if (lan->ctrl.fd > 0) { close(lan->ctrl.fd); }
+
+    if (lan->app_fd > 0) { close(lan->app_fd); }
+
+    free(lan);
+}
+
+/**
+ * \brief Speak the Icom LAN protocol on the UDP rigport
+ *
+ * On return rigport is a local stream carrying plain CI-V frames.
+ */
+int icom_lan_open(RIG *rig)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    hamlib_port_t *rp = &rig->state.rigport;
+    struct icom_lan *lan;
+    struct sockaddr_storage peer, local;
+    socklen_t peer_len = sizeof(peer);
+    socklen_t local_len = sizeof(local);
+    int pair[2];
+    int civ_port;
+    int retval;
+
+    ENTERFUNC;
+
+    if (rp->type.rig != RIG_PORT_UDP_NETWORK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: lan_user needs a host:port rig_pathname\n",
+                  __func__);
+        RETURNFUNC(-RIG_ECONF);
+    }
+
+    lan = calloc(1, sizeof(*lan));
+
+    if (!lan)
+    {
+        RETURNFUNC(-RIG_ENOMEM);
+    }
+
+    lan->ctrl.name = "control";
+    lan->ctrl.fd = rp->fd;
+    lan->civ.name = "CI-V";
+    lan->civ.fd = -1;
+    lan->app_fd = -1;
+
+    if (getpeername(rp->fd, (struct sockaddr *) &peer, &peer_len) != 0
+            || getsockname(rp->fd, (struct sockaddr *) &local, &local_len) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s\n", __func__, strerror(errno));
+        free(lan);
+        RETURNFUNC(-RIG_EIO);
+    }
+
+    lan->ctrl.my_id = (uint32_t) rand() << 16 ^ (uint32_t) rand();
+
+    retval = icom_lan_connect(&lan->ctrl);
+
+    if (retval == RIG_OK)
+    {
+        retval = icom_lan_login(lan, priv->lan_user, priv->lan_password);
+    }
+
+    if (retval != RIG_OK)
+    {
+        /* rigport still owns the control socket */
+        free(lan);
+        RETURNFUNC(retval);
+    }
+
+    /* the CI-V stream goes from a port of our own to the one the radio names */
+    lan->civ.fd = socket(peer.ss_family, SOCK_DGRAM, 0);
+    local_len = sizeof(local);
+
+    if (lan->civ.fd < 0
+            || connect(lan->civ.fd, (struct sockaddr *) &peer, peer_len) != 0
+            || getsockname(lan->civ.fd, (struct sockaddr *) &local, &local_len) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: CI-V socket: %s\n", __func__, strerror(errno));
+        lan->ctrl.fd = -1;
+        icom_lan_free(lan);
+        RETURNFUNC(-RIG_EIO);
+    }
+
+    civ_port = icom_lan_request_stream(lan, priv->lan_user,
+                                       local.ss_family == AF_INET6 ?
+                                       ntohs(((struct sockaddr_in6 *) &local)->sin6_port) :
+                                       ntohs(((struct sockaddr_in *) &local)->sin_port));
+
+    if (civ_port <= 0)
+    {
+        lan->ctrl.fd = -1;
+        icom_lan_free(lan);
+        RETURNFUNC(civ_port < 0 ? civ_port : -RIG_EPROTO);
+    }
+
+    if (peer.ss_family == AF_INET6)
+    {
+        ((struct sockaddr_in6 *) &peer)->sin6_port = htons(civ_port);
+    }
+    else
+    {
+        ((struct sockaddr_in *) &peer)->sin_port = htons(civ_port);
+    }
+
+    lan->civ.my_id = lan->ctrl.my_id + 1;
+
+    if (connect(lan->civ.fd, (struct sockaddr *) &peer, peer_len) != 0
+            || (retval = icom_lan_connect(&lan->civ)) != RIG_OK
+            || (retval = icom_lan_send_openclose(lan, 1)) != RIG_OK)
+    {
+        lan->ctrl.fd = -1;
+        icom_lan_free(lan);
+        RETURNFUNC(retval != RIG_OK ? retval : -RIG_EIO);
+    }
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: socketpair: %s\n", __func__, strerror(errno));
+        lan->ctrl.fd = -1;
+        icom_lan_free(lan);
+        RETURNFUNC(-RIG_EIO);
+    }
+
+    /* from here on rigport is the CI-V stream, a plain byte stream */
+    rp->fd = pair[0];
+    rp->type.rig = RIG_PORT_NETWORK;
+    lan->app_fd = pair[1];
+
+    elapsed_ms(&lan->ctrl.last_rx, HAMLIB_ELAPSED_SET);
+    elapsed_ms(&lan->civ.last_rx, HAMLIB_ELAPSED_SET);
+    elapsed_ms(&lan->ctrl.last_ping, HAMLIB_ELAPSED_SET);
+    elapsed_ms(&lan->civ.last_ping, HAMLIB_ELAPSED_SET);
+
+    lan->running = 1;
+
+    if (pthread_create(&lan->thread, NULL, icom_lan_thread, lan) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        icom_lan_free(lan);
+        RETURNFUNC(-RIG_EINTERNAL);
+    }
+
+    priv->lan = lan;
+
+    if (priv->re_civ_addr != lan->radio_civ && lan->radio_civ)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: radio says its CI-V address is %#x, using %#x\n",
+                  __func__, lan->radio_civ, priv->re_civ_addr);
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: CI-V stream to %s open on port %d\n", __func__,
+              lan->radio_name, civ_port);
+
+    RETURNFUNC(RIG_OK);
+}
+
+/**
+ * \brief Log out and stop the LAN streams, rigport is closed by rig_close()
+ */
+void icom_lan_close(RIG *rig)
+{
+    struct icom_priv_data *priv = (struct icom_priv_data *) rig->state.priv;
+    struct icom_lan *lan = priv->lan;
+
+    if (!lan)
+    {
+        return;
+    }
+
+    lan->running = 0;
+    pthread_join(lan->thread, NULL);
+
+    icom_lan_send_openclose(lan, 0);
+    icom_lan_send_control(&lan->civ, LAN_T_DISCONNECT, 0);
+    icom_lan_send_token(lan, LAN_REQ_TOKEN_DEL);
+    icom_lan_send_control(&lan->ctrl, LAN_T_DISCONNECT, 0);
+
+    icom_lan_free(lan);
+    priv->lan = NULL;
+}
+
+#else
+
+int icom_lan_open(RIG *rig)
+{
+    rig_debug(RIG_DEBUG_ERR, "%s: Icom LAN needs pthreads and BSD sockets\n",
+              __func__);
+    return -RIG_ENAVAIL;
+}
+
+void icom_lan_close(RIG *rig)
+{
+}
+
+#endif
@@ -56,6 +56,14 @@
     } }
 
 
+/*
+ * A window of 1 ms coalesces without holding anything back: retunes that
+ * arrive while one is on its way are merged into the latest, see
+ * rigqueue.c.  The "coalesce" conf still overrides it.
+ */
+#define PERSEUS_COALESCE_MS 1
+
+static int perseus_init(RIG *rig);
 static int perseus_r2i_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width,
                             unsigned char *md, signed char *pd);
 static void perseus_i2r_mode(RIG *rig, unsigned char md, int pd,
@@ -156,7 +164,7 @@ const struct rig_caps perseus_caps =
     .get_conf =  icom_get_conf,
 
     .priv = (void *)& perseus_priv_caps,
-    .rig_init =   icom_init,
+    .rig_init =   perseus_init,
     .rig_cleanup =   icom_cleanup,
     .rig_open =  icom_rig_open,
     .rig_close =  icom_rig_open,
@@ -177,6 +185,22 @@ const struct rig_caps perseus_caps =
  * Function definitions below
  */
 
+/*
+ * SDR front-ends retune on every scroll step, queue them so the caller
+ * does not wait on CI-V and only the latest one is sent
+ */
+static int perseus_init(RIG *rig)
+{
+    int retval = icom_init(rig);
+
+    if (retval == RIG_OK)
+    {
+        rig->state.coalesce_ms = PERSEUS_COALESCE_MS;
+    }
+
+    return retval;
+}
+
 
 /*
  * This function does the special bandwidth coding for the Perseus
@@ -34,6 +34,8 @@
 #include "token.h"
 #include "cal.h"
 #include "iofunc.h"
+#include "k4pan.h"
+#include "p3pan.h"
 
 #define K3_MODES (RIG_MODE_CW|RIG_MODE_CWR|RIG_MODE_SSB|\
     RIG_MODE_RTTY|RIG_MODE_RTTYR|RIG_MODE_FM|RIG_MODE_AM|RIG_MODE_PKTUSB|\
@@ -218,6 +220,7 @@ const struct rig_caps k3_caps =
     .parm_gran =        {},
     .extlevels =        k3_ext_levels,
     .extparms =     kenwood_cfg_params,
+    .cfgparams =        k3_cfg_params,
     .preamp =       { 1, RIG_DBLST_END, },
     .attenuator =       { 10, RIG_DBLST_END, },
     .max_rit =      Hz(9990),
@@ -292,10 +295,27 @@ const struct rig_caps k3_caps =
     },
     .priv = (void *)& k3_priv_caps,
 
+    .spectrum_scopes = {
+        {
+            .id = 0,
+            .name = "Main",
+        },
+        {
+            .id = -1,
+            .name = NULL,
+        },
+    },
+    .spectrum_modes = {
+        RIG_SPECTRUM_MODE_CENTER,
+        RIG_SPECTRUM_MODE_NONE,
+    },
+
     .rig_init =     kenwood_init,
-    .rig_cleanup =      kenwood_cleanup,
-    .rig_open =     elecraft_open,
-    .rig_close =        kenwood_close,
+    .rig_cleanup =      k3_cleanup,
+    .rig_open =     k3_open,
+    .rig_close =        k3_close,
+    .set_conf =     k3_set_conf,
+    .get_conf =     k3_get_conf,
     .set_freq =     k3_set_freq,
     .get_freq =     kenwood_get_freq,
     .set_mode =     k3_set_mode,
@@ -311,6 +331,8 @@ const struct rig_caps k3_caps =
     .set_xit =      k3_set_xit,
     .get_xit =      kenwood_get_xit,
     .get_ptt =      kenwood_get_ptt,
+    .get_bulk =      kenwood_get_bulk,
+    .set_bulk =      kenwood_set_bulk,
     .set_ptt =      kenwood_set_ptt,
     .get_dcd =      kenwood_get_dcd,
     .set_func =     k3_set_func,
@@ -331,6 +353,10 @@ const struct rig_caps k3_caps =
     .send_morse =       kenwood_send_morse,
     .wait_morse =       rig_wait_morse,
 
+    .async_data_supported = 1,
+    .read_frame_direct = kenwood_read_frame_direct,
+    .is_async_frame = kenwood_is_async_frame,
+    .process_async_frame = kenwood_process_async_frame,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
 
@@ -369,6 +395,7 @@ const struct rig_caps k3s_caps =
     .parm_gran =        {},
     .extlevels =        k3_ext_levels,
     .extparms =     kenwood_cfg_params,
+    .cfgparams =        k3_cfg_params,
     .preamp =       { 1, RIG_DBLST_END, },
     .attenuator =       { 5, 10, 15, RIG_DBLST_END, },
     .max_rit =      Hz(9990),
@@ -443,10 +470,27 @@ const struct rig_caps k3s_caps =
     },
     .priv = (void *)& k3_priv_caps,
 
+    .spectrum_scopes = {
+        {
+            .id = 0,
+            .name = "Main",
+        },
+        {
+            .id = -1,
+            .name = NULL,
+        },
+    },
+    .spectrum_modes = {
+        RIG_SPECTRUM_MODE_CENTER,
+        RIG_SPECTRUM_MODE_NONE,
+    },
+
     .rig_init =     kenwood_init,
-    .rig_cleanup =      kenwood_cleanup,
-    .rig_open =     elecraft_open,
-    .rig_close =        kenwood_close,
+    .rig_cleanup =      k3_cleanup,
+    .rig_open =     k3_open,
+    .rig_close =        k3_close,
+    .set_conf =     k3_set_conf,
+    .get_conf =     k3_get_conf,
     .set_freq =     k3_set_freq,
     .get_freq =     kenwood_get_freq,
     .set_mode =     k3_set_mode,
@@ -462,6 +506,8 @@ const struct rig_caps k3s_caps =
     .set_xit =      k3_set_xit,
     .get_xit =      kenwood_get_xit,
     .get_ptt =      kenwood_get_ptt,
+    .get_bulk =      kenwood_get_bulk,
+    .set_bulk =      kenwood_set_bulk,
     .set_ptt =      kenwood_set_ptt,
     .get_dcd =      kenwood_get_dcd,
     .set_func =     k3_set_func,
@@ -481,6 +527,10 @@ const struct rig_caps k3s_caps =
     .get_ant =      kenwood_get_ant,
     .send_morse =       kenwood_send_morse,
     .wait_morse =       rig_wait_morse,
+    .async_data_supported = 1,
+    .read_frame_direct = kenwood_read_frame_direct,
+    .is_async_frame = kenwood_is_async_frame,
+    .process_async_frame = kenwood_process_async_frame,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
 
@@ -490,7 +540,7 @@ const struct rig_caps k4_caps =
     RIG_MODEL(RIG_MODEL_K4),
     .model_name =       "K4",
     .mfg_name =     "Elecraft",
-    .version =      BACKEND_VER ".24",
+    .version =      BACKEND_VER ".25",
     .copyright =        "LGPL",
     .status =       RIG_STATUS_STABLE,
     .rig_type =     RIG_TYPE_TRANSCEIVER,
@@ -520,6 +570,7 @@ const struct rig_caps k4_caps =
     .parm_gran =        {},
     .extlevels =        k3_ext_levels,
     .extparms =     kenwood_cfg_params,
+    .cfgparams =        k4_cfg_params,
     .preamp =       { 1, RIG_DBLST_END, },
     .attenuator =       { 5, 10, 15, RIG_DBLST_END, },
     .max_rit =      Hz(9990),
@@ -594,10 +645,31 @@ const struct rig_caps k4_caps =
     },
     .priv = (void *)& k3_priv_caps,
 
+    .spectrum_scopes = {
+        {
+            .id = 0,
+            .name = "Main",
+        },
+        {
+            .id = 1,
+            .name = "Sub",
+        },
+        {
+            .id = -1,
+            .name = NULL,
+        },
+    },
+    .spectrum_modes = {
+        RIG_SPECTRUM_MODE_CENTER,
+        RIG_SPECTRUM_MODE_NONE,
+    },
+
     .rig_init =     kenwood_init,
-    .rig_cleanup =      kenwood_cleanup,
-    .rig_open =     elecraft_open,
-    .rig_close =        kenwood_close,
+    .rig_cleanup =      k4_cleanup,
+    .rig_open =     k4_open,
+    .rig_close =        k4_close,
+    .set_conf =     k4_set_conf,
+    .get_conf =     k4_get_conf,
     .set_freq =     kenwood_set_freq,
     .get_freq =     kenwood_get_freq,
     .set_mode =     k3_set_mode,
@@ -632,6 +704,10 @@ const struct rig_caps k4_caps =
     .get_ant =      kenwood_get_ant,
     .send_morse =       kenwood_send_morse,
     .wait_morse =       rig_wait_morse,
+    .async_data_supported = 1,
+    .read_frame_direct = kenwood_read_frame_direct,
+    .is_async_frame = kenwood_is_async_frame,
+    .process_async_frame = kenwood_process_async_frame,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
 
@@ -670,6 +746,7 @@ const struct rig_caps kx3_caps =
     .parm_gran =        {},
     .extlevels =        kx3_ext_levels,
     .extparms =     kenwood_cfg_params,
+    .cfgparams =        k3_cfg_params,
     .preamp =       { 1, RIG_DBLST_END, },
     .attenuator =       { 10, RIG_DBLST_END, },
     .max_rit =      Hz(9990),
@@ -744,10 +821,27 @@ const struct rig_caps kx3_caps =
     },
     .priv = (void *)& k3_priv_caps,
 
+    .spectrum_scopes = {
+        {
+            .id = 0,
+            .name = "Main",
+        },
+        {
+            .id = -1,
+            .name = NULL,
+        },
+    },
+    .spectrum_modes = {
+        RIG_SPECTRUM_MODE_CENTER,
+        RIG_SPECTRUM_MODE_NONE,
+    },
+
     .rig_init =     kenwood_init,
-    .rig_cleanup =      kenwood_cleanup,
-    .rig_open =     elecraft_open,
-    .rig_close =        kenwood_close,
+    .rig_cleanup =      k3_cleanup,
+    .rig_open =     k3_open,
+    .rig_close =        k3_close,
+    .set_conf =     k3_set_conf,
+    .get_conf =     k3_get_conf,
     .set_freq =     kenwood_set_freq,
     .get_freq =     kenwood_get_freq,
     .set_mode =     k3_set_mode,
@@ -763,6 +857,8 @@ const struct rig_caps kx3_caps =
     .set_xit =      k3_set_xit,
     .get_xit =      kenwood_get_xit,
     .get_ptt =      kenwood_get_ptt,
+    .get_bulk =      kenwood_get_bulk,
+    .set_bulk =      kenwood_set_bulk,
     .set_ptt =      kenwood_set_ptt,
     .get_dcd =      kenwood_get_dcd,
     .set_func =     k3_set_func,
@@ -820,6 +916,7 @@ const struct rig_caps kx2_caps =
     .parm_gran =        {},
     .extlevels =        kx3_ext_levels,
     .extparms =     kenwood_cfg_params,
+    .cfgparams =        k3_cfg_params,
     .preamp =       { 1, RIG_DBLST_END, },
     .attenuator =       { 10, RIG_DBLST_END, },
     .max_rit =      Hz(9990),
@@ -894,10 +991,27 @@ const struct rig_caps kx2_caps =
     },
     .priv = (void *)& k3_priv_caps,
 
+    .spectrum_scopes = {
+        {
+            .id = 0,
+            .name = "Main",
+        },
+        {
+            .id = -1,
+            .name = NULL,
+        },
+    },
+    .spectrum_modes = {
+        RIG_SPECTRUM_MODE_CENTER,
+        RIG_SPECTRUM_MODE_NONE,
+    },
+
     .rig_init =     kenwood_init,
-    .rig_cleanup =      kenwood_cleanup,
-    .rig_open =     elecraft_open,
-    .rig_close =        kenwood_close,
+    .rig_cleanup =      k3_cleanup,
+    .rig_open =     k3_open,
+    .rig_close =        k3_close,
+    .set_conf =     k3_set_conf,
+    .get_conf =     k3_get_conf,
     .set_freq =     kenwood_set_freq,
     .get_freq =     kenwood_get_freq,
     .set_mode =     k3_set_mode,
@@ -913,6 +1027,8 @@ const struct rig_caps kx2_caps =
     .set_xit =      k3_set_xit,
     .get_xit =      kenwood_get_xit,
     .get_ptt =      kenwood_get_ptt,
+    .get_bulk =      kenwood_get_bulk,
+    .set_bulk =      kenwood_set_bulk,
     .set_ptt =      kenwood_set_ptt,
     .get_dcd =      kenwood_get_dcd,
     .set_func =     k3_set_func,
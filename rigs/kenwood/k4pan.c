@@ -0,0 +1,502 @@
+/*
+ *  Hamlib Elecraft backend - K4 panadapter stream
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The K4 CAT commands stay on rigport as for every other Elecraft rig.  When
+ * the rig is reached over the network and "k4_pan_port" is set, a second
+ * connection is opened to that port of the same host and a reader thread
+ * turns its panadapter frames into spectrum lines, which go through
+ * rig_fire_spectrum_event() like the Icom scope data: callback, history and
+ * multicast publisher.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "kenwood.h"
+#include "elecraft.h"
+#include "k4pan.h"
+#include "iofunc.h"
+#include "network.h"
+#include "misc.h"
+#include "event.h"
+#include "spectrum_pool.h"
+
+#define K4PAN_TIMEOUT 1000      /* ms, also how long k4_close() may wait */
+#define K4PAN_MAX_PAYLOAD (K4PAN_PAN_HEADER_LEN + HAMLIB_MAX_SPECTRUM_DATA)
+
+static const unsigned char k4pan_start_marker[4] = { 0xfe, 0xfd, 0xfc, 0xfb };
+static const unsigned char k4pan_end_marker[4] = { 0xfb, 0xfc, 0xfd, 0xfe };
+
+struct k4pan_priv_data
+{
+    int port;                   /* k4_pan_port, 0 = stream not used */
+    hamlib_port_t panport;
+    int running;
+#ifdef HAVE_PTHREAD
+    pthread_t thread;
+#endif
+    RIG *rig;
+    unsigned char payload[K4PAN_MAX_PAYLOAD];
+    unsigned char data[HAMLIB_MAX_SPECTRUM_DATA]; /* used if the pool is empty */
+};
+
+const struct confparams k4_cfg_params[] =
+{
+    {
+        TOK_K4_PAN_PORT, "k4_pan_port", "Panadapter port",
+        "TCP port of the K4 binary panadapter stream on the rig's host, 0 to disable. "
+        "Only used when the rig is reached over the network",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 65535, 1 } }
+    },
+    { RIG_CONF_END, NULL, }
+};
+
+static struct k4pan_priv_data *k4pan_priv(RIG *rig, int create)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+
+    if (!priv->data && create)
+    {
+        priv->data = calloc(1, sizeof(struct k4pan_priv_data));
+    }
+
+    return priv->data;
+}
+
+static unsigned long k4pan_get_u32(const unsigned char *p)
+{
+    return (unsigned long)p[0] | ((unsigned long)p[1] << 8)
+           | ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+int k4pan_decode(const unsigned char *payload, size_t len,
+                 struct rig_spectrum_line *line, unsigned char *data,
+                 size_t data_size)
+{
+    long center;
+    unsigned long span;
+    size_t bins;
+
+    if (len < K4PAN_PAN_HEADER_LEN || payload[0] != K4PAN_PAYLOAD_PAN)
+    {
+        return -RIG_EPROTO;
+    }
+
+    center = (long)(int32_t)k4pan_get_u32(payload + 4);
+    span = k4pan_get_u32(payload + 8);
+    bins = payload[12] | (payload[13] << 8);
+
+    if (bins > len - K4PAN_PAN_HEADER_LEN || bins > data_size)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: bad bin count %d in %d byte frame\n",
+                  __func__, (int)bins, (int)len);
+        return -RIG_EPROTO;
+    }
+
+    memcpy(data, payload + K4PAN_PAN_HEADER_LEN, bins);
+
+    *line = (struct rig_spectrum_line)
+    {
+        .id = payload[3],
+        .data_level_min = 0,
+        .data_level_max = 255,
+        .signal_strength_min = K4PAN_DBM_MIN,
+        .signal_strength_max = K4PAN_DBM_MAX,
+        .spectrum_mode = RIG_SPECTRUM_MODE_CENTER,
+        .center_freq = center,
+        .span_freq = span,
+        .low_edge_freq = center - (freq_t)span / 2,
+        .high_edge_freq = center + (freq_t)span / 2,
+        .spectrum_data_length = bins,
+        .spectrum_data = data,
+    };
+
+    return RIG_OK;
+}
+
+static void k4pan_dispatch(struct k4pan_priv_data *pan, size_t len)
+{
+    struct spectrum_pool_line *pl = spectrum_pool_get();
+    struct rig_spectrum_line stack_line;
+    struct rig_spectrum_line *line = pl ? &pl->line : &stack_line;
+    unsigned char *data = pl ? pl->data : pan->data;
+
+    if (k4pan_decode(pan->payload, len, line, data,
+                     HAMLIB_MAX_SPECTRUM_DATA) == RIG_OK)
+    {
+        rig_fire_spectrum_event(pan->rig, line);
+    }
+
+    if (pl)
+    {
+        spectrum_pool_put(pl);
+    }
+}
+
+/* Skip to the byte after the next start marker */
+static int k4pan_sync(struct k4pan_priv_data *pan)
+{
+    unsigned char buf[4];
+    int ret = read_block(&pan->panport, buf, sizeof(buf));
+
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    /* frames normally follow each other, else slide a byte at a time */
+    while (memcmp(buf, k4pan_start_marker, sizeof(buf)) != 0)
+    {
+        if (!pan->running)
+        {
+            return -RIG_ETIMEOUT;
+        }
+
+        memmove(buf, buf + 1, sizeof(buf) - 1);
+        ret = read_block(&pan->panport, buf + sizeof(buf) - 1, 1);
+
+        if (ret < 0)
+        {
+            return ret;
+        }
+    }
+
+    return RIG_OK;
+}
+
+/* Read one frame after the start marker into pan->payload */
+static int k4pan_read_frame(struct k4pan_priv_data *pan, size_t *len)
+{
+    unsigned char buf[4];
+    unsigned long left;
+    int ret;
+
+    ret = read_block(&pan->panport, buf, sizeof(buf));
+
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    *len = k4pan_get_u32(buf);
+    left = *len;
+
+    /* payloads we have no use for are read through and dropped */
+    while (left > 0)
+    {
+        size_t chunk = left < sizeof(pan->payload) ? left : sizeof(pan->payload);
+
+        ret = read_block(&pan->panport, pan->payload, chunk);
+
+        if (ret < 0)
+        {
+            return ret;
+        }
+
+        left -= chunk;
+    }
+
+    ret = read_block(&pan->panport, buf, sizeof(buf));
+
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    if (memcmp(buf, k4pan_end_marker, sizeof(buf)) != 0)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: frame without end marker dropped\n",
+                  __func__);
+        return -RIG_EPROTO;
+    }
+
+    if (*len > sizeof(pan->payload))
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: %d byte frame skipped\n", __func__,
+                  (int)*len);
+        *len = 0;
+    }
+
+    return RIG_OK;
+}
+
+#ifdef HAVE_PTHREAD
+static void *k4pan_thread(void *arg)
+{
+    struct k4pan_priv_data *pan = arg;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: started\n", __func__);
+
+    while (pan->running)
+    {
+        size_t len;
+        int ret = k4pan_sync(pan);
+
+        if (ret == RIG_OK && pan->running)
+        {
+            ret = k4pan_read_frame(pan, &len);
+
+            if (ret == RIG_OK)
+            {
+                if (len > 0 && pan->payload[0] == K4PAN_PAYLOAD_PAN)
+                {
+                    k4pan_dispatch(pan, len);
+                }
+
+                continue;
+            }
+        }
+
+        if (ret == -RIG_ETIMEOUT || ret == -RIG_EPROTO)
+        {
+            continue;
+        }
+
+        if (ret != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: panadapter stream lost: %s\n", __func__,
+                      rigerror(ret));
+            break;
+        }
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: stopped\n", __func__);
+
+    return NULL;
+}
+#endif
+
+static void k4pan_close_port(struct k4pan_priv_data *pan)
+{
+    /* not network_close(), which tears down Winsock for rigport too */
+    if (pan->panport.fd > 0)
+    {
+#ifdef __MINGW32__
+        closesocket(pan->panport.fd);
+#else
+        close(pan->panport.fd);
+#endif
+        pan->panport.fd = 0;
+    }
+
+    network_release(&pan->panport);
+}
+
+static int k4pan_start(RIG *rig, struct k4pan_priv_data *pan)
+{
+#ifdef HAVE_PTHREAD
+    struct rig_state *rs = &rig->state;
+    char *colon;
+    size_t len;
+    int ret;
+
+    if (rs->rigport.type.rig != RIG_PORT_NETWORK)
+    {
+        rig_debug(RIG_DEBUG_WARN,
+                  "%s: k4_pan_port needs a network connection to the K4, ignored\n",
+                  __func__);
+        return RIG_OK;
+    }
+
+    memset(&pan->panport, 0, sizeof(pan->panport));
+    pan->panport.type.rig = RIG_PORT_NETWORK;
+    pan->panport.timeout = K4PAN_TIMEOUT;
+
+    /* same host as rigport, the last ':' starts rigport's port number */
+    SNPRINTF(pan->panport.pathname, sizeof(pan->panport.pathname), "%s",
+             rs->rigport.pathname);
+    colon = strrchr(pan->panport.pathname, ':');
+
+    if (colon && strchr(colon, ']') == NULL)
+    {
+        *colon = '\0';
+    }
+
+    len = strlen(pan->panport.pathname);
+    snprintf(pan->panport.pathname + len, sizeof(pan->panport.pathname) - len,
+             ":%d", pan->port);
+
+    ret = network_open(&pan->panport, pan->port);
+
+    if (ret != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot open panadapter stream %s\n", __func__,
+                  pan->panport.pathname);
+        return ret;
+    }
+
+    pan->rig = rig;
+    pan->running = 1;
+
+    if (pthread_create(&pan->thread, NULL, k4pan_thread, pan))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        pan->running = 0;
+        k4pan_close_port(pan);
+        return -RIG_EINTERNAL;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: panadapter stream on %s\n", __func__,
+              pan->panport.pathname);
+
+    return RIG_OK;
+#else
+    rig_debug(RIG_DEBUG_WARN, "%s: built without threads, k4_pan_port ignored\n",
+              __func__);
+    return RIG_OK;
+#endif
+}
+
+static void k4pan_stop(struct k4pan_priv_data *pan)
+{
+#ifdef HAVE_PTHREAD
+
+    if (!pan || !pan->running)
+    {
+        return;
+    }
+
+    pan->running = 0;
+    pthread_join(pan->thread, NULL);
+    k4pan_close_port(pan);
+#endif
+}
+
+int k4_set_conf(RIG *rig, token_t token, const char *val)
+{
+    struct k4pan_priv_data *pan;
+
+    ENTERFUNC;
+
+    switch (token)
+    {
+    case TOK_K4_PAN_PORT:
+        pan = k4pan_priv(rig, 1);
+
+        if (!pan)
+        {
+            RETURNFUNC(-RIG_ENOMEM);
+        }
+
+        pan->port = atoi(val);
+
+        if (pan->port < 0 || pan->port > 65535)
+        {
+            pan->port = 0;
+            RETURNFUNC(-RIG_EINVAL);
+        }
+
+        break;
+
+    default:
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+int k4_get_conf(RIG *rig, token_t token, char *val)
+{
+    struct k4pan_priv_data *pan;
+
+    ENTERFUNC;
+
+    switch (token)
+    {
+    case TOK_K4_PAN_PORT:
+        pan = k4pan_priv(rig, 0);
+        sprintf(val, "%d", pan ? pan->port : 0);
+        break;
+
+    default:
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+int k4_open(RIG *rig)
+{
+    struct k4pan_priv_data *pan;
+    int err;
+
+    ENTERFUNC;
+
+    err = elecraft_open(rig);
+
+    if (err != RIG_OK)
+    {
+        RETURNFUNC(err);
+    }
+
+    pan = k4pan_priv(rig, 0);
+
+    if (pan && pan->port > 0 && !pan->running)
+    {
+        err = k4pan_start(rig, pan);
+
+        if (err != RIG_OK)
+        {
+            kenwood_close(rig);
+            RETURNFUNC(err);
+        }
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+int k4_close(RIG *rig)
+{
+    ENTERFUNC;
+
+    k4pan_stop(k4pan_priv(rig, 0));
+
+    RETURNFUNC(kenwood_close(rig));
+}
+
+int k4_cleanup(RIG *rig)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+
+    ENTERFUNC;
+
+    if (priv)
+    {
+        k4pan_stop(priv->data);
+        free(priv->data);
+        priv->data = NULL;
+    }
+
+    RETURNFUNC(kenwood_cleanup(rig));
+}
@@ -0,0 +1,56 @@
+/*
+ *  Hamlib Elecraft backend - K4 panadapter stream
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _K4PAN_H
+#define _K4PAN_H 1
+
+#include <hamlib/rig.h>
+#include "token.h"
+
+#define TOK_K4_PAN_PORT TOKEN_BACKEND(110)  /* TCP port of the K4 binary stream, 0 = off */
+
+/*
+ * K4 binary stream framing, as decoded here:
+ *   FE FD FC FB, u32 payload length (LE), payload, FB FC FD FE
+ * A panadapter payload is
+ *   u8 type (2), u8 version, u8 sequence, u8 receiver (0 main, 1 sub),
+ *   i32 center Hz (LE), u32 span Hz (LE), u16 bin count (LE), u8 bins[]
+ * with each bin 0..255 standing for -160..+95 dBm.
+ */
+#define K4PAN_PAYLOAD_PAN 2
+#define K4PAN_PAN_HEADER_LEN 16
+#define K4PAN_DBM_MIN (-160)
+#define K4PAN_DBM_MAX 95
+
+extern const struct confparams k4_cfg_params[];
+
+int k4_set_conf(RIG *rig, token_t token, const char *val);
+int k4_get_conf(RIG *rig, token_t token, char *val);
+int k4_open(RIG *rig);
+int k4_close(RIG *rig);
+int k4_cleanup(RIG *rig);
+
+/* Decode one payload, exposed for testing; returns RIG_OK or -RIG_EPROTO */
+int k4pan_decode(const unsigned char *payload, size_t len,
+                 struct rig_spectrum_line *line, unsigned char *data,
+                 size_t data_size);
+
+#endif /* _K4PAN_H */
@@ -34,6 +34,10 @@
 #include "register.h"
 #include "cal.h"
 #include "cache.h"
+#include "rigfacts.h"
+#include "stats.h"
+#include "event.h"
+#include "iofunc.h"
 
 #include "kenwood.h"
 #include "ts990s.h"
@@ -43,6 +47,10 @@
 #define min(a,b) (((a) < (b)) ? (a) : (b))
 #endif
 
+static int kenwood_is_report(const unsigned char *frame, size_t frame_length);
+static void kenwood_if_to_cache(RIG *rig, const struct kenwood_if_data *ifd);
+static void kenwood_settings_init(RIG *rig);
+
 struct kenwood_id
 {
     rig_model_t model;
@@ -211,6 +219,161 @@ struct confparams kenwood_cfg_params[] =
 };
 
 
+/*
+ * The TH/TM handhelds and mobiles have no IF; what pollers ask them is
+ * "FO n", the whole state of band n in one line, which every getter of
+ * thd72.c, thd74.c and tmd710.c reads again.  kenwood_transaction()
+ * keeps the last "FO n" and "ME nnn" answers for the cache timeout, and
+ * drops them on any command that may change something.  The answer to a
+ * "FO n,..." or "ME nnn,..." set is the new state and is kept too.
+ */
+static int kenwood_th_cacheable(const char *cmd)
+{
+    size_t len = strlen(cmd);
+
+    if (len == 4 && !strncmp(cmd, "FO ", 3) && isdigit((unsigned char) cmd[3]))
+    {
+        return 1;
+    }
+
+    return len == 6 && !strncmp(cmd, "ME ", 3)
+           && isdigit((unsigned char) cmd[3]) && isdigit((unsigned char) cmd[4])
+           && isdigit((unsigned char) cmd[5]);
+}
+
+/* queries that leave FO and ME alone; anything else drops the answers */
+static int kenwood_th_harmless(const char *cmd)
+{
+    size_t len = strlen(cmd);
+
+    if (len == 2)
+    {
+        /* the TH/TM sets all have arguments, but for these */
+        return strcmp(cmd, "TX") && strcmp(cmd, "RX")
+               && strcmp(cmd, "UP") && strcmp(cmd, "DW");
+    }
+
+    /* S meter, busy, memory and VFO/memory mode of a band, band select */
+    if (len == 4 && isdigit((unsigned char) cmd[3]))
+    {
+        return !strncmp(cmd, "SM ", 3) || !strncmp(cmd, "BY ", 3)
+               || !strncmp(cmd, "MR ", 3) || !strncmp(cmd, "VM ", 3)
+               || !strncmp(cmd, "BC ", 3);
+    }
+
+    /* memory name */
+    return len == 6 && !strncmp(cmd, "MN ", 3) && isdigit((unsigned char) cmd[3]);
+}
+
+static struct kenwood_th_reply *kenwood_th_find(struct kenwood_priv_data *priv,
+        const char *cmd)
+{
+    int i;
+
+    for (i = 0; i < KENWOOD_TH_REPLIES; i++)
+    {
+        if (priv->th_replies[i].cmd[0] && !strcmp(priv->th_replies[i].cmd, cmd))
+        {
+            return &priv->th_replies[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int kenwood_th_get(RIG *rig, const char *cmd, char *data,
+                          size_t datasize)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+    struct kenwood_th_reply *r;
+    int age;
+
+    if (rig->state.cache.timeout_ms <= 0 || !data || !datasize)
+    {
+        return 0;
+    }
+
+    r = kenwood_th_find(priv, cmd);
+
+    if (!r)
+    {
+        return 0;
+    }
+
+    age = elapsed_ms(&r->time, HAMLIB_ELAPSED_GET);
+
+    if (age >= rig->state.cache.timeout_ms)
+    {
+        r->cmd[0] = '\0';
+        return 0;
+    }
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: %s answered from cache, age=%dms\n", __func__,
+              cmd, age);
+    SNPRINTF(data, datasize, "%s", r->reply);
+
+    return 1;
+}
+
+/* keep reply, the answer of cmd or the echo of a FO/ME set */
+static void kenwood_th_put(RIG *rig, const char *cmd, const char *reply)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+    struct kenwood_th_reply *r;
+    char key[8];
+    size_t len;
+
+    if (kenwood_th_cacheable(cmd))
+    {
+        if (strncmp(reply, cmd, 3)) { return; }
+
+        SNPRINTF(key, sizeof(key), "%s", cmd);
+    }
+    else if ((!strncmp(cmd, "FO ", 3) || !strncmp(cmd, "ME ", 3))
+             && strchr(cmd, ',') && !strncmp(reply, cmd, 3))
+    {
+        /* the set echoes the new state, keyed like its query */
+        len = strcspn(reply, ",");
+        SNPRINTF(key, sizeof(key), "%.*s", (int) len, reply);
+
+        if (!kenwood_th_cacheable(key))
+        {
+            return;
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    r = kenwood_th_find(priv, key);
+
+    if (!r)
+    {
+        r = &priv->th_replies[priv->th_reply_next];
+        priv->th_reply_next = (priv->th_reply_next + 1) % KENWOOD_TH_REPLIES;
+    }
+
+    len = strcspn(reply, "\r");
+
+    if (len >= sizeof(r->reply)) { len = sizeof(r->reply) - 1; }
+
+    memcpy(r->reply, reply, len);
+    r->reply[len] = '\0';
+    SNPRINTF(r->cmd, sizeof(r->cmd), "%s", key);
+    elapsed_ms(&r->time, HAMLIB_ELAPSED_SET);
+}
+
+static void kenwood_th_clear(struct kenwood_priv_data *priv)
+{
+    int i;
+
+    for (i = 0; i < KENWOOD_TH_REPLIES; i++)
+    {
+        priv->th_replies[i].cmd[0] = '\0';
+    }
+}
+
 /**
  * kenwood_transaction
  * Assumes rig!=NULL rig->state!=NULL rig->caps!=NULL
@@ -230,6 +393,127 @@ struct confparams kenwood_cfg_params[] =
  *   RIG_REJECTED - if a negative acknowledge was received or command not
  *          recognized by rig.
  */
+/*
+ * Send the set commands held back during kenwood_set_bulk() in one write,
+ * the verify command behind them, and read the answers up to its reply.
+ * A refusal cannot be pinned on one of the commands, it is left in
+ * bulk_err for kenwood_set_bulk() to sort out.
+ */
+static int kenwood_bulk_flush(RIG *rig)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+    hamlib_port_t *rp = &rig->state.rigport;
+    char buffer[KENWOOD_MAX_BUF_LEN];
+    int retval, tries;
+
+    if (priv->bulk_len == 0)
+    {
+        return RIG_OK;
+    }
+
+    priv->bulk_flushes++;
+
+    if (!priv->no_id)
+    {
+        memcpy(priv->bulk + priv->bulk_len, priv->verify_cmd,
+               strlen(priv->verify_cmd));
+        priv->bulk_len += strlen(priv->verify_cmd);
+    }
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: cmdstr = %.*s\n", __func__, priv->bulk_len,
+              priv->bulk);
+
+    rig_flush(rp);
+    retval = write_block(rp, (unsigned char *) priv->bulk, priv->bulk_len);
+    priv->bulk_len = 0;
+
+    // besides our answers there may be AI reports, up to a point
+    for (tries = 0; retval == RIG_OK && !priv->no_id && tries < 32; tries++)
+    {
+        retval = read_string(rp, (unsigned char *) buffer, sizeof(buffer), ";", 1,
+                             0, 1);
+
+        if (retval < 0)
+        {
+            break;
+        }
+
+        retval = RIG_OK;
+
+        if (strlen(buffer) == 2)
+        {
+            switch (buffer[0])
+            {
+            case 'N': retval = -RIG_ENAVAIL; break;
+
+            case '?': retval = -RIG_ERJCTED; break;
+
+            case 'O':
+            case 'E': retval = -RIG_EIO; break;
+            }
+
+            if (retval != RIG_OK)
+            {
+                rig_debug(RIG_DEBUG_VERBOSE, "%s: %s answered\n", __func__, buffer);
+
+                if (priv->bulk_err == RIG_OK) { priv->bulk_err = retval; }
+
+                retval = RIG_OK;
+                continue;
+            }
+        }
+
+        if (strncmp(buffer, priv->verify_cmd, 2) == 0)
+        {
+            break;
+        }
+    }
+
+    if (retval != RIG_OK && priv->bulk_err == RIG_OK)
+    {
+        priv->bulk_err = retval;
+    }
+
+    return retval;
+}
+
+/*
+ * kenwood_transaction() during kenwood_set_bulk(): a set command is held
+ * back to go out with the others, anything expecting an answer has them
+ * sent first.  Returns 1 when the transaction must go ahead as usual.
+ */
+static int kenwood_bulk_hold(RIG *rig, const char *cmdstr, size_t datasize)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+    size_t len = strlen(cmdstr);
+
+    // the same exceptions as the verification in kenwood_transaction()
+    if (datasize || len < 3 || strncmp(cmdstr, "RU", 2) == 0
+            || strncmp(cmdstr, "RD", 2) == 0 || strncmp(cmdstr, "KYW", 3) == 0)
+    {
+        kenwood_bulk_flush(rig);
+        return 1;
+    }
+
+    if (priv->bulk_len + len + 1 + sizeof(priv->verify_cmd) > KENWOOD_BULK_LEN)
+    {
+        kenwood_bulk_flush(rig);
+    }
+
+    memcpy(priv->bulk + priv->bulk_len, cmdstr, len);
+    priv->bulk_len += len;
+
+    if (cmdstr[len - 1] != ';')
+    {
+        priv->bulk[priv->bulk_len++] = ';';
+    }
+
+    // then we must be setting something so we'll invalidate the cache
+    priv->cache_start.tv_sec = 0;
+
+    return RIG_OK;
+}
+
 int kenwood_transaction(RIG *rig, const char *cmdstr, char *data,
                         size_t datasize)
 {
@@ -244,6 +528,7 @@ int kenwood_transaction(RIG *rig, const char *cmdstr, char *data,
     struct kenwood_priv_data *priv = rig->state.priv;
     struct kenwood_priv_caps *caps = kenwood_caps(rig);
     struct rig_state *rs;
+    struct timespec stats_start;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -279,6 +564,35 @@ int kenwood_transaction(RIG *rig, const char *cmdstr, char *data,
         // else we drop through and do the real IF command
     }
 
+    if (caps->cmdtrm == EOM_TH && cmdstr)
+    {
+        if (kenwood_th_cacheable(cmdstr))
+        {
+            if (kenwood_th_get(rig, cmdstr, data, datasize))
+            {
+                rs->transaction_active = 0;
+                RETURNFUNC2(RIG_OK);
+            }
+        }
+        else if (!kenwood_th_harmless(cmdstr))
+        {
+            kenwood_th_clear(priv);
+        }
+    }
+
+    if (priv->bulk && cmdstr)
+    {
+        retval = kenwood_bulk_hold(rig, cmdstr, datasize);
+
+        if (retval != 1)
+        {
+            rs->transaction_active = 0;
+            RETURNFUNC2(retval);
+        }
+    }
+
+    rig_stats_begin(rig, &stats_start);
+
     if (strlen(cmdstr) > 2 || strcmp(cmdstr, "RX") == 0
             || strncmp(cmdstr, "TX", 2) == 0 || strncmp(cmdstr, "ZZTX", 4) == 0)
     {
@@ -292,6 +606,13 @@ int kenwood_transaction(RIG *rig, const char *cmdstr, char *data,
 
 transaction_write:
 
+    // no retry once the caller's deadline has passed, see rig_set_deadline()
+    if (retry_read > 0 && rig_get_deadline() == 0)
+    {
+        retval = -RIG_ETIMEOUT;
+        goto transaction_quit;
+    }
+
     if (cmdstr)
     {
         rig_debug(RIG_DEBUG_TRACE, "%s: cmdstr = %s\n", __func__, cmdstr);
@@ -509,6 +830,13 @@ transaction_read:
     {
         if (cmdstr && (buffer[0] != cmdstr[0] || (cmdstr[1] && buffer[1] != cmdstr[1])))
         {
+            /* an AI report the async handler has already applied */
+            if (rs->async_data_enabled
+                    && kenwood_is_report((unsigned char *) buffer, strlen(buffer)))
+            {
+                goto transaction_read;
+            }
+
             /*
              * TODO: When RIG_TRN is enabled, we can pass the string to
              * the decoder for callback. That way we don't ignore any
@@ -560,6 +888,12 @@ transaction_read:
         if (priv->verify_cmd[0] != buffer[0]
                 || (priv->verify_cmd[1] && priv->verify_cmd[1] != buffer[1]))
         {
+            if (rs->async_data_enabled
+                    && kenwood_is_report((unsigned char *) buffer, strlen(buffer)))
+            {
+                goto transaction_read;
+            }
+
             /*
              * TODO: When RIG_TRN is enabled, we can pass the string to
              * the decoder for callback. That way we don't ignore any
@@ -608,6 +942,13 @@ transaction_quit:
         strncpy(priv->last_if_response, buffer, caps->if_len);
     }
 
+    if (retval == RIG_OK && caps->cmdtrm == EOM_TH && cmdstr && data)
+    {
+        kenwood_th_put(rig, cmdstr, buffer);
+    }
+
+    rig_stats_end(rig, &stats_start, retval, retry_read);
+
     rs->transaction_active = 0;
     RETURNFUNC2(retval);
 }
@@ -768,6 +1109,8 @@ int kenwood_init(RIG *rig)
 
     priv->ag_format = -1;  // force determination of AG format
 
+    kenwood_settings_init(rig);
+
     rig_debug(RIG_DEBUG_TRACE, "%s: if_len = %d\n", __func__, caps->if_len);
 
     // SDRUno uses mode 8 for DIG
@@ -797,26 +1140,57 @@ int kenwood_open(RIG *rig)
     char *idptr;
     char id[KENWOOD_MAX_BUF_LEN];
     int retry_save = rig->state.rigport.retry;
+    const char *fact;
 
     ENTERFUNC;
 
     id[0] = 0;
     rig->state.rigport.retry = 0;
-    err = kenwood_get_id(rig, id);
 
-    if (err != RIG_OK)
+    /* an ID from an earlier open -- the PS query below checks it */
+    fact = rig_facts_get(rig, "id");
+
+    if (rig_facts_get(rig, "verify"))
+    {
+        /* an earlier open found no answer to ID, go straight to FA */
+        fact = NULL;
+        err = -RIG_ETIMEOUT;
+    }
+    else if (fact)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: replaying ID %s\n", __func__, fact);
+        SNPRINTF(id, sizeof(id), "%s", fact);
+        err = RIG_OK;
+    }
+    else
     {
-        // TS450S is flaky on the 1st ID call so we'll try again
-        hl_usleep(200 * 1000);
         err = kenwood_get_id(rig, id);
+
+        if (err != RIG_OK)
+        {
+            // TS450S is flaky on the 1st ID call so we'll try again
+            hl_usleep(200 * 1000);
+            err = kenwood_get_id(rig, id);
+        }
     }
 
     if (err == RIG_OK)   // some rigs give ID while in standby
     {
         powerstat_t powerstat = 0;
+        int got_id = 1;
         rig_debug(RIG_DEBUG_TRACE, "%s: got ID so try PS\n", __func__);
         err = rig_get_powerstat(rig, &powerstat);
 
+        if (fact && err == -RIG_ETIMEOUT)
+        {
+            /* no answer, the replayed ID may be stale: ask for it */
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: no answer to PS, asking for ID\n",
+                      __func__);
+            rig_facts_clear(rig);
+            err = kenwood_get_id(rig, id);
+            got_id = err == RIG_OK;
+        }
+
         if (err == RIG_OK && powerstat == 0 && priv->poweron == 0
                 && rig->state.auto_power_on)
         {
@@ -824,9 +1198,13 @@ int kenwood_open(RIG *rig)
             rig_set_powerstat(rig, 1);
         }
 
-        priv->poweron = 1;
+        if (got_id)
+        {
+            rig_facts_set(rig, "id", id);
+            priv->poweron = 1;
 
-        err = RIG_OK;  // reset our err back to OK for later checks
+            err = RIG_OK;  // reset our err back to OK for later checks
+        }
     }
 
     if (err == -RIG_ETIMEOUT && rig->state.auto_power_on)
@@ -860,8 +1238,17 @@ int kenwood_open(RIG *rig)
         /* we need the firmware version for these rigs to deal with f/w defects */
         static char fw_version[7];
         char *dot_pos;
+        const char *fw = rig_facts_get(rig, "fw");
 
-        err = kenwood_transaction(rig, "FV", fw_version, sizeof(fw_version));
+        if (fw)
+        {
+            SNPRINTF(fw_version, sizeof(fw_version), "FV%s", fw);
+            err = RIG_OK;
+        }
+        else
+        {
+            err = kenwood_transaction(rig, "FV", fw_version, sizeof(fw_version));
+        }
 
         if (RIG_OK != err)
         {
@@ -881,6 +1268,7 @@ int kenwood_open(RIG *rig)
             if (dot_pos)
             {
                 priv->fw_rev_uint = atoi(&fw_version[2]) * 100 + atoi(dot_pos + 1);
+                rig_facts_set(rig, "fw", priv->fw_rev);
             }
             else
             {
@@ -915,6 +1303,7 @@ int kenwood_open(RIG *rig)
         priv->verify_cmd[2] = caps->cmdtrm;
         priv->verify_cmd[3] = '\0';
         strcpy(id, "ID019");      /* fake a TS-2000 */
+        rig_facts_set(rig, "verify", "FA");
     }
     else
     {
@@ -985,9 +1374,14 @@ int kenwood_open(RIG *rig)
             /* get current AI state so it can be restored */
             kenwood_get_trn(rig, &priv->trn_state);  /* ignore errors */
 
-            /* Currently we cannot cope with AI mode so turn it off in
-               case last client left it on */
-            if (priv->trn_state != RIG_TRN_OFF)
+            /* With async data the AI stream feeds the cache, see
+               kenwood_process_async_frame(); otherwise we cannot cope with
+               AI mode so turn it off in case last client left it on */
+            if (rig->state.async_data_enabled)
+            {
+                kenwood_transaction(rig, "AI2", NULL, 0);
+            }
+            else if (priv->trn_state != RIG_TRN_OFF)
             {
                 kenwood_set_trn(rig, RIG_TRN_OFF); /* ignore status in case
                                                       it's not supported */
@@ -1080,62 +1474,227 @@ int kenwood_get_if(RIG *rig)
 {
     struct kenwood_priv_data *priv = rig->state.priv;
     struct kenwood_priv_caps *caps = kenwood_caps(rig);
+    int retval;
 
     ENTERFUNC;
 
-    RETURNFUNC(kenwood_safe_transaction(rig, "IF", priv->info,
-                                        KENWOOD_MAX_BUF_LEN, caps->if_len));
+    retval = kenwood_safe_transaction(rig, "IF", priv->info,
+                                      KENWOOD_MAX_BUF_LEN, caps->if_len);
+
+    if (retval != RIG_OK)
+    {
+        RETURNFUNC(retval);
+    }
+
+    /* an answer from kenwood_transaction's IF cache is decoded already */
+    if (priv->if_data_time.tv_sec == 0
+            || memcmp(&priv->if_data_time, &priv->cache_start,
+                      sizeof(priv->if_data_time)) != 0)
+    {
+        kenwood_decode_if(rig, priv->info, &priv->if_data);
+        kenwood_if_to_cache(rig, &priv->if_data);
+        priv->if_data_time = priv->cache_start;
+    }
+
+    RETURNFUNC(RIG_OK);
 }
 
 
-/* FN FR FT
- *  Sets the RX/TX VFO or M.CH mode of the transceiver, does not set split
- *  VFO, but leaves it unchanged if in split VFO mode.
- *
- */
-int kenwood_set_vfo(RIG *rig, vfo_t vfo)
+/* up to n digits from s as a frequency, what sscanf(SCNfreq) gives for them */
+static freq_t kenwood_parse_digits(const char *s, size_t n)
 {
-    char cmdbuf[12];
-    int retval;
-    char vfo_function;
-    struct kenwood_priv_data *priv = rig->state.priv;
-
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called vfo=%s\n", __func__, rig_strvfo(vfo));
+    freq_t f = 0;
+    size_t i = 0;
 
+    while (i < n && s[i] == ' ') { i++; }
 
-    /* Emulations do not need to set VFO since VFOB is a copy of VFOA
-     * except for frequency.  And we can change freq without changing VFOS
-     * This prevents a 1.8 second delay in PowerSDR when switching VFOs
-     * We'll do this once if curr_mode has not been set yet
-     */
-    if (priv->is_emulation && priv->curr_mode > 0)
+    for (; i < n && s[i] >= '0' && s[i] <= '9'; i++)
     {
-        TRACE;
-        RETURNFUNC2(RIG_OK);
+        f = f * 10 + (s[i] - '0');
     }
 
-    if (rig->state.current_vfo == vfo)
+    return f;
+}
+
+/*
+ * kenwood_parse_if
+ *  Splits an IF answer of len bytes into its fields in one pass, without
+ *  a rig, so it can be run on recorded answers.  The layout is the common
+ *  one, rigs that differ use their own decoding.
+ *
+ *  IF P1(11) P2(5) P3(5) P4 P5 P6(3) P7 P8 P9 P10 P11 P12 P13 P14(2) P15;
+ */
+int kenwood_parse_if(const char *info, size_t len, const rmode_t mode_table[],
+                     struct kenwood_if_data *ifd)
+{
+    char buf[6];
+
+    memset(ifd, 0, sizeof(*ifd));
+    ifd->split = -1;
+
+    if (len < 31)
     {
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: vfo already is %s...skipping\n", __func__,
-                  rig_strvfo(vfo));
-        RETURNFUNC2(RIG_OK);
+        rig_debug(RIG_DEBUG_ERR, "%s: IF answer too short '%.*s'\n", __func__,
+                  (int) len, info);
+        return -RIG_EPROTO;
     }
 
-    switch (vfo)
-    {
-    case RIG_VFO_A:
-        vfo_function = '0';
-        break;
+    ifd->freq = kenwood_parse_digits(info + 2, 11);
 
-    case RIG_VFO_B:
-        vfo_function = '1';
-        break;
+    memcpy(buf, info + 18, 5);
+    buf[5] = '\0';
+    ifd->rit = atoi(buf);
 
-    case RIG_VFO_MEM:
-        vfo_function = '2';
-        break;
+    ifd->rit_on = info[23] == '1';
+    ifd->xit_on = info[24] == '1';
 
-    case RIG_VFO_TX:
+    memcpy(buf, info + 26, 2);
+    buf[2] = '\0';
+    ifd->mem_ch = atoi(buf);
+
+    ifd->ptt = info[28] == '0' ? RIG_PTT_OFF : RIG_PTT_ON;
+    ifd->mode = kenwood2rmode(info[29] - '0', mode_table);
+    ifd->function = info[30];
+
+    switch (len > 32 ? info[32] : '\0')
+    {
+    case '0': ifd->split = RIG_SPLIT_OFF; break;
+
+    case '1': ifd->split = RIG_SPLIT_ON; break;
+    }
+
+    return RIG_OK;
+}
+
+int kenwood_decode_if(RIG *rig, const char *info, struct kenwood_if_data *ifd)
+{
+    return kenwood_parse_if(info, strlen(info), kenwood_caps(rig)->mode_table,
+                            ifd);
+}
+
+
+/*
+ * One IF answers a whole polling cycle: what the rig's own get functions
+ * would work out from it goes to the rig cache.  Nothing is cached while
+ * transmitting split, when the IF shows the TX side.
+ */
+static void kenwood_if_to_cache(RIG *rig, const struct kenwood_if_data *ifd)
+{
+    struct rig_state *rs = &rig->state;
+    const struct rig_caps *caps = rig->caps;
+    vfo_t vfo;
+
+    switch (ifd->function)
+    {
+    case '0': vfo = RIG_VFO_A; break;
+
+    case '1': vfo = RIG_VFO_B; break;
+
+    case '2': vfo = RIG_VFO_MEM; break;
+
+    default: vfo = RIG_VFO_NONE;
+    }
+
+    if (ifd->ptt == RIG_PTT_OFF || ifd->split != RIG_SPLIT_ON)
+    {
+        if (vfo != RIG_VFO_NONE && ifd->freq > 0)
+        {
+            rig_set_cache_freq(rig, vfo, ifd->freq);
+        }
+
+        /* same answer kenwood_get_mode_if() would give */
+        if (vfo != RIG_VFO_NONE && caps->get_mode == kenwood_get_mode_if
+                && ifd->mode != RIG_MODE_NONE
+                && !(RIG_IS_TS450S || RIG_IS_TS690S || RIG_IS_TS850 || RIG_IS_TS950S
+                     || RIG_IS_TS950SDX))
+        {
+            rig_set_cache_mode(rig, vfo, ifd->mode, rig_passband_normal(rig, ifd->mode));
+        }
+
+        /* P4/P5 are what RT;/XT; would answer */
+        if ((vfo == RIG_VFO_A || vfo == RIG_VFO_B) && caps->get_func == kenwood_get_func)
+        {
+            rig_set_cache_func(rig, vfo, RIG_FUNC_RIT, ifd->rit_on);
+            rig_set_cache_func(rig, vfo, RIG_FUNC_XIT, ifd->xit_on);
+        }
+    }
+
+    rig_cache_write_begin(rig);
+
+    rs->cache.ptt = ifd->ptt;
+    elapsed_ms(&rs->cache.time_ptt, HAMLIB_ELAPSED_SET);
+
+    if (ifd->ptt == RIG_PTT_OFF || ifd->split != RIG_SPLIT_ON)
+    {
+        if (vfo != RIG_VFO_NONE && caps->get_vfo == kenwood_get_vfo_if)
+        {
+            rs->cache.vfo = vfo;
+            elapsed_ms(&rs->cache.time_vfo, HAMLIB_ELAPSED_SET);
+        }
+
+        /* only where kenwood_get_split_vfo_if() agrees on the TX VFO */
+        if (caps->get_split_vfo == kenwood_get_split_vfo_if && !RIG_IS_TS990S
+                && ifd->split >= 0 && vfo != RIG_VFO_MEM && vfo == rs->rx_vfo)
+        {
+            rs->cache.split = ifd->split;
+            rs->cache.split_vfo = ifd->split == RIG_SPLIT_OFF ? vfo
+                                  : vfo == RIG_VFO_A ? RIG_VFO_B : RIG_VFO_A;
+            elapsed_ms(&rs->cache.time_split, HAMLIB_ELAPSED_SET);
+        }
+    }
+
+    rig_cache_write_end(rig);
+}
+
+
+/* FN FR FT
+ *  Sets the RX/TX VFO or M.CH mode of the transceiver, does not set split
+ *  VFO, but leaves it unchanged if in split VFO mode.
+ *
+ */
+int kenwood_set_vfo(RIG *rig, vfo_t vfo)
+{
+    char cmdbuf[12];
+    int retval;
+    char vfo_function;
+    struct kenwood_priv_data *priv = rig->state.priv;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called vfo=%s\n", __func__, rig_strvfo(vfo));
+
+
+    /* Emulations do not need to set VFO since VFOB is a copy of VFOA
+     * except for frequency.  And we can change freq without changing VFOS
+     * This prevents a 1.8 second delay in PowerSDR when switching VFOs
+     * We'll do this once if curr_mode has not been set yet
+     */
+    if (priv->is_emulation && priv->curr_mode > 0)
+    {
+        TRACE;
+        RETURNFUNC2(RIG_OK);
+    }
+
+    if (rig->state.current_vfo == vfo)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: vfo already is %s...skipping\n", __func__,
+                  rig_strvfo(vfo));
+        RETURNFUNC2(RIG_OK);
+    }
+
+    switch (vfo)
+    {
+    case RIG_VFO_A:
+        vfo_function = '0';
+        break;
+
+    case RIG_VFO_B:
+        vfo_function = '1';
+        break;
+
+    case RIG_VFO_MEM:
+        vfo_function = '2';
+        break;
+
+    case RIG_VFO_TX:
         vfo_function = rig->state.tx_vfo == RIG_VFO_B ? '1' : '0';
         break;
 
@@ -1597,30 +2156,23 @@ int kenwood_get_split_vfo_if(RIG *rig, vfo_t rxvfo, split_t *split,
         RETURNFUNC(retval);
     }
 
-    switch (priv->info[32])
+    if (priv->if_data.split < 0)
     {
-    case '0':
-        *split = RIG_SPLIT_OFF;
-        break;
-
-    case '1':
-        *split = RIG_SPLIT_ON;
-        break;
-
-    default:
         rig_debug(RIG_DEBUG_ERR, "%s: unsupported split %c\n",
                   __func__, priv->info[32]);
         RETURNFUNC(-RIG_EPROTO);
     }
 
+    *split = priv->if_data.split;
+
     /* Remember whether split is on, for kenwood_set_vfo */
     priv->split = *split;
 
     /* find where is the txvfo.. */
     /* Elecraft info[30] does not track split VFO when transmitting */
-    transmitting = '1' == priv->info[28] && !RIG_IS_K2 && !RIG_IS_K3;
+    transmitting = priv->if_data.ptt != RIG_PTT_OFF && !RIG_IS_K2 && !RIG_IS_K3;
 
-    switch (priv->info[30])
+    switch (priv->if_data.function)
     {
     case '0':
         if (rig->state.rx_vfo == RIG_VFO_A)
@@ -1711,18 +2263,18 @@ int kenwood_get_vfo_if(RIG *rig, vfo_t *vfo)
 
     /* Elecraft info[30] does not track split VFO when transmitting */
     split_and_transmitting =
-        '1' == priv->info[28] /* transmitting */
-        && '1' == priv->info[32]               /* split */
+        priv->if_data.ptt != RIG_PTT_OFF        /* transmitting */
+        && priv->if_data.split == RIG_SPLIT_ON  /* split */
         && !RIG_IS_K2
         && !RIG_IS_K3;
 
-    switch (priv->info[30])
+    switch (priv->if_data.function)
     {
     case '0':
         *vfo = rig->state.rx_vfo = rig->state.tx_vfo = priv->tx_vfo =
                                        split_and_transmitting ? RIG_VFO_B : RIG_VFO_A;
 
-        if (priv->info[32] == '1') { priv->tx_vfo = RIG_VFO_B; }
+        if (priv->if_data.split == RIG_SPLIT_ON) { priv->tx_vfo = RIG_VFO_B; }
 
         break;
 
@@ -1866,7 +2418,6 @@ int kenwood_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
 int kenwood_get_freq_if(RIG *rig, vfo_t vfo, freq_t *freq)
 {
     struct kenwood_priv_data *priv = rig->state.priv;
-    char freqbuf[50];
     int retval;
 
     ENTERFUNC;
@@ -1883,9 +2434,7 @@ int kenwood_get_freq_if(RIG *rig, vfo_t vfo, freq_t *freq)
         RETURNFUNC(retval);
     }
 
-    memcpy(freqbuf, priv->info, 15);
-    freqbuf[14] = '\0';
-    sscanf(freqbuf + 2, "%"SCNfreq, freq);
+    *freq = priv->if_data.freq;
 
     RETURNFUNC(RIG_OK);
 }
@@ -1971,7 +2520,6 @@ int kenwood_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
 int kenwood_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
 {
     int retval;
-    char buf[7];
     struct kenwood_priv_data *priv = rig->state.priv;
 
     ENTERFUNC;
@@ -1989,10 +2537,7 @@ int kenwood_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
     }
 
     // TODO: Fix for different rigs
-    memcpy(buf, &priv->info[17], 6);
-
-    buf[6] = '\0';
-    *rit = atoi(buf);
+    *rit = priv->if_data.rit;
 
     RETURNFUNC(RIG_OK);
 }
@@ -2693,7 +3238,6 @@ int kenwood_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
 int kenwood_get_mode_if(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
 {
     int err;
-    struct kenwood_priv_caps *caps = kenwood_caps(rig);
     struct kenwood_priv_data *priv = rig->state.priv;
 
     ENTERFUNC;
@@ -2710,7 +3254,7 @@ int kenwood_get_mode_if(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
         RETURNFUNC(err);
     }
 
-    *mode = kenwood2rmode(priv->info[29] - '0', caps->mode_table);
+    *mode = priv->if_data.mode;
 
     *width = rig_passband_normal(rig, *mode);
 
@@ -3024,15 +3568,243 @@ static int kenwood_find_slope_filter_for_value(RIG *rig, vfo_t vfo,
     return -RIG_EINVAL;
 }
 
+/*
+ * Levels and funcs that are a command and a fixed width number, scaled
+ * linearly, are set and read from this table instead of the switches in
+ * kenwood_set_level() and friends.  An entry naming a model replaces the
+ * generic one for that model; kenwood_init() resolves them per rig into
+ * priv->level_map and priv->func_map, so a call is one index, and the
+ * command is built and its answer parsed without snprintf or sscanf.
+ */
+struct kenwood_setting
+{
+    setting_t setting;
+    rig_model_t model;      /* RIG_MODEL_NONE for the models without their own */
+    const char *set;        /* command prefix, NULL if it cannot be set */
+    const char *get;        /* query, NULL if it cannot be read */
+    unsigned char width;    /* digits of the value */
+    unsigned char repeat;   /* times the value is sent and answered, PL has 2 */
+    int scale;              /* raw = value * scale, a float level being 0..1 */
+    int min, max;           /* int levels: accepted values, unchecked if equal;
+                               funcs: max is the highest status sent as is */
+};
+
+static const struct kenwood_setting kenwood_level_table[] =
+{
+    { RIG_LEVEL_RF, RIG_MODEL_NONE, "RG", "RG", 3, 1, 255, 0, 0 },
+    { RIG_LEVEL_SQL, RIG_MODEL_NONE, "SQ0", NULL, 3, 1, 255, 0, 0 },
+    { RIG_LEVEL_KEYSPD, RIG_MODEL_NONE, "KS", "KS", 3, 1, 1, 5, 60 },
+    { RIG_LEVEL_COMP, RIG_MODEL_NONE, "PL", "PL", 3, 2, 100, 0, 0 },
+    { RIG_LEVEL_COMP, RIG_MODEL_TS990S, "PL", "PL", 3, 2, 255, 0, 0 },
+    { RIG_LEVEL_VOXDELAY, RIG_MODEL_NONE, "VD", "VD", 4, 1, 100, 0, 30 },   /* raw in ms */
+    { RIG_LEVEL_VOXGAIN, RIG_MODEL_NONE, "VG", "VG", 3, 1, 9, 0, 0 },
+    { RIG_LEVEL_BKIN_DLYMS, RIG_MODEL_NONE, "SD", "SD", 4, 1, 1, 0, 1000 },
+    { RIG_LEVEL_RAWSTR, RIG_MODEL_NONE, NULL, "SM", 4, 1, 1, 0, 0 },
+    { RIG_LEVEL_RAWSTR, RIG_MODEL_TS590S, NULL, "SM0", 4, 1, 1, 0, 0 },
+    { RIG_LEVEL_RAWSTR, RIG_MODEL_TS590SG, NULL, "SM0", 4, 1, 1, 0, 0 },
+};
+
+static const struct kenwood_setting kenwood_func_table[] =
+{
+    { RIG_FUNC_NB, RIG_MODEL_NONE, "NB", "NB", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_NB, RIG_MODEL_TS890S, "NB1", "NB1", 1, 1, 1, 0, 1 },   /* newer Kenwoods have a second noise blanker */
+    { RIG_FUNC_NB2, RIG_MODEL_NONE, "NB2", "NB2", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_ABM, RIG_MODEL_NONE, "AM", "AM", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_COMP, RIG_MODEL_NONE, "PR", "PR", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_COMP, RIG_MODEL_TS890S, "PR0", "PR", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_TONE, RIG_MODEL_NONE, "TO", "TO", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_TSQL, RIG_MODEL_NONE, "CT", "CT", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_VOX, RIG_MODEL_NONE, "VX", "VX", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_NR, RIG_MODEL_NONE, "NR", "NR", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_NR, RIG_MODEL_TS890S, "NR", "NR", 1, 1, 1, 0, 2 },     /* NR1 and NR2 */
+    { RIG_FUNC_ANF, RIG_MODEL_NONE, "NT", "NT", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_LOCK, RIG_MODEL_NONE, "LK", "LK", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_AIP, RIG_MODEL_NONE, "MX", "MX", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_RIT, RIG_MODEL_NONE, "RT", "RT", 1, 1, 1, 0, 1 },
+    { RIG_FUNC_XIT, RIG_MODEL_NONE, "XT", "XT", 1, 1, 1, 0, 1 },
+};
+
+#define KENWOOD_TABLE_LEN(t) (int)(sizeof(t) / sizeof((t)[0]))
+
+/* bit number of a single setting in six steps, -1 if it is not one bit */
+static int kenwood_setting_idx(setting_t setting)
+{
+    int idx = 0, shift;
+
+    if (!setting || (setting & (setting - 1)))
+    {
+        return -1;
+    }
+
+    for (shift = 32; shift; shift >>= 1)
+    {
+        if (setting >> shift)
+        {
+            setting >>= shift;
+            idx += shift;
+        }
+    }
+
+    return idx;
+}
+
+static void kenwood_setting_map(RIG *rig, const struct kenwood_setting *table,
+                                int len, const struct kenwood_setting *map[])
+{
+    int i, idx;
+
+    for (i = 0; i < len; i++)
+    {
+        if (table[i].model != RIG_MODEL_NONE
+                && table[i].model != rig->caps->rig_model)
+        {
+            continue;
+        }
+
+        idx = kenwood_setting_idx(table[i].setting);
+
+        // the model's own entry wins whatever the order
+        if (idx >= 0 && (!map[idx] || table[i].model != RIG_MODEL_NONE))
+        {
+            map[idx] = &table[i];
+        }
+    }
+}
+
+/* fills priv->level_map and priv->func_map for this model */
+static void kenwood_settings_init(RIG *rig)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+
+    kenwood_setting_map(rig, kenwood_level_table,
+                        KENWOOD_TABLE_LEN(kenwood_level_table), priv->level_map);
+    kenwood_setting_map(rig, kenwood_func_table,
+                        KENWOOD_TABLE_LEN(kenwood_func_table), priv->func_map);
+}
+
+static const struct kenwood_setting *kenwood_setting_find(
+    const struct kenwood_setting *const map[], setting_t setting)
+{
+    int idx = kenwood_setting_idx(setting);
+
+    return idx < 0 ? NULL : map[idx];
+}
+
+/* sends the set command of ks with raw, zero padded, repeat times */
+static int kenwood_setting_set(RIG *rig, const struct kenwood_setting *ks,
+                               int raw)
+{
+    char cmd[16];
+    size_t n = strlen(ks->set);
+    int i, j, v;
+
+    if (raw < 0 || n + ks->width * ks->repeat >= sizeof(cmd))
+    {
+        return -RIG_EINVAL;
+    }
+
+    memcpy(cmd, ks->set, n);
+
+    for (i = 0; i < ks->repeat; i++)
+    {
+        for (j = ks->width - 1, v = raw; j >= 0; j--, v /= 10)
+        {
+            cmd[n + j] = '0' + v % 10;
+        }
+
+        n += ks->width;
+    }
+
+    cmd[n] = '\0';
+
+    return kenwood_transaction(rig, cmd, NULL, 0);
+}
+
+/* reads the raw value of ks, the first one if the answer repeats it */
+static int kenwood_setting_get(RIG *rig, const struct kenwood_setting *ks,
+                               int *raw)
+{
+    char buf[KENWOOD_MAX_BUF_LEN];
+    size_t n = strlen(ks->get);
+    int retval;
+
+    retval = kenwood_safe_transaction(rig, ks->get, buf, sizeof(buf),
+                                      n + ks->width * ks->repeat);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    *raw = (int) kenwood_parse_digits(buf + n, ks->width);
+
+    return RIG_OK;
+}
+
+static int kenwood_set_level_table(RIG *rig, const struct kenwood_setting *ks,
+                                   setting_t level, value_t val)
+{
+    int raw;
+
+    if (RIG_LEVEL_IS_FLOAT(level))
+    {
+        if (val.f > 1.0 || val.f < 0) { return -RIG_EINVAL; }
+
+        raw = val.f * ks->scale;
+    }
+    else
+    {
+        if (ks->min != ks->max && (val.i < ks->min || val.i > ks->max))
+        {
+            return -RIG_EINVAL;
+        }
+
+        raw = val.i * ks->scale;
+    }
+
+    return kenwood_setting_set(rig, ks, raw);
+}
+
+static int kenwood_get_level_table(RIG *rig, const struct kenwood_setting *ks,
+                                   setting_t level, value_t *val)
+{
+    int raw;
+    int retval = kenwood_setting_get(rig, ks, &raw);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    if (RIG_LEVEL_IS_FLOAT(level))
+    {
+        val->f = (float) raw / ks->scale;
+    }
+    else
+    {
+        val->i = raw / ks->scale;
+    }
+
+    return RIG_OK;
+}
+
+
 int kenwood_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
 {
     char levelbuf[16];
     int i, kenwood_val;
     struct kenwood_priv_data *priv = rig->state.priv;
     struct kenwood_priv_caps *caps = kenwood_caps(rig);
+    const struct kenwood_setting *ks = kenwood_setting_find(priv->level_map,
+                                       level);
 
     ENTERFUNC;
 
+    if (ks && ks->set)
+    {
+        RETURNFUNC(kenwood_set_level_table(rig, ks, level, val));
+    }
+
     if (RIG_LEVEL_IS_FLOAT(level))
     {
         if (val.f > 1.0) { RETURNFUNC(-RIG_EINVAL); }
@@ -3119,21 +3891,6 @@ int kenwood_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
         break;
     }
 
-    case RIG_LEVEL_RF:
-
-        /* XXX check level range */
-        // KX2 and KX3 have range -190 to 250
-        if (val.f > 1.0 || val.f < 0) { RETURNFUNC(-RIG_EINVAL); }
-
-        kenwood_val = val.f * 255.0;
-        SNPRINTF(levelbuf, sizeof(levelbuf), "RG%03d", kenwood_val);
-        break;
-
-    case RIG_LEVEL_SQL:
-        /* Default to RX#0 */
-        SNPRINTF(levelbuf, sizeof(levelbuf), "SQ0%03d", kenwood_val);
-        break;
-
     case RIG_LEVEL_AGC:
         if (kenwood_val > 3)
         {
@@ -3246,52 +4003,6 @@ int kenwood_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
         SNPRINTF(levelbuf, sizeof(levelbuf), "PT%02d", (val.i / 50) - 8);
         break;
 
-    case RIG_LEVEL_KEYSPD:
-        if (val.i > 60 || val.i < 5)
-        {
-            RETURNFUNC(-RIG_EINVAL);
-        }
-
-        SNPRINTF(levelbuf, sizeof(levelbuf), "KS%03d", val.i);
-        break;
-
-    case RIG_LEVEL_COMP:
-        if (RIG_IS_TS990S)
-        {
-            kenwood_val = val.f * 255.0f;
-        }
-        else
-        {
-            kenwood_val = val.f * 100.0f;
-        }
-
-        SNPRINTF(levelbuf, sizeof(levelbuf), "PL%03d%03d", kenwood_val, kenwood_val);
-        break;
-
-    case RIG_LEVEL_VOXDELAY:
-        if (val.i > 30 || val.i < 0)
-        {
-            RETURNFUNC(-RIG_EINVAL);
-        }
-
-        // Raw value is in milliseconds
-        SNPRINTF(levelbuf, sizeof(levelbuf), "VD%04d", val.i * 100);
-        break;
-
-    case RIG_LEVEL_VOXGAIN:
-        kenwood_val = val.f * 9.0f;
-        SNPRINTF(levelbuf, sizeof(levelbuf), "VG%03d", kenwood_val);
-        break;
-
-    case RIG_LEVEL_BKIN_DLYMS:
-        if (val.i > 1000 || val.i < 0)
-        {
-            RETURNFUNC(-RIG_EINVAL);
-        }
-
-        SNPRINTF(levelbuf, sizeof(levelbuf), "SD%04d", val.i);
-        break;
-
     default:
         rig_debug(RIG_DEBUG_ERR, "%s: unsupported set_level %s", __func__,
                   rig_strlevel(level));
@@ -3345,6 +4056,8 @@ int kenwood_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
     int i, ret, agclevel, len, value;
     struct kenwood_priv_data *priv = rig->state.priv;
     struct kenwood_priv_caps *caps = kenwood_caps(rig);
+    const struct kenwood_setting *ks = kenwood_setting_find(priv->level_map,
+                                       level);
 
     ENTERFUNC;
 
@@ -3353,33 +4066,15 @@ int kenwood_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    if (ks && ks->get)
+    {
+        RETURNFUNC(kenwood_get_level_table(rig, ks, level, val));
+    }
+
     switch (level)
     {
         int power_now, power_min, power_max;
 
-    case RIG_LEVEL_RAWSTR:
-        if (RIG_IS_TS590S || RIG_IS_TS590SG)
-        {
-            cmd = "SM0";
-            len = 3;
-        }
-        else
-        {
-            cmd = "SM";
-            len = 2;
-        }
-
-        retval = kenwood_safe_transaction(rig, cmd, lvlbuf, 10, len + 4);
-
-        if (retval != RIG_OK)
-        {
-            RETURNFUNC(retval);
-        }
-
-        /* XXX atoi ? */
-        sscanf(lvlbuf + len, "%d", &val->i); /* rawstr */
-        break;
-
     case RIG_LEVEL_STRENGTH:
         if (RIG_IS_TS590S || RIG_IS_TS590SG || RIG_IS_TS480)
         {
@@ -3587,11 +4282,6 @@ int kenwood_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
             RETURNFUNC(-RIG_EPROTO);
         }
 
-    case RIG_LEVEL_RF:
-        RETURNFUNC(get_kenwood_level(rig, "RG", &val->f, NULL));
-
-
-
     case RIG_LEVEL_MICGAIN:
     {
         int micgain_now;
@@ -3699,90 +4389,6 @@ int kenwood_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
         val->i = (val->i * 1000) + 1000; /* 00 - 08 */
         break;
 
-    case RIG_LEVEL_KEYSPD:
-        retval = kenwood_safe_transaction(rig, "KS", lvlbuf, 50, 5);
-
-        if (retval != RIG_OK)
-        {
-            RETURNFUNC(retval);
-        }
-
-        sscanf(lvlbuf + 2, "%d", &val->i);
-        break;
-
-    case RIG_LEVEL_COMP:
-    {
-        int raw_value;
-        retval = kenwood_safe_transaction(rig, "PL", lvlbuf, 50, 8);
-
-        if (retval != RIG_OK)
-        {
-            RETURNFUNC(retval);
-        }
-
-        sscanf(lvlbuf + 2, "%3d", &raw_value);
-
-        if (RIG_IS_TS990S)
-        {
-            val->f = (float) raw_value / 255.0f;
-        }
-        else
-        {
-            val->f = (float) raw_value / 100.0f;
-        }
-
-        break;
-    }
-
-    case RIG_LEVEL_VOXDELAY:
-    {
-        int raw_value;
-        retval = kenwood_safe_transaction(rig, "VD", lvlbuf, 50, 6);
-
-        if (retval != RIG_OK)
-        {
-            RETURNFUNC(retval);
-        }
-
-        sscanf(lvlbuf + 2, "%d", &raw_value);
-
-        // Value is in milliseconds
-        val->i = raw_value / 100;
-        break;
-    }
-
-    case RIG_LEVEL_VOXGAIN:
-    {
-        int raw_value;
-        retval = kenwood_safe_transaction(rig, "VG", lvlbuf, 50, 5);
-
-        if (retval != RIG_OK)
-        {
-            RETURNFUNC(retval);
-        }
-
-        sscanf(lvlbuf + 2, "%d", &raw_value);
-
-        val->f = (float) raw_value / 9.0f;
-        break;
-    }
-
-    case RIG_LEVEL_BKIN_DLYMS:
-    {
-        int raw_value;
-        retval = kenwood_safe_transaction(rig, "SD", lvlbuf, 50, 6);
-
-        if (retval != RIG_OK)
-        {
-            RETURNFUNC(retval);
-        }
-
-        sscanf(lvlbuf + 2, "%d", &raw_value);
-
-        val->i = raw_value;
-        break;
-    }
-
     case RIG_LEVEL_IF:
     case RIG_LEVEL_APF:
     case RIG_LEVEL_NR:
@@ -3805,88 +4411,24 @@ int kenwood_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
 int kenwood_set_func(RIG *rig, vfo_t vfo, setting_t func, int status)
 {
     char buf[10]; /* longest cmd is GTxxx */
+    struct kenwood_priv_data *priv = rig->state.priv;
+    const struct kenwood_setting *ks = kenwood_setting_find(priv->func_map, func);
 
     ENTERFUNC;
 
-    switch (func)
+    if (ks && ks->set)
     {
-    case RIG_FUNC_NB:
-    case RIG_FUNC_NB2:
-
-        /* newer Kenwoods have a second noise blanker */
-        if (RIG_IS_TS890S)
-        {
-            switch (func)
-            {
-            case RIG_FUNC_NB:
-                SNPRINTF(buf, sizeof(buf), "NB1%c", (status == 0) ? '0' : '1');
-                break;
-
-            case RIG_FUNC_NB2:
-                SNPRINTF(buf, sizeof(buf), "NB2%c", (status == 0) ? '0' : '1');
-                break;
-
-            default:
-                rig_debug(RIG_DEBUG_ERR, "%s: expected 0,1, or 2 and got %d\n", __func__,
-                          status);
-                RETURNFUNC(-RIG_EINVAL);
-            }
-        }
-        else
-        {
-            SNPRINTF(buf, sizeof(buf), "NB%c", (status == 0) ? '0' : '1');
-        }
-
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
-
-    case RIG_FUNC_ABM:
-        SNPRINTF(buf, sizeof(buf), "AM%c", (status == 0) ? '0' : '1');
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
-
-    case RIG_FUNC_COMP:
-        if (RIG_IS_TS890S)
-        {
-            SNPRINTF(buf, sizeof(buf), "PR0%c", (status == 0) ? '0' : '1');
-        }
-        else
-        {
-            SNPRINTF(buf, sizeof(buf), "PR%c", (status == 0) ? '0' : '1');
-        }
-
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
-
-    case RIG_FUNC_TONE:
-        SNPRINTF(buf, sizeof(buf), "TO%c", (status == 0) ? '0' : '1');
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
-
-    case RIG_FUNC_TSQL:
-        SNPRINTF(buf, sizeof(buf), "CT%c", (status == 0) ? '0' : '1');
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
-
-    case RIG_FUNC_VOX:
-        SNPRINTF(buf, sizeof(buf), "VX%c", (status == 0) ? '0' : '1');
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
+        // anything but 0 is on, and a rig with more than one on state takes those
+        RETURNFUNC(kenwood_setting_set(rig, ks,
+                                       status >= 1 && status <= ks->max ? status : status != 0));
+    }
 
+    switch (func)
+    {
     case RIG_FUNC_FAGC:
         SNPRINTF(buf, sizeof(buf), "GT00%c", (status == 0) ? '4' : '2');
         RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
 
-    case RIG_FUNC_NR:
-        if (RIG_IS_TS890S)
-        {
-            char c = '1';
-
-            if (status == 2) { c = '2'; }
-
-            SNPRINTF(buf, sizeof(buf), "NR%c", (status == 0) ? '0' : c);
-        }
-        else
-        {
-            SNPRINTF(buf, sizeof(buf), "NR%c", (status == 0) ? '0' : '1');
-        }
-
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
-
     case RIG_FUNC_BC:
         SNPRINTF(buf, sizeof(buf), "BC%c", (status == 0) ? '0' : '1');
         RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
@@ -3895,26 +4437,6 @@ int kenwood_set_func(RIG *rig, vfo_t vfo, setting_t func, int status)
         SNPRINTF(buf, sizeof(buf), "BC%c", (status == 0) ? '0' : '2');
         RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
 
-    case RIG_FUNC_ANF:
-        SNPRINTF(buf, sizeof(buf), "NT%c", (status == 0) ? '0' : '1');
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
-
-    case RIG_FUNC_LOCK:
-        SNPRINTF(buf, sizeof(buf), "LK%c", (status == 0) ? '0' : '1');
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
-
-    case RIG_FUNC_AIP:
-        SNPRINTF(buf, sizeof(buf), "MX%c", (status == 0) ? '0' : '1');
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
-
-    case RIG_FUNC_RIT:
-        SNPRINTF(buf, sizeof(buf), "RT%c", (status == 0) ? '0' : '1');
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
-
-    case RIG_FUNC_XIT:
-        SNPRINTF(buf, sizeof(buf), "XT%c", (status == 0) ? '0' : '1');
-        RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
-
     case RIG_FUNC_TUNER:
         SNPRINTF(buf, sizeof(buf), "AC1%c0", (status == 0) ? '0' : '1');
         RETURNFUNC(kenwood_transaction(rig, buf, NULL, 0));
@@ -3968,10 +4490,11 @@ int get_kenwood_func(RIG *rig, const char *cmd, int *status)
  */
 int kenwood_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
 {
-    char *cmd;
     char respbuf[20];
     int retval;
     int raw_value;
+    struct kenwood_priv_data *priv = rig->state.priv;
+    const struct kenwood_setting *ks = kenwood_setting_find(priv->func_map, func);
 
     ENTERFUNC;
 
@@ -3980,6 +4503,12 @@ int kenwood_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    if (ks && ks->get)
+    {
+        // just return whatever the rig returns, as get_kenwood_func() does
+        RETURNFUNC(kenwood_setting_get(rig, ks, status));
+    }
+
     switch (func)
     {
     case RIG_FUNC_FAGC:
@@ -3993,37 +4522,6 @@ int kenwood_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
         *status = respbuf[4] != '4' ? 1 : 0;
         RETURNFUNC(RIG_OK);
 
-    case RIG_FUNC_NB:
-        cmd = "NB";
-
-        if (RIG_IS_TS890S)
-        {
-            cmd = "NB1";
-        }
-
-        RETURNFUNC(get_kenwood_func(rig, cmd, status));
-
-    case RIG_FUNC_NB2:
-        RETURNFUNC(get_kenwood_func(rig, "NB2", status));
-
-    case RIG_FUNC_ABM:
-        RETURNFUNC(get_kenwood_func(rig, "AM", status));
-
-    case RIG_FUNC_COMP:
-        RETURNFUNC(get_kenwood_func(rig, "PR", status));
-
-    case RIG_FUNC_TONE:
-        RETURNFUNC(get_kenwood_func(rig, "TO", status));
-
-    case RIG_FUNC_TSQL:
-        RETURNFUNC(get_kenwood_func(rig, "CT", status));
-
-    case RIG_FUNC_VOX:
-        RETURNFUNC(get_kenwood_func(rig, "VX", status));
-
-    case RIG_FUNC_NR:
-        RETURNFUNC(get_kenwood_func(rig, "NR", status));
-
     /* FIXME on TS2000 */
     // Check for BC #1
     case RIG_FUNC_BC: // Most will return BC1 or BC0, if BC2 then BC1 is off
@@ -4046,21 +4544,6 @@ int kenwood_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
 
         RETURNFUNC(retval);
 
-    case RIG_FUNC_ANF:
-        RETURNFUNC(get_kenwood_func(rig, "NT", status));
-
-    case RIG_FUNC_LOCK:
-        RETURNFUNC(get_kenwood_func(rig, "LK", status));
-
-    case RIG_FUNC_AIP:
-        RETURNFUNC(get_kenwood_func(rig, "MX", status));
-
-    case RIG_FUNC_RIT:
-        RETURNFUNC(get_kenwood_func(rig, "RT", status));
-
-    case RIG_FUNC_XIT:
-        RETURNFUNC(get_kenwood_func(rig, "XT", status));
-
     case RIG_FUNC_TUNER:
         retval = kenwood_safe_transaction(rig, "AC", respbuf, 20, 5);
 
@@ -4571,11 +5054,171 @@ int kenwood_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
         RETURNFUNC(retval);
     }
 
-    *ptt = priv->info[28] == '0' ? RIG_PTT_OFF : RIG_PTT_ON;
+    *ptt = priv->if_data.ptt;
 
     RETURNFUNC(RIG_OK);
 }
 
+/*
+ * Settings first..end-1 have gone out since the last call: if anything
+ * among them was refused, have rig_set_bulk() redo the ones that looked
+ * fine one at a time to find out which.
+ */
+static void kenwood_bulk_end(RIG *rig, struct rig_setting *settings, int first,
+                             int end)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+    int i;
+
+    kenwood_bulk_flush(rig);
+
+    if (priv->bulk_err == RIG_OK)
+    {
+        return;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s, settings %d-%d go one at a time\n",
+              __func__, rigerror(priv->bulk_err), first, end - 1);
+
+    for (i = first; i < end; i++)
+    {
+        if (settings[i].retval == RIG_OK) { settings[i].retval = -RIG_ENIMPL; }
+    }
+
+    priv->bulk_err = RIG_OK;
+}
+
+/*
+ * kenwood_set_bulk
+ * The set commands of all the settings are chained in one write with a
+ * single ID; behind them, rather than each waiting for its own ID; answer.
+ * A setting that has to read something first sends the ones before it on
+ * the way.  The TH/TM handhelds answer every command and are left to the
+ * generic code.
+ */
+int kenwood_set_bulk(RIG *rig, vfo_t vfo, struct rig_setting *settings,
+                     int count)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+    const struct rig_caps *caps = rig->caps;
+    char bulk[KENWOOD_BULK_LEN];
+    int i, first = 0;
+
+    ENTERFUNC;
+
+    if (kenwood_caps(rig)->cmdtrm != EOM_KEN)
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
+    priv->bulk = bulk;
+    priv->bulk_len = 0;
+    priv->bulk_err = RIG_OK;
+
+    for (i = 0; i < count; i++)
+    {
+        struct rig_setting *s = &settings[i];
+        int flushes = priv->bulk_flushes;
+
+        if (s->retval != -RIG_ENIMPL)
+        {
+            continue;
+        }
+
+        s->retval = s->type == RIG_SETTING_FUNC ?
+                    caps->set_func(rig, vfo, s->setting, s->val.i) :
+                    caps->set_level(rig, vfo, s->setting, s->val);
+
+        if (priv->bulk_flushes != flushes)
+        {
+            // this one may be among those that went out
+            kenwood_bulk_end(rig, settings, first, i + 1);
+            first = i + 1;
+        }
+    }
+
+    kenwood_bulk_end(rig, settings, first, count);
+    priv->bulk = NULL;
+
+    RETURNFUNC(RIG_OK);
+}
+
+/*
+ * kenwood_get_bulk
+ * FA; FB; and IF; go out in one write, and the IF answer is primed into
+ * the IF cache so the split decoding below doesn't hit the wire again.
+ * Modes and meters are left to the generic code.
+ */
+int kenwood_get_bulk(RIG *rig, struct rig_bulk *bulk)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+    struct kenwood_priv_caps *caps = kenwood_caps(rig);
+    char buf[3][KENWOOD_MAX_BUF_LEN];
+    const char *cmds[3];
+    char *replies[3];
+    int ifidx = -1;
+    int n = 0;
+    int retval;
+    int i;
+
+    ENTERFUNC;
+
+    if (bulk->mask & RIG_BULK_FREQ_A) { cmds[n] = "FA;"; replies[n] = buf[n]; n++; }
+
+    if (bulk->mask & RIG_BULK_FREQ_B) { cmds[n] = "FB;"; replies[n] = buf[n]; n++; }
+
+    if (bulk->mask & (RIG_BULK_PTT | RIG_BULK_SPLIT))
+    {
+        ifidx = n;
+        cmds[n] = "IF;";
+        replies[n] = buf[n];
+        n++;
+    }
+
+    if (n == 0) { RETURNFUNC(RIG_OK); }
+
+    retval = rig_transaction_batch(rig, cmds, n, replies, KENWOOD_MAX_BUF_LEN,
+                                   caps->cmdtrm);
+
+    for (i = 0; i < n; i++)
+    {
+        if (i == ifidx || strlen(buf[i]) < 3 || buf[i][0] != 'F') { continue; }
+
+        if (buf[i][1] == 'A' && sscanf(buf[i] + 2, "%"SCNfreq, &bulk->freqA) == 1)
+        {
+            bulk->valid |= RIG_BULK_FREQ_A;
+        }
+        else if (buf[i][1] == 'B'
+                 && sscanf(buf[i] + 2, "%"SCNfreq, &bulk->freqB) == 1)
+        {
+            bulk->valid |= RIG_BULK_FREQ_B;
+        }
+    }
+
+    if (ifidx >= 0 && strncmp(buf[ifidx], "IF", 2) == 0
+            && (RIG_IS_POWERSDR || strlen(buf[ifidx]) == caps->if_len))
+    {
+        strncpy(priv->info, buf[ifidx], KENWOOD_MAX_BUF_LEN - 1);
+        strncpy(priv->last_if_response, buf[ifidx], caps->if_len);
+        elapsed_ms(&priv->cache_start, HAMLIB_ELAPSED_SET);
+
+        if (bulk->mask & RIG_BULK_PTT)
+        {
+            bulk->ptt = priv->info[28] == '0' ? RIG_PTT_OFF : RIG_PTT_ON;
+            bulk->valid |= RIG_BULK_PTT;
+        }
+
+        if ((bulk->mask & RIG_BULK_SPLIT)
+                && kenwood_get_split_vfo_if(rig, RIG_VFO_CURR, &bulk->split,
+                                            &bulk->split_vfo) == RIG_OK)
+        {
+            bulk->valid |= RIG_BULK_SPLIT;
+        }
+    }
+
+    RETURNFUNC(retval);
+}
+
 int kenwood_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 {
     const char *ptt_cmd;
@@ -4752,6 +5395,182 @@ int kenwood_get_trn(RIG *rig, int *trn)
     RETURNFUNC(RIG_OK);
 }
 
+/*
+ * AI (auto information) stream, used when async data is enabled.
+ * The rig is put in AI2 at open and the async data handler in rig.c reads
+ * every frame.  FA, FB, MD, OM, TX, RX and IF reports go to the cache and
+ * the event callbacks; anything else is an answer for kenwood_transaction.
+ * A report seen while a transaction is active is handed on as well since it
+ * may be the answer to the query in flight.
+ */
+static int kenwood_is_report(const unsigned char *frame, size_t frame_length)
+{
+    if (frame_length < 3)
+    {
+        return 0;
+    }
+
+    return !memcmp(frame, "FA", 2) || !memcmp(frame, "FB", 2)
+           || !memcmp(frame, "MD", 2) || !memcmp(frame, "OM", 2)
+           || !memcmp(frame, "TX", 2) || !memcmp(frame, "RX", 2)
+           || !memcmp(frame, "IF", 2);
+}
+
+int kenwood_read_frame_direct(RIG *rig, size_t buffer_length,
+                              const unsigned char *buffer)
+{
+    struct kenwood_priv_caps *caps = kenwood_caps(rig);
+    char cmdtrm_str[2] = { caps->cmdtrm, '\0' };
+    int retval;
+
+    retval = read_string_direct(&rig->state.rigport, (unsigned char *) buffer,
+                                buffer_length - 1, cmdtrm_str, 1, 0, 1);
+
+    if (retval > 0)
+    {
+        ((unsigned char *) buffer)[retval] = '\0';
+    }
+
+    return retval;
+}
+
+int kenwood_is_async_frame(RIG *rig, size_t frame_length,
+                           const unsigned char *frame)
+{
+    return kenwood_is_report(frame, frame_length);
+}
+
+static rmode_t kenwood_report_mode(const rmode_t mode_table[], unsigned char c)
+{
+    int kmode = c <= '9' ? c - '0' : c - 'A' + 10;
+
+    if (kmode < 0)
+    {
+        return RIG_MODE_NONE;
+    }
+
+    return kenwood2rmode(kmode, mode_table);
+}
+
+/*
+ * kenwood_parse_report
+ *  Decodes one auto information report, len bytes without the terminator
+ *  or with it, into what it tells.  Does not need a rig, so it can be run
+ *  on a recorded AI stream.  -RIG_EPROTO if the report says nothing.
+ */
+int kenwood_parse_report(const char *s, size_t len, const rmode_t mode_table[],
+                         struct kenwood_report *r)
+{
+    memset(r, 0, sizeof(*r));
+    r->freq_vfo = r->mode_vfo = r->ptt_vfo = RIG_VFO_CURR;
+
+    if (len < 2)
+    {
+        return -RIG_EPROTO;
+    }
+
+    if (s[0] == 'F' && (s[1] == 'A' || s[1] == 'B'))
+    {
+        if (len > 2 && s[2] >= '0' && s[2] <= '9')
+        {
+            r->freq = kenwood_parse_digits(s + 2, len - 2);
+            r->freq_vfo = s[1] == 'A' ? RIG_VFO_A : RIG_VFO_B;
+            r->have_freq = 1;
+        }
+    }
+    else if (s[0] == 'M' || s[0] == 'O')
+    {
+        /* MDx (K4 MD$x for VFO B), or TS-990S OM0x/OM1x */
+        size_t offs = 2;
+
+        if (len > 2 && s[2] == '$') { r->mode_vfo = RIG_VFO_B; offs = 3; }
+        else if (s[0] == 'O')
+        {
+            r->mode_vfo = len > 2 && s[2] == '1' ? RIG_VFO_SUB : RIG_VFO_MAIN;
+            offs = 3;
+        }
+
+        if (len > offs + 1
+                && (r->mode = kenwood_report_mode(mode_table, s[offs])) != RIG_MODE_NONE)
+        {
+            r->have_mode = 1;
+        }
+    }
+    else if (s[0] == 'T' || s[0] == 'R')
+    {
+        r->ptt = s[0] == 'T' ? RIG_PTT_ON : RIG_PTT_OFF;
+        r->have_ptt = 1;
+    }
+    else if (s[0] == 'I' && len >= 33)
+    {
+        r->freq_vfo = s[30] == '0' ? RIG_VFO_A : s[30] == '1' ? RIG_VFO_B :
+                      RIG_VFO_CURR;
+
+        if (s[2] == ' ' || (s[2] >= '0' && s[2] <= '9'))
+        {
+            r->freq = kenwood_parse_digits(s + 2, 11);
+            r->have_freq = 1;
+        }
+
+        if ((r->mode = kenwood_report_mode(mode_table, s[29])) != RIG_MODE_NONE)
+        {
+            r->have_mode = 1;
+        }
+
+        r->ptt = s[28] == '0' ? RIG_PTT_OFF : RIG_PTT_ON;
+        r->have_ptt = 1;
+    }
+
+    return r->have_freq || r->have_mode || r->have_ptt ? RIG_OK : -RIG_EPROTO;
+}
+
+int kenwood_process_async_frame(RIG *rig, size_t frame_length,
+                                const unsigned char *frame)
+{
+    struct rig_state *rs = &rig->state;
+    struct kenwood_report r;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: %.*s\n", __func__, (int) frame_length,
+              (const char *) frame);
+
+    if (kenwood_parse_report((const char *) frame, frame_length,
+                             kenwood_caps(rig)->mode_table, &r) == RIG_OK)
+    {
+        if (r.have_freq)
+        {
+            rig_fire_freq_event(rig, r.freq_vfo, r.freq);
+            rs->use_cached_freq = 1;
+        }
+
+        if (r.have_mode)
+        {
+            rig_fire_mode_event(rig, r.mode_vfo, r.mode,
+                                rig_passband_normal(rig, r.mode));
+            rs->use_cached_mode = 1;
+        }
+
+        if (r.have_ptt)
+        {
+            rig_fire_ptt_event(rig, r.ptt_vfo, r.ptt);
+            rs->use_cached_ptt = 1;
+        }
+
+        rig_cache_push(rig);
+    }
+
+    if (rs->transaction_active)
+    {
+        int retval = write_block_sync(&rs->rigport, frame, frame_length);
+
+        if (retval < 0)
+        {
+            return retval;
+        }
+    }
+
+    return RIG_OK;
+}
+
 /*
  * kenwood_set_powerstat
  */
@@ -4917,8 +5736,17 @@ int kenwood_send_morse(RIG *rig, vfo_t vfo, const char *msg)
              */
             if (!strncmp(m2, "KY0", 3)) { break; }
 
-            if (!strncmp(m2, "KY1", 3)) { hl_usleep(500000); }
-            else { RETURNFUNC(-RIG_EINVAL); }
+            if (strncmp(m2, "KY1", 3)) { RETURNFUNC(-RIG_EINVAL); }
+
+            // a PTT off or stop_morse from another thread ends the message
+            if (rig_lock_preempt(rig))
+            {
+                rig_debug(RIG_DEBUG_VERBOSE, "%s: rest of the message dropped\n",
+                          __func__);
+                RETURNFUNC(-RIG_ETRUNC);
+            }
+
+            hl_usleep(500000);
         }
 
         buff_len = msg_len > 24 ? 24 : msg_len;
@@ -5117,7 +5945,6 @@ int kenwood_get_mem(RIG *rig, vfo_t vfo, int *ch)
 int kenwood_get_mem_if(RIG *rig, vfo_t vfo, int *ch)
 {
     int err;
-    char buf[4];
     struct kenwood_priv_data *priv = rig->state.priv;
 
     ENTERFUNC;
@@ -5134,53 +5961,26 @@ int kenwood_get_mem_if(RIG *rig, vfo_t vfo, int *ch)
         RETURNFUNC(err);
     }
 
-    memcpy(buf, &priv->info[26], 2);
-    buf[2] = '\0';
-
-    *ch = atoi(buf);
+    *ch = priv->if_data.mem_ch;
 
     RETURNFUNC(RIG_OK);
 }
 
-int kenwood_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
+/*
+ * MR0 1700005890000510   ;
+ * MRsbccfffffffffffMLTtt ;
+ *
+ * Decodes the simplex (MR0) answer of a memory read into chan, the split
+ * (MR1) answer goes through kenwood_parse_mr_split() afterwards.
+ */
+static int kenwood_parse_mr(RIG *rig, char *buf, channel_t *chan)
 {
-    int err;
-    char buf[26];
-    char cmd[8];
-    char bank = ' ';
     struct kenwood_priv_caps *caps = kenwood_caps(rig);
 
-    ENTERFUNC;
-
-    if (!chan)
-    {
-        RETURNFUNC(-RIG_EINVAL);
-    }
-
-    /* put channel num in the command string */
-
-    if (RIG_IS_TS940)
-    {
-        bank = '0' + chan->bank_num;
-    }
-
-    SNPRINTF(cmd, sizeof(cmd), "MR0%c%02d", bank, chan->channel_num);
-
-    err = kenwood_safe_transaction(rig, cmd, buf, 26, 23);
-
-    if (err != RIG_OK)
-    {
-        RETURNFUNC(err);
-    }
-
     memset(chan, 0x00, sizeof(channel_t));
 
     chan->vfo = RIG_VFO_VFO;
 
-    /* MR0 1700005890000510   ;
-     * MRsbccfffffffffffMLTtt ;
-     */
-
     /* parse from right to left */
 
     /* XXX based on the available documentation, there is no command
@@ -5215,7 +6015,7 @@ int kenwood_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
 
     if (chan->freq == RIG_FREQ_NONE)
     {
-        RETURNFUNC(-RIG_ENAVAIL);
+        return -RIG_ENAVAIL;
     }
 
     buf[6] = '\0';
@@ -5226,14 +6026,12 @@ int kenwood_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
         chan->bank_num = buf[3] - '0';
     }
 
-    /* split freq */
-    cmd[2] = '1';
-    err = kenwood_safe_transaction(rig, cmd, buf, 26, 23);
+    return RIG_OK;
+}
 
-    if (err != RIG_OK)
-    {
-        RETURNFUNC(err);
-    }
+static void kenwood_parse_mr_split(RIG *rig, char *buf, channel_t *chan)
+{
+    struct kenwood_priv_caps *caps = kenwood_caps(rig);
 
     chan->tx_mode = kenwood2rmode(buf[17] - '0', caps->mode_table);
 
@@ -5250,6 +6048,54 @@ int kenwood_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
     {
         chan->split = RIG_SPLIT_ON;
     }
+}
+
+static char kenwood_mr_bank(RIG *rig, int bank_num)
+{
+    return RIG_IS_TS940 ? '0' + bank_num : ' ';
+}
+
+int kenwood_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
+{
+    int err;
+    char buf[26];
+    char cmd[8];
+
+    ENTERFUNC;
+
+    if (!chan)
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    /* put channel num in the command string */
+    SNPRINTF(cmd, sizeof(cmd), "MR0%c%02d", kenwood_mr_bank(rig, chan->bank_num),
+             chan->channel_num);
+
+    err = kenwood_safe_transaction(rig, cmd, buf, 26, 23);
+
+    if (err != RIG_OK)
+    {
+        RETURNFUNC(err);
+    }
+
+    err = kenwood_parse_mr(rig, buf, chan);
+
+    if (err != RIG_OK)
+    {
+        RETURNFUNC(err);
+    }
+
+    /* split freq */
+    cmd[2] = '1';
+    err = kenwood_safe_transaction(rig, cmd, buf, 26, 23);
+
+    if (err != RIG_OK)
+    {
+        RETURNFUNC(err);
+    }
+
+    kenwood_parse_mr_split(rig, buf, chan);
 
     if (!read_only)
     {
@@ -5264,6 +6110,104 @@ int kenwood_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only)
     RETURNFUNC(RIG_OK);
 }
 
+/*
+ * Dumps the memory bank with MR0/MR1 pairs for KENWOOD_MR_BURST channels
+ * in a single write through rig_transaction_batch(), so a bank costs one
+ * round trip per burst instead of two per channel.  A channel whose answer
+ * is not a memory read (e.g. "?;" for an unused slot) is reported empty.
+ */
+#define KENWOOD_MR_BURST 8
+
+int kenwood_get_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
+                            rig_ptr_t arg)
+{
+    struct kenwood_priv_caps *caps = kenwood_caps(rig);
+    const chan_t *chan_list = rig->state.chan_list;
+    char cmdbuf[2 * KENWOOD_MR_BURST][8];
+    char buf[2 * KENWOOD_MR_BURST][KENWOOD_MAX_BUF_LEN];
+    const char *cmds[2 * KENWOOD_MR_BURST];
+    char *replies[2 * KENWOOD_MR_BURST];
+    channel_t *chan;
+    int i, j, k, n;
+    int retval;
+
+    ENTERFUNC;
+
+    for (k = 0; k < 2 * KENWOOD_MR_BURST; k++)
+    {
+        cmds[k] = cmdbuf[k];
+        replies[k] = buf[k];
+    }
+
+    for (i = 0; !RIG_IS_CHAN_END(chan_list[i]) && i < HAMLIB_CHANLSTSIZ; i++)
+    {
+        chan = NULL;
+        retval = chan_cb(rig, &chan, chan_list[i].startc, chan_list, arg);
+
+        if (retval != RIG_OK)
+        {
+            RETURNFUNC(retval);
+        }
+
+        if (chan == NULL)
+        {
+            RETURNFUNC(-RIG_ENOMEM);
+        }
+
+        for (j = chan_list[i].startc; j <= chan_list[i].endc; j += n)
+        {
+            char bank = kenwood_mr_bank(rig, 0);
+
+            n = chan_list[i].endc - j + 1;
+
+            if (n > KENWOOD_MR_BURST) { n = KENWOOD_MR_BURST; }
+
+            for (k = 0; k < n; k++)
+            {
+                SNPRINTF(cmdbuf[2 * k], sizeof(cmdbuf[0]), "MR0%c%02d", bank, j + k);
+                SNPRINTF(cmdbuf[2 * k + 1], sizeof(cmdbuf[0]), "MR1%c%02d", bank, j + k);
+            }
+
+            retval = rig_transaction_batch(rig, cmds, 2 * n, replies,
+                                           KENWOOD_MAX_BUF_LEN, caps->cmdtrm);
+
+            if (retval != RIG_OK)
+            {
+                RETURNFUNC(retval);
+            }
+
+            for (k = 0; k < n; k++)
+            {
+                int chan_next = j + k < chan_list[i].endc ? j + k + 1 : j + k;
+
+                if (strlen(buf[2 * k]) != 23 || strncmp(buf[2 * k], "MR0", 3)
+                        || kenwood_parse_mr(rig, buf[2 * k], chan) != RIG_OK)
+                {
+                    continue;
+                }
+
+                chan->channel_num = j + k;
+
+                if (strlen(buf[2 * k + 1]) == 23 && !strncmp(buf[2 * k + 1], "MR1", 3))
+                {
+                    kenwood_parse_mr_split(rig, buf[2 * k + 1], chan);
+                }
+
+                chan->vfo = RIG_VFO_MEM;
+
+                retval = chan_cb(rig, &chan, chan_next, chan_list, arg);
+
+                if (retval != RIG_OK)
+                {
+                    RETURNFUNC(retval);
+                }
+            }
+        }
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
 int kenwood_set_channel(RIG *rig, vfo_t vfo, const channel_t *chan)
 {
     char buf[128];
@@ -5412,7 +6356,7 @@ int kenwood_get_ext_parm(RIG *rig, token_t token, value_t *val)
             RETURNFUNC(err);
         }
 
-        val->i = (priv->info[24] == '1') ? 1 : 0;
+        val->i = priv->if_data.xit_on;
         RETURNFUNC(RIG_OK);
 
     case TOK_RIT:
@@ -5423,7 +6367,7 @@ int kenwood_get_ext_parm(RIG *rig, token_t token, value_t *val)
             RETURNFUNC(err);
         }
 
-        val->i = (priv->info[23] == '1') ? 1 : 0;
+        val->i = priv->if_data.rit_on;
         RETURNFUNC(RIG_OK);
     }
 
@@ -5520,9 +6464,9 @@ DECLARE_PROBERIG_BACKEND(kenwood)
         id_len = read_string(port, (unsigned char *) idbuf, IDBUFSZ, ";\r", 2, 0, 1);
         close(port->fd);
 
-        if (retval != RIG_OK || id_len < 0)
+        if (retval == RIG_OK && id_len > 0)
         {
-            continue;
+            break;
         }
     }
 
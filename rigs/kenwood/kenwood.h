@@ -35,6 +35,7 @@
 
 #define KENWOOD_MODE_TABLE_MAX  24
 #define KENWOOD_MAX_BUF_LEN   128 /* max answer len, arbitrary */
+#define KENWOOD_BULK_LEN      512 /* set commands chained by kenwood_set_bulk() */
 
 
 /* Tokens for Parameters common to multiple rigs.
@@ -135,6 +136,52 @@ struct kenwood_priv_caps
     struct kenwood_slope_filter *slope_filter_low; /* Last entry should have value == -1 and frequency_hz == -1 */
 };
 
+/*
+ * IF answer decoded once by kenwood_get_if(), see kenwood_decode_if()
+ */
+struct kenwood_if_data
+{
+    freq_t freq;        /* P1, frequency of the VFO or channel in use */
+    shortfreq_t rit;    /* P3, RIT/XIT offset */
+    int rit_on;         /* P4 */
+    int xit_on;         /* P5 */
+    int mem_ch;         /* P6 */
+    ptt_t ptt;          /* P8 */
+    rmode_t mode;       /* P9 */
+    char function;      /* P10, '0' VFO A, '1' VFO B, '2' memory */
+    int split;          /* P12, RIG_SPLIT_OFF/ON, -1 if the rig sent something else */
+};
+
+#define KENWOOD_TH_REPLIES 8    /* "FO n" and "ME nnn" answers kept */
+
+/*
+ * Answer of a TH/TM handheld or mobile kept by kenwood_transaction(): one
+ * "FO" answer has frequency, step, shift, offset, tones and (on the
+ * TH-D74) mode of a band, and is what all their getters parse
+ */
+struct kenwood_th_reply
+{
+    char cmd[8];                        /* the query, "FO 0" or "ME 012", "" if unused */
+    char reply[KENWOOD_MAX_BUF_LEN];    /* its answer, without the terminator */
+    struct timespec time;               /* when it was read */
+};
+
+/*
+ * What an auto information report tells, see kenwood_parse_report()
+ */
+struct kenwood_report
+{
+    int have_freq;
+    vfo_t freq_vfo;
+    freq_t freq;
+    int have_mode;
+    vfo_t mode_vfo;
+    rmode_t mode;
+    int have_ptt;
+    vfo_t ptt_vfo;
+    ptt_t ptt;
+};
+
 struct kenwood_priv_data
 {
     char info[KENWOOD_MAX_BUF_LEN];
@@ -172,6 +219,16 @@ struct kenwood_priv_data
     rmode_t modeB;
     int datamodeA; // datamode status from get_mode or set_mode
     int datamodeB; // datamode status from get_mode or set_mode
+    struct kenwood_if_data if_data; // info decoded by kenwood_get_if()
+    struct timespec if_data_time;   // cache_start of the IF answer in if_data
+    struct kenwood_th_reply th_replies[KENWOOD_TH_REPLIES]; // TH/TM FO and ME answers
+    int th_reply_next;              // th_replies slot to reuse next
+    char *bulk;     // set commands held back by kenwood_set_bulk(), else NULL
+    int bulk_len;
+    int bulk_flushes; // times the held commands went out
+    int bulk_err;   // first refusal among them not yet sorted out
+    const struct kenwood_setting *level_map[RIG_SETTING_MAX]; // table entry of each level, see kenwood_settings_init()
+    const struct kenwood_setting *func_map[RIG_SETTING_MAX];  // and of each func
 };
 
 
@@ -233,6 +290,9 @@ int kenwood_set_ant(RIG *rig, vfo_t vfo, ant_t ant, value_t option);
 int kenwood_set_ant_no_ack(RIG *rig, vfo_t vfo, ant_t ant, value_t option);
 int kenwood_get_ant(RIG *rig, vfo_t vfo, ant_t dummy, value_t *option, ant_t *ant_curr, ant_t *ant_tx, ant_t *ant_rx);
 int kenwood_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt);
+int kenwood_get_bulk(RIG *rig, struct rig_bulk *bulk);
+int kenwood_set_bulk(RIG *rig, vfo_t vfo, struct rig_setting *settings,
+                     int count);
 int kenwood_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt);
 int kenwood_set_ptt_safe(RIG *rig, vfo_t vfo, ptt_t ptt);
 int kenwood_get_dcd(RIG *rig, vfo_t vfo, dcd_t *dcd);
@@ -241,15 +301,29 @@ int kenwood_set_mem(RIG *rig, vfo_t vfo, int ch);
 int kenwood_get_mem(RIG *rig, vfo_t vfo, int *ch);
 int kenwood_get_mem_if(RIG *rig, vfo_t vfo, int *ch);
 int kenwood_get_channel(RIG *rig, vfo_t vfo, channel_t *chan, int read_only);
+int kenwood_get_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
+                            rig_ptr_t arg);
 int kenwood_set_channel(RIG *rig, vfo_t vfo, const channel_t *chan);
 int kenwood_scan(RIG *rig, vfo_t vfo, scan_t scan, int ch);
 const char *kenwood_get_info(RIG *rig);
 int kenwood_get_id(RIG *rig, char *buf);
 int kenwood_get_if(RIG *rig);
+int kenwood_decode_if(RIG *rig, const char *info, struct kenwood_if_data *ifd);
+int kenwood_parse_if(const char *info, size_t len, const rmode_t mode_table[],
+                     struct kenwood_if_data *ifd);
+int kenwood_parse_report(const char *s, size_t len, const rmode_t mode_table[],
+                         struct kenwood_report *r);
 
 int kenwood_set_trn(RIG *rig, int trn);
 int kenwood_get_trn(RIG *rig, int *trn);
 
+int kenwood_read_frame_direct(RIG *rig, size_t buffer_length,
+                              const unsigned char *buffer);
+int kenwood_is_async_frame(RIG *rig, size_t frame_length,
+                           const unsigned char *frame);
+int kenwood_process_async_frame(RIG *rig, size_t frame_length,
+                                const unsigned char *frame);
+
 /* only use if returned string has length 6, e.g. 'SQ011;' */
 int get_kenwood_level(RIG *rig, const char *cmd, float *fval, int *ival);
 int get_kenwood_func(RIG *rig, const char *cmd, int *status);
@@ -0,0 +1,452 @@
+/*
+ *  Hamlib Elecraft backend - P3/PX3 panadapter port
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * A K3 or KX3 with a P3 or PX3 keeps its CAT commands on rigport.  The
+ * panadapter has a PC port of its own; when "p3_port" names it, it is
+ * opened as a second serial port and a reader thread polls the sweep with
+ * #SPG;, turning each reply into a spectrum line for
+ * rig_fire_spectrum_event(), the same path as the K4 stream (k4pan.c):
+ * callback, history and multicast publisher.  Span and display levels are
+ * read again every P3PAN_SETTINGS_EVERY sweeps.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "kenwood.h"
+#include "elecraft.h"
+#include "p3pan.h"
+#include "iofunc.h"
+#include "serial.h"
+#include "misc.h"
+#include "cache.h"
+#include "event.h"
+#include "spectrum_pool.h"
+
+#define P3PAN_TIMEOUT 1000      /* ms, also how long k3_close() may wait */
+#define P3PAN_SETTINGS_EVERY 20
+#define P3PAN_MAX_REPLY (4 + HAMLIB_MAX_SPECTRUM_DATA + 2)
+
+struct p3pan_priv_data
+{
+    char path[HAMLIB_FILPATHLEN];   /* p3_port, "" = not used */
+    int speed;
+    hamlib_port_t p3port;
+    int running;
+#ifdef HAVE_PTHREAD
+    pthread_t thread;
+#endif
+    RIG *rig;
+    freq_t center;
+    freq_t span;
+    int ref;
+    int scale;
+    char reply[P3PAN_MAX_REPLY];
+    unsigned char data[HAMLIB_MAX_SPECTRUM_DATA]; /* used if the pool is empty */
+};
+
+const struct confparams k3_cfg_params[] =
+{
+    {
+        TOK_P3_PORT, "p3_port", "P3/PX3 port",
+        "Serial device of the P3 or PX3 PC port, for its spectrum. Empty to disable",
+        "", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_P3_SPEED, "p3_speed", "P3/PX3 port speed",
+        "Baud rate of the P3 or PX3 PC port",
+        "38400", RIG_CONF_NUMERIC, { .n = { 4800, 38400, 1 } }
+    },
+    { RIG_CONF_END, NULL, }
+};
+
+static struct p3pan_priv_data *p3pan_priv(RIG *rig, int create)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+
+    if (!priv->data && create)
+    {
+        struct p3pan_priv_data *pan = calloc(1, sizeof(struct p3pan_priv_data));
+
+        if (pan)
+        {
+            pan->speed = 38400;
+        }
+
+        priv->data = pan;
+    }
+
+    return priv->data;
+}
+
+int p3pan_decode(const char *reply, size_t len, freq_t center, freq_t span,
+                 int ref, int scale, struct rig_spectrum_line *line,
+                 unsigned char *data, size_t data_size)
+{
+    size_t points;
+
+    if (len < 5 || strncmp(reply, "#SPG", 4) != 0)
+    {
+        return -RIG_EPROTO;
+    }
+
+    points = len - 4;
+
+    if (points > data_size)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %d points do not fit\n", __func__,
+                  (int)points);
+        return -RIG_EPROTO;
+    }
+
+    memcpy(data, reply + 4, points);
+
+    *line = (struct rig_spectrum_line)
+    {
+        .id = 0,
+        .data_level_min = 0,
+        .data_level_max = 255,
+        .signal_strength_min = ref - scale,
+        .signal_strength_max = ref,
+        .spectrum_mode = RIG_SPECTRUM_MODE_CENTER,
+        .center_freq = center,
+        .span_freq = span,
+        .low_edge_freq = center - span / 2,
+        .high_edge_freq = center + span / 2,
+        .spectrum_data_length = points,
+        .spectrum_data = data,
+    };
+
+    return RIG_OK;
+}
+
+/* Send cmd and read its reply into buf without the ';', return its length */
+static int p3pan_query(struct p3pan_priv_data *pan, const char *cmd, char *buf,
+                       size_t size)
+{
+    int ret;
+
+    rig_flush(&pan->p3port);
+
+    ret = write_block(&pan->p3port, (const unsigned char *) cmd, strlen(cmd));
+
+    if (ret != RIG_OK)
+    {
+        return ret;
+    }
+
+    ret = read_string(&pan->p3port, (unsigned char *) buf, size, ";", 1, 0, 1);
+
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    /* "?;" for a command the firmware does not know */
+    if (ret < 5 || buf[ret - 1] != ';' || strncmp(buf, cmd, 4) != 0)
+    {
+        return -RIG_EPROTO;
+    }
+
+    buf[--ret] = '\0';
+
+    return ret;
+}
+
+static void p3pan_read_settings(struct p3pan_priv_data *pan)
+{
+    char buf[32];
+
+    if (p3pan_query(pan, "#SPN;", buf, sizeof(buf)) > 4 && atol(buf + 4) > 0)
+    {
+        pan->span = atol(buf + 4);
+    }
+
+    if (p3pan_query(pan, "#REF;", buf, sizeof(buf)) > 4)
+    {
+        pan->ref = atoi(buf + 4);
+    }
+
+    if (p3pan_query(pan, "#SCL;", buf, sizeof(buf)) > 4 && atoi(buf + 4) > 0)
+    {
+        pan->scale = atoi(buf + 4);
+    }
+}
+
+static void p3pan_dispatch(struct p3pan_priv_data *pan, size_t len)
+{
+    struct spectrum_pool_line *pl = spectrum_pool_get();
+    struct rig_spectrum_line stack_line;
+    struct rig_spectrum_line *line = pl ? &pl->line : &stack_line;
+    unsigned char *data = pl ? pl->data : pan->data;
+    struct rig_cache_snapshot snap;
+
+    /* the display follows VFO A; keep the last frequency seen */
+    rig_cache_snapshot(pan->rig, RIG_VFO_A, &snap);
+
+    if (snap.freq > 0)
+    {
+        pan->center = snap.freq;
+    }
+
+    if (p3pan_decode(pan->reply, len, pan->center, pan->span, pan->ref,
+                     pan->scale, line, data, HAMLIB_MAX_SPECTRUM_DATA) == RIG_OK)
+    {
+        rig_fire_spectrum_event(pan->rig, line);
+    }
+
+    if (pl)
+    {
+        spectrum_pool_put(pl);
+    }
+}
+
+#ifdef HAVE_PTHREAD
+static void *p3pan_thread(void *arg)
+{
+    struct p3pan_priv_data *pan = arg;
+    unsigned int sweeps = 0;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: started\n", __func__);
+
+    while (pan->running)
+    {
+        int ret;
+
+        if (sweeps++ % P3PAN_SETTINGS_EVERY == 0)
+        {
+            p3pan_read_settings(pan);
+        }
+
+        ret = p3pan_query(pan, "#SPG;", pan->reply, sizeof(pan->reply));
+
+        if (ret >= 0)
+        {
+            p3pan_dispatch(pan, ret);
+            continue;
+        }
+
+        if (ret == -RIG_ETIMEOUT || ret == -RIG_EPROTO)
+        {
+            continue;
+        }
+
+        rig_debug(RIG_DEBUG_ERR, "%s: panadapter port lost: %s\n", __func__,
+                  rigerror(ret));
+        break;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: stopped\n", __func__);
+
+    return NULL;
+}
+#endif
+
+static int p3pan_start(RIG *rig, struct p3pan_priv_data *pan)
+{
+#ifdef HAVE_PTHREAD
+    int ret;
+
+    memset(&pan->p3port, 0, sizeof(pan->p3port));
+    pan->p3port.type.rig = RIG_PORT_SERIAL;
+    pan->p3port.timeout = P3PAN_TIMEOUT;
+    pan->p3port.parm.serial.rate = pan->speed;
+    pan->p3port.parm.serial.data_bits = 8;
+    pan->p3port.parm.serial.stop_bits = 1;
+    pan->p3port.parm.serial.parity = RIG_PARITY_NONE;
+    pan->p3port.parm.serial.handshake = RIG_HANDSHAKE_NONE;
+    SNPRINTF(pan->p3port.pathname, sizeof(pan->p3port.pathname), "%s",
+             pan->path);
+
+    ret = serial_open(&pan->p3port);
+
+    if (ret != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot open panadapter port %s\n", __func__,
+                  pan->path);
+        return ret;
+    }
+
+    pan->rig = rig;
+    pan->center = 0;
+    pan->span = P3PAN_SPAN_DEFAULT;
+    pan->ref = P3PAN_REF_DEFAULT;
+    pan->scale = P3PAN_SCALE_DEFAULT;
+    pan->running = 1;
+
+    if (pthread_create(&pan->thread, NULL, p3pan_thread, pan))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        pan->running = 0;
+        port_close(&pan->p3port, RIG_PORT_SERIAL);
+        return -RIG_EINTERNAL;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: panadapter port %s\n", __func__,
+              pan->path);
+
+    return RIG_OK;
+#else
+    rig_debug(RIG_DEBUG_WARN, "%s: built without threads, p3_port ignored\n",
+              __func__);
+    return RIG_OK;
+#endif
+}
+
+static void p3pan_stop(struct p3pan_priv_data *pan)
+{
+#ifdef HAVE_PTHREAD
+
+    if (!pan || !pan->running)
+    {
+        return;
+    }
+
+    pan->running = 0;
+    pthread_join(pan->thread, NULL);
+    port_close(&pan->p3port, RIG_PORT_SERIAL);
+#endif
+}
+
+int k3_set_conf(RIG *rig, token_t token, const char *val)
+{
+    struct p3pan_priv_data *pan;
+
+    ENTERFUNC;
+
+    pan = p3pan_priv(rig, 1);
+
+    if (!pan)
+    {
+        RETURNFUNC(-RIG_ENOMEM);
+    }
+
+    switch (token)
+    {
+    case TOK_P3_PORT:
+        SNPRINTF(pan->path, sizeof(pan->path), "%s", val);
+        break;
+
+    case TOK_P3_SPEED:
+        if (atoi(val) < 4800 || atoi(val) > 38400)
+        {
+            RETURNFUNC(-RIG_EINVAL);
+        }
+
+        pan->speed = atoi(val);
+        break;
+
+    default:
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+int k3_get_conf(RIG *rig, token_t token, char *val)
+{
+    struct p3pan_priv_data *pan;
+
+    ENTERFUNC;
+
+    pan = p3pan_priv(rig, 0);
+
+    switch (token)
+    {
+    case TOK_P3_PORT:
+        sprintf(val, "%s", pan ? pan->path : "");
+        break;
+
+    case TOK_P3_SPEED:
+        sprintf(val, "%d", pan ? pan->speed : 38400);
+        break;
+
+    default:
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+int k3_open(RIG *rig)
+{
+    struct p3pan_priv_data *pan;
+    int err;
+
+    ENTERFUNC;
+
+    err = elecraft_open(rig);
+
+    if (err != RIG_OK)
+    {
+        RETURNFUNC(err);
+    }
+
+    pan = p3pan_priv(rig, 0);
+
+    if (pan && pan->path[0] && !pan->running)
+    {
+        err = p3pan_start(rig, pan);
+
+        if (err != RIG_OK)
+        {
+            kenwood_close(rig);
+            RETURNFUNC(err);
+        }
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+int k3_close(RIG *rig)
+{
+    ENTERFUNC;
+
+    p3pan_stop(p3pan_priv(rig, 0));
+
+    RETURNFUNC(kenwood_close(rig));
+}
+
+int k3_cleanup(RIG *rig)
+{
+    struct kenwood_priv_data *priv = rig->state.priv;
+
+    ENTERFUNC;
+
+    if (priv)
+    {
+        p3pan_stop(priv->data);
+        free(priv->data);
+        priv->data = NULL;
+    }
+
+    RETURNFUNC(kenwood_cleanup(rig));
+}
@@ -0,0 +1,60 @@
+/*
+ *  Hamlib Elecraft backend - P3/PX3 panadapter port
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _P3PAN_H
+#define _P3PAN_H 1
+
+#include <hamlib/rig.h>
+#include "token.h"
+
+#define TOK_P3_PORT  TOKEN_BACKEND(111)  /* serial device of the P3/PX3 PC port, "" = off */
+#define TOK_P3_SPEED TOKEN_BACKEND(112)  /* its baud rate */
+
+/*
+ * P3/PX3 PC port commands, as used here; ';' ends commands and replies as
+ * on the rig's own CAT port:
+ *   #SPG;  ->  #SPG<bytes>;   one byte per display column, low to high
+ *                             frequency, each a level 0..255 above the
+ *                             bottom of the display (never ';')
+ *   #SPN;  ->  #SPNnnnnnn;    span in Hz
+ *   #REF;  ->  #REF[-]nnn;    level at the top of the display, dBm
+ *   #SCL;  ->  #SCLnnn;       dB from the bottom to the top of the display
+ * The display is centred on VFO A, whose frequency comes from the cache.
+ */
+#define P3PAN_SPAN_DEFAULT 200000
+#define P3PAN_REF_DEFAULT (-10)
+#define P3PAN_SCALE_DEFAULT 80
+
+extern const struct confparams k3_cfg_params[];
+
+int k3_set_conf(RIG *rig, token_t token, const char *val);
+int k3_get_conf(RIG *rig, token_t token, char *val);
+int k3_open(RIG *rig);
+int k3_close(RIG *rig);
+int k3_cleanup(RIG *rig);
+
+/* Decode one #SPG reply without its ';', exposed for testing; returns
+ * RIG_OK or -RIG_EPROTO */
+int p3pan_decode(const char *reply, size_t len, freq_t center, freq_t span,
+                 int ref, int scale, struct rig_spectrum_line *line,
+                 unsigned char *data, size_t data_size);
+
+#endif /* _P3PAN_H */
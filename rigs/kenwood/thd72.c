@@ -32,6 +32,7 @@
 #include "iofunc.h"
 #include "serial.h"
 #include "misc.h"
+#include "clone.h"
 
 
 // Some commands are very slow to process so we put a DELAY in those places
@@ -1419,207 +1420,230 @@ static int thd72_get_channel(RIG *rig, vfo_t vfo, channel_t *chan,
     return RIG_OK;
 }
 
-#ifdef false  /* not working */
-#define CMD_SZ 5
-#define BLOCK_SZ 256
-#define BLOCK_COUNT 256
-#define CHAN_PER_BLOCK 4
+/*
+ * Clone mode.  "0M PROGRAM" switches the radio to a binary protocol at
+ * 57600 bd where the 64 KiB memory image moves in 256 byte blocks:
+ *   R 00 nn 00 00          read block nn, answered W 00 nn 00 00 + data,
+ *                          then ACK (0x06) both ways
+ *   W 00 nn 00 00 + data   write block nn, answered ACK
+ *   E                      back to CAT, answered ACK
+ * Memory channels are 40 byte records at 0x1000, six to a block, with the
+ * RX frequency and the repeater offset as little endian Hz.
+ */
+#define THD72_CLONE_HDR_SZ  5
+#define THD72_CLONE_BLK_SZ  256
+#define THD72_CLONE_BLKS    256
+#define THD72_CLONE_RATE    57600
 
-static int thd72_get_block(RIG *rig, int block_num, char *block)
+static const struct rig_clone_field thd72_clone_fields[] =
 {
-    hamlib_port_t *rp = &rig->state.rigport;
-    char cmd[CMD_SZ] = "R\0\0\0\0";
-    char resp[CMD_SZ];
-    int ret;
+    { RIG_CLONE_FREQ, RIG_CLONE_TBL_REC, 0, 4, RIG_CLONE_ENC_LE },
+    { RIG_CLONE_RPTR_OFFS, RIG_CLONE_TBL_REC, 4, 4, RIG_CLONE_ENC_LE },
+    { RIG_CLONE_END },
+};
 
-    /* fetching block i */
-    cmd[2] = block_num & 0xff;
+static const struct rig_clone_layout thd72_clone_layout =
+{
+    .image_size = THD72_CLONE_BLKS * THD72_CLONE_BLK_SZ,
+    .first_channel = 0,
+    .channels = 1000,
+    .tbl = {
+        [RIG_CLONE_TBL_REC] = { 0x1000, 40, 6, THD72_CLONE_BLK_SZ, 1032 },
+    },
+    .empty_byte = 0xff,
+    .empty_size = 4,
+    .fields = thd72_clone_fields,
+};
 
-    ret = write_block(rp, cmd, CMD_SZ);
+static int thd72_clone_ack(hamlib_port_t *rp)
+{
+    unsigned char ack;
+    int ret = read_block(rp, &ack, 1);
 
-    if (ret != RIG_OK)
+    if (ret != 1)
     {
-        return ret;
+        return ret < 0 ? ret : -RIG_EPROTO;
     }
 
-    /* read response first */
-    ret = read_block(rp, resp, CMD_SZ);
+    return ack == 0x06 ? RIG_OK : -RIG_EPROTO;
+}
+
+static int thd72_clone_enter(RIG *rig)
+{
+    hamlib_port_t *rp = &rig->state.rigport;
+    char resp[16];
+    int ret;
 
-    if (ret != CMD_SZ)
+    ret = kenwood_transaction(rig, "0M PROGRAM", resp, sizeof(resp));
+
+    if (ret != RIG_OK)
     {
         return ret;
     }
 
-    if (resp[0] != 'W' || memcmp(cmd + 1, resp + 1, CMD_SZ - 1))
+    if (strcmp(resp, "0M") != 0)
     {
         return -RIG_EPROTO;
     }
 
-    /* read block */
-    ret = read_block(rp, block, BLOCK_SZ);
-
-    if (ret != BLOCK_SZ)
+    if (rp->type.rig == RIG_PORT_SERIAL)
     {
-        return ret;
+        rp->parm.serial.rate = THD72_CLONE_RATE;
+        serial_setup(rp);
+        ser_set_rts(rp, 1);
     }
 
-    ret = write_block(rp, "\006", 1);
+    hl_usleep(100 * 1000); /* let the radio switch over */
+    rig_flush(rp);
 
-    if (ret != RIG_OK)
-    {
-        return ret;
-    }
+    return RIG_OK;
+}
 
-    ret = read_block(rp, resp, 1);
+static int thd72_clone_leave(RIG *rig, int rate)
+{
+    hamlib_port_t *rp = &rig->state.rigport;
+    int ret;
 
-    if (ret != 1)
+    ret = write_block(rp, (unsigned char *) "E", 1);
+
+    if (ret == RIG_OK)
     {
-        return ret;
+        ret = thd72_clone_ack(rp);
     }
 
-    if (resp[0] != 0x06)
+    if (rp->type.rig == RIG_PORT_SERIAL)
     {
-        return -RIG_EPROTO;
+        rp->parm.serial.rate = rate;
+        serial_setup(rp);
     }
 
-    return RIG_OK;
+    return ret;
 }
 
-#ifdef XXREMOVEDXX
-int thd72_get_chan_all_cb(RIG *rig, chan_cb_t chan_cb, rig_ptr_t arg)
+static int thd72_clone_read_block(RIG *rig, int blk, unsigned char *data)
 {
-    int i, j, ret;
     hamlib_port_t *rp = &rig->state.rigport;
-    channel_t *chan;
-    chan_t *chan_list = rig->state.chan_list;
-    int chan_next = chan_list[0].start;
-    char block[BLOCK_SZ];
-    char resp[CMD_SZ];
+    unsigned char cmd[THD72_CLONE_HDR_SZ] = { 'R', 0, 0, 0, 0 };
+    unsigned char hdr[THD72_CLONE_HDR_SZ];
+    int ret;
+
+    cmd[2] = blk & 0xff;
 
-    ret = kenwood_transaction(rig, "0M PROGRAM", resp, CMD_SZ);
+    ret = write_block(rp, cmd, sizeof(cmd));
 
     if (ret != RIG_OK)
     {
         return ret;
     }
 
-    if (strlen(resp) != 2 || memcmp(resp, "0M", 2))
+    ret = read_block(rp, hdr, sizeof(hdr));
+
+    if (ret != sizeof(hdr))
     {
-        return -RIG_EPROTO;
+        return ret < 0 ? ret : -RIG_EPROTO;
     }
 
-    rp->parm.serial.rate = 57600;
-    serial_setup(rp);
-
+    if (hdr[0] != 'W' || memcmp(cmd + 1, hdr + 1, sizeof(hdr) - 1))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: bad header for block %d\n", __func__, blk);
+        return -RIG_EPROTO;
+    }
 
-    hl_usleep(100 * 1000); /* let the pcr settle */
-    rig_flush(rp); /* flush any remaining data */
-    ret = ser_set_rts(rp, 1); /* setRTS or Hardware flow control? */
+    ret = read_block(rp, data, THD72_CLONE_BLK_SZ);
 
-    if (ret != RIG_OK)
+    if (ret != THD72_CLONE_BLK_SZ)
     {
-        return ret;
+        return ret < 0 ? ret : -RIG_EPROTO;
     }
 
-    /*
-     * setting chan to NULL means the application
-     * has to provide a struct where to store data
-     * future data for channel channel_num
-     */
-    chan = NULL;
-    ret = chan_cb(rig, &chan, chan_next, chan_list, arg);
+    ret = write_block(rp, (unsigned char *) "\006", 1);
 
     if (ret != RIG_OK)
     {
         return ret;
     }
 
-    if (chan == NULL)
-    {
-        return -RIG_ENOMEM;
-    }
-
-    for (i = 0; i < BLOCK_COUNT; i++)
-    {
+    return thd72_clone_ack(rp);
+}
 
-        ret = thd72_get_block(rig, i, block);
+static int thd72_clone_write_block(RIG *rig, int blk, const unsigned char *data)
+{
+    hamlib_port_t *rp = &rig->state.rigport;
+    unsigned char cmd[THD72_CLONE_HDR_SZ + THD72_CLONE_BLK_SZ] = { 'W', 0, 0, 0, 0 };
+    int ret;
 
-        if (ret != RIG_OK)
-        {
-            return ret;
-        }
+    cmd[2] = blk & 0xff;
+    memcpy(cmd + THD72_CLONE_HDR_SZ, data, THD72_CLONE_BLK_SZ);
 
-        /*
-         * Most probably, there's 64 bytes per channel (256*256 / 1000+)
-         */
-        for (j = 0; j < CHAN_PER_BLOCK; j++)
-        {
-            char *block_chan = block + j * (BLOCK_SZ / CHAN_PER_BLOCK);
-            memset(chan, 0, sizeof(channel_t));
-            chan->vfo = RIG_VFO_MEM;
-            chan->channel_num = i * CHAN_PER_BLOCK + j;
+    ret = write_block(rp, cmd, sizeof(cmd));
 
-            /* What are the extra 64 channels ? */
-            if (chan->channel_num >= 1000)
-            {
-                break;
-            }
+    if (ret != RIG_OK)
+    {
+        return ret;
+    }
 
-            /* non-empty channel ? */
-            // if (block_chan[0] != 0xff) {
-            // since block_chan is *signed* char, this maps to -1
-            if (block_chan[0] != -1)
-            {
+    return thd72_clone_ack(rp);
+}
 
-                memcpy(chan->channel_desc, block_chan, 8);
-                /* TODO: chop off trailing chars */
-                chan->channel_desc[8] = '\0';
+static int thd72_clone_read(RIG *rig, unsigned char *image, size_t len)
+{
+    int rate = rig->state.rigport.parm.serial.rate;
+    int blk, ret;
 
-                /* TODO: parse block and fill in chan */
-            }
+    rig_debug(RIG_DEBUG_TRACE, "%s: called\n", __func__);
 
-            /* notify the end? */
-            chan_next = chan_next < chan_list[i].end ? chan_next + 1 : chan_next;
+    ret = thd72_clone_enter(rig);
 
-            /*
-             * provide application with channel data,
-             * and ask for a new channel structure
-             */
-            chan_cb(rig, &chan, chan_next, chan_list, arg);
-        }
+    if (ret != RIG_OK)
+    {
+        return ret;
     }
 
-    ret = write_block(rp, "E", 1);
+    for (blk = 0; ret == RIG_OK && blk < THD72_CLONE_BLKS; blk++)
+    {
+        ret = thd72_clone_read_block(rig, blk, image + blk * THD72_CLONE_BLK_SZ);
+    }
 
     if (ret != RIG_OK)
     {
+        rig_debug(RIG_DEBUG_ERR, "%s: block %d: %s\n", __func__, blk - 1,
+                  rigerror(ret));
+        thd72_clone_leave(rig, rate);
         return ret;
     }
 
-    ret = read_block(rp, resp, 1);
+    return thd72_clone_leave(rig, rate);
+}
 
-    if (ret != 1)
+static int thd72_clone_write(RIG *rig, const unsigned char *image, size_t len)
+{
+    int rate = rig->state.rigport.parm.serial.rate;
+    int blk, ret;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: called\n", __func__);
+
+    ret = thd72_clone_enter(rig);
+
+    if (ret != RIG_OK)
     {
         return ret;
     }
 
-    if (resp[0] != 0x06)
+    for (blk = 0; ret == RIG_OK && blk < THD72_CLONE_BLKS; blk++)
     {
-        return -RIG_EPROTO;
+        ret = thd72_clone_write_block(rig, blk, image + blk * THD72_CLONE_BLK_SZ);
     }
 
-    /* setRTS?? getCTS needed? */
-    ret = ser_set_rts(rp, 1);
-
     if (ret != RIG_OK)
     {
+        rig_debug(RIG_DEBUG_ERR, "%s: block %d: %s\n", __func__, blk - 1,
+                  rigerror(ret));
+        thd72_clone_leave(rig, rate);
         return ret;
     }
 
-    return RIG_OK;
+    return thd72_clone_leave(rig, rate);
 }
-#endif
-#endif  /* none working stuff */
 /*
  * th-d72a rig capabilities.
  */
@@ -1739,7 +1763,9 @@ const struct rig_caps thd72a_caps =
     .get_mem  = thd72_get_mem,
     .set_channel = thd72_set_channel,
     .get_channel = thd72_get_channel,
-//.get_chan_all_cb = thd72_get_chan_all_cb, this doesn't work yet
+    .clone_read = thd72_clone_read,
+    .clone_write = thd72_clone_write,
+    .clone_layout = &thd72_clone_layout,
     .get_info =  th_get_info,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
@@ -171,6 +171,7 @@ const struct rig_caps trc80_caps =
     .set_mem =  kenwood_set_mem,
     .get_mem =  kenwood_get_mem,
     .get_channel =  kenwood_get_channel,
+    .get_chan_all_cb =  kenwood_get_chan_all_cb,
     .scan =  kenwood_scan,
     .set_powerstat =  kenwood_set_powerstat,
     .get_powerstat =  kenwood_get_powerstat,
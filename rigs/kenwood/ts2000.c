@@ -300,6 +300,8 @@ const struct rig_caps ts2000_caps =
     .set_ctcss_sql =  kenwood_set_ctcss_sql,
     .get_ctcss_sql =  kenwood_get_ctcss_sql,
     .get_ptt =  kenwood_get_ptt,
+    .get_bulk =  kenwood_get_bulk,
+    .set_bulk =  kenwood_set_bulk,
     .set_ptt =  kenwood_set_ptt,
     .get_dcd =  kenwood_get_dcd,
     .set_func =  kenwood_set_func,
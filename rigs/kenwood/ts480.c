@@ -853,7 +853,6 @@ static int ts480_set_rit(RIG *rig, vfo_t vfo, shortfreq_t rit)
 static int ts480_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
 {
     int retval;
-    char buf[7];
     struct kenwood_priv_data *priv = rig->state.priv;
 
     ENTERFUNC;
@@ -870,10 +869,7 @@ static int ts480_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
         RETURNFUNC(retval);
     }
 
-    memcpy(buf, &priv->info[18], 5);
-
-    buf[6] = '\0';
-    *rit = atoi(buf);
+    *rit = priv->if_data.rit;
 
     RETURNFUNC(RIG_OK);
 }
@@ -1413,6 +1409,8 @@ const struct rig_caps ts480_caps =
     .set_split_vfo = kenwood_set_split_vfo,
     .get_split_vfo = kenwood_get_split_vfo_if,
     .get_ptt = kenwood_get_ptt,
+    .get_bulk = kenwood_get_bulk,
+    .set_bulk = kenwood_set_bulk,
     .set_ptt = kenwood_set_ptt,
     .get_dcd = kenwood_get_dcd,
     .set_powerstat = kenwood_set_powerstat,
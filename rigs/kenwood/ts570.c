@@ -1062,6 +1062,7 @@ const struct rig_caps ts570s_caps =
     .set_mem =  kenwood_set_mem,
     .get_mem =  kenwood_get_mem,
     .get_channel = kenwood_get_channel,
+    .get_chan_all_cb = kenwood_get_chan_all_cb,
     .set_channel = ts570_set_channel,
     .set_trn =  kenwood_set_trn,
     .get_trn =  kenwood_get_trn,
@@ -1249,6 +1250,7 @@ const struct rig_caps ts570d_caps =
     .set_mem =  kenwood_set_mem,
     .get_mem =  kenwood_get_mem,
     .get_channel = kenwood_get_channel,
+    .get_chan_all_cb = kenwood_get_chan_all_cb,
     .set_channel = ts570_set_channel,
     .set_trn =  kenwood_set_trn,
     .get_trn =  kenwood_get_trn,
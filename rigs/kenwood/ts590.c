@@ -222,6 +222,8 @@ const struct rig_caps ts590_caps =
     .set_split_vfo = kenwood_set_split_vfo,
     .get_split_vfo = kenwood_get_split_vfo_if,
     .get_ptt = kenwood_get_ptt,
+    .get_bulk = kenwood_get_bulk,
+    .set_bulk = kenwood_set_bulk,
     .set_ptt = kenwood_set_ptt,
     .get_dcd = kenwood_get_dcd,
     .set_powerstat = kenwood_set_powerstat,
@@ -251,6 +253,7 @@ const struct rig_caps ts590_caps =
     .get_mem =  kenwood_get_mem,
     .set_channel =  kenwood_set_channel,
     .get_channel =  kenwood_get_channel,
+    .get_chan_all_cb =  kenwood_get_chan_all_cb,
     .vfo_ops = TS590_VFO_OPS,
     .vfo_op =  kenwood_vfo_op,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
@@ -393,6 +396,8 @@ const struct rig_caps ts590sg_caps =
     .set_split_vfo = kenwood_set_split_vfo,
     .get_split_vfo = kenwood_get_split_vfo_if,
     .get_ptt = kenwood_get_ptt,
+    .get_bulk = kenwood_get_bulk,
+    .set_bulk = kenwood_set_bulk,
     .set_ptt = kenwood_set_ptt,
     .get_dcd = kenwood_get_dcd,
     .set_powerstat = kenwood_set_powerstat,
@@ -422,6 +427,7 @@ const struct rig_caps ts590sg_caps =
     .get_mem =  kenwood_get_mem,
     .set_channel =  kenwood_set_channel,
     .get_channel =  kenwood_get_channel,
+    .get_chan_all_cb =  kenwood_get_chan_all_cb,
     .vfo_ops = TS590_VFO_OPS,
     .vfo_op =  kenwood_vfo_op,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
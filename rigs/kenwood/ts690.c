@@ -198,6 +198,7 @@ const struct rig_caps ts690s_caps =
     .reset = kenwood_reset,
     .scan =  kenwood_scan,
     .get_channel = kenwood_get_channel,
+    .get_chan_all_cb = kenwood_get_chan_all_cb,
     .set_channel = kenwood_set_channel,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
@@ -208,6 +208,7 @@ const struct rig_caps ts790_caps =
     .get_mem =  kenwood_get_mem,
     .set_channel = kenwood_set_channel,
     .get_channel = kenwood_get_channel,
+    .get_chan_all_cb = kenwood_get_chan_all_cb,
     .set_trn =  kenwood_set_trn,
     .get_trn =  kenwood_get_trn,
     .get_info =  kenwood_get_info,
@@ -243,6 +243,7 @@ const struct rig_caps ts850_caps =
     .set_mem =  kenwood_set_mem,
     .get_mem =  kenwood_get_mem_if,
     .get_channel = kenwood_get_channel,
+    .get_chan_all_cb = kenwood_get_chan_all_cb,
     .set_channel = ts850_set_channel,
     .set_trn =  kenwood_set_trn,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
@@ -189,6 +189,7 @@ const struct rig_caps ts940_caps =
     .scan =  kenwood_scan,
     .set_channel = kenwood_set_channel,
     .get_channel = kenwood_get_channel,
+    .get_chan_all_cb = kenwood_get_chan_all_cb,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
 
@@ -52,6 +52,7 @@
 #endif
 
 #include "si570avrusb.h"
+#include "usb_port.h"
 
 static int si570avrusb_init(RIG *rig);
 static int si570picusb_init(RIG *rig);
@@ -128,6 +129,7 @@ struct si570xxxusb_priv_data
 
     int i2c_addr;
     int bpf;    /* enable BPF? */
+    int async;  /* frequency writes go out as asynchronous transfers */
 };
 
 #define SI570AVRUSB_MODES (RIG_MODE_USB)    /* USB is for SDR */
@@ -843,6 +845,9 @@ int fasdr_open(RIG *rig)
     rig_debug(RIG_DEBUG_VERBOSE, "%s: using Xtall at %.3f MHz\n",
               __func__, priv->osc_freq);
 
+    /* a sweeping SDR program must not wait on each LO step */
+    priv->async = usb_async_start(&rig->state.rigport) == RIG_OK;
+
     return RIG_OK;
 }
 
@@ -1074,6 +1079,9 @@ int si570xxxusb_open(RIG *rig)
     rig_debug(RIG_DEBUG_VERBOSE, "%s: using Xtall at %.3f MHz\n",
               __func__, priv->osc_freq);
 
+    /* a sweeping SDR program must not wait on each LO step */
+    priv->async = usb_async_start(&rig->state.rigport) == RIG_OK;
+
     return RIG_OK;
 }
 
@@ -1236,6 +1244,16 @@ int si570xxxusb_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
     buffer[0] = theSolution.N1 / 4;
     buffer[0] = buffer[0] + (theSolution.HS_DIV << 5);
 
+    if (priv->async)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: Freq=%.6f MHz, Real=%.6f MHz, queued\n",
+                  __func__, freq / 1e6, f);
+
+        return usb_async_control(&rig->state.rigport, 0, REQUEST_TYPE_OUT,
+                                 request, value, index, buffer, sizeof(buffer),
+                                 NULL, NULL);
+    }
+
     ret = libusb_control_transfer(udh, REQUEST_TYPE_OUT,
                                   request, value, index, buffer, sizeof(buffer), rig->state.rigport.timeout);
 
@@ -1281,6 +1299,13 @@ int si570xxxusb_set_freq_by_value(RIG *rig, vfo_t vfo, freq_t freq)
               __func__, freq / 1e6, f,
               buffer[0], buffer[1], buffer[2], buffer[3]);
 
+    if (priv->async)
+    {
+        return usb_async_control(&rig->state.rigport, 0, REQUEST_TYPE_OUT,
+                                 request, value, index, buffer, sizeof(buffer),
+                                 NULL, NULL);
+    }
+
     ret = libusb_control_transfer(udh, REQUEST_TYPE_OUT,
                                   request, value, index, buffer, sizeof(buffer), rig->state.rigport.timeout);
 
@@ -1337,6 +1362,9 @@ int si570xxxusb_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     unsigned char buffer[6];
     int ret;
 
+    /* read back what was tuned last, not a step still on its way */
+    usb_async_flush(&rig->state.rigport);
+
     if (priv->version >= 0x0f00 || rig->caps->rig_model == RIG_MODEL_SI570PICUSB ||
             rig->caps->rig_model == RIG_MODEL_SI570PEABERRY1
             || rig->caps->rig_model == RIG_MODEL_SI570PEABERRY2)
@@ -32,14 +32,36 @@
 #include <errno.h>
 #include <usrp_standard.h>
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
 #include "usrp_impl.h"
 #include "token.h"
 
+/*
+ * Retuning takes milliseconds, so set_freq goes through the request queue
+ * and only the latest of the retunes pending meanwhile reaches the board.
+ * A 1 ms window holds none of them back; the "coalesce" conf overrides it.
+ */
+#define USRP_COALESCE_MS 1
+
+#ifdef HAVE_PTHREAD
+#define USRP_LOCK(p)	pthread_mutex_lock(&(p)->lock)
+#define USRP_UNLOCK(p)	pthread_mutex_unlock(&(p)->lock)
+#else
+#define USRP_LOCK(p)
+#define USRP_UNLOCK(p)
+#endif
+
 
 struct usrp_priv_data {
 	usrp_standard_rx *urx;
 	usrp_standard_tx *utx;
 	freq_t if_mix_freq;
+#ifdef HAVE_PTHREAD
+	pthread_mutex_t lock;	/* urx, tuned from the queue thread and read from the caller's */
+#endif
 };
 
 
@@ -51,6 +73,11 @@ int usrp_init(RIG *rig)
 		return -RIG_ENOMEM;
 	}
 
+#ifdef HAVE_PTHREAD
+	pthread_mutex_init(&((struct usrp_priv_data*)rig->state.priv)->lock, NULL);
+#endif
+	rig->state.coalesce_ms = USRP_COALESCE_MS;
+
 	return RIG_OK;
 }
 
@@ -59,8 +86,12 @@ int usrp_cleanup(RIG *rig)
 	if (!rig)
 		return -RIG_EINVAL;
 
-	if (rig->state.priv)
+	if (rig->state.priv) {
+#ifdef HAVE_PTHREAD
+		pthread_mutex_destroy(&((struct usrp_priv_data*)rig->state.priv)->lock);
+#endif
 		free(rig->state.priv);
+	}
 	rig->state.priv = NULL;
 
 	return RIG_OK;
@@ -132,7 +163,13 @@ int usrp_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
 	struct usrp_priv_data *priv = (struct usrp_priv_data*)rig->state.priv;
 	int chan = 0;
 
-	if (!priv->urx->set_rx_freq (chan, freq))
+	int ok;
+
+	USRP_LOCK(priv);
+	ok = priv->urx->set_rx_freq (chan, freq);
+	USRP_UNLOCK(priv);
+
+	if (!ok)
 		return -RIG_EPROTO;
 
 	return RIG_OK;
@@ -144,7 +181,9 @@ int usrp_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
 	struct usrp_priv_data *priv = (struct usrp_priv_data*)rig->state.priv;
 	int chan = 0;
 
+	USRP_LOCK(priv);
 	*freq = priv->urx->rx_freq (chan);
+	USRP_UNLOCK(priv);
 
 	return RIG_OK;
 }
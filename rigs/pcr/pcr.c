@@ -43,7 +43,9 @@
 #include "misc.h"
 #include "register.h"
 #include "cal.h"
+#include "event.h"
 #include "pcr.h"
+#include "sweep.h"
 
 /*
  * modes in use by the "MD" command
@@ -233,6 +235,29 @@ pcr_read_block(RIG *rig, char *rxbuffer, size_t count)
     return -RIG_EPROTO;
 }
 
+/*
+ * I3 (I7 for the sub receiver) reports a tone as "1" and its code,
+ * 0-9 and A-D as they are, E for * and F for #, and its end as "0".
+ */
+static void
+pcr_dtmf(RIG *rig, vfo_t vfo, const char *buf)
+{
+    char digit[2];
+
+    if (buf[2] != '1')
+    {
+        return;
+    }
+
+    digit[0] = buf[3] == 'E' ? '*' : buf[3] == 'F' ? '#' : buf[3];
+    digit[1] = '\0';
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: DTMF %s on %s\n", __func__, digit,
+              rig_strvfo(vfo));
+
+    rig_fire_dtmf_event(rig, vfo, digit);
+}
+
 /* expects a 4 byte buffer to parse */
 static int
 pcr_parse_answer(RIG *rig, char *buf, int len)
@@ -287,8 +312,7 @@ pcr_parse_answer(RIG *rig, char *buf, int len)
             return RIG_OK;
 
         case '3':
-            rig_debug(RIG_DEBUG_WARN, "%s: DTMF %c\n",
-                      __func__, buf[3]);
+            pcr_dtmf(rig, RIG_VFO_MAIN, buf);
             return RIG_OK;
 
         /* Sub receiver (on PCR-2500..) - TBC */
@@ -306,8 +330,7 @@ pcr_parse_answer(RIG *rig, char *buf, int len)
             return RIG_OK;
 
         case '7':
-            rig_debug(RIG_DEBUG_WARN, "%s: DTMF %c (Sub)\n",
-                      __func__, buf[3]);
+            pcr_dtmf(rig, RIG_VFO_SUB, buf);
             return RIG_OK;
         }
     }
@@ -369,30 +392,15 @@ pcr_send(RIG *rig, const char *cmd)
 }
 
 
+/* read and parse the answer to a command already sent */
 static int
-pcr_transaction(RIG *rig, const char *cmd)
+pcr_read_answer(RIG *rig)
 {
     int err;
     struct rig_state *rs = &rig->state;
     struct pcr_priv_caps *caps = pcr_caps(rig);
     struct pcr_priv_data *priv = (struct pcr_priv_data *) rs->priv;
 
-    rig_debug(RIG_DEBUG_TRACE, "%s: cmd = %s\n",
-              __func__, cmd);
-
-    if (!priv->auto_update)
-    {
-        rig_flush(&rs->rigport);
-    }
-
-    pcr_send(rig, cmd);
-
-    /* the pcr does not give ack in auto update mode */
-    if (priv->auto_update)
-    {
-        return RIG_OK;
-    }
-
     err = pcr_read_block(rig, priv->reply_buf, caps->reply_size);
 
     if (err < 0)
@@ -411,6 +419,35 @@ pcr_transaction(RIG *rig, const char *cmd)
     return pcr_parse_answer(rig, &priv->reply_buf[caps->reply_offset], err);
 }
 
+static int
+pcr_transaction(RIG *rig, const char *cmd)
+{
+    struct rig_state *rs = &rig->state;
+    struct pcr_priv_data *priv = (struct pcr_priv_data *) rs->priv;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: cmd = %s\n",
+              __func__, cmd);
+
+    /*
+     * with the reader thread the flush only drains what it handed on,
+     * acks that nobody waits for in auto update mode among them
+     */
+    if (!priv->auto_update || rs->rigport.asyncio)
+    {
+        rig_flush(&rs->rigport);
+    }
+
+    pcr_send(rig, cmd);
+
+    /* the pcr does not give ack in auto update mode */
+    if (priv->auto_update)
+    {
+        return RIG_OK;
+    }
+
+    return pcr_read_answer(rig);
+}
+
 static int
 pcr_set_comm_speed(RIG *rig, int rate)
 {
@@ -662,7 +699,18 @@ pcr_open(RIG *rig)
     /* switch to different speed if requested */
     if (wanted_serial_rate != startup_serial_rate && wanted_serial_rate >= 300)
     {
-        return pcr_set_comm_speed(rig, wanted_serial_rate);
+        err = pcr_set_comm_speed(rig, wanted_serial_rate);
+
+        if (err != RIG_OK)
+        {
+            return err;
+        }
+    }
+
+    /* the reader thread keeps the level and squelch status from the stream */
+    if (rs->async_data_enabled)
+    {
+        return pcr_set_trn(rig, RIG_TRN_RIG);
     }
 
     return RIG_OK;
@@ -1233,6 +1281,97 @@ pcr_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
     return -RIG_ENIMPL;
 }
 
+/*
+ * pcr_get_sweep
+ *
+ * The level query goes out as soon as the dwell is over, without first
+ * waiting for the tuning ack, which is picked up together with the level
+ * afterwards.  With no dwell a step is a single round trip.
+ */
+int
+pcr_get_sweep(RIG *rig, vfo_t vfo, const struct rig_sweep_cfg *cfg,
+              unsigned char *data, size_t count)
+{
+    struct pcr_priv_data *priv = (struct pcr_priv_data *) rig->state.priv;
+    struct pcr_rcvr *rcvr = is_sub_rcvr(rig,
+                                        vfo) ? &priv->sub_rcvr : &priv->main_rcvr;
+    const char *query = is_sub_rcvr(rig, vfo) ? "I5?" : "I1?";
+    char buf[20];
+    size_t i;
+    int tries;
+    int err;
+
+    /* levels arrive unasked in auto update mode, leave it to the frontend */
+    if (priv->auto_update)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    rig_flush(&rig->state.rigport);
+
+    for (i = 0; i < count; i++)
+    {
+        freq_t freq = cfg->start + i * cfg->step;
+        struct timespec tuned;
+        double left;
+
+        SNPRINTF(buf, sizeof(buf), "K%c%010" PRIll "0%c0%c00",
+                 is_sub_rcvr(rig, vfo) ? '1' : '0',
+                 (int64_t) freq,
+                 rcvr->last_mode, rcvr->last_filter);
+
+        elapsed_ms(&tuned, HAMLIB_ELAPSED_SET);
+
+        err = pcr_send(rig, buf);
+
+        if (err != RIG_OK)
+        {
+            return err;
+        }
+
+        left = cfg->dwell_ms - elapsed_ms(&tuned, HAMLIB_ELAPSED_GET);
+
+        if (left > 0)
+        {
+            hl_usleep((rig_useconds_t)(left * 1000));
+        }
+
+        err = pcr_send(rig, query);
+
+        if (err != RIG_OK)
+        {
+            return err;
+        }
+
+        /* the tuning ack, and maybe a late one from before, then the level */
+        for (tries = 0; tries < 3; tries++)
+        {
+            err = pcr_read_answer(rig);
+
+            if (err != RIG_OK)
+            {
+                return err;
+            }
+
+            if (priv->reply_buf[pcr_caps(rig)->reply_offset] == 'I')
+            {
+                break;
+            }
+        }
+
+        if (tries == 3)
+        {
+            return -RIG_EPROTO;
+        }
+
+        rcvr->last_freq = freq;
+        data[i] = rig_sweep_level(rig_raw2val(rcvr->raw_level,
+                                              &rig->state.str_cal));
+    }
+
+    return RIG_OK;
+}
+
 
 /*
  * pcr_set_func
@@ -1898,6 +2037,110 @@ int pcr_set_trn(RIG *rig, int trn)
     }
 }
 
+/*
+ * With async data enabled, pcr_open() turns on auto update and the
+ * frontend's reader thread takes the stream.  Every answer is handed on
+ * in the shape pcr_read_block() expects, reply_size bytes with the four
+ * answer characters at reply_offset, so that what is not a status update
+ * reaches pcr_transaction() as if read from the port.
+ */
+int pcr_read_frame_direct(RIG *rig, size_t buffer_length,
+                          const unsigned char *buffer)
+{
+    hamlib_port_t *rp = &rig->state.rigport;
+    struct pcr_priv_caps *caps = pcr_caps(rig);
+    unsigned char *frame = (unsigned char *) buffer;
+    unsigned char *p = frame + caps->reply_offset;
+    int skipped = 0;
+    int err;
+
+    if (buffer_length < caps->reply_size)
+    {
+        return -RIG_EINTERNAL;
+    }
+
+    memset(frame, 0x0a, caps->reply_size);
+
+    /* CR/LF and whatever else lies between answers */
+    do
+    {
+        err = read_block_direct(rp, p, 1);
+
+        if (err < 0)
+        {
+            return err;
+        }
+
+        if (err != 1 || ++skipped > PCR_MAX_CMD_LEN)
+        {
+            return -RIG_EPROTO;
+        }
+    }
+    while (!is_valid_answer(*p));
+
+    err = read_block_direct(rp, p + 1, 3);
+
+    if (err < 0)
+    {
+        return err;
+    }
+
+    if (err != 3)
+    {
+        return -RIG_EPROTO;
+    }
+
+    return caps->reply_size;
+}
+
+/* in auto update mode every I answer is pushed, nothing asks for them */
+int pcr_is_async_frame(RIG *rig, size_t frame_length,
+                       const unsigned char *frame)
+{
+    struct pcr_priv_data *priv = (struct pcr_priv_data *) rig->state.priv;
+    struct pcr_priv_caps *caps = pcr_caps(rig);
+
+    return priv->auto_update && frame_length == caps->reply_size
+           && frame[caps->reply_offset] == 'I';
+}
+
+int pcr_process_async_frame(RIG *rig, size_t frame_length,
+                            const unsigned char *frame)
+{
+    struct pcr_priv_data *priv = (struct pcr_priv_data *) rig->state.priv;
+    struct pcr_priv_caps *caps = pcr_caps(rig);
+    unsigned int main_sql = priv->main_rcvr.squelch_status;
+    unsigned int sub_sql = priv->sub_rcvr.squelch_status;
+    char buf[5];
+    int err;
+
+    /* NUL terminated for the sscanf in pcr_parse_answer() */
+    memcpy(buf, frame + caps->reply_offset, 4);
+    buf[4] = '\0';
+
+    err = pcr_parse_answer(rig, buf, 4);
+
+    if (err != RIG_OK)
+    {
+        return err;
+    }
+
+    /* squelch opening and closing is the DCD, see pcr_get_dcd() */
+    if ((main_sql ^ priv->main_rcvr.squelch_status) & 0x02)
+    {
+        rig_fire_dcd_event(rig, RIG_VFO_MAIN, (priv->main_rcvr.squelch_status & 0x02)
+                           ? RIG_DCD_ON : RIG_DCD_OFF);
+    }
+
+    if ((sub_sql ^ priv->sub_rcvr.squelch_status) & 0x02)
+    {
+        rig_fire_dcd_event(rig, RIG_VFO_SUB, (priv->sub_rcvr.squelch_status & 0x02)
+                           ? RIG_DCD_ON : RIG_DCD_OFF);
+    }
+
+    return RIG_OK;
+}
+
 int pcr_decode_event(RIG *rig)
 {
     int err;
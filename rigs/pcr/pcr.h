@@ -101,6 +101,8 @@ const char *pcr_get_info(RIG *rig);
 
 int pcr_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val);
 int pcr_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val);
+int pcr_get_sweep(RIG *rig, vfo_t vfo, const struct rig_sweep_cfg *cfg,
+                  unsigned char *data, size_t count);
 
 int pcr_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status);
 int pcr_set_func(RIG *rig, vfo_t vfo, setting_t func, int status);
@@ -112,6 +114,12 @@ int pcr_get_dcs_sql(RIG *rig, vfo_t vfo, tone_t *tone);
 int pcr_set_dcs_sql(RIG *rig, vfo_t vfo, tone_t tone);
 int pcr_set_trn(RIG * rig, int trn);
 int pcr_decode_event(RIG *rig);
+int pcr_read_frame_direct(RIG *rig, size_t buffer_length,
+                          const unsigned char *buffer);
+int pcr_is_async_frame(RIG *rig, size_t frame_length,
+                       const unsigned char *frame);
+int pcr_process_async_frame(RIG *rig, size_t frame_length,
+                            const unsigned char *frame);
 int pcr_set_powerstat(RIG * rig, powerstat_t status);
 int pcr_get_powerstat(RIG * rig, powerstat_t *status);
 int pcr_get_dcd(RIG * rig, vfo_t vfo, dcd_t *dcd);
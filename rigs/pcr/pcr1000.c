@@ -153,6 +153,7 @@ const struct rig_caps pcr1000_caps =
 
     .set_level  = pcr_set_level,
     .get_level  = pcr_get_level,
+    .get_sweep  = pcr_get_sweep,
 
     .set_func   = pcr_set_func,
     .get_func   = pcr_get_func,
@@ -162,6 +163,12 @@ const struct rig_caps pcr1000_caps =
 
     .set_trn    = pcr_set_trn,
     .decode_event   = pcr_decode_event,
+    .get_dcd    = pcr_get_dcd,
+
+    .async_data_supported = 1,
+    .read_frame_direct = pcr_read_frame_direct,
+    .is_async_frame = pcr_is_async_frame,
+    .process_async_frame = pcr_process_async_frame,
 
     .set_powerstat  = pcr_set_powerstat,
     .get_powerstat  = pcr_get_powerstat,
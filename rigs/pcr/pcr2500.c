@@ -176,6 +176,7 @@ const struct rig_caps pcr2500_caps =
 
     .set_level  = pcr_set_level,
     .get_level  = pcr_get_level,
+    .get_sweep  = pcr_get_sweep,
 
     .set_ext_level  = pcr_set_ext_level,
 
@@ -191,6 +192,11 @@ const struct rig_caps pcr2500_caps =
     .decode_event   = pcr_decode_event,
     .get_dcd    = pcr_get_dcd,
 
+    .async_data_supported = 1,
+    .read_frame_direct = pcr_read_frame_direct,
+    .is_async_frame = pcr_is_async_frame,
+    .process_async_frame = pcr_process_async_frame,
+
     .set_powerstat  = pcr_set_powerstat,
     .get_powerstat  = pcr_get_powerstat,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
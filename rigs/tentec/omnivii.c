@@ -32,6 +32,7 @@
 #include "tentec.h"
 #include "tentec2.h"
 #include "bandplan.h"
+#include "cache.h"
 
 struct tt588_priv_data
 {
@@ -95,6 +96,7 @@ static int tt588_get_split_freq(RIG *rig, vfo_t vfo, freq_t *tx_freq);
 static int tt588_set_vfo(RIG *rig, vfo_t vfo);
 static int tt588_get_vfo(RIG *rig, vfo_t *vfo);
 static int tt588_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width);
+static int tt588_get_bulk(RIG *rig, struct rig_bulk *bulk);
 static int tt588_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width);
 static char which_vfo(const RIG *rig, vfo_t vfo);
 static int tt588_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val);
@@ -228,6 +230,7 @@ const struct rig_caps tt588_caps =
     .set_split_vfo =  tt588_set_split_vfo,
     .get_split_vfo =  tt588_get_split_vfo,
     .set_ptt =  tt588_set_ptt,
+    .get_bulk =  tt588_get_bulk,
     .reset =  tt588_reset,
     .get_info =  tt588_get_info,
     .get_xit = tt588_get_xit,
@@ -595,6 +598,27 @@ int tt588_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *tx_mode,
     return tt588_get_mode(rig, RIG_VFO_B, tx_mode, tx_width);
 }
 
+/* Hamlib mode for a ?M reply character, RIG_MODE_NONE if unknown */
+static rmode_t tt588_mode2rig(char ttmode)
+{
+    switch (ttmode)
+    {
+    case TT588_AM:  return RIG_MODE_AM;
+
+    case TT588_USB: return RIG_MODE_USB;
+
+    case TT588_LSB: return RIG_MODE_LSB;
+
+    case TT588_CW: return RIG_MODE_CW;
+
+    case TT588_CWR: return RIG_MODE_CWR;
+
+    case TT588_FM: return RIG_MODE_FM;
+
+    default: return RIG_MODE_NONE;
+    }
+}
+
 /*
  * tt588_get_mode
  * Assumes rig!=NULL, mode!=NULL
@@ -660,21 +684,10 @@ int tt588_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
         break;
     }
 
-    switch (ttmode)
-    {
-    case TT588_AM:  *mode = RIG_MODE_AM;  break;
-
-    case TT588_USB: *mode = RIG_MODE_USB; break;
-
-    case TT588_LSB: *mode = RIG_MODE_LSB; break;
-
-    case TT588_CW: *mode = RIG_MODE_CW;  break;
-
-    case TT588_CWR: *mode = RIG_MODE_CWR;  break;
-
-    case TT588_FM: *mode = RIG_MODE_FM;  break;
+    *mode = tt588_mode2rig(ttmode);
 
-    default:
+    if (*mode == RIG_MODE_NONE)
+    {
         rig_debug(RIG_DEBUG_ERR, "%s: unsupported mode '%c'\n", __func__, ttmode);
         return -RIG_EPROTO;
     }
@@ -787,6 +800,130 @@ int tt588_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
     return RIG_OK;
 }
 
+/*
+ * tt588_get_bulk
+ * ?A, ?B, ?M, ?W and ?S go out in one write and the answers are read back
+ * in order.  They hold binary bytes, so each one is read by its length
+ * rather than up to a CR; ?S is 6 bytes in Rx and 4 in Tx, as the top bit
+ * of its first data byte tells.  The Rx S-meter goes to the level cache as
+ * well, for a STRENGTH read following the poll.
+ */
+static int tt588_get_bulk(RIG *rig, struct rig_bulk *bulk)
+{
+    hamlib_port_t *rp = &rig->state.rigport;
+    int want_freqA = bulk->mask & RIG_BULK_FREQ_A;
+    int want_freqB = bulk->mask & RIG_BULK_FREQ_B;
+    int want_mode = bulk->mask & (RIG_BULK_MODE_A | RIG_BULK_MODE_B);
+    int want_meter = bulk->mask & (RIG_BULK_PTT | RIG_BULK_STRENGTH);
+    unsigned char respbuf[8];
+    char cmdbuf[16] = "";
+    rmode_t modeA = RIG_MODE_NONE, modeB = RIG_MODE_NONE;
+    int retval;
+
+    if (want_freqA) { strcat(cmdbuf, "?A" EOM); }
+
+    if (want_freqB) { strcat(cmdbuf, "?B" EOM); }
+
+    if (want_mode) { strcat(cmdbuf, "?M" EOM "?W" EOM); }
+
+    if (want_meter) { strcat(cmdbuf, "?S" EOM); }
+
+    if (!cmdbuf[0]) { return RIG_OK; }
+
+    rig_flush(rp);
+    retval = write_block(rp, (unsigned char *) cmdbuf, strlen(cmdbuf));
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+#define TT588_BULK_READ(len, c) \
+    retval = read_block(rp, respbuf, (len)); \
+    if (retval != (len) || respbuf[0] != (c) || respbuf[(len) - 1] != 0x0d) \
+    { \
+        rig_debug(RIG_DEBUG_ERR, "%s: bad or missing '%c' answer\n", __func__, (c)); \
+        rig_flush(rp); \
+        return retval < 0 ? retval : -RIG_EPROTO; \
+    }
+
+    if (want_freqA)
+    {
+        TT588_BULK_READ(6, 'A');
+        bulk->freqA = (respbuf[1] << 24) + (respbuf[2] << 16)
+                      + (respbuf[3] << 8) + respbuf[4];
+        bulk->valid |= RIG_BULK_FREQ_A;
+    }
+
+    if (want_freqB)
+    {
+        TT588_BULK_READ(6, 'B');
+        bulk->freqB = (respbuf[1] << 24) + (respbuf[2] << 16)
+                      + (respbuf[3] << 8) + respbuf[4];
+        bulk->valid |= RIG_BULK_FREQ_B;
+    }
+
+    if (want_mode)
+    {
+        TT588_BULK_READ(4, 'M');
+        modeA = tt588_mode2rig(respbuf[1]);
+        modeB = tt588_mode2rig(respbuf[2]);
+
+        /* one filter for both VFOs, as in tt588_get_mode() */
+        TT588_BULK_READ(3, 'W');
+
+        if (respbuf[1] < sizeof(tt588_rxFilter) / sizeof(tt588_rxFilter[0]))
+        {
+            if (modeA != RIG_MODE_NONE)
+            {
+                bulk->modeA = modeA;
+                bulk->widthA = tt588_rxFilter[respbuf[1]];
+                bulk->valid |= RIG_BULK_MODE_A;
+            }
+
+            if (modeB != RIG_MODE_NONE)
+            {
+                bulk->modeB = modeB;
+                bulk->widthB = tt588_rxFilter[respbuf[1]];
+                bulk->valid |= RIG_BULK_MODE_B;
+            }
+        }
+    }
+
+    if (want_meter)
+    {
+        retval = read_block(rp, respbuf, 4);
+
+        if (retval != 4 || respbuf[0] != 'S')
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: bad or missing 'S' answer\n", __func__);
+            rig_flush(rp);
+            return retval < 0 ? retval : -RIG_EPROTO;
+        }
+
+        bulk->ptt = (respbuf[1] & 0x80) ? RIG_PTT_ON : RIG_PTT_OFF;
+        bulk->valid |= RIG_BULK_PTT;
+
+        if (!(respbuf[1] & 0x80))
+        {
+            int slevel;
+
+            /* Rx reply is S0944<CR>, S-units then dB over S9 */
+            if (read_block(rp, respbuf + 4, 2) == 2 && respbuf[5] == 0x0d
+                    && sscanf((char *) respbuf, "S%02d", &slevel) == 1)
+            {
+                bulk->strength.i = (slevel - 9) * 6;
+                bulk->valid |= RIG_BULK_STRENGTH;
+                rig_set_cache_level(rig, RIG_VFO_CURR, RIG_LEVEL_STRENGTH, bulk->strength);
+            }
+        }
+    }
+
+#undef TT588_BULK_READ
+
+    return RIG_OK;
+}
+
 /* Find rx filter index of bandwidth the same or larger as requested. */
 static int tt588_filter_number(int width)
 {
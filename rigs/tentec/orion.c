@@ -81,6 +81,7 @@
 #include "serial.h"
 #include "misc.h"
 #include "idx_builtin.h"
+#include "cache.h"
 #include "orion.h"
 #include <cal.h>
 
@@ -686,6 +687,32 @@ int tt565_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
     return retval;
 }
 
+/**
+ * \param ttmode Orion mode character, as in the ?RxM reply
+ * \returns Hamlib mode, RIG_MODE_NONE if unknown
+ */
+static rmode_t tt565_mode2rig(char ttmode)
+{
+    switch (ttmode)
+    {
+    case TT565_USB: return RIG_MODE_USB;
+
+    case TT565_LSB: return RIG_MODE_LSB;
+
+    case TT565_CW:  return RIG_MODE_CW;
+
+    case TT565_CWR: return RIG_MODE_CWR;
+
+    case TT565_AM:  return RIG_MODE_AM;
+
+    case TT565_FM:  return RIG_MODE_FM;
+
+    case TT565_RTTY:    return RIG_MODE_RTTY;
+
+    default: return RIG_MODE_NONE;
+    }
+}
+
 /**
  * \param rig must != NULL
  * \param vfo
@@ -722,24 +749,10 @@ int tt565_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
     }
 
     ttmode = respbuf[4];
+    *mode = tt565_mode2rig(ttmode);
 
-    switch (ttmode)
+    if (*mode == RIG_MODE_NONE)
     {
-    case TT565_USB: *mode = RIG_MODE_USB; break;
-
-    case TT565_LSB: *mode = RIG_MODE_LSB; break;
-
-    case TT565_CW:  *mode = RIG_MODE_CW;  break;
-
-    case TT565_CWR: *mode = RIG_MODE_CWR;  break;
-
-    case TT565_AM:  *mode = RIG_MODE_AM;  break;
-
-    case TT565_FM:  *mode = RIG_MODE_FM;  break;
-
-    case TT565_RTTY:    *mode = RIG_MODE_RTTY;  break;
-
-    default:
         rig_debug(RIG_DEBUG_ERR, "%s: unsupported mode '%c'\n",
                   __func__, ttmode);
         return -RIG_EPROTO;
@@ -988,6 +1001,121 @@ int tt565_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
     return RIG_OK;
 }
 
+/**
+ * \param rig must != NULL
+ * \param bulk Selection in bulk->mask, results, see rig_get_bulk()
+ * \returns RIG_OK or < 0
+ * \brief Read VFO frequencies, main Rx mode, PTT and S-meter in one go
+ *
+ * The queries are written back to back and Orion answers them in order,
+ * so a status poll costs one round trip instead of one per query plus the
+ * pause tt565_get_mode() leaves between ?RxM and ?RxF.  For the same
+ * reason ?RMF goes last, with the other queries between it and ?RMM.
+ * Frequencies are asked in ASCII (?AF) whatever TT565_ASCII_FREQ says, as
+ * a binary byte could pass for the CR ending a reply.
+ *
+ * The main Rx S-meter also goes to the level cache as RAWSTR, so that a
+ * STRENGTH read right after the poll does not send ?S again.
+ */
+int tt565_get_bulk(RIG *rig, struct rig_bulk *bulk)
+{
+    char buf[5][TT565_BUFSIZE];
+    const char *cmds[5];
+    char *replies[5];
+    rmode_t mode = RIG_MODE_NONE;
+    pbwidth_t width = 0;
+    int n = 0;
+    int retval;
+    int i;
+
+    if (bulk->mask & RIG_BULK_FREQ_A) { cmds[n] = "?AF" EOM; replies[n] = buf[n]; n++; }
+
+    if (bulk->mask & RIG_BULK_FREQ_B) { cmds[n] = "?BF" EOM; replies[n] = buf[n]; n++; }
+
+    if (bulk->mask & (RIG_BULK_MODE_A | RIG_BULK_MODE_B))
+    {
+        cmds[n] = "?RMM" EOM;
+        replies[n] = buf[n];
+        n++;
+    }
+
+    if (bulk->mask & (RIG_BULK_PTT | RIG_BULK_STRENGTH))
+    {
+        cmds[n] = "?S" EOM;
+        replies[n] = buf[n];
+        n++;
+    }
+
+    if (bulk->mask & (RIG_BULK_MODE_A | RIG_BULK_MODE_B))
+    {
+        cmds[n] = "?RMF" EOM;
+        replies[n] = buf[n];
+        n++;
+    }
+
+    if (n == 0) { return RIG_OK; }
+
+    retval = rig_transaction_batch(rig, cmds, n, replies, TT565_BUFSIZE, EOM[0]);
+
+    for (i = 0; i < n; i++)
+    {
+        const char *r = buf[i];
+        unsigned int binf;
+
+        if (r[0] != '@') { continue; }  /* unread, or Z! for a rejected query */
+
+        if ((r[1] == 'A' || r[1] == 'B') && r[2] == 'F'
+                && sscanf(r + 3, "%8u", &binf) == 1)
+        {
+            if (r[1] == 'A')
+            {
+                bulk->freqA = (freq_t) binf;
+                bulk->valid |= RIG_BULK_FREQ_A;
+            }
+            else
+            {
+                bulk->freqB = (freq_t) binf;
+                bulk->valid |= RIG_BULK_FREQ_B;
+            }
+        }
+        else if (!strncmp(r + 1, "RMM", 3))
+        {
+            mode = tt565_mode2rig(r[4]);
+        }
+        else if (!strncmp(r + 1, "RMF", 3) && isdigit((unsigned char)r[4]))
+        {
+            width = atoi(r + 4);
+        }
+        else if (r[1] == 'S' && (r[2] == 'T' || r[2] == 'R'))
+        {
+            value_t rawstr;
+
+            /* @SRMnnnSnnn in Rx, S-meter in Tx => 0, as tt565_get_level() */
+            rawstr.i = r[2] == 'R' ? atoi(r + 4) : 0;
+            rig_set_cache_level(rig, RIG_VFO_MAIN, RIG_LEVEL_RAWSTR, rawstr);
+
+            bulk->ptt = r[2] == 'T' ? RIG_PTT_ON : RIG_PTT_OFF;
+            bulk->valid |= RIG_BULK_PTT;
+
+            if (rig->state.str_cal.size)
+            {
+                bulk->strength.i = (int)rig_raw2val(rawstr.i, &rig->state.str_cal);
+                bulk->valid |= RIG_BULK_STRENGTH;
+            }
+        }
+    }
+
+    /* both VFOs use the main receiver, as in tt565_get_mode() */
+    if (mode != RIG_MODE_NONE && width > 0)
+    {
+        bulk->modeA = bulk->modeB = mode;
+        bulk->widthA = bulk->widthB = width;
+        bulk->valid |= RIG_BULK_MODE_A | RIG_BULK_MODE_B;
+    }
+
+    return retval;
+}
+
 /**
  * \param rig must != NULL
  * \param reset (not used)
@@ -64,6 +64,7 @@ static int tt565_set_split_vfo(RIG *rig, vfo_t vfo, split_t split, vfo_t tx_vfo)
 static int tt565_get_split_vfo(RIG *rig, vfo_t vfo, split_t *split, vfo_t *tx_vfo);
 static int tt565_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt);
 static int tt565_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt);
+static int tt565_get_bulk(RIG *rig, struct rig_bulk *bulk);
 static int tt565_reset(RIG *rig, reset_t reset);
 static int tt565_set_mem(RIG * rig, vfo_t vfo, int ch);
 static int tt565_get_mem(RIG * rig, vfo_t vfo, int *ch);
@@ -348,6 +349,7 @@ RIG_MODEL(RIG_MODEL_TT565),
 .get_mem =  tt565_get_mem,
 .set_ptt =  tt565_set_ptt,
 .get_ptt =  tt565_get_ptt,
+.get_bulk =  tt565_get_bulk,
 .vfo_op =  tt565_vfo_op,
 .set_ts =  tt565_set_ts,
 .get_ts =  tt565_get_ts,
@@ -527,6 +529,7 @@ RIG_MODEL(RIG_MODEL_TT599),
 .get_mem =  tt565_get_mem,
 .set_ptt =  tt565_set_ptt,
 .get_ptt =  tt565_get_ptt,
+.get_bulk =  tt565_get_bulk,
 .vfo_op =  tt565_vfo_op,
 .get_info =  tt565_get_info,
 .get_func = tt565_get_func,
@@ -74,7 +74,7 @@ const struct rig_caps bcd996t_caps =
 
     .has_get_func =  BCD996T_FUNC,
     .has_set_func =  BCD996T_FUNC,
-    .has_get_level =  BCD996T_LEVEL_ALL,
+    .has_get_level =  BCD996T_LEVEL_ALL | RIG_LEVEL_RAWSTR,
     .has_set_level =  RIG_LEVEL_SET(BCD996T_LEVEL_ALL),
     .has_get_parm =  BCD996T_PARM_ALL,
     .has_set_parm =  RIG_PARM_SET(BCD996T_PARM_ALL),
@@ -118,9 +118,21 @@ const struct rig_caps bcd996t_caps =
         RIG_FLT_END,
     },
 
+    .cfgparams =  uniden_digital_cfg_params,
+    .priv =  NULL,
+
+    .rig_init =  uniden_digital_init,
+    .rig_cleanup =  uniden_digital_cleanup,
+    .rig_open =  uniden_digital_open,
+    .rig_close =  uniden_digital_close,
+    .set_conf =  uniden_digital_set_conf,
+    .get_conf2 =  uniden_digital_get_conf2,
+
     .get_info =  uniden_digital_get_info,
     .set_freq =  uniden_digital_set_freq,
     .get_freq =  uniden_digital_get_freq,
+    .get_dcd =  uniden_digital_get_dcd,
+    .get_level =  uniden_digital_get_level,
     .hamlib_check_rig_caps = HAMLIB_CHECK_RIG_CAPS
 };
 
@@ -26,10 +26,17 @@
 #include <string.h>  /* String function definitions */
 #include <unistd.h>  /* UNIX standard function definitions */
 #include <math.h>
+#include <errno.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 #include "hamlib/rig.h"
 #include "serial.h"
 #include "misc.h"
+#include "token.h"
+#include "event.h"
 
 #include "uniden_digital.h"
 
@@ -74,6 +81,19 @@ uniden_id_string_list[] =
 /* I'm still getting clipped output from buffers  being too small elsewhere! */
 #define BUFSZ 256  /* Wild guess, 64 was too small. */
 
+#define TOK_MONITOR TOKEN_BACKEND(1)
+
+const struct confparams uniden_digital_cfg_params[] =
+{
+    {
+        TOK_MONITOR, "monitor", "Status monitor period", "Poll GLG in the background every this many ms, slower while nothing changes, report status, frequency and squelch changes as events and answer get_freq, get_dcd and RAWSTR from the last reading. 0 disables", "0", RIG_CONF_NUMERIC, { .n = { 0, 10000, 1 } }
+    },
+    { RIG_CONF_END, NULL, }
+};
+
+static void uniden_monitor_lock(RIG *rig);
+static void uniden_monitor_unlock(RIG *rig);
+
 /**
  * uniden_transaction
  * uniden_digital_transaction
@@ -108,6 +128,7 @@ uniden_digital_transaction(RIG *rig, const char *cmdstr, int cmd_len,
     size_t reply_len = BUFSZ;
 
     rs = &rig->state;
+    uniden_monitor_lock(rig);
     rs->transaction_active = 1;
 
 transaction_write:
@@ -165,7 +186,7 @@ transaction_write:
         goto transaction_quit;
     }*/
 
-    if (strcmp(data, "OK"EOM))
+    if (strcmp(data, "OK"EOM) == 0)
     {
         /* everything is fine */
         retval = RIG_OK;
@@ -176,7 +197,7 @@ transaction_write:
      *  in the right mode or using the correct parameters. ERR indicates
      *  an INVALID Command.
      */
-    if (strcmp(data, "NG"EOM))
+    if (strcmp(data, "NG"EOM) == 0)
     {
         /* Invalid command */
         rig_debug(RIG_DEBUG_VERBOSE,
@@ -185,7 +206,7 @@ transaction_write:
         goto transaction_quit;
     }
 
-    if (strcmp(data, "ERR"EOM))
+    if (strcmp(data, "ERR"EOM) == 0)
     {
         /*  Command format error */
         rig_debug(RIG_DEBUG_VERBOSE,
@@ -194,7 +215,7 @@ transaction_write:
         goto transaction_quit;
     }
 
-    if (strcmp(data, "FER"EOM))
+    if (strcmp(data, "FER"EOM) == 0)
     {
         /*  Framing error */
         rig_debug(RIG_DEBUG_VERBOSE, "%s: Framing Error for '%s'\n", __func__, cmdstr);
@@ -202,7 +223,7 @@ transaction_write:
         goto transaction_quit;
     }
 
-    if (strcmp(data, "ORER"EOM))
+    if (strcmp(data, "ORER"EOM) == 0)
     {
         /*  Overrun error */
         rig_debug(RIG_DEBUG_VERBOSE, "%s: Overrun Error for '%s'\n", __func__, cmdstr);
@@ -262,6 +283,7 @@ transaction_write:
     retval = RIG_OK;
 transaction_quit:
     rs->transaction_active = 0;
+    uniden_monitor_unlock(rig);
     return retval;
 }
 
@@ -397,34 +419,552 @@ int uniden_digital_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
 }
 
 /*
- * skeleton
+ * Bits of the receiver state the GLG and PWR answers give away, and the
+ * background monitor that keeps them.
+ *
+ * "GLG" answers
+ *   GLG,FRQ/TGID,MOD,ATT,CTCSS/DCS,NAME1,NAME2,NAME3,SQL,MUT,SYS_TAG,CHAN_TAG,P25NAC
+ * with every field empty while nothing is received, FRQ in MHz
+ * (XXXX.XXXX) on conventional channels and the talkgroup otherwise.
+ * "PWR" answers PWR,RSSI,FRQ with RSSI 0..1023 and FRQ in 100 Hz.
  */
-int uniden_digital_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
+#define UNIDEN_GLG_FIELDS   12
+#define UNIDEN_GLG_SQL      7
+
+struct uniden_status
 {
-#if 0
-    char freqbuf[BUFSZ];
-    size_t freq_len = BUFSZ;
+    char glg[BUFSZ];    /* GLG fields, as the status text */
+    freq_t freq;        /* 0 while unknown, e.g. on a talkgroup */
+    dcd_t dcd;
+};
+
+static int uniden_parse_glg(const char *reply, struct uniden_status *st)
+{
+    const char *field[UNIDEN_GLG_FIELDS];
+    const char *p;
+    int n;
+
+    if (strncmp(reply, "GLG,", 4) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: unexpected answer '%s'\n", __func__, reply);
+        return -RIG_EPROTO;
+    }
+
+    SNPRINTF(st->glg, sizeof(st->glg), "%s", reply + 4);
+    st->glg[strcspn(st->glg, "\r\n")] = '\0';
+
+    for (n = 0, p = st->glg; n < UNIDEN_GLG_FIELDS && p; n++)
+    {
+        field[n] = p;
+        p = strchr(p, ',');
+
+        if (p)
+        {
+            p++;
+        }
+    }
+
+    if (n <= UNIDEN_GLG_SQL)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: short answer '%s'\n", __func__, reply);
+        return -RIG_EPROTO;
+    }
+
+    st->freq = 0;
+
+    if (memchr(field[0], '.', strcspn(field[0], ",")))
+    {
+        st->freq = atof(field[0]) * 1e6;
+    }
+
+    st->dcd = field[UNIDEN_GLG_SQL][0] == '1' ? RIG_DCD_ON : RIG_DCD_OFF;
+
+    return RIG_OK;
+}
+
+static int uniden_parse_pwr(const char *reply, int *rssi, freq_t *freq)
+{
+    unsigned long frq;
+
+    if (sscanf(reply, "PWR,%d,%lu", rssi, &frq) != 2)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: unexpected answer '%s'\n", __func__, reply);
+        return -RIG_EPROTO;
+    }
+
+    *freq = frq * 100.0;
+
+    return RIG_OK;
+}
+
+static int uniden_read_glg(RIG *rig, struct uniden_status *st)
+{
+    char buf[BUFSZ];
+    size_t buf_len = BUFSZ;
     int ret;
 
-    ret = uniden_transaction(rig, "RF" EOM, 3, NULL, freqbuf, &freq_len);
+    ret = uniden_digital_transaction(rig, "GLG" EOM, 4, NULL, buf, &buf_len);
 
     if (ret != RIG_OK)
     {
         return ret;
     }
 
-    if (freq_len < 10)
+    return uniden_parse_glg(buf, st);
+}
+
+static int uniden_read_pwr(RIG *rig, int *rssi, freq_t *freq)
+{
+    char buf[BUFSZ];
+    size_t buf_len = BUFSZ;
+    int ret;
+
+    ret = uniden_digital_transaction(rig, "PWR" EOM, 4, NULL, buf, &buf_len);
+
+    if (ret != RIG_OK)
     {
-        return -RIG_EPROTO;
+        return ret;
+    }
+
+    return uniden_parse_pwr(buf, rssi, freq);
+}
+
+
+/*
+ * Trunk logging wants every talkgroup and squelch change, which means
+ * reading GLG continuously.  With "monitor" set a thread does that at
+ * monitor_ms, and at each poll with the squelch open reads PWR too.
+ * Changes fire the status, frequency and DCD events; the getters answer
+ * from the last reading while it is fresh.
+ *
+ * After UNIDEN_MONITOR_IDLE_POLLS polls with nothing new and the squelch
+ * closed the period doubles, up to UNIDEN_MONITOR_SLOWEST times
+ * monitor_ms; the first change brings it back.  A poll is skipped while
+ * an API call holds the port.
+ */
+#define UNIDEN_MONITOR_IDLE_POLLS   10
+#define UNIDEN_MONITOR_SLOWEST      8
+
+#ifdef HAVE_PTHREAD
+
+struct uniden_monitor
+{
+    RIG *rig;
+    pthread_t thread;
+    pthread_mutex_t io_lock;        /* recursive, held for each transaction */
+    pthread_mutex_t cache_lock;     /* st, rssi and their times */
+    volatile int run;
+    struct uniden_status st;
+    int st_valid;
+    struct timespec st_time;
+    int rssi;
+    int rssi_valid;
+    struct timespec rssi_time;
+};
+
+static void uniden_monitor_lock(RIG *rig)
+{
+    struct uniden_digital_priv_data *priv = rig->state.priv;
+
+    if (priv && priv->monitor)
+    {
+        pthread_mutex_lock(&priv->monitor->io_lock);
+    }
+}
+
+static void uniden_monitor_unlock(RIG *rig)
+{
+    struct uniden_digital_priv_data *priv = rig->state.priv;
+
+    if (priv && priv->monitor)
+    {
+        pthread_mutex_unlock(&priv->monitor->io_lock);
     }
+}
 
-    sscanf(freqbuf + 2, "%"SCNfreq, freq);
-    /* returned freq in hundreds of Hz */
-    *freq *= 100;
+/* One GLG, plus PWR while receiving, io_lock held; 1 if anything changed */
+static int uniden_monitor_poll(struct uniden_monitor *mon)
+{
+    RIG *rig = mon->rig;
+    struct uniden_status st;
+    struct uniden_status old;
+    int had;
+    int rssi = 0;
+    freq_t pwr_freq = 0;
+    int pwr_ok = 0;
+
+    if (uniden_read_glg(rig, &st) != RIG_OK)
+    {
+        return 0;
+    }
 
+    if (st.dcd == RIG_DCD_ON)
+    {
+        pwr_ok = uniden_read_pwr(rig, &rssi, &pwr_freq) == RIG_OK;
+
+        /* PWR knows the frequency of a talkgroup too */
+        if (pwr_ok && st.freq == 0)
+        {
+            st.freq = pwr_freq;
+        }
+    }
+
+    pthread_mutex_lock(&mon->cache_lock);
+    old = mon->st;
+    had = mon->st_valid;
+    mon->st = st;
+    mon->st_valid = 1;
+    elapsed_ms(&mon->st_time, HAMLIB_ELAPSED_SET);
+
+    if (pwr_ok)
+    {
+        mon->rssi = rssi;
+        mon->rssi_valid = 1;
+        elapsed_ms(&mon->rssi_time, HAMLIB_ELAPSED_SET);
+    }
+
+    pthread_mutex_unlock(&mon->cache_lock);
+
+    if (had && strcmp(old.glg, st.glg) == 0)
+    {
+        return 0;
+    }
+
+    rig_fire_status_event(rig, RIG_VFO_CURR, st.glg);
+
+    if (st.freq != 0 && (!had || st.freq != old.freq))
+    {
+        rig_fire_freq_event(rig, RIG_VFO_CURR, st.freq);
+    }
+
+    if (!had || st.dcd != old.dcd)
+    {
+        rig_fire_dcd_event(rig, RIG_VFO_CURR, st.dcd);
+    }
+
+    return 1;
+}
+
+static void *uniden_monitor_thread(void *arg)
+{
+    struct uniden_monitor *mon = arg;
+    struct uniden_digital_priv_data *priv = mon->rig->state.priv;
+    int period = priv->monitor_ms;
+    int idle = 0;
+
+    while (mon->run)
+    {
+        struct timespec start;
+        int changed;
+
+        elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+        if (pthread_mutex_trylock(&mon->io_lock) != 0)
+        {
+            hl_usleep(priv->monitor_ms * 1000);
+            continue;
+        }
+
+        changed = uniden_monitor_poll(mon);
+        pthread_mutex_unlock(&mon->io_lock);
+
+        if (changed || mon->st.dcd == RIG_DCD_ON)
+        {
+            period = priv->monitor_ms;
+            idle = 0;
+        }
+        else if (++idle >= UNIDEN_MONITOR_IDLE_POLLS
+                 && period < UNIDEN_MONITOR_SLOWEST * priv->monitor_ms)
+        {
+            period *= 2;
+            idle = 0;
+            rig_debug(RIG_DEBUG_TRACE, "%s: idle, polling every %d ms\n", __func__,
+                      period);
+        }
+
+        /* short naps, so that close does not wait for a slow period */
+        while (mon->run && elapsed_ms(&start, HAMLIB_ELAPSED_GET) < period)
+        {
+            hl_usleep(10 * 1000);
+        }
+    }
+
+    return NULL;
+}
+
+static int uniden_monitor_start(RIG *rig)
+{
+    struct uniden_digital_priv_data *priv = rig->state.priv;
+    struct uniden_monitor *mon;
+    pthread_mutexattr_t attr;
+
+    ENTERFUNC;
+
+    if (priv->monitor)
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
+    mon = calloc(1, sizeof(*mon));
+
+    if (!mon)
+    {
+        RETURNFUNC(-RIG_ENOMEM);
+    }
+
+    mon->rig = rig;
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&mon->io_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    pthread_mutex_init(&mon->cache_lock, NULL);
+
+    mon->run = 1;
+    priv->monitor = mon;
+
+    if (pthread_create(&mon->thread, NULL, uniden_monitor_thread, mon))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        priv->monitor = NULL;
+        pthread_mutex_destroy(&mon->io_lock);
+        pthread_mutex_destroy(&mon->cache_lock);
+        free(mon);
+        RETURNFUNC(-RIG_EINTERNAL);
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+static void uniden_monitor_stop(RIG *rig)
+{
+    struct uniden_digital_priv_data *priv = rig->state.priv;
+    struct uniden_monitor *mon = priv->monitor;
+
+    if (!mon)
+    {
+        return;
+    }
+
+    mon->run = 0;
+    pthread_join(mon->thread, NULL);
+
+    priv->monitor = NULL;
+    pthread_mutex_destroy(&mon->io_lock);
+    pthread_mutex_destroy(&mon->cache_lock);
+    free(mon);
+}
+
+/* Last reading, if not older than two of the slowest periods */
+static int uniden_monitor_cached(RIG *rig, struct uniden_status *st, int *rssi)
+{
+    struct uniden_digital_priv_data *priv = rig->state.priv;
+    struct uniden_monitor *mon = priv ? priv->monitor : NULL;
+    int max_age;
+    int ret = -RIG_ENAVAIL;
+
+    if (!mon)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    max_age = 2 * UNIDEN_MONITOR_SLOWEST * priv->monitor_ms;
+
+    pthread_mutex_lock(&mon->cache_lock);
+
+    if (st && mon->st_valid
+            && elapsed_ms(&mon->st_time, HAMLIB_ELAPSED_GET) <= max_age)
+    {
+        *st = mon->st;
+        ret = RIG_OK;
+    }
+
+    if (rssi && mon->rssi_valid
+            && elapsed_ms(&mon->rssi_time, HAMLIB_ELAPSED_GET) <= max_age)
+    {
+        *rssi = mon->rssi;
+        ret = RIG_OK;
+    }
+
+    pthread_mutex_unlock(&mon->cache_lock);
+
+    return ret;
+}
+
+#else /* !HAVE_PTHREAD */
+
+static void uniden_monitor_lock(RIG *rig)
+{
+}
+
+static void uniden_monitor_unlock(RIG *rig)
+{
+}
+
+static int uniden_monitor_start(RIG *rig)
+{
+    rig_debug(RIG_DEBUG_WARN, "%s: built without threads, monitor ignored\n",
+              __func__);
     return RIG_OK;
-#else
-    return -RIG_ENIMPL;
+}
+
+static void uniden_monitor_stop(RIG *rig)
+{
+}
+
+static int uniden_monitor_cached(RIG *rig, struct uniden_status *st, int *rssi)
+{
+    return -RIG_ENAVAIL;
+}
+
 #endif
+
+
+int uniden_digital_init(RIG *rig)
+{
+    rig->state.priv = calloc(1, sizeof(struct uniden_digital_priv_data));
+
+    if (!rig->state.priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    return RIG_OK;
 }
 
+int uniden_digital_cleanup(RIG *rig)
+{
+    free(rig->state.priv);
+    rig->state.priv = NULL;
+
+    return RIG_OK;
+}
+
+int uniden_digital_open(RIG *rig)
+{
+    struct uniden_digital_priv_data *priv = rig->state.priv;
+
+    if (priv->monitor_ms > 0)
+    {
+        uniden_monitor_start(rig);  /* the getters still work without it */
+    }
+
+    return RIG_OK;
+}
+
+int uniden_digital_close(RIG *rig)
+{
+    uniden_monitor_stop(rig);
+
+    return RIG_OK;
+}
+
+int uniden_digital_set_conf(RIG *rig, token_t token, const char *val)
+{
+    struct uniden_digital_priv_data *priv = rig->state.priv;
+    char *end;
+    long value;
+
+    switch (token)
+    {
+    case TOK_MONITOR:
+        value = strtol(val, &end, 10);
+
+        if (end == val || value < 0 || value > 10000)
+        {
+            return -RIG_EINVAL;
+        }
+
+        priv->monitor_ms = (int)value;
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+int uniden_digital_get_conf2(RIG *rig, token_t token, char *val, int val_len)
+{
+    struct uniden_digital_priv_data *priv = rig->state.priv;
+
+    switch (token)
+    {
+    case TOK_MONITOR:
+        SNPRINTF(val, val_len, "%d", priv->monitor_ms);
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+/*
+ * uniden_digital_get_freq
+ * From the monitor when it knows, else from PWR
+ */
+int uniden_digital_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
+{
+    struct uniden_status st;
+    int rssi;
+
+    if (uniden_monitor_cached(rig, &st, NULL) == RIG_OK && st.freq != 0)
+    {
+        *freq = st.freq;
+        return RIG_OK;
+    }
+
+    return uniden_read_pwr(rig, &rssi, freq);
+}
+
+/*
+ * uniden_digital_get_dcd
+ * Squelch status of GLG
+ */
+int uniden_digital_get_dcd(RIG *rig, vfo_t vfo, dcd_t *dcd)
+{
+    struct uniden_status st;
+    int ret;
+
+    ret = uniden_monitor_cached(rig, &st, NULL);
+
+    if (ret != RIG_OK)
+    {
+        ret = uniden_read_glg(rig, &st);
+    }
+
+    if (ret == RIG_OK)
+    {
+        *dcd = st.dcd;
+    }
+
+    return ret;
+}
+
+/*
+ * uniden_digital_get_level
+ * RAWSTR is the RSSI of PWR
+ */
+int uniden_digital_get_level(RIG *rig, vfo_t vfo, setting_t level,
+                             value_t *val)
+{
+    freq_t freq;
+
+    if (level != RIG_LEVEL_RAWSTR)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: unsupported %s\n", __func__,
+                  rig_strlevel(level));
+        return -RIG_EINVAL;
+    }
+
+    if (uniden_monitor_cached(rig, NULL, &val->i) == RIG_OK)
+    {
+        return RIG_OK;
+    }
+
+    return uniden_read_pwr(rig, &val->i, &freq);
+}
@@ -26,13 +26,29 @@
 
 #define BACKEND_DIGITAL_VER	"20170808"
 
+struct uniden_digital_priv_data {
+	int monitor_ms;	/* monitor conf, fastest GLG poll period, 0 = off */
+	struct uniden_monitor *monitor;	/* running monitor, if any */
+};
+
+extern const struct confparams uniden_digital_cfg_params[];
+
 int uniden_digital_transaction (RIG *rig, const char *cmdstr, int cmd_len,
 		const char *replystr, char *data, size_t *datasize);
 
+int uniden_digital_init(RIG *rig);
+int uniden_digital_cleanup(RIG *rig);
+int uniden_digital_open(RIG *rig);
+int uniden_digital_close(RIG *rig);
+int uniden_digital_set_conf(RIG *rig, token_t token, const char *val);
+int uniden_digital_get_conf2(RIG *rig, token_t token, char *val, int val_len);
+
 const char* uniden_digital_get_info(RIG *rig);
 
 int uniden_digital_set_freq(RIG *rig, vfo_t vfo, freq_t freq);
 int uniden_digital_get_freq(RIG *rig, vfo_t vfo, freq_t *freq);
+int uniden_digital_get_dcd(RIG *rig, vfo_t vfo, dcd_t *dcd);
+int uniden_digital_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val);
 
 
 #endif /* _UNIDEN_DIGITAL_H */
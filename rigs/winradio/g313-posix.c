@@ -36,6 +36,8 @@
 
 #include "winradio.h"
 #include "linradio/wrg313api.h"
+#include "event.h"
+#include "spectrum_pool.h"
 
 
 #define G313_FUNC  RIG_FUNC_NONE
@@ -48,6 +50,11 @@
 
 #define FIFO_PATHNAME_SIZE 64
 
+/* the DSP spectrum covers the IF around the tuned frequency, in dB */
+#define G313_SPECTRUM_SPAN kHz(20)
+#define G313_SPECTRUM_DB_MIN (-140)
+#define G313_SPECTRUM_DB_MAX (-20)
+
 
 const struct confparams g313_cfg_params[] =
 {
@@ -83,6 +90,8 @@ struct g313_priv_data
     struct g313_fifo_data if_buf;
     struct g313_fifo_data audio_buf;
     struct g313_fifo_data spectrum_buf;
+    RIG *rig;
+    volatile freq_t freq;   /* centre of the spectrum, for the callback */
 };
 
 static void g313_audio_callback(short *buffer, int count, void *arg);
@@ -122,6 +131,7 @@ int g313_init(RIG *rig)
     }
 
     memset(priv, 0, sizeof(struct g313_priv_data));
+    priv->rig = rig;
 
     priv->hWRAPI = g313_init_api();
 
@@ -143,6 +153,7 @@ int g313_open(RIG *rig)
     struct g313_priv_data *priv = (struct g313_priv_data *)rig->state.priv;
     RADIO_DESC *List;
     int Count;
+    unsigned int f;
 
     void *audio_callback = g313_audio_callback;
     void *if_callback = g313_if_callback;
@@ -223,9 +234,10 @@ int g313_open(RIG *rig)
     rig_debug(RIG_DEBUG_VERBOSE, "%s: spectrum path %s fifo: %d\n", __func__,
               priv->spectrum_buf.path, priv->spectrum_buf.fd);
 
-    if (priv->spectrum_buf.fd == -1)
+    /* the spectrum also goes to rig_fire_spectrum_event(), fifo or not */
+    if (GetFrequency(priv->hRadio, &f) == 0)
     {
-        spectrum_callback = NULL;
+        priv->freq = f;
     }
 
     ret = StartStreaming(priv->hRadio, audio_callback, if_callback,
@@ -321,6 +333,11 @@ int g313_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
     ret = SetFrequency(priv->hRadio, (unsigned int)(freq));
     ret = ret == 0 ? RIG_OK : -RIG_EIO;
 
+    if (ret == RIG_OK)
+    {
+        priv->freq = freq;
+    }
+
     return ret;
 }
 
@@ -635,13 +652,72 @@ static void g313_if_callback(short *buffer, int count, void *arg)
 #pragma GCC diagnostic pop
 }
 
+/*
+ * Runs on the API's streaming thread: the levels are scaled straight into
+ * a pool line, which the spectrum consumers then hold by reference.  When
+ * they have every pool line tied up the buffer is dropped, the thread is
+ * never made to wait.
+ */
 static void  g313_spectrum_callback(float *buffer, int count, void *arg)
 {
+    struct g313_priv_data *priv = (struct g313_priv_data *)arg;
+    struct spectrum_pool_line *pl;
+    freq_t center = priv->freq;
+    int per, length, i;
+
+    if (priv->spectrum_buf.fd != -1)
+    {
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-result"
-    struct g313_priv_data *priv = (struct g313_priv_data *)arg;
-    write(priv->spectrum_buf.fd, buffer, count * sizeof(float));
+        write(priv->spectrum_buf.fd, buffer, count * sizeof(float));
 #pragma GCC diagnostic pop
+    }
+
+    if (count <= 0 || (pl = spectrum_pool_get()) == NULL)
+    {
+        return;
+    }
+
+    /* peak of each group of bins when there are more than a line holds */
+    per = (count + HAMLIB_MAX_SPECTRUM_DATA - 1) / HAMLIB_MAX_SPECTRUM_DATA;
+    length = (count + per - 1) / per;
+
+    for (i = 0; i < length; i++)
+    {
+        const float *bin = buffer + i * per;
+        int n = count - i * per < per ? count - i * per : per;
+        float db = bin[0];
+        float level;
+        int j;
+
+        for (j = 1; j < n; j++)
+        {
+            db = bin[j] > db ? bin[j] : db;
+        }
+
+        level = (db - G313_SPECTRUM_DB_MIN) * 255
+                / (G313_SPECTRUM_DB_MAX - G313_SPECTRUM_DB_MIN);
+        pl->data[i] = level < 0 ? 0 : level > 255 ? 255 : (unsigned char) level;
+    }
+
+    pl->line = (struct rig_spectrum_line)
+    {
+        .id = 0,
+        .data_level_min = 0,
+        .data_level_max = 255,
+        .signal_strength_min = G313_SPECTRUM_DB_MIN,
+        .signal_strength_max = G313_SPECTRUM_DB_MAX,
+        .spectrum_mode = RIG_SPECTRUM_MODE_CENTER,
+        .center_freq = center,
+        .span_freq = G313_SPECTRUM_SPAN,
+        .low_edge_freq = center - G313_SPECTRUM_SPAN / 2,
+        .high_edge_freq = center + G313_SPECTRUM_SPAN / 2,
+        .spectrum_data_length = length,
+        .spectrum_data = pl->data,
+    };
+
+    rig_fire_spectrum_event(priv->rig, &pl->line);
+    spectrum_pool_put(pl);
 }
 
 const struct rig_caps g313_caps =
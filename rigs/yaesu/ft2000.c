@@ -282,6 +282,7 @@ const struct rig_caps ft2000_caps =
     .set_func =           newcat_set_func,
     .get_level =          newcat_get_level,
     .set_level =          newcat_set_level,
+    .set_bulk =          newcat_set_bulk,
     .get_mem =            newcat_get_mem,
     .set_mem =            newcat_set_mem,
     .vfo_op =             newcat_vfo_op,
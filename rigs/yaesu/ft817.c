@@ -697,6 +697,101 @@ static int ft817_read_eeprom(RIG *rig, unsigned short addr, unsigned char *out)
     return RIG_OK;
 }
 
+/*
+ * Only in digimode we need fetch to extra bits from EEPROM.
+ * This save communication cycle for all other modes.
+ * Because mode and frequency are shared this saves also when
+ * getting the frequency.
+ */
+static int ft817_get_dig_mode(RIG *rig)
+{
+    struct ft817_priv_data *p = (struct ft817_priv_data *) rig->state.priv;
+    unsigned char dig_mode;
+    int n;
+
+    if ((p->fm_status[4] & 0x7f) != 0x0a)
+    {
+        return RIG_OK;
+    }
+
+    if ((n = ft817_read_eeprom(rig, 0x0065, &dig_mode)) < 0)
+    {
+        return n;
+    }
+
+    /* Top 3 bit define the digi mode */
+    p->dig_mode = dig_mode >> 5;
+
+    return RIG_OK;
+}
+
+/*
+ * Send status reads back to back, also for the FT-857 and FT-897.  The
+ * port is flushed once and each command goes out as soon as the answer to
+ * the previous one is in, the rig needs no other gap between them.  The
+ * whole burst is retried when one of the answers is lost.
+ */
+int ft817_read_status_burst(RIG *rig, const unsigned char *const cmd[],
+                            unsigned char *const data[], const int len[],
+                            int count)
+{
+    hamlib_port_t *rp = &rig->state.rigport;
+    int retries = rp->retry;
+    int i, n;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: called, %d reads\n", __func__, count);
+
+    do
+    {
+        rig_flush(rp);
+
+        for (i = 0, n = 0; i < count && n >= 0; i++)
+        {
+            write_block(rp, cmd[i], YAESU_CMD_LENGTH);
+            n = read_block(rp, data[i], len[i]);
+
+            if (n >= 0 && n != len[i])
+            {
+                rig_debug(RIG_DEBUG_VERBOSE, "%s: Length mismatch exp %d got %d!\n",
+                          __func__, len[i], n);
+                n = -RIG_EIO;
+            }
+        }
+    }
+    while (n < 0 && retries-- > 0);
+
+    return n < 0 ? n : RIG_OK;
+}
+
+static int ft817_get_status_burst(RIG *rig)
+{
+    struct ft817_priv_data *p = (struct ft817_priv_data *) rig->state.priv;
+    const unsigned char *const cmd[3] =
+    {
+        ncmd[FT817_NATIVE_CAT_GET_FREQ_MODE_STATUS].nseq,
+        ncmd[FT817_NATIVE_CAT_GET_RX_STATUS].nseq,
+        ncmd[FT817_NATIVE_CAT_GET_TX_STATUS].nseq
+    };
+    unsigned char *const data[3] = { p->fm_status, &p->rx_status, &p->tx_status };
+    const int len[3] = { 5, 1, 1 };
+    int n;
+
+    if ((n = ft817_read_status_burst(rig, cmd, data, len, 3)) < 0)
+    {
+        return n;
+    }
+
+    if ((n = ft817_get_dig_mode(rig)) < 0)
+    {
+        return n;
+    }
+
+    gettimeofday(&p->fm_status_tv, NULL);
+    p->rx_status_tv = p->tx_status_tv = p->fm_status_tv;
+
+    return RIG_OK;
+}
+
 static int ft817_get_status(RIG *rig, int status)
 {
     struct ft817_priv_data *p = (struct ft817_priv_data *) rig->state.priv;
@@ -766,29 +861,12 @@ static int ft817_get_status(RIG *rig, int status)
     switch (status)
     {
     case FT817_NATIVE_CAT_GET_FREQ_MODE_STATUS:
-    {
-        /* Only in digimode we need fetch to extra bits from EEPROM.
-         * This save communication cycle for all other modes.
-         * Because mode and frequency are shared this saves also when
-         * getting the frequency. */
-        switch (p->fm_status[4] & 0x7f)
+        if ((n = ft817_get_dig_mode(rig)) < 0)
         {
-            unsigned char dig_mode;
-
-        case 0x0a:
-            if ((n = ft817_read_eeprom(rig, 0x0065, &dig_mode)) < 0)
-            {
-                return n;
-            }
-
-            /* Top 3 bit define the digi mode */
-            p->dig_mode = dig_mode >> 5;
-
-        default:
-            break;
+            return n;
         }
-    }
-    break;
+
+        break;
 
     case FT817_NATIVE_CAT_GET_TX_METERING:
         /* FT-817 returns 2 bytes with 4 nibbles.
@@ -817,9 +895,6 @@ static int ft817_get_status(RIG *rig, int status)
 static int ft817_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
 {
     struct ft817_priv_data *p = (struct ft817_priv_data *) rig->state.priv;
-    freq_t f1 = 0, f2 = 0;
-    int retries = rig->state.rigport.retry +
-                  1; // +1 because, because 2 steps are needed even in best scenario
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s: called, vfo=%s, ptt=%d, split=%d\n", __func__,
               rig_strvfo(vfo), rig->state.cache.ptt, rig->state.cache.split);
@@ -831,39 +906,18 @@ static int ft817_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
         return RIG_OK;
     }
 
-    while ((f1 == 0 || f1 != f2) && retries-- > 0)
+    if (check_cache_timeout(&p->fm_status_tv))
     {
         int n;
-        rig_debug(RIG_DEBUG_TRACE, "%s: retries=%d\n", __func__, retries);
 
-        if ((n = ft817_get_status(rig, FT817_NATIVE_CAT_GET_FREQ_MODE_STATUS)) < 0)
+        if ((n = ft817_get_status_burst(rig)) < 0)
         {
             return n;
         }
-
-        f1 = f2;
-        f2 = from_bcd_be(p->fm_status, 8);
-        dump_hex(p->fm_status, sizeof(p->fm_status) / sizeof(p->fm_status[0]));
     }
 
-#if 1 // user must be twiddling the VFO
-    // usually get_freq is OK but we have to allow that f1 != f2 when knob is moving
-    *freq = f2 * 10;
+    *freq = from_bcd_be(p->fm_status, 8) * 10;
     return RIG_OK;
-#else // remove this if no complaints
-
-    if (retries >= 0)
-    {
-        *freq = f1 * 10;
-        return RIG_OK;
-    }
-    else
-    {
-        return -RIG_EIO;
-    }
-
-#endif
-
 }
 
 static int ft817_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
@@ -876,7 +930,7 @@ static int ft817_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
     {
         int n;
 
-        if ((n = ft817_get_status(rig, FT817_NATIVE_CAT_GET_FREQ_MODE_STATUS)) < 0)
+        if ((n = ft817_get_status_burst(rig)) < 0)
         {
             return n;
         }
@@ -1001,7 +1055,7 @@ static int ft817_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
     {
         int n;
 
-        if ((n = ft817_get_status(rig, FT817_NATIVE_CAT_GET_TX_STATUS)) < 0)
+        if ((n = ft817_get_status_burst(rig)) < 0)
         {
             return n;
         }
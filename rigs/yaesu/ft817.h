@@ -75,7 +75,17 @@
  */
 #define FT817_CACHE_TIMEOUT     50
 
+/*
+ * get_freq, get_mode and get_ptt read the freq/mode, RX and TX status in
+ * one burst (see ft817_read_status_burst()), the three answers share one
+ * timestamp so the rest of a polling cycle, S-meter included, is answered
+ * from it.
+ */
+
 int ft817_set_powerstat(RIG *rig, powerstat_t status);
 int ft817_read_ack(RIG *rig);
+int ft817_read_status_burst(RIG *rig, const unsigned char *const cmd[],
+                            unsigned char *const data[], const int len[],
+                            int count);
 
 #endif /* _FT817_H */
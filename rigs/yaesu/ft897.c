@@ -640,6 +640,57 @@ static int ft897_read_eeprom(RIG *rig, unsigned short addr, unsigned char *out)
     return RIG_OK;
 }
 
+/* the digi mode is in EEPROM, only needed when the mode is DIG */
+static int ft897_get_dig_mode(RIG *rig)
+{
+    struct ft897_priv_data *p = (struct ft897_priv_data *) rig->state.priv;
+    int n;
+
+    if ((p->fm_status[4] & 0x7f) != 0x0a)
+    {
+        return RIG_OK;
+    }
+
+    if ((n = ft897_read_eeprom(rig, 0x0078, &p->fm_status[5])) < 0)
+    {
+        return n;
+    }
+
+    p->fm_status[5] >>= 5;
+
+    return RIG_OK;
+}
+
+/* freq/mode, RX and TX status in one go -- see ft817_read_status_burst() */
+static int ft897_get_status_burst(RIG *rig)
+{
+    struct ft897_priv_data *p = (struct ft897_priv_data *) rig->state.priv;
+    const unsigned char *const cmd[3] =
+    {
+        ncmd[FT897_NATIVE_CAT_GET_FREQ_MODE_STATUS].nseq,
+        ncmd[FT897_NATIVE_CAT_GET_RX_STATUS].nseq,
+        ncmd[FT897_NATIVE_CAT_GET_TX_STATUS].nseq
+    };
+    unsigned char *const data[3] = { p->fm_status, &p->rx_status, &p->tx_status };
+    const int len[3] = { YAESU_CMD_LENGTH, 1, 1 };
+    int n;
+
+    if ((n = ft817_read_status_burst(rig, cmd, data, len, 3)) < 0)
+    {
+        return n;
+    }
+
+    if ((n = ft897_get_dig_mode(rig)) < 0)
+    {
+        return n;
+    }
+
+    gettimeofday(&p->fm_status_tv, NULL);
+    p->rx_status_tv = p->tx_status_tv = p->fm_status_tv;
+
+    return RIG_OK;
+}
+
 static int ft897_get_status(RIG *rig, int status)
 {
     struct ft897_priv_data *p = (struct ft897_priv_data *) rig->state.priv;
@@ -699,12 +750,10 @@ static int ft897_get_status(RIG *rig, int status)
 
     if (status == FT897_NATIVE_CAT_GET_FREQ_MODE_STATUS)
     {
-        if ((n = ft897_read_eeprom(rig, 0x0078, &p->fm_status[5])) < 0)
+        if ((n = ft897_get_dig_mode(rig)) < 0)
         {
             return n;
         }
-
-        p->fm_status[5] >>= 5;
     }
 
     gettimeofday(tv, NULL);
@@ -724,7 +773,7 @@ int ft897_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     {
         int n;
 
-        if ((n = ft897_get_status(rig, FT897_NATIVE_CAT_GET_FREQ_MODE_STATUS)) < 0)
+        if ((n = ft897_get_status_burst(rig)) < 0)
         {
             return n;
         }
@@ -745,7 +794,7 @@ int ft897_get_mode(RIG *rig, vfo_t vfo, rmode_t *mode, pbwidth_t *width)
     {
         int n;
 
-        if ((n = ft897_get_status(rig, FT897_NATIVE_CAT_GET_FREQ_MODE_STATUS)) < 0)
+        if ((n = ft897_get_status_burst(rig)) < 0)
         {
             return n;
         }
@@ -829,7 +878,7 @@ int ft897_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
     {
         int n;
 
-        if ((n = ft897_get_status(rig, FT897_NATIVE_CAT_GET_TX_STATUS)) < 0)
+        if ((n = ft897_get_status_burst(rig)) < 0)
         {
             return n;
         }
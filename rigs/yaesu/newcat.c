@@ -37,7 +37,12 @@
 #include "hamlib/rig.h"
 #include "iofunc.h"
 #include "misc.h"
+#include "cache.h"
 #include "cal.h"
+#include "stats.h"
+#include "event.h"
+#include "sprintflst.h"
+#include "rigfacts.h"
 #include "newcat.h"
 
 /* global variables */
@@ -367,11 +372,19 @@ int valid_commands_count = sizeof(valid_commands) / sizeof(
  */
 
 #define TOK_FAST_SET_CMD TOKEN_BACKEND(1)
+#define TOK_METER_STREAM TOKEN_BACKEND(2)
+#define TOK_METER_LEVELS TOKEN_BACKEND(3)
 
 const struct confparams newcat_cfg_params[] =
 {
     {
-        TOK_FAST_SET_CMD, "fast_commands_token", "High throughput of commands", "Enabled high throughput of >200 messages/sec by not waiting for ACK/NAK of messages", "0", RIG_CONF_NUMERIC, { .n = { 0, 1, 1 } }
+        TOK_FAST_SET_CMD, "fast_commands_token", "High throughput of commands", "Enabled high throughput of >200 messages/sec by not waiting for ACK/NAK of messages, 2 checks each set along with the next command and reports failures to the error callback", "0", RIG_CONF_NUMERIC, { .n = { 0, 2, 1 } }
+    },
+    {
+        TOK_METER_STREAM, "meter_stream", "Meter stream period", "Read the meter_levels meters round robin in the background, each once per this many ms, and answer get_level for them from the last reading. 0 disables", "0", RIG_CONF_NUMERIC, { .n = { 0, 10000, 1 } }
+    },
+    {
+        TOK_METER_LEVELS, "meter_levels", "Streamed meters", "Comma separated meter levels read by meter_stream", NEWCAT_METER_DEFAULT_LEVELS, RIG_CONF_STRING,
     },
     { RIG_CONF_END, NULL, }
 };
@@ -409,6 +422,7 @@ static int newcat_get_contour_level(RIG *rig, vfo_t vfo, int *level);
 static int newcat_set_contour_width(RIG *rig, vfo_t vfo, int width);
 static int newcat_get_contour_width(RIG *rig, vfo_t vfo, int *width);
 static ncboolean newcat_valid_command(RIG *rig, char const *const command);
+static void newcat_valid_command_init(RIG *rig);
 
 /*
  * The BS command needs to know what band we're on so we can restore band info
@@ -479,7 +493,19 @@ int newcat_init(RIG *rig)
 
     priv->rig_id = NC_RIGID_NONE;
     priv->current_mem = NC_MEM_CHANNEL_NONE;
+
+    // meters without a table of their own in the caps
+    rig_cal_default(rig, RIG_LEVEL_SWR, &yaesu_default_swr_cal);
+    rig_cal_default(rig, RIG_LEVEL_ALC, &yaesu_default_alc_cal);
+    rig_cal_default(rig, RIG_LEVEL_RFPOWER_METER, &yaesu_default_rfpower_meter_cal);
+    rig_cal_default(rig, RIG_LEVEL_COMP_METER, &yaesu_default_comp_meter_cal);
+    rig_cal_default(rig, RIG_LEVEL_VD_METER, &yaesu_default_vd_meter_cal);
+    rig_cal_default(rig, RIG_LEVEL_ID_METER, &yaesu_default_id_meter_cal);
     priv->fast_set_commands = FALSE;
+    newcat_meter_parse_levels(NEWCAT_METER_DEFAULT_LEVELS,
+                              &priv->meter_stream_levels);
+
+    newcat_valid_command_init(rig);
 
     RETURNFUNC(RIG_OK);
 }
@@ -499,6 +525,7 @@ int newcat_cleanup(RIG *rig)
 
     if (rig->state.priv)
     {
+        newcat_meter_stream_stop(rig);
         free(rig->state.priv);
     }
 
@@ -549,7 +576,21 @@ int newcat_open(RIG *rig)
     // for this sequence we will shorten the timeout so we can detect rig is powered off faster
     int timeout = rig->state.rigport.timeout;
     rig->state.rigport.timeout = 100;
-    newcat_get_trn(rig, &priv->trn_state);  /* ignore errors */
+
+    /* replay what an earlier open found; anything answering AI is taken
+       to be the same rig, otherwise ask again */
+    if (priv->rig_id == NC_RIGID_NONE
+            && rig_facts_get_int(rig, "rig_id", &priv->rig_id))
+    {
+        rig_facts_get_int(rig, "width_frequency", &priv->width_frequency);
+    }
+
+    if (newcat_get_trn(rig, &priv->trn_state) == -RIG_ETIMEOUT)
+    {
+        rig_facts_clear(rig);
+        priv->rig_id = NC_RIGID_NONE;
+        priv->width_frequency = 0;
+    }
 
     /* Currently we cannot cope with AI mode so turn it off in case
        last client left it on */
@@ -561,6 +602,11 @@ int newcat_open(RIG *rig)
     /* Initialize rig_id in case any subsequent commands need it */
     (void)newcat_get_rigid(rig);
     rig_debug(RIG_DEBUG_VERBOSE, "%s: rig_id=%d\n", __func__, priv->rig_id);
+
+    if (priv->rig_id != NC_RIGID_NONE)
+    {
+        rig_facts_set_int(rig, "rig_id", priv->rig_id);
+    }
     rig->state.rigport.timeout = timeout;
 
 #if 0 // possible future enhancement?
@@ -596,6 +642,11 @@ int newcat_open(RIG *rig)
         rig_debug(RIG_DEBUG_VERBOSE, "%s: disabling FTDX3000 band select\n", __func__);
     }
 
+    if (priv->meter_stream_ms > 0)
+    {
+        newcat_meter_stream_start(rig);  /* get_level still works without it */
+    }
+
     RETURNFUNC(RIG_OK);
 }
 
@@ -613,6 +664,15 @@ int newcat_close(RIG *rig)
 
     ENTERFUNC;
 
+    newcat_meter_stream_stop(rig);
+    newcat_verify_deferred(rig);
+
+    /* only known once a set_freq went through, kept for the next open */
+    if (priv->width_frequency > 0)
+    {
+        rig_facts_set_int(rig, "width_frequency", priv->width_frequency);
+    }
+
     if (!no_restore_ai && priv->trn_state >= 0)
     {
         /* restore AI state */
@@ -665,7 +725,7 @@ int newcat_set_conf(RIG *rig, token_t token, const char *val)
             RETURNFUNC(-RIG_EINVAL);
         }
 
-        if ((value == 0) || (value == 1))
+        if ((value == 0) || (value == 1) || (value == NEWCAT_FAST_SET_DEFERRED))
         {
             priv->fast_set_commands = (int)value;
         }
@@ -676,6 +736,21 @@ int newcat_set_conf(RIG *rig, token_t token, const char *val)
 
         break;
 
+    case TOK_METER_STREAM:
+        value = strtol(val, &end, 10);
+
+        if (end == val || value < 0 || value > 10000)
+        {
+            RETURNFUNC(-RIG_EINVAL);
+        }
+
+        priv->meter_stream_ms = (int)value;
+        break;
+
+    case TOK_METER_LEVELS:
+        ret = newcat_meter_parse_levels(val, &priv->meter_stream_levels);
+        break;
+
     default:
         ret = -RIG_EINVAL;
     }
@@ -715,6 +790,14 @@ int newcat_get_conf2(RIG *rig, token_t token, char *val, int val_len)
         SNPRINTF(val, val_len, "%d", priv->fast_set_commands);
         break;
 
+    case TOK_METER_STREAM:
+        SNPRINTF(val, val_len, "%d", priv->meter_stream_ms);
+        break;
+
+    case TOK_METER_LEVELS:
+        rig_sprintf_level(val, val_len, priv->meter_stream_levels);
+        break;
+
     default:
         ret = -RIG_EINVAL;
     }
@@ -4502,6 +4585,128 @@ int newcat_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
 }
 
 
+/*
+ * The RM meter query for level, shared by newcat_get_level() and the meter
+ * stream.  Not for the FTDX3000/5000 SWR, which depends on the tuner.
+ */
+int newcat_meter_cmd(RIG *rig, setting_t level, char *cmd, size_t cmd_len)
+{
+    const char *rm;
+
+    if (!newcat_valid_command(rig, "RM"))
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    switch (level)
+    {
+    case RIG_LEVEL_SWR:
+        if (is_ftdx3000 || is_ftdx3000dm || is_ftdx5000)
+        {
+            return -RIG_ENAVAIL;
+        }
+
+        rm = is_ftdx9000 ? "09" : "6";
+        break;
+
+    case RIG_LEVEL_ALC:
+        rm = is_ftdx9000 ? "07" : "4";
+        break;
+
+    case RIG_LEVEL_RFPOWER_METER:
+    case RIG_LEVEL_RFPOWER_METER_WATTS:
+        rm = is_ftdx9000 ? "08" : "5";
+        break;
+
+    case RIG_LEVEL_COMP_METER:
+        rm = is_ftdx9000 ? "06" : "3";
+        break;
+
+    case RIG_LEVEL_VD_METER:
+        rm = is_ftdx9000 ? "11" : "8";
+        break;
+
+    case RIG_LEVEL_ID_METER:
+        rm = is_ftdx9000 ? "10" : "7";
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    SNPRINTF(cmd, cmd_len, "RM%s%c", rm, cat_term);
+
+    return RIG_OK;
+}
+
+/* Raw meter reading of an RM answer, the command already skipped */
+int newcat_meter_raw(const char *retlvl)
+{
+    char digits[4];
+
+    // Some rigs like FTDX101 have 6-byte return so we just truncate
+    SNPRINTF(digits, sizeof(digits), "%.3s", retlvl);
+
+    return atoi(digits);
+}
+
+/* Calibrated value of a raw RM reading, see newcat_meter_cmd() */
+float newcat_meter_raw2val(RIG *rig, setting_t level, int raw)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    const struct rig_caps *caps = rig->caps;
+    float f;
+
+    switch (level)
+    {
+    case RIG_LEVEL_SWR:
+        return rig_cal_value(rig, level, raw, &yaesu_default_swr_cal);
+
+    case RIG_LEVEL_ALC:
+        return rig_cal_value(rig, level, raw, &yaesu_default_alc_cal);
+
+    case RIG_LEVEL_RFPOWER_METER:
+    case RIG_LEVEL_RFPOWER_METER_WATTS:
+        f = rig_cal_value(rig, level, raw, &yaesu_default_rfpower_meter_cal);
+
+        if (caps->rfpower_meter_cal.size != 0 && priv->rig_id == NC_RIGID_FT2000)
+        {
+            // we reuse the FT2000D table for the FT2000 so need to divide by 2
+            // hopefully this works well otherwise we need a separate table
+            f /= 2;
+        }
+
+        if (level == RIG_LEVEL_RFPOWER_METER)
+        {
+            f /= 100.0;
+        }
+
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: RFPOWER_METER=%d, converted to %f\n",
+                  __func__, raw, f);
+
+        if (level == RIG_LEVEL_RFPOWER_METER && f > 1.0)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: val->f(%f) clipped at 1.0\n", __func__, f);
+            f = 1.0;
+        }
+
+        return f;
+
+    case RIG_LEVEL_COMP_METER:
+        return rig_cal_value(rig, level, raw, &yaesu_default_comp_meter_cal);
+
+    case RIG_LEVEL_VD_METER:
+        return rig_cal_value(rig, level, raw, &yaesu_default_vd_meter_cal);
+
+    case RIG_LEVEL_ID_METER:
+        return rig_cal_value(rig, level, raw, &yaesu_default_id_meter_cal);
+
+    default:
+        return 0;
+    }
+}
+
+
 int newcat_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
 {
     struct rig_state *state = &rig->state;
@@ -4509,13 +4714,18 @@ int newcat_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
     int err;
     int ret_data_len;
     char *retlvl;
-    int retlvl_len;
     float scale;
     char main_sub_vfo = '0';
     int i;
 
     ENTERFUNC;
 
+    /* a meter the stream read recently, no I/O */
+    if (newcat_meter_cached(rig, level, val) == RIG_OK)
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
     /* Set Main or SUB vfo */
     err = newcat_set_vfo_from_alias(rig, &vfo);
 
@@ -4788,11 +4998,7 @@ int newcat_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
             RETURNFUNC(-RIG_ENAVAIL);
         }
 
-        if (is_ftdx9000)
-        {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM09%c", cat_term);
-        }
-        else if (is_ftdx3000 || is_ftdx3000dm || is_ftdx5000)
+        if (is_ftdx3000 || is_ftdx3000dm || is_ftdx5000)
         {
             // The 3000 has to use the meter read for SWR when the tuner is on
             // We'll assume the 5000 is the same way for now
@@ -4811,95 +5017,24 @@ int newcat_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
                      && meter.i == RIG_METER_SWR) ? '2' : '6',
                      cat_term);
         }
-        else
+        else if (RIG_OK != (err = newcat_meter_cmd(rig, level, priv->cmd_str,
+                                  sizeof(priv->cmd_str))))
         {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM6%c", cat_term);
+            RETURNFUNC(err);
         }
 
         break;
 
     case RIG_LEVEL_ALC:
-        if (!newcat_valid_command(rig, "RM"))
-        {
-            RETURNFUNC(-RIG_ENAVAIL);
-        }
-
-        if (is_ftdx9000)
-        {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM07%c", cat_term);
-        }
-        else
-        {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM4%c", cat_term);
-        }
-
-        break;
-
     case RIG_LEVEL_RFPOWER_METER:
     case RIG_LEVEL_RFPOWER_METER_WATTS:
-        if (!newcat_valid_command(rig, "RM"))
-        {
-            RETURNFUNC(-RIG_ENAVAIL);
-        }
-
-        if (is_ftdx9000)
-        {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM08%c", cat_term);
-        }
-        else
-        {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM5%c", cat_term);
-        }
-
-        break;
-
     case RIG_LEVEL_COMP_METER:
-        if (!newcat_valid_command(rig, "RM"))
-        {
-            RETURNFUNC(-RIG_ENAVAIL);
-        }
-
-        if (is_ftdx9000)
-        {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM06%c", cat_term);
-        }
-        else
-        {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM3%c", cat_term);
-        }
-
-        break;
-
     case RIG_LEVEL_VD_METER:
-        if (!newcat_valid_command(rig, "RM"))
-        {
-            RETURNFUNC(-RIG_ENAVAIL);
-        }
-
-        if (is_ftdx9000)
-        {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM11%c", cat_term);
-        }
-        else
-        {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM8%c", cat_term);
-        }
-
-        break;
-
     case RIG_LEVEL_ID_METER:
-        if (!newcat_valid_command(rig, "RM"))
-        {
-            RETURNFUNC(-RIG_ENAVAIL);
-        }
-
-        if (is_ftdx9000)
+        if (RIG_OK != (err = newcat_meter_cmd(rig, level, priv->cmd_str,
+                                  sizeof(priv->cmd_str))))
         {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM10%c", cat_term);
-        }
-        else
-        {
-            SNPRINTF(priv->cmd_str, sizeof(priv->cmd_str), "RM7%c", cat_term);
+            RETURNFUNC(err);
         }
 
         break;
@@ -5015,7 +5150,6 @@ int newcat_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
 
     /* skip command */
     retlvl = priv->ret_data + strlen(priv->cmd_str) - 1;
-    retlvl_len = strlen(retlvl);
     rig_debug(RIG_DEBUG_TRACE, "%s: retlvl='%s'\n", __func__, retlvl);
     /* chop term */
     priv->ret_data[ret_data_len - 1] = '\0';
@@ -5060,201 +5194,76 @@ int newcat_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
         break;
 
     case RIG_LEVEL_SWR:
-        if (retlvl_len > 3)
-        {
-            // Some rigs like FTDX101 have 6-byte return so we just truncate
-            retlvl[3] = 0;
-        }
+    case RIG_LEVEL_ALC:
+    case RIG_LEVEL_RFPOWER_METER:
+    case RIG_LEVEL_RFPOWER_METER_WATTS:
+    case RIG_LEVEL_COMP_METER:
+    case RIG_LEVEL_VD_METER:
+    case RIG_LEVEL_ID_METER:
+        val->f = newcat_meter_raw2val(rig, level, newcat_meter_raw(retlvl));
+        break;
 
-        if (rig->caps->swr_cal.size == 0)
+    case RIG_LEVEL_MICGAIN:
+        if (is_ftdx1200 || is_ftdx3000 || is_ftdx3000dm || is_ft891 || is_ft991
+                || is_ftdx101d
+                || is_ftdx101mp
+                || is_ftdx10)
         {
-            val->f = rig_raw2val_float(atoi(retlvl), &yaesu_default_swr_cal);
+            scale = 100.;
         }
         else
         {
-            val->f = rig_raw2val_float(atoi(retlvl), &rig->caps->swr_cal);
+            scale = 255.;
         }
 
+        val->f = (float)atoi(retlvl) / scale;
         break;
 
-    case RIG_LEVEL_ALC:
-        if (retlvl_len > 3)
-        {
-            // Some rigs like FTDX101 have 6-byte return so we just truncate
-            retlvl[3] = 0;
-        }
+    case RIG_LEVEL_AF:
+        val->f = (float)atoi(retlvl) / 255;
+        break;
 
-        if (rig->caps->alc_cal.size == 0)
+    case RIG_LEVEL_RF:
+        if (is_ft891)
         {
-            val->f = rig_raw2val_float(atoi(retlvl), &yaesu_default_alc_cal);
+            scale = 30.;
         }
         else
         {
-            val->f = rig_raw2val_float(atoi(retlvl), &rig->caps->alc_cal);
+            scale = 255.;
         }
 
+        val->f = (float)atoi(retlvl) / scale;
         break;
 
-    case RIG_LEVEL_RFPOWER_METER:
-    case RIG_LEVEL_RFPOWER_METER_WATTS:
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: RFPOWER_METER retlvl=%s\n", __func__, retlvl);
-
-        if (retlvl_len > 3)
-        {
-            // Some rigs like FTDX101 have 6-byte return so we just truncate
-            rig_debug(RIG_DEBUG_VERBOSE, "%s: retlvl of %s getting truncated\n", __func__,
-                      retlvl);
-            retlvl[3] = 0;
-            rig_debug(RIG_DEBUG_VERBOSE, "%s: retlvl truncated to %s\n", __func__, retlvl);
-        }
-
-        if (rig->caps->rfpower_meter_cal.size == 0)
+    case RIG_LEVEL_SQL:
+        if (is_ft891 || is_ft991 || is_ftdx101d || is_ftdx101mp || is_ftdx10)
         {
-            val->f = rig_raw2val_float(atoi(retlvl),
-                                       &yaesu_default_rfpower_meter_cal) / (level == RIG_LEVEL_RFPOWER_METER_WATTS ?
-                                               1.0 : 100.0);
+            scale = 100.;
         }
         else
         {
-            val->f = rig_raw2val_float(atoi(retlvl),
-                                       &rig->caps->rfpower_meter_cal) / (level == RIG_LEVEL_RFPOWER_METER_WATTS ? 1.0 :
-                                               100.0);
-
-            if (priv->rig_id == NC_RIGID_FT2000)
-            {
-                // we reuse the FT2000D table for the FT2000 so need to divide by 2
-                // hopefully this works well otherwise we need a separate table
-                val->f /= 2;
-            }
-        }
-
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: RFPOWER_METER=%s, converted to %f\n",
-                  __func__, retlvl, val->f);
-
-        if (level == RIG_LEVEL_RFPOWER_METER && val->f > 1.0)
-        {
-            rig_debug(RIG_DEBUG_VERBOSE, "%s: val->f(%f) clipped at 1.0\n", __func__,
-                      val->f);
-            val->f = 1.0;
+            scale = 255.;
         }
 
+        val->f = (float)atoi(retlvl) / scale;
         break;
 
-    case RIG_LEVEL_COMP_METER:
-        if (retlvl_len > 3)
-        {
-            // Some rigs like FTDX101 have 6-byte return so we just truncate
-            retlvl[3] = 0;
-        }
+    case RIG_LEVEL_BKINDL:
+    {
+        int raw_value = atoi(retlvl);
+        int millis;
+        value_t keyspd;
 
-        if (rig->caps->comp_meter_cal.size == 0)
-        {
-            val->f = rig_raw2val_float(atoi(retlvl), &yaesu_default_comp_meter_cal);
-        }
-        else
+        if (is_ftdx101d || is_ftdx101mp || is_ftdx10)
         {
-            val->f = rig_raw2val_float(atoi(retlvl), &rig->caps->comp_meter_cal);
-        }
+            switch (raw_value)
+            {
+            case 0: millis = 30; break;
 
-        break;
+            case 1: millis = 50; break;
 
-    case RIG_LEVEL_VD_METER:
-        if (retlvl_len > 3)
-        {
-            // Some rigs like FTDX101 have 6-byte return so we just truncate
-            retlvl[3] = 0;
-        }
-
-        if (rig->caps->vd_meter_cal.size == 0)
-        {
-            val->f = rig_raw2val_float(atoi(retlvl), &yaesu_default_vd_meter_cal);
-        }
-        else
-        {
-            val->f = rig_raw2val_float(atoi(retlvl), &rig->caps->vd_meter_cal);
-        }
-
-        break;
-
-    case RIG_LEVEL_ID_METER:
-        if (retlvl_len > 3)
-        {
-            // Some rigs like FTDX101 have 6-byte return so we just truncate
-            retlvl[3] = 0;
-        }
-
-        if (rig->caps->id_meter_cal.size == 0)
-        {
-            val->f = rig_raw2val_float(atoi(retlvl), &yaesu_default_id_meter_cal);
-        }
-        else
-        {
-            val->f = rig_raw2val_float(atoi(retlvl), &rig->caps->id_meter_cal);
-        }
-
-        break;
-
-    case RIG_LEVEL_MICGAIN:
-        if (is_ftdx1200 || is_ftdx3000 || is_ftdx3000dm || is_ft891 || is_ft991
-                || is_ftdx101d
-                || is_ftdx101mp
-                || is_ftdx10)
-        {
-            scale = 100.;
-        }
-        else
-        {
-            scale = 255.;
-        }
-
-        val->f = (float)atoi(retlvl) / scale;
-        break;
-
-    case RIG_LEVEL_AF:
-        val->f = (float)atoi(retlvl) / 255;
-        break;
-
-    case RIG_LEVEL_RF:
-        if (is_ft891)
-        {
-            scale = 30.;
-        }
-        else
-        {
-            scale = 255.;
-        }
-
-        val->f = (float)atoi(retlvl) / scale;
-        break;
-
-    case RIG_LEVEL_SQL:
-        if (is_ft891 || is_ft991 || is_ftdx101d || is_ftdx101mp || is_ftdx10)
-        {
-            scale = 100.;
-        }
-        else
-        {
-            scale = 255.;
-        }
-
-        val->f = (float)atoi(retlvl) / scale;
-        break;
-
-    case RIG_LEVEL_BKINDL:
-    {
-        int raw_value = atoi(retlvl);
-        int millis;
-        value_t keyspd;
-
-        if (is_ftdx101d || is_ftdx101mp || is_ftdx10)
-        {
-            switch (raw_value)
-            {
-            case 0: millis = 30; break;
-
-            case 1: millis = 50; break;
-
-            case 2: millis = 100; break;
+            case 2: millis = 100; break;
 
             case 3: millis = 150; break;
 
@@ -7220,6 +7229,103 @@ const char *newcat_get_info(RIG *rig)
 }
 
 
+/*
+ * Is the valid_commands[] entry supported by this rig model?
+ */
+static ncboolean newcat_command_supported(const yaesu_newcat_commands_t *cmd,
+        rig_model_t model)
+{
+    switch (model)
+    {
+    case RIG_MODEL_FT450: return cmd->ft450;
+
+    case RIG_MODEL_FT891: return cmd->ft891;
+
+    case RIG_MODEL_FT950: return cmd->ft950;
+
+    case RIG_MODEL_FT991: return cmd->ft991;
+
+    case RIG_MODEL_FT2000: return cmd->ft2000;
+
+    case RIG_MODEL_FT9000: return cmd->ft9000;
+
+    case RIG_MODEL_FTDX5000: return cmd->ft5000;
+
+    case RIG_MODEL_FTDX1200: return cmd->ft1200;
+
+    case RIG_MODEL_FTDX3000: return cmd->ft3000;
+
+    case RIG_MODEL_FTDX101D: return cmd->ft101d;
+
+    case RIG_MODEL_FTDX101MP: return cmd->ft101mp;
+
+    case RIG_MODEL_FTDX10: return cmd->ft10;
+
+    default: return FALSE;
+    }
+}
+
+/* bit index of a two upper case letter command, -1 for anything else */
+static int newcat_cmd_index(char const *const command)
+{
+    if (command[0] < 'A' || command[0] > 'Z'
+            || command[1] < 'A' || command[1] > 'Z' || command[2] != '\0')
+    {
+        return -1;
+    }
+
+    return (command[0] - 'A') * 26 + (command[1] - 'A');
+}
+
+/*
+ * newcat_valid_command_init
+ *
+ * Fill priv->valid_cmd_map with the commands valid_commands[] lists for
+ * this model so newcat_valid_command() is a single bit test.
+ */
+static void newcat_valid_command_init(RIG *rig)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    rig_model_t model = rig->caps->rig_model;
+    int i;
+
+    memset(priv->valid_cmd_map, 0, sizeof(priv->valid_cmd_map));
+    priv->valid_cmd_map_ready = FALSE;
+
+    switch (model)
+    {
+    case RIG_MODEL_FT450:
+    case RIG_MODEL_FT891:
+    case RIG_MODEL_FT950:
+    case RIG_MODEL_FT991:
+    case RIG_MODEL_FT2000:
+    case RIG_MODEL_FT9000:
+    case RIG_MODEL_FTDX5000:
+    case RIG_MODEL_FTDX1200:
+    case RIG_MODEL_FTDX3000:
+    case RIG_MODEL_FTDX101D:
+    case RIG_MODEL_FTDX101MP:
+    case RIG_MODEL_FTDX10:
+        break;
+
+    default:
+        return;
+    }
+
+    for (i = 0; i < valid_commands_count; i++)
+    {
+        int idx = newcat_cmd_index(valid_commands[i].command);
+
+        if (idx >= 0 && newcat_command_supported(&valid_commands[i], model))
+        {
+            priv->valid_cmd_map[idx >> 3] |= 1 << (idx & 7);
+        }
+    }
+
+    priv->valid_cmd_map_ready = TRUE;
+}
+
+
 /*
  * newcat_valid_command
  *
@@ -7232,8 +7338,10 @@ const char *newcat_get_info(RIG *rig)
 ncboolean newcat_valid_command(RIG *rig, char const *const command)
 {
     const struct rig_caps *caps;
+    const struct newcat_priv_data *priv;
     int search_high;
     int search_low;
+    int idx;
 
     rig_debug(RIG_DEBUG_TRACE, "%s %s\n", __func__, command);
 
@@ -7273,13 +7381,32 @@ ncboolean newcat_valid_command(RIG *rig, char const *const command)
         RETURNFUNC2(FALSE);
     }
 
+    priv = (struct newcat_priv_data *)rig->state.priv;
+    idx = newcat_cmd_index(command);
+
+    if (priv && priv->valid_cmd_map_ready && idx >= 0)
+    {
+        if (priv->valid_cmd_map[idx >> 3] & (1 << (idx & 7)))
+        {
+            RETURNFUNC2(TRUE);
+        }
+
+        /* an FT-DX3000DM may be driving another model's backend */
+        if (!is_ftdx3000dm)
+        {
+            rig_debug(RIG_DEBUG_TRACE, "%s: '%s' command '%s' not supported\n",
+                      __func__, caps->model_name, command);
+            RETURNFUNC2(FALSE);
+        }
+    }
+
     /*
      * Make sure the command is known, and then check to make sure
      * is it valid for the rig.
      */
 
     search_low = 0;
-    search_high = valid_commands_count;
+    search_high = valid_commands_count - 1;
 
     while (search_low <= search_high)
     {
@@ -10123,16 +10250,192 @@ int newcat_vfomem_toggle(RIG *rig)
  * "?;" busy please wait response; the command is not resent but up to
  * 'retry' retries to receive a valid response are made.
  */
-int newcat_get_cmd(RIG *rig)
+/*
+ * newcat_parse_reply
+ *  Checks the reply to a get command: RIG_OK, or the error the reply
+ *  stands for.  Works on the two strings alone, so recorded replies can be
+ *  run through it without a rig.
+ */
+int newcat_parse_reply(const char *cmd, const char *reply)
+{
+    size_t len = strlen(reply);
+
+    /* Check that command termination is correct - alternative is
+       response is longer than the buffer */
+    if (len == 0 || cat_term != reply[len - 1])
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: Command is not correctly terminated '%s'\n",
+                  __func__, reply);
+        return -RIG_EPROTO;
+    }
+
+    /* check for error codes */
+    if (2 == len)
+    {
+        /* The following error responses  are documented for Kenwood
+           but not for  Yaesu, but at least one of  them is known to
+           occur  in that  the  FT-450 certainly  responds to  "IF;"
+           occasionally with  "?;". The others are  harmless even of
+           they do not occur as they are unambiguous. */
+        switch (reply[0])
+        {
+        case 'N':
+            /* Command recognized by rig but invalid data entered. */
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: NegAck for '%s'\n", __func__, cmd);
+            return -RIG_ENAVAIL;
+
+        case 'O':
+            /* Too many characters sent without a carriage return */
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: Overflow for '%s'\n", __func__, cmd);
+            return -RIG_EPROTO;
+
+        case 'E':
+            /* Communication error */
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: Communication error for '%s'\n", __func__,
+                      cmd);
+            return -RIG_EIO;
+
+        case '?':
+            return -RIG_ERJCTED;
+        }
+
+        return RIG_OK;
+    }
+
+    /* verify that reply was to the command we sent */
+    if (reply[0] != cmd[0] || reply[1] != cmd[1])
+    {
+        /*
+         * TODO: When RIG_TRN is enabled, we can pass the string
+         * to the decoder for callback. That way we don't ignore
+         * any commands.
+         */
+        rig_debug(RIG_DEBUG_ERR, "%s: wrong reply %.2s for command %.2s\n",
+                  __func__, reply, cmd);
+        // we were using BUSBUSY but microham devices need retries
+        // this should be OK under all other circumstances too
+        return -RIG_EPROTO;
+    }
+
+    return RIG_OK;
+}
+
+/*
+ * Send the set commands held back during newcat_set_bulk() in one write,
+ * the verify query behind them, and read the answers up to its reply.
+ * A refusal cannot be pinned on one of the commands, it is left in
+ * bulk_err for newcat_set_bulk() to sort out.
+ */
+static int newcat_bulk_flush(RIG *rig)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    hamlib_port_t *rp = &rig->state.rigport;
+    char const *const verify_cmd = RIG_MODEL_FT9000 == rig->caps->rig_model ?
+                                   "AI;" : "ID;";
+    char reply[NEWCAT_DATA_LEN];
+    int rc, tries;
+
+    if (priv->bulk_len == 0)
+    {
+        return RIG_OK;
+    }
+
+    priv->bulk_flushes++;
+    memcpy(priv->bulk + priv->bulk_len, verify_cmd, strlen(verify_cmd));
+    priv->bulk_len += strlen(verify_cmd);
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: cmd_str = %.*s\n", __func__, priv->bulk_len,
+              priv->bulk);
+
+    rig_flush(rp);
+    rc = write_block(rp, (unsigned char *) priv->bulk, priv->bulk_len);
+    priv->bulk_len = 0;
+
+    // besides our answers there may be AI reports, up to a point
+    for (tries = 0; rc == RIG_OK && tries < 32; tries++)
+    {
+        rc = read_string(rp, (unsigned char *) reply, sizeof(reply), &cat_term,
+                         sizeof(cat_term), 0, 1);
+
+        if (rc < 0)
+        {
+            break;
+        }
+
+        rc = RIG_OK;
+
+        if (strlen(reply) == 2)
+        {
+            switch (reply[0])
+            {
+            case 'N': rc = -RIG_ENAVAIL; break;
+
+            case '?': rc = -RIG_ERJCTED; break;
+
+            case 'O':
+            case 'E': rc = -RIG_EIO; break;
+            }
+
+            if (rc != RIG_OK)
+            {
+                rig_debug(RIG_DEBUG_VERBOSE, "%s: %s answered\n", __func__, reply);
+
+                if (priv->bulk_err == RIG_OK) { priv->bulk_err = rc; }
+
+                rc = RIG_OK;
+                continue;
+            }
+        }
+
+        if (strncmp(reply, verify_cmd, 2) == 0)
+        {
+            break;
+        }
+    }
+
+    if (rc != RIG_OK && priv->bulk_err == RIG_OK)
+    {
+        priv->bulk_err = rc;
+    }
+
+    return rc;
+}
+
+/* newcat_set_cmd() during newcat_set_bulk(): hold cmd_str back */
+static int newcat_bulk_hold(RIG *rig)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    size_t len = strlen(priv->cmd_str);
+
+    // room for the verify query too
+    if (priv->bulk_len + len + 4 > NEWCAT_BULK_LEN)
+    {
+        newcat_bulk_flush(rig);
+    }
+
+    memcpy(priv->bulk + priv->bulk_len, priv->cmd_str, len);
+    priv->bulk_len += len;
+
+    return RIG_OK;
+}
+
+static int newcat_get_cmd_unlocked(RIG *rig)
 {
     struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
     int retry_count = 0;
     int rc = -RIG_EPROTO;
     int is_read_cmd = 0;
+    struct timespec stats_start;
 
     ENTERFUNC;
 
+    // the sets held back by newcat_set_bulk() go first
+    if (priv->bulk)
+    {
+        newcat_bulk_flush(rig);
+    }
+
     // try to cache rapid repeats of the IF command
     // this is for WSJT-X/JTDX sequence of v/f/m/t
     // should allow rapid repeat of any call using the IF; cmd
@@ -10215,9 +10518,19 @@ int newcat_get_cmd(RIG *rig)
         priv->cache_start.tv_sec = 0;
     }
 
+    rig_stats_begin(rig, &stats_start);
+
+    newcat_verify_deferred(rig);
 
     while (rc != RIG_OK && retry_count++ <= state->rigport.retry)
     {
+        // no retry once the caller's deadline has passed, see rig_set_deadline()
+        if (retry_count > 1 && rig_get_deadline() == 0)
+        {
+            rc = -RIG_ETIMEOUT;
+            break;
+        }
+
         rig_flush(&state->rigport);  /* discard any unsolicited data */
 
         if (rc != -RIG_BUSBUSY)
@@ -10229,6 +10542,7 @@ int newcat_get_cmd(RIG *rig)
                                             (unsigned char *) priv->cmd_str,
                                             strlen(priv->cmd_str))))
             {
+                rig_stats_end(rig, &stats_start, rc, retry_count - 1);
                 RETURNFUNC(rc);
             }
         }
@@ -10243,105 +10557,49 @@ int newcat_get_cmd(RIG *rig)
 
         rig_debug(RIG_DEBUG_TRACE, "%s: read count = %d, ret_data = %s\n",
                   __func__, rc, priv->ret_data);
-        rc = RIG_OK;              /* received something */
 
-        /* Check that command termination is correct - alternative is
-           response is longer than the buffer */
-        if (cat_term  != priv->ret_data[strlen(priv->ret_data) - 1])
-        {
-            rig_debug(RIG_DEBUG_ERR, "%s: Command is not correctly terminated '%s'\n",
-                      __func__, priv->ret_data);
-            rc = -RIG_EPROTO; /* retry */
-            /* we could decrement retry_count
-               here but there is a danger of
-               infinite looping so we just use up
-               a retry for safety's sake */
-            continue;
-        }
+        rc = newcat_parse_reply(priv->cmd_str, priv->ret_data);
 
-        /* check for error codes */
-        if (2 == strlen(priv->ret_data))
+        if (rc == -RIG_ENAVAIL)
         {
-            /* The following error responses  are documented for Kenwood
-               but not for  Yaesu, but at least one of  them is known to
-               occur  in that  the  FT-450 certainly  responds to  "IF;"
-               occasionally with  "?;". The others are  harmless even of
-               they do not occur as they are unambiguous. */
-            switch (priv->ret_data[0])
-            {
-            case 'N':
-                /* Command recognized by rig but invalid data entered. */
-                rig_debug(RIG_DEBUG_VERBOSE, "%s: NegAck for '%s'\n", __func__, priv->cmd_str);
-                RETURNFUNC(-RIG_ENAVAIL);
-
-            case 'O':
-                /* Too many characters sent without a carriage return */
-                rig_debug(RIG_DEBUG_VERBOSE, "%s: Overflow for '%s'\n", __func__,
-                          priv->cmd_str);
-                rc = -RIG_EPROTO;
-                break;            /* retry */
+            rig_stats_end(rig, &stats_start, rc, retry_count - 1);
+            RETURNFUNC(rc);
+        }
 
-            case 'E':
-                /* Communication error */
-                rig_debug(RIG_DEBUG_VERBOSE, "%s: Communication error for '%s'\n", __func__,
+        if (rc == -RIG_ERJCTED)
+        {
+            /* The ? response is ambiguous and undocumented by Yaesu, but for get commands it seems to
+             * indicate that the rig rejected the command because the state of the rig is not valid for the command
+             * or that the command parameter is invalid. Retrying the command does not fix the issue,
+             * as the error is caused by the an invalid combination of rig state.
+             *
+             * For example, the following cases have been observed:
+             * - MR and MC commands are rejected when referring to an _empty_ memory channel even
+             *   if the channel number is in a valid range
+             * - BC (ANF) and RL (NR) commands fail in AM/FM modes, because they are
+             *   supported only in SSB/CW/RTTY modes
+             * - MG (MICGAIN) command fails in RTTY mode, as it's a digital mode
+             *
+             * There are many more cases like these and they vary by rig model.
+             *
+             * So far, "rig busy" type situations with the ? response have not been observed for get commands.
+             * Followup 20201213 FTDX3000 FB; command returning ?; so do NOT abort
+             * see https://github.com/Hamlib/Hamlib/issues/464
+             */
+            if (priv->question_mark_response_means_rejected)
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: Command rejected by the rig (get): '%s'\n",
+                          __func__,
                           priv->cmd_str);
-                rc = -RIG_EIO;
-                break;            /* retry */
-
-            case '?':
-
-                /* The ? response is ambiguous and undocumented by Yaesu, but for get commands it seems to
-                 * indicate that the rig rejected the command because the state of the rig is not valid for the command
-                 * or that the command parameter is invalid. Retrying the command does not fix the issue,
-                 * as the error is caused by the an invalid combination of rig state.
-                 *
-                 * For example, the following cases have been observed:
-                 * - MR and MC commands are rejected when referring to an _empty_ memory channel even
-                 *   if the channel number is in a valid range
-                 * - BC (ANF) and RL (NR) commands fail in AM/FM modes, because they are
-                 *   supported only in SSB/CW/RTTY modes
-                 * - MG (MICGAIN) command fails in RTTY mode, as it's a digital mode
-                 *
-                 * There are many more cases like these and they vary by rig model.
-                 *
-                 * So far, "rig busy" type situations with the ? response have not been observed for get commands.
-                 * Followup 20201213 FTDX3000 FB; command returning ?; so do NOT abort
-                 * see https://github.com/Hamlib/Hamlib/issues/464
-                 */
-                if (priv->question_mark_response_means_rejected)
-                {
-                    rig_debug(RIG_DEBUG_ERR, "%s: Command rejected by the rig (get): '%s'\n",
-                              __func__,
-                              priv->cmd_str);
-                    RETURNFUNC(-RIG_ERJCTED);
-                }
-
-                rig_debug(RIG_DEBUG_WARN, "%s: Rig busy - retrying %d of %d: '%s'\n", __func__,
-                          retry_count, state->rigport.retry, priv->cmd_str);
-
-                rc = -RIG_ERJCTED; /* retry */
-                break;
+                rig_stats_end(rig, &stats_start, -RIG_ERJCTED, retry_count - 1);
+                RETURNFUNC(-RIG_ERJCTED);
             }
 
-            continue;
+            rig_debug(RIG_DEBUG_WARN, "%s: Rig busy - retrying %d of %d: '%s'\n", __func__,
+                      retry_count, state->rigport.retry, priv->cmd_str);
         }
 
-        /* verify that reply was to the command we sent */
-        if ((priv->ret_data[0] != priv->cmd_str[0]
-                || priv->ret_data[1] != priv->cmd_str[1]))
-        {
-            /*
-             * TODO: When RIG_TRN is enabled, we can pass the string
-             * to the decoder for callback. That way we don't ignore
-             * any commands.
-             */
-            rig_debug(RIG_DEBUG_ERR, "%s: wrong reply %.2s for command %.2s\n",
-                      __func__, priv->ret_data, priv->cmd_str);
-            // we were using BUSBUSY but microham devices need retries
-            // this should be OK under all other circumstances too
-            //rc = -RIG_BUSBUSY;    /* retry read only */
-            rc = -RIG_EPROTO;
-        }
+        /* anything else but RIG_OK is retried */
     }
 
     // update the cache
@@ -10351,25 +10609,24 @@ int newcat_get_cmd(RIG *rig)
         strcpy(priv->last_if_response, priv->ret_data);
     }
 
+    // the loop test bumps retry_count once more when the retries run out
+    if (retry_count > state->rigport.retry + 1)
+    {
+        retry_count = state->rigport.retry + 1;
+    }
+
+    rig_stats_end(rig, &stats_start, rc, retry_count - 1);
+
     RETURNFUNC(rc);
 }
 
 /*
- * This tries to set and read to validate the set command actually worked
- * returns RIG_OK if set, -RIG_EIMPL if not implemented yet, or -RIG_EPROTO if unsuccessful
+ * Pick the query that reads back what priv->cmd_str sets, "" if there is
+ * nothing to read back, -RIG_ENIMPL if unknown
  */
-int newcat_set_cmd_validate(RIG *rig)
+static int newcat_valcmd(RIG *rig, char *valcmd)
 {
-    struct rig_state *state = &rig->state;
-    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
-    char valcmd[16];
-    int retries = 8;
-    int retry = 0;
-    int sleepms = 50;
-    int rc = -RIG_EPROTO;
-
-    ENTERFUNC;
-    rig_debug(RIG_DEBUG_TRACE, "%s: priv->cmd_str=%s\n", __func__, priv->cmd_str);
+    const struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
 
     // For FA and FB rig.c now tries to verify the set_freq actually works
     // For example the FT-2000 can't do a FA set followed by an immediate read
@@ -10462,6 +10719,32 @@ int newcat_set_cmd_validate(RIG *rig)
     else
     {
         rig_debug(RIG_DEBUG_TRACE, "%s: %s not implemented\n", __func__, priv->cmd_str);
+        return -RIG_ENIMPL;
+    }
+
+    return RIG_OK;
+}
+
+
+/*
+ * This tries to set and read to validate the set command actually worked
+ * returns RIG_OK if set, -RIG_EIMPL if not implemented yet, or -RIG_EPROTO if unsuccessful
+ */
+int newcat_set_cmd_validate(RIG *rig)
+{
+    struct rig_state *state = &rig->state;
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    char valcmd[16];
+    int retries = 8;
+    int retry = 0;
+    int sleepms = 50;
+    int rc = -RIG_EPROTO;
+
+    ENTERFUNC;
+    rig_debug(RIG_DEBUG_TRACE, "%s: priv->cmd_str=%s\n", __func__, priv->cmd_str);
+
+    if (newcat_valcmd(rig, valcmd) != RIG_OK)
+    {
         RETURNFUNC(-RIG_ENIMPL);
     }
 
@@ -10523,6 +10806,114 @@ int newcat_set_cmd_validate(RIG *rig)
 
     RETURNFUNC(-RIG_EPROTO);
 }
+/*
+ * fast_commands_token=2: the set command goes out followed by a query and
+ * we return at once.  newcat_verify_deferred() reads the answers just
+ * before the next command, by which time they are normally waiting, and
+ * reports a rejected or mismatching set through the error callback.
+ */
+static int newcat_set_cmd_deferred(RIG *rig, const char *verify_cmd)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    char valcmd[16];
+    char cmd[NEWCAT_DATA_LEN + sizeof(valcmd)];
+    int rc;
+
+    // only these queries answer with exactly the value that was set
+    priv->verify_compare = (strncmp(priv->cmd_str, "MD", 2) == 0
+                            || strncmp(priv->cmd_str, "AI", 2) == 0
+                            || strncmp(priv->cmd_str, "FT", 2) == 0
+                            || strncmp(priv->cmd_str, "VS", 2) == 0)
+                           && newcat_valcmd(rig, valcmd) == RIG_OK && valcmd[0] != '\0';
+
+    SNPRINTF(priv->verify_query, sizeof(priv->verify_query), "%s",
+             priv->verify_compare ? valcmd : verify_cmd);
+    SNPRINTF(cmd, sizeof(cmd), "%s%s", priv->cmd_str, priv->verify_query);
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: cmd_str = %s\n", __func__, cmd);
+
+    rc = write_block(&rig->state.rigport, (unsigned char *) cmd, strlen(cmd));
+
+    if (rc != RIG_OK)
+    {
+        return rc;
+    }
+
+    SNPRINTF(priv->verify_cmd, sizeof(priv->verify_cmd), "%s", priv->cmd_str);
+    priv->verify_pending = 1;
+
+    return RIG_OK;
+}
+
+/*
+ * Collect the answers to the last deferred set, see above.  Returns the
+ * error found, which has already been reported.
+ */
+static int newcat_verify_deferred_unlocked(RIG *rig)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    char reply[NEWCAT_DATA_LEN] = "";
+    int err = RIG_OK;
+    int tries;
+
+    if (!priv->verify_pending)
+    {
+        return RIG_OK;
+    }
+
+    priv->verify_pending = 0;
+
+    // a few tries to step over unsolicited AI reports
+    for (tries = 0; tries < 4; tries++)
+    {
+        if (read_string(&rig->state.rigport, (unsigned char *) reply, sizeof(reply),
+                        &cat_term, sizeof(cat_term), 0, 1) <= 0)
+        {
+            err = -RIG_ETIMEOUT;
+            break;
+        }
+
+        if (strlen(reply) == 2)
+        {
+            // the set was refused, the query answer still follows
+            switch (reply[0])
+            {
+            case 'N': err = -RIG_ENAVAIL; continue;
+
+            case '?': err = -RIG_ERJCTED; continue;
+
+            case 'O':
+            case 'E': err = -RIG_EIO; continue;
+            }
+        }
+
+        if (strncmp(reply, priv->verify_query, 2) != 0)
+        {
+            continue;
+        }
+
+        if (err == RIG_OK && priv->verify_compare
+                && (strncmp(priv->verify_cmd, "FT", 2) == 0
+                    || strncmp(priv->verify_cmd, "VS", 2) == 0 ?
+                    strncmp(priv->verify_cmd, reply, 2) != 0 :
+                    strcmp(priv->verify_cmd, reply) != 0))
+        {
+            err = -RIG_EPROTO;
+        }
+
+        break;
+    }
+
+    if (err != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: '%s' failed: %s, last answer '%s'\n", __func__,
+                  priv->verify_cmd, rigerror(err), reply);
+        rig_fire_error_event(rig, err, priv->verify_cmd);
+    }
+
+    return err;
+}
+
 /*
  * Writes a null  terminated command string from  priv->cmd_str to the
  * CAT  port that is not expected to have a response.
@@ -10533,7 +10924,7 @@ int newcat_set_cmd_validate(RIG *rig)
  * "?;" busy please wait response; the command is not resent but up to
  * 'retry' retries to receive a valid response are made.
  */
-int newcat_set_cmd(RIG *rig)
+static int newcat_set_cmd_unlocked(RIG *rig)
 {
     struct rig_state *state = &rig->state;
     struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
@@ -10545,6 +10936,18 @@ int newcat_set_cmd(RIG *rig)
     char const *const verify_cmd = RIG_MODEL_FT9000 == rig->caps->rig_model ?
                                    "AI;" : "ID;";
 
+    newcat_verify_deferred(rig);
+
+    if (priv->bulk)
+    {
+        RETURNFUNC(newcat_bulk_hold(rig));
+    }
+
+    if (priv->fast_set_commands == NEWCAT_FAST_SET_DEFERRED)
+    {
+        RETURNFUNC(newcat_set_cmd_deferred(rig, verify_cmd));
+    }
+
     while (rc != RIG_OK && retry_count++ <= state->rigport.retry)
     {
         rig_flush(&state->rigport);  /* discard any unsolicited data */
@@ -10710,6 +11113,121 @@ int newcat_set_cmd(RIG *rig)
     RETURNFUNC(rc);
 }
 
+/*
+ * The public entry points to the port.  While the meter stream runs they
+ * take its I/O lock, see newcat_meter.c.
+ */
+int newcat_get_cmd(RIG *rig)
+{
+    int rc;
+
+    newcat_io_lock(rig);
+    rc = newcat_get_cmd_unlocked(rig);
+    newcat_io_unlock(rig);
+
+    return rc;
+}
+
+int newcat_set_cmd(RIG *rig)
+{
+    int rc;
+
+    newcat_io_lock(rig);
+    rc = newcat_set_cmd_unlocked(rig);
+    newcat_io_unlock(rig);
+
+    return rc;
+}
+
+int newcat_verify_deferred(RIG *rig)
+{
+    int rc;
+
+    newcat_io_lock(rig);
+    rc = newcat_verify_deferred_unlocked(rig);
+    newcat_io_unlock(rig);
+
+    return rc;
+}
+
+/*
+ * Settings first..end-1 have gone out since the last call: if anything
+ * among them was refused, have rig_set_bulk() redo the ones that looked
+ * fine one at a time to find out which.
+ */
+static void newcat_bulk_end(RIG *rig, struct rig_setting *settings, int first,
+                            int end)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    int i;
+
+    newcat_io_lock(rig);
+    newcat_bulk_flush(rig);
+    newcat_io_unlock(rig);
+
+    if (priv->bulk_err == RIG_OK)
+    {
+        return;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s, settings %d-%d go one at a time\n",
+              __func__, rigerror(priv->bulk_err), first, end - 1);
+
+    for (i = first; i < end; i++)
+    {
+        if (settings[i].retval == RIG_OK) { settings[i].retval = -RIG_ENIMPL; }
+    }
+
+    priv->bulk_err = RIG_OK;
+}
+
+/*
+ * The set commands of all the settings are chained in one write with a
+ * single ID; behind them, rather than each waiting for its own.  A
+ * setting that has to read something first sends the ones before it on
+ * the way.
+ */
+int newcat_set_bulk(RIG *rig, vfo_t vfo, struct rig_setting *settings,
+                    int count)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    char bulk[NEWCAT_BULK_LEN];
+    int i, first = 0;
+
+    ENTERFUNC;
+
+    priv->bulk = bulk;
+    priv->bulk_len = 0;
+    priv->bulk_err = RIG_OK;
+
+    for (i = 0; i < count; i++)
+    {
+        struct rig_setting *s = &settings[i];
+        int flushes = priv->bulk_flushes;
+
+        if (s->retval != -RIG_ENIMPL)
+        {
+            continue;
+        }
+
+        s->retval = s->type == RIG_SETTING_FUNC ?
+                    rig->caps->set_func(rig, vfo, s->setting, s->val.i) :
+                    rig->caps->set_level(rig, vfo, s->setting, s->val);
+
+        if (priv->bulk_flushes != flushes)
+        {
+            // this one may be among those that went out
+            newcat_bulk_end(rig, settings, first, i + 1);
+            first = i + 1;
+        }
+    }
+
+    newcat_bulk_end(rig, settings, first, count);
+    priv->bulk = NULL;
+
+    RETURNFUNC(RIG_OK);
+}
+
 struct
 {
     rmode_t mode;
@@ -54,6 +54,7 @@ typedef char ncboolean;
 
 /* Hopefully large enough for future use, 128 chars plus '\0' */
 #define NEWCAT_DATA_LEN                 129
+#define NEWCAT_BULK_LEN                 512 /* set commands chained by newcat_set_bulk() */
 
 /* arbitrary value for now.  11 bits (8N2+1) == 2.2917 mS @ 4800 bps */
 #define NEWCAT_DEFAULT_READ_TIMEOUT     (NEWCAT_DATA_LEN * 5)
@@ -109,6 +110,9 @@ struct newcat_priv_caps
     struct newcat_roofing_filter roofing_filters[NEWCAT_ROOFING_FILTER_COUNT];
 };
 
+/* "AA".."ZZ" as a bitmap */
+#define NEWCAT_CMD_MAP_SIZE ((26 * 26 + 7) / 8)
+
 /*
  * Private state for newcat rigs
  */
@@ -122,14 +126,30 @@ struct newcat_priv_data
     int
     rig_id;                         /* rig id from CAT Command ID; */
     int trn_state;  /* AI state found at startup */
-    int fast_set_commands; /* do not check for ACK/NAK; needed for high throughput > 100 commands/s */
+    int fast_set_commands; /* do not check for ACK/NAK; needed for high throughput > 100 commands/s, see NEWCAT_FAST_SET_DEFERRED */
     int width_frequency; /* found at startup */
     struct timespec cache_start;
     char last_if_response[NEWCAT_DATA_LEN];
     int poweron; /* to prevent powering on more than once */
     int question_mark_response_means_rejected; /* the question mark response has multiple meanings */
+    int verify_pending; /* answers to a deferred set verification are due, see newcat_verify_deferred() */
+    int verify_compare; /* the query answers with the value set, compare it */
+    char verify_cmd[NEWCAT_DATA_LEN];   /* the set command being verified */
+    char verify_query[16];              /* the query sent after it */
+    int valid_cmd_map_ready; /* valid_cmd_map holds this model's commands */
+    unsigned char valid_cmd_map[NEWCAT_CMD_MAP_SIZE]; /* one bit per two letter command, see newcat_valid_command() */
+    int meter_stream_ms; /* meter_stream conf, round robin period, 0 = off */
+    setting_t meter_stream_levels; /* meters it reads, meter_levels conf */
+    struct newcat_meter_stream *meter_stream; /* running stream, see newcat_meter.c */
+    char *bulk; /* set commands held back by newcat_set_bulk(), else NULL */
+    int bulk_len;
+    int bulk_flushes; /* times the held commands went out */
+    int bulk_err; /* first refusal among them not yet sorted out */
 };
 
+/* fast_set_commands value: verify each set with the next command */
+#define NEWCAT_FAST_SET_DEFERRED 2
+
 /*
  * Functions considered to be Stable:
  *
@@ -163,8 +183,23 @@ struct newcat_priv_data
  */
 
 int newcat_get_cmd(RIG *rig);
+int newcat_parse_reply(const char *cmd, const char *reply);
 int newcat_set_cmd(RIG *rig);
 
+/* RM meters, see newcat_get_level() */
+int newcat_meter_cmd(RIG *rig, setting_t level, char *cmd, size_t cmd_len);
+int newcat_meter_raw(const char *retlvl);
+float newcat_meter_raw2val(RIG *rig, setting_t level, int raw);
+
+/* Background meter reader, newcat_meter.c */
+#define NEWCAT_METER_DEFAULT_LEVELS "SWR,ALC,RFPOWER_METER,COMP_METER"
+int newcat_meter_parse_levels(const char *list, setting_t *levels);
+int newcat_meter_stream_start(RIG *rig);
+void newcat_meter_stream_stop(RIG *rig);
+int newcat_meter_cached(RIG *rig, setting_t level, value_t *val);
+void newcat_io_lock(RIG *rig);
+void newcat_io_unlock(RIG *rig);
+
 int newcat_init(RIG *rig);
 int newcat_cleanup(RIG *rig);
 int newcat_open(RIG *rig);
@@ -193,6 +228,7 @@ int newcat_get_ant(RIG * rig, vfo_t vfo, ant_t dummy, value_t * option, ant_t *
 int newcat_set_level(RIG * rig, vfo_t vfo, setting_t level, value_t val);
 int newcat_get_level(RIG * rig, vfo_t vfo, setting_t level, value_t * val);
 int newcat_set_func(RIG * rig, vfo_t vfo, setting_t func, int status);
+int newcat_set_bulk(RIG * rig, vfo_t vfo, struct rig_setting *settings, int count);
 int newcat_get_func(RIG * rig, vfo_t vfo, setting_t func, int *status);
 int newcat_set_mem(RIG * rig, vfo_t vfo, int ch);
 int newcat_get_mem(RIG * rig, vfo_t vfo, int *ch);
@@ -223,6 +259,7 @@ int newcat_set_trn(RIG * rig, int trn);
 int newcat_get_trn(RIG * rig, int *trn);
 int newcat_set_channel(RIG * rig, vfo_t vfo, const channel_t * chan);
 int newcat_get_channel(RIG * rig, vfo_t vfo, channel_t * chan, int read_only);
+int newcat_verify_deferred(RIG *rig);
 rmode_t newcat_rmode(char mode);
 char newcat_modechar(rmode_t rmode);
 rmode_t newcat_rmode_width(RIG *rig, vfo_t vfo, char mode, pbwidth_t *width);
@@ -0,0 +1,441 @@
+/*
+ *  Hamlib Yaesu backend - newcat meter stream
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Tune-up displays poll SWR, ALC, power and compression several times a
+ * second, and each RM query is a round trip that a frequency read has to
+ * queue behind.  AI does not report RM meters, so with "meter_stream" set
+ * a thread reads the meter_levels meters itself, one per time slot, and
+ * stores them in the level cache; newcat_get_level() also answers them
+ * from the last reading without I/O.
+ *
+ * User commands come first: newcat_get_cmd()/newcat_set_cmd() take the
+ * stream's I/O lock, and the thread skips its slot while one of them is
+ * waiting for the lock or finished less than NEWCAT_METER_GAP_MS ago, so
+ * meter reads go into the gaps between API calls rather than within them.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "hamlib/rig.h"
+#include "iofunc.h"
+#include "misc.h"
+#include "cache.h"
+#include "newcat.h"
+
+#define NEWCAT_METER_MAX 8
+#define NEWCAT_METER_GAP_MS 20      /* quiet time after a user command */
+
+struct newcat_meter
+{
+    setting_t level;
+    char cmd[8];
+    int raw;
+    int valid;
+    struct timespec time;
+};
+
+struct newcat_meter_stream
+{
+    RIG *rig;
+#ifdef HAVE_PTHREAD
+    pthread_t thread;
+    pthread_mutex_t io_lock;        /* recursive, held for each command */
+    pthread_mutex_t cache_lock;     /* meters[].raw/valid/time */
+#endif
+    int run;
+    int waiting;                    /* user commands waiting for io_lock */
+    struct timespec last_user_io;
+    int count;
+    struct newcat_meter meters[NEWCAT_METER_MAX];
+};
+
+/* The levels the stream can read, see newcat_meter_cmd() */
+#define NEWCAT_METER_LEVELS (RIG_LEVEL_SWR | RIG_LEVEL_ALC | \
+        RIG_LEVEL_RFPOWER_METER | RIG_LEVEL_RFPOWER_METER_WATTS | \
+        RIG_LEVEL_COMP_METER | RIG_LEVEL_VD_METER | RIG_LEVEL_ID_METER)
+
+int newcat_meter_parse_levels(const char *list, setting_t *levels)
+{
+    char buf[256];
+    char *tok, *save = NULL;
+    setting_t parsed = 0;
+
+    SNPRINTF(buf, sizeof(buf), "%s", list);
+
+    for (tok = strtok_r(buf, ", ", &save); tok; tok = strtok_r(NULL, ", ", &save))
+    {
+        setting_t level = rig_parse_level(tok);
+
+        if (!(level & NEWCAT_METER_LEVELS))
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: '%s' is not a meter the stream can read\n",
+                      __func__, tok);
+            return -RIG_EINVAL;
+        }
+
+        parsed |= level;
+    }
+
+    *levels = parsed;
+
+    return RIG_OK;
+}
+
+/* RFPOWER_METER and RFPOWER_METER_WATTS share one RM reading */
+static struct newcat_meter *newcat_meter_find(struct newcat_meter_stream *ms,
+        setting_t level)
+{
+    int i;
+
+    if (level == RIG_LEVEL_RFPOWER_METER_WATTS)
+    {
+        level = RIG_LEVEL_RFPOWER_METER;
+    }
+
+    for (i = 0; i < ms->count; i++)
+    {
+        if (ms->meters[i].level == level)
+        {
+            return &ms->meters[i];
+        }
+    }
+
+    return NULL;
+}
+
+#ifdef HAVE_PTHREAD
+
+static int newcat_meter_is_worker(struct newcat_meter_stream *ms)
+{
+    return ms->run && pthread_equal(pthread_self(), ms->thread);
+}
+
+void newcat_io_lock(RIG *rig)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    struct newcat_meter_stream *ms = priv->meter_stream;
+
+    if (!ms)
+    {
+        return;
+    }
+
+    if (newcat_meter_is_worker(ms))
+    {
+        pthread_mutex_lock(&ms->io_lock);
+        return;
+    }
+
+    __atomic_add_fetch(&ms->waiting, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_lock(&ms->io_lock);
+    __atomic_sub_fetch(&ms->waiting, 1, __ATOMIC_SEQ_CST);
+}
+
+void newcat_io_unlock(RIG *rig)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    struct newcat_meter_stream *ms = priv->meter_stream;
+
+    if (!ms)
+    {
+        return;
+    }
+
+    if (!newcat_meter_is_worker(ms))
+    {
+        elapsed_ms(&ms->last_user_io, HAMLIB_ELAPSED_SET);
+    }
+
+    pthread_mutex_unlock(&ms->io_lock);
+}
+
+/* One RM query with the stream's own buffers, io_lock held */
+static int newcat_meter_read(struct newcat_meter_stream *ms,
+                             struct newcat_meter *m)
+{
+    RIG *rig = ms->rig;
+    hamlib_port_t *rp = &rig->state.rigport;
+    char reply[NEWCAT_DATA_LEN];
+    size_t cmd_len = strlen(m->cmd);
+    value_t val;
+    int ret;
+
+    /* answers to a deferred set are read first, they are not ours */
+    newcat_verify_deferred(rig);
+
+    rig_flush(rp);
+    ret = write_block(rp, (unsigned char *) m->cmd, cmd_len);
+
+    if (ret != RIG_OK)
+    {
+        return ret;
+    }
+
+    ret = read_string(rp, (unsigned char *) reply, sizeof(reply), ";", 1, 0, 1);
+
+    if (ret < 0)
+    {
+        return ret;
+    }
+
+    if (ret <= (int)cmd_len - 1 || strncmp(reply, m->cmd, cmd_len - 1) != 0)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: unexpected answer '%s' to %s\n", __func__,
+                  reply, m->cmd);
+        return -RIG_EPROTO;
+    }
+
+    pthread_mutex_lock(&ms->cache_lock);
+    m->raw = newcat_meter_raw(reply + cmd_len - 1);
+    m->valid = 1;
+    elapsed_ms(&m->time, HAMLIB_ELAPSED_SET);
+    pthread_mutex_unlock(&ms->cache_lock);
+
+    /* lets rig_get_level() answer without calling into the backend */
+    val.f = newcat_meter_raw2val(rig, m->level, m->raw);
+    rig_set_cache_level(rig, RIG_VFO_CURR, m->level, val);
+
+    if (m->level == RIG_LEVEL_RFPOWER_METER
+            && rig_has_get_level(rig, RIG_LEVEL_RFPOWER_METER_WATTS))
+    {
+        val.f = newcat_meter_raw2val(rig, RIG_LEVEL_RFPOWER_METER_WATTS, m->raw);
+        rig_set_cache_level(rig, RIG_VFO_CURR, RIG_LEVEL_RFPOWER_METER_WATTS, val);
+    }
+
+    return RIG_OK;
+}
+
+static void *newcat_meter_thread(void *arg)
+{
+    struct newcat_meter_stream *ms = arg;
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)
+                                    ms->rig->state.priv;
+    int slot_ms = priv->meter_stream_ms / ms->count;
+    int next = 0;
+
+    if (slot_ms < 1)
+    {
+        slot_ms = 1;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %d meters, one every %d ms\n", __func__,
+              ms->count, slot_ms);
+
+    while (ms->run)
+    {
+        hl_usleep(slot_ms * 1000);
+
+        if (!ms->run || __atomic_load_n(&ms->waiting, __ATOMIC_SEQ_CST) > 0)
+        {
+            continue;
+        }
+
+        if (pthread_mutex_trylock(&ms->io_lock) != 0)
+        {
+            continue;
+        }
+
+        if (elapsed_ms(&ms->last_user_io, HAMLIB_ELAPSED_GET) < NEWCAT_METER_GAP_MS)
+        {
+            pthread_mutex_unlock(&ms->io_lock);
+            continue;
+        }
+
+        newcat_meter_read(ms, &ms->meters[next]);
+        pthread_mutex_unlock(&ms->io_lock);
+
+        next = (next + 1) % ms->count;
+    }
+
+    return NULL;
+}
+
+int newcat_meter_stream_start(RIG *rig)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    struct newcat_meter_stream *ms;
+    pthread_mutexattr_t attr;
+    setting_t levels = priv->meter_stream_levels;
+    int i;
+
+    ENTERFUNC;
+
+    if (priv->meter_stream)
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
+    ms = calloc(1, sizeof(*ms));
+
+    if (!ms)
+    {
+        RETURNFUNC(-RIG_ENOMEM);
+    }
+
+    ms->rig = rig;
+
+    /* WATTS is served from the RFPOWER_METER reading */
+    if (levels & RIG_LEVEL_RFPOWER_METER_WATTS)
+    {
+        levels = (levels & ~RIG_LEVEL_RFPOWER_METER_WATTS) | RIG_LEVEL_RFPOWER_METER;
+    }
+
+    for (i = 0; i < RIG_SETTING_MAX && ms->count < NEWCAT_METER_MAX; i++)
+    {
+        struct newcat_meter *m = &ms->meters[ms->count];
+        setting_t level = rig_idx2setting(i);
+
+        if (!(levels & level) || !rig_has_get_level(rig, level))
+        {
+            continue;
+        }
+
+        if (newcat_meter_cmd(rig, level, m->cmd, sizeof(m->cmd)) != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: %s not streamed on this rig\n",
+                      __func__, rig_strlevel(level));
+            continue;
+        }
+
+        m->level = level;
+        ms->count++;
+    }
+
+    if (ms->count == 0)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: no meter to stream\n", __func__);
+        free(ms);
+        RETURNFUNC(RIG_OK);
+    }
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&ms->io_lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    pthread_mutex_init(&ms->cache_lock, NULL);
+
+    ms->run = 1;
+    priv->meter_stream = ms;
+
+    if (pthread_create(&ms->thread, NULL, newcat_meter_thread, ms))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        priv->meter_stream = NULL;
+        pthread_mutex_destroy(&ms->io_lock);
+        pthread_mutex_destroy(&ms->cache_lock);
+        free(ms);
+        RETURNFUNC(-RIG_EINTERNAL);
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+void newcat_meter_stream_stop(RIG *rig)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    struct newcat_meter_stream *ms = priv->meter_stream;
+
+    if (!ms)
+    {
+        return;
+    }
+
+    ms->run = 0;
+    pthread_join(ms->thread, NULL);
+
+    priv->meter_stream = NULL;
+    pthread_mutex_destroy(&ms->io_lock);
+    pthread_mutex_destroy(&ms->cache_lock);
+    free(ms);
+}
+
+int newcat_meter_cached(RIG *rig, setting_t level, value_t *val)
+{
+    struct newcat_priv_data *priv = (struct newcat_priv_data *)rig->state.priv;
+    struct newcat_meter_stream *ms = priv->meter_stream;
+    struct newcat_meter *m;
+    int raw = 0;
+    int fresh = 0;
+
+    if (!ms || !(m = newcat_meter_find(ms, level)))
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    /* two periods old at most, else the caller goes to the rig */
+    pthread_mutex_lock(&ms->cache_lock);
+
+    if (m->valid && elapsed_ms(&m->time, HAMLIB_ELAPSED_GET)
+            <= 2 * priv->meter_stream_ms)
+    {
+        raw = m->raw;
+        fresh = 1;
+    }
+
+    pthread_mutex_unlock(&ms->cache_lock);
+
+    if (!fresh)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    val->f = newcat_meter_raw2val(rig, level, raw);
+
+    return RIG_OK;
+}
+
+#else /* !HAVE_PTHREAD */
+
+void newcat_io_lock(RIG *rig)
+{
+}
+
+void newcat_io_unlock(RIG *rig)
+{
+}
+
+int newcat_meter_stream_start(RIG *rig)
+{
+    rig_debug(RIG_DEBUG_WARN, "%s: built without threads, meter_stream ignored\n",
+              __func__);
+    return RIG_OK;
+}
+
+void newcat_meter_stream_stop(RIG *rig)
+{
+}
+
+int newcat_meter_cached(RIG *rig, setting_t level, value_t *val)
+{
+    return -RIG_ENAVAIL;
+}
+
+#endif
@@ -38,6 +38,50 @@
 
 #define BUFSZ 128
 
+#define TOK_PRECISE 1
+#define TOK_PIPELINE 2
+
+struct celestron_priv_data
+{
+    int precise;        /* 32-bit "b"/"z" commands instead of 16-bit "B"/"Z" */
+    int pipeline;       /* send the position query along with the goto */
+    int pos_valid;      /* az/el read with the last goto, not yet returned */
+    azimuth_t az;
+    elevation_t el;
+};
+
+/**
+ * celestron_read_reply
+ *
+ * Read one '#' terminated reply, stripping the terminator.
+ */
+static int
+celestron_read_reply(ROT *rot, char *data, size_t data_len)
+{
+    int retval;
+
+    memset(data, 0, data_len);
+    retval = read_string(&rot->state.rotport, (unsigned char *) data, data_len,
+                         ACK, strlen(ACK), 0, 1);
+
+    if (retval < 0)
+    {
+        return retval;
+    }
+
+    /* check for acknowledge */
+    if (retval < 1 || data[retval - 1] != '#')
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: unexpected response, len %d: '%s'\n", __func__,
+                  retval, data);
+        return -RIG_EPROTO;
+    }
+
+    data[retval - 1] = '\0';
+
+    return RIG_OK;
+}
+
 /**
  * celestron_transaction
  *
@@ -89,40 +133,152 @@ transaction_write:
     }
 
     /* the answer */
-    memset(data, 0, data_len);
-    retval = read_string(&rs->rotport, (unsigned char *) data, data_len,
-                         ACK, strlen(ACK), 0, 1);
+    retval = celestron_read_reply(rot, data, data_len);
 
-    if (retval < 0)
+    if (retval < 0 && retval != -RIG_EPROTO)
     {
         if (retry_read++ < rot->state.rotport.retry)
         {
             goto transaction_write;
         }
+    }
+
+transaction_quit:
+    return retval;
+}
+
+
+static int
+celestron_init(ROT *rot)
+{
+    rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
+
+    rot->state.priv = calloc(1, sizeof(struct celestron_priv_data));
 
-        goto transaction_quit;
+    if (!rot->state.priv)
+    {
+        return -RIG_ENOMEM;
     }
 
-    /* check for acknowledge */
-    if (retval < 1 || data[retval - 1] != '#')
+    return RIG_OK;
+}
+
+static int
+celestron_cleanup(ROT *rot)
+{
+    rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
+
+    free(rot->state.priv);
+    rot->state.priv = NULL;
+
+    return RIG_OK;
+}
+
+static int
+celestron_get_conf2(ROT *rot, token_t token, char *val, int val_len)
+{
+    struct celestron_priv_data *priv = (struct celestron_priv_data *)
+                                       rot->state.priv;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s called %d\n", __func__, (int)token);
+
+    switch (token)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: unexpected response, len %d: '%s'\n", __func__,
-                  retval, data);
-        return -RIG_EPROTO;
+    case TOK_PRECISE:
+        SNPRINTF(val, val_len, "%d", priv->precise);
+        break;
+
+    case TOK_PIPELINE:
+        SNPRINTF(val, val_len, "%d", priv->pipeline);
+        break;
+
+    default:
+        return -RIG_EINVAL;
     }
 
-    data[retval - 1] = '\0';
+    return RIG_OK;
+}
 
-    retval = RIG_OK;
-transaction_quit:
-    return retval;
+static int
+celestron_get_conf(ROT *rot, token_t token, char *val)
+{
+    return celestron_get_conf2(rot, token, val, 128);
+}
+
+static int
+celestron_set_conf(ROT *rot, token_t token, const char *val)
+{
+    struct celestron_priv_data *priv = (struct celestron_priv_data *)
+                                       rot->state.priv;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: called %d=%s\n", __func__, (int)token, val);
+
+    switch (token)
+    {
+    case TOK_PRECISE:
+        priv->precise = atoi(val) ? 1 : 0;
+        break;
+
+    case TOK_PIPELINE:
+        priv->pipeline = atoi(val) ? 1 : 0;
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    priv->pos_valid = 0;
+
+    return RIG_OK;
 }
 
+/*
+ * Parse a "Z" (XXXX,XXXX) or "z" (XXXXXXXX,XXXXXXXX) reply, each
+ * value being a fraction of a revolution.
+ */
+static int
+celestron_parse_position(const struct celestron_priv_data *priv,
+                         const char *posbuf, azimuth_t *az, elevation_t *el)
+{
+    int digits = priv->precise ? 8 : 4;
+    double rev = priv->precise ? 4294967296. : 65536.;
+    unsigned long w1, w2;
+    char *end;
+
+    if (strlen(posbuf) < 2 * digits + 1 || posbuf[digits] != ',')
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: unexpected position '%s'\n", __func__,
+                  posbuf);
+        return -RIG_EPROTO;
+    }
+
+    w1 = strtoul(posbuf, &end, 16);
+
+    if (end != posbuf + digits)
+    {
+        return -RIG_EPROTO;
+    }
+
+    w2 = strtoul(posbuf + digits + 1, &end, 16);
+
+    if (end != posbuf + 2 * digits + 1)
+    {
+        return -RIG_EPROTO;
+    }
+
+    *az = ((azimuth_t)w1 * 360.) / rev;
+    *el = ((elevation_t)w2 * 360.) / rev;
+
+    return RIG_OK;
+}
 
 static int
 celestron_set_position(ROT *rot, azimuth_t az, elevation_t el)
 {
+    struct celestron_priv_data *priv = (struct celestron_priv_data *)
+                                       rot->state.priv;
     char cmdstr[32];
+    char posbuf[32];
     int retval;
 
     rig_debug(RIG_DEBUG_TRACE, "%s called: %f %f\n", __func__, az, el);
@@ -134,46 +290,86 @@ celestron_set_position(ROT *rot, azimuth_t az, elevation_t el)
           tube is perpendicular to the azimuth axis.
      */
 
-    SNPRINTF(cmdstr, sizeof(cmdstr), "B%04X,%04X",
-             (unsigned)((az / 360.) * 65535),
-             (unsigned)((el / 360.) * 65535));
+    if (priv->precise)
+    {
+        SNPRINTF(cmdstr, sizeof(cmdstr), "b%08X,%08X",
+                 (unsigned)((az / 360.) * 4294967295.),
+                 (unsigned)((el / 360.) * 4294967295.));
+    }
+    else
+    {
+        SNPRINTF(cmdstr, sizeof(cmdstr), "B%04X,%04X",
+                 (unsigned)((az / 360.) * 65535),
+                 (unsigned)((el / 360.) * 65535));
+    }
+
+    priv->pos_valid = 0;
+
+    if (!priv->pipeline)
+    {
+        return celestron_transaction(rot, cmdstr, NULL, 0);
+    }
+
+    /*
+     * Queue the position query behind the goto, so a tracking loop
+     * doing set_position/get_position pays for one round trip only.
+     */
+    strcat(cmdstr, priv->precise ? "z" : "Z");
 
     retval = celestron_transaction(rot, cmdstr, NULL, 0);
 
-    return retval;
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    /* the goto went through, a missed position only costs a re-read */
+    if (celestron_read_reply(rot, posbuf, sizeof(posbuf)) == RIG_OK
+            && celestron_parse_position(priv, posbuf, &priv->az,
+                                        &priv->el) == RIG_OK)
+    {
+        priv->pos_valid = 1;
+    }
+
+    return RIG_OK;
 }
 
 static int
 celestron_get_position(ROT *rot, azimuth_t *az, elevation_t *el)
 {
+    struct celestron_priv_data *priv = (struct celestron_priv_data *)
+                                       rot->state.priv;
     char posbuf[32];
     int retval;
-    unsigned w;
 
     rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
 
-    /* Get Azm-Alt */
-    retval = celestron_transaction(rot, "Z", posbuf, sizeof(posbuf));
-
-    if (retval != RIG_OK || strlen(posbuf) < 9 || posbuf[4] != ',')
+    if (priv->pos_valid)
     {
-        return retval < 0 ? retval : -RIG_EPROTO;
+        /* read along with the last goto, hand it out once */
+        priv->pos_valid = 0;
+        *az = priv->az;
+        *el = priv->el;
+
+        return RIG_OK;
     }
 
-    if (sscanf(posbuf, "%04X", &w) != 1)
+    /* Get Azm-Alt */
+    retval = celestron_transaction(rot, priv->precise ? "z" : "Z", posbuf,
+                                   sizeof(posbuf));
+
+    if (retval != RIG_OK)
     {
-        return -RIG_EPROTO;
+        return retval;
     }
 
-    *az = ((azimuth_t)w * 360.) / 65536.;
+    retval = celestron_parse_position(priv, posbuf, az, el);
 
-    if (sscanf(posbuf + 5, "%04X", &w) != 1)
+    if (retval != RIG_OK)
     {
-        return -RIG_EPROTO;
+        return retval;
     }
 
-    *el = ((elevation_t)w * 360.) / 65536.;
-
     rig_debug(RIG_DEBUG_TRACE, "%s: (az, el) = (%.1f, %.1f)\n",
               __func__, *az, *el);
 
@@ -213,6 +409,19 @@ celestron_get_info(ROT *rot)
 
 
 
+static const struct confparams celestron_cfg_params[] =
+{
+    {
+        TOK_PRECISE, "precise", "Precise positioning", "Use the 32-bit b/z commands, firmware 2.2 and later",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_PIPELINE, "pipeline", "Pipelined goto", "Read the position back in the same round trip as each goto",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    { RIG_CONF_END, NULL, }
+};
+
 /* ************************************************************************* */
 /*
  * Celestron Nexstar telescope(rotator) capabilities.
@@ -229,7 +438,7 @@ const struct rot_caps nexstar_rot_caps =
     ROT_MODEL(ROT_MODEL_NEXSTAR),
     .model_name =     "NexStar",  // Any Celestron starting with version 1.2
     .mfg_name =       "Celestron",
-    .version =        "20220109.0",
+    .version =        "20261014.0",
     .copyright =      "LGPL",
     .status =         RIG_STATUS_BETA,
     .rot_type =       ROT_TYPE_AZEL,
@@ -250,6 +459,13 @@ const struct rot_caps nexstar_rot_caps =
     .min_el =     0.0,
     .max_el =     180.0,
 
+    .cfgparams =    celestron_cfg_params,
+    .get_conf =     celestron_get_conf,
+    .get_conf2 =    celestron_get_conf2,
+    .set_conf =     celestron_set_conf,
+
+    .rot_init =     celestron_init,
+    .rot_cleanup =  celestron_cleanup,
     .get_position = celestron_get_position,
     .set_position = celestron_set_position,
     .stop         = celestron_stop,
@@ -21,13 +21,23 @@
 
 #include "indi_wrapper.hpp"
 
-#include <math.h>
+#include <cmath>
 #include <limits.h>
 
 #define DIV_ROUND_UP(n,d) (((n) + (d) - 1) / (d))
 
 static std::unique_ptr<RotINDIClient> indi_wrapper_client(new RotINDIClient());
 
+RotINDIClient::RotINDIClient() :
+    mTelescope(NULL),
+    mDstAz(INT_MAX),
+    mDstEl(INT_MAX)
+{
+    Coord none = { NAN, NAN };
+
+    mPos.store(none);
+}
+
 int RotINDIClient::setSpeed(int speedPercent)
 {
     if (!mTelescope || !mTelescope->isConnected())
@@ -323,10 +333,32 @@ int RotINDIClient::unPark()
     return RIG_OK;
 }
 
-void RotINDIClient::position(azimuth_t *az, elevation_t *el)
+int RotINDIClient::position(azimuth_t *az, elevation_t *el)
+{
+    Coord pos = mPos.load(std::memory_order_acquire);
+
+    if (std::isnan(pos.az))
+    {
+        rig_debug(RIG_DEBUG_ERR, "indi: no position received from the server yet\n");
+        return -RIG_EIO;
+    }
+
+    *az = pos.az;
+    *el = pos.el;
+
+    return RIG_OK;
+}
+
+void RotINDIClient::storePosition(INumberVectorProperty *nvp)
 {
-    *az = mAz;
-    *el = mEl;
+    if (nvp->nnp < 2)
+    {
+        return;
+    }
+
+    Coord pos = { (azimuth_t)nvp->np[0].value, (elevation_t)nvp->np[1].value };
+
+    mPos.store(pos, std::memory_order_release);
 }
 
 double RotINDIClient::getPositionDiffBetween(double deg1, double deg2)
@@ -385,8 +417,9 @@ int RotINDIClient::setPosition(azimuth_t az, elevation_t el)
     double currDstNewDstElDiff = getPositionDiff(mDstEl, el, -90, 90);
     double currDstNewDstDistance = sqrt(pow(currDstNewDstAzDiff,
                                             2) + pow(currDstNewDstElDiff, 2));
-    double currPosNewDstAzDiff = getPositionDiff(mAz, az, 0, 360);
-    double currPosNewDstElDiff = getPositionDiff(mEl, el, -90, 90);
+    Coord pos = mPos.load(std::memory_order_acquire);
+    double currPosNewDstAzDiff = getPositionDiff(pos.az, az, 0, 360);
+    double currPosNewDstElDiff = getPositionDiff(pos.el, el, -90, 90);
     double currPosNewDstDistance = sqrt(pow(currPosNewDstAzDiff,
                                             2) + pow(currPosNewDstElDiff, 2));
 
@@ -485,8 +518,7 @@ void RotINDIClient::newProperty(INDI::Property *property)
 
     if (name == "HORIZONTAL_COORD")
     {
-        mAz = property->getNumber()->np[0].value;
-        mEl = property->getNumber()->np[1].value;
+        storePosition(property->getNumber());
     }
 }
 void RotINDIClient::removeProperty(INDI::Property *property) {}
@@ -496,10 +528,10 @@ void RotINDIClient::newNumber(INumberVectorProperty *nvp)
 {
     std::string name(nvp->name);
 
+    // the server pushes every change, so get_position never has to ask
     if (name == "HORIZONTAL_COORD")
     {
-        mAz = nvp->np[0].value;
-        mEl = nvp->np[1].value;
+        storePosition(nvp);
     }
 }
 void RotINDIClient::newMessage(INDI::BaseDevice *dp, int messageID) {}
@@ -562,9 +594,7 @@ extern "C" int indi_wrapper_get_position(ROT *rot, azimuth_t *az,
 {
     rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
 
-    indi_wrapper_client->position(az, el);
-
-    return RIG_OK;
+    return indi_wrapper_client->position(az, el);
 }
 
 extern "C" int indi_wrapper_stop(ROT *rot)
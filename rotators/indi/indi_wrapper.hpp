@@ -22,6 +22,8 @@
 #ifndef _INDI_WRAPPER_HPP
 #define _INDI_WRAPPER_HPP 1
 
+#include <atomic>
+
 #include <libindi/basedevice.h>
 #include <libindi/baseclient.h>
 
@@ -30,12 +32,14 @@
 class RotINDIClient : public INDI::BaseClient
 {
 public:
+    RotINDIClient();
+
     int setSpeed(int speedPercent);
     int move(int direction, int speedPercent);
     int stop();
     int park();
     int unPark();
-    void position(azimuth_t *az, elevation_t *el);
+    int position(azimuth_t *az, elevation_t *el);
     int setPosition(azimuth_t az, elevation_t el);
     const char *getInfo();
     void close(void);
@@ -58,14 +62,23 @@ private:
 	double getPositionDiffBetween(double deg1, double deg2);
 	double getPositionDiffOutside(double deg1, double deg2, double minDeg, double maxDeg);
 	double getPositionDiff(double deg1, double deg2, double minDeg, double maxDeg);
+    void storePosition(INumberVectorProperty *nvp);
 
     INDI::BaseDevice *mTelescope;
 
     azimuth_t mDstAz;
     elevation_t mDstEl;
 
-    azimuth_t mAz;
-    elevation_t mEl;
+    // HORIZONTAL_COORD as last pushed by the server.  Written by the INDI
+    // listener thread and read without a lock, as one value so az and el
+    // always come from the same update.  az is NaN until the first one.
+    struct Coord
+    {
+        azimuth_t az;
+        elevation_t el;
+    };
+
+    std::atomic<Coord> mPos;
 };
 
 #endif  // _INDI_WRAPPER_HPP
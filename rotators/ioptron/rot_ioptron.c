@@ -41,6 +41,16 @@
 
 #define BUFSZ 128
 
+#define TOK_PIPELINE 1
+
+struct ioptron_priv_data
+{
+    int pipeline;       /* one write per goto, position read back with it */
+    int pos_valid;      /* az/el read with the last goto, not yet returned */
+    azimuth_t az;
+    elevation_t el;
+};
+
 /**
  * ioptron_transaction
  *
@@ -132,6 +142,165 @@ transaction_quit:
     return retval;
 }
 
+/**
+ * ioptron_acked
+ *
+ * Send cmdstr, made of nacks commands replying a bare '1' each.  The
+ * acknowledges carry no '#', so count them byte by byte rather than
+ * waiting for a terminator that never comes; a stray '#' is skipped.
+ */
+static int
+ioptron_acked(ROT *rot, const char *cmdstr, int nacks)
+{
+    struct rot_state *rs = &rot->state;
+    int retry_read = 0;
+    int remaining;
+    int retval;
+
+transaction_write:
+
+    rig_flush(&rs->rotport);
+
+    retval = write_block(&rs->rotport, (unsigned char *) cmdstr, strlen(cmdstr));
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    for (remaining = nacks; remaining > 0;)
+    {
+        unsigned char c;
+
+        retval = read_block(&rs->rotport, &c, 1);
+
+        if (retval < 0)
+        {
+            if (retry_read++ < rs->rotport.retry)
+            {
+                goto transaction_write;
+            }
+
+            return retval;
+        }
+
+        if (c == ACK[0])
+        {
+            continue;
+        }
+
+        if (c != ACK1)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: '%s' not acknowledged, got 0x%02x\n",
+                      __func__, cmdstr, c);
+            return -RIG_EPROTO;
+        }
+
+        remaining--;
+    }
+
+    return RIG_OK;
+}
+
+/**  parses an :GAC# reply, sign and 8 digits alt then 9 digits az */
+static int
+ioptron_parse_position(const char *posbuf, azimuth_t *az, elevation_t *el)
+{
+    float w;
+
+    if (strlen(posbuf) < 18)
+    {
+        return -RIG_EPROTO;
+    }
+
+    if (sscanf(posbuf, "%9f", &w) != 1)
+    {
+        return -RIG_EPROTO;
+    }
+
+    /** convert from .01 arc sec to degrees  */
+    *el = ((elevation_t)w / 360000.);
+
+    if (sscanf(posbuf + 9, "%9f", &w) != 1)
+    {
+        return -RIG_EPROTO;
+    }
+
+    *az = ((azimuth_t)w / 360000.);
+
+    return RIG_OK;
+}
+
+static int ioptron_init(ROT *rot)
+{
+    rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
+
+    rot->state.priv = calloc(1, sizeof(struct ioptron_priv_data));
+
+    if (!rot->state.priv)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    return RIG_OK;
+}
+
+static int ioptron_cleanup(ROT *rot)
+{
+    rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
+
+    free(rot->state.priv);
+    rot->state.priv = NULL;
+
+    return RIG_OK;
+}
+
+static int ioptron_get_conf2(ROT *rot, token_t token, char *val, int val_len)
+{
+    struct ioptron_priv_data *priv = (struct ioptron_priv_data *)
+                                     rot->state.priv;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s called %d\n", __func__, (int)token);
+
+    switch (token)
+    {
+    case TOK_PIPELINE:
+        SNPRINTF(val, val_len, "%d", priv->pipeline);
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+static int ioptron_get_conf(ROT *rot, token_t token, char *val)
+{
+    return ioptron_get_conf2(rot, token, val, 128);
+}
+
+static int ioptron_set_conf(ROT *rot, token_t token, const char *val)
+{
+    struct ioptron_priv_data *priv = (struct ioptron_priv_data *)
+                                     rot->state.priv;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: called %d=%s\n", __func__, (int)token, val);
+
+    switch (token)
+    {
+    case TOK_PIPELINE:
+        priv->pipeline = atoi(val) ? 1 : 0;
+        priv->pos_valid = 0;
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
 /**
  * Opens the Port and sets all needed parameters for operation
  * as of 12/2018 initiates mount with V3 :MountInfo#
@@ -148,12 +317,17 @@ static int ioptron_open(ROT *rot)
  * set altitude
  * goto set
  * stop tracking - mount starts tracking after goto
+ * With pipeline set, the four go out in a single write followed by
+ * :GAC#, and the position is kept for the next get_position.
  */
 static int
 ioptron_set_position(ROT *rot, azimuth_t az, elevation_t el)
 {
-    char cmdstr[32];
-    char retbuf[10];
+    struct ioptron_priv_data *priv = (struct ioptron_priv_data *)
+                                     rot->state.priv;
+    char azstr[16], elstr[16];
+    char cmdstr[64];
+    char posbuf[32];
     int retval;
     float faz, fel;
 
@@ -162,78 +336,104 @@ ioptron_set_position(ROT *rot, azimuth_t az, elevation_t el)
     /* units .01 arc sec */
     faz = az * 360000;
     fel = el * 360000;
-    /* set azmiuth, returns '1" if OK */
-    SNPRINTF(cmdstr, sizeof(cmdstr), ":Sz%09.0f#", faz);
-    retval = ioptron_transaction(rot, cmdstr, retbuf, sizeof(retbuf));
+    SNPRINTF(azstr, sizeof(azstr), ":Sz%09.0f#", faz);
+    SNPRINTF(elstr, sizeof(elstr), ":Sa+%08.0f#", fel);
 
-    if (retval != RIG_OK || retbuf[0] != ACK1)
+    priv->pos_valid = 0;
+
+    if (priv->pipeline)
     {
-        return  -RIG_EPROTO;
+        SNPRINTF(cmdstr, sizeof(cmdstr), "%s%s:MS#:ST0#:GAC#", azstr, elstr);
+
+        retval = ioptron_acked(rot, cmdstr, 4);
+
+        if (retval != RIG_OK)
+        {
+            return retval;
+        }
+
+        /* the goto went through, a missed position only costs a re-read */
+        do
+        {
+            memset(posbuf, 0, sizeof(posbuf));
+            retval = read_string(&rot->state.rotport, (unsigned char *) posbuf,
+                                 sizeof(posbuf), ACK, strlen(ACK), 0, 1);
+        }
+        while (retval == 1);    /* a '#' trailing the last acknowledge */
+
+        if (retval > 0
+                && ioptron_parse_position(posbuf, &priv->az, &priv->el) == RIG_OK)
+        {
+            priv->pos_valid = 1;
+        }
+
+        return RIG_OK;
     }
 
-    /* set altitude, returns '1" if OK */
-    SNPRINTF(cmdstr, sizeof(cmdstr), ":Sa+%08.0f#", fel);
-    retval = ioptron_transaction(rot, cmdstr, retbuf, sizeof(retbuf));
+    /* set azmiuth, returns '1" if OK */
+    retval = ioptron_acked(rot, azstr, 1);
 
-    if (retval != RIG_OK || retbuf[0] != ACK1)
+    if (retval != RIG_OK)
     {
-        return  -RIG_EPROTO;
+        return retval;
     }
 
-    /* move to set target, V2 command, returns '1" if OK */
-    SNPRINTF(cmdstr, sizeof(cmdstr), ":MS#"); //
-    retval = ioptron_transaction(rot, cmdstr, retbuf, sizeof(retbuf));
+    /* set altitude, returns '1" if OK */
+    retval = ioptron_acked(rot, elstr, 1);
 
-    if (retval != RIG_OK || retbuf[0] != ACK1)
+    if (retval != RIG_OK)
     {
-        return  -RIG_EPROTO;
+        return retval;
     }
 
-    /* stop tracking, V2 command, returns '1" if OK */
-    SNPRINTF(cmdstr, sizeof(cmdstr), ":ST0#");
-    retval = ioptron_transaction(rot, cmdstr, retbuf, sizeof(retbuf));
+    /* move to set target, V2 command, returns '1" if OK */
+    retval = ioptron_acked(rot, ":MS#", 1);
 
-    if (retval != RIG_OK || retbuf[0] != ACK1)
+    if (retval != RIG_OK)
     {
-        return  -RIG_EPROTO;
+        return retval;
     }
 
-    return retval;
+    /* stop tracking, V2 command, returns '1" if OK */
+    return ioptron_acked(rot, ":ST0#", 1);
 }
 
 /**  gets current position  */
 static int
 ioptron_get_position(ROT *rot, azimuth_t *az, elevation_t *el)
 {
+    struct ioptron_priv_data *priv = (struct ioptron_priv_data *)
+                                     rot->state.priv;
     char posbuf[32];
     int retval;
-    float w;
 
     rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
 
-    /** Get Az-Alt */
-    retval = ioptron_transaction(rot, ":GAC#", posbuf, sizeof(posbuf));
-
-    if (retval != RIG_OK || strlen(posbuf) < 18)
+    if (priv->pos_valid)
     {
-        return retval < 0 ? retval : -RIG_EPROTO;
+        /* read along with the last goto, hand it out once */
+        priv->pos_valid = 0;
+        *az = priv->az;
+        *el = priv->el;
+
+        return RIG_OK;
     }
 
-    if (sscanf(posbuf, "%9f", &w) != 1)
+    /** Get Az-Alt */
+    retval = ioptron_transaction(rot, ":GAC#", posbuf, sizeof(posbuf));
+
+    if (retval != RIG_OK)
     {
-        return -RIG_EPROTO;
+        return retval;
     }
 
-    /** convert from .01 arc sec to degrees  */
-    *el = ((elevation_t)w / 360000.);
+    retval = ioptron_parse_position(posbuf, az, el);
 
-    if (sscanf(posbuf + 9, "%9f", &w) != 1)
+    if (retval != RIG_OK)
     {
-        return -RIG_EPROTO;
+        return retval;
     }
 
-    *az = ((azimuth_t)w / 360000.);
-
     rig_debug(RIG_DEBUG_TRACE, "%s: (az, el) = (%.1f, %.1f)\n",
               __func__, *az, *el);
 
@@ -245,27 +445,19 @@ static int
 ioptron_stop(ROT *rot)
 {
     int retval;
-    char retbuf[10];
 
     rig_debug(RIG_DEBUG_TRACE, "%s called\n", __func__);
 
     /** stop slew, returns "1" if OK */
-    retval = ioptron_transaction(rot, ":Q#", retbuf, 10);
+    retval = ioptron_acked(rot, ":Q#", 1);
 
-    if (retval != RIG_OK || retbuf[0] != ACK1)
+    if (retval != RIG_OK)
     {
-        return  -RIG_EPROTO;
+        return retval;
     }
 
     /** stops tracking returns "1" if OK */
-    retval = ioptron_transaction(rot, ":ST0#", retbuf, 10);
-
-    if (retval != RIG_OK || retbuf[0] != ACK1)
-    {
-        return  -RIG_EPROTO;
-    }
-
-    return retval;
+    return ioptron_acked(rot, ":ST0#", 1);
 }
 
 /** get mount type code, initializes mount */
@@ -290,6 +482,15 @@ ioptron_get_info(ROT *rot)
 
 
 
+static const struct confparams ioptron_cfg_params[] =
+{
+    {
+        TOK_PIPELINE, "pipeline", "Pipelined goto", "Send each goto in one write and read the position back with it",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    { RIG_CONF_END, NULL, }
+};
+
 /** *************************************************************************
  *
  * ioptron mount capabilities.
@@ -305,7 +506,7 @@ const struct rot_caps ioptron_rot_caps =
     ROT_MODEL(ROT_MODEL_IOPTRON),
     .model_name =     "iOptron",
     .mfg_name =       "iOptron",
-    .version =        "20220109.0",
+    .version =        "20261014.0",
     .copyright =      "LGPL",
     .status =         RIG_STATUS_STABLE,
     .rot_type =       ROT_TYPE_AZEL,
@@ -326,6 +527,13 @@ const struct rot_caps ioptron_rot_caps =
     .min_el =     0.0,
     .max_el =     180.0,
 
+    .cfgparams    = ioptron_cfg_params,
+    .get_conf     = ioptron_get_conf,
+    .get_conf2    = ioptron_get_conf2,
+    .set_conf     = ioptron_set_conf,
+
+    .rot_init     = ioptron_init,
+    .rot_cleanup  = ioptron_cleanup,
     .rot_open     = ioptron_open,
     .get_position = ioptron_get_position,
     .set_position = ioptron_set_position,
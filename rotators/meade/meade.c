@@ -37,6 +37,7 @@
 
 #include "meade.h"
 
+#define TOK_PIPELINE 1
 
 struct meade_priv_data
 {
@@ -47,6 +48,9 @@ struct meade_priv_data
     azimuth_t target_az;
     elevation_t target_el;
     char product_name[32];
+
+    int pipeline;         /* skip the :D# check, read position with goto */
+    int pos_valid;        /* az/el read with the last goto, not returned */
 };
 
 /**
@@ -129,7 +133,7 @@ transaction:
         {
             return_value = read_string(&rs->rotport, (unsigned char *) data,
                                        expected_return_length + 1,
-                                       "\r\n", strlen("\r\n"), 0, 1);
+                                       "#", strlen("#"), 0, 1);
 
             if (return_value > 0)
             {
@@ -158,6 +162,78 @@ transaction:
     }
 }
 
+/*
+ * Read n '#' terminated replies back to back into data, returning as
+ * soon as the last terminator is in rather than waiting for the timeout.
+ */
+static int meade_read_replies(ROT *rot, char *data, size_t data_len, int n)
+{
+    size_t len = 0;
+    int retval;
+
+    memset(data, 0, data_len);
+
+    while (n-- > 0)
+    {
+        if (len + 1 >= data_len)
+        {
+            return -RIG_EPROTO;
+        }
+
+        retval = read_string(&rot->state.rotport, (unsigned char *) data + len,
+                             data_len - len, "#", 1, 0, 1);
+
+        if (retval <= 0)
+        {
+            return retval < 0 ? retval : -RIG_EPROTO;
+        }
+
+        len += retval;
+    }
+
+    return (int)len;
+}
+
+/*
+ * Parse the concatenated :GZ#:GA# replies
+ */
+static int meade_parse_position(const char *return_str, azimuth_t *az,
+                                elevation_t *el)
+{
+    char eom;
+    int az_degrees, az_minutes, az_seconds, el_degrees, el_minutes, el_seconds;
+    int n;
+
+    // GZ returns DDD*MM# or DDD*MM'SS#
+    // GA returns sDD*MM# or sDD*MM'SS#
+    n = sscanf(return_str, "%d%*c%d:%d#%d%*c%d:%d%c", &az_degrees, &az_minutes,
+               &az_seconds, &el_degrees, &el_minutes, &el_seconds, &eom);
+
+    if (n != 7 || eom != '#')
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: not 6 args in '%s'\nTrying low precision\n",
+                  __func__, return_str);
+        az_seconds = el_seconds = 0;
+        n = sscanf(return_str, "%d%*c%d#%d%*c%d%c", &az_degrees, &az_minutes,
+                   &el_degrees, &el_minutes, &eom);
+
+        if (n != 5 || eom != '#')
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: not 4 args in '%s', parsing failed\n", __func__,
+                      return_str);
+            return -RIG_EPROTO;
+        }
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: az=%03d:%02d:%02d, el=%03d:%02d:%02d\n",
+              __func__, az_degrees, az_minutes, az_seconds, el_degrees, el_minutes,
+              el_seconds);
+    *az = dmmm2dec(az_degrees, az_minutes, az_seconds, az_seconds);
+    *el = dmmm2dec(el_degrees, el_minutes, el_seconds, el_seconds);
+
+    return RIG_OK;
+}
+
 /*
  * Initialization
  */
@@ -203,6 +279,50 @@ static int meade_cleanup(ROT *rot)
     return RIG_OK;
 }
 
+static int meade_get_conf2(ROT *rot, token_t token, char *val, int val_len)
+{
+    struct meade_priv_data *priv = (struct meade_priv_data *)rot->state.priv;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s called %d\n", __func__, (int)token);
+
+    switch (token)
+    {
+    case TOK_PIPELINE:
+        SNPRINTF(val, val_len, "%d", priv->pipeline);
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
+static int meade_get_conf(ROT *rot, token_t token, char *val)
+{
+    return meade_get_conf2(rot, token, val, 128);
+}
+
+static int meade_set_conf(ROT *rot, token_t token, const char *val)
+{
+    struct meade_priv_data *priv = (struct meade_priv_data *)rot->state.priv;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: called %d=%s\n", __func__, (int)token, val);
+
+    switch (token)
+    {
+    case TOK_PIPELINE:
+        priv->pipeline = atoi(val) ? 1 : 0;
+        priv->pos_valid = 0;
+        break;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    return RIG_OK;
+}
+
 /*
  * Opens the Port and sets all needed parameters for operation
  */
@@ -255,6 +375,65 @@ static int meade_close(ROT *rot)
     return meade_transaction(rot, ":Q#", NULL, 0, 0);
 }
 
+/*
+ * Goto and position query in a single write.  The :D# busy check is
+ * skipped so a tracking client can re-target a mount still slewing.
+ */
+static int meade_set_position_pipelined(ROT *rot, float az_degrees,
+                                        float az_minutes, float el_degrees,
+                                        float el_minutes)
+{
+    struct meade_priv_data *priv = (struct meade_priv_data *)rot->state.priv;
+    struct rot_state *rs = &rot->state;
+    char cmd_str[BUFSIZE];
+    char return_str[BUFSIZE];
+    unsigned char ack[3];
+    int retval;
+
+    num_sprintf(cmd_str, ":Sz %03.0f*%02.0f#:Sa+%02.0f*%02.0f#:MA#:GZ#:GA#",
+                az_degrees, az_minutes, el_degrees, el_minutes);
+
+    rig_flush(&rs->rotport);
+
+    retval = write_block(&rs->rotport, (unsigned char *) cmd_str,
+                         strlen(cmd_str));
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    retval = read_block(&rs->rotport, ack, sizeof(ack));
+
+    if (retval < 0)
+    {
+        return retval;
+    }
+
+    if (ack[0] != '1' || ack[1] != '1' || ack[2] != '0')
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: expected 110, got %.3s\n", __func__,
+                  (char *) ack);
+
+        /* MA errors come with a '#' terminated message, drop it */
+        if (ack[2] != '0')
+        {
+            meade_read_replies(rot, return_str, sizeof(return_str), 1);
+        }
+
+        return -RIG_EINVAL;
+    }
+
+    /* the goto went through, a missed position only costs a re-read */
+    if (meade_read_replies(rot, return_str, sizeof(return_str), 2) > 0
+            && meade_parse_position(return_str, &priv->az, &priv->el) == RIG_OK)
+    {
+        priv->pos_valid = 1;
+    }
+
+    return RIG_OK;
+}
+
 /*
  * Sets the target position and starts movement
  *
@@ -285,6 +464,22 @@ static int meade_set_position(ROT *rot, azimuth_t az, elevation_t el)
         az_minutes = 59;
     }
 
+    priv->pos_valid = 0;
+
+    if (priv->pipeline)
+    {
+        int retval = meade_set_position_pipelined(rot, az_degrees, az_minutes,
+                     el_degrees, el_minutes);
+
+        if (retval == RIG_OK)
+        {
+            priv->target_az = az;
+            priv->target_el = el;
+        }
+
+        return retval;
+    }
+
     /* Check if there is an active movement and stop it */
     /* Undesirable behavior if stopped can happen */
     /* So we just ignore commands while moving */
@@ -325,43 +520,48 @@ static int meade_set_position(ROT *rot, azimuth_t az, elevation_t el)
  */
 static int meade_get_position(ROT *rot, azimuth_t *az, elevation_t *el)
 {
+    struct meade_priv_data *priv = (struct meade_priv_data *)rot->state.priv;
+    struct rot_state *rs = &rot->state;
     char return_str[BUFSIZE];
-    char eom;
-    size_t return_str_size;
-    int az_degrees, az_minutes, az_seconds, el_degrees, el_minutes, el_seconds;
-    int n;
+    int retry_read = 0;
+    int retval;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
-    meade_transaction(rot, ":GZ#:GA#", return_str, &return_str_size, BUFSIZE);
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: returned '%s'\n", __func__, return_str);
-    // GZ returns DDD*MM# or DDD*MM'SS#
-    // GA returns sDD*MM# or sDD*MM'SS#
-    n = sscanf(return_str, "%d%*c%d:%d#%d%*c%d:%d%c", &az_degrees, &az_minutes,
-               &az_seconds, &el_degrees, &el_minutes, &el_seconds, &eom);
+    if (priv->pos_valid)
+    {
+        /* read along with the last goto, hand it out once */
+        priv->pos_valid = 0;
+        *az = priv->az;
+        *el = priv->el;
 
-    if (n != 7 || eom != '#')
+        return RIG_OK;
+    }
+
+    do
     {
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: not 6 args in '%s'\nTrying low precision\n",
-                  __func__, return_str);
-        az_seconds = el_seconds = 0;
-        n = sscanf(return_str, "%d%*c%d#%d%*c%d%c", &az_degrees, &az_minutes,
-                   &el_degrees, &el_minutes, &eom);
+        rig_flush(&rs->rotport);
 
-        if (n != 5 || eom != '#')
+        retval = write_block(&rs->rotport, (unsigned char *) ":GZ#:GA#", 8);
+
+        if (retval != RIG_OK)
         {
-            rig_debug(RIG_DEBUG_ERR, "%s: not 4 args in '%s', parsing failed\n", __func__,
-                      return_str);
-            return -RIG_EPROTO;
+            return retval;
         }
+
+        retval = meade_read_replies(rot, return_str, sizeof(return_str), 2);
     }
+    while (retval < 0 && retry_read++ < rs->rotport.retry);
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: az=%03d:%02d:%02d, el=%03d:%02d:%02d\n",
-              __func__, az_degrees, az_minutes, az_seconds, el_degrees, el_minutes,
-              el_seconds);
-    *az = dmmm2dec(az_degrees, az_minutes, az_seconds, az_seconds);
-    *el = dmmm2dec(el_degrees, el_minutes, el_seconds, el_seconds);
-    return RIG_OK;
+    if (retval < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: read error %s\n", __func__, rigerror(retval));
+        return retval;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: returned '%s'\n", __func__, return_str);
+
+    return meade_parse_position(return_str, az, el);
 }
 
 /*
@@ -452,6 +652,15 @@ static const char *meade_get_info(ROT *rot)
     return buf;
 }
 
+static const struct confparams meade_cfg_params[] =
+{
+    {
+        TOK_PIPELINE, "pipeline", "Pipelined goto", "Re-target while slewing, read the position back with each goto",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    { RIG_CONF_END, NULL, }
+};
+
 /*
  * Meade telescope rotator capabilities.
  */
@@ -461,7 +670,7 @@ const struct rot_caps meade_caps =
     ROT_MODEL(ROT_MODEL_MEADE),
     .model_name =       "LX200/Autostar",
     .mfg_name =         "Meade",
-    .version =          "20220109.0",
+    .version =          "20261014.0",
     .copyright =        "LGPL",
     .status =           RIG_STATUS_STABLE,
     .rot_type =         ROT_TYPE_AZEL,
@@ -500,8 +709,10 @@ const struct rot_caps meade_caps =
 
     .get_info =         meade_get_info,
 
-    .get_conf =         rot_get_conf,
-    .set_conf =         rot_set_conf,
+    .cfgparams =        meade_cfg_params,
+    .get_conf =         meade_get_conf,
+    .get_conf2 =        meade_get_conf2,
+    .set_conf =         meade_set_conf,
 };
 
 DECLARE_INITROT_BACKEND(meade)
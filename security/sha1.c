@@ -0,0 +1,138 @@
+/*
+ *  Hamlib Interface - SHA-1 message digest
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <string.h>
+
+#include "sha1.h"
+
+#define ROL(x,n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void sha1_process(sha1_context *ctx, const unsigned char data[64])
+{
+    uint32_t W[80];
+    uint32_t A, B, C, D, E, temp;
+    int t;
+
+    for (t = 0; t < 16; t++)
+    {
+        W[t] = (uint32_t) data[4 * t] << 24 | (uint32_t) data[4 * t + 1] << 16
+               | (uint32_t) data[4 * t + 2] << 8 | (uint32_t) data[4 * t + 3];
+    }
+
+    for (t = 16; t < 80; t++)
+    {
+        W[t] = ROL(W[t - 3] ^ W[t - 8] ^ W[t - 14] ^ W[t - 16], 1);
+    }
+
+    A = ctx->state[0];
+    B = ctx->state[1];
+    C = ctx->state[2];
+    D = ctx->state[3];
+    E = ctx->state[4];
+
+    for (t = 0; t < 80; t++)
+    {
+        if (t < 20)
+        {
+            temp = ((B & C) | (~B & D)) + 0x5A827999;
+        }
+        else if (t < 40)
+        {
+            temp = (B ^ C ^ D) + 0x6ED9EBA1;
+        }
+        else if (t < 60)
+        {
+            temp = ((B & C) | (B & D) | (C & D)) + 0x8F1BBCDC;
+        }
+        else
+        {
+            temp = (B ^ C ^ D) + 0xCA62C1D6;
+        }
+
+        temp += ROL(A, 5) + E + W[t];
+        E = D;
+        D = C;
+        C = ROL(B, 30);
+        B = A;
+        A = temp;
+    }
+
+    ctx->state[0] += A;
+    ctx->state[1] += B;
+    ctx->state[2] += C;
+    ctx->state[3] += D;
+    ctx->state[4] += E;
+}
+
+void sha1_starts(sha1_context *ctx)
+{
+    ctx->state[0] = 0x67452301;
+    ctx->state[1] = 0xEFCDAB89;
+    ctx->state[2] = 0x98BADCFE;
+    ctx->state[3] = 0x10325476;
+    ctx->state[4] = 0xC3D2E1F0;
+    ctx->length = 0;
+}
+
+void sha1_update(sha1_context *ctx, const unsigned char *input, size_t length)
+{
+    size_t fill = ctx->length % 64;
+
+    ctx->length += length;
+
+    if (fill && fill + length >= 64)
+    {
+        memcpy(ctx->buffer + fill, input, 64 - fill);
+        sha1_process(ctx, ctx->buffer);
+        input += 64 - fill;
+        length -= 64 - fill;
+        fill = 0;
+    }
+
+    for (; length >= 64 && !fill; input += 64, length -= 64)
+    {
+        sha1_process(ctx, input);
+    }
+
+    memcpy(ctx->buffer + fill, input, length);
+}
+
+void sha1_finish(sha1_context *ctx, unsigned char digest[20])
+{
+    static const unsigned char padding[64] = { 0x80 };
+    unsigned char msglen[8];
+    uint64_t bits = ctx->length * 8;
+    size_t fill = ctx->length % 64;
+    int i;
+
+    for (i = 0; i < 8; i++)
+    {
+        msglen[i] = (unsigned char)(bits >> (56 - 8 * i));
+    }
+
+    sha1_update(ctx, padding, fill < 56 ? 56 - fill : 120 - fill);
+    sha1_update(ctx, msglen, 8);
+
+    for (i = 0; i < 20; i++)
+    {
+        digest[i] = (unsigned char)(ctx->state[i / 4] >> (24 - 8 * (i % 4)));
+    }
+}
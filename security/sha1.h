@@ -0,0 +1,44 @@
+/*
+ *  Hamlib Interface - SHA-1 message digest
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _SHA1_H
+#define _SHA1_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/*
+ * FIPS 180-1 SHA-1, here for the WebSocket handshake (RFC 6455) and not
+ * for anything that has to be secure.
+ */
+typedef struct
+{
+    uint32_t state[5];
+    uint64_t length;        /* bytes hashed so far */
+    unsigned char buffer[64];
+}
+sha1_context;
+
+void sha1_starts(sha1_context *ctx);
+void sha1_update(sha1_context *ctx, const unsigned char *input, size_t length);
+void sha1_finish(sha1_context *ctx, unsigned char digest[20]);
+
+#endif /* sha1.h */
@@ -0,0 +1,320 @@
+// Serial line behaviour shared by the simulators, see sim_io.h
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <unistd.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "sim_io.h"
+
+enum { DIST_FIXED, DIST_UNIFORM, DIST_NORMAL, DIST_EXP };
+
+static int baud;
+static double delay_ms;
+static double jitter_ms;
+static int dist = DIST_UNIFORM;
+static int latency_ms;
+static double loss;
+static double garbage;
+static int transceive_ms;
+static unsigned int seed;
+
+// bytes of the command being answered, and when its first one came in
+static long rx_bytes;
+static long long rx_first;
+static int talking;
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t line_lock = PTHREAD_MUTEX_INITIALIZER;
+#define LINE_LOCK() pthread_mutex_lock(&line_lock)
+#define LINE_UNLOCK() pthread_mutex_unlock(&line_lock)
+#else
+#define LINE_LOCK()
+#define LINE_UNLOCK()
+#endif
+
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+static void sleep_until(long long t)
+{
+    long long left;
+
+    while ((left = t - now_ns()) > 0)
+    {
+        struct timespec ts;
+
+        ts.tv_sec = left / 1000000000LL;
+        ts.tv_nsec = left % 1000000000LL;
+        nanosleep(&ts, NULL);
+    }
+}
+
+
+// uniform in [0, 1), called with line_lock held
+static double chance(void)
+{
+    return rand_r(&seed) / (RAND_MAX + 1.0);
+}
+
+
+static double processing_ms(void)
+{
+    double ms = delay_ms;
+
+    switch (dist)
+    {
+    case DIST_UNIFORM:
+        ms += jitter_ms * (2 * chance() - 1);
+        break;
+
+    case DIST_NORMAL:
+        // Box-Muller
+        ms += jitter_ms * sqrt(-2 * log(1 - chance())) * cos(2 * M_PI * chance());
+        break;
+
+    case DIST_EXP:
+        ms = -delay_ms * log(1 - chance());
+        break;
+    }
+
+    return ms > 0 ? ms : 0;
+}
+
+
+static double env_num(const char *name, double dflt)
+{
+    const char *s = getenv(name);
+
+    return s && *s ? atof(s) : dflt;
+}
+
+
+void sim_io_init(void)
+{
+    const char *s;
+
+    baud = (int) env_num("SIM_BAUD", 0);
+    delay_ms = env_num("SIM_DELAY_MS", 0);
+    jitter_ms = env_num("SIM_JITTER_MS", 0);
+    latency_ms = (int) env_num("SIM_LATENCY_MS", 0);
+    loss = env_num("SIM_LOSS", 0) / 100;
+    garbage = env_num("SIM_GARBAGE", 0) / 100;
+    transceive_ms = (int) env_num("SIM_TRANSCEIVE_MS", 0);
+    seed = (unsigned int) env_num("SIM_SEED", (double) time(NULL));
+
+    s = getenv("SIM_DELAY_DIST");
+
+    if (s && strcasecmp(s, "fixed") == 0) { dist = DIST_FIXED; }
+    else if (s && strcasecmp(s, "normal") == 0) { dist = DIST_NORMAL; }
+    else if (s && strcasecmp(s, "exp") == 0) { dist = DIST_EXP; }
+    else if (s && *s && strcasecmp(s, "uniform") != 0)
+    {
+        fprintf(stderr, "SIM_DELAY_DIST=%s unknown, using uniform\n", s);
+    }
+
+    if (baud || delay_ms || jitter_ms || latency_ms || loss || garbage
+            || transceive_ms)
+    {
+        printf("line: baud=%d delay=%.1fms jitter=%.1fms dist=%s latency=%dms"
+               " loss=%.1f%% garbage=%.1f%% transceive=%dms seed=%u\n",
+               baud, delay_ms, jitter_ms,
+               dist == DIST_FIXED ? "fixed" : dist == DIST_NORMAL ? "normal"
+               : dist == DIST_EXP ? "exp" : "uniform",
+               latency_ms, loss * 100, garbage * 100, transceive_ms, seed);
+        fflush(stdout);
+    }
+}
+
+
+ssize_t sim_read(int fd, void *buf, size_t len)
+{
+    ssize_t n = read(fd, buf, len);
+
+    LINE_LOCK();
+
+    if (n > 0)
+    {
+        if (rx_bytes == 0) { rx_first = now_ns(); }
+
+        rx_bytes += n;
+        talking = 1;
+    }
+    else
+    {
+        // client gone, nobody to report to
+        talking = 0;
+    }
+
+    LINE_UNLOCK();
+
+    return n;
+}
+
+
+// called with line_lock held
+static ssize_t line_send(int fd, const unsigned char *buf, size_t len,
+                         int reply)
+{
+    long long byte_ns = baud > 0 ? 10000000000LL / baud : 0;
+    long long start = now_ns();
+    unsigned char *out;
+    ssize_t ret = len;
+    size_t i;
+
+    if (reply)
+    {
+        // the command was still on the wire until now
+        if (rx_bytes > 0 && rx_first + rx_bytes * byte_ns > start)
+        {
+            start = rx_first + rx_bytes * byte_ns;
+        }
+
+        start += (long long)(processing_ms() * 1000000);
+        rx_bytes = 0;
+    }
+
+    if (loss > 0 && chance() < loss)
+    {
+        printf("line: reply dropped\n");
+        return len;
+    }
+
+    out = malloc(len);
+
+    if (!out) { return -1; }
+
+    memcpy(out, buf, len);
+
+    if (garbage > 0 && len > 0 && chance() < garbage)
+    {
+        i = (size_t)(chance() * len);
+        out[i] ^= 1 + (unsigned char)(chance() * 255);
+        printf("line: byte %d corrupted\n", (int) i);
+    }
+
+    if (latency_ms > 0)
+    {
+        // the adapter passes the bytes on at the first tick after the last one
+        long long tick = latency_ms * 1000000LL;
+        long long end = start + (long long) len * byte_ns;
+
+        sleep_until((end + tick - 1) / tick * tick);
+        ret = write(fd, out, len);
+    }
+    else if (byte_ns > 0)
+    {
+        for (i = 0; i < len; i++)
+        {
+            sleep_until(start + (long long) i * byte_ns);
+
+            if (write(fd, &out[i], 1) != 1)
+            {
+                ret = -1;
+                break;
+            }
+        }
+
+        // the last byte takes its time too
+        sleep_until(start + (long long) len * byte_ns);
+    }
+    else
+    {
+        sleep_until(start);
+        ret = write(fd, out, len);
+    }
+
+    free(out);
+
+    return ret;
+}
+
+
+ssize_t sim_write(int fd, const void *buf, size_t len)
+{
+    ssize_t n;
+
+    LINE_LOCK();
+    n = line_send(fd, buf, len, 1);
+    LINE_UNLOCK();
+
+    return n;
+}
+
+
+#ifdef HAVE_PTHREAD
+
+static int *transceive_fdp;
+static sim_transceive_cb_t transceive_cb;
+
+
+static void *transceive_thread(void *arg)
+{
+    unsigned char buf[64];
+
+    while (1)
+    {
+        int n;
+
+        usleep(transceive_ms * 1000);
+
+        LINE_LOCK();
+
+        if (talking && *transceive_fdp >= 0
+                && (n = transceive_cb(buf, sizeof(buf))) > 0)
+        {
+            line_send(*transceive_fdp, buf, n, 0);
+        }
+
+        LINE_UNLOCK();
+    }
+
+    return NULL;
+}
+
+
+void sim_transceive(int *fdp, sim_transceive_cb_t cb)
+{
+    pthread_t thread;
+
+    if (transceive_ms <= 0) { return; }
+
+    transceive_fdp = fdp;
+    transceive_cb = cb;
+
+    if (pthread_create(&thread, NULL, transceive_thread, NULL))
+    {
+        perror("pthread_create");
+        return;
+    }
+
+    pthread_detach(thread);
+}
+
+#else
+
+void sim_transceive(int *fdp, sim_transceive_cb_t cb)
+{
+    if (transceive_ms > 0)
+    {
+        fprintf(stderr, "SIM_TRANSCEIVE_MS needs pthreads, ignored\n");
+    }
+}
+
+#endif
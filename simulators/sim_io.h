@@ -0,0 +1,36 @@
+// Serial line behaviour shared by the simulators
+//
+// By default a simulator answers as fast as the pty lets it.  These
+// environment variables make it behave more like a rig on a real cable:
+//
+//   SIM_BAUD=n           pace every byte, both ways, as 8N1 at n baud
+//   SIM_DELAY_MS=n       extra processing time before each reply
+//   SIM_JITTER_MS=n      spread of that time
+//   SIM_DELAY_DIST=d     fixed, uniform (+-jitter), normal (sd jitter)
+//                        or exp (mean DELAY_MS), default uniform
+//   SIM_LATENCY_MS=n     hold replies until the next tick of a USB serial
+//                        latency timer, as FTDI style adapters do
+//   SIM_LOSS=p           drop p percent of replies
+//   SIM_GARBAGE=p        corrupt one byte in p percent of replies
+//   SIM_TRANSCEIVE_MS=n  send the rig's unsolicited frequency report every
+//                        n ms while a client is talking
+//   SIM_SEED=n           seed for the random choices, to repeat a run
+//
+// The delays come on top of the fixed ones written in each simulator.
+
+#ifndef _SIM_IO_H
+#define _SIM_IO_H 1
+
+#include <sys/types.h>
+
+// fills buf with the unsolicited report, returns its length or 0 for none
+typedef int (*sim_transceive_cb_t)(unsigned char *buf, int len);
+
+void sim_io_init(void);
+ssize_t sim_read(int fd, void *buf, size_t len);
+ssize_t sim_write(int fd, const void *buf, size_t len);
+
+// fdp is read on every report, so a simulator may reopen its port
+void sim_transceive(int *fdp, sim_transceive_cb_t cb);
+
+#endif // _SIM_IO_H
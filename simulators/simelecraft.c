@@ -7,11 +7,13 @@
 #include <string.h>
 #include <unistd.h>
 #include <hamlib/rig.h>
+#include "sim_io.h"
 
 #define BUFSIZE 256
 
 float freqA = 14074000;
 float freqB = 14074500;
+int freqa = 14074000, freqb = 14073500;
 
 // ID 0310 == 310, Must drop leading zero
 typedef enum nc_rigid_e
@@ -41,7 +43,7 @@ getmyline(int fd, char *buf)
     int i = 0;
     memset(buf, 0, BUFSIZE);
 
-    while (read(fd, &c, 1) > 0)
+    while (sim_read(fd, &c, 1) > 0)
     {
         buf[i++] = c;
 
@@ -78,6 +80,7 @@ int openPort(char *comport) // doesn't matter for using pts devices
     }
 
     printf("name=%s\n", name);
+    fflush(stdout);     // scripts wait for this line
 
     if (fd == -1 || grantpt(fd) == -1 || unlockpt(fd) == -1)
     {
@@ -91,14 +94,23 @@ int openPort(char *comport) // doesn't matter for using pts devices
 
 
 
+// FA report a rig in auto information mode sends when the VFO moves
+int transceive(unsigned char *buf, int len)
+{
+    return snprintf((char *)buf, len, "FA%011d;", freqa);
+}
+
 int main(int argc, char *argv[])
 {
     char buf[256];
     char *pbuf;
     int n;
-    int fd = openPort(argv[1]);
+    int fd;
     int modea, modeb = 0;
-    int freqa = 14074000, freqb = 14073500;
+
+    sim_io_init();
+    fd = openPort(argv[1]);
+    sim_transceive(&fd, transceive);
 
     while (1)
     {
@@ -112,7 +124,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "RM5100000;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             printf("n=%d\n", n);
 
             if (n <= 0) { perror("RM5"); }
@@ -123,7 +135,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "AN030;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             printf("n=%d\n", n);
 
             if (n <= 0) { perror("AN"); }
@@ -133,7 +145,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "IF059014200000+000000700000;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             printf("n=%d\n", n);
 
             if (n <= 0) { perror("IF"); }
@@ -144,7 +156,7 @@ int main(int argc, char *argv[])
             usleep(50 * 1000);
             int id = 24;
             SNPRINTF(buf, sizeof(buf), "ID%03d;", id);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
             printf("n=%d\n", n);
 
             if (n <= 0) { perror("ID"); }
@@ -170,7 +182,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "VS0;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             printf("n=%d\n", n);
 
             if (n < 0) { perror("VS"); }
@@ -182,7 +194,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             SNPRINTF(buf, sizeof(buf), "EX032%1d;", ant);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
             printf("n=%d\n", n);
 
             if (n < 0) { perror("EX032"); }
@@ -192,36 +204,36 @@ int main(int argc, char *argv[])
             // KPA3 SNPRINTF(buf, sizeof(buf), "OM AP----L-----;");
             // K4+KPA3
             SNPRINTF(buf, sizeof(buf), "OM AP-S----4---;");
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
             printf("n=%d\n", n);
 
             if (n < 0) { perror("OM"); }
         }
         else if (strcmp(buf, "K2;") == 0)
         {
-            write(fd, "K20;", 4);
+            sim_write(fd, "K20;", 4);
         }
         else if (strcmp(buf, "K3;") == 0)
         {
-            write(fd, "K30;", 4);
+            sim_write(fd, "K30;", 4);
         }
         else if (strcmp(buf, "RVM;") == 0)
         {
-            write(fd, "RV02.37;", 8);
+            sim_write(fd, "RV02.37;", 8);
         }
         else if (strcmp(buf, "AI;") == 0)
         {
-            write(fd, "AI0;", 4);
+            sim_write(fd, "AI0;", 4);
         }
         else if (strcmp(buf, "MD;") == 0)
         {
             SNPRINTF(buf, sizeof(buf), "MD%d;", modea);
-            write(fd, buf, strlen(buf));
+            sim_write(fd, buf, strlen(buf));
         }
         else if (strcmp(buf, "MD$;") == 0)
         {
             SNPRINTF(buf, sizeof(buf), "MD$%d;", modeb);
-            write(fd, buf, strlen(buf));
+            sim_write(fd, buf, strlen(buf));
         }
         else if (strncmp(buf, "MD", 2) == 0)
         {
@@ -231,12 +243,12 @@ int main(int argc, char *argv[])
         else if (strcmp(buf, "FA;") == 0)
         {
             SNPRINTF(buf, sizeof(buf), "FA%011d;", freqa);
-            write(fd, buf, strlen(buf));
+            sim_write(fd, buf, strlen(buf));
         }
         else if (strcmp(buf, "FB;") == 0)
         {
             SNPRINTF(buf, sizeof(buf), "FB%011d;", freqb);
-            write(fd, buf, strlen(buf));
+            sim_write(fd, buf, strlen(buf));
         }
 
         else if (strncmp(buf, "FA", 2) == 0)
@@ -250,17 +262,17 @@ int main(int argc, char *argv[])
         else if (strncmp(buf, "FR;", 3) == 0)
         {
             SNPRINTF(buf, sizeof(buf), "FR0;");
-            write(fd, buf, strlen(buf));
+            sim_write(fd, buf, strlen(buf));
         }
         else if (strncmp(buf, "FT;", 3) == 0)
         {
             SNPRINTF(buf, sizeof(buf), "FT0;");
-            write(fd, buf, strlen(buf));
+            sim_write(fd, buf, strlen(buf));
         }
         else if (strncmp(buf, "TQ;", 3) == 0)
         {
             SNPRINTF(buf, sizeof(buf), "TQ0;");
-            write(fd, buf, strlen(buf));
+            sim_write(fd, buf, strlen(buf));
         }
         else if (strlen(buf) > 0)
         {
@@ -86,6 +86,7 @@ int openPort(char *comport) // doesn't matter for using pts devices
     }
 
     printf("name=%s\n", name);
+    fflush(stdout);     // scripts wait for this line
 
     if (fd == -1 || grantpt(fd) == -1 || unlockpt(fd) == -1)
     {
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <unistd.h>
 #include "../include/hamlib/rig.h"
+#include "sim_io.h"
 
 #define BUFSIZE 256
 
@@ -41,7 +42,7 @@ getmyline(int fd, char *buf)
     int i = 0;
     memset(buf, 0, BUFSIZE);
 
-    while (read(fd, &c, 1) > 0)
+    while (sim_read(fd, &c, 1) > 0)
     {
         buf[i++] = c;
 
@@ -78,6 +79,7 @@ int openPort(char *comport) // doesn't matter for using pts devices
     }
 
     printf("name=%s\n", name);
+    fflush(stdout);     // scripts wait for this line
 
     if (fd == -1 || grantpt(fd) == -1 || unlockpt(fd) == -1)
     {
@@ -90,13 +92,22 @@ int openPort(char *comport) // doesn't matter for using pts devices
 #endif
 
 
+// FA report a rig in auto information mode sends when the VFO moves
+int transceive(unsigned char *buf, int len)
+{
+    return snprintf((char *)buf, len, "FA%09.0f;", freqA);
+}
 
 int main(int argc, char *argv[])
 {
     char buf[256];
     char *pbuf;
     int n;
-    int fd = openPort(argv[1]);
+    int fd;
+
+    sim_io_init();
+    fd = openPort(argv[1]);
+    sim_transceive(&fd, transceive);
 
     while (1)
     {
@@ -111,18 +122,29 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "RM5100000;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             printf("n=%d\n", n);
 
             if (n <= 0) { perror("RM5"); }
         }
+        else if (strlen(buf) == 4 && strncmp(buf, "RM", 2) == 0
+                 && strchr("3467", buf[2]))
+        {
+            char rbuf[32];
+
+            usleep(10 * 1000);
+            SNPRINTF(rbuf, sizeof(rbuf), "RM%c%03d000;", buf[2], buf[2] * 10 % 256);
+            n = sim_write(fd, rbuf, strlen(rbuf));
+
+            if (n <= 0) { perror("RM"); }
+        }
 
         if (strcmp(buf, "AN0;") == 0)
         {
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "AN030;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             printf("n=%d\n", n);
 
             if (n <= 0) { perror("AN"); }
@@ -132,7 +154,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "IF059014200000+000000700000;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             printf("n=%d\n", n);
 
             if (n <= 0) { perror("IF"); }
@@ -143,7 +165,7 @@ int main(int argc, char *argv[])
             usleep(50 * 1000);
             int id = NC_RIGID_FTDX3000;
             SNPRINTF(buf, sizeof(buf), "ID%03d;", id);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
             printf("n=%d\n", n);
 
             if (n <= 0) { perror("ID"); }
@@ -153,7 +175,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             SNPRINTF(buf, sizeof(buf), "AI0;");
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
             printf("n=%d\n", n);
 
             if (n <= 0) { perror("ID"); }
@@ -179,11 +201,48 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "VS0;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             printf("n=%d\n", n);
 
             if (n < 0) { perror("VS"); }
         }
+        /* no delay on these so newcat_bench times the host side */
+        else if (strcmp(buf, "FA;") == 0)
+        {
+            SNPRINTF(buf, sizeof(buf), "FA%09.0f;", freqA);
+            n = sim_write(fd, buf, strlen(buf));
+
+            if (n <= 0) { perror("FA"); }
+        }
+        else if (strcmp(buf, "FB;") == 0)
+        {
+            SNPRINTF(buf, sizeof(buf), "FB%09.0f;", freqB);
+            n = sim_write(fd, buf, strlen(buf));
+
+            if (n <= 0) { perror("FB"); }
+        }
+        else if (strncmp(buf, "FA", 2) == 0)
+        {
+            sscanf(buf, "FA%f", &freqA);
+        }
+        else if (strncmp(buf, "FB", 2) == 0)
+        {
+            sscanf(buf, "FB%f", &freqB);
+        }
+        else if (strcmp(buf, "SH0;") == 0)
+        {
+            pbuf = "SH000;";
+            n = sim_write(fd, pbuf, strlen(pbuf));
+
+            if (n <= 0) { perror("SH0"); }
+        }
+        else if (strcmp(buf, "MD0;") == 0)
+        {
+            pbuf = "MD02;";
+            n = sim_write(fd, pbuf, strlen(pbuf));
+
+            if (n <= 0) { perror("MD0"); }
+        }
         else if (strcmp(buf, "EX032;") == 0)
         {
             static int ant = 0;
@@ -191,7 +250,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             SNPRINTF(buf, sizeof(buf), "EX032%1d;", ant);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
             printf("n=%d\n", n);
 
             if (n < 0) { perror("EX032"); }
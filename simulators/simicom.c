@@ -13,6 +13,7 @@
 #include <sys/time.h>
 #include <hamlib/rig.h>
 #include "../src/misc.h"
+#include "sim_io.h"
 
 #define BUFSIZE 256
 #define X25
@@ -33,6 +34,7 @@ pbwidth_t widthB = 1;
 ant_t ant_curr = 0;
 int ant_option = 0;
 int ptt = 0;
+unsigned char civ_addr = 0x94;
 
 void dumphex(unsigned char *buf, int n)
 {
@@ -48,7 +50,7 @@ frameGet(int fd, unsigned char *buf)
     memset(buf, 0, BUFSIZE);
     unsigned char c;
 
-    while (read(fd, &c, 1) > 0)
+    while (sim_read(fd, &c, 1) > 0)
     {
         buf[i++] = c;
         //printf("i=%d, c=0x%02x\n",i,c);
@@ -78,6 +80,15 @@ void frameParse(int fd, unsigned char *frame, int len)
         return;
     }
 
+    // answer from the rig to the controller, as a real rig does
+    {
+        unsigned char to = frame[2];
+
+        frame[2] = frame[3];
+        frame[3] = to;
+        civ_addr = frame[3];
+    }
+
     switch (frame[4])
     {
     case 0x03:
@@ -95,7 +106,7 @@ void frameParse(int fd, unsigned char *frame, int len)
         }
 
         frame[10] = 0xfd;
-        write(fd, frame, 11);
+        sim_write(fd, frame, 11);
         break;
 
     case 0x04:
@@ -113,7 +124,7 @@ void frameParse(int fd, unsigned char *frame, int len)
         }
 
         frame[7] = 0xfd;
-        write(fd, frame, 8);
+        sim_write(fd, frame, 8);
         break;
 
     case 0x05:
@@ -125,7 +136,7 @@ void frameParse(int fd, unsigned char *frame, int len)
 
         frame[4] = 0xfb;
         frame[5] = 0xfd;
-        write(fd, frame, 6);
+        sim_write(fd, frame, 6);
         break;
 
     case 0x06:
@@ -134,7 +145,7 @@ void frameParse(int fd, unsigned char *frame, int len)
 
         frame[4] = 0xfb;
         frame[5] = 0xfd;
-        write(fd, frame, 6);
+        sim_write(fd, frame, 6);
         break;
 
     case 0x07:
@@ -154,7 +165,7 @@ void frameParse(int fd, unsigned char *frame, int len)
 
         frame[4] = 0xfb;
         frame[5] = 0xfd;
-        write(fd, frame, 6);
+        sim_write(fd, frame, 6);
         break;
 
     case 0x0f:
@@ -164,7 +175,7 @@ void frameParse(int fd, unsigned char *frame, int len)
         printf("set split %d\n", 1);
         frame[4] = 0xfb;
         frame[5] = 0xfd;
-        write(fd, frame, 6);
+        sim_write(fd, frame, 6);
         break;
 
     case 0x12: // we're simulating the 3-byte version -- not the 2-byte
@@ -185,7 +196,7 @@ void frameParse(int fd, unsigned char *frame, int len)
         frame[7] = 0xfd;
         printf("write 8 bytes\n");
         dump_hex(frame, 8);
-        write(fd, frame, 8);
+        sim_write(fd, frame, 8);
         break;
 
     case 0x14:
@@ -201,7 +212,7 @@ void frameParse(int fd, unsigned char *frame, int len)
 
             to_bcd(&frame[6], (long long)power_level, 2);
             frame[8] = 0xfd;
-            write(fd, frame, 9);
+            sim_write(fd, frame, 9);
             break;
         }
 
@@ -220,7 +231,7 @@ void frameParse(int fd, unsigned char *frame, int len)
 
             to_bcd(&frame[6], (long long)meter_level, 2);
             frame[8] = 0xfd;
-            write(fd, frame, 9);
+            sim_write(fd, frame, 9);
             break;
         }
 
@@ -234,20 +245,20 @@ void frameParse(int fd, unsigned char *frame, int len)
             else { frame[6] = widthB; }
 
             frame[7] = 0xfd;
-            write(fd, frame, 8);
+            sim_write(fd, frame, 8);
             break;
 
         case 0x04: // IC7200 data mode
             frame[6] = 0;
             frame[7] = 0;
             frame[8] = 0xfd;
-            write(fd, frame, 9);
+            sim_write(fd, frame, 9);
             break;
 
         case 0x07: // satmode
             frame[6] = 0;
             frame[7] = 0xfd;
-            write(fd, frame, 8);
+            sim_write(fd, frame, 8);
             break;
 
         }
@@ -262,14 +273,14 @@ void frameParse(int fd, unsigned char *frame, int len)
             {
                 frame[6] = ptt;
                 frame[7] = 0xfd;
-                write(fd, frame, 8);
+                sim_write(fd, frame, 8);
             }
             else
             {
                 ptt = frame[6];
                 frame[7] = 0xfb;
                 frame[8] = 0xfd;
-                write(fd, frame, 9);
+                sim_write(fd, frame, 9);
             }
 
             break;
@@ -296,7 +307,7 @@ void frameParse(int fd, unsigned char *frame, int len)
             }
 
             frame[11] = 0xfd;
-            write(fd, frame, 12);
+            sim_write(fd, frame, 12);
         }
         else
         {
@@ -308,7 +319,7 @@ void frameParse(int fd, unsigned char *frame, int len)
 
             frame[4] = 0xfb;
             frame[5] = 0xfd;
-            write(fd, frame, 6);
+            sim_write(fd, frame, 6);
         }
 
         break;
@@ -324,7 +335,7 @@ void frameParse(int fd, unsigned char *frame, int len)
             frame[7] = frame[5] == 0 ? datamodeA : datamodeB;
             frame[8] = 0xfb;
             frame[9] = 0xfd;
-            write(fd, frame, 10);
+            sim_write(fd, frame, 10);
         }
         else
         {
@@ -343,7 +354,7 @@ void frameParse(int fd, unsigned char *frame, int len)
 
             frame[4] = 0xfb;
             frame[5] = 0xfd;
-            write(fd, frame, 6);
+            sim_write(fd, frame, 6);
         }
 
         printf("\n");
@@ -395,6 +406,7 @@ int openPort(char *comport) // doesn't matter for using pts devices
     }
 
     printf("name=%s\n", name);
+    fflush(stdout);     // scripts wait for this line
 
     if (fd == -1 || grantpt(fd) == -1 || unlockpt(fd) == -1)
     {
@@ -420,10 +432,29 @@ void rigStatus()
            freqB);
 }
 
+// frequency broadcast a rig with CI-V transceive on sends when the VFO moves
+int transceive(unsigned char *buf, int len)
+{
+    buf[0] = 0xfe;
+    buf[1] = 0xfe;
+    buf[2] = 0x00;
+    buf[3] = civ_addr;
+    buf[4] = 0x00;
+    to_bcd(&buf[5], (long long)(current_vfo == RIG_VFO_B ? freqB : freqA),
+           (civ_731_mode ? 4 : 5) * 2);
+    buf[civ_731_mode ? 9 : 10] = 0xfd;
+
+    return civ_731_mode ? 10 : 11;
+}
+
 int main(int argc, char **argv)
 {
     unsigned char buf[256];
-    int fd = openPort(argv[1]);
+    int fd;
+
+    sim_io_init();
+    fd = openPort(argv[1]);
+    sim_transceive(&fd, transceive);
 
     printf("%s: %s\n", argv[0], rig_version());
 #ifdef X25
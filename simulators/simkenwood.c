@@ -7,11 +7,13 @@
 #include <string.h>
 #include <unistd.h>
 #include <hamlib/rig.h>
+#include "sim_io.h"
 
 #define BUFSIZE 256
 
 float freqA = 14074000;
 float freqB = 14074500;
+int freqa = 14074000, freqb = 140735000;
 int filternum = 7;
 int datamode = 0;
 int ptt, ptt_data, ptt_mic, ptt_tune;
@@ -44,7 +46,7 @@ getmyline(int fd, char *buf)
     int i = 0;
     memset(buf, 0, BUFSIZE);
 
-    while (read(fd, &c, 1) > 0)
+    while (sim_read(fd, &c, 1) > 0)
     {
         buf[i++] = c;
 
@@ -81,6 +83,7 @@ int openPort(char *comport) // doesn't matter for using pts devices
     }
 
     printf("name=%s\n", name);
+    fflush(stdout);     // scripts wait for this line
 
     if (fd == -1 || grantpt(fd) == -1 || unlockpt(fd) == -1)
     {
@@ -94,15 +97,24 @@ int openPort(char *comport) // doesn't matter for using pts devices
 
 
 
+// FA report a rig in auto information mode sends when the VFO moves
+int transceive(unsigned char *buf, int len)
+{
+    return snprintf((char *)buf, len, "FA%011d;", freqa);
+}
+
 int main(int argc, char *argv[])
 {
     char buf[256];
     char *pbuf;
     int n;
-    int fd = openPort(argv[1]);
-    int freqa = 14074000, freqb = 140735000;
+    int fd;
     int modeA = 0; // , modeB = 0;
 
+    sim_io_init();
+    fd = openPort(argv[1]);
+    sim_transceive(&fd, transceive);
+
     while (1)
     {
         buf[0] = 0;
@@ -115,7 +127,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "RM5100000;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
 //            printf("n=%d\n", n);
 
             if (n <= 0) { perror("RM5"); }
@@ -126,7 +138,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "AN030;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
 //            printf("n=%d\n", n);
 
             if (n <= 0) { perror("AN"); }
@@ -137,7 +149,7 @@ int main(int argc, char *argv[])
             usleep(50 * 1000);
             pbuf = "IF000503130001000+0000000000030000000;";
             //pbuf = "IF00010138698     +00000000002000000 ;
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
 //            printf("n=%d\n", n);
 
             if (n <= 0) { perror("IF"); }
@@ -146,7 +158,7 @@ int main(int argc, char *argv[])
         {
             usleep(50 * 1000);
             pbuf = "FW2400;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
         }
         else if (strcmp(buf, "ID;") == 0)
         {
@@ -154,7 +166,7 @@ int main(int argc, char *argv[])
             usleep(50 * 1000);
             int id = 24;
             SNPRINTF(buf, sizeof(buf), "ID%03d;", id);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
 //            printf("n=%d\n", n);
 
             if (n <= 0) { perror("ID"); }
@@ -180,7 +192,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "VS0;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
 //            printf("n=%d\n", n);
 
             if (n < 0) { perror("VS"); }
@@ -192,7 +204,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             SNPRINTF(buf, sizeof(buf), "EX032%1d;", ant);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
 //            printf("n=%d\n", n);
 
             if (n < 0) { perror("EX032"); }
@@ -200,12 +212,12 @@ int main(int argc, char *argv[])
         else if (strcmp(buf, "FA;") == 0)
         {
             SNPRINTF(buf, sizeof(buf), "FA%011d;", freqa);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strcmp(buf, "FB;") == 0)
         {
             SNPRINTF(buf, sizeof(buf), "FA%011d;", freqa);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strncmp(buf, "FA", 2) == 0)
         {
@@ -218,18 +230,18 @@ int main(int argc, char *argv[])
         else if (strncmp(buf, "AI;", 3) == 0)
         {
             SNPRINTF(buf, sizeof(buf), "AI0;");
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strncmp(buf, "SA;", 3) == 0)
         {
             SNPRINTF(buf, sizeof(buf), "SA0;");
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strncmp(buf, "MD;", 3) == 0)
         {
             SNPRINTF(buf, sizeof(buf), "MD%d;",
                      modeA); // not worried about modeB yet for simulator
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strncmp(buf, "MD", 2) == 0)
         {
@@ -238,7 +250,7 @@ int main(int argc, char *argv[])
         else if (strncmp(buf, "FL;", 3) == 0)
         {
             SNPRINTF(buf, sizeof(buf), "FL%03d;", filternum);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strncmp(buf, "FL", 2) == 0)
         {
@@ -247,7 +259,7 @@ int main(int argc, char *argv[])
         else if (strncmp(buf, "DA;", 3) == 0)
         {
             SNPRINTF(buf, sizeof(buf), "DA%d;", datamode);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strncmp(buf, "DA", 2) == 0)
         {
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <hamlib/rig.h>
+#include "sim_io.h"
 
 #define BUFSIZE 256
 
@@ -53,7 +54,7 @@ getmyline(int fd, char *buf)
     int i = 0;
     memset(buf, 0, BUFSIZE);
 
-    while (read(fd, &c, 1) > 0)
+    while (sim_read(fd, &c, 1) > 0)
     {
         buf[i++] = c;
 
@@ -90,6 +91,7 @@ int openPort(char *comport) // doesn't matter for using pts devices
     }
 
     printf("name=%s\n", name);
+    fflush(stdout);     // scripts wait for this line
 
     if (fd == -1 || grantpt(fd) == -1 || unlockpt(fd) == -1)
     {
@@ -102,6 +104,11 @@ int openPort(char *comport) // doesn't matter for using pts devices
 #endif
 
 
+// FA report a rig in auto information mode sends when the VFO moves
+int transceive(unsigned char *buf, int len)
+{
+    return snprintf((char *)buf, len, "FA%08.0f;", freqA);
+}
 
 int main(int argc, char *argv[])
 {
@@ -109,7 +116,11 @@ int main(int argc, char *argv[])
     char resp[256];
     char *pbuf;
     int n;
-    int fd = openPort(argv[1]);
+    int fd;
+
+    sim_io_init();
+    fd = openPort(argv[1]);
+    sim_transceive(&fd, transceive);
 
     while (1)
     {
@@ -129,7 +140,7 @@ int main(int argc, char *argv[])
         if (strcmp(buf, "PS;") == 0)
         {
             sprintf(resp, "PS%d;", power);
-            n = write(fd, resp, strlen(resp));
+            n = sim_write(fd, resp, strlen(resp));
 
             if (n <= 0) { perror("PS"); }
         }
@@ -142,7 +153,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "RM5100000;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             //printf("n=%d\n", n);
 
             if (n <= 0) { perror("RM5"); }
@@ -152,7 +163,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "RM8197000;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             //printf("n=%d\n", n);
 
             if (n <= 0) { perror("RM8"); }
@@ -162,7 +173,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "RM9089000;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             //printf("n=%d\n", n);
 
             if (n <= 0) { perror("RM9"); }
@@ -173,7 +184,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "AN030;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             //printf("n=%d\n", n);
 
             if (n <= 0) { perror("AN"); }
@@ -183,7 +194,7 @@ int main(int argc, char *argv[])
             //SNPRINTF(resp, sizeof(resp), "FA%010.0f;", freqA);
             SNPRINTF(resp, sizeof(resp), "FA%08.0f;", freqA);
             freqA += 10;
-            n = write(fd, resp, strlen(resp));
+            n = sim_write(fd, resp, strlen(resp));
         }
         else if (strncmp(buf, "FA", 2) == 0)
         {
@@ -193,7 +204,7 @@ int main(int argc, char *argv[])
         {
             //SNPRINTF(resp, sizeof(resp), "FB%0010.0f;", freqB);
             SNPRINTF(resp, sizeof(resp), "FB%08.0f;", freqB);
-            n = write(fd, resp, strlen(resp));
+            n = sim_write(fd, resp, strlen(resp));
         }
         else if (strncmp(buf, "FA", 2) == 0)
         {
@@ -202,7 +213,7 @@ int main(int argc, char *argv[])
         else if (strcmp(buf, "FB;") == 0)
         {
             SNPRINTF(resp, sizeof(resp), "FB%010.0f;", freqB);
-            n = write(fd, resp, strlen(resp));
+            n = sim_write(fd, resp, strlen(resp));
         }
         else if (strncmp(buf, "FB", 2) == 0)
         {
@@ -213,7 +224,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             pbuf = "IF00107041000+000000200000;";
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             //printf("n=%d\n", n);
 
             if (n <= 0) { perror("IF"); }
@@ -224,7 +235,7 @@ int main(int argc, char *argv[])
             usleep(50 * 1000);
             int id = NC_RIGID_FTDX3000DM;
             SNPRINTF(buf, sizeof(buf), "ID%03d;", id);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
             //printf("n=%d\n", n);
 
             if (n <= 0) { perror("ID"); }
@@ -234,7 +245,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             SNPRINTF(buf, sizeof(buf), "AI0;");
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
             //printf("n=%d\n", n);
 
             if (n <= 0) { perror("ID"); }
@@ -277,7 +288,7 @@ int main(int argc, char *argv[])
 
             if (curr_vfo == RIG_VFO_B || curr_vfo == RIG_VFO_SUB) { pbuf[2] = '1'; }
 
-            n = write(fd, pbuf, strlen(pbuf));
+            n = sim_write(fd, pbuf, strlen(pbuf));
             printf("%s\n", pbuf);
 
             if (n < 0) { perror("VS"); }
@@ -287,7 +298,7 @@ int main(int argc, char *argv[])
             usleep(50 * 1000);
             SNPRINTF(resp, sizeof(resp), "FT%c;", tx_vfo);
             printf(" FT response#1=%s, tx_vfo=%c\n", resp, tx_vfo);
-            n = write(fd, resp, strlen(resp));
+            n = sim_write(fd, resp, strlen(resp));
             printf(" FT response#2=%s\n", resp);
 
             if (n < 0) { perror("FT"); }
@@ -304,7 +315,7 @@ int main(int argc, char *argv[])
         {
             usleep(50 * 1000);
             SNPRINTF(resp, sizeof(resp), "MD0%c;", modeA);
-            n = write(fd, resp, strlen(resp));
+            n = sim_write(fd, resp, strlen(resp));
 
             if (n < 0) { perror("MD0;"); }
         }
@@ -316,7 +327,7 @@ int main(int argc, char *argv[])
         {
             usleep(50 * 1000);
             SNPRINTF(resp, sizeof(resp), "MD1%c;", modeB);
-            n = write(fd, resp, strlen(resp));
+            n = sim_write(fd, resp, strlen(resp));
 
             if (n < 0) { perror("MD0;"); }
         }
@@ -328,7 +339,7 @@ int main(int argc, char *argv[])
         {
             usleep(50 * 1000);
             SNPRINTF(resp, sizeof(resp), "SM0111;");
-            n = write(fd, resp, strlen(resp));
+            n = sim_write(fd, resp, strlen(resp));
 
             if (n < 0) { perror("SM"); }
         }
@@ -336,7 +347,7 @@ int main(int argc, char *argv[])
         {
             usleep(50 * 1000);
             SNPRINTF(resp, sizeof(resp), "TX%d;", ptt);
-            n = write(fd, resp, strlen(resp));
+            n = sim_write(fd, resp, strlen(resp));
 
             if (n < 0) { perror("TX"); }
         }
@@ -352,7 +363,7 @@ int main(int argc, char *argv[])
             printf("%s\n", buf);
             usleep(50 * 1000);
             SNPRINTF(buf, sizeof(buf), "EX032%1d;", ant);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
             //printf("n=%d\n", n);
 
             if (n < 0) { perror("EX032"); }
@@ -361,39 +372,39 @@ int main(int argc, char *argv[])
         {
             SNPRINTF(buf, sizeof(buf), "NA00;");
             usleep(50 * 1000);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
             //printf("%s n=%d\n", buf, n);
         }
         else if (strcmp(buf, "RF0;") == 0)
         {
             SNPRINTF(buf, sizeof(buf), "RF0%d;", roofing_filter_main);
             usleep(50 * 1000);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strcmp(buf, "RF1;") == 0)
         {
             SNPRINTF(buf, sizeof(buf), "RF1%d;", roofing_filter_sub);
             usleep(50 * 1000);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strncmp(buf, "RF", 2) == 0)
         {
             SNPRINTF(buf, sizeof(buf), "RF%c%d;", buf[2],
                      buf[2] == 0 ? roofing_filter_main : roofing_filter_sub);
             usleep(50 * 1000);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strcmp(buf, "SH0;") == 0)
         {
             SNPRINTF(buf, sizeof(buf), "SH%c%02d;", buf[2], width_main);
             usleep(50 * 1000);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strcmp(buf, "SH1;") == 0)
         {
             SNPRINTF(buf, sizeof(buf), "SH%c%02d;", buf[2], width_sub);
             usleep(50 * 1000);
-            n = write(fd, buf, strlen(buf));
+            n = sim_write(fd, buf, strlen(buf));
         }
         else if (strncmp(buf, "SH", 2) == 0 && strlen(buf) > 4)
         {
@@ -25,21 +25,71 @@ LOCAL_SRC_FILES := \
         network.c \
         sleep.c \
         gpio.c \
+        ioevent.c \
+        stats.c \
+        rigqueue.c \
+        spectrum_pool.c \
+        spectrum_proc.c \
+        spectrum_history.c \
         microham.c \
         rot_ext.c \
         cm108.c \
-        sprintflst.c
+        sprintflst.c \
+        rot_track.c \
+        usb_port.c \
+        dcd_watch.c \
+        keyer.c \
+        morse_queue.c \
+        metrics.c \
+        trace.c \
+        capture.c \
+        amplifier.c \
+        amp_reg.c \
+        amp_conf.c \
+        amp_settings.c \
+        extamp.c \
+        cache.c \
+        rigfacts.c \
+        clone.c \
+        chanset.c \
+        chancache.c \
+        swscan.c \
+        sweep.c \
+        snapshot_data.c \
+        station.c \
+        band_follow.c \
+        doppler.c \
+        vfo_plan.c \
+        conf_index.c \
+        caps_index.c \
+        caps_json.c \
+        async_dispatch.c \
+        shmcache.c \
+        journal.c \
+        rto.c \
+        deadline.c \
+        riginfo.c \
+        rig_lock.c \
+        executor.c \
+        spscring.c \
+        thread_sched.c \
+        usb_ident.c \
+        rig_follow.c
 
 
+# rig backends of the build profile, see HAMLIB_RIG_BACKENDS in ../Android.mk;
+# register.c leaves the others out through HAMLIB_SKIP_RIG_<NAME>
+HAMLIB_UC = $(subst a,A,$(subst b,B,$(subst c,C,$(subst d,D,$(subst e,E,$(subst f,F,$(subst g,G,$(subst h,H,$(subst i,I,$(subst j,J,$(subst k,K,$(subst l,L,$(subst m,M,$(subst n,N,$(subst o,O,$(subst p,P,$(subst q,Q,$(subst r,R,$(subst s,S,$(subst t,T,$(subst u,U,$(subst v,V,$(subst w,W,$(subst x,X,$(subst y,Y,$(subst z,Z,$(1)))))))))))))))))))))))))))
+HAMLIB_RIG_SKIP := $(filter-out dummy $(HAMLIB_RIG_BACKENDS),$(HAMLIB_ALL_RIG_BACKENDS))
+
 LOCAL_MODULE := libhamlib
-LOCAL_CFLAGS := 
+LOCAL_CFLAGS := -DHAMLIB_DEBUG_LEVEL_MAX=$(HAMLIB_DEBUG_LEVEL) \
+        $(foreach be,$(HAMLIB_RIG_SKIP),-DHAMLIB_SKIP_RIG_$(call HAMLIB_UC,$(be)))
 LOCAL_C_INCLUDES := android include
-LOCAL_STATIC_LIBRARIES := adat alinco amsat aor ars barrett celestron cnctrk \
-        dorji drake dummy easycomm elad ether6 flexradio fodtrack \
-        gs232a heathkit icmarine icom ioptron jrc kachina kenwood kit \
-        lowe m2 meade pcr prm80 prosistel racal rft \
-        rotorez rs sartek satel skanti spid tapr tentec ts7400 tuner \
-        uniden wj yaesu radant androidsensor
+LOCAL_STATIC_LIBRARIES := $(sort dummy $(filter $(HAMLIB_ALL_RIG_BACKENDS),$(HAMLIB_RIG_BACKENDS))) \
+        amsat ars celestron cnctrk easycomm ether6 fodtrack \
+        gs232a heathkit ioptron m2 meade prosistel \
+        rotorez sartek satel spid ts7400 radant androidsensor
 
 LOCAL_LDLIBS := -llog -landroid
 
@@ -41,6 +41,7 @@
 
 #include "amp_conf.h"
 #include "token.h"
+#include "conf_index.h"
 
 
 /*
@@ -71,6 +72,16 @@ static const struct confparams ampfrontend_cfg_params[] =
         TOK_RETRY, "retry", "Retry", "Max number of retry",
         "0", RIG_CONF_NUMERIC, { .n = { 0, 10, 1 } }
     },
+    {
+        TOK_AMP_CACHE_TIMEOUT, "cache_timeout", "Cache timeout",
+        "How long in ms a level, frequency or power status reading is reused, 0 always asks the amplifier unless polled",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 60000, 1 } }
+    },
+    {
+        TOK_AMP_POLL_INTERVAL, "poll_interval", "Poll interval",
+        "Delay in ms between two queries of the background poller, 0 for no poller",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 10000, 1 } }
+    },
 
     { RIG_CONF_END, NULL, }
 };
@@ -187,6 +198,25 @@ int frontamp_set_conf(AMP *amp, token_t token, const char *val)
         rs->ampport_deprecated.retry = val_i;
         break;
 
+    case TOK_AMP_CACHE_TIMEOUT:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL;
+        }
+
+        rs->cache.timeout_ms = val_i;
+        break;
+
+    case TOK_AMP_POLL_INTERVAL:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL;
+        }
+
+        /* taken into account by the next amp_open() */
+        rs->cache.poll_ms = val_i;
+        break;
+
     case TOK_SERIAL_SPEED:
         if (rs->ampport.type.rig != RIG_PORT_SERIAL)
         {
@@ -369,6 +399,14 @@ int frontamp_get_conf2(AMP *amp, token_t token, char *val, int val_len)
         SNPRINTF(val, val_len, "%d", rs->ampport.retry);
         break;
 
+    case TOK_AMP_CACHE_TIMEOUT:
+        SNPRINTF(val, val_len, "%d", rs->cache.timeout_ms);
+        break;
+
+    case TOK_AMP_POLL_INTERVAL:
+        SNPRINTF(val, val_len, "%d", rs->cache.poll_ms);
+        break;
+
     case TOK_SERIAL_SPEED:
         if (rs->ampport.type.rig != RIG_PORT_SERIAL)
         {
@@ -572,6 +610,20 @@ const struct confparams *HAMLIB_API amp_confparam_lookup(AMP *amp,
     /* 0 returned for invalid format */
     token = strtol(name, NULL, 0);
 
+    if (amp->state.conf_index)
+    {
+        const struct conf_index *idx = amp->state.conf_index;
+
+        cfp = conf_index_name(idx, name);
+
+        if (!cfp && token != RIG_CONF_END)
+        {
+            cfp = conf_index_token(idx, token);
+        }
+
+        return cfp;
+    }
+
     for (cfp = amp->caps->cfgparams; cfp && cfp->name; cfp++)
     {
         if (!strcmp(cfp->name, name) || token == cfp->token)
@@ -634,6 +686,48 @@ token_t HAMLIB_API amp_token_lookup(AMP *amp, const char *name)
 }
 
 
+/* Hash the tables amp_confparam_lookup() and amp_ext_lookup() scan, in
+ * the order they scan them.  Without the index they scan as before. */
+void amp_conf_index_init(AMP *amp)
+{
+    struct amp_state *rs = &amp->state;
+    const struct confparams *conf[3];
+    const struct confparams *ext[2];
+    int n = 0;
+
+    conf[n++] = amp->caps->cfgparams;
+    conf[n++] = ampfrontend_cfg_params;
+
+    if (amp->caps->port_type == RIG_PORT_SERIAL)
+    {
+        conf[n++] = ampfrontend_serial_cfg_params;
+    }
+
+    rs->conf_index = conf_index_new(conf, n);
+
+    ext[0] = amp->caps->extlevels;
+    ext[1] = amp->caps->extparms;
+    rs->ext_index = conf_index_new(ext, 2);
+
+    if (!rs->conf_index || !rs->ext_index)
+    {
+        amp_debug(RIG_DEBUG_WARN, "%s: no memory, linear lookups\n", __func__);
+        amp_conf_index_cleanup(amp);
+    }
+}
+
+
+void amp_conf_index_cleanup(AMP *amp)
+{
+    struct amp_state *rs = &amp->state;
+
+    conf_index_free(rs->conf_index);
+    conf_index_free(rs->ext_index);
+    rs->conf_index = NULL;
+    rs->ext_index = NULL;
+}
+
+
 /**
  * \brief Set an amplifier configuration parameter.
  *
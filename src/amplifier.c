@@ -62,6 +62,9 @@
 #include "usb_port.h"
 #include "network.h"
 #include "token.h"
+#include "misc.h"
+#include "band_follow.h"
+#include "conf_index.h"
 
 //! @cond Doxygen_Suppress
 #define CHECK_AMP_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
@@ -130,6 +133,347 @@ static int remove_opened_amp(const AMP *amp)
 }
 
 
+/*
+ * Level, frequency and power status cache.  A reader that misses holds
+ * state.lock while it asks the amplifier, and anyone who queued up on the
+ * lock meanwhile takes that answer instead of asking again.  With
+ * poll_interval set, a thread walks through everything the backend can
+ * read, one query every poll_interval ms, so readers only ever see the
+ * cache and the port carries the poller's queries and nothing else.
+ */
+#define AMP_ITEM_FREQ       (-2)
+#define AMP_ITEM_POWERSTAT  (-1)
+
+struct amp_poller
+{
+    AMP *amp;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int stop;
+    int nitems;
+    int items[RIG_SETTING_MAX + 2];
+};
+
+
+static struct timespec *amp_cache_time(struct amp_state *rs, int item)
+{
+    switch (item)
+    {
+    case AMP_ITEM_FREQ:
+        return &rs->cache.time_freq;
+
+    case AMP_ITEM_POWERSTAT:
+        return &rs->cache.time_powerstat;
+
+    default:
+        return &rs->cache.time_level[item];
+    }
+}
+
+
+static void amp_cache_invalidate(AMP *amp, int item)
+{
+    struct amp_state *rs = &amp->state;
+
+    pthread_mutex_lock(&rs->cache_lock);
+    elapsed_ms(amp_cache_time(rs, item), HAMLIB_ELAPSED_INVALIDATE);
+    pthread_mutex_unlock(&rs->cache_lock);
+}
+
+
+static void amp_cache_invalidate_all(AMP *amp)
+{
+    int i;
+
+    amp_cache_invalidate(amp, AMP_ITEM_FREQ);
+    amp_cache_invalidate(amp, AMP_ITEM_POWERSTAT);
+
+    for (i = 0; i < RIG_SETTING_MAX; i++)
+    {
+        amp_cache_invalidate(amp, i);
+    }
+}
+
+
+/* polled readings stay good until two rounds of the poller are missed */
+static int amp_cache_ttl(const struct amp_state *rs)
+{
+    const struct amp_poller *poller = (const struct amp_poller *) rs->poller;
+
+    if (rs->cache.timeout_ms > 0)
+    {
+        return rs->cache.timeout_ms;
+    }
+
+    return poller ? 2 * poller->nitems * rs->cache.poll_ms : 0;
+}
+
+
+static int amp_cache_fresh(const struct amp_state *rs, struct timespec *t)
+{
+    int ttl = amp_cache_ttl(rs);
+
+    return ttl > 0 && elapsed_ms(t, HAMLIB_ELAPSED_GET) < ttl;
+}
+
+
+/* ask the amplifier for item and keep the answer, called with state.lock held */
+static int amp_cache_fill(AMP *amp, int item)
+{
+    struct amp_state *rs = &amp->state;
+    freq_t freq = 0;
+    powerstat_t status = RIG_POWER_UNKNOWN;
+    value_t val;
+    int retval;
+
+    switch (item)
+    {
+    case AMP_ITEM_FREQ:
+        retval = amp->caps->get_freq(amp, &freq);
+        break;
+
+    case AMP_ITEM_POWERSTAT:
+        retval = amp->caps->get_powerstat(amp, &status);
+        break;
+
+    default:
+        retval = amp->caps->get_level(amp, rig_idx2setting(item), &val);
+    }
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    pthread_mutex_lock(&rs->cache_lock);
+
+    switch (item)
+    {
+    case AMP_ITEM_FREQ:
+        rs->cache.freq = freq;
+        rs->cache.freq_seq++;
+        break;
+
+    case AMP_ITEM_POWERSTAT:
+        rs->cache.powerstat = status;
+        rs->cache.powerstat_seq++;
+        break;
+
+    default:
+        if (AMP_LEVEL_IS_STRING(rig_idx2setting(item)))
+        {
+            const char *str = val.s ? val.s : "";
+
+            /* backends answer from a scratch buffer reused by other queries */
+            if (strcmp(rs->cache.fault, str))
+            {
+                strncpy(rs->cache.fault, str, sizeof(rs->cache.fault) - 1);
+            }
+
+            val.s = rs->cache.fault;
+        }
+
+        rs->cache.level[item] = val;
+        rs->cache.level_seq[item]++;
+    }
+
+    elapsed_ms(amp_cache_time(rs, item), HAMLIB_ELAPSED_SET);
+    pthread_mutex_unlock(&rs->cache_lock);
+
+    return RIG_OK;
+}
+
+
+static int amp_cache_newer(const struct timespec *t, const struct timespec *than)
+{
+    return t->tv_sec > than->tv_sec
+           || (t->tv_sec == than->tv_sec && t->tv_nsec >= than->tv_nsec);
+}
+
+
+/*
+ * Make sure the cache holds a reading of item, asking the amplifier unless
+ * it is fresh or was read while we waited for the lock.  The caller copies
+ * the reading out under state.cache_lock.
+ */
+static int amp_cache_read(AMP *amp, int item)
+{
+    struct amp_state *rs = &amp->state;
+    struct timespec *t = amp_cache_time(rs, item);
+    struct timespec asked;
+    int hit, retval = RIG_OK;
+
+    pthread_mutex_lock(&rs->cache_lock);
+    hit = amp_cache_fresh(rs, t);
+    pthread_mutex_unlock(&rs->cache_lock);
+
+    if (hit)
+    {
+        return RIG_OK;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &asked);
+    pthread_mutex_lock(&rs->lock);
+
+    pthread_mutex_lock(&rs->cache_lock);
+    hit = amp_cache_newer(t, &asked) || amp_cache_fresh(rs, t);
+    pthread_mutex_unlock(&rs->cache_lock);
+
+    if (!hit)
+    {
+        retval = amp_cache_fill(amp, item);
+    }
+
+    pthread_mutex_unlock(&rs->lock);
+
+    return retval;
+}
+
+
+static void *amp_poller_thread(void *arg)
+{
+    struct amp_poller *poller = (struct amp_poller *) arg;
+    AMP *amp = poller->amp;
+    struct amp_state *rs = &amp->state;
+    int i = 0;
+
+    pthread_mutex_lock(&poller->lock);
+
+    while (!poller->stop)
+    {
+        struct timespec next;
+        int retval;
+
+        pthread_mutex_unlock(&poller->lock);
+
+        pthread_mutex_lock(&rs->lock);
+        retval = amp_cache_fill(amp, poller->items[i]);
+        pthread_mutex_unlock(&rs->lock);
+
+        if (retval != RIG_OK)
+        {
+            amp_debug(RIG_DEBUG_VERBOSE, "%s: item %d: %s\n", __func__, poller->items[i],
+                      rigerror(retval));
+        }
+
+        i = (i + 1) % poller->nitems;
+
+        clock_gettime(CLOCK_REALTIME, &next);
+        next.tv_sec += rs->cache.poll_ms / 1000;
+        next.tv_nsec += (rs->cache.poll_ms % 1000) * 1000000L;
+
+        if (next.tv_nsec >= 1000000000L)
+        {
+            next.tv_sec++;
+            next.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&poller->lock);
+
+        while (!poller->stop
+                && pthread_cond_timedwait(&poller->cond, &poller->lock, &next) == 0)
+        {
+            /* woken early, keep waiting out the interval */
+        }
+    }
+
+    pthread_mutex_unlock(&poller->lock);
+
+    return NULL;
+}
+
+
+static int amp_poller_start(AMP *amp)
+{
+    struct amp_state *rs = &amp->state;
+    const struct amp_caps *caps = amp->caps;
+    struct amp_poller *poller;
+    int i;
+
+    if (rs->cache.poll_ms <= 0)
+    {
+        return RIG_OK;
+    }
+
+    poller = calloc(1, sizeof(*poller));
+
+    if (!poller)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    poller->amp = amp;
+
+    if (caps->get_powerstat)
+    {
+        poller->items[poller->nitems++] = AMP_ITEM_POWERSTAT;
+    }
+
+    if (caps->get_freq)
+    {
+        poller->items[poller->nitems++] = AMP_ITEM_FREQ;
+    }
+
+    for (i = 0; caps->get_level && i < RIG_SETTING_MAX; i++)
+    {
+        if (rs->has_get_level & rig_idx2setting(i))
+        {
+            poller->items[poller->nitems++] = i;
+        }
+    }
+
+    if (poller->nitems == 0)
+    {
+        amp_debug(RIG_DEBUG_WARN, "%s: nothing to poll\n", __func__);
+        free(poller);
+        return RIG_OK;
+    }
+
+    pthread_mutex_init(&poller->lock, NULL);
+    pthread_cond_init(&poller->cond, NULL);
+
+    if (pthread_create(&poller->thread, NULL, amp_poller_thread, poller))
+    {
+        amp_debug(RIG_DEBUG_ERR, "%s: pthread_create failed\n", __func__);
+        pthread_cond_destroy(&poller->cond);
+        pthread_mutex_destroy(&poller->lock);
+        free(poller);
+        return -RIG_EINTERNAL;
+    }
+
+    rs->poller = poller;
+
+    amp_debug(RIG_DEBUG_VERBOSE, "%s: polling %d items every %d ms\n", __func__,
+              poller->nitems, rs->cache.poll_ms);
+
+    return RIG_OK;
+}
+
+
+static void amp_poller_stop(AMP *amp)
+{
+    struct amp_poller *poller = (struct amp_poller *) amp->state.poller;
+
+    if (!poller)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&poller->lock);
+    poller->stop = 1;
+    pthread_cond_signal(&poller->cond);
+    pthread_mutex_unlock(&poller->lock);
+
+    pthread_join(poller->thread, NULL);
+
+    pthread_cond_destroy(&poller->cond);
+    pthread_mutex_destroy(&poller->lock);
+    amp->state.poller = NULL;
+    free(poller);
+}
+
+
 #ifdef XXREMOVEDXX
 /**
  * \brief Executess cfunc() on each #AMP handle.
@@ -256,6 +600,12 @@ AMP *HAMLIB_API amp_init(amp_model_t amp_model)
 
     rs->ampport.fd = -1;
 
+    pthread_mutex_init(&rs->lock, NULL);
+    pthread_mutex_init(&rs->cache_lock, NULL);
+    rs->cache.timeout_ms = 0;
+    rs->cache.poll_ms = 0;
+    amp_cache_invalidate_all(amp);
+
     /*
      * let the backend a chance to setup his private data
      * This must be done only once defaults are setup,
@@ -271,6 +621,8 @@ AMP *HAMLIB_API amp_init(amp_model_t amp_model)
                       "%s: backend_init failed!\n",
                       __func__);
             /* cleanup and exit */
+            pthread_mutex_destroy(&rs->cache_lock);
+            pthread_mutex_destroy(&rs->lock);
             free(amp);
             return NULL;
         }
@@ -282,6 +634,8 @@ AMP *HAMLIB_API amp_init(amp_model_t amp_model)
     memcpy(&amp->state.ampport_deprecated, &amp->state.ampport,
            sizeof(amp->state.ampport_deprecated));
 
+    amp_conf_index_init(amp);
+
     return amp;
 }
 
@@ -421,6 +775,9 @@ int HAMLIB_API amp_open(AMP *amp)
     memcpy(&amp->state.ampport_deprecated, &amp->state.ampport,
            sizeof(amp->state.ampport_deprecated));
 
+    /* without the poller, readings are just not cached as long */
+    amp_poller_start(amp);
+
     return RIG_OK;
 }
 
@@ -466,6 +823,9 @@ int HAMLIB_API amp_close(AMP *amp)
         return -RIG_EINVAL;
     }
 
+    band_follow_amp_gone(amp);
+    amp_poller_stop(amp);
+
     /*
      * Let the backend say 73s to the amp.
      * and ignore the return code.
@@ -507,6 +867,7 @@ int HAMLIB_API amp_close(AMP *amp)
     remove_opened_amp(amp);
 
     rs->comm_state = 0;
+    amp_cache_invalidate_all(amp);
 
     return RIG_OK;
 }
@@ -553,6 +914,9 @@ int HAMLIB_API amp_cleanup(AMP *amp)
         amp->caps->amp_cleanup(amp);
     }
 
+    amp_conf_index_cleanup(amp);
+    pthread_mutex_destroy(&amp->state.cache_lock);
+    pthread_mutex_destroy(&amp->state.lock);
     free(amp);
 
     return RIG_OK;
@@ -577,6 +941,7 @@ int HAMLIB_API amp_cleanup(AMP *amp)
 int HAMLIB_API amp_reset(AMP *amp, amp_reset_t reset)
 {
     const struct amp_caps *caps;
+    int retval;
 
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -592,7 +957,14 @@ int HAMLIB_API amp_reset(AMP *amp, amp_reset_t reset)
         return -RIG_ENAVAIL;
     }
 
-    return caps->reset(amp, reset);
+    pthread_mutex_lock(&amp->state.lock);
+    retval = caps->reset(amp, reset);
+    pthread_mutex_unlock(&amp->state.lock);
+
+    /* anything may have changed */
+    amp_cache_invalidate_all(amp);
+
+    return retval;
 }
 
 
@@ -616,6 +988,7 @@ int HAMLIB_API amp_reset(AMP *amp, amp_reset_t reset)
 int HAMLIB_API amp_get_freq(AMP *amp, freq_t *freq)
 {
     const struct amp_caps *caps;
+    int retval;
 
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -631,7 +1004,16 @@ int HAMLIB_API amp_get_freq(AMP *amp, freq_t *freq)
         return -RIG_ENAVAIL;
     }
 
-    return caps->get_freq(amp, freq);
+    retval = amp_cache_read(amp, AMP_ITEM_FREQ);
+
+    if (retval == RIG_OK)
+    {
+        pthread_mutex_lock(&amp->state.cache_lock);
+        *freq = amp->state.cache.freq;
+        pthread_mutex_unlock(&amp->state.cache_lock);
+    }
+
+    return retval;
 }
 
 
@@ -656,6 +1038,7 @@ int HAMLIB_API amp_get_freq(AMP *amp, freq_t *freq)
 int HAMLIB_API amp_set_freq(AMP *amp, freq_t freq)
 {
     const struct amp_caps *caps;
+    int retval;
 
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -671,7 +1054,13 @@ int HAMLIB_API amp_set_freq(AMP *amp, freq_t freq)
         return -RIG_ENAVAIL;
     }
 
-    return caps->set_freq(amp, freq);
+    pthread_mutex_lock(&amp->state.lock);
+    retval = caps->set_freq(amp, freq);
+    pthread_mutex_unlock(&amp->state.lock);
+
+    amp_cache_invalidate(amp, AMP_ITEM_FREQ);
+
+    return retval;
 }
 
 
@@ -690,6 +1079,8 @@ int HAMLIB_API amp_set_freq(AMP *amp, freq_t freq)
  */
 const char *HAMLIB_API amp_get_info(AMP *amp)
 {
+    const char *info;
+
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_AMP_ARG(amp))
@@ -702,7 +1093,11 @@ const char *HAMLIB_API amp_get_info(AMP *amp)
         return NULL;
     }
 
-    return amp->caps->get_info(amp);
+    pthread_mutex_lock(&amp->state.lock);
+    info = amp->caps->get_info(amp);
+    pthread_mutex_unlock(&amp->state.lock);
+
+    return info;
 }
 
 
@@ -728,6 +1123,8 @@ const char *HAMLIB_API amp_get_info(AMP *amp)
  */
 int HAMLIB_API amp_get_level(AMP *amp, setting_t level, value_t *val)
 {
+    int idx, retval;
+
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_AMP_ARG(amp))
@@ -740,7 +1137,27 @@ int HAMLIB_API amp_get_level(AMP *amp, setting_t level, value_t *val)
         return -RIG_ENAVAIL;
     }
 
-    return amp->caps->get_level(amp, level, val);
+    idx = rig_setting2idx(level);
+
+    /* only single levels go through the cache */
+    if (level == AMP_LEVEL_NONE || rig_idx2setting(idx) != level)
+    {
+        pthread_mutex_lock(&amp->state.lock);
+        retval = amp->caps->get_level(amp, level, val);
+        pthread_mutex_unlock(&amp->state.lock);
+        return retval;
+    }
+
+    retval = amp_cache_read(amp, idx);
+
+    if (retval == RIG_OK)
+    {
+        pthread_mutex_lock(&amp->state.cache_lock);
+        *val = amp->state.cache.level[idx];
+        pthread_mutex_unlock(&amp->state.cache_lock);
+    }
+
+    return retval;
 }
 
 
@@ -764,6 +1181,8 @@ int HAMLIB_API amp_get_level(AMP *amp, setting_t level, value_t *val)
  */
 int HAMLIB_API amp_get_ext_level(AMP *amp, token_t level, value_t *val)
 {
+    int retval;
+
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_AMP_ARG(amp))
@@ -776,7 +1195,11 @@ int HAMLIB_API amp_get_ext_level(AMP *amp, token_t level, value_t *val)
         return -RIG_ENAVAIL;
     }
 
-    return amp->caps->get_ext_level(amp, level, val);
+    pthread_mutex_lock(&amp->state.lock);
+    retval = amp->caps->get_ext_level(amp, level, val);
+    pthread_mutex_unlock(&amp->state.lock);
+
+    return retval;
 }
 
 
@@ -802,6 +1225,8 @@ int HAMLIB_API amp_get_ext_level(AMP *amp, token_t level, value_t *val)
  */
 int HAMLIB_API amp_set_powerstat(AMP *amp, powerstat_t status)
 {
+    int retval;
+
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_AMP_ARG(amp))
@@ -814,7 +1239,14 @@ int HAMLIB_API amp_set_powerstat(AMP *amp, powerstat_t status)
         return -RIG_ENAVAIL;
     }
 
-    return amp->caps->set_powerstat(amp, status);
+    pthread_mutex_lock(&amp->state.lock);
+    retval = amp->caps->set_powerstat(amp, status);
+    pthread_mutex_unlock(&amp->state.lock);
+
+    /* levels read in standby or while off mean nothing now */
+    amp_cache_invalidate_all(amp);
+
+    return retval;
 }
 
 
@@ -839,6 +1271,8 @@ int HAMLIB_API amp_set_powerstat(AMP *amp, powerstat_t status)
  */
 int HAMLIB_API amp_get_powerstat(AMP *amp, powerstat_t *status)
 {
+    int retval;
+
     amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_AMP_ARG(amp))
@@ -851,7 +1285,16 @@ int HAMLIB_API amp_get_powerstat(AMP *amp, powerstat_t *status)
         return -RIG_ENAVAIL;
     }
 
-    return amp->caps->get_powerstat(amp, status);
+    retval = amp_cache_read(amp, AMP_ITEM_POWERSTAT);
+
+    if (retval == RIG_OK)
+    {
+        pthread_mutex_lock(&amp->state.cache_lock);
+        *status = amp->state.cache.powerstat;
+        pthread_mutex_unlock(&amp->state.cache_lock);
+    }
+
+    return retval;
 }
 
 
@@ -0,0 +1,194 @@
+/*
+ *  Hamlib Interface - async frame dispatch
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The async data handler thread reads every frame off the rig port and
+ * only splits and classifies them.  A reply to a command goes straight to
+ * the waiting caller through the sync pipe.  An async frame (transceive,
+ * scope data) is copied into a small ring, and a task on the rig's strand
+ * of the shared executor (executor.c) hands the frames to
+ * caps->process_async_frame() in the order they came, so a slow event
+ * callback never holds up the replies behind it.  Only one drain task is
+ * queued at a time; it runs until the ring is empty.  When the ring is
+ * full the oldest frame is dropped: transceive data is superseded by what
+ * follows anyway.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "async_dispatch.h"
+#include "executor.h"
+#include "trace.h"
+
+#ifdef HAVE_PTHREAD
+
+#define ASYNC_DISPATCH_FRAMES 32
+
+struct async_dispatch_frame
+{
+    int length;
+    unsigned char data[ASYNC_DISPATCH_FRAME_LENGTH];
+};
+
+struct async_dispatch
+{
+    RIG *rig;
+    hl_strand_t *strand;
+    pthread_mutex_t lock;
+    int posted;             /* a drain task is queued or running */
+    unsigned int head;      /* next slot to fill */
+    unsigned int tail;      /* next slot to process */
+    unsigned int dropped;
+    struct async_dispatch_frame frame[ASYNC_DISPATCH_FRAMES];
+};
+
+static void async_dispatch_drain(void *arg)
+{
+    struct async_dispatch *d = (struct async_dispatch *) arg;
+    RIG *rig = d->rig;
+    struct async_dispatch_frame frame;
+
+    for (;;)
+    {
+        int result;
+
+        pthread_mutex_lock(&d->lock);
+
+        if (d->head == d->tail)
+        {
+            d->posted = 0;
+            pthread_mutex_unlock(&d->lock);
+            break;
+        }
+
+        frame.length = d->frame[d->tail % ASYNC_DISPATCH_FRAMES].length;
+        memcpy(frame.data, d->frame[d->tail % ASYNC_DISPATCH_FRAMES].data,
+               frame.length);
+        d->tail++;
+        pthread_mutex_unlock(&d->lock);
+
+        TRACE_ASYNC_FRAME(frame.length);
+        result = rig->caps->process_async_frame(rig, frame.length, frame.data);
+        TRACE_ASYNC_FRAME_DONE(frame.length, result);
+
+        if (result < 0)
+        {
+            // TODO: error handling -> store errors in rig state -> to be exposed in async snapshot packets
+            rig_debug(RIG_DEBUG_ERR, "%s: process_async_frame() failed, result=%d\n",
+                      __func__, result);
+        }
+    }
+}
+
+struct async_dispatch *async_dispatch_start(RIG *rig)
+{
+    struct async_dispatch *d = calloc(1, sizeof(*d));
+    hl_executor_t *ex = hl_executor_default();
+
+    if (d == NULL)
+    {
+        return NULL;
+    }
+
+    d->strand = ex ? hl_strand_new(ex, "async_dispatch") : NULL;
+
+    if (d->strand == NULL)
+    {
+        free(d);
+        return NULL;
+    }
+
+    d->rig = rig;
+    pthread_mutex_init(&d->lock, NULL);
+
+    return d;
+}
+
+void async_dispatch_push(struct async_dispatch *d, const unsigned char *frame,
+                         int length)
+{
+    struct async_dispatch_frame *slot;
+    int post;
+
+    if (length <= 0 || length > ASYNC_DISPATCH_FRAME_LENGTH)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&d->lock);
+
+    if (d->head - d->tail == ASYNC_DISPATCH_FRAMES)
+    {
+        d->tail++;
+
+        if (d->dropped++ == 0)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: event handlers fall behind, dropping frames\n",
+                      __func__);
+        }
+    }
+
+    slot = &d->frame[d->head % ASYNC_DISPATCH_FRAMES];
+    slot->length = length;
+    memcpy(slot->data, frame, length);
+    d->head++;
+    post = !d->posted;
+    d->posted = 1;
+
+    pthread_mutex_unlock(&d->lock);
+
+    if (post && hl_strand_post(d->strand, async_dispatch_drain, d) != RIG_OK)
+    {
+        pthread_mutex_lock(&d->lock);
+        d->posted = 0;
+        pthread_mutex_unlock(&d->lock);
+    }
+}
+
+void async_dispatch_stop(struct async_dispatch *d)
+{
+    if (d == NULL)
+    {
+        return;
+    }
+
+    // waits for the drain task, which empties the ring first
+    hl_strand_free(d->strand);
+
+    if (d->dropped)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: %u async frames dropped\n", __func__,
+                  d->dropped);
+    }
+
+    pthread_mutex_destroy(&d->lock);
+    free(d);
+}
+
+#endif /* HAVE_PTHREAD */
@@ -0,0 +1,42 @@
+/*
+ *  Hamlib Interface - async frame dispatch
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _ASYNC_DISPATCH_H
+#define _ASYNC_DISPATCH_H 1
+
+#include <hamlib/rig.h>
+
+#define ASYNC_DISPATCH_FRAME_LENGTH 1024    /* longest frame the reader passes on */
+
+/*
+ * Hands async frames from the async data handler to
+ * caps->process_async_frame() on the rig's strand of the shared executor
+ * -- see async_dispatch.c.  async_dispatch_stop() processes what is still queued
+ * before it returns.
+ */
+struct async_dispatch;
+
+struct async_dispatch *async_dispatch_start(RIG *rig);
+void async_dispatch_push(struct async_dispatch *d, const unsigned char *frame,
+                         int length);
+void async_dispatch_stop(struct async_dispatch *d);
+
+#endif /* _ASYNC_DISPATCH_H */
@@ -0,0 +1,424 @@
+/*
+ *  Hamlib Interface - amplifier band follow
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * An amplifier linked with amp_follow_rig() is retuned from inside the
+ * library: every frequency the rig reports goes through
+ * rig_set_cache_freq(), whether it comes from transceive, rig_set_freq()
+ * or rig_get_freq(), and is handed to a thread of the link's own.  The
+ * thread waits for the VFO to settle for the debounce time and calls
+ * amp_set_freq() only when the transmit frequency lands in another band,
+ * or another segment of the band.  Nothing is polled, and the rig's
+ * caller never waits on the amplifier port.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "band_follow.h"
+#include "misc.h"
+
+/* amateur bands an amplifier is switched between */
+static const struct
+{
+    freq_t start;
+    freq_t end;
+} band_follow_bands[] =
+{
+    { kHz(1800), MHz(2) },
+    { kHz(3500), MHz(4) },
+    { kHz(5250), kHz(5450) },
+    { MHz(7), kHz(7300) },
+    { kHz(10100), kHz(10150) },
+    { MHz(14), kHz(14350) },
+    { kHz(18068), kHz(18168) },
+    { MHz(21), kHz(21450) },
+    { kHz(24890), kHz(24990) },
+    { MHz(28), kHz(29700) },
+    { MHz(50), MHz(54) },
+    { MHz(70), MHz(71) },
+    { MHz(144), MHz(148) },
+    { MHz(222), MHz(225) },
+    { MHz(420), MHz(450) },
+};
+
+
+int band_follow_band(freq_t freq)
+{
+    int i;
+
+    for (i = 0; i < sizeof(band_follow_bands) / sizeof(band_follow_bands[0]); i++)
+    {
+        if (freq >= band_follow_bands[i].start && freq <= band_follow_bands[i].end)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+#ifdef HAVE_PTHREAD
+
+struct band_follow
+{
+    RIG *rig;
+    AMP *amp;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int run;
+    int debounce_ms;
+    freq_t segment;         /* 0 for whole bands */
+    freq_t target;          /* last transmit frequency reported */
+    int pending;            /* target not looked at by the thread yet */
+    struct timespec moved;  /* when target last changed */
+    int band;               /* band and segment last sent, -1 for none */
+    long seg;
+};
+
+/* guards rig_state.amp_follow and amp_state.follow against unlinking */
+static pthread_mutex_t band_follow_links = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* A and Main are the same VFO to the cache, and so are B and Sub */
+static vfo_t band_follow_side(vfo_t vfo)
+{
+    switch (vfo)
+    {
+    case RIG_VFO_A:
+    case RIG_VFO_VFO:
+    case RIG_VFO_MAIN:
+    case RIG_VFO_MAIN_A:
+        return RIG_VFO_A;
+
+    case RIG_VFO_B:
+    case RIG_VFO_SUB:
+    case RIG_VFO_MAIN_B:
+        return RIG_VFO_B;
+
+    default:
+        return vfo;
+    }
+}
+
+
+static void *band_follow_thread(void *arg)
+{
+    struct band_follow *f = (struct band_follow *) arg;
+
+    pthread_mutex_lock(&f->lock);
+
+    while (f->run)
+    {
+        struct timespec now, settled;
+        freq_t freq;
+        int band;
+        long seg;
+
+        if (!f->pending)
+        {
+            pthread_cond_wait(&f->cond, &f->lock);
+            continue;
+        }
+
+        settled = f->moved;
+        settled.tv_sec += f->debounce_ms / 1000;
+        settled.tv_nsec += (f->debounce_ms % 1000) * 1000000L;
+
+        if (settled.tv_nsec >= 1000000000L)
+        {
+            settled.tv_sec++;
+            settled.tv_nsec -= 1000000000L;
+        }
+
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        if (now.tv_sec < settled.tv_sec
+                || (now.tv_sec == settled.tv_sec && now.tv_nsec < settled.tv_nsec))
+        {
+            /* still turning, or a newer frequency moved the deadline */
+            pthread_cond_timedwait(&f->cond, &f->lock, &settled);
+            continue;
+        }
+
+        freq = f->target;
+        f->pending = 0;
+
+        band = band_follow_band(freq);
+        seg = f->segment > 0 ? (long) floor(freq / f->segment) : 0;
+
+        if (band < 0 || (band == f->band && seg == f->seg))
+        {
+            continue;
+        }
+
+        pthread_mutex_unlock(&f->lock);
+
+        if (amp_set_freq(f->amp, freq) == RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: amplifier follows to %.0f Hz\n", __func__,
+                      freq);
+            pthread_mutex_lock(&f->lock);
+            f->band = band;
+            f->seg = seg;
+        }
+        else
+        {
+            /* tried again on the next frequency the rig reports */
+            rig_debug(RIG_DEBUG_WARN, "%s: amplifier did not take %.0f Hz\n", __func__,
+                      freq);
+            pthread_mutex_lock(&f->lock);
+        }
+    }
+
+    pthread_mutex_unlock(&f->lock);
+
+    return NULL;
+}
+
+
+void band_follow_notify(RIG *rig, vfo_t vfo, freq_t freq)
+{
+    struct rig_state *rs = &rig->state;
+    struct band_follow *f;
+    vfo_t tx_vfo;
+
+    /* the common case stays a single load */
+    if (!rs->amp_follow || freq <= 0)
+    {
+        return;
+    }
+
+    tx_vfo = rs->cache.split ? rs->cache.split_vfo : rs->current_vfo;
+
+    if (tx_vfo != RIG_VFO_NONE && tx_vfo != RIG_VFO_CURR
+            && band_follow_side(vfo) != band_follow_side(tx_vfo))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&band_follow_links);
+    f = (struct band_follow *) rs->amp_follow;
+
+    if (f)
+    {
+        pthread_mutex_lock(&f->lock);
+
+        /* repeated readings of the same frequency do not hold the deadline back */
+        if (freq != f->target)
+        {
+            f->target = freq;
+            f->pending = 1;
+            clock_gettime(CLOCK_REALTIME, &f->moved);
+            pthread_cond_signal(&f->cond);
+        }
+
+        pthread_mutex_unlock(&f->lock);
+    }
+
+    pthread_mutex_unlock(&band_follow_links);
+}
+
+
+/* called with band_follow_links held */
+static void band_follow_unlink(struct band_follow *f)
+{
+    pthread_mutex_lock(&f->lock);
+    f->run = 0;
+    pthread_cond_signal(&f->cond);
+    pthread_mutex_unlock(&f->lock);
+
+    pthread_join(f->thread, NULL);
+
+    f->rig->state.amp_follow = NULL;
+    f->amp->state.follow = NULL;
+
+    pthread_cond_destroy(&f->cond);
+    pthread_mutex_destroy(&f->lock);
+    free(f);
+}
+
+
+void band_follow_rig_gone(RIG *rig)
+{
+    if (!rig->state.amp_follow)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&band_follow_links);
+
+    if (rig->state.amp_follow)
+    {
+        band_follow_unlink((struct band_follow *) rig->state.amp_follow);
+    }
+
+    pthread_mutex_unlock(&band_follow_links);
+}
+
+
+void band_follow_amp_gone(AMP *amp)
+{
+    if (!amp->state.follow)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&band_follow_links);
+
+    if (amp->state.follow)
+    {
+        band_follow_unlink((struct band_follow *) amp->state.follow);
+    }
+
+    pthread_mutex_unlock(&band_follow_links);
+}
+
+
+/**
+ * \brief Make an amplifier follow the band of a rig
+ * \param amp         The amplifier handle, opened
+ * \param rig         The rig handle, NULL to stop following
+ * \param debounce_ms How long the rig frequency must stay put before the
+ *                    amplifier is retuned, 0 to retune at once
+ * \param segment     Also retune when the frequency moves to another
+ *                    \a segment Hz wide slice of the band, 0 for bands only
+ *
+ * From here on every frequency the rig reports for its transmit VFO,
+ * through transceive or through the rig_set_freq() and rig_get_freq()
+ * of the application, is checked against the amateur bands, and
+ * amp_set_freq() is sent once the rig settles in another band or
+ * segment.  A frequency outside the bands leaves the amplifier where it
+ * is.  The check runs on a thread of its own, so the rig calls never
+ * wait for the amplifier.
+ *
+ * An amplifier follows one rig at a time; a new call replaces the older
+ * link.  The link is dropped by amp_close() and by rig_cleanup().
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa amp_set_freq()
+ */
+int HAMLIB_API amp_follow_rig(AMP *amp, RIG *rig, int debounce_ms,
+                              freq_t segment)
+{
+    struct band_follow *f;
+
+    amp_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!amp || !amp->caps || debounce_ms < 0 || segment < 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    band_follow_amp_gone(amp);
+
+    if (!rig)
+    {
+        return RIG_OK;
+    }
+
+    if (!amp->state.comm_state)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (!amp->caps->set_freq)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    band_follow_rig_gone(rig);
+
+    f = calloc(1, sizeof(*f));
+
+    if (!f)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    f->rig = rig;
+    f->amp = amp;
+    f->run = 1;
+    f->debounce_ms = debounce_ms;
+    f->segment = segment;
+    f->band = -1;
+    f->seg = -1;
+    pthread_mutex_init(&f->lock, NULL);
+    pthread_cond_init(&f->cond, NULL);
+
+    if (pthread_create(&f->thread, NULL, band_follow_thread, f))
+    {
+        amp_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        pthread_cond_destroy(&f->cond);
+        pthread_mutex_destroy(&f->lock);
+        free(f);
+        return -RIG_EINTERNAL;
+    }
+
+    pthread_mutex_lock(&band_follow_links);
+    rig->state.amp_follow = f;
+    amp->state.follow = f;
+    pthread_mutex_unlock(&band_follow_links);
+
+    amp_debug(RIG_DEBUG_VERBOSE, "%s: %s follows %s\n", __func__,
+              amp->caps->model_name, rig->caps->model_name);
+
+    return RIG_OK;
+}
+
+#else
+
+void band_follow_notify(RIG *rig, vfo_t vfo, freq_t freq)
+{
+}
+
+
+void band_follow_rig_gone(RIG *rig)
+{
+}
+
+
+void band_follow_amp_gone(AMP *amp)
+{
+}
+
+
+int HAMLIB_API amp_follow_rig(AMP *amp, RIG *rig, int debounce_ms,
+                              freq_t segment)
+{
+    return -RIG_ENIMPL;
+}
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ *  Hamlib Interface - amplifier band follow
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _BAND_FOLLOW_H
+#define _BAND_FOLLOW_H 1
+
+#include <hamlib/rig.h>
+#include <hamlib/amplifier.h>
+
+/* Index of the amateur band freq is in, -1 when outside all of them */
+int band_follow_band(freq_t freq);
+
+/* Called by rig_set_cache_freq() with every frequency the rig reports */
+void band_follow_notify(RIG *rig, vfo_t vfo, freq_t freq);
+
+/* Drop the link before the rig or the amplifier goes away */
+void band_follow_rig_gone(RIG *rig);
+void band_follow_amp_gone(AMP *amp);
+
+#endif /* _BAND_FOLLOW_H */
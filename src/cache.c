@@ -20,11 +20,301 @@
  *
  */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "cache.h"
 #include "misc.h"
+#include "band_follow.h"
+#include "rig_follow.h"
+#include "shmcache.h"
+#include "journal.h"
+#include "riginfo.h"
 
 #define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
 
+#if defined(__GNUC__)
+#define SEQ_LOAD(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SEQ_STORE(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define SEQ_CAS(p, o, n)    __atomic_compare_exchange_n((p), (o), (n), 0, \
+                                __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)
+#define SEQ_FENCE()         __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+// a plain compare and store would let two writers in, as would volatile
+#error "cache.c needs the GNU __atomic builtins (gcc or clang)"
+#endif
+
+/*
+ * The cache is written from the poll thread, the async data handler and
+ * every rigctld client thread.  Readers like rig_get_cache and
+ * snapshot_serialize only need a consistent copy of a few fields so they
+ * use the sequence counter instead of waiting on a mutex.
+ * An odd counter means a write is in progress.
+ */
+void rig_cache_write_begin(RIG *rig)
+{
+    volatile unsigned int *seq = &rig->state.cache_seqlock;
+    unsigned int s;
+
+    for (;;)
+    {
+        s = SEQ_LOAD(seq);
+
+        // another writer is active -- they only hold it for a few stores
+        if (s & 1) { continue; }
+
+        if (SEQ_CAS(seq, &s, s + 1)) { break; }
+    }
+}
+
+void rig_cache_write_end(RIG *rig)
+{
+    volatile unsigned int *seq = &rig->state.cache_seqlock;
+
+    // still the only writer, so the segment gets a consistent copy
+    rig_shm_update(rig);
+    rig_journal_update(rig);
+
+    SEQ_STORE(seq, SEQ_LOAD(seq) + 1);
+
+    rig_info_cache_written(rig);
+}
+
+unsigned int rig_cache_read_begin(RIG *rig)
+{
+    volatile unsigned int *seq = &rig->state.cache_seqlock;
+    unsigned int s;
+
+    // wait out any writer so we don't copy half-updated values
+    while ((s = SEQ_LOAD(seq)) & 1) { }
+
+    return s;
+}
+
+int rig_cache_read_retry(RIG *rig, unsigned int seq)
+{
+    SEQ_FENCE();
+    return SEQ_LOAD(&rig->state.cache_seqlock) != seq;
+}
+
+/*
+ * Cache clock.  Ages are worked out in integer ms against one reading of
+ * CLOCK_REALTIME_COARSE, which is read from memory rather than the TSC and
+ * lags the stamps by at most a tick; a stamp that is ahead of it by less
+ * than CACHE_CLOCK_SLACK_MS is just fresh.  The stamps stay CLOCK_REALTIME
+ * as elapsed_ms() sets them, they are published in the shm_cache segment
+ * as wall clock times.
+ *
+ * rs->cache_reset is the cache epoch: stamps up to it count as never set,
+ * so rig_cache_reset() invalidates every entry with one store.  An epoch
+ * ahead of the clock, after the clock was stepped back, is ignored.
+ */
+#define CACHE_AGE_NEVER (1000 * 1000)
+#define CACHE_CLOCK_SLACK_MS 20
+
+static void cache_now(struct timespec *now)
+{
+#ifdef CLOCK_REALTIME_COARSE
+
+    if (clock_gettime(CLOCK_REALTIME_COARSE, now) == 0) { return; }
+
+#endif
+    clock_gettime(CLOCK_REALTIME, now);
+}
+
+static int stamp_before_eq(const struct timespec *a, const struct timespec *b)
+{
+    return a->tv_sec < b->tv_sec
+           || (a->tv_sec == b->tv_sec && a->tv_nsec <= b->tv_nsec);
+}
+
+static int cache_age(const struct rig_state *rs, const struct timespec *now,
+                     const struct timespec *t)
+{
+    int64_t ms;
+
+    if (t->tv_nsec == 0)
+    {
+        return CACHE_AGE_NEVER;
+    }
+
+    if (stamp_before_eq(t, &rs->cache_reset)
+            && stamp_before_eq(&rs->cache_reset, now))
+    {
+        return CACHE_AGE_NEVER;
+    }
+
+    ms = (int64_t)(now->tv_sec - t->tv_sec) * 1000
+         + (now->tv_nsec - t->tv_nsec) / 1000000;
+
+    if (ms < 0)
+    {
+        return ms > -CACHE_CLOCK_SLACK_MS ? 0 : CACHE_AGE_NEVER;
+    }
+
+    return ms < CACHE_AGE_NEVER ? (int) ms : CACHE_AGE_NEVER;
+}
+
+int rig_cache_age(RIG *rig, const struct timespec *t)
+{
+    struct timespec now;
+
+    cache_now(&now);
+
+    return cache_age(&rig->state, &now, t);
+}
+
+int rig_cache_stale(RIG *rig, const struct timespec *t)
+{
+    return t->tv_nsec == 0 || stamp_before_eq(t, &rig->state.cache_reset);
+}
+
+void rig_cache_reset(RIG *rig)
+{
+    rig_cache_write_begin(rig);
+    clock_gettime(CLOCK_REALTIME, &rig->state.cache_reset);
+    rig_cache_write_end(rig);
+}
+
+/*
+ * Adaptive TTL -- with cache_adaptive_max_ms above cache.timeout_ms each
+ * slot doubles its TTL whenever a refresh from the rig returns the value it
+ * already had, up to the ceiling.  The first refresh that shows a change, or
+ * VFO twiddling, drops the slot back to cache.timeout_ms so tuning stays
+ * responsive while an idle rig is polled much less often.
+ */
+int rig_cache_freq_slot(RIG *rig, vfo_t vfo)
+{
+    if (vfo == RIG_VFO_CURR) { vfo = rig->state.current_vfo; }
+
+    switch (vfo)
+    {
+    case RIG_VFO_A:
+    case RIG_VFO_VFO:
+    case RIG_VFO_MAIN:
+    case RIG_VFO_MAIN_A:
+        return RIG_CACHE_SLOT_FREQ_A;
+
+    case RIG_VFO_B:
+    case RIG_VFO_SUB:
+    case RIG_VFO_MAIN_B:
+        return RIG_CACHE_SLOT_FREQ_B;
+
+    default:
+        return RIG_CACHE_SLOT_FREQ_OTHER;
+    }
+}
+
+/*
+ * Push-fresh cache -- a backend that receives the rig's own change reports
+ * (Icom transceive, for instance) sets use_cached_freq/mode/ptt for what
+ * the reports cover and calls rig_cache_push() for each one it gets.
+ * Those entries are then answered from the cache with no TTL for as long
+ * as reports keep coming, push_timeout_ms after the last one.  Once the
+ * stream has gone quiet the next read polls the rig again, and a poll
+ * that finds the value the stream left in the cache shows nothing was
+ * missed, so it renews the lease as a report would.
+ */
+void rig_cache_push(RIG *rig)
+{
+    elapsed_ms(&rig->state.time_push, HAMLIB_ELAPSED_SET);
+}
+
+int rig_cache_pushed(RIG *rig, int use_cached)
+{
+    struct rig_state *rs = &rig->state;
+
+    if (!use_cached)
+    {
+        return 0;
+    }
+
+    return rs->push_timeout_ms == 0
+           || elapsed_ms(&rs->time_push, HAMLIB_ELAPSED_GET) < rs->push_timeout_ms;
+}
+
+void rig_cache_push_check(RIG *rig, int use_cached, int unchanged)
+{
+    if (use_cached && unchanged)
+    {
+        rig_cache_push(rig);
+    }
+}
+
+/*
+ * Returns the timeout to compare the age of a cache slot against.
+ * value is what the cache currently holds for the slot and age_ms its age.
+ */
+int rig_cache_ttl(RIG *rig, int slot, uint64_t value, int age_ms)
+{
+    struct rig_state *rs = &rig->state;
+    struct rig_cache_adapt *a;
+    struct timespec now;
+    double now_ms, stored_ms;
+    int base = rs->cache.timeout_ms;
+
+    if (base <= 0 || rs->cache_adaptive_max_ms <= base || slot < 0
+            || slot >= (int)(sizeof(rs->cache_adapt) / sizeof(rs->cache_adapt[0])))
+    {
+        return base;
+    }
+
+    a = &rs->cache_adapt[slot];
+
+    if (rs->twiddle_state == TWIDDLE_ON)
+    {
+        a->ttl_ms = base;
+        return base;
+    }
+
+    if (a->ttl_ms < base || a->ttl_ms > rs->cache_adaptive_max_ms)
+    {
+        a->ttl_ms = base;
+    }
+
+    // stale or invalidated entries tell us nothing about the change rate
+    if (age_ms >= a->ttl_ms)
+    {
+        return a->ttl_ms;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    now_ms = now.tv_sec * 1e3 + now.tv_nsec / 1e6;
+    stored_ms = now_ms - age_ms;
+
+    // same refresh as last time we looked
+    if (stored_ms - a->seen_ms < 2 && a->seen_ms - stored_ms < 2)
+    {
+        return a->ttl_ms;
+    }
+
+    rig_cache_write_begin(rig);
+
+    if (value != a->value)
+    {
+        a->ttl_ms = base;
+    }
+    else
+    {
+        a->ttl_ms *= 2;
+
+        if (a->ttl_ms > rs->cache_adaptive_max_ms)
+        {
+            a->ttl_ms = rs->cache_adaptive_max_ms;
+        }
+    }
+
+    a->value = value;
+    a->seen_ms = stored_ms;
+
+    rig_cache_write_end(rig);
+
+    rig_debug(RIG_DEBUG_CACHE, "%s: slot=%d ttl=%dms\n", __func__, slot,
+              a->ttl_ms);
+
+    return a->ttl_ms;
+}
+
 /**
  * \addtogroup rig
  * @{
@@ -47,6 +337,8 @@ int rig_set_cache_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 
     if (vfo == RIG_VFO_SUB && rig->state.cache.satmode) { vfo = RIG_VFO_SUB_A; };
 
+    rig_cache_write_begin(rig);
+
     switch (vfo)
     {
     case RIG_VFO_ALL: // we'll use NONE to reset all VFO caches
@@ -92,10 +384,13 @@ int rig_set_cache_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
         break;
 
     default:
+        rig_cache_write_end(rig);
         rig_debug(RIG_DEBUG_ERR, "%s: unknown vfo=%s\n", __func__, rig_strvfo(vfo));
         RETURNFUNC(-RIG_EINTERNAL);
     }
 
+    rig_cache_write_end(rig);
+
     rig_cache_show(rig, __func__, __LINE__);
     RETURNFUNC(RIG_OK);
 }
@@ -132,25 +427,13 @@ int rig_set_cache_freq(RIG *rig, vfo_t vfo, freq_t freq)
                   rig_strvfo(vfo), freq);
     }
 
+    rig_cache_write_begin(rig);
+
     switch (vfo)
     {
     case RIG_VFO_ALL: // we'll use NONE to reset all VFO caches
-        elapsed_ms(&rig->state.cache.time_freqMainA, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_freqMainB, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_freqMainC, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_freqSubA, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_freqSubB, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_freqSubC, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_freqMem, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_vfo, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_modeMainA, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_modeMainB, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_modeMainC, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_widthMainA, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_widthMainB, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_widthMainC, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_ptt, HAMLIB_ELAPSED_INVALIDATE);
-        elapsed_ms(&rig->state.cache.time_split, HAMLIB_ELAPSED_INVALIDATE);
+        // a new epoch, see rig_cache_reset(); we are already writing
+        clock_gettime(CLOCK_REALTIME, &rig->state.cache_reset);
         break;
 
     case RIG_VFO_A:
@@ -195,11 +478,19 @@ int rig_set_cache_freq(RIG *rig, vfo_t vfo, freq_t freq)
         break;
 
     default:
+        rig_cache_write_end(rig);
         rig_debug(RIG_DEBUG_ERR, "%s: unknown vfo?, vfo=%s\n", __func__,
                   rig_strvfo(vfo));
         return (-RIG_EINVAL);
     }
 
+    rig_cache_write_end(rig);
+
+    // an amplifier linked by amp_follow_rig() hears about it from here
+    band_follow_notify(rig, vfo, freq);
+    // and a rig linked by rig_follow_rig()
+    rig_follow_notify(rig, vfo, freq);
+
     if (rig_need_debug(RIG_DEBUG_CACHE))
     {
         rig_cache_show(rig, __func__, __LINE__);
@@ -233,6 +524,10 @@ int rig_set_cache_freq(RIG *rig, vfo_t vfo, freq_t freq)
 int rig_get_cache(RIG *rig, vfo_t vfo, freq_t *freq, int *cache_ms_freq,
                   rmode_t *mode, int *cache_ms_mode, pbwidth_t *width, int *cache_ms_width)
 {
+    const struct rig_state *rs = &rig->state;
+    struct timespec now;
+    unsigned int seq;
+
     if (CHECK_RIG_ARG(rig) || !freq || !cache_ms_freq ||
             !mode || !cache_ms_mode || !width || !cache_ms_width)
     {
@@ -242,11 +537,10 @@ int rig_get_cache(RIG *rig, vfo_t vfo, freq_t *freq, int *cache_ms_freq,
     if (rig_need_debug(RIG_DEBUG_CACHE))
     {
         ENTERFUNC2;
+        rig_debug(RIG_DEBUG_CACHE, "%s:  vfo=%s, current_vfo=%s\n", __func__,
+                  rig_strvfo(vfo), rig_strvfo(rig->state.current_vfo));
     }
 
-    rig_debug(RIG_DEBUG_CACHE, "%s:  vfo=%s, current_vfo=%s\n", __func__,
-              rig_strvfo(vfo), rig_strvfo(rig->state.current_vfo));
-
     if (vfo == RIG_VFO_CURR)
     {
         vfo = rig->state.current_vfo;
@@ -298,132 +592,114 @@ int rig_get_cache(RIG *rig, vfo_t vfo, freq_t *freq, int *cache_ms_freq,
     // If we're in satmode we map SUB to SUB_A
     if (vfo == RIG_VFO_SUB && rig->state.cache.satmode) { vfo = RIG_VFO_SUB_A; };
 
-    switch (vfo)
+    cache_now(&now);
+
+    do
     {
-    case RIG_VFO_CURR:
-        *freq = rig->state.cache.freqCurr;
-        *mode = rig->state.cache.modeCurr;
-        *width = rig->state.cache.widthCurr;
-        *cache_ms_freq = elapsed_ms(&rig->state.cache.time_freqCurr,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_mode = elapsed_ms(&rig->state.cache.time_modeCurr,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_width = elapsed_ms(&rig->state.cache.time_widthCurr,
-                                     HAMLIB_ELAPSED_GET);
-        break;
+        seq = rig_cache_read_begin(rig);
 
-    case RIG_VFO_OTHER:
-        *freq = rig->state.cache.freqOther;
-        *mode = rig->state.cache.modeOther;
-        *width = rig->state.cache.widthOther;
-        *cache_ms_freq = elapsed_ms(&rig->state.cache.time_freqOther,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_mode = elapsed_ms(&rig->state.cache.time_modeOther,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_width = elapsed_ms(&rig->state.cache.time_widthOther,
-                                     HAMLIB_ELAPSED_GET);
-        break;
+        switch (vfo)
+        {
+        case RIG_VFO_CURR:
+            *freq = rig->state.cache.freqCurr;
+            *mode = rig->state.cache.modeCurr;
+            *width = rig->state.cache.widthCurr;
+            *cache_ms_freq = cache_age(rs, &now, &rs->cache.time_freqCurr);
+            *cache_ms_mode = cache_age(rs, &now, &rs->cache.time_modeCurr);
+            *cache_ms_width = cache_age(rs, &now, &rs->cache.time_widthCurr);
+            break;
 
-    case RIG_VFO_A:
-    case RIG_VFO_VFO:
-    case RIG_VFO_MAIN:
-    case RIG_VFO_MAIN_A:
-        *freq = rig->state.cache.freqMainA;
-        *mode = rig->state.cache.modeMainA;
-        *width = rig->state.cache.widthMainA;
-        *cache_ms_freq = elapsed_ms(&rig->state.cache.time_freqMainA,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_mode = elapsed_ms(&rig->state.cache.time_modeMainA,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_width = elapsed_ms(&rig->state.cache.time_widthMainA,
-                                     HAMLIB_ELAPSED_GET);
-        break;
+        case RIG_VFO_OTHER:
+            *freq = rig->state.cache.freqOther;
+            *mode = rig->state.cache.modeOther;
+            *width = rig->state.cache.widthOther;
+            *cache_ms_freq = cache_age(rs, &now, &rs->cache.time_freqOther);
+            *cache_ms_mode = cache_age(rs, &now, &rs->cache.time_modeOther);
+            *cache_ms_width = cache_age(rs, &now, &rs->cache.time_widthOther);
+            break;
 
-    case RIG_VFO_B:
-    case RIG_VFO_SUB:
-    case RIG_VFO_MAIN_B:
-        *freq = rig->state.cache.freqMainB;
-        *mode = rig->state.cache.modeMainB;
-        *width = rig->state.cache.widthMainB;
-        *cache_ms_freq = elapsed_ms(&rig->state.cache.time_freqMainB,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_mode = elapsed_ms(&rig->state.cache.time_modeMainB,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_width = elapsed_ms(&rig->state.cache.time_widthMainB,
-                                     HAMLIB_ELAPSED_GET);
-        break;
+        case RIG_VFO_A:
+        case RIG_VFO_VFO:
+        case RIG_VFO_MAIN:
+        case RIG_VFO_MAIN_A:
+            *freq = rig->state.cache.freqMainA;
+            *mode = rig->state.cache.modeMainA;
+            *width = rig->state.cache.widthMainA;
+            *cache_ms_freq = cache_age(rs, &now, &rs->cache.time_freqMainA);
+            *cache_ms_mode = cache_age(rs, &now, &rs->cache.time_modeMainA);
+            *cache_ms_width = cache_age(rs, &now, &rs->cache.time_widthMainA);
+            break;
 
-    case RIG_VFO_SUB_A:
-        *freq = rig->state.cache.freqSubA;
-        *mode = rig->state.cache.modeSubA;
-        *width = rig->state.cache.widthSubA;
-        *cache_ms_freq = elapsed_ms(&rig->state.cache.time_freqSubA,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_mode = elapsed_ms(&rig->state.cache.time_modeSubA,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_width = elapsed_ms(&rig->state.cache.time_widthSubA,
-                                     HAMLIB_ELAPSED_GET);
-        break;
+        case RIG_VFO_B:
+        case RIG_VFO_SUB:
+        case RIG_VFO_MAIN_B:
+            *freq = rig->state.cache.freqMainB;
+            *mode = rig->state.cache.modeMainB;
+            *width = rig->state.cache.widthMainB;
+            *cache_ms_freq = cache_age(rs, &now, &rs->cache.time_freqMainB);
+            *cache_ms_mode = cache_age(rs, &now, &rs->cache.time_modeMainB);
+            *cache_ms_width = cache_age(rs, &now, &rs->cache.time_widthMainB);
+            break;
 
-    case RIG_VFO_SUB_B:
-        *freq = rig->state.cache.freqSubB;
-        *mode = rig->state.cache.modeSubB;
-        *width = rig->state.cache.widthSubB;
-        *cache_ms_freq = elapsed_ms(&rig->state.cache.time_freqSubB,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_mode = elapsed_ms(&rig->state.cache.time_modeSubB,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_width = elapsed_ms(&rig->state.cache.time_widthSubB,
-                                     HAMLIB_ELAPSED_GET);
-        break;
+        case RIG_VFO_SUB_A:
+            *freq = rig->state.cache.freqSubA;
+            *mode = rig->state.cache.modeSubA;
+            *width = rig->state.cache.widthSubA;
+            *cache_ms_freq = cache_age(rs, &now, &rs->cache.time_freqSubA);
+            *cache_ms_mode = cache_age(rs, &now, &rs->cache.time_modeSubA);
+            *cache_ms_width = cache_age(rs, &now, &rs->cache.time_widthSubA);
+            break;
 
-    case RIG_VFO_C:
-        //case RIG_VFO_MAINC: // not used by any rig yet
-        *freq = rig->state.cache.freqMainC;
-        *mode = rig->state.cache.modeMainC;
-        *width = rig->state.cache.widthMainC;
-        *cache_ms_freq = elapsed_ms(&rig->state.cache.time_freqMainC,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_mode = elapsed_ms(&rig->state.cache.time_modeMainC,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_width = elapsed_ms(&rig->state.cache.time_widthMainC,
-                                     HAMLIB_ELAPSED_GET);
-        break;
+        case RIG_VFO_SUB_B:
+            *freq = rig->state.cache.freqSubB;
+            *mode = rig->state.cache.modeSubB;
+            *width = rig->state.cache.widthSubB;
+            *cache_ms_freq = cache_age(rs, &now, &rs->cache.time_freqSubB);
+            *cache_ms_mode = cache_age(rs, &now, &rs->cache.time_modeSubB);
+            *cache_ms_width = cache_age(rs, &now, &rs->cache.time_widthSubB);
+            break;
 
-    case RIG_VFO_SUB_C:
-        *freq = rig->state.cache.freqSubC;
-        *mode = rig->state.cache.modeSubC;
-        *width = rig->state.cache.widthSubC;
-        *cache_ms_freq = elapsed_ms(&rig->state.cache.time_freqSubC,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_mode = elapsed_ms(&rig->state.cache.time_modeSubC,
-                                    HAMLIB_ELAPSED_GET);
-        *cache_ms_width = elapsed_ms(&rig->state.cache.time_widthSubC,
-                                     HAMLIB_ELAPSED_GET);
-        break;
+        case RIG_VFO_C:
+            //case RIG_VFO_MAINC: // not used by any rig yet
+            *freq = rig->state.cache.freqMainC;
+            *mode = rig->state.cache.modeMainC;
+            *width = rig->state.cache.widthMainC;
+            *cache_ms_freq = cache_age(rs, &now, &rs->cache.time_freqMainC);
+            *cache_ms_mode = cache_age(rs, &now, &rs->cache.time_modeMainC);
+            *cache_ms_width = cache_age(rs, &now, &rs->cache.time_widthMainC);
+            break;
 
-    case RIG_VFO_MEM:
-        *freq = rig->state.cache.freqMem;
-        *mode = rig->state.cache.modeMem;
-        *width = rig->state.cache.widthMem;
-        *cache_ms_freq = elapsed_ms(&rig->state.cache.time_freqMem, HAMLIB_ELAPSED_GET);
-        *cache_ms_mode = elapsed_ms(&rig->state.cache.time_modeMem, HAMLIB_ELAPSED_GET);
-        *cache_ms_width = elapsed_ms(&rig->state.cache.time_widthMem,
-                                     HAMLIB_ELAPSED_GET);
-        break;
+        case RIG_VFO_SUB_C:
+            *freq = rig->state.cache.freqSubC;
+            *mode = rig->state.cache.modeSubC;
+            *width = rig->state.cache.widthSubC;
+            *cache_ms_freq = cache_age(rs, &now, &rs->cache.time_freqSubC);
+            *cache_ms_mode = cache_age(rs, &now, &rs->cache.time_modeSubC);
+            *cache_ms_width = cache_age(rs, &now, &rs->cache.time_widthSubC);
+            break;
 
-    default:
-        rig_debug(RIG_DEBUG_ERR, "%s: unknown vfo?, vfo=%s\n", __func__,
-                  rig_strvfo(vfo));
-        RETURNFUNC(-RIG_EINVAL);
-    }
+        case RIG_VFO_MEM:
+            *freq = rig->state.cache.freqMem;
+            *mode = rig->state.cache.modeMem;
+            *width = rig->state.cache.widthMem;
+            *cache_ms_freq = cache_age(rs, &now, &rs->cache.time_freqMem);
+            *cache_ms_mode = cache_age(rs, &now, &rs->cache.time_modeMem);
+            *cache_ms_width = cache_age(rs, &now, &rs->cache.time_widthMem);
+            break;
 
-    rig_debug(RIG_DEBUG_CACHE, "%s: vfo=%s, freq=%.0f, mode=%s, width=%d\n",
-              __func__, rig_strvfo(vfo),
-              (double)*freq, rig_strrmode(*mode), (int)*width);
+        default:
+            rig_debug(RIG_DEBUG_ERR, "%s: unknown vfo?, vfo=%s\n", __func__,
+                      rig_strvfo(vfo));
+            RETURNFUNC(-RIG_EINVAL);
+        }
+    }
+    while (rig_cache_read_retry(rig, seq));
 
     if (rig_need_debug(RIG_DEBUG_CACHE))
     {
+        rig_debug(RIG_DEBUG_CACHE, "%s: vfo=%s, freq=%.0f, mode=%s, width=%d\n",
+                  __func__, rig_strvfo(vfo),
+                  (double)*freq, rig_strrmode(*mode), (int)*width);
         RETURNFUNC(RIG_OK);
     }
 
@@ -454,4 +730,459 @@ void rig_cache_show(RIG *rig, const char *func, int line)
     }
 }
 
+/*
+ * Fill in *snap from a consistent copy of the cache without any lock.
+ * The *_ok flags follow the cache checks in rig_get_freq(), rig_get_mode(),
+ * rig_get_vfo(), rig_get_ptt() and rig_get_split_vfo() but use the fixed
+ * cache.timeout_ms, so anything only kept alive by the adaptive TTL is
+ * left for the locked path.
+ */
+void rig_cache_snapshot(RIG *rig, vfo_t vfo, struct rig_cache_snapshot *snap)
+{
+    struct rig_state *rs = &rig->state;
+    int ttl = rs->cache.timeout_ms;
+    int always = ttl == HAMLIB_CACHE_ALWAYS;
+    int ms_freq, ms_mode, ms_width, ms_vfo, ms_ptt, ms_split;
+    struct timespec now;
+    unsigned int seq;
+
+    memset(snap, 0, sizeof(*snap));
+
+    if (CHECK_RIG_ARG(rig))
+    {
+        return;
+    }
+
+    // unlike elapsed_ms(), cache_age() does not stamp a time never set
+    cache_now(&now);
+
+    do
+    {
+        seq = rig_cache_read_begin(rig);
+
+        snap->target = vfo_fixup(rig, vfo, rs->cache.split);
+
+        if (snap->target == RIG_VFO_CURR) { snap->target = rs->current_vfo; }
+
+        rig_get_cache(rig, snap->target, &snap->freq, &ms_freq, &snap->mode,
+                      &ms_mode, &snap->width, &ms_width);
+        snap->vfo = rs->cache.vfo;
+        ms_vfo = cache_age(rs, &now, &rs->cache.time_vfo);
+        snap->ptt = rs->cache.ptt;
+        snap->ptt_set = !rig_cache_stale(rig, &rs->cache.time_ptt);
+        ms_ptt = cache_age(rs, &now, &rs->cache.time_ptt);
+        snap->split = rs->cache.split;
+        snap->tx_vfo = rs->cache.split_vfo;
+        ms_split = cache_age(rs, &now, &rs->cache.time_split);
+    }
+    while (rig_cache_read_retry(rig, seq));
+
+    /* uplink and the FTDX101D/IC910 split case have their own rules */
+    snap->freq_ok = snap->freq != 0 && rs->uplink == 0
+                    && !(snap->split && (rig->caps->rig_model == RIG_MODEL_FTDX101D
+                                         || rig->caps->rig_model == RIG_MODEL_IC910))
+                    && (ms_freq < ttl || always || rig_cache_pushed(rig, rs->use_cached_freq));
+    snap->mode_ok = rig->caps->get_mode != NULL
+                    && (always || rig_cache_pushed(rig, rs->use_cached_mode)
+                        || (snap->mode != RIG_MODE_NONE && ms_mode < ttl && ms_width < ttl));
+    snap->vfo_ok = rig->caps->get_vfo != NULL && ms_vfo < ttl;
+    snap->ptt_ok = ms_ptt < ttl || rig_cache_pushed(rig, rs->use_cached_ptt);
+    snap->split_ok = rig->caps->get_split_vfo == NULL || ms_split < ttl;
+    snap->freq_ms = ms_freq;
+    snap->mode_ms = ms_mode > ms_width ? ms_mode : ms_width;
+    snap->ptt_ms = ms_ptt;
+}
+
+/*
+ * Stale-while-revalidate.  The rig_get_*_swr() calls answer from the cache
+ * however old the value is and, when it is past the cache timeout, queue
+ * the ordinary getter through rig_submit() to bring it up to date.  One
+ * refresh of each kind is in flight at a time, rs->swr_pending has a bit
+ * for each.  Only when nothing is cached yet do they ask the rig and wait.
+ */
+#define SWR_FREQ 0x01
+#define SWR_MODE 0x02
+#define SWR_PTT  0x04
+
+static void swr_done(RIG *rig, struct rig_request *req, rig_ptr_t arg)
+{
+    unsigned int bit = (unsigned int)(uintptr_t) arg;
+
+    if (req->retcode != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: refresh type %d failed: %s\n", __func__,
+                  req->type, rigerror(req->retcode));
+    }
+
+    __atomic_fetch_and(&rig->state.swr_pending, ~bit, __ATOMIC_RELEASE);
+    free(req);
+}
+
+static void swr_refresh(RIG *rig, rig_request_t type, vfo_t vfo,
+                        unsigned int bit)
+{
+    struct rig_request *req;
+
+    if (__atomic_fetch_or(&rig->state.swr_pending, bit, __ATOMIC_ACQ_REL) & bit)
+    {
+        return;     /* one is on its way */
+    }
+
+    req = calloc(1, sizeof(*req));
+
+    if (req)
+    {
+        req->type = type;
+        req->vfo = vfo;
+
+        if (rig_submit(rig, req, swr_done, (rig_ptr_t)(uintptr_t) bit) == RIG_OK)
+        {
+            return;
+        }
+
+        free(req);
+    }
+
+    __atomic_fetch_and(&rig->state.swr_pending, ~bit, __ATOMIC_RELEASE);
+}
+
+/*
+ * Level and func cache.  Each setting has a slot for the A/Main side and
+ * one for the B/Sub side, in rig_setting2idx() order.  Set calls and
+ * backends that decode levels from async reports or bulk answers fill the
+ * slots, rig_get_level()/rig_get_func() answer from them while they are
+ * younger than cache_level_timeout_ms/cache_func_timeout_ms.  The 10 kB of
+ * slots are only allocated by the first store, a handle that never sets a
+ * level or func does without.
+ */
+#define RIG_CACHE_SETTING_SIDES 2
+
+struct rig_cache_setting
+{
+    value_t val;
+    int valid;
+    struct timespec time;
+};
+
+struct rig_cache_settings
+{
+    struct rig_cache_setting level[RIG_CACHE_SETTING_SIDES][RIG_SETTING_MAX];
+    struct rig_cache_setting func[RIG_CACHE_SETTING_SIDES][RIG_SETTING_MAX];
+};
+
+void rig_cache_settings_free(RIG *rig)
+{
+    free(rig->state.cache_settings);
+    rig->state.cache_settings = NULL;
+}
+
+// called under rig_cache_write_begin(), so only one writer allocates
+static struct rig_cache_settings *rig_cache_settings_get(RIG *rig)
+{
+    if (!rig->state.cache_settings)
+    {
+        rig->state.cache_settings = calloc(1, sizeof(struct rig_cache_settings));
+    }
+
+    return rig->state.cache_settings;
+}
+
+static struct rig_cache_setting *rig_cache_setting_slot(RIG *rig,
+        struct rig_cache_settings *cs, vfo_t vfo, setting_t setting, int func)
+{
+    int side, idx;
+
+    // a slot holds exactly one setting
+    if (!cs || setting == 0 || (setting & (setting - 1)) != 0)
+    {
+        return NULL;
+    }
+
+    if (vfo == RIG_VFO_CURR || vfo == RIG_VFO_VFO) { vfo = rig->state.current_vfo; }
+
+    switch (vfo)
+    {
+    case RIG_VFO_A:
+    case RIG_VFO_MAIN:
+    case RIG_VFO_MAIN_A:
+        side = 0;
+        break;
+
+    case RIG_VFO_B:
+    case RIG_VFO_SUB:
+    case RIG_VFO_MAIN_B:
+        side = 1;
+        break;
+
+    default:
+        // memory, the Sub A/B pair, or a current VFO we don't know yet
+        return NULL;
+    }
+
+    // same index as rig_setting2idx(), without its debug lines on every get
+    for (idx = 0; idx < RIG_SETTING_MAX - 1 && !(setting & rig_idx2setting(idx));
+            idx++) { }
+
+    return func ? &cs->func[side][idx] : &cs->level[side][idx];
+}
+
+static void rig_cache_setting_store(RIG *rig, vfo_t vfo, setting_t setting,
+                                    int func, const value_t *val)
+{
+    struct rig_cache_setting *slot;
+
+    // nothing to clear before the first store
+    if (!val && !rig->state.cache_settings) { return; }
+
+    rig_cache_write_begin(rig);
+
+    slot = rig_cache_setting_slot(rig, rig_cache_settings_get(rig), vfo, setting,
+                                  func);
+
+    if (!slot)
+    {
+        rig_cache_write_end(rig);
+        return;
+    }
+
+    if (val)
+    {
+        slot->val = *val;
+        slot->valid = 1;
+        elapsed_ms(&slot->time, HAMLIB_ELAPSED_SET);
+    }
+    else
+    {
+        slot->valid = 0;
+    }
+
+    rig_cache_write_end(rig);
+}
+
+static int rig_cache_setting_fetch(RIG *rig, vfo_t vfo, setting_t setting,
+                                   int func, int ttl, value_t *val)
+{
+    struct rig_cache_setting *slot;
+    value_t copy;
+    unsigned int seq;
+    int valid, age_ms;
+
+    if (ttl == 0) { return -RIG_ENAVAIL; }
+
+    slot = rig_cache_setting_slot(rig, rig->state.cache_settings, vfo, setting,
+                                  func);
+
+    if (!slot) { return -RIG_ENAVAIL; }
+
+    do
+    {
+        seq = rig_cache_read_begin(rig);
+        valid = slot->valid;
+        copy = slot->val;
+        age_ms = valid ? elapsed_ms(&slot->time, HAMLIB_ELAPSED_GET) : 0;
+    }
+    while (rig_cache_read_retry(rig, seq));
+
+    if (!valid || (ttl != HAMLIB_CACHE_ALWAYS && age_ms >= ttl))
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    *val = copy;
+
+    return RIG_OK;
+}
+
+int rig_cache_level_peek(RIG *rig, vfo_t vfo, setting_t level, value_t *val,
+                         struct timespec *time)
+{
+    struct rig_cache_setting *slot;
+
+    slot = rig_cache_setting_slot(rig, rig->state.cache_settings, vfo, level, 0);
+
+    if (!slot || !slot->valid) { return 0; }
+
+    *val = slot->val;
+    *time = slot->time;
+
+    return 1;
+}
+
+void rig_set_cache_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
+{
+    rig_cache_setting_store(rig, vfo, level, 0, &val);
+}
+
+int rig_get_cache_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
+{
+    return rig_cache_setting_fetch(rig, vfo, level, 0,
+                                   rig->state.cache_level_timeout_ms, val);
+}
+
+void rig_clear_cache_level(RIG *rig, vfo_t vfo, setting_t level)
+{
+    rig_cache_setting_store(rig, vfo, level, 0, NULL);
+}
+
+void rig_set_cache_func(RIG *rig, vfo_t vfo, setting_t func, int status)
+{
+    value_t val;
+
+    val.i = status;
+    rig_cache_setting_store(rig, vfo, func, 1, &val);
+}
+
+int rig_get_cache_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
+{
+    value_t val;
+    int retval = rig_cache_setting_fetch(rig, vfo, func, 1,
+                                         rig->state.cache_func_timeout_ms, &val);
+
+    if (retval == RIG_OK) { *status = val.i; }
+
+    return retval;
+}
+
+void rig_clear_cache_func(RIG *rig, vfo_t vfo, setting_t func)
+{
+    rig_cache_setting_store(rig, vfo, func, 1, NULL);
+}
+
+/**
+ * \brief get the frequency without waiting for the rig
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param freq  The location where to store the frequency
+ * \param age_ms The location where to store the age of the value in ms
+ * \param stale Set to 1 when the value is older than the cache timeout
+ *
+ * Answers from the cache however old its value is, so the call returns at
+ * once while the rig is busy or timing out.  A stale value is flagged and
+ * a rig_get_freq() is queued with rig_submit() to refresh the cache for
+ * later calls.  Only when no frequency is cached yet does it call
+ * rig_get_freq() and wait.
+ *
+ * \return RIG_OK, or what rig_get_freq() returned when nothing was cached.
+ *
+ * \sa rig_get_freq(), rig_get_mode_swr(), rig_get_ptt_swr()
+ */
+int HAMLIB_API rig_get_freq_swr(RIG *rig, vfo_t vfo, freq_t *freq, int *age_ms,
+                                int *stale)
+{
+    struct rig_cache_snapshot snap;
+
+    if (CHECK_RIG_ARG(rig) || !freq || !age_ms || !stale)
+    {
+        return -RIG_EINVAL;
+    }
+
+    rig_cache_snapshot(rig, vfo, &snap);
+
+    if (snap.freq == 0)
+    {
+        *age_ms = 0;
+        *stale = 0;
+        return rig_get_freq(rig, vfo, freq);
+    }
+
+    *freq = snap.freq;
+    *age_ms = snap.freq_ms;
+    *stale = !snap.freq_ok;
+
+    if (*stale)
+    {
+        swr_refresh(rig, RIG_REQ_GET_FREQ, vfo, SWR_FREQ);
+    }
+
+    return RIG_OK;
+}
+
+/**
+ * \brief get the mode and passband without waiting for the rig
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param mode  The location where to store the mode
+ * \param width The location where to store the passband width
+ * \param age_ms The location where to store the age of the older of the two in ms
+ * \param stale Set to 1 when the value is older than the cache timeout
+ *
+ * As rig_get_freq_swr(), for rig_get_mode().
+ *
+ * \return RIG_OK, or what rig_get_mode() returned when nothing was cached.
+ */
+int HAMLIB_API rig_get_mode_swr(RIG *rig, vfo_t vfo, rmode_t *mode,
+                                pbwidth_t *width, int *age_ms, int *stale)
+{
+    struct rig_cache_snapshot snap;
+
+    if (CHECK_RIG_ARG(rig) || !mode || !width || !age_ms || !stale)
+    {
+        return -RIG_EINVAL;
+    }
+
+    rig_cache_snapshot(rig, vfo, &snap);
+
+    if (snap.mode == RIG_MODE_NONE)
+    {
+        *age_ms = 0;
+        *stale = 0;
+        return rig_get_mode(rig, vfo, mode, width);
+    }
+
+    *mode = snap.mode;
+    *width = snap.width;
+    *age_ms = snap.mode_ms;
+    *stale = !snap.mode_ok;
+
+    if (*stale)
+    {
+        swr_refresh(rig, RIG_REQ_GET_MODE, vfo, SWR_MODE);
+    }
+
+    return RIG_OK;
+}
+
+/**
+ * \brief get the PTT state without waiting for the rig
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param ptt   The location where to store the PTT state
+ * \param age_ms The location where to store the age of the value in ms
+ * \param stale Set to 1 when the value is older than the cache timeout
+ *
+ * As rig_get_freq_swr(), for rig_get_ptt().
+ *
+ * \return RIG_OK, or what rig_get_ptt() returned when nothing was cached.
+ */
+int HAMLIB_API rig_get_ptt_swr(RIG *rig, vfo_t vfo, ptt_t *ptt, int *age_ms,
+                               int *stale)
+{
+    struct rig_cache_snapshot snap;
+
+    if (CHECK_RIG_ARG(rig) || !ptt || !age_ms || !stale)
+    {
+        return -RIG_EINVAL;
+    }
+
+    rig_cache_snapshot(rig, vfo, &snap);
+
+    if (!snap.ptt_set)
+    {
+        *age_ms = 0;
+        *stale = 0;
+        return rig_get_ptt(rig, vfo, ptt);
+    }
+
+    *ptt = snap.ptt;
+    *age_ms = snap.ptt_ms;
+    *stale = !snap.ptt_ok;
+
+    if (*stale)
+    {
+        swr_refresh(rig, RIG_REQ_GET_PTT, vfo, SWR_PTT);
+    }
+
+    return RIG_OK;
+}
+
 /*! @} */
@@ -29,4 +29,101 @@ int rig_set_cache_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width);
 int rig_set_cache_freq(RIG *rig, vfo_t vfo, freq_t freq);
 void rig_cache_show(RIG *rig, const char *func, int line);
 
+/*
+ * Cache seqlock -- writers bracket their updates with write_begin/write_end,
+ * readers copy what they need and retry if a write overlapped the copy:
+ *
+ *     do { seq = rig_cache_read_begin(rig); ...copy...; }
+ *     while (rig_cache_read_retry(rig, seq));
+ *
+ * Write sections must be short and must not nest.
+ */
+void rig_cache_write_begin(RIG *rig);
+void rig_cache_write_end(RIG *rig);
+unsigned int rig_cache_read_begin(RIG *rig);
+int rig_cache_read_retry(RIG *rig, unsigned int seq);
+
+/*
+ * Cache clock -- see cache.c.  rig_cache_age() is the age of a cache stamp
+ * in ms, 1000000 for one never set or older than the last
+ * rig_cache_reset(), which invalidates the whole cache at once.
+ * rig_cache_stale() only tells the last two apart from a stamp in use.
+ */
+int rig_cache_age(RIG *rig, const struct timespec *t);
+int rig_cache_stale(RIG *rig, const struct timespec *t);
+void rig_cache_reset(RIG *rig);
+
+/*
+ * Adaptive cache TTL slots, indexes into rig_state.cache_adapt[].
+ * Cache checks ask rig_cache_ttl() for the timeout instead of using
+ * cache.timeout_ms directly.
+ */
+enum rig_cache_slot_e
+{
+    RIG_CACHE_SLOT_FREQ_A,
+    RIG_CACHE_SLOT_FREQ_B,
+    RIG_CACHE_SLOT_FREQ_OTHER,
+    RIG_CACHE_SLOT_MODE,
+    RIG_CACHE_SLOT_PTT,
+    RIG_CACHE_SLOT_SPLIT,
+    RIG_CACHE_SLOT_VFO
+};
+
+int rig_cache_freq_slot(RIG *rig, vfo_t vfo);
+int rig_cache_ttl(RIG *rig, int slot, uint64_t value, int age_ms);
+
+/*
+ * Push-fresh cache entries, for rigs that report their own changes -- see
+ * rig_cache_push().  use_cached is one of rig_state.use_cached_freq, _mode
+ * or _ptt.
+ */
+void rig_cache_push(RIG *rig);
+int rig_cache_pushed(RIG *rig, int use_cached);
+void rig_cache_push_check(RIG *rig, int use_cached, int unchanged);
+
+/*
+ * Level and func cache, one slot per setting and VFO side -- see
+ * rig_set_cache_level().  The getters return -RIG_ENAVAIL when the slot is
+ * empty or older than cache_level_timeout_ms/cache_func_timeout_ms.
+ */
+void rig_cache_settings_free(RIG *rig);
+void rig_set_cache_level(RIG *rig, vfo_t vfo, setting_t level, value_t val);
+int rig_get_cache_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val);
+void rig_clear_cache_level(RIG *rig, vfo_t vfo, setting_t level);
+/* Level slot as stored, for code already inside rig_cache_write_begin();
+ * returns 0 if there is none */
+int rig_cache_level_peek(RIG *rig, vfo_t vfo, setting_t level, value_t *val,
+                         struct timespec *time);
+void rig_set_cache_func(RIG *rig, vfo_t vfo, setting_t func, int status);
+int rig_get_cache_func(RIG *rig, vfo_t vfo, setting_t func, int *status);
+void rig_clear_cache_func(RIG *rig, vfo_t vfo, setting_t func);
+
+/*
+ * Lock-free cache reads for rigctld -- see rig_cache_snapshot().  Each
+ * *_ok flag says the matching rig_get_xxx() would answer from the cache.
+ */
+struct rig_cache_snapshot
+{
+    vfo_t target;       // vfo the freq/mode belong to, after vfo_fixup()
+    freq_t freq;
+    rmode_t mode;
+    pbwidth_t width;
+    vfo_t vfo;          // current VFO as rig_get_vfo() reports it
+    ptt_t ptt;
+    split_t split;
+    vfo_t tx_vfo;
+    int freq_ok;
+    int mode_ok;
+    int vfo_ok;
+    int ptt_ok;
+    int split_ok;
+    int freq_ms;        // ages, for rig_get_freq_swr() and friends
+    int mode_ms;
+    int ptt_ms;
+    int ptt_set;        // a PTT state has been cached at all
+};
+
+extern HAMLIB_EXPORT(void) rig_cache_snapshot(RIG *rig, vfo_t vfo,
+        struct rig_cache_snapshot *snap);
+
 #endif
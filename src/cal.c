@@ -32,6 +32,9 @@
 
 #include <hamlib/config.h>
 
+#include <stdlib.h>
+#include <string.h>
+
 #include <hamlib/rig.h>
 #include "cal.h"
 
@@ -70,8 +73,6 @@ float HAMLIB_API rig_raw2val(int rawval, const cal_table_t *cal)
     /* ASSERT(cal != NULL) */
     /* ASSERT(cal->size <= HAMLIB_MAX_CAL_LENGTH) */
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
     if (cal->size == 0)
     {
         return rawval;
@@ -145,8 +146,6 @@ float HAMLIB_API rig_raw2val_float(int rawval, const cal_table_float_t *cal)
     /* ASSERT(cal != NULL) */
     /* ASSERT(cal->size <= HAMLIB_MAX_CAL_LENGTH) */
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
     if (cal->size == 0)
     {
         return rawval;
@@ -183,4 +182,382 @@ float HAMLIB_API rig_raw2val_float(int rawval, const cal_table_float_t *cal)
     return cal->table[i].val - interpolation;
 }
 
+/*
+ * Compiled tables.  rig_raw2val() is called for every meter reading and
+ * walks the table doing a division each time; a meter stream at 20 Hz on
+ * a few meters does that a lot.  These build the slopes once.
+ */
+
+static void cal_compile_common(struct cal_compiled *cc)
+{
+    int i;
+
+    cc->sorted = 1;
+    cc->slope[0] = 0;
+
+    for (i = 1; i < cc->size; i++)
+    {
+        int dr = cc->raw[i] - cc->raw[i - 1];
+
+        if (dr < 0)
+        {
+            cc->sorted = 0;
+        }
+
+        /* equal raws answer the upper value, like rig_raw2val */
+        cc->slope[i] = dr == 0 ? 0 : (cc->val[i] - cc->val[i - 1]) / (float)dr;
+    }
+
+    cc->lut_n = 0;
+
+    if (cc->size > 0 && cc->raw[cc->size - 1] - cc->raw[0] < CAL_LUT_SIZE
+            && cc->raw[cc->size - 1] >= cc->raw[0])
+    {
+        cc->lut_lo = cc->raw[0];
+        cc->lut_n = cc->raw[cc->size - 1] - cc->raw[0] + 1;
+    }
+}
+
+
+/**
+ * \brief Prepare a calibration table for cal_value()
+ * \param cc Compiled table to fill in
+ * \param cal Calibration table, may be NULL or empty
+ */
+void cal_compile(struct cal_compiled *cc, const cal_table_t *cal)
+{
+    int i;
+
+    memset(cc, 0, sizeof(*cc));
+
+    if (!cal || cal->size <= 0)
+    {
+        return;
+    }
+
+    cc->size = cal->size > HAMLIB_MAX_CAL_LENGTH ? HAMLIB_MAX_CAL_LENGTH :
+               cal->size;
+
+    for (i = 0; i < cc->size; i++)
+    {
+        cc->raw[i] = cal->table[i].raw;
+        cc->val[i] = cal->table[i].val;
+    }
+
+    cal_compile_common(cc);
+
+    for (i = 0; i < cc->lut_n; i++)
+    {
+        cc->lut[i] = rig_raw2val(cc->lut_lo + i, cal);
+    }
+}
+
+
+/**
+ * \brief Prepare a floating-point calibration table for cal_value()
+ * \param cc Compiled table to fill in
+ * \param cal Calibration table, may be NULL or empty
+ */
+void cal_compile_float(struct cal_compiled *cc, const cal_table_float_t *cal)
+{
+    int i;
+
+    memset(cc, 0, sizeof(*cc));
+
+    if (!cal || cal->size <= 0)
+    {
+        return;
+    }
+
+    cc->size = cal->size > HAMLIB_MAX_CAL_LENGTH ? HAMLIB_MAX_CAL_LENGTH :
+               cal->size;
+
+    for (i = 0; i < cc->size; i++)
+    {
+        cc->raw[i] = cal->table[i].raw;
+        cc->val[i] = cal->table[i].val;
+    }
+
+    cal_compile_common(cc);
+
+    for (i = 0; i < cc->lut_n; i++)
+    {
+        cc->lut[i] = rig_raw2val_float(cc->lut_lo + i, cal);
+    }
+}
+
+
+/**
+ * \brief Convert raw data with a compiled calibration table
+ * \param cc Table from cal_compile() or cal_compile_float()
+ * \param rawval Input value
+ *
+ * Same clamping as rig_raw2val().  Inside the lookup table range the
+ * result is identical, elsewhere it may differ in the last bit.
+ *
+ * \return Calibrated value
+ */
+float cal_value(const struct cal_compiled *cc, int rawval)
+{
+    int lo, hi;
+
+    if (rawval >= cc->lut_lo && rawval - cc->lut_lo < cc->lut_n)
+    {
+        return cc->lut[rawval - cc->lut_lo];
+    }
+
+    if (cc->size == 0)
+    {
+        return rawval;
+    }
+
+    /* first i with rawval < raw[i], as the scan in rig_raw2val finds */
+    if (cc->sorted)
+    {
+        lo = 0;
+        hi = cc->size;
+
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+
+            if (rawval < cc->raw[mid])
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+    }
+    else
+    {
+        for (lo = 0; lo < cc->size && rawval >= cc->raw[lo]; lo++) { }
+    }
+
+    if (lo == 0)
+    {
+        return cc->val[0];
+    }
+
+    if (lo >= cc->size)
+    {
+        return cc->val[cc->size - 1];
+    }
+
+    return cc->val[lo] - (cc->raw[lo] - rawval) * cc->slope[lo];
+}
+
+
+/**
+ * \brief Convert several raw readings with one compiled table
+ * \param cc Table from cal_compile() or cal_compile_float()
+ * \param rawval Input values
+ * \param val Output, n values
+ * \param n Number of values
+ */
+void cal_values(const struct cal_compiled *cc, const int *rawval, float *val,
+                int n)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        val[i] = cal_value(cc, rawval[i]);
+    }
+}
+
+
+/*
+ * One compiled table per calibrated meter level of struct rig_caps.  A
+ * compiled table is over 1 kB, so only the levels that have a caps table
+ * or a backend default get one.
+ */
+enum
+{
+    RIG_CAL_STR,
+    RIG_CAL_SWR,
+    RIG_CAL_ALC,
+    RIG_CAL_RFPOWER_METER,
+    RIG_CAL_COMP_METER,
+    RIG_CAL_VD_METER,
+    RIG_CAL_ID_METER,
+    RIG_CAL_LEVELS
+};
+
+struct rig_cal
+{
+    struct cal_compiled *level[RIG_CAL_LEVELS];    /* NULL for no table */
+};
+
+
+static int rig_cal_index(setting_t level)
+{
+    switch (level)
+    {
+    case RIG_LEVEL_STRENGTH:
+        return RIG_CAL_STR;
+
+    case RIG_LEVEL_SWR:
+        return RIG_CAL_SWR;
+
+    case RIG_LEVEL_ALC:
+        return RIG_CAL_ALC;
+
+    case RIG_LEVEL_RFPOWER_METER:
+    case RIG_LEVEL_RFPOWER_METER_WATTS:
+        return RIG_CAL_RFPOWER_METER;
+
+    case RIG_LEVEL_COMP_METER:
+        return RIG_CAL_COMP_METER;
+
+    case RIG_LEVEL_VD_METER:
+        return RIG_CAL_VD_METER;
+
+    case RIG_LEVEL_ID_METER:
+        return RIG_CAL_ID_METER;
+
+    default:
+        return -1;
+    }
+}
+
+
+static void rig_cal_add(struct rig_cal *rc, int i, const cal_table_t *cal,
+                        const cal_table_float_t *cal_float)
+{
+    struct cal_compiled *cc;
+
+    if ((cal ? cal->size : cal_float->size) <= 0)
+    {
+        return;
+    }
+
+    cc = malloc(sizeof(*cc));
+
+    if (!cc)
+    {
+        /* rig_cal_value() falls back on rig_raw2val_float() */
+        return;
+    }
+
+    if (cal)
+    {
+        cal_compile(cc, cal);
+    }
+    else
+    {
+        cal_compile_float(cc, cal_float);
+    }
+
+    rc->level[i] = cc;
+}
+
+
+/* Called by rig_init() before the backend init, so that can add defaults */
+int rig_cal_init(RIG *rig)
+{
+    const struct rig_caps *caps = rig->caps;
+    struct rig_cal *rc;
+
+    rc = calloc(1, sizeof(*rc));
+
+    if (!rc)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    rig_cal_add(rc, RIG_CAL_STR, &caps->str_cal, NULL);
+    rig_cal_add(rc, RIG_CAL_SWR, NULL, &caps->swr_cal);
+    rig_cal_add(rc, RIG_CAL_ALC, NULL, &caps->alc_cal);
+    rig_cal_add(rc, RIG_CAL_RFPOWER_METER, NULL, &caps->rfpower_meter_cal);
+    rig_cal_add(rc, RIG_CAL_COMP_METER, NULL, &caps->comp_meter_cal);
+    rig_cal_add(rc, RIG_CAL_VD_METER, NULL, &caps->vd_meter_cal);
+    rig_cal_add(rc, RIG_CAL_ID_METER, NULL, &caps->id_meter_cal);
+
+    rig->state.cal = rc;
+
+    return RIG_OK;
+}
+
+
+void rig_cal_cleanup(RIG *rig)
+{
+    struct rig_cal *rc = rig->state.cal;
+    int i;
+
+    if (!rc)
+    {
+        return;
+    }
+
+    for (i = 0; i < RIG_CAL_LEVELS; i++)
+    {
+        free(rc->level[i]);
+    }
+
+    free(rc);
+    rig->state.cal = NULL;
+}
+
+
+/**
+ * \brief Compiled caps calibration table of a meter level
+ * \param rig The rig handle
+ * \param level RIG_LEVEL_STRENGTH, RIG_LEVEL_SWR, ... RIG_LEVEL_ID_METER
+ *
+ * \return the table, or NULL if the caps have none for \a level and the
+ * backend set no default with rig_cal_default()
+ */
+const struct cal_compiled *rig_cal_level(RIG *rig, setting_t level)
+{
+    const struct rig_cal *rc = rig->state.cal;
+    int i = rig_cal_index(level);
+
+    return rc && i >= 0 ? rc->level[i] : NULL;
+}
+
+
+/**
+ * \brief Backend default for a meter level the caps have no table for
+ * \param rig The rig handle
+ * \param level As for rig_cal_level()
+ * \param cal Table used when the caps table of \a level is empty
+ */
+void rig_cal_default(RIG *rig, setting_t level, const cal_table_float_t *cal)
+{
+    struct rig_cal *rc = rig->state.cal;
+    int i = rig_cal_index(level);
+
+    if (rc && i >= 0 && !rc->level[i] && i != RIG_CAL_STR && cal)
+    {
+        rig_cal_add(rc, i, NULL, cal);
+    }
+}
+
+/**
+ * \brief Calibrated value of a meter reading
+ * \param rig The rig handle
+ * \param level As for rig_cal_level()
+ * \param rawval The reading
+ * \param def Backend default table, used as is when nothing was compiled
+ * for \a level, may be NULL
+ *
+ * \return the value from the compiled caps table (or compiled default),
+ * else from \a def, else \a rawval
+ */
+float rig_cal_value(RIG *rig, setting_t level, int rawval,
+                    const cal_table_float_t *def)
+{
+    const struct cal_compiled *cc = rig_cal_level(rig, level);
+
+    if (cc)
+    {
+        return cal_value(cc, rawval);
+    }
+
+    return def ? rig_raw2val_float(rawval, def) : rawval;
+}
+
 /** @} */
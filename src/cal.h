@@ -27,4 +27,38 @@
 extern HAMLIB_EXPORT(float) rig_raw2val(int rawval, const cal_table_t *cal);
 extern HAMLIB_EXPORT(float) rig_raw2val_float(int rawval, const cal_table_float_t *cal);
 
+/*
+ * A calibration table made ready for repeated conversions: the slope of
+ * each segment is worked out once, the segment is found by binary search,
+ * and a table whose raw values fit a 256 wide range gets a lookup table
+ * holding exactly what rig_raw2val()/rig_raw2val_float() would return.
+ */
+#define CAL_LUT_SIZE 256
+
+struct cal_compiled
+{
+    int size;                   /* 0 when there was no table */
+    int sorted;                 /* raw values ascending, binary search ok */
+    int raw[HAMLIB_MAX_CAL_LENGTH];
+    float val[HAMLIB_MAX_CAL_LENGTH];
+    float slope[HAMLIB_MAX_CAL_LENGTH];  /* of segment i-1..i, 0 for i=0 */
+    int lut_lo;                 /* raw value of lut[0] */
+    int lut_n;                  /* 0 for no lookup table */
+    float lut[CAL_LUT_SIZE];
+};
+
+void cal_compile(struct cal_compiled *cc, const cal_table_t *cal);
+void cal_compile_float(struct cal_compiled *cc, const cal_table_float_t *cal);
+float cal_value(const struct cal_compiled *cc, int rawval);
+void cal_values(const struct cal_compiled *cc, const int *rawval, float *val,
+                int n);
+
+/* The caps calibration tables of a rig, compiled by rig_init() */
+int rig_cal_init(RIG *rig);
+void rig_cal_cleanup(RIG *rig);
+const struct cal_compiled *rig_cal_level(RIG *rig, setting_t level);
+void rig_cal_default(RIG *rig, setting_t level, const cal_table_float_t *cal);
+float rig_cal_value(RIG *rig, setting_t level, int rawval,
+                    const cal_table_float_t *def);
+
 #endif /* _CAL_H */
@@ -0,0 +1,477 @@
+/*
+ *  Hamlib Interface - range, filter and channel list index
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * rig_get_range() on the power conversions, rig_passband_*() on every
+ * set_mode with RIG_PASSBAND_NORMAL and rig_lookup_mem_caps() on every
+ * channel read or write used to walk their lists, mode masks and all.
+ * Once the rig is open the lists hold still, so they are indexed then.
+ *
+ * A range list becomes a sorted array of the distinct start and end
+ * frequencies.  Each point, and each gap between two points, is a cell
+ * that knows which ranges cover it, in list order, so a lookup is a
+ * binary search and a check of the mode of a range or two.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "caps_index.h"
+
+#define RANGE_POINTS (2 * HAMLIB_FRQRANGESIZ)
+#define RANGE_CELLS (2 * RANGE_POINTS - 1)
+#define MODE_BITS 64
+
+struct range_cells
+{
+    int npoints;
+    freq_t point[RANGE_POINTS];
+    /* cell 2i is point[i], cell 2i+1 is between point[i] and point[i+1];
+     * its ranges are cover[first[c]] to cover[first[c + 1] - 1] */
+    unsigned short first[RANGE_CELLS + 1];
+    unsigned char *cover;
+};
+
+struct caps_index
+{
+    struct range_cells range[2];        /* rx, tx */
+
+    /* per mode bit, 0 where there is no filter or tuning step */
+    rmode_t has_filter;
+    int passband[3][MODE_BITS];         /* RIG_CAPS_PB_NORMAL... */
+    rmode_t has_ts;
+    shortfreq_t ts[MODE_BITS];
+
+    int nchan;
+    int chan_sorted;                    /* ascending and apart */
+    unsigned char chan_order[HAMLIB_CHANLSTSIZ];
+    chan_t chan_all;
+};
+
+
+static int mode_bit(rmode_t mode)
+{
+    int bit = 0;
+
+    if (mode == 0 || (mode & (mode - 1)) != 0)
+    {
+        return -1;
+    }
+
+    if (mode >> 32) { bit += 32; mode >>= 32; }
+
+    if (mode >> 16) { bit += 16; mode >>= 16; }
+
+    if (mode >> 8) { bit += 8; mode >>= 8; }
+
+    if (mode >> 4) { bit += 4; mode >>= 4; }
+
+    if (mode >> 2) { bit += 2; mode >>= 2; }
+
+    if (mode >> 1) { bit += 1; }
+
+    return bit;
+}
+
+
+static int freq_cmp(const void *a, const void *b)
+{
+    freq_t fa = *(const freq_t *) a, fb = *(const freq_t *) b;
+
+    return fa < fb ? -1 : fa > fb;
+}
+
+/* Last point <= freq, -1 if none */
+static int range_point(const struct range_cells *rc, freq_t freq)
+{
+    int lo = 0, hi = rc->npoints - 1;
+
+    if (rc->npoints == 0 || !(freq >= rc->point[0]))
+    {
+        return -1;
+    }
+
+    while (lo < hi)
+    {
+        int mid = (lo + hi + 1) / 2;
+
+        if (rc->point[mid] <= freq) { lo = mid; }
+        else { hi = mid - 1; }
+    }
+
+    return lo;
+}
+
+static int range_cell(const struct range_cells *rc, freq_t freq)
+{
+    int i = range_point(rc, freq);
+
+    if (i < 0 || (i == rc->npoints - 1 && freq > rc->point[i]))
+    {
+        return -1;
+    }
+
+    return freq == rc->point[i] ? 2 * i : 2 * i + 1;
+}
+
+static int range_cells_build(struct range_cells *rc, const freq_range_t *list)
+{
+    int n, i, c, ncells, total;
+
+    for (n = 0; n < HAMLIB_FRQRANGESIZ
+            && !(list[n].startf == 0 && list[n].endf == 0); n++)
+    {
+        rc->point[2 * n] = list[n].startf;
+        rc->point[2 * n + 1] = list[n].endf;
+    }
+
+    rc->npoints = 0;
+    rc->cover = NULL;
+    rc->first[0] = 0;
+
+    if (n == 0)
+    {
+        return RIG_OK;
+    }
+
+    qsort(rc->point, 2 * n, sizeof(freq_t), freq_cmp);
+
+    for (i = 1, rc->npoints = 1; i < 2 * n; i++)
+    {
+        if (rc->point[i] != rc->point[rc->npoints - 1])
+        {
+            rc->point[rc->npoints++] = rc->point[i];
+        }
+    }
+
+    ncells = 2 * rc->npoints - 1;
+
+    /* a cell is covered when a frequency in it is; the gap midpoint will do */
+    for (total = 0, c = 0; c < ncells; c++)
+    {
+        freq_t f = (c & 1) ? (rc->point[c / 2] + rc->point[c / 2 + 1]) / 2 :
+                   rc->point[c / 2];
+
+        for (i = 0; i < n; i++)
+        {
+            if (f >= list[i].startf && f <= list[i].endf) { total++; }
+        }
+    }
+
+    rc->cover = malloc(total > 0 ? total : 1);
+
+    if (!rc->cover)
+    {
+        rc->npoints = 0;
+        return -RIG_ENOMEM;
+    }
+
+    for (total = 0, c = 0; c < ncells; c++)
+    {
+        freq_t f = (c & 1) ? (rc->point[c / 2] + rc->point[c / 2 + 1]) / 2 :
+                   rc->point[c / 2];
+
+        rc->first[c] = total;
+
+        for (i = 0; i < n; i++)
+        {
+            if (f >= list[i].startf && f <= list[i].endf) { rc->cover[total++] = i; }
+        }
+    }
+
+    rc->first[ncells] = total;
+
+    return RIG_OK;
+}
+
+
+static void passband_build(struct caps_index *ci, const struct filter_list *flt)
+{
+    int bit;
+
+    for (bit = 0; bit < MODE_BITS; bit++)
+    {
+        rmode_t mode = (rmode_t) 1 << bit;
+        int i;
+
+        for (i = 0; i < HAMLIB_FLTLSTSIZ && flt[i].modes; i++)
+        {
+            if (flt[i].modes & mode) { break; }
+        }
+
+        if (i == HAMLIB_FLTLSTSIZ || !flt[i].modes)
+        {
+            continue;
+        }
+
+        ci->has_filter |= mode;
+        ci->passband[RIG_CAPS_PB_NORMAL][bit] = flt[i].width;
+
+        /* narrow and wide: the first later filter narrower or wider */
+        if (i < HAMLIB_FLTLSTSIZ - 1)
+        {
+            int j;
+
+            for (j = i + 1; j < HAMLIB_FLTLSTSIZ && flt[j].modes; j++)
+            {
+                if ((flt[j].modes & mode) && flt[j].width < flt[i].width)
+                {
+                    ci->passband[RIG_CAPS_PB_NARROW][bit] = flt[j].width;
+                    break;
+                }
+            }
+
+            for (j = i + 1; j < HAMLIB_FLTLSTSIZ && flt[j].modes; j++)
+            {
+                if ((flt[j].modes & mode) && flt[j].width > flt[i].width)
+                {
+                    ci->passband[RIG_CAPS_PB_WIDE][bit] = flt[j].width;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static void ts_build(struct caps_index *ci, const struct tuning_step_list *ts)
+{
+    int bit;
+
+    for (bit = 0; bit < MODE_BITS; bit++)
+    {
+        rmode_t mode = (rmode_t) 1 << bit;
+        int i;
+
+        for (i = 0; i < HAMLIB_TSLSTSIZ && ts[i].ts; i++)
+        {
+            if (ts[i].modes & mode)
+            {
+                ci->has_ts |= mode;
+                ci->ts[bit] = ts[i].ts;
+                break;
+            }
+        }
+    }
+}
+
+static void chan_build(struct caps_index *ci, const chan_t *list)
+{
+    int i, j;
+
+    memset(&ci->chan_all, 0, sizeof(ci->chan_all));
+    ci->chan_all.startc = list[0].startc;
+    ci->chan_all.type = RIG_MTYPE_NONE;    /* meaningless */
+
+    for (i = 0; i < HAMLIB_CHANLSTSIZ && !RIG_IS_CHAN_END(list[i]); i++)
+    {
+        unsigned char *p1 = (unsigned char *) &ci->chan_all.mem_caps;
+        const unsigned char *p2 = (const unsigned char *) &list[i].mem_caps;
+
+        /* chan_all.mem_caps |= list[i].mem_caps, as rig_lookup_mem_caps did */
+        for (j = 0; j < sizeof(channel_cap_t); j++)
+        {
+            p1[j] |= p2[j];
+        }
+
+        ci->chan_all.endc = list[i].endc;
+
+        /* insertion sort by startc, there are a handful at most */
+        for (j = i; j > 0 && list[ci->chan_order[j - 1]].startc > list[i].startc; j--)
+        {
+            ci->chan_order[j] = ci->chan_order[j - 1];
+        }
+
+        ci->chan_order[j] = i;
+    }
+
+    ci->nchan = i;
+    ci->chan_sorted = 1;
+
+    for (i = 1; i < ci->nchan; i++)
+    {
+        if (list[ci->chan_order[i]].startc <= list[ci->chan_order[i - 1]].endc)
+        {
+            /* overlapping entries: the first in list order must win */
+            ci->chan_sorted = 0;
+        }
+    }
+}
+
+
+int rig_caps_index_build(RIG *rig)
+{
+    struct rig_state *rs = &rig->state;
+    struct caps_index *ci;
+
+    rig_caps_index_free(rig);
+
+    ci = calloc(1, sizeof(*ci));
+
+    if (!ci)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    if (range_cells_build(&ci->range[0], rs->rx_range_list) != RIG_OK
+            || range_cells_build(&ci->range[1], rs->tx_range_list) != RIG_OK)
+    {
+        free(ci->range[0].cover);
+        free(ci);
+        return -RIG_ENOMEM;
+    }
+
+    passband_build(ci, rs->filters);
+    ts_build(ci, rs->tuning_steps);
+    chan_build(ci, rs->chan_list);
+
+    rs->caps_index = ci;
+
+    return RIG_OK;
+}
+
+void rig_caps_index_free(RIG *rig)
+{
+    struct caps_index *ci = rig->state.caps_index;
+
+    if (!ci)
+    {
+        return;
+    }
+
+    free(ci->range[0].cover);
+    free(ci->range[1].cover);
+    free(ci);
+    rig->state.caps_index = NULL;
+}
+
+
+int rig_caps_index_range(RIG *rig, int tx, freq_t freq, rmode_t mode,
+                         const freq_range_t **range)
+{
+    const struct caps_index *ci = rig->state.caps_index;
+    const struct range_cells *rc;
+    const freq_range_t *list;
+    int c, i;
+
+    if (!ci)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    rc = &ci->range[tx ? 1 : 0];
+    list = tx ? rig->state.tx_range_list : rig->state.rx_range_list;
+    *range = NULL;
+
+    c = range_cell(rc, freq);
+
+    if (c < 0)
+    {
+        return RIG_OK;
+    }
+
+    for (i = rc->first[c]; i < rc->first[c + 1]; i++)
+    {
+        if (list[rc->cover[i]].modes & mode)
+        {
+            *range = &list[rc->cover[i]];
+            break;
+        }
+    }
+
+    return RIG_OK;
+}
+
+int rig_caps_index_passband(RIG *rig, rmode_t mode, int which,
+                            pbwidth_t *width, int *found)
+{
+    const struct caps_index *ci = rig->state.caps_index;
+    int bit = mode_bit(mode);
+
+    if (!ci || bit < 0 || which < 0 || which > RIG_CAPS_PB_WIDE)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    *found = (ci->has_filter & mode) != 0;
+    *width = ci->passband[which][bit];
+
+    return RIG_OK;
+}
+
+int rig_caps_index_resolution(RIG *rig, rmode_t mode, shortfreq_t *ts)
+{
+    const struct caps_index *ci = rig->state.caps_index;
+    int bit = mode_bit(mode);
+
+    if (!ci || bit < 0)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    *ts = (ci->has_ts & mode) ? ci->ts[bit] : -RIG_EINVAL;
+
+    return RIG_OK;
+}
+
+int rig_caps_index_chan(RIG *rig, int ch, const chan_t **chan)
+{
+    const struct caps_index *ci = rig->state.caps_index;
+    const chan_t *list = rig->state.chan_list;
+    int lo, hi;
+
+    if (!ci)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    if (ch == RIG_MEM_CAPS_ALL)
+    {
+        *chan = &ci->chan_all;
+        return RIG_OK;
+    }
+
+    if (!ci->chan_sorted)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    *chan = NULL;
+    lo = 0;
+    hi = ci->nchan - 1;
+
+    while (lo <= hi)
+    {
+        int mid = (lo + hi) / 2;
+        const chan_t *c = &list[ci->chan_order[mid]];
+
+        if (ch < c->startc) { hi = mid - 1; }
+        else if (ch > c->endc) { lo = mid + 1; }
+        else
+        {
+            *chan = c;
+            break;
+        }
+    }
+
+    return RIG_OK;
+}
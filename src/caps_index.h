@@ -0,0 +1,56 @@
+/*
+ *  Hamlib Interface - range, filter and channel list index
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _CAPS_INDEX_H
+#define _CAPS_INDEX_H 1
+
+#include <hamlib/rig.h>
+
+/*
+ * Index over the rx/tx range lists, filters, tuning steps and channel list
+ * of rig_state, built by rig_open() once the backend has settled them and
+ * again when the range lists are switched by the "region" conf.  Code that
+ * rewrites those lists after open calls rig_caps_index_build() again.
+ *
+ * The lookups answer exactly as the linear scans they replace, NULL or
+ * found = 0 standing for nothing found.  They return -RIG_ENAVAIL where the
+ * caller should fall back on its own scan: no index yet, or a mode mask of
+ * more than one mode for the per mode tables.
+ */
+int rig_caps_index_build(RIG *rig);
+void rig_caps_index_free(RIG *rig);
+
+/* First range of the rx (tx = 0) or tx list holding freq for one of mode */
+int rig_caps_index_range(RIG *rig, int tx, freq_t freq, rmode_t mode,
+                         const freq_range_t **range);
+
+/* What rig_passband_normal/narrow/wide and rig_get_resolution return */
+#define RIG_CAPS_PB_NORMAL 0
+#define RIG_CAPS_PB_NARROW 1
+#define RIG_CAPS_PB_WIDE 2
+int rig_caps_index_passband(RIG *rig, rmode_t mode, int which,
+                            pbwidth_t *width, int *found);
+int rig_caps_index_resolution(RIG *rig, rmode_t mode, shortfreq_t *ts);
+
+/* Channel list entry holding ch, and the union of all for RIG_MEM_CAPS_ALL */
+int rig_caps_index_chan(RIG *rig, int ch, const chan_t **chan);
+
+#endif /* _CAPS_INDEX_H */
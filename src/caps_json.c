@@ -0,0 +1,749 @@
+/*
+ *  Hamlib Interface - rig capabilities as JSON
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * rig_caps_to_json() and rig_caps_export_json() write what the registered
+ * rig_caps say about a model, for support matrices and the like.  Only the
+ * caps are read: no RIG is set up, no backend init or port is involved, so
+ * every model of the build can be exported in one go, spread over a few
+ * threads.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+
+//! @cond Doxygen_Suppress
+
+#define CAPS_JSON_BUFSZ 16384           /* first try, most models fit */
+#define CAPS_JSON_BUFMAX (1024 * 1024)
+#define CAPS_JSON_THREADS_MAX 16
+
+struct caps_writer
+{
+    char *buf;
+    size_t len;
+    size_t pos;
+    int first;          /* nothing written yet in the current object/array */
+    int truncated;
+};
+
+static void cw_printf(struct caps_writer *w, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    if (w->truncated) { return; }
+
+    va_start(ap, fmt);
+    n = vsnprintf(w->buf + w->pos, w->len - w->pos, fmt, ap);
+    va_end(ap);
+
+    if (n < 0 || (size_t) n >= w->len - w->pos)
+    {
+        w->truncated = 1;
+        return;
+    }
+
+    w->pos += n;
+}
+
+/* the comma before every member or element but the first */
+static void cw_sep(struct caps_writer *w)
+{
+    if (!w->first)
+    {
+        cw_printf(w, ",");
+    }
+
+    w->first = 0;
+}
+
+static void cw_open(struct caps_writer *w, const char *key, char c)
+{
+    cw_sep(w);
+
+    if (key)
+    {
+        cw_printf(w, "\"%s\":", key);
+    }
+
+    cw_printf(w, "%c", c);
+    w->first = 1;
+}
+
+static void cw_close(struct caps_writer *w, char c)
+{
+    cw_printf(w, "%c", c);
+    w->first = 0;
+}
+
+/* a string value, NULL written as null */
+static void cw_string(struct caps_writer *w, const char *key, const char *s)
+{
+    cw_sep(w);
+
+    if (key)
+    {
+        cw_printf(w, "\"%s\":", key);
+    }
+
+    if (!s)
+    {
+        cw_printf(w, "null");
+        return;
+    }
+
+    cw_printf(w, "\"");
+
+    for (; *s; s++)
+    {
+        unsigned char c = *s;
+
+        if (c == '"' || c == '\\') { cw_printf(w, "\\%c", c); }
+        else if (c < 32) { cw_printf(w, "\\u%04x", c); }
+        else { cw_printf(w, "%c", c); }
+    }
+
+    cw_printf(w, "\"");
+}
+
+static void cw_int(struct caps_writer *w, const char *key, long long i)
+{
+    cw_sep(w);
+    cw_printf(w, "\"%s\":%lld", key, i);
+}
+
+static void cw_bool(struct caps_writer *w, const char *key, int b)
+{
+    cw_sep(w);
+    cw_printf(w, "\"%s\":%s", key, b ? "true" : "false");
+}
+
+/* the names of the bits set in a mode mask */
+static void cw_modes(struct caps_writer *w, const char *key, rmode_t modes)
+{
+    int i;
+
+    cw_open(w, key, '[');
+
+    for (i = 0; i < 64; i++)
+    {
+        if (modes & (CONSTANT_64BIT_FLAG(i)))
+        {
+            cw_string(w, NULL, rig_strrmode(CONSTANT_64BIT_FLAG(i)));
+        }
+    }
+
+    cw_close(w, ']');
+}
+
+/* the names of the bits set in a func, level or parm mask */
+static void cw_settings(struct caps_writer *w, const char *key,
+                        setting_t set, const char *(*name)(setting_t))
+{
+    int i;
+
+    cw_open(w, key, '[');
+
+    for (i = 0; i < RIG_SETTING_MAX; i++)
+    {
+        setting_t s = rig_idx2setting(i);
+
+        if (set & s)
+        {
+            const char *n = name(s);
+
+            cw_string(w, NULL, n && *n ? n : "?");
+        }
+    }
+
+    cw_close(w, ']');
+}
+
+static void cw_vfo_ops(struct caps_writer *w, const char *key, vfo_op_t ops)
+{
+    int i;
+
+    cw_open(w, key, '[');
+
+    for (i = 0; i < 32; i++)
+    {
+        if (ops & (1UL << i))
+        {
+            cw_string(w, NULL, rig_strvfop((vfo_op_t)(1UL << i)));
+        }
+    }
+
+    cw_close(w, ']');
+}
+
+static void cw_scan_ops(struct caps_writer *w, const char *key, scan_t ops)
+{
+    int i;
+
+    cw_open(w, key, '[');
+
+    for (i = 0; i < 32; i++)
+    {
+        if (ops & (1UL << i))
+        {
+            cw_string(w, NULL, rig_strscan((scan_t)(1UL << i)));
+        }
+    }
+
+    cw_close(w, ']');
+}
+
+/* a 0 terminated dB list, preamp, attenuator and the like */
+static void cw_db_list(struct caps_writer *w, const char *key, const int *db)
+{
+    int i;
+
+    cw_open(w, key, '[');
+
+    for (i = 0; i < HAMLIB_MAXDBLSTSIZ && db[i] != 0; i++)
+    {
+        cw_sep(w);
+        cw_printf(w, "%d", db[i]);
+    }
+
+    cw_close(w, ']');
+}
+
+/* a 0 terminated tone list, NULL for none */
+static void cw_tones(struct caps_writer *w, const char *key, const tone_t *t)
+{
+    int i;
+
+    cw_open(w, key, '[');
+
+    for (i = 0; t && t[i] != 0; i++)
+    {
+        cw_sep(w);
+        cw_printf(w, "%u", t[i]);
+    }
+
+    cw_close(w, ']');
+}
+
+static void cw_ranges(struct caps_writer *w, const char *key,
+                      const freq_range_t *r)
+{
+    int i;
+
+    cw_open(w, key, '[');
+
+    for (i = 0; i < HAMLIB_FRQRANGESIZ && !RIG_IS_FRNG_END(r[i]); i++)
+    {
+        cw_open(w, NULL, '{');
+        cw_sep(w);
+        cw_printf(w, "\"start\":%.0f,\"end\":%.0f", r[i].startf, r[i].endf);
+        cw_modes(w, "modes", r[i].modes);
+        cw_int(w, "low_power", r[i].low_power);
+        cw_int(w, "high_power", r[i].high_power);
+        cw_string(w, "vfo", rig_strvfo(r[i].vfo));
+        cw_int(w, "ant", r[i].ant);
+        cw_string(w, "label", r[i].label);
+        cw_close(w, '}');
+    }
+
+    cw_close(w, ']');
+}
+
+static const char *caps_json_rig_type(int rig_type)
+{
+    switch (rig_type & RIG_TYPE_MASK)
+    {
+    case RIG_TYPE_TRANSCEIVER:  return "Transceiver";
+
+    case RIG_TYPE_HANDHELD:     return "Handheld";
+
+    case RIG_TYPE_MOBILE:       return "Mobile";
+
+    case RIG_TYPE_RECEIVER:     return "Receiver";
+
+    case RIG_TYPE_PCRECEIVER:   return "PC Receiver";
+
+    case RIG_TYPE_SCANNER:      return "Scanner";
+
+    case RIG_TYPE_TRUNKSCANNER: return "Trunking scanner";
+
+    case RIG_TYPE_COMPUTER:     return "Computer";
+
+    case RIG_TYPE_TUNER:        return "Tuner";
+
+    case RIG_TYPE_OTHER:        return "Other";
+
+    default:                    return "Unknown";
+    }
+}
+
+static const char *caps_json_port_type(rig_port_t port)
+{
+    static const char *names[] =
+    {
+        "None", "Serial", "Network", "Device", "Packet", "DTMF", "Ultra",
+        "RPC", "Parallel", "USB", "UDP Network", "CM108", "GPIO", "GPION"
+    };
+
+    if ((unsigned) port < sizeof(names) / sizeof(names[0]))
+    {
+        return names[port];
+    }
+
+    return "Unknown";
+}
+
+static const char *caps_json_parity(enum serial_parity_e parity)
+{
+    switch (parity)
+    {
+    case RIG_PARITY_NONE:   return "None";
+
+    case RIG_PARITY_ODD:    return "Odd";
+
+    case RIG_PARITY_EVEN:   return "Even";
+
+    case RIG_PARITY_MARK:   return "Mark";
+
+    case RIG_PARITY_SPACE:  return "Space";
+
+    default:                return "Unknown";
+    }
+}
+
+static const char *caps_json_handshake(enum serial_handshake_e handshake)
+{
+    switch (handshake)
+    {
+    case RIG_HANDSHAKE_NONE:        return "None";
+
+    case RIG_HANDSHAKE_XONXOFF:     return "XONXOFF";
+
+    case RIG_HANDSHAKE_HARDWARE:    return "Hardware";
+
+    default:                        return "Unknown";
+    }
+}
+
+/* the names of the entry points the backend fills in */
+static void cw_commands(struct caps_writer *w, const struct rig_caps *caps)
+{
+#define CAPS_JSON_CMD(f) if (caps->f) { cw_string(w, NULL, #f); }
+    cw_open(w, "commands", '[');
+    CAPS_JSON_CMD(set_freq) CAPS_JSON_CMD(get_freq)
+    CAPS_JSON_CMD(set_mode) CAPS_JSON_CMD(get_mode)
+    CAPS_JSON_CMD(set_vfo) CAPS_JSON_CMD(get_vfo)
+    CAPS_JSON_CMD(set_ptt) CAPS_JSON_CMD(get_ptt)
+    CAPS_JSON_CMD(get_dcd)
+    CAPS_JSON_CMD(set_rptr_shift) CAPS_JSON_CMD(get_rptr_shift)
+    CAPS_JSON_CMD(set_rptr_offs) CAPS_JSON_CMD(get_rptr_offs)
+    CAPS_JSON_CMD(set_split_freq) CAPS_JSON_CMD(get_split_freq)
+    CAPS_JSON_CMD(set_split_mode) CAPS_JSON_CMD(get_split_mode)
+    CAPS_JSON_CMD(set_split_vfo) CAPS_JSON_CMD(get_split_vfo)
+    CAPS_JSON_CMD(set_rit) CAPS_JSON_CMD(get_rit)
+    CAPS_JSON_CMD(set_xit) CAPS_JSON_CMD(get_xit)
+    CAPS_JSON_CMD(set_ts) CAPS_JSON_CMD(get_ts)
+    CAPS_JSON_CMD(set_dcs_code) CAPS_JSON_CMD(get_dcs_code)
+    CAPS_JSON_CMD(set_ctcss_tone) CAPS_JSON_CMD(get_ctcss_tone)
+    CAPS_JSON_CMD(set_powerstat) CAPS_JSON_CMD(get_powerstat)
+    CAPS_JSON_CMD(set_ant) CAPS_JSON_CMD(get_ant)
+    CAPS_JSON_CMD(set_level) CAPS_JSON_CMD(get_level)
+    CAPS_JSON_CMD(set_func) CAPS_JSON_CMD(get_func)
+    CAPS_JSON_CMD(set_parm) CAPS_JSON_CMD(get_parm)
+    CAPS_JSON_CMD(send_morse) CAPS_JSON_CMD(send_voice_mem)
+    CAPS_JSON_CMD(set_mem) CAPS_JSON_CMD(get_mem)
+    CAPS_JSON_CMD(vfo_op) CAPS_JSON_CMD(scan)
+    CAPS_JSON_CMD(set_trn) CAPS_JSON_CMD(get_trn)
+    CAPS_JSON_CMD(decode_event)
+    CAPS_JSON_CMD(set_channel) CAPS_JSON_CMD(get_channel)
+    CAPS_JSON_CMD(get_info)
+    cw_close(w, ']');
+#undef CAPS_JSON_CMD
+}
+
+//! @endcond
+
+/**
+ * \brief write the capabilities of a model as a JSON object
+ * \param caps  The capabilities, from rig_get_caps() or rig_list_foreach()
+ * \param buf   Buffer for the result
+ * \param len   Size of \a buf
+ *
+ * Writes one JSON object, without newlines, holding the identity, port
+ * settings, function/level/parm lists, frequency ranges, tuning steps,
+ * filters, memory layout and the backend entry points of \a caps.  Only
+ * the caps are read, no RIG is needed.  The function is reentrant.
+ *
+ * \return RIG_OK, -RIG_EINVAL, or -RIG_ETRUNC if \a buf was too small.
+ *
+ * \sa rig_caps_export_json()
+ */
+int HAMLIB_API rig_caps_to_json(const struct rig_caps *caps, char *buf,
+                                int len)
+{
+    struct caps_writer w = { buf, (size_t) len, 0, 1, 0 };
+    int i;
+
+    if (!caps || !buf || len < 1)
+    {
+        return -RIG_EINVAL;
+    }
+
+    buf[0] = '\0';
+
+    cw_open(&w, NULL, '{');
+    cw_int(&w, "model", caps->rig_model);
+    cw_string(&w, "mfg_name", caps->mfg_name);
+    cw_string(&w, "model_name", caps->model_name);
+    cw_string(&w, "macro_name", caps->macro_name);
+    cw_string(&w, "version", caps->version);
+    cw_string(&w, "copyright", caps->copyright);
+    cw_string(&w, "status", rig_strstatus(caps->status));
+    cw_string(&w, "rig_type", caps_json_rig_type(caps->rig_type));
+    cw_int(&w, "ptt_type", caps->ptt_type);
+    cw_int(&w, "dcd_type", caps->dcd_type);
+    cw_string(&w, "port_type", caps_json_port_type(caps->port_type));
+
+    cw_open(&w, "serial", '{');
+    cw_int(&w, "rate_min", caps->serial_rate_min);
+    cw_int(&w, "rate_max", caps->serial_rate_max);
+    cw_int(&w, "data_bits", caps->serial_data_bits);
+    cw_int(&w, "stop_bits", caps->serial_stop_bits);
+    cw_string(&w, "parity", caps_json_parity(caps->serial_parity));
+    cw_string(&w, "handshake", caps_json_handshake(caps->serial_handshake));
+    cw_close(&w, '}');
+
+    cw_int(&w, "write_delay", caps->write_delay);
+    cw_int(&w, "post_write_delay", caps->post_write_delay);
+    cw_int(&w, "timeout", caps->timeout);
+    cw_int(&w, "retry", caps->retry);
+
+    cw_settings(&w, "get_func", caps->has_get_func, rig_strfunc);
+    cw_settings(&w, "set_func", caps->has_set_func, rig_strfunc);
+    cw_settings(&w, "get_level", caps->has_get_level, rig_strlevel);
+    cw_settings(&w, "set_level", caps->has_set_level, rig_strlevel);
+    cw_settings(&w, "get_parm", caps->has_get_parm, rig_strparm);
+    cw_settings(&w, "set_parm", caps->has_set_parm, rig_strparm);
+
+    cw_open(&w, "ext_levels", '[');
+
+    for (i = 0; caps->extlevels && caps->extlevels[i].token != RIG_CONF_END; i++)
+    {
+        cw_string(&w, NULL, caps->extlevels[i].name);
+    }
+
+    cw_close(&w, ']');
+
+    cw_tones(&w, "ctcss", caps->ctcss_list);
+    cw_tones(&w, "dcs", caps->dcs_list);
+    cw_db_list(&w, "preamp", caps->preamp);
+    cw_db_list(&w, "attenuator", caps->attenuator);
+    cw_int(&w, "max_rit", caps->max_rit);
+    cw_int(&w, "max_xit", caps->max_xit);
+    cw_int(&w, "max_ifshift", caps->max_ifshift);
+
+    cw_open(&w, "agc_levels", '[');
+
+    for (i = 0; i < caps->agc_level_count && i < HAMLIB_MAX_AGC_LEVELS; i++)
+    {
+        cw_string(&w, NULL, rig_stragclevel(caps->agc_levels[i]));
+    }
+
+    cw_close(&w, ']');
+
+    cw_vfo_ops(&w, "vfo_ops", caps->vfo_ops);
+    cw_scan_ops(&w, "scan_ops", caps->scan_ops);
+    cw_int(&w, "targetable_vfo", caps->targetable_vfo);
+    cw_bool(&w, "async_data", caps->async_data_supported);
+    cw_int(&w, "bank_qty", caps->bank_qty);
+    cw_int(&w, "chan_desc_sz", caps->chan_desc_sz);
+
+    cw_open(&w, "channels", '[');
+
+    for (i = 0; i < HAMLIB_CHANLSTSIZ && !RIG_IS_CHAN_END(caps->chan_list[i]); i++)
+    {
+        cw_open(&w, NULL, '{');
+        cw_int(&w, "start", caps->chan_list[i].startc);
+        cw_int(&w, "end", caps->chan_list[i].endc);
+        cw_string(&w, "type", rig_strmtype(caps->chan_list[i].type));
+        cw_close(&w, '}');
+    }
+
+    cw_close(&w, ']');
+
+    cw_ranges(&w, "rx_range_list1", caps->rx_range_list1);
+    cw_ranges(&w, "tx_range_list1", caps->tx_range_list1);
+    cw_ranges(&w, "rx_range_list2", caps->rx_range_list2);
+    cw_ranges(&w, "tx_range_list2", caps->tx_range_list2);
+    cw_ranges(&w, "rx_range_list3", caps->rx_range_list3);
+    cw_ranges(&w, "tx_range_list3", caps->tx_range_list3);
+    cw_ranges(&w, "rx_range_list4", caps->rx_range_list4);
+    cw_ranges(&w, "tx_range_list4", caps->tx_range_list4);
+    cw_ranges(&w, "rx_range_list5", caps->rx_range_list5);
+    cw_ranges(&w, "tx_range_list5", caps->tx_range_list5);
+
+    cw_open(&w, "tuning_steps", '[');
+
+    for (i = 0; i < HAMLIB_TSLSTSIZ && !RIG_IS_TS_END(caps->tuning_steps[i]); i++)
+    {
+        cw_open(&w, NULL, '{');
+        cw_modes(&w, "modes", caps->tuning_steps[i].modes);
+        cw_int(&w, "step", caps->tuning_steps[i].ts);
+        cw_close(&w, '}');
+    }
+
+    cw_close(&w, ']');
+
+    cw_open(&w, "filters", '[');
+
+    for (i = 0; i < HAMLIB_FLTLSTSIZ && !RIG_IS_FLT_END(caps->filters[i]); i++)
+    {
+        cw_open(&w, NULL, '{');
+        cw_modes(&w, "modes", caps->filters[i].modes);
+        cw_int(&w, "width", caps->filters[i].width);
+        cw_close(&w, '}');
+    }
+
+    cw_close(&w, ']');
+
+    cw_commands(&w, caps);
+    cw_close(&w, '}');
+
+    return w.truncated ? -RIG_ETRUNC : RIG_OK;
+}
+
+//! @cond Doxygen_Suppress
+
+struct caps_export
+{
+    const struct rig_caps **caps;
+    char **json;
+    int count;
+    int stride;
+    int error;
+};
+
+struct caps_export_job
+{
+    struct caps_export *exp;
+    int first;
+};
+
+static int caps_export_collect(const struct rig_caps *caps, rig_ptr_t data)
+{
+    struct caps_export *exp = data;
+
+    exp->caps[exp->count++] = caps;
+
+    return 1;
+}
+
+static int caps_export_count(const struct rig_caps *caps, rig_ptr_t data)
+{
+    (*(int *) data)++;
+
+    return 1;
+}
+
+/* serialize models first, first + stride, ... into their own buffers */
+static void *caps_export_worker(void *arg)
+{
+    struct caps_export_job *job = arg;
+    struct caps_export *exp = job->exp;
+    int i;
+
+    for (i = job->first; i < exp->count; i += exp->stride)
+    {
+        size_t len = CAPS_JSON_BUFSZ;
+
+        for (;;)
+        {
+            char *buf = malloc(len);
+            int retval;
+
+            if (!buf)
+            {
+                exp->error = -RIG_ENOMEM;
+                return NULL;
+            }
+
+            retval = rig_caps_to_json(exp->caps[i], buf, (int) len);
+
+            if (retval == RIG_OK)
+            {
+                exp->json[i] = buf;
+                break;
+            }
+
+            free(buf);
+
+            if (retval != -RIG_ETRUNC || len >= CAPS_JSON_BUFMAX)
+            {
+                exp->error = retval;
+                return NULL;
+            }
+
+            len *= 2;
+        }
+    }
+
+    return NULL;
+}
+
+//! @endcond
+
+/**
+ * \brief write the capabilities of every model as a JSON array
+ * \param fout      Where to write
+ * \param threads   Number of threads to serialize with, 0 for one per CPU
+ *
+ * Loads all the backends of the build, then writes a JSON array holding
+ * the rig_caps_to_json() object of each model, one per line, in model
+ * order.  No RIG is set up for it, so this is what support matrices and
+ * capability listings should be made from.  The models are serialized
+ * by up to \a threads threads, each into its own buffer, then written
+ * in order.
+ *
+ * \return RIG_OK, -RIG_EINVAL, -RIG_ENOMEM or -RIG_EIO.
+ *
+ * \sa rig_caps_to_json(), rig_list_foreach()
+ */
+int HAMLIB_API rig_caps_export_json(FILE *fout, int threads)
+{
+    struct caps_export exp;
+    struct caps_export_job jobs[CAPS_JSON_THREADS_MAX];
+    int total = 0;
+    int i;
+
+    if (!fout)
+    {
+        return -RIG_EINVAL;
+    }
+
+    rig_load_all_backends();
+    rig_list_foreach(caps_export_count, &total);
+
+    memset(&exp, 0, sizeof(exp));
+    exp.caps = calloc(total ? total : 1, sizeof(*exp.caps));
+    exp.json = calloc(total ? total : 1, sizeof(*exp.json));
+
+    if (!exp.caps || !exp.json)
+    {
+        free(exp.caps);
+        free(exp.json);
+        return -RIG_ENOMEM;
+    }
+
+    rig_list_foreach(caps_export_collect, &exp);
+
+    if (threads <= 0)
+    {
+        long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+        threads = ncpu > 0 ? (int) ncpu : 1;
+    }
+
+    if (threads > CAPS_JSON_THREADS_MAX) { threads = CAPS_JSON_THREADS_MAX; }
+
+    if (threads > exp.count) { threads = exp.count > 0 ? exp.count : 1; }
+
+    exp.stride = threads;
+
+    for (i = 0; i < threads; i++)
+    {
+        jobs[i].exp = &exp;
+        jobs[i].first = i;
+    }
+
+#ifdef HAVE_PTHREAD
+    {
+        pthread_t tid[CAPS_JSON_THREADS_MAX];
+        int started[CAPS_JSON_THREADS_MAX];
+
+        /* this thread takes the first share */
+        for (i = 1; i < threads; i++)
+        {
+            started[i] = pthread_create(&tid[i], NULL, caps_export_worker,
+                                        &jobs[i]) == 0;
+        }
+
+        caps_export_worker(&jobs[0]);
+
+        for (i = 1; i < threads; i++)
+        {
+            if (started[i])
+            {
+                pthread_join(tid[i], NULL);
+            }
+            else
+            {
+                caps_export_worker(&jobs[i]);
+            }
+        }
+    }
+#else
+
+    for (i = 0; i < threads; i++)
+    {
+        caps_export_worker(&jobs[i]);
+    }
+
+#endif
+
+    if (exp.error == RIG_OK)
+    {
+        fputs("[\n", fout);
+
+        for (i = 0; i < exp.count; i++)
+        {
+            fputs(exp.json[i], fout);
+            fputs(i + 1 < exp.count ? ",\n" : "\n", fout);
+        }
+
+        fputs("]\n", fout);
+
+        if (ferror(fout))
+        {
+            exp.error = -RIG_EIO;
+        }
+    }
+
+    for (i = 0; i < exp.count; i++)
+    {
+        free(exp.json[i]);
+    }
+
+    free(exp.json);
+    free(exp.caps);
+
+    return exp.error;
+}
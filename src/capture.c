@@ -0,0 +1,606 @@
+/*
+ *  Hamlib Interface - CAT traffic capture and replay
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * capture_file records the rig port traffic with timestamps, see
+ * capture.h for the format.  replay_file plays such a capture back in
+ * place of the rig: the rig port is pointed at a pty whose other end is
+ * served by a thread that matches what the backend writes against the
+ * 'W' records and answers with the 'R' records that follow, as fast as
+ * the backend reads them.  Running the same commands through the same
+ * backend thus repeats the session without the rig, for benchmarking and
+ * regression tests of the backend's parsing.
+ *
+ * A write that does not match skips ahead to the next 'W' record that
+ * starts with the same byte, so a replay survives a backend sending a
+ * little more or less than it did while capturing.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#if defined(HAVE_PTHREAD) && !defined(_WIN32)
+#define CAPTURE_REPLAY 1
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include "capture.h"
+#include "misc.h"
+
+struct capture
+{
+    char capture_path[HAMLIB_FILPATHLEN];
+    char replay_path[HAMLIB_FILPATHLEN];
+    FILE *out;
+    struct timespec last;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t lock;
+#endif
+#ifdef CAPTURE_REPLAY
+    unsigned char *log;
+    size_t log_len;
+    int master;
+    volatile int thread_run;
+    int dropping;
+    pthread_t thread;
+    char saved_pathname[HAMLIB_FILPATHLEN];
+    enum rig_port_e saved_type;
+    unsigned char saved_parm[sizeof(((hamlib_port_t *) 0)->parm)];
+#endif
+};
+
+static struct capture *capture_get(RIG *rig, int create)
+{
+    struct capture *c = rig->state.capture;
+
+    if (c || !create)
+    {
+        return c;
+    }
+
+    c = calloc(1, sizeof(*c));
+
+    if (!c)
+    {
+        return NULL;
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init(&c->lock, NULL);
+#endif
+#ifdef CAPTURE_REPLAY
+    c->master = -1;
+#endif
+    rig->state.capture = c;
+
+    return c;
+}
+
+static unsigned char *put_be(unsigned char *p, unsigned long v, int n)
+{
+    while (n-- > 0)
+    {
+        *p++ = (v >> (8 * n)) & 0xff;
+    }
+
+    return p;
+}
+
+static unsigned long get_be(const unsigned char *p, int n)
+{
+    unsigned long v = 0;
+
+    while (n-- > 0)
+    {
+        v = (v << 8) | *p++;
+    }
+
+    return v;
+}
+
+static int set_path(RIG *rig, const char *path, int replay)
+{
+    struct capture *c = capture_get(rig, path && *path);
+
+    if (!c)
+    {
+        return path && *path ? -RIG_ENOMEM : RIG_OK;
+    }
+
+    if (strlen(path) >= HAMLIB_FILPATHLEN)
+    {
+        return -RIG_EINVAL;
+    }
+
+    strcpy(replay ? c->replay_path : c->capture_path, path);
+
+    return RIG_OK;
+}
+
+int capture_set_file(RIG *rig, const char *path)
+{
+    return set_path(rig, path, 0);
+}
+
+const char *capture_get_file(RIG *rig)
+{
+    struct capture *c = capture_get(rig, 0);
+
+    return c ? c->capture_path : "";
+}
+
+int replay_set_file(RIG *rig, const char *path)
+{
+#ifdef CAPTURE_REPLAY
+    return set_path(rig, path, 1);
+#else
+    return path && *path ? -RIG_ENIMPL : RIG_OK;
+#endif
+}
+
+const char *replay_get_file(RIG *rig)
+{
+    struct capture *c = capture_get(rig, 0);
+
+    return c ? c->replay_path : "";
+}
+
+void capture_io(hamlib_port_t *p, int dir, const void *buf, size_t len)
+{
+    const unsigned char *data = buf;
+    struct capture *c;
+    struct timespec now;
+    unsigned char rec[CAPTURE_RECORD_SIZE];
+    long long us;
+
+    if (!p || !p->rig || p != &p->rig->state.rigport || len == 0)
+    {
+        return;
+    }
+
+    c = p->rig->state.capture;
+
+    if (!c || !c->out)
+    {
+        return;
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&c->lock);
+#endif
+
+    if (c->out)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        us = (now.tv_sec - c->last.tv_sec) * 1000000LL
+             + (now.tv_nsec - c->last.tv_nsec) / 1000;
+        c->last = now;
+
+        if (us < 0) { us = 0; }
+
+        if (us > 0xffffffffLL) { us = 0xffffffffLL; }
+
+        while (len > 0)
+        {
+            size_t n = len > 0xffff ? 0xffff : len;
+            unsigned char *q = rec;
+
+            *q++ = dir;
+            q = put_be(q, (unsigned long) us, 4);
+            put_be(q, n, 2);
+
+            fwrite(rec, sizeof(rec), 1, c->out);
+            fwrite(data, n, 1, c->out);
+
+            data += n;
+            len -= n;
+            us = 0;
+        }
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&c->lock);
+#endif
+}
+
+#ifdef CAPTURE_REPLAY
+
+static size_t record_next(const struct capture *c, size_t pos)
+{
+    return pos + CAPTURE_RECORD_SIZE + get_be(c->log + pos + 5, 2);
+}
+
+/* send the 'R' records from pos on, returns the next 'W' record */
+static size_t replay_answer(struct capture *c, size_t pos)
+{
+    while (pos < c->log_len && c->log[pos] == CAPTURE_READ)
+    {
+        const unsigned char *data = c->log + pos + CAPTURE_RECORD_SIZE;
+        size_t len = get_be(c->log + pos + 5, 2);
+
+        while (len > 0)
+        {
+            ssize_t n = write(c->master, data, len);
+
+            if (n < 0)
+            {
+                if (errno == EINTR || errno == EAGAIN) { continue; }
+
+                rig_debug(RIG_DEBUG_ERR, "%s: write failed: %s\n", __func__,
+                          strerror(errno));
+                return c->log_len;
+            }
+
+            data += n;
+            len -= n;
+        }
+
+        pos = record_next(c, pos);
+    }
+
+    return pos;
+}
+
+/* feed one byte the backend wrote, *off is how much of record *pos matched */
+static void replay_byte(struct capture *c, size_t *pos, size_t *off,
+                        unsigned char b)
+{
+    size_t q;
+
+    *pos = replay_answer(c, *pos);
+
+    if (*pos >= c->log_len)
+    {
+        return;
+    }
+
+    if (c->log[*pos + CAPTURE_RECORD_SIZE + *off] != b)
+    {
+        q = *off ? *pos : record_next(c, *pos);
+
+        while (q < c->log_len && (c->log[q] != CAPTURE_WRITE
+                                  || c->log[q + CAPTURE_RECORD_SIZE] != b))
+        {
+            q = record_next(c, q);
+        }
+
+        if (q >= c->log_len)
+        {
+            if (!c->dropping)
+            {
+                rig_debug(RIG_DEBUG_WARN, "%s: 0x%02x not in the capture, "
+                          "dropping the write\n", __func__, b);
+            }
+
+            c->dropping = 1;
+            *off = 0;
+            return;
+        }
+
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: write differs, skipping to offset %lu\n",
+                  __func__, (unsigned long) q);
+        *pos = q;
+        *off = 0;
+    }
+
+    if (++*off == get_be(c->log + *pos + 5, 2))
+    {
+        *pos = replay_answer(c, record_next(c, *pos));
+        *off = 0;
+        c->dropping = 0;
+
+        if (*pos >= c->log_len)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: end of the capture\n", __func__);
+        }
+    }
+}
+
+static void *replay_thread(void *arg)
+{
+    struct capture *c = arg;
+    size_t pos = CAPTURE_HEADER_SIZE, off = 0;
+    unsigned char buf[256];
+
+    while (c->thread_run)
+    {
+        struct pollfd pfd = { c->master, POLLIN, 0 };
+        ssize_t i, n;
+
+        if (poll(&pfd, 1, 100) <= 0)
+        {
+            continue;
+        }
+
+        if (!(pfd.revents & POLLIN))
+        {
+            // the backend has the pty closed for now
+            hl_usleep(10 * 1000);
+            continue;
+        }
+
+        n = read(c->master, buf, sizeof(buf));
+
+        for (i = 0; i < n; i++)
+        {
+            replay_byte(c, &pos, &off, buf[i]);
+        }
+    }
+
+    return NULL;
+}
+
+static int replay_load(RIG *rig, struct capture *c)
+{
+    FILE *f = fopen(c->replay_path, "rb");
+    size_t pos;
+    long len;
+
+    if (!f)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot open %s: %s\n", __func__,
+                  c->replay_path, strerror(errno));
+        return -RIG_EIO;
+    }
+
+    if (fseek(f, 0, SEEK_END) != 0 || (len = ftell(f)) < CAPTURE_HEADER_SIZE
+            || fseek(f, 0, SEEK_SET) != 0
+            || !(c->log = malloc(len))
+            || fread(c->log, len, 1, f) != 1
+            || memcmp(c->log, CAPTURE_MAGIC, 6) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s is not a capture file\n", __func__,
+                  c->replay_path);
+        fclose(f);
+        free(c->log);
+        c->log = NULL;
+        return -RIG_EINVAL;
+    }
+
+    fclose(f);
+
+    if (get_be(c->log + 8, 4) != (unsigned long) rig->caps->rig_model)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: %s was captured with model %lu\n", __func__,
+                  c->replay_path, get_be(c->log + 8, 4));
+    }
+
+    // cut a record truncated at the end, or anything after it
+    for (pos = CAPTURE_HEADER_SIZE; pos + CAPTURE_RECORD_SIZE <= (size_t) len;)
+    {
+        size_t next = record_next(c, pos);
+
+        if ((c->log[pos] != CAPTURE_WRITE && c->log[pos] != CAPTURE_READ)
+                || get_be(c->log + pos + 5, 2) == 0 || next > (size_t) len)
+        {
+            break;
+        }
+
+        pos = next;
+    }
+
+    c->log_len = pos;
+
+    return RIG_OK;
+}
+
+static int replay_start(RIG *rig, struct capture *c)
+{
+    hamlib_port_t *rp = &rig->state.rigport;
+    const char *name;
+    int ret;
+
+    if (rp->type.rig != RIG_PORT_SERIAL && rp->type.rig != RIG_PORT_NETWORK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: replay needs a serial or network rig port\n",
+                  __func__);
+        return -RIG_ECONF;
+    }
+
+    ret = replay_load(rig, c);
+
+    if (ret != RIG_OK)
+    {
+        return ret;
+    }
+
+    c->master = posix_openpt(O_RDWR | O_NOCTTY);
+
+    if (c->master < 0 || grantpt(c->master) < 0 || unlockpt(c->master) < 0
+            || !(name = ptsname(c->master)) || strlen(name) >= HAMLIB_FILPATHLEN)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: no pty: %s\n", __func__, strerror(errno));
+        ret = -RIG_EIO;
+        goto fail;
+    }
+
+    strcpy(c->saved_pathname, rp->pathname);
+    c->saved_type = rp->type.rig;
+    memcpy(c->saved_parm, &rp->parm, sizeof(c->saved_parm));
+    strcpy(rp->pathname, name);
+
+    if (rp->type.rig != RIG_PORT_SERIAL)
+    {
+        // any rate does on a pty
+        memset(&rp->parm, 0, sizeof(rp->parm));
+        rp->parm.serial.rate = 38400;
+        rp->parm.serial.data_bits = 8;
+        rp->parm.serial.stop_bits = 1;
+        rp->type.rig = RIG_PORT_SERIAL;
+    }
+
+    c->thread_run = 1;
+
+    if (pthread_create(&c->thread, NULL, replay_thread, c) != 0)
+    {
+        c->thread_run = 0;
+        strcpy(rp->pathname, c->saved_pathname);
+        rp->type.rig = c->saved_type;
+        memcpy(&rp->parm, c->saved_parm, sizeof(c->saved_parm));
+        ret = -RIG_EINTERNAL;
+        goto fail;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: replaying %s on %s\n", __func__,
+              c->replay_path, name);
+
+    return RIG_OK;
+
+fail:
+
+    if (c->master >= 0) { close(c->master); }
+
+    c->master = -1;
+    free(c->log);
+    c->log = NULL;
+
+    return ret;
+}
+
+static void replay_stop(RIG *rig, struct capture *c)
+{
+    if (!c->thread_run)
+    {
+        return;
+    }
+
+    c->thread_run = 0;
+    pthread_join(c->thread, NULL);
+    close(c->master);
+    c->master = -1;
+    free(c->log);
+    c->log = NULL;
+
+    strcpy(rig->state.rigport.pathname, c->saved_pathname);
+    rig->state.rigport.type.rig = c->saved_type;
+    memcpy(&rig->state.rigport.parm, c->saved_parm, sizeof(c->saved_parm));
+}
+
+#endif /* CAPTURE_REPLAY */
+
+int capture_open(RIG *rig)
+{
+    struct capture *c = capture_get(rig, 0);
+    unsigned char header[CAPTURE_HEADER_SIZE];
+
+    if (!c)
+    {
+        return RIG_OK;
+    }
+
+    capture_close(rig);
+
+#ifdef CAPTURE_REPLAY
+
+    if (c->replay_path[0])
+    {
+        int ret = replay_start(rig, c);
+
+        if (ret != RIG_OK)
+        {
+            return ret;
+        }
+    }
+
+#endif
+
+    if (!c->capture_path[0])
+    {
+        return RIG_OK;
+    }
+
+    memcpy(header, CAPTURE_MAGIC, 6);
+    put_be(put_be(header + 6, 0, 2), rig->caps->rig_model, 4);
+
+    c->out = fopen(c->capture_path, "wb");
+
+    if (!c->out || fwrite(header, sizeof(header), 1, c->out) != 1)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot write %s: %s\n", __func__,
+                  c->capture_path, strerror(errno));
+
+        if (c->out) { fclose(c->out); }
+
+        c->out = NULL;
+        capture_close(rig);
+        return -RIG_EIO;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &c->last);
+
+    return RIG_OK;
+}
+
+void capture_close(RIG *rig)
+{
+    struct capture *c = capture_get(rig, 0);
+
+    if (!c)
+    {
+        return;
+    }
+
+#ifdef CAPTURE_REPLAY
+    replay_stop(rig, c);
+#endif
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&c->lock);
+#endif
+
+    if (c->out)
+    {
+        fclose(c->out);
+        c->out = NULL;
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&c->lock);
+#endif
+}
+
+void capture_free(RIG *rig)
+{
+    struct capture *c = capture_get(rig, 0);
+
+    if (!c)
+    {
+        return;
+    }
+
+    capture_close(rig);
+#ifdef HAVE_PTHREAD
+    pthread_mutex_destroy(&c->lock);
+#endif
+    free(c);
+    rig->state.capture = NULL;
+}
@@ -0,0 +1,65 @@
+/*
+ *  Hamlib Interface - CAT traffic capture and replay
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _CAPTURE_H
+#define _CAPTURE_H 1
+
+#include <hamlib/rig.h>
+
+/*
+ * A capture file, written while the capture_file conf is set, holds every
+ * chunk written to or read from the rig port, integers big-endian:
+ *
+ *    0  6  "HLCAP1"
+ *    6  2  0
+ *    8  4  rig model
+ *   12     records
+ *
+ * and each record:
+ *
+ *    0  1  'W' written to the rig, 'R' read from it
+ *    1  4  microseconds since the previous record (monotonic clock)
+ *    5  2  length n
+ *    7  n  the bytes
+ */
+#define CAPTURE_MAGIC "HLCAP1"
+#define CAPTURE_HEADER_SIZE 12
+#define CAPTURE_RECORD_SIZE 7
+
+#define CAPTURE_WRITE 'W'
+#define CAPTURE_READ 'R'
+
+int capture_set_file(RIG *rig, const char *path);
+const char *capture_get_file(RIG *rig);
+int replay_set_file(RIG *rig, const char *path);
+const char *replay_get_file(RIG *rig);
+
+/* Before the rig port is opened: start the capture, or the replay that
+ * stands in for the rig on a pty */
+int capture_open(RIG *rig);
+/* After the rig port is closed */
+void capture_close(RIG *rig);
+void capture_free(RIG *rig);
+
+/* Record a chunk of rig port traffic, a no-op unless capturing */
+void capture_io(hamlib_port_t *p, int dir, const void *buf, size_t len);
+
+#endif /* _CAPTURE_H */
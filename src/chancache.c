@@ -0,0 +1,670 @@
+/*
+ *  Hamlib Interface - memory channel cache
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Memory channel cache, the chan_cache conf.
+ *
+ * Without a backend get_channel every rig_get_channel() of a memory
+ * channel switches the rig to memory mode, selects the channel, reads
+ * each field and switches back.  With chan_cache on, what a read gave is
+ * kept per channel number, whether it came from rig_get_channel() or
+ * from a bank read through rig_get_chan_all_cb(), and read-only queries
+ * of the channel are answered from it.  rig_set_channel() and the other
+ * memory writes of the frontend drop what they touch, backends drop it
+ * all with rig_chan_cache_invalidate() when they see the memory written
+ * by someone else.  rig_get_channel_by_freq() looks channels up by
+ * frequency in a sorted index of the cache.
+ */
+
+#include <hamlib/config.h>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "chancache.h"
+
+#define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+//! @cond Doxygen_Suppress
+
+/* highest channel number kept + 1 */
+#define CHAN_CACHE_MAX 10000
+/* a lookup reads up to this many unknown channels one by one, more in one bank read */
+#define CHAN_CACHE_SINGLE_MAX 16
+
+enum chan_cache_slot
+{
+    CHAN_CACHE_UNKNOWN = 0,
+    CHAN_CACHE_EMPTY,
+    CHAN_CACHE_VALID
+};
+
+struct chan_cache_freq
+{
+    freq_t freq;
+    int ch;
+};
+
+struct rig_chan_cache
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t lock;
+#endif
+    int size;
+    unsigned char *slot;        /* enum chan_cache_slot by channel number */
+    channel_t **chan;           /* the channel of a CHAN_CACHE_VALID slot */
+    struct chan_cache_freq *index;
+    int nindex;
+    int index_dirty;
+};
+
+#ifdef HAVE_PTHREAD
+#define CC_LOCK(cc)   pthread_mutex_lock(&(cc)->lock)
+#define CC_UNLOCK(cc) pthread_mutex_unlock(&(cc)->lock)
+#else
+#define CC_LOCK(cc)
+#define CC_UNLOCK(cc)
+#endif
+
+static int chan_cache_size(const RIG *rig)
+{
+    const chan_t *chan_list = rig->state.chan_list;
+    int i, size = 0;
+
+    for (i = 0; !RIG_IS_CHAN_END(chan_list[i]) && i < HAMLIB_CHANLSTSIZ; i++)
+    {
+        if (chan_list[i].endc >= size)
+        {
+            size = chan_list[i].endc + 1;
+        }
+    }
+
+    return size < CHAN_CACHE_MAX ? size : CHAN_CACHE_MAX;
+}
+
+/* the cache of rig, made on first use */
+static struct rig_chan_cache *chan_cache(RIG *rig)
+{
+    struct rig_chan_cache *cc = rig->state.chancache;
+    struct rig_chan_cache *expected = NULL;
+    int size;
+
+    if (!rig->state.chan_cache)
+    {
+        return NULL;
+    }
+
+    if (cc)
+    {
+        return cc;
+    }
+
+    size = chan_cache_size(rig);
+
+    if (size == 0)
+    {
+        return NULL;
+    }
+
+    cc = calloc(1, sizeof(*cc));
+
+    if (!cc)
+    {
+        return NULL;
+    }
+
+    cc->size = size;
+    cc->slot = calloc(size, sizeof(*cc->slot));
+    cc->chan = calloc(size, sizeof(*cc->chan));
+
+    if (!cc->slot || !cc->chan)
+    {
+        free(cc->slot);
+        free(cc->chan);
+        free(cc);
+        return NULL;
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init(&cc->lock, NULL);
+#endif
+
+    // two threads reading their first channel at once keep the first cache made
+    if (!__atomic_compare_exchange_n((struct rig_chan_cache **)
+                                     &rig->state.chancache, &expected, cc, 0,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+#ifdef HAVE_PTHREAD
+        pthread_mutex_destroy(&cc->lock);
+#endif
+        free(cc->slot);
+        free(cc->chan);
+        free(cc);
+        cc = expected;
+    }
+
+    return cc;
+}
+
+static int ext_list_len(const struct ext_list *ext)
+{
+    int n = 0;
+
+    while (ext && !RIG_IS_EXT_END(ext[n]))
+    {
+        n++;
+    }
+
+    return n;
+}
+
+/* called with the cache locked */
+static void chan_cache_drop(struct rig_chan_cache *cc, int ch)
+{
+    if (cc->chan[ch])
+    {
+        free(cc->chan[ch]->ext_levels);
+        free(cc->chan[ch]);
+        cc->chan[ch] = NULL;
+    }
+
+    if (cc->slot[ch] == CHAN_CACHE_VALID)
+    {
+        cc->index_dirty = 1;
+    }
+
+    cc->slot[ch] = CHAN_CACHE_UNKNOWN;
+}
+
+int chan_cache_get(RIG *rig, int ch, channel_t *chan, int *retval)
+{
+    struct rig_chan_cache *cc = chan_cache(rig);
+    const channel_t *c;
+    struct ext_list *ext_levels;
+    int n;
+
+    if (!cc || ch < 0 || ch >= cc->size)
+    {
+        return 0;
+    }
+
+    CC_LOCK(cc);
+
+    c = cc->chan[ch];
+
+    if (cc->slot[ch] == CHAN_CACHE_EMPTY)
+    {
+        CC_UNLOCK(cc);
+        *retval = -RIG_ENAVAIL;
+        return 1;
+    }
+
+    if (cc->slot[ch] != CHAN_CACHE_VALID || c->bank_num != chan->bank_num)
+    {
+        CC_UNLOCK(cc);
+        return 0;
+    }
+
+    // ext_levels stays the caller's, only resized to what was read
+    ext_levels = chan->ext_levels;
+    n = ext_list_len(c->ext_levels);
+
+    if (n > 0)
+    {
+        struct ext_list *p = realloc(ext_levels, (n + 1) * sizeof(*p));
+
+        if (!p)
+        {
+            CC_UNLOCK(cc);
+            return 0;
+        }
+
+        memcpy(p, c->ext_levels, (n + 1) * sizeof(*p));
+        ext_levels = p;
+    }
+
+    memcpy(chan, c, sizeof(*chan));
+    chan->ext_levels = ext_levels;
+
+    CC_UNLOCK(cc);
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: channel %d from the cache\n", __func__, ch);
+
+    *retval = RIG_OK;
+    return 1;
+}
+
+void chan_cache_store(RIG *rig, int ch, const channel_t *chan, int retval)
+{
+    struct rig_chan_cache *cc;
+    channel_t *c = NULL;
+
+    if (retval != RIG_OK && retval != -RIG_ENAVAIL)
+    {
+        return;
+    }
+
+    cc = chan_cache(rig);
+
+    if (!cc || ch < 0 || ch >= cc->size)
+    {
+        return;
+    }
+
+    if (retval == RIG_OK)
+    {
+        int n = ext_list_len(chan->ext_levels);
+
+        c = malloc(sizeof(*c));
+
+        if (!c)
+        {
+            return;
+        }
+
+        memcpy(c, chan, sizeof(*c));
+        c->ext_levels = NULL;
+
+        if (n > 0)
+        {
+            c->ext_levels = malloc((n + 1) * sizeof(struct ext_list));
+
+            if (!c->ext_levels)
+            {
+                free(c);
+                return;
+            }
+
+            memcpy(c->ext_levels, chan->ext_levels, (n + 1) * sizeof(struct ext_list));
+        }
+    }
+
+    CC_LOCK(cc);
+
+    chan_cache_drop(cc, ch);
+    cc->chan[ch] = c;
+    cc->slot[ch] = c ? CHAN_CACHE_VALID : CHAN_CACHE_EMPTY;
+
+    if (c)
+    {
+        cc->index_dirty = 1;
+    }
+
+    CC_UNLOCK(cc);
+}
+
+void chan_cache_mark_empty(RIG *rig)
+{
+    struct rig_chan_cache *cc = chan_cache(rig);
+    const chan_t *chan_list = rig->state.chan_list;
+    int i, j;
+
+    if (!cc)
+    {
+        return;
+    }
+
+    CC_LOCK(cc);
+
+    for (i = 0; !RIG_IS_CHAN_END(chan_list[i]) && i < HAMLIB_CHANLSTSIZ; i++)
+    {
+        for (j = chan_list[i].startc; j <= chan_list[i].endc && j < cc->size; j++)
+        {
+            if (cc->slot[j] == CHAN_CACHE_UNKNOWN)
+            {
+                cc->slot[j] = CHAN_CACHE_EMPTY;
+            }
+        }
+    }
+
+    CC_UNLOCK(cc);
+}
+
+void chan_cache_free(RIG *rig)
+{
+    struct rig_chan_cache *cc = rig->state.chancache;
+    int i;
+
+    if (!cc)
+    {
+        return;
+    }
+
+    for (i = 0; i < cc->size; i++)
+    {
+        chan_cache_drop(cc, i);
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_destroy(&cc->lock);
+#endif
+    free(cc->slot);
+    free(cc->chan);
+    free(cc->index);
+    free(cc);
+    rig->state.chancache = NULL;
+}
+
+/* the channels of chan_list not known yet, the first max of them in list */
+static int chan_cache_unknown(RIG *rig, struct rig_chan_cache *cc, int *list,
+                              int max)
+{
+    const chan_t *chan_list = rig->state.chan_list;
+    int i, j, n = 0;
+
+    CC_LOCK(cc);
+
+    for (i = 0; !RIG_IS_CHAN_END(chan_list[i]) && i < HAMLIB_CHANLSTSIZ; i++)
+    {
+        for (j = chan_list[i].startc; j <= chan_list[i].endc && j < cc->size; j++)
+        {
+            if (cc->slot[j] != CHAN_CACHE_UNKNOWN)
+            {
+                continue;
+            }
+
+            if (n < max)
+            {
+                list[n] = j;
+            }
+
+            n++;
+        }
+    }
+
+    CC_UNLOCK(cc);
+
+    return n;
+}
+
+static int chan_cache_freq_cmp(const void *a, const void *b)
+{
+    const struct chan_cache_freq *fa = a, *fb = b;
+
+    if (fa->freq != fb->freq)
+    {
+        return fa->freq < fb->freq ? -1 : 1;
+    }
+
+    return fa->ch - fb->ch;
+}
+
+/* called with the cache locked */
+static int chan_cache_index(struct rig_chan_cache *cc)
+{
+    int i, n = 0;
+
+    if (!cc->index_dirty && cc->index)
+    {
+        return RIG_OK;
+    }
+
+    free(cc->index);
+    cc->index = malloc(cc->size * sizeof(*cc->index));
+    cc->nindex = 0;
+
+    if (!cc->index)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    for (i = 0; i < cc->size; i++)
+    {
+        if (cc->slot[i] == CHAN_CACHE_VALID)
+        {
+            cc->index[n].freq = cc->chan[i]->freq;
+            cc->index[n].ch = i;
+            n++;
+        }
+    }
+
+    qsort(cc->index, n, sizeof(*cc->index), chan_cache_freq_cmp);
+    cc->nindex = n;
+    cc->index_dirty = 0;
+
+    return RIG_OK;
+}
+
+/* chan_cb_t of the bank read warming the cache, rig_get_chan_all_cb() keeps the channels */
+static int chan_cache_warm_cb(RIG *rig, channel_t **chan, int channel_num,
+                              const chan_t *chan_list, rig_ptr_t arg)
+{
+    channel_t *scratch = (channel_t *)arg;
+
+    free(scratch->ext_levels);
+    memset(scratch, 0, sizeof(*scratch));
+    *chan = scratch;
+
+    return RIG_OK;
+}
+
+/* read what the cache does not know yet */
+static int chan_cache_warm(RIG *rig, vfo_t vfo, struct rig_chan_cache *cc)
+{
+    int list[CHAN_CACHE_SINGLE_MAX];
+    channel_t chan;
+    int i, n, retval = RIG_OK;
+
+    n = chan_cache_unknown(rig, cc, list, CHAN_CACHE_SINGLE_MAX);
+
+    if (n == 0)
+    {
+        return RIG_OK;
+    }
+
+    memset(&chan, 0, sizeof(chan));
+
+    if (n > CHAN_CACHE_SINGLE_MAX || !rig->caps->get_channel)
+    {
+        // one bank read beats switching to memory mode for each channel
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: reading %d channels\n", __func__, n);
+        retval = rig_get_chan_all_cb(rig, vfo, chan_cache_warm_cb,
+                                     (rig_ptr_t)&chan);
+        free(chan.ext_levels);
+        return retval;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        memset(&chan, 0, sizeof(chan));
+        chan.vfo = RIG_VFO_MEM;
+        chan.channel_num = list[i];
+
+        retval = rig_get_channel(rig, vfo, &chan, 1);
+        free(chan.ext_levels);
+
+        if (retval != RIG_OK && retval != -RIG_ENAVAIL)
+        {
+            return retval;
+        }
+    }
+
+    return RIG_OK;
+}
+
+//! @endcond
+
+/**
+ * \brief look a memory channel up by frequency
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param freq  The frequency of the channel
+ * \param chan  Where to store the channel data
+ *
+ * Needs the chan_cache conf.  The channels the cache does not know yet
+ * are read first, by a bank read through rig_get_chan_all_cb() unless
+ * only a few are missing, so later lookups cost no I/O until a memory
+ * write invalidates channels.  The lowest channel number on \a freq
+ * within half a Hz wins.
+ *
+ * Like rig_get_channel(), chan->ext_levels is resized with realloc()
+ * when the channel has ext_levels.
+ *
+ * \return RIG_OK if the operation has been successful, -RIG_ENAVAIL
+ * without the cache or when no channel is on \a freq, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_get_channel(), rig_chan_cache_invalidate()
+ */
+int HAMLIB_API rig_get_channel_by_freq(RIG *rig, vfo_t vfo, freq_t freq,
+                                       channel_t *chan)
+{
+    struct rig_chan_cache *cc;
+    int lo, hi, ch, retval;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (CHECK_RIG_ARG(rig) || !chan)
+    {
+        return -RIG_EINVAL;
+    }
+
+    cc = chan_cache(rig);
+
+    if (!cc)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    retval = chan_cache_warm(rig, vfo, cc);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    CC_LOCK(cc);
+
+    retval = chan_cache_index(cc);
+
+    if (retval != RIG_OK)
+    {
+        CC_UNLOCK(cc);
+        return retval;
+    }
+
+    // first entry not below freq - 0.5
+    lo = 0;
+    hi = cc->nindex;
+
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+
+        if (cc->index[mid].freq < freq - 0.5)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    ch = lo < cc->nindex && fabs(cc->index[lo].freq - freq) <= 0.5 ?
+         cc->index[lo].ch : -1;
+
+    CC_UNLOCK(cc);
+
+    if (ch < 0)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    chan->vfo = RIG_VFO_MEM;
+    chan->channel_num = ch;
+
+    // bank_num has to match for chan_cache_get(), take the cached one
+    CC_LOCK(cc);
+
+    if (cc->slot[ch] == CHAN_CACHE_VALID)
+    {
+        chan->bank_num = cc->chan[ch]->bank_num;
+    }
+
+    CC_UNLOCK(cc);
+
+    if (!chan_cache_get(rig, ch, chan, &retval))
+    {
+        // invalidated in between
+        return rig_get_channel(rig, vfo, chan, 1);
+    }
+
+    return retval;
+}
+
+/**
+ * \brief forget cached memory channels
+ * \param rig   The rig handle
+ * \param ch    The channel number, or -1 for all of them
+ *
+ * For applications that know the memory changed behind Hamlib's back,
+ * e.g. edited on the front panel, and for backends that see another
+ * controller write it.  Safe to call from the async reader thread.
+ *
+ * \return RIG_OK, or -RIG_EINVAL when \a rig is NULL.
+ *
+ * \sa rig_get_channel_by_freq()
+ */
+int HAMLIB_API rig_chan_cache_invalidate(RIG *rig, int ch)
+{
+    struct rig_chan_cache *cc;
+    int i;
+
+    if (!rig)
+    {
+        return -RIG_EINVAL;
+    }
+
+    cc = rig->state.chancache;
+
+    if (!cc || ch >= cc->size)
+    {
+        return RIG_OK;
+    }
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: channel %d\n", __func__, ch);
+
+    CC_LOCK(cc);
+
+    if (ch >= 0)
+    {
+        chan_cache_drop(cc, ch);
+    }
+    else
+    {
+        for (i = 0; i < cc->size; i++)
+        {
+            chan_cache_drop(cc, i);
+        }
+    }
+
+    CC_UNLOCK(cc);
+
+    return RIG_OK;
+}
@@ -0,0 +1,45 @@
+/*
+ *  Hamlib Interface - memory channel cache
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef _CHANCACHE_H
+#define _CHANCACHE_H 1
+
+#include <hamlib/rig.h>
+
+/*
+ * rig_get_channel() asks before reading memory channel ch: 1 when the
+ * cache answers, with *retval RIG_OK and chan filled in or -RIG_ENAVAIL
+ * for a channel known to be empty, 0 when the rig has to be read.
+ */
+int chan_cache_get(RIG *rig, int ch, channel_t *chan, int *retval);
+/*
+ * Keeps what a read of memory channel ch gave: the channel on RIG_OK,
+ * the channel being empty on -RIG_ENAVAIL, nothing on other errors.
+ */
+void chan_cache_store(RIG *rig, int ch, const channel_t *chan, int retval);
+/* Channels not read by a complete bank read are empty */
+void chan_cache_mark_empty(RIG *rig);
+
+/* rig_cleanup() */
+void chan_cache_free(RIG *rig);
+
+#endif /* _CHANCACHE_H */
@@ -0,0 +1,573 @@
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file src/chanset.c
+ * \brief Packed channel sets for bulk memory operations
+ */
+
+/*
+ *  Hamlib Interface - packed channel sets
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <hamlib/config.h>
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <hamlib/rig.h>
+
+#ifndef DOC_HIDDEN
+
+#define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+#define CHAN_SET_NONE ((unsigned)-1)
+
+/* a level of a channel, only the non zero ones are kept */
+struct chan_set_level
+{
+    unsigned char idx;
+    value_t val;
+};
+
+/*
+ * One column per channel_t member, all carved out of a single arena
+ * block, so a set costs about what its channels carry instead of a whole
+ * channel_t each.  Names, levels and ext_levels go to side pools and
+ * each channel only keeps where its entries start.
+ */
+struct rig_chan_set
+{
+    int count;
+    int capacity;
+    void *arena;
+
+    int *channel_num;
+    int *bank_num;
+    vfo_t *vfo;
+    ant_t *ant;
+    freq_t *freq;
+    rmode_t *mode;
+    pbwidth_t *width;
+    freq_t *tx_freq;
+    rmode_t *tx_mode;
+    pbwidth_t *tx_width;
+    split_t *split;
+    vfo_t *tx_vfo;
+    rptr_shift_t *rptr_shift;
+    shortfreq_t *rptr_offs;
+    shortfreq_t *tuning_step;
+    shortfreq_t *rit;
+    shortfreq_t *xit;
+    setting_t *funcs;
+    tone_t *ctcss_tone;
+    tone_t *ctcss_sql;
+    tone_t *dcs_code;
+    tone_t *dcs_sql;
+    int *scan_group;
+    unsigned int *flags;
+    unsigned *desc;             /* into names, CHAN_SET_NONE for no name */
+    unsigned *lvl;              /* first entry in levels */
+    unsigned char *nlvl;
+    unsigned *ext;              /* into exts, CHAN_SET_NONE for no list */
+
+    char *names;
+    size_t names_len, names_size;
+    struct chan_set_level *levels;
+    size_t levels_len, levels_size;
+    struct ext_list *exts;      /* RIG_EXT_END terminated lists */
+    size_t exts_len, exts_size;
+};
+
+#define CS_COL(f) { offsetof(struct rig_chan_set, f), \
+                    sizeof(*((struct rig_chan_set *)0)->f) }
+
+static const struct
+{
+    size_t off;
+    size_t size;
+} chan_set_cols[] =
+{
+    CS_COL(channel_num), CS_COL(bank_num), CS_COL(vfo), CS_COL(ant),
+    CS_COL(freq), CS_COL(mode), CS_COL(width),
+    CS_COL(tx_freq), CS_COL(tx_mode), CS_COL(tx_width),
+    CS_COL(split), CS_COL(tx_vfo),
+    CS_COL(rptr_shift), CS_COL(rptr_offs), CS_COL(tuning_step),
+    CS_COL(rit), CS_COL(xit), CS_COL(funcs),
+    CS_COL(ctcss_tone), CS_COL(ctcss_sql), CS_COL(dcs_code), CS_COL(dcs_sql),
+    CS_COL(scan_group), CS_COL(flags),
+    CS_COL(desc), CS_COL(lvl), CS_COL(nlvl), CS_COL(ext),
+};
+
+#define CHAN_SET_NCOLS (sizeof(chan_set_cols) / sizeof(chan_set_cols[0]))
+
+#define CS_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+#define CS_COLPTR(set, i) \
+    ((void **)((char *)(set) + chan_set_cols[i].off))
+
+/* move every column to a new arena of room for capacity channels */
+static int chan_set_resize(struct rig_chan_set *set, int capacity)
+{
+    size_t total = 0, pos = 0;
+    char *arena;
+    int i;
+
+    for (i = 0; i < (int)CHAN_SET_NCOLS; i++)
+    {
+        total += CS_ALIGN(chan_set_cols[i].size * capacity);
+    }
+
+    arena = malloc(total ? total : 1);
+
+    if (!arena)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    for (i = 0; i < (int)CHAN_SET_NCOLS; i++)
+    {
+        void **col = CS_COLPTR(set, i);
+
+        if (set->count)
+        {
+            memcpy(arena + pos, *col, chan_set_cols[i].size * set->count);
+        }
+
+        *col = arena + pos;
+        pos += CS_ALIGN(chan_set_cols[i].size * capacity);
+    }
+
+    free(set->arena);
+    set->arena = arena;
+    set->capacity = capacity;
+
+    return RIG_OK;
+}
+
+/* make room for n more elements of size in a side pool */
+static int chan_set_pool(void **pool, size_t *len, size_t *size,
+                         size_t n, size_t elem)
+{
+    void *p;
+    size_t want = *size ? *size : 64;
+
+    if (*len + n <= *size)
+    {
+        return RIG_OK;
+    }
+
+    while (want < *len + n)
+    {
+        want *= 2;
+    }
+
+    p = realloc(*pool, want * elem);
+
+    if (!p)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    *pool = p;
+    *size = want;
+
+    return RIG_OK;
+}
+
+#endif /* !DOC_HIDDEN */
+
+
+/**
+ * \brief allocate an empty channel set
+ * \param capacity  Number of channels to make room for, it grows as needed
+ *
+ * A channel set keeps many channels packed by column, which makes a dump
+ * of thousands of channels cost kilobytes instead of a full channel_t
+ * (and an ext_levels allocation) per channel.  The whole set goes with a
+ * single rig_chan_set_free().
+ *
+ * \return the set, or NULL when out of memory.
+ *
+ * \sa rig_chan_set_free(), rig_get_chan_set()
+ */
+rig_chan_set_t *HAMLIB_API rig_chan_set_new(int capacity)
+{
+    struct rig_chan_set *set = calloc(1, sizeof(*set));
+
+    if (!set)
+    {
+        return NULL;
+    }
+
+    if (chan_set_resize(set, capacity > 0 ? capacity : 16) != RIG_OK)
+    {
+        free(set);
+        return NULL;
+    }
+
+    return set;
+}
+
+/**
+ * \brief release a channel set and everything in it
+ * \param set   The set, NULL is ignored
+ */
+void HAMLIB_API rig_chan_set_free(rig_chan_set_t *set)
+{
+    if (!set)
+    {
+        return;
+    }
+
+    free(set->arena);
+    free(set->names);
+    free(set->levels);
+    free(set->exts);
+    free(set);
+}
+
+/**
+ * \brief number of channels in a set
+ */
+int HAMLIB_API rig_chan_set_count(const rig_chan_set_t *set)
+{
+    return set ? set->count : 0;
+}
+
+/**
+ * \brief append a copy of a channel to a set
+ * \param set   The set
+ * \param chan  The channel, its ext_levels are copied too
+ *
+ * \return RIG_OK, or -RIG_ENOMEM.
+ */
+int HAMLIB_API rig_chan_set_add(rig_chan_set_t *set, const channel_t *chan)
+{
+    static const value_t zero;
+    size_t desc_len, n;
+    int i, k;
+
+    if (!set || !chan)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (set->count == set->capacity
+            && chan_set_resize(set, set->capacity * 2) != RIG_OK)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    k = set->count;
+
+    desc_len = strnlen(chan->channel_desc, sizeof(chan->channel_desc));
+    set->desc[k] = CHAN_SET_NONE;
+
+    if (desc_len)
+    {
+        if (chan_set_pool((void **)&set->names, &set->names_len, &set->names_size,
+                          desc_len + 1, 1) != RIG_OK)
+        {
+            return -RIG_ENOMEM;
+        }
+
+        set->desc[k] = set->names_len;
+        memcpy(set->names + set->names_len, chan->channel_desc, desc_len);
+        set->names[set->names_len + desc_len] = '\0';
+        set->names_len += desc_len + 1;
+    }
+
+    for (i = 0, n = 0; i < RIG_SETTING_MAX; i++)
+    {
+        n += memcmp(&chan->levels[i], &zero, sizeof(zero)) != 0;
+    }
+
+    if (chan_set_pool((void **)&set->levels, &set->levels_len,
+                      &set->levels_size, n, sizeof(struct chan_set_level)) != RIG_OK)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    set->lvl[k] = set->levels_len;
+    set->nlvl[k] = n;
+
+    for (i = 0; i < RIG_SETTING_MAX; i++)
+    {
+        if (memcmp(&chan->levels[i], &zero, sizeof(zero)) != 0)
+        {
+            set->levels[set->levels_len].idx = i;
+            set->levels[set->levels_len].val = chan->levels[i];
+            set->levels_len++;
+        }
+    }
+
+    set->ext[k] = CHAN_SET_NONE;
+
+    if (chan->ext_levels)
+    {
+        for (n = 0; !RIG_IS_EXT_END(chan->ext_levels[n]); n++) { }
+
+        if (chan_set_pool((void **)&set->exts, &set->exts_len, &set->exts_size,
+                          n + 1, sizeof(struct ext_list)) != RIG_OK)
+        {
+            return -RIG_ENOMEM;
+        }
+
+        set->ext[k] = set->exts_len;
+        memcpy(set->exts + set->exts_len, chan->ext_levels,
+               (n + 1) * sizeof(struct ext_list));
+        set->exts_len += n + 1;
+    }
+
+    set->channel_num[k] = chan->channel_num;
+    set->bank_num[k] = chan->bank_num;
+    set->vfo[k] = chan->vfo;
+    set->ant[k] = chan->ant;
+    set->freq[k] = chan->freq;
+    set->mode[k] = chan->mode;
+    set->width[k] = chan->width;
+    set->tx_freq[k] = chan->tx_freq;
+    set->tx_mode[k] = chan->tx_mode;
+    set->tx_width[k] = chan->tx_width;
+    set->split[k] = chan->split;
+    set->tx_vfo[k] = chan->tx_vfo;
+    set->rptr_shift[k] = chan->rptr_shift;
+    set->rptr_offs[k] = chan->rptr_offs;
+    set->tuning_step[k] = chan->tuning_step;
+    set->rit[k] = chan->rit;
+    set->xit[k] = chan->xit;
+    set->funcs[k] = chan->funcs;
+    set->ctcss_tone[k] = chan->ctcss_tone;
+    set->ctcss_sql[k] = chan->ctcss_sql;
+    set->dcs_code[k] = chan->dcs_code;
+    set->dcs_sql[k] = chan->dcs_sql;
+    set->scan_group[k] = chan->scan_group;
+    set->flags[k] = chan->flags;
+
+    set->count++;
+
+    return RIG_OK;
+}
+
+/**
+ * \brief unpack one channel of a set
+ * \param set   The set
+ * \param idx   Position in the set, from 0 to rig_chan_set_count() - 1
+ * \param chan  Where to unpack it
+ *
+ * chan->ext_levels is pointed into the set rather than allocated, it must
+ * not be freed and is only valid until the set is added to or freed.
+ *
+ * \return RIG_OK, or -RIG_EINVAL when idx is out of the set.
+ */
+int HAMLIB_API rig_chan_set_get(const rig_chan_set_t *set, int idx,
+                                channel_t *chan)
+{
+    unsigned i;
+
+    if (!set || !chan || idx < 0 || idx >= set->count)
+    {
+        return -RIG_EINVAL;
+    }
+
+    memset(chan, 0, sizeof(channel_t));
+
+    chan->channel_num = set->channel_num[idx];
+    chan->bank_num = set->bank_num[idx];
+    chan->vfo = set->vfo[idx];
+    chan->ant = set->ant[idx];
+    chan->freq = set->freq[idx];
+    chan->mode = set->mode[idx];
+    chan->width = set->width[idx];
+    chan->tx_freq = set->tx_freq[idx];
+    chan->tx_mode = set->tx_mode[idx];
+    chan->tx_width = set->tx_width[idx];
+    chan->split = set->split[idx];
+    chan->tx_vfo = set->tx_vfo[idx];
+    chan->rptr_shift = set->rptr_shift[idx];
+    chan->rptr_offs = set->rptr_offs[idx];
+    chan->tuning_step = set->tuning_step[idx];
+    chan->rit = set->rit[idx];
+    chan->xit = set->xit[idx];
+    chan->funcs = set->funcs[idx];
+    chan->ctcss_tone = set->ctcss_tone[idx];
+    chan->ctcss_sql = set->ctcss_sql[idx];
+    chan->dcs_code = set->dcs_code[idx];
+    chan->dcs_sql = set->dcs_sql[idx];
+    chan->scan_group = set->scan_group[idx];
+    chan->flags = set->flags[idx];
+
+    if (set->desc[idx] != CHAN_SET_NONE)
+    {
+        strncpy(chan->channel_desc, set->names + set->desc[idx],
+                sizeof(chan->channel_desc) - 1);
+    }
+
+    for (i = 0; i < set->nlvl[idx]; i++)
+    {
+        const struct chan_set_level *l = &set->levels[set->lvl[idx] + i];
+
+        chan->levels[l->idx] = l->val;
+    }
+
+    if (set->ext[idx] != CHAN_SET_NONE)
+    {
+        chan->ext_levels = set->exts + set->ext[idx];
+    }
+
+    return RIG_OK;
+}
+
+/**
+ * \brief frequency of one channel of a set, without unpacking it
+ * \return the frequency, or 0 when idx is out of the set
+ */
+freq_t HAMLIB_API rig_chan_set_freq(const rig_chan_set_t *set, int idx)
+{
+    return set && idx >= 0 && idx < set->count ? set->freq[idx] : 0;
+}
+
+
+#ifndef DOC_HIDDEN
+
+struct chan_set_fill
+{
+    rig_chan_set_t *set;
+    channel_t chan;
+    int retval;
+};
+
+/* chan_cb_t packing each channel read into the set */
+static int chan_set_fill_cb(RIG *rig, channel_t **chan, int channel_num,
+                            const chan_t *chan_list, rig_ptr_t arg)
+{
+    struct chan_set_fill *fill = (struct chan_set_fill *)arg;
+
+    if (*chan != NULL)
+    {
+        fill->retval = rig_chan_set_add(fill->set, *chan);
+
+        if (fill->retval != RIG_OK)
+        {
+            return fill->retval;
+        }
+    }
+
+    /* the scratch channel is reused, drop what the last read put in it */
+    free(fill->chan.ext_levels);
+    memset(&fill->chan, 0, sizeof(fill->chan));
+    *chan = &fill->chan;
+
+    return RIG_OK;
+}
+
+#endif /* !DOC_HIDDEN */
+
+
+/**
+ * \brief read all the memory channels into a set
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param set   The set, channels are appended to it
+ *
+ * Goes through rig_get_chan_all_cb(), so backends with a bulk or clone
+ * mode dump benefit from it the same way.  Empty channels are left out.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_set_chan_set(), rig_chan_set_new()
+ */
+int HAMLIB_API rig_get_chan_set(RIG *rig, vfo_t vfo, rig_chan_set_t *set)
+{
+    struct chan_set_fill fill;
+    int retval;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (CHECK_RIG_ARG(rig) || !set)
+    {
+        return -RIG_EINVAL;
+    }
+
+    memset(&fill, 0, sizeof(fill));
+    fill.set = set;
+
+    retval = rig_get_chan_all_cb(rig, vfo, chan_set_fill_cb, (rig_ptr_t)&fill);
+
+    free(fill.chan.ext_levels);
+
+    if (retval == RIG_OK && fill.retval != RIG_OK)
+    {
+        retval = fill.retval;
+    }
+
+    return retval;
+}
+
+/**
+ * \brief write every channel of a set to the rig
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param set   The set
+ *
+ * Only the channels in the set are written, each to its channel_num.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_get_chan_set()
+ */
+int HAMLIB_API rig_set_chan_set(RIG *rig, vfo_t vfo, const rig_chan_set_t *set)
+{
+    channel_t chan;
+    int i;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (CHECK_RIG_ARG(rig) || !set)
+    {
+        return -RIG_EINVAL;
+    }
+
+    for (i = 0; i < set->count; i++)
+    {
+        int retval;
+
+        rig_chan_set_get(set, i, &chan);
+        chan.vfo = RIG_VFO_MEM;
+
+        retval = rig_set_channel(rig, vfo, &chan);
+
+        if (retval != RIG_OK)
+        {
+            return retval;
+        }
+    }
+
+    return RIG_OK;
+}
+
+/** @} */
@@ -0,0 +1,355 @@
+/*
+ *  Hamlib Interface - clone mode memory images
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <hamlib/rig.h>
+#include "clone.h"
+
+#define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+/* offset of entry idx of a table in the image, or -1 past its end */
+static long clone_entry(const struct rig_clone_layout *layout,
+                        const struct rig_clone_tbl *tbl, int idx)
+{
+    size_t off;
+
+    if (idx < 0 || idx >= tbl->count)
+    {
+        return -1;
+    }
+
+    if (tbl->per_page)
+    {
+        off = tbl->base + (size_t)(idx / tbl->per_page) * tbl->page_size
+              + (size_t)(idx % tbl->per_page) * tbl->entry_size;
+    }
+    else
+    {
+        off = tbl->base + (size_t)idx * tbl->entry_size;
+    }
+
+    if (off + tbl->entry_size > layout->image_size)
+    {
+        return -1;
+    }
+
+    return (long)off;
+}
+
+static unsigned long clone_number(const unsigned char *p,
+                                  const struct rig_clone_field *f)
+{
+    unsigned long v = 0;
+    int i;
+
+    for (i = 0; i < f->size; i++)
+    {
+        unsigned char b = f->enc == RIG_CLONE_ENC_LE
+                          || f->enc == RIG_CLONE_ENC_BCD_LE ? p[f->size - 1 - i] : p[i];
+
+        if (f->enc == RIG_CLONE_ENC_BCD_LE || f->enc == RIG_CLONE_ENC_BCD_BE)
+        {
+            v = v * 100 + (b >> 4) * 10 + (b & 0x0f);
+        }
+        else
+        {
+            v = (v << 8) | b;
+        }
+    }
+
+    v >>= f->shift;
+
+    if (f->mask) { v &= f->mask; }
+
+    return v * (f->scale ? f->scale : 1);
+}
+
+static void clone_text(char *dst, size_t dstlen, const unsigned char *p,
+                       int size)
+{
+    int n = size < (int)dstlen - 1 ? size : (int)dstlen - 1;
+
+    while (n > 0 && (p[n - 1] == 0x00 || p[n - 1] == 0xff || p[n - 1] == ' '))
+    {
+        n--;
+    }
+
+    memcpy(dst, p, n);
+    dst[n] = '\0';
+}
+
+/* list lookup for the table driven items, 0 when out of range */
+static int clone_lookup(const struct rig_clone_field *f, unsigned long v)
+{
+    return f->list && v < (unsigned long)f->list_len ? f->list[v] : 0;
+}
+
+/**
+ * \brief decode one channel out of a clone image
+ * \return RIG_OK, or -RIG_ENAVAIL for an unused slot
+ */
+int rig_clone_decode_chan(RIG *rig, const struct rig_clone_layout *layout,
+                          const unsigned char *image, int channel_num,
+                          channel_t *chan)
+{
+    const struct rig_clone_field *f;
+    int idx = channel_num - layout->first_channel;
+    long rec;
+    int i;
+
+    if (idx < 0 || idx >= layout->channels)
+    {
+        return -RIG_EINVAL;
+    }
+
+    rec = clone_entry(layout, &layout->tbl[RIG_CLONE_TBL_REC], idx);
+
+    if (rec < 0)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    for (i = 0; i < layout->empty_size && image[rec + i] == layout->empty_byte;
+            i++) { }
+
+    if (layout->empty_size && i == layout->empty_size)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    memset(chan, 0, sizeof(channel_t));
+    chan->vfo = RIG_VFO_MEM;
+    chan->channel_num = channel_num;
+    chan->tx_freq = RIG_FREQ_NONE;
+    chan->split = RIG_SPLIT_OFF;
+
+    for (f = layout->fields; f->item != RIG_CLONE_END; f++)
+    {
+        long off = clone_entry(layout, &layout->tbl[f->table], idx);
+        const unsigned char *p;
+        unsigned long v;
+
+        if (off < 0 || f->offset + f->size > layout->tbl[f->table].entry_size)
+        {
+            continue;
+        }
+
+        p = image + off + f->offset;
+
+        if (f->item == RIG_CLONE_NAME)
+        {
+            clone_text(chan->channel_desc, sizeof(chan->channel_desc), p, f->size);
+            continue;
+        }
+
+        v = clone_number(p, f);
+
+        switch (f->item)
+        {
+        case RIG_CLONE_FREQ: chan->freq = (freq_t)v; break;
+
+        case RIG_CLONE_TX_FREQ:
+            chan->tx_freq = (freq_t)v;
+            chan->split = v ? RIG_SPLIT_ON : RIG_SPLIT_OFF;
+            break;
+
+        case RIG_CLONE_RPTR_OFFS: chan->rptr_offs = (shortfreq_t)v; break;
+
+        case RIG_CLONE_RPTR_SHIFT:
+            chan->rptr_shift = (rptr_shift_t)clone_lookup(f, v);
+            break;
+
+        case RIG_CLONE_MODE: chan->mode = (rmode_t)clone_lookup(f, v); break;
+
+        case RIG_CLONE_TS: chan->tuning_step = clone_lookup(f, v); break;
+
+        case RIG_CLONE_CTCSS_TONE: chan->ctcss_tone = clone_lookup(f, v); break;
+
+        case RIG_CLONE_CTCSS_SQL: chan->ctcss_sql = clone_lookup(f, v); break;
+
+        case RIG_CLONE_DCS_CODE: chan->dcs_code = clone_lookup(f, v); break;
+
+        case RIG_CLONE_SKIP:
+            if (v) { chan->flags |= RIG_CHFLAG_SKIP; }
+
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if (chan->freq == 0)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    return RIG_OK;
+}
+
+/*
+ * rig_get_chan_all_cb() for a backend with clone_read: one transfer of
+ * the whole image, then every channel of chan_list decoded from memory.
+ */
+int rig_clone_get_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
+                              rig_ptr_t arg)
+{
+    const struct rig_clone_layout *layout = rig->caps->clone_layout;
+    const chan_t *chan_list = rig->state.chan_list;
+    unsigned char *image;
+    channel_t *chan;
+    int i, j;
+    int retval;
+
+    image = malloc(layout->image_size);
+
+    if (!image)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    retval = rig_clone_read(rig, image, layout->image_size);
+
+    for (i = 0; retval == RIG_OK && !RIG_IS_CHAN_END(chan_list[i])
+            && i < HAMLIB_CHANLSTSIZ; i++)
+    {
+        chan = NULL;
+        retval = chan_cb(rig, &chan, chan_list[i].startc, chan_list, arg);
+
+        if (retval == RIG_OK && chan == NULL)
+        {
+            retval = -RIG_ENOMEM;
+        }
+
+        for (j = chan_list[i].startc; retval == RIG_OK && j <= chan_list[i].endc;
+                j++)
+        {
+            int chan_next = j < chan_list[i].endc ? j + 1 : j;
+
+            if (rig_clone_decode_chan(rig, layout, image, j, chan) != RIG_OK)
+            {
+                continue;
+            }
+
+            retval = chan_cb(rig, &chan, chan_next, chan_list, arg);
+        }
+    }
+
+    free(image);
+
+    return retval;
+}
+
+/**
+ * \brief size of the clone mode memory image
+ * \param rig   The rig handle
+ *
+ * \return the number of bytes rig_clone_read() needs, 0 when the rig has
+ * no clone mode support in Hamlib.
+ *
+ * \sa rig_clone_read(), rig_clone_write()
+ */
+size_t HAMLIB_API rig_clone_size(RIG *rig)
+{
+    if (!rig || !rig->caps || !rig->caps->clone_read || !rig->caps->clone_layout)
+    {
+        return 0;
+    }
+
+    return rig->caps->clone_layout->image_size;
+}
+
+/**
+ * \brief read the whole memory image in clone mode
+ * \param rig   The rig handle
+ * \param image Where to store the image
+ * \param len   Size of \a image, rig_clone_size() bytes are needed
+ *
+ * The rig is put in clone (programming) mode for the transfer and taken
+ * out of it afterwards, so CAT is usable again once this returns.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_clone_write(), rig_clone_size()
+ */
+int HAMLIB_API rig_clone_read(RIG *rig, unsigned char *image, size_t len)
+{
+    size_t size;
+
+    if (CHECK_RIG_ARG(rig) || !image)
+    {
+        return -RIG_EINVAL;
+    }
+
+    size = rig_clone_size(rig);
+
+    if (size == 0)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    if (len < size)
+    {
+        return -RIG_EINVAL;
+    }
+
+    return rig->caps->clone_read(rig, image, size);
+}
+
+/**
+ * \brief write a whole memory image back in clone mode
+ * \param rig   The rig handle
+ * \param image An image as read by rig_clone_read(), possibly edited
+ * \param len   Size of \a image, must be rig_clone_size()
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_clone_read(), rig_clone_size()
+ */
+int HAMLIB_API rig_clone_write(RIG *rig, const unsigned char *image,
+                               size_t len)
+{
+    if (CHECK_RIG_ARG(rig) || !image)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (!rig->caps->clone_write || rig_clone_size(rig) == 0)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    if (len != rig_clone_size(rig))
+    {
+        return -RIG_EINVAL;
+    }
+
+    rig_chan_cache_invalidate(rig, -1);
+
+    return rig->caps->clone_write(rig, image, len);
+}
@@ -0,0 +1,116 @@
+/*
+ *  Hamlib Interface - clone mode memory images
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _CLONE_H
+#define _CLONE_H
+
+#include <hamlib/rig.h>
+
+/*
+ * A backend that can transfer the radio's whole memory image in clone
+ * mode sets clone_read/clone_write in its caps, plus a clone_layout that
+ * says where a channel lives in that image.  rig_get_chan_all_cb() then
+ * reads the image once and decodes every channel from memory instead of
+ * asking for them one CAT command at a time.
+ */
+
+/* where a field's bytes are: the channel record or one of the side tables */
+enum rig_clone_table
+{
+    RIG_CLONE_TBL_REC = 0,
+    RIG_CLONE_TBL_NAME,
+    RIG_CLONE_TBL_FLAG,
+    RIG_CLONE_TBL_MAX
+};
+
+/* how the bytes of a field are coded */
+enum rig_clone_enc
+{
+    RIG_CLONE_ENC_LE,       /* little endian binary, size bytes */
+    RIG_CLONE_ENC_BE,       /* big endian binary, size bytes */
+    RIG_CLONE_ENC_BCD_LE,   /* packed BCD, least significant byte first */
+    RIG_CLONE_ENC_BCD_BE,   /* packed BCD, most significant byte first */
+    RIG_CLONE_ENC_TEXT,     /* size characters, padded with 0x00/0xff/space */
+};
+
+/* which channel_t member a field fills */
+enum rig_clone_item
+{
+    RIG_CLONE_END = 0,
+    RIG_CLONE_FREQ,
+    RIG_CLONE_TX_FREQ,
+    RIG_CLONE_RPTR_OFFS,
+    RIG_CLONE_RPTR_SHIFT,   /* index into list */
+    RIG_CLONE_MODE,         /* index into list */
+    RIG_CLONE_TS,           /* index into list */
+    RIG_CLONE_CTCSS_TONE,   /* index into list */
+    RIG_CLONE_CTCSS_SQL,    /* index into list */
+    RIG_CLONE_DCS_CODE,     /* index into list */
+    RIG_CLONE_SKIP,         /* non zero sets RIG_CHFLAG_SKIP */
+    RIG_CLONE_NAME,
+};
+
+struct rig_clone_field
+{
+    enum rig_clone_item item;
+    enum rig_clone_table table;
+    unsigned short offset;      /* in the table entry */
+    unsigned char size;         /* bytes */
+    enum rig_clone_enc enc;
+    unsigned char shift;        /* applied before mask, for bit fields */
+    unsigned int mask;          /* 0 for all bits */
+    int scale;                  /* value multiplier, 0 for 1 */
+    const int *list;            /* item specific value list */
+    int list_len;
+};
+
+/*
+ * A table is an array of fixed size entries, one per channel, grouped
+ * in pages of per_page entries that start every page_size bytes when the
+ * radio lays them out that way (per_page 0 means one packed array).
+ */
+struct rig_clone_tbl
+{
+    size_t base;
+    unsigned short entry_size;
+    unsigned short per_page;
+    unsigned short page_size;
+    int count;                  /* entries in the table, 0 if unused */
+};
+
+struct rig_clone_layout
+{
+    size_t image_size;
+    int first_channel;          /* channel number of entry 0 */
+    int channels;
+    struct rig_clone_tbl tbl[RIG_CLONE_TBL_MAX];
+    /* a slot whose record starts with empty_size bytes of empty_byte is unused */
+    unsigned char empty_byte;
+    unsigned char empty_size;
+    const struct rig_clone_field *fields;   /* ends with RIG_CLONE_END */
+};
+
+int rig_clone_decode_chan(RIG *rig, const struct rig_clone_layout *layout,
+                          const unsigned char *image, int channel_num,
+                          channel_t *chan);
+int rig_clone_get_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
+                              rig_ptr_t arg);
+
+#endif /* _CLONE_H */
@@ -40,6 +40,16 @@
 
 #include <hamlib/rig.h>
 #include "token.h"
+#include "snapshot_data.h"
+#include "spectrum_proc.h"
+#include "spectrum_history.h"
+#include "keyer.h"
+#include "capture.h"
+#include "shmcache.h"
+#include "journal.h"
+#include "conf_index.h"
+#include "caps_index.h"
+#include "sprintflst.h"
 
 
 /*
@@ -126,6 +136,166 @@ static const struct confparams frontend_cfg_params[] =
         "Cache timeout, value of 0 disables caching",
         "500", RIG_CONF_NUMERIC, { .n = {0, 5000, 1}}
     },
+    {
+        TOK_CACHE_LEVEL_TIMEOUT, "cache_level_timeout", "Level cache timeout in ms",
+        "How long a level that was set or read stays in the cache, 0 disables level caching. Meters are only cached when the backend streams them",
+        "500", RIG_CONF_NUMERIC, { .n = {0, 60000, 1}}
+    },
+    {
+        TOK_CACHE_FUNC_TIMEOUT, "cache_func_timeout", "Func cache timeout in ms",
+        "How long a function status that was set or read stays in the cache, 0 disables func caching",
+        "500", RIG_CONF_NUMERIC, { .n = {0, 60000, 1}}
+    },
+    {
+        TOK_PACED_WRITER, "paced_writer", "Paced writer thread",
+        "True sends write_delay paced commands from a thread of its own so callers do not wait for every byte",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_OPEN_CACHE, "open_cache", "Open cache",
+        "True keeps the rig ID and similar facts found by rig_open on disk, under $XDG_CACHE_HOME/hamlib, so the next open can skip asking for them",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_OPEN_FAST, "open_fast", "Fast open",
+        "True returns from rig_open once the rig has identified, the frequency and mode of each VFO are read when first asked for",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_CW_KEY, "cw_key", "CW key line",
+        "Line send_morse keys CW on from a timing thread: DTR or RTS of the PTT serial port, or of the rig port, or the PTT line itself. None leaves CW to the rig",
+        "None", RIG_CONF_COMBO, { .c = {{ "None", "DTR", "RTS", "PTT", NULL }} }
+    },
+    {
+        TOK_CW_WPM, "cw_wpm", "CW speed",
+        "Speed in words per minute of the CW keyed by Hamlib",
+        "20", RIG_CONF_NUMERIC, { .n = {5, 100, 1}}
+    },
+    {
+        TOK_CW_PTT_LEAD, "cw_ptt_lead", "CW PTT lead in ms",
+        "Time from PTT to the first CW element when PTT has a line of its own",
+        "50", RIG_CONF_NUMERIC, { .n = {0, 1000, 1}}
+    },
+    {
+        TOK_CW_PTT_TAIL, "cw_ptt_tail", "CW PTT tail in ms",
+        "Time PTT is held after the last CW element",
+        "200", RIG_CONF_NUMERIC, { .n = {0, 5000, 1}}
+    },
+    {
+        TOK_MORSE_QUEUE, "morse_queue", "CW queue",
+        "True makes send_morse return at once, a thread hands the queued messages to the rig as its keyer buffer takes them",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_PTT_FAST, "ptt_fast", "Fast PTT",
+        "True makes set_ptt go straight to the PTT line or the rig's PTT command, without VFO switching or settle delays",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_SERIAL_LOW_LATENCY, "serial_low_latency", "Low latency serial port",
+        "True sets ASYNC_LOW_LATENCY on the rig port and its FTDI latency timer to 1 ms where writable, restored on close",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_CAPTURE_FILE, "capture_file", "Capture file",
+        "Records every write to and read from the rig port with timestamps in this file",
+        "", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_REPLAY_FILE, "replay_file", "Replay file",
+        "Plays a capture_file back in place of the rig, answering the backend's commands from it",
+        "", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_POLL_LEVELS, "poll_levels", "Polled levels",
+        "Levels the poll routine reads every other poll_interval, e.g. STRENGTH,SWR; empty for none",
+        "", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_SHM_CACHE, "shm_cache", "Shared memory cache",
+        "Name of a shared memory segment local processes read the rig cache from, see rig_shm.h; empty for none",
+        "", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_JOURNAL_FILE, "journal_file", "State journal",
+        "File every frequency, mode, PTT, split and VFO change is appended to, see rig_journal.h; empty for none",
+        "", RIG_CONF_STRING, { }
+    },
+    {
+        TOK_JOURNAL_SIZE, "journal_size", "State journal records",
+        "Records the journal_file keeps before the oldest are overwritten, 32 bytes each",
+        "65536", RIG_CONF_NUMERIC, { .n = {1024, 16777216, 1}}
+    },
+    {
+        TOK_TIMEOUT_ADAPTIVE, "timeout_adaptive", "Adaptive timeout",
+        "True makes rig port reads wait srtt + 4 * rttvar of the replies seen so far to that command, as TCP does, at most timeout",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_TIMEOUT_FLOOR, "timeout_floor", "Adaptive timeout floor in ms",
+        "Shortest timeout timeout_adaptive will use",
+        "20", RIG_CONF_NUMERIC, { .n = {1, 10000, 1}}
+    },
+    {
+        TOK_CHAN_CACHE, "chan_cache", "Memory channel cache",
+        "True answers read-only rig_get_channel() of a memory channel from the last read of it, until a memory write",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_CACHE_ADAPTIVE, "cache_adaptive_max", "Adaptive cache timeout ceiling in ms",
+        "Lets unchanged cache entries live up to this long while the rig is idle, 0 keeps cache_timeout fixed",
+        "0", RIG_CONF_NUMERIC, { .n = {0, 60000, 1}}
+    },
+    {
+        TOK_COALESCE, "coalesce", "set_freq/set_mode coalescing window in ms",
+        "Queues set_freq/set_mode and sends only the latest value at most once per window, 0 sends every call",
+        "0", RIG_CONF_NUMERIC, { .n = {0, 1000, 1}}
+    },
+    {
+        TOK_MULTICAST_SPECTRUM, "multicast_spectrum", "Multicast spectrum format",
+        "Send spectrum lines in the JSON snapshot, as compact binary packets, or both; Compressed is binary with the lines entropy coded, for slow links",
+        "JSON", RIG_CONF_COMBO, { .c = {{ "JSON", "Binary", "Both", "Compressed", NULL }} }
+    },
+    {
+        TOK_SPECTRUM_LINES, "spectrum_lines", "Spectrum lines combined",
+        "Number of spectrum scope lines combined into one before callbacks and multicast, 0 or 1 for none",
+        "0", RIG_CONF_NUMERIC, { .n = {0, SPECTRUM_PROC_MAX_LINES, 1}}
+    },
+    {
+        TOK_SPECTRUM_REDUCE, "spectrum_reduce", "Spectrum combining",
+        "Combine spectrum lines and bins by average or by peak hold",
+        "Average", RIG_CONF_COMBO, { .c = {{ "Average", "Peak", NULL }} }
+    },
+    {
+        TOK_SPECTRUM_WIDTH, "spectrum_width", "Spectrum width",
+        "Maximum number of bins per spectrum line, 0 for no limit",
+        "0", RIG_CONF_NUMERIC, { .n = {0, HAMLIB_MAX_SPECTRUM_DATA, 1}}
+    },
+    {
+        TOK_SPECTRUM_DB, "spectrum_db", "Spectrum in dB",
+        "True rescales spectrum data to 1 dB per step above the minimum signal strength",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
+    {
+        TOK_PUSH_TIMEOUT, "push_timeout", "Pushed cache timeout",
+        "Milliseconds after the last change report from the rig that freq/mode/ptt are answered from the cache without polling, 0 for no limit",
+        "5000", RIG_CONF_NUMERIC, { .n = {0, 3600000, 1}}
+    },
+    {
+        TOK_MULTICAST_BATCH, "multicast_batch", "Multicast batching window",
+        "Milliseconds to wait for further state updates before sending a multicast snapshot, 0 sends one per update",
+        "0", RIG_CONF_NUMERIC, { .n = {0, 1000, 1}}
+    },
+    {
+        TOK_MULTICAST_KEYFRAME, "multicast_keyframe", "Multicast keyframe interval",
+        "Send only the changed fields in multicast state snapshots, with a full snapshot every this many packets, 0 for full snapshots only",
+        "0", RIG_CONF_NUMERIC, { .n = {0, 1000, 1}}
+    },
+    {
+        TOK_SPECTRUM_HISTORY, "spectrum_history", "Spectrum history",
+        "Number of recent spectrum lines kept per scope for rig_get_spectrum_history, 0 for none",
+        "0", RIG_CONF_NUMERIC, { .n = {0, SPECTRUM_HISTORY_MAX_LINES, 1}}
+    },
     {
         TOK_AUTO_POWER_ON, "auto_power_on", "Auto power on",
         "True enables compatible rigs to be powered up on open",
@@ -171,6 +341,11 @@ static const struct confparams frontend_cfg_params[] =
         "True enables asynchronous data transfer for backends that support it. This allows use of transceive and spectrum data.",
         "0", RIG_CONF_CHECKBUTTON, { }
     },
+    {
+        TOK_ASYNC_SHARED, "async_shared", "Shared async reader",
+        "True reads the async data of this rig from one thread shared by every rig of the process with it set, woken by epoll/kqueue; a failing port is retried after up to 500 ms",
+        "0", RIG_CONF_CHECKBUTTON, { }
+    },
 
     { RIG_CONF_END, NULL, }
 };
@@ -493,6 +668,8 @@ static int frontend_set_conf(RIG *rig, token_t token, const char *val)
             return -RIG_EINVAL;
         }
 
+        if (rs->caps_index) { rig_caps_index_build(rig); }
+
         break;
 
     case TOK_PTT_TYPE:
@@ -635,6 +812,345 @@ static int frontend_set_conf(RIG *rig, token_t token, const char *val)
         rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_ALL, atol(val));
         break;
 
+    case TOK_CACHE_ADAPTIVE:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->cache_adaptive_max_ms = val_i;
+        break;
+
+    case TOK_COALESCE:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->coalesce_ms = val_i;
+        break;
+
+    case TOK_MULTICAST_SPECTRUM:
+        if (!strcmp(val, "JSON"))
+        {
+            rs->multicast_spectrum = SNAPSHOT_SPECTRUM_JSON;
+        }
+        else if (!strcmp(val, "Binary"))
+        {
+            rs->multicast_spectrum = SNAPSHOT_SPECTRUM_BINARY;
+        }
+        else if (!strcmp(val, "Both"))
+        {
+            rs->multicast_spectrum = SNAPSHOT_SPECTRUM_BOTH;
+        }
+        else if (!strcmp(val, "Compressed"))
+        {
+            rs->multicast_spectrum = SNAPSHOT_SPECTRUM_COMPRESSED;
+        }
+        else
+        {
+            return -RIG_EINVAL;
+        }
+
+        break;
+
+    case TOK_SPECTRUM_LINES:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0
+                || val_i > SPECTRUM_PROC_MAX_LINES)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->spectrum_lines = val_i;
+        break;
+
+    case TOK_SPECTRUM_REDUCE:
+        if (!strcmp(val, "Average"))
+        {
+            rs->spectrum_reduce = SPECTRUM_REDUCE_AVERAGE;
+        }
+        else if (!strcmp(val, "Peak"))
+        {
+            rs->spectrum_reduce = SPECTRUM_REDUCE_PEAK;
+        }
+        else
+        {
+            return -RIG_EINVAL;
+        }
+
+        break;
+
+    case TOK_SPECTRUM_WIDTH:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0
+                || val_i > HAMLIB_MAX_SPECTRUM_DATA)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->spectrum_width = val_i;
+        break;
+
+    case TOK_SPECTRUM_DB:
+        if (1 != sscanf(val, "%d", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->spectrum_db = val_i ? 1 : 0;
+        break;
+
+    case TOK_PUSH_TIMEOUT:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->push_timeout_ms = val_i;
+        break;
+
+    case TOK_CACHE_LEVEL_TIMEOUT:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_LEVEL, val_i);
+        break;
+
+    case TOK_CACHE_FUNC_TIMEOUT:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_FUNC, val_i);
+        break;
+
+    case TOK_PACED_WRITER:
+        if (1 != sscanf(val, "%d", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->paced_writer = val_i ? 1 : 0;
+        break;
+
+    case TOK_OPEN_CACHE:
+        if (1 != sscanf(val, "%d", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->open_cache = val_i ? 1 : 0;
+        break;
+
+    case TOK_OPEN_FAST:
+        if (1 != sscanf(val, "%d", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->open_fast = val_i ? 1 : 0;
+        break;
+
+    case TOK_CW_KEY:
+        if (!strcmp(val, "None"))
+        {
+            rs->cw_key = KEYER_NONE;
+        }
+        else if (!strcmp(val, "DTR"))
+        {
+            rs->cw_key = KEYER_DTR;
+        }
+        else if (!strcmp(val, "RTS"))
+        {
+            rs->cw_key = KEYER_RTS;
+        }
+        else if (!strcmp(val, "PTT"))
+        {
+            rs->cw_key = KEYER_PTT;
+        }
+        else
+        {
+            return -RIG_EINVAL;
+        }
+
+        break;
+
+    case TOK_CW_WPM:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 5 || val_i > 100)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->cw_wpm = val_i;
+        break;
+
+    case TOK_CW_PTT_LEAD:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->cw_ptt_lead_ms = val_i;
+        break;
+
+    case TOK_CW_PTT_TAIL:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->cw_ptt_tail_ms = val_i;
+        break;
+
+    case TOK_PTT_FAST:
+        if (1 != sscanf(val, "%d", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->ptt_fast = val_i ? 1 : 0;
+        break;
+
+    case TOK_MORSE_QUEUE:
+        if (1 != sscanf(val, "%d", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->morse_queue = val_i ? 1 : 0;
+        break;
+
+    case TOK_SERIAL_LOW_LATENCY:
+        if (1 != sscanf(val, "%d", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->serial_low_latency = val_i ? 1 : 0;
+        break;
+
+    case TOK_CAPTURE_FILE:
+        return capture_set_file(rig, val);
+
+    case TOK_REPLAY_FILE:
+        return replay_set_file(rig, val);
+
+    case TOK_SHM_CACHE:
+        return rig_shm_set_name(rig, val);
+
+    case TOK_JOURNAL_FILE:
+        return rig_journal_set_path(rig, val);
+
+    case TOK_JOURNAL_SIZE:
+        if (1 != sscanf(val, "%d", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        return rig_journal_set_size(rig, val_i);
+
+    case TOK_TIMEOUT_ADAPTIVE:
+        if (1 != sscanf(val, "%d", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->timeout_adaptive = val_i ? 1 : 0;
+        break;
+
+    case TOK_TIMEOUT_FLOOR:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 1)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->timeout_floor = val_i;
+        break;
+
+    case TOK_CHAN_CACHE:
+        if (1 != sscanf(val, "%d", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->chan_cache = val_i ? 1 : 0;
+
+        /* memory writes while off are not seen */
+        if (!rs->chan_cache)
+        {
+            rig_chan_cache_invalidate(rig, -1);
+        }
+
+        break;
+
+    case TOK_POLL_LEVELS:
+    {
+        setting_t levels = RIG_LEVEL_NONE;
+        const char *p = val;
+
+        while (*(p += strspn(p, " ,")) != '\0')
+        {
+            char name[32];
+            size_t n = strcspn(p, " ,");
+            setting_t level;
+
+            if (n >= sizeof(name))
+            {
+                return -RIG_EINVAL;
+            }
+
+            memcpy(name, p, n);
+            name[n] = '\0';
+            level = rig_parse_level(name);
+
+            if (level == RIG_LEVEL_NONE)
+            {
+                return -RIG_EINVAL;
+            }
+
+            levels |= level;
+            p += n;
+        }
+
+        rs->poll_levels = levels;
+        break;
+    }
+
+    case TOK_MULTICAST_BATCH:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->multicast_batch_ms = val_i;
+        break;
+
+    case TOK_MULTICAST_KEYFRAME:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->multicast_keyframe = val_i;
+        break;
+
+    case TOK_SPECTRUM_HISTORY:
+        if (1 != sscanf(val, "%d", &val_i) || val_i < 0
+                || val_i > SPECTRUM_HISTORY_MAX_LINES)
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        if (spectrum_history_init(rig, val_i) != RIG_OK)
+        {
+            return -RIG_ENOMEM;
+        }
+
+        rs->spectrum_history_lines = val_i;
+        break;
+
     case TOK_AUTO_POWER_ON:
         if (1 != sscanf(val, "%d", &val_i))
         {
@@ -716,6 +1232,15 @@ static int frontend_set_conf(RIG *rig, token_t token, const char *val)
         rs->async_data_enabled = val_i ? 1 : 0;
         break;
 
+    case TOK_ASYNC_SHARED:
+        if (1 != sscanf(val, "%d", &val_i))
+        {
+            return -RIG_EINVAL; //value format error
+        }
+
+        rs->async_shared = val_i ? 1 : 0;
+        break;
+
     default:
         return -RIG_EINVAL;
     }
@@ -1028,6 +1553,141 @@ static int frontend_get_conf2(RIG *rig, token_t token, char *val, int val_len)
         SNPRINTF(val, val_len, "%d", rig_get_cache_timeout_ms(rig, HAMLIB_CACHE_ALL));
         break;
 
+    case TOK_CACHE_ADAPTIVE:
+        SNPRINTF(val, val_len, "%d", rs->cache_adaptive_max_ms);
+        break;
+
+    case TOK_COALESCE:
+        SNPRINTF(val, val_len, "%d", rs->coalesce_ms);
+        break;
+
+    case TOK_MULTICAST_SPECTRUM:
+        SNPRINTF(val, val_len, "%s",
+                 rs->multicast_spectrum == SNAPSHOT_SPECTRUM_BINARY ? "Binary" :
+                 rs->multicast_spectrum == SNAPSHOT_SPECTRUM_BOTH ? "Both" :
+                 rs->multicast_spectrum == SNAPSHOT_SPECTRUM_COMPRESSED ? "Compressed" : "JSON");
+        break;
+
+    case TOK_SPECTRUM_LINES:
+        SNPRINTF(val, val_len, "%d", rs->spectrum_lines);
+        break;
+
+    case TOK_SPECTRUM_REDUCE:
+        SNPRINTF(val, val_len, "%s",
+                 rs->spectrum_reduce == SPECTRUM_REDUCE_PEAK ? "Peak" : "Average");
+        break;
+
+    case TOK_SPECTRUM_WIDTH:
+        SNPRINTF(val, val_len, "%d", rs->spectrum_width);
+        break;
+
+    case TOK_SPECTRUM_DB:
+        SNPRINTF(val, val_len, "%d", rs->spectrum_db);
+        break;
+
+    case TOK_PUSH_TIMEOUT:
+        SNPRINTF(val, val_len, "%d", rs->push_timeout_ms);
+        break;
+
+    case TOK_CACHE_LEVEL_TIMEOUT:
+        SNPRINTF(val, val_len, "%d", rig_get_cache_timeout_ms(rig, HAMLIB_CACHE_LEVEL));
+        break;
+
+    case TOK_CACHE_FUNC_TIMEOUT:
+        SNPRINTF(val, val_len, "%d", rig_get_cache_timeout_ms(rig, HAMLIB_CACHE_FUNC));
+        break;
+
+    case TOK_PACED_WRITER:
+        SNPRINTF(val, val_len, "%d", rs->paced_writer);
+        break;
+
+    case TOK_OPEN_CACHE:
+        SNPRINTF(val, val_len, "%d", rs->open_cache);
+        break;
+
+    case TOK_OPEN_FAST:
+        SNPRINTF(val, val_len, "%d", rs->open_fast);
+        break;
+
+    case TOK_CW_KEY:
+        SNPRINTF(val, val_len, "%s",
+                 rs->cw_key == KEYER_DTR ? "DTR" :
+                 rs->cw_key == KEYER_RTS ? "RTS" :
+                 rs->cw_key == KEYER_PTT ? "PTT" : "None");
+        break;
+
+    case TOK_CW_WPM:
+        SNPRINTF(val, val_len, "%d", rs->cw_wpm);
+        break;
+
+    case TOK_CW_PTT_LEAD:
+        SNPRINTF(val, val_len, "%d", rs->cw_ptt_lead_ms);
+        break;
+
+    case TOK_CW_PTT_TAIL:
+        SNPRINTF(val, val_len, "%d", rs->cw_ptt_tail_ms);
+        break;
+
+    case TOK_PTT_FAST:
+        SNPRINTF(val, val_len, "%d", rs->ptt_fast);
+        break;
+
+    case TOK_MORSE_QUEUE:
+        SNPRINTF(val, val_len, "%d", rs->morse_queue);
+        break;
+
+    case TOK_SERIAL_LOW_LATENCY:
+        SNPRINTF(val, val_len, "%d", rs->serial_low_latency);
+        break;
+
+    case TOK_CAPTURE_FILE:
+        SNPRINTF(val, val_len, "%s", capture_get_file(rig));
+        break;
+
+    case TOK_REPLAY_FILE:
+        SNPRINTF(val, val_len, "%s", replay_get_file(rig));
+        break;
+
+    case TOK_SHM_CACHE:
+        SNPRINTF(val, val_len, "%s", rig_shm_get_name(rig));
+        break;
+
+    case TOK_JOURNAL_FILE:
+        SNPRINTF(val, val_len, "%s", rig_journal_get_path(rig));
+        break;
+
+    case TOK_JOURNAL_SIZE:
+        SNPRINTF(val, val_len, "%d", rig_journal_get_size(rig));
+        break;
+
+    case TOK_TIMEOUT_ADAPTIVE:
+        SNPRINTF(val, val_len, "%d", rs->timeout_adaptive);
+        break;
+
+    case TOK_TIMEOUT_FLOOR:
+        SNPRINTF(val, val_len, "%d", rs->timeout_floor);
+        break;
+
+    case TOK_CHAN_CACHE:
+        SNPRINTF(val, val_len, "%d", rs->chan_cache);
+        break;
+
+    case TOK_POLL_LEVELS:
+        rig_sprintf_level(val, val_len, rs->poll_levels);
+        break;
+
+    case TOK_MULTICAST_BATCH:
+        SNPRINTF(val, val_len, "%d", rs->multicast_batch_ms);
+        break;
+
+    case TOK_MULTICAST_KEYFRAME:
+        SNPRINTF(val, val_len, "%d", rs->multicast_keyframe);
+        break;
+
+    case TOK_SPECTRUM_HISTORY:
+        SNPRINTF(val, val_len, "%d", rs->spectrum_history_lines);
+        break;
+
     case TOK_AUTO_POWER_ON:
         SNPRINTF(val, val_len, "%d", rs->auto_power_on);
         break;
@@ -1064,6 +1724,10 @@ static int frontend_get_conf2(RIG *rig, token_t token, char *val, int val_len)
         SNPRINTF(val, val_len, "%d", rs->async_data_enabled);
         break;
 
+    case TOK_ASYNC_SHARED:
+        SNPRINTF(val, val_len, "%d", rs->async_shared);
+        break;
+
     default:
         return -RIG_EINVAL;
     }
@@ -1166,6 +1830,20 @@ const struct confparams *HAMLIB_API rig_confparam_lookup(RIG *rig,
     /* 0 returned for invalid format */
     token = strtol(name, NULL, 0);
 
+    if (rig->state.conf_index)
+    {
+        const struct conf_index *idx = rig->state.conf_index;
+
+        cfp = conf_index_name(idx, name);
+
+        if (!cfp && token != RIG_CONF_END)
+        {
+            cfp = conf_index_token(idx, token);
+        }
+
+        return cfp;
+    }
+
     for (cfp = rig->caps->cfgparams; cfp && cfp->name; cfp++)
     {
         if (!strcmp(cfp->name, name) || token == cfp->token)
@@ -1223,6 +1901,49 @@ token_t HAMLIB_API rig_token_lookup(RIG *rig, const char *name)
 }
 
 
+/* Hash the tables rig_confparam_lookup() and rig_ext_lookup() scan, in
+ * the order they scan them.  Without the index they scan as before. */
+void rig_conf_index_init(RIG *rig)
+{
+    struct rig_state *rs = &rig->state;
+    const struct confparams *conf[3];
+    const struct confparams *ext[3];
+    int n = 0;
+
+    conf[n++] = rig->caps->cfgparams;
+    conf[n++] = frontend_cfg_params;
+
+    if (rig->caps->port_type == RIG_PORT_SERIAL)
+    {
+        conf[n++] = frontend_serial_cfg_params;
+    }
+
+    rs->conf_index = conf_index_new(conf, n);
+
+    ext[0] = rig->caps->extlevels;
+    ext[1] = rig->caps->extfuncs;
+    ext[2] = rig->caps->extparms;
+    rs->ext_index = conf_index_new(ext, 3);
+
+    if (!rs->conf_index || !rs->ext_index)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: no memory, linear lookups\n", __func__);
+        rig_conf_index_cleanup(rig);
+    }
+}
+
+
+void rig_conf_index_cleanup(RIG *rig)
+{
+    struct rig_state *rs = &rig->state;
+
+    conf_index_free(rs->conf_index);
+    conf_index_free(rs->ext_index);
+    rs->conf_index = NULL;
+    rs->ext_index = NULL;
+}
+
+
 /**
  * \brief set a radio configuration parameter
  * \param rig   The rig handle
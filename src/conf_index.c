@@ -0,0 +1,146 @@
+/*
+ *  Hamlib Interface - configuration token index
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The conf and ext lookups used to strcmp their way through up to three
+ * tables on every call, which rigctld does for each \set_conf and each
+ * extended level by name.  The tables are fixed once the caps are known,
+ * so rig_init() and friends hash them once and the lookups become a probe
+ * or two.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "conf_index.h"
+
+struct conf_index
+{
+    unsigned int mask;                      /* slots - 1, slots a power of 2 */
+    const struct confparams **by_name;
+    const struct confparams **by_token;
+};
+
+static unsigned int hash_name(const char *name)
+{
+    unsigned int h = 2166136261u;   /* FNV-1a */
+
+    while (*name)
+    {
+        h ^= (unsigned char) * name++;
+        h *= 16777619u;
+    }
+
+    return h;
+}
+
+static unsigned int hash_token(token_t token)
+{
+    return (unsigned int) token * 2654435761u;
+}
+
+struct conf_index *conf_index_new(const struct confparams *const tables[],
+                                  int ntables)
+{
+    struct conf_index *idx;
+    const struct confparams *cfp;
+    unsigned int slots = 8;
+    int n = 0;
+    int t;
+
+    for (t = 0; t < ntables; t++)
+    {
+        for (cfp = tables[t]; cfp && cfp->name; cfp++) { n++; }
+    }
+
+    // at most half full so probes stay short
+    while (slots < 2 * (unsigned int) n) { slots <<= 1; }
+
+    idx = calloc(1, sizeof(*idx) + 2 * slots * sizeof(idx->by_name[0]));
+
+    if (!idx) { return NULL; }
+
+    idx->mask = slots - 1;
+    idx->by_name = (const struct confparams **)(idx + 1);
+    idx->by_token = idx->by_name + slots;
+
+    for (t = 0; t < ntables; t++)
+    {
+        for (cfp = tables[t]; cfp && cfp->name; cfp++)
+        {
+            unsigned int i;
+
+            for (i = hash_name(cfp->name) & idx->mask; idx->by_name[i];
+                    i = (i + 1) & idx->mask)
+            {
+                if (!strcmp(idx->by_name[i]->name, cfp->name)) { break; }
+            }
+
+            if (!idx->by_name[i]) { idx->by_name[i] = cfp; }
+
+            if (cfp->token == RIG_CONF_END) { continue; }
+
+            for (i = hash_token(cfp->token) & idx->mask; idx->by_token[i];
+                    i = (i + 1) & idx->mask)
+            {
+                if (idx->by_token[i]->token == cfp->token) { break; }
+            }
+
+            if (!idx->by_token[i]) { idx->by_token[i] = cfp; }
+        }
+    }
+
+    return idx;
+}
+
+void conf_index_free(struct conf_index *idx)
+{
+    free(idx);
+}
+
+const struct confparams *conf_index_name(const struct conf_index *idx,
+        const char *name)
+{
+    unsigned int i;
+
+    for (i = hash_name(name) & idx->mask; idx->by_name[i]; i = (i + 1) & idx->mask)
+    {
+        if (!strcmp(idx->by_name[i]->name, name)) { return idx->by_name[i]; }
+    }
+
+    return NULL;
+}
+
+const struct confparams *conf_index_token(const struct conf_index *idx,
+        token_t token)
+{
+    unsigned int i;
+
+    for (i = hash_token(token) & idx->mask; idx->by_token[i];
+            i = (i + 1) & idx->mask)
+    {
+        if (idx->by_token[i]->token == token) { return idx->by_token[i]; }
+    }
+
+    return NULL;
+}
@@ -0,0 +1,54 @@
+/*
+ *  Hamlib Interface - configuration token index
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _CONF_INDEX_H
+#define _CONF_INDEX_H 1
+
+#include <hamlib/rig.h>
+#include <hamlib/rotator.h>
+#include <hamlib/amplifier.h>
+
+/*
+ * Hash index by name and by token over a list of confparams tables, each
+ * ended by a NULL name.  Where a name or token is in several tables the
+ * first one wins, as with a linear scan of the tables in the same order.
+ */
+struct conf_index;
+
+struct conf_index *conf_index_new(const struct confparams *const tables[],
+                                  int ntables);
+void conf_index_free(struct conf_index *idx);
+
+const struct confparams *conf_index_name(const struct conf_index *idx,
+        const char *name);
+const struct confparams *conf_index_token(const struct conf_index *idx,
+        token_t token);
+
+/* Built at rig/rot/amp_init over the frontend and backend tables, one
+ * index for the conf params and one for the ext levels, funcs and parms */
+void rig_conf_index_init(RIG *rig);
+void rig_conf_index_cleanup(RIG *rig);
+void rot_conf_index_init(ROT *rot);
+void rot_conf_index_cleanup(ROT *rot);
+void amp_conf_index_init(AMP *amp);
+void amp_conf_index_cleanup(AMP *amp);
+
+#endif /* _CONF_INDEX_H */
@@ -0,0 +1,295 @@
+/*
+ *  Hamlib Interface - interrupt driven DCD
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * A thread sleeping on the DCD port until the carrier line changes, so
+ * rig_get_dcd() answers from memory and the dcd callback fires within the
+ * interrupt latency instead of whenever the application next polls.
+ *
+ * GPIO pins are armed with the sysfs "edge" file, after which the value
+ * file reports POLLPRI on every transition.  A gpiochip line queues edge
+ * events on its request fd instead, which then polls readable.  A CM108 has no way to query
+ * its Volume Down input on demand, but sends a HID input report each time
+ * one of its buttons changes: reading those is the only way to get DCD
+ * from it at all.
+ *
+ * Pins that cannot interrupt, and other DCD types, keep being polled.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#ifdef HAVE_POLL_H
+#include <poll.h>
+#endif
+
+#include "dcd_watch.h"
+#include "event.h"
+#include "gpio.h"
+#include "misc.h"
+
+#if defined(HAVE_PTHREAD) && defined(HAVE_POLL_H)
+
+/* byte 0 of the CM108 HID input report, squelch is wired to Volume Down */
+#define CM108_HID_VOLDN 0x02
+
+struct dcd_watch
+{
+    RIG *rig;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    int wake[2];        /* written to by dcd_watch_stop() */
+    dcd_t dcd;
+};
+
+
+static void dcd_watch_set(struct dcd_watch *w, dcd_t dcd)
+{
+    int changed;
+
+    pthread_mutex_lock(&w->lock);
+    changed = w->dcd != dcd;
+    w->dcd = dcd;
+    pthread_mutex_unlock(&w->lock);
+
+    if (changed)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: DCD %s\n", __func__,
+                  dcd == RIG_DCD_ON ? "on" : "off");
+        rig_fire_dcd_event(w->rig, RIG_VFO_CURR, dcd);
+    }
+}
+
+
+static void *dcd_watch_thread(void *arg)
+{
+    struct dcd_watch *w = (struct dcd_watch *) arg;
+    hamlib_port_t *port = &w->rig->state.dcdport;
+    int cm108 = port->type.dcd == RIG_DCD_CM108;
+    struct pollfd fds[2];
+
+    fds[0].fd = port->fd;
+    fds[0].events = cm108 || port->parm.gpio.lines ? POLLIN : POLLPRI | POLLERR;
+    fds[1].fd = w->wake[0];
+    fds[1].events = POLLIN;
+
+    for (;;)
+    {
+        dcd_t dcd;
+
+        if (poll(fds, 2, -1) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            rig_debug(RIG_DEBUG_ERR, "%s: poll: %s\n", __func__, strerror(errno));
+            break;
+        }
+
+        if (fds[1].revents)
+        {
+            break;
+        }
+
+        if (!fds[0].revents)
+        {
+            continue;
+        }
+
+        if (cm108)
+        {
+            unsigned char report[8];
+            ssize_t n = read(port->fd, report, sizeof(report));
+
+            if (n < 0 && errno == EINTR)
+            {
+                continue;
+            }
+
+            if (n <= 0)
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: CM108 read: %s\n", __func__,
+                          n < 0 ? strerror(errno) : "end of file");
+                break;
+            }
+
+            dcd = report[0] & CM108_HID_VOLDN ? RIG_DCD_ON : RIG_DCD_OFF;
+        }
+        else if (gpio_dcd_get(port, &dcd) != RIG_OK)  /* also acks the edge */
+        {
+            break;
+        }
+
+        dcd_watch_set(w, dcd);
+    }
+
+    /* dcd_watch_stop() closes up, rig_get_dcd() keeps the last state */
+    return NULL;
+}
+
+
+int dcd_watch_start(RIG *rig)
+{
+    struct rig_state *rs = &rig->state;
+    hamlib_port_t *port = &rs->dcdport;
+    struct dcd_watch *w;
+    dcd_t dcd = RIG_DCD_OFF;
+
+    switch (port->type.dcd)
+    {
+    case RIG_DCD_GPIO:
+    case RIG_DCD_GPION:
+        if (gpio_edge(port, "both") != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: GPIO%s cannot interrupt, polling DCD\n",
+                      __func__, port->pathname);
+            return -RIG_ENAVAIL;
+        }
+
+        /* clears the pending edge too */
+        if (gpio_dcd_get(port, &dcd) != RIG_OK)
+        {
+            return -RIG_EIO;
+        }
+
+        break;
+
+    case RIG_DCD_CM108:
+        /* closed squelch until the first report says otherwise */
+        break;
+
+    default:
+        return -RIG_ENAVAIL;
+    }
+
+    w = calloc(1, sizeof(*w));
+
+    if (!w)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    if (pipe(w->wake) < 0)
+    {
+        free(w);
+        return -RIG_EIO;
+    }
+
+    w->rig = rig;
+    w->dcd = dcd;
+    pthread_mutex_init(&w->lock, NULL);
+
+    if (pthread_create(&w->thread, NULL, dcd_watch_thread, w))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        close(w->wake[0]);
+        close(w->wake[1]);
+        pthread_mutex_destroy(&w->lock);
+        free(w);
+        return -RIG_EINTERNAL;
+    }
+
+    rs->dcd_watch = w;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: watching DCD on %s\n", __func__,
+              port->pathname);
+
+    return RIG_OK;
+}
+
+
+int dcd_watch_get(RIG *rig, dcd_t *dcd)
+{
+    struct dcd_watch *w = (struct dcd_watch *) rig->state.dcd_watch;
+
+    if (!w)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    pthread_mutex_lock(&w->lock);
+    *dcd = w->dcd;
+    pthread_mutex_unlock(&w->lock);
+
+    return RIG_OK;
+}
+
+
+void dcd_watch_stop(RIG *rig)
+{
+    struct dcd_watch *w = (struct dcd_watch *) rig->state.dcd_watch;
+
+    if (!w)
+    {
+        return;
+    }
+
+    if (write(w->wake[1], "", 1) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: wake: %s\n", __func__, strerror(errno));
+    }
+
+    pthread_join(w->thread, NULL);
+
+    close(w->wake[0]);
+    close(w->wake[1]);
+    pthread_mutex_destroy(&w->lock);
+    free(w);
+
+    rig->state.dcd_watch = NULL;
+
+    if (rig->state.dcdport.type.dcd == RIG_DCD_GPIO
+            || rig->state.dcdport.type.dcd == RIG_DCD_GPION)
+    {
+        gpio_edge(&rig->state.dcdport, "none");
+    }
+}
+
+#else
+
+int dcd_watch_start(RIG *rig)
+{
+    return -RIG_ENAVAIL;
+}
+
+
+int dcd_watch_get(RIG *rig, dcd_t *dcd)
+{
+    return -RIG_ENAVAIL;
+}
+
+
+void dcd_watch_stop(RIG *rig)
+{
+}
+
+#endif
@@ -0,0 +1,35 @@
+/*
+ *  Hamlib Interface - interrupt driven DCD
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _DCD_WATCH_H
+#define _DCD_WATCH_H 1
+
+#include <hamlib/rig.h>
+
+/* Watch the opened DCD port for changes, -RIG_ENAVAIL leaves it polled */
+int dcd_watch_start(RIG *rig);
+
+/* Last DCD state seen by the watcher, -RIG_ENAVAIL if there is none */
+int dcd_watch_get(RIG *rig, dcd_t *dcd);
+
+void dcd_watch_stop(RIG *rig);
+
+#endif /* _DCD_WATCH_H */
@@ -0,0 +1,121 @@
+/*
+ *  Hamlib Interface - per-thread call deadlines
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * A deadline belongs to the thread that set it and covers every API call
+ * that thread makes until it is cleared.  read_string() and read_block()
+ * wait no longer than what is left of it, the retry loops of the Icom,
+ * Kenwood and newcat backends stop once it has passed, and rig_get_freq(),
+ * rig_get_mode() and rig_get_ptt() then answer from the cache however old,
+ * flagging it for rig_deadline_stale().
+ */
+
+#include <hamlib/config.h>
+
+#include <time.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+
+#ifdef __GNUC__
+#define DEADLINE_TLS __thread
+#else
+#define DEADLINE_TLS
+#endif
+
+/* tv_sec 0 is no deadline */
+static DEADLINE_TLS struct timespec deadline;
+static DEADLINE_TLS int deadline_stale;
+
+/**
+ * \brief Give the API calls of the calling thread a deadline
+ * \param ms milliseconds from now, 0 or less clears it
+ *
+ * Also clears the flag rig_deadline_stale() reports.
+ */
+void HAMLIB_API rig_set_deadline(int ms)
+{
+    deadline_stale = 0;
+
+    if (ms <= 0)
+    {
+        deadline.tv_sec = 0;
+        deadline.tv_nsec = 0;
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += ms / 1000;
+    deadline.tv_nsec += (long)(ms % 1000) * 1000000;
+
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+}
+
+/**
+ * \brief Milliseconds left of the calling thread's deadline
+ * \return -1 without a deadline, 0 once it has passed
+ */
+int HAMLIB_API rig_get_deadline(void)
+{
+    struct timespec now;
+    long ms;
+
+    if (deadline.tv_sec == 0)
+    {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    // rounded up, 0 only when it really has passed
+    ms = (deadline.tv_sec - now.tv_sec) * 1000
+         + (deadline.tv_nsec - now.tv_nsec + 999999) / 1000000;
+
+    return ms > 0 ? (int) ms : 0;
+}
+
+/**
+ * \brief Whether a call since rig_set_deadline() answered from the cache
+ * because the deadline had passed
+ */
+int HAMLIB_API rig_deadline_stale(void)
+{
+    return deadline_stale;
+}
+
+//! @cond Doxygen_Suppress
+/* The deadline has passed: the getter answers from the cache and says so */
+int rig_deadline_cache(void)
+{
+    if (rig_get_deadline() != 0)
+    {
+        return 0;
+    }
+
+    deadline_stale = 1;
+
+    return 1;
+}
+//! @endcond
@@ -42,6 +42,11 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <time.h>
+#include <sys/time.h>
+
+#ifdef HAVE_PTHREAD
+#  include <pthread.h>
+#endif
 
 #ifdef ANDROID
 #  include <android/log.h>
@@ -72,6 +77,162 @@ static rig_ptr_t rig_vprintf_arg;
 
 extern HAMLIB_EXPORT(void) dump_hex(const unsigned char ptr[], size_t size);
 
+#if defined(HAVE_PTHREAD) && defined(__GNUC__)
+/*
+ * Asynchronous debug output -- see rig_set_debug_async().
+ *
+ * Callers format their message into a slot of a bounded lock-free ring
+ * and return; a background thread adds the time stamp and writes the
+ * slots out, flushing the stream only when the ring runs dry.  Each slot
+ * carries a sequence number so several producers can fill slots at once
+ * while the single consumer drains them in order.
+ */
+#define DEBUG_ASYNC 1
+#define DEBUG_RING_SLOTS  4096  /* must be a power of two */
+#define DEBUG_RING_MSGLEN 512
+
+struct debug_slot
+{
+    unsigned int seq;
+    int stamp;
+    struct timeval tv;
+    char msg[DEBUG_RING_MSGLEN];
+};
+
+static struct debug_slot *debug_ring;
+static unsigned int debug_head;     /* next slot to fill */
+static unsigned int debug_tail;     /* next slot to drain, consumer only */
+static unsigned int debug_dropped;  /* messages lost to a full ring */
+static int debug_async_enabled;
+static int debug_async_run;
+static pthread_t debug_async_tid;
+static pthread_mutex_t debug_async_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static void debug_async_put(const char *fmt, va_list ap)
+{
+    unsigned int pos = __atomic_load_n(&debug_head, __ATOMIC_RELAXED);
+    struct debug_slot *slot;
+    int len;
+
+    for (;;)
+    {
+        unsigned int seq;
+        int diff;
+
+        slot = &debug_ring[pos & (DEBUG_RING_SLOTS - 1)];
+        seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        diff = (int)(seq - pos);
+
+        if (diff == 0)
+        {
+            if (__atomic_compare_exchange_n(&debug_head, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if (diff < 0)
+        {
+            // ring is full, better to lose a line than to stall the caller
+            __atomic_fetch_add(&debug_dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        else
+        {
+            pos = __atomic_load_n(&debug_head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->stamp = rig_debug_time_stamp;
+
+    if (slot->stamp) { gettimeofday(&slot->tv, NULL); }
+
+    len = vsnprintf(slot->msg, sizeof(slot->msg), fmt, ap);
+
+    if (len >= (int)sizeof(slot->msg))
+    {
+        strcpy(&slot->msg[sizeof(slot->msg) - 5], "...\n");
+    }
+
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+static int debug_async_drain(void)
+{
+    int count = 0;
+    unsigned int dropped;
+
+    for (;;)
+    {
+        struct debug_slot *slot = &debug_ring[debug_tail & (DEBUG_RING_SLOTS - 1)];
+
+        if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != debug_tail + 1)
+        {
+            break;
+        }
+
+        if (slot->stamp)
+        {
+            char buf[256];
+            fprintf(rig_debug_stream, "%s: ", date_strget_tv(buf, sizeof(buf), 1,
+                    &slot->tv));
+        }
+
+        fputs(slot->msg, rig_debug_stream);
+
+        __atomic_store_n(&slot->seq, debug_tail + DEBUG_RING_SLOTS,
+                         __ATOMIC_RELEASE);
+        debug_tail++;
+        count++;
+    }
+
+    dropped = __atomic_exchange_n(&debug_dropped, 0, __ATOMIC_RELAXED);
+
+    if (dropped)
+    {
+        fprintf(rig_debug_stream, "rig_debug: %u messages dropped\n", dropped);
+        count++;
+    }
+
+    if (count) { fflush(rig_debug_stream); }
+
+    return count;
+}
+
+static void *debug_async_thread(void *arg)
+{
+    (void)arg;
+
+    while (__atomic_load_n(&debug_async_run, __ATOMIC_ACQUIRE))
+    {
+        if (debug_async_drain() == 0)
+        {
+            hl_usleep(2 * 1000);
+        }
+    }
+
+    debug_async_drain();
+
+    return NULL;
+}
+
+static void debug_async_stop(void)
+{
+    pthread_mutex_lock(&debug_async_mutex);
+
+    if (debug_async_enabled)
+    {
+        __atomic_store_n(&debug_async_enabled, 0, __ATOMIC_RELEASE);
+        __atomic_store_n(&debug_async_run, 0, __ATOMIC_RELEASE);
+        pthread_join(debug_async_tid, NULL);
+        // anything queued while the thread was exiting
+        debug_async_drain();
+    }
+
+    pthread_mutex_unlock(&debug_async_mutex);
+}
+#endif
+
 /**
  * \brief Do a hex dump of the unsigned char array.
  *
@@ -94,7 +255,7 @@ void dump_hex(const unsigned char ptr[], size_t size)
     char line[4 + 4 + 3 * DUMP_HEX_WIDTH + 4 + DUMP_HEX_WIDTH + 1];
     int i;
 
-    if (!rig_need_debug(RIG_DEBUG_TRACE))
+    if (RIG_DEBUG_TRACE > HAMLIB_DEBUG_LEVEL_MAX || !rig_need_debug(RIG_DEBUG_TRACE))
     {
         return;
     }
@@ -167,7 +328,8 @@ void HAMLIB_API rig_set_debug(enum rig_debug_level_e debug_level)
  */
 int HAMLIB_API rig_need_debug(enum rig_debug_level_e debug_level)
 {
-    return (debug_level <= rig_debug_level);
+    return (debug_level <= HAMLIB_DEBUG_LEVEL_MAX
+            && debug_level <= rig_debug_level);
 }
 
 
@@ -184,6 +346,88 @@ void HAMLIB_API rig_set_debug_time_stamp(int flag)
     rig_debug_time_stamp = flag;
 }
 
+
+/**
+ * \brief Enable or disable asynchronous debugging output.
+ *
+ * \param flag `TRUE` or `FALSE`.
+ *
+ * When enabled, rig_debug() only formats the message into a ring buffer
+ * and a background thread time stamps and writes it to the debug stream,
+ * so high debug levels cost the caller little more than a vsnprintf().
+ * Messages are dropped, and the loss reported, if the ring fills up.
+ * Output through a callback set with rig_set_debug_callback() is always
+ * synchronous.  Pending output is flushed on disable and at exit.
+ *
+ * \return RIG_OK, or -RIG_ENIMPL when Hamlib was built without threads.
+ */
+int HAMLIB_API rig_set_debug_async(int flag)
+{
+#ifdef DEBUG_ASYNC
+    static int atexit_done;
+    int i;
+
+    if (!flag)
+    {
+        debug_async_stop();
+        return RIG_OK;
+    }
+
+    pthread_mutex_lock(&debug_async_mutex);
+
+    if (debug_async_enabled)
+    {
+        pthread_mutex_unlock(&debug_async_mutex);
+        return RIG_OK;
+    }
+
+    if (!debug_ring)
+    {
+        // never freed, a late caller may still be writing into a slot
+        debug_ring = calloc(DEBUG_RING_SLOTS, sizeof(*debug_ring));
+
+        if (!debug_ring)
+        {
+            pthread_mutex_unlock(&debug_async_mutex);
+            return -RIG_ENOMEM;
+        }
+
+        for (i = 0; i < DEBUG_RING_SLOTS; i++)
+        {
+            debug_ring[i].seq = i;
+        }
+    }
+
+    if (!rig_debug_stream)
+    {
+        rig_debug_stream = stderr;
+    }
+
+    debug_async_run = 1;
+
+    if (pthread_create(&debug_async_tid, NULL, debug_async_thread, NULL))
+    {
+        debug_async_run = 0;
+        pthread_mutex_unlock(&debug_async_mutex);
+        return -RIG_EINTERNAL;
+    }
+
+    if (!atexit_done)
+    {
+        atexit(debug_async_stop);
+        atexit_done = 1;
+    }
+
+    __atomic_store_n(&debug_async_enabled, 1, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&debug_async_mutex);
+
+    return RIG_OK;
+#else
+    return flag ? -RIG_ENIMPL : RIG_OK;
+#endif
+}
+
 //! @endcond
 
 
@@ -216,19 +460,29 @@ void HAMLIB_API rig_debug(enum rig_debug_level_e debug_level,
     }
     else
     {
-        if (!rig_debug_stream)
+#ifdef DEBUG_ASYNC
+
+        if (__atomic_load_n(&debug_async_enabled, __ATOMIC_ACQUIRE))
         {
-            rig_debug_stream = stderr;
+            debug_async_put(fmt, ap);
         }
-
-        if (rig_debug_time_stamp)
+        else
+#endif
         {
-            char buf[256];
-            fprintf(rig_debug_stream, "%s: ", date_strget(buf, sizeof(buf), 1));
+            if (!rig_debug_stream)
+            {
+                rig_debug_stream = stderr;
+            }
+
+            if (rig_debug_time_stamp)
+            {
+                char buf[256];
+                fprintf(rig_debug_stream, "%s: ", date_strget(buf, sizeof(buf), 1));
+            }
+
+            vfprintf(rig_debug_stream, fmt, ap);
+            fflush(rig_debug_stream);
         }
-
-        vfprintf(rig_debug_stream, fmt, ap);
-        fflush(rig_debug_stream);
     }
 
     va_end(ap);
@@ -0,0 +1,612 @@
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file src/doppler.c
+ * \brief Doppler correction of satellite uplink and downlink
+ */
+
+/*
+ *  Hamlib Interface - satellite Doppler correction
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Satellite programs used to push a corrected rig_set_freq() for each VFO
+ * several times a second, most of them moving the VFO by less than it can
+ * tune.  With rig_set_doppler() they hand over the nominal frequencies and
+ * the range rate instead, as samples or as a callback, and a thread of the
+ * rig's own does the rest:
+ *
+ *  - every period it works out the range rate due when the command
+ *    reaches the rig, interpolating between samples and extrapolating a
+ *    few seconds past the last one
+ *  - the downlink is received at f * (1 - v/c), the uplink is sent at
+ *    f * (1 + v/c) so the satellite hears it on its nominal frequency
+ *  - each side is rounded to the VFO's tuning step and sent only when
+ *    that changes, straight to its VFO: Main and Sub on satellite rigs,
+ *    else the current VFO and the split TX VFO.  Rigs that can target a
+ *    VFO (Icom 0x25, Kenwood FA/FB, ...) do so without any VFO swap.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "doppler.h"
+
+#define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+#define DOPPLER_C 299792458.0           /* m/s */
+#define DOPPLER_PERIOD_MS 200
+/* a rate sample is extrapolated at most this long */
+#define DOPPLER_EXTRAPOLATE_S 5.0
+
+#ifdef HAVE_PTHREAD
+
+struct doppler_side
+{
+    freq_t nominal;             /* 0 when the side is not corrected */
+    vfo_t vfo;
+    int split;                  /* sent with rig_set_split_freq() */
+    int sign;                   /* -1 for the downlink, +1 for the uplink */
+    /* thread only */
+    shortfreq_t step;
+    freq_t sent;                /* 0 until the first one */
+};
+
+struct doppler
+{
+    RIG *rig;
+    pthread_t thread;
+    pthread_mutex_t lock;       /* guards everything but the thread only fields */
+    pthread_cond_t cond;
+    struct doppler_side side[2];
+    int period_ms;
+    shortfreq_t min_step;
+    rig_doppler_cb_t cb;
+    rig_ptr_t arg;
+    struct rig_doppler_sample *pts;
+    int n;
+    int size;
+    int changed;                /* configuration replaced, steps to look up */
+    int stop;
+    /* thread only */
+    double latency_ms;          /* average rig_set_freq() time */
+};
+
+/* serializes rig_set_doppler(), rig_add_doppler() and stops */
+static pthread_mutex_t doppler_handle_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static double doppler_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* wait with d->lock held, returns non-zero when asked to stop */
+static int doppler_wait_until(struct doppler *d, double when)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)when;
+    ts.tv_nsec = (long)((when - (double)ts.tv_sec) * 1e9);
+
+    while (!d->stop && doppler_now() < when)
+    {
+        if (pthread_cond_timedwait(&d->cond, &d->lock, &ts) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+
+    return d->stop;
+}
+
+
+/* range rate at time when from the samples, with d->lock held */
+static int doppler_interp(const struct doppler *d, double when, double *rate)
+{
+    const struct rig_doppler_sample *a, *b;
+    int i;
+
+    if (d->n == 0)
+    {
+        return 0;
+    }
+
+    if (d->n == 1 || when <= d->pts[0].time)
+    {
+        *rate = d->pts[0].range_rate;
+        return 1;
+    }
+
+    for (i = 1; i < d->n - 1 && d->pts[i].time <= when; i++)
+        ;
+
+    a = &d->pts[i - 1];
+    b = &d->pts[i];
+
+    /* past the last sample the last segment goes on for a while */
+    if (when > b->time + DOPPLER_EXTRAPOLATE_S)
+    {
+        when = b->time + DOPPLER_EXTRAPOLATE_S;
+    }
+
+    *rate = a->range_rate + (when - a->time) * (b->range_rate - a->range_rate)
+            / (b->time - a->time);
+
+    return 1;
+}
+
+
+/* tuning step of a side's VFO in the mode the cache has for it */
+static shortfreq_t doppler_step(RIG *rig, const struct doppler_side *s)
+{
+    freq_t freq;
+    rmode_t mode = RIG_MODE_NONE;
+    pbwidth_t width;
+    int ms_freq, ms_mode, ms_width;
+    shortfreq_t step;
+
+    rig_get_cache(rig, s->split ? RIG_VFO_TX : s->vfo, &freq, &ms_freq, &mode,
+                  &ms_mode, &width, &ms_width);
+
+    step = rig_get_resolution(rig, mode != RIG_MODE_NONE ? mode : RIG_MODE_USB);
+
+    return step > 0 ? step : 1;
+}
+
+
+static void doppler_send(struct doppler *d, struct doppler_side *s, double rate)
+{
+    struct timespec start;
+    freq_t freq = s->nominal * (1 + s->sign * rate / DOPPLER_C);
+    double ms;
+    int retval;
+
+    freq = s->step * floor(freq / s->step + 0.5);
+
+    if (freq == s->sent)
+    {
+        return;
+    }
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+    if (s->split)
+    {
+        retval = rig_set_split_freq(d->rig, RIG_VFO_CURR, freq);
+    }
+    else
+    {
+        retval = rig_set_freq(d->rig, s->vfo, freq);
+    }
+
+    ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+    d->latency_ms = d->latency_ms > 0 ? (3 * d->latency_ms + ms) / 4 : ms;
+
+    if (retval != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: %s %.0f: %s\n", __func__,
+                  s->split ? "split" : rig_strvfo(s->vfo), freq, rigerror(retval));
+        return;
+    }
+
+    s->sent = freq;
+}
+
+
+static void *doppler_thread(void *arg)
+{
+    struct doppler *d = arg;
+    struct doppler_side side[2];
+    double now = doppler_now();
+    int i;
+
+    pthread_mutex_lock(&d->lock);
+
+    for (;;)
+    {
+        double when, rate = 0;
+        rig_doppler_cb_t cb;
+        rig_ptr_t cb_arg;
+        shortfreq_t min_step;
+        int period_ms, have_rate;
+
+        if (d->changed)
+        {
+            /* a new configuration starts from scratch on each side */
+            memcpy(side, d->side, sizeof(side));
+            d->changed = 0;
+            min_step = d->min_step;
+            pthread_mutex_unlock(&d->lock);
+
+            for (i = 0; i < 2; i++)
+            {
+                side[i].step = min_step > 0 ? min_step : doppler_step(d->rig, &side[i]);
+            }
+
+            pthread_mutex_lock(&d->lock);
+        }
+
+        when = doppler_now() + d->latency_ms / 1000;
+        cb = d->cb;
+        cb_arg = d->arg;
+        period_ms = d->period_ms;
+        have_rate = cb ? 1 : doppler_interp(d, when, &rate);
+        pthread_mutex_unlock(&d->lock);
+
+        if (cb)
+        {
+            rate = cb(d->rig, when, cb_arg);
+        }
+
+        if (have_rate)
+        {
+            for (i = 0; i < 2; i++)
+            {
+                if (side[i].nominal > 0)
+                {
+                    doppler_send(d, &side[i], rate);
+                }
+            }
+        }
+
+        pthread_mutex_lock(&d->lock);
+
+        now += period_ms / 1000.0;
+
+        /* fell behind, do not burst to catch up */
+        if (now < doppler_now())
+        {
+            now = doppler_now();
+        }
+
+        if (d->changed)
+        {
+            continue;
+        }
+
+        if (doppler_wait_until(d, now))
+        {
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&d->lock);
+
+    return NULL;
+}
+
+
+static void doppler_free(struct doppler *d)
+{
+    pthread_cond_destroy(&d->cond);
+    pthread_mutex_destroy(&d->lock);
+    free(d->pts);
+    free(d);
+}
+
+
+/* with doppler_handle_lock held */
+static void doppler_stop_locked(RIG *rig)
+{
+    struct doppler *d = rig->state.doppler;
+
+    if (!d)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&d->lock);
+    d->stop = 1;
+    pthread_cond_signal(&d->cond);
+    pthread_mutex_unlock(&d->lock);
+
+    pthread_join(d->thread, NULL);
+    rig->state.doppler = NULL;
+    doppler_free(d);
+}
+
+
+void doppler_stop(RIG *rig)
+{
+    pthread_mutex_lock(&doppler_handle_lock);
+    doppler_stop_locked(rig);
+    pthread_mutex_unlock(&doppler_handle_lock);
+}
+
+
+/* fill the sides of d from conf, with d->lock held if the thread runs */
+static void doppler_configure(RIG *rig, struct doppler *d,
+                              const struct rig_doppler *conf)
+{
+    int satrig = (rig->state.vfo_list & RIG_VFO_SUB) != 0;
+    struct doppler_side *down = &d->side[0];
+    struct doppler_side *up = &d->side[1];
+
+    memset(d->side, 0, sizeof(d->side));
+
+    down->nominal = conf->downlink;
+    down->vfo = conf->downlink_vfo != RIG_VFO_NONE ? conf->downlink_vfo :
+                satrig ? RIG_VFO_MAIN : RIG_VFO_CURR;
+    down->sign = -1;
+
+    up->nominal = conf->uplink;
+    up->vfo = conf->uplink_vfo != RIG_VFO_NONE ? conf->uplink_vfo :
+              satrig ? RIG_VFO_SUB : RIG_VFO_TX;
+    up->split = up->vfo == RIG_VFO_TX;
+    up->sign = 1;
+
+    d->period_ms = conf->period_ms > 0 ? conf->period_ms : DOPPLER_PERIOD_MS;
+    d->min_step = conf->min_step;
+    d->cb = conf->range_rate_cb;
+    d->arg = conf->arg;
+    d->changed = 1;
+
+    rig_debug(RIG_DEBUG_VERBOSE,
+              "%s: downlink %.0f on %s, uplink %.0f on %s, every %d ms\n", __func__,
+              down->nominal, rig_strvfo(down->vfo), up->nominal,
+              up->split ? "split" : rig_strvfo(up->vfo), d->period_ms);
+}
+
+
+/**
+ * \brief Correct the uplink and downlink frequencies for Doppler shift.
+ *
+ * \param rig The rig handle, opened.
+ * \param conf The nominal frequencies and how to correct them, NULL to
+ * stop correcting.
+ *
+ * A background thread tunes the downlink VFO to \a conf->downlink shifted
+ * by the range rate, and the uplink VFO to \a conf->uplink shifted the
+ * other way, every \a conf->period_ms.  The range rate comes from
+ * \a conf->range_rate_cb, or else from the samples handed over with
+ * rig_add_doppler(); nothing is sent until there is one.  A VFO is only
+ * sent a new frequency when the corrected one moves by its tuning step
+ * (or \a conf->min_step), so the bus sees a fraction of the traffic a
+ * correction per VFO per period would make.
+ *
+ * Without VFOs given, satellite rigs with Main and Sub receive on Main
+ * and send on Sub (as with rig_set_uplink() 1); other rigs receive on the
+ * current VFO and send with rig_set_split_freq(), which needs split on.
+ * The rig is never asked to swap VFOs when its backend can set a VFO's
+ * frequency directly.
+ *
+ * Calling this again while correcting replaces the configuration, for
+ * instance when the user tunes across a transponder, and keeps the
+ * samples.  rig_close() stops correcting.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_add_doppler()
+ */
+int HAMLIB_API rig_set_doppler(RIG *rig, const struct rig_doppler *conf)
+{
+    struct doppler *d;
+    int retval;
+
+    ENTERFUNC;
+
+    if (CHECK_RIG_ARG(rig))
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    if (!conf)
+    {
+        doppler_stop(rig);
+        RETURNFUNC(RIG_OK);
+    }
+
+    if (conf->downlink < 0 || conf->uplink < 0
+            || (conf->downlink == 0 && conf->uplink == 0)
+            || conf->period_ms < 0 || conf->min_step < 0)
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    if (!rig->caps->set_freq)
+    {
+        RETURNFUNC(-RIG_ENAVAIL);
+    }
+
+    pthread_mutex_lock(&doppler_handle_lock);
+
+    d = rig->state.doppler;
+
+    if (d)
+    {
+        pthread_mutex_lock(&d->lock);
+        doppler_configure(rig, d, conf);
+        pthread_cond_signal(&d->cond);
+        pthread_mutex_unlock(&d->lock);
+        pthread_mutex_unlock(&doppler_handle_lock);
+        RETURNFUNC(RIG_OK);
+    }
+
+    d = calloc(1, sizeof(*d));
+
+    if (!d)
+    {
+        pthread_mutex_unlock(&doppler_handle_lock);
+        RETURNFUNC(-RIG_ENOMEM);
+    }
+
+    d->rig = rig;
+    doppler_configure(rig, d, conf);
+    pthread_mutex_init(&d->lock, NULL);
+    pthread_cond_init(&d->cond, NULL);
+
+    retval = pthread_create(&d->thread, NULL, doppler_thread, d);
+
+    if (retval != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create error: %s\n", __func__,
+                  strerror(retval));
+        doppler_free(d);
+        pthread_mutex_unlock(&doppler_handle_lock);
+        RETURNFUNC(-RIG_EINTERNAL);
+    }
+
+    rig->state.doppler = d;
+    pthread_mutex_unlock(&doppler_handle_lock);
+
+    RETURNFUNC(RIG_OK);
+}
+
+
+/**
+ * \brief Hand range rate samples to the Doppler correction.
+ *
+ * \param rig The rig handle, correcting with rig_set_doppler().
+ * \param samples The samples, in increasing time order and after the last
+ * one already given.
+ * \param n The number of samples.
+ *
+ * Between samples the range rate is interpolated, past the last one the
+ * last two are extrapolated for a few seconds and then held.  A single
+ * sample holds its range rate.  Samples no longer needed are dropped.
+ *
+ * \return RIG_OK if the samples were added, otherwise a **negative value**
+ * if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_EINVAL \a rig is not correcting, or the samples are out of
+ * order.
+ *
+ * \sa rig_set_doppler()
+ */
+int HAMLIB_API rig_add_doppler(RIG *rig,
+                               const struct rig_doppler_sample *samples, int n)
+{
+    struct doppler *d;
+    double now = doppler_now();
+    double after;
+    int i, keep;
+
+    ENTERFUNC;
+
+    if (CHECK_RIG_ARG(rig) || n < 0 || (n > 0 && !samples))
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    pthread_mutex_lock(&doppler_handle_lock);
+
+    d = rig->state.doppler;
+
+    if (!d)
+    {
+        pthread_mutex_unlock(&doppler_handle_lock);
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    pthread_mutex_lock(&d->lock);
+
+    after = d->n ? d->pts[d->n - 1].time : -HUGE_VAL;
+
+    for (i = 0; i < n; i++)
+    {
+        if (samples[i].time <= after)
+        {
+            pthread_mutex_unlock(&d->lock);
+            pthread_mutex_unlock(&doppler_handle_lock);
+            RETURNFUNC(-RIG_EINVAL);
+        }
+
+        after = samples[i].time;
+    }
+
+    /* of what is in the past, only the last two are still needed */
+    for (keep = 0; keep + 2 < d->n && d->pts[keep + 2].time <= now; keep++)
+        ;
+
+    if (keep > 0)
+    {
+        memmove(d->pts, d->pts + keep, (d->n - keep) * sizeof(*d->pts));
+        d->n -= keep;
+    }
+
+    if (d->n + n > d->size)
+    {
+        int size = d->n + n + 16;
+        struct rig_doppler_sample *pts = realloc(d->pts, size * sizeof(*pts));
+
+        if (!pts)
+        {
+            pthread_mutex_unlock(&d->lock);
+            pthread_mutex_unlock(&doppler_handle_lock);
+            RETURNFUNC(-RIG_ENOMEM);
+        }
+
+        d->pts = pts;
+        d->size = size;
+    }
+
+    memcpy(d->pts + d->n, samples, n * sizeof(*samples));
+    d->n += n;
+    pthread_cond_signal(&d->cond);
+    pthread_mutex_unlock(&d->lock);
+    pthread_mutex_unlock(&doppler_handle_lock);
+
+    RETURNFUNC(RIG_OK);
+}
+
+#else
+
+void doppler_stop(RIG *rig)
+{
+}
+
+
+int HAMLIB_API rig_set_doppler(RIG *rig, const struct rig_doppler *conf)
+{
+    return -RIG_ENIMPL;
+}
+
+
+int HAMLIB_API rig_add_doppler(RIG *rig,
+                               const struct rig_doppler_sample *samples, int n)
+{
+    return -RIG_ENIMPL;
+}
+
+#endif
+
+/** @} */
@@ -0,0 +1,30 @@
+/*
+ *  Hamlib Interface - satellite Doppler correction
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _DOPPLER_H
+#define _DOPPLER_H 1
+
+#include <hamlib/rig.h>
+
+/* Stop correcting, if rig_set_doppler() started it, and wait for the thread */
+void doppler_stop(RIG *rig);
+
+#endif /* _DOPPLER_H */
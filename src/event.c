@@ -39,6 +39,7 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <errno.h>
+#include <time.h>
 
 #ifdef HAVE_PTHREAD
 #  include <pthread.h>
@@ -49,6 +50,10 @@
 #include "misc.h"
 #include "cache.h"
 #include "network.h"
+#include "spectrum_proc.h"
+#include "spectrum_history.h"
+#include "journal.h"
+#include "thread_sched.h"
 
 #define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
 
@@ -66,170 +71,350 @@ typedef struct rig_poll_routine_priv_data_s
 
 // TODO: Where to start/stop rig poll routine?
 
-void *rig_poll_routine(void *arg)
+/*
+ * The poll routine runs in ticks of poll_interval ms and reads each field
+ * every rig_poll_every[] ticks: PTT and the frequency of the current VFO
+ * on every tick, split only now and then, the levels listed in the
+ * poll_levels conf only when there are any.  Freq, mode and PTT are left
+ * alone while the rig pushes its own changes (see rig_cache_push()), and
+ * every RIG_POLL_IDLE_TICKS ticks without a change or any cache activity
+ * from other threads the rates of everything but PTT halve, down to
+ * 1/RIG_POLL_STRIDE_MAX.  The first change, PTT on or a cache write by
+ * someone else restores them.
+ */
+enum rig_poll_field_e
 {
-    rig_poll_routine_args *args = (rig_poll_routine_args *)arg;
-    RIG *rig = args->rig;
-    struct rig_state *rs = &rig->state;
+    RIG_POLL_PTT,
+    RIG_POLL_VFO,
+    RIG_POLL_FREQ_CURR,
+    RIG_POLL_FREQ_OTHER,
+    RIG_POLL_MODE_CURR,
+    RIG_POLL_MODE_OTHER,
+    RIG_POLL_SPLIT,
+    RIG_POLL_LEVELS,
+    RIG_POLL_FIELDS
+};
+
+static const int rig_poll_every[RIG_POLL_FIELDS] = { 1, 2, 1, 2, 2, 4, 8, 2 };
+
+#define RIG_POLL_IDLE_TICKS 10
+#define RIG_POLL_STRIDE_MAX 8
+
+/* what the last poll of each field found, index 0 VFO A, 1 VFO B */
+struct rig_poll_last
+{
+    vfo_t vfo;
+    freq_t freq[2];
+    rmode_t mode[2];
+    pbwidth_t width[2];
+    ptt_t ptt;
+    split_t split;
+    value_t level[RIG_SETTING_MAX];
+    setting_t levels_read;
+};
+
+static const vfo_t rig_poll_vfos[2] = { RIG_VFO_A, RIG_VFO_B };
+
+static int rig_poll_vfo(RIG *rig, struct rig_poll_last *last)
+{
+    vfo_t vfo = RIG_VFO_NONE;
     int result;
-    int update_occurred;
 
-    vfo_t vfo = RIG_VFO_NONE, vfo_prev = RIG_VFO_NONE;
-    freq_t freq_main = 0, freq_sub = 0, freq_main_prev = 0, freq_sub_prev = 0;
-    rmode_t mode_main = RIG_MODE_NONE, mode_sub = RIG_MODE_NONE,
-            mode_main_prev = RIG_MODE_NONE, mode_sub_prev = RIG_MODE_NONE;
-    pbwidth_t width_main = 0, width_sub = 0, width_main_prev = 0,
-              width_sub_prev = 0;
-    split_t split, split_prev = -1;
+    result = rig_get_vfo(rig, &vfo);
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Starting rig poll routine thread\n",
-              __FILE__, __LINE__);
+    if (result != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s(%d): rig_get_vfo error %s\n", __FILE__, __LINE__,
+                  rigerror(result));
+        return 0;
+    }
 
-    // Rig cache time should be equal to rig poll interval (should be set automatically by rigctld at least)
-    rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_ALL, rs->poll_interval);
+    if (vfo == last->vfo)
+    {
+        return 0;
+    }
+
+    rig_debug(RIG_DEBUG_CACHE, "%s(%d) vfo=%s was %s\n", __FILE__, __LINE__,
+              rig_strvfo(vfo), rig_strvfo(last->vfo));
+    rig_fire_vfo_event(rig, vfo);
+    last->vfo = vfo;
+
+    return 1;
+}
+
+static int rig_poll_freq(RIG *rig, struct rig_poll_last *last, int i)
+{
+    freq_t freq = 0;
+    int result;
 
-    update_occurred = 0;
+    result = rig_get_freq(rig, rig_poll_vfos[i], &freq);
 
-    while (rs->poll_routine_thread_run)
+    if (result != RIG_OK)
     {
-        if (rig->caps->get_vfo)
-        {
-            result = rig_get_vfo(rig, &vfo);
+        rig_debug(RIG_DEBUG_ERR, "%s(%d): rig_get_freq %s error %s\n", __FILE__,
+                  __LINE__, rig_strvfo(rig_poll_vfos[i]), rigerror(result));
+        return 0;
+    }
 
-            if (result != RIG_OK)
-            {
-                rig_debug(RIG_DEBUG_ERR, "%s(%d): rig_get_vfo error %s\n", __FILE__, __LINE__,
-                          rigerror(result));
-            }
+    if (freq == last->freq[i])
+    {
+        return 0;
+    }
 
-            if (vfo != vfo_prev)
-            {
-                rig_fire_vfo_event(rig, vfo);
-            }
+    rig_debug(RIG_DEBUG_CACHE, "%s(%d) freq %s=%.0f was %.0f\n", __FILE__, __LINE__,
+              rig_strvfo(rig_poll_vfos[i]), freq, last->freq[i]);
+    rig_fire_freq_event(rig, rig_poll_vfos[i], freq);
+    last->freq[i] = freq;
 
-            if (vfo != vfo_prev)
-            {
-                rig_debug(RIG_DEBUG_CACHE,
-                          "%s(%d) vfo=%s was %s\n", __FILE__, __LINE__,
-                          rig_strvfo(vfo), rig_strvfo(vfo_prev));
-                update_occurred = 1;
-                vfo_prev = vfo;
-            }
+    return 1;
+}
+
+static int rig_poll_mode(RIG *rig, struct rig_poll_last *last, int i)
+{
+    rmode_t mode = RIG_MODE_NONE;
+    pbwidth_t width = 0;
+    int result;
+
+    result = rig_get_mode(rig, rig_poll_vfos[i], &mode, &width);
+
+    if (result != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s(%d): rig_get_mode %s error %s\n", __FILE__,
+                  __LINE__, rig_strvfo(rig_poll_vfos[i]), rigerror(result));
+        return 0;
+    }
+
+    if (mode == last->mode[i] && width == last->width[i])
+    {
+        return 0;
+    }
+
+    rig_debug(RIG_DEBUG_CACHE, "%s(%d) mode %s=%s/%ld was %s/%ld\n", __FILE__,
+              __LINE__, rig_strvfo(rig_poll_vfos[i]), rig_strrmode(mode), width,
+              rig_strrmode(last->mode[i]), last->width[i]);
+    rig_fire_mode_event(rig, rig_poll_vfos[i], mode, width);
+    last->mode[i] = mode;
+    last->width[i] = width;
+
+    return 1;
+}
+
+static int rig_poll_ptt(RIG *rig, struct rig_poll_last *last)
+{
+    ptt_t ptt = RIG_PTT_OFF;
+    int result;
+
+    result = rig_get_ptt(rig, RIG_VFO_CURR, &ptt);
+
+    if (result != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s(%d): rig_get_ptt error %s\n", __FILE__, __LINE__,
+                  rigerror(result));
+        return 0;
+    }
+
+    if (ptt == last->ptt)
+    {
+        return 0;
+    }
+
+    rig_debug(RIG_DEBUG_CACHE, "%s(%d) ptt=%d was %d\n", __FILE__, __LINE__,
+              ptt, last->ptt);
+    rig_fire_ptt_event(rig, RIG_VFO_CURR, ptt);
+    last->ptt = ptt;
+
+    return 1;
+}
+
+static int rig_poll_split(RIG *rig, struct rig_poll_last *last)
+{
+    split_t split = RIG_SPLIT_OFF;
+    vfo_t tx_vfo;
+    int result;
+
+    result = rig_get_split_vfo(rig, RIG_VFO_A, &split, &tx_vfo);
+
+    if (result != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s(%d): rig_get_split_vfo error %s\n", __FILE__,
+                  __LINE__, rigerror(result));
+        return 0;
+    }
+
+    if (split == last->split)
+    {
+        return 0;
+    }
+
+    rig_debug(RIG_DEBUG_CACHE, "%s(%d) split=%d was %d\n", __FILE__, __LINE__,
+              split, last->split);
+    last->split = split;
+
+    return 1;
+}
+
+static int rig_poll_levels(RIG *rig, struct rig_poll_last *last)
+{
+    setting_t levels = rig_has_get_level(rig, rig->state.poll_levels);
+    int changed = 0;
+    int i;
+
+    for (i = 0; i < RIG_SETTING_MAX; i++)
+    {
+        setting_t level = rig_idx2setting(i);
+        value_t val;
+        int same;
+
+        if (!(levels & level))
+        {
+            continue;
         }
 
-        if (rig->caps->get_freq)
+        if (rig_get_level(rig, RIG_VFO_CURR, level, &val) != RIG_OK)
         {
-            result = rig_get_freq(rig, RIG_VFO_A, &freq_main);
+            continue;
+        }
 
-            if (result != RIG_OK)
-            {
-                rig_debug(RIG_DEBUG_ERR, "%s(%d): rig_get_freqA error %s\n", __FILE__, __LINE__,
-                          rigerror(result));
-            }
+        same = RIG_LEVEL_IS_FLOAT(level) ? val.f == last->level[i].f
+               : val.i == last->level[i].i;
 
-            result = rig_get_freq(rig, RIG_VFO_B, &freq_sub);
+        if (!same || !(last->levels_read & level))
+        {
+            last->level[i] = val;
+            last->levels_read |= level;
+            changed = 1;
+        }
+    }
 
-            if (result != RIG_OK)
-            {
-                rig_debug(RIG_DEBUG_ERR, "%s(%d): rig_get_freqB error %s\n", __FILE__, __LINE__,
-                          rigerror(result));
-            }
+    return changed;
+}
 
-            if (freq_main != freq_main_prev)
-            {
-                rig_fire_freq_event(rig, RIG_VFO_A, freq_main);
-            }
+void *rig_poll_routine(void *arg)
+{
+    rig_poll_routine_args *args = (rig_poll_routine_args *)arg;
+    RIG *rig = args->rig;
+    struct rig_state *rs = &rig->state;
+    struct rig_poll_last last;
+    unsigned int tick, seq;
+    int stride = 1, idle = 0;
+    int i;
 
-            if (freq_sub != freq_sub_prev)
-            {
-                rig_fire_freq_event(rig, RIG_VFO_B, freq_sub);
-            }
+    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Starting rig poll routine thread\n",
+              __FILE__, __LINE__);
 
-            if (freq_main != freq_main_prev || freq_sub != freq_sub_prev)
-            {
-                rig_debug(RIG_DEBUG_CACHE,
-                          "%s(%d) freq_main=%.0f was %.0f, freq_sub=%.0f was %.0f\n", __FILE__, __LINE__,
-                          freq_main, freq_main_prev, freq_sub, freq_sub_prev);
-                update_occurred = 1;
-                freq_main_prev = freq_main;
-                freq_sub_prev = freq_sub;
-            }
+    hl_thread_sched_apply("poll routine");
+
+    // anything an application asks for goes ahead of the poll
+    rig_lock_thread_prio(RIG_PRIO_BACKGROUND);
+
+    // Rig cache time should be equal to rig poll interval (should be set automatically by rigctld at least)
+    rig_set_cache_timeout_ms(rig, HAMLIB_CACHE_ALL, rs->poll_interval);
+
+    memset(&last, 0, sizeof(last));
+    last.vfo = RIG_VFO_NONE;
+    last.split = -1;
+
+    seq = rig_cache_read_begin(rig);
+
+    for (tick = 0; rs->poll_routine_thread_run; tick++)
+    {
+        int due[RIG_POLL_FIELDS];
+        int update_occurred = 0, levels_changed = 0;
+        int other = rs->current_vfo == RIG_VFO_B || rs->current_vfo == RIG_VFO_SUB;
+
+        if (rig_cache_read_begin(rig) != seq || last.ptt != RIG_PTT_OFF)
+        {
+            stride = 1;
+            idle = 0;
         }
 
-        if (rig->caps->get_mode)
+        for (i = 0; i < RIG_POLL_FIELDS; i++)
         {
-            result = rig_get_mode(rig, RIG_VFO_A, &mode_main, &width_main);
+            due[i] = tick % (rig_poll_every[i] * (i == RIG_POLL_PTT ? 1 : stride)) == 0;
+        }
 
-            if (result != RIG_OK)
-            {
-                rig_debug(RIG_DEBUG_ERR, "%s(%d): rig_get_modeA error %s\n", __FILE__, __LINE__,
-                          rigerror(result));
-            }
+        if (rig_cache_pushed(rig, rs->use_cached_freq))
+        {
+            due[RIG_POLL_FREQ_CURR] = due[RIG_POLL_FREQ_OTHER] = 0;
+        }
 
-            result = rig_get_mode(rig, RIG_VFO_B, &mode_sub, &width_sub);
+        if (rig_cache_pushed(rig, rs->use_cached_mode))
+        {
+            due[RIG_POLL_MODE_CURR] = due[RIG_POLL_MODE_OTHER] = 0;
+        }
 
-            if (result != RIG_OK)
-            {
-                rig_debug(RIG_DEBUG_ERR, "%s(%d): rig_get_modeB error %s\n", __FILE__, __LINE__,
-                          rigerror(result));
-            }
+        if (rig_cache_pushed(rig, rs->use_cached_ptt))
+        {
+            due[RIG_POLL_PTT] = 0;
+        }
+
+        if (due[RIG_POLL_PTT] && rs->pttport.type.ptt != RIG_PTT_NONE)
+        {
+            update_occurred |= rig_poll_ptt(rig, &last);
+        }
+
+        if (due[RIG_POLL_VFO] && rig->caps->get_vfo)
+        {
+            update_occurred |= rig_poll_vfo(rig, &last);
+        }
 
-            if (mode_main != mode_main_prev || width_main != width_main_prev)
+        if (rig->caps->get_freq)
+        {
+            if (due[RIG_POLL_FREQ_CURR])
             {
-                rig_fire_mode_event(rig, RIG_VFO_A, mode_main, width_main);
+                update_occurred |= rig_poll_freq(rig, &last, other);
             }
 
-            if (mode_sub != mode_sub_prev || width_sub != width_sub_prev)
+            if (due[RIG_POLL_FREQ_OTHER])
             {
-                rig_fire_mode_event(rig, RIG_VFO_B, mode_sub, width_sub);
+                update_occurred |= rig_poll_freq(rig, &last, !other);
             }
+        }
 
-            if (mode_main != mode_main_prev || mode_sub != mode_sub_prev)
+        if (rig->caps->get_mode)
+        {
+            if (due[RIG_POLL_MODE_CURR])
             {
-                rig_debug(RIG_DEBUG_CACHE, "%s(%d) mode_main=%s was %s, mode_sub=%s was %s\n",
-                          __FILE__, __LINE__, rig_strrmode(mode_main), rig_strrmode(mode_main_prev),
-                          rig_strrmode(mode_sub), rig_strrmode(mode_sub_prev));
-                update_occurred = 1;
-                mode_main_prev = mode_main;
-                mode_sub_prev = mode_sub;
+                update_occurred |= rig_poll_mode(rig, &last, other);
             }
 
-            if (width_main != width_main_prev || width_sub != width_sub_prev)
+            if (due[RIG_POLL_MODE_OTHER])
             {
-                rig_debug(RIG_DEBUG_CACHE,
-                          "%s(%d) width_main=%ld was %ld, width_sub=%ld was %ld\n", __FILE__, __LINE__,
-                          width_main, width_main_prev, width_sub, width_sub_prev);
-                update_occurred = 1;
-                width_main_prev = width_main;
-                width_sub_prev = width_sub;
+                update_occurred |= rig_poll_mode(rig, &last, !other);
             }
         }
 
-        if (rig->caps->get_split_vfo)
+        if (due[RIG_POLL_SPLIT] && rig->caps->get_split_vfo)
         {
-            vfo_t tx_vfo;
-            result = rig_get_split_vfo(rig, RIG_VFO_A, &split, &tx_vfo);
+            update_occurred |= rig_poll_split(rig, &last);
+        }
 
-            if (result != RIG_OK)
-            {
-                rig_debug(RIG_DEBUG_ERR, "%s(%d): rig_get_modeA error %s\n", __FILE__, __LINE__,
-                          rigerror(result));
-            }
+        if (due[RIG_POLL_LEVELS] && rs->poll_levels)
+        {
+            levels_changed = rig_poll_levels(rig, &last);
+        }
 
-            if (split != split_prev)
-            {
-                rig_debug(RIG_DEBUG_CACHE, "%s(%d) split=%d was %d\n", __FILE__, __LINE__,
-                          split,
-                          split_prev);
-                update_occurred = 1;
-                split_prev = split;
-            }
+        if (update_occurred || levels_changed)
+        {
+            network_publish_rig_poll_data(rig);
         }
 
+        // meters move all the time, only the rest counts as the rig being used
         if (update_occurred)
         {
-            network_publish_rig_poll_data(rig);
+            stride = 1;
+            idle = 0;
         }
+        else if (++idle >= RIG_POLL_IDLE_TICKS && stride < RIG_POLL_STRIDE_MAX)
+        {
+            stride *= 2;
+            idle = 0;
+            rig_debug(RIG_DEBUG_CACHE, "%s(%d) rig idle, polling at 1/%d\n",
+                      __FILE__, __LINE__, stride);
+        }
+
+        // our own reads are in the cache already, anything after this is someone else
+        seq = rig_cache_read_begin(rig);
 
         hl_usleep(rs->poll_interval * 1000);
     }
@@ -543,6 +728,249 @@ int HAMLIB_API rig_set_spectrum_callback(RIG *rig, spectrum_cb_t cb,
 }
 
 
+/**
+ * \brief set the callback for late command errors
+ * \param rig   The rig handle
+ * \param cb    The callback to install
+ * \param arg   A Pointer to some private data to pass later on to the callback
+ *
+ *  Install a callback for errors found after the call that caused them
+ *  has already returned, e.g. a set command whose verification a backend
+ *  deferred.  The callback gets the Hamlib error code and the command
+ *  string concerned.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ */
+int HAMLIB_API rig_set_error_callback(RIG *rig, error_cb_t cb, rig_ptr_t arg)
+{
+    ENTERFUNC;
+
+    if (CHECK_RIG_ARG(rig))
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    rig->callbacks.error_event = cb;
+    rig->callbacks.error_arg = arg;
+
+    RETURNFUNC(RIG_OK);
+}
+
+
+/**
+ * \brief set the callback for receiver status changes
+ * \param rig   The rig handle
+ * \param cb    The callback to install
+ * \param arg   A Pointer to some private data to pass later on to the callback
+ *
+ *  Install a callback for changes of a receiver status that has no setting
+ *  of its own, such as the system, talkgroup and channel a trunking scanner
+ *  is monitoring.  The text is backend specific and stays valid only for
+ *  the duration of the call.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ */
+int HAMLIB_API rig_set_status_callback(RIG *rig, status_cb_t cb, rig_ptr_t arg)
+{
+    ENTERFUNC;
+
+    if (CHECK_RIG_ARG(rig))
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    rig->callbacks.status_event = cb;
+    rig->callbacks.status_arg = arg;
+
+    RETURNFUNC(RIG_OK);
+}
+
+
+/**
+ * \brief set the callback for CW queue progress
+ * \param rig   The rig handle
+ * \param cb    The callback to install
+ * \param arg   A Pointer to some private data to pass later on to the callback
+ *
+ *  Install a callback for the messages queued by rig_send_morse() with the
+ *  morse_queue option set.  It is called from the queue thread each time
+ *  the rig has taken more of a message, with the message text, the number
+ *  of its characters taken so far and RIG_OK; the last call for a message
+ *  has all of it.  A message cut short by rig_stop_morse(), or by an error,
+ *  gets a last call with -RIG_ETRUNC or the error.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_send_morse(), rig_stop_morse()
+ */
+int HAMLIB_API rig_set_morse_callback(RIG *rig, morse_cb_t cb, rig_ptr_t arg)
+{
+    ENTERFUNC;
+
+    if (CHECK_RIG_ARG(rig))
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    rig->callbacks.morse_event = cb;
+    rig->callbacks.morse_arg = arg;
+
+    RETURNFUNC(RIG_OK);
+}
+
+
+/**
+ * \brief set the callback for ALE and selcall messages
+ * \param rig   The rig handle
+ * \param cb    The callback to install
+ * \param arg   A Pointer to some private data to pass later on to the callback
+ *
+ *  Install a callback for the ALE and selcall messages a rig sends on its
+ *  own: a call received, a link established or ended, a change of channel.
+ *  It is called from the async reader, so the "async" conf must be set,
+ *  as soon as the message is in.  The event stays valid only for the
+ *  duration of the call; the last one of each type is also kept, see
+ *  rig_get_ale_event().
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ */
+int HAMLIB_API rig_set_ale_callback(RIG *rig, ale_cb_t cb, rig_ptr_t arg)
+{
+    ENTERFUNC;
+
+    if (CHECK_RIG_ARG(rig))
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    rig->callbacks.ale_event = cb;
+    rig->callbacks.ale_arg = arg;
+
+    RETURNFUNC(RIG_OK);
+}
+
+
+/**
+ * \brief set the callback for received DTMF digits
+ * \param rig   The rig handle
+ * \param cb    The callback to install
+ * \param arg   A Pointer to some private data to pass later on to the callback
+ *
+ *  Install a callback for the DTMF digits the rig decodes, called with
+ *  them as they are detected instead of waiting for rig_recv_dtmf() to be
+ *  polled.  Backends reporting tones in their status stream, like the PCR
+ *  receivers, call it from the async reader, so the "async" conf must be
+ *  set.  The digits are a NUL terminated string of 0-9, A-D, * and #,
+ *  valid only for the duration of the call.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_recv_dtmf()
+ */
+int HAMLIB_API rig_set_dtmf_callback(RIG *rig, dtmf_cb_t cb, rig_ptr_t arg)
+{
+    ENTERFUNC;
+
+    if (CHECK_RIG_ARG(rig))
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    rig->callbacks.dtmf_event = cb;
+    rig->callbacks.dtmf_arg = arg;
+
+    RETURNFUNC(RIG_OK);
+}
+
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t ale_lock = PTHREAD_MUTEX_INITIALIZER;
+#define ALE_LOCK()   pthread_mutex_lock(&ale_lock)
+#define ALE_UNLOCK() pthread_mutex_unlock(&ale_lock)
+#else
+#define ALE_LOCK()
+#define ALE_UNLOCK()
+#endif
+
+/**
+ * \brief get the last ALE or selcall message of a type
+ * \param rig   The rig handle
+ * \param type  Which message
+ * \param ev    Where to copy it
+ *
+ *  Nothing is asked of the rig: this is what its messages last said, so a
+ *  program can tell whether a link is up without waiting for the next
+ *  message.  ev->ms tells how old it is.
+ *
+ * \return RIG_OK, -RIG_ENAVAIL if no such message arrived since rig_open()
+ * or another negative value if an error occurred.
+ *
+ * \sa rig_set_ale_callback()
+ */
+int HAMLIB_API rig_get_ale_event(RIG *rig, enum rig_ale_event_e type,
+                                 struct rig_ale_event *ev)
+{
+    int ret = RIG_OK;
+
+    if (CHECK_RIG_ARG(rig) || !ev || type < RIG_ALE_CALL
+            || type >= RIG_ALE_EVENT_MAX)
+    {
+        return -RIG_EINVAL;
+    }
+
+    ALE_LOCK();
+
+    if (rig->state.ale_last[type].type != type)
+    {
+        ret = -RIG_ENAVAIL;
+    }
+    else
+    {
+        *ev = rig->state.ale_last[type];
+    }
+
+    ALE_UNLOCK();
+
+    return ret;
+}
+
+
+/**
+ * \brief name of an ALE message type
+ * \param type  The type
+ * \return "CALL", "LINK" and so on, "" if type is not one
+ */
+const char *HAMLIB_API rig_strale(enum rig_ale_event_e type)
+{
+    switch (type)
+    {
+    case RIG_ALE_CALL: return "CALL";
+
+    case RIG_ALE_LINK: return "LINK";
+
+    case RIG_ALE_UNLINK: return "UNLINK";
+
+    case RIG_ALE_CHANNEL: return "CHANNEL";
+
+    case RIG_ALE_SELCALL: return "SELCALL";
+
+    case RIG_ALE_EVENT_MAX: break;
+    }
+
+    return "";
+}
+
+
 /**
  * \brief control the transceive mode
  * \param rig   The rig handle
@@ -635,8 +1063,10 @@ int rig_fire_vfo_event(RIG *rig, vfo_t vfo)
 
     rig_debug(RIG_DEBUG_TRACE, "Event: vfo changed to %s\n", rig_strvfo(vfo));
 
+    rig_cache_write_begin(rig);
     rig->state.cache.vfo = vfo;
     elapsed_ms(&rig->state.cache.time_vfo, HAMLIB_ELAPSED_SET);
+    rig_cache_write_end(rig);
 
     network_publish_rig_transceive_data(rig);
 
@@ -656,8 +1086,10 @@ int rig_fire_ptt_event(RIG *rig, vfo_t vfo, ptt_t ptt)
     rig_debug(RIG_DEBUG_TRACE, "Event: PTT changed to %i on %s\n", ptt,
               rig_strvfo(vfo));
 
+    rig_cache_write_begin(rig);
     rig->state.cache.ptt = ptt;
     elapsed_ms(&rig->state.cache.time_ptt, HAMLIB_ELAPSED_SET);
+    rig_cache_write_end(rig);
 
     network_publish_rig_transceive_data(rig);
 
@@ -677,6 +1109,8 @@ int rig_fire_dcd_event(RIG *rig, vfo_t vfo, dcd_t dcd)
     rig_debug(RIG_DEBUG_TRACE, "Event: DCD changed to %i on %s\n", dcd,
               rig_strvfo(vfo));
 
+    rig_journal_dcd(rig, vfo, dcd);
+
     network_publish_rig_transceive_data(rig);
 
     if (rig->callbacks.dcd_event)
@@ -688,6 +1122,95 @@ int rig_fire_dcd_event(RIG *rig, vfo_t vfo, dcd_t dcd)
 }
 
 
+int rig_fire_error_event(RIG *rig, int err, const char *cmd)
+{
+    ENTERFUNC;
+
+    rig_debug(RIG_DEBUG_TRACE, "Event: late error '%s' for %s\n", rigerror(err),
+              cmd);
+
+    if (rig->callbacks.error_event)
+    {
+        rig->callbacks.error_event(rig, err, cmd, rig->callbacks.error_arg);
+    }
+
+    RETURNFUNC(0);
+}
+
+
+/*
+ * For backends parsing the rig's ALE messages: stamps ev, keeps it for
+ * rig_get_ale_event() and calls the callback.  A channel change that
+ * names the frequency also updates the frequency cache and fires the
+ * frequency event.
+ */
+int rig_fire_ale_event(RIG *rig, struct rig_ale_event *ev)
+{
+    struct timespec now;
+
+    ENTERFUNC;
+
+    if (ev->type < RIG_ALE_CALL || ev->type >= RIG_ALE_EVENT_MAX)
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    ev->ms = (int64_t) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+
+    rig_debug(RIG_DEBUG_TRACE, "Event: ALE %s from='%s' to='%s' channel=%d freq=%.0f\n",
+              rig_strale(ev->type), ev->from, ev->to, ev->channel, ev->freq);
+
+    ALE_LOCK();
+    rig->state.ale_last[ev->type] = *ev;
+    ALE_UNLOCK();
+
+    if (ev->type == RIG_ALE_CHANNEL && ev->freq > 0)
+    {
+        rig_fire_freq_event(rig, RIG_VFO_A, ev->freq);
+    }
+
+    if (rig->callbacks.ale_event)
+    {
+        rig->callbacks.ale_event(rig, ev, rig->callbacks.ale_arg);
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+
+int rig_fire_dtmf_event(RIG *rig, vfo_t vfo, const char *digits)
+{
+    ENTERFUNC;
+
+    rig_debug(RIG_DEBUG_TRACE, "Event: DTMF '%s' on %s\n", digits,
+              rig_strvfo(vfo));
+
+    if (rig->callbacks.dtmf_event)
+    {
+        rig->callbacks.dtmf_event(rig, vfo, digits, rig->callbacks.dtmf_arg);
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+
+int rig_fire_status_event(RIG *rig, vfo_t vfo, const char *status)
+{
+    ENTERFUNC;
+
+    rig_debug(RIG_DEBUG_TRACE, "Event: status changed to '%s' on %s\n", status,
+              rig_strvfo(vfo));
+
+    if (rig->callbacks.status_event)
+    {
+        rig->callbacks.status_event(rig, vfo, status, rig->callbacks.status_arg);
+    }
+
+    RETURNFUNC(RIG_OK);
+}
+
+
 int rig_fire_pltune_event(RIG *rig, vfo_t vfo, freq_t *freq, rmode_t *mode,
                           pbwidth_t *width)
 {
@@ -711,7 +1234,9 @@ static int print_spectrum_line(char *str, size_t length,
                                struct rig_spectrum_line *line)
 {
     int data_level_max = line->data_level_max / 2;
-    int aggregate_count = line->spectrum_data_length / 120;
+    /* lines of fewer than 120 points, sweeps among them, print one to one */
+    int aggregate_count = line->spectrum_data_length > 120
+                          ? (int)(line->spectrum_data_length / 120) : 1;
     int aggregate_value = 0;
     int i, c;
     int charlen = strlen("█");
@@ -768,8 +1293,22 @@ static int print_spectrum_line(char *str, size_t length,
 
 int rig_fire_spectrum_event(RIG *rig, struct rig_spectrum_line *line)
 {
+    struct spectrum_pool_line *processed = NULL;
+
     ENTERFUNC;
 
+    if (spectrum_proc_active(rig))
+    {
+        processed = spectrum_proc_line(rig, line);
+
+        if (!processed)
+        {
+            RETURNFUNC(RIG_OK);
+        }
+
+        line = &processed->line;
+    }
+
     if (rig_need_debug(RIG_DEBUG_TRACE))
     {
         char spectrum_debug[line->spectrum_data_length * 4];
@@ -778,6 +1317,8 @@ int rig_fire_spectrum_event(RIG *rig, struct rig_spectrum_line *line)
                   spectrum_debug);
     }
 
+    spectrum_history_add(rig, line);
+
     network_publish_rig_spectrum_data(rig, line);
 
     if (rig->callbacks.spectrum_event)
@@ -785,6 +1326,11 @@ int rig_fire_spectrum_event(RIG *rig, struct rig_spectrum_line *line)
         rig->callbacks.spectrum_event(rig, line, rig->callbacks.spectrum_arg);
     }
 
+    if (processed)
+    {
+        spectrum_pool_put(processed);
+    }
+
     RETURNFUNC(RIG_OK);
 }
 
@@ -34,6 +34,10 @@ int rig_fire_ptt_event(RIG *rig, vfo_t vfo, ptt_t ptt);
 int rig_fire_dcd_event(RIG *rig, vfo_t vfo, dcd_t dcd);
 int rig_fire_pltune_event(RIG *rig, vfo_t vfo, freq_t *freq, rmode_t *mode, pbwidth_t *width);
 int rig_fire_spectrum_event(RIG *rig, struct rig_spectrum_line *line);
+int rig_fire_error_event(RIG *rig, int err, const char *cmd);
+int rig_fire_status_event(RIG *rig, vfo_t vfo, const char *status);
+int rig_fire_ale_event(RIG *rig, struct rig_ale_event *ev);
+int rig_fire_dtmf_event(RIG *rig, vfo_t vfo, const char *digits);
 
 #endif /* _EVENT_H */
 
@@ -0,0 +1,598 @@
+/*
+ *  Hamlib Interface - work-stealing executor
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Every worker owns a deque.  A task posted from a worker goes on the
+ * front of that worker's deque and the worker takes from the front, so
+ * work a task spawns runs next while it is still warm in that core's
+ * cache.  A worker with nothing left takes from the back of the others'
+ * deques.  Tasks posted from outside the pool are dealt round robin onto
+ * the backs.
+ *
+ * A strand is a FIFO of tasks plus one task of its own that drains it.
+ * That task is on a deque or running while the FIFO is non-empty and
+ * never twice at a time, which is all that keeps one port's operations
+ * in order.  After STRAND_BATCH tasks it goes to the back of its deque so
+ * a busy port cannot starve the others on the same worker.
+ *
+ * pending counts tasks on the deques.  It is raised before the sleepers
+ * are signalled under ex->lock and checked under the same lock before a
+ * worker sleeps, so a post cannot slip between a worker's last scan and
+ * its wait.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "executor.h"
+#include "thread_sched.h"
+
+#ifdef HAVE_PTHREAD
+
+//! @cond Doxygen_Suppress
+
+#define EXECUTOR_MAX_THREADS 32
+#define STRAND_BATCH 16
+
+struct hl_task
+{
+    hl_task_fn fn;
+    void *arg;
+    int owned;              /* free() after running, strands embed theirs */
+    struct hl_task *prev;
+    struct hl_task *next;
+};
+
+struct hl_worker
+{
+    hl_executor_t *ex;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    struct hl_task *front;
+    struct hl_task *back;
+};
+
+struct hl_executor
+{
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int running;
+    int pending;
+    unsigned int next_inject;
+    int nworkers;
+    struct hl_worker workers[EXECUTOR_MAX_THREADS];
+};
+
+struct hl_strand
+{
+    hl_executor_t *ex;
+    pthread_mutex_t lock;
+    pthread_cond_t idle;
+    struct hl_task *head;
+    struct hl_task *tail;
+    int scheduled;
+    struct hl_task run;
+    char name[32];
+};
+
+#if defined(__GNUC__)
+static __thread struct hl_worker *current_worker;
+#define CURRENT_WORKER(ex) \
+    ((current_worker && current_worker->ex == (ex)) ? current_worker : NULL)
+#else
+#define CURRENT_WORKER(ex) NULL
+#endif
+
+static void deque_push(struct hl_worker *w, struct hl_task *t, int at_back)
+{
+    pthread_mutex_lock(&w->lock);
+
+    if (at_back)
+    {
+        t->next = NULL;
+        t->prev = w->back;
+
+        if (w->back) { w->back->next = t; }
+        else { w->front = t; }
+
+        w->back = t;
+    }
+    else
+    {
+        t->prev = NULL;
+        t->next = w->front;
+
+        if (w->front) { w->front->prev = t; }
+        else { w->back = t; }
+
+        w->front = t;
+    }
+
+    pthread_mutex_unlock(&w->lock);
+}
+
+static struct hl_task *deque_pop(struct hl_worker *w, int from_back)
+{
+    struct hl_task *t;
+
+    pthread_mutex_lock(&w->lock);
+
+    t = from_back ? w->back : w->front;
+
+    if (t)
+    {
+        if (t->prev) { t->prev->next = t->next; }
+        else { w->front = t->next; }
+
+        if (t->next) { t->next->prev = t->prev; }
+        else { w->back = t->prev; }
+    }
+
+    pthread_mutex_unlock(&w->lock);
+
+    return t;
+}
+
+static void executor_push(hl_executor_t *ex, struct hl_task *t, int at_back)
+{
+    struct hl_worker *w = CURRENT_WORKER(ex);
+
+    if (!w)
+    {
+        pthread_mutex_lock(&ex->lock);
+        w = &ex->workers[ex->next_inject++ % ex->nworkers];
+        pthread_mutex_unlock(&ex->lock);
+        at_back = 1;
+    }
+
+    deque_push(w, t, at_back);
+
+    pthread_mutex_lock(&ex->lock);
+    ex->pending++;
+    pthread_cond_signal(&ex->cond);
+    pthread_mutex_unlock(&ex->lock);
+}
+
+static struct hl_task *executor_take(struct hl_worker *self)
+{
+    hl_executor_t *ex = self->ex;
+    struct hl_task *t;
+    int start = (int)(self - ex->workers);
+    int i;
+
+    t = deque_pop(self, 0);
+
+    for (i = 1; !t && i < ex->nworkers; i++)
+    {
+        t = deque_pop(&ex->workers[(start + i) % ex->nworkers], 1);
+    }
+
+    if (t)
+    {
+        pthread_mutex_lock(&ex->lock);
+        ex->pending--;
+        pthread_mutex_unlock(&ex->lock);
+    }
+
+    return t;
+}
+
+static void *executor_worker(void *arg)
+{
+    struct hl_worker *self = arg;
+    hl_executor_t *ex = self->ex;
+
+#if defined(__GNUC__)
+    current_worker = self;
+#endif
+
+    // async frames are dispatched here, so workers get the same treatment
+    hl_thread_sched_apply("executor worker");
+
+    for (;;)
+    {
+        struct hl_task *t = executor_take(self);
+
+        if (t)
+        {
+            int owned = t->owned;
+
+            t->fn(t->arg);
+
+            if (owned) { free(t); }
+
+            continue;
+        }
+
+        pthread_mutex_lock(&ex->lock);
+
+        if (ex->pending == 0 && !ex->running)
+        {
+            pthread_mutex_unlock(&ex->lock);
+            break;
+        }
+
+        if (ex->pending == 0)
+        {
+            pthread_cond_wait(&ex->cond, &ex->lock);
+        }
+
+        pthread_mutex_unlock(&ex->lock);
+    }
+
+    return NULL;
+}
+
+static int executor_ncpus(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO si;
+
+    GetSystemInfo(&si);
+    return (int) si.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    return (int) sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    return 2;
+#endif
+}
+
+hl_executor_t *HAMLIB_API hl_executor_new(int nthreads)
+{
+    hl_executor_t *ex;
+    int i;
+
+    if (nthreads <= 0)
+    {
+        nthreads = executor_ncpus();
+    }
+
+    // one worker would have nobody to steal from, a port stuck in a long
+    // read would hold up everybody else
+    if (nthreads < 2) { nthreads = 2; }
+
+    if (nthreads > EXECUTOR_MAX_THREADS) { nthreads = EXECUTOR_MAX_THREADS; }
+
+    ex = calloc(1, sizeof(*ex));
+
+    if (!ex)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_init(&ex->lock, NULL);
+    pthread_cond_init(&ex->cond, NULL);
+    ex->running = 1;
+
+    for (i = 0; i < nthreads; i++)
+    {
+        struct hl_worker *w = &ex->workers[i];
+
+        w->ex = ex;
+        pthread_mutex_init(&w->lock, NULL);
+    }
+
+    // workers steal from every slot up to nworkers, so set it before any start
+    ex->nworkers = nthreads;
+
+    for (i = 0; i < nthreads; i++)
+    {
+        if (pthread_create(&ex->workers[i].thread, NULL, executor_worker,
+                           &ex->workers[i]) != 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: pthread_create failed for worker %d\n",
+                      __func__, i);
+            break;
+        }
+    }
+
+    if (i < nthreads)
+    {
+        int started = i;
+
+        pthread_mutex_lock(&ex->lock);
+        ex->running = 0;
+        pthread_cond_broadcast(&ex->cond);
+        pthread_mutex_unlock(&ex->lock);
+
+        for (i = 0; i < started; i++)
+        {
+            pthread_join(ex->workers[i].thread, NULL);
+        }
+
+        for (i = 0; i < nthreads; i++)
+        {
+            pthread_mutex_destroy(&ex->workers[i].lock);
+        }
+
+        pthread_cond_destroy(&ex->cond);
+        pthread_mutex_destroy(&ex->lock);
+        free(ex);
+        return NULL;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %d workers\n", __func__, nthreads);
+
+    return ex;
+}
+
+void HAMLIB_API hl_executor_free(hl_executor_t *ex)
+{
+    int i;
+
+    if (!ex)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&ex->lock);
+    ex->running = 0;
+    pthread_cond_broadcast(&ex->cond);
+    pthread_mutex_unlock(&ex->lock);
+
+    for (i = 0; i < ex->nworkers; i++)
+    {
+        pthread_join(ex->workers[i].thread, NULL);
+        pthread_mutex_destroy(&ex->workers[i].lock);
+    }
+
+    pthread_cond_destroy(&ex->cond);
+    pthread_mutex_destroy(&ex->lock);
+    free(ex);
+}
+
+static hl_executor_t *default_executor;
+static pthread_once_t default_once = PTHREAD_ONCE_INIT;
+
+static void default_executor_init(void)
+{
+    default_executor = hl_executor_new(0);
+}
+
+hl_executor_t *HAMLIB_API hl_executor_default(void)
+{
+    pthread_once(&default_once, default_executor_init);
+
+    return default_executor;
+}
+
+int HAMLIB_API hl_executor_post(hl_executor_t *ex, hl_task_fn fn, void *arg)
+{
+    struct hl_task *t;
+
+    if (!ex || !fn)
+    {
+        return -RIG_EINVAL;
+    }
+
+    t = calloc(1, sizeof(*t));
+
+    if (!t)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    t->fn = fn;
+    t->arg = arg;
+    t->owned = 1;
+
+    executor_push(ex, t, 0);
+
+    return RIG_OK;
+}
+
+static void strand_run(void *arg)
+{
+    hl_strand_t *s = arg;
+    int n;
+
+    for (n = 0; n < STRAND_BATCH; n++)
+    {
+        struct hl_task *t;
+
+        pthread_mutex_lock(&s->lock);
+        t = s->head;
+
+        if (!t)
+        {
+            s->scheduled = 0;
+            pthread_cond_broadcast(&s->idle);
+            pthread_mutex_unlock(&s->lock);
+            return;
+        }
+
+        s->head = t->next;
+
+        if (!s->head) { s->tail = NULL; }
+
+        pthread_mutex_unlock(&s->lock);
+
+        t->fn(t->arg);
+        free(t);
+    }
+
+    pthread_mutex_lock(&s->lock);
+
+    if (!s->head)
+    {
+        s->scheduled = 0;
+        pthread_cond_broadcast(&s->idle);
+        pthread_mutex_unlock(&s->lock);
+        return;
+    }
+
+    pthread_mutex_unlock(&s->lock);
+
+    executor_push(s->ex, &s->run, 1);
+}
+
+hl_strand_t *HAMLIB_API hl_strand_new(hl_executor_t *ex, const char *name)
+{
+    hl_strand_t *s;
+
+    if (!ex)
+    {
+        return NULL;
+    }
+
+    s = calloc(1, sizeof(*s));
+
+    if (!s)
+    {
+        return NULL;
+    }
+
+    s->ex = ex;
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_cond_init(&s->idle, NULL);
+    s->run.fn = strand_run;
+    s->run.arg = s;
+
+    if (name)
+    {
+        strncpy(s->name, name, sizeof(s->name) - 1);
+    }
+
+    return s;
+}
+
+void HAMLIB_API hl_strand_free(hl_strand_t *s)
+{
+    if (!s)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&s->lock);
+
+    while (s->scheduled)
+    {
+        pthread_cond_wait(&s->idle, &s->lock);
+    }
+
+    pthread_mutex_unlock(&s->lock);
+
+    pthread_cond_destroy(&s->idle);
+    pthread_mutex_destroy(&s->lock);
+    free(s);
+}
+
+int HAMLIB_API hl_strand_post(hl_strand_t *s, hl_task_fn fn, void *arg)
+{
+    struct hl_task *t;
+    int schedule;
+
+    if (!s || !fn)
+    {
+        return -RIG_EINVAL;
+    }
+
+    t = calloc(1, sizeof(*t));
+
+    if (!t)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    t->fn = fn;
+    t->arg = arg;
+
+    pthread_mutex_lock(&s->lock);
+
+    if (s->tail) { s->tail->next = t; }
+    else { s->head = t; }
+
+    s->tail = t;
+    schedule = !s->scheduled;
+    s->scheduled = 1;
+
+    pthread_mutex_unlock(&s->lock);
+
+    if (schedule)
+    {
+        executor_push(s->ex, &s->run, 0);
+    }
+
+    return RIG_OK;
+}
+
+//! @endcond
+
+#else /* !HAVE_PTHREAD */
+
+/* Without threads a post runs the task before it returns */
+
+struct hl_executor { int unused; };
+struct hl_strand { int unused; };
+
+static hl_executor_t inline_executor;
+
+hl_executor_t *HAMLIB_API hl_executor_new(int nthreads)
+{
+    return &inline_executor;
+}
+
+void HAMLIB_API hl_executor_free(hl_executor_t *ex)
+{
+}
+
+hl_executor_t *HAMLIB_API hl_executor_default(void)
+{
+    return &inline_executor;
+}
+
+int HAMLIB_API hl_executor_post(hl_executor_t *ex, hl_task_fn fn, void *arg)
+{
+    if (!fn) { return -RIG_EINVAL; }
+
+    fn(arg);
+    return RIG_OK;
+}
+
+hl_strand_t *HAMLIB_API hl_strand_new(hl_executor_t *ex, const char *name)
+{
+    return calloc(1, sizeof(hl_strand_t));
+}
+
+void HAMLIB_API hl_strand_free(hl_strand_t *s)
+{
+    free(s);
+}
+
+int HAMLIB_API hl_strand_post(hl_strand_t *s, hl_task_fn fn, void *arg)
+{
+    if (!fn) { return -RIG_EINVAL; }
+
+    fn(arg);
+    return RIG_OK;
+}
+
+#endif
@@ -0,0 +1,56 @@
+/*
+ *  Hamlib Interface - work-stealing executor
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _EXECUTOR_H
+#define _EXECUTOR_H 1
+
+#include <hamlib/rig.h>
+
+/*
+ * A few worker threads run short tasks for many devices -- see
+ * executor.c.  Work for one port goes through that port's strand, which
+ * runs its tasks one at a time and in the order they were posted, while
+ * the strands of different ports run side by side.  Tasks must not block
+ * for long: a socket read that waits for a client belongs on a thread of
+ * its own.
+ */
+typedef struct hl_executor hl_executor_t;
+typedef struct hl_strand hl_strand_t;
+typedef void (*hl_task_fn)(void *arg);
+
+/* nthreads 0 for one worker per CPU */
+extern HAMLIB_EXPORT(hl_executor_t *) hl_executor_new(int nthreads);
+/* Runs what is still queued, then stops the workers */
+extern HAMLIB_EXPORT(void) hl_executor_free(hl_executor_t *ex);
+/* The executor the library itself uses, started on first use */
+extern HAMLIB_EXPORT(hl_executor_t *) hl_executor_default(void);
+/* A task with no ordering against any other */
+extern HAMLIB_EXPORT(int) hl_executor_post(hl_executor_t *ex, hl_task_fn fn,
+        void *arg);
+
+extern HAMLIB_EXPORT(hl_strand_t *) hl_strand_new(hl_executor_t *ex,
+        const char *name);
+/* Waits for the strand's queued tasks, so never from one of them */
+extern HAMLIB_EXPORT(void) hl_strand_free(hl_strand_t *s);
+extern HAMLIB_EXPORT(int) hl_strand_post(hl_strand_t *s, hl_task_fn fn,
+        void *arg);
+
+#endif /* _EXECUTOR_H */
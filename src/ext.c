@@ -45,6 +45,7 @@
 #include <hamlib/rig.h>
 
 #include "token.h"
+#include "conf_index.h"
 
 static int rig_has_ext_token(RIG *rig, token_t token)
 {
@@ -242,6 +243,11 @@ const struct confparams *HAMLIB_API rig_ext_lookup(RIG *rig, const char *name)
         return NULL;
     }
 
+    if (rig->state.ext_index)
+    {
+        return conf_index_name(rig->state.ext_index, name);
+    }
+
     for (cfp = rig->caps->extlevels; cfp && cfp->name; cfp++)
     {
         if (!strcmp(cfp->name, name))
@@ -289,6 +295,11 @@ const struct confparams *HAMLIB_API rig_ext_lookup_tok(RIG *rig, token_t token)
         return NULL;
     }
 
+    if (rig->state.ext_index)
+    {
+        return conf_index_token(rig->state.ext_index, token);
+    }
+
     for (cfp = rig->caps->extlevels; cfp && cfp->token; cfp++)
     {
         if (cfp->token == token)
@@ -51,6 +51,7 @@
 #include <hamlib/amplifier.h>
 
 #include "token.h"
+#include "conf_index.h"
 
 
 /**
@@ -186,6 +187,11 @@ const struct confparams *HAMLIB_API amp_ext_lookup(AMP *amp, const char *name)
         return NULL;
     }
 
+    if (amp->state.ext_index)
+    {
+        return conf_index_name(amp->state.ext_index, name);
+    }
+
     for (cfp = amp->caps->extlevels; cfp && cfp->name; cfp++)
     {
         if (!strcmp(cfp->name, name))
@@ -230,6 +236,11 @@ const struct confparams *HAMLIB_API amp_ext_lookup_tok(AMP *amp, token_t token)
         return NULL;
     }
 
+    if (amp->state.ext_index)
+    {
+        return conf_index_token(amp->state.ext_index, token);
+    }
+
     for (cfp = amp->caps->extlevels; cfp && cfp->token; cfp++)
     {
         if (cfp->token == token)
@@ -19,6 +19,9 @@
  *
  */
 
+#include <hamlib/config.h>
+
+#include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
@@ -26,9 +29,198 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 
+#ifdef HAVE_LINUX_GPIO_H
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#endif
+
 #include "gpio.h"
 
 
+/*
+ * A port named "/dev/gpiochipN:line[,line...]" goes through the GPIO
+ * character device instead of sysfs: the lines are requested once at open,
+ * port->fd is the line request and every change is a single ioctl.  The
+ * first line is the PTT or DCD pin, the other ones are plain outputs that
+ * rig_set_gpio_lines() can switch together with PTT, e.g. band select bits.
+ */
+static int gpio_is_chardev(const hamlib_port_t *port)
+{
+    return !strncmp(port->pathname, "/dev/", 5);
+}
+
+#ifdef HAVE_LINUX_GPIO_H
+
+static int gpio_chardev_open(hamlib_port_t *port, int output, int on_value)
+{
+    struct gpio_v2_line_request req;
+    char chip[HAMLIB_FILPATHLEN];
+    const char *p;
+    char *end;
+    int fd;
+
+    p = strchr(port->pathname, ':');
+
+    if (!p || p - port->pathname >= sizeof(chip))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: expected chip:line[,line...], got \"%s\"\n",
+                  __func__, port->pathname);
+        return -RIG_EINVAL;
+    }
+
+    memset(&req, 0, sizeof(req));
+    memcpy(chip, port->pathname, p - port->pathname);
+    chip[p - port->pathname] = '\0';
+
+    do
+    {
+        unsigned long line = strtoul(p + 1, &end, 10);
+
+        if (end == p + 1 || req.num_lines >= GPIO_LINES_MAX)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: bad line list \"%s\"\n", __func__,
+                      port->pathname);
+            return -RIG_EINVAL;
+        }
+
+        req.offsets[req.num_lines++] = line;
+        p = end;
+    }
+    while (*p == ',');
+
+    if (*p != '\0' || (!output && req.num_lines > 1))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: bad line list \"%s\"\n", __func__,
+                  port->pathname);
+        return -RIG_EINVAL;
+    }
+
+    SNPRINTF(req.consumer, sizeof(req.consumer), "hamlib");
+
+    if (output)
+    {
+        /* everything starts low, i.e. PTT off once active low applies */
+        req.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+    }
+    else
+    {
+        /* the edges are queued on the request fd for the DCD watcher */
+        req.config.flags = GPIO_V2_LINE_FLAG_INPUT
+                           | GPIO_V2_LINE_FLAG_EDGE_RISING
+                           | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+    }
+
+    if (!on_value)
+    {
+        req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_FLAGS;
+        req.config.attrs[0].attr.flags = req.config.flags
+                                         | GPIO_V2_LINE_FLAG_ACTIVE_LOW;
+        req.config.attrs[0].mask = 1;
+        req.config.num_attrs = 1;
+    }
+
+    fd = open(chip, O_RDWR | O_CLOEXEC);
+
+    if (fd < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: opening %s: %s\n", __func__, chip,
+                  strerror(errno));
+        return -RIG_EIO;
+    }
+
+    if (ioctl(fd, GPIO_V2_GET_LINE_IOCTL, &req) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: requesting %s: %s\n", __func__,
+                  port->pathname, strerror(errno));
+        close(fd);
+        return -RIG_EIO;
+    }
+
+    /* the line request stays valid without the chip */
+    close(fd);
+
+    if (!output)
+    {
+        fcntl(req.fd, F_SETFL, fcntl(req.fd, F_GETFL) | O_NONBLOCK);
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s requested, %u line%s\n", __func__,
+              port->pathname, req.num_lines, req.num_lines > 1 ? "s" : "");
+
+    port->parm.gpio.lines = req.num_lines;
+    port->fd = req.fd;
+    return req.fd;
+}
+
+
+static int gpio_chardev_set(hamlib_port_t *port, unsigned int mask,
+                            unsigned int bits)
+{
+    struct gpio_v2_line_values values;
+
+    values.mask = mask;
+    values.bits = bits;
+
+    if (ioctl(port->fd, GPIO_V2_LINE_SET_VALUES_IOCTL, &values) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s: %s\n", __func__, port->pathname,
+                  strerror(errno));
+        return -RIG_EIO;
+    }
+
+    return RIG_OK;
+}
+
+
+static int gpio_chardev_get(hamlib_port_t *port, int *value)
+{
+    struct gpio_v2_line_values values;
+    struct gpio_v2_line_event event;
+
+    /* the event queue only tells the watcher to look, drop what piled up */
+    while (read(port->fd, &event, sizeof(event)) > 0)
+    {
+    }
+
+    values.mask = 1;
+    values.bits = 0;
+
+    if (ioctl(port->fd, GPIO_V2_LINE_GET_VALUES_IOCTL, &values) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s: %s\n", __func__, port->pathname,
+                  strerror(errno));
+        return -RIG_EIO;
+    }
+
+    *value = values.bits & 1;
+    return RIG_OK;
+}
+
+#else
+
+static int gpio_chardev_open(hamlib_port_t *port, int output, int on_value)
+{
+    rig_debug(RIG_DEBUG_ERR, "%s: no GPIO character device support for %s\n",
+              __func__, port->pathname);
+    return -RIG_ENIMPL;
+}
+
+
+static int gpio_chardev_set(hamlib_port_t *port, unsigned int mask,
+                            unsigned int bits)
+{
+    return -RIG_ENIMPL;
+}
+
+
+static int gpio_chardev_get(hamlib_port_t *port, int *value)
+{
+    return -RIG_ENIMPL;
+}
+
+#endif
+
+
 int gpio_open(hamlib_port_t *port, int output, int on_value)
 {
     char pathname[HAMLIB_FILPATHLEN * 2];
@@ -37,6 +229,12 @@ int gpio_open(hamlib_port_t *port, int output, int on_value)
     char *dir;
 
     port->parm.gpio.on_value = on_value;
+    port->parm.gpio.lines = 0;
+
+    if (gpio_is_chardev(port))
+    {
+        return gpio_chardev_open(port, output, on_value);
+    }
 
     SNPRINTF(pathname, HAMLIB_FILPATHLEN, "/sys/class/gpio/export");
     fexp = fopen(pathname, "w");
@@ -99,6 +297,7 @@ int gpio_open(hamlib_port_t *port, int output, int on_value)
 
 int gpio_close(hamlib_port_t *port)
 {
+    port->parm.gpio.lines = 0;
     return close(port->fd);
 }
 
@@ -108,6 +307,12 @@ int gpio_ptt_set(hamlib_port_t *port, ptt_t pttx)
     char *val;
     port->parm.gpio.value = pttx != RIG_PTT_OFF;
 
+    if (port->parm.gpio.lines)
+    {
+        /* active low is set up in the request */
+        return gpio_chardev_set(port, 1, port->parm.gpio.value);
+    }
+
     if ((port->parm.gpio.value && port->parm.gpio.on_value)
             || (!port->parm.gpio.value && !port->parm.gpio.on_value))
     {
@@ -146,6 +351,18 @@ int gpio_dcd_get(hamlib_port_t *port, dcd_t *dcdx)
     char val;
     int port_value;
 
+    if (port->parm.gpio.lines)
+    {
+        int retval = gpio_chardev_get(port, &port_value);
+
+        if (retval == RIG_OK)
+        {
+            *dcdx = port_value ? RIG_DCD_ON : RIG_DCD_OFF;
+        }
+
+        return retval;
+    }
+
     lseek(port->fd, 0, SEEK_SET);
 
     if (read(port->fd, &val, sizeof(val)) <= 0)
@@ -169,3 +386,72 @@ int gpio_dcd_get(hamlib_port_t *port, dcd_t *dcdx)
     return RIG_OK;
 }
 
+
+int gpio_edge(hamlib_port_t *port, const char *edge)
+{
+    char pathname[HAMLIB_FILPATHLEN * 2];
+    FILE *fedge;
+
+    if (port->parm.gpio.lines)
+    {
+        /* both edges are part of the input line request */
+        return RIG_OK;
+    }
+
+    SNPRINTF(pathname,
+             sizeof(pathname),
+             "/sys/class/gpio/gpio%s/edge",
+             port->pathname);
+    fedge = fopen(pathname, "w");
+
+    if (!fedge)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE,
+                  "GPIO%s edge (using %s): %s\n",
+                  port->pathname,
+                  pathname,
+                  strerror(errno));
+        return -RIG_ENAVAIL;
+    }
+
+    fprintf(fedge, "%s\n", edge);
+
+    /* pins that cannot interrupt refuse the write, seen on close */
+    if (fclose(fedge) != 0)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE,
+                  "GPIO%s edge %s: %s\n",
+                  port->pathname,
+                  edge,
+                  strerror(errno));
+        return -RIG_ENAVAIL;
+    }
+
+    return RIG_OK;
+}
+
+
+int gpio_set_lines(hamlib_port_t *port, unsigned int mask, unsigned int bits)
+{
+    int retval;
+
+    if (!port->parm.gpio.lines)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    if (port->parm.gpio.lines < GPIO_LINES_MAX
+            && (mask >> port->parm.gpio.lines))
+    {
+        return -RIG_EINVAL;
+    }
+
+    retval = gpio_chardev_set(port, mask, bits);
+
+    if (retval == RIG_OK && (mask & 1))
+    {
+        port->parm.gpio.value = bits & 1;
+    }
+
+    return retval;
+}
@@ -27,12 +27,17 @@
 
 __BEGIN_DECLS
 
+/* Most lines one gpiochip port can group, one bit each */
+#define GPIO_LINES_MAX 32
+
 /* Hamlib internal use, see rig.c */
 int gpio_open(hamlib_port_t *p, int output, int on_value);
 int gpio_close(hamlib_port_t *p);
 int gpio_ptt_set(hamlib_port_t *p, ptt_t pttx);
 int gpio_ptt_get(hamlib_port_t *p, ptt_t *pttx);
 int gpio_dcd_get(hamlib_port_t *p, dcd_t *dcdx);
+int gpio_edge(hamlib_port_t *p, const char *edge);
+int gpio_set_lines(hamlib_port_t *p, unsigned int mask, unsigned int bits);
 
 __END_DECLS
 
@@ -0,0 +1,568 @@
+/*
+ *  Hamlib Interface - port readiness event engine
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Lets a process that talks to several rigs (rigctld, rig multiplexers)
+ * wait for any of their ports to become readable with one kernel call,
+ * instead of one select() per port per read.  epoll is used on Linux,
+ * kqueue on the BSDs and macOS, and select() everywhere else.
+ *
+ * Ports are watched on their raw fd; the registered callback is expected
+ * to drain the data with the *_direct read functions.  rig.c reads the
+ * async data of the rigs opened with the async_shared conf this way.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+#ifdef HAVE_SYS_TIME_H
+#include <sys/time.h>
+#endif
+
+#if defined(HAVE_SYS_EPOLL_H)
+#include <sys/epoll.h>
+#define PORT_EVENT_EPOLL 1
+#elif defined(HAVE_SYS_EVENT_H)
+#include <sys/event.h>
+#define PORT_EVENT_KQUEUE 1
+#elif defined(HAVE_SYS_SELECT_H)
+#include <sys/select.h>
+#elif defined(HAVE_WINSOCK2_H)
+#include <winsock2.h>
+#endif
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "ioevent.h"
+#include "iofunc.h"
+
+struct port_event_entry
+{
+    hamlib_port_t *port;
+    int fd;
+    port_event_cb_t cb;
+    rig_ptr_t arg;
+};
+
+static struct port_event_entry entries[PORT_EVENT_MAX];
+static int nentries;
+
+#if defined(PORT_EVENT_EPOLL) || defined(PORT_EVENT_KQUEUE)
+static int pollfd = -1;
+#endif
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t port_event_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define PORT_EVENT_LOCK()   pthread_mutex_lock(&port_event_mutex)
+#define PORT_EVENT_UNLOCK() pthread_mutex_unlock(&port_event_mutex)
+
+/* the port whose callback is running, port_event_remove() waits for it */
+static pthread_cond_t port_event_done = PTHREAD_COND_INITIALIZER;
+static const hamlib_port_t *running;
+static pthread_t running_thread;
+#else
+#define PORT_EVENT_LOCK()
+#define PORT_EVENT_UNLOCK()
+#endif
+
+
+static int find_entry(const hamlib_port_t *p)
+{
+    int i;
+
+    for (i = 0; i < nentries; i++)
+    {
+        if (entries[i].port == p)
+        {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+
+#if defined(PORT_EVENT_EPOLL) || defined(PORT_EVENT_KQUEUE)
+/* must be called with the lock held */
+static int engine_init(void)
+{
+    if (pollfd >= 0)
+    {
+        return RIG_OK;
+    }
+
+#ifdef PORT_EVENT_EPOLL
+    pollfd = epoll_create1(EPOLL_CLOEXEC);
+#else
+    pollfd = kqueue();
+#endif
+
+    if (pollfd < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s failed: %s\n", __func__,
+                  port_event_engine(), strerror(errno));
+        return -RIG_EIO;
+    }
+
+    return RIG_OK;
+}
+#endif
+
+
+/* must be called with the lock held */
+static int engine_watch(int fd, int add)
+{
+#if defined(PORT_EVENT_EPOLL)
+    struct epoll_event ev;
+    int retval;
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+
+    retval = epoll_ctl(pollfd, add ? EPOLL_CTL_ADD : EPOLL_CTL_DEL, fd, &ev);
+#elif defined(PORT_EVENT_KQUEUE)
+    struct kevent ev;
+    int retval;
+
+    EV_SET(&ev, fd, EVFILT_READ, add ? EV_ADD : EV_DELETE, 0, 0, NULL);
+
+    retval = kevent(pollfd, &ev, 1, NULL, 0, NULL);
+#else
+    int retval = 0;
+
+    /* select() rebuilds its fd_set from the table on every dispatch */
+    (void)fd;
+    (void)add;
+#endif
+
+    if (retval < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s fd=%d failed: %s\n", __func__,
+                  add ? "add" : "remove", fd, strerror(errno));
+        return -RIG_EIO;
+    }
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Name of the readiness engine compiled in
+ * \return "epoll", "kqueue" or "select"
+ */
+const char *port_event_engine(void)
+{
+#if defined(PORT_EVENT_EPOLL)
+    return "epoll";
+#elif defined(PORT_EVENT_KQUEUE)
+    return "kqueue";
+#else
+    return "select";
+#endif
+}
+
+
+/**
+ * \brief Watch a port for incoming data
+ * \param p port, must be open
+ * \param cb callback run from port_event_dispatch() when \a p is readable
+ * \param arg opaque pointer handed back to \a cb
+ * \return RIG_OK or a negative error code
+ */
+int port_event_add(hamlib_port_t *p, port_event_cb_t cb, rig_ptr_t arg)
+{
+    int retval;
+
+    if (!p || !cb || p->fd < 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    PORT_EVENT_LOCK();
+
+    if (find_entry(p) >= 0)
+    {
+        PORT_EVENT_UNLOCK();
+        return -RIG_EINVAL;
+    }
+
+    if (nentries >= PORT_EVENT_MAX)
+    {
+        PORT_EVENT_UNLOCK();
+        rig_debug(RIG_DEBUG_ERR, "%s: too many ports, max=%d\n", __func__,
+                  PORT_EVENT_MAX);
+        return -RIG_ENOMEM;
+    }
+
+#if !defined(PORT_EVENT_EPOLL) && !defined(PORT_EVENT_KQUEUE)
+
+    if (p->fd >= FD_SETSIZE)
+    {
+        PORT_EVENT_UNLOCK();
+        return -RIG_EINVAL;
+    }
+
+#else
+    retval = engine_init();
+
+    if (retval != RIG_OK)
+    {
+        PORT_EVENT_UNLOCK();
+        return retval;
+    }
+
+#endif
+
+    retval = engine_watch(p->fd, 1);
+
+    if (retval == RIG_OK)
+    {
+        entries[nentries].port = p;
+        entries[nentries].fd = p->fd;
+        entries[nentries].cb = cb;
+        entries[nentries].arg = arg;
+        nentries++;
+
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: watching fd=%d with %s\n", __func__,
+                  p->fd, port_event_engine());
+    }
+
+    PORT_EVENT_UNLOCK();
+
+    return retval;
+}
+
+
+/**
+ * \brief Stop watching a port
+ * \param p port previously given to port_event_add()
+ * \return RIG_OK or a negative error code
+ *
+ * Must be called before the port is closed.  Returns once a callback
+ * running for \a p in another thread is done.
+ */
+int port_event_remove(hamlib_port_t *p)
+{
+    int i;
+
+    PORT_EVENT_LOCK();
+
+    i = find_entry(p);
+
+    if (i < 0)
+    {
+        PORT_EVENT_UNLOCK();
+        return -RIG_EINVAL;
+    }
+
+    engine_watch(entries[i].fd, 0);
+
+    nentries--;
+    entries[i] = entries[nentries];
+
+#ifdef HAVE_PTHREAD
+
+    while (running == p && !pthread_equal(running_thread, pthread_self()))
+    {
+        pthread_cond_wait(&port_event_done, &port_event_mutex);
+    }
+
+#endif
+
+    PORT_EVENT_UNLOCK();
+
+    return RIG_OK;
+}
+
+
+#if defined(PORT_EVENT_EPOLL) || defined(PORT_EVENT_KQUEUE)
+/* look up the callback for fd, must be called with the lock held */
+static int lookup_fd(int fd, struct port_event_entry *entry)
+{
+    int i;
+
+    for (i = 0; i < nentries; i++)
+    {
+        if (entries[i].fd == fd)
+        {
+            *entry = entries[i];
+            return 1;
+        }
+    }
+
+    return 0;
+}
+#endif
+
+
+/* adds entry to the ready list, or ev to its events if it is there already */
+static void ready_add(struct port_event_entry *ready, int *events, int *nready,
+                      const struct port_event_entry *entry, int ev)
+{
+    int i;
+
+    for (i = 0; i < *nready; i++)
+    {
+        if (ready[i].port == entry->port)
+        {
+            events[i] |= ev;
+            return;
+        }
+    }
+
+    ready[*nready] = *entry;
+    events[*nready] = ev;
+    (*nready)++;
+}
+
+
+/**
+ * \brief Wait for data on any watched port and run the callbacks
+ * \param timeout_ms maximum wait in milliseconds, -1 to wait forever
+ * \return number of callbacks run, 0 on timeout, or a negative error code
+ *
+ * Callbacks are run without the engine lock held, so they may call
+ * port_event_remove().  One thread dispatches at a time.
+ *
+ * A port that read_string_direct() kept bytes back for is ready without
+ * waiting: its fd will not become readable for data already read.
+ */
+int port_event_dispatch(int timeout_ms)
+{
+    struct port_event_entry ready[PORT_EVENT_MAX];
+    int events[PORT_EVENT_MAX];
+    int nready = 0;
+    int n, i;
+
+    PORT_EVENT_LOCK();
+
+    for (i = 0; i < nentries; i++)
+    {
+        if (port_rxbuf_pending(entries[i].port) > 0)
+        {
+            ready_add(ready, events, &nready, &entries[i], PORT_EVENT_READ);
+        }
+    }
+
+    PORT_EVENT_UNLOCK();
+
+    if (nready > 0)
+    {
+        timeout_ms = 0;
+    }
+
+#if defined(PORT_EVENT_EPOLL)
+    struct epoll_event evs[PORT_EVENT_MAX];
+
+    if (pollfd < 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    n = epoll_wait(pollfd, evs, PORT_EVENT_MAX, timeout_ms);
+
+    if (n < 0)
+    {
+        return errno == EINTR ? 0 : -RIG_EIO;
+    }
+
+    PORT_EVENT_LOCK();
+
+    for (i = 0; i < n; i++)
+    {
+        struct port_event_entry entry;
+        int ev = 0;
+
+        if (!lookup_fd(evs[i].data.fd, &entry))
+        {
+            continue;
+        }
+
+        if (evs[i].events & EPOLLIN)
+        {
+            ev |= PORT_EVENT_READ;
+        }
+
+        if (evs[i].events & (EPOLLERR | EPOLLHUP))
+        {
+            ev |= PORT_EVENT_ERROR;
+        }
+
+        ready_add(ready, events, &nready, &entry, ev);
+    }
+
+    PORT_EVENT_UNLOCK();
+
+#elif defined(PORT_EVENT_KQUEUE)
+    struct kevent evs[PORT_EVENT_MAX];
+    struct timespec ts, *tsp = NULL;
+
+    if (pollfd < 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (timeout_ms >= 0)
+    {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+        tsp = &ts;
+    }
+
+    n = kevent(pollfd, NULL, 0, evs, PORT_EVENT_MAX, tsp);
+
+    if (n < 0)
+    {
+        return errno == EINTR ? 0 : -RIG_EIO;
+    }
+
+    PORT_EVENT_LOCK();
+
+    for (i = 0; i < n; i++)
+    {
+        struct port_event_entry entry;
+        int ev = PORT_EVENT_READ;
+
+        if (!lookup_fd((int)evs[i].ident, &entry))
+        {
+            continue;
+        }
+
+        if (evs[i].flags & (EV_ERROR | EV_EOF))
+        {
+            ev |= PORT_EVENT_ERROR;
+        }
+
+        ready_add(ready, events, &nready, &entry, ev);
+    }
+
+    PORT_EVENT_UNLOCK();
+
+#else
+    struct port_event_entry watched[PORT_EVENT_MAX];
+    struct timeval tv, *tvp = NULL;
+    fd_set rfds, efds;
+    int nwatched;
+    int maxfd = -1;
+
+    FD_ZERO(&rfds);
+    FD_ZERO(&efds);
+
+    PORT_EVENT_LOCK();
+
+    nwatched = nentries;
+    memcpy(watched, entries, nwatched * sizeof(watched[0]));
+
+    PORT_EVENT_UNLOCK();
+
+    for (i = 0; i < nwatched; i++)
+    {
+        FD_SET(watched[i].fd, &rfds);
+        FD_SET(watched[i].fd, &efds);
+
+        if (watched[i].fd > maxfd)
+        {
+            maxfd = watched[i].fd;
+        }
+    }
+
+    if (timeout_ms >= 0)
+    {
+        tv.tv_sec = timeout_ms / 1000;
+        tv.tv_usec = (timeout_ms % 1000) * 1000;
+        tvp = &tv;
+    }
+
+    n = select(maxfd + 1, &rfds, NULL, &efds, tvp);
+
+    if (n < 0)
+    {
+        return errno == EINTR ? 0 : -RIG_EIO;
+    }
+
+    for (i = 0; i < nwatched && n > 0; i++)
+    {
+        int fd = watched[i].fd;
+        int ev;
+
+        if (!FD_ISSET(fd, &rfds) && !FD_ISSET(fd, &efds))
+        {
+            continue;
+        }
+
+        ev = FD_ISSET(fd, &rfds) ? PORT_EVENT_READ : 0;
+
+        if (FD_ISSET(fd, &efds))
+        {
+            ev |= PORT_EVENT_ERROR;
+        }
+
+        ready_add(ready, events, &nready, &watched[i], ev);
+    }
+
+#endif
+
+    for (i = 0; i < nready; i++)
+    {
+        int retval;
+
+        PORT_EVENT_LOCK();
+
+        /* removed by an earlier callback of this round */
+        if (find_entry(ready[i].port) < 0)
+        {
+            PORT_EVENT_UNLOCK();
+            continue;
+        }
+
+#ifdef HAVE_PTHREAD
+        running = ready[i].port;
+        running_thread = pthread_self();
+#endif
+        PORT_EVENT_UNLOCK();
+
+        retval = ready[i].cb(ready[i].port, events[i], ready[i].arg);
+
+#ifdef HAVE_PTHREAD
+        PORT_EVENT_LOCK();
+        running = NULL;
+        pthread_cond_broadcast(&port_event_done);
+        PORT_EVENT_UNLOCK();
+#endif
+
+        if (retval < 0)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: callback for fd=%d returned %s\n",
+                      __func__, ready[i].fd, rigerror(retval));
+        }
+    }
+
+    return nready;
+}
@@ -0,0 +1,49 @@
+/*
+ *  Hamlib Interface - port readiness event engine header
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _IOEVENT_H
+#define _IOEVENT_H 1
+
+#include <hamlib/rig.h>
+
+__BEGIN_DECLS
+
+#define PORT_EVENT_READ     (1<<0)  /* data can be read without blocking */
+#define PORT_EVENT_ERROR    (1<<1)  /* error or hangup on the fd */
+
+/* maximum number of ports one process can watch */
+#define PORT_EVENT_MAX      64
+
+/*
+ * Called from port_event_dispatch() with the events seen on the port.
+ * The callback normally does read_block_direct()/read_string_direct().
+ */
+typedef int (*port_event_cb_t)(hamlib_port_t *p, int events, rig_ptr_t arg);
+
+/* internal to the library, used by the shared async reader in rig.c */
+extern int port_event_add(hamlib_port_t *p, port_event_cb_t cb, rig_ptr_t arg);
+extern int port_event_remove(hamlib_port_t *p);
+extern int port_event_dispatch(int timeout_ms);
+extern const char *port_event_engine(void);
+
+__END_DECLS
+
+#endif /* _IOEVENT_H */
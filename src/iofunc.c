@@ -40,6 +40,7 @@
 #include <fcntl.h>   /* File control definitions */
 #include <errno.h>   /* Error number definitions */
 #include <sys/time.h>
+#include <time.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -54,10 +55,18 @@
 #include "cm108.h"
 #include "gpio.h"
 #include "asyncpipe.h"
+#include "spscring.h"
+#include "stats.h"
+#include "capture.h"
+#include "sleep.h"
+#include "rto.h"
 
 #if defined(WIN32) && defined(HAVE_WINDOWS_H)
 #include <windows.h>
 
+/* Windows keeps its async pipes, the sync rings below are POSIX only */
+#define port_sync_ring(p) ((struct spsc_ring *) NULL)
+
 static void init_sync_data_pipe(hamlib_port_t *p)
 {
     p->sync_data_pipe = NULL;
@@ -109,6 +118,97 @@ static int create_sync_data_pipe(hamlib_port_t *p)
 
 #else
 
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+
+/*
+ * The async data handler and the thread waiting for a reply share one
+ * process, so they need no fd between them: replies go through an SPSC
+ * ring (spscring.c) and the error code rides along with it.  The pipes
+ * are only made when the small table below is full.  hamlib_port_t
+ * cannot grow, so like the receive buffers further down the rings are
+ * found by port; the lookup is lock free, a slot's port is only
+ * published once its ring is there.
+ */
+#define PORT_SYNC_RING_SIZE 65536
+#define PORT_SYNC_MAX 8
+
+struct port_sync
+{
+    hamlib_port_t *p;
+    struct spsc_ring *ring;
+};
+
+static struct port_sync port_syncs[PORT_SYNC_MAX];
+static pthread_mutex_t port_sync_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static struct spsc_ring *port_sync_ring(const hamlib_port_t *p)
+{
+    int i;
+
+    for (i = 0; i < PORT_SYNC_MAX; i++)
+    {
+        if (__atomic_load_n(&port_syncs[i].p, __ATOMIC_ACQUIRE) == p)
+        {
+            return port_syncs[i].ring;
+        }
+    }
+
+    return NULL;
+}
+
+static int port_sync_attach(hamlib_port_t *p)
+{
+    int i;
+
+    pthread_mutex_lock(&port_sync_mutex);
+
+    for (i = 0; i < PORT_SYNC_MAX; i++)
+    {
+        if (port_syncs[i].p == NULL)
+        {
+            port_syncs[i].ring = spsc_ring_new(PORT_SYNC_RING_SIZE);
+
+            if (!port_syncs[i].ring)
+            {
+                break;
+            }
+
+            __atomic_store_n(&port_syncs[i].p, p, __ATOMIC_RELEASE);
+            pthread_mutex_unlock(&port_sync_mutex);
+            return 1;
+        }
+    }
+
+    pthread_mutex_unlock(&port_sync_mutex);
+
+    return 0;
+}
+
+static void port_sync_detach(hamlib_port_t *p)
+{
+    int i;
+
+    pthread_mutex_lock(&port_sync_mutex);
+
+    for (i = 0; i < PORT_SYNC_MAX; i++)
+    {
+        if (port_syncs[i].p == p)
+        {
+            __atomic_store_n(&port_syncs[i].p, NULL, __ATOMIC_RELEASE);
+            spsc_ring_free(port_syncs[i].ring);
+            port_syncs[i].ring = NULL;
+        }
+    }
+
+    pthread_mutex_unlock(&port_sync_mutex);
+}
+#else
+#define port_sync_ring(p) ((struct spsc_ring *) NULL)
+#define port_sync_attach(p) 0
+#define port_sync_detach(p)
+#endif
+
 static void init_sync_data_pipe(hamlib_port_t *p)
 {
     p->fd_sync_write = -1;
@@ -119,6 +219,8 @@ static void init_sync_data_pipe(hamlib_port_t *p)
 
 static void close_sync_data_pipe(hamlib_port_t *p)
 {
+    port_sync_detach(p);
+
     if (p->fd_sync_read != -1)
     {
         close(p->fd_sync_read);
@@ -151,6 +253,13 @@ static int create_sync_data_pipe(hamlib_port_t *p)
     int sync_pipe_fds[2];
     int flags;
 
+    if (port_sync_attach(p))
+    {
+        rig_debug(RIG_DEBUG_VERBOSE,
+                  "%s: created data ring for synchronous transactions\n", __func__);
+        return (RIG_OK);
+    }
+
     status = pipe(sync_pipe_fds);
     flags = fcntl(sync_pipe_fds[0], F_GETFL);
     flags |= O_NONBLOCK;
@@ -221,6 +330,168 @@ static int create_sync_data_pipe(hamlib_port_t *p)
 
 #endif
 
+/*
+ * Receive staging buffers for read_string_direct().  Instead of reading one
+ * byte per syscall while looking for the terminator, whatever the port has
+ * available is read in one go, scanned with memchr(), and the bytes after
+ * the terminator are kept here for the next read on the same port.
+ * hamlib_port_t cannot grow, so the buffers live in a small table keyed by
+ * port; ports that find the table full just use the unbuffered path.
+ */
+#define PORT_RXBUF_SIZE 512
+#define PORT_RXBUF_MAX  8
+
+struct port_rxbuf
+{
+    hamlib_port_t *p;
+    size_t len;
+    unsigned char data[PORT_RXBUF_SIZE];
+};
+
+static struct port_rxbuf port_rxbufs[PORT_RXBUF_MAX];
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+static pthread_mutex_t port_rxbuf_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define RXBUF_LOCK()   pthread_mutex_lock(&port_rxbuf_mutex)
+#define RXBUF_UNLOCK() pthread_mutex_unlock(&port_rxbuf_mutex)
+#else
+#define RXBUF_LOCK()
+#define RXBUF_UNLOCK()
+#endif
+
+static struct port_rxbuf *port_rxbuf_get(hamlib_port_t *p, int create)
+{
+    struct port_rxbuf *rb = NULL;
+    int i;
+
+    RXBUF_LOCK();
+
+    for (i = 0; i < PORT_RXBUF_MAX; i++)
+    {
+        if (port_rxbufs[i].p == p)
+        {
+            rb = &port_rxbufs[i];
+            break;
+        }
+
+        if (create && !rb && port_rxbufs[i].p == NULL)
+        {
+            rb = &port_rxbufs[i];
+        }
+    }
+
+    if (rb && rb->p != p)
+    {
+        rb->p = p;
+        rb->len = 0;
+    }
+
+    RXBUF_UNLOCK();
+
+    return rb;
+}
+
+/* release the staging buffer of port p, dropping any leftover bytes */
+static void port_rxbuf_release(hamlib_port_t *p)
+{
+    int i;
+
+    RXBUF_LOCK();
+
+    for (i = 0; i < PORT_RXBUF_MAX; i++)
+    {
+        if (port_rxbufs[i].p == p)
+        {
+            port_rxbufs[i].p = NULL;
+            port_rxbufs[i].len = 0;
+        }
+    }
+
+    RXBUF_UNLOCK();
+}
+
+/**
+ * \brief Drop bytes buffered by read_string_direct() but not yet returned
+ * \param p port
+ *
+ * Called by the port flush functions so a flush clears both the OS and
+ * the Hamlib receive buffer.
+ */
+void HAMLIB_API port_rxbuf_discard(hamlib_port_t *p)
+{
+    struct port_rxbuf *rb = port_rxbuf_get(p, 0);
+
+    if (rb && rb->len > 0)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: dropping %d buffered bytes\n", __func__,
+                  (int)rb->len);
+        rb->len = 0;
+    }
+}
+
+/**
+ * \brief Number of bytes buffered by read_string_direct() for the next read
+ * \param p port
+ */
+size_t HAMLIB_API port_rxbuf_pending(hamlib_port_t *p)
+{
+    struct port_rxbuf *rb = port_rxbuf_get(p, 0);
+
+    return rb ? rb->len : 0;
+}
+
+/*
+ * Move up to room bytes from the staging buffer to dst, stopping after the
+ * first byte found in stopset.  *found is set when a stop byte was copied.
+ */
+static size_t port_rxbuf_take(struct port_rxbuf *rb, unsigned char *dst,
+                              size_t room, const char *stopset, int stopset_len,
+                              int *found)
+{
+    size_t n = rb->len < room ? rb->len : room;
+    size_t i;
+
+    *found = 0;
+
+    if (stopset && stopset_len > 0)
+    {
+        const unsigned char *stop = NULL;
+
+        if (stopset_len == 1)
+        {
+            stop = memchr(rb->data, stopset[0], n);
+        }
+        else
+        {
+            for (i = 0; i < n; i++)
+            {
+                if (memchr(stopset, rb->data[i], stopset_len))
+                {
+                    stop = &rb->data[i];
+                    break;
+                }
+            }
+        }
+
+        if (stop)
+        {
+            n = stop - rb->data + 1;
+            *found = 1;
+        }
+    }
+
+    memcpy(dst, rb->data, n);
+    rb->len -= n;
+
+    if (rb->len > 0)
+    {
+        memmove(rb->data, rb->data + n, rb->len);
+    }
+
+    return n;
+}
+
 /**
  * \brief Open a hamlib_port based on its rig port type
  * \param p rig port descriptor
@@ -233,6 +504,7 @@ int HAMLIB_API port_open(hamlib_port_t *p)
 
     p->fd = -1;
     init_sync_data_pipe(p);
+    port_rxbuf_release(p);
 
     if (p->asyncio)
     {
@@ -380,6 +652,9 @@ int HAMLIB_API port_close(hamlib_port_t *p, rig_port_t port_type)
 {
     int ret = RIG_OK;
 
+    port_rxbuf_release(p);
+    port_writer_stop(p);
+
     if (p->fd != -1)
     {
         switch (port_type)
@@ -791,6 +1066,11 @@ int HAMLIB_API write_block_sync_error(hamlib_port_t *p,
     return async_pipe_write(p->sync_data_error_pipe, txbuffer, count, p->timeout);
 }
 
+int HAMLIB_API port_sync_discard(hamlib_port_t *p)
+{
+    return -RIG_ENIMPL;
+}
+
 #else
 
 /* POSIX */
@@ -799,6 +1079,20 @@ static ssize_t port_read_generic(hamlib_port_t *p, void *buf, size_t count,
                                  int direct)
 {
     int fd = direct ? p->fd : p->fd_sync_read;
+    struct spsc_ring *ring = direct ? NULL : port_sync_ring(p);
+
+    if (ring)
+    {
+        size_t n = spsc_ring_read(ring, buf, count);
+
+        if (n == 0)
+        {
+            errno = EAGAIN;
+            return -1;
+        }
+
+        return (ssize_t) n;
+    }
 
     if (p->type.rig == RIG_PORT_SERIAL && p->parm.serial.data_bits == 7)
     {
@@ -889,6 +1183,28 @@ static int port_wait_for_data(hamlib_port_t *p, int direct)
     int fd, errorfd, maxfd;
     struct timeval tv, tv_timeout;
     int result;
+    struct spsc_ring *ring = direct ? NULL : port_sync_ring(p);
+
+    if (ring)
+    {
+        int code;
+
+        result = spsc_ring_wait(ring, p->timeout);
+
+        if (result < 0)
+        {
+            return result;
+        }
+
+        if (spsc_ring_get_error(ring, &code))
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s(): returning error code %d\n", __func__,
+                      code);
+            return code;
+        }
+
+        return RIG_OK;
+    }
 
     fd = direct ? p->fd : p->fd_sync_read;
     errorfd = direct ? -1 : p->fd_sync_error_read;
@@ -955,25 +1271,445 @@ int HAMLIB_API write_block_sync(hamlib_port_t *p, const unsigned char *txbuffer,
                                 size_t count)
 {
 
+    struct spsc_ring *ring;
+
     if (!p->asyncio)
     {
         return -RIG_EINTERNAL;
     }
 
+    if ((ring = port_sync_ring(p)))
+    {
+        int ret = spsc_ring_write(ring, txbuffer, count);
+
+        return ret < 0 ? ret : (int) count;
+    }
+
     return (int) write(p->fd_sync_write, txbuffer, count);
 }
 
 int HAMLIB_API write_block_sync_error(hamlib_port_t *p,
                                       const unsigned char *txbuffer, size_t count)
 {
+    struct spsc_ring *ring;
+
     if (!p->asyncio)
     {
         return -RIG_EINTERNAL;
     }
 
+    // the reader only ever wants the latest code
+    if ((ring = port_sync_ring(p)) && count > 0)
+    {
+        spsc_ring_put_error(ring, (signed char) txbuffer[count - 1]);
+        return (int) count;
+    }
+
     return (int) write(p->fd_sync_error_write, txbuffer, count);
 }
 
+/**
+ * \brief Drop reply bytes the async reader has queued but nobody read
+ * \param p port with asyncio set
+ * \return number of bytes dropped, or a negative error code
+ *
+ * The async reader thread owns the fd and has already handed the
+ * unsolicited frames to the async data handler, so what is left here is
+ * only stale replies.  Never blocks.
+ */
+int HAMLIB_API port_sync_discard(hamlib_port_t *p)
+{
+    struct spsc_ring *ring;
+    unsigned char buf[256];
+    int total = 0;
+    int code;
+    ssize_t n;
+
+    if (!p->asyncio)
+    {
+        return -RIG_EINTERNAL;
+    }
+
+    if ((ring = port_sync_ring(p)))
+    {
+        while ((n = spsc_ring_read(ring, buf, sizeof(buf))) > 0)
+        {
+            total += n;
+        }
+
+        // nor a stale error code meant for an earlier transaction
+        spsc_ring_get_error(ring, &code);
+
+        return total;
+    }
+
+    while ((n = read(p->fd_sync_read, buf, sizeof(buf))) > 0)
+    {
+        total += n;
+    }
+
+    while (read(p->fd_sync_error_read, buf, sizeof(buf)) > 0)
+    {
+    }
+
+    return total;
+}
+
+#endif
+
+/* port_read_generic, with what the rig sent recorded if capturing */
+static ssize_t port_read_capture(hamlib_port_t *p, void *buf, size_t count,
+                                 int direct)
+{
+    ssize_t n = port_read_generic(p, buf, count, direct);
+
+    if (direct && n > 0) { capture_io(p, CAPTURE_READ, buf, n); }
+
+    return n;
+}
+
+/*
+ * Minimum gap between the start of a write and the end of the previous
+ * one on port p, in ms.  A per-char write_delay also spaces commands.
+ */
+static int port_write_gap(const hamlib_port_t *p)
+{
+    return p->post_write_delay > p->write_delay ?
+           p->post_write_delay : p->write_delay;
+}
+
+static void port_pace_write(const hamlib_port_t *p)
+{
+    struct timespec deadline, now;
+    int gap = port_write_gap(p);
+
+    if (gap <= 0 || (p->post_write_date.tv_sec == 0
+                     && p->post_write_date.tv_usec == 0))
+    {
+        return;
+    }
+
+    deadline.tv_sec = p->post_write_date.tv_sec + gap / 1000;
+    deadline.tv_nsec = (p->post_write_date.tv_usec + (gap % 1000) * 1000L)
+                       * 1000L;
+
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (now.tv_sec > deadline.tv_sec
+            || (now.tv_sec == deadline.tv_sec && now.tv_nsec >= deadline.tv_nsec))
+    {
+        return;
+    }
+
+    hl_sleep_until(&deadline);
+}
+
+/* post_write_date holds the monotonic time of the last write */
+static void port_mark_write(hamlib_port_t *p)
+{
+    struct timespec now;
+
+    if (port_write_gap(p) <= 0) { return; }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    p->post_write_date.tv_sec = (int)now.tv_sec;
+    p->post_write_date.tv_usec = (int)(now.tv_nsec / 1000);
+}
+
+/*
+ * Paced writer threads.  With write_delay set, write_block() used to send
+ * one byte per write_delay ms from the caller's thread, so a 40 byte
+ * memory write to an old rig held the caller (and every rigctld client
+ * behind it) for two seconds.  A port with a writer thread instead queues
+ * the command and returns; the thread sends the bytes on an absolute
+ * deadline per byte so the pacing does not drift.  Reads on the port wait
+ * for the queue to empty before their timeout starts, which keeps command
+ * and reply in order.  Like the rx buffers the state lives in a small
+ * table keyed by port since hamlib_port_t cannot grow.
+ */
+#ifdef HAVE_PTHREAD
+#define PORT_WRITER_MAX   4
+#define PORT_WRITER_QLEN  16
+#define PORT_WRITER_CMD   256
+
+struct port_writer
+{
+    hamlib_port_t *p;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int head;
+    int count;          /* queued commands, including the one being sent */
+    int stop;
+    int error;          /* first failed write, reported to the next caller */
+    struct
+    {
+        size_t len;
+        unsigned char data[PORT_WRITER_CMD];
+    } q[PORT_WRITER_QLEN];
+};
+
+static struct port_writer *port_writers[PORT_WRITER_MAX];
+
+static struct port_writer *port_writer_get(const hamlib_port_t *p)
+{
+    struct port_writer *w = NULL;
+    int i;
+
+    RXBUF_LOCK();
+
+    for (i = 0; i < PORT_WRITER_MAX; i++)
+    {
+        if (port_writers[i] && port_writers[i]->p == p)
+        {
+            w = port_writers[i];
+            break;
+        }
+    }
+
+    RXBUF_UNLOCK();
+
+    return w;
+}
+
+static void timespec_add_ms(struct timespec *t, int ms)
+{
+    t->tv_sec += ms / 1000;
+    t->tv_nsec += (ms % 1000) * 1000000L;
+
+    if (t->tv_nsec >= 1000000000L)
+    {
+        t->tv_sec++;
+        t->tv_nsec -= 1000000000L;
+    }
+}
+
+static void *port_writer_thread(void *arg)
+{
+    struct port_writer *w = arg;
+    hamlib_port_t *p = w->p;
+
+    pthread_mutex_lock(&w->mutex);
+
+    for (;;)
+    {
+        struct timespec deadline;
+        size_t i, len;
+        int ret = RIG_OK;
+
+        while (w->count == 0 && !w->stop)
+        {
+            pthread_cond_wait(&w->cond, &w->mutex);
+        }
+
+        if (w->count == 0) { break; }
+
+        len = w->q[w->head].len;
+        pthread_mutex_unlock(&w->mutex);
+
+        /* the slot at head is ours until count drops */
+        port_pace_write(p);
+        clock_gettime(CLOCK_MONOTONIC, &deadline);
+
+        for (i = 0; i < len; i++)
+        {
+            if (i > 0)
+            {
+                timespec_add_ms(&deadline, p->write_delay);
+                hl_sleep_until(&deadline);
+            }
+
+            if (port_write(p, w->q[w->head].data + i, 1) != 1)
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: write failed - %s\n", __func__,
+                          strerror(errno));
+                ret = -RIG_EIO;
+                break;
+            }
+        }
+
+        port_mark_write(p);
+
+        pthread_mutex_lock(&w->mutex);
+
+        if (ret != RIG_OK && w->error == RIG_OK) { w->error = ret; }
+
+        w->head = (w->head + 1) % PORT_WRITER_QLEN;
+        w->count--;
+        pthread_cond_broadcast(&w->cond);
+    }
+
+    pthread_mutex_unlock(&w->mutex);
+
+    return NULL;
+}
+
+/* queue one command, waiting for a free slot; returns a pending error */
+static int port_writer_queue(struct port_writer *w,
+                             const unsigned char *txbuffer, size_t count)
+{
+    int ret;
+
+    pthread_mutex_lock(&w->mutex);
+
+    while (w->count == PORT_WRITER_QLEN)
+    {
+        pthread_cond_wait(&w->cond, &w->mutex);
+    }
+
+    ret = w->error;
+    w->error = RIG_OK;
+
+    if (ret == RIG_OK)
+    {
+        int tail = (w->head + w->count) % PORT_WRITER_QLEN;
+
+        memcpy(w->q[tail].data, txbuffer, count);
+        w->q[tail].len = count;
+        w->count++;
+        pthread_cond_broadcast(&w->cond);
+    }
+
+    pthread_mutex_unlock(&w->mutex);
+
+    return ret;
+}
+
+/* wait until everything queued on p is on the wire */
+static int port_writer_drain(const hamlib_port_t *p)
+{
+    struct port_writer *w = port_writer_get(p);
+    int ret;
+
+    if (!w) { return RIG_OK; }
+
+    pthread_mutex_lock(&w->mutex);
+
+    while (w->count > 0)
+    {
+        pthread_cond_wait(&w->cond, &w->mutex);
+    }
+
+    ret = w->error;
+    w->error = RIG_OK;
+    pthread_mutex_unlock(&w->mutex);
+
+    return ret;
+}
+
+/**
+ * \brief Send the paced output of a port from a thread of its own
+ * \param p rig port descriptor, already open
+ * \return RIG_OK or < 0 error
+ *
+ * Only useful when write_delay is set: write_block() then queues the
+ * command and returns instead of sleeping between bytes.
+ * port_close() stops the thread once the queue is sent.
+ */
+int HAMLIB_API port_writer_start(hamlib_port_t *p)
+{
+    struct port_writer *w;
+    int i, slot = -1;
+
+    if (p->fd < 0 || p->write_delay <= 0) { return -RIG_EINVAL; }
+
+    if (port_writer_get(p)) { return RIG_OK; }
+
+    w = calloc(1, sizeof(*w));
+
+    if (!w) { return -RIG_ENOMEM; }
+
+    w->p = p;
+    pthread_mutex_init(&w->mutex, NULL);
+    pthread_cond_init(&w->cond, NULL);
+
+    RXBUF_LOCK();
+
+    for (i = 0; i < PORT_WRITER_MAX; i++)
+    {
+        if (port_writers[i] == NULL)
+        {
+            slot = i;
+            port_writers[i] = w;
+            break;
+        }
+    }
+
+    RXBUF_UNLOCK();
+
+    if (slot < 0 || pthread_create(&w->thread, NULL, port_writer_thread, w))
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: no writer thread, writing inline\n",
+                  __func__);
+
+        if (slot >= 0)
+        {
+            RXBUF_LOCK();
+            port_writers[slot] = NULL;
+            RXBUF_UNLOCK();
+        }
+
+        pthread_cond_destroy(&w->cond);
+        pthread_mutex_destroy(&w->mutex);
+        free(w);
+        return -RIG_EINTERNAL;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: paced writer started, %d ms/char\n",
+              __func__, p->write_delay);
+
+    return RIG_OK;
+}
+
+/**
+ * \brief Send what is queued and stop the writer thread of a port
+ * \param p rig port descriptor
+ */
+void HAMLIB_API port_writer_stop(hamlib_port_t *p)
+{
+    struct port_writer *w = port_writer_get(p);
+    int i;
+
+    if (!w) { return; }
+
+    pthread_mutex_lock(&w->mutex);
+    w->stop = 1;
+    pthread_cond_broadcast(&w->cond);
+    pthread_mutex_unlock(&w->mutex);
+
+    pthread_join(w->thread, NULL);
+
+    RXBUF_LOCK();
+
+    for (i = 0; i < PORT_WRITER_MAX; i++)
+    {
+        if (port_writers[i] == w) { port_writers[i] = NULL; }
+    }
+
+    RXBUF_UNLOCK();
+
+    pthread_cond_destroy(&w->cond);
+    pthread_mutex_destroy(&w->mutex);
+    free(w);
+}
+#else
+#define port_writer_get(p) NULL
+#define port_writer_drain(p) RIG_OK
+
+int HAMLIB_API port_writer_start(hamlib_port_t *p)
+{
+    return -RIG_ENIMPL;
+}
+
+void HAMLIB_API port_writer_stop(hamlib_port_t *p)
+{
+}
 #endif
 
 /**
@@ -991,6 +1727,9 @@ int HAMLIB_API write_block_sync_error(hamlib_port_t *p,
  *
  * Also, post_write_delay is for some Yaesu rigs (eg: FT747) that
  * get confused with sequential fast writes between cmd sequences.
+ * Rather than sleeping after every write, the next write waits until
+ * that much time has passed since the previous one, so a command that
+ * follows a read of the rig's answer usually does not wait at all.
  *
  * input:
  *
@@ -999,7 +1738,7 @@ int HAMLIB_API write_block_sync_error(hamlib_port_t *p,
  * count - count of byte to send from the txbuffer
  * write_delay - write delay in ms between 2 chars
  * post_write_delay - minimum delay between two writes
- * post_write_date - timeval of last write
+ * post_write_date - CLOCK_MONOTONIC time of last write
  *
  * Actually, this function has nothing specific to serial comm,
  * it could work very well also with any file handle, like a socket.
@@ -1017,32 +1756,38 @@ int HAMLIB_API write_block(hamlib_port_t *p, const unsigned char *txbuffer,
         return (-RIG_EIO);
     }
 
-#ifdef WANT_NON_ACTIVE_POST_WRITE_DELAY
+    port_rto_command(p, txbuffer, count);
 
-    if (p->post_write_date.tv_sec != 0)
-    {
-        signed int date_delay;    /* in us */
-        struct timeval tv;
+#ifdef HAVE_PTHREAD
 
-        /* FIXME in Y2038 ... */
-        gettimeofday(&tv, NULL);
-        date_delay = p->post_write_delay * 1000 -
-                     ((tv.tv_sec - p->post_write_date.tv_sec) * 1000000 +
-                      (tv.tv_usec - p->post_write_date.tv_usec));
+    if (p->write_delay > 0 && count <= PORT_WRITER_CMD)
+    {
+        struct port_writer *w = port_writer_get(p);
 
-        if (date_delay > 0)
+        if (w)
         {
-            /*
-             * optional delay after last write
-             */
-            hl_sleep(date_delay);
-        }
+            ret = port_writer_queue(w, txbuffer, count);
 
-        p->post_write_date.tv_sec = 0;
+            if (ret != RIG_OK) { return ret; }
+
+            rig_debug(RIG_DEBUG_TRACE, "%s(): TX %d bytes, queued\n", __func__,
+                      (int)count);
+            dump_hex((unsigned char *) txbuffer, count);
+            rig_stats_io(p, 0, (int)count);
+            capture_io(p, CAPTURE_WRITE, txbuffer, count);
+            return RIG_OK;
+        }
     }
 
+    /* anything else has to go out after what is already queued */
+    ret = port_writer_drain(p);
+
+    if (ret != RIG_OK) { return ret; }
+
 #endif
 
+    port_pace_write(p);
+
     if (p->write_delay > 0)
     {
         int i;
@@ -1064,7 +1809,7 @@ int HAMLIB_API write_block(hamlib_port_t *p, const unsigned char *txbuffer,
                 return -RIG_EIO;
             }
 
-            if (p->write_delay > 0) { hl_usleep(p->write_delay * 1000); }
+            if (i + 1 < count) { hl_usleep(p->write_delay * 1000); }
         }
     }
     else
@@ -1088,27 +1833,10 @@ int HAMLIB_API write_block(hamlib_port_t *p, const unsigned char *txbuffer,
     rig_debug(RIG_DEBUG_TRACE, "%s(): TX %d bytes, method=%d\n", __func__,
               (int)count, method);
     dump_hex((unsigned char *) txbuffer, count);
+    rig_stats_io(p, 0, (int)count);
+    capture_io(p, CAPTURE_WRITE, txbuffer, count);
 
-    if (p->post_write_delay > 0)
-    {
-        method |= 4;
-#ifdef WANT_NON_ACTIVE_POST_WRITE_DELAY
-#define POST_WRITE_DELAY_TRSHLD 10
-
-        if (p->post_write_delay > POST_WRITE_DELAY_TRSHLD)
-        {
-            struct timeval tv;
-            gettimeofday(&tv, NULL);
-            p->post_write_date.tv_sec = tv.tv_sec;
-            p->post_write_date.tv_usec = tv.tv_usec;
-        }
-        else
-#endif
-            hl_usleep(p->post_write_delay * 1000); /* optional delay after last write */
-
-        /* otherwise some yaesu rigs get confused */
-        /* with sequential fast writes*/
-    }
+    port_mark_write(p);
 
     return RIG_OK;
 }
@@ -1118,6 +1846,7 @@ static int read_block_generic(hamlib_port_t *p, unsigned char *rxbuffer,
 {
     struct timeval start_time, end_time, elapsed_time;
     int total_count = 0;
+    struct spsc_ring *ring = direct ? NULL : port_sync_ring(p);
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called, direct=%d\n", __func__, direct);
 
@@ -1126,15 +1855,44 @@ static int read_block_generic(hamlib_port_t *p, unsigned char *rxbuffer,
         return -RIG_EINTERNAL;
     }
 
+    /* the timeout runs from when the command has actually gone out */
+    if (port_writer_drain(p) != RIG_OK)
+    {
+        return -RIG_EIO;
+    }
+
     /* Store the time of the read loop start */
     gettimeofday(&start_time, NULL);
 
+    if (direct)
+    {
+        struct port_rxbuf *rb = port_rxbuf_get(p, 0);
+
+        if (rb && rb->len > 0)
+        {
+            int found;
+            size_t n = port_rxbuf_take(rb, rxbuffer, count, NULL, 0, &found);
+
+            total_count += n;
+            count -= n;
+        }
+    }
+
     while (count > 0)
     {
         int result;
         int rd_count;
 
-        result = port_wait_for_data(p, direct);
+        if (ring)
+        {
+            // the async reader thread copies the bytes straight into rxbuffer
+            result = spsc_ring_read_direct(ring, rxbuffer + total_count, count, NULL, 0,
+                                           p->timeout);
+        }
+        else
+        {
+            result = port_wait_for_data(p, direct);
+        }
 
         if (result == -RIG_ETIMEOUT)
         {
@@ -1147,6 +1905,7 @@ static int read_block_generic(hamlib_port_t *p, unsigned char *rxbuffer,
                 dump_hex((unsigned char *) rxbuffer, total_count);
             }
 
+            rig_stats_timeout(p);
             rig_debug(RIG_DEBUG_WARN,
                       "%s(): Timed out %d.%d seconds after %d chars, direct=%d\n",
                       __func__,
@@ -1174,9 +1933,18 @@ static int read_block_generic(hamlib_port_t *p, unsigned char *rxbuffer,
          * grab bytes from the rig
          * The file descriptor must have been set up non blocking.
          */
-        rd_count = (int) port_read_generic(p, rxbuffer + total_count, count, direct);
+        if (ring)
+        {
+            rd_count = result;
+        }
+        else
+        {
+            rd_count = (int) port_read_capture(p, rxbuffer + total_count, count, direct);
+        }
 
-        if (rd_count < 0)
+        /* a readable socket giving 0 bytes has been closed by the peer */
+        if (rd_count < 0 || (rd_count == 0 && direct
+                             && p->type.rig == RIG_PORT_NETWORK))
         {
             rig_debug(RIG_DEBUG_ERR, "%s(): read failed, direct=%d - %s\n", __func__,
                       direct, strerror(errno));
@@ -1189,6 +1957,7 @@ static int read_block_generic(hamlib_port_t *p, unsigned char *rxbuffer,
 
     if (direct)
     {
+        rig_stats_io(p, total_count, 0);
         rig_debug(RIG_DEBUG_TRACE, "%s(): RX %d bytes, direct=%d\n", __func__,
                   total_count, direct);
         dump_hex((unsigned char *) rxbuffer, total_count);
@@ -1219,7 +1988,24 @@ static int read_block_generic(hamlib_port_t *p, unsigned char *rxbuffer,
 int HAMLIB_API read_block(hamlib_port_t *p, unsigned char *rxbuffer,
                           size_t count)
 {
-    return read_block_generic(p, rxbuffer, count, !p->asyncio);
+    struct timespec start;
+    int left = rig_get_deadline();
+    int timeout;
+    int ret;
+
+    if (left == 0)
+    {
+        return -RIG_ETIMEOUT;
+    }
+
+    timeout = port_rto_begin(p, &start);
+
+    if (left > 0 && left < p->timeout) { p->timeout = left; }
+
+    ret = read_block_generic(p, rxbuffer, count, !p->asyncio);
+    port_rto_end(p, timeout, &start, ret);
+
+    return ret;
 }
 
 /**
@@ -1256,6 +2042,9 @@ static int read_string_generic(hamlib_port_t *p,
                                int direct)
 {
     struct timeval start_time, end_time, elapsed_time;
+    struct port_rxbuf *rb = NULL;
+    struct spsc_ring *ring = NULL;
+    int rb_fill = 0;
     int total_count = 0;
     int i = 0;
     static int minlen = 1; // dynamic minimum length of rig response data
@@ -1281,17 +2070,58 @@ static int read_string_generic(hamlib_port_t *p,
         return 0;
     }
 
+    /* the timeout runs from when the command has actually gone out */
+    if (port_writer_drain(p) != RIG_OK)
+    {
+        return -RIG_EIO;
+    }
+
     /* Store the time of the read loop start */
     gettimeofday(&start_time, NULL);
 
     memset(rxbuffer, 0, rxmax);
 
+    if (direct && p->type.rig != RIG_PORT_UDP_NETWORK)
+    {
+        // datagrams cannot be split across reads, so UDP stays unbuffered
+        // without a stopset there is nothing to scan for, so only drain
+        rb_fill = stopset && stopset_len > 0;
+        rb = port_rxbuf_get(p, rb_fill);
+    }
+    else if (!direct)
+    {
+        ring = port_sync_ring(p);
+    }
+
     while (total_count < rxmax - 1) // allow 1 byte for end-of-string
     {
         ssize_t rd_count = 0;
         int result;
 
-        result = port_wait_for_data(p, direct);
+        if (rb && rb->len > 0)
+        {
+            int found;
+
+            if (total_count == 0 && rb->data[0] == '\\') { rxmax = (rxmax - 1) * 5; }
+
+            total_count += port_rxbuf_take(rb, &rxbuffer[total_count],
+                                           rxmax - 1 - total_count, stopset, stopset_len, &found);
+
+            if (found) { break; }
+
+            continue;
+        }
+
+        if (ring)
+        {
+            // the async reader thread copies the reply straight into rxbuffer
+            result = spsc_ring_read_direct(ring, &rxbuffer[total_count],
+                                           rxmax - 1 - total_count, stopset, stopset_len, p->timeout);
+        }
+        else
+        {
+            result = port_wait_for_data(p, direct);
+        }
 
         if (result == -RIG_ETIMEOUT)
         {
@@ -1309,6 +2139,7 @@ static int read_string_generic(hamlib_port_t *p,
 
                 if (!flush_flag)
                 {
+                    rig_stats_timeout(p);
                     rig_debug(RIG_DEBUG_WARN,
                               "%s(): Timed out %d.%03d seconds after %d chars, direct=%d\n",
                               __func__,
@@ -1340,20 +2171,34 @@ static int read_string_generic(hamlib_port_t *p,
          * read 1 character from the rig, (check if in stop set)
          * The file descriptor must have been set up non blocking.
          */
-        do
+        if (ring)
         {
-            rd_count = port_read_generic(p, &rxbuffer[total_count],
-                                         expected_len == 1 ? 1 : minlen, direct);
-            minlen -= rd_count;
-
-            if (errno == EAGAIN)
+            rd_count = result;
+        }
+        else
+        {
+            do
             {
-                hl_usleep(5 * 1000);
-                rig_debug(RIG_DEBUG_WARN, "%s: port_read is busy? direct=%d\n", __func__,
-                          direct);
+                if (rb && rb_fill)
+                {
+                    rd_count = port_read_capture(p, rb->data, PORT_RXBUF_SIZE, direct);
+                }
+                else
+                {
+                    rd_count = port_read_capture(p, &rxbuffer[total_count],
+                                                 expected_len == 1 ? 1 : minlen, direct);
+                    minlen -= rd_count;
+                }
+
+                if (errno == EAGAIN)
+                {
+                    hl_usleep(5 * 1000);
+                    rig_debug(RIG_DEBUG_WARN, "%s: port_read is busy? direct=%d\n", __func__,
+                              direct);
+                }
             }
+            while (++i < 10 && errno == EBUSY);   // 50ms should be enough
         }
-        while (++i < 10 && errno == EBUSY);   // 50ms should be enough
 
         /* if we get 0 bytes or an error something is wrong */
         if (rd_count <= 0)
@@ -1369,6 +2214,12 @@ static int read_string_generic(hamlib_port_t *p,
             return -RIG_EIO;
         }
 
+        if (rb && rb_fill)
+        {
+            rb->len = rd_count;
+            continue;
+        }
+
         // check to see if our string startis with \...if so we need more chars
         if (total_count == 0 && rxbuffer[total_count] == '\\') { rxmax = (rxmax - 1) * 5; }
 
@@ -1396,6 +2247,7 @@ static int read_string_generic(hamlib_port_t *p,
 
     if (direct)
     {
+        rig_stats_io(p, total_count, 0);
         rig_debug(RIG_DEBUG_TRACE,
                   "%s(): RX %d characters, direct=%d\n",
                   __func__,
@@ -1441,8 +2293,32 @@ int HAMLIB_API read_string(hamlib_port_t *p,
                            int flush_flag,
                            int expected_len)
 {
-    return read_string_generic(p, rxbuffer, rxmax, stopset, stopset_len, flush_flag,
-                               expected_len, !p->asyncio);
+    struct timespec start;
+    int left;
+    int timeout;
+    int ret;
+
+    if (flush_flag)
+    {
+        return read_string_generic(p, rxbuffer, rxmax, stopset, stopset_len,
+                                   flush_flag, expected_len, !p->asyncio);
+    }
+
+    // the caller's deadline, see rig_set_deadline()
+    if ((left = rig_get_deadline()) == 0)
+    {
+        return -RIG_ETIMEOUT;
+    }
+
+    timeout = port_rto_begin(p, &start);
+
+    if (left > 0 && left < p->timeout) { p->timeout = left; }
+
+    ret = read_string_generic(p, rxbuffer, rxmax, stopset, stopset_len, flush_flag,
+                              expected_len, !p->asyncio);
+    port_rto_end(p, timeout, &start, ret);
+
+    return ret;
 }
 
 
@@ -65,4 +65,11 @@ extern HAMLIB_EXPORT(int) read_string_direct(hamlib_port_t *p,
                                              int flush_flag,
                                              int expected_len);
 
+extern HAMLIB_EXPORT(void) port_rxbuf_discard(hamlib_port_t *p);
+extern HAMLIB_EXPORT(size_t) port_rxbuf_pending(hamlib_port_t *p);
+extern HAMLIB_EXPORT(int) port_sync_discard(hamlib_port_t *p);
+
+extern HAMLIB_EXPORT(int) port_writer_start(hamlib_port_t *p);
+extern HAMLIB_EXPORT(void) port_writer_stop(hamlib_port_t *p);
+
 #endif /* _IOFUNC_H */
@@ -0,0 +1,693 @@
+/*
+ *  Hamlib Interface - rig state journal
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The journal_file conf names a file rig_open() maps and rig_close()
+ * unmaps.  rig_cache_write_end() compares the cache with what was last
+ * journalled and appends a record per change, while it is still the only
+ * cache writer; DCD, which the cache does not keep, takes the same lock
+ * from rig_fire_dcd_event().  So there is one writer per process and an
+ * append is a few stores into the mapping, no system call.  See
+ * hamlib/rig_journal.h for the layout.
+ *
+ * The head counter is still bumped atomically and every record carries
+ * its number, so readers in other processes -- and a second owner of the
+ * same file, should anybody do that -- never take a half written record.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#if defined(HAVE_SYS_MMAN_H) && !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define JOURNAL_SUPPORTED 1
+#endif
+
+#include <hamlib/rig.h>
+#include <hamlib/rig_journal.h>
+
+#include "journal.h"
+#include "cache.h"
+#include "misc.h"
+
+#if defined(__GNUC__)
+#define JRN_LOAD(p)          __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define JRN_STORE(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define JRN_FETCH_ADD(p, v)  __atomic_fetch_add((p), (v), __ATOMIC_ACQ_REL)
+#define JRN_FENCE_RELEASE()  __atomic_thread_fence(__ATOMIC_RELEASE)
+#define JRN_FENCE_ACQUIRE()  __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+#define JRN_LOAD(p)          (*(p))
+#define JRN_STORE(p, v)      (*(p) = (v))
+#define JRN_FETCH_ADD(p, v)  ((*(p) += (v)) - (v))
+#define JRN_FENCE_RELEASE()
+#define JRN_FENCE_ACQUIRE()
+#endif
+
+#define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+#define JOURNAL_MIN_SIZE 1024
+#define JOURNAL_MAX_SIZE (16 * 1024 * 1024)
+
+/* the cache slots journalled, see rig_journal.h */
+enum
+{
+    JRN_MAIN_A, JRN_MAIN_B, JRN_MAIN_C, JRN_SUB_A, JRN_SUB_B, JRN_SUB_C, JRN_VFOS
+};
+
+struct jrn_last
+{
+    int set;
+    int64_t i;
+    double f;
+};
+
+struct jrn_vfo
+{
+    struct jrn_last freq;
+    struct jrn_last mode;
+    struct jrn_last width;
+};
+
+struct jrn_map
+{
+    struct rig_journal_header *hdr;
+    size_t len;
+};
+
+struct journal
+{
+    char path[HAMLIB_FILPATHLEN];
+    int size;
+    struct jrn_map m;
+    /* what was journalled last, only touched by the cache writer */
+    struct jrn_vfo vfos[JRN_VFOS];
+    struct jrn_last ptt;
+    struct jrn_last split;
+    struct jrn_last vfo;
+    struct jrn_last dcd;
+    vfo_t dcd_vfo;
+};
+
+struct rig_journal
+{
+    struct jrn_map m;
+};
+
+
+static struct journal *journal_get(RIG *rig)
+{
+    struct journal *j = rig->state.journal;
+
+    if (!j)
+    {
+        j = calloc(1, sizeof(*j));
+
+        if (!j)
+        {
+            return NULL;
+        }
+
+        j->size = JOURNAL_DEFAULT_SIZE;
+        rig->state.journal = j;
+    }
+
+    return j;
+}
+
+int rig_journal_set_path(RIG *rig, const char *path)
+{
+    struct journal *j = rig->state.journal;
+
+    if (!path || !*path)
+    {
+        if (j) { j->path[0] = '\0'; }
+
+        return RIG_OK;
+    }
+
+    if (strlen(path) >= sizeof(j->path))
+    {
+        return -RIG_EINVAL;
+    }
+
+#ifndef JOURNAL_SUPPORTED
+    return -RIG_ENIMPL;
+#else
+    j = journal_get(rig);
+
+    if (!j)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    strcpy(j->path, path);
+
+    return RIG_OK;
+#endif
+}
+
+const char *rig_journal_get_path(RIG *rig)
+{
+    const struct journal *j = rig->state.journal;
+
+    return j ? j->path : "";
+}
+
+int rig_journal_set_size(RIG *rig, int records)
+{
+    struct journal *j;
+
+    if (records < JOURNAL_MIN_SIZE || records > JOURNAL_MAX_SIZE)
+    {
+        return -RIG_EINVAL;
+    }
+
+    j = journal_get(rig);
+
+    if (!j)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    j->size = records;
+
+    return RIG_OK;
+}
+
+int rig_journal_get_size(RIG *rig)
+{
+    const struct journal *j = rig->state.journal;
+
+    return j ? j->size : JOURNAL_DEFAULT_SIZE;
+}
+
+static int64_t jrn_now_ms(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static struct rig_journal_record *jrn_slots(const struct rig_journal_header *hdr)
+{
+    return (struct rig_journal_record *)((char *)hdr + hdr->header_size);
+}
+
+static void jrn_append(struct rig_journal_header *hdr, int64_t ms, vfo_t vfo,
+                       int field, int64_t i, double f)
+{
+    uint64_t n = JRN_FETCH_ADD(&hdr->head, 1);
+    struct rig_journal_record *r = &jrn_slots(hdr)[n % hdr->capacity];
+
+    JRN_STORE(&r->seq, 0);
+    JRN_FENCE_RELEASE();
+
+    r->ms = ms;
+    r->vfo = vfo;
+    r->field = field;
+    r->reserved = 0;
+
+    if (field == RIG_JOURNAL_FREQ) { r->value.f = f; }
+    else { r->value.i = i; }
+
+    JRN_STORE(&r->seq, (uint32_t)(n + 1));
+}
+
+/*
+ * Append a record if the value differs from the last one journalled.
+ * *ms is taken on the first change of an update and shared by the rest.
+ */
+static void jrn_note(struct journal *j, struct jrn_last *last, int64_t *ms,
+                     vfo_t vfo, int field, int64_t i, double f)
+{
+    if (last->set && last->i == i && last->f == f)
+    {
+        return;
+    }
+
+    last->set = 1;
+    last->i = i;
+    last->f = f;
+
+    if (*ms == 0) { *ms = jrn_now_ms(); }
+
+    jrn_append(j->m.hdr, *ms, vfo, field, i, f);
+}
+
+static void jrn_vfo(RIG *rig, struct journal *j, struct jrn_vfo *v, int64_t *ms,
+                    vfo_t vfo, freq_t freq, rmode_t mode, pbwidth_t width,
+                    const struct timespec *time_freq,
+                    const struct timespec *time_mode,
+                    const struct timespec *time_width)
+{
+    // a frequency of 0 or no mode is how the cache invalidates an entry
+    if (!rig_cache_stale(rig, time_freq) && freq != 0)
+    {
+        jrn_note(j, &v->freq, ms, vfo, RIG_JOURNAL_FREQ, 0, freq);
+    }
+
+    if (!rig_cache_stale(rig, time_mode) && mode != RIG_MODE_NONE)
+    {
+        jrn_note(j, &v->mode, ms, vfo, RIG_JOURNAL_MODE, (int64_t) mode, 0);
+    }
+
+    if (!rig_cache_stale(rig, time_width))
+    {
+        jrn_note(j, &v->width, ms, vfo, RIG_JOURNAL_WIDTH, width, 0);
+    }
+}
+
+#define JRN_VFO(slot, vfo, c, name) \
+    jrn_vfo(rig, j, &j->vfos[slot], &ms, vfo, (c)->freq##name, (c)->mode##name, \
+            (c)->width##name, &(c)->time_freq##name, &(c)->time_mode##name, \
+            &(c)->time_width##name)
+
+void rig_journal_update(RIG *rig)
+{
+    struct journal *j = rig->state.journal;
+    const struct rig_cache *c = &rig->state.cache;
+    int64_t ms = 0;
+
+    if (!j || !j->m.hdr)
+    {
+        return;
+    }
+
+    JRN_VFO(JRN_MAIN_A, RIG_VFO_A, c, MainA);
+    JRN_VFO(JRN_MAIN_B, RIG_VFO_B, c, MainB);
+    JRN_VFO(JRN_MAIN_C, RIG_VFO_C, c, MainC);
+    JRN_VFO(JRN_SUB_A, RIG_VFO_SUB_A, c, SubA);
+    JRN_VFO(JRN_SUB_B, RIG_VFO_SUB_B, c, SubB);
+    JRN_VFO(JRN_SUB_C, RIG_VFO_SUB_C, c, SubC);
+
+    if (!rig_cache_stale(rig, &c->time_vfo))
+    {
+        jrn_note(j, &j->vfo, &ms, c->vfo, RIG_JOURNAL_VFO, c->vfo, 0);
+    }
+
+    if (!rig_cache_stale(rig, &c->time_ptt))
+    {
+        jrn_note(j, &j->ptt, &ms, RIG_VFO_TX, RIG_JOURNAL_PTT, c->ptt, 0);
+    }
+
+    // f only compares the transmit VFO, a new one alone is a change too
+    if (!rig_cache_stale(rig, &c->time_split))
+    {
+        jrn_note(j, &j->split, &ms, c->split_vfo, RIG_JOURNAL_SPLIT, c->split,
+                 c->split_vfo);
+    }
+}
+
+void rig_journal_dcd(RIG *rig, vfo_t vfo, dcd_t dcd)
+{
+    struct journal *j = rig->state.journal;
+    int64_t ms = 0;
+
+    if (!j || !j->m.hdr)
+    {
+        return;
+    }
+
+    rig_cache_write_begin(rig);
+
+    if (j->m.hdr)
+    {
+        if (vfo != j->dcd_vfo) { j->dcd.set = 0; }
+
+        j->dcd_vfo = vfo;
+        jrn_note(j, &j->dcd, &ms, vfo, RIG_JOURNAL_DCD, dcd, 0);
+    }
+
+    rig_cache_write_end(rig);
+}
+
+#ifdef JOURNAL_SUPPORTED
+
+static size_t jrn_file_len(uint32_t capacity)
+{
+    return sizeof(struct rig_journal_header)
+           + (size_t) capacity * sizeof(struct rig_journal_record);
+}
+
+/* a header this build can append to, or read from */
+static int jrn_header_ok(const struct rig_journal_header *hdr, size_t len)
+{
+    return hdr->magic == RIG_JOURNAL_MAGIC
+           && hdr->version == RIG_JOURNAL_VERSION
+           && hdr->header_size == sizeof(struct rig_journal_header)
+           && hdr->record_size == sizeof(struct rig_journal_record)
+           && hdr->capacity > 0
+           && len >= jrn_file_len(hdr->capacity);
+}
+
+#endif
+
+int rig_journal_open(RIG *rig)
+{
+#ifdef JOURNAL_SUPPORTED
+    struct journal *j = rig->state.journal;
+    struct rig_journal_header hdr;
+    struct jrn_map m;
+    struct stat st;
+    int reuse;
+    void *p;
+    int fd;
+
+    if (!j || !j->path[0] || j->m.hdr)
+    {
+        return RIG_OK;
+    }
+
+    fd = open(j->path, O_RDWR | O_CREAT, 0644);
+
+    if (fd < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: open %s: %s\n", __func__, j->path,
+                  strerror(errno));
+        return -RIG_EIO;
+    }
+
+    m.len = jrn_file_len(j->size);
+
+    // carry on with a file of the same size, start over otherwise
+    reuse = fstat(fd, &st) == 0 && (size_t) st.st_size == m.len
+            && pread(fd, &hdr, sizeof(hdr), 0) == sizeof(hdr)
+            && jrn_header_ok(&hdr, m.len) && hdr.capacity == (uint32_t) j->size;
+
+    if (!reuse && (ftruncate(fd, 0) < 0 || ftruncate(fd, (off_t) m.len) < 0))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: resize %s: %s\n", __func__, j->path,
+                  strerror(errno));
+        close(fd);
+        return -RIG_EIO;
+    }
+
+    p = mmap(NULL, m.len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (p == MAP_FAILED)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: mmap %s: %s\n", __func__, j->path,
+                  strerror(errno));
+        return -RIG_EIO;
+    }
+
+    m.hdr = p;
+
+    if (!reuse)
+    {
+        m.hdr->version = RIG_JOURNAL_VERSION;
+        m.hdr->header_size = sizeof(struct rig_journal_header);
+        m.hdr->record_size = sizeof(struct rig_journal_record);
+        m.hdr->capacity = j->size;
+        m.hdr->created_ms = jrn_now_ms();
+        JRN_STORE(&m.hdr->magic, RIG_JOURNAL_MAGIC);
+    }
+
+    m.hdr->pid = (uint32_t)getpid();
+    m.hdr->rig_model = rig->caps->rig_model;
+
+    // start from what the cache holds now
+    memset(j->vfos, 0, sizeof(j->vfos));
+    j->ptt.set = j->split.set = j->vfo.set = j->dcd.set = 0;
+
+    rig_cache_write_begin(rig);
+    j->m = m;
+    rig_cache_write_end(rig);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: journal in %s, %d records, %llu written\n",
+              __func__, j->path, j->size, (unsigned long long) m.hdr->head);
+
+    return RIG_OK;
+#else
+    return RIG_OK;
+#endif
+}
+
+void rig_journal_close(RIG *rig)
+{
+#ifdef JOURNAL_SUPPORTED
+    struct journal *j = rig->state.journal;
+    struct jrn_map m;
+
+    if (!j || !j->m.hdr)
+    {
+        return;
+    }
+
+    rig_cache_write_begin(rig);
+    m = j->m;
+    j->m.hdr = NULL;
+    rig_cache_write_end(rig);
+
+    munmap(m.hdr, m.len);
+#endif
+}
+
+void rig_journal_free(RIG *rig)
+{
+    rig_journal_close(rig);
+    free(rig->state.journal);
+    rig->state.journal = NULL;
+}
+
+/*
+ * Copy the complete records stamped since_ms <= ms < until_ms, oldest
+ * first.  Slots overwritten or being written while we look are skipped.
+ */
+static int jrn_query(const struct rig_journal_header *hdr, int64_t since_ms,
+                     int64_t until_ms, struct rig_journal_record *recs, int max)
+{
+    const struct rig_journal_record *slots = jrn_slots(hdr);
+    uint64_t head = JRN_LOAD(&hdr->head);
+    uint64_t n = head > hdr->capacity ? head - hdr->capacity : 0;
+    int count = 0;
+
+    for (; n < head && count < max; n++)
+    {
+        const struct rig_journal_record *r = &slots[n % hdr->capacity];
+        uint32_t seq = JRN_LOAD(&r->seq);
+
+        if (seq != (uint32_t)(n + 1))
+        {
+            continue;
+        }
+
+        memcpy(&recs[count], r, sizeof(*r));
+        JRN_FENCE_ACQUIRE();
+
+        if (JRN_LOAD(&r->seq) != seq
+                || recs[count].ms < since_ms
+                || (until_ms && recs[count].ms >= until_ms))
+        {
+            continue;
+        }
+
+        count++;
+    }
+
+    return count;
+}
+
+/**
+ * \brief read back changes from the rig's journal
+ * \param rig      The rig handle
+ * \param since_ms First stamp wanted, CLOCK_REALTIME milliseconds
+ * \param until_ms Stamp to stop before, 0 for up to now
+ * \param recs     Where to copy the records to
+ * \param max      Room in \a recs
+ *
+ * Reads the journal_file the rig is writing, oldest record first.  With
+ * more than \a max records in the range the oldest \a max come back; ask
+ * again from the stamp of the last one, dropping the records whose \a seq
+ * was seen already.
+ *
+ * \return the number of records copied, -RIG_EINVAL, or -RIG_ENAVAIL when
+ * the rig keeps no journal.
+ *
+ * \sa rig_journal_read()
+ */
+int HAMLIB_API rig_get_journal(RIG *rig, int64_t since_ms, int64_t until_ms,
+                               struct rig_journal_record *recs, int max)
+{
+    const struct journal *j;
+
+    if (CHECK_RIG_ARG(rig) || !recs || max < 1)
+    {
+        return -RIG_EINVAL;
+    }
+
+    j = rig->state.journal;
+
+    if (!j || !j->m.hdr)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    return jrn_query(j->m.hdr, since_ms, until_ms, recs, max);
+}
+
+/**
+ * \brief map a journal file another process writes, or wrote
+ * \param path The owner's journal_file conf
+ *
+ * \return a handle for rig_journal_read(), or NULL when \a path is not a
+ * journal this version can read.
+ *
+ * \sa rig_journal_read(), rig_journal_detach()
+ */
+rig_journal_t *HAMLIB_API rig_journal_attach(const char *path)
+{
+#ifdef JOURNAL_SUPPORTED
+    rig_journal_t *journal;
+    struct stat st;
+    void *p;
+    int fd;
+
+    if (!path)
+    {
+        return NULL;
+    }
+
+    fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+    {
+        return NULL;
+    }
+
+    if (fstat(fd, &st) < 0 || (size_t) st.st_size < sizeof(struct rig_journal_header))
+    {
+        close(fd);
+        return NULL;
+    }
+
+    p = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (p == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    if (!jrn_header_ok(p, st.st_size) || !(journal = calloc(1, sizeof(*journal))))
+    {
+        munmap(p, st.st_size);
+        return NULL;
+    }
+
+    journal->m.hdr = p;
+    journal->m.len = st.st_size;
+
+    return journal;
+#else
+    (void) path;
+    return NULL;
+#endif
+}
+
+/**
+ * \brief read back changes from a journal file
+ * \param journal  The handle from rig_journal_attach()
+ * \param since_ms First stamp wanted, CLOCK_REALTIME milliseconds
+ * \param until_ms Stamp to stop before, 0 for up to now
+ * \param recs     Where to copy the records to
+ * \param max      Room in \a recs
+ *
+ * Same as rig_get_journal(), from another process.  Does not enter the
+ * kernel.
+ *
+ * \return the number of records copied, -RIG_EINVAL, or -RIG_EPROTO if
+ * the file was started over with another layout.
+ */
+int HAMLIB_API rig_journal_read(rig_journal_t *journal, int64_t since_ms,
+                                int64_t until_ms,
+                                struct rig_journal_record *recs, int max)
+{
+    if (!journal || !journal->m.hdr || !recs || max < 1)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (!jrn_header_ok(journal->m.hdr, journal->m.len))
+    {
+        return -RIG_EPROTO;
+    }
+
+    return jrn_query(journal->m.hdr, since_ms, until_ms, recs, max);
+}
+
+/**
+ * \brief unmap a journal mapped by rig_journal_attach()
+ * \param journal The handle, freed here
+ */
+void HAMLIB_API rig_journal_detach(rig_journal_t *journal)
+{
+    if (!journal)
+    {
+        return;
+    }
+
+#ifdef JOURNAL_SUPPORTED
+
+    if (journal->m.hdr) { munmap(journal->m.hdr, journal->m.len); }
+
+#endif
+    free(journal);
+}
+
+/**
+ * \brief name of a journal field
+ * \param field RIG_JOURNAL_FREQ and so on
+ *
+ * \return "FREQ", "MODE"... or "" for an unknown field.
+ */
+const char *HAMLIB_API rig_strjournal(enum rig_journal_field_e field)
+{
+    switch (field)
+    {
+    case RIG_JOURNAL_FREQ: return "FREQ";
+
+    case RIG_JOURNAL_MODE: return "MODE";
+
+    case RIG_JOURNAL_WIDTH: return "WIDTH";
+
+    case RIG_JOURNAL_PTT: return "PTT";
+
+    case RIG_JOURNAL_SPLIT: return "SPLIT";
+
+    case RIG_JOURNAL_VFO: return "VFO";
+
+    case RIG_JOURNAL_DCD: return "DCD";
+    }
+
+    return "";
+}
@@ -0,0 +1,47 @@
+/*
+ *  Hamlib Interface - rig state journal
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef _JOURNAL_H
+#define _JOURNAL_H 1
+
+#include <hamlib/rig.h>
+
+#define JOURNAL_DEFAULT_SIZE 65536
+
+/* The journal_file and journal_size confs, taking effect at the next rig_open() */
+int rig_journal_set_path(RIG *rig, const char *path);
+const char *rig_journal_get_path(RIG *rig);
+int rig_journal_set_size(RIG *rig, int records);
+int rig_journal_get_size(RIG *rig);
+
+/* Map the file once the rig is open, unmap it on close */
+int rig_journal_open(RIG *rig);
+void rig_journal_close(RIG *rig);
+void rig_journal_free(RIG *rig);
+
+/* Record what changed in the cache, called inside rig_cache_write_begin() */
+void rig_journal_update(RIG *rig);
+
+/* DCD is not cached, rig_fire_dcd_event() hands it over */
+void rig_journal_dcd(RIG *rig, vfo_t vfo, dcd_t dcd);
+
+#endif /* _JOURNAL_H */
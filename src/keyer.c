@@ -0,0 +1,706 @@
+/*
+ *  Hamlib Interface - timed CW and PTT keying
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Keys CW on a serial line (or the PTT line) from a thread of its own.
+ *
+ * rig_send_morse() turns the text into a queue of key down/up elements
+ * and returns.  The keying thread runs at SCHED_FIFO priority when the
+ * system lets it, and sleeps towards absolute CLOCK_MONOTONIC deadlines:
+ * a late wake-up shortens the next element instead of stretching the
+ * whole message, so the timing does not drift with load.
+ *
+ * When PTT is on a line of its own it is raised cw_ptt_lead ms before the
+ * first element and held cw_ptt_tail ms after the last one, a message
+ * queued meanwhile goes out without dropping PTT.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/time.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "keyer.h"
+#include "serial.h"
+#include "parallel.h"
+#include "cm108.h"
+#include "gpio.h"
+#include "misc.h"
+
+#ifdef HAVE_PTHREAD
+
+/* elements, about 300 characters */
+#define KEYER_QUEUE_LEN 4096
+
+/* below the threaded interrupt handlers, which default to 50 */
+#define KEYER_PRIORITY 40
+
+static const char *const morse_table[128] =
+{
+    ['A'] = ".-",    ['B'] = "-...",  ['C'] = "-.-.",  ['D'] = "-..",
+    ['E'] = ".",     ['F'] = "..-.",  ['G'] = "--.",   ['H'] = "....",
+    ['I'] = "..",    ['J'] = ".---",  ['K'] = "-.-",   ['L'] = ".-..",
+    ['M'] = "--",    ['N'] = "-.",    ['O'] = "---",   ['P'] = ".--.",
+    ['Q'] = "--.-",  ['R'] = ".-.",   ['S'] = "...",   ['T'] = "-",
+    ['U'] = "..-",   ['V'] = "...-",  ['W'] = ".--",   ['X'] = "-..-",
+    ['Y'] = "-.--",  ['Z'] = "--..",
+    ['0'] = "-----", ['1'] = ".----", ['2'] = "..---", ['3'] = "...--",
+    ['4'] = "....-", ['5'] = ".....", ['6'] = "-....", ['7'] = "--...",
+    ['8'] = "---..", ['9'] = "----.",
+    ['.'] = ".-.-.-", [','] = "--..--", ['?'] = "..--..", ['\''] = ".----.",
+    ['!'] = "-.-.--", ['/'] = "-..-.",  ['('] = "-.--.",  [')'] = "-.--.-",
+    ['&'] = ".-...",  [':'] = "---...", [';'] = "-.-.-.", ['='] = "-...-",
+    ['+'] = ".-.-.",  ['-'] = "-....-", ['_'] = "..--.-", ['"'] = ".-..-.",
+    ['$'] = "...-..-", ['@'] = ".--.-.",
+};
+
+struct keyer_element
+{
+    unsigned char key;  /* key down for the element */
+    unsigned int us;    /* length of the element */
+};
+
+struct keyer
+{
+    RIG *rig;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;    /* something queued, or stop */
+    pthread_cond_t idle;    /* queue sent and PTT released */
+    struct keyer_element queue[KEYER_QUEUE_LEN];
+    unsigned int head, tail;    /* free running, modulo KEYER_QUEUE_LEN */
+    unsigned int gen;   /* bumped by keyer_abort() */
+    int line;           /* KEYER_DTR, KEYER_RTS or KEYER_PTT */
+    int ptt;            /* PTT is sequenced around the CW */
+    int key_on, ptt_on, running, stop;
+    hamlib_port_t serial;   /* DTR/RTS lines */
+    int serial_owned;   /* serial.fd was opened for the keyer */
+};
+
+
+static void timespec_add_us(struct timespec *t, long us)
+{
+    t->tv_sec += us / 1000000;
+    t->tv_nsec += (us % 1000000) * 1000;
+
+    if (t->tv_nsec >= 1000000000)
+    {
+        t->tv_sec++;
+        t->tv_nsec -= 1000000000;
+    }
+}
+
+
+static void keyer_sleep_until(const struct timespec *t)
+{
+#ifdef HAVE_CLOCK_NANOSLEEP
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, t, NULL) == EINTR)
+    {
+    }
+
+#else
+    struct timespec now;
+    long us;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    us = (t->tv_sec - now.tv_sec) * 1000000L + (t->tv_nsec - now.tv_nsec) / 1000;
+
+    if (us > 0)
+    {
+        hl_usleep(us);
+    }
+
+#endif
+}
+
+
+/* called with the lock held */
+static void keyer_ptt(struct keyer *k, int on)
+{
+    hamlib_port_t *pttport = &k->rig->state.pttport;
+    ptt_t ptt = on ? RIG_PTT_ON : RIG_PTT_OFF;
+    int retval;
+
+    switch (pttport->type.ptt)
+    {
+    case RIG_PTT_SERIAL_DTR:
+        retval = ser_set_dtr(&k->serial, on);
+        break;
+
+    case RIG_PTT_SERIAL_RTS:
+        retval = ser_set_rts(&k->serial, on);
+        break;
+
+    case RIG_PTT_PARALLEL:
+        retval = par_ptt_set(pttport, ptt);
+        break;
+
+    case RIG_PTT_CM108:
+        retval = cm108_ptt_set(pttport, ptt);
+        break;
+
+    case RIG_PTT_GPIO:
+    case RIG_PTT_GPION:
+        retval = gpio_ptt_set(pttport, ptt);
+        break;
+
+    default:
+        return;
+    }
+
+    if (retval != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: PTT %s failed: %s\n", __func__,
+                  on ? "on" : "off", rigerror(retval));
+    }
+}
+
+
+/* called with the lock held */
+static void keyer_key(struct keyer *k, int on)
+{
+    int retval;
+
+    switch (k->line)
+    {
+    case KEYER_DTR:
+        retval = ser_set_dtr(&k->serial, on);
+        break;
+
+    case KEYER_RTS:
+        retval = ser_set_rts(&k->serial, on);
+        break;
+
+    default:
+        keyer_ptt(k, on);
+        retval = RIG_OK;
+        break;
+    }
+
+    if (retval != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: key %s failed: %s\n", __func__,
+                  on ? "down" : "up", rigerror(retval));
+    }
+
+    k->key_on = on;
+}
+
+
+static void *keyer_thread(void *arg)
+{
+    struct keyer *k = (struct keyer *) arg;
+    const struct rig_state *rs = &k->rig->state;
+    struct timespec next, tail_until;
+    int tail_armed = 0;
+
+    pthread_mutex_lock(&k->lock);
+
+    while (!k->stop)
+    {
+        struct keyer_element el;
+        unsigned int gen;
+
+        if (k->head == k->tail)
+        {
+            k->running = 0;
+
+            if (!k->ptt_on)
+            {
+                tail_armed = 0;
+                pthread_cond_broadcast(&k->idle);
+                pthread_cond_wait(&k->cond, &k->lock);
+                continue;
+            }
+
+            /* hang time, the wall clock is good enough for it */
+            if (!tail_armed)
+            {
+                struct timeval tv;
+
+                gettimeofday(&tv, NULL);
+                tail_until.tv_sec = tv.tv_sec;
+                tail_until.tv_nsec = tv.tv_usec * 1000;
+                timespec_add_us(&tail_until, rs->cw_ptt_tail_ms * 1000L);
+                tail_armed = 1;
+            }
+
+            if (pthread_cond_timedwait(&k->cond, &k->lock, &tail_until) == ETIMEDOUT
+                    && k->head == k->tail && k->ptt_on)
+            {
+                keyer_ptt(k, 0);
+                k->ptt_on = 0;
+            }
+
+            continue;
+        }
+
+        tail_armed = 0;
+        gen = k->gen;
+
+        if (k->ptt && !k->ptt_on)
+        {
+            keyer_ptt(k, 1);
+            k->ptt_on = 1;
+            clock_gettime(CLOCK_MONOTONIC, &next);
+            timespec_add_us(&next, rs->cw_ptt_lead_ms * 1000L);
+            k->running = 1;
+        }
+        else
+        {
+            el = k->queue[k->head % KEYER_QUEUE_LEN];
+            k->head++;
+
+            if (el.key != k->key_on)
+            {
+                keyer_key(k, el.key);
+            }
+
+            if (!k->running)
+            {
+                clock_gettime(CLOCK_MONOTONIC, &next);
+                k->running = 1;
+            }
+
+            timespec_add_us(&next, el.us);
+        }
+
+        pthread_mutex_unlock(&k->lock);
+        keyer_sleep_until(&next);
+        pthread_mutex_lock(&k->lock);
+
+        /* after an abort the next message starts from scratch */
+        if (k->gen != gen)
+        {
+            k->running = 0;
+        }
+    }
+
+    if (k->key_on)
+    {
+        keyer_key(k, 0);
+    }
+
+    if (k->ptt_on)
+    {
+        keyer_ptt(k, 0);
+        k->ptt_on = 0;
+    }
+
+    k->running = 0;
+    pthread_cond_broadcast(&k->idle);
+    pthread_mutex_unlock(&k->lock);
+
+    return NULL;
+}
+
+
+static int keyer_create_thread(struct keyer *k)
+{
+#ifdef SCHED_FIFO
+    pthread_attr_t attr;
+    struct sched_param param;
+    int retval;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+    pthread_attr_setschedpolicy(&attr, SCHED_FIFO);
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = KEYER_PRIORITY;
+
+    if (param.sched_priority > sched_get_priority_max(SCHED_FIFO))
+    {
+        param.sched_priority = sched_get_priority_max(SCHED_FIFO);
+    }
+
+    pthread_attr_setschedparam(&attr, &param);
+    retval = pthread_create(&k->thread, &attr, keyer_thread, k);
+    pthread_attr_destroy(&attr);
+
+    if (retval == 0)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: keying at SCHED_FIFO %d\n", __func__,
+                  param.sched_priority);
+        return 0;
+    }
+
+    /* EPERM without CAP_SYS_NICE or an rtprio limit */
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: no realtime priority: %s\n", __func__,
+              strerror(retval));
+#endif
+
+    return pthread_create(&k->thread, NULL, keyer_thread, k);
+}
+
+
+/* the serial port the DTR/RTS lines are on, NULL if there is none */
+static hamlib_port_t *keyer_serial_port(struct rig_state *rs)
+{
+    if (rs->pttport.type.ptt == RIG_PTT_SERIAL_DTR
+            || rs->pttport.type.ptt == RIG_PTT_SERIAL_RTS)
+    {
+        return &rs->pttport;
+    }
+
+    if (rs->rigport.type.rig == RIG_PORT_SERIAL)
+    {
+        return &rs->rigport;
+    }
+
+    return NULL;
+}
+
+
+int keyer_start(RIG *rig)
+{
+    struct rig_state *rs = &rig->state;
+    struct keyer *k;
+    ptt_type_t ptt_type = rs->pttport.type.ptt;
+    int ptt_line, serial, retval;
+
+    if (rs->cw_key == KEYER_NONE)
+    {
+        return RIG_OK;
+    }
+
+    ptt_line = ptt_type == RIG_PTT_SERIAL_DTR || ptt_type == RIG_PTT_SERIAL_RTS
+               || ptt_type == RIG_PTT_PARALLEL || ptt_type == RIG_PTT_CM108
+               || ptt_type == RIG_PTT_GPIO || ptt_type == RIG_PTT_GPION;
+
+    if (rs->cw_key == KEYER_PTT && !ptt_line)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: keying on PTT needs a PTT line\n", __func__);
+        return -RIG_ECONF;
+    }
+
+    if ((rs->cw_key == KEYER_DTR && ptt_type == RIG_PTT_SERIAL_DTR)
+            || (rs->cw_key == KEYER_RTS && ptt_type == RIG_PTT_SERIAL_RTS))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: CW and PTT on the same line\n", __func__);
+        return -RIG_ECONF;
+    }
+
+    k = calloc(1, sizeof(*k));
+
+    if (!k)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    k->rig = rig;
+    k->line = rs->cw_key;
+    k->ptt = rs->cw_key != KEYER_PTT && ptt_line;
+    k->serial.fd = -1;
+
+    serial = rs->cw_key != KEYER_PTT || ptt_type == RIG_PTT_SERIAL_DTR
+             || ptt_type == RIG_PTT_SERIAL_RTS;
+
+    if (serial)
+    {
+        hamlib_port_t *port = keyer_serial_port(rs);
+
+        if (!port)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: no serial port to key %s on\n", __func__,
+                      rs->cw_key == KEYER_DTR ? "DTR" : "RTS");
+            free(k);
+            return -RIG_ECONF;
+        }
+
+        if (port == &rs->rigport && rs->cw_key == KEYER_RTS
+                && rs->rigport.parm.serial.handshake == RIG_HANDSHAKE_HARDWARE)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: RTS is used for handshake\n", __func__);
+            free(k);
+            return -RIG_ECONF;
+        }
+
+        memcpy(&k->serial, port, sizeof(k->serial));
+
+        /* a PTT port of its own is only open while transmitting, keep one */
+        if (!strcmp(port->pathname, rs->rigport.pathname))
+        {
+            k->serial.fd = rs->rigport.fd;
+        }
+        else
+        {
+            k->serial.fd = ser_open(&k->serial);
+
+            if (k->serial.fd < 0)
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: cannot open \"%s\"\n", __func__,
+                          k->serial.pathname);
+                free(k);
+                return -RIG_EIO;
+            }
+
+            k->serial_owned = 1;
+        }
+    }
+
+    pthread_mutex_init(&k->lock, NULL);
+    pthread_cond_init(&k->cond, NULL);
+    pthread_cond_init(&k->idle, NULL);
+
+    retval = keyer_create_thread(k);
+
+    if (retval)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(retval));
+
+        if (k->serial_owned)
+        {
+            ser_close(&k->serial);
+        }
+
+        pthread_cond_destroy(&k->idle);
+        pthread_cond_destroy(&k->cond);
+        pthread_mutex_destroy(&k->lock);
+        free(k);
+        return -RIG_EINTERNAL;
+    }
+
+    rs->keyer = k;
+
+    return RIG_OK;
+}
+
+
+void keyer_stop(RIG *rig)
+{
+    struct keyer *k = (struct keyer *) rig->state.keyer;
+
+    if (!k)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&k->lock);
+    k->stop = 1;
+    pthread_cond_broadcast(&k->cond);
+    pthread_mutex_unlock(&k->lock);
+
+    pthread_join(k->thread, NULL);
+
+    if (k->serial_owned)
+    {
+        ser_close(&k->serial);
+    }
+
+    pthread_cond_destroy(&k->idle);
+    pthread_cond_destroy(&k->cond);
+    pthread_mutex_destroy(&k->lock);
+    free(k);
+
+    rig->state.keyer = NULL;
+}
+
+
+/* called with the lock held, merges key up time into the last element */
+static int keyer_push(struct keyer *k, int key, unsigned int us)
+{
+    if (!key && k->tail != k->head
+            && !k->queue[(k->tail - 1) % KEYER_QUEUE_LEN].key)
+    {
+        k->queue[(k->tail - 1) % KEYER_QUEUE_LEN].us += us;
+        return RIG_OK;
+    }
+
+    if (k->tail - k->head >= KEYER_QUEUE_LEN)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    k->queue[k->tail % KEYER_QUEUE_LEN].key = key;
+    k->queue[k->tail % KEYER_QUEUE_LEN].us = us;
+    k->tail++;
+
+    return RIG_OK;
+}
+
+
+int keyer_send(RIG *rig, const char *msg)
+{
+    struct keyer *k = (struct keyer *) rig->state.keyer;
+    int wpm = rig->state.cw_wpm > 0 ? rig->state.cw_wpm : 20;
+    unsigned int dit = 1200000 / wpm;   /* PARIS timing */
+    unsigned int tail;
+    int retval = RIG_OK;
+
+    if (!k)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    pthread_mutex_lock(&k->lock);
+    tail = k->tail;
+
+    for (; *msg && retval == RIG_OK; msg++)
+    {
+        unsigned char c = toupper((unsigned char) * msg);
+        const char *code = c < 128 ? morse_table[c] : NULL;
+
+        if (c == ' ')
+        {
+            /* 3 dits after the previous character make 7 */
+            retval = keyer_push(k, 0, 4 * dit);
+            continue;
+        }
+
+        if (!code)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: no morse for '%c'\n", __func__, *msg);
+            continue;
+        }
+
+        for (; *code && retval == RIG_OK; code++)
+        {
+            retval = keyer_push(k, 1, *code == '-' ? 3 * dit : dit);
+
+            if (retval == RIG_OK)
+            {
+                retval = keyer_push(k, 0, dit);
+            }
+        }
+
+        if (retval == RIG_OK)
+        {
+            retval = keyer_push(k, 0, 2 * dit);
+        }
+    }
+
+    if (retval == RIG_OK)
+    {
+        pthread_cond_signal(&k->cond);
+    }
+    else
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: keyer queue full\n", __func__);
+        k->tail = tail;
+    }
+
+    pthread_mutex_unlock(&k->lock);
+
+    return retval;
+}
+
+
+int keyer_abort(RIG *rig)
+{
+    struct keyer *k = (struct keyer *) rig->state.keyer;
+
+    if (!k)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    pthread_mutex_lock(&k->lock);
+    k->head = k->tail;
+    k->gen++;
+
+    if (k->key_on)
+    {
+        keyer_key(k, 0);
+    }
+
+    if (k->ptt_on)
+    {
+        keyer_ptt(k, 0);
+        k->ptt_on = 0;
+    }
+
+    k->running = 0;
+    pthread_cond_broadcast(&k->cond);
+    pthread_mutex_unlock(&k->lock);
+
+    return RIG_OK;
+}
+
+
+int keyer_wait(RIG *rig)
+{
+    struct keyer *k = (struct keyer *) rig->state.keyer;
+
+    if (!k)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    pthread_mutex_lock(&k->lock);
+
+    while (!k->stop && (k->head != k->tail || k->running || k->ptt_on))
+    {
+        pthread_cond_wait(&k->idle, &k->lock);
+    }
+
+    pthread_mutex_unlock(&k->lock);
+
+    return RIG_OK;
+}
+
+#else
+
+int keyer_start(RIG *rig)
+{
+    if (rig->state.cw_key == KEYER_NONE)
+    {
+        return RIG_OK;
+    }
+
+    rig_debug(RIG_DEBUG_ERR, "%s: the keyer needs pthreads\n", __func__);
+    return -RIG_ENIMPL;
+}
+
+
+void keyer_stop(RIG *rig)
+{
+}
+
+
+int keyer_send(RIG *rig, const char *msg)
+{
+    return -RIG_ENAVAIL;
+}
+
+
+int keyer_abort(RIG *rig)
+{
+    return -RIG_ENAVAIL;
+}
+
+
+int keyer_wait(RIG *rig)
+{
+    return -RIG_ENAVAIL;
+}
+
+#endif
@@ -0,0 +1,50 @@
+/*
+ *  Hamlib Interface - timed CW and PTT keying
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _KEYER_H
+#define _KEYER_H 1
+
+#include <hamlib/rig.h>
+
+/* Values of rig_state.cw_key, the line the keyer sends CW on */
+enum keyer_line_e
+{
+    KEYER_NONE = 0,     /* no keyer, send_morse goes to the backend */
+    KEYER_DTR,          /* DTR of the PTT serial port, or of the rig port */
+    KEYER_RTS,          /* RTS of the PTT serial port, or of the rig port */
+    KEYER_PTT           /* the PTT line itself, for full break-in rigs */
+};
+
+/* Start the keying thread when cw_key is set, RIG_OK if it is not */
+int keyer_start(RIG *rig);
+
+void keyer_stop(RIG *rig);
+
+/* Queue a message, returns once it is queued */
+int keyer_send(RIG *rig, const char *msg);
+
+/* Drop what is queued and key up at once */
+int keyer_abort(RIG *rig);
+
+/* Wait until the queue is sent and PTT released */
+int keyer_wait(RIG *rig);
+
+#endif /* _KEYER_H */
@@ -133,6 +133,30 @@
  */
 const static int loc_char_range[] = { 18, 10, 24, 10, 24, 10 };
 
+/*
+ * Locator character values plus one, 0 for characters that are not valid
+ * in that position, so decoding is one lookup per character instead of
+ * case tests and subtractions.
+ */
+#define LOC_L(c, v) [c] = (v) + 1, [(c) + ('a' - 'A')] = (v) + 1
+static const unsigned char loc_letter_value[256] =
+{
+    LOC_L('A', 0), LOC_L('B', 1), LOC_L('C', 2), LOC_L('D', 3),
+    LOC_L('E', 4), LOC_L('F', 5), LOC_L('G', 6), LOC_L('H', 7),
+    LOC_L('I', 8), LOC_L('J', 9), LOC_L('K', 10), LOC_L('L', 11),
+    LOC_L('M', 12), LOC_L('N', 13), LOC_L('O', 14), LOC_L('P', 15),
+    LOC_L('Q', 16), LOC_L('R', 17), LOC_L('S', 18), LOC_L('T', 19),
+    LOC_L('U', 20), LOC_L('V', 21), LOC_L('W', 22), LOC_L('X', 23),
+    LOC_L('Y', 24), LOC_L('Z', 25),
+};
+#undef LOC_L
+
+static const unsigned char loc_digit_value[256] =
+{
+    ['0'] = 1, ['1'] = 2, ['2'] = 3, ['3'] = 4, ['4'] = 5,
+    ['5'] = 6, ['6'] = 7, ['7'] = 8, ['8'] = 9, ['9'] = 10,
+};
+
 #endif  /* !DOC_HIDDEN */
 
 /** \def MAX_LOCATOR_PAIRS
@@ -419,6 +443,64 @@ int HAMLIB_API dec2dmmm(double dec, int *degrees, double *minutes, int *sw)
 }
 
 
+/* begin dph */
+/* locator2longlat() on the first len chars of locator, without logging */
+static int loc_decode(const char *locator, size_t len, double *longitude,
+                      double *latitude)
+{
+    int x_or_y, paircount;
+    int locvalue, pair;
+    double xy[2];
+
+    paircount = len / 2;
+
+    /* verify paircount is within limits */
+    if (paircount > MAX_LOCATOR_PAIRS)
+    {
+        paircount = MAX_LOCATOR_PAIRS;
+    }
+    else if (paircount < MIN_LOCATOR_PAIRS)
+    {
+        return -RIG_EINVAL;
+    }
+
+    /*
+     * For x(=longitude) and y(=latitude), gather the pairs into the index
+     * of the smallest square, then go to its center in one step
+     */
+    for (x_or_y = 0;  x_or_y < 2;  ++x_or_y)
+    {
+        long cell = 0;
+        long divisions = 1;
+
+        for (pair = 0;  pair < paircount;  ++pair)
+        {
+            const unsigned char *values = (loc_char_range[pair] == 10) ?
+                                          loc_digit_value : loc_letter_value;
+
+            locvalue = values[(unsigned char)locator[pair * 2 + x_or_y]] - 1;
+
+            /* Check range for non-letter/digit or out of range */
+            if ((locvalue < 0) || (locvalue >= loc_char_range[pair]))
+            {
+                return -RIG_EINVAL;
+            }
+
+            cell = cell * loc_char_range[pair] + locvalue;
+            divisions *= loc_char_range[pair];
+        }
+
+        /* Center ordinate in the Maidenhead "square" or "subsquare" */
+        xy[x_or_y] = -90.0 + (cell + 0.5) * (180.0 / divisions);
+    }
+
+    *longitude = xy[0] * 2.0;
+    *latitude = xy[1];
+
+    return RIG_OK;
+}
+
+
 /**
  * \brief Convert QRA locator (Maidenhead grid square) to Longitude/Latitude.
  *
@@ -448,15 +530,10 @@ int HAMLIB_API dec2dmmm(double dec, int *degrees, double *minutes, int *sw)
  *
  * \sa longlat2locator()
  */
-/* begin dph */
 int HAMLIB_API locator2longlat(double *longitude,
                                double *latitude,
                                const char *locator)
 {
-    int x_or_y, paircount;
-    int locvalue, pair;
-    double xy[2];
-
     rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     /* bail if NULL pointers passed */
@@ -465,52 +542,7 @@ int HAMLIB_API locator2longlat(double *longitude,
         return -RIG_EINVAL;
     }
 
-    paircount = strlen(locator) / 2;
-
-    /* verify paircount is within limits */
-    if (paircount > MAX_LOCATOR_PAIRS)
-    {
-        paircount = MAX_LOCATOR_PAIRS;
-    }
-    else if (paircount < MIN_LOCATOR_PAIRS)
-    {
-        return -RIG_EINVAL;
-    }
-
-    /* For x(=longitude) and y(=latitude) */
-    for (x_or_y = 0;  x_or_y < 2;  ++x_or_y)
-    {
-        double ordinate = -90.0;
-        int divisions = 1;
-
-        for (pair = 0;  pair < paircount;  ++pair)
-        {
-            locvalue = locator[pair * 2 + x_or_y];
-
-            /* Value of digit or letter */
-            locvalue -= (loc_char_range[pair] == 10) ? '0' :
-                        (isupper(locvalue)) ? 'A' : 'a';
-
-            /* Check range for non-letter/digit or out of range */
-            if ((locvalue < 0) || (locvalue >= loc_char_range[pair]))
-            {
-                return -RIG_EINVAL;
-            }
-
-            divisions *= loc_char_range[pair];
-            ordinate += locvalue * 180.0 / divisions;
-        }
-
-        /* Center ordinate in the Maidenhead "square" or "subsquare" */
-        ordinate += 90.0 / divisions;
-
-        xy[x_or_y] = ordinate;
-    }
-
-    *longitude = xy[0] * 2.0;
-    *latitude = xy[1];
-
-    return RIG_OK;
+    return loc_decode(locator, strlen(locator), longitude, latitude);
 }
 /* end dph */
 
@@ -549,7 +581,7 @@ int HAMLIB_API longlat2locator(double longitude,
                                int pair_count)
 {
     int x_or_y, pair, locvalue;
-    double square_size;
+    long divisions;
 
     rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -563,21 +595,33 @@ int HAMLIB_API longlat2locator(double longitude,
         return -RIG_EINVAL;
     }
 
+    divisions = 1;
+
+    for (pair = 0;  pair < pair_count;  ++pair)
+    {
+        divisions *= loc_char_range[pair];
+    }
+
     for (x_or_y = 0;  x_or_y < 2;  ++x_or_y)
     {
         double ordinate = (x_or_y == 0) ? longitude / 2.0 : latitude;
-        int divisions = 1;
+        long cell;
 
         /* The 1e-6 here guards against floating point rounding errors */
         ordinate = fmod(ordinate + 270.000001, 180.0);
 
-        for (pair = 0;  pair < pair_count;  ++pair)
+        /* index of the smallest square, then split it up in integers */
+        cell = (long)(ordinate / (180.0 / divisions));
+
+        if (cell >= divisions)
         {
-            divisions *= loc_char_range[pair];
-            square_size = 180.0 / divisions;
+            cell = divisions - 1;
+        }
 
-            locvalue = (int)(ordinate / square_size);
-            ordinate -= square_size * locvalue;
+        for (pair = pair_count - 1;  pair >= 0;  --pair)
+        {
+            locvalue = cell % loc_char_range[pair];
+            cell /= loc_char_range[pair];
             locvalue += (loc_char_range[pair] == 10) ? '0' : 'A';
             locator[pair * 2 + x_or_y] = locvalue;
         }
@@ -590,95 +634,49 @@ int HAMLIB_API longlat2locator(double longitude,
 /* end dph */
 
 
-/**
- * \brief Calculate the distance and bearing between two points.
- *
- * \param lon1 The local Longitude, decimal degrees.
- * \param lat1 The local Latitude, decimal degrees,
- * \param lon2 The remote Longitude, decimal degrees.
- * \param lat2 The remote Latitude, decimal degrees.
- * \param distance Pointer for the distance, km.
- * \param azimuth Pointer for the bearing, decimal degrees.
- *
- * Calculate the distance and bearing (QRB) between \a lon1, \a lat1 and
- * \a lon2, \a lat2.
- *
- * This version will calculate the QRB to a precision sufficient for 12
- * character locators.  Antipodal points, which are easily calculated, are
- * considered equidistant and the bearing is simply resolved to be true north,
- * e.g. \a azimuth = 0.0.
- *
- * \return RIG_OK if the operation has been successful, otherwise a **negative
- * value** if an error occurred (in which case, cause is set appropriately).
- *
- * \retval RIG_OK The calculations were successful.
- * \retval RIG_EINVAL If a NULL pointer passed or \a lat and \a lon values
- * exceed -90 to 90 or -180 to 180.
- *
- * \sa distance_long_path(), azimuth_long_path()
- */
-int HAMLIB_API qrb(double lon1,
-                   double lat1,
-                   double lon2,
-                   double lat2,
-                   double *distance,
-                   double *azimuth)
+/* Prevent ACOS() Domain Error */
+static inline double qrb_pole_clamp(double lat)
 {
-    double delta_long, tmp, arc, az;
-
-    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
-    /* bail if NULL pointers passed */
-    if (!distance || !azimuth)
+    if (lat == 90.0)
     {
-        return -RIG_EINVAL;
+        return 89.999999999;
     }
 
-    if ((lat1 > 90.0 || lat1 < -90.0) || (lat2 > 90.0 || lat2 < -90.0))
+    if (lat == -90.0)
     {
-        return -RIG_EINVAL;
+        return -89.999999999;
     }
 
-    if ((lon1 > 180.0 || lon1 < -180.0) || (lon2 > 180.0 || lon2 < -180.0))
-    {
-        return -RIG_EINVAL;
-    }
+    return lat;
+}
 
-    /* Prevent ACOS() Domain Error */
-    if (lat1 == 90.0)
-    {
-        lat1 = 89.999999999;
-    }
-    else if (lat1 == -90.0)
-    {
-        lat1 = -89.999999999;
-    }
 
-    if (lat2 == 90.0)
-    {
-        lat2 = 89.999999999;
-    }
-    else if (lat2 == -90.0)
-    {
-        lat2 = -89.999999999;
-    }
+/*
+ * The qrb() arithmetic, from a station given in radians with the sine and
+ * cosine of its latitude to lon2/lat2 in degrees.  Range checks are up to
+ * the caller, and nothing is logged, so batches can call it in a loop.
+ */
+static inline void qrb_calc(double lon1, double sin_lat1, double cos_lat1,
+                            double lon2, double lat2,
+                            double *distance, double *azimuth)
+{
+    double delta_long, sin_lat2, cos_lat2, cos_delta, tmp, az;
 
-    /* Convert variables to Radians */
-    lat1 /= RADIAN;
-    lon1 /= RADIAN;
-    lat2 /= RADIAN;
-    lon2 /= RADIAN;
+    lat2 = qrb_pole_clamp(lat2) / RADIAN;
+    delta_long = lon2 / RADIAN - lon1;
 
-    delta_long = lon2 - lon1;
+    sin_lat2 = sin(lat2);
+    cos_lat2 = cos(lat2);
+    cos_delta = cos(delta_long);
 
-    tmp = sin(lat1) * sin(lat2) + cos(lat1) * cos(lat2) * cos(delta_long);
+    tmp = sin_lat1 * sin_lat2 + cos_lat1 * cos_lat2 * cos_delta;
 
     if (tmp > .999999999999999)
     {
         /* Station points coincide, use an Omni! */
         *distance = 0.0;
         *azimuth = 0.0;
-        return RIG_OK;
+        return;
     }
 
     if (tmp < -.999999)
@@ -691,22 +689,20 @@ int HAMLIB_API qrb(double lon1,
          */
         *distance = 180.0 * ARC_IN_KM;
         *azimuth = 0.0;
-        return RIG_OK;
+        return;
     }
 
-    arc = acos(tmp);
-
     /*
      * One degree of arc is 60 Nautical miles
      * at the surface of the earth, 111.2 km, or 69.1 sm
      * This method is easier than the one in the handbook
      */
-    *distance = ARC_IN_KM * RADIAN * arc;
+    *distance = ARC_IN_KM * RADIAN * acos(tmp);
 
     /* Short Path */
     /* Change to azimuth computation by Dave Freese, W1HKJ */
-    az = RADIAN * atan2(sin(lon2 - lon1) * cos(lat2),
-                        (cos(lat1) * sin(lat2) - sin(lat1) * cos(lat2) * cos(lon2 - lon1)));
+    az = RADIAN * atan2(sin(delta_long) * cos_lat2,
+                        (cos_lat1 * sin_lat2 - sin_lat1 * cos_lat2 * cos_delta));
 
     az = fmod(360.0 + az, 360.0);
 
@@ -720,6 +716,70 @@ int HAMLIB_API qrb(double lon1,
     }
 
     *azimuth = floor(az + 0.5);
+}
+
+
+static inline int qrb_valid(double lon, double lat)
+{
+    return lat <= 90.0 && lat >= -90.0 && lon <= 180.0 && lon >= -180.0;
+}
+
+
+/**
+ * \brief Calculate the distance and bearing between two points.
+ *
+ * \param lon1 The local Longitude, decimal degrees.
+ * \param lat1 The local Latitude, decimal degrees,
+ * \param lon2 The remote Longitude, decimal degrees.
+ * \param lat2 The remote Latitude, decimal degrees.
+ * \param distance Pointer for the distance, km.
+ * \param azimuth Pointer for the bearing, decimal degrees.
+ *
+ * Calculate the distance and bearing (QRB) between \a lon1, \a lat1 and
+ * \a lon2, \a lat2.
+ *
+ * This version will calculate the QRB to a precision sufficient for 12
+ * character locators.  Antipodal points, which are easily calculated, are
+ * considered equidistant and the bearing is simply resolved to be true north,
+ * e.g. \a azimuth = 0.0.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_OK The calculations were successful.
+ * \retval RIG_EINVAL If a NULL pointer passed or \a lat and \a lon values
+ * exceed -90 to 90 or -180 to 180.
+ *
+ * \sa distance_long_path(), azimuth_long_path()
+ */
+int HAMLIB_API qrb(double lon1,
+                   double lat1,
+                   double lon2,
+                   double lat2,
+                   double *distance,
+                   double *azimuth)
+{
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    /* bail if NULL pointers passed */
+    if (!distance || !azimuth)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if ((lat1 > 90.0 || lat1 < -90.0) || (lat2 > 90.0 || lat2 < -90.0))
+    {
+        return -RIG_EINVAL;
+    }
+
+    if ((lon1 > 180.0 || lon1 < -180.0) || (lon2 > 180.0 || lon2 < -180.0))
+    {
+        return -RIG_EINVAL;
+    }
+
+    lat1 = qrb_pole_clamp(lat1) / RADIAN;
+
+    qrb_calc(lon1 / RADIAN, sin(lat1), cos(lat1), lon2, lat2, distance, azimuth);
 
     return RIG_OK;
 }
@@ -783,4 +843,220 @@ double HAMLIB_API azimuth_long_path(double azimuth)
     }
 }
 
+/**
+ * \brief Prepare a home QTH for qrb_home_batch().
+ *
+ * \param home The structure to fill in.
+ * \param lon The home Longitude, decimal degrees.
+ * \param lat The home Latitude, decimal degrees.
+ *
+ * Works out the sine and cosine of the home latitude once, so that
+ * distances and bearings from the same station do not recompute them.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_OK \a home is ready.
+ * \retval RIG_EINVAL If \a home is NULL or \a lat and \a lon values exceed
+ * -90 to 90 or -180 to 180.
+ *
+ * \sa qrb_home_batch()
+ */
+int HAMLIB_API qrb_home_init(struct qrb_home *home, double lon, double lat)
+{
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!home || !qrb_valid(lon, lat))
+    {
+        return -RIG_EINVAL;
+    }
+
+    lat = qrb_pole_clamp(lat) / RADIAN;
+
+    home->lon = lon / RADIAN;
+    home->sin_lat = sin(lat);
+    home->cos_lat = cos(lat);
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Calculate the distance and bearing from one station to many.
+ *
+ * \param home The local station, see qrb_home_init().
+ * \param lon2 The remote Longitudes, decimal degrees.
+ * \param lat2 The remote Latitudes, decimal degrees.
+ * \param n The number of remote stations.
+ * \param dist Array of \a n for the distances, km.
+ * \param az Array of \a n for the bearings, decimal degrees.
+ *
+ * Same results as qrb() for each remote station, without logging.  A
+ * remote station out of range gets NAN for distance and bearing.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_OK The calculations were done.
+ * \retval RIG_EINVAL If a NULL pointer was passed.
+ *
+ * \sa qrb(), qrb_batch()
+ */
+int HAMLIB_API qrb_home_batch(const struct qrb_home *home,
+                              const double *lon2,
+                              const double *lat2,
+                              size_t n,
+                              double *dist,
+                              double *az)
+{
+    size_t i;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called, n=%lu\n", __func__,
+              (unsigned long)n);
+
+    if (!home || !lon2 || !lat2 || !dist || !az)
+    {
+        return -RIG_EINVAL;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        if (!qrb_valid(lon2[i], lat2[i]))
+        {
+            dist[i] = az[i] = NAN;
+            continue;
+        }
+
+        qrb_calc(home->lon, home->sin_lat, home->cos_lat, lon2[i], lat2[i],
+                 &dist[i], &az[i]);
+    }
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Calculate the distance and bearing between many pairs of points.
+ *
+ * \param lon1 The local Longitudes, decimal degrees.
+ * \param lat1 The local Latitudes, decimal degrees.
+ * \param lon2 The remote Longitudes, decimal degrees.
+ * \param lat2 The remote Latitudes, decimal degrees.
+ * \param n The number of pairs.
+ * \param dist Array of \a n for the distances, km.
+ * \param az Array of \a n for the bearings, decimal degrees.
+ *
+ * Same results as qrb() for each pair, without logging.  A pair with a
+ * point out of range gets NAN for distance and bearing.  When all pairs
+ * share the local station, qrb_home_batch() does less work.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_OK The calculations were done.
+ * \retval RIG_EINVAL If a NULL pointer was passed.
+ *
+ * \sa qrb(), qrb_home_batch()
+ */
+int HAMLIB_API qrb_batch(const double *lon1,
+                         const double *lat1,
+                         const double *lon2,
+                         const double *lat2,
+                         size_t n,
+                         double *dist,
+                         double *az)
+{
+    size_t i;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called, n=%lu\n", __func__,
+              (unsigned long)n);
+
+    if (!lon1 || !lat1 || !lon2 || !lat2 || !dist || !az)
+    {
+        return -RIG_EINVAL;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        double lat;
+
+        if (!qrb_valid(lon1[i], lat1[i]) || !qrb_valid(lon2[i], lat2[i]))
+        {
+            dist[i] = az[i] = NAN;
+            continue;
+        }
+
+        lat = qrb_pole_clamp(lat1[i]) / RADIAN;
+
+        qrb_calc(lon1[i] / RADIAN, sin(lat), cos(lat), lon2[i], lat2[i],
+                 &dist[i], &az[i]);
+    }
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Convert a list of QRA locators to Longitude/Latitude.
+ *
+ * \param locators QRA locators separated by white space, e.g.
+ * `"IN98XC DM33DX"`.
+ * \param lon Array of \a n for the Longitudes, decimal degrees.
+ * \param lat Array of \a n for the Latitudes, decimal degrees.
+ * \param n The size of \a lon and \a lat.
+ *
+ * Converts each locator as locator2longlat() does, up to \a n of them,
+ * without logging.  A malformed locator gets NAN for longitude and latitude
+ * and does not stop the conversion.
+ *
+ * \return The number of locators converted, otherwise a **negative value**
+ * if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_EINVAL If a NULL pointer was passed.
+ *
+ * \sa locator2longlat()
+ */
+int HAMLIB_API locator2longlat_batch(const char *locators,
+                                     double *lon,
+                                     double *lat,
+                                     size_t n)
+{
+    const char *p = locators;
+    size_t i;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!locators || !lon || !lat)
+    {
+        return -RIG_EINVAL;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        size_t len;
+
+        while (isspace((unsigned char)*p))
+        {
+            p++;
+        }
+
+        if (*p == '\0')
+        {
+            break;
+        }
+
+        for (len = 0; p[len] != '\0' && !isspace((unsigned char)p[len]); len++)
+            ;
+
+        if (loc_decode(p, len, &lon[i], &lat[i]) != RIG_OK)
+        {
+            lon[i] = lat[i] = NAN;
+        }
+
+        p += len;
+    }
+
+    return (int)i;
+}
+
 /*! @} */
@@ -34,6 +34,7 @@
 
 #include <hamlib/config.h>
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
@@ -43,6 +44,10 @@
 #include <fcntl.h>
 
 #include <hamlib/rig.h>
+#include "cache.h"
+#include "clone.h"
+#include "caps_index.h"
+#include "chancache.h"
 
 #ifndef DOC_HIDDEN
 
@@ -351,6 +356,38 @@ static int rig_mem_caps_empty(const channel_cap_t *mem_cap)
 }
 
 
+/*
+ * mem_cap_all trimmed down to what the backend can actually read, so
+ * a channel without mem_caps costs one query per readable property
+ * instead of one per property, with frontend emulation for the rest.
+ */
+static void generic_readable_mem_caps(RIG *rig, channel_cap_t *mem_cap)
+{
+    const struct rig_caps *rc = rig->caps;
+
+    *mem_cap = mem_cap_all;
+
+    mem_cap->vfo = rc->get_vfo != NULL;
+    mem_cap->ant = rc->get_ant != NULL;
+    mem_cap->mode = mem_cap->width = rc->get_mode != NULL;
+    mem_cap->split = mem_cap->tx_vfo = rc->get_split_vfo != NULL;
+    mem_cap->tx_freq = rc->get_split_freq != NULL;
+    mem_cap->tx_mode = mem_cap->tx_width = rc->get_split_mode != NULL;
+    mem_cap->rptr_shift = rc->get_rptr_shift != NULL;
+    mem_cap->rptr_offs = rc->get_rptr_offs != NULL;
+    mem_cap->tuning_step = rc->get_ts != NULL;
+    mem_cap->rit = rc->get_rit != NULL;
+    mem_cap->xit = rc->get_xit != NULL;
+    mem_cap->funcs = rig->state.has_get_func;
+    mem_cap->levels = rig->state.has_get_level;
+    mem_cap->ctcss_tone = rc->get_ctcss_tone != NULL;
+    mem_cap->ctcss_sql = rc->get_ctcss_sql != NULL;
+    mem_cap->dcs_code = rc->get_dcs_code != NULL;
+    mem_cap->dcs_sql = rc->get_dcs_sql != NULL;
+    mem_cap->ext_levels = rc->extlevels != NULL && rc->get_ext_level != NULL;
+}
+
+
 /*
  * stores current VFO state into chan by emulating rig_get_channel
  */
@@ -361,6 +398,7 @@ static int generic_save_channel(RIG *rig, channel_t *chan)
     vfo_t vfo;
     setting_t setting;
     const channel_cap_t *mem_cap = NULL;
+    channel_cap_t readable;
     value_t vdummy = {0};
 
     chan_num = chan->channel_num;
@@ -380,10 +418,11 @@ static int generic_save_channel(RIG *rig, channel_t *chan)
         }
     }
 
-    /* If vfo!=RIG_VFO_MEM or incomplete backend, try all properties */
+    /* If vfo!=RIG_VFO_MEM or incomplete backend, try all readable properties */
     if (mem_cap == NULL || rig_mem_caps_empty(mem_cap))
     {
-        mem_cap = &mem_cap_all;
+        generic_readable_mem_caps(rig, &readable);
+        mem_cap = &readable;
     }
 
     if (mem_cap->freq)
@@ -515,7 +554,10 @@ static int generic_save_channel(RIG *rig, channel_t *chan)
      * - flags
      */
 
-    rig_ext_level_foreach(rig, generic_retr_extl, (rig_ptr_t)chan);
+    if (mem_cap->ext_levels)
+    {
+        rig_ext_level_foreach(rig, generic_retr_extl, (rig_ptr_t)chan);
+    }
 
     return RIG_OK;
 }
@@ -660,6 +702,8 @@ static int generic_restore_channel(RIG *rig, const channel_t *chan)
 
     return RIG_OK;
 }
+
+static int set_channel(RIG *rig, vfo_t vfo, const channel_t *chan);
 #endif  /* !DOC_HIDDEN */
 
 
@@ -685,12 +729,7 @@ static int generic_restore_channel(RIG *rig, const channel_t *chan)
  */
 int HAMLIB_API rig_set_channel(RIG *rig, vfo_t vfo, const channel_t *chan)
 {
-    struct rig_caps *rc;
-    int curr_chan_num = -1, get_mem_status = RIG_OK;
-    vfo_t curr_vfo;
-    vfo_t vfotmp; /* requested vfo */
     int retcode;
-    int can_emulate_by_vfo_mem, can_emulate_by_vfo_op;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -699,6 +738,26 @@ int HAMLIB_API rig_set_channel(RIG *rig, vfo_t vfo, const channel_t *chan)
         return -RIG_EINVAL;
     }
 
+    retcode = set_channel(rig, vfo, chan);
+
+    /* written or half written, read it again next time */
+    if (chan->vfo == RIG_VFO_MEM)
+    {
+        rig_chan_cache_invalidate(rig, chan->channel_num);
+    }
+
+    return retcode;
+}
+
+static int set_channel(RIG *rig, vfo_t vfo, const channel_t *chan)
+{
+    struct rig_caps *rc;
+    int curr_chan_num = -1, get_mem_status = RIG_OK;
+    vfo_t curr_vfo;
+    vfo_t vfotmp; /* requested vfo */
+    int retcode;
+    int can_emulate_by_vfo_mem, can_emulate_by_vfo_op;
+
     /*
      * TODO: check validity of chan->channel_num
      */
@@ -836,6 +895,7 @@ int HAMLIB_API rig_get_channel(RIG *rig, vfo_t vfox, channel_t *chan,
     vfo_t vfotmp = RIG_VFO_NONE; /* requested vfo */
     int retcode = RIG_OK;
     int can_emulate_by_vfo_mem, can_emulate_by_vfo_op;
+    int mem_ch;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -849,10 +909,19 @@ int HAMLIB_API rig_get_channel(RIG *rig, vfo_t vfox, channel_t *chan,
      */
 
     rc = rig->caps;
+    mem_ch = chan->vfo == RIG_VFO_MEM ? chan->channel_num : -1;
+
+    /* the chan_cache conf, see chancache.c */
+    if (read_only && mem_ch >= 0 && chan_cache_get(rig, mem_ch, chan, &retcode))
+    {
+        return retcode;
+    }
 
     if (rc->get_channel)
     {
-        return rc->get_channel(rig, vfotmp, chan, read_only);
+        retcode = rc->get_channel(rig, vfotmp, chan, read_only);
+        chan_cache_store(rig, mem_ch, chan, retcode);
+        return retcode;
     }
 
     /*
@@ -919,6 +988,7 @@ int HAMLIB_API rig_get_channel(RIG *rig, vfo_t vfox, channel_t *chan,
         }
 
         retcode = generic_save_channel(rig, chan);
+        chan_cache_store(rig, mem_ch, chan, retcode);
 
         /* restore current memory number */
         if (vfotmp == RIG_VFO_MEM && get_mem_status == RIG_OK)
@@ -938,8 +1008,97 @@ int HAMLIB_API rig_get_channel(RIG *rig, vfo_t vfox, channel_t *chan,
 
 
 #ifndef DOC_HIDDEN
-int get_chan_all_cb_generic(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
-                            rig_ptr_t arg)
+/*
+ * Without a backend get_channel, rig_get_channel() emulates every read by
+ * switching to memory mode, selecting the channel, reading it and switching
+ * back again.  A whole bank dump switches once, walks the channels with
+ * set_mem and restores the VFO and memory channel once at the end.
+ */
+struct generic_mem_walk
+{
+    vfo_t vfo;          /* VFO to go back to */
+    int mem;            /* memory channel to go back to, -1 if unknown */
+    int by_vfo_op;      /* copy each channel to the VFO with RIG_OP_TO_VFO */
+};
+
+static int generic_mem_walk_begin(RIG *rig, struct generic_mem_walk *walk)
+{
+    const struct rig_caps *rc = rig->caps;
+    int by_vfo_mem;
+
+    if (!rc->set_mem)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    by_vfo_mem = rc->set_vfo
+                 && ((rig->state.vfo_list & RIG_VFO_MEM) == RIG_VFO_MEM);
+
+    walk->by_vfo_op = !by_vfo_mem && rc->vfo_op
+                      && rig_has_vfo_op(rig, RIG_OP_TO_VFO);
+
+    if (!by_vfo_mem && !walk->by_vfo_op)
+    {
+        return -RIG_ENTARGET;
+    }
+
+    walk->vfo = rig->state.current_vfo;
+
+    if (rig_get_mem(rig, RIG_VFO_CURR, &walk->mem) != RIG_OK)
+    {
+        walk->mem = -1;
+    }
+
+    if (by_vfo_mem && walk->vfo != RIG_VFO_MEM)
+    {
+        return rig_set_vfo(rig, RIG_VFO_MEM);
+    }
+
+    return RIG_OK;
+}
+
+static int generic_mem_walk_read(RIG *rig, const struct generic_mem_walk *walk,
+                                 channel_t *chan)
+{
+    int retval = rig_set_mem(rig, RIG_VFO_CURR, chan->channel_num);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    if (walk->by_vfo_op)
+    {
+        retval = rig_vfo_op(rig, RIG_VFO_CURR, RIG_OP_TO_VFO);
+
+        if (retval != RIG_OK)
+        {
+            return retval;
+        }
+    }
+
+    /* whatever the cache holds belongs to the previous channel */
+    rig_set_cache_freq(rig, RIG_VFO_ALL, 0);
+    rig_set_cache_mode(rig, RIG_VFO_ALL, RIG_MODE_NONE, 0);
+
+    return generic_save_channel(rig, chan);
+}
+
+static void generic_mem_walk_end(RIG *rig, const struct generic_mem_walk *walk)
+{
+    if (walk->mem >= 0)
+    {
+        rig_set_mem(rig, RIG_VFO_CURR, walk->mem);
+    }
+
+    if (!walk->by_vfo_op && rig->state.current_vfo != walk->vfo)
+    {
+        rig_set_vfo(rig, walk->vfo);
+    }
+}
+
+static int get_chan_all_cb_walk(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
+                                rig_ptr_t arg, const struct generic_mem_walk *walk)
 {
     int i, j;
     chan_t *chan_list = rig->state.chan_list;
@@ -974,10 +1133,14 @@ int get_chan_all_cb_generic(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
             chan->vfo = RIG_VFO_MEM;
             chan->channel_num = j;
 
-            /*
-             * TODO: if doesn't have rc->get_channel, special generic
-             */
-            retval = rig_get_channel(rig, vfo, chan, 1);
+            if (walk)
+            {
+                retval = generic_mem_walk_read(rig, walk, chan);
+            }
+            else
+            {
+                retval = rig_get_channel(rig, vfo, chan, 1);
+            }
 
             if (retval == -RIG_ENAVAIL)
             {
@@ -1004,6 +1167,32 @@ int get_chan_all_cb_generic(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
 }
 
 
+int get_chan_all_cb_generic(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
+                            rig_ptr_t arg)
+{
+    struct generic_mem_walk walk;
+    int retval;
+
+    if (rig->caps->get_channel)
+    {
+        return get_chan_all_cb_walk(rig, vfo, chan_cb, arg, NULL);
+    }
+
+    retval = generic_mem_walk_begin(rig, &walk);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    retval = get_chan_all_cb_walk(rig, vfo, chan_cb, arg, &walk);
+
+    generic_mem_walk_end(rig, &walk);
+
+    return retval;
+}
+
+
 int set_chan_all_cb_generic(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
                             rig_ptr_t arg)
 {
@@ -1059,6 +1248,69 @@ static int map_chan(RIG *rig,
     return RIG_OK;
 }
 
+
+struct chan_cache_cb_s
+{
+    chan_cb_t chan_cb;
+    rig_ptr_t arg;
+};
+
+/* hands each channel read to the chan_cache on its way to the application */
+static int chan_cache_cb(RIG *rig,
+                         channel_t **chan,
+                         int channel_num,
+                         const chan_t *chan_list,
+                         rig_ptr_t arg)
+{
+    const struct chan_cache_cb_s *cb = (struct chan_cache_cb_s *)arg;
+
+    if (*chan != NULL)
+    {
+        chan_cache_store(rig, (*chan)->channel_num, *chan, RIG_OK);
+    }
+
+    return cb->chan_cb(rig, chan, channel_num, chan_list, cb->arg);
+}
+
+
+/* rig_get_chan_all_cb() and rig_get_chan_all() */
+static int get_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
+                           rig_ptr_t arg)
+{
+    const struct rig_caps *rc = rig->caps;
+    struct chan_cache_cb_s cb;
+    int retval;
+
+    cb.chan_cb = chan_cb;
+    cb.arg = arg;
+
+    if (rc->get_chan_all_cb)
+    {
+        retval = rc->get_chan_all_cb(rig, vfo, chan_cache_cb, (rig_ptr_t)&cb);
+    }
+    else if (rc->clone_read && rc->clone_layout)
+    {
+        retval = rig_clone_get_chan_all_cb(rig, vfo, chan_cache_cb, (rig_ptr_t)&cb);
+    }
+    else
+    {
+        /*
+         * if not available, emulate it
+         *
+         * TODO: save_current_state, restore_current_state
+         */
+        retval = get_chan_all_cb_generic(rig, vfo, chan_cache_cb, (rig_ptr_t)&cb);
+    }
+
+    /* the channels a whole bank read skipped are empty */
+    if (retval == RIG_OK)
+    {
+        chan_cache_mark_empty(rig);
+    }
+
+    return retval;
+}
+
 #endif  /* DOC_HIDDEN */
 
 
@@ -1092,6 +1344,8 @@ int HAMLIB_API rig_set_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
 
     rc = rig->caps;
 
+    rig_chan_cache_invalidate(rig, -1);
+
     if (rc->set_chan_all_cb)
     {
         return rc->set_chan_all_cb(rig, vfo, chan_cb, arg);
@@ -1127,9 +1381,6 @@ int HAMLIB_API rig_set_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
 int HAMLIB_API rig_get_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
                                    rig_ptr_t arg)
 {
-    struct rig_caps *rc;
-    int retval;
-
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_RIG_ARG(rig) || !chan_cb)
@@ -1137,18 +1388,7 @@ int HAMLIB_API rig_get_chan_all_cb(RIG *rig, vfo_t vfo, chan_cb_t chan_cb,
         return -RIG_EINVAL;
     }
 
-    rc = rig->caps;
-
-    if (rc->get_chan_all_cb)
-    {
-        return rc->get_chan_all_cb(rig, vfo, chan_cb, arg);
-    }
-
-
-    /* if not available, emulate it */
-    retval = get_chan_all_cb_generic(rig, vfo, chan_cb, arg);
-
-    return retval;
+    return get_chan_all_cb(rig, vfo, chan_cb, arg);
 }
 
 
@@ -1182,6 +1422,8 @@ int HAMLIB_API rig_set_chan_all(RIG *rig, vfo_t vfo, const channel_t chans[])
     memset(&map_arg, 0, sizeof(map_arg));
     map_arg.chans = (channel_t *) chans;
 
+    rig_chan_cache_invalidate(rig, -1);
+
     if (rc->set_chan_all_cb)
     {
         return rc->set_chan_all_cb(rig, vfo, map_chan, (rig_ptr_t)&map_arg);
@@ -1210,9 +1452,7 @@ int HAMLIB_API rig_set_chan_all(RIG *rig, vfo_t vfo, const channel_t chans[])
  */
 int HAMLIB_API rig_get_chan_all(RIG *rig, vfo_t vfo, channel_t chans[])
 {
-    struct rig_caps *rc;
     struct map_all_s map_arg;
-    int retval;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -1221,21 +1461,258 @@ int HAMLIB_API rig_get_chan_all(RIG *rig, vfo_t vfo, channel_t chans[])
         return -RIG_EINVAL;
     }
 
-    rc = rig->caps;
     memset(&map_arg, 0, sizeof(map_arg));
     map_arg.chans = chans;
 
-    if (rc->get_chan_all_cb)
+    return get_chan_all_cb(rig, vfo, map_chan, (rig_ptr_t)&map_arg);
+}
+
+
+#ifndef DOC_HIDDEN
+#define CHAN_DIGEST_INIT 0xcbf29ce484222325ULL
+
+/* FNV-1a over one field */
+static void chan_digest_add(uint64_t *h, const void *p, size_t len)
+{
+    const unsigned char *b = p;
+
+    while (len--)
+    {
+        *h = (*h ^ *b++) * 0x100000001b3ULL;
+    }
+}
+
+#define CHAN_DIGEST(h, cap, field) \
+    do { if (cap) { chan_digest_add(&(h), &(field), sizeof(field)); } } while (0)
+
+/*
+ * Digest of what a channel holds, limited to the properties its mem_caps
+ * says the rig stores, so two channels that would read back the same from
+ * the radio digest the same.  All empty channels digest alike.
+ */
+static uint64_t chan_digest(RIG *rig, const channel_t *chan)
+{
+    const chan_t *chan_cap = rig_lookup_mem_caps(rig, chan->channel_num);
+    const channel_cap_t *mem_cap = chan_cap ? &chan_cap->mem_caps : NULL;
+    uint64_t h = CHAN_DIGEST_INIT;
+    int i;
+
+    if (chan->freq == RIG_FREQ_NONE)
     {
-        return rc->get_chan_all_cb(rig, vfo, map_chan, (rig_ptr_t)&map_arg);
+        return h;
     }
 
-    /*
-     * if not available, emulate it
-     *
-     * TODO: save_current_state, restore_current_state
-     */
-    retval = get_chan_all_cb_generic(rig, vfo, map_chan, (rig_ptr_t)&map_arg);
+    if (mem_cap == NULL || rig_mem_caps_empty(mem_cap))
+    {
+        mem_cap = &mem_cap_all;
+    }
+
+    CHAN_DIGEST(h, mem_cap->bank_num, chan->bank_num);
+    CHAN_DIGEST(h, mem_cap->ant, chan->ant);
+    CHAN_DIGEST(h, mem_cap->freq, chan->freq);
+    CHAN_DIGEST(h, mem_cap->mode, chan->mode);
+    CHAN_DIGEST(h, mem_cap->width, chan->width);
+    CHAN_DIGEST(h, mem_cap->split, chan->split);
+
+    if (chan->split != RIG_SPLIT_OFF)
+    {
+        CHAN_DIGEST(h, mem_cap->tx_freq, chan->tx_freq);
+        CHAN_DIGEST(h, mem_cap->tx_mode, chan->tx_mode);
+        CHAN_DIGEST(h, mem_cap->tx_width, chan->tx_width);
+        CHAN_DIGEST(h, mem_cap->tx_vfo, chan->tx_vfo);
+    }
+
+    CHAN_DIGEST(h, mem_cap->rptr_shift, chan->rptr_shift);
+    CHAN_DIGEST(h, mem_cap->rptr_offs, chan->rptr_offs);
+    CHAN_DIGEST(h, mem_cap->tuning_step, chan->tuning_step);
+    CHAN_DIGEST(h, mem_cap->rit, chan->rit);
+    CHAN_DIGEST(h, mem_cap->xit, chan->xit);
+
+    if (mem_cap->funcs)
+    {
+        setting_t funcs = chan->funcs & mem_cap->funcs;
+        chan_digest_add(&h, &funcs, sizeof(funcs));
+    }
+
+    for (i = 0; i < RIG_SETTING_MAX; i++)
+    {
+        CHAN_DIGEST(h, mem_cap->levels & rig_idx2setting(i), chan->levels[i]);
+    }
+
+    CHAN_DIGEST(h, mem_cap->ctcss_tone, chan->ctcss_tone);
+    CHAN_DIGEST(h, mem_cap->ctcss_sql, chan->ctcss_sql);
+    CHAN_DIGEST(h, mem_cap->dcs_code, chan->dcs_code);
+    CHAN_DIGEST(h, mem_cap->dcs_sql, chan->dcs_sql);
+    CHAN_DIGEST(h, mem_cap->scan_group, chan->scan_group);
+    CHAN_DIGEST(h, mem_cap->flags, chan->flags);
+
+    if (mem_cap->channel_desc)
+    {
+        chan_digest_add(&h, chan->channel_desc,
+                        strnlen(chan->channel_desc, sizeof(chan->channel_desc)));
+    }
+
+    return h;
+}
+
+/* write order: by bank, then channel number */
+static int chan_delta_cmp(const void *a, const void *b)
+{
+    const channel_t *ca = *(const channel_t * const *)a;
+    const channel_t *cb = *(const channel_t * const *)b;
+
+    if (ca->bank_num != cb->bank_num)
+    {
+        return ca->bank_num < cb->bank_num ? -1 : 1;
+    }
+
+    return ca->channel_num - cb->channel_num;
+}
+#endif /* !DOC_HIDDEN */
+
+
+/**
+ * \brief write only the channels that differ from what the rig holds
+ * \param rig       The rig handle
+ * \param vfo       The target VFO
+ * \param chans     The wanted content of all the memory channels
+ * \param current   What the rig holds now, or NULL to read it first
+ * \param nwritten  If not NULL, set to the number of channels written
+ *
+ *  Like rig_set_chan_all(), \a chans and \a current are indexed by
+ *  channel number.  A channel is written only when its digest over the
+ *  properties in its mem_caps differs from the one in \a current, and
+ *  wanted channels with a freq of RIG_FREQ_NONE clear the ones still in
+ *  use.  Writes go in bank order, so rig_set_bank() is called once per
+ *  bank instead of once per channel.
+ *
+ *  \a current can be the \a chans of the previous successful sync when
+ *  nothing else writes the rig memories, which saves reading them back.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_set_chan_all(), rig_get_chan_all()
+ */
+int HAMLIB_API rig_set_chan_all_delta(RIG *rig, vfo_t vfo,
+                                      const channel_t chans[],
+                                      const channel_t current[], int *nwritten)
+{
+    const chan_t *chan_list;
+    channel_t *fetched = NULL;
+    const channel_t **todo;
+    int nchan = 0, ntodo = 0;
+    int bank = -1;
+    int retval = RIG_OK;
+    int i, j;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (CHECK_RIG_ARG(rig) || !chans)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (nwritten) { *nwritten = 0; }
+
+    chan_list = rig->state.chan_list;
+
+    for (i = 0; !RIG_IS_CHAN_END(chan_list[i]) && i < HAMLIB_CHANLSTSIZ; i++)
+    {
+        if (chan_list[i].endc >= nchan) { nchan = chan_list[i].endc + 1; }
+    }
+
+    if (nchan == 0)
+    {
+        return RIG_OK;
+    }
+
+    if (!current)
+    {
+        fetched = calloc(nchan, sizeof(channel_t));
+
+        if (!fetched)
+        {
+            return -RIG_ENOMEM;
+        }
+
+        retval = rig_get_chan_all(rig, vfo, fetched);
+
+        if (retval != RIG_OK)
+        {
+            free(fetched);
+            return retval;
+        }
+
+        current = fetched;
+    }
+
+    todo = calloc(nchan, sizeof(*todo));
+
+    if (!todo)
+    {
+        free(fetched);
+        return -RIG_ENOMEM;
+    }
+
+    for (i = 0; !RIG_IS_CHAN_END(chan_list[i]) && i < HAMLIB_CHANLSTSIZ; i++)
+    {
+        for (j = chan_list[i].startc; j <= chan_list[i].endc; j++)
+        {
+            if (current[j].channel_num != j && current[j].freq != RIG_FREQ_NONE)
+            {
+                continue;   /* not filled in for this channel, leave it alone */
+            }
+
+            if (chans[j].freq == RIG_FREQ_NONE && current[j].freq == RIG_FREQ_NONE)
+            {
+                continue;
+            }
+
+            if (chan_digest(rig, &chans[j]) != chan_digest(rig, &current[j]))
+            {
+                todo[ntodo++] = &chans[j];
+            }
+        }
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %d of %d channels differ\n", __func__,
+              ntodo, nchan);
+
+    qsort(todo, ntodo, sizeof(*todo), chan_delta_cmp);
+
+    for (i = 0; i < ntodo; i++)
+    {
+        channel_t chan = *todo[i];
+
+        if (rig->caps->set_bank && chan.bank_num != bank)
+        {
+            retval = rig_set_bank(rig, vfo, chan.bank_num);
+
+            if (retval != RIG_OK)
+            {
+                break;
+            }
+
+            bank = chan.bank_num;
+        }
+
+        chan.vfo = RIG_VFO_MEM;
+        retval = rig_set_channel(rig, vfo, &chan);
+
+        if (retval != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: channel %d: %s\n", __func__,
+                      chan.channel_num, rigerror(retval));
+            break;
+        }
+
+        if (nwritten) { (*nwritten)++; }
+    }
+
+    free(todo);
+    free(fetched);
 
     return retval;
 }
@@ -1344,6 +1821,7 @@ int HAMLIB_API rig_set_mem_all_cb(RIG *rig,
 
     if (rc->set_mem_all_cb)
     {
+        rig_chan_cache_invalidate(rig, -1);
         return rc->set_mem_all_cb(rig, chan_cb, parm_cb, arg);
     }
 
@@ -1481,8 +1959,11 @@ int HAMLIB_API rig_set_mem_all(RIG *rig,
     mem_all_arg.vals = (value_t *) vals;
 
     if (rc->set_mem_all_cb)
+    {
+        rig_chan_cache_invalidate(rig, -1);
         return rc->set_mem_all_cb(rig, map_chan, map_parm,
                                   (rig_ptr_t)&mem_all_arg);
+    }
 
     /* if not available, emulate it */
     retval = rig_set_chan_all(rig, vfo, chans);
@@ -1579,7 +2060,8 @@ int HAMLIB_API rig_get_mem_all(RIG *rig,
  *
  *  Lookup the memory type and capabilities associated with a channel number.
  *  If \a ch equals RIG_MEM_CAPS_ALL, then a union of all the mem_caps sets
- *  is returned (pointer to static memory).
+ *  is returned (pointer to static memory, or into the rig handle once it
+ *  is open).
  *
  * \return a pointer to a chan_t structure if the operation has been successful,
  * otherwise a NULL pointer, most probably because of incorrect channel number
@@ -1589,6 +2071,7 @@ const chan_t *HAMLIB_API rig_lookup_mem_caps(RIG *rig, int ch)
 {
     chan_t *chan_list;
     static chan_t chan_list_all;
+    const chan_t *chan;
     int i;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
@@ -1598,6 +2081,11 @@ const chan_t *HAMLIB_API rig_lookup_mem_caps(RIG *rig, int ch)
         return NULL;
     }
 
+    if (rig_caps_index_chan(rig, ch, &chan) == RIG_OK)
+    {
+        return chan;
+    }
+
     if (ch == RIG_MEM_CAPS_ALL)
     {
         memset(&chan_list_all, 0, sizeof(chan_list_all));
@@ -0,0 +1,623 @@
+/*
+ *  Hamlib Interface - OpenMetrics exposition of cached telemetry
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * rig_get_metrics(), rot_get_metrics() and amp_get_metrics() write what the
+ * caches and the transaction counters hold in the OpenMetrics text format,
+ * for a Prometheus scrape of the daemons.  They never call a backend: a
+ * value that was never read is left out rather than asked for, and every
+ * cached value comes with its age so a dashboard can tell a stale reading
+ * from a current one.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include <hamlib/rig.h>
+#include <hamlib/rotator.h>
+#include <hamlib/amplifier.h>
+#include "cache.h"
+
+//! @cond Doxygen_Suppress
+
+#define METRICS_NEVER 1000000   /* rig_cache_age() of a stamp never set */
+
+struct metrics_writer
+{
+    char *buf;
+    size_t len;
+    size_t pos;
+    int truncated;
+};
+
+static void mw_printf(struct metrics_writer *w, const char *fmt, ...)
+{
+    va_list ap;
+    int n;
+
+    if (w->truncated) { return; }
+
+    va_start(ap, fmt);
+    n = vsnprintf(w->buf + w->pos, w->len - w->pos, fmt, ap);
+    va_end(ap);
+
+    if (n < 0 || (size_t) n >= w->len - w->pos)
+    {
+        w->buf[w->pos] = '\0';     /* whole lines only */
+        w->truncated = 1;
+        return;
+    }
+
+    w->pos += n;
+}
+
+static void mw_family(struct metrics_writer *w, const char *name,
+                      const char *type, const char *help)
+{
+    mw_printf(w, "# TYPE %s %s\n# HELP %s %s\n", name, type, name, help);
+}
+
+/* a label value with \, " and newlines escaped */
+static const char *mw_escape(const char *s, char *out, size_t size)
+{
+    size_t n = 0;
+
+    for (; s && *s && n + 2 < size; s++)
+    {
+        if (*s == '\\' || *s == '"') { out[n++] = '\\'; out[n++] = *s; }
+        else if (*s == '\n') { out[n++] = '\\'; out[n++] = 'n'; }
+        else { out[n++] = *s; }
+    }
+
+    out[n] = '\0';
+
+    return out;
+}
+
+static void mw_info(struct metrics_writer *w, const char *name,
+                    const char *help, const char *model, const char *mfg,
+                    const char *version)
+{
+    char m[64], f[64], v[64];
+
+    mw_family(w, name, "info", help);
+    mw_printf(w, "%s_info{model=\"%s\",manufacturer=\"%s\",backend_version=\"%s\"} 1\n",
+              name, mw_escape(model, m, sizeof(m)), mw_escape(mfg, f, sizeof(f)),
+              mw_escape(version, v, sizeof(v)));
+}
+
+static int mw_finish(struct metrics_writer *w)
+{
+    mw_printf(w, "# EOF\n");
+
+    return w->truncated ? -RIG_ETRUNC : RIG_OK;
+}
+
+/* age of a stamp taken with elapsed_ms(), -1 if it was never set */
+static double metrics_age(const struct timespec *t, const struct timespec *now)
+{
+    if (t->tv_sec == 0 && t->tv_nsec == 0) { return -1; }
+
+    return (now->tv_sec - t->tv_sec) + (now->tv_nsec - t->tv_nsec) / 1e9;
+}
+
+static const char *const metrics_cache_items[HAMLIB_CACHE_FUNC + 1] =
+{
+    "all", "vfo", "freq", "mode", "ptt", "split", "width", "level", "func"
+};
+
+static const char *const metrics_prio_names[RIG_PRIO_N] =
+{
+    "safety", "set", "get", "background"
+};
+
+static void rig_metrics_stats(struct metrics_writer *w, RIG *rig)
+{
+    struct rig_stats st;
+    uint64_t count = 0;
+    int i;
+
+    rig_get_stats(rig, &st);
+
+    mw_family(w, "hamlib_rig_transactions", "counter",
+              "Backend transactions completed.");
+    mw_printf(w, "hamlib_rig_transactions_total %" PRIu64 "\n", st.transactions);
+    mw_family(w, "hamlib_rig_errors", "counter",
+              "Transactions that ended in an error.");
+    mw_printf(w, "hamlib_rig_errors_total %" PRIu64 "\n", st.errors);
+    mw_family(w, "hamlib_rig_timeouts", "counter", "Read timeouts on the rig port.");
+    mw_printf(w, "hamlib_rig_timeouts_total %" PRIu64 "\n", st.timeouts);
+    mw_family(w, "hamlib_rig_retries", "counter", "Transaction retries.");
+    mw_printf(w, "hamlib_rig_retries_total %" PRIu64 "\n", st.retries);
+    mw_family(w, "hamlib_rig_sent_bytes", "counter",
+              "Bytes written to the rig port.");
+    mw_printf(w, "hamlib_rig_sent_bytes_total %" PRIu64 "\n", st.bytes_out);
+    mw_family(w, "hamlib_rig_received_bytes", "counter",
+              "Bytes read from the rig port.");
+    mw_printf(w, "hamlib_rig_received_bytes_total %" PRIu64 "\n", st.bytes_in);
+
+    // bucket n of the counters holds 2^n..2^(n+1)-1 us
+    mw_family(w, "hamlib_rig_transaction_latency_seconds", "histogram",
+              "Backend transaction latency.");
+
+    for (i = 0; i < (int)(sizeof(st.latency_hist) / sizeof(st.latency_hist[0]));
+            i++)
+    {
+        count += st.latency_hist[i];
+        mw_printf(w, "hamlib_rig_transaction_latency_seconds_bucket{le=\"%g\"} %"
+                  PRIu64 "\n", (double)((uint64_t) 2 << i) / 1e6, count);
+    }
+
+    mw_printf(w, "hamlib_rig_transaction_latency_seconds_bucket{le=\"+Inf\"} %"
+              PRIu64 "\n", count);
+    mw_printf(w, "hamlib_rig_transaction_latency_seconds_count %" PRIu64 "\n",
+              count);
+    mw_printf(w, "hamlib_rig_transaction_latency_seconds_sum %g\n",
+              st.latency_total_us / 1e6);
+    mw_family(w, "hamlib_rig_transaction_latency_max_seconds", "gauge",
+              "Slowest backend transaction.");
+    mw_printf(w, "hamlib_rig_transaction_latency_max_seconds %g\n",
+              st.latency_max_us / 1e6);
+
+    // width is checked together with mode and has no counters of its own
+    mw_family(w, "hamlib_rig_cache_hits", "counter",
+              "Getter calls answered from the cache.");
+
+    for (i = HAMLIB_CACHE_VFO; i <= HAMLIB_CACHE_FUNC; i++)
+    {
+        if (i == HAMLIB_CACHE_WIDTH) { continue; }
+
+        mw_printf(w, "hamlib_rig_cache_hits_total{item=\"%s\"} %" PRIu64 "\n",
+                  metrics_cache_items[i], st.cache_hit[i]);
+    }
+
+    mw_family(w, "hamlib_rig_cache_misses", "counter",
+              "Getter calls that had to ask the rig.");
+
+    for (i = HAMLIB_CACHE_VFO; i <= HAMLIB_CACHE_FUNC; i++)
+    {
+        if (i == HAMLIB_CACHE_WIDTH) { continue; }
+
+        mw_printf(w, "hamlib_rig_cache_misses_total{item=\"%s\"} %" PRIu64 "\n",
+                  metrics_cache_items[i], st.cache_miss[i]);
+    }
+
+    mw_family(w, "hamlib_rig_lock_acquisitions", "counter",
+              "API lock acquisitions by priority class.");
+
+    for (i = 0; i < RIG_PRIO_N; i++)
+    {
+        mw_printf(w, "hamlib_rig_lock_acquisitions_total{class=\"%s\"} %" PRIu64 "\n",
+                  metrics_prio_names[i], st.lock_calls[i]);
+    }
+
+    mw_family(w, "hamlib_rig_lock_wait_seconds", "counter",
+              "Time spent waiting for the API lock by priority class.");
+
+    for (i = 0; i < RIG_PRIO_N; i++)
+    {
+        mw_printf(w, "hamlib_rig_lock_wait_seconds_total{class=\"%s\"} %g\n",
+                  metrics_prio_names[i], st.lock_wait_total_us[i] / 1e6);
+    }
+
+    mw_family(w, "hamlib_rig_lock_preemptions", "counter",
+              "Calls that let a PTT off through mid-call.");
+    mw_printf(w, "hamlib_rig_lock_preemptions_total %" PRIu64 "\n",
+              st.lock_preemptions);
+}
+
+/* the level cache slots that hold a value, for the A and B side */
+static void rig_metrics_levels(struct metrics_writer *w, RIG *rig)
+{
+    static const vfo_t sides[] = { RIG_VFO_A, RIG_VFO_B };
+    value_t vals[2][RIG_SETTING_MAX];
+    struct timespec times[2][RIG_SETTING_MAX];
+    int valid[2][RIG_SETTING_MAX];
+    setting_t levels = rig->state.has_get_level;
+    unsigned int seq;
+    int i, s, any = 0;
+
+    if (!rig->state.cache_settings) { return; }
+
+    do
+    {
+        seq = rig_cache_read_begin(rig);
+
+        for (s = 0; s < 2; s++)
+        {
+            for (i = 0; i < RIG_SETTING_MAX; i++)
+            {
+                setting_t level = rig_idx2setting(i);
+
+                valid[s][i] = (levels & level)
+                              && rig_cache_level_peek(rig, sides[s], level, &vals[s][i], &times[s][i]);
+                any |= valid[s][i];
+            }
+        }
+    }
+    while (rig_cache_read_retry(rig, seq));
+
+    if (!any) { return; }
+
+    mw_family(w, "hamlib_rig_level", "gauge",
+              "Last value of a level or meter in the cache.");
+
+    for (s = 0; s < 2; s++)
+    {
+        for (i = 0; i < RIG_SETTING_MAX; i++)
+        {
+            setting_t level = rig_idx2setting(i);
+
+            if (!valid[s][i]) { continue; }
+
+            mw_printf(w, "hamlib_rig_level{level=\"%s\",vfo=\"%s\"} %g\n",
+                      rig_strlevel(level), rig_strvfo(sides[s]),
+                      RIG_LEVEL_IS_FLOAT(level) ? vals[s][i].f : (double) vals[s][i].i);
+        }
+    }
+
+    mw_family(w, "hamlib_rig_level_age_seconds", "gauge",
+              "Age of the cached level value.");
+
+    for (s = 0; s < 2; s++)
+    {
+        for (i = 0; i < RIG_SETTING_MAX; i++)
+        {
+            if (!valid[s][i]) { continue; }
+
+            mw_printf(w, "hamlib_rig_level_age_seconds{level=\"%s\",vfo=\"%s\"} %g\n",
+                      rig_strlevel(rig_idx2setting(i)), rig_strvfo(sides[s]),
+                      rig_cache_age(rig, &times[s][i]) / 1e3);
+        }
+    }
+}
+
+//! @endcond
+
+/**
+ * \brief format cached state and transaction statistics as OpenMetrics
+ * \param rig   The rig handle
+ * \param buf   Buffer for the result
+ * \param len   Size of \a buf
+ *
+ * Writes a complete OpenMetrics text exposition, "# EOF" included, of
+ * the frequency, mode, PTT and split cache, the cached levels and meters
+ * (SWR, ALC, temperature and the like), and the counters and latency
+ * histogram of rig_get_stats().  Only the caches are read, so a scrape
+ * never causes a rig transaction; a value never read is left out.
+ *
+ * \return RIG_OK, -RIG_EINVAL, or -RIG_ETRUNC if \a buf was too small
+ * and holds the lines that fitted.
+ *
+ * \sa rig_get_stats(), rot_get_metrics(), amp_get_metrics()
+ */
+int HAMLIB_API rig_get_metrics(RIG *rig, char *buf, int len)
+{
+    static const vfo_t vfos[] = { RIG_VFO_A, RIG_VFO_B };
+    struct rig_cache_snapshot snap[2];
+    struct metrics_writer w = { buf, (size_t) len, 0, 0 };
+    int i;
+
+    if (!rig || !rig->caps || !buf || len < 1)
+    {
+        return -RIG_EINVAL;
+    }
+
+    buf[0] = '\0';
+
+    for (i = 0; i < 2; i++)
+    {
+        rig_cache_snapshot(rig, vfos[i], &snap[i]);
+    }
+
+    mw_info(&w, "hamlib_rig", "Rig model served.", rig->caps->model_name,
+            rig->caps->mfg_name, rig->caps->version);
+    mw_family(&w, "hamlib_rig_up", "gauge", "1 while the rig port is open.");
+    mw_printf(&w, "hamlib_rig_up %d\n", rig->state.comm_state ? 1 : 0);
+
+    mw_family(&w, "hamlib_rig_frequency_hertz", "gauge", "Cached VFO frequency.");
+
+    for (i = 0; i < 2; i++)
+    {
+        if (snap[i].freq_ms >= METRICS_NEVER) { continue; }
+
+        mw_printf(&w, "hamlib_rig_frequency_hertz{vfo=\"%s\"} %.0f\n",
+                  rig_strvfo(vfos[i]), snap[i].freq);
+    }
+
+    mw_family(&w, "hamlib_rig_passband_hertz", "gauge", "Cached VFO passband.");
+
+    for (i = 0; i < 2; i++)
+    {
+        if (snap[i].mode_ms >= METRICS_NEVER) { continue; }
+
+        mw_printf(&w, "hamlib_rig_passband_hertz{vfo=\"%s\"} %ld\n",
+                  rig_strvfo(vfos[i]), (long) snap[i].width);
+    }
+
+    mw_family(&w, "hamlib_rig_mode", "info", "Cached VFO mode.");
+
+    for (i = 0; i < 2; i++)
+    {
+        if (snap[i].mode_ms >= METRICS_NEVER) { continue; }
+
+        mw_printf(&w, "hamlib_rig_mode_info{vfo=\"%s\",mode=\"%s\"} 1\n",
+                  rig_strvfo(vfos[i]), rig_strrmode(snap[i].mode));
+    }
+
+    mw_family(&w, "hamlib_rig_ptt", "gauge", "Cached PTT state, 0 for receive.");
+
+    if (snap[0].ptt_set)
+    {
+        mw_printf(&w, "hamlib_rig_ptt %d\n", (int) snap[0].ptt);
+    }
+
+    mw_family(&w, "hamlib_rig_split", "gauge", "1 while split is on.");
+    mw_printf(&w, "hamlib_rig_split %d\n", snap[0].split == RIG_SPLIT_ON);
+
+    mw_family(&w, "hamlib_rig_cache_age_seconds", "gauge",
+              "Age of the cached frequency, mode and PTT.");
+
+    for (i = 0; i < 2; i++)
+    {
+        if (snap[i].freq_ms < METRICS_NEVER)
+        {
+            mw_printf(&w, "hamlib_rig_cache_age_seconds{item=\"freq\",vfo=\"%s\"} %g\n",
+                      rig_strvfo(vfos[i]), snap[i].freq_ms / 1e3);
+        }
+
+        if (snap[i].mode_ms < METRICS_NEVER)
+        {
+            mw_printf(&w, "hamlib_rig_cache_age_seconds{item=\"mode\",vfo=\"%s\"} %g\n",
+                      rig_strvfo(vfos[i]), snap[i].mode_ms / 1e3);
+        }
+    }
+
+    if (snap[0].ptt_set && snap[0].ptt_ms < METRICS_NEVER)
+    {
+        mw_printf(&w, "hamlib_rig_cache_age_seconds{item=\"ptt\"} %g\n",
+                  snap[0].ptt_ms / 1e3);
+    }
+
+    rig_metrics_levels(&w, rig);
+    rig_metrics_stats(&w, rig);
+
+    return mw_finish(&w);
+}
+
+/**
+ * \brief format the cached position and status as OpenMetrics
+ * \param rot   The rotator handle
+ * \param buf   Buffer for the result
+ * \param len   Size of \a buf
+ *
+ * Like rig_get_metrics(): the last azimuth, elevation and status read,
+ * their ages and how many times each was read from the controller,
+ * without asking the controller.  The position is reported as the
+ * controller gave it, before south_zero and the offsets.
+ *
+ * \return RIG_OK, -RIG_EINVAL, or -RIG_ETRUNC if \a buf was too small.
+ */
+int HAMLIB_API rot_get_metrics(ROT *rot, char *buf, int len)
+{
+    struct metrics_writer w = { buf, (size_t) len, 0, 0 };
+    struct rot_cache c;
+    struct timespec now;
+    unsigned int seq;
+    double age;
+    int tries = 0;
+
+    if (!rot || !rot->caps || !buf || len < 1)
+    {
+        return -RIG_EINVAL;
+    }
+
+    buf[0] = '\0';
+
+    // cache_lock is held across controller queries, so copy without it
+    do
+    {
+        seq = rot->state.cache.position_seq + rot->state.cache.status_seq;
+        memcpy(&c, &rot->state.cache, sizeof(c));
+    }
+    while (seq != rot->state.cache.position_seq + rot->state.cache.status_seq
+            && ++tries < 4);
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    mw_info(&w, "hamlib_rot", "Rotator model served.", rot->caps->model_name,
+            rot->caps->mfg_name, rot->caps->version);
+    mw_family(&w, "hamlib_rot_up", "gauge", "1 while the rotator port is open.");
+    mw_printf(&w, "hamlib_rot_up %d\n", rot->state.comm_state ? 1 : 0);
+
+    // open() invalidates the stamps, so go by the read counts
+    age = c.position_seq ? metrics_age(&c.time_position, &now) : -1;
+    mw_family(&w, "hamlib_rot_azimuth_degrees", "gauge", "Last azimuth read.");
+    mw_family(&w, "hamlib_rot_elevation_degrees", "gauge", "Last elevation read.");
+    mw_family(&w, "hamlib_rot_position_age_seconds", "gauge",
+              "Age of the last position read.");
+
+    if (age >= 0)
+    {
+        mw_printf(&w, "hamlib_rot_azimuth_degrees %g\n", c.az);
+        mw_printf(&w, "hamlib_rot_elevation_degrees %g\n", c.el);
+        mw_printf(&w, "hamlib_rot_position_age_seconds %g\n", age);
+    }
+
+    mw_family(&w, "hamlib_rot_position_reads", "counter",
+              "Positions read from the controller.");
+    mw_printf(&w, "hamlib_rot_position_reads_total %u\n", c.position_seq);
+
+    age = c.status_seq ? metrics_age(&c.time_status, &now) : -1;
+    mw_family(&w, "hamlib_rot_status", "gauge",
+              "Last status flags read, rot_status_t bits.");
+    mw_family(&w, "hamlib_rot_status_age_seconds", "gauge",
+              "Age of the last status read.");
+
+    if (age >= 0)
+    {
+        mw_printf(&w, "hamlib_rot_status %u\n", (unsigned) c.status);
+        mw_printf(&w, "hamlib_rot_status_age_seconds %g\n", age);
+    }
+
+    mw_family(&w, "hamlib_rot_status_reads", "counter",
+              "Status flags read from the controller.");
+    mw_printf(&w, "hamlib_rot_status_reads_total %u\n", c.status_seq);
+
+    return mw_finish(&w);
+}
+
+/**
+ * \brief format the cached amplifier readings as OpenMetrics
+ * \param amp   The amplifier handle
+ * \param buf   Buffer for the result
+ * \param len   Size of \a buf
+ *
+ * Like rig_get_metrics(): the last frequency, power status and level
+ * readings (SWR, power, temperature and the like) with their ages and
+ * read counts, without asking the amplifier.  A fault reported through
+ * AMP_LEVEL_FAULT shows as the "fault" label of hamlib_amp_fault_info.
+ *
+ * \return RIG_OK, -RIG_EINVAL, or -RIG_ETRUNC if \a buf was too small.
+ */
+int HAMLIB_API amp_get_metrics(AMP *amp, char *buf, int len)
+{
+    struct metrics_writer w = { buf, (size_t) len, 0, 0 };
+    struct amp_state *rs;
+    struct amp_cache c;
+    struct timespec now;
+    char fault[sizeof(c.fault) * 2];
+    double age;
+    int i;
+
+    if (!amp || !amp->caps || !buf || len < 1)
+    {
+        return -RIG_EINVAL;
+    }
+
+    buf[0] = '\0';
+    rs = &amp->state;
+
+    pthread_mutex_lock(&rs->cache_lock);
+    memcpy(&c, &rs->cache, sizeof(c));
+    pthread_mutex_unlock(&rs->cache_lock);
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    mw_info(&w, "hamlib_amp", "Amplifier model served.", amp->caps->model_name,
+            amp->caps->mfg_name, amp->caps->version);
+    mw_family(&w, "hamlib_amp_up", "gauge", "1 while the amplifier port is open.");
+    mw_printf(&w, "hamlib_amp_up %d\n", rs->comm_state ? 1 : 0);
+
+    mw_family(&w, "hamlib_amp_frequency_hertz", "gauge", "Last frequency read.");
+    // open() invalidates the stamps, so go by the read counts
+    age = c.freq_seq ? metrics_age(&c.time_freq, &now) : -1;
+
+    if (age >= 0)
+    {
+        mw_printf(&w, "hamlib_amp_frequency_hertz %.0f\n", c.freq);
+    }
+
+    mw_family(&w, "hamlib_amp_powerstat", "gauge",
+              "Last power status read, powerstat_t.");
+
+    if (c.powerstat_seq)
+    {
+        mw_printf(&w, "hamlib_amp_powerstat %d\n", (int) c.powerstat);
+    }
+
+    mw_family(&w, "hamlib_amp_level", "gauge", "Last level reading.");
+
+    for (i = 0; i < RIG_SETTING_MAX; i++)
+    {
+        setting_t level = rig_idx2setting(i);
+
+        if (!(rs->has_get_level & level) || AMP_LEVEL_IS_STRING(level)
+                || !c.level_seq[i])
+        {
+            continue;
+        }
+
+        mw_printf(&w, "hamlib_amp_level{level=\"%s\"} %g\n", amp_strlevel(level),
+                  AMP_LEVEL_IS_FLOAT(level) ? c.level[i].f : (double) c.level[i].i);
+    }
+
+    mw_family(&w, "hamlib_amp_age_seconds", "gauge",
+              "Age of the last reading of each item.");
+
+    if (age >= 0)
+    {
+        mw_printf(&w, "hamlib_amp_age_seconds{item=\"freq\"} %g\n", age);
+    }
+
+    if (c.powerstat_seq)
+    {
+        mw_printf(&w, "hamlib_amp_age_seconds{item=\"powerstat\"} %g\n",
+                  metrics_age(&c.time_powerstat, &now));
+    }
+
+    for (i = 0; i < RIG_SETTING_MAX; i++)
+    {
+        setting_t level = rig_idx2setting(i);
+
+        if (!(rs->has_get_level & level) || !c.level_seq[i])
+        {
+            continue;
+        }
+
+        mw_printf(&w, "hamlib_amp_age_seconds{item=\"%s\"} %g\n", amp_strlevel(level),
+                  metrics_age(&c.time_level[i], &now));
+    }
+
+    mw_family(&w, "hamlib_amp_reads", "counter",
+              "Readings taken from the amplifier, by item.");
+    mw_printf(&w, "hamlib_amp_reads_total{item=\"freq\"} %u\n", c.freq_seq);
+    mw_printf(&w, "hamlib_amp_reads_total{item=\"powerstat\"} %u\n",
+              c.powerstat_seq);
+
+    for (i = 0; i < RIG_SETTING_MAX; i++)
+    {
+        setting_t level = rig_idx2setting(i);
+
+        if (!(rs->has_get_level & level))
+        {
+            continue;
+        }
+
+        mw_printf(&w, "hamlib_amp_reads_total{item=\"%s\"} %u\n",
+                  amp_strlevel(level), c.level_seq[i]);
+    }
+
+    mw_family(&w, "hamlib_amp_fault", "info", "Last fault the amplifier reported.");
+
+    if (c.fault[0])
+    {
+        mw_printf(&w, "hamlib_amp_fault_info{fault=\"%s\"} 1\n",
+                  mw_escape(c.fault, fault, sizeof(fault)));
+    }
+
+    return mw_finish(&w);
+}
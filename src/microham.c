@@ -76,147 +76,169 @@
 #define PATH_MAX 256
 #endif
 
-#if !(defined(WIN32) || !defined(HAVE_GLOB_H))
-static char
-uh_device_path[PATH_MAX];  // use PATH_MAX since udev names can be VERY long!
+#if defined(HAVE_PTHREAD) && defined(HAVE_SOCKETPAIR) && defined(HAVE_SELECT) \
+    && defined(HAVE_GLOB_H) && !defined(WIN32)
+#  define UH_ROUTER 1
 #endif
-static int uh_device_fd = -1;
-static int uh_is_initialized = 0;
 
-static int uh_radio_pair[2] = { -1, -1};
-static int uh_ptt_pair[2]   = { -1, -1};
-static int uh_wkey_pair[2]  = { -1, -1};
+#ifdef UH_ROUTER
 
-static int uh_radio_in_use;
-static int uh_ptt_in_use;
-static int uh_wkey_in_use;
+#include <pthread.h>
+#include <termios.h>
+#include <sys/stat.h>
+#include <glob.h>
 
-static int statusbyte = 0;
+//
+// Several microHam devices can be in use at the same time, e.g. two
+// radios on two keyers for SO2R.  Each one has its own reading thread,
+// its own channel sockets and its own lock, so a busy WinKey on one
+// device never holds up the radio on another.
+//
+// Every device read is parsed in one go: the radio and WinKey bytes of
+// all the frames in it go out with a single write per channel, and the
+// bytes waiting on a channel socket are sent to the device as one block
+// of frames.
+//
+#define UH_MAX_DEVICES 4
 
-#ifdef HAVE_PTHREAD
+// the channels of a device, each is a socket pair
+enum { UH_RADIO, UH_PTT, UH_WKEY, UH_NCHANNELS };
 
-#include <pthread.h>
+// bytes taken from a channel socket at once
+#define UH_BATCH 64
 
-static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-static pthread_t readthread;
-#define getlock()  if (pthread_mutex_lock(&mutex))   perror("GETLOCK:")
-#define freelock() if (pthread_mutex_unlock(&mutex)) perror("FREELOCK:")
-#else
-#define getlock()
-#define freelock()
-#endif
+struct uh_device
+{
+    char path[PATH_MAX];
+    int fd;                             // -1 when the slot is free
+    volatile int run;                   // cleared to stop the thread
+    int pair[UH_NCHANNELS][2];          // [0] is ours, [1] is handed out
+    int in_use[UH_NCHANNELS];
+    int statusbyte;
+    pthread_t thread;
+    pthread_mutex_t lock;               // one frame sequence at a time
+    time_t lastbeat;
+    // receive side, only touched by the reading thread
+    unsigned char frame[4];
+    int framepos;
+    int frameseq;
+    int incontrol;
+    unsigned char controlstring[256];
+    int numcontrolbytes;
+};
 
-#if defined(HAVE_SELECT)
-//
-// time of last heartbeat. Updated by heartbeat()
-//
-static time_t lastbeat = 0;
-#endif
+static struct uh_device uh_devices[UH_MAX_DEVICES];
+static int uh_devices_ready;
+// guards opening and closing of devices and channels
+static pthread_mutex_t uh_devices_lock = PTHREAD_MUTEX_INITIALIZER;
 
-#if defined(HAVE_PTHREAD) && defined(HAVE_SOCKETPAIR) && defined(HAVE_SELECT)
 static time_t starttime;
 
 #define TIME ((int) (time(NULL) - starttime))
-#endif
 
-//
-// close all sockets and mark them free
-//
-static void close_all_files()
+static void uh_devices_init()
 {
-    if (uh_radio_pair[0] >= 0)
-    {
-        close(uh_radio_pair[0]);
-    }
+    int i, c;
 
-    if (uh_radio_pair[1] >= 0)
+    if (uh_devices_ready)
     {
-        close(uh_radio_pair[1]);
+        return;
     }
 
-    if (uh_ptt_pair[0]   >= 0)
+    for (i = 0; i < UH_MAX_DEVICES; i++)
     {
-        close(uh_ptt_pair[0]);
-    }
+        uh_devices[i].fd = -1;
 
-    if (uh_ptt_pair[1]   >= 0)
-    {
-        close(uh_ptt_pair[1]);
+        for (c = 0; c < UH_NCHANNELS; c++)
+        {
+            uh_devices[i].pair[c][0] = -1;
+            uh_devices[i].pair[c][1] = -1;
+        }
     }
 
-    if (uh_wkey_pair[0]  >= 0)
+    starttime = time(NULL);
+    uh_devices_ready = 1;
+}
+
+
+//
+// Find the device and channel a socket handed out by uh_open_xxx() belongs to
+//
+static struct uh_device *uh_lookup(int fd, int *channel)
+{
+    int i, c;
+
+    if (fd < 0 || !uh_devices_ready)
     {
-        close(uh_wkey_pair[0]);
+        return NULL;
     }
 
-    if (uh_wkey_pair[1]  >= 0)
+    for (i = 0; i < UH_MAX_DEVICES; i++)
     {
-        close(uh_wkey_pair[1]);
-    }
+        if (uh_devices[i].fd < 0)
+        {
+            continue;
+        }
 
-    uh_radio_pair[0] = -1;
-    uh_radio_pair[1] = -1;
-    uh_ptt_pair[0] = -1;
-    uh_ptt_pair[1] = -1;
-    uh_wkey_pair[0] = -1;
-    uh_wkey_pair[1] = -1;
-    uh_radio_in_use = 0;
-    uh_ptt_in_use = 0;
-    uh_wkey_in_use = 0;
+        for (c = 0; c < UH_NCHANNELS; c++)
+        {
+            if (uh_devices[i].pair[c][1] == fd)
+            {
+                if (channel)
+                {
+                    *channel = c;
+                }
 
-//  finally, close connection to microHam device
-    if (uh_device_fd >= 0)
-    {
-        close(uh_device_fd);
+                return &uh_devices[i];
+            }
+        }
     }
+
+    return NULL;
 }
 
 
-static void close_microham()
+static void close_all_files(struct uh_device *dev)
 {
-    if (!uh_is_initialized)
+    int c;
+
+    for (c = 0; c < UH_NCHANNELS; c++)
     {
-        return;
+        if (dev->pair[c][0] >= 0)
+        {
+            close(dev->pair[c][0]);
+        }
+
+        if (dev->pair[c][1] >= 0)
+        {
+            close(dev->pair[c][1]);
+        }
+
+        dev->pair[c][0] = -1;
+        dev->pair[c][1] = -1;
+        dev->in_use[c] = 0;
     }
 
-    TRACE("%10d:Closing MicroHam device\n", TIME);
-    uh_is_initialized = 0;
-#ifdef HAVE_PTHREAD
-    // wait for read_device thread to finish
-    pthread_join(readthread, NULL);
-#endif
-    close_all_files();
+//  finally, close connection to microHam device
+    if (dev->fd >= 0)
+    {
+        close(dev->fd);
+    }
+
+    dev->fd = -1;
 }
 
 
-#if defined(WIN32) || !defined(HAVE_GLOB_H)
-/*
- * On Windows, this is not really needed since we have uhrouter.exe
- * creating virtual COM ports
- *
- * I do now know how to "find" a microham device under Windows.
- *
- * Therefore, a dummy version of finddevices() is included such that it compiles
- * well on WIN32. Since the dummy version does not find anything, no reading thread
- * and no sockets are created.
- *
- *
- * For those who want to implement the WIN32 case here properly:
- *
- * What finddevices() must do:
- * Scan all USB-serial ports with an FTDI chip, and look
- * for its serial number, take the first port you can find where the serial
- * number begins with MK, M2, CK, DK, D2, 2R, 2P or UR. Then, open the serial
- * line with correct serial speed etc. and put a valid fd into uh_device_fd.
- */
-/* Commenting out the following dummy function to quell the warning from
- * MinGW's GCC of a defined but not used function.
- */
-/* static void finddevices() */
-/* { */
-/* } */
+static void close_microham(struct uh_device *dev)
+{
+    TRACE("%10d:Closing MicroHam device %s\n", TIME, dev->path);
+    dev->run = 0;
+    // wait for read_device thread to finish
+    pthread_join(dev->thread, NULL);
+    pthread_mutex_destroy(&dev->lock);
+    close_all_files(dev);
+}
 
-#else
 
 /*
  * POSIX (including APPLE)
@@ -278,23 +300,108 @@ static struct uhtypes
 };
 
 
+//
+// Open the serial line to a microHam device:
+// microHam devices always use 230400 baud, 8N1, only TxD/RxD is used
+//
+static int open_device(const char *path)
+{
+    struct termios TTY;
+    int fd;
+
+    fd = open(path, O_RDWR | O_NONBLOCK | O_NOCTTY);
+
+    if (fd < 0)
+    {
+        MYERROR("Cannot open serial port %s\n", path);
+        perror("Open:");
+        return -1;
+    }
+
+    tcflush(fd, TCIFLUSH);
+
+    if (tcgetattr(fd, &TTY))
+    {
+        MYERROR("Cannot get comm params\n");
+        close(fd);
+        return -1;
+    }
+
+    // 8 data bits
+    TTY.c_cflag &= ~CSIZE;
+    TTY.c_cflag |= CS8;
+    // enable receiver, set local mode
+    TTY.c_cflag |= (CLOCAL | CREAD);
+    // no parity
+    TTY.c_cflag &= ~PARENB;
+    // 1 stop bit
+    TTY.c_cflag &= ~CSTOPB;
+
+    cfsetispeed(&TTY, B230400);
+    cfsetospeed(&TTY, B230400);
+
+    // raw input
+    TTY.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
+    // raw output
+    TTY.c_oflag &= ~OPOST;
+
+    // timeouts
+    TTY.c_cc[VMIN] = 0;
+    TTY.c_cc[VTIME] = 255;
+
+    if (tcsetattr(fd, TCSANOW, &TTY))
+    {
+        MYERROR("Can't set device communication parameters");
+        close(fd);
+        return -1;
+    }
+
+    TRACE("SerialPort opened: %s fd=%d\n", path, fd);
+    return fd;
+}
+
+
+static int device_path_in_use(const char *path)
+{
+    int i;
+
+    for (i = 0; i < UH_MAX_DEVICES; i++)
+    {
+        if (uh_devices[i].fd >= 0 && !strcmp(uh_devices[i].path, path))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
 //
 // Find a microHamDevice. Here we assume that the device special
 // file has a name from which we can tell this is a microHam device
 // This is the case for MacOS and LINUX (for LINUX: use udev)
 //
-#include <termios.h>
-#include <sys/stat.h>
-#include <glob.h>
-static void finddevices()
+// An empty match takes the first device, otherwise the device path must
+// contain match, e.g. the serial number.  A match starting with / is
+// taken as the device path itself.
+//
+static int finddevice(struct uh_device *dev, const char *match)
 {
     struct stat st;
     glob_t gbuf;
     int i, j;
-    struct termios TTY;
-    int fd;
 
-    uh_device_fd = -1; // indicates "no device is found"
+    if (match[0] == '/')
+    {
+        if (strlen(match) >= PATH_MAX)
+        {
+            return -1;
+        }
+
+        strcpy(dev->path, match);
+        return open_device(dev->path);
+    }
 
     //
     // Check ALL device special files that might be relevant,
@@ -302,107 +409,111 @@ static void finddevices()
     for (i = 0; i < NUMUHTYPES; i++)
     {
         DEBUG("Checking for %s device\n", uhtypes[i].device);
-        glob(uhtypes[i].device, 0, NULL, &gbuf);
+
+        if (glob(uhtypes[i].device, 0, NULL, &gbuf))
+        {
+            continue;
+        }
 
         for (j = 0; j < gbuf.gl_pathc; j++)
         {
-            DEBUG("Found file: %s\n", gbuf.gl_pathv[j]);
+            const char *path = gbuf.gl_pathv[j];
+            int fd;
+
+            DEBUG("Found file: %s\n", path);
 
-            if (!stat(gbuf.gl_pathv[j], &st))
+            if (stat(path, &st) || !S_ISCHR(st.st_mode)
+                    || (match[0] && !strstr(path, match))
+                    || device_path_in_use(path))
             {
-                if (S_ISCHR(st.st_mode))
-                {
-                    // found a character special device with correct name
-                    if (strlen(gbuf.gl_pathv[j]) >= PATH_MAX)
-                    {
-                        // I do not know if this can happen, but if it happens, we just skip the device.
-                        MYERROR("Name too long: %s\n", gbuf.gl_pathv[j]);
-                        continue;
-                    }
-
-                    DEBUG("%s is a character special file\n", gbuf.gl_pathv[j]);
-                    strcpy(uh_device_path, gbuf.gl_pathv[j]);
-                    TRACE("Found a %s, Device=%s\n", uhtypes[i].name, uh_device_path);
-
-                    fd = open(uh_device_path, O_RDWR | O_NONBLOCK | O_NOCTTY);
-
-                    if (fd < 0)
-                    {
-                        MYERROR("Cannot open serial port %s\n", uh_device_path);
-                        perror("Open:");
-                        continue;
-                    }
-
-                    tcflush(fd, TCIFLUSH);
-
-                    if (tcgetattr(fd, &TTY))
-                    {
-                        MYERROR("Cannot get comm params\n");
-                        close(fd);
-                        continue;
-                    }
-
-                    // microHam devices always use 230400 baud, 8N1, only TxD/RxD is used (no h/w handshake)
-                    // 8 data bits
-                    TTY.c_cflag &= ~CSIZE;
-                    TTY.c_cflag |= CS8;
-                    // enable receiver, set local mode
-                    TTY.c_cflag |= (CLOCAL | CREAD);
-                    // no parity
-                    TTY.c_cflag &= ~PARENB;
-                    // 1 stop bit
-                    TTY.c_cflag &= ~CSTOPB;
-
-                    cfsetispeed(&TTY, B230400);
-                    cfsetospeed(&TTY, B230400);
-
-                    // NO h/w handshake
-                    // TTY.c_cflag &= ~CRTSCTS;
-                    // raw input
-                    TTY.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
-                    // raw output
-                    TTY.c_oflag &= ~OPOST;
-                    // software flow control disabled
-                    // TTY.c_iflag &= ~IXON;
-                    // do not translate CR to NL
-                    // TTY.c_iflag &= ~ICRNL;
-
-                    // timeouts
-                    TTY.c_cc[VMIN] = 0;
-                    TTY.c_cc[VTIME] = 255;
-
-                    if (tcsetattr(fd, TCSANOW, &TTY))
-                    {
-                        MYERROR("Can't set device communication parameters");
-                        close(fd);
-                        continue;
-                    }
-
-                    TRACE("SerialPort opened: %s fd=%d\n", uh_device_path, fd);
-                    uh_device_fd = fd;
-                    // The first time we were successful, we skip all what might come
-                    return;
-                }
+                continue;
+            }
+
+            // found a character special device with correct name
+            if (strlen(path) >= PATH_MAX)
+            {
+                // I do not know if this can happen, but if it happens, we just skip the device.
+                MYERROR("Name too long: %s\n", path);
+                continue;
+            }
+
+            strcpy(dev->path, path);
+            TRACE("Found a %s, Device=%s\n", uhtypes[i].name, dev->path);
+
+            fd = open_device(dev->path);
+
+            if (fd >= 0)
+            {
+                // The first time we were successful, we skip all what might come
+                globfree(&gbuf);
+                return fd;
             }
         }
+
+        globfree(&gbuf);
+    }
+
+    return -1;
+}
+
+
+//
+// Write a block of frames to the device. It is non-blocking,
+// so wait a little when its output buffer is full.
+// Called with dev->lock held.
+//
+static void write_frames(struct uh_device *dev, const unsigned char *seq,
+                         int len, const char *what)
+{
+    while (len > 0)
+    {
+        int ret = write(dev->fd, seq, len);
+
+        if (ret > 0)
+        {
+            seq += ret;
+            len -= ret;
+            continue;
+        }
+
+        if (ret < 0 && (errno == EAGAIN || errno == EINTR))
+        {
+            fd_set fds;
+            struct timeval tv;
+
+            FD_ZERO(&fds);
+            FD_SET(dev->fd, &fds);
+            tv.tv_sec = 0;
+            tv.tv_usec = 100000;
+
+            if (select(dev->fd + 1, NULL, &fds, NULL, &tv) > 0)
+            {
+                continue;
+            }
+        }
+
+        MYERROR("Write%s failed with %d\n", what, ret);
+
+        if (ret < 0)
+        {
+            perror("WriteError:");
+        }
+
+        return;
     }
 }
 
-#endif
 
-#if defined(HAVE_SELECT)
 //
 // parse a frame received from the keyer
 // This is called from the "device reading" thread
 // once a complete frame has been received
-// Send Radio and Winkey bytes received to the client sockets.
+// Radio and Winkey bytes are collected in the buffers given,
+// the caller passes them on to the client sockets.
 //
-static int frameseq = 0;
-static int incontrol = 0;
-static unsigned char controlstring[256];
-static int numcontrolbytes = 0;
-
-static void parseFrame(const unsigned char *frame)
+static void parseFrame(struct uh_device *dev, const unsigned char *frame,
+                       unsigned char *radio, int *nradio,
+                       unsigned char *wkey, int *nwkey)
 {
     unsigned char byte;
     FRAME("RCV frame %02x %02x %02x %02x\n", frame[0], frame[1], frame[2],
@@ -411,11 +522,11 @@ static void parseFrame(const unsigned char *frame)
     // frames come in sequences. The first frame of a sequence has bit6 cleared in the headerbyte.
     if ((frame[0] & 0x40) == 0)
     {
-        frameseq = 0;
+        dev->frameseq = 0;
     }
     else
     {
-        frameseq++;
+        dev->frameseq++;
     }
 
     // A frame is of the form header-byte1-byte2-byte3
@@ -437,17 +548,13 @@ static void parseFrame(const unsigned char *frame)
         }
 
         DEBUG("%10d:FromRadio: %02x\n", TIME, byte);
-
-        if (write(uh_radio_pair[0], &byte, 1) != 1)
-        {
-            MYERROR("Write Radio Socket\n");
-        }
+        radio[(*nradio)++] = byte;
     }
 
     // ignore AUX/RADIO2 for the time being
 
     // check the shared channel for validity, if it is the CONTROL channel it is always valid
-    if ((frame[0] & 0x08) || (frameseq == 1))
+    if ((frame[0] & 0x08) || (dev->frameseq == 1))
     {
         byte = frame[3] & 0x7F;
 
@@ -456,7 +563,7 @@ static void parseFrame(const unsigned char *frame)
             byte |= 0x80;
         }
 
-        switch (frameseq)
+        switch (dev->frameseq)
         {
         case 0:  // Flag byte
             DEBUG("%10d:RCV: Flags=%02x\n", TIME, byte);
@@ -464,44 +571,43 @@ static void parseFrame(const unsigned char *frame)
             break;
 
         case 1:  // part of control string
-            if ((frame[0] & 0x08) == 0 && !incontrol)
+            if ((frame[0] & 0x08) == 0 && !dev->incontrol)
             {
                 // start or end of a control sequence
-                numcontrolbytes = 1;
-                controlstring[0] = byte;
-                incontrol = 1;
+                dev->numcontrolbytes = 1;
+                dev->controlstring[0] = byte;
+                dev->incontrol = 1;
                 break;
             }
 
-            if ((frame[0] & 0x08) == 0 && incontrol)
+            if ((frame[0] & 0x08) == 0 && dev->incontrol)
             {
                 int i;
                 // end of a control sequence
-                controlstring[numcontrolbytes++] = byte;
+                dev->controlstring[dev->numcontrolbytes++] = byte;
                 DEBUG("%10d:FromControl:", TIME);
 
-                for (i = 0; i < numcontrolbytes; i++) { DEBUG(" %02x", controlstring[i]); }
+                for (i = 0; i < dev->numcontrolbytes; i++) { DEBUG(" %02x", dev->controlstring[i]); }
 
                 DEBUG(".\n");
-                incontrol = 0;
+                dev->incontrol = 0;
                 // printing control messages is only used for debugging.
                 // Note that we can get a lot of unsolicited control messages
                 // here (squelch, voltage change, etc.)
                 break;
             }
 
-            // in the middle of a control string
-            controlstring[numcontrolbytes++] = byte;
+            // in the middle of a control string, drop what does not fit
+            if (dev->numcontrolbytes < sizeof(dev->controlstring))
+            {
+                dev->controlstring[dev->numcontrolbytes++] = byte;
+            }
+
             break;
 
         case 2: // message from WinKey chip
             DEBUG("%10d:RCV: WinKey=%02x\n", TIME, byte);
-
-            if (write(uh_wkey_pair[0], &byte, 1) != 1)
-            {
-                MYERROR("Write Winkey socket\n");
-            }
-
+            wkey[(*nwkey)++] = byte;
             break;
 
         case 3: // Key pressed on PS2 keyboard connected to microHam device
@@ -510,16 +616,15 @@ static void parseFrame(const unsigned char *frame)
         }
     }
 }
-#endif  /* HAVE_SELECT */
 
 
-#if defined(HAVE_SELECT)
 //
 // Send radio bytes to microHam device
 //
-static void writeRadio(const unsigned char *bytes, int len)
+static void writeRadio(struct uh_device *dev, const unsigned char *bytes,
+                       int len)
 {
-    unsigned char seq[4];
+    unsigned char seq[UH_BATCH * 4];
     int i;
 
     DEBUG("%10d:Send radio data: ", TIME);
@@ -528,85 +633,65 @@ static void writeRadio(const unsigned char *bytes, int len)
 
     DEBUG(".\n");
 
-    getlock();
+    pthread_mutex_lock(&dev->lock);
 
     for (i = 0; i < len; i++)
     {
-        int ret;
+        unsigned char *s = seq + 4 * i;
 
-        seq[0] = 0x28;
-        seq[1] = 0x80 | bytes[i];
-        seq[2] = 0x80;
-        seq[3] = 0X80 | statusbyte;
+        s[0] = 0x28;
+        s[1] = 0x80 | bytes[i];
+        s[2] = 0x80;
+        s[3] = 0X80 | dev->statusbyte;
 
-        if (statusbyte & 0x80)
+        if (dev->statusbyte & 0x80)
         {
-            seq[0] |= 0x01;
+            s[0] |= 0x01;
         }
 
         if (bytes[i]   & 0x80)
         {
-            seq[0] |= 0x04;
-        }
-
-        if ((ret = write(uh_device_fd, seq, 4)) < 4)
-        {
-            MYERROR("WriteRadio failed with %d\n", ret);
-
-            if (ret < 0)
-            {
-                perror("WriteRadioError:");
-            }
+            s[0] |= 0x04;
         }
     }
 
-    freelock();
+    write_frames(dev, seq, 4 * len, "Radio");
+    pthread_mutex_unlock(&dev->lock);
 }
-#endif  /* HAVE_SELECT */
 
 
 //
 // send statusbyte to microHam device
 //
-static void writeFlags()
+static void writeFlags(struct uh_device *dev)
 {
     unsigned char seq[4];
-    int ret;
 
-    DEBUG("%10d:Sending FlagByte: %02x\n", TIME, statusbyte);
-    getlock();
+    pthread_mutex_lock(&dev->lock);
+    DEBUG("%10d:Sending FlagByte: %02x\n", TIME, dev->statusbyte);
     seq[0] = 0x08;
 
-    if (statusbyte & 0x80)
+    if (dev->statusbyte & 0x80)
     {
         seq[0] = 0x09;
     }
 
     seq[1] = 0x80;
     seq[2] = 0x80;
-    seq[3] = 0x80 | statusbyte;
+    seq[3] = 0x80 | dev->statusbyte;
 
-    if ((ret = write(uh_device_fd, seq, 4)) < 4)
-    {
-        MYERROR("WriteFlags failed with %d\n", ret);
-
-        if (ret < 0)
-        {
-            perror("WriteFlagsError:");
-        }
-    }
-
-    freelock();
+    write_frames(dev, seq, 4, "Flags");
+    pthread_mutex_unlock(&dev->lock);
 }
 
 
-#if defined(HAVE_SELECT)
 //
 // Send bytes to the WinKeyer within microHam device
 //
-static void writeWkey(const unsigned char *bytes, int len)
+static void writeWkey(struct uh_device *dev, const unsigned char *bytes,
+                      int len)
 {
-    unsigned char seq[12];
+    unsigned char seq[UH_BATCH * 12];
     int i;
     DEBUG("%10d:Send WinKey data: ", TIME);
 
@@ -615,58 +700,49 @@ static void writeWkey(const unsigned char *bytes, int len)
     DEBUG(".\n");
     // Winkey data is in the third frame of a sequence,
     // So send two no-ops first. Include statusbyte in first frame
-    getlock();
+    pthread_mutex_lock(&dev->lock);
 
     for (i = 0; i < len; i++)
     {
-        int ret;
-
-        seq[ 0] = 0x08;
-        seq[ 1] = 0x80;
-        seq[ 2] = 0x80;
-        seq[ 3] = 0X80 | statusbyte;
-        seq[ 4] = 0x40;
-        seq[ 5] = 0x80;
-        seq[ 6] = 0x80;
-        seq[ 7] = 0x80;
-        seq[ 8] = 0x48;
-        seq[ 9] = 0x80;
-        seq[10] = 0x80;
-        seq[11] = 0x80 | bytes[i];
-
-        if (statusbyte & 0x80)
+        unsigned char *s = seq + 12 * i;
+
+        s[ 0] = 0x08;
+        s[ 1] = 0x80;
+        s[ 2] = 0x80;
+        s[ 3] = 0X80 | dev->statusbyte;
+        s[ 4] = 0x40;
+        s[ 5] = 0x80;
+        s[ 6] = 0x80;
+        s[ 7] = 0x80;
+        s[ 8] = 0x48;
+        s[ 9] = 0x80;
+        s[10] = 0x80;
+        s[11] = 0x80 | bytes[i];
+
+        if (dev->statusbyte & 0x80)
         {
-            seq[ 0] |= 0x01;
+            s[ 0] |= 0x01;
         }
 
         if (bytes[i]   & 0x80)
         {
-            seq[ 8] |= 0x01;
-        }
-
-        if ((ret = write(uh_device_fd, seq, 12)) < 12)
-        {
-            MYERROR("WriteWINKEY failed with %d\n", ret);
-
-            if (ret < 0)
-            {
-                perror("WriteWinkeyError:");
-            }
+            s[ 8] |= 0x01;
         }
     }
 
-    freelock();
+    write_frames(dev, seq, 12 * len, "WINKEY");
+    pthread_mutex_unlock(&dev->lock);
 }
-#endif  /* HAVE_SELECT */
 
 
 //
 // Write a control string to the microHam device
 //
-static void writeControl(const unsigned char *data, int len)
+static void writeControl(struct uh_device *dev, const unsigned char *data,
+                         int len)
 {
     int i;
-    unsigned char seq[8];
+    unsigned char seq[8 * 8];
 
     DEBUG("%10d:WriteControl:", TIME);
 
@@ -676,72 +752,113 @@ static void writeControl(const unsigned char *data, int len)
     // Control data is in the second frame of a sequence,
     // So send a no-op first. Include statusbyte in first frame.
     // First and last byte of the control message is NOT marked "valid"
-    getlock();
+    pthread_mutex_lock(&dev->lock);
 
-    for (i = 0; i < len; i++)
+    for (i = 0; i < len && i < 8; i++)
     {
-        int ret;
+        unsigned char *s = seq + 8 * i;
 
         // encode statusbyte in first frame
-        seq[0] = 0x08;
-        seq[1] = 0x80;
-        seq[2] = 0x80;
-        seq[3] = 0x80 | statusbyte;
-        seq[4] = 0x48; // marked valid
-        seq[5] = 0x80;
-        seq[6] = 0x80;
-        seq[7] = 0x80 | data[i];
-
-        if (statusbyte & 0x80)
+        s[0] = 0x08;
+        s[1] = 0x80;
+        s[2] = 0x80;
+        s[3] = 0x80 | dev->statusbyte;
+        s[4] = 0x48; // marked valid
+        s[5] = 0x80;
+        s[6] = 0x80;
+        s[7] = 0x80 | data[i];
+
+        if (dev->statusbyte & 0x80)
         {
-            seq[0] |= 1;
+            s[0] |= 1;
         }
 
         if (i == 0 || i == len - 1)
         {
-            seq[4] = 0x40; // un-mark valid
+            s[4] = 0x40; // un-mark valid
         }
 
         if (data[i] & 0x80)
         {
-            seq[4] |= 0x01;
-        }
-
-        if ((ret = write(uh_device_fd, seq, 8)) < 8)
-        {
-            MYERROR("WriteControl failed, ret=%d\n", ret);
-
-            if (ret < 0)
-            {
-                perror("WriteControlError:");
-            }
+            s[4] |= 0x01;
         }
     }
 
-    freelock();
+    write_frames(dev, seq, 8 * i, "Control");
+    pthread_mutex_unlock(&dev->lock);
 }
 
 
-#if defined(HAVE_PTHREAD) && defined(HAVE_SOCKETPAIR) && defined(HAVE_SELECT)
 //
 // send a heartbeat and record time
-// The "last heartbeat" time is recorded in a global variable
-// such that the service thread can decice whether a new
-// heartbeat is due.
+// The "last heartbeat" time is recorded such that the service
+// thread can decide whether a new heartbeat is due.
 //
-static void heartbeat()
+static void heartbeat(struct uh_device *dev)
 {
     unsigned char seq[2];
 
     seq[0] = 0x7e;
     seq[1] = 0xfe;
-    writeControl(seq, 2);
-    lastbeat = time(NULL);
+    writeControl(dev, seq, 2);
+    dev->lastbeat = time(NULL);
+}
+
+
+//
+// Take what the device has sent, compose frames and pass the radio and
+// WinKey bytes on to the client sockets
+//
+static void read_frames(struct uh_device *dev)
+{
+    unsigned char buf[256];
+    // every frame carries at most one radio and one WinKey byte
+    unsigned char radio[sizeof(buf) / 4 + 1], wkey[sizeof(buf) / 4 + 1];
+    int n;
+
+    while ((n = read(dev->fd, buf, sizeof(buf))) > 0)
+    {
+        int i, nradio = 0, nwkey = 0;
+
+        // the bytes from the microHam device come in "frames"
+        // a frame is a four-byte sequence. The first byte has the MSB unset,
+        // then come three bytes with the MSB set
+        for (i = 0; i < n; i++)
+        {
+            if (!(buf[i] & 0x80) && dev->framepos != 0)
+            {
+                MYERROR("FrameSyncStartError\n");
+                dev->framepos = 0;
+            }
+
+            if ((buf[i] & 0x80) && dev->framepos == 0)
+            {
+                MYERROR("FrameSyncStartError\n");
+                continue;
+            }
+
+            dev->frame[dev->framepos++] = buf[i];
+
+            if (dev->framepos >= 4)
+            {
+                dev->framepos = 0;
+                parseFrame(dev, dev->frame, radio, &nradio, wkey, &nwkey);
+            }
+        }
+
+        if (nradio > 0 && write(dev->pair[UH_RADIO][0], radio, nradio) != nradio)
+        {
+            MYERROR("Write Radio Socket\n");
+        }
+
+        if (nwkey > 0 && write(dev->pair[UH_WKEY][0], wkey, nwkey) != nwkey)
+        {
+            MYERROR("Write Winkey socket\n");
+        }
+    }
 }
-#endif /* defined(HAVE_PTHREAD) && defined(HAVE_SOCKETPAIR) && defined(HAVE_SELECT) */
 
 
-#if defined(HAVE_SELECT)
 //
 // This thread reads from the microHam device and puts data on the sockets
 // it also issues periodic heartbeat messages
@@ -749,73 +866,46 @@ static void heartbeat()
 //
 static void *read_device(void *p)
 {
-    unsigned char frame[4];
-    int framepos = 0;
-    unsigned char buf[2];
+    struct uh_device *dev = (struct uh_device *) p;
+    unsigned char buf[UH_BATCH];
     fd_set fds;
     struct timeval tv;
+    int n;
 
-    // the bytes from the microHam decive come in "frames"
-    // a frame is a four-byte sequence. The first byte has the MSB unset,
-    // then come three bytes with the MSB set
     // What comes here is an "infinite" loop. However this thread
     // terminates if the device is closed.
-    for (;;)
+    while (dev->run)
     {
         int ret;
-        int maxdev;
-
-        //
-        // setting uh_is_initialized to zero in the main thread
-        // tells this one that it is all over now
-        //
-        if (!uh_is_initialized)
-        {
-            return NULL;
-        }
-
-
-#if defined(HAVE_PTHREAD) && defined(HAVE_SOCKETPAIR) && defined(HAVE_SELECT)
+        int c, maxdev;
 
         //
         // This is the right place to ensure that a heartbeat is sent
         // to the microham device regularly (15 sec delay is the maximum
         // allowed, let us use 5 secs to be on the safe side).
         //
-        if ((time(NULL) - lastbeat) > 5)
+        if ((time(NULL) - dev->lastbeat) > 5)
         {
-            heartbeat();
+            heartbeat(dev);
         }
 
-#endif
-
         //
         // Wait for something to arrive, either from the microham device
         // or from the sockets used for I/O from hamlib.
         // If nothing arrives within 100 msec, restart the "infinite loop".
         //
         FD_ZERO(&fds);
-        FD_SET(uh_device_fd, &fds);
-        FD_SET(uh_radio_pair[0], &fds);
-        FD_SET(uh_ptt_pair[0], &fds);
-        FD_SET(uh_wkey_pair[0], &fds);
-
-        // determine max of these fd's for use in select()
-        maxdev = uh_device_fd;
+        FD_SET(dev->fd, &fds);
+        maxdev = dev->fd;
 
-        if (uh_radio_pair[0] > maxdev)
+        for (c = 0; c < UH_NCHANNELS; c++)
         {
-            maxdev = uh_radio_pair[0];
-        }
-
-        if (uh_ptt_pair[0]   > maxdev)
-        {
-            maxdev = uh_ptt_pair[0];
-        }
+            FD_SET(dev->pair[c][0], &fds);
 
-        if (uh_wkey_pair[0]  > maxdev)
-        {
-            maxdev = uh_wkey_pair[0];
+            if (dev->pair[c][0] > maxdev)
+            {
+                maxdev = dev->pair[c][0];
+            }
         }
 
         tv.tv_usec = 100000;
@@ -834,262 +924,189 @@ static void *read_device(void *p)
         //
         // Take care of the incoming data (microham device, sockets)
         //
-        if (FD_ISSET(uh_device_fd, &fds))
+        if (FD_ISSET(dev->fd, &fds))
         {
-            // compose frame, if it is complete, all parseFrame
-            while (read(uh_device_fd, buf, 1) > 0)
-            {
-                if (!(buf[0] & 0x80) && framepos != 0)
-                {
-                    MYERROR("FrameSyncStartError\n");
-                    framepos = 0;
-                }
-
-                if ((buf[0] & 0x80) && framepos == 0)
-                {
-                    MYERROR("FrameSyncStartError\n");
-                    framepos = 0;
-                    continue;
-                }
-
-                frame[framepos++] = buf[0];
-
-                if (framepos >= 4)
-                {
-                    framepos = 0;
-                    parseFrame(frame);
-                }
-            }
+            read_frames(dev);
         }
 
-        if (FD_ISSET(uh_ptt_pair[0], &fds))
+        if (FD_ISSET(dev->pair[UH_PTT][0], &fds))
         {
             // we do not expect any data here, but drain the socket
-            while (read(uh_ptt_pair[0], buf, 1) > 0)
+            while (read(dev->pair[UH_PTT][0], buf, sizeof(buf)) > 0)
             {
                 // do nothing
             }
         }
 
-        if (FD_ISSET(uh_radio_pair[0], &fds))
+        if (FD_ISSET(dev->pair[UH_RADIO][0], &fds))
         {
             // read everything that is there, and send it to the radio
-            while (read(uh_radio_pair[0], buf, 1) > 0)
+            while ((n = read(dev->pair[UH_RADIO][0], buf, sizeof(buf))) > 0)
             {
-                writeRadio(buf, 1);
+                writeRadio(dev, buf, n);
             }
         }
 
-        if (FD_ISSET(uh_wkey_pair[0], &fds))
+        if (FD_ISSET(dev->pair[UH_WKEY][0], &fds))
         {
             // read everything that is there, and send it to the WinKey chip
-            while (read(uh_wkey_pair[0], buf, 1) > 0)
+            while ((n = read(dev->pair[UH_WKEY][0], buf, sizeof(buf))) > 0)
             {
-                writeWkey(buf, 1);
+                writeWkey(dev, buf, n);
             }
         }
     }
 
-//    return NULL;
+    return NULL;
 }
-#endif
 
 
-/*
- * If we do not have pthreads, we cannot use the microham device.
- * This is so because we have to digest unsolicited messages
- * (e.g. voltage change) and since we have to send periodic
- * heartbeats.
- * Nevertheless, the program should compile well even we we do not
- * have pthreads, in this case start_thread is a dummy since uh_is_initialized
- * is never set.
- *
- * If we do not have socketpair(), the same thing applies.
- *
- * If we do not have select(), then the read thread cannot work so we
- * do not spawn it.
- */
-static void start_thread()
+static int set_nonblocking(int fd)
 {
-#if defined(HAVE_PTHREAD) && defined(HAVE_SOCKETPAIR) && defined(HAVE_SELECT)
-    /*
-     * Find a microHam device and open serial port to it.
-     * If successful, create sockets for doing I/O from within hamlib
-     * and start a thread to listen to the "other ends" of the sockets
-     */
-    int ret, fail;
-    unsigned char buf[4];
-    pthread_attr_t attr;
+    int ret = fcntl(fd, F_GETFL, 0);
 
-    if (uh_is_initialized)
-    {
-        return;  // PARANOIA: this should not happen
-    }
-
-    finddevices();
-
-    if (uh_device_fd  < 0)
-    {
-        MYERROR("Could not open any microHam device.\n");
-        return;
-    }
-
-    // Create socket pairs
-    if (socketpair(AF_UNIX, SOCK_STREAM, 0, uh_radio_pair)  < 0)
-    {
-        perror("RadioPair:");
-        return;
-    }
-
-    if (socketpair(AF_UNIX, SOCK_STREAM, 0, uh_ptt_pair)    < 0)
-    {
-        perror("PTTPair:");
-        return;
-    }
-
-    if (socketpair(AF_UNIX, SOCK_STREAM, 0, uh_wkey_pair) < 0)
+    if (ret != -1)
     {
-        perror("WkeyPair:");
-        return;
+        ret = fcntl(fd, F_SETFL, ret | O_NONBLOCK);
     }
 
-    DEBUG("RADIO  sockets: server=%d  client=%d\n", uh_radio_pair[0],
-          uh_radio_pair[1]);
-    DEBUG("PTT    sockets: server=%d  client=%d\n", uh_ptt_pair[0], uh_ptt_pair[1]);
-    DEBUG("WinKey sockets: server=%d  client=%d\n", uh_wkey_pair[0],
-          uh_wkey_pair[1]);
+    return ret;
+}
 
-    //
-    // Make the sockets nonblocking
-    // First try if we can set flags, then do set the flags
-    //
 
-    fail = 0;
+/*
+ * Find a microHam device and open serial port to it.
+ * If successful, create sockets for doing I/O from within hamlib
+ * and start a thread to listen to the "other ends" of the sockets
+ */
+static int start_thread(struct uh_device *dev, const char *match)
+{
+    int ret, c;
+    unsigned char buf[4];
 
-    ret = fcntl(uh_radio_pair[0], F_GETFL, 0);
+    dev->fd = finddevice(dev, match);
 
-    if (ret != -1)
+    if (dev->fd  < 0)
     {
-        ret = fcntl(uh_radio_pair[0], F_SETFL, ret | O_NONBLOCK);
+        MYERROR("Could not open any microHam device.\n");
+        return -1;
     }
 
-    if (ret == -1)
+    // Create socket pairs, and make them nonblocking
+    for (c = 0; c < UH_NCHANNELS; c++)
     {
-        fail = 1;
-    }
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, dev->pair[c]) < 0)
+        {
+            perror("SocketPair:");
+            close_all_files(dev);
+            return -1;
+        }
 
-    ret = fcntl(uh_ptt_pair[0], F_GETFL, 0);
+        DEBUG("Channel %d sockets: server=%d  client=%d\n", c, dev->pair[c][0],
+              dev->pair[c][1]);
 
-    if (ret != -1)
-    {
-        ret = fcntl(uh_ptt_pair[0], F_SETFL, ret | O_NONBLOCK);
+        if (set_nonblocking(dev->pair[c][0]) == -1
+                || set_nonblocking(dev->pair[c][1]) == -1)
+        {
+            close_all_files(dev);
+            return -1;
+        }
     }
 
-    if (ret == -1)
+    // drain input from microHam device
+    while (read(dev->fd, buf, sizeof(buf)) > 0)
     {
-        fail = 1;
+        // do_nothing
     }
 
-    ret = fcntl(uh_wkey_pair[0], F_GETFL, 0);
-
-    if (ret != -1)
-    {
-        ret = fcntl(uh_wkey_pair[0], F_SETFL, ret | O_NONBLOCK);
-    }
+    pthread_mutex_init(&dev->lock, NULL);
+    dev->statusbyte = 0;
+    dev->framepos = 0;
+    dev->frameseq = 0;
+    dev->incontrol = 0;
+    dev->run = 1;
 
-    if (ret == -1)
-    {
-        fail = 1;
-    }
+    // Do some heartbeats to sync-in
+    heartbeat(dev);
+    heartbeat(dev);
+    heartbeat(dev);
 
-    ret = fcntl(uh_radio_pair[1], F_GETFL, 0);
+    // Set keyer mode to DIGITAL
+    buf[0] = 0x0A; buf[1] = 0x03; buf[2] = 0x8a; writeControl(dev, buf, 3);
 
-    if (ret != -1)
-    {
-        ret = fcntl(uh_radio_pair[1], F_SETFL, ret | O_NONBLOCK);
-    }
+    // Start background thread reading the microham device and the sockets
+    ret = pthread_create(&dev->thread, NULL, read_device, dev);
 
-    if (ret == -1)
+    if (ret != 0)
     {
-        fail = 1;
+        MYERROR("Could not start read_device thread\n");
+        pthread_mutex_destroy(&dev->lock);
+        close_all_files(dev);
+        return -1;
     }
 
-    ret = fcntl(uh_ptt_pair[1], F_GETFL, 0);
+    return 0;
+}
 
-    if (ret != -1)
-    {
-        ret = fcntl(uh_ptt_pair[1], F_SETFL, ret | O_NONBLOCK);
-    }
 
-    if (ret == -1)
-    {
-        fail = 1;
-    }
+//
+// Open a channel of the device name selects, starting the device if needed.
+// name is what follows "uh-rig" or "uh-ptt" in the port pathname: empty
+// for the first device, or ":<match>" with part of its device path, e.g.
+// its serial number.
+//
+static struct uh_device *open_channel(const char *name, int channel)
+{
+    const char *match = name[0] == ':' ? name + 1 : "";
+    struct uh_device *dev = NULL;
+    int i;
 
-    ret = fcntl(uh_wkey_pair[1], F_GETFL, 0);
+    pthread_mutex_lock(&uh_devices_lock);
+    uh_devices_init();
 
-    if (ret != -1)
+    for (i = 0; i < UH_MAX_DEVICES && !dev; i++)
     {
-        ret = fcntl(uh_wkey_pair[1], F_SETFL, ret | O_NONBLOCK);
+        if (uh_devices[i].fd >= 0
+                && (!match[0] || strstr(uh_devices[i].path, match)))
+        {
+            dev = &uh_devices[i];
+        }
     }
 
-    if (ret == -1)
+    for (i = 0; i < UH_MAX_DEVICES && !dev; i++)
     {
-        fail = 1;
-    }
+        if (uh_devices[i].fd < 0)
+        {
+            if (start_thread(&uh_devices[i], match) == 0)
+            {
+                dev = &uh_devices[i];
+            }
 
-    //
-    // If something went wrong, close everything and return
-    //
-    if (fail)
-    {
-        close_all_files();
-        return;
+            break;
+        }
     }
 
-    // drain input from microHam device
-    while (read(uh_device_fd, buf, 1) > 0)
+    if (dev)
     {
-        // do_nothing
+        dev->in_use[channel] = 1;
     }
 
-    uh_is_initialized = 1;
-    starttime = time(NULL);
-
-    // Do some heartbeats to sync-in
-    heartbeat();
-    heartbeat();
-    heartbeat();
+    pthread_mutex_unlock(&uh_devices_lock);
 
-    // Set keyer mode to DIGITAL
-    buf[0] = 0x0A; buf[1] = 0x03; buf[2] = 0x8a; writeControl(buf, 3);
-
-    // Start background thread reading the microham device and the sockets
-    pthread_attr_init(&attr);
-    ret = pthread_create(&readthread, &attr, read_device, NULL);
-
-    if (ret != 0)
-    {
-        MYERROR("Could not start read_device thread\n");
-        close_all_files();
-        uh_is_initialized = 0;
-        return;
-    }
-
-    //TRACE("Started daemonized thread reading microHam\n");
-#endif
-// if we do not have pthreads, this function does nothing.
+    return dev;
 }
 
 
 /*
  * What comes now are "public" functions that can be called from outside
  *
-   void uh_close_XXX()        XXX= ptt, radio, wkey
-   void uh_open_XXX()         XXX= ptt, wkey
-   void uh_open_radio(int baud, int databits, int stopbits, int rtscts)
-   void uh_set_ptt(int ptt)
-   int  uh_get_ptt()
+   void uh_close(int fd)
+   int  uh_open_ptt(const char *name)
+   int  uh_open_wkey(), void uh_close_wkey()
+   int  uh_open_radio(const char *name, int baud, int databits, int stopbits, int rtscts)
+   void uh_set_ptt(int fd, int ptt)
+   int  uh_get_ptt(int fd)
+   int  uh_is_radio(int fd), uh_is_ptt(int fd)
 
  * Note that it is not intended that any I/O is done via the PTT sockets
  * but hamlib needs a valid file descriptor!
@@ -1097,75 +1114,67 @@ static void start_thread()
  */
 
 /*
- * Close routines:
+ * Close routine:
  * Mark the channel as closed, but close the connection
- * to the microHam device only if ALL channels are closed
+ * to the microHam device only if ALL its channels are closed
  *
  * NOTE: hamlib repeatedly opens/closes the PTT port while keeping the
  *       the radio port open.
  */
-void uh_close_ptt()
+void uh_close(int fd)
 {
-    uh_ptt_in_use = 0;
+    struct uh_device *dev;
+    int c;
+
+    pthread_mutex_lock(&uh_devices_lock);
+    dev = uh_lookup(fd, &c);
 
-    if (!uh_radio_in_use && ! uh_wkey_in_use)
+    if (dev)
     {
-        close_microham();
+        dev->in_use[c] = 0;
+
+        if (!dev->in_use[UH_RADIO] && !dev->in_use[UH_PTT] && !dev->in_use[UH_WKEY])
+        {
+            close_microham(dev);
+        }
     }
+
+    pthread_mutex_unlock(&uh_devices_lock);
 }
 
 
-void uh_close_radio()
+int uh_open_ptt(const char *name)
 {
-    uh_radio_in_use = 0;
+    struct uh_device *dev = open_channel(name, UH_PTT);
 
-    if (!uh_ptt_in_use && ! uh_wkey_in_use)
-    {
-        close_microham();
-    }
+    return dev ? dev->pair[UH_PTT][1] : -1;
 }
 
-void uh_close_wkey()
-{
-    uh_wkey_in_use = 0;
 
-    if (!uh_ptt_in_use && ! uh_radio_in_use)
-    {
-        close_microham();
-    }
-}
-
-int uh_open_ptt()
+//
+// The WinKey channel is used by external programs, which know of
+// one device only: it is always that of the first device.
+//
+int uh_open_wkey()
 {
-    if (!uh_is_initialized)
-    {
-        start_thread();
+    struct uh_device *dev = open_channel("", UH_WKEY);
 
-        if (!uh_is_initialized)
-        {
-            return -1;
-        }
-    }
-
-    uh_ptt_in_use = 1;
-    return uh_ptt_pair[1];
+    return dev ? dev->pair[UH_WKEY][1] : -1;
 }
 
-int uh_open_wkey()
+
+void uh_close_wkey()
 {
-    if (!uh_is_initialized)
-    {
-        start_thread();
+    int i;
 
-        if (!uh_is_initialized)
+    for (i = 0; uh_devices_ready && i < UH_MAX_DEVICES; i++)
+    {
+        if (uh_devices[i].fd >= 0 && uh_devices[i].in_use[UH_WKEY])
         {
-            return -1;
+            uh_close(uh_devices[i].pair[UH_WKEY][1]);
+            return;
         }
     }
-
-
-    uh_wkey_in_use = 1;
-    return uh_wkey_pair[1];
 }
 
 
@@ -1175,20 +1184,12 @@ int uh_open_wkey()
 // Hardware handshake (rtscts) can be on of off.
 // microHam devices ALWAYS use "no parity".
 //
-int uh_open_radio(int baud, int databits, int stopbits, int rtscts)
+int uh_open_radio(const char *name, int baud, int databits, int stopbits,
+                  int rtscts)
 {
     unsigned char string[5];
     int baudrateConst;
-
-    if (!uh_is_initialized)
-    {
-        start_thread();
-
-        if (!uh_is_initialized)
-        {
-            return -1;
-        }
-    }
+    struct uh_device *dev;
 
     baudrateConst = 11059200 / baud ;
     string[0] = 0x01;
@@ -1223,16 +1224,25 @@ int uh_open_radio(int baud, int databits, int stopbits, int rtscts)
     }
 
     string[4] = 0x81;
-    writeControl(string, 5);
 
-    uh_radio_in_use = 1;
-    return uh_radio_pair[1];
+    dev = open_channel(name, UH_RADIO);
+
+    if (!dev)
+    {
+        return -1;
+    }
+
+    writeControl(dev, string, 5);
+
+    return dev->pair[UH_RADIO][1];
 }
 
 
-void uh_set_ptt(int ptt)
+void uh_set_ptt(int fd, int ptt)
 {
-    if (!uh_ptt_in_use)
+    struct uh_device *dev = uh_lookup(fd, NULL);
+
+    if (!dev || !dev->in_use[UH_PTT])
     {
         MYERROR("%10d:SetPTT but not open\n", TIME);
         return;
@@ -1240,24 +1250,30 @@ void uh_set_ptt(int ptt)
 
     DEBUG("%10d:SET PTT = %d\n", TIME, ptt);
 
+    pthread_mutex_lock(&dev->lock);
+
     if (ptt)
     {
-        statusbyte |= 0x04;
+        dev->statusbyte |= 0x04;
     }
     else
     {
-        statusbyte &= ~0x04;
+        dev->statusbyte &= ~0x04;
     }
 
-    writeFlags();
+    pthread_mutex_unlock(&dev->lock);
+
+    writeFlags(dev);
 }
 
 
-int uh_get_ptt()
+int uh_get_ptt(int fd)
 {
+    struct uh_device *dev = uh_lookup(fd, NULL);
+
     // Possibly we can do better, but we just reflect
     // what we have done via uh_set_ptt.
-    if (statusbyte & 0x04)
+    if (dev && (dev->statusbyte & 0x04))
     {
         return 1;
     }
@@ -1266,3 +1282,87 @@ int uh_get_ptt()
         return 0;
     }
 }
+
+
+int uh_is_radio(int fd)
+{
+    int c;
+
+    return uh_lookup(fd, &c) != NULL && c == UH_RADIO;
+}
+
+
+int uh_is_ptt(int fd)
+{
+    int c;
+
+    return uh_lookup(fd, &c) != NULL && c == UH_PTT;
+}
+
+#else /* UH_ROUTER */
+
+/*
+ * If we do not have pthreads, we cannot use the microham device.
+ * This is so because we have to digest unsolicited messages
+ * (e.g. voltage change) and since we have to send periodic
+ * heartbeats.
+ *
+ * If we do not have socketpair(), the same thing applies.
+ * If we do not have select(), then the read thread cannot work.
+ *
+ * On Windows, this is not really needed since we have uhrouter.exe
+ * creating virtual COM ports, and finding a microHam device there
+ * is not implemented: it behaves as if there was none.
+ */
+void uh_close(int fd)
+{
+}
+
+
+int uh_open_ptt(const char *name)
+{
+    return -1;
+}
+
+
+int uh_open_wkey()
+{
+    return -1;
+}
+
+
+void uh_close_wkey()
+{
+}
+
+
+int uh_open_radio(const char *name, int baud, int databits, int stopbits,
+                  int rtscts)
+{
+    return -1;
+}
+
+
+void uh_set_ptt(int fd, int ptt)
+{
+}
+
+
+int uh_get_ptt(int fd)
+{
+    return 0;
+}
+
+
+int uh_is_radio(int fd)
+{
+    return 0;
+}
+
+
+int uh_is_ptt(int fd)
+{
+    return 0;
+}
+
+#endif /* UH_ROUTER */
@@ -24,10 +24,15 @@
 //
 //
 
-extern int  uh_open_radio(int baud, int databits, int stopbits, int rtscts);
-extern int  uh_open_ptt();
+// name selects the device: "" for the first one, or ":<match>" with part
+// of its device path (e.g. the serial number) or the device path itself
+extern int  uh_open_radio(const char *name, int baud, int databits,
+                          int stopbits, int rtscts);
+extern int  uh_open_ptt(const char *name);
+extern int  uh_open_wkey();
 extern void uh_close_wkey();
-extern void uh_set_ptt(int ptt);
-extern int  uh_get_ptt();
-extern void uh_close_radio();
-extern void uh_close_ptt();
+extern void uh_close(int fd);
+extern void uh_set_ptt(int fd, int ptt);
+extern int  uh_get_ptt(int fd);
+extern int  uh_is_radio(int fd);
+extern int  uh_is_ptt(int fd);
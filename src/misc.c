@@ -47,6 +47,8 @@
 #endif
 
 #include <math.h>
+#include <float.h>
+#include <locale.h>
 
 #include <hamlib/rig.h>
 #include <hamlib/rotator.h>
@@ -121,6 +123,47 @@ static int clock_gettime(clockid_t clock_id, struct timespec *tp)
 
 #endif // __APPLE__
 
+/*
+ * BCD tables.  Each step of the codec does one octet, two digits, so a
+ * 10 digit CI-V frequency is 5 lookups with one divide by 100 each way,
+ * instead of a divide and a modulo per digit.  bcd_dec[] also covers the
+ * non-BCD octets, giving what the old digit at a time decoding gave.
+ */
+static const unsigned char bcd_enc[100] =
+{
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19,
+    0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29,
+    0x30, 0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39,
+    0x40, 0x41, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49,
+    0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x60, 0x61, 0x62, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69,
+    0x70, 0x71, 0x72, 0x73, 0x74, 0x75, 0x76, 0x77, 0x78, 0x79,
+    0x80, 0x81, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x90, 0x91, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99
+};
+
+static const unsigned char bcd_dec[256] =
+{
+      0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,
+     10,  11,  12,  13,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  25,
+     20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35,
+     30,  31,  32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,
+     40,  41,  42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,
+     50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,  64,  65,
+     60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,
+     70,  71,  72,  73,  74,  75,  76,  77,  78,  79,  80,  81,  82,  83,  84,  85,
+     80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  95,
+     90,  91,  92,  93,  94,  95,  96,  97,  98,  99, 100, 101, 102, 103, 104, 105,
+    100, 101, 102, 103, 104, 105, 106, 107, 108, 109, 110, 111, 112, 113, 114, 115,
+    110, 111, 112, 113, 114, 115, 116, 117, 118, 119, 120, 121, 122, 123, 124, 125,
+    120, 121, 122, 123, 124, 125, 126, 127, 128, 129, 130, 131, 132, 133, 134, 135,
+    130, 131, 132, 133, 134, 135, 136, 137, 138, 139, 140, 141, 142, 143, 144, 145,
+    140, 141, 142, 143, 144, 145, 146, 147, 148, 149, 150, 151, 152, 153, 154, 155,
+    150, 151, 152, 153, 154, 155, 156, 157, 158, 159, 160, 161, 162, 163, 164, 165
+};
+
+
 /**
  * \brief Convert from binary to 4-bit BCD digits, little-endian
  * \param bcd_data
@@ -135,8 +178,6 @@ static int clock_gettime(clockid_t clock_id, struct timespec *tp)
  * bcd_len is the number of BCD digits, usually 10 or 8 in 1-Hz units,
  * and 6 digits in 100-Hz units for Tx offset data.
  *
- * Hope the compiler will do a good job optimizing it (esp. w/the 64bit freq)
- *
  * Returns a pointer to (unsigned char *)bcd_data.
  *
  * \sa to_bcd_be()
@@ -147,18 +188,13 @@ unsigned char *HAMLIB_API to_bcd(unsigned char bcd_data[],
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
     /* '450'/4-> 5,0;0,4 */
     /* '450'/3-> 5,0;x,4 */
 
     for (i = 0; i < bcd_len / 2; i++)
     {
-        unsigned char a = freq % 10;
-        freq /= 10;
-        a |= (freq % 10) << 4;
-        freq /= 10;
-        bcd_data[i] = a;
+        bcd_data[i] = bcd_enc[freq % 100];
+        freq /= 100;
     }
 
     if (bcd_len & 1)
@@ -182,8 +218,6 @@ unsigned char *HAMLIB_API to_bcd(unsigned char bcd_data[],
  *
  * bcd_len is the number of BCD digits.
  *
- * Hope the compiler will do a good job optimizing it (esp. w/ the 64bit freq)
- *
  * Returns frequency in Hz an unsigned long long integer.
  *
  * \sa from_bcd_be()
@@ -192,9 +226,7 @@ unsigned long long HAMLIB_API from_bcd(const unsigned char bcd_data[],
                                        unsigned bcd_len)
 {
     int i;
-    freq_t f = 0;
-
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    unsigned long long f = 0;
 
     if (bcd_len & 1)
     {
@@ -203,10 +235,7 @@ unsigned long long HAMLIB_API from_bcd(const unsigned char bcd_data[],
 
     for (i = (bcd_len / 2) - 1; i >= 0; i--)
     {
-        f *= 10;
-        f += bcd_data[i] >> 4;
-        f *= 10;
-        f += bcd_data[i] & 0x0f;
+        f = f * 100 + bcd_dec[bcd_data[i]];
     }
 
     return f;
@@ -234,8 +263,6 @@ unsigned char *HAMLIB_API to_bcd_be(unsigned char bcd_data[],
     /* '450'/4 -> 0,4;5,0 */
     /* '450'/3 -> 4,5;0,x */
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
     if (bcd_len & 1)
     {
         bcd_data[bcd_len / 2] &= 0x0f;
@@ -246,11 +273,8 @@ unsigned char *HAMLIB_API to_bcd_be(unsigned char bcd_data[],
 
     for (i = (bcd_len / 2) - 1; i >= 0; i--)
     {
-        unsigned char a = freq % 10;
-        freq /= 10;
-        a |= (freq % 10) << 4;
-        freq /= 10;
-        bcd_data[i] = a;
+        bcd_data[i] = bcd_enc[freq % 100];
+        freq /= 100;
     }
 
     return bcd_data;
@@ -272,16 +296,11 @@ unsigned long long HAMLIB_API from_bcd_be(const unsigned char bcd_data[],
         unsigned bcd_len)
 {
     int i;
-    freq_t f = 0;
-
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    unsigned long long f = 0;
 
     for (i = 0; i < bcd_len / 2; i++)
     {
-        f *= 10;
-        f += bcd_data[i] >> 4;
-        f *= 10;
-        f += bcd_data[i] & 0x0f;
+        f = f * 100 + bcd_dec[bcd_data[i]];
     }
 
     if (bcd_len & 1)
@@ -293,6 +312,317 @@ unsigned long long HAMLIB_API from_bcd_be(const unsigned char bcd_data[],
     return f;
 }
 
+/**
+ * \brief Convert several little-endian BCD fields in a row to binary
+ * \param bcd_data The first field
+ * \param bcd_len Number of BCD digits of each field, even
+ * \param val Output, \a n values
+ * \param n Number of fields
+ *
+ * For frames carrying fields back to back, like the lower and upper edge
+ * of an Icom scope wave frame.
+ *
+ * \sa from_bcd()
+ */
+void HAMLIB_API from_bcd_list(const unsigned char bcd_data[], unsigned bcd_len,
+                              unsigned long long val[], int n)
+{
+    int k;
+
+    for (k = 0; k < n; k++)
+    {
+        val[k] = from_bcd(bcd_data + k * (bcd_len / 2), bcd_len);
+    }
+}
+
+
+/**
+ * \brief Convert several values to little-endian BCD fields in a row
+ * \param bcd_data Output, \a n fields of \a bcd_len digits
+ * \param val Values to convert
+ * \param bcd_len Number of BCD digits of each field, even
+ * \param n Number of fields
+ * \return bcd_data
+ *
+ * \sa to_bcd()
+ */
+unsigned char *HAMLIB_API to_bcd_list(unsigned char bcd_data[],
+                                      const unsigned long long val[],
+                                      unsigned bcd_len, int n)
+{
+    int k;
+
+    for (k = 0; k < n; k++)
+    {
+        to_bcd(bcd_data + k * (bcd_len / 2), val[k], bcd_len);
+    }
+
+    return bcd_data;
+}
+
+
+/*
+ * sscanf() replacements for the number arguments of rigctl/rigctld
+ * commands.  The plain decimal forms every client sends are converted
+ * directly, anything else (exponents, hex, inf, overflow, a locale with a
+ * decimal comma...) goes to sscanf, so the result and the return value are
+ * always those of sscanf.
+ */
+
+/* Digits of s as an integer, after blanks and a sign; NULL if unusual */
+static const char *num_scan_digits(const char *s, int max_digits,
+                                   unsigned long long *acc, int *neg)
+{
+    int n;
+
+    while (*s == ' ' || *s == '\t' || *s == '\n' || *s == '\r') { s++; }
+
+    *neg = *s == '-';
+
+    if (*s == '-' || *s == '+') { s++; }
+
+    for (*acc = 0, n = 0; *s >= '0' && *s <= '9'; s++, n++)
+    {
+        if (n == max_digits) { return NULL; }
+
+        *acc = *acc * 10 + (*s - '0');
+    }
+
+    return n ? s : NULL;
+}
+
+/* A number ends where sscanf would stop too */
+static int num_scan_end(const char *s)
+{
+    return *s == '\0' || *s == ' ' || *s == '\t' || *s == '\n' || *s == '\r'
+           || (strchr(".,eEpPxXiInN", *s) == NULL
+               && !(*s >= '0' && *s <= '9'));
+}
+
+/* The decimal point is a dot in the current locale */
+static int num_scan_dot(void)
+{
+    const struct lconv *lc = localeconv();
+
+    return lc->decimal_point[0] == '.' && lc->decimal_point[1] == '\0';
+}
+
+/* [-]digits[.digits] as mantissa / 10^frac, mantissa below limit */
+static int num_scan_decimal(const char *s, unsigned long long limit,
+                            int max_frac, unsigned long long *mant, int *frac,
+                            int *neg)
+{
+    const char *p = s;
+    int digits = 0;
+
+    while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') { p++; }
+
+    *neg = *p == '-';
+
+    if (*p == '-' || *p == '+') { p++; }
+
+    for (*mant = 0, *frac = 0; *p >= '0' && *p <= '9'; p++, digits++)
+    {
+        *mant = *mant * 10 + (*p - '0');
+
+        if (*mant >= limit) { return 0; }
+    }
+
+    if (*p == '.')
+    {
+        if (!num_scan_dot()) { return 0; }
+
+        for (p++; *p >= '0' && *p <= '9'; p++, digits++)
+        {
+            *mant = *mant * 10 + (*p - '0');
+
+            if (*mant >= limit || ++*frac > max_frac) { return 0; }
+        }
+    }
+
+    return digits > 0 && num_scan_end(p);
+}
+
+int HAMLIB_API num_scan_int(const char *s, int *val)
+{
+    unsigned long long acc;
+    int neg;
+    const char *end = num_scan_digits(s, 9, &acc, &neg);
+
+    if (!end || !num_scan_end(end))
+    {
+        return sscanf(s, "%d", val);
+    }
+
+    *val = neg ? -(int) acc : (int) acc;
+
+    return 1;
+}
+
+int HAMLIB_API num_scan_long(const char *s, long *val)
+{
+    unsigned long long acc;
+    int neg;
+    const char *end = num_scan_digits(s, sizeof(long) > 4 ? 18 : 9, &acc, &neg);
+
+    if (!end || !num_scan_end(end))
+    {
+        return sscanf(s, "%ld", val);
+    }
+
+    *val = neg ? -(long) acc : (long) acc;
+
+    return 1;
+}
+
+/*
+ * Mantissa and power of ten both exact, so one division rounds correctly
+ * and the result is that of strtod()
+ */
+int HAMLIB_API num_scan_double(const char *s, double *val)
+{
+    static const double p10[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    unsigned long long mant;
+    int frac, neg;
+    double d;
+
+    if (!num_scan_decimal(s, 1ULL << 53, 22, &mant, &frac, &neg))
+    {
+        return sscanf(s, "%lf", val);
+    }
+
+    d = (double) mant / p10[frac];
+    *val = neg ? -d : d;
+
+    return 1;
+}
+
+int HAMLIB_API num_scan_float(const char *s, float *val)
+{
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+    static const float p10[] =
+    {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+    };
+    unsigned long long mant;
+    int frac, neg;
+    float f;
+
+    if (!num_scan_decimal(s, 1ULL << 24, 10, &mant, &frac, &neg))
+    {
+        return sscanf(s, "%f", val);
+    }
+
+    f = (float) mant / p10[frac];
+    *val = neg ? -f : f;
+
+    return 1;
+#else
+    /* float maths done wider would round twice */
+    return sscanf(s, "%f", val);
+#endif
+}
+
+/* "00".."99", two digits per division */
+static const char num_fmt_pairs[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* digits of u right-aligned ending at end, returns where they start */
+static char *num_fmt_digits(char *end, uint64_t u)
+{
+    while (u >= 100)
+    {
+        const char *d = num_fmt_pairs + (u % 100) * 2;
+
+        u /= 100;
+        *--end = d[1];
+        *--end = d[0];
+    }
+
+    if (u >= 10)
+    {
+        *--end = num_fmt_pairs[u * 2 + 1];
+        *--end = num_fmt_pairs[u * 2];
+    }
+    else
+    {
+        *--end = '0' + u;
+    }
+
+    return end;
+}
+
+/*
+ * printf("%" PRId64) without printf: str needs 21 bytes, is NUL
+ * terminated, and the length is returned.
+ */
+int HAMLIB_API num_fmt_int(char *str, int64_t val)
+{
+    char num[20];
+    char *p = num_fmt_digits(num + sizeof(num),
+                             val < 0 ? -(uint64_t) val : (uint64_t) val);
+    int len = 0;
+
+    if (val < 0) { str[len++] = '-'; }
+
+    memcpy(str + len, p, num + sizeof(num) - p);
+    len += num + sizeof(num) - p;
+    str[len] = '\0';
+
+    return len;
+}
+
+/*
+ * printf("%f") without printf for the values levels take: str needs 32
+ * bytes.  Scaled to micro units the value is an integer plus a fraction
+ * that decides the rounding; when that fraction is too near one half
+ * for the product to tell, or the number is large or not finite, or the
+ * locale has no decimal dot, printf decides.
+ */
+int HAMLIB_API num_fmt_float(char *str, double val)
+{
+    double a = fabs(val);
+    double scaled, frac;
+    uint64_t u, fp;
+    int len = 0;
+
+    if (!(a < 1e9) || !num_scan_dot())
+    {
+        return snprintf(str, 32, "%f", val);
+    }
+
+    scaled = a * 1e6;
+    u = (uint64_t) scaled;
+    frac = scaled - (double) u;
+
+    if (fabs(frac - 0.5) <= scaled * 1e-15 + 1e-12)
+    {
+        return snprintf(str, 32, "%f", val);
+    }
+
+    if (frac > 0.5) { u++; }
+
+    if (signbit(val)) { str[len++] = '-'; }
+
+    len += num_fmt_int(str + len, (int64_t)(u / 1000000));
+    str[len++] = '.';
+
+    fp = u % 1000000;
+    memcpy(str + len, num_fmt_pairs + (fp / 10000) * 2, 2);
+    memcpy(str + len + 2, num_fmt_pairs + (fp / 100 % 100) * 2, 2);
+    memcpy(str + len + 4, num_fmt_pairs + (fp % 100) * 2, 2);
+    len += 6;
+    str[len] = '\0';
+
+    return len;
+}
+
 size_t HAMLIB_API to_hex(size_t source_length, const unsigned char *source_data,
                          size_t dest_length, char *dest_data)
 {
@@ -385,6 +715,7 @@ int HAMLIB_API sprintf_freq(char *str, int str_len, freq_t freq)
     double f;
     char *hz;
     int decplaces = 10;
+    int unit_digits = 9;
     int retval;
 
     // too verbose
@@ -400,18 +731,58 @@ int HAMLIB_API sprintf_freq(char *str, int str_len, freq_t freq)
         hz = "MHz";
         f = (double)freq / MHz(1);
         decplaces = 7;
+        unit_digits = 6;
     }
     else if (llabs(freq) >= kHz(1))
     {
         hz = "kHz";
         f = (double)freq / kHz(1);
         decplaces = 4;
+        unit_digits = 3;
     }
     else
     {
         hz = "Hz";
         f = (double)freq;
         decplaces = 1;
+        unit_digits = 0;
+    }
+
+    // whole Hz: the digits as they are, the point moved, no division
+    if (fabs(freq) < 1e15 && freq == (double)(int64_t) freq
+            && !(freq == 0 && signbit(freq)) && num_scan_dot())
+    {
+        char num[48];
+        char digits[21];
+        int64_t n = (int64_t) freq;
+        int len = 0, dlen, ilen;
+
+        if (n < 0)
+        {
+            num[len++] = '-';
+            n = -n;
+        }
+
+        // the unit was picked so that a digit is left before the point
+        dlen = num_fmt_int(digits, n);
+        ilen = dlen - unit_digits;
+
+        memcpy(num + len, digits, ilen);
+        len += ilen;
+        num[len++] = '.';
+        memcpy(num + len, digits + ilen, unit_digits);
+        len += unit_digits;
+
+        memset(num + len, '0', decplaces - unit_digits);
+        len += decplaces - unit_digits;
+        num[len++] = ' ';
+        len += strlen(strcpy(num + len, hz));
+
+        if (len < str_len)
+        {
+            memcpy(str, num, len + 1);
+            return len;
+        }
     }
 
     SNPRINTF(str, str_len, "%.*f %s", decplaces, f, hz);
@@ -500,6 +871,119 @@ static const struct
     { RIG_MODE_NONE, "" },
 };
 
+/*
+ * Name lookups for the rig_parse_*() tables, built on first use: an open
+ * addressing hash of the names holding table index + 1, the first entry
+ * of a name winning as with the old linear walks.  A table is walked as an
+ * array of entries stride bytes apart with the name pointer at str_off, so
+ * the one index type serves all of them.
+ */
+#define NAME_INDEX_SIZE 256
+
+struct name_index
+{
+    int ready;
+    unsigned char slot[NAME_INDEX_SIZE];
+};
+
+#define NAME_AT(table, stride, str_off, i) \
+    (*(const char *const *)((const char *)(table) + (i) * (stride) + (str_off)))
+
+static unsigned int name_hash(const char *s)
+{
+    unsigned int h = 2166136261u;   /* FNV-1a */
+
+    while (*s)
+    {
+        h = (h ^ (unsigned char) *s++) * 16777619u;
+    }
+
+    return h % NAME_INDEX_SIZE;
+}
+
+static void name_index_init(struct name_index *ni, const void *table,
+                            size_t stride, size_t str_off)
+{
+    int i;
+
+    if (__atomic_load_n(&ni->ready, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+
+    /* racing threads all write the same values */
+    for (i = 0; i < NAME_INDEX_SIZE / 2
+            && NAME_AT(table, stride, str_off, i)[0] != '\0'; i++)
+    {
+        const char *name = NAME_AT(table, stride, str_off, i);
+        unsigned int h;
+
+        for (h = name_hash(name); ni->slot[h]; h = (h + 1) % NAME_INDEX_SIZE)
+        {
+            if (!strcmp(NAME_AT(table, stride, str_off, ni->slot[h] - 1), name)) { break; }
+        }
+
+        if (!ni->slot[h]) { ni->slot[h] = i + 1; }
+    }
+
+    __atomic_store_n(&ni->ready, 1, __ATOMIC_RELEASE);
+}
+
+/* Index of the first entry named s, -1 if none */
+static int name_index_find(struct name_index *ni, const void *table,
+                           size_t stride, size_t str_off, const char *s)
+{
+    unsigned int h;
+
+    name_index_init(ni, table, stride, str_off);
+
+    for (h = name_hash(s); ni->slot[h]; h = (h + 1) % NAME_INDEX_SIZE)
+    {
+        if (!strcmp(s, NAME_AT(table, stride, str_off, ni->slot[h] - 1)))
+        {
+            return ni->slot[h] - 1;
+        }
+    }
+
+    return -1;
+}
+
+#define NAME_FIND(ni, table, s) \
+    name_index_find(&(ni), (table), sizeof((table)[0]), \
+                    (size_t)((const char *) &(table)[0].str - (const char *) (table)), (s))
+
+
+/* The name of each rmode_t bit, the first mode_str entry winning */
+static const char *mode_by_bit[64];
+static struct name_index mode_names;
+static int mode_index_ready;
+
+static void mode_index_init(void)
+{
+    int i;
+
+    if (__atomic_load_n(&mode_index_ready, __ATOMIC_ACQUIRE))
+    {
+        return;
+    }
+
+    /* racing threads all write the same values */
+    for (i = 0 ; mode_str[i].str[0] != '\0'; i++)
+    {
+        rmode_t mode = mode_str[i].mode;
+        int bit;
+
+        for (bit = 0; !(mode & 1); bit++)
+        {
+            mode >>= 1;
+        }
+
+        if (!mode_by_bit[bit]) { mode_by_bit[bit] = mode_str[i].str; }
+    }
+
+    __atomic_store_n(&mode_index_ready, 1, __ATOMIC_RELEASE);
+}
+
 
 /**
  * \brief Convert alpha string to enum RIG_MODE
@@ -512,14 +996,11 @@ rmode_t HAMLIB_API rig_parse_mode(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    i = NAME_FIND(mode_names, mode_str, s);
 
-    for (i = 0 ; mode_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        if (!strcmp(s, mode_str[i].str))
-        {
-            return mode_str[i].mode;
-        }
+        return mode_str[i].mode;
     }
 
     rig_debug(RIG_DEBUG_WARN, "%s: mode '%s' not found\n", __func__, s);
@@ -541,20 +1022,19 @@ const char *HAMLIB_API rig_strrmode(rmode_t mode)
     // only enable if needed for debugging -- too verbose otherwise
     //rig_debug(RIG_DEBUG_TRACE, "%s called mode=0x%"PRXll"\n", __func__, mode);
 
-    if (mode == RIG_MODE_NONE)
+    if (mode == RIG_MODE_NONE || (mode & (mode - 1)))
     {
         return "";
     }
 
-    for (i = 0 ; mode_str[i].str[0] != '\0'; i++)
+    mode_index_init();
+
+    for (i = 0; !(mode & 1); i++)
     {
-        if (mode == mode_str[i].mode)
-        {
-            return mode_str[i].str;
-        }
+        mode >>= 1;
     }
 
-    return "";
+    return mode_by_bit[i] ? mode_by_bit[i] : "";
 }
 
 /**
@@ -625,6 +1105,8 @@ static const struct
     { 0xffffffff, "" },
 };
 
+static struct name_index vfo_names;
+
 
 /**
  * \brief Convert alpha string to enum RIG_VFO_...
@@ -637,16 +1119,11 @@ vfo_t HAMLIB_API rig_parse_vfo(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    i = NAME_FIND(vfo_names, vfo_str, s);
 
-    for (i = 0 ; vfo_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        if (!strcmp(s, vfo_str[i].str))
-        {
-            rig_debug(RIG_DEBUG_CACHE, "%s: str='%s' vfo='%s'\n", __func__, vfo_str[i].str,
-                      rig_strvfo(vfo_str[i].vfo));
-            return vfo_str[i].vfo;
-        }
+        return vfo_str[i].vfo;
     }
 
     rig_debug(RIG_DEBUG_ERR, "%s: '%s' not found so vfo='%s'\n", __func__, s,
@@ -737,6 +1214,8 @@ static const struct
     { RIG_FUNC_NONE, "" },
 };
 
+static struct name_index rig_func_names;
+
 
 static const struct
 {
@@ -747,6 +1226,8 @@ static const struct
     { ROT_FUNC_NONE, "" },
 };
 
+static struct name_index rot_func_names;
+
 
 /**
  * utility function to convert index to bit value
@@ -768,14 +1249,11 @@ setting_t HAMLIB_API rig_parse_func(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    i = NAME_FIND(rig_func_names, rig_func_str, s);
 
-    for (i = 0 ; rig_func_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        if (!strcmp(s, rig_func_str[i].str))
-        {
-            return rig_func_str[i].func;
-        }
+        return rig_func_str[i].func;
     }
 
     return RIG_FUNC_NONE;
@@ -793,14 +1271,11 @@ setting_t HAMLIB_API rot_parse_func(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    i = NAME_FIND(rot_func_names, rot_func_str, s);
 
-    for (i = 0 ; rot_func_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        if (!strcmp(s, rot_func_str[i].str))
-        {
-            return rot_func_str[i].func;
-        }
+        return rot_func_str[i].func;
     }
 
     return ROT_FUNC_NONE;
@@ -926,6 +1401,8 @@ static const struct
     { RIG_LEVEL_NONE, "" },
 };
 
+static struct name_index rig_level_names;
+
 
 static const struct
 {
@@ -937,6 +1414,8 @@ static const struct
     { ROT_LEVEL_NONE, "" },
 };
 
+static struct name_index rot_level_names;
+
 
 static const struct
 {
@@ -955,6 +1434,8 @@ static const struct
     { AMP_LEVEL_NONE, "" },
 };
 
+static struct name_index amp_level_names;
+
 
 /**
  * \brief Convert alpha string to enum RIG_LEVEL_...
@@ -967,14 +1448,11 @@ setting_t HAMLIB_API rig_parse_level(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    i = NAME_FIND(rig_level_names, rig_level_str, s);
 
-    for (i = 0 ; rig_level_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        if (!strcmp(s, rig_level_str[i].str))
-        {
-            return rig_level_str[i].level;
-        }
+        return rig_level_str[i].level;
     }
 
     return RIG_LEVEL_NONE;
@@ -992,14 +1470,11 @@ setting_t HAMLIB_API rot_parse_level(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    i = NAME_FIND(rot_level_names, rot_level_str, s);
 
-    for (i = 0 ; rot_level_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        if (!strcmp(s, rot_level_str[i].str))
-        {
-            return rot_level_str[i].level;
-        }
+        return rot_level_str[i].level;
     }
 
     return ROT_LEVEL_NONE;
@@ -1017,20 +1492,11 @@ setting_t HAMLIB_API amp_parse_level(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called level=%s\n", __func__, s);
+    i = NAME_FIND(amp_level_names, amp_level_str, s);
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called str=%s\n", __func__,
-              amp_level_str[0].str);
-
-    for (i = 0 ; amp_level_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        rig_debug(RIG_DEBUG_VERBOSE, "%s called checking=%s\n", __func__,
-                  amp_level_str[i].str);
-
-        if (!strcmp(s, amp_level_str[i].str))
-        {
-            return amp_level_str[i].level;
-        }
+        return amp_level_str[i].level;
     }
 
     return AMP_LEVEL_NONE;
@@ -1144,6 +1610,8 @@ static const struct
     { RIG_PARM_NONE, "" },
 };
 
+static struct name_index rig_parm_names;
+
 
 static const struct
 {
@@ -1154,6 +1622,8 @@ static const struct
     { ROT_PARM_NONE, "" },
 };
 
+static struct name_index rot_parm_names;
+
 
 /**
  * \brief Convert alpha string to RIG_PARM_...
@@ -1166,14 +1636,11 @@ setting_t HAMLIB_API rig_parse_parm(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    i = NAME_FIND(rig_parm_names, rig_parm_str, s);
 
-    for (i = 0 ; rig_parm_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        if (!strcmp(s, rig_parm_str[i].str))
-        {
-            return rig_parm_str[i].parm;
-        }
+        return rig_parm_str[i].parm;
     }
 
     return RIG_PARM_NONE;
@@ -1191,14 +1658,11 @@ setting_t HAMLIB_API rot_parse_parm(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    i = NAME_FIND(rot_parm_names, rot_parm_str, s);
 
-    for (i = 0 ; rot_parm_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        if (!strcmp(s, rot_parm_str[i].str))
-        {
-            return rot_parm_str[i].parm;
-        }
+        return rot_parm_str[i].parm;
     }
 
     return ROT_PARM_NONE;
@@ -1399,6 +1863,8 @@ static const struct
     { RIG_OP_NONE, "" },
 };
 
+static struct name_index vfo_op_names;
+
 
 /**
  * \brief Convert alpha string to enum RIG_OP_...
@@ -1411,14 +1877,11 @@ vfo_op_t HAMLIB_API rig_parse_vfo_op(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    i = NAME_FIND(vfo_op_names, vfo_op_str, s);
 
-    for (i = 0 ; vfo_op_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        if (!strcmp(s, vfo_op_str[i].str))
-        {
-            return vfo_op_str[i].vfo_op;
-        }
+        return vfo_op_str[i].vfo_op;
     }
 
     return RIG_OP_NONE;
@@ -1469,6 +1932,8 @@ static const struct
     { -1, NULL }
 };
 
+static struct name_index scan_names;
+
 
 /**
  * \brief Convert alpha string to enum RIG_SCAN_...
@@ -1481,14 +1946,11 @@ scan_t HAMLIB_API rig_parse_scan(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    i = NAME_FIND(scan_names, scan_str, s);
 
-    for (i = 0 ; scan_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        if (strcmp(s, scan_str[i].str) == 0)
-        {
-            return scan_str[i].rscan;
-        }
+        return scan_str[i].rscan;
     }
 
     return RIG_SCAN_NONE;
@@ -1558,8 +2020,6 @@ const char *HAMLIB_API rig_strptrshift(rptr_shift_t shift)
  */
 rptr_shift_t HAMLIB_API rig_parse_rptr_shift(const char *s)
 {
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
-
     if (strcmp(s, "+") == 0)
     {
         return RIG_RPT_SHIFT_PLUS;
@@ -1591,6 +2051,8 @@ static const struct
     { RIG_MTYPE_NONE, "" },
 };
 
+static struct name_index mtype_names;
+
 
 /**
  * \brief Convert alpha string to enum RIG_MTYPE_...
@@ -1603,14 +2065,11 @@ chan_type_t HAMLIB_API rig_parse_mtype(const char *s)
 {
     int i;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    i = NAME_FIND(mtype_names, mtype_str, s);
 
-    for (i = 0 ; mtype_str[i].str[0] != '\0'; i++)
+    if (i >= 0)
     {
-        if (strcmp(s, mtype_str[i].str) == 0)
-        {
-            return mtype_str[i].mtype;
-        }
+        return mtype_str[i].mtype;
     }
 
     return RIG_MTYPE_NONE;
@@ -1834,7 +2293,18 @@ double HAMLIB_API elapsed_ms(struct timespec *start, int option)
 int HAMLIB_API rig_get_cache_timeout_ms(RIG *rig, hamlib_cache_t selection)
 {
     rig_debug(RIG_DEBUG_TRACE, "%s: called selection=%d\n", __func__, selection);
-    return rig->state.cache.timeout_ms;
+
+    switch (selection)
+    {
+    case HAMLIB_CACHE_LEVEL:
+        return rig->state.cache_level_timeout_ms;
+
+    case HAMLIB_CACHE_FUNC:
+        return rig->state.cache_func_timeout_ms;
+
+    default:
+        return rig->state.cache.timeout_ms;
+    }
 }
 
 int HAMLIB_API rig_set_cache_timeout_ms(RIG *rig, hamlib_cache_t selection,
@@ -1842,7 +2312,28 @@ int HAMLIB_API rig_set_cache_timeout_ms(RIG *rig, hamlib_cache_t selection,
 {
     rig_debug(RIG_DEBUG_TRACE, "%s: called selection=%d, ms=%d\n", __func__,
               selection, ms);
-    rig->state.cache.timeout_ms = ms;
+
+    // levels and funcs have their own TTLs, the rest share cache.timeout_ms
+    switch (selection)
+    {
+    case HAMLIB_CACHE_ALL:
+        rig->state.cache_level_timeout_ms = ms;
+        rig->state.cache_func_timeout_ms = ms;
+        rig->state.cache.timeout_ms = ms;
+        break;
+
+    case HAMLIB_CACHE_LEVEL:
+        rig->state.cache_level_timeout_ms = ms;
+        break;
+
+    case HAMLIB_CACHE_FUNC:
+        rig->state.cache_func_timeout_ms = ms;
+        break;
+
+    default:
+        rig->state.cache.timeout_ms = ms;
+    }
+
     return RIG_OK;
 }
 
@@ -2433,6 +2924,12 @@ void *HAMLIB_API rig_get_function_ptr(rig_model_t rig_model,
     case RIG_FUNCTION_PROCESS_ASYNC_FRAME:
         return caps->process_async_frame;
 
+    case RIG_FUNCTION_GET_BULK:
+        return caps->get_bulk;
+
+    case RIG_FUNCTION_SET_BULK:
+        return caps->set_bulk;
+
     default:
         rig_debug(RIG_DEBUG_ERR, "Unknown function?? function=%d\n", rig_function);
     }
@@ -2503,6 +3000,45 @@ const char *HAMLIB_API rig_get_caps_cptr(rig_model_t rig_model,
     }
 }
 
+/**
+ * \brief Get a pointer into a rig handle without using rig->state
+ * \param rig The rig handle
+ * \param idx Which part of the handle
+ *
+ * Applications that go through this (or the HAMLIB_RIGPORT() and friends
+ * macros) keep working if struct rig_state is reordered, e.g. to pack the
+ * fields the poll loop uses together, in a later major version.
+ *
+ * \return the pointer, NULL for an unknown \a idx
+ */
+void *HAMLIB_API rig_data_pointer(RIG *rig, rig_ptrx_t idx)
+{
+    switch (idx)
+    {
+    case RIG_PTRX_RIGPORT:
+        return &rig->state.rigport;
+
+    case RIG_PTRX_PTTPORT:
+        return &rig->state.pttport;
+
+    case RIG_PTRX_DCDPORT:
+        return &rig->state.dcdport;
+
+    case RIG_PTRX_CACHE:
+        return &rig->state.cache;
+
+    case RIG_PTRX_STATE:
+        return &rig->state;
+
+    case RIG_PTRX_CALLBACKS:
+        return &rig->callbacks;
+
+    default:
+        rig_debug(RIG_DEBUG_ERR, "%s: Invalid data index=%d\n", __func__, idx);
+        return NULL;
+    }
+}
+
 void errmsg(int err, char *s, const char *func, const char *file, int line)
 {
     rig_debug(RIG_DEBUG_ERR, "%s(%s:%d): %s: %s\b", __func__, file, line, s,
@@ -2556,15 +3092,25 @@ static struct tm *gmtime_r(const time_t *t, struct tm *r)
 
 //! @cond Doxygen_Suppress
 char *date_strget(char *buf, int buflen, int localtime)
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return date_strget_tv(buf, buflen, localtime, &tv);
+}
+
+// same as date_strget but for a time captured earlier
+char *date_strget_tv(char *buf, int buflen, int localtime,
+                     const struct timeval *tv)
 {
     char tmpbuf[64];
     struct tm *mytm;
     time_t t;
-    struct timeval tv;
     struct tm result;
     int mytimezone;
 
-    t = time(NULL);
+    t = tv->tv_sec;
 
     if (localtime)
     {
@@ -2578,8 +3124,7 @@ char *date_strget(char *buf, int buflen, int localtime)
     }
 
     strftime(buf, buflen, "%Y-%m-%dT%H:%M:%S.", mytm);
-    gettimeofday(&tv, NULL);
-    SNPRINTF(tmpbuf, sizeof(tmpbuf), "%06ld", (long)tv.tv_usec);
+    SNPRINTF(tmpbuf, sizeof(tmpbuf), "%06ld", (long)tv->tv_usec);
     strcat(buf, tmpbuf);
     SNPRINTF(tmpbuf, sizeof(tmpbuf), "%s%04d", mytimezone >= 0 ? "-" : "+",
              ((int)abs(mytimezone) / 3600) * 100);
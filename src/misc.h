@@ -23,6 +23,7 @@
 #define _MISC_H 1
 
 #include <hamlib/rig.h>
+#include "trace.h"
 
 
 /*
@@ -36,6 +37,48 @@
 #define set_transaction_inactive(rig) {(rig)->state.transaction_active = 0;}
 #endif
 
+/*
+ * Per-RIG locking, outermost first:
+ *
+ *  - the API lock, taken by RIG_LOCK() at the top of the rig_xxx() API
+ *    calls, serializes what they do to rig_state and the port.  It nests
+ *    because the API calls call each other and the backends call back
+ *    into them; callbacks fired from inside run with it held.  Threads
+ *    waiting for it are served by class, see rig_prio_t: a PTT off goes
+ *    ahead of queued setters, setters ahead of getters, getters ahead of
+ *    meter reads and the poll routine.  rig_lock_preempt() lets a PTT off
+ *    in between the transactions of a long call such as send_morse.
+ *    rs->mutex_state only guards the lock's own fields.
+ *  - rs->mutex_set_transaction, set_transaction_active() above, keeps a
+ *    multi-frame exchange together for the backends that need it.
+ *  - the cache sequence counter, see rig_cache_write_begin(), which readers
+ *    never wait on.  Getters the cache can answer read it before RIG_LOCK(),
+ *    so they do not queue up behind a slow exchange on another thread.
+ *
+ * RIG_LOCK() holds the lock up to the end of the enclosing block, at
+ * RIG_PRIO_GET; RIG_LOCK_PRIO() names the class.
+ * rig_open(), rig_close() and rig_cleanup() are not covered: they start and
+ * join the threads that make the other calls.  Without the cleanup
+ * attribute the calls stay unlocked, as they used to be.
+ */
+#if defined(HAVE_PTHREAD) && defined(__GNUC__)
+extern RIG *rig_lock_acquire(RIG *rig, rig_prio_t prio);
+extern void rig_lock_release(RIG **rig);
+extern int rig_lock_preempt(RIG *rig);
+extern void rig_lock_thread_prio(rig_prio_t prio);
+#define RIG_LOCK_PRIO(rig, prio) \
+    RIG *rig_lock_held_ __attribute__((cleanup(rig_lock_release), unused)) = \
+        rig_lock_acquire((rig), (prio))
+#else
+#define RIG_LOCK_PRIO(rig, prio) do {} while (0)
+#define rig_lock_preempt(rig) 0
+#define rig_lock_thread_prio(prio) do {} while (0)
+#endif
+#define RIG_LOCK(rig) RIG_LOCK_PRIO(rig, RIG_PRIO_GET)
+
+/* 1 once the thread's rig_set_deadline() has passed, see deadline.c */
+extern int rig_deadline_cache(void);
+
 __BEGIN_DECLS
 
 // a function to return just a string of spaces for indenting rig debug lines
@@ -76,6 +119,30 @@ extern HAMLIB_EXPORT(unsigned long long) from_bcd_be(const unsigned char
                                                      bcd_data[],
                                                      unsigned bcd_len);
 
+/*
+ * n fields of bcd_len (even) digits back to back, little endian
+ */
+extern HAMLIB_EXPORT(void) from_bcd_list(const unsigned char bcd_data[],
+                                         unsigned bcd_len,
+                                         unsigned long long val[],
+                                         int n);
+
+extern HAMLIB_EXPORT(unsigned char *) to_bcd_list(unsigned char bcd_data[],
+                                                  const unsigned long long val[],
+                                                  unsigned bcd_len,
+                                                  int n);
+
+/*
+ * sscanf(s, "%d"/"%ld"/"%lf"/"%f", val) with the plain decimal forms
+ * converted without going through the scanf machinery
+ */
+extern HAMLIB_EXPORT(int) num_scan_int(const char *s, int *val);
+extern HAMLIB_EXPORT(int) num_scan_long(const char *s, long *val);
+extern HAMLIB_EXPORT(int) num_scan_double(const char *s, double *val);
+extern HAMLIB_EXPORT(int) num_scan_float(const char *s, float *val);
+extern HAMLIB_EXPORT(int) num_fmt_int(char *str, int64_t val);
+extern HAMLIB_EXPORT(int) num_fmt_float(char *str, double val);
+
 extern HAMLIB_EXPORT(size_t) to_hex(size_t source_length,
                                     const unsigned char *source_data,
                                     size_t dest_length,
@@ -124,6 +191,7 @@ extern HAMLIB_EXPORT(int) parse_hoststr(char *hoststr, int hoststr_len, char hos
 extern HAMLIB_EXPORT(uint32_t) CRC32_function(uint8_t *buf, uint32_t len);
 
 extern HAMLIB_EXPORT(char *)date_strget(char *buf, int buflen, int localtime);
+extern HAMLIB_EXPORT(char *)date_strget_tv(char *buf, int buflen, int localtime, const struct timeval *tv);
 
 #ifdef PRId64
 /** \brief printf(3) format to be used for long long (64bits) type */
@@ -157,45 +225,30 @@ extern HAMLIB_EXPORT(char *)date_strget(char *buf, int buflen, int localtime);
 void errmsg(int err, char *s, const char *func, const char *file, int line);
 #define ERRMSG(err, s) errmsg(err,  s, __func__, __FILENAME__, __LINE__)
 #define ENTERFUNC {     ++rig->state.depth; \
+                        TRACE_FUNC_ENTRY(__func__, rig->state.depth); \
                         rig_debug(RIG_DEBUG_VERBOSE, "%.*s%d:%s(%d):%s entered\n", rig->state.depth, spaces(), rig->state.depth, __FILENAME__, __LINE__, __func__); \
                   }
-#define ENTERFUNC2 {    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d):%s entered\n", __FILENAME__, __LINE__, __func__); \
+#define ENTERFUNC2 {    TRACE_FUNC_ENTRY(__func__, 0); \
+                        rig_debug(RIG_DEBUG_VERBOSE, "%s(%d):%s entered\n", __FILENAME__, __LINE__, __func__); \
                    }
 // we need to refer to rc just once as it 
 // could be a function call 
 #define RETURNFUNC(rc) {do { \
 			            int rctmp = rc; \
+                        TRACE_FUNC_RETURN(__func__, rig->state.depth, rctmp); \
                         rig_debug(RIG_DEBUG_VERBOSE, "%.*s%d:%s(%d):%s returning(%ld) %s\n", rig->state.depth, spaces(), rig->state.depth, __FILENAME__, __LINE__, __func__, (long int) (rctmp), rctmp<0?rigerror2(rctmp):""); \
                         --rig->state.depth; \
                         return (rctmp); \
                        } while(0);}
 #define RETURNFUNC2(rc) {do { \
 			            int rctmp = rc; \
+                        TRACE_FUNC_RETURN(__func__, 0, rctmp); \
                         rig_debug(RIG_DEBUG_VERBOSE, "%s(%d):%s returning2(%ld) %s\n",  __FILENAME__, __LINE__, __func__, (long int) (rctmp), rctmp<0?rigerror2(rctmp):""); \
                         return (rctmp); \
                        } while(0);}
 
-#define CACHE_RESET {\
-    elapsed_ms(&rig->state.cache.time_freqMainA, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_freqMainB, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_freqSubA, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_freqSubB, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_vfo, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_modeMainA, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_modeMainB, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_modeMainC, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_modeSubA, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_modeSubB, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_modeSubC, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_widthMainA, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_widthMainB, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_widthMainC, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_widthSubA, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_widthSubB, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_widthSubC, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_ptt, HAMLIB_ELAPSED_INVALIDATE);\
-    elapsed_ms(&rig->state.cache.time_split, HAMLIB_ELAPSED_INVALIDATE);\
-     }
+// every cache entry stale at once, see rig_cache_reset() in cache.c
+#define CACHE_RESET rig_cache_reset(rig)
 
 
 typedef enum settings_value_e
@@ -0,0 +1,375 @@
+/*
+ *  Hamlib Interface - CW message queue
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/*
+ * With the morse_queue option rig_send_morse() queues the message and
+ * returns, and a thread of the rig's own hands the queue to the backend
+ * MORSE_CHUNK characters at a time.  The backends wait for room in the
+ * rig's keyer buffer themselves (Kenwood asks KY; until it is free), so
+ * one chunk at a time keeps at most a buffer's worth ahead of what is
+ * keyed: the morse callback hears about every chunk the rig has taken,
+ * and rig_stop_morse() only has the rest of the current chunk to stop.
+ * A contest macro queued while the previous one is going out follows it
+ * without a gap.  The thread sleeps while the queue is empty.
+ *
+ * The chunks are the size of the Kenwood KY buffer, which the backends
+ * with bigger buffers take as it is, so the rig keys the same characters
+ * as with the whole message.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "morse_queue.h"
+#include "thread_sched.h"
+#include "misc.h"
+
+#ifdef HAVE_PTHREAD
+
+#define MORSE_CHUNK 24
+
+struct morse_msg
+{
+    struct morse_msg *next;
+    vfo_t vfo;
+    char text[];
+};
+
+struct morse_queue
+{
+    RIG *rig;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;    /* something queued, or stop */
+    pthread_cond_t idle;    /* queue empty and nothing being sent */
+    struct morse_msg *head, *tail;
+    unsigned int gen;       /* bumped by morse_queue_abort() */
+    int sending, stop;
+};
+
+
+static void morse_progress(RIG *rig, const struct morse_msg *m, int sent,
+                           int status)
+{
+    if (rig->callbacks.morse_event)
+    {
+        rig->callbacks.morse_event(rig, m->vfo, m->text, sent, status,
+                                   rig->callbacks.morse_arg);
+    }
+}
+
+
+/* dropped messages hear about it, called without the lock */
+static void morse_drop(RIG *rig, struct morse_msg *m)
+{
+    while (m)
+    {
+        struct morse_msg *next = m->next;
+
+        morse_progress(rig, m, 0, -RIG_ETRUNC);
+        free(m);
+        m = next;
+    }
+}
+
+
+static void *morse_queue_thread(void *arg)
+{
+    struct morse_queue *q = (struct morse_queue *) arg;
+    RIG *rig = q->rig;
+
+    hl_thread_sched_apply("morse queue");
+
+    pthread_mutex_lock(&q->lock);
+
+    for (;;)
+    {
+        struct morse_msg *m;
+        unsigned int gen;
+        int len, sent = 0, status = RIG_OK;
+
+        while (!q->stop && !q->head)
+        {
+            q->sending = 0;
+            pthread_cond_broadcast(&q->idle);
+            pthread_cond_wait(&q->cond, &q->lock);
+        }
+
+        if (q->stop)
+        {
+            break;
+        }
+
+        m = q->head;
+        q->head = m->next;
+
+        if (!q->head)
+        {
+            q->tail = NULL;
+        }
+
+        q->sending = 1;
+        gen = q->gen;
+        len = strlen(m->text);
+
+        while (sent < len && status == RIG_OK)
+        {
+            char chunk[MORSE_CHUNK + 1];
+            int n = len - sent > MORSE_CHUNK ? MORSE_CHUNK : len - sent;
+
+            memcpy(chunk, m->text + sent, n);
+            chunk[n] = '\0';
+
+            pthread_mutex_unlock(&q->lock);
+            status = rig_send_morse_now(rig, m->vfo, chunk);
+            pthread_mutex_lock(&q->lock);
+
+            if (q->gen != gen)
+            {
+                /* rig_stop_morse() came in meanwhile */
+                status = -RIG_ETRUNC;
+            }
+
+            if (status == RIG_OK)
+            {
+                sent += n;
+            }
+
+            pthread_mutex_unlock(&q->lock);
+            morse_progress(rig, m, sent, status);
+            pthread_mutex_lock(&q->lock);
+        }
+
+        if (status != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: %d of %d characters sent: %s\n",
+                      __func__, sent, len, rigerror(status));
+        }
+
+        free(m);
+    }
+
+    q->sending = 0;
+    pthread_cond_broadcast(&q->idle);
+    pthread_mutex_unlock(&q->lock);
+
+    return NULL;
+}
+
+
+int morse_queue_start(RIG *rig)
+{
+    struct morse_queue *q;
+    int retval;
+
+    if (!rig->state.morse_queue || rig->state.keyer)
+    {
+        /* the keyer has a queue of its own */
+        return RIG_OK;
+    }
+
+    q = calloc(1, sizeof(*q));
+
+    if (!q)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    q->rig = rig;
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    pthread_cond_init(&q->idle, NULL);
+
+    retval = pthread_create(&q->thread, NULL, morse_queue_thread, q);
+
+    if (retval)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(retval));
+        pthread_cond_destroy(&q->idle);
+        pthread_cond_destroy(&q->cond);
+        pthread_mutex_destroy(&q->lock);
+        free(q);
+        return -RIG_EINTERNAL;
+    }
+
+    rig->state.morse_queue_thread = q;
+
+    return RIG_OK;
+}
+
+
+void morse_queue_stop(RIG *rig)
+{
+    struct morse_queue *q = (struct morse_queue *) rig->state.morse_queue_thread;
+    struct morse_msg *dropped;
+
+    if (!q)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    dropped = q->head;
+    q->head = q->tail = NULL;
+    q->gen++;
+    q->stop = 1;
+    pthread_cond_broadcast(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+
+    morse_drop(rig, dropped);
+    pthread_join(q->thread, NULL);
+
+    pthread_cond_destroy(&q->idle);
+    pthread_cond_destroy(&q->cond);
+    pthread_mutex_destroy(&q->lock);
+    free(q);
+
+    rig->state.morse_queue_thread = NULL;
+}
+
+
+int morse_queue_send(RIG *rig, vfo_t vfo, const char *msg)
+{
+    struct morse_queue *q = (struct morse_queue *) rig->state.morse_queue_thread;
+    size_t len = strlen(msg);
+    struct morse_msg *m;
+
+    if (!q)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    m = malloc(sizeof(*m) + len + 1);
+
+    if (!m)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    m->next = NULL;
+    m->vfo = vfo;
+    memcpy(m->text, msg, len + 1);
+
+    pthread_mutex_lock(&q->lock);
+
+    if (q->tail)
+    {
+        q->tail->next = m;
+    }
+    else
+    {
+        q->head = m;
+    }
+
+    q->tail = m;
+    pthread_cond_signal(&q->cond);
+    pthread_mutex_unlock(&q->lock);
+
+    return RIG_OK;
+}
+
+
+void morse_queue_abort(RIG *rig)
+{
+    struct morse_queue *q = (struct morse_queue *) rig->state.morse_queue_thread;
+    struct morse_msg *dropped;
+
+    if (!q)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    dropped = q->head;
+    q->head = q->tail = NULL;
+    q->gen++;
+    pthread_mutex_unlock(&q->lock);
+
+    morse_drop(rig, dropped);
+}
+
+
+int morse_queue_wait(RIG *rig)
+{
+    struct morse_queue *q = (struct morse_queue *) rig->state.morse_queue_thread;
+
+    if (!q)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    while (!q->stop && (q->head || q->sending))
+    {
+        pthread_cond_wait(&q->idle, &q->lock);
+    }
+
+    pthread_mutex_unlock(&q->lock);
+
+    return RIG_OK;
+}
+
+#else
+
+int morse_queue_start(RIG *rig)
+{
+    if (!rig->state.morse_queue)
+    {
+        return RIG_OK;
+    }
+
+    rig_debug(RIG_DEBUG_ERR, "%s: the morse queue needs pthreads\n", __func__);
+    return -RIG_ENIMPL;
+}
+
+
+void morse_queue_stop(RIG *rig)
+{
+}
+
+
+int morse_queue_send(RIG *rig, vfo_t vfo, const char *msg)
+{
+    return -RIG_ENAVAIL;
+}
+
+
+void morse_queue_abort(RIG *rig)
+{
+}
+
+
+int morse_queue_wait(RIG *rig)
+{
+    return -RIG_ENAVAIL;
+}
+
+#endif
@@ -0,0 +1,46 @@
+/*
+ *  Hamlib Interface - CW message queue
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef _MORSE_QUEUE_H
+#define _MORSE_QUEUE_H 1
+
+#include <hamlib/rig.h>
+
+/* Start the queue thread when morse_queue is set, RIG_OK if it is not */
+int morse_queue_start(RIG *rig);
+
+/* Drops what is still queued, waits for the message being sent */
+void morse_queue_stop(RIG *rig);
+
+/* Queue a message, returns once it is queued */
+int morse_queue_send(RIG *rig, vfo_t vfo, const char *msg);
+
+/* Drop everything queued; the message being sent stops at its next chunk */
+void morse_queue_abort(RIG *rig);
+
+/* Wait until everything queued has been handed to the rig */
+int morse_queue_wait(RIG *rig);
+
+/* rig.c: rig_send_morse() without the queue, what the queue thread calls */
+int rig_send_morse_now(RIG *rig, vfo_t vfo, const char *msg);
+
+#endif /* _MORSE_QUEUE_H */
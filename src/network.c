@@ -49,6 +49,10 @@
 #  include <netinet/in.h>
 #endif
 
+#ifdef HAVE_NETINET_TCP_H
+#  include <netinet/tcp.h>
+#endif
+
 #if HAVE_NETDB_H
 #  include <netdb.h>
 #endif
@@ -78,7 +82,12 @@
 #include "network.h"
 #include "misc.h"
 #include "asyncpipe.h"
+#include "spscring.h"
 #include "snapshot_data.h"
+#include "spectrum_pool.h"
+#include "thread_sched.h"
+#include "event.h"
+#include "cache.h"
 
 #ifdef HAVE_WINDOWS_H
 #include "io.h"
@@ -115,9 +124,12 @@ typedef struct multicast_publisher_args_s
 #if defined(WIN32) && defined(HAVE_WINDOWS_H)
     hamlib_async_pipe_t *data_pipe;
 #else
-    int data_write_fd;
-    int data_read_fd;
+    struct spsc_ring *data_ring;
+    pthread_mutex_t data_write_lock;    /* the ring takes one producer at a time */
 #endif
+    struct snapshot_spectrum_history spectrum_history;
+    struct snapshot_state_history state_history;
+    int spectrum_inflight;  /* spectrum lines referenced from the pipe */
 } multicast_publisher_args;
 
 typedef struct multicast_publisher_priv_data_s
@@ -126,6 +138,204 @@ typedef struct multicast_publisher_priv_data_s
     multicast_publisher_args args;
 } multicast_publisher_priv_data;
 
+typedef struct multicast_subscriber_priv_data_s
+{
+    pthread_t thread_id;
+    RIG *rig;
+    int socket_fd;
+    volatile int run;
+    pthread_mutex_t mutex;      /* mirror and time, the thread is the only writer */
+    struct snapshot_mirror mirror;
+    struct timespec time;       /* of the last packet applied */
+    struct snapshot_spectrum_history spectrum_history;
+    unsigned char spectrum_data[HAMLIB_MAX_SPECTRUM_DATA];
+} multicast_subscriber_priv_data;
+
+/*
+ * Connection manager
+ *
+ * Every TCP port opened by network_open() gets an entry here recording how
+ * to open it again.  A backend that sees the link drop calls
+ * network_link_down(); a background thread then reconnects with
+ * exponential backoff while network_request_begin() lets requests wait a
+ * little for a reconnect under way or due, and fails the others at once
+ * instead of leaving them blocked for timeout * retry.
+ * network_transaction() wraps the whole pattern for line based protocols,
+ * replaying a request once over the new connection when it is a getter.
+ */
+#define NETWORK_CONN_MAX        16
+#define NETWORK_BACKOFF_MIN     250     /* ms before the 2nd attempt, doubling */
+#define NETWORK_BACKOFF_MAX     8000
+#define NETWORK_RECOVER_WAIT    1000    /* longest wait for a reconnect, ms */
+#define NETWORK_CONNECT_TIMEOUT 5000    /* upper bound on one connect(), ms */
+/* dead peers are noticed after KEEPIDLE + KEEPINTVL * KEEPCNT seconds */
+#define NETWORK_KEEPIDLE        5
+#define NETWORK_KEEPINTVL       1
+#define NETWORK_KEEPCNT         3
+
+struct network_conn
+{
+    hamlib_port_t *rp;
+    int default_port;
+    int down;
+    int generation;             /* bumped by each reconnect */
+    int backoff;                /* ms from last_attempt to the next attempt */
+    struct timespec last_attempt;
+    int (*resume)(hamlib_port_t *rp, void *arg);
+    void *resume_arg;
+    network_push_t push;
+    void *push_arg;
+    int thread_running;
+    int stop;
+};
+
+static struct network_conn network_conns[NETWORK_CONN_MAX];
+
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t network_conn_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t network_conn_cond = PTHREAD_COND_INITIALIZER;
+#define CONN_LOCK()      pthread_mutex_lock(&network_conn_mutex)
+#define CONN_UNLOCK()    pthread_mutex_unlock(&network_conn_mutex)
+#define CONN_BROADCAST() pthread_cond_broadcast(&network_conn_cond)
+#else
+#define CONN_LOCK()
+#define CONN_UNLOCK()
+#define CONN_BROADCAST()
+#endif
+
+/* entry of port rp, lock held */
+static struct network_conn *network_conn_find(hamlib_port_t *rp, int create)
+{
+    struct network_conn *c = NULL;
+    int i;
+
+    for (i = 0; i < NETWORK_CONN_MAX; i++)
+    {
+        if (network_conns[i].rp == rp)
+        {
+            return &network_conns[i];
+        }
+
+        if (create && !c && network_conns[i].rp == NULL)
+        {
+            c = &network_conns[i];
+        }
+    }
+
+    if (c)
+    {
+        memset(c, 0, sizeof(*c));
+        c->rp = rp;
+    }
+    else if (create)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: more than %d connections, %s not managed\n",
+                  __func__, NETWORK_CONN_MAX, rp->pathname);
+    }
+
+    return c;
+}
+
+/*
+ * connect() giving up after timeout ms rather than the OS default, which
+ * can be minutes for an unreachable host
+ */
+static int network_connect(int fd, const struct sockaddr *addr, socklen_t len,
+                           int timeout)
+{
+    int ret;
+    int inprogress;
+#ifdef __MINGW32__
+    u_long nonblock = 1;
+
+    ioctlsocket(fd, FIONBIO, &nonblock);
+#else
+    int flags = fcntl(fd, F_GETFL, 0);
+
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+#endif
+
+    ret = connect(fd, addr, len);
+
+#ifdef __MINGW32__
+    inprogress = ret != 0 && WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+    inprogress = ret != 0 && errno == EINPROGRESS;
+#endif
+
+    if (inprogress)
+    {
+        fd_set wfds, efds;
+        struct timeval tv;
+
+        FD_ZERO(&wfds);
+        FD_SET(fd, &wfds);
+        efds = wfds;
+        tv.tv_sec = timeout / 1000;
+        tv.tv_usec = (timeout % 1000) * 1000;
+
+        ret = select(fd + 1, NULL, &wfds, &efds, &tv);
+
+        if (ret == 0)
+        {
+            errno = ETIMEDOUT;
+            ret = -1;
+        }
+        else if (ret > 0)
+        {
+            int err = 0;
+            socklen_t errlen = sizeof(err);
+
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, (char *)&err, &errlen);
+
+            if (err != 0)
+            {
+                errno = err;
+                ret = -1;
+            }
+            else
+            {
+                ret = 0;
+            }
+        }
+    }
+
+#ifdef __MINGW32__
+    nonblock = 0;
+    ioctlsocket(fd, FIONBIO, &nonblock);
+#else
+    fcntl(fd, F_SETFL, flags);
+#endif
+
+    return ret;
+}
+
+/* ask the OS to probe an idle link so a dead peer turns into a read error */
+static void network_keepalive(int fd)
+{
+    int on = 1;
+    int val;
+
+    setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, (char *)&on, sizeof(on));
+
+#if defined(TCP_KEEPIDLE)
+    val = NETWORK_KEEPIDLE;
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPIDLE, (char *)&val, sizeof(val));
+#elif defined(TCP_KEEPALIVE)
+    val = NETWORK_KEEPIDLE;
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPALIVE, (char *)&val, sizeof(val));
+#endif
+#if defined(TCP_KEEPINTVL)
+    val = NETWORK_KEEPINTVL;
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPINTVL, (char *)&val, sizeof(val));
+#endif
+#if defined(TCP_KEEPCNT)
+    val = NETWORK_KEEPCNT;
+    setsockopt(fd, IPPROTO_TCP, TCP_KEEPCNT, (char *)&val, sizeof(val));
+#endif
+    (void)val;
+}
+
 static void handle_error(enum rig_debug_level_e lvl, const char *msg)
 {
     int e;
@@ -309,7 +519,9 @@ int network_open(hamlib_port_t *rp, int default_port)
             return (-RIG_EIO);
         }
 
-        if (connect(fd, res->ai_addr, res->ai_addrlen) == 0)
+        if (network_connect(fd, res->ai_addr, res->ai_addrlen,
+                            rp->timeout > 0 && rp->timeout < NETWORK_CONNECT_TIMEOUT ?
+                            rp->timeout : NETWORK_CONNECT_TIMEOUT) == 0)
         {
             break;
         }
@@ -339,6 +551,23 @@ int network_open(hamlib_port_t *rp, int default_port)
 
     rp->fd = fd;
 
+    if (hints.ai_socktype == SOCK_STREAM)
+    {
+        struct network_conn *c;
+
+        network_keepalive(fd);
+
+        CONN_LOCK();
+        c = network_conn_find(rp, 1);
+
+        if (c)
+        {
+            c->default_port = default_port;
+        }
+
+        CONN_UNLOCK();
+    }
+
     socklen_t clientLen = sizeof(client);
     getsockname(rp->fd, (struct sockaddr *)&client, &clientLen);
     rig_debug(RIG_DEBUG_TRACE, "%s: client port=%d\n", __func__, client.sin_port);
@@ -365,6 +594,14 @@ void network_flush(hamlib_port_t *rp)
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
+    port_rxbuf_discard(rp);
+
+    // the async reader owns the socket, only its queued replies can go
+    if (rp->asyncio && port_sync_discard(rp) >= 0)
+    {
+        return;
+    }
+
     for (;;)
     {
         int ret;
@@ -416,6 +653,8 @@ int network_close(hamlib_port_t *rp)
 {
     int ret = 0;
 
+    network_release(rp);
+
     if (rp->fd > 0)
     {
 #ifdef __MINGW32__
@@ -441,244 +680,698 @@ int network_close(hamlib_port_t *rp)
 }
 //! @endcond
 
-extern void sync_callback(int lock);
-
-#ifdef HAVE_PTHREAD
-//! @cond Doxygen_Suppress
-
-#define MULTICAST_DATA_PIPE_TIMEOUT_MILLIS 1000
-
-#if defined(WIN32) && defined(HAVE_WINDOWS_H)
-
-static int multicast_publisher_create_data_pipe(multicast_publisher_priv_data
-        *mcast_publisher_priv)
+/*
+ * Close and open rp again, then let the backend restore its session.
+ * Not network_close(), which would tear down Winsock for every port.
+ */
+static int network_reopen(struct network_conn *c, hamlib_port_t *rp,
+                          int default_port)
 {
-    int status;
-
-    status = async_pipe_create(&mcast_publisher_priv->args.data_pipe,
-                               PIPE_BUFFER_SIZE_DEFAULT, MULTICAST_DATA_PIPE_TIMEOUT_MILLIS);
+    int ret;
 
-    if (status != 0)
+    if (rp->fd > 0)
     {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: multicast publisher data pipe creation failed with status=%d, err=%s\n",
-                  __func__,
-                  status, strerror(errno));
-        return (-RIG_EINTERNAL);
+#ifdef __MINGW32__
+        closesocket(rp->fd);
+#else
+        close(rp->fd);
+#endif
     }
 
-    return (RIG_OK);
-}
+    /* not 0, a stray write must not land on stdin */
+    rp->fd = -1;
+    port_rxbuf_discard(rp);
 
-static void multicast_publisher_close_data_pipe(multicast_publisher_priv_data
-        *mcast_publisher_priv)
-{
-    if (mcast_publisher_priv->args.data_pipe != NULL)
+    ret = network_open(rp, default_port);
+
+    if (ret == RIG_OK && c->resume)
     {
-        async_pipe_close(mcast_publisher_priv->args.data_pipe);
-        mcast_publisher_priv->args.data_pipe = NULL;
+        ret = c->resume(rp, c->resume_arg);
+
+        if (ret != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: %s reconnected but resume failed: %s\n",
+                      __func__, rp->pathname, rigerror(ret));
+        }
     }
+
+    return ret == RIG_OK ? RIG_OK : -RIG_EIO;
 }
 
-static int multicast_publisher_write_data(multicast_publisher_args
-        *mcast_publisher_args, size_t length, const unsigned char *data)
+/* one reconnect attempt if the backoff allows it, lock held */
+static void network_conn_attempt(struct network_conn *c)
 {
-    ssize_t result;
+    hamlib_port_t *rp = c->rp;
+    int ret;
 
-    result = async_pipe_write(mcast_publisher_args->data_pipe, data, length,
-                              MULTICAST_DATA_PIPE_TIMEOUT_MILLIS);
+    elapsed_ms(&c->last_attempt, HAMLIB_ELAPSED_SET);
 
-    if (result < 0)
+    CONN_UNLOCK();
+    ret = network_reopen(c, rp, c->default_port);
+    CONN_LOCK();
+
+    if (c->rp != rp)
     {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: error writing to multicast publisher data pipe, result=%d\n", __func__,
-                  (int)result);
-        return (-RIG_EIO);
+        return;
     }
 
-    if (result != length)
+    if (ret == RIG_OK)
     {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: could not write to multicast publisher data pipe, expected %d bytes, wrote %d bytes\n",
-                  __func__, (int)length, (int)result);
-        return (-RIG_EIO);
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: reconnected to %s\n", __func__,
+                  rp->pathname);
+        c->down = 0;
+        c->backoff = 0;
+        c->generation++;
     }
-
-    return (RIG_OK);
-}
-
-static int multicast_publisher_read_data(multicast_publisher_args
-        *mcast_publisher_args, size_t length, unsigned char *data)
-{
-    ssize_t result;
-
-    result = async_pipe_wait_for_data(mcast_publisher_args->data_pipe,
-                                      MULTICAST_DATA_PIPE_TIMEOUT_MILLIS);
-
-    if (result < 0)
+    else
     {
-        // Timeout is expected when there is no data
-        if (result != -RIG_ETIMEOUT)
+        c->backoff = c->backoff ? c->backoff * 2 : NETWORK_BACKOFF_MIN;
+
+        if (c->backoff > NETWORK_BACKOFF_MAX)
         {
-            rig_debug(RIG_DEBUG_ERR,
-                      "%s: error waiting for multicast publisher data, result=%ld\n", __func__,
-                      (long) result);
+            c->backoff = NETWORK_BACKOFF_MAX;
         }
 
-        return (result);
+        rig_debug(RIG_DEBUG_WARN, "%s: reconnect to %s failed, next try in %d ms\n",
+                  __func__, rp->pathname, c->backoff);
     }
 
-    result = async_pipe_read(mcast_publisher_args->data_pipe, data, length,
-                             MULTICAST_DATA_PIPE_TIMEOUT_MILLIS);
-
-    if (result < 0)
-    {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: error reading multicast publisher data, result=%ld\n", __func__,
-                  (long) result);
-        return (-RIG_EIO);
-    }
+    CONN_BROADCAST();
+}
 
-    if (result != length)
-    {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: could not read from multicast publisher data pipe, expected %ld bytes, read %ld bytes\n",
-                  __func__, (long) length, (long) result);
-        return (-RIG_EIO);
-    }
+/* ms until the next reconnect attempt of c is due, lock held */
+static int network_conn_due(struct network_conn *c)
+{
+    int due = c->backoff - (int)elapsed_ms(&c->last_attempt, HAMLIB_ELAPSED_GET);
 
-    return (RIG_OK);
+    return due > 0 ? due : 0;
 }
 
-#else
-
-static int multicast_publisher_create_data_pipe(multicast_publisher_priv_data
-        *mcast_publisher_priv)
+/*
+ * True if the peer has closed rp, seen as end of file waiting to be read.
+ * Lets a link that died while idle be reopened before a request is sent,
+ * so even requests that must not be replayed go out on the new connection.
+ */
+static int network_peer_closed(hamlib_port_t *rp)
 {
-    int data_pipe_fds[2];
-    int status;
+    fd_set rfds;
+    struct timeval tv = { 0, 0 };
+    char c;
 
-    status = pipe(data_pipe_fds);
-
-    if (status != 0)
+    if (rp->fd <= 0)
     {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: multicast publisher data pipe creation failed with status=%d, err=%s\n",
-                  __func__,
-                  status, strerror(errno));
-        return (-RIG_EINTERNAL);
+        return 0;
     }
 
-    int flags = fcntl(data_pipe_fds[0], F_GETFD);
-    flags |= O_NONBLOCK;
+    FD_ZERO(&rfds);
+    FD_SET(rp->fd, &rfds);
 
-    if (fcntl(data_pipe_fds[0], F_SETFD, flags))
+    if (select(rp->fd + 1, &rfds, NULL, NULL, &tv) != 1)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: error setting O_NONBLOCK on pipe=%s\n", __func__,
-                  strerror(errno));
+        return 0;
     }
 
-    mcast_publisher_priv->args.data_read_fd = data_pipe_fds[0];
-    mcast_publisher_priv->args.data_write_fd = data_pipe_fds[1];
-
-    return (RIG_OK);
+    return recv(rp->fd, &c, 1, MSG_PEEK) == 0;
 }
 
-static void multicast_publisher_close_data_pipe(multicast_publisher_priv_data
-        *mcast_publisher_priv)
+#ifdef HAVE_PTHREAD
+static void network_deadline(struct timespec *ts, int ms)
 {
-    if (mcast_publisher_priv->args.data_read_fd != -1)
-    {
-        close(mcast_publisher_priv->args.data_read_fd);
-        mcast_publisher_priv->args.data_read_fd = -1;
-    }
+    struct timeval now;
 
-    if (mcast_publisher_priv->args.data_write_fd != -1)
+    gettimeofday(&now, NULL);
+    ts->tv_sec = now.tv_sec + ms / 1000;
+    ts->tv_nsec = now.tv_usec * 1000L + (ms % 1000) * 1000000L;
+
+    if (ts->tv_nsec >= 1000000000L)
     {
-        close(mcast_publisher_priv->args.data_write_fd);
-        mcast_publisher_priv->args.data_write_fd = -1;
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
     }
 }
 
-static int multicast_publisher_write_data(multicast_publisher_args
-        *mcast_publisher_args, size_t length, const unsigned char *data)
+static void *network_reconnect_thread(void *arg)
 {
-    int fd = mcast_publisher_args->data_write_fd;
-    ssize_t result;
+    struct network_conn *c = arg;
 
-    result = write(fd, data, length);
+    CONN_LOCK();
 
-    if (result < 0)
+    while (!c->stop && c->down)
     {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: error writing to multicast publisher data pipe, result=%d, err=%s\n",
-                  __func__,
-                  (int)result, strerror(errno));
-        return (-RIG_EIO);
-    }
+        int due = network_conn_due(c);
 
-    if (result != length)
-    {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: could not write to multicast publisher data pipe, expected %ld bytes, wrote %ld bytes\n",
-                  __func__, (long) length, (long) result);
-        return (-RIG_EIO);
+        if (due > 0)
+        {
+            struct timespec deadline;
+
+            network_deadline(&deadline, due);
+            pthread_cond_timedwait(&network_conn_cond, &network_conn_mutex, &deadline);
+            continue;
+        }
+
+        network_conn_attempt(c);
     }
 
-    return (RIG_OK);
+    c->thread_running = 0;
+    CONN_BROADCAST();
+    CONN_UNLOCK();
+
+    return NULL;
 }
+#endif
 
-static int multicast_publisher_read_data(multicast_publisher_args
-        *mcast_publisher_args, size_t length, unsigned char *data)
+/**
+ * \brief Report that the connection of rp is gone
+ *
+ * Starts reconnecting in the background.  Until it succeeds requests
+ * through network_request_begin() fail fast or wait for it.
+ *
+ * \param rp Port data structure
+ */
+void network_link_down(hamlib_port_t *rp)
 {
-    int fd = mcast_publisher_args->data_read_fd;
-    fd_set rfds, efds;
-    struct timeval timeout;
-    ssize_t result;
-    int retval;
-
-    timeout.tv_sec = MULTICAST_DATA_PIPE_TIMEOUT_MILLIS / 1000;
-    timeout.tv_usec = 0;
-
-    FD_ZERO(&rfds);
-    FD_SET(fd, &rfds);
-    efds = rfds;
+    struct network_conn *c;
 
-    retval = select(fd + 1, &rfds, NULL, &efds, &timeout);
+    CONN_LOCK();
+    c = network_conn_find(rp, 0);
 
-    if (retval == 0)
+    if (!c)
     {
-        return (-RIG_ETIMEOUT);
+        CONN_UNLOCK();
+        return;
     }
 
-    if (retval < 0)
+    if (!c->down)
     {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s(): select() failed when reading multicast publisher data: %s\n",
-                  __func__,
-                  strerror(errno));
-
-        return -RIG_EIO;
+        rig_debug(RIG_DEBUG_WARN, "%s: lost connection to %s\n", __func__,
+                  rp->pathname);
+        c->down = 1;
+        c->backoff = 0;
     }
 
-    if (FD_ISSET(fd, &efds))
+#ifdef HAVE_PTHREAD
+
+    if (!c->thread_running && !c->stop)
     {
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s(): fd error when reading multicast publisher data\n", __func__);
-        return -RIG_EIO;
-    }
+        pthread_t thread;
+        pthread_attr_t attr;
 
-    result = read(fd, data, length);
+        pthread_attr_init(&attr);
+        pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+        c->thread_running = pthread_create(&thread, &attr,
+                                           network_reconnect_thread, c) == 0;
+        pthread_attr_destroy(&attr);
 
-    if (result < 0)
+        if (!c->thread_running)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: no reconnect thread: %s\n", __func__,
+                      strerror(errno));
+        }
+    }
+
+#endif
+    CONN_BROADCAST();
+    CONN_UNLOCK();
+}
+
+/**
+ * \brief Check the connection of rp before a request
+ *
+ * Returns at once while the link is up, noticing a peer that closed it
+ * while idle.  While it is down, waits up to NETWORK_RECOVER_WAIT ms for
+ * a reconnect due by then, and otherwise fails without blocking.  Ports
+ * not opened by network_open() always pass.
+ *
+ * \param rp Port data structure
+ * \return RIG_OK when the request can go ahead, -RIG_EIO if not
+ */
+int network_request_begin(hamlib_port_t *rp)
+{
+    struct network_conn *c;
+    int ret = RIG_OK;
+
+    CONN_LOCK();
+    c = network_conn_find(rp, 0);
+
+    if (c && !c->down && network_peer_closed(rp))
+    {
+        CONN_UNLOCK();
+        network_link_down(rp);
+        CONN_LOCK();
+        c = network_conn_find(rp, 0);
+    }
+
+    if (c && c->down)
+    {
+        int due = network_conn_due(c);
+
+        if (due > NETWORK_RECOVER_WAIT)
+        {
+            ret = -RIG_EIO;
+        }
+        else if (!c->thread_running)
+        {
+            /* no background thread: try inline, honouring the backoff */
+            if (due == 0)
+            {
+                network_conn_attempt(c);
+            }
+
+            ret = c->rp == rp && !c->down ? RIG_OK : -RIG_EIO;
+        }
+
+#ifdef HAVE_PTHREAD
+        else
+        {
+            struct timespec deadline;
+
+            network_deadline(&deadline, NETWORK_RECOVER_WAIT);
+
+            while (c->rp == rp && c->down && !c->stop)
+            {
+                if (pthread_cond_timedwait(&network_conn_cond, &network_conn_mutex,
+                                           &deadline) != 0)
+                {
+                    break;
+                }
+            }
+
+            ret = c->rp == rp && !c->down ? RIG_OK : -RIG_EIO;
+        }
+
+#endif
+
+        if (ret != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: %s is down\n", __func__, rp->pathname);
+        }
+    }
+
+    CONN_UNLOCK();
+
+    return ret;
+}
+
+/**
+ * \brief Count of reconnects of rp, so a backend can tell its session is new
+ * \param rp Port data structure
+ */
+int network_generation(hamlib_port_t *rp)
+{
+    struct network_conn *c;
+    int generation = 0;
+
+    CONN_LOCK();
+    c = network_conn_find(rp, 0);
+
+    if (c)
+    {
+        generation = c->generation;
+    }
+
+    CONN_UNLOCK();
+
+    return generation;
+}
+
+/**
+ * \brief Set what to send on a new connection before requests resume
+ *
+ * resume runs on the reconnect thread with the link still marked down,
+ * so it must talk to rp with write_block()/read_string() directly.
+ *
+ * \param rp Port data structure
+ * \param resume callback, NULL for none
+ * \param arg passed to resume
+ */
+void network_set_resume(hamlib_port_t *rp,
+                        int (*resume)(hamlib_port_t *rp, void *arg), void *arg)
+{
+    struct network_conn *c;
+
+    CONN_LOCK();
+    c = network_conn_find(rp, 0);
+
+    if (c)
+    {
+        c->resume = resume;
+        c->resume_arg = arg;
+    }
+
+    CONN_UNLOCK();
+}
+
+/**
+ * \brief Set who gets the lines the peer sends without being asked
+ *
+ * rigctld sends \subscribe events as lines starting with '!' between
+ * replies.  With a handler set, network_transaction() gives such lines to
+ * it, both those waiting when a request goes out (which the flush would
+ * otherwise drop) and those read where a reply was expected.
+ *
+ * \param rp Port data structure
+ * \param push callback, NULL for none
+ * \param arg passed to push
+ */
+void network_set_push(hamlib_port_t *rp, network_push_t push, void *arg)
+{
+    struct network_conn *c;
+
+    CONN_LOCK();
+    c = network_conn_find(rp, 0);
+
+    if (c)
+    {
+        c->push = push;
+        c->push_arg = arg;
+    }
+
+    CONN_UNLOCK();
+}
+
+/* push handler of rp, NULL if none */
+static network_push_t network_push_get(hamlib_port_t *rp, void **arg)
+{
+    network_push_t push = NULL;
+    struct network_conn *c;
+
+    CONN_LOCK();
+    c = network_conn_find(rp, 0);
+
+    if (c && !c->down)
+    {
+        push = c->push;
+        *arg = c->push_arg;
+    }
+
+    CONN_UNLOCK();
+
+    return push;
+}
+
+/* true if a read on rp would not block */
+static int network_readable(hamlib_port_t *rp)
+{
+    fd_set rfds;
+    struct timeval tv = { 0, 0 };
+
+    if (port_rxbuf_pending(rp) > 0)
+    {
+        return 1;
+    }
+
+    if (rp->fd <= 0)
+    {
+        return 0;
+    }
+
+    FD_ZERO(&rfds);
+    FD_SET(rp->fd, &rfds);
+
+    return select(rp->fd + 1, &rfds, NULL, NULL, &tv) == 1;
+}
+
+/* hands the lines already received to push, dropping anything else */
+static void network_push_drain(hamlib_port_t *rp, network_push_t push,
+                               void *arg)
+{
+    char line[256];
+    int ret;
+
+    while (network_readable(rp))
+    {
+        ret = read_string(rp, (unsigned char *) line, sizeof(line), "\n", 1, 0, 1);
+
+        if (ret <= 0)
+        {
+            break;
+        }
+
+        if (line[0] == '!')
+        {
+            push(rp, line, arg);
+        }
+        else
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: dropping stray '%.*s'\n", __func__,
+                      (int) strcspn(line, "\n"), line);
+        }
+    }
+}
+
+/**
+ * \brief Give the push handler the lines received so far
+ *
+ * For a backend about to answer from what pushes told it: nothing is
+ * sent and nothing waited for.
+ *
+ * \param rp Port data structure
+ */
+void network_push_poll(hamlib_port_t *rp)
+{
+    network_push_t push;
+    void *arg = NULL;
+
+    push = network_push_get(rp, &arg);
+
+    if (push)
+    {
+        network_push_drain(rp, push, arg);
+    }
+}
+
+/**
+ * \brief Forget the connection state of rp, stopping its reconnects
+ *
+ * Done by network_close(); a backend closing a socket itself calls it
+ * before rp goes away.
+ *
+ * \param rp Port data structure
+ */
+void network_release(hamlib_port_t *rp)
+{
+    struct network_conn *c;
+
+    CONN_LOCK();
+    c = network_conn_find(rp, 0);
+
+    if (c)
+    {
+        c->stop = 1;
+        CONN_BROADCAST();
+#ifdef HAVE_PTHREAD
+
+        while (c->thread_running)
+        {
+            pthread_cond_wait(&network_conn_cond, &network_conn_mutex);
+        }
+
+#endif
+        memset(c, 0, sizeof(*c));
+    }
+
+    CONN_UNLOCK();
+}
+
+/**
+ * \brief Send a request and read one reply, surviving a dropped link
+ *
+ * Flushes, writes cmd and reads up to a byte in stopset.  An I/O error
+ * marks the link down; a request safe to repeat is then sent once more
+ * if the connection comes back within NETWORK_RECOVER_WAIT ms.
+ *
+ * \param rp Port data structure
+ * \param cmd request
+ * \param cmd_len length of cmd
+ * \param buf reply buffer
+ * \param buf_len size of buf
+ * \param stopset reply terminators
+ * \param replay non-zero if cmd may be sent twice
+ * \return length of the reply, or < 0 on error
+ */
+int network_transaction(hamlib_port_t *rp, const char *cmd, int cmd_len,
+                        char *buf, int buf_len, const char *stopset, int replay)
+{
+    int attempt;
+    int ret = -RIG_EIO;
+    network_push_t push;
+    void *push_arg = NULL;
+
+    for (attempt = 0; attempt < 2; attempt++)
+    {
+        ret = network_request_begin(rp);
+
+        if (ret != RIG_OK)
+        {
+            return ret;
+        }
+
+        push = network_push_get(rp, &push_arg);
+
+        if (push)
+        {
+            network_push_drain(rp, push, push_arg);
+        }
+
+        rig_flush(rp);
+
+        ret = write_block(rp, (const unsigned char *) cmd, cmd_len);
+
+        if (ret == RIG_OK)
+        {
+            ret = read_string(rp, (unsigned char *) buf, buf_len, stopset,
+                              strlen(stopset), 0, 1);
+
+            while (push && ret > 0 && buf[0] == '!')
+            {
+                push(rp, buf, push_arg);
+                ret = read_string(rp, (unsigned char *) buf, buf_len, stopset,
+                                  strlen(stopset), 0, 1);
+            }
+        }
+
+        if (ret != -RIG_EIO)
+        {
+            break;
+        }
+
+        network_link_down(rp);
+
+        if (!replay)
+        {
+            break;
+        }
+
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: replaying %.*s", __func__, cmd_len, cmd);
+    }
+
+    return ret;
+}
+
+/**
+ * \brief Tell whether a rigctld/rotctld/ampctld request only reads state
+ *
+ * Such requests may be replayed after a reconnect.
+ *
+ * \param cmd request as sent, with or without an extended response prefix
+ */
+int network_rigctl_getter(const char *cmd)
+{
+    /* get_* and the pure conversions of the three protocols */
+    static const char getters[] = "fmixksnlupacrodvtejzy";
+
+    while (*cmd == '+' || *cmd == ';' || *cmd == '|' || *cmd == ',')
+    {
+        cmd++;
+    }
+
+    if (*cmd == '\\')
+    {
+        cmd++;
+        return strncmp(cmd, "get_", 4) == 0 || strncmp(cmd, "dump_", 5) == 0
+               || strncmp(cmd, "chk_vfo", 7) == 0;
+    }
+
+    return cmd[0] != '\0' && strchr(getters, cmd[0]) != NULL
+           && (cmd[1] == '\0' || cmd[1] == ' ' || cmd[1] == '\n');
+}
+
+extern void sync_callback(int lock);
+
+#ifdef HAVE_PTHREAD
+//! @cond Doxygen_Suppress
+
+#define MULTICAST_DATA_PIPE_TIMEOUT_MILLIS 1000
+#define MULTICAST_DATA_RING_SIZE 65536
+
+#if defined(WIN32) && defined(HAVE_WINDOWS_H)
+
+static int multicast_publisher_create_data_pipe(multicast_publisher_priv_data
+        *mcast_publisher_priv)
+{
+    int status;
+
+    status = async_pipe_create(&mcast_publisher_priv->args.data_pipe,
+                               PIPE_BUFFER_SIZE_DEFAULT, MULTICAST_DATA_PIPE_TIMEOUT_MILLIS);
+
+    if (status != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR,
+                  "%s: multicast publisher data pipe creation failed with status=%d, err=%s\n",
+                  __func__,
+                  status, strerror(errno));
+        return (-RIG_EINTERNAL);
+    }
+
+    return (RIG_OK);
+}
+
+static void multicast_publisher_close_data_pipe(multicast_publisher_priv_data
+        *mcast_publisher_priv)
+{
+    if (mcast_publisher_priv->args.data_pipe != NULL)
+    {
+        async_pipe_close(mcast_publisher_priv->args.data_pipe);
+        mcast_publisher_priv->args.data_pipe = NULL;
+    }
+}
+
+static int multicast_publisher_write_data(multicast_publisher_args
+        *mcast_publisher_args, size_t length, const unsigned char *data)
+{
+    ssize_t result;
+
+    result = async_pipe_write(mcast_publisher_args->data_pipe, data, length,
+                              MULTICAST_DATA_PIPE_TIMEOUT_MILLIS);
+
+    if (result < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR,
+                  "%s: error writing to multicast publisher data pipe, result=%d\n", __func__,
+                  (int)result);
+        return (-RIG_EIO);
+    }
+
+    if (result != length)
+    {
+        rig_debug(RIG_DEBUG_ERR,
+                  "%s: could not write to multicast publisher data pipe, expected %d bytes, wrote %d bytes\n",
+                  __func__, (int)length, (int)result);
+        return (-RIG_EIO);
+    }
+
+    return (RIG_OK);
+}
+
+static int multicast_publisher_read_data(multicast_publisher_args
+        *mcast_publisher_args, size_t length, unsigned char *data, int timeout_ms)
+{
+    ssize_t result;
+
+    result = async_pipe_wait_for_data(mcast_publisher_args->data_pipe,
+                                      timeout_ms);
+
+    if (result < 0)
     {
-        if (errno == EAGAIN)
+        // Timeout is expected when there is no data
+        if (result != -RIG_ETIMEOUT)
         {
-            return (-RIG_ETIMEOUT);
+            rig_debug(RIG_DEBUG_ERR,
+                      "%s: error waiting for multicast publisher data, result=%ld\n", __func__,
+                      (long) result);
         }
 
-        rig_debug(RIG_DEBUG_ERR, "%s: error reading multicast publisher data: %s\n",
-                  __func__, strerror(errno));
+        return (result);
+    }
+
+    result = async_pipe_read(mcast_publisher_args->data_pipe, data, length,
+                             MULTICAST_DATA_PIPE_TIMEOUT_MILLIS);
+
+    if (result < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR,
+                  "%s: error reading multicast publisher data, result=%ld\n", __func__,
+                  (long) result);
         return (-RIG_EIO);
     }
 
@@ -693,6 +1386,89 @@ static int multicast_publisher_read_data(multicast_publisher_args
     return (RIG_OK);
 }
 
+#else
+
+/*
+ * Packets reach the publisher thread through an SPSC ring, spscring.c,
+ * instead of a pipe: nothing selects on it, and the ring moves a packet
+ * with no syscall unless the publisher is asleep.  Several threads
+ * publish, so writers take data_write_lock between themselves; the
+ * publisher reads without it.  Every packet is one write, so the reader
+ * never sees half of one.
+ */
+static int multicast_publisher_create_data_pipe(multicast_publisher_priv_data
+        *mcast_publisher_priv)
+{
+    mcast_publisher_priv->args.data_ring =
+        spsc_ring_new(MULTICAST_DATA_RING_SIZE);
+
+    if (mcast_publisher_priv->args.data_ring == NULL)
+    {
+        rig_debug(RIG_DEBUG_ERR,
+                  "%s: multicast publisher data ring creation failed\n", __func__);
+        return (-RIG_EINTERNAL);
+    }
+
+    pthread_mutex_init(&mcast_publisher_priv->args.data_write_lock, NULL);
+
+    return (RIG_OK);
+}
+
+static void multicast_publisher_close_data_pipe(multicast_publisher_priv_data
+        *mcast_publisher_priv)
+{
+    if (mcast_publisher_priv->args.data_ring != NULL)
+    {
+        spsc_ring_free(mcast_publisher_priv->args.data_ring);
+        mcast_publisher_priv->args.data_ring = NULL;
+        pthread_mutex_destroy(&mcast_publisher_priv->args.data_write_lock);
+    }
+}
+
+static int multicast_publisher_write_data(multicast_publisher_args
+        *mcast_publisher_args, size_t length, const unsigned char *data)
+{
+    int result;
+
+    pthread_mutex_lock(&mcast_publisher_args->data_write_lock);
+    result = spsc_ring_write(mcast_publisher_args->data_ring, data, length);
+    pthread_mutex_unlock(&mcast_publisher_args->data_write_lock);
+
+    if (result != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR,
+                  "%s: multicast publisher data ring full, dropping %ld bytes\n",
+                  __func__, (long) length);
+        return (-RIG_EIO);
+    }
+
+    return (RIG_OK);
+}
+
+static int multicast_publisher_read_data(multicast_publisher_args
+        *mcast_publisher_args, size_t length, unsigned char *data, int timeout_ms)
+{
+    struct spsc_ring *ring = mcast_publisher_args->data_ring;
+    size_t result;
+
+    if (spsc_ring_wait(ring, timeout_ms) != RIG_OK)
+    {
+        return (-RIG_ETIMEOUT);
+    }
+
+    result = spsc_ring_read(ring, data, length);
+
+    if (result != length)
+    {
+        rig_debug(RIG_DEBUG_ERR,
+                  "%s: could not read from multicast publisher data ring, expected %ld bytes, read %ld bytes\n",
+                  __func__, (long) length, (long) result);
+        return (-RIG_EIO);
+    }
+
+    return (RIG_OK);
+}
+
 #endif
 
 static int multicast_publisher_write_packet_header(RIG *rig,
@@ -763,18 +1539,26 @@ int network_publish_rig_transceive_data(RIG *rig)
     return multicast_publisher_write_packet_header(rig, &packet);
 }
 
+/*
+ * Spectrum lines go to the publisher thread by reference: the pipe carries
+ * a pointer to a spectrum_pool_line the publisher releases when done.  A
+ * backend that assembled the line in a pool buffer costs no copy at all,
+ * any other line is copied into the pool once.
+ */
 int network_publish_rig_spectrum_data(RIG *rig, struct rig_spectrum_line *line)
 {
     int result;
     struct rig_state *rs = &rig->state;
     multicast_publisher_priv_data *mcast_publisher_priv;
     multicast_publisher_args *mcast_publisher_args;
+    struct spectrum_pool_line *pl;
     multicast_publisher_data_packet packet =
     {
         .type = MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM,
         .padding = 0,
-        .data_length = sizeof(struct rig_spectrum_line) + line->spectrum_data_length,
+        .data_length = sizeof(pl),
     };
+    unsigned char msg[sizeof(packet) + sizeof(pl)];
 
     if (rs->multicast_publisher_priv_data == NULL)
     {
@@ -782,30 +1566,50 @@ int network_publish_rig_spectrum_data(RIG *rig, struct rig_spectrum_line *line)
         return RIG_OK;
     }
 
-    result = multicast_publisher_write_packet_header(rig, &packet);
+    pl = spectrum_pool_from_line(line);
 
-    if (result != RIG_OK)
+    if (pl)
     {
-        RETURNFUNC2(result);
+        spectrum_pool_ref(pl);
+    }
+    else
+    {
+        if (line->spectrum_data_length > HAMLIB_MAX_SPECTRUM_DATA)
+        {
+            RETURNFUNC2(-RIG_EINVAL);
+        }
+
+        pl = spectrum_pool_get();
+
+        if (!pl)
+        {
+            // publisher is behind, drop this line
+            RETURNFUNC2(-RIG_ENOMEM);
+        }
+
+        pl->line = *line;
+        pl->line.spectrum_data = pl->data;
+        memcpy(pl->data, line->spectrum_data, line->spectrum_data_length);
     }
 
     mcast_publisher_priv = (multicast_publisher_priv_data *)
                            rs->multicast_publisher_priv_data;
     mcast_publisher_args = &mcast_publisher_priv->args;
 
-    result = multicast_publisher_write_data(
-                 mcast_publisher_args, sizeof(struct rig_spectrum_line), (unsigned char *) line);
+    // header and pointer in one write so other publishers cannot interleave
+    memcpy(msg, &packet, sizeof(packet));
+    memcpy(msg + sizeof(packet), &pl, sizeof(pl));
 
-    if (result != RIG_OK)
-    {
-        RETURNFUNC2(result);
-    }
+    __atomic_add_fetch(&mcast_publisher_args->spectrum_inflight, 1,
+                       __ATOMIC_RELAXED);
 
-    result = multicast_publisher_write_data(
-                 mcast_publisher_args, line->spectrum_data_length, line->spectrum_data);
+    result = multicast_publisher_write_data(mcast_publisher_args, sizeof(msg), msg);
 
     if (result != RIG_OK)
     {
+        __atomic_sub_fetch(&mcast_publisher_args->spectrum_inflight, 1,
+                           __ATOMIC_RELAXED);
+        spectrum_pool_put(pl);
         RETURNFUNC2(result);
     }
 
@@ -813,15 +1617,16 @@ int network_publish_rig_spectrum_data(RIG *rig, struct rig_spectrum_line *line)
 }
 
 static int multicast_publisher_read_packet(multicast_publisher_args
-        *mcast_publisher_args,
-        uint8_t *type, struct rig_spectrum_line *spectrum_line,
-        unsigned char *spectrum_data)
+        *mcast_publisher_args, int timeout_ms,
+        uint8_t *type, struct spectrum_pool_line **spectrum_line)
 {
     int result;
     multicast_publisher_data_packet packet;
 
+    *spectrum_line = NULL;
+
     result = multicast_publisher_read_data(mcast_publisher_args, sizeof(packet),
-                                           (unsigned char *) &packet);
+                                           (unsigned char *) &packet, timeout_ms);
 
     if (result < 0)
     {
@@ -835,69 +1640,135 @@ static int multicast_publisher_read_packet(multicast_publisher_args
         break;
 
     case MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM:
-        result = multicast_publisher_read_data(
-                     mcast_publisher_args, sizeof(struct rig_spectrum_line),
-                     (unsigned char *) spectrum_line);
+        if (packet.data_length != sizeof(*spectrum_line))
+        {
+            rig_debug(RIG_DEBUG_ERR,
+                      "%s: multicast publisher data error, expected %d bytes of spectrum reference, got %d bytes\n",
+                      __func__, (int)sizeof(*spectrum_line), (int)packet.data_length);
+            return (-RIG_EPROTO);
+        }
+
+        result = multicast_publisher_read_data(mcast_publisher_args,
+                                               sizeof(*spectrum_line), (unsigned char *) spectrum_line,
+                                               MULTICAST_DATA_PIPE_TIMEOUT_MILLIS);
 
         if (result < 0)
         {
+            *spectrum_line = NULL;
             return (result);
         }
 
-        if (packet.data_length - sizeof(struct rig_spectrum_line) !=
-                spectrum_line->spectrum_data_length)
-        {
-            rig_debug(RIG_DEBUG_ERR,
-                      "%s: multicast publisher data error, expected %d bytes of spectrum data, got %d bytes\n",
-                      __func__, (int)spectrum_line->spectrum_data_length,
-                      (int)(packet.data_length - sizeof(struct rig_spectrum_line)));
-            return (-RIG_EPROTO);
-        }
+        __atomic_sub_fetch(&mcast_publisher_args->spectrum_inflight, 1,
+                           __ATOMIC_RELAXED);
+        break;
 
-        spectrum_line->spectrum_data = spectrum_data;
+    default:
+        rig_debug(RIG_DEBUG_ERR,
+                  "%s: unexpected multicast publisher data packet type: %d\n", __func__,
+                  packet.type);
+        return (-RIG_EPROTO);
+    }
 
-        result = multicast_publisher_read_data(mcast_publisher_args,
-                                               spectrum_line->spectrum_data_length, spectrum_data);
+    *type = packet.type;
+
+    return (RIG_OK);
+}
+
+static void multicast_publisher_send(multicast_publisher_args *args,
+                                     struct sockaddr_in *dest_addr, uint8_t packet_type,
+                                     struct rig_spectrum_line *spectrum_line)
+{
+    char snapshot_buffer[HAMLIB_MAX_SNAPSHOT_PACKET_SIZE];
+    RIG *rig = args->rig;
+    struct rig_state *rs = &rig->state;
+    int socket_fd = args->socket_fd;
+    int result;
+    ssize_t send_result;
+
+    if (packet_type == MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM
+            && rs->multicast_spectrum != SNAPSHOT_SPECTRUM_JSON)
+    {
+        size_t length;
+
+        args->spectrum_history.compress =
+            rs->multicast_spectrum == SNAPSHOT_SPECTRUM_COMPRESSED;
+        result = snapshot_serialize_spectrum_binary(sizeof(snapshot_buffer),
+                 (unsigned char *) snapshot_buffer, &length, rig, spectrum_line,
+                 &args->spectrum_history);
+
+        if (result != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: error serializing spectrum line, result=%d\n",
+                      __func__, result);
+        }
+        else if (sendto(socket_fd, snapshot_buffer, length, 0,
+                        (struct sockaddr *) dest_addr, sizeof(*dest_addr)) < 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: error sending UDP packet: %s\n", __func__,
+                      strerror(errno));
+        }
 
-        if (result < 0)
+        if (rs->multicast_spectrum != SNAPSHOT_SPECTRUM_BOTH)
         {
-            return (result);
+            return;
         }
+    }
 
-        break;
+    if (packet_type == MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM)
+    {
+        result = snapshot_serialize(sizeof(snapshot_buffer), snapshot_buffer, rig,
+                                    spectrum_line);
+    }
+    else
+    {
+        result = snapshot_serialize_state(sizeof(snapshot_buffer), snapshot_buffer,
+                                          rig, &args->state_history, rs->multicast_keyframe);
+    }
 
-    default:
-        rig_debug(RIG_DEBUG_ERR,
-                  "%s: unexpected multicast publisher data packet type: %d\n", __func__,
-                  packet.type);
-        return (-RIG_EPROTO);
+    if (result != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: error serializing rig snapshot data, result=%d\n",
+                  __func__, result);
+        return;
     }
 
-    *type = packet.type;
+    rig_debug(RIG_DEBUG_TRACE, "%s: sending rig snapshot data: %s\n", __func__,
+              snapshot_buffer);
 
-    return (RIG_OK);
+    send_result = sendto(
+                      socket_fd,
+                      snapshot_buffer,
+                      strlen(snapshot_buffer),
+                      0,
+                      (struct sockaddr *) dest_addr,
+                      sizeof(*dest_addr)
+                  );
+
+    if (send_result < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: error sending UDP packet: %s\n", __func__,
+                  strerror(errno));
+    }
 }
 
 void *multicast_publisher(void *arg)
 {
-    unsigned char spectrum_data[HAMLIB_MAX_SPECTRUM_DATA];
-    char snapshot_buffer[HAMLIB_MAX_SNAPSHOT_PACKET_SIZE];
-
     struct multicast_publisher_args_s *args = (struct multicast_publisher_args_s *)
             arg;
     RIG *rig = args->rig;
     struct rig_state *rs = &rig->state;
-    struct rig_spectrum_line spectrum_line;
-    uint8_t packet_type;
+    struct spectrum_pool_line *spectrum_line;
+    struct spectrum_pool_line *next_line = NULL;
+    uint8_t packet_type, next_type;
 
     struct sockaddr_in dest_addr;
-    int socket_fd = args->socket_fd;
     int result;
-    ssize_t send_result;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Starting multicast publisher\n", __FILE__,
               __LINE__);
 
+    hl_thread_sched_apply("multicast publisher");
+
     memset(&dest_addr, 0, sizeof(dest_addr));
     dest_addr.sin_family = AF_INET;
     dest_addr.sin_addr.s_addr = inet_addr(args->multicast_addr);
@@ -905,8 +1776,8 @@ void *multicast_publisher(void *arg)
 
     while (rs->multicast_publisher_run)
     {
-        result = multicast_publisher_read_packet(args, &packet_type, &spectrum_line,
-                 spectrum_data);
+        result = multicast_publisher_read_packet(args,
+                 MULTICAST_DATA_PIPE_TIMEOUT_MILLIS, &packet_type, &spectrum_line);
 
         if (result != RIG_OK)
         {
@@ -921,36 +1792,67 @@ void *multicast_publisher(void *arg)
             continue;
         }
 
-        result = snapshot_serialize(sizeof(snapshot_buffer), snapshot_buffer, rig,
-                                    packet_type == MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM ? &spectrum_line :
-                                    NULL);
-
-        if (result != RIG_OK)
+        if (packet_type != MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM
+                && rs->multicast_batch_ms > 0)
         {
-            rig_debug(RIG_DEBUG_ERR, "%s: error serializing rig snapshot data, result=%d\n",
-                      __func__, result);
-            continue;
+            struct timespec batch_start;
+            int batched = 0;
+            int left;
+
+            // the snapshot is taken from the cache when sent, so any further
+            // poll/transceive updates within the window cost nothing extra
+            elapsed_ms(&batch_start, HAMLIB_ELAPSED_SET);
+
+            while ((left = rs->multicast_batch_ms - (int) elapsed_ms(&batch_start,
+                           HAMLIB_ELAPSED_GET)) > 0
+                    && multicast_publisher_read_packet(args, left, &next_type,
+                            &next_line) == RIG_OK)
+            {
+                if (next_type == MULTICAST_PUBLISHER_DATA_PACKET_TYPE_SPECTRUM)
+                {
+                    // keep the order, the state goes out first
+                    break;
+                }
+
+                batched++;
+            }
+
+            if (batched > 0)
+            {
+                rig_debug(RIG_DEBUG_TRACE, "%s: %d state updates batched\n", __func__,
+                          batched + 1);
+            }
         }
 
-        rig_debug(RIG_DEBUG_TRACE, "%s: sending rig snapshot data: %s\n", __func__,
-                  snapshot_buffer);
+        multicast_publisher_send(args, &dest_addr, packet_type,
+                                 spectrum_line ? &spectrum_line->line : NULL);
 
-        send_result = sendto(
-                          socket_fd,
-                          snapshot_buffer,
-                          strlen(snapshot_buffer),
-                          0,
-                          (struct sockaddr *) &dest_addr,
-                          sizeof(dest_addr)
-                      );
+        if (spectrum_line)
+        {
+            spectrum_pool_put(spectrum_line);
+        }
 
-        if (send_result < 0)
+        if (next_line)
         {
-            rig_debug(RIG_DEBUG_ERR, "%s: error sending UDP packet: %s\n", __func__,
-                      strerror(errno));
+            multicast_publisher_send(args, &dest_addr, next_type, &next_line->line);
+            spectrum_pool_put(next_line);
+            next_line = NULL;
+        }
+    }
+
+    // give back the lines still queued in the pipe
+    while (__atomic_load_n(&args->spectrum_inflight, __ATOMIC_RELAXED) > 0
+            && multicast_publisher_read_packet(args,
+                    MULTICAST_DATA_PIPE_TIMEOUT_MILLIS, &packet_type, &spectrum_line) == RIG_OK)
+    {
+        if (spectrum_line)
+        {
+            spectrum_pool_put(spectrum_line);
         }
     }
 
+    snapshot_state_history_free(&args->state_history);
+
     rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Stopping multicast publisher\n", __FILE__,
               __LINE__);
     return NULL;
@@ -1128,5 +2030,382 @@ int network_multicast_publisher_stop(RIG *rig)
 
     RETURNFUNC(RIG_OK);
 }
+
+//! @cond Doxygen_Suppress
+
+static const struct snapshot_vfo_values *multicast_subscriber_vfo(
+    const struct snapshot_mirror *m, vfo_t vfo)
+{
+    int i;
+
+    for (i = 0; i < SNAPSHOT_VFO_COUNT; i++)
+    {
+        if (m->vfo[i].vfo == vfo) { return &m->vfo[i]; }
+    }
+
+    return NULL;
+}
+
+/* the VFO receiving, RIG_VFO_NONE if the packets did not say */
+static vfo_t multicast_subscriber_rx(const struct snapshot_mirror *m)
+{
+    int i;
+
+    for (i = 0; i < SNAPSHOT_VFO_COUNT; i++)
+    {
+        if (m->vfo[i].vfo != RIG_VFO_NONE && m->vfo[i].rx) { return m->vfo[i].vfo; }
+    }
+
+    return RIG_VFO_NONE;
+}
+
+static int multicast_subscriber_ptt(const struct snapshot_mirror *m)
+{
+    int i;
+
+    for (i = 0; i < SNAPSHOT_VFO_COUNT; i++)
+    {
+        if (m->vfo[i].ptt) { return 1; }
+    }
+
+    return 0;
+}
+
+/*
+ * What changed between last and m goes out as events, so the cache
+ * follows and the callbacks an application set fire as with a rig in
+ * transceive mode.
+ */
+static void multicast_subscriber_events(RIG *rig,
+                                        const struct snapshot_mirror *last, const struct snapshot_mirror *m)
+{
+    vfo_t rx_vfo = multicast_subscriber_rx(m);
+    int ptt = multicast_subscriber_ptt(m);
+    int i;
+
+    for (i = 0; i < SNAPSHOT_VFO_COUNT; i++)
+    {
+        const struct snapshot_vfo_values *v = &m->vfo[i];
+        const struct snapshot_vfo_values *was = last->valid ?
+                                                multicast_subscriber_vfo(last, v->vfo) : NULL;
+
+        if (v->vfo == RIG_VFO_NONE || !v->cached)
+        {
+            continue;
+        }
+
+        if (!was || !was->cached || was->freq != v->freq)
+        {
+            rig_fire_freq_event(rig, v->vfo, v->freq);
+        }
+
+        if (!was || !was->cached || was->mode != v->mode || was->width != v->width)
+        {
+            rig_fire_mode_event(rig, v->vfo, v->mode, v->width);
+        }
+    }
+
+    if (rx_vfo != RIG_VFO_NONE && !m->split
+            && (!last->valid || multicast_subscriber_rx(last) != rx_vfo))
+    {
+        rig_fire_vfo_event(rig, rx_vfo);
+    }
+
+    if (!last->valid || multicast_subscriber_ptt(last) != ptt)
+    {
+        rig_fire_ptt_event(rig, RIG_VFO_CURR, ptt ? RIG_PTT_ON : RIG_PTT_OFF);
+    }
+
+    if (!last->valid || last->split != m->split || last->split_vfo != m->split_vfo)
+    {
+        rig_cache_write_begin(rig);
+        rig->state.cache.split = m->split ? RIG_SPLIT_ON : RIG_SPLIT_OFF;
+        rig->state.cache.split_vfo = m->split_vfo;
+        elapsed_ms(&rig->state.cache.time_split, HAMLIB_ELAPSED_SET);
+        rig_cache_write_end(rig);
+    }
+}
+
+static void multicast_subscriber_packet(multicast_subscriber_priv_data *priv,
+                                        const char *packet, size_t length)
+{
+    RIG *rig = priv->rig;
+    struct rig_spectrum_line line;
+    struct snapshot_mirror last, m;
+    int result;
+
+    memset(&line, 0, sizeof(line));
+    line.spectrum_data = priv->spectrum_data;
+
+    if (length >= 4 && memcmp(packet, SNAPSHOT_SPECTRUM_MAGIC, 4) == 0)
+    {
+        result = snapshot_parse_spectrum_binary((const unsigned char *) packet,
+                                                length, &line, &priv->spectrum_history);
+
+        if (result == RIG_OK)
+        {
+            rig_fire_spectrum_event(rig, &line);
+        }
+        else
+        {
+            rig_debug(RIG_DEBUG_TRACE, "%s: spectrum packet dropped: %s\n", __func__,
+                      rigerror(result));
+        }
+
+        return;
+    }
+
+    // only this thread writes the mirror, it can read it unlocked
+    last = priv->mirror;
+    m = last;
+    result = snapshot_parse(packet, length, &m, &line);
+
+    if (result < 0)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: packet dropped: %s\n", __func__,
+                  rigerror(result));
+
+        if (!m.synced && last.synced)
+        {
+            pthread_mutex_lock(&priv->mutex);
+            priv->mirror.synced = 0;
+            pthread_mutex_unlock(&priv->mutex);
+        }
+
+        return;
+    }
+
+    pthread_mutex_lock(&priv->mutex);
+    priv->mirror = m;
+    elapsed_ms(&priv->time, HAMLIB_ELAPSED_SET);
+    pthread_mutex_unlock(&priv->mutex);
+
+    multicast_subscriber_events(rig, &last, &m);
+
+    if (result == SNAPSHOT_PARSED_SPECTRUM)
+    {
+        rig_fire_spectrum_event(rig, &line);
+    }
+}
+
+static void *multicast_subscriber(void *arg)
+{
+    multicast_subscriber_priv_data *priv = arg;
+    char packet[HAMLIB_MAX_SNAPSHOT_PACKET_SIZE];
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Starting multicast subscriber\n",
+              __FILE__, __LINE__);
+
+    hl_thread_sched_apply("multicast subscriber");
+
+    while (priv->run)
+    {
+        struct timeval tv;
+        fd_set rfds;
+        ssize_t n;
+
+        FD_ZERO(&rfds);
+        FD_SET(priv->socket_fd, &rfds);
+        tv.tv_sec = MULTICAST_DATA_PIPE_TIMEOUT_MILLIS / 1000;
+        tv.tv_usec = 0;
+
+        // wakes up now and then to see whether to stop
+        if (select(priv->socket_fd + 1, &rfds, NULL, NULL, &tv) <= 0)
+        {
+            continue;
+        }
+
+        n = recv(priv->socket_fd, packet, sizeof(packet), 0);
+
+        if (n <= 0)
+        {
+            continue;
+        }
+
+        multicast_subscriber_packet(priv, packet, n);
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): Stopping multicast subscriber\n",
+              __FILE__, __LINE__);
+    return NULL;
+}
+
+//! @endcond
+
+/**
+ * \brief Start multicast subscriber
+ *
+ * Join the group a multicast publisher (rigctld -M) sends to and follow
+ * its packets: state changes go to the rig cache and fire the freq, mode,
+ * vfo and ptt events, spectrum lines fire the spectrum event.  Nothing is
+ * sent to the rig.  The state heard last is kept for
+ * network_multicast_subscriber_read().
+ *
+ * \param multicast_addr UDP address of the group, 0.0.0.0 does nothing
+ * \param multicast_port UDP socket port
+ * \return RIG_OK or < 0 if error
+ */
+int network_multicast_subscriber_start(RIG *rig, const char *multicast_addr,
+                                       int multicast_port)
+{
+    struct rig_state *rs = &rig->state;
+    multicast_subscriber_priv_data *priv;
+    struct sockaddr_in addr;
+    struct ip_mreq mreq;
+    int socket_fd;
+    int on = 1;
+    int status;
+
+    ENTERFUNC;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): multicast address=%s, port=%d\n",
+              __FILE__, __LINE__, multicast_addr, multicast_port);
+
+    if (strcmp(multicast_addr, "0.0.0.0") == 0)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s(%d): not starting multicast subscriber\n",
+                  __FILE__, __LINE__);
+        RETURNFUNC(RIG_OK);
+    }
+
+    if (rs->multicast_subscriber_priv_data != NULL)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s(%d): multicast subscriber already running\n",
+                  __FILE__, __LINE__);
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    status = network_init();
+
+    if (status != RIG_OK)
+    {
+        RETURNFUNC(status);
+    }
+
+    socket_fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (socket_fd < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: error opening new UDP socket: %s\n", __func__,
+                  strerror(errno));
+        RETURNFUNC(-RIG_EIO);
+    }
+
+    // any number of applications on this machine may listen to the group
+    setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, (const char *) &on,
+               sizeof(on));
+#ifdef SO_REUSEPORT
+    setsockopt(socket_fd, SOL_SOCKET, SO_REUSEPORT, (const char *) &on,
+               sizeof(on));
+#endif
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(multicast_port);
+
+    memset(&mreq, 0, sizeof(mreq));
+    mreq.imr_multiaddr.s_addr = inet_addr(multicast_addr);
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+
+    if (bind(socket_fd, (struct sockaddr *) &addr, sizeof(addr)) < 0
+            || setsockopt(socket_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP,
+                          (const char *) &mreq, sizeof(mreq)) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot join %s port %d: %s\n", __func__,
+                  multicast_addr, multicast_port, strerror(errno));
+        close(socket_fd);
+        RETURNFUNC(-RIG_EIO);
+    }
+
+    priv = calloc(1, sizeof(multicast_subscriber_priv_data));
+
+    if (priv == NULL)
+    {
+        close(socket_fd);
+        RETURNFUNC(-RIG_ENOMEM);
+    }
+
+    priv->rig = rig;
+    priv->socket_fd = socket_fd;
+    priv->run = 1;
+    pthread_mutex_init(&priv->mutex, NULL);
+
+    if (pthread_create(&priv->thread_id, NULL, multicast_subscriber, priv))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s(%d) pthread_create error %s\n", __FILE__, __LINE__,
+                  strerror(errno));
+        pthread_mutex_destroy(&priv->mutex);
+        free(priv);
+        close(socket_fd);
+        RETURNFUNC(-RIG_EINTERNAL);
+    }
+
+    rs->multicast_subscriber_priv_data = priv;
+
+    RETURNFUNC(RIG_OK);
+}
+
+/**
+ * \brief Stop multicast subscriber
+ *
+ * \return RIG_OK or < 0 if error
+ */
+int network_multicast_subscriber_stop(RIG *rig)
+{
+    struct rig_state *rs = &rig->state;
+    multicast_subscriber_priv_data *priv = rs->multicast_subscriber_priv_data;
+
+    ENTERFUNC;
+
+    if (priv == NULL)
+    {
+        RETURNFUNC(RIG_OK);
+    }
+
+    priv->run = 0;
+
+    if (pthread_join(priv->thread_id, NULL))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s(%d): pthread_join error %s\n", __FILE__, __LINE__,
+                  strerror(errno));
+        // just ignore it
+    }
+
+    close(priv->socket_fd);
+    pthread_mutex_destroy(&priv->mutex);
+    free(priv);
+    rs->multicast_subscriber_priv_data = NULL;
+
+    RETURNFUNC(RIG_OK);
+}
+
+/**
+ * \brief The state the multicast subscriber heard last
+ *
+ * \param mirror gets a copy of it
+ * \param age_ms gets the ms since the last packet applied, may be NULL
+ * \return RIG_OK, -RIG_ENAVAIL when no subscriber runs or no full
+ * snapshot has been heard yet
+ */
+int network_multicast_subscriber_read(RIG *rig, struct snapshot_mirror *mirror,
+                                      int *age_ms)
+{
+    multicast_subscriber_priv_data *priv = rig->state.multicast_subscriber_priv_data;
+
+    if (priv == NULL)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    pthread_mutex_lock(&priv->mutex);
+    *mirror = priv->mirror;
+
+    if (age_ms) { *age_ms = (int) elapsed_ms(&priv->time, HAMLIB_ELAPSED_GET); }
+
+    pthread_mutex_unlock(&priv->mutex);
+
+    return mirror->valid ? RIG_OK : -RIG_ENAVAIL;
+}
 #endif
 /** @} */
@@ -28,14 +28,32 @@
 __BEGIN_DECLS
 
 /* Hamlib internal use, see rig.c */
+int network_init(void);
 int network_open(hamlib_port_t *p, int default_port);
 int network_close(hamlib_port_t *rp);
 void network_flush(hamlib_port_t *rp);
+void network_link_down(hamlib_port_t *rp);
+int network_request_begin(hamlib_port_t *rp);
+int network_generation(hamlib_port_t *rp);
+void network_set_resume(hamlib_port_t *rp,
+                        int (*resume)(hamlib_port_t *rp, void *arg), void *arg);
+/* gets the unasked '!' lines of rigctld, see network_set_push() */
+typedef void (*network_push_t)(hamlib_port_t *rp, const char *line, void *arg);
+void network_set_push(hamlib_port_t *rp, network_push_t push, void *arg);
+void network_push_poll(hamlib_port_t *rp);
+void network_release(hamlib_port_t *rp);
+int network_transaction(hamlib_port_t *rp, const char *cmd, int cmd_len,
+                        char *buf, int buf_len, const char *stopset, int replay);
+int network_rigctl_getter(const char *cmd);
 int network_publish_rig_poll_data(RIG *rig);
 int network_publish_rig_transceive_data(RIG *rig);
 int network_publish_rig_spectrum_data(RIG *rig, struct rig_spectrum_line *line);
 HAMLIB_EXPORT(int) network_multicast_publisher_start(RIG *rig, const char *multicast_addr, int multicast_port, enum multicast_item_e items);
 HAMLIB_EXPORT(int) network_multicast_publisher_stop(RIG *rig);
+struct snapshot_mirror;
+HAMLIB_EXPORT(int) network_multicast_subscriber_start(RIG *rig, const char *multicast_addr, int multicast_port);
+HAMLIB_EXPORT(int) network_multicast_subscriber_stop(RIG *rig);
+HAMLIB_EXPORT(int) network_multicast_subscriber_read(RIG *rig, struct snapshot_mirror *mirror, int *age_ms);
 
 __END_DECLS
 
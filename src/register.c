@@ -106,6 +106,9 @@ DEFINE_INITRIG_BACKEND(winradio);
  *  This is a NULL terminated list of available rig backends. Each entry in
  *  the list consists of two fields: The branch number, which is an integer,
  *  and the branch name, which is a character string.
+ *
+ *  Backends left out with configure --with-rig-backends are compiled out
+ *  through HAMLIB_SKIP_RIG_<NAME>.
  */
 static struct
 {
@@ -116,140 +119,197 @@ static struct
 } rig_backend_list[RIG_BACKEND_MAX] =
 {
     { RIG_DUMMY, RIG_BACKEND_DUMMY, RIG_FUNCNAMA(dummy) },
+#ifndef HAMLIB_SKIP_RIG_YAESU
     { RIG_YAESU, RIG_BACKEND_YAESU, RIG_FUNCNAM(yaesu) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_KENWOOD
     { RIG_KENWOOD, RIG_BACKEND_KENWOOD, RIG_FUNCNAM(kenwood) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_ICOM
     { RIG_ICOM, RIG_BACKEND_ICOM, RIG_FUNCNAM(icom) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_ICMARINE
     { RIG_ICMARINE, RIG_BACKEND_ICMARINE, RIG_FUNCNAMA(icmarine) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_PCR
     { RIG_PCR, RIG_BACKEND_PCR, RIG_FUNCNAMA(pcr) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_AOR
     { RIG_AOR, RIG_BACKEND_AOR, RIG_FUNCNAMA(aor) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_JRC
     { RIG_JRC, RIG_BACKEND_JRC, RIG_FUNCNAMA(jrc) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_UNIDEN
     { RIG_UNIDEN, RIG_BACKEND_UNIDEN, RIG_FUNCNAM(uniden) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_DRAKE
     { RIG_DRAKE, RIG_BACKEND_DRAKE, RIG_FUNCNAM(drake) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_LOWE
     { RIG_LOWE, RIG_BACKEND_LOWE, RIG_FUNCNAM(lowe) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_RACAL
     { RIG_RACAL, RIG_BACKEND_RACAL, RIG_FUNCNAMA(racal) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_WJ
     { RIG_WJ, RIG_BACKEND_WJ, RIG_FUNCNAMA(wj) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_SKANTI
     { RIG_SKANTI, RIG_BACKEND_SKANTI, RIG_FUNCNAMA(skanti) },
-#ifdef HAVE_WINRADIO
+#endif
+#if defined(HAVE_WINRADIO) && !defined(HAMLIB_SKIP_RIG_WINRADIO)
     { RIG_WINRADIO, RIG_BACKEND_WINRADIO, RIG_FUNCNAMA(winradio) },
 #endif /* HAVE_WINRADIO */
+#ifndef HAMLIB_SKIP_RIG_TENTEC
     { RIG_TENTEC, RIG_BACKEND_TENTEC, RIG_FUNCNAMA(tentec) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_ALINCO
     { RIG_ALINCO, RIG_BACKEND_ALINCO, RIG_FUNCNAMA(alinco) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_KACHINA
     { RIG_KACHINA, RIG_BACKEND_KACHINA, RIG_FUNCNAMA(kachina) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_TAPR
     { RIG_TAPR, RIG_BACKEND_TAPR, RIG_FUNCNAMA(tapr) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_FLEXRADIO
     { RIG_FLEXRADIO, RIG_BACKEND_FLEXRADIO, RIG_FUNCNAMA(flexradio) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_RFT
     { RIG_RFT, RIG_BACKEND_RFT, RIG_FUNCNAMA(rft) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_KIT
     { RIG_KIT, RIG_BACKEND_KIT, RIG_FUNCNAMA(kit) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_TUNER
     { RIG_TUNER, RIG_BACKEND_TUNER, RIG_FUNCNAMA(tuner) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_RS
     { RIG_RS, RIG_BACKEND_RS, RIG_FUNCNAMA(rs) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_PRM80
     { RIG_PRM80, RIG_BACKEND_PRM80, RIG_FUNCNAMA(prm80) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_ADAT
     { RIG_ADAT, RIG_BACKEND_ADAT, RIG_FUNCNAM(adat) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_DORJI
     { RIG_DORJI, RIG_BACKEND_DORJI, RIG_FUNCNAMA(dorji) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_BARRETT
     { RIG_BARRETT, RIG_BACKEND_BARRETT, RIG_FUNCNAMA(barrett) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_ELAD
     { RIG_ELAD, RIG_BACKEND_ELAD, RIG_FUNCNAMA(elad) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_CODAN
     { RIG_CODAN, RIG_BACKEND_CODAN, RIG_FUNCNAMA(codan) },
+#endif
+#ifndef HAMLIB_SKIP_RIG_GOMSPACE
     { RIG_GOMSPACE, RIG_BACKEND_GOMSPACE, RIG_FUNCNAM(gomspace) },
+#endif
     { 0, NULL }, /* end */
 };
 
 
 /*
- * This struct to keep track of known rig models.
- * It is chained, and used in a hash table, see below.
+ * Known rig models, indexed by model number.  Model numbers are
+ * backend * MAX_MODELS_PER_BACKEND + n, so the table is a direct map with
+ * no collisions and no allocations: registering a model stores its caps
+ * pointer and rig_get_caps() is a single array load.
  */
 //! @cond Doxygen_Suppress
-struct rig_list
-{
-    const struct rig_caps *caps;
-    struct rig_list *next;
-};
+#define RIGLSTHASHSZ 65535
 //! @endcond
 
+static const struct rig_caps *rig_caps_table[RIGLSTHASHSZ] = { NULL, };
 
-// This size has to be > than the max# of rigs for any manufacturer
-// A fatal error will occur when running rigctl if this value is too small
-//! @cond Doxygen_Suppress
-#define RIGLSTHASHSZ 65535
-#define HASH_FUNC(a) ((a)%RIGLSTHASHSZ)
-//! @endcond
+/* highest model registered so far, bounds the list walks */
+static rig_model_t rig_caps_max;
 
+/* which entries of rig_backend_list have had their be_init_all run */
+static char rig_backend_loaded[RIG_BACKEND_MAX];
 
-/*
- * The rig_hash_table is a hash table pointing to a list of next==NULL
- *  terminated caps.
- */
-static struct rig_list *rig_hash_table[RIGLSTHASHSZ] = { NULL, };
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+static pthread_mutex_t rig_backend_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
 
 static int rig_lookup_backend(rig_model_t rig_model);
 
 
-/*
- * Basically, this is a hash insert function that doesn't check for dup!
- */
 //! @cond Doxygen_Suppress
 int HAMLIB_API rig_register(const struct rig_caps *caps)
 {
-    int hval;
-    struct rig_list *p;
-
-    //rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+    rig_model_t model;
 
     if (!caps)
     {
         return -RIG_EINVAL;
     }
 
-#if 0
-    rig_debug(RIG_DEBUG_VERBOSE,
-              "%s: rig_register (%u)\n",
-              __func__,
-              caps->rig_model);
-#endif
+    model = caps->rig_model;
 
-    p = (struct rig_list *)malloc(sizeof(struct rig_list));
+    if (model >= RIGLSTHASHSZ)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: model %u out of range\n", __func__, model);
+        return -RIG_EINVAL;
+    }
 
-    if (!p)
+    if (rig_caps_table[model] && rig_caps_table[model] != caps)
     {
-        return -RIG_ENOMEM;
+        rig_debug(RIG_DEBUG_ERR, "%s: model %u registered twice, %s and %s\n",
+                  __func__, model, rig_caps_table[model]->model_name,
+                  caps->model_name);
+        return -RIG_EINVAL;
     }
 
-    hval = HASH_FUNC(caps->rig_model);
+    rig_caps_table[model] = caps;
 
-    if (rig_hash_table[hval])
+    if (model > rig_caps_max)
     {
-        printf("Hash collision!!! Fatal error!!\n");
-        exit(1);
+        rig_caps_max = model;
     }
 
-    p->caps = caps;
-    // p->handle = NULL;
-    p->next = rig_hash_table[hval];
-    rig_hash_table[hval] = p;
-
-    //RETURNFUNC(RIG_OK);
     return RIG_OK;
 }
 //! @endcond
 
 /*
  * Get rig capabilities.
- * ie. rig_hash_table lookup
+ * Only the backend of the model is loaded if it was not already, so
+ * rig_init() and friends do not need rig_load_all_backends().
  */
 
 //! @cond Doxygen_Suppress
 const struct rig_caps *HAMLIB_API rig_get_caps(rig_model_t rig_model)
 {
-    struct rig_list *p;
+    int be_idx;
 
-    for (p = rig_hash_table[HASH_FUNC(rig_model)]; p; p = p->next)
+    if (rig_model >= RIGLSTHASHSZ)
     {
-        if (p->caps->rig_model == rig_model)
-        {
-            return p->caps;
-        }
+        return NULL;
     }
 
-    return NULL;    /* sorry, caps not registered! */
+    if (rig_caps_table[rig_model])
+    {
+        return rig_caps_table[rig_model];
+    }
+
+    be_idx = rig_lookup_backend(rig_model);
+
+    /*
+     * rig_backend_loaded[] is only looked at under rig_backend_mutex: another
+     * thread may be in the middle of registering this backend's caps.
+     */
+    if (be_idx >= 0)
+    {
+        rig_load_backend(rig_backend_list[be_idx].be_name);
+    }
+
+    return rig_caps_table[rig_model];   /* NULL if not a known model */
 }
 //! @endcond
 
@@ -286,60 +346,15 @@ static int rig_lookup_backend(rig_model_t rig_model)
 //! @cond Doxygen_Suppress
 int HAMLIB_API rig_check_backend(rig_model_t rig_model)
 {
-    const struct rig_caps *caps;
-    int be_idx;
-    int retval;
-    int i, n;
-
-    /* already loaded ? */
-    caps = rig_get_caps(rig_model);
-
-    if (caps)
+    if (rig_get_caps(rig_model))
     {
         return RIG_OK;
     }
 
-    // hmmm...no caps so did we already load the rigs?
-    for (n = 0, i = 0; i < RIGLSTHASHSZ; i++)
-    {
-        if (rig_hash_table[i]) { ++n; }
-    }
-
-    if (n > 1)
-    {
-        rig_debug(RIG_DEBUG_ERR, "%s: rig model %u not found and rig count=%d\n",
-                  __func__, rig_model, n);
-        return -RIG_ENAVAIL;
-    }
-
-    be_idx = rig_lookup_backend(rig_model);
-
-    /*
-     * Never heard about this backend family!
-     */
-    if (be_idx == -1)
-    {
-        rig_debug(RIG_DEBUG_VERBOSE,
-                  "rig_check_backend: unsupported backend %u for model %u\n",
-                  RIG_BACKEND_NUM(rig_model),
-                  rig_model);
-        return -RIG_ENAVAIL;
-    }
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: model %u not found in backend %u\n",
+              __func__, rig_model, RIG_BACKEND_NUM(rig_model));
 
-    // do we need to load the backend?
-//    if (rig_backend_list[be_idx].be_init_all == 0)
-    {
-        retval = rig_load_backend(rig_backend_list[be_idx].be_name);
-    }
-#if 0
-    else
-    {
-        retval = RIG_OK;
-    }
-
-#endif
-
-    return retval;
+    return -RIG_ENAVAIL;
 }
 //! @endcond
 
@@ -348,65 +363,40 @@ int HAMLIB_API rig_check_backend(rig_model_t rig_model)
 //! @cond Doxygen_Suppress
 int HAMLIB_API rig_unregister(rig_model_t rig_model)
 {
-    int hval;
-    struct rig_list *p, *q;
-
-    hval = HASH_FUNC(rig_model);
-    q = NULL;
-
-    for (p = rig_hash_table[hval]; p; p = p->next)
+    if (rig_model >= RIGLSTHASHSZ || !rig_caps_table[rig_model])
     {
-        if (p->caps->rig_model == rig_model)
-        {
-            if (q == NULL)
-            {
-                rig_hash_table[hval] = p->next;
-            }
-            else
-            {
-                q->next = p->next;
-            }
-
-            free(p);
-            return RIG_OK;
-        }
-
-        q = p;
+        return -RIG_EINVAL; /* sorry, caps not registered! */
     }
 
-    return -RIG_EINVAL; /* sorry, caps not registered! */
+    rig_caps_table[rig_model] = NULL;
+
+    return RIG_OK;
 }
 //! @endcond
 
 /*
  * rig_list_foreach
- * executes cfunc on all the elements stored in the rig hash list
+ * executes cfunc on all the registered caps, in model order
  */
 //! @cond Doxygen_Suppress
 int HAMLIB_API rig_list_foreach(int (*cfunc)(const struct rig_caps *,
                                 rig_ptr_t),
                                 rig_ptr_t data)
 {
-    struct rig_list *p;
-    int i;
+    rig_model_t i;
 
     if (!cfunc)
     {
         return -RIG_EINVAL;
     }
 
-    for (i = 0; i < RIGLSTHASHSZ; i++)
+    for (i = 0; i <= rig_caps_max; i++)
     {
-        struct rig_list *next = NULL;
+        const struct rig_caps *caps = rig_caps_table[i];
 
-        for (p = rig_hash_table[i]; p; p = next)
+        if (caps && (*cfunc)(caps, data) == 0)
         {
-            next = p->next;       /* read before call in case it is unregistered */
-
-            if ((*cfunc)(p->caps, data) == 0)
-            {
-                return RIG_OK;
-            }
+            return RIG_OK;
         }
     }
 
@@ -416,33 +406,25 @@ int HAMLIB_API rig_list_foreach(int (*cfunc)(const struct rig_caps *,
 
 /*
  * rig_list_foreach_model
- * executes cfunc on all the elements stored in the rig hash list
+ * executes cfunc on all the registered models, in model order
  */
 //! @cond Doxygen_Suppress
 int HAMLIB_API rig_list_foreach_model(int (*cfunc)(const rig_model_t rig_model,
                                       rig_ptr_t),
                                       rig_ptr_t data)
 {
-    struct rig_list *p;
-    int i;
+    rig_model_t i;
 
     if (!cfunc)
     {
         return -RIG_EINVAL;
     }
 
-    for (i = 0; i < RIGLSTHASHSZ; i++)
+    for (i = 0; i <= rig_caps_max; i++)
     {
-        struct rig_list *next = NULL;
-
-        for (p = rig_hash_table[i]; p; p = next)
+        if (rig_caps_table[i] && (*cfunc)(i, data) == 0)
         {
-            next = p->next;       /* read before call in case it is unregistered */
-
-            if ((*cfunc)(p->caps->rig_model, data) == 0)
-            {
-                return RIG_OK;
-            }
+            return RIG_OK;
         }
     }
 
@@ -462,6 +444,43 @@ static int dummy_rig_probe(const hamlib_port_t *p,
 //! @endcond
 
 
+/*
+ * The model a serial port's USB descriptors name, found without talking
+ * to the rig; RIG_MODEL_NONE if they name none.  *skip is set for the data
+ * port of a rig whose CAT port is another, not worth probing.
+ */
+static rig_model_t rig_probe_usb(hamlib_port_t *p, int *skip)
+{
+    struct rig_usb_device dev;
+
+    *skip = 0;
+
+    if (p->type.rig != RIG_PORT_SERIAL
+            || rig_usb_identify_port(p->pathname, &dev) != RIG_OK)
+    {
+        return RIG_MODEL_NONE;
+    }
+
+    if (!dev.cat)
+    {
+        *skip = 1;
+        return RIG_MODEL_NONE;
+    }
+
+    if (dev.model != RIG_MODEL_NONE)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: %s is a %s from its USB descriptors\n",
+                  __func__, p->pathname, dev.serial[0] ? dev.serial : dev.product);
+
+        if (dev.serial_rate)
+        {
+            p->parm.serial.rate = dev.serial_rate;
+        }
+    }
+
+    return dev.model;
+}
+
 /*
  * rig_probe_first
  * called straight by rig_probe
@@ -469,9 +488,16 @@ static int dummy_rig_probe(const hamlib_port_t *p,
 //! @cond Doxygen_Suppress
 rig_model_t rig_probe_first(hamlib_port_t *p)
 {
-    int i;
+    int i, skip;
     rig_model_t model;
 
+    model = rig_probe_usb(p, &skip);
+
+    if (model != RIG_MODEL_NONE || skip)
+    {
+        return model;
+    }
+
     for (i = 0; i < RIG_BACKEND_MAX && rig_backend_list[i].be_name; i++)
     {
         if (rig_backend_list[i].be_probe_all)
@@ -492,6 +518,74 @@ rig_model_t rig_probe_first(hamlib_port_t *p)
 //! @endcond
 
 
+/*
+ * Backends in the order rig_probe_port() tries them: the common CAT
+ * protocols first, and the cheap ones (one query per baud rate) before
+ * Icom, which has to walk the CI-V addresses.  gomspace is left out, its
+ * probe does no I/O and always answers GS100.
+ */
+static const int rig_probe_order[] =
+{
+    RIG_KENWOOD, RIG_YAESU, RIG_ICOM, RIG_ELAD, RIG_UNIDEN, RIG_DRAKE,
+    RIG_LOWE, RIG_ADAT,
+};
+
+#define RIG_PROBE_ORDER_LEN (int)(sizeof(rig_probe_order) / sizeof(rig_probe_order[0]))
+
+/*
+ * rig_probe_port
+ * probes backends in likelihood order and stops at the first one that
+ * identifies the rig, called by rig_probe_all_ports
+ */
+//! @cond Doxygen_Suppress
+rig_model_t rig_probe_port(hamlib_port_t *p,
+                           rig_probe_func_t cfunc,
+                           rig_ptr_t data)
+{
+    rig_model_t model;
+    int i, j, skip;
+
+    model = rig_probe_usb(p, &skip);
+
+    if (model != RIG_MODEL_NONE)
+    {
+        if (cfunc)
+        {
+            (*cfunc)(p, model, data);
+        }
+
+        return model;
+    }
+
+    if (skip)
+    {
+        return RIG_MODEL_NONE;
+    }
+
+    for (j = 0; j < RIG_PROBE_ORDER_LEN; j++)
+    {
+        for (i = 0; i < RIG_BACKEND_MAX && rig_backend_list[i].be_name; i++)
+        {
+            if (rig_backend_list[i].be_num != rig_probe_order[j]
+                    || !rig_backend_list[i].be_probe_all)
+            {
+                continue;
+            }
+
+            model = (*rig_backend_list[i].be_probe_all)(p, cfunc, data);
+
+            if (model != RIG_MODEL_NONE)
+            {
+                return model;
+            }
+        }
+    }
+
+    return RIG_MODEL_NONE;
+}
+//! @endcond
+
+
 /*
  * rig_probe_all_backends
  * called straight by rig_probe_all
@@ -521,8 +615,7 @@ int rig_load_all_backends()
 {
     int i;
 
-    memset(rig_hash_table, 0, sizeof(rig_hash_table));
-
+    /* backends already loaded by rig_get_caps() are skipped */
     for (i = 0; i < RIG_BACKEND_MAX && rig_backend_list[i].be_name; i++)
     {
         rig_load_backend(rig_backend_list[i].be_name);
@@ -551,16 +644,31 @@ int HAMLIB_API rig_load_backend(const char *be_name)
     {
         if (!strcmp(be_name, rig_backend_list[i].be_name))
         {
+            int retval = RIG_OK;
+
             be_init = rig_backend_list[i].be_init_all ;
 
-            if (be_init)
+            if (!be_init)
             {
-                return (*be_init)(NULL);
+                return -RIG_EINVAL;
             }
-            else
+
+#ifdef HAVE_PTHREAD
+            pthread_mutex_lock(&rig_backend_mutex);
+#endif
+
+            /* registering is idempotent, but there is no need to redo it */
+            if (!rig_backend_loaded[i])
             {
-                return -RIG_EINVAL;
+                retval = (*be_init)(NULL);
+                rig_backend_loaded[i] = 1;
             }
+
+#ifdef HAVE_PTHREAD
+            pthread_mutex_unlock(&rig_backend_mutex);
+#endif
+
+            return retval;
         }
     }
 
@@ -60,6 +60,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <errno.h>
+#include <math.h>
 #ifdef HAVE_PTHREAD
 #include <pthread.h>
 #endif
@@ -73,10 +74,34 @@
 #include "event.h"
 #include "cm108.h"
 #include "gpio.h"
+#include "dcd_watch.h"
+#include "keyer.h"
+#include "morse_queue.h"
 #include "misc.h"
 #include "sprintflst.h"
 #include "hamlibdatetime.h"
 #include "cache.h"
+#include "rigfacts.h"
+#include "stats.h"
+#include "rigqueue.h"
+#include "spectrum_proc.h"
+#include "spectrum_history.h"
+#include "band_follow.h"
+#include "rig_follow.h"
+#include "doppler.h"
+#include "vfo_plan.h"
+#include "capture.h"
+#include "shmcache.h"
+#include "journal.h"
+#include "rto.h"
+#include "chancache.h"
+#include "conf_index.h"
+#include "cal.h"
+#include "caps_index.h"
+#include "async_dispatch.h"
+#include "ioevent.h"
+#include "thread_sched.h"
+#include "riginfo.h"
 
 /**
  * \brief Hamlib release number
@@ -223,10 +248,16 @@ typedef struct async_data_handler_priv_data_s
 {
     pthread_t thread_id;
     async_data_handler_args args;
+    struct async_dispatch *dispatch;
+    int shared;     /* read by the shared reader rather than thread_id */
+    int backoff_us; /* shared reader: last backoff of a failing port */
+    struct timeval retry_at; /* shared reader: when it goes back in the loop */
 } async_data_handler_priv_data;
 
 static int async_data_handler_start(RIG *rig);
 static int async_data_handler_stop(RIG *rig);
+static int async_shared_add(RIG *rig);
+static void async_shared_remove(RIG *rig);
 void *async_data_handler(void *arg);
 #endif
 
@@ -488,6 +519,10 @@ RIG *HAMLIB_API rig_init(rig_model_t rig_model)
     struct rig_state *rs;
     int i;
 
+#ifdef HAVE_ETW
+    hamlib_trace_init();
+#endif
+
     rig_check_rig_caps();
 
     rig_check_backend(rig_model);
@@ -544,6 +579,9 @@ RIG *HAMLIB_API rig_init(rig_model_t rig_model)
     rs = &rig->state;
 #ifdef HAVE_PTHREAD
     pthread_mutex_init(&rs->mutex_set_transaction, NULL);
+    // the API lock itself, see rig_lock.c
+    pthread_mutex_init(&rs->mutex_state, NULL);
+    pthread_cond_init(&rs->cond_state, NULL);
 #endif
 
     rs->async_data_enabled = 0;
@@ -608,6 +646,14 @@ RIG *HAMLIB_API rig_init(rig_model_t rig_model)
     rs->poll_interval = 0; // disable polling by default
     rs->lo_freq = 0;
     rs->cache.timeout_ms = 500;  // 500ms cache timeout by default
+    rs->cache_level_timeout_ms = 500;
+    rs->cache_func_timeout_ms = 500;
+    rs->push_timeout_ms = 5000;
+    rs->cw_wpm = 20;
+    rs->cw_ptt_lead_ms = 50;
+    rs->cw_ptt_tail_ms = 200;
+    rs->serial_latency_timer = -1;
+    rs->timeout_floor = RTO_DEFAULT_FLOOR;
 
     // We are using range_list1 as the default
     // Eventually we will have separate model number for different rig variations
@@ -755,6 +801,12 @@ RIG *HAMLIB_API rig_init(rig_model_t rig_model)
      * This must be done only once defaults are setup,
      * so the backend init can override rig_state.
      */
+    if (rig_cal_init(rig) != RIG_OK)
+    {
+        free(rig);
+        return (NULL);
+    }
+
     if (caps->rig_init != NULL)
     {
         int retcode = caps->rig_init(rig);
@@ -765,11 +817,16 @@ RIG *HAMLIB_API rig_init(rig_model_t rig_model)
                       "%s: backend_init failed!\n",
                       __func__);
             /* cleanup and exit */
+            rig_cal_cleanup(rig);
+            rig_cache_settings_free(rig);
             free(rig);
             return (NULL);
         }
     }
 
+    rig_conf_index_init(rig);
+    rig_info_init(rig);
+
     return (rig);
 }
 
@@ -992,6 +1049,14 @@ int HAMLIB_API rig_open(RIG *rig)
         }
     }
 
+    /* a replay swaps the rig port for a pty, so this comes first */
+    status = capture_open(rig);
+
+    if (status < 0)
+    {
+        RETURNFUNC(status);
+    }
+
     status = port_open(&rs->rigport);
 
     if (status < 0)
@@ -999,9 +1064,16 @@ int HAMLIB_API rig_open(RIG *rig)
         rig_debug(RIG_DEBUG_VERBOSE, "%s: rs->comm_state==0?=%d\n", __func__,
                   rs->comm_state);
         rs->comm_state = 0;
+        capture_close(rig);
         RETURNFUNC(status);
     }
 
+    if (rs->paced_writer && rs->rigport.write_delay > 0)
+    {
+        /* falls back to writing from the caller's thread */
+        port_writer_start(&rs->rigport);
+    }
+
     switch (rs->pttport.type.ptt)
     {
     case RIG_PTT_NONE:
@@ -1202,6 +1274,20 @@ int HAMLIB_API rig_open(RIG *rig)
 
         break;
 
+    case RIG_DCD_CM108:
+        rs->dcdport.fd = cm108_open(&rs->dcdport);
+
+        if (rs->dcdport.fd < 0)
+        {
+            rig_debug(RIG_DEBUG_ERR,
+                      "%s: cannot open DCD device \"%s\"\n",
+                      __func__,
+                      rs->dcdport.pathname);
+            status = -RIG_EIO;
+        }
+
+        break;
+
     default:
         rig_debug(RIG_DEBUG_ERR,
                   "%s: unsupported DCD type %d\n",
@@ -1210,17 +1296,41 @@ int HAMLIB_API rig_open(RIG *rig)
         status = -RIG_ECONF;
     }
 
+    if (status == RIG_OK)
+    {
+        status = keyer_start(rig);
+    }
+
+    if (status == RIG_OK)
+    {
+        status = morse_queue_start(rig);
+
+        if (status < 0)
+        {
+            keyer_stop(rig);
+        }
+    }
+
     if (status < 0)
     {
         port_close(&rs->rigport, rs->rigport.type.rig);
+        capture_close(rig);
         RETURNFUNC(status);
     }
 
+    /* without a watcher, rig_get_dcd() keeps reading the port */
+    dcd_watch_start(rig);
+
+    memset(rs->ale_last, 0, sizeof(rs->ale_last));
+
     status = async_data_handler_start(rig);
 
     if (status < 0)
     {
+        morse_queue_stop(rig);
+        keyer_stop(rig);
         port_close(&rs->rigport, rs->rigport.type.rig);
+        capture_close(rig);
         RETURNFUNC(status);
     }
 
@@ -1231,12 +1341,17 @@ int HAMLIB_API rig_open(RIG *rig)
               &rs->comm_state,
               rs->comm_state);
 
+    // the backend may widen this once it has probed the rig
+    rs->targetable_vfo = caps->targetable_vfo;
+
     /*
      * Maybe the backend has something to initialize
      * In case of failure, just close down and report error code.
      */
     if (caps->rig_open != NULL)
     {
+        rig_facts_load(rig);
+
         status = caps->rig_open(rig);
 
         if (status != RIG_OK)
@@ -1244,12 +1359,18 @@ int HAMLIB_API rig_open(RIG *rig)
             remove_opened_rig(rig);
             async_data_handler_stop(rig);
             port_close(&rs->rigport, rs->rigport.type.rig);
+            capture_close(rig);
             memcpy(&rs->rigport_deprecated, &rs->rigport, sizeof(hamlib_port_t_deprecated));
             rs->comm_state = 0;
             RETURNFUNC(status);
         }
+
+        rig_facts_save(rig);
     }
 
+    // the backend has settled the range, filter and channel lists by now
+    rig_caps_index_build(rig);
+
     /*
      * trigger state->current_vfo first retrieval
      */
@@ -1296,6 +1417,8 @@ int HAMLIB_API rig_open(RIG *rig)
         }
     }
 
+    vfo_plan_audit(rig);
+
     if (rs->auto_disable_screensaver)
     {
         // try to turn off the screensaver if possible
@@ -1305,6 +1428,19 @@ int HAMLIB_API rig_open(RIG *rig)
         rig_set_parm(rig, RIG_PARM_SCREENSAVER, parm_value);
     }
 
+    // a reader-side convenience, the rig works without it
+    if (rig_shm_publish_open(rig) != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: shm_cache %s not published\n", __func__,
+                  rig_shm_get_name(rig));
+    }
+
+    if (rig_journal_open(rig) != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: journal_file %s not written\n", __func__,
+                  rig_journal_get_path(rig));
+    }
+
     // read frequency to update internal status
 //    freq_t freq;
 //    if (caps->get_freq) rig_get_freq(rig, RIG_VFO_A, &freq);
@@ -1312,13 +1448,19 @@ int HAMLIB_API rig_open(RIG *rig)
     
     // prime the freq and mode settings
     // don't care about the return here -- if it doesn't work so be it
-    freq_t freq;
-    rig_get_freq(rig, RIG_VFO_A, &freq);
-    rig_get_freq(rig, RIG_VFO_B, &freq);
-    rmode_t mode;
-    pbwidth_t width;
-    rig_get_mode(rig, RIG_VFO_A, &mode, &width);
-    rig_get_mode(rig, RIG_VFO_B, &mode, &width);
+    // with open_fast the getters miss the empty cache and ask the rig
+    // themselves, so the first one pays for its own VFO only
+    if (!rs->open_fast)
+    {
+        freq_t freq;
+        rmode_t mode;
+        pbwidth_t width;
+
+        rig_get_freq(rig, RIG_VFO_A, &freq);
+        rig_get_freq(rig, RIG_VFO_B, &freq);
+        rig_get_mode(rig, RIG_VFO_A, &mode, &width);
+        rig_get_mode(rig, RIG_VFO_B, &mode, &width);
+    }
 
     memcpy(&rs->rigport_deprecated, &rs->rigport, sizeof(hamlib_port_t_deprecated));
     memcpy(&rs->pttport_deprecated, &rs->pttport, sizeof(hamlib_port_t_deprecated));
@@ -1360,6 +1502,16 @@ int HAMLIB_API rig_close(RIG *rig)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    /* anything still queued by rig_submit() is failed, not sent */
+    rig_queue_stop(rig);
+
+    /* unsent CW is dropped, the keyer lets go of its lines */
+    morse_queue_stop(rig);
+    keyer_stop(rig);
+
+    /* no more corrections once the port is about to go */
+    doppler_stop(rig);
+
     /*
      * Let the backend say 73s to the rig.
      * and ignore the return code.
@@ -1367,6 +1519,7 @@ int HAMLIB_API rig_close(RIG *rig)
     if (caps->rig_close)
     {
         caps->rig_close(rig);
+        rig_facts_save(rig);
     }
 
     async_data_handler_stop(rig);
@@ -1437,6 +1590,8 @@ int HAMLIB_API rig_close(RIG *rig)
                   rs->pttport.type.ptt);
     }
 
+    dcd_watch_stop(rig);
+
     switch (rs->dcdport.type.dcd)
     {
     case RIG_DCD_NONE:
@@ -1463,6 +1618,10 @@ int HAMLIB_API rig_close(RIG *rig)
         gpio_close(&rs->dcdport);
         break;
 
+    case RIG_DCD_CM108:
+        cm108_close(&rs->dcdport);
+        break;
+
     default:
         rig_debug(RIG_DEBUG_ERR,
                   "%s: unsupported DCD type %d\n",
@@ -1473,6 +1632,9 @@ int HAMLIB_API rig_close(RIG *rig)
     rs->dcdport.fd = rs->pttport.fd = -1;
 
     port_close(&rs->rigport, rs->rigport.type.rig);
+    capture_close(rig);
+    rig_shm_publish_close(rig);
+    rig_journal_close(rig);
 
     remove_opened_rig(rig);
 
@@ -1513,6 +1675,11 @@ int HAMLIB_API rig_cleanup(RIG *rig)
         rig_close(rig);
     }
 
+#ifdef HAVE_PTHREAD
+    // its events reach into what is freed below
+    network_multicast_subscriber_stop(rig);
+#endif
+
     /*
      * basically free up the priv struct
      */
@@ -1521,6 +1688,26 @@ int HAMLIB_API rig_cleanup(RIG *rig)
         rig->caps->rig_cleanup(rig);
     }
 
+    band_follow_rig_gone(rig);
+    rig_follow_rig_gone(rig);
+    spectrum_proc_free(rig);
+    spectrum_history_free(rig);
+    capture_free(rig);
+    rig_shm_free(rig);
+    rig_journal_free(rig);
+    rig_rto_free(rig);
+    chan_cache_free(rig);
+    rig_cache_settings_free(rig);
+    rig_facts_free(rig);
+    rig_conf_index_cleanup(rig);
+    rig_cal_cleanup(rig);
+    rig_caps_index_free(rig);
+    rig_info_free(rig);
+#ifdef HAVE_PTHREAD
+    pthread_mutex_destroy(&rig->state.mutex_state);
+    pthread_cond_destroy(&rig->state.cond_state);
+#endif
+
     free(rig);
 
     return (RIG_OK);
@@ -1549,6 +1736,8 @@ int HAMLIB_API rig_set_twiddle(RIG *rig, int seconds)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     rig->state.twiddle_timeout = seconds;
 
     RETURNFUNC(RIG_OK);
@@ -1574,6 +1763,8 @@ int HAMLIB_API rig_set_uplink(RIG *rig, int val)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     rig->state.uplink = val;
 
     RETURNFUNC(RIG_OK);
@@ -1600,6 +1791,8 @@ int HAMLIB_API rig_get_twiddle(RIG *rig, int *seconds)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     *seconds = rig->state.twiddle_timeout;
     RETURNFUNC(RIG_OK);
 }
@@ -1696,6 +1889,8 @@ int HAMLIB_API rig_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
         RETURNFUNC2(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     if (rig->state.twiddle_state == TWIDDLE_ON)
     {
         // we keep skipping set_freq while the vfo knob is in motion
@@ -1706,6 +1901,17 @@ int HAMLIB_API rig_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
 
     caps = rig->caps;
 
+    if (rig_queue_coalescing(rig) && caps->set_freq)
+    {
+        struct rig_request req = { .type = RIG_REQ_SET_FREQ, .vfo = vfo, .freq = freq };
+
+        // the cache shows where we are heading right away, the I/O thread catches up
+        rig_set_cache_freq(rig, vfo, freq);
+        retcode = rig_queue_coalesce(rig, &req);
+        ELAPSED2;
+        RETURNFUNC2(retcode);
+    }
+
     if (rig->state.lo_freq != 0.0)
     {
         freq -= rig->state.lo_freq;
@@ -1900,6 +2106,7 @@ int HAMLIB_API rig_set_freq(RIG *rig, vfo_t vfo, freq_t freq)
  */
 int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
 {
+    struct rig_cache_snapshot snap;
     const struct rig_caps *caps;
     int retcode;
     vfo_t curr_vfo;
@@ -1919,6 +2126,18 @@ int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
         RETURNFUNC2(-RIG_EINVAL);
     }
 
+    rig_cache_snapshot(rig, vfo, &snap);
+
+    if (snap.freq_ok)
+    {
+        rig_stats_cache(rig, HAMLIB_CACHE_FREQ, 1);
+        *freq = snap.freq;
+        ELAPSED2;
+        return (RIG_OK);
+    }
+
+    RIG_LOCK(rig);
+
     rig_debug(RIG_DEBUG_VERBOSE, "%s(%d) called vfo=%s\n", __func__, __LINE__,
               rig_strvfo(vfo));
     rig_cache_show(rig, __func__, __LINE__);
@@ -1986,10 +2205,12 @@ int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
 
     rig_cache_show(rig, __func__, __LINE__);
 
-    if (*freq != 0 && (cache_ms_freq < rig->state.cache.timeout_ms
+    if (*freq != 0 && (cache_ms_freq < rig_cache_ttl(rig, rig_cache_freq_slot(rig,
+                       vfo), (uint64_t)*freq, cache_ms_freq)
                        || (rig->state.cache.timeout_ms == HAMLIB_CACHE_ALWAYS
-                           || rig->state.use_cached_freq)))
+                           || rig_cache_pushed(rig, rig->state.use_cached_freq))))
     {
+        rig_stats_cache(rig, HAMLIB_CACHE_FREQ, 1);
         rig_debug(RIG_DEBUG_TRACE, "%s: %s cache hit age=%dms, freq=%.0f\n", __func__,
                   rig_strvfo(vfo), cache_ms_freq, *freq);
         ELAPSED2;
@@ -1997,14 +2218,23 @@ int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     }
     else
     {
+        rig_stats_cache(rig, HAMLIB_CACHE_FREQ, 0);
         rig_debug(RIG_DEBUG_TRACE,
                   "%s: cache miss age=%dms, cached_vfo=%s, asked_vfo=%s\n", __func__,
                   cache_ms_freq,
                   rig_strvfo(vfo), rig_strvfo(vfo));
     }
 
+    freq_t cached_freq = *freq;
     caps = rig->caps;
 
+    // past the caller's deadline the cache is the answer, however old
+    if (cached_freq != 0 && rig_deadline_cache())
+    {
+        ELAPSED2;
+        return (RIG_OK);
+    }
+
     if (caps->get_freq == NULL)
     {
         RETURNFUNC2(-RIG_ENAVAIL);
@@ -2013,10 +2243,7 @@ int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
     rig_debug(RIG_DEBUG_VERBOSE, "%s(%d): vfo_opt=%d, model=%d\n", __func__,
               __LINE__, rig->state.vfo_opt, rig->caps->rig_model);
 
-    // If we're in vfo_mode then rigctld will do any VFO swapping we need
-    if ((caps->targetable_vfo & RIG_TARGETABLE_FREQ)
-            || vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo
-            || (rig->state.vfo_opt == 1 && rig->caps->rig_model == RIG_MODEL_NETRIGCTL))
+    if (vfo_plan(rig, vfo, RIG_TARGETABLE_FREQ, "get_freq") != RIG_VFO_PLAN_SWAP)
     {
         // If rig does not have set_vfo we need to change vfo
         if (vfo == RIG_VFO_CURR && caps->set_vfo == NULL)
@@ -2028,6 +2255,13 @@ int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
 
         retcode = caps->get_freq(rig, vfo, freq);
 
+        if (retcode == -RIG_ETIMEOUT && cached_freq != 0 && rig_deadline_cache())
+        {
+            *freq = cached_freq;
+            ELAPSED2;
+            return (RIG_OK);
+        }
+
         rig_cache_show(rig, __func__, __LINE__);
 
         // sometimes a network rig like FLRig will return freq=0
@@ -2083,6 +2317,11 @@ int HAMLIB_API rig_get_freq(RIG *rig, vfo_t vfo, freq_t *freq)
         }
     }
 
+    if (retcode == RIG_OK)
+    {
+        rig_cache_push_check(rig, rig->state.use_cached_freq, *freq == cached_freq);
+    }
+
     /* VFO compensation */
     if (rig->state.vfo_comp != 0.0)
     {
@@ -2141,6 +2380,119 @@ int HAMLIB_API rig_get_freqs(RIG *rig, freq_t *freqA, freq_t freqB)
 }
 
 
+/**
+ * \brief get several values from the rig at once
+ * \param rig   The rig handle
+ * \param bulk  The selection in bulk->mask and the storage for the results
+ *
+ *  Retrieves any combination of the RIG_BULK_* values in one call.
+ *  When the backend has a get_bulk routine it is given the first chance to
+ *  fill the request in as few exchanges as possible (e.g. one Kenwood IF;
+ *  answer).  Whatever it could not provide is then fetched through the
+ *  normal rig_get_freq(), rig_get_mode() etc. calls, which will usually be
+ *  cache hits for values the backend just returned.
+ *
+ *  bulk->valid tells which values were actually retrieved.
+ *
+ * \return RIG_OK if everything in bulk->mask was retrieved, otherwise
+ * the first error seen (bulk->valid still describes the partial result).
+ *
+ * \sa rig_get_freq(), rig_get_mode(), rig_get_ptt(), rig_get_split_vfo()
+ */
+int HAMLIB_API rig_get_bulk(RIG *rig, struct rig_bulk *bulk)
+{
+    const struct rig_caps *caps;
+    rig_bulk_t todo;
+    int retcode = RIG_OK;
+    int rc;
+
+    if (CHECK_RIG_ARG(rig) || !bulk)
+    {
+        RETURNFUNC2(-RIG_EINVAL);
+    }
+
+    RIG_LOCK(rig);
+
+    ENTERFUNC;
+
+    caps = rig->caps;
+    bulk->valid = RIG_BULK_NONE;
+
+    if (caps->get_bulk)
+    {
+        rc = caps->get_bulk(rig, bulk);
+
+        if (rc != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: backend get_bulk failed: %s\n", __func__,
+                      rigerror(rc));
+        }
+
+        bulk->valid &= bulk->mask;
+
+        if (bulk->valid & RIG_BULK_FREQ_A) { rig_set_cache_freq(rig, RIG_VFO_A, bulk->freqA); }
+
+        if (bulk->valid & RIG_BULK_FREQ_B) { rig_set_cache_freq(rig, RIG_VFO_B, bulk->freqB); }
+
+        if (bulk->valid & RIG_BULK_MODE_A) { rig_set_cache_mode(rig, RIG_VFO_A, bulk->modeA, bulk->widthA); }
+
+        if (bulk->valid & RIG_BULK_MODE_B) { rig_set_cache_mode(rig, RIG_VFO_B, bulk->modeB, bulk->widthB); }
+
+        if (bulk->valid & (RIG_BULK_PTT | RIG_BULK_SPLIT))
+        {
+            rig_cache_write_begin(rig);
+
+            if (bulk->valid & RIG_BULK_PTT)
+            {
+                rig->state.cache.ptt = bulk->ptt;
+                elapsed_ms(&rig->state.cache.time_ptt, HAMLIB_ELAPSED_SET);
+            }
+
+            if (bulk->valid & RIG_BULK_SPLIT)
+            {
+                rig->state.cache.split = bulk->split;
+                rig->state.cache.split_vfo = bulk->split_vfo;
+                elapsed_ms(&rig->state.cache.time_split, HAMLIB_ELAPSED_SET);
+            }
+
+            rig_cache_write_end(rig);
+        }
+    }
+
+    todo = bulk->mask & ~bulk->valid;
+
+    // generic fallback for anything the backend didn't give us
+    // each read is a call of its own, a PTT off may go in between
+#define BULK_GET(bit, call) \
+    if (todo & (bit)) \
+    { \
+        rc = (call); \
+        if (rc == RIG_OK) { bulk->valid |= (bit); } \
+        else if (retcode == RIG_OK) { retcode = rc; } \
+        rig_lock_preempt(rig); \
+    }
+
+    BULK_GET(RIG_BULK_FREQ_A, rig_get_freq(rig, RIG_VFO_A, &bulk->freqA));
+    BULK_GET(RIG_BULK_FREQ_B, rig_get_freq(rig, RIG_VFO_B, &bulk->freqB));
+    BULK_GET(RIG_BULK_MODE_A, rig_get_mode(rig, RIG_VFO_A, &bulk->modeA,
+                                           &bulk->widthA));
+    BULK_GET(RIG_BULK_MODE_B, rig_get_mode(rig, RIG_VFO_B, &bulk->modeB,
+                                           &bulk->widthB));
+    BULK_GET(RIG_BULK_PTT, rig_get_ptt(rig, RIG_VFO_CURR, &bulk->ptt));
+    BULK_GET(RIG_BULK_SPLIT, rig_get_split_vfo(rig, RIG_VFO_CURR, &bulk->split,
+             &bulk->split_vfo));
+    BULK_GET(RIG_BULK_STRENGTH, rig_get_level(rig, RIG_VFO_CURR,
+             RIG_LEVEL_STRENGTH, &bulk->strength));
+    BULK_GET(RIG_BULK_RFPOWER, rig_get_level(rig, RIG_VFO_CURR, RIG_LEVEL_RFPOWER,
+             &bulk->rfpower));
+    BULK_GET(RIG_BULK_SWR, rig_get_level(rig, RIG_VFO_CURR, RIG_LEVEL_SWR,
+                                         &bulk->swr));
+#undef BULK_GET
+
+    RETURNFUNC(retcode);
+}
+
+
 /**
  * \brief set the mode of the target VFO
  * \param rig   The rig handle
@@ -2178,6 +2530,8 @@ int HAMLIB_API rig_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
         RETURNFUNC2(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     rig_get_lock_mode(rig, &locked_mode);
     if (locked_mode) { return(RIG_OK); }
 
@@ -2190,6 +2544,17 @@ int HAMLIB_API rig_set_mode(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width)
 
     caps = rig->caps;
 
+    if (rig_queue_coalescing(rig) && caps->set_mode)
+    {
+        struct rig_request req = { .type = RIG_REQ_SET_MODE, .vfo = vfo, .mode = mode, .width = width };
+
+        if (mode != RIG_MODE_NONE) { rig_set_cache_mode(rig, vfo, mode, width); }
+
+        retcode = rig_queue_coalesce(rig, &req);
+        ELAPSED2;
+        RETURNFUNC2(retcode);
+    }
+
     if (caps->set_mode == NULL)
     {
         RETURNFUNC2(-RIG_ENAVAIL);
@@ -2296,6 +2661,7 @@ int HAMLIB_API rig_get_mode(RIG *rig,
                             rmode_t *mode,
                             pbwidth_t *width)
 {
+    struct rig_cache_snapshot snap;
     const struct rig_caps *caps;
     int retcode;
     freq_t freq;
@@ -2320,6 +2686,19 @@ int HAMLIB_API rig_get_mode(RIG *rig,
         RETURNFUNC(-RIG_ENAVAIL);
     }
 
+    rig_cache_snapshot(rig, vfo, &snap);
+
+    if (snap.mode_ok)
+    {
+        rig_stats_cache(rig, HAMLIB_CACHE_MODE, 1);
+        *mode = snap.mode;
+        *width = snap.width;
+        ELAPSED2;
+        RETURNFUNC(RIG_OK);
+    }
+
+    RIG_LOCK(rig);
+
     vfo = vfo_fixup(rig, vfo, rig->state.cache.split);
 
     *mode = RIG_MODE_NONE;
@@ -2333,8 +2712,9 @@ int HAMLIB_API rig_get_mode(RIG *rig,
     rig_cache_show(rig, __func__, __LINE__);
 
     if (rig->state.cache.timeout_ms == HAMLIB_CACHE_ALWAYS
-            || rig->state.use_cached_mode)
+            || rig_cache_pushed(rig, rig->state.use_cached_mode))
     {
+        rig_stats_cache(rig, HAMLIB_CACHE_MODE, 1);
         rig_debug(RIG_DEBUG_TRACE, "%s: cache hit age mode=%dms, width=%dms\n",
                   __func__, cache_ms_mode, cache_ms_width);
 
@@ -2342,9 +2722,13 @@ int HAMLIB_API rig_get_mode(RIG *rig,
         RETURNFUNC(RIG_OK);
     }
 
-    if ((*mode != RIG_MODE_NONE && cache_ms_mode < rig->state.cache.timeout_ms)
-            && cache_ms_width < rig->state.cache.timeout_ms)
+    int ttl_mode = rig_cache_ttl(rig, RIG_CACHE_SLOT_MODE,
+                                 *mode ^ ((uint64_t)*width << 40), cache_ms_mode);
+
+    if ((*mode != RIG_MODE_NONE && cache_ms_mode < ttl_mode)
+            && cache_ms_width < ttl_mode)
     {
+        rig_stats_cache(rig, HAMLIB_CACHE_MODE, 1);
         rig_debug(RIG_DEBUG_TRACE, "%s: cache hit age mode=%dms, width=%dms\n",
                   __func__, cache_ms_mode, cache_ms_width);
 
@@ -2353,16 +2737,36 @@ int HAMLIB_API rig_get_mode(RIG *rig,
     }
     else
     {
+        rig_stats_cache(rig, HAMLIB_CACHE_MODE, 0);
         rig_debug(RIG_DEBUG_TRACE, "%s: cache miss age mode=%dms, width=%dms\n",
                   __func__, cache_ms_mode, cache_ms_width);
     }
 
+    rmode_t cached_mode = *mode;
+    pbwidth_t cached_width = *width;
+
+    // past the caller's deadline the cache is the answer, however old
+    if (cached_mode != RIG_MODE_NONE && rig_deadline_cache())
+    {
+        ELAPSED2;
+        RETURNFUNC(RIG_OK);
+    }
+
     if ((caps->targetable_vfo & RIG_TARGETABLE_MODE)
             || vfo == RIG_VFO_CURR
             || vfo == rig->state.current_vfo)
     {
         TRACE;
         retcode = caps->get_mode(rig, vfo, mode, width);
+
+        if (retcode == -RIG_ETIMEOUT && cached_mode != RIG_MODE_NONE
+                && rig_deadline_cache())
+        {
+            *mode = cached_mode;
+            *width = cached_width;
+            ELAPSED2;
+            RETURNFUNC(RIG_OK);
+        }
         rig_debug(RIG_DEBUG_TRACE, "%s: retcode after get_mode=%d\n", __func__,
                   retcode);
         rig_cache_show(rig, __func__, __LINE__);
@@ -2402,6 +2806,12 @@ int HAMLIB_API rig_get_mode(RIG *rig,
         }
     }
 
+    if (retcode == RIG_OK)
+    {
+        rig_cache_push_check(rig, rig->state.use_cached_mode,
+                             *mode == cached_mode && *width == cached_width);
+    }
+
     if (retcode == RIG_OK
             && (vfo == RIG_VFO_CURR || vfo == rig->state.current_vfo))
     {
@@ -2440,7 +2850,8 @@ int HAMLIB_API rig_get_mode(RIG *rig,
 pbwidth_t HAMLIB_API rig_passband_normal(RIG *rig, rmode_t mode)
 {
     const struct rig_state *rs;
-    int i;
+    pbwidth_t width;
+    int i, found;
 
     ENTERFUNC;
 
@@ -2456,6 +2867,22 @@ pbwidth_t HAMLIB_API rig_passband_normal(RIG *rig, rmode_t mode)
 
     if (mode == RIG_MODE_RTTYR) { mode = RIG_MODE_RTTY; }
 
+    if (rig_caps_index_passband(rig, mode, RIG_CAPS_PB_NORMAL, &width,
+                                &found) == RIG_OK)
+    {
+        if (found)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%.*s%d:%s: return width=%d\n",
+                      rig->state.depth, spaces(), rig->state.depth, __func__, (int)width);
+            RETURNFUNC(width);
+        }
+
+        rig_debug(RIG_DEBUG_VERBOSE,
+                  "%s: filter not found...return RIG_PASSBAND_NORMAL=%d\n", __func__,
+                  (int)RIG_PASSBAND_NORMAL);
+        RETURNFUNC(RIG_PASSBAND_NORMAL);
+    }
+
     for (i = 0; i < HAMLIB_FLTLSTSIZ && rs->filters[i].modes; i++)
     {
         if (rs->filters[i].modes & mode)
@@ -2492,7 +2919,7 @@ pbwidth_t HAMLIB_API rig_passband_narrow(RIG *rig, rmode_t mode)
 {
     const struct rig_state *rs;
     pbwidth_t normal;
-    int i;
+    int i, found;
 
     ENTERFUNC;
 
@@ -2503,6 +2930,11 @@ pbwidth_t HAMLIB_API rig_passband_narrow(RIG *rig, rmode_t mode)
 
     rs = &rig->state;
 
+    if (rig_caps_index_passband(rig, mode, RIG_CAPS_PB_NARROW, &normal, &found) == RIG_OK)
+    {
+        RETURNFUNC(normal);
+    }
+
     for (i = 0; i < HAMLIB_FLTLSTSIZ - 1 && rs->filters[i].modes; i++)
     {
         if (rs->filters[i].modes & mode)
@@ -2544,7 +2976,7 @@ pbwidth_t HAMLIB_API rig_passband_wide(RIG *rig, rmode_t mode)
 {
     const struct rig_state *rs;
     pbwidth_t normal;
-    int i;
+    int i, found;
 
     ENTERFUNC;
 
@@ -2555,6 +2987,11 @@ pbwidth_t HAMLIB_API rig_passband_wide(RIG *rig, rmode_t mode)
 
     rs = &rig->state;
 
+    if (rig_caps_index_passband(rig, mode, RIG_CAPS_PB_WIDE, &normal, &found) == RIG_OK)
+    {
+        RETURNFUNC(normal);
+    }
+
     for (i = 0; i < HAMLIB_FLTLSTSIZ - 1 && rs->filters[i].modes; i++)
     {
         if (rs->filters[i].modes & mode)
@@ -2625,6 +3062,8 @@ int HAMLIB_API rig_set_vfo(RIG *rig, vfo_t vfo)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     vfo = vfo_fixup(rig, vfo, rig->state.cache.split);
 
     if (vfo == RIG_VFO_CURR) { RETURNFUNC(RIG_OK); }
@@ -2753,6 +3192,7 @@ int HAMLIB_API rig_set_vfo(RIG *rig, vfo_t vfo)
  */
 int HAMLIB_API rig_get_vfo(RIG *rig, vfo_t *vfo)
 {
+    struct rig_cache_snapshot snap;
     const struct rig_caps *caps;
     int retcode;
     int cache_ms;
@@ -2780,11 +3220,25 @@ int HAMLIB_API rig_get_vfo(RIG *rig, vfo_t *vfo)
         RETURNFUNC(-RIG_ENAVAIL);
     }
 
-    cache_ms = elapsed_ms(&rig->state.cache.time_vfo, HAMLIB_ELAPSED_GET);
+    rig_cache_snapshot(rig, RIG_VFO_CURR, &snap);
+
+    if (snap.vfo_ok)
+    {
+        rig_stats_cache(rig, HAMLIB_CACHE_VFO, 1);
+        *vfo = snap.vfo;
+        ELAPSED2;
+        RETURNFUNC(RIG_OK);
+    }
+
+    RIG_LOCK(rig);
+
+    cache_ms = rig_cache_age(rig, &rig->state.cache.time_vfo);
     rig_debug(RIG_DEBUG_TRACE, "%s: cache check age=%dms\n", __func__, cache_ms);
 
-    if (cache_ms < rig->state.cache.timeout_ms)
+    if (cache_ms < rig_cache_ttl(rig, RIG_CACHE_SLOT_VFO, rig->state.cache.vfo,
+                                 cache_ms))
     {
+        rig_stats_cache(rig, HAMLIB_CACHE_VFO, 1);
         rig_debug(RIG_DEBUG_TRACE, "%s: cache hit age=%dms\n", __func__, cache_ms);
         *vfo = rig->state.cache.vfo;
         ELAPSED2;
@@ -2792,6 +3246,7 @@ int HAMLIB_API rig_get_vfo(RIG *rig, vfo_t *vfo)
     }
     else
     {
+        rig_stats_cache(rig, HAMLIB_CACHE_VFO, 0);
         rig_debug(RIG_DEBUG_TRACE, "%s: cache miss age=%dms\n", __func__, cache_ms);
     }
 
@@ -2820,37 +3275,73 @@ int HAMLIB_API rig_get_vfo(RIG *rig, vfo_t *vfo)
 }
 
 
+static int rig_set_ptt_slow(RIG *rig, vfo_t vfo, ptt_t ptt);
+
+struct ptt_verify
+{
+    struct rig_request req;     /* first, the callback gets its address */
+    ptt_t ptt;                  /* what rig_set_ptt_fast() asked for */
+};
+
+static void rig_ptt_verify_cb(RIG *rig, struct rig_request *req,
+                              rig_ptr_t arg)
+{
+    struct ptt_verify *v = (struct ptt_verify *) req;
+
+    if (req->retcode != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: reading PTT back failed: %s\n", __func__,
+                  rigerror(req->retcode));
+    }
+    else if ((req->ptt != RIG_PTT_OFF) != (v->ptt != RIG_PTT_OFF))
+    {
+        /* rig_get_ptt() has put what the rig says in the cache */
+        rig_debug(RIG_DEBUG_WARN, "%s: PTT set to %d, rig reports %d\n", __func__,
+                  v->ptt, req->ptt);
+    }
+
+    free(v);
+}
+
+
 /**
- * \brief set PTT on/off
+ * \brief set PTT on/off with as little as possible in the way
  * \param rig   The rig handle
- * \param vfo   The target VFO
  * \param ptt   The PTT status to set to
  *
- *  Sets "Push-To-Talk" on/off.
+ *  Switches PTT for time critical callers, e.g. FT8 slots or remote CW.
+ *  A PTT line is set with a single call on the already open port.
+ *  CAT PTT goes straight to the backend's set_ptt on the current VFO,
+ *  without the VFO switching and settle delays of rig_set_ptt().  The PTT
+ *  cache is updated before returning.
+ *
+ *  PTT is not read back here.  When the application queues its rig I/O
+ *  with rig_submit(), a read back of CAT PTT is queued behind, and a rig
+ *  that did not follow is logged and corrects the cache.
+ *
+ *  A serial PTT port that is not open yet, or shared with ptt_share, is
+ *  handed to rig_set_ptt(), which knows how to open and release it.
  *
  * \return RIG_OK if the operation has been successful, otherwise
  * a negative value if an error occurred (in which case, cause is
  * set appropriately).
  *
- * \sa rig_get_ptt()
+ * \sa rig_set_ptt(), rig_submit()
  */
-int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
+int HAMLIB_API rig_set_ptt_fast(RIG *rig, ptt_t ptt)
 {
-    const struct rig_caps *caps;
-    struct rig_state *rs = &rig->state;
-    int retcode = RIG_OK;
-
-    ELAPSED1;
-    ENTERFUNC;
+    struct rig_state *rs;
+    int retcode;
+    int cat = 0;
 
     if (CHECK_RIG_ARG(rig))
     {
-        RETURNFUNC(-RIG_EINVAL);
+        return -RIG_EINVAL;
     }
 
-    caps = rig->caps;
+    rs = &rig->state;
 
-    switch (rig->state.pttport.type.ptt)
+    switch (rs->pttport.type.ptt)
     {
     case RIG_PTT_RIG:
         if (ptt == RIG_PTT_ON_MIC || ptt == RIG_PTT_ON_DATA)
@@ -2860,24 +3351,165 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 
     /* fall through */
     case RIG_PTT_RIG_MICDATA:
-        if (caps->set_ptt == NULL)
+        if (rig->caps->set_ptt == NULL)
         {
-            RETURNFUNC(-RIG_ENIMPL);
+            return -RIG_ENIMPL;
         }
 
-        if ((caps->targetable_vfo & RIG_TARGETABLE_PTT)
-                || vfo == RIG_VFO_CURR
-                || vfo == rig->state.current_vfo)
         {
-            int retry = 3;
-            ptt_t tptt;
-
-            do
-            {
-                TRACE;
-                retcode = caps->set_ptt(rig, vfo, ptt);
+            // only CAT keying waits for the rig, the lines do not
+            RIG_LOCK_PRIO(rig, ptt == RIG_PTT_OFF ? RIG_PRIO_SAFETY : RIG_PRIO_SET);
+            retcode = rig->caps->set_ptt(rig, RIG_VFO_CURR, ptt);
+        }
 
-                if (retcode != RIG_OK) { RETURNFUNC(retcode); }
+        cat = 1;
+        break;
+
+    case RIG_PTT_SERIAL_DTR:
+    case RIG_PTT_SERIAL_RTS:
+        if (rs->pttport.fd < 0
+                || (rs->ptt_share && strcmp(rs->pttport.pathname, rs->rigport.pathname)))
+        {
+            return rig_set_ptt_slow(rig, RIG_VFO_CURR, ptt);
+        }
+
+        if (rs->pttport.type.ptt == RIG_PTT_SERIAL_DTR)
+        {
+            retcode = ser_set_dtr(&rs->pttport, ptt != RIG_PTT_OFF);
+        }
+        else
+        {
+            retcode = ser_set_rts(&rs->pttport, ptt != RIG_PTT_OFF);
+        }
+
+        break;
+
+    case RIG_PTT_PARALLEL:
+        retcode = par_ptt_set(&rs->pttport, ptt);
+        break;
+
+    case RIG_PTT_CM108:
+        retcode = cm108_ptt_set(&rs->pttport, ptt);
+        break;
+
+    case RIG_PTT_GPIO:
+    case RIG_PTT_GPION:
+        retcode = gpio_ptt_set(&rs->pttport, ptt);
+        break;
+
+    case RIG_PTT_NONE:
+        return -RIG_ENAVAIL;
+
+    default:
+        return -RIG_EINVAL;
+    }
+
+    if (retcode != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: return code=%d\n", __func__, retcode);
+        return retcode;
+    }
+
+    rs->transmit = ptt != RIG_PTT_OFF;
+
+    rig_cache_write_begin(rig);
+    rs->cache.ptt = ptt;
+    elapsed_ms(&rs->cache.time_ptt, HAMLIB_ELAPSED_SET);
+    rig_cache_write_end(rig);
+
+    /* only behind rig_submit(), whose thread owns the port */
+    if (cat && rs->submit_queue && rig->caps->get_ptt)
+    {
+        struct ptt_verify *v = calloc(1, sizeof(*v));
+
+        if (v)
+        {
+            v->req.type = RIG_REQ_VERIFY_PTT;
+            v->req.vfo = RIG_VFO_CURR;
+            v->ptt = ptt;
+
+            if (rig_submit(rig, &v->req, rig_ptt_verify_cb, NULL) != RIG_OK)
+            {
+                free(v);
+            }
+        }
+    }
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief set PTT on/off
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param ptt   The PTT status to set to
+ *
+ *  Sets "Push-To-Talk" on/off.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa rig_get_ptt()
+ */
+int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
+{
+    if (CHECK_RIG_ARG(rig))
+    {
+        return -RIG_EINVAL;
+    }
+
+    RIG_LOCK_PRIO(rig, ptt == RIG_PTT_OFF ? RIG_PRIO_SAFETY : RIG_PRIO_SET);
+
+    if (rig->state.ptt_fast)
+    {
+        return rig_set_ptt_fast(rig, ptt);
+    }
+
+    return rig_set_ptt_slow(rig, vfo, ptt);
+}
+
+
+static int rig_set_ptt_slow(RIG *rig, vfo_t vfo, ptt_t ptt)
+{
+    const struct rig_caps *caps;
+    struct rig_state *rs = &rig->state;
+    int retcode = RIG_OK;
+
+    ELAPSED1;
+    ENTERFUNC;
+
+    caps = rig->caps;
+
+    switch (rig->state.pttport.type.ptt)
+    {
+    case RIG_PTT_RIG:
+        if (ptt == RIG_PTT_ON_MIC || ptt == RIG_PTT_ON_DATA)
+        {
+            ptt = RIG_PTT_ON;
+        }
+
+    /* fall through */
+    case RIG_PTT_RIG_MICDATA:
+        if (caps->set_ptt == NULL)
+        {
+            RETURNFUNC(-RIG_ENIMPL);
+        }
+
+        if ((caps->targetable_vfo & RIG_TARGETABLE_PTT)
+                || vfo == RIG_VFO_CURR
+                || vfo == rig->state.current_vfo)
+        {
+            int retry = 3;
+            ptt_t tptt;
+
+            do
+            {
+                TRACE;
+                retcode = caps->set_ptt(rig, vfo, ptt);
+
+                if (retcode != RIG_OK) { RETURNFUNC(retcode); }
 
 #if 0
                 hl_usleep(50 * 1000); // give PTT a chance to do it's thing
@@ -3101,8 +3733,10 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
     // is requested on a rig that can't change freq on a transmitting VFO
     if (ptt != RIG_PTT_ON) { hl_usleep(50 * 1000); }
 
+    rig_cache_write_begin(rig);
     rig->state.cache.ptt = ptt;
     elapsed_ms(&rig->state.cache.time_ptt, HAMLIB_ELAPSED_SET);
+    rig_cache_write_end(rig);
 
     if (retcode != RIG_OK) { rig_debug(RIG_DEBUG_ERR, "%s: return code=%d\n", __func__, retcode); }
 
@@ -3114,6 +3748,69 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
 }
 
 
+/**
+ * \brief switch several GPIO lines of the PTT port at once
+ * \param rig   The rig handle
+ * \param mask  The lines to change, bit 0 is PTT itself
+ * \param bits  The new values of the lines in \a mask
+ *
+ *  A GPIO PTT port opened from a gpiochip, e.g. "/dev/gpiochip0:17,5,6",
+ *  holds all the lines listed in its pathname.  Bit n of \a mask and \a bits
+ *  stands for the line in position n, so band select outputs and PTT can be
+ *  switched in a single operation, without a band decoder ever seeing a
+ *  half-written band.  PTT keeps its GPION inversion, the other lines are
+ *  driven as given.
+ *
+ * \return RIG_OK if the operation has been successful, -RIG_ENAVAIL if the
+ * PTT port is not a gpiochip, otherwise a negative value if an error
+ * occurred (in which case, cause is set appropriately).
+ *
+ * \sa rig_set_ptt()
+ */
+int HAMLIB_API rig_set_gpio_lines(RIG *rig, unsigned int mask,
+                                  unsigned int bits)
+{
+    struct rig_state *rs;
+    int retcode;
+
+    ENTERFUNC;
+
+    if (CHECK_RIG_ARG(rig))
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
+    rs = &rig->state;
+
+    if (rs->pttport.type.ptt != RIG_PTT_GPIO
+            && rs->pttport.type.ptt != RIG_PTT_GPION)
+    {
+        RETURNFUNC(-RIG_ENAVAIL);
+    }
+
+    retcode = gpio_set_lines(&rs->pttport, mask, bits);
+
+    if (retcode == RIG_OK && (mask & 1))
+    {
+        ptt_t ptt = bits & 1 ? RIG_PTT_ON : RIG_PTT_OFF;
+
+        rs->transmit = ptt != RIG_PTT_OFF;
+
+        rig_cache_write_begin(rig);
+        rs->cache.ptt = ptt;
+        elapsed_ms(&rs->cache.time_ptt, HAMLIB_ELAPSED_SET);
+        rig_cache_write_end(rig);
+
+        memcpy(&rs->pttport_deprecated, &rs->pttport,
+               sizeof(rs->pttport_deprecated));
+    }
+
+    RETURNFUNC(retcode);
+}
+
+
 /**
  * \brief get the status of the PTT
  * \param rig   The rig handle
@@ -3130,6 +3827,7 @@ int HAMLIB_API rig_set_ptt(RIG *rig, vfo_t vfo, ptt_t ptt)
  */
 int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
 {
+    struct rig_cache_snapshot snap;
     const struct rig_caps *caps;
     struct rig_state *rs = &rig->state;
     int retcode = RIG_OK;
@@ -3152,11 +3850,26 @@ int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
         RETURNFUNC(-RIG_EINVAL);
     }
 
-    cache_ms = elapsed_ms(&rig->state.cache.time_ptt, HAMLIB_ELAPSED_GET);
+    rig_cache_snapshot(rig, vfo, &snap);
+
+    if (snap.ptt_ok)
+    {
+        rig_stats_cache(rig, HAMLIB_CACHE_PTT, 1);
+        *ptt = snap.ptt;
+        ELAPSED2;
+        RETURNFUNC(RIG_OK);
+    }
+
+    RIG_LOCK(rig);
+
+    cache_ms = rig_cache_age(rig, &rig->state.cache.time_ptt);
     rig_debug(RIG_DEBUG_TRACE, "%s: cache check age=%dms\n", __func__, cache_ms);
 
-    if (cache_ms < rig->state.cache.timeout_ms)
+    if (cache_ms < rig_cache_ttl(rig, RIG_CACHE_SLOT_PTT, rig->state.cache.ptt,
+                                 cache_ms)
+            || rig_cache_pushed(rig, rs->use_cached_ptt))
     {
+        rig_stats_cache(rig, HAMLIB_CACHE_PTT, 1);
         rig_debug(RIG_DEBUG_TRACE, "%s: cache hit age=%dms\n", __func__, cache_ms);
         *ptt = rig->state.cache.ptt;
         ELAPSED2;
@@ -3164,6 +3877,7 @@ int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
     }
     else
     {
+        rig_stats_cache(rig, HAMLIB_CACHE_PTT, 0);
         rig_debug(RIG_DEBUG_TRACE, "%s: cache miss age=%dms\n", __func__, cache_ms);
     }
 
@@ -3184,13 +3898,34 @@ int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
                 || vfo == RIG_VFO_CURR
                 || vfo == rig->state.current_vfo)
         {
+            ptt_t cached_ptt = rs->cache.ptt;
+            // past the caller's deadline the cache is the answer, however old
+            int cached = rs->cache.time_ptt.tv_sec != 0;
+
+            if (cached && rig_deadline_cache())
+            {
+                *ptt = cached_ptt;
+                ELAPSED2;
+                RETURNFUNC(RIG_OK);
+            }
+
             TRACE;
             retcode = caps->get_ptt(rig, vfo, ptt);
 
+            if (retcode == -RIG_ETIMEOUT && cached && rig_deadline_cache())
+            {
+                *ptt = cached_ptt;
+                ELAPSED2;
+                RETURNFUNC(RIG_OK);
+            }
+
             if (retcode == RIG_OK)
             {
+                rig_cache_push_check(rig, rs->use_cached_ptt, *ptt == cached_ptt);
+                rig_cache_write_begin(rig);
                 rig->state.cache.ptt = *ptt;
                 elapsed_ms(&rig->state.cache.time_ptt, HAMLIB_ELAPSED_SET);
+                rig_cache_write_end(rig);
             }
 
             ELAPSED2;
@@ -3238,8 +3973,10 @@ int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
             {
                 /* return the first error code */
                 retcode = rc2;
+                rig_cache_write_begin(rig);
                 rig->state.cache.ptt = *ptt;
                 elapsed_ms(&rig->state.cache.time_ptt, HAMLIB_ELAPSED_SET);
+                rig_cache_write_end(rig);
             }
         }
 
@@ -3274,8 +4011,10 @@ int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
             *ptt = status ? RIG_PTT_ON : RIG_PTT_OFF;
         }
 
+        rig_cache_write_begin(rig);
         rig->state.cache.ptt = *ptt;
         elapsed_ms(&rig->state.cache.time_ptt, HAMLIB_ELAPSED_SET);
+        rig_cache_write_end(rig);
         ELAPSED2;
         RETURNFUNC(retcode);
 
@@ -3307,8 +4046,10 @@ int HAMLIB_API rig_get_ptt(RIG *rig, vfo_t vfo, ptt_t *ptt)
             *ptt = status ? RIG_PTT_ON : RIG_PTT_OFF;
         }
 
+        rig_cache_write_begin(rig);
         rig->state.cache.ptt = *ptt;
         elapsed_ms(&rig->state.cache.time_ptt, HAMLIB_ELAPSED_SET);
+        rig_cache_write_end(rig);
         ELAPSED2;
         RETURNFUNC(retcode);
 
@@ -3424,6 +4165,8 @@ int HAMLIB_API rig_get_dcd(RIG *rig, vfo_t vfo, dcd_t *dcd)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (!dcd)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -3506,11 +4249,25 @@ int HAMLIB_API rig_get_dcd(RIG *rig, vfo_t vfo, dcd_t *dcd)
 
     case RIG_DCD_GPIO:
     case RIG_DCD_GPION:
+        if (dcd_watch_get(rig, dcd) == RIG_OK)
+        {
+            RETURNFUNC(RIG_OK);
+        }
+
         retcode = gpio_dcd_get(&rig->state.dcdport, dcd);
         memcpy(&rig->state.dcdport_deprecated, &rig->state.dcdport,
                sizeof(rig->state.dcdport_deprecated));
         RETURNFUNC(retcode);
 
+    case RIG_DCD_CM108:
+        if (dcd_watch_get(rig, dcd) == RIG_OK)
+        {
+            RETURNFUNC(RIG_OK);
+        }
+
+        /* the CM108 only reports the pin by interrupt */
+        RETURNFUNC(-RIG_ENAVAIL);
+
     case RIG_DCD_NONE:
         RETURNFUNC(-RIG_ENAVAIL);    /* not available */
 
@@ -3549,6 +4306,8 @@ int HAMLIB_API rig_set_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t rptr_shift)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     caps = rig->caps;
 
     if (caps->set_rptr_shift == NULL)
@@ -3620,6 +4379,8 @@ int HAMLIB_API rig_get_rptr_shift(RIG *rig, vfo_t vfo, rptr_shift_t *rptr_shift)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (!rptr_shift)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -3696,6 +4457,8 @@ int HAMLIB_API rig_set_rptr_offs(RIG *rig, vfo_t vfo, shortfreq_t rptr_offs)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     caps = rig->caps;
 
     if (caps->set_rptr_offs == NULL)
@@ -3766,6 +4529,8 @@ int HAMLIB_API rig_get_rptr_offs(RIG *rig, vfo_t vfo, shortfreq_t *rptr_offs)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (!rptr_offs)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -3842,6 +4607,8 @@ int HAMLIB_API rig_set_split_freq(RIG *rig, vfo_t vfo, freq_t tx_freq)
         RETURNFUNC2(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called vfo=%s, curr_vfo=%s, tx_freq=%.0f\n",
               __func__,
@@ -4007,6 +4774,8 @@ int HAMLIB_API rig_get_split_freq(RIG *rig, vfo_t vfo, freq_t *tx_freq)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (!tx_freq)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -4040,7 +4809,10 @@ int HAMLIB_API rig_get_split_freq(RIG *rig, vfo_t vfo, freq_t *tx_freq)
         tx_vfo = vfo;
     }
 
-    if (caps->get_freq && (caps->targetable_vfo & RIG_TARGETABLE_FREQ))
+    // the TX VFO may be the current one, e.g. when split is off
+    if (caps->get_freq
+            && vfo_plan(rig, tx_vfo, RIG_TARGETABLE_FREQ,
+                        "get_split_freq") != RIG_VFO_PLAN_SWAP)
     {
         TRACE;
         retcode = caps->get_freq(rig, tx_vfo, tx_freq);
@@ -4162,6 +4934,8 @@ int HAMLIB_API rig_set_split_mode(RIG *rig,
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     // we check both VFOs are in the same tx mode -- then we can ignore
     // this could be make more intelligent but this should cover all cases where we can skip this
     if (tx_mode == rig->state.cache.modeMainA && tx_mode == rig->state.cache.modeMainB)
@@ -4188,7 +4962,7 @@ int HAMLIB_API rig_set_split_mode(RIG *rig,
             && (vfo == RIG_VFO_CURR
                 || vfo == RIG_VFO_TX
                 || vfo == rig->state.current_vfo
-                || rig->caps->rig_model == RIG_MODEL_NETRIGCTL))
+                || RIG_MODEL_IS_NETRIGCTL(rig->caps->rig_model)))
     {
         TRACE;
         retcode = caps->set_split_mode(rig, vfo, tx_mode, tx_width);
@@ -4215,8 +4989,9 @@ int HAMLIB_API rig_set_split_mode(RIG *rig,
     rig_debug(RIG_DEBUG_VERBOSE, "%s: curr_vfo=%s, tx_vfo=%s\n", __func__,
               rig_strvfo(curr_vfo), rig_strvfo(tx_vfo));
 
-    if (caps->set_mode && ((caps->targetable_vfo & RIG_TARGETABLE_MODE)
-                           || (rig->caps->rig_model == RIG_MODEL_NETRIGCTL)))
+    if (caps->set_mode && (RIG_MODEL_IS_NETRIGCTL(rig->caps->rig_model)
+                           || vfo_plan(rig, tx_vfo, RIG_TARGETABLE_MODE,
+                                       "set_split_mode") != RIG_VFO_PLAN_SWAP))
     {
         TRACE;
         retcode = caps->set_mode(rig, tx_vfo, tx_mode, tx_width);
@@ -4263,7 +5038,7 @@ int HAMLIB_API rig_set_split_mode(RIG *rig,
     }
 
     // code below here should be dead code now -- but maybe we have  VFO situatiuon we need to handle
-    if (caps->rig_model == RIG_MODEL_NETRIGCTL)
+    if (RIG_MODEL_IS_NETRIGCTL(caps->rig_model))
     {
         // special handlingt for netrigctl to avoid set_vfo
         retcode = caps->set_split_mode(rig, vfo, tx_mode, tx_width);
@@ -4371,6 +5146,8 @@ int HAMLIB_API rig_get_split_mode(RIG *rig, vfo_t vfo, rmode_t *tx_mode,
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (!tx_mode || !tx_width)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -4509,6 +5286,8 @@ int HAMLIB_API rig_set_split_freq_mode(RIG *rig,
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     caps = rig->caps;
 
     // if split is off we'll turn it on
@@ -4568,12 +5347,32 @@ int HAMLIB_API rig_set_split_freq_mode(RIG *rig,
         ELAPSED2;
         RETURNFUNC(retcode);
     }
-    else
+
+    // when the TX VFO takes both directly, skip the backend split helpers
+    // which may swap VFOs or toggle split around the mode change
+    if (caps->set_freq && caps->set_mode
+            && vfo_plan(rig, vfo, RIG_TARGETABLE_FREQ,
+                        "set_split_freq_mode") != RIG_VFO_PLAN_SWAP
+            && vfo_plan(rig, vfo, RIG_TARGETABLE_MODE,
+                        "set_split_freq_mode") != RIG_VFO_PLAN_SWAP)
     {
         TRACE;
-        retcode = rig_set_split_freq(rig, vfo, tx_freq);
+        retcode = rig_set_freq(rig, vfo, tx_freq);
+
+        // do not mess with mode while PTT is on
+        if (RIG_OK == retcode && !rig->state.cache.ptt)
+        {
+            TRACE;
+            retcode = rig_set_mode(rig, vfo, tx_mode, tx_width);
+        }
+
+        ELAPSED2;
+        RETURNFUNC(retcode);
     }
 
+    TRACE;
+    retcode = rig_set_split_freq(rig, vfo, tx_freq);
+
     if (RIG_OK == retcode)
     {
         TRACE;
@@ -4627,6 +5426,8 @@ int HAMLIB_API rig_get_split_freq_mode(RIG *rig,
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (!tx_freq || !tx_mode || !tx_width)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -4690,6 +5491,8 @@ int HAMLIB_API rig_set_split_vfo(RIG *rig,
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     caps = rig->caps;
 
     if (caps->set_split_vfo == NULL)
@@ -4734,7 +5537,7 @@ int HAMLIB_API rig_set_split_vfo(RIG *rig,
     TRACE;
 
     if ((!(caps->targetable_vfo & RIG_TARGETABLE_FREQ))
-            && (!(rig->caps->rig_model == RIG_MODEL_NETRIGCTL)))
+            && (!RIG_MODEL_IS_NETRIGCTL(rig->caps->rig_model)))
 #if BUILTINFUNC
         rig_set_vfo(rig, rx_vfo == RIG_VFO_B ? RIG_VFO_B : RIG_VFO_A,
                     __builtin_FUNCTION());
@@ -4762,9 +5565,11 @@ int HAMLIB_API rig_set_split_vfo(RIG *rig,
             rig->state.tx_vfo = tx_vfo;
         }
 
+        rig_cache_write_begin(rig);
         rig->state.cache.split = split;
         rig->state.cache.split_vfo = tx_vfo;
         elapsed_ms(&rig->state.cache.time_split, HAMLIB_ELAPSED_SET);
+        rig_cache_write_end(rig);
         ELAPSED2;
         RETURNFUNC(retcode);
     }
@@ -4807,9 +5612,11 @@ int HAMLIB_API rig_set_split_vfo(RIG *rig,
         rig->state.tx_vfo = tx_vfo;
     }
 
+    rig_cache_write_begin(rig);
     rig->state.cache.split = split;
     rig->state.cache.split_vfo = tx_vfo;
     elapsed_ms(&rig->state.cache.time_split, HAMLIB_ELAPSED_SET);
+    rig_cache_write_end(rig);
     ELAPSED2;
     RETURNFUNC(retcode);
 }
@@ -4835,6 +5642,7 @@ int HAMLIB_API rig_get_split_vfo(RIG *rig,
                                  split_t *split,
                                  vfo_t *tx_vfo)
 {
+    struct rig_cache_snapshot snap;
     const struct rig_caps *caps;
 #if 0
     int retcode, rc2;
@@ -4875,13 +5683,29 @@ int HAMLIB_API rig_get_split_vfo(RIG *rig,
         RETURNFUNC(RIG_OK);
     }
 
-    cache_ms = elapsed_ms(&rig->state.cache.time_split, HAMLIB_ELAPSED_GET);
+    rig_cache_snapshot(rig, vfo, &snap);
+
+    if (snap.split_ok)
+    {
+        rig_stats_cache(rig, HAMLIB_CACHE_SPLIT, 1);
+        *split = snap.split;
+        *tx_vfo = snap.tx_vfo;
+        ELAPSED2;
+        RETURNFUNC(RIG_OK);
+    }
+
+    RIG_LOCK(rig);
+
+    cache_ms = rig_cache_age(rig, &rig->state.cache.time_split);
     rig_debug(RIG_DEBUG_TRACE, "%s: cache check age=%dms\n", __func__, cache_ms);
 
-    if (cache_ms < rig->state.cache.timeout_ms)
+    if (cache_ms < rig_cache_ttl(rig, RIG_CACHE_SLOT_SPLIT,
+                                 ((uint64_t)rig->state.cache.split_vfo << 8) | rig->state.cache.split,
+                                 cache_ms))
     {
         *split = rig->state.cache.split;
         *tx_vfo = rig->state.cache.split_vfo;
+        rig_stats_cache(rig, HAMLIB_CACHE_SPLIT, 1);
         rig_debug(RIG_DEBUG_TRACE, "%s: cache hit age=%dms, split=%d, tx_vfo=%s\n",
                   __func__, cache_ms, *split, rig_strvfo(*tx_vfo));
         ELAPSED2;
@@ -4889,6 +5713,7 @@ int HAMLIB_API rig_get_split_vfo(RIG *rig,
     }
     else
     {
+        rig_stats_cache(rig, HAMLIB_CACHE_SPLIT, 0);
         rig_debug(RIG_DEBUG_TRACE, "%s: cache miss age=%dms\n", __func__, cache_ms);
     }
 
@@ -4904,9 +5729,11 @@ int HAMLIB_API rig_get_split_vfo(RIG *rig,
         {
             // rigctld doesn't like nested calls
             retcode = caps->get_split_vfo(rig, vfo, split, tx_vfo);
+            rig_cache_write_begin(rig);
             rig->state.cache.split = *split;
             rig->state.cache.split_vfo = *tx_vfo;
             elapsed_ms(&rig->state.cache.time_split, HAMLIB_ELAPSED_SET);
+            rig_cache_write_end(rig);
             rig_debug(RIG_DEBUG_TRACE, "%s: cache.split=%d\n", __func__,
                       rig->state.cache.split);
         }
@@ -4946,9 +5773,11 @@ int HAMLIB_API rig_get_split_vfo(RIG *rig,
 
     if (retcode == RIG_OK)  // only update cache on success
     {
+        rig_cache_write_begin(rig);
         rig->state.cache.split = *split;
         rig->state.cache.split_vfo = *tx_vfo;
         elapsed_ms(&rig->state.cache.time_split, HAMLIB_ELAPSED_SET);
+        rig_cache_write_end(rig);
         rig_debug(RIG_DEBUG_TRACE, "%s(%d): cache.split=%d\n", __func__, __LINE__,
                   rig->state.cache.split);
     }
@@ -4985,6 +5814,8 @@ int HAMLIB_API rig_set_rit(RIG *rig, vfo_t vfo, shortfreq_t rit)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     caps = rig->caps;
 
     if (caps->set_rit == NULL)
@@ -5056,6 +5887,8 @@ int HAMLIB_API rig_get_rit(RIG *rig, vfo_t vfo, shortfreq_t *rit)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (!rit)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -5133,6 +5966,8 @@ int HAMLIB_API rig_set_xit(RIG *rig, vfo_t vfo, shortfreq_t xit)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     caps = rig->caps;
 
     if (caps->set_xit == NULL)
@@ -5204,6 +6039,8 @@ int HAMLIB_API rig_get_xit(RIG *rig, vfo_t vfo, shortfreq_t *xit)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (!xit)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -5281,6 +6118,8 @@ int HAMLIB_API rig_set_ts(RIG *rig, vfo_t vfo, shortfreq_t ts)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     caps = rig->caps;
 
     if (caps->set_ts == NULL)
@@ -5352,6 +6191,8 @@ int HAMLIB_API rig_get_ts(RIG *rig, vfo_t vfo, shortfreq_t *ts)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (!ts)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -5433,6 +6274,8 @@ int HAMLIB_API rig_set_ant(RIG *rig, vfo_t vfo, ant_t ant, value_t option)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     caps = rig->caps;
 
     if (caps->set_ant == NULL)
@@ -5513,6 +6356,8 @@ int HAMLIB_API rig_get_ant(RIG *rig, vfo_t vfo, ant_t ant, value_t *option,
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (ant_curr == NULL || ant_tx == NULL || ant_rx == NULL)
     {
         rig_debug(RIG_DEBUG_ERR,
@@ -5606,12 +6451,17 @@ int HAMLIB_API rig_power2mW(RIG *rig,
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (rig->caps->power2mW != NULL)
     {
         RETURNFUNC(rig->caps->power2mW(rig, mwpower, power, freq, mode));
     }
 
-    txrange = rig_get_range(rig->state.tx_range_list, freq, mode);
+    if (rig_caps_index_range(rig, 1, freq, mode, &txrange) != RIG_OK)
+    {
+        txrange = rig_get_range(rig->state.tx_range_list, freq, mode);
+    }
 
     if (!txrange)
     {
@@ -5660,12 +6510,17 @@ int HAMLIB_API rig_mW2power(RIG *rig,
         RETURNFUNC2(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (rig->caps->mW2power != NULL)
     {
         RETURNFUNC2(rig->caps->mW2power(rig, power, mwpower, freq, mode));
     }
 
-    txrange = rig_get_range(rig->state.tx_range_list, freq, mode);
+    if (rig_caps_index_range(rig, 1, freq, mode, &txrange) != RIG_OK)
+    {
+        txrange = rig_get_range(rig->state.tx_range_list, freq, mode);
+    }
 
     if (!txrange)
     {
@@ -5706,6 +6561,7 @@ int HAMLIB_API rig_mW2power(RIG *rig,
 shortfreq_t HAMLIB_API rig_get_resolution(RIG *rig, rmode_t mode)
 {
     const struct rig_state *rs;
+    shortfreq_t ts;
     int i;
 
     ENTERFUNC;
@@ -5717,6 +6573,11 @@ shortfreq_t HAMLIB_API rig_get_resolution(RIG *rig, rmode_t mode)
 
     rs = &rig->state;
 
+    if (rig_caps_index_resolution(rig, mode, &ts) == RIG_OK)
+    {
+        RETURNFUNC(ts);
+    }
+
     for (i = 0; i < HAMLIB_TSLSTSIZ && rs->tuning_steps[i].ts; i++)
     {
         if (rs->tuning_steps[i].modes & mode)
@@ -5755,6 +6616,8 @@ int HAMLIB_API rig_set_powerstat(RIG *rig, powerstat_t status)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     if (rig->caps->set_powerstat == NULL)
     {
         rig_debug(RIG_DEBUG_WARN, "%s set_powerstat not implemented\n", __func__);
@@ -5793,6 +6656,8 @@ int HAMLIB_API rig_get_powerstat(RIG *rig, powerstat_t *status)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (!status)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -5834,6 +6699,8 @@ int HAMLIB_API rig_reset(RIG *rig, reset_t reset)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     if (rig->caps->reset == NULL)
     {
         RETURNFUNC(-RIG_ENAVAIL);
@@ -5850,6 +6717,10 @@ extern int rig_probe_first(hamlib_port_t *p);
 extern int rig_probe_all_backends(hamlib_port_t *p,
                                   rig_probe_func_t cfunc,
                                   rig_ptr_t data);
+
+extern rig_model_t rig_probe_port(hamlib_port_t *p,
+                                  rig_probe_func_t cfunc,
+                                  rig_ptr_t data);
 //! @endcond
 
 
@@ -5859,7 +6730,8 @@ extern int rig_probe_all_backends(hamlib_port_t *p,
  *
  *  Try to guess what is the model of the first rig attached to the port.
  *  It can be very buggy, and mess up the radio at the other end.
- *  (but fun if it works!)
+ *  (but fun if it works!)  A USB port whose descriptors name the rig is
+ *  answered from them without any I/O, see rig_usb_identify_port().
  *
  * \warning this is really Experimental, It has been tested only
  * with IC-706MkIIG. any feedback welcome! --SF
@@ -5908,32 +6780,188 @@ int HAMLIB_API rig_probe_all(hamlib_port_t *port,
 }
 
 
-/**
- * \brief check retrieval ability of VFO operations
- * \param rig   The rig handle
- * \param op    The VFO op
- *
- *  Checks if a rig is capable of executing a VFO operation.
- *  Since the \a op is an OR'ed bitmap argument, more than
- *  one op can be checked at the same time.
- *
- *  EXAMPLE: if (rig_has_vfo_op(my_rig, RIG_OP_CPY)) disp_VFOcpy_btn();
- *
- * \return a bit map mask of supported op settings that can be retrieved,
- * otherwise 0 if none supported.
- *
- * \sa rig_vfo_op()
- */
-vfo_op_t HAMLIB_API rig_has_vfo_op(RIG *rig, vfo_op_t op)
+//! @cond Doxygen_Suppress
+struct rig_probe_port_arg
 {
-    int retcode;
+    hamlib_port_t *port;
+    rig_probe_func_t cfunc;
+    rig_ptr_t data;
+    rig_model_t model;
+};
 
-    ENTERFUNC;
+#ifdef HAVE_PTHREAD
+static pthread_mutex_t rig_probe_mutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+/* backends report from the port threads, the caller sees one at a time */
+static int rig_probe_port_found(const hamlib_port_t *port, rig_model_t model,
+                                rig_ptr_t data)
+{
+    struct rig_probe_port_arg *arg = data;
+    int ret = RIG_OK;
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_lock(&rig_probe_mutex);
+#endif
+
+    if (arg->cfunc)
+    {
+        ret = (*arg->cfunc)(port, model, arg->data);
+    }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_unlock(&rig_probe_mutex);
+#endif
+
+    return ret;
+}
+
+static void *rig_probe_port_thread(void *data)
+{
+    struct rig_probe_port_arg *arg = data;
+
+    arg->model = rig_probe_port(arg->port, rig_probe_port_found, arg);
+
+    return NULL;
+}
+//! @endcond
+
+
+/**
+ * \brief try to guess the rigs on several ports at once
+ * \param ports An array of ports linking the host to the rigs
+ * \param count Number of ports in the array
+ * \param cfunc Function to be called each time a rig is found
+ * \param data  Arbitrary data passed to cfunc
+ *
+ *  Probes every port from a thread of its own, so the time taken is that
+ *  of the slowest port rather than the sum of all of them.  On each port
+ *  the backends are tried in order of likelihood and probing stops at the
+ *  first that recognises the rig.  cfunc is never called concurrently.
+ *  Ports whose USB descriptors name the rig are reported at once and the
+ *  data ports of such rigs skipped, see rig_usb_identify_port().
+ *
+ * \warning Experimental, see rig_probe_all().
+ *
+ * \return the number of ports a rig was found on, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ */
+int HAMLIB_API rig_probe_all_ports(hamlib_port_t ports[],
+                                   int count,
+                                   rig_probe_func_t cfunc,
+                                   rig_ptr_t data)
+{
+    struct rig_probe_port_arg *args;
+    int i, found = 0;
+#ifdef HAVE_PTHREAD
+    pthread_t *threads;
+    char *started;
+#endif
+
+    if (!ports || count <= 0)
+    {
+        return (-RIG_EINVAL);
+    }
+
+    args = calloc(count, sizeof(*args));
+
+    if (!args)
+    {
+        return (-RIG_ENOMEM);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        args[i].port = &ports[i];
+        args[i].cfunc = cfunc;
+        args[i].data = data;
+        args[i].model = RIG_MODEL_NONE;
+    }
+
+#ifdef HAVE_PTHREAD
+    threads = calloc(count, sizeof(*threads));
+    started = calloc(count, 1);
+
+    if (!threads || !started)
+    {
+        free(threads);
+        free(started);
+        free(args);
+        return (-RIG_ENOMEM);
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        started[i] = pthread_create(&threads[i], NULL, rig_probe_port_thread,
+                                    &args[i]) == 0;
+
+        if (!started[i])
+        {
+            /* no thread to spare, probe this one from here */
+            rig_probe_port_thread(&args[i]);
+        }
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (started[i])
+        {
+            pthread_join(threads[i], NULL);
+        }
+    }
+
+    free(threads);
+    free(started);
+#else
+
+    for (i = 0; i < count; i++)
+    {
+        rig_probe_port_thread(&args[i]);
+    }
+
+#endif
+
+    for (i = 0; i < count; i++)
+    {
+        if (args[i].model != RIG_MODEL_NONE)
+        {
+            found++;
+        }
+    }
+
+    free(args);
+
+    return (found);
+}
 
-    if (!rig || !rig->caps)
-    {
-        RETURNFUNC(0);
-    }
+
+/**
+ * \brief check retrieval ability of VFO operations
+ * \param rig   The rig handle
+ * \param op    The VFO op
+ *
+ *  Checks if a rig is capable of executing a VFO operation.
+ *  Since the \a op is an OR'ed bitmap argument, more than
+ *  one op can be checked at the same time.
+ *
+ *  EXAMPLE: if (rig_has_vfo_op(my_rig, RIG_OP_CPY)) disp_VFOcpy_btn();
+ *
+ * \return a bit map mask of supported op settings that can be retrieved,
+ * otherwise 0 if none supported.
+ *
+ * \sa rig_vfo_op()
+ */
+vfo_op_t HAMLIB_API rig_has_vfo_op(RIG *rig, vfo_op_t op)
+{
+    int retcode;
+
+    ENTERFUNC;
+
+    if (!rig || !rig->caps)
+    {
+        RETURNFUNC(0);
+    }
 
     retcode = rig->caps->vfo_ops & op;
     RETURNFUNC(retcode);
@@ -5969,6 +6997,8 @@ int HAMLIB_API rig_vfo_op(RIG *rig, vfo_t vfo, vfo_op_t op)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     caps = rig->caps;
 
     if (caps->vfo_op == NULL || rig_has_vfo_op(rig, op) == 0)
@@ -5978,6 +7008,12 @@ int HAMLIB_API rig_vfo_op(RIG *rig, vfo_t vfo, vfo_op_t op)
         RETURNFUNC(-RIG_ENAVAIL);
     }
 
+    /* writes or clears the memory channel selected, which one is not known here */
+    if (op & (RIG_OP_FROM_VFO | RIG_OP_MCL))
+    {
+        rig_chan_cache_invalidate(rig, -1);
+    }
+
     if (vfo == RIG_VFO_CURR
             || vfo == rig->state.current_vfo)
     {
@@ -6079,6 +7115,8 @@ int HAMLIB_API rig_scan(RIG *rig, vfo_t vfo, scan_t scan, int ch)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     caps = rig->caps;
 
     if (caps->scan == NULL
@@ -6150,6 +7188,8 @@ int HAMLIB_API rig_send_dtmf(RIG *rig, vfo_t vfo, const char *digits)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     if (!digits)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -6207,11 +7247,14 @@ int HAMLIB_API rig_send_dtmf(RIG *rig, vfo_t vfo, const char *digits)
  *
  *  Receives DTMF digits (not blocking).
  *  See DTMF change speed, etc. (TODO).
+ *  Rather than polling this, rig_set_dtmf_callback() has the digits
+ *  pushed as they are detected.
  *
  * \return RIG_OK if the operation has been successful, otherwise
  * a negative value if an error occurred (in which case, cause is
  * set appropriately).
  *
+ * \sa rig_set_dtmf_callback()
  */
 int HAMLIB_API rig_recv_dtmf(RIG *rig, vfo_t vfo, char *digits, int *length)
 {
@@ -6226,6 +7269,8 @@ int HAMLIB_API rig_recv_dtmf(RIG *rig, vfo_t vfo, char *digits, int *length)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     if (!digits || !length)
     {
         RETURNFUNC(-RIG_EINVAL);
@@ -6281,7 +7326,11 @@ int HAMLIB_API rig_recv_dtmf(RIG *rig, vfo_t vfo, char *digits, int *length)
  * \param msg   Message to be sent
  *
  *  Sends morse message.
- *  See keyer change speed, etc. (TODO).
+ *  With the cw_key option set, Hamlib keys the message itself on a serial
+ *  or PTT line at cw_wpm, and returns once it is queued.
+ *  With the morse_queue option set, the message is queued and returns at
+ *  once; a thread hands the queue to the rig as its keyer buffer takes it,
+ *  reporting progress to the callback set with rig_set_morse_callback().
  *
  * \return RIG_OK if the operation has been successful, otherwise
  * a negative value if an error occurred (in which case, cause is
@@ -6289,6 +7338,24 @@ int HAMLIB_API rig_recv_dtmf(RIG *rig, vfo_t vfo, char *digits, int *length)
  *
  */
 int HAMLIB_API rig_send_morse(RIG *rig, vfo_t vfo, const char *msg)
+{
+    ENTERFUNC;
+
+    if (CHECK_RIG_ARG(rig) || !msg)
+    {
+        RETURNFUNC(-RIG_EINVAL);
+    }
+
+    // not behind the API lock, the queue thread may be holding it
+    if (rig->state.morse_queue_thread)
+    {
+        RETURNFUNC(morse_queue_send(rig, vfo, msg));
+    }
+
+    RETURNFUNC(rig_send_morse_now(rig, vfo, msg));
+}
+
+int rig_send_morse_now(RIG *rig, vfo_t vfo, const char *msg)
 {
     const struct rig_caps *caps;
     int retcode, rc2;
@@ -6296,14 +7363,11 @@ int HAMLIB_API rig_send_morse(RIG *rig, vfo_t vfo, const char *msg)
 
     ENTERFUNC;
 
-    if (CHECK_RIG_ARG(rig))
-    {
-        RETURNFUNC(-RIG_EINVAL);
-    }
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
 
-    if (!msg)
+    if (rig->state.keyer)
     {
-        RETURNFUNC(-RIG_EINVAL);
+        RETURNFUNC(keyer_send(rig, msg));
     }
 
     caps = rig->caps;
@@ -6373,6 +7437,16 @@ int HAMLIB_API rig_stop_morse(RIG *rig, vfo_t vfo)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    // before the lock, so the queue thread hands nothing more to the rig
+    morse_queue_abort(rig);
+
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SAFETY);
+
+    if (rig->state.keyer)
+    {
+        RETURNFUNC(keyer_abort(rig));
+    }
+
     caps = rig->caps;
 
     if (caps->stop_morse == NULL)
@@ -6477,6 +7551,14 @@ int HAMLIB_API rig_wait_morse(RIG *rig, vfo_t vfo)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    if (rig->state.keyer)
+    {
+        RETURNFUNC(keyer_wait(rig));
+    }
+
+    // the rest of the queue first, then the rig's own buffer
+    morse_queue_wait(rig);
+
     caps = rig->caps;
 
     if (vfo == RIG_VFO_CURR
@@ -6541,6 +7623,8 @@ int HAMLIB_API rig_send_voice_mem(RIG *rig, vfo_t vfo, int ch)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     caps = rig->caps;
 
     if (caps->send_voice_mem == NULL)
@@ -6645,6 +7729,8 @@ int HAMLIB_API rig_set_vfo_opt(RIG *rig, int status)
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     if (rig->caps->set_vfo_opt == NULL)
     {
         RETURNFUNC(-RIG_ENAVAIL);
@@ -6673,6 +7759,8 @@ const char *HAMLIB_API rig_get_info(RIG *rig)
         return (NULL);
     }
 
+    RIG_LOCK(rig);
+
     if (rig->caps->get_info == NULL)
     {
         return (NULL);
@@ -6683,58 +7771,27 @@ const char *HAMLIB_API rig_get_info(RIG *rig)
 }
 
 
-static void make_crc_table(unsigned long crcTable[])
-{
-    unsigned long POLYNOMIAL = 0xEDB88320;
-    unsigned char b = 0;
-
-    do
-    {
-        // Start with the data byte
-        unsigned long remainder = b;
-
-        unsigned long bit;
-
-        for (bit = 8; bit > 0; --bit)
-        {
-            if (remainder & 1)
-            {
-                remainder = (remainder >> 1) ^ POLYNOMIAL;
-            }
-            else
-            {
-                remainder = (remainder >> 1);
-            }
-        }
-
-        crcTable[(size_t)b] = remainder;
-    }
-    while (0 != ++b);
-}
-
-static unsigned long crcTable[256];
-
-static unsigned long gen_crc(unsigned char *p, size_t n)
-{
-    unsigned long crc = 0xfffffffful;
-    size_t i;
-
-    if (crcTable[0] == 0) { make_crc_table(crcTable); }
-
-    for (i = 0; i < n; i++)
-    {
-        crc = crcTable[*p++ ^ (crc & 0xff)] ^ (crc >> 8);
-    }
-
-    return ((~crc) & 0xffffffff);
-}
-
 /**
  * \brief get freq/mode/width for requested VFO
  * \param rig   The rig handle
  *
  * returns a string for all known VFOs plus rig split status and satellite mode status
  */
+#ifndef DOC_HIDDEN
+/* %.0f of a frequency, whole Hz without printf */
+static void rig_info_freq(char *buf, size_t len, freq_t freq)
+{
+    if (fabs(freq) < 1e15 && freq == (double)(int64_t) freq
+            && !(freq == 0 && signbit(freq)))
+    {
+        num_fmt_int(buf, (int64_t) freq);
+        return;
+    }
+
+    snprintf(buf, len, "%.0f", freq);
+}
+#endif
+
 int HAMLIB_API rig_get_rig_info(RIG *rig, char *response, int max_response_len)
 {
     vfo_t vfoA, vfoB;
@@ -6746,13 +7803,26 @@ int HAMLIB_API rig_get_rig_info(RIG *rig, char *response, int max_response_len)
     int satmode;
     int ret;
     int rxa, txa, rxb, txb;
-    response[0] = 0;
+    unsigned int seq;
+    char freqAstr[32], freqBstr[32];
 
     if (CHECK_RIG_ARG(rig) || !response)
     {
         RETURNFUNC2(-RIG_EINVAL);
     }
 
+    response[0] = 0;
+
+    // nothing written to the cache since the last call, same answer
+    if (rig_info_cached(rig, response, max_response_len))
+    {
+        return RIG_OK;
+    }
+
+    RIG_LOCK(rig);
+
+    seq = rig_cache_read_begin(rig);
+
     ELAPSED1;
 
     vfoA = vfo_fixup(rig, RIG_VFO_A, rig->state.cache.split);
@@ -6789,14 +7859,13 @@ int HAMLIB_API rig_get_rig_info(RIG *rig, char *response, int max_response_len)
     txa = split == 0;
     rxb = !rxa;
     txb = split == 1;
+    rig_info_freq(freqAstr, sizeof(freqAstr), freqA);
+    rig_info_freq(freqBstr, sizeof(freqBstr), freqB);
     SNPRINTF(response, max_response_len - strlen("CRC=0x00000000\n"),
-             "VFO=%s Freq=%.0f Mode=%s Width=%d RX=%d TX=%d\nVFO=%s Freq=%.0f Mode=%s Width=%d RX=%d TX=%d\nSplit=%d SatMode=%d\nRig=%s\nApp=Hamlib\nVersion=20210506 1.0.0\n",
-             rig_strvfo(vfoA), freqA, modeAstr, (int)widthA, rxa, txa, rig_strvfo(vfoB),
-             freqB, modeBstr, (int)widthB, rxb, txb, split, satmode, rig->caps->model_name);
-    unsigned long crc = gen_crc((unsigned char *)response, strlen(response));
-    char tmpstr[32];
-    SNPRINTF(tmpstr, sizeof(tmpstr), "CRC=0x%08lx\n", crc);
-    strcat(response, tmpstr);
+             "VFO=%s Freq=%s Mode=%s Width=%d RX=%d TX=%d\nVFO=%s Freq=%s Mode=%s Width=%d RX=%d TX=%d\nSplit=%d SatMode=%d\nRig=%s\nApp=Hamlib\nVersion=20210506 1.0.0\n",
+             rig_strvfo(vfoA), freqAstr, modeAstr, (int)widthA, rxa, txa, rig_strvfo(vfoB),
+             freqBstr, modeBstr, (int)widthB, rxb, txb, split, satmode, rig->caps->model_name);
+    rig_info_store(rig, response, max_response_len, seq);
 
 
     if (strlen(response) >= max_response_len - 1)
@@ -6841,6 +7910,8 @@ int HAMLIB_API rig_get_vfo_info(RIG *rig, vfo_t vfo, freq_t *freq,
         RETURNFUNC(-RIG_EINVAL);
     }
 
+    RIG_LOCK(rig);
+
     //if (vfo == RIG_VFO_CURR) { vfo = rig->state.current_vfo; }
 
     vfo = vfo_fixup(rig, vfo, rig->state.cache.split);
@@ -6920,6 +7991,8 @@ int HAMLIB_API rig_set_clock(RIG *rig, int year, int month, int day, int hour,
         return -RIG_ENIMPL;
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     RETURNFUNC2(rig->caps->set_clock(rig, year, month, day, hour, min, sec,
                                      msec, utc_offset));
 }
@@ -6939,6 +8012,8 @@ int HAMLIB_API rig_get_clock(RIG *rig, int *year, int *month, int *day,
         return -RIG_ENIMPL;
     }
 
+    RIG_LOCK(rig);
+
     retval = rig->caps->get_clock(rig, year, month, day, hour, min, sec,
                                   msec, utc_offset);
     RETURNFUNC2(retval);
@@ -7146,7 +8221,10 @@ HAMLIB_EXPORT(void) sync_callback(int lock)
 
 #ifdef HAVE_PTHREAD
 
-#define MAX_FRAME_LENGTH 1024
+#define MAX_FRAME_LENGTH ASYNC_DISPATCH_FRAME_LENGTH
+
+/* read errors other than garbled frames back off from 10 ms up to this */
+#define ASYNC_ERROR_BACKOFF_MAX_US (500 * 1000)
 
 static int async_data_handler_start(RIG *rig)
 {
@@ -7175,6 +8253,26 @@ static int async_data_handler_start(RIG *rig)
     async_data_handler_priv = (async_data_handler_priv_data *)
                               rs->async_data_handler_priv_data;
     async_data_handler_priv->args.rig = rig;
+    async_data_handler_priv->dispatch = async_dispatch_start(rig);
+
+    if (async_data_handler_priv->dispatch == NULL)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: no dispatch thread, async frames are processed by the reader\n",
+                  __func__);
+    }
+
+    if (rs->async_shared)
+    {
+        if (async_shared_add(rig) == RIG_OK)
+        {
+            async_data_handler_priv->shared = 1;
+            RETURNFUNC(RIG_OK);
+        }
+
+        rig_debug(RIG_DEBUG_WARN, "%s: port cannot be shared, starting a reader thread of its own\n",
+                  __func__);
+    }
+
     int err = pthread_create(&async_data_handler_priv->thread_id, NULL,
                              async_data_handler, &async_data_handler_priv->args);
 
@@ -7205,7 +8303,12 @@ static int async_data_handler_stop(RIG *rig)
 
     if (async_data_handler_priv != NULL)
     {
-        if (async_data_handler_priv->thread_id != 0)
+        if (async_data_handler_priv->shared)
+        {
+            async_shared_remove(rig);
+            async_data_handler_priv->shared = 0;
+        }
+        else if (async_data_handler_priv->thread_id != 0)
         {
             int err = pthread_join(async_data_handler_priv->thread_id, NULL);
 
@@ -7219,6 +8322,7 @@ static int async_data_handler_stop(RIG *rig)
             async_data_handler_priv->thread_id = 0;
         }
 
+        async_dispatch_stop(async_data_handler_priv->dispatch);
         free(rs->async_data_handler_priv_data);
         rs->async_data_handler_priv_data = NULL;
     }
@@ -7228,6 +8332,76 @@ static int async_data_handler_stop(RIG *rig)
     RETURNFUNC(RIG_OK);
 }
 
+/* reads one frame into frame and hands it on, returns the read error if any */
+static int async_data_read_frame(RIG *rig, struct async_dispatch *dispatch,
+                                 unsigned char *frame, size_t frame_size)
+{
+    struct rig_state *rs = &rig->state;
+    int frame_length;
+    int async_frame;
+    int result;
+
+    result = rig->caps->read_frame_direct(rig, frame_size, frame);
+
+    if (result < 0)
+    {
+        // Timeouts occur always if there is nothing to receive, so they are not really errors in this case
+        if (result != -RIG_ETIMEOUT)
+        {
+            // TODO: it may be necessary to have mutex locking on transaction_active flag
+            if (rs->transaction_active)
+            {
+                unsigned char data = (unsigned char) result;
+                write_block_sync_error(&rs->rigport, &data, 1);
+            }
+
+            // TODO: error handling -> store errors in rig state -> to be exposed in async snapshot packets
+            rig_debug(RIG_DEBUG_ERR, "%s: read_frame_direct() failed, result=%d\n",
+                      __func__, result);
+        }
+
+        return result;
+    }
+
+    frame_length = result;
+
+    async_frame = rig->caps->is_async_frame(rig, frame_length, frame);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: received frame: len=%d async=%d\n", __func__,
+              frame_length, async_frame);
+
+    if (async_frame && dispatch != NULL)
+    {
+        async_dispatch_push(dispatch, frame, frame_length);
+    }
+    else if (async_frame)
+    {
+        TRACE_ASYNC_FRAME(frame_length);
+        result = rig->caps->process_async_frame(rig, frame_length, frame);
+        TRACE_ASYNC_FRAME_DONE(frame_length, result);
+
+        if (result < 0)
+        {
+            // TODO: error handling -> store errors in rig state -> to be exposed in async snapshot packets
+            rig_debug(RIG_DEBUG_ERR, "%s: process_async_frame() failed, result=%d\n",
+                      __func__, result);
+        }
+    }
+    else
+    {
+        result = write_block_sync(&rs->rigport, frame, frame_length);
+
+        if (result < 0)
+        {
+            // TODO: error handling? can writing to a pipe really fail in ways we can recover from?
+            rig_debug(RIG_DEBUG_ERR, "%s: write_block_sync() failed, result=%d\n", __func__,
+                      result);
+        }
+    }
+
+    return RIG_OK;
+}
+
 void *async_data_handler(void *arg)
 {
     struct async_data_handler_args_s *args = (struct async_data_handler_args_s *)
@@ -7235,80 +8409,237 @@ void *async_data_handler(void *arg)
     RIG *rig = args->rig;
     unsigned char frame[MAX_FRAME_LENGTH];
     struct rig_state *rs = &rig->state;
-    int result;
+    struct async_dispatch *dispatch = ((async_data_handler_priv_data *)
+                                       rs->async_data_handler_priv_data)->dispatch;
+    int backoff_us = 0;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s: Starting async data handler thread\n",
               __func__);
 
+    hl_thread_sched_apply("async data handler");
+
     // TODO: check how to enable "transceive" on recent Kenwood/Yaesu rigs
     // TODO: add initial support for async in Kenwood kenwood_transaction (+one) functions -> add transaction_active flag usage
     // TODO: add initial support for async in Yaesu newcat_get_cmd/set_cmd (+validate) functions -> add transaction_active flag usage
 
     while (rs->async_data_handler_thread_run)
     {
-        int frame_length;
-        int async_frame;
-
-        result = rig->caps->read_frame_direct(rig, sizeof(frame), frame);
+        int result = async_data_read_frame(rig, dispatch, frame, sizeof(frame));
 
-        if (result < 0)
+        // a garbled frame says nothing about the next one, a failing port does
+        if (result < 0 && result != -RIG_ETIMEOUT && result != -RIG_EPROTO)
         {
-            // Timeouts occur always if there is nothing to receive, so they are not really errors in this case
-            if (result != -RIG_ETIMEOUT)
-            {
-                // TODO: it may be necessary to have mutex locking on transaction_active flag
-                if (rs->transaction_active)
-                {
-                    unsigned char data = (unsigned char) result;
-                    write_block_sync_error(&rs->rigport, &data, 1);
-                }
+            backoff_us = backoff_us ? backoff_us * 2 : 10 * 1000;
 
-                // TODO: error handling -> store errors in rig state -> to be exposed in async snapshot packets
-                rig_debug(RIG_DEBUG_ERR, "%s: read_frame_direct() failed, result=%d\n",
-                          __func__, result);
-                hl_usleep(500 * 1000);
+            if (backoff_us > ASYNC_ERROR_BACKOFF_MAX_US)
+            {
+                backoff_us = ASYNC_ERROR_BACKOFF_MAX_US;
             }
 
+            hl_usleep(backoff_us);
+        }
+        else if (result >= 0)
+        {
+            backoff_us = 0;
+        }
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: Stopping async data handler thread\n",
+              __func__);
+
+    return NULL;
+}
+
+
+/*
+ * With the async_shared conf the ports of all such rigs are watched by one
+ * thread through ioevent.c, and a frame is read only once its port is
+ * readable, instead of each rig polling its port from a thread of its own.
+ * A port that fails is taken out of the loop and put back after the same
+ * backoff the thread of its own would sleep.
+ */
+static pthread_mutex_t async_shared_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t async_shared_thread;
+static int async_shared_users;
+static volatile int async_shared_run;
+/* the rigs being read, under async_shared_lock */
+static RIG *async_shared_rigs[PORT_EVENT_MAX];
+/* only ever used by async_shared_reader() */
+static unsigned char async_shared_frame[MAX_FRAME_LENGTH];
+
+static int async_data_ready(hamlib_port_t *p, int events, rig_ptr_t arg);
+
+/* puts the ports whose backoff is over back into the loop */
+static void async_shared_retry(void)
+{
+    struct timeval now;
+    int i;
+
+    // async_shared_remove() joins this thread holding the lock
+    if (pthread_mutex_trylock(&async_shared_lock))
+    {
+        return;
+    }
+
+    gettimeofday(&now, NULL);
+
+    for (i = 0; i < PORT_EVENT_MAX; i++)
+    {
+        RIG *rig = async_shared_rigs[i];
+        async_data_handler_priv_data *priv;
+
+        if (!rig)
+        {
             continue;
         }
 
-        frame_length = result;
+        priv = (async_data_handler_priv_data *) rig->state.async_data_handler_priv_data;
+
+        if (timerisset(&priv->retry_at) && !timercmp(&now, &priv->retry_at, <)
+                && port_event_add(&rig->state.rigport, async_data_ready, rig) == RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: %s port back in the shared reader\n",
+                      __func__, rig->caps->model_name);
+            timerclear(&priv->retry_at);
+        }
+    }
+
+    pthread_mutex_unlock(&async_shared_lock);
+}
+
+static void *async_shared_reader(void *arg)
+{
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: Starting shared async reader with %s\n",
+              __func__, port_event_engine());
+
+    hl_thread_sched_apply("async data handler");
+
+    while (async_shared_run)
+    {
+        port_event_dispatch(100);
+        async_shared_retry();
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: Stopping shared async reader\n", __func__);
+
+    return NULL;
+}
+
+static int async_data_ready(hamlib_port_t *p, int events, rig_ptr_t arg)
+{
+    RIG *rig = (RIG *) arg;
+    struct rig_state *rs = &rig->state;
+    async_data_handler_priv_data *priv = (async_data_handler_priv_data *)
+                                         rs->async_data_handler_priv_data;
+    int result = async_data_read_frame(rig, priv->dispatch, async_shared_frame,
+                                       sizeof(async_shared_frame));
 
-        async_frame = rig->caps->is_async_frame(rig, frame_length, frame);
+    if (result >= 0)
+    {
+        priv->backoff_us = 0;
+        return RIG_OK;
+    }
 
-        rig_debug(RIG_DEBUG_VERBOSE, "%s: received frame: len=%d async=%d\n", __func__,
-                  frame_length, async_frame);
+    // a failing port stays readable and would starve the other rigs
+    if ((events & PORT_EVENT_ERROR)
+            || (result != -RIG_ETIMEOUT && result != -RIG_EPROTO))
+    {
+        struct timeval wait;
 
-        if (async_frame)
+        // a reader already got it from async_data_read_frame()
+        if (rs->transaction_active && result == -RIG_ETIMEOUT)
         {
-            result = rig->caps->process_async_frame(rig, frame_length, frame);
+            unsigned char data = (unsigned char) - RIG_EIO;
+            write_block_sync_error(&rs->rigport, &data, 1);
+        }
 
-            if (result < 0)
-            {
-                // TODO: error handling -> store errors in rig state -> to be exposed in async snapshot packets
-                rig_debug(RIG_DEBUG_ERR, "%s: process_async_frame() failed, result=%d\n",
-                          __func__, result);
-                continue;
-            }
+        priv->backoff_us = priv->backoff_us ? priv->backoff_us * 2 : 10 * 1000;
+
+        if (priv->backoff_us > ASYNC_ERROR_BACKOFF_MAX_US)
+        {
+            priv->backoff_us = ASYNC_ERROR_BACKOFF_MAX_US;
         }
-        else
+
+        gettimeofday(&priv->retry_at, NULL);
+        wait.tv_sec = priv->backoff_us / 1000000;
+        wait.tv_usec = priv->backoff_us % 1000000;
+        timeradd(&priv->retry_at, &wait, &priv->retry_at);
+
+        rig_debug(RIG_DEBUG_ERR, "%s: %s port failing, retried in %d ms\n",
+                  __func__, rig->caps->model_name, priv->backoff_us / 1000);
+        port_event_remove(p);
+    }
+
+    return RIG_OK;
+}
+
+static int async_shared_add(RIG *rig)
+{
+    int retval;
+    int i;
+
+    pthread_mutex_lock(&async_shared_lock);
+
+    for (i = 0; i < PORT_EVENT_MAX && async_shared_rigs[i]; i++) {}
+
+    retval = port_event_add(&rig->state.rigport, async_data_ready, rig);
+
+    if (retval == RIG_OK)
+    {
+        // port_event_add() takes at most PORT_EVENT_MAX, so there is room
+        async_shared_rigs[i] = rig;
+
+        if (async_shared_users++ == 0)
         {
-            result = write_block_sync(&rs->rigport, frame, frame_length);
+            async_shared_run = 1;
 
-            if (result < 0)
+            if (pthread_create(&async_shared_thread, NULL, async_shared_reader, NULL))
             {
-                // TODO: error handling? can writing to a pipe really fail in ways we can recover from?
-                rig_debug(RIG_DEBUG_ERR, "%s: write_block_sync() failed, result=%d\n", __func__,
-                          result);
-                continue;
+                rig_debug(RIG_DEBUG_ERR, "%s: pthread_create error: %s\n", __func__,
+                          strerror(errno));
+                async_shared_run = 0;
+                async_shared_users = 0;
+                async_shared_rigs[i] = NULL;
+                port_event_remove(&rig->state.rigport);
+                retval = -RIG_EINTERNAL;
             }
         }
     }
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s: Stopping async data handler thread\n",
-              __func__);
+    pthread_mutex_unlock(&async_shared_lock);
 
-    return NULL;
+    return retval;
+}
+
+static void async_shared_remove(RIG *rig)
+{
+    int i;
+
+    pthread_mutex_lock(&async_shared_lock);
+
+    // out of the list first, so async_shared_retry() cannot put it back
+    for (i = 0; i < PORT_EVENT_MAX; i++)
+    {
+        if (async_shared_rigs[i] == rig)
+        {
+            async_shared_rigs[i] = NULL;
+        }
+    }
+
+    pthread_mutex_unlock(&async_shared_lock);
+
+    // waits for a frame of this rig being read, may be backing off
+    port_event_remove(&rig->state.rigport);
+
+    pthread_mutex_lock(&async_shared_lock);
+
+    if (--async_shared_users == 0)
+    {
+        async_shared_run = 0;
+        pthread_join(async_shared_thread, NULL);
+    }
+
+    pthread_mutex_unlock(&async_shared_lock);
 }
 #endif
 
@@ -7376,6 +8707,114 @@ HAMLIB_EXPORT(int) rig_send_raw(RIG *rig, const unsigned char *send,
     RETURNFUNC(retval);
 }
 
+/**
+ * \brief send several terminated CAT commands in one write and collect the replies
+ * \param rig         The rig handle
+ * \param cmds        Array of commands, with or without the terminator
+ * \param ncmds       Number of commands in \a cmds
+ * \param replies     Array of \a ncmds reply buffers, NULL entries for commands that give no reply
+ * \param reply_len   Size of each reply buffer
+ * \param term        Command/reply terminator, e.g. ';' for Kenwood/Yaesu/Elecraft
+ *
+ * Protocols like Kenwood's accept concatenated commands such as "FA;FB;MD;IF;"
+ * in a single write and then answer each one in order.  This writes all of
+ * \a cmds with one write_block and splits the answers on \a term so a full
+ * state refresh costs one round trip instead of one per command.
+ * The terminator is stripped from each reply.
+ *
+ * \note Only queries whose replies arrive in command order can be batched.
+ * A command that the rig rejects (e.g. "?;") still consumes one reply slot.
+ *
+ * \return RIG_OK if all replies were read, otherwise a negative value
+ * (in which case the unread replies are set to the empty string).
+ * -RIG_EINVAL if \a reply_len is less than 1.
+ *
+ * \sa rig_send_raw()
+ */
+HAMLIB_EXPORT(int) rig_transaction_batch(RIG *rig, const char *cmds[],
+        int ncmds, char *replies[], int reply_len, char term)
+{
+    struct rig_state *rs;
+    unsigned char *buf;
+    char stopset[2];
+    size_t len = 0;
+    int retval = RIG_OK;
+    int i;
+
+    if (CHECK_RIG_ARG(rig) || !cmds || !replies || ncmds <= 0 || reply_len < 1)
+    {
+        return (-RIG_EINVAL);
+    }
+
+    ENTERFUNC;
+
+    /* the whole batch is one exchange, no other thread's may come between */
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
+    rs = &rig->state;
+
+    for (i = 0; i < ncmds; i++)
+    {
+        if (!cmds[i] || !cmds[i][0]) { RETURNFUNC(-RIG_EINVAL); }
+
+        len += strlen(cmds[i]) + 1;
+
+        if (replies[i]) { replies[i][0] = 0; }
+    }
+
+    buf = malloc(len);
+
+    if (!buf) { RETURNFUNC(-RIG_ENOMEM); }
+
+    len = 0;
+
+    for (i = 0; i < ncmds; i++)
+    {
+        size_t cmdlen = strlen(cmds[i]);
+
+        memcpy(buf + len, cmds[i], cmdlen);
+        len += cmdlen;
+
+        if (cmds[i][cmdlen - 1] != term) { buf[len++] = term; }
+    }
+
+    stopset[0] = term;
+    stopset[1] = 0;
+
+    set_transaction_active(rig);
+
+    rig_flush(&rs->rigport);
+
+    retval = write_block(&rs->rigport, buf, len);
+
+    free(buf);
+
+    for (i = 0; retval == RIG_OK && i < ncmds; i++)
+    {
+        int nbytes;
+
+        if (!replies[i]) { continue; }
+
+        nbytes = read_string(&rs->rigport, (unsigned char *) replies[i], reply_len,
+                             stopset, 1, 0, 1);
+
+        if (nbytes < 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: reply %d of %d for '%s' failed: %s\n",
+                      __func__, i + 1, ncmds, cmds[i], rigerror(nbytes));
+            replies[i][0] = 0;
+            retval = nbytes;
+            break;
+        }
+
+        if (nbytes > 0 && replies[i][nbytes - 1] == term) { replies[i][nbytes - 1] = 0; }
+    }
+
+    set_transaction_inactive(rig);
+
+    RETURNFUNC(retval);
+}
+
 HAMLIB_EXPORT(int) rig_set_lock_mode(RIG *rig, int mode)
 {
     int retcode = -RIG_ENAVAIL;
@@ -0,0 +1,397 @@
+/*
+ *  Hamlib Interface - rig to rig frequency follow
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * A rig linked with rig_follow_rig() is retuned from inside the library,
+ * the way band_follow.c retunes an amplifier: every frequency the master
+ * reports goes through rig_set_cache_freq() and is handed to a thread of
+ * the link's own, which sets the slave.  Nothing is polled for the link.
+ *
+ * With RIG_FOLLOW_BOTH the slave's frequencies go back to the master the
+ * same way.  A link hears its own rig_set_freq() again through the cache;
+ * such echoes, and frequencies the other side already has, are dropped,
+ * so the two rigs never chase each other.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "rig_follow.h"
+#include "misc.h"
+
+#ifdef HAVE_PTHREAD
+
+/* side 0 is the master, side 1 the slave */
+struct rig_follow
+{
+    RIG *rig[2];
+    vfo_t vfo;
+    freq_t offset;
+    int flags;
+    int coalesce_ms;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int run;
+    freq_t last[2];         /* last frequency known on each side */
+    freq_t sent[2];         /* last one the link set there, 0 for none */
+    int pending[2];         /* last[i] still to be sent to the other side */
+    struct timespec set_at[2];  /* when the link last set each side */
+};
+
+/* guards rig_state.rig_follow against unlinking */
+static pthread_mutex_t rig_follow_links = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* A and Main are the same VFO to the cache, and so are B and Sub */
+static vfo_t rig_follow_side(vfo_t vfo)
+{
+    switch (vfo)
+    {
+    case RIG_VFO_A:
+    case RIG_VFO_VFO:
+    case RIG_VFO_MAIN:
+    case RIG_VFO_MAIN_A:
+        return RIG_VFO_A;
+
+    case RIG_VFO_B:
+    case RIG_VFO_SUB:
+    case RIG_VFO_MAIN_B:
+        return RIG_VFO_B;
+
+    default:
+        return vfo;
+    }
+}
+
+
+/* the frequency of the other side for freq on side from */
+static freq_t rig_follow_map(const struct rig_follow *f, int from, freq_t freq)
+{
+    if (f->flags & RIG_FOLLOW_INVERT)
+    {
+        return f->offset - freq;
+    }
+
+    return from == 0 ? freq + f->offset : freq - f->offset;
+}
+
+
+static void *rig_follow_thread(void *arg)
+{
+    struct rig_follow *f = (struct rig_follow *) arg;
+
+    pthread_mutex_lock(&f->lock);
+
+    while (f->run)
+    {
+        struct timespec now, due;
+        int from = f->pending[0] ? 0 : f->pending[1] ? 1 : -1;
+        int to, ret;
+        freq_t freq;
+
+        if (from < 0)
+        {
+            pthread_cond_wait(&f->cond, &f->lock);
+            continue;
+        }
+
+        to = !from;
+
+        /* at most one rig_set_freq() per coalesce_ms, with the latest value */
+        due = f->set_at[to];
+        due.tv_sec += f->coalesce_ms / 1000;
+        due.tv_nsec += (f->coalesce_ms % 1000) * 1000000L;
+
+        if (due.tv_nsec >= 1000000000L)
+        {
+            due.tv_sec++;
+            due.tv_nsec -= 1000000000L;
+        }
+
+        clock_gettime(CLOCK_REALTIME, &now);
+
+        if (now.tv_sec < due.tv_sec
+                || (now.tv_sec == due.tv_sec && now.tv_nsec < due.tv_nsec))
+        {
+            pthread_cond_timedwait(&f->cond, &f->lock, &due);
+            continue;
+        }
+
+        f->pending[from] = 0;
+        freq = rig_follow_map(f, from, f->last[from]);
+
+        if (freq <= 0 || fabs(freq - f->last[to]) < 0.5)
+        {
+            continue;
+        }
+
+        f->sent[to] = freq;
+        f->set_at[to] = now;
+        pthread_mutex_unlock(&f->lock);
+
+        ret = rig_set_freq(f->rig[to], f->vfo, freq);
+
+        pthread_mutex_lock(&f->lock);
+
+        if (ret == RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: %s follows to %.0f Hz\n", __func__,
+                      f->rig[to]->caps->model_name, freq);
+            f->last[to] = freq;
+        }
+        else
+        {
+            /* tried again on the next frequency reported */
+            rig_debug(RIG_DEBUG_WARN, "%s: %s did not take %.0f Hz: %s\n", __func__,
+                      f->rig[to]->caps->model_name, freq, rigerror(ret));
+            f->sent[to] = 0;
+        }
+    }
+
+    pthread_mutex_unlock(&f->lock);
+
+    return NULL;
+}
+
+
+void rig_follow_notify(RIG *rig, vfo_t vfo, freq_t freq)
+{
+    struct rig_state *rs = &rig->state;
+    struct rig_follow *f;
+    vfo_t want;
+    int side;
+
+    /* the common case stays a single load */
+    if (!rs->rig_follow || freq <= 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&rig_follow_links);
+    f = (struct rig_follow *) rs->rig_follow;
+
+    if (!f)
+    {
+        pthread_mutex_unlock(&rig_follow_links);
+        return;
+    }
+
+    side = f->rig[1] == rig;
+    want = f->vfo == RIG_VFO_CURR ? rs->current_vfo : f->vfo;
+
+    if (want != RIG_VFO_NONE && want != RIG_VFO_CURR
+            && rig_follow_side(vfo) != rig_follow_side(want))
+    {
+        pthread_mutex_unlock(&rig_follow_links);
+        return;
+    }
+
+    pthread_mutex_lock(&f->lock);
+
+    if (freq != f->last[side])
+    {
+        f->last[side] = freq;
+
+        /* the echo of the link's own set is not a change to pass on */
+        if (freq != f->sent[side] && (side == 0 || (f->flags & RIG_FOLLOW_BOTH)))
+        {
+            f->pending[side] = 1;
+            pthread_cond_signal(&f->cond);
+        }
+    }
+
+    pthread_mutex_unlock(&f->lock);
+    pthread_mutex_unlock(&rig_follow_links);
+}
+
+
+void rig_follow_rig_gone(RIG *rig)
+{
+    struct rig_follow *f;
+
+    if (!rig->state.rig_follow)
+    {
+        return;
+    }
+
+    /*
+     * Unhooked first and joined without rig_follow_links: the thread may
+     * be in a rig_set_freq() whose notify waits for that lock.
+     */
+    pthread_mutex_lock(&rig_follow_links);
+    f = (struct rig_follow *) rig->state.rig_follow;
+
+    if (f)
+    {
+        f->rig[0]->state.rig_follow = NULL;
+        f->rig[1]->state.rig_follow = NULL;
+    }
+
+    pthread_mutex_unlock(&rig_follow_links);
+
+    if (!f)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&f->lock);
+    f->run = 0;
+    pthread_cond_signal(&f->cond);
+    pthread_mutex_unlock(&f->lock);
+
+    pthread_join(f->thread, NULL);
+
+    pthread_cond_destroy(&f->cond);
+    pthread_mutex_destroy(&f->lock);
+    free(f);
+}
+
+#else
+
+void rig_follow_notify(RIG *rig, vfo_t vfo, freq_t freq)
+{
+}
+
+void rig_follow_rig_gone(RIG *rig)
+{
+}
+
+#endif
+
+
+/**
+ * \brief Make a rig follow the frequency of another
+ * \param slave       The rig handle that is retuned, opened
+ * \param master      The rig handle followed, opened; NULL to stop following
+ * \param vfo         The VFO followed on the master and set on the slave,
+ *                    RIG_VFO_CURR for the current one of each
+ * \param offset      Added to the master's frequency, or with
+ *                    RIG_FOLLOW_INVERT the frequency the master's is
+ *                    subtracted from
+ * \param coalesce_ms Least time between two frequencies set on a rig, the
+ *                    latest one being sent; 0 to set every one at once
+ * \param flags       RIG_FOLLOW_INVERT, RIG_FOLLOW_BOTH or 0
+ *
+ * Typically an SDR panadapter following a transceiver.  From here on every
+ * frequency the master reports, through transceive, a poll routine or the
+ * rig_set_freq() and rig_get_freq() of the application, is set on the slave
+ * as master + \a offset, which covers transverters and IF taps alike; with
+ * RIG_FOLLOW_INVERT it is \a offset - master, for an IF whose spectrum is
+ * inverted.  With RIG_FOLLOW_BOTH the slave's changes are mapped back onto
+ * the master too.  The link does no polling of its own: a rig that neither
+ * sends transceive updates nor is polled by someone is only followed when
+ * the application reads or sets it.
+ *
+ * The slave is set from a thread of the link's own, so the master's calls
+ * never wait for it.  A rig is in one link at a time; a new call replaces
+ * the links either rig was in.  The link is dropped by rig_cleanup() of
+ * either rig.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise
+ * a negative value if an error occurred (in which case, cause is
+ * set appropriately).
+ *
+ * \sa amp_follow_rig()
+ */
+int HAMLIB_API rig_follow_rig(RIG *slave, RIG *master, vfo_t vfo,
+                              freq_t offset, int coalesce_ms, int flags)
+{
+#ifdef HAVE_PTHREAD
+    struct rig_follow *f;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!slave || !slave->caps || master == slave || coalesce_ms < 0
+            || (flags & ~(RIG_FOLLOW_INVERT | RIG_FOLLOW_BOTH)))
+    {
+        return -RIG_EINVAL;
+    }
+
+    rig_follow_rig_gone(slave);
+
+    if (!master)
+    {
+        return RIG_OK;
+    }
+
+    if (!master->caps || !slave->state.comm_state || !master->state.comm_state)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (!slave->caps->set_freq
+            || ((flags & RIG_FOLLOW_BOTH) && !master->caps->set_freq))
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    rig_follow_rig_gone(master);
+
+    f = calloc(1, sizeof(*f));
+
+    if (!f)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    f->rig[0] = master;
+    f->rig[1] = slave;
+    f->vfo = vfo;
+    f->offset = offset;
+    f->flags = flags;
+    f->coalesce_ms = coalesce_ms;
+    f->run = 1;
+    pthread_mutex_init(&f->lock, NULL);
+    pthread_cond_init(&f->cond, NULL);
+
+    if (pthread_create(&f->thread, NULL, rig_follow_thread, f))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        pthread_cond_destroy(&f->cond);
+        pthread_mutex_destroy(&f->lock);
+        free(f);
+        return -RIG_EINTERNAL;
+    }
+
+    pthread_mutex_lock(&rig_follow_links);
+    master->state.rig_follow = f;
+    slave->state.rig_follow = f;
+    pthread_mutex_unlock(&rig_follow_links);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s follows %s\n", __func__,
+              slave->caps->model_name, master->caps->model_name);
+
+    return RIG_OK;
+#else
+    return -RIG_ENIMPL;
+#endif
+}
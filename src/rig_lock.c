@@ -0,0 +1,209 @@
+/*
+ *  Hamlib Interface - per-RIG API lock
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The lock RIG_LOCK() takes, see misc.h.  A plain mutex hands itself to
+ * whichever waiter the OS wakes first, so a PTT off could sit behind a
+ * sweep of level reads.  This one keeps a count of waiters per rig_prio_t
+ * and a waiter only takes the lock when no one of a more urgent class is
+ * waiting.  Within a class the order is whatever the wakeups give.
+ *
+ * rs->mutex_state guards lock_owner, lock_depth, lock_prio and
+ * lock_waiting and is only held for a few instructions; the API lock
+ * itself is lock_depth > 0.
+ */
+
+#include <hamlib/config.h>
+
+#include <time.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "stats.h"
+
+#if defined(HAVE_PTHREAD) && defined(__GNUC__)
+
+//! @cond Doxygen_Suppress
+
+/* every lock this thread takes is demoted to this class, see rig_lock_thread_prio() */
+static __thread rig_prio_t thread_prio = RIG_PRIO_SAFETY;
+
+static int rig_lock_outranked(const struct rig_state *rs, rig_prio_t prio)
+{
+    int i;
+
+    for (i = 0; i < (int) prio; i++)
+    {
+        if (rs->lock_waiting[i] > 0) { return 1; }
+    }
+
+    return 0;
+}
+
+static uint64_t rig_lock_us_since(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)(now.tv_sec - start->tv_sec) * 1000000
+           + (now.tv_nsec - start->tv_nsec) / 1000;
+}
+
+/* RIG_LOCK_PRIO() takes this at a declaration, the cleanup attribute gives it back */
+RIG *rig_lock_acquire(RIG *rig, rig_prio_t prio)
+{
+    struct rig_state *rs;
+    struct timespec start;
+
+    if (!rig)
+    {
+        return rig;
+    }
+
+    rs = &rig->state;
+
+    if (prio != RIG_PRIO_SAFETY && prio < thread_prio)
+    {
+        prio = thread_prio;
+    }
+
+    pthread_mutex_lock(&rs->mutex_state);
+
+    if (rs->lock_depth > 0 && pthread_equal(rs->lock_owner, pthread_self()))
+    {
+        rs->lock_depth++;
+        pthread_mutex_unlock(&rs->mutex_state);
+        return rig;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    rs->lock_waiting[prio]++;
+
+    while (rs->lock_depth > 0 || rig_lock_outranked(rs, prio))
+    {
+        pthread_cond_wait(&rs->cond_state, &rs->mutex_state);
+    }
+
+    rs->lock_waiting[prio]--;
+    rs->lock_owner = pthread_self();
+    rs->lock_depth = 1;
+    rs->lock_prio = prio;
+
+    pthread_mutex_unlock(&rs->mutex_state);
+
+    rig_stats_lock(rig, prio, rig_lock_us_since(&start));
+
+    return rig;
+}
+
+void rig_lock_release(RIG **rig)
+{
+    struct rig_state *rs;
+
+    if (!*rig)
+    {
+        return;
+    }
+
+    rs = &(*rig)->state;
+
+    pthread_mutex_lock(&rs->mutex_state);
+
+    // waiters recheck their class against the others, so wake them all
+    if (--rs->lock_depth == 0)
+    {
+        pthread_cond_broadcast(&rs->cond_state);
+    }
+
+    pthread_mutex_unlock(&rs->mutex_state);
+}
+
+/*
+ * A transaction boundary inside a long API call: if a RIG_PRIO_SAFETY
+ * call is waiting, give it the lock and take it back afterwards, ahead of
+ * everybody else.  Only for places where the caller holds no other lock
+ * the PTT off could need -- between kenwood_send_morse() chunks, say, not
+ * inside a backend's transaction.  Returns 1 if a safety call went
+ * through, the caller may want to drop what it was sending.
+ */
+int rig_lock_preempt(RIG *rig)
+{
+    struct rig_state *rs = &rig->state;
+    rig_prio_t prio;
+    int depth;
+
+    if (rs->transaction_active)
+    {
+        return 0;
+    }
+
+    pthread_mutex_lock(&rs->mutex_state);
+
+    if (rs->lock_depth == 0 || !pthread_equal(rs->lock_owner, pthread_self())
+            || rs->lock_prio == RIG_PRIO_SAFETY
+            || rs->lock_waiting[RIG_PRIO_SAFETY] == 0)
+    {
+        pthread_mutex_unlock(&rs->mutex_state);
+        return 0;
+    }
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: letting %d safety call(s) through\n",
+              __func__, rs->lock_waiting[RIG_PRIO_SAFETY]);
+
+    depth = rs->lock_depth;
+    prio = rs->lock_prio;
+
+    // counted as a safety waiter, everyone else stays behind us
+    rs->lock_waiting[RIG_PRIO_SAFETY]++;
+    rs->lock_depth = 0;
+    pthread_cond_broadcast(&rs->cond_state);
+
+    while (rs->lock_depth > 0 || rs->lock_waiting[RIG_PRIO_SAFETY] > 1)
+    {
+        pthread_cond_wait(&rs->cond_state, &rs->mutex_state);
+    }
+
+    rs->lock_waiting[RIG_PRIO_SAFETY]--;
+    rs->lock_owner = pthread_self();
+    rs->lock_depth = depth;
+    rs->lock_prio = prio;
+
+    pthread_mutex_unlock(&rs->mutex_state);
+
+    rig_stats_preempt(rig);
+
+    return 1;
+}
+
+/*
+ * Demote every API call the calling thread makes from now on to at least
+ * \a prio, for threads that only ever do background work.  PTT off keeps
+ * its class.
+ */
+void rig_lock_thread_prio(rig_prio_t prio)
+{
+    thread_prio = prio;
+}
+
+//! @endcond
+
+#endif
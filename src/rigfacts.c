@@ -0,0 +1,346 @@
+/*
+ *  Hamlib Interface - persisted rig facts
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "rigfacts.h"
+
+#define RIG_FACTS_MAX     16
+#define RIG_FACTS_KEYLEN  24
+#define RIG_FACTS_VALLEN  64
+#define RIG_FACTS_PATHLEN 1024
+
+struct rig_facts
+{
+    int count;
+    int dirty;
+    char key[RIG_FACTS_MAX][RIG_FACTS_KEYLEN];
+    char val[RIG_FACTS_MAX][RIG_FACTS_VALLEN];
+    char path[RIG_FACTS_PATHLEN];
+};
+
+static int facts_mkdir(const char *dir)
+{
+#ifdef _WIN32
+    int ret = mkdir(dir);
+#else
+    int ret = mkdir(dir, 0755);
+#endif
+
+    return (ret == 0 || errno == EEXIST) ? RIG_OK : -RIG_EIO;
+}
+
+/* <cache dir>/hamlib, made if missing: $XDG_CACHE_HOME, %LOCALAPPDATA% on
+ * Windows, else ~/.cache.  Also where netrigctl keeps dump_state answers. */
+int rig_cache_dir(char *dir, size_t len)
+{
+    const char *base = getenv("XDG_CACHE_HOME");
+
+    if (base && *base)
+    {
+        SNPRINTF(dir, len, "%s", base);
+    }
+#ifdef _WIN32
+    else if ((base = getenv("LOCALAPPDATA")) != NULL)
+    {
+        SNPRINTF(dir, len, "%s", base);
+    }
+#endif
+    else if ((base = getenv("HOME")) != NULL)
+    {
+        SNPRINTF(dir, len, "%s/.cache", base);
+
+        if (facts_mkdir(dir) != RIG_OK) { return -RIG_EIO; }
+    }
+    else
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    strncat(dir, "/hamlib", len - strlen(dir) - 1);
+
+    if (facts_mkdir(dir) != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: cannot create %s: %s\n", __func__, dir,
+                  strerror(errno));
+        return -RIG_EIO;
+    }
+
+    return RIG_OK;
+}
+
+/* <cache dir>/hamlib/<model>-<port path with separators flattened> */
+static int facts_path(RIG *rig, char *path, size_t len)
+{
+    /* room left in path for the model and port */
+    char dir[RIG_FACTS_PATHLEN - HAMLIB_FILPATHLEN - 16];
+    char port[HAMLIB_FILPATHLEN];
+    char *s;
+    int ret;
+
+    ret = rig_cache_dir(dir, sizeof(dir));
+
+    if (ret != RIG_OK)
+    {
+        return ret;
+    }
+
+    SNPRINTF(port, sizeof(port), "%s", rig->state.rigport.pathname);
+
+    for (s = port; *s; s++)
+    {
+        if (*s == '/' || *s == '\\' || *s == ':') { *s = '_'; }
+    }
+
+    SNPRINTF(path, len, "%s/%u-%s", dir, rig->caps->rig_model, port);
+
+    return RIG_OK;
+}
+
+static struct rig_facts *facts_of(RIG *rig)
+{
+    return rig->state.open_cache ? rig->state.rig_facts : NULL;
+}
+
+/* read the facts file of this rig and port, a missing file is not an error */
+int rig_facts_load(RIG *rig)
+{
+    struct rig_facts *f;
+    char line[RIG_FACTS_KEYLEN + RIG_FACTS_VALLEN + 4];
+    FILE *fp;
+
+    if (!rig->state.open_cache)
+    {
+        return RIG_OK;
+    }
+
+    if (!rig->state.rig_facts)
+    {
+        rig->state.rig_facts = calloc(1, sizeof(struct rig_facts));
+
+        if (!rig->state.rig_facts) { return -RIG_ENOMEM; }
+    }
+
+    f = rig->state.rig_facts;
+    f->count = 0;
+    f->dirty = 0;
+
+    if (facts_path(rig, f->path, sizeof(f->path)) != RIG_OK)
+    {
+        f->path[0] = '\0';
+        return RIG_OK;
+    }
+
+    fp = fopen(f->path, "r");
+
+    if (!fp)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: no facts in %s yet\n", __func__, f->path);
+        return RIG_OK;
+    }
+
+    while (f->count < RIG_FACTS_MAX && fgets(line, sizeof(line), fp))
+    {
+        char *eq = strchr(line, '=');
+
+        if (!eq || eq == line) { continue; }
+
+        *eq++ = '\0';
+        eq[strcspn(eq, "\r\n")] = '\0';
+
+        if (strlen(line) >= RIG_FACTS_KEYLEN || strlen(eq) >= RIG_FACTS_VALLEN)
+        {
+            continue;
+        }
+
+        strcpy(f->key[f->count], line);
+        strcpy(f->val[f->count], eq);
+        f->count++;
+    }
+
+    fclose(fp);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %d facts from %s\n", __func__, f->count,
+              f->path);
+
+    return RIG_OK;
+}
+
+/* write the facts back if any changed, through a rename so a crash
+ * never leaves half a file */
+int rig_facts_save(RIG *rig)
+{
+    struct rig_facts *f = facts_of(rig);
+    char tmp[RIG_FACTS_PATHLEN + 8];
+    FILE *fp;
+    int i;
+
+    if (!f || !f->dirty || !f->path[0])
+    {
+        return RIG_OK;
+    }
+
+    if (f->count == 0)
+    {
+        remove(f->path);
+        f->dirty = 0;
+        return RIG_OK;
+    }
+
+    SNPRINTF(tmp, sizeof(tmp), "%s.tmp", f->path);
+    fp = fopen(tmp, "w");
+
+    if (!fp)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: cannot write %s: %s\n", __func__, tmp,
+                  strerror(errno));
+        return -RIG_EIO;
+    }
+
+    for (i = 0; i < f->count; i++)
+    {
+        fprintf(fp, "%s=%s\n", f->key[i], f->val[i]);
+    }
+
+    if (fclose(fp) != 0)
+    {
+        remove(tmp);
+        return -RIG_EIO;
+    }
+
+#ifdef _WIN32
+    remove(f->path);    /* rename does not replace on Windows */
+#endif
+
+    if (rename(tmp, f->path) != 0)
+    {
+        remove(tmp);
+        return -RIG_EIO;
+    }
+
+    f->dirty = 0;
+
+    return RIG_OK;
+}
+
+void rig_facts_free(RIG *rig)
+{
+    free(rig->state.rig_facts);
+    rig->state.rig_facts = NULL;
+}
+
+const char *rig_facts_get(RIG *rig, const char *key)
+{
+    const struct rig_facts *f = facts_of(rig);
+    int i;
+
+    for (i = 0; f && i < f->count; i++)
+    {
+        if (!strcmp(f->key[i], key))
+        {
+            return f->val[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* returns 1 and sets *val when key holds a number */
+int rig_facts_get_int(RIG *rig, const char *key, int *val)
+{
+    const char *s = rig_facts_get(rig, key);
+    char *end;
+    long l;
+
+    if (!s || !*s) { return 0; }
+
+    l = strtol(s, &end, 10);
+
+    if (*end) { return 0; }
+
+    *val = (int)l;
+
+    return 1;
+}
+
+void rig_facts_set(RIG *rig, const char *key, const char *val)
+{
+    struct rig_facts *f = facts_of(rig);
+    int i;
+
+    if (!f) { return; }
+
+    for (i = 0; i < f->count; i++)
+    {
+        if (!strcmp(f->key[i], key))
+        {
+            break;
+        }
+    }
+
+    if (i == RIG_FACTS_MAX)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: no room for %s\n", __func__, key);
+        return;
+    }
+
+    if (i < f->count && !strncmp(f->val[i], val, RIG_FACTS_VALLEN - 1))
+    {
+        return;
+    }
+
+    if (i == f->count)
+    {
+        SNPRINTF(f->key[i], RIG_FACTS_KEYLEN, "%s", key);
+        f->count++;
+    }
+
+    SNPRINTF(f->val[i], RIG_FACTS_VALLEN, "%s", val);
+    f->dirty = 1;
+}
+
+void rig_facts_set_int(RIG *rig, const char *key, int val)
+{
+    char buf[16];
+
+    SNPRINTF(buf, sizeof(buf), "%d", val);
+    rig_facts_set(rig, key, buf);
+}
+
+/* forget everything, the file goes on the next save */
+void rig_facts_clear(RIG *rig)
+{
+    struct rig_facts *f = facts_of(rig);
+
+    if (!f || f->count == 0) { return; }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: dropping %d facts\n", __func__, f->count);
+    f->count = 0;
+    f->dirty = 1;
+}
@@ -0,0 +1,49 @@
+/*
+ *  Hamlib Interface - persisted rig facts
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _RIGFACTS_H
+#define _RIGFACTS_H
+
+#include <hamlib/rig.h>
+
+/* Fills dir with <cache dir>/hamlib, creating it if needed */
+int rig_cache_dir(char *dir, size_t len);
+
+/*
+ * Facts a backend discovers on open and that do not change between runs
+ * (ID string, firmware level, reply widths...), kept in a small key=value
+ * file per model and port under $XDG_CACHE_HOME/hamlib.  Only used when
+ * the open_cache conf option is set; every call is a no-op otherwise.
+ *
+ * rig_open() loads the file before the backend's rig_open and writes it
+ * back after it, and again after the backend's rig_close, if a fact changed.
+ * A backend that finds a replayed fact to be wrong calls rig_facts_clear().
+ */
+int rig_facts_load(RIG *rig);
+int rig_facts_save(RIG *rig);
+void rig_facts_free(RIG *rig);
+
+const char *rig_facts_get(RIG *rig, const char *key);
+int rig_facts_get_int(RIG *rig, const char *key, int *val);
+void rig_facts_set(RIG *rig, const char *key, const char *val);
+void rig_facts_set_int(RIG *rig, const char *key, int val);
+void rig_facts_clear(RIG *rig);
+
+#endif /* _RIGFACTS_H */
@@ -0,0 +1,331 @@
+/*
+ *  Hamlib Interface - prebuilt rig_get_rig_info() text
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+/*
+ * Clients like WSJT-X call rig_get_rig_info() several times a second to
+ * see whether anything changed.  Building the text takes two VFO reads
+ * and a CRC over the result, so the last text is kept with the cache
+ * sequence counter it was built at and handed out again until the cache
+ * is written or the cache timeout runs out.  A rebuild that comes out the
+ * same keeps its CRC and generation; only a different text moves the
+ * generation on, which is what rig_wait_rig_info() waits for.
+ */
+
+#include <hamlib/config.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "cache.h"
+#include "riginfo.h"
+
+#define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+//! @cond Doxygen_Suppress
+
+#define RIG_INFO_MAX 1024
+
+struct rig_info
+{
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t lock;
+    pthread_cond_t cond;        /* cache written, for rig_wait_rig_info() */
+#endif
+    int waiters;
+    int valid;
+    unsigned int seq;           /* cache_seqlock the text was built at */
+    struct timespec built;
+    unsigned int generation;    /* moves on when the text changes */
+    size_t body_len;            /* the text up to the CRC line */
+    char text[RIG_INFO_MAX];
+};
+
+#ifdef HAVE_PTHREAD
+#define INFO_LOCK(ri)   pthread_mutex_lock(&(ri)->lock)
+#define INFO_UNLOCK(ri) pthread_mutex_unlock(&(ri)->lock)
+#else
+#define INFO_LOCK(ri)
+#define INFO_UNLOCK(ri)
+#endif
+
+static void make_crc_table(unsigned long crcTable[])
+{
+    unsigned long POLYNOMIAL = 0xEDB88320;
+    unsigned char b = 0;
+
+    do
+    {
+        // Start with the data byte
+        unsigned long remainder = b;
+
+        unsigned long bit;
+
+        for (bit = 8; bit > 0; --bit)
+        {
+            if (remainder & 1)
+            {
+                remainder = (remainder >> 1) ^ POLYNOMIAL;
+            }
+            else
+            {
+                remainder = (remainder >> 1);
+            }
+        }
+
+        crcTable[(size_t)b] = remainder;
+    }
+    while (0 != ++b);
+}
+
+static unsigned long crcTable[256];
+
+static unsigned long gen_crc(unsigned char *p, size_t n)
+{
+    unsigned long crc = 0xfffffffful;
+    size_t i;
+
+    if (crcTable[0] == 0) { make_crc_table(crcTable); }
+
+    for (i = 0; i < n; i++)
+    {
+        crc = crcTable[*p++ ^ (crc & 0xff)] ^ (crc >> 8);
+    }
+
+    return ((~crc) & 0xffffffff);
+}
+
+int rig_info_init(RIG *rig)
+{
+    struct rig_info *ri = calloc(1, sizeof(*ri));
+
+    if (!ri) { return -RIG_ENOMEM; }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init(&ri->lock, NULL);
+    pthread_cond_init(&ri->cond, NULL);
+#endif
+    rig->state.rig_info = ri;
+
+    return RIG_OK;
+}
+
+void rig_info_free(RIG *rig)
+{
+    struct rig_info *ri = rig->state.rig_info;
+
+    if (!ri) { return; }
+
+#ifdef HAVE_PTHREAD
+    pthread_mutex_destroy(&ri->lock);
+    pthread_cond_destroy(&ri->cond);
+#endif
+    free(ri);
+    rig->state.rig_info = NULL;
+}
+
+int rig_info_cached(RIG *rig, char *response, int max_response_len)
+{
+    struct rig_info *ri = rig->state.rig_info;
+    int timeout_ms = rig->state.cache.timeout_ms;
+    int ok;
+
+    if (!ri || timeout_ms == 0) { return 0; }
+
+    INFO_LOCK(ri);
+
+    ok = ri->valid && ri->seq == rig->state.cache_seqlock
+         && strlen(ri->text) < (size_t) max_response_len
+         && (timeout_ms == HAMLIB_CACHE_ALWAYS
+             || elapsed_ms(&ri->built, HAMLIB_ELAPSED_GET) < timeout_ms);
+
+    if (ok) { strcpy(response, ri->text); }
+
+    INFO_UNLOCK(ri);
+
+    return ok;
+}
+
+void rig_info_store(RIG *rig, char *response, int max_response_len,
+                    unsigned int seq)
+{
+    struct rig_info *ri = rig->state.rig_info;
+    size_t len = strlen(response);
+    char crcstr[32];
+
+    if (!ri || len >= sizeof(ri->text) - sizeof(crcstr))
+    {
+        SNPRINTF(crcstr, sizeof(crcstr), "CRC=0x%08lx\n",
+                 gen_crc((unsigned char *)response, len));
+        strncat(response, crcstr, max_response_len - len - 1);
+        return;
+    }
+
+    INFO_LOCK(ri);
+
+    if (!ri->valid || ri->body_len != len || memcmp(ri->text, response, len))
+    {
+        memcpy(ri->text, response, len);
+        SNPRINTF(crcstr, sizeof(crcstr), "CRC=0x%08lx\n",
+                 gen_crc((unsigned char *)response, len));
+        strcpy(ri->text + len, crcstr);
+        ri->body_len = len;
+        ri->generation++;
+    }
+
+    ri->seq = seq;
+    ri->valid = 1;
+    elapsed_ms(&ri->built, HAMLIB_ELAPSED_SET);
+
+    strncat(response, ri->text + len, max_response_len - len - 1);
+
+    INFO_UNLOCK(ri);
+}
+
+void rig_info_cache_written(RIG *rig)
+{
+#ifdef HAVE_PTHREAD
+    struct rig_info *ri = rig->state.rig_info;
+
+    if (!ri) { return; }
+
+    // pairs with the fence in rig_wait_rig_info(): it sees our write or we see it waiting
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&ri->waiters, __ATOMIC_RELAXED) == 0) { return; }
+
+    pthread_mutex_lock(&ri->lock);
+    pthread_cond_broadcast(&ri->cond);
+    pthread_mutex_unlock(&ri->lock);
+#else
+    (void) rig;
+#endif
+}
+
+//! @endcond
+
+/**
+ * \brief wait for rig_get_rig_info() to change
+ * \param rig   The rig handle
+ * \param response  The location where to store the info, as rig_get_rig_info()
+ * \param max_response_len  Size of response
+ * \param generation  In: the generation the caller has seen, 0 for none.
+ * Out: the generation of the info returned.
+ * \param timeout_ms  How long to wait for a change
+ *
+ * Returns at once when the info differs from the one with \a generation,
+ * otherwise sleeps until the cache is written by another thread -- the
+ * poll routine, async data from the rig or another client -- and the info
+ * has changed, or until \a timeout_ms is up.  Long-polling clients use it
+ * in place of calling rig_get_rig_info() in a loop and do no work while
+ * nothing changes.
+ *
+ * \return RIG_OK with the new info, -RIG_ETIMEOUT with the unchanged info
+ * when nothing changed in time, or the error of rig_get_rig_info().
+ *
+ * \sa rig_get_rig_info()
+ */
+int HAMLIB_API rig_wait_rig_info(RIG *rig, char *response, int max_response_len,
+                                 unsigned int *generation, int timeout_ms)
+{
+    struct rig_info *ri;
+#ifdef HAVE_PTHREAD
+    struct timespec deadline;
+    struct timeval tv;
+#endif
+    unsigned int gen;
+    int ret;
+
+    if (CHECK_RIG_ARG(rig) || !response || !generation)
+    {
+        return -RIG_EINVAL;
+    }
+
+    ri = rig->state.rig_info;
+
+    if (!ri) { return -RIG_EINTERNAL; }
+
+#ifdef HAVE_PTHREAD
+    gettimeofday(&tv, NULL);
+    deadline.tv_sec = tv.tv_sec + timeout_ms / 1000;
+    deadline.tv_nsec = tv.tv_usec * 1000L + (timeout_ms % 1000) * 1000000L;
+
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+#endif
+
+    for (;;)
+    {
+        // taken before the build so a write during it is not slept through
+        unsigned int seq = rig_cache_read_begin(rig);
+        int timedout = 0;
+
+        ret = rig_get_rig_info(rig, response, max_response_len);
+
+        if (ret != RIG_OK) { return ret; }
+
+        INFO_LOCK(ri);
+        gen = ri->generation;
+        INFO_UNLOCK(ri);
+
+        if (gen != *generation)
+        {
+            *generation = gen;
+            return RIG_OK;
+        }
+
+        if (timeout_ms <= 0) { return -RIG_ETIMEOUT; }
+
+#ifdef HAVE_PTHREAD
+        pthread_mutex_lock(&ri->lock);
+        __atomic_fetch_add(&ri->waiters, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        while (rig->state.cache_seqlock == seq && !timedout)
+        {
+            timedout = pthread_cond_timedwait(&ri->cond, &ri->lock,
+                                              &deadline) == ETIMEDOUT;
+        }
+
+        __atomic_fetch_sub(&ri->waiters, 1, __ATOMIC_RELAXED);
+        pthread_mutex_unlock(&ri->lock);
+#else
+        // nobody else writes the cache, look once more after the timeout
+        hl_usleep(timeout_ms * 1000);
+        timeout_ms = 0;
+        (void) seq;
+#endif
+
+        if (timedout) { return -RIG_ETIMEOUT; }
+    }
+}
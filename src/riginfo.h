@@ -0,0 +1,49 @@
+/*
+ *  Hamlib Interface - prebuilt rig_get_rig_info() text
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef _RIGINFO_H
+#define _RIGINFO_H 1
+
+#include <hamlib/rig.h>
+
+/* rig_init()/rig_cleanup() */
+int rig_info_init(RIG *rig);
+void rig_info_free(RIG *rig);
+
+/*
+ * rig_get_rig_info() asks for the text as last built before building it:
+ * 1 and the text in response while the cache has not been written since
+ * seq and the text is younger than the cache timeout, 0 otherwise.
+ */
+int rig_info_cached(RIG *rig, char *response, int max_response_len);
+/*
+ * Takes a freshly built text without its CRC line, built from the cache
+ * as it was at seq, and appends the CRC.  The generation moves on only
+ * when the text differs from the last one.
+ */
+void rig_info_store(RIG *rig, char *response, int max_response_len,
+                    unsigned int seq);
+
+/* Wakes rig_wait_rig_info(), called by rig_cache_write_end() */
+void rig_info_cache_written(RIG *rig);
+
+#endif /* _RIGINFO_H */
@@ -0,0 +1,608 @@
+/*
+ *  Hamlib Interface - asynchronous request queue
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * rig_submit() lets GUI applications hand a request to Hamlib and carry
+ * on, instead of blocking on the CAT round trip.  Requests are queued per
+ * RIG and executed in order by one I/O thread, started on the first
+ * submit and stopped by rig_close().
+ *
+ * A queued setter that a newer request of the same kind makes redundant
+ * (set_freq on the same VFO while someone spins the knob) is dropped
+ * before it reaches the rig and completed with req->coalesced set.
+ * Setters are never merged across a VFO, split or PTT change.
+ *
+ * With the "coalesce" conf set, rig_set_freq() and rig_set_mode() go
+ * through the queue as well: they update the cache and return at once,
+ * and the I/O thread sends the latest value at most once per window so a
+ * dragged panadapter does not stack up serial round trips.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "rigqueue.h"
+#include "misc.h"
+
+#define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+static int rig_request_execute(RIG *rig, struct rig_request *req)
+{
+    switch (req->type)
+    {
+    case RIG_REQ_SET_FREQ:
+        return rig_set_freq(rig, req->vfo, req->freq);
+
+    case RIG_REQ_GET_FREQ:
+        return rig_get_freq(rig, req->vfo, &req->freq);
+
+    case RIG_REQ_SET_MODE:
+        return rig_set_mode(rig, req->vfo, req->mode, req->width);
+
+    case RIG_REQ_GET_MODE:
+        return rig_get_mode(rig, req->vfo, &req->mode, &req->width);
+
+    case RIG_REQ_SET_VFO:
+        return rig_set_vfo(rig, req->vfo);
+
+    case RIG_REQ_GET_VFO:
+        return rig_get_vfo(rig, &req->vfo);
+
+    case RIG_REQ_SET_PTT:
+        return rig_set_ptt(rig, req->vfo, req->ptt);
+
+    case RIG_REQ_GET_PTT:
+        return rig_get_ptt(rig, req->vfo, &req->ptt);
+
+    case RIG_REQ_SET_SPLIT_VFO:
+        return rig_set_split_vfo(rig, req->vfo, req->split, req->tx_vfo);
+
+    case RIG_REQ_GET_SPLIT_VFO:
+        return rig_get_split_vfo(rig, req->vfo, &req->split, &req->tx_vfo);
+
+    case RIG_REQ_SET_SPLIT_FREQ:
+        return rig_set_split_freq(rig, req->vfo, req->freq);
+
+    case RIG_REQ_SET_LEVEL:
+        return rig_set_level(rig, req->vfo, req->setting, req->val);
+
+    case RIG_REQ_GET_LEVEL:
+        return rig_get_level(rig, req->vfo, req->setting, &req->val);
+
+    case RIG_REQ_SET_FUNC:
+        return rig_set_func(rig, req->vfo, req->setting, req->status);
+
+    case RIG_REQ_GET_FUNC:
+        return rig_get_func(rig, req->vfo, req->setting, &req->status);
+
+    case RIG_REQ_VERIFY_PTT:
+        elapsed_ms(&rig->state.cache.time_ptt, HAMLIB_ELAPSED_INVALIDATE);
+        return rig_get_ptt(rig, req->vfo, &req->ptt);
+
+    default:
+        rig_debug(RIG_DEBUG_ERR, "%s: unknown request type %d\n", __func__,
+                  req->type);
+        return -RIG_EINVAL;
+    }
+}
+
+static void rig_request_complete(RIG *rig, struct rig_request *req, int retval)
+{
+    req->retcode = retval;
+
+    if (req->cb)
+    {
+        req->cb(rig, req, req->cb_arg);
+    }
+}
+
+#ifdef HAVE_PTHREAD
+
+struct rig_queue
+{
+    RIG *rig;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t work;    // signalled on submit and on stop
+    pthread_cond_t idle;    // signalled when the queue has drained
+    struct rig_request *head;
+    struct rig_request *tail;
+    int busy;               // the I/O thread is executing a request
+    int run;
+    struct timespec last_sent[RIG_REQ_GET_FUNC + 1];  // per type, for coalesce_ms
+};
+
+/* requests that change what RIG_VFO_CURR or TX means for the ones behind */
+static int rig_request_is_barrier(const struct rig_request *req)
+{
+    switch (req->type)
+    {
+    case RIG_REQ_SET_VFO:
+    case RIG_REQ_SET_SPLIT_VFO:
+    case RIG_REQ_SET_PTT:
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+/* setters that rs->coalesce_ms spaces out */
+static int rig_request_is_throttled(const struct rig_request *req)
+{
+    switch (req->type)
+    {
+    case RIG_REQ_SET_FREQ:
+    case RIG_REQ_SET_MODE:
+    case RIG_REQ_SET_SPLIT_FREQ:
+        return 1;
+
+    default:
+        return 0;
+    }
+}
+
+/*
+ * Non-zero while req has to wait out the coalescing window, with *due set
+ * to when it may go.  It stays at the head of the queue meanwhile, so
+ * newer values keep replacing it.
+ */
+static int rig_queue_hold(const struct rig_queue *q,
+                          const struct rig_request *req, struct timespec *due)
+{
+    int window = q->rig->state.coalesce_ms;
+    struct timespec now;
+
+    if (window <= 0 || !rig_request_is_throttled(req)
+            || q->last_sent[req->type].tv_sec == 0)
+    {
+        return 0;
+    }
+
+    *due = q->last_sent[req->type];
+    due->tv_sec += window / 1000;
+    due->tv_nsec += (long)(window % 1000) * 1000000L;
+
+    if (due->tv_nsec >= 1000000000L)
+    {
+        due->tv_sec++;
+        due->tv_nsec -= 1000000000L;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    return now.tv_sec < due->tv_sec
+           || (now.tv_sec == due->tv_sec && now.tv_nsec < due->tv_nsec);
+}
+
+/* newer makes older redundant: only the last value would stick anyway */
+static int rig_request_supersedes(const struct rig_request *newer,
+                                  const struct rig_request *older)
+{
+    if (newer->type != older->type || newer->vfo != older->vfo)
+    {
+        return 0;
+    }
+
+    switch (newer->type)
+    {
+    case RIG_REQ_SET_FREQ:
+    case RIG_REQ_SET_MODE:
+    case RIG_REQ_SET_SPLIT_FREQ:
+        return 1;
+
+    case RIG_REQ_SET_LEVEL:
+    case RIG_REQ_SET_FUNC:
+        return newer->setting == older->setting;
+
+    default:
+        return 0;
+    }
+}
+
+static void *rig_queue_thread(void *arg)
+{
+    struct rig_queue *q = (struct rig_queue *)arg;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: request queue thread started\n",
+              __func__);
+
+    pthread_mutex_lock(&q->lock);
+
+    for (;;)
+    {
+        struct rig_request *req;
+        struct timespec due;
+        int retval;
+
+        while (q->run && q->head == NULL)
+        {
+            pthread_cond_wait(&q->work, &q->lock);
+        }
+
+        if (!q->run)
+        {
+            break;
+        }
+
+        req = q->head;
+
+        if (rig_queue_hold(q, req, &due))
+        {
+            pthread_cond_timedwait(&q->work, &q->lock, &due);
+            continue;
+        }
+
+        if (rig_request_is_throttled(req))
+        {
+            clock_gettime(CLOCK_REALTIME, &q->last_sent[req->type]);
+        }
+
+        q->head = req->next;
+
+        if (q->head == NULL)
+        {
+            q->tail = NULL;
+        }
+
+        req->next = NULL;
+        q->busy = 1;
+        pthread_mutex_unlock(&q->lock);
+
+        retval = rig_request_execute(q->rig, req);
+
+        if (retval != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: request type %d failed: %s\n",
+                      __func__, req->type, rigerror(retval));
+        }
+
+        rig_request_complete(q->rig, req, retval);
+
+        pthread_mutex_lock(&q->lock);
+        q->busy = 0;
+
+        if (q->head == NULL)
+        {
+            pthread_cond_broadcast(&q->idle);
+        }
+    }
+
+    pthread_mutex_unlock(&q->lock);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: request queue thread stopped\n",
+              __func__);
+
+    return NULL;
+}
+
+static struct rig_queue *rig_queue_get(RIG *rig)
+{
+    static pthread_mutex_t create_lock = PTHREAD_MUTEX_INITIALIZER;
+    struct rig_queue *q;
+
+    pthread_mutex_lock(&create_lock);
+
+    q = (struct rig_queue *)rig->state.submit_queue;
+
+    if (q == NULL)
+    {
+        q = calloc(1, sizeof(struct rig_queue));
+
+        if (q == NULL)
+        {
+            pthread_mutex_unlock(&create_lock);
+            return NULL;
+        }
+
+        q->rig = rig;
+        q->run = 1;
+        pthread_mutex_init(&q->lock, NULL);
+        pthread_cond_init(&q->work, NULL);
+        pthread_cond_init(&q->idle, NULL);
+
+        if (pthread_create(&q->thread, NULL, rig_queue_thread, q) != 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: pthread_create error: %s\n", __func__,
+                      strerror(errno));
+            pthread_cond_destroy(&q->idle);
+            pthread_cond_destroy(&q->work);
+            pthread_mutex_destroy(&q->lock);
+            free(q);
+            pthread_mutex_unlock(&create_lock);
+            return NULL;
+        }
+
+        rig->state.submit_queue = q;
+    }
+
+    pthread_mutex_unlock(&create_lock);
+
+    return q;
+}
+
+void rig_queue_stop(RIG *rig)
+{
+    struct rig_queue *q = (struct rig_queue *)rig->state.submit_queue;
+    struct rig_request *req;
+
+    if (q == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&q->lock);
+    q->run = 0;
+    req = q->head;
+    q->head = q->tail = NULL;
+    pthread_cond_broadcast(&q->work);
+    pthread_mutex_unlock(&q->lock);
+
+    pthread_join(q->thread, NULL);
+
+    /* the port is about to go away, fail whatever did not get sent */
+    while (req)
+    {
+        struct rig_request *next = req->next;
+
+        req->next = NULL;
+        rig_request_complete(rig, req, -RIG_EIO);
+        req = next;
+    }
+
+    pthread_cond_destroy(&q->idle);
+    pthread_cond_destroy(&q->work);
+    pthread_mutex_destroy(&q->lock);
+    free(q);
+    rig->state.submit_queue = NULL;
+}
+
+int rig_queue_is_worker(RIG *rig)
+{
+    const struct rig_queue *q = (struct rig_queue *)rig->state.submit_queue;
+
+    return q != NULL && pthread_equal(q->thread, pthread_self());
+}
+
+int rig_queue_coalescing(RIG *rig)
+{
+    return rig->state.coalesce_ms > 0 && !rig_queue_is_worker(rig);
+}
+
+#else /* !HAVE_PTHREAD */
+
+void rig_queue_stop(RIG *rig)
+{
+}
+
+int rig_queue_is_worker(RIG *rig)
+{
+    return 0;
+}
+
+int rig_queue_coalescing(RIG *rig)
+{
+    return 0;
+}
+
+#endif /* HAVE_PTHREAD */
+
+static void rig_queue_free_cb(RIG *rig, struct rig_request *req,
+                              rig_ptr_t arg)
+{
+    if (req->retcode != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: coalesced request type %d failed: %s\n",
+                  __func__, req->type, rigerror(req->retcode));
+    }
+
+    free(req);
+}
+
+int rig_queue_coalesce(RIG *rig, const struct rig_request *tmpl)
+{
+    struct rig_request *req = malloc(sizeof(struct rig_request));
+    int retval;
+
+    if (req == NULL)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    *req = *tmpl;
+    retval = rig_submit(rig, req, rig_queue_free_cb, NULL);
+
+    if (retval != RIG_OK)
+    {
+        free(req);
+    }
+
+    return retval;
+}
+
+
+/**
+ * \brief queue a request for the rig without waiting for it
+ * \param rig   The rig handle
+ * \param req   The request, owned by the caller until \a cb has run
+ * \param cb    Completion callback, may be NULL
+ * \param arg   Opaque pointer passed to \a cb
+ *
+ * Hands \a req to the rig's I/O thread, which executes queued requests in
+ * order with the ordinary rig_set_xxx()/rig_get_xxx() calls and then runs
+ * \a cb with req->retcode set.  A still-queued set_freq, set_mode,
+ * set_split_freq, set_level or set_func for the same VFO (and setting) is
+ * replaced by \a req; its callback runs right away from this call with
+ * req->coalesced set and RIG_OK.  Without pthread support the request is
+ * executed before rig_submit() returns.
+ *
+ * The I/O thread goes through the same per-RIG lock as every other API
+ * call, so direct calls from other threads may be mixed with rig_submit();
+ * they run in between queued requests rather than in order with them.
+ *
+ * \return RIG_OK if the request was queued, otherwise a negative value if
+ * an error occurred (in which case \a cb is not called).
+ *
+ * \sa rig_submit_wait()
+ */
+int HAMLIB_API rig_submit(RIG *rig, struct rig_request *req,
+                          rig_request_cb_t cb, rig_ptr_t arg)
+{
+#ifdef HAVE_PTHREAD
+    struct rig_queue *q;
+    struct rig_request *r, *prev = NULL, *match = NULL, *match_prev = NULL;
+#endif
+
+    if (CHECK_RIG_ARG(rig) || !req)
+    {
+        return -RIG_EINVAL;
+    }
+
+    req->cb = cb;
+    req->cb_arg = arg;
+    req->retcode = RIG_OK;
+    req->coalesced = 0;
+    req->next = NULL;
+
+#ifdef HAVE_PTHREAD
+    q = rig_queue_get(rig);
+
+    if (q == NULL)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    /* the newest redundant request since the last barrier, if any */
+    for (r = q->head; r; prev = r, r = r->next)
+    {
+        if (rig_request_is_barrier(r))
+        {
+            match = match_prev = NULL;
+        }
+        else if (rig_request_supersedes(req, r))
+        {
+            match = r;
+            match_prev = prev;
+        }
+    }
+
+    if (match)
+    {
+        /* take over its place in line, it was going out first anyway */
+        req->next = match->next;
+
+        if (match_prev)
+        {
+            match_prev->next = req;
+        }
+        else
+        {
+            q->head = req;
+        }
+
+        if (q->tail == match)
+        {
+            q->tail = req;
+        }
+
+        match->next = NULL;
+    }
+    else if (q->tail)
+    {
+        q->tail->next = req;
+        q->tail = req;
+    }
+    else
+    {
+        q->head = q->tail = req;
+    }
+
+    pthread_cond_signal(&q->work);
+    pthread_mutex_unlock(&q->lock);
+
+    if (match)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: request type %d coalesced\n", __func__,
+                  match->type);
+        match->coalesced = 1;
+        rig_request_complete(rig, match, RIG_OK);
+    }
+
+#else
+    rig_request_complete(rig, req, rig_request_execute(rig, req));
+#endif
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief wait until all requests queued with rig_submit() have completed
+ * \param rig   The rig handle
+ *
+ * Must not be called from a completion callback.
+ *
+ * \return RIG_OK, or a negative value if \a rig is invalid.
+ *
+ * \sa rig_submit()
+ */
+int HAMLIB_API rig_submit_wait(RIG *rig)
+{
+#ifdef HAVE_PTHREAD
+    struct rig_queue *q;
+#endif
+
+    if (CHECK_RIG_ARG(rig))
+    {
+        return -RIG_EINVAL;
+    }
+
+#ifdef HAVE_PTHREAD
+    q = (struct rig_queue *)rig->state.submit_queue;
+
+    if (q == NULL || rig_queue_is_worker(rig))
+    {
+        return RIG_OK;
+    }
+
+    pthread_mutex_lock(&q->lock);
+
+    while (q->run && (q->head || q->busy))
+    {
+        pthread_cond_wait(&q->idle, &q->lock);
+    }
+
+    pthread_mutex_unlock(&q->lock);
+#endif
+
+    return RIG_OK;
+}
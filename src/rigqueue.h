@@ -0,0 +1,39 @@
+/*
+ *  Hamlib Interface - asynchronous request queue
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _RIGQUEUE_H
+#define _RIGQUEUE_H 1
+
+#include <hamlib/rig.h>
+
+/* Stop the rig_submit() I/O thread, failing queued requests with -RIG_EIO */
+void rig_queue_stop(RIG *rig);
+
+/* Non-zero when called from the rig_submit() I/O thread */
+int rig_queue_is_worker(RIG *rig);
+
+/* Non-zero when rig_set_freq()/rig_set_mode() should go through the queue */
+int rig_queue_coalescing(RIG *rig);
+
+/* Queue a heap copy of tmpl, freed once it completes or is coalesced */
+int rig_queue_coalesce(RIG *rig, const struct rig_request *tmpl);
+
+#endif /* _RIGQUEUE_H */
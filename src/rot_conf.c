@@ -42,6 +42,7 @@
 
 #include "rot_conf.h"
 #include "token.h"
+#include "conf_index.h"
 
 
 /*
@@ -104,6 +105,26 @@ static const struct confparams rotfrontend_cfg_params[] =
         "Adjust azimuth 180 degrees for south oriented rotators",
         "0", RIG_CONF_CHECKBUTTON,
     },
+    {
+        TOK_ROT_CACHE_TIMEOUT, "cache_timeout", "Cache timeout",
+        "How long in ms a position or status reading is reused, 0 always asks the rotator",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 5000, 1 } }
+    },
+    {
+        TOK_ROT_DEADBAND, "deadband", "Deadband",
+        "Degrees a new position must differ from the last one sent, 0 sends every position",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 90, .1 } }
+    },
+    {
+        TOK_ROT_MIN_STEP, "min_step", "Minimum step",
+        "Degrees positions are rounded to before sending, 0 sends them as given",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 90, .1 } }
+    },
+    {
+        TOK_ROT_MIN_INTERVAL, "min_interval", "Minimum interval",
+        "Shortest time in ms between two positions sent, a new one waits for it",
+        "0", RIG_CONF_NUMERIC, { .n = { 0, 60000, 1 } }
+    },
 
     { RIG_CONF_END, NULL, }
 };
@@ -355,6 +376,22 @@ int frontrot_set_conf(ROT *rot, token_t token, const char *val)
         rs->south_zero = atoi(val);
         break;
 
+    case TOK_ROT_CACHE_TIMEOUT:
+        rs->cache.timeout_ms = atoi(val);
+        break;
+
+    case TOK_ROT_DEADBAND:
+        rs->move_filter.deadband = atof(val);
+        break;
+
+    case TOK_ROT_MIN_STEP:
+        rs->move_filter.min_step = atof(val);
+        break;
+
+    case TOK_ROT_MIN_INTERVAL:
+        rs->move_filter.min_interval_ms = atoi(val);
+        break;
+
     default:
         return -RIG_EINVAL;
     }
@@ -519,6 +556,22 @@ int frontrot_get_conf(ROT *rot, token_t token, char *val, int val_len)
         SNPRINTF(val, val_len, "%d", rs->south_zero);
         break;
 
+    case TOK_ROT_CACHE_TIMEOUT:
+        SNPRINTF(val, val_len, "%d", rs->cache.timeout_ms);
+        break;
+
+    case TOK_ROT_DEADBAND:
+        SNPRINTF(val, val_len, "%f", rs->move_filter.deadband);
+        break;
+
+    case TOK_ROT_MIN_STEP:
+        SNPRINTF(val, val_len, "%f", rs->move_filter.min_step);
+        break;
+
+    case TOK_ROT_MIN_INTERVAL:
+        SNPRINTF(val, val_len, "%d", rs->move_filter.min_interval_ms);
+        break;
+
     default:
         return -RIG_EINVAL;
     }
@@ -631,6 +684,20 @@ const struct confparams *HAMLIB_API rot_confparam_lookup(ROT *rot,
     /* 0 returned for invalid format */
     token = strtol(name, NULL, 0);
 
+    if (rot->state.conf_index)
+    {
+        const struct conf_index *idx = rot->state.conf_index;
+
+        cfp = conf_index_name(idx, name);
+
+        if (!cfp && token != RIG_CONF_END)
+        {
+            cfp = conf_index_token(idx, token);
+        }
+
+        return cfp;
+    }
+
     //rig_debug(RIG_DEBUG_TRACE, "%s: token=%d\n", __func__, (int)token);
     for (cfp = rot->caps->cfgparams; cfp && cfp->name; cfp++)
     {
@@ -697,6 +764,49 @@ token_t HAMLIB_API rot_token_lookup(ROT *rot, const char *name)
 }
 
 
+/* Hash the tables rot_confparam_lookup() and rot_ext_lookup() scan, in
+ * the order they scan them.  Without the index they scan as before. */
+void rot_conf_index_init(ROT *rot)
+{
+    struct rot_state *rs = &rot->state;
+    const struct confparams *conf[3];
+    const struct confparams *ext[3];
+    int n = 0;
+
+    conf[n++] = rot->caps->cfgparams;
+    conf[n++] = rotfrontend_cfg_params;
+
+    if (rot->caps->port_type == RIG_PORT_SERIAL)
+    {
+        conf[n++] = rotfrontend_serial_cfg_params;
+    }
+
+    rs->conf_index = conf_index_new(conf, n);
+
+    ext[0] = rot->caps->extlevels;
+    ext[1] = rot->caps->extfuncs;
+    ext[2] = rot->caps->extparms;
+    rs->ext_index = conf_index_new(ext, 3);
+
+    if (!rs->conf_index || !rs->ext_index)
+    {
+        rot_debug(RIG_DEBUG_WARN, "%s: no memory, linear lookups\n", __func__);
+        rot_conf_index_cleanup(rot);
+    }
+}
+
+
+void rot_conf_index_cleanup(ROT *rot)
+{
+    struct rot_state *rs = &rot->state;
+
+    conf_index_free(rs->conf_index);
+    conf_index_free(rs->ext_index);
+    rs->conf_index = NULL;
+    rs->ext_index = NULL;
+}
+
+
 /**
  * \brief Set a rotator configuration parameter.
  *
@@ -47,6 +47,7 @@
 #include <hamlib/rotator.h>
 
 #include "token.h"
+#include "conf_index.h"
 
 static int rot_has_ext_token(ROT *rot, token_t token)
 {
@@ -271,6 +272,11 @@ const struct confparams *HAMLIB_API rot_ext_lookup(ROT *rot, const char *name)
         return NULL;
     }
 
+    if (rot->state.ext_index)
+    {
+        return conf_index_name(rot->state.ext_index, name);
+    }
+
     for (cfp = rot->caps->extlevels; cfp && cfp->name; cfp++)
     {
         if (!strcmp(cfp->name, name))
@@ -323,6 +329,11 @@ const struct confparams *HAMLIB_API rot_ext_lookup_tok(ROT *rot, token_t token)
         return NULL;
     }
 
+    if (rot->state.ext_index)
+    {
+        return conf_index_token(rot->state.ext_index, token);
+    }
+
     for (cfp = rot->caps->extlevels; cfp && cfp->token; cfp++)
     {
         if (cfp->token == token)
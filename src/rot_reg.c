@@ -69,7 +69,10 @@ DEFINE_INITROT_BACKEND(fodtrack);
 DEFINE_INITROT_BACKEND(rotorez);
 DEFINE_INITROT_BACKEND(sartek);
 DEFINE_INITROT_BACKEND(gs232a);
+#ifndef HAMLIB_SKIP_RIG_KIT
+/* the kit rotators are built with the kit rig backend */
 DEFINE_INITROT_BACKEND(kit);
+#endif
 DEFINE_INITROT_BACKEND(heathkit);
 DEFINE_INITROT_BACKEND(spid);
 DEFINE_INITROT_BACKEND(m2);
@@ -117,7 +120,9 @@ static struct
     { ROT_ROTOREZ, ROT_BACKEND_ROTOREZ, ROT_FUNCNAMA(rotorez) },
     { ROT_SARTEK, ROT_BACKEND_SARTEK, ROT_FUNCNAMA(sartek) },
     { ROT_GS232A, ROT_BACKEND_GS232A, ROT_FUNCNAMA(gs232a) },
+#ifndef HAMLIB_SKIP_RIG_KIT
     { ROT_KIT, ROT_BACKEND_KIT, ROT_FUNCNAMA(kit) },
+#endif
     { ROT_HEATHKIT, ROT_BACKEND_HEATHKIT, ROT_FUNCNAMA(heathkit) },
     { ROT_SPID, ROT_BACKEND_SPID, ROT_FUNCNAMA(spid) },
     { ROT_M2, ROT_BACKEND_M2, ROT_FUNCNAMA(m2) },
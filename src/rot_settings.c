@@ -82,6 +82,7 @@
 int HAMLIB_API rot_set_level(ROT *rot, setting_t level, value_t val)
 {
     const struct rot_caps *caps;
+    int retval;
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -97,7 +98,12 @@ int HAMLIB_API rot_set_level(ROT *rot, setting_t level, value_t val)
         return -RIG_ENAVAIL;
     }
 
-    return caps->set_level(rot, level, val);
+    /* the trajectory scheduler may be talking to the controller */
+    pthread_mutex_lock(&rot->state.cache_lock);
+    retval = caps->set_level(rot, level, val);
+    pthread_mutex_unlock(&rot->state.cache_lock);
+
+    return retval;
 }
 
 
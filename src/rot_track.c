@@ -0,0 +1,678 @@
+/**
+ * \addtogroup rotator
+ * @{
+ */
+
+/**
+ * \file src/rot_track.c
+ * \brief Timestamped trajectories for satellite tracking
+ */
+
+/*
+ *  Hamlib Interface - rotator trajectory scheduler
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Tracking programs used to send a fresh rot_set_position() every second
+ * or so, which the controller executes as one step after another.  With
+ * rot_set_trajectory() they hand over the whole pass instead, and a
+ * scheduler thread feeds the controller:
+ *
+ *  - before the first point is due, the rotator is sent there at full
+ *    speed, so tracking starts on time.  The position is polled while it
+ *    gets there, which tells how fast the rotator slews.
+ *  - during the pass, setpoints are interpolated from the points, ahead
+ *    of time by what a command takes to reach the controller.  They go
+ *    out as often as the controller answers, within TRACK_PERIOD_MIN_MS
+ *    and TRACK_PERIOD_MAX_MS, and only when they moved by TRACK_DEADBAND.
+ *  - on rotators with ROT_LEVEL_SPEED, the speed follows what the current
+ *    segment needs, so the rotator moves smoothly instead of hurrying to
+ *    each setpoint and stopping.  The speed in use before is put back at
+ *    the end.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include <hamlib/rotator.h>
+#include "misc.h"
+#include "idx_builtin.h"
+#include "rot_track.h"
+
+#define CHECK_ROT_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+#define TRACK_PERIOD_MIN_MS 100
+#define TRACK_PERIOD_MAX_MS 1000
+/* setpoints are sent this many command times apart */
+#define TRACK_PERIOD_LATENCIES 4
+/* degrees a setpoint must move before it is sent */
+#define TRACK_DEADBAND 0.1
+/* speed headroom over what the trajectory needs */
+#define TRACK_SPEED_MARGIN 1.25
+/* slower than this in deg/s is taken as not moving */
+#define TRACK_SLEW_MIN 0.5
+
+struct rot_track
+{
+    ROT *rot;
+    pthread_t thread;
+    pthread_mutex_t lock;       /* guards pts, n, size, stop and done */
+    pthread_cond_t cond;
+    struct rot_point *pts;
+    int n;
+    int size;
+    int stop;
+    int done;
+    /* scheduler thread only */
+    double latency_ms;          /* average rot_set_position() time */
+    double slew;                /* deg/s seen at full speed, 0 until known */
+    int speed;                  /* last speed sent, -1 for none */
+};
+
+/* serializes rot_set_trajectory(), rot_add_trajectory() and cancels */
+static pthread_mutex_t track_handle_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static double track_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+/* wait with t->lock held, returns non-zero when asked to stop */
+static int track_wait_until(struct rot_track *t, double when)
+{
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)when;
+    ts.tv_nsec = (long)((when - (double)ts.tv_sec) * 1e9);
+
+    while (!t->stop && track_now() < when)
+    {
+        if (pthread_cond_timedwait(&t->cond, &t->lock, &ts) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+
+    return t->stop;
+}
+
+
+/* position due at time when, and the rate in deg/s of that segment */
+static void track_interp(const struct rot_track *t, double when,
+                         double *az, double *el, double *rate)
+{
+    const struct rot_point *a, *b;
+    double daz, del, f;
+    int i;
+
+    *rate = 0;
+
+    if (when <= t->pts[0].time || t->n == 1)
+    {
+        *az = t->pts[0].az;
+        *el = t->pts[0].el;
+        return;
+    }
+
+    if (when >= t->pts[t->n - 1].time)
+    {
+        *az = t->pts[t->n - 1].az;
+        *el = t->pts[t->n - 1].el;
+        return;
+    }
+
+    for (i = 1; t->pts[i].time <= when; i++)
+        ;
+
+    a = &t->pts[i - 1];
+    b = &t->pts[i];
+
+    /* go the short way across north, the range is fixed up below */
+    daz = b->az - a->az;
+
+    if (daz > 180) { daz -= 360; }
+    else if (daz < -180) { daz += 360; }
+
+    del = b->el - a->el;
+    f = (when - a->time) / (b->time - a->time);
+
+    *az = a->az + f * daz;
+    *el = a->el + f * del;
+    *rate = fmax(fabs(daz), fabs(del)) / (b->time - a->time);
+}
+
+
+/* would rot_set_position() take this azimuth */
+static int track_az_ok(const struct rot_state *rs, double az)
+{
+    az += rs->az_offset;
+
+    if (rs->south_zero)
+    {
+        az += az >= 180 ? -180 : 180;
+    }
+
+    return az >= rs->min_az && az <= rs->max_az;
+}
+
+
+static int track_send(struct rot_track *t, double az, double el)
+{
+    const struct rot_state *rs = &t->rot->state;
+    struct timespec start;
+    double ms;
+    int retval;
+
+    if (!track_az_ok(rs, az))
+    {
+        if (track_az_ok(rs, az + 360)) { az += 360; }
+        else if (track_az_ok(rs, az - 360)) { az -= 360; }
+    }
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    retval = rot_set_position(t->rot, (azimuth_t)az, (elevation_t)el);
+    ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+
+    t->latency_ms = t->latency_ms > 0 ? (3 * t->latency_ms + ms) / 4 : ms;
+
+    if (retval != RIG_OK)
+    {
+        rot_debug(RIG_DEBUG_WARN, "%s: set_position az=%.2f el=%.2f: %s\n",
+                  __func__, az, el, rigerror(retval));
+    }
+
+    return retval;
+}
+
+
+static int track_period_ms(const struct rot_track *t)
+{
+    double ms = TRACK_PERIOD_LATENCIES * t->latency_ms;
+
+    if (ms < TRACK_PERIOD_MIN_MS) { return TRACK_PERIOD_MIN_MS; }
+
+    if (ms > TRACK_PERIOD_MAX_MS) { return TRACK_PERIOD_MAX_MS; }
+
+    return (int)ms;
+}
+
+
+static void track_speed_range(ROT *rot, int *min, int *max)
+{
+    const gran_t *gran = &rot->state.level_gran[ROT_LVL_SPEED];
+
+    *min = gran->min.i > 0 ? gran->min.i : 1;
+    *max = gran->max.i > *min ? gran->max.i : 100;
+}
+
+
+static void track_set_speed(struct rot_track *t, int speed)
+{
+    value_t val;
+
+    if (speed == t->speed)
+    {
+        return;
+    }
+
+    val.i = speed;
+
+    if (rot_set_level(t->rot, ROT_LEVEL_SPEED, val) == RIG_OK)
+    {
+        t->speed = speed;
+    }
+}
+
+
+/* get onto the first point while it is not due yet, timing the slew */
+static int track_prerotate(struct rot_track *t, const struct rot_point *first,
+                           int use_speed, int speed_max)
+{
+    ROT *rot = t->rot;
+    azimuth_t az;
+    elevation_t el;
+    double prev_az = 0, prev_el = 0, prev_t = 0;
+    int poll = rot->caps->get_position != NULL;
+    int stop;
+
+    if (use_speed)
+    {
+        track_set_speed(t, speed_max);
+    }
+
+    track_send(t, first->az, first->el);
+
+    if (poll && rot_get_position(rot, &az, &el) == RIG_OK)
+    {
+        prev_az = az;
+        prev_el = el;
+        prev_t = track_now();
+    }
+    else
+    {
+        poll = 0;
+    }
+
+    for (;;)
+    {
+        double now = track_now();
+        double when = fmin(now + track_period_ms(t) / 1000.0, first->time);
+
+        pthread_mutex_lock(&t->lock);
+        stop = track_wait_until(t, when);
+        pthread_mutex_unlock(&t->lock);
+
+        if (stop || track_now() >= first->time)
+        {
+            return stop;
+        }
+
+        if (poll && rot_get_position(rot, &az, &el) == RIG_OK)
+        {
+            double dt = track_now() - prev_t;
+            double rate = fmax(fabs(az - prev_az), fabs(el - prev_el)) / dt;
+
+            if (rate >= TRACK_SLEW_MIN && rate > t->slew && rate < 360)
+            {
+                t->slew = rate;
+                rot_debug(RIG_DEBUG_VERBOSE, "%s: slews at %.1f deg/s\n", __func__,
+                          rate);
+            }
+
+            prev_az = az;
+            prev_el = el;
+            prev_t += dt;
+        }
+        else
+        {
+            poll = 0;
+        }
+    }
+}
+
+
+static void *track_thread(void *arg)
+{
+    struct rot_track *t = arg;
+    ROT *rot = t->rot;
+    struct rot_point first;
+    double last_az = 0, last_el = 0;
+    int orig_speed = rot->state.current_speed;
+    int use_speed = rot_has_set_level(rot, ROT_LEVEL_SPEED) != 0;
+    int speed_min, speed_max;
+    int sent = 0;
+
+    track_speed_range(rot, &speed_min, &speed_max);
+
+    pthread_mutex_lock(&t->lock);
+    first = t->pts[0];
+    pthread_mutex_unlock(&t->lock);
+
+    if (first.time > track_now())
+    {
+        if (track_prerotate(t, &first, use_speed, speed_max))
+        {
+            goto done;
+        }
+    }
+
+    for (;;)
+    {
+        double now, when, az, el, rate, end;
+        int stop;
+
+        now = track_now();
+        when = now + t->latency_ms / 1000.0;
+
+        pthread_mutex_lock(&t->lock);
+
+        if (t->stop)
+        {
+            pthread_mutex_unlock(&t->lock);
+            break;
+        }
+
+        track_interp(t, when, &az, &el, &rate);
+        end = t->pts[t->n - 1].time;
+        pthread_mutex_unlock(&t->lock);
+
+        if (use_speed && t->slew > 0 && rate > 0)
+        {
+            double need = rate * TRACK_SPEED_MARGIN / t->slew;
+            int speed = speed_min + (int)ceil(fmin(need, 1) * (speed_max - speed_min));
+
+            track_set_speed(t, speed);
+        }
+
+        if (!sent || fabs(az - last_az) >= TRACK_DEADBAND
+                || fabs(el - last_el) >= TRACK_DEADBAND)
+        {
+            if (track_send(t, az, el) == RIG_OK)
+            {
+                last_az = az;
+                last_el = el;
+                sent = 1;
+            }
+        }
+
+        if (when >= end)
+        {
+            break;
+        }
+
+        pthread_mutex_lock(&t->lock);
+        stop = track_wait_until(t, now + track_period_ms(t) / 1000.0);
+        pthread_mutex_unlock(&t->lock);
+
+        if (stop)
+        {
+            break;
+        }
+    }
+
+done:
+
+    if (t->speed >= 0 && t->speed != orig_speed)
+    {
+        track_set_speed(t, orig_speed);
+    }
+
+    pthread_mutex_lock(&t->lock);
+    t->done = 1;
+    pthread_mutex_unlock(&t->lock);
+
+    return NULL;
+}
+
+
+static int track_check(const struct rot_point *pts, int n, double after)
+{
+    int i;
+
+    for (i = 0; i < n; i++)
+    {
+        if (pts[i].time <= after)
+        {
+            return -RIG_EINVAL;
+        }
+
+        after = pts[i].time;
+    }
+
+    return RIG_OK;
+}
+
+
+static void track_free(struct rot_track *t)
+{
+    pthread_cond_destroy(&t->cond);
+    pthread_mutex_destroy(&t->lock);
+    free(t->pts);
+    free(t);
+}
+
+
+/* with track_handle_lock held */
+static void track_cancel_locked(ROT *rot)
+{
+    struct rot_track *t = rot->state.trajectory;
+
+    if (!t)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&t->lock);
+    t->stop = 1;
+    pthread_cond_signal(&t->cond);
+    pthread_mutex_unlock(&t->lock);
+
+    pthread_join(t->thread, NULL);
+    rot->state.trajectory = NULL;
+    track_free(t);
+}
+
+
+/* with track_handle_lock held */
+static int track_start_locked(ROT *rot, const struct rot_point *pts, int n)
+{
+    struct rot_track *t;
+    int retval;
+
+    track_cancel_locked(rot);
+
+    if (n == 0)
+    {
+        return RIG_OK;
+    }
+
+    t = calloc(1, sizeof(*t));
+
+    if (!t)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    t->pts = malloc(n * sizeof(*pts));
+
+    if (!t->pts)
+    {
+        free(t);
+        return -RIG_ENOMEM;
+    }
+
+    memcpy(t->pts, pts, n * sizeof(*pts));
+    t->n = t->size = n;
+    t->rot = rot;
+    t->speed = -1;
+    pthread_mutex_init(&t->lock, NULL);
+    pthread_cond_init(&t->cond, NULL);
+
+    retval = pthread_create(&t->thread, NULL, track_thread, t);
+
+    if (retval != 0)
+    {
+        rot_debug(RIG_DEBUG_ERR, "%s: pthread_create error: %s\n", __func__,
+                  strerror(retval));
+        track_free(t);
+        return -RIG_EINTERNAL;
+    }
+
+    rot->state.trajectory = t;
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Follow a timestamped trajectory.
+ *
+ * \param rot The #ROT handle.
+ * \param pts The points, in increasing time order.
+ * \param n The number of points, 0 to stop following a trajectory.
+ *
+ * Replaces any trajectory in progress.  A background thread moves the
+ * rotator to the first point straight away and then steers along the
+ * points, interpolating between them, until the last one is reached.
+ * Points in the past are passed by.  rot_stop() and rot_close() end the
+ * trajectory.
+ *
+ * Azimuth is interpolated the short way round and brought into the
+ * min_az..max_az range where possible.
+ *
+ * \return RIG_OK if the trajectory was started, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_OK The trajectory was started.
+ * \retval RIG_EINVAL \a rot is NULL or inconsistent, or the points are not
+ * in increasing time order.
+ * \retval RIG_ENAVAIL rot_caps#set_position() capability is not available.
+ *
+ * \sa rot_add_trajectory()
+ */
+int HAMLIB_API rot_set_trajectory(ROT *rot, const struct rot_point *pts, int n)
+{
+    int retval;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called, %d points\n", __func__, n);
+
+    if (CHECK_ROT_ARG(rot) || n < 0 || (n > 0 && !pts))
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (rot->caps->set_position == NULL)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    retval = track_check(pts, n, -HUGE_VAL);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    pthread_mutex_lock(&track_handle_lock);
+    retval = track_start_locked(rot, pts, n);
+    pthread_mutex_unlock(&track_handle_lock);
+
+    return retval;
+}
+
+
+/**
+ * \brief Extend the trajectory in progress.
+ *
+ * \param rot The #ROT handle.
+ * \param pts The points to append, in increasing time order and after the
+ * last point already given.
+ * \param n The number of points.
+ *
+ * Lets tracking programs hand over a pass a few points at a time.  When no
+ * trajectory is in progress, this is the same as rot_set_trajectory().
+ *
+ * \return RIG_OK if the points were added, otherwise a **negative value**
+ * if an error occurred (in which case, cause is set appropriately).
+ *
+ * \sa rot_set_trajectory()
+ */
+int HAMLIB_API rot_add_trajectory(ROT *rot, const struct rot_point *pts, int n)
+{
+    struct rot_track *t;
+    int retval;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called, %d points\n", __func__, n);
+
+    if (CHECK_ROT_ARG(rot) || n < 0 || (n > 0 && !pts))
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (rot->caps->set_position == NULL)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    if (n == 0)
+    {
+        return RIG_OK;
+    }
+
+    pthread_mutex_lock(&track_handle_lock);
+
+    t = rot->state.trajectory;
+
+    if (t)
+    {
+        pthread_mutex_lock(&t->lock);
+
+        if (t->done)
+        {
+            pthread_mutex_unlock(&t->lock);
+            t = NULL;
+        }
+    }
+
+    if (!t)
+    {
+        retval = track_check(pts, n, -HUGE_VAL);
+
+        if (retval == RIG_OK)
+        {
+            retval = track_start_locked(rot, pts, n);
+        }
+
+        pthread_mutex_unlock(&track_handle_lock);
+        return retval;
+    }
+
+    retval = track_check(pts, n, t->pts[t->n - 1].time);
+
+    if (retval == RIG_OK && t->n + n > t->size)
+    {
+        int size = t->size * 2 > t->n + n ? t->size * 2 : t->n + n;
+        struct rot_point *p = realloc(t->pts, size * sizeof(*p));
+
+        if (p)
+        {
+            t->pts = p;
+            t->size = size;
+        }
+        else
+        {
+            retval = -RIG_ENOMEM;
+        }
+    }
+
+    if (retval == RIG_OK)
+    {
+        memcpy(t->pts + t->n, pts, n * sizeof(*pts));
+        t->n += n;
+        pthread_cond_signal(&t->cond);
+    }
+
+    pthread_mutex_unlock(&t->lock);
+    pthread_mutex_unlock(&track_handle_lock);
+
+    return retval;
+}
+
+
+/* rot_stop() and rot_close() end the trajectory before they go ahead */
+void rot_track_cancel(ROT *rot)
+{
+    pthread_mutex_lock(&track_handle_lock);
+    track_cancel_locked(rot);
+    pthread_mutex_unlock(&track_handle_lock);
+}
+
+/** @} */
@@ -52,6 +52,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <math.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -65,6 +66,9 @@
 #include "network.h"
 #include "rot_conf.h"
 #include "token.h"
+#include "misc.h"
+#include "rot_track.h"
+#include "conf_index.h"
 
 
 #ifndef DOC_HIDDEN
@@ -149,6 +153,118 @@ static int remove_opened_rot(const ROT *rot)
 
     return -RIG_EINVAL; /* Not found in list ! */
 }
+
+
+/*
+ * Position and status cache.  A reader that misses holds cache_lock while
+ * it asks the controller, and anyone who queued up on the lock meanwhile
+ * takes that answer instead of asking again.  rotctld clients polling the
+ * same rotator thus share one controller query, even with cache_timeout 0.
+ *
+ * Commands that move the rotator hold the lock too, so they do not cut
+ * into a query from another thread such as the trajectory scheduler.
+ */
+static void rot_cache_invalidate(ROT *rot)
+{
+    elapsed_ms(&rot->state.cache.time_position, HAMLIB_ELAPSED_INVALIDATE);
+    elapsed_ms(&rot->state.cache.time_status, HAMLIB_ELAPSED_INVALIDATE);
+    rot->state.move_filter.valid = 0;
+}
+
+
+static int rot_cache_fresh(const struct rot_state *rs, struct timespec *t)
+{
+    return rs->cache.timeout_ms > 0
+           && elapsed_ms(t, HAMLIB_ELAPSED_GET) < rs->cache.timeout_ms;
+}
+
+
+static void rot_cache_store_position(struct rot_state *rs, azimuth_t az,
+                                     elevation_t el)
+{
+    rs->cache.az = az;
+    rs->cache.el = el;
+    elapsed_ms(&rs->cache.time_position, HAMLIB_ELAPSED_SET);
+    rs->cache.position_seq++;
+}
+
+
+static void rot_cache_store_status(struct rot_state *rs, rot_status_t status)
+{
+    rs->cache.status = status;
+    elapsed_ms(&rs->cache.time_status, HAMLIB_ELAPSED_SET);
+    rs->cache.status_seq++;
+}
+
+
+/* from the controller's frame to the caller's: south_zero, then offsets */
+static void rot_position_to_user(const struct rot_state *rs, azimuth_t az,
+                                 elevation_t el, azimuth_t *azimuth,
+                                 elevation_t *elevation)
+{
+    if (rs->south_zero)
+    {
+        az += az >= 180 ? -180 : 180;
+        rot_debug(RIG_DEBUG_VERBOSE, "%s: south adj to az=%.2f\n", __func__, az);
+    }
+
+    *azimuth = az - rs->az_offset;
+    *elevation = el - rs->el_offset;
+}
+
+
+/* the rotator is told to move, what we read before no longer holds */
+static void rot_cache_move_begin(ROT *rot)
+{
+    pthread_mutex_lock(&rot->state.cache_lock);
+}
+
+
+static int rot_cache_move_end(ROT *rot, int retval)
+{
+    rot_cache_invalidate(rot);
+    pthread_mutex_unlock(&rot->state.cache_lock);
+
+    return retval;
+}
+
+
+static float rot_move_round(float val, float step, float min, float max)
+{
+    if (step <= 0)
+    {
+        return val;
+    }
+
+    val = roundf(val / step) * step;
+
+    return val < min ? min : val > max ? max : val;
+}
+
+
+/*
+ * Rounds the target to min_step and tells whether it is worth sending, i.e.
+ * it is outside the deadband around the last position sent.  Called with
+ * cache_lock held.
+ */
+static int rot_move_wanted(ROT *rot, azimuth_t *az, elevation_t *el)
+{
+    const struct rot_state *rs = &rot->state;
+    const struct rot_move_filter *mf = &rs->move_filter;
+    int type = rot->caps->rot_type;
+
+    *az = rot_move_round(*az, mf->min_step, rs->min_az, rs->max_az);
+    *el = rot_move_round(*el, mf->min_step, rs->min_el, rs->max_el);
+
+    if (!mf->valid)
+    {
+        return 1;
+    }
+
+    /* an axis the rotator does not have cannot make it move */
+    return ((type & ROT_FLAG_AZIMUTH) && fabsf(*az - mf->az) > mf->deadband)
+           || ((type & ROT_FLAG_ELEVATION) && fabsf(*el - mf->el) > mf->deadband);
+}
 #endif /* !DOC_HIDDEN */
 
 /** @} */ /* rotator definitions */
@@ -309,6 +425,9 @@ ROT *HAMLIB_API rot_init(rot_model_t rot_model)
     memcpy(rs->level_gran, caps->level_gran, sizeof(gran_t)*RIG_SETTING_MAX);
     memcpy(rs->parm_gran, caps->parm_gran, sizeof(gran_t)*RIG_SETTING_MAX);
 
+    rs->cache.timeout_ms = 0;
+    rot_cache_invalidate(rot);
+
     /*
      * let the backend a chance to setup his private data
      * This must be done only once defaults are setup,
@@ -329,12 +448,16 @@ ROT *HAMLIB_API rot_init(rot_model_t rot_model)
         }
     }
 
+    pthread_mutex_init(&rs->cache_lock, NULL);
+
     // Now we have to copy our new rig state hamlib_port structure to the deprecated one
     // Clients built on older 4.X versions will use the old structure
     // Clients built on newer 4.5 versions will use the new structure
     memcpy(&rot->state.rotport_deprecated, &rot->state.rotport,
            sizeof(rot->state.rotport_deprecated));
 
+    rot_conf_index_init(rot);
+
     return rot;
 }
 
@@ -532,6 +655,8 @@ int HAMLIB_API rot_close(ROT *rot)
         return -RIG_EINVAL;
     }
 
+    rot_track_cancel(rot);
+
     /*
      * Let the backend say 73s to the rot.
      * and ignore the return code.
@@ -576,6 +701,7 @@ int HAMLIB_API rot_close(ROT *rot)
     remove_opened_rot(rot);
 
     rs->comm_state = 0;
+    rot_cache_invalidate(rot);
 
     memcpy(&rot->state.rotport_deprecated, &rot->state.rotport,
            sizeof(rot->state.rotport_deprecated));
@@ -625,6 +751,8 @@ int HAMLIB_API rot_cleanup(ROT *rot)
         rot->caps->rot_cleanup(rot);
     }
 
+    rot_conf_index_cleanup(rot);
+    pthread_mutex_destroy(&rot->state.cache_lock);
     free(rot);
 
     return RIG_OK;
@@ -644,6 +772,12 @@ int HAMLIB_API rot_cleanup(ROT *rot)
  * only the elevation or both.  The rotator backend will ignore the unneeded
  * parameter.
  *
+ * With the "min_step" conf parameter the position is rounded to that many
+ * degrees, and with "deadband" it is not sent at all while it stays that
+ * close to the last position sent, as long as nothing else moved the
+ * rotator since.  "min_interval" makes the call wait until that many ms have
+ * passed since the last position went out.
+ *
  * \return RIG_OK if the operation has been successful, otherwise a **negative
  * value** if an error occurred (in which case, cause is set appropriately).
  *
@@ -660,6 +794,8 @@ int HAMLIB_API rot_set_position(ROT *rot,
 {
     const struct rot_caps *caps;
     const struct rot_state *rs;
+    struct rot_move_filter *mf;
+    int retval;
 
     rot_debug(RIG_DEBUG_VERBOSE, "%s called az=%.02f el=%.02f\n", __func__, azimuth,
               elevation);
@@ -674,6 +810,7 @@ int HAMLIB_API rot_set_position(ROT *rot,
 
     caps = rot->caps;
     rs = &rot->state;
+    mf = &rot->state.move_filter;
 
     rot_debug(RIG_DEBUG_VERBOSE, "%s: south_zero=%d \n", __func__, rs->south_zero);
 
@@ -699,7 +836,44 @@ int HAMLIB_API rot_set_position(ROT *rot,
         return -RIG_ENAVAIL;
     }
 
-    return caps->set_position(rot, azimuth, elevation);
+    rot_cache_move_begin(rot);
+
+    if (!rot_move_wanted(rot, &azimuth, &elevation))
+    {
+        rot_debug(RIG_DEBUG_TRACE, "%s: az=%.2f el=%.2f already sent\n", __func__,
+                  azimuth, elevation);
+        pthread_mutex_unlock(&rot->state.cache_lock);
+        return RIG_OK;
+    }
+
+    if (mf->min_interval_ms > 0)
+    {
+        double wait = mf->min_interval_ms - elapsed_ms(&mf->time_sent,
+                      HAMLIB_ELAPSED_GET);
+
+        /* let position reads through while we wait */
+        if (wait > 0)
+        {
+            pthread_mutex_unlock(&rot->state.cache_lock);
+            hl_usleep((rig_useconds_t)(wait * 1000));
+            pthread_mutex_lock(&rot->state.cache_lock);
+        }
+    }
+
+    retval = caps->set_position(rot, azimuth, elevation);
+    rot_cache_invalidate(rot);
+
+    if (retval == RIG_OK)
+    {
+        mf->az = azimuth;
+        mf->el = elevation;
+        mf->valid = 1;
+        elapsed_ms(&mf->time_sent, HAMLIB_ELAPSED_SET);
+    }
+
+    pthread_mutex_unlock(&rot->state.cache_lock);
+
+    return retval;
 }
 
 
@@ -731,10 +905,11 @@ int HAMLIB_API rot_get_position(ROT *rot,
                                 elevation_t *elevation)
 {
     const struct rot_caps *caps;
-    const struct rot_state *rs;
+    struct rot_state *rs;
     azimuth_t az;
     elevation_t el;
-    int retval;
+    unsigned int seq;
+    int retval = RIG_OK;
 
     rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
@@ -751,20 +926,34 @@ int HAMLIB_API rot_get_position(ROT *rot,
         return -RIG_ENAVAIL;
     }
 
-    retval = caps->get_position(rot, &az, &el);
+    seq = rs->cache.position_seq;
+    pthread_mutex_lock(&rs->cache_lock);
 
-    if (retval != RIG_OK) { return retval; }
-
-    rot_debug(RIG_DEBUG_VERBOSE, "%s: got az=%.2f, el=%.2f\n", __func__, az, el);
-
-    if (rs->south_zero)
+    if (seq != rs->cache.position_seq
+            || rot_cache_fresh(rs, &rs->cache.time_position))
     {
-        az += az >= 180 ? -180 : 180;
-        rot_debug(RIG_DEBUG_VERBOSE, "%s: south adj to az=%.2f\n", __func__, az);
+        /* read while we waited for the lock, or recently enough */
+        az = rs->cache.az;
+        el = rs->cache.el;
+        rot_debug(RIG_DEBUG_VERBOSE, "%s: cached az=%.2f, el=%.2f\n", __func__, az,
+                  el);
+    }
+    else
+    {
+        retval = caps->get_position(rot, &az, &el);
+
+        if (retval == RIG_OK)
+        {
+            rot_cache_store_position(rs, az, el);
+            rot_debug(RIG_DEBUG_VERBOSE, "%s: got az=%.2f, el=%.2f\n", __func__, az, el);
+        }
     }
 
-    *azimuth = az - rot->state.az_offset;
-    *elevation = el - rot->state.el_offset;
+    pthread_mutex_unlock(&rs->cache_lock);
+
+    if (retval != RIG_OK) { return retval; }
+
+    rot_position_to_user(rs, az, el, azimuth, elevation);
 
     return RIG_OK;
 }
@@ -804,7 +993,9 @@ int HAMLIB_API rot_park(ROT *rot)
         return -RIG_ENAVAIL;
     }
 
-    return caps->park(rot);
+    rot_cache_move_begin(rot);
+
+    return rot_cache_move_end(rot, caps->park(rot));
 }
 
 
@@ -835,6 +1026,8 @@ int HAMLIB_API rot_stop(ROT *rot)
         return -RIG_EINVAL;
     }
 
+    rot_track_cancel(rot);
+
     caps = rot->caps;
 
     if (caps->stop == NULL)
@@ -842,7 +1035,9 @@ int HAMLIB_API rot_stop(ROT *rot)
         return -RIG_ENAVAIL;
     }
 
-    return caps->stop(rot);
+    rot_cache_move_begin(rot);
+
+    return rot_cache_move_end(rot, caps->stop(rot));
 }
 
 
@@ -879,7 +1074,9 @@ int HAMLIB_API rot_reset(ROT *rot, rot_reset_t reset)
         return -RIG_ENAVAIL;
     }
 
-    return caps->reset(rot, reset);
+    rot_cache_move_begin(rot);
+
+    return rot_cache_move_end(rot, caps->reset(rot, reset));
 }
 
 
@@ -919,7 +1116,9 @@ int HAMLIB_API rot_move(ROT *rot, int direction, int speed)
         return -RIG_ENAVAIL;
     }
 
-    return caps->move(rot, direction, speed);
+    rot_cache_move_begin(rot);
+
+    return rot_cache_move_end(rot, caps->move(rot, direction, speed));
 }
 
 
@@ -971,6 +1170,10 @@ const char *HAMLIB_API rot_get_info(ROT *rot)
  */
 int HAMLIB_API rot_get_status(ROT *rot, rot_status_t *status)
 {
+    struct rot_state *rs;
+    unsigned int seq;
+    int retval = RIG_OK;
+
     rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
     if (CHECK_ROT_ARG(rot))
@@ -983,7 +1186,680 @@ int HAMLIB_API rot_get_status(ROT *rot, rot_status_t *status)
         return -RIG_ENAVAIL;
     }
 
-    return rot->caps->get_status(rot, status);
+    rs = &rot->state;
+    seq = rs->cache.status_seq;
+    pthread_mutex_lock(&rs->cache_lock);
+
+    if (seq != rs->cache.status_seq
+            || rot_cache_fresh(rs, &rs->cache.time_status))
+    {
+        *status = rs->cache.status;
+    }
+    else
+    {
+        retval = rot->caps->get_status(rot, status);
+
+        if (retval == RIG_OK)
+        {
+            rot_cache_store_status(rs, *status);
+        }
+    }
+
+    pthread_mutex_unlock(&rs->cache_lock);
+
+    return retval;
+}
+
+
+/**
+ * \brief Query position and status flags of the rotator at once.
+ *
+ * \param rot The #ROT handle.
+ * \param azimuth The variable where the azimuth will be stored.
+ * \param elevation The variable where the elevation will be stored.
+ * \param status The variable where the status flags will be stored.
+ *
+ * Same as rot_get_position() followed by rot_get_status(), but a backend
+ * whose controller reports both in one reply answers with a single
+ * transaction.  Other backends get the two queries, minus whatever the
+ * cache still holds.  Without rot_caps#get_status(), \a status is
+ * #ROT_STATUS_NONE.
+ *
+ * \return RIG_OK if the operation has been successful, otherwise a **negative
+ * value** if an error occurred (in which case, cause is set appropriately).
+ *
+ * \retval RIG_OK The query was successful.
+ * \retval RIG_EINVAL \a rot is NULL or inconsistent.
+ * \retval RIG_ENAVAIL Neither rot_caps#get_state() nor rot_caps#get_position()
+ * is available.
+ *
+ * \sa rot_get_position(), rot_get_status()
+ */
+int HAMLIB_API rot_get_state(ROT *rot,
+                             azimuth_t *azimuth,
+                             elevation_t *elevation,
+                             rot_status_t *status)
+{
+    const struct rot_caps *caps;
+    struct rot_state *rs;
+    azimuth_t az;
+    elevation_t el;
+    rot_status_t st;
+    unsigned int position_seq, status_seq;
+    int has_status, position_fresh, status_fresh;
+    int retval = RIG_OK;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (CHECK_ROT_ARG(rot) || !azimuth || !elevation || !status)
+    {
+        return -RIG_EINVAL;
+    }
+
+    caps = rot->caps;
+    rs = &rot->state;
+
+    if (caps->get_state == NULL && caps->get_position == NULL)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    has_status = caps->get_state != NULL || caps->get_status != NULL;
+
+    position_seq = rs->cache.position_seq;
+    status_seq = rs->cache.status_seq;
+    pthread_mutex_lock(&rs->cache_lock);
+
+    position_fresh = position_seq != rs->cache.position_seq
+                     || rot_cache_fresh(rs, &rs->cache.time_position);
+    status_fresh = !has_status || status_seq != rs->cache.status_seq
+                   || rot_cache_fresh(rs, &rs->cache.time_status);
+
+    if (!position_fresh || !status_fresh)
+    {
+        retval = -RIG_ENAVAIL;
+
+        if (caps->get_state)
+        {
+            retval = caps->get_state(rot, &az, &el, &st);
+
+            if (retval == RIG_OK)
+            {
+                rot_cache_store_position(rs, az, el);
+                rot_cache_store_status(rs, st);
+            }
+        }
+
+        /* no native query, or the controller at hand cannot do it */
+        if (retval == -RIG_ENAVAIL)
+        {
+            retval = RIG_OK;
+            has_status = caps->get_status != NULL;
+
+            if (!position_fresh)
+            {
+                retval = caps->get_position
+                         ? caps->get_position(rot, &az, &el) : -RIG_ENAVAIL;
+
+                if (retval == RIG_OK)
+                {
+                    rot_cache_store_position(rs, az, el);
+                }
+            }
+
+            if (retval == RIG_OK && !status_fresh && caps->get_status)
+            {
+                retval = caps->get_status(rot, &st);
+
+                if (retval == RIG_OK)
+                {
+                    rot_cache_store_status(rs, st);
+                }
+                else if (retval == -RIG_ENAVAIL)
+                {
+                    /* e.g. a rotctld whose rotator has no status */
+                    has_status = 0;
+                    retval = RIG_OK;
+                }
+            }
+        }
+    }
+
+    az = rs->cache.az;
+    el = rs->cache.el;
+    st = has_status ? rs->cache.status : ROT_STATUS_NONE;
+
+    pthread_mutex_unlock(&rs->cache_lock);
+
+    if (retval != RIG_OK) { return retval; }
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s: az=%.2f, el=%.2f, status=0x%x\n", __func__,
+              az, el, (unsigned) st);
+
+    rot_position_to_user(rs, az, el, azimuth, elevation);
+    *status = st;
+
+    return RIG_OK;
+}
+
+
+/*
+ * Rotator groups: several #ROT handles steered as one.  Each call runs the
+ * operation on every member at the same time, one thread per member after
+ * the first, which runs on the caller's thread, so commanding the group
+ * costs about one controller's latency.
+ */
+enum rot_group_op
+{
+    ROT_GROUP_OPEN,
+    ROT_GROUP_CLOSE,
+    ROT_GROUP_SET_POSITION,
+    ROT_GROUP_GET_POSITION,
+    ROT_GROUP_GET_STATUS,
+    ROT_GROUP_STOP,
+    ROT_GROUP_PARK
+};
+
+struct rot_group_job
+{
+    ROT *rot;
+    enum rot_group_op op;
+    azimuth_t az;
+    elevation_t el;
+    rot_status_t status;
+    int retval;
+    pthread_t thread;
+    int started;
+};
+
+struct rot_group
+{
+    int n;
+    struct rot_group_job *jobs;
+};
+
+
+static void rot_group_job_run(struct rot_group_job *job)
+{
+    ROT *rot = job->rot;
+    const struct rot_state *rs = &rot->state;
+    azimuth_t az = job->az;
+    elevation_t el = job->el;
+
+    switch (job->op)
+    {
+    case ROT_GROUP_OPEN:
+        job->retval = rot_open(rot);
+        break;
+
+    case ROT_GROUP_CLOSE:
+        job->retval = rot_close(rot);
+        break;
+
+    case ROT_GROUP_SET_POSITION:
+
+        /* an axis this member does not have must still pass the range check */
+        if (!(rot->caps->rot_type & ROT_FLAG_AZIMUTH))
+        {
+            az = rs->min_az - rs->az_offset;
+        }
+
+        if (!(rot->caps->rot_type & ROT_FLAG_ELEVATION))
+        {
+            el = rs->min_el - rs->el_offset;
+        }
+
+        job->retval = rot_set_position(rot, az, el);
+        break;
+
+    case ROT_GROUP_GET_POSITION:
+        job->retval = rot_get_position(rot, &job->az, &job->el);
+        break;
+
+    case ROT_GROUP_GET_STATUS:
+        job->retval = rot_get_status(rot, &job->status);
+        break;
+
+    case ROT_GROUP_STOP:
+        job->retval = rot_stop(rot);
+        break;
+
+    case ROT_GROUP_PARK:
+        job->retval = rot_park(rot);
+        break;
+    }
+}
+
+
+static void *rot_group_thread(void *arg)
+{
+    rot_group_job_run((struct rot_group_job *)arg);
+
+    return NULL;
+}
+
+
+/* runs op on all members at once, returns the first member's error if any */
+static int rot_group_run(ROT_GROUP *grp, enum rot_group_op op)
+{
+    int retval = RIG_OK;
+    int i;
+
+    for (i = 0; i < grp->n; i++)
+    {
+        grp->jobs[i].op = op;
+        grp->jobs[i].retval = RIG_OK;
+        grp->jobs[i].started = 0;
+    }
+
+    for (i = 1; i < grp->n; i++)
+    {
+        grp->jobs[i].started = pthread_create(&grp->jobs[i].thread, NULL,
+                                              rot_group_thread, &grp->jobs[i]) == 0;
+
+        if (!grp->jobs[i].started)
+        {
+            rot_debug(RIG_DEBUG_WARN, "%s: pthread_create failed, member %d in line\n",
+                      __func__, i);
+        }
+    }
+
+    rot_group_job_run(&grp->jobs[0]);
+
+    for (i = 1; i < grp->n; i++)
+    {
+        if (grp->jobs[i].started)
+        {
+            pthread_join(grp->jobs[i].thread, NULL);
+        }
+        else
+        {
+            rot_group_job_run(&grp->jobs[i]);
+        }
+    }
+
+    for (i = 0; i < grp->n; i++)
+    {
+        if (grp->jobs[i].retval != RIG_OK)
+        {
+            rot_debug(RIG_DEBUG_ERR, "%s: member %d: %s\n", __func__, i,
+                      rigerror(grp->jobs[i].retval));
+
+            if (retval == RIG_OK)
+            {
+                retval = grp->jobs[i].retval;
+            }
+        }
+    }
+
+    return retval;
+}
+
+
+/**
+ * \brief Make a group of rotators that are steered together.
+ *
+ * \param rots The member #ROT handles, as returned by rot_init().
+ * \param n The number of members.
+ *
+ * Makes a group out of rotators that turn a stacked array or a dish as one,
+ * including a pair of azimuth only and elevation only controllers.  Commands
+ * given to the group go to all members at the same time.  The members stay
+ * owned by the caller, which configures them with rot_set_conf() before
+ * rot_group_open() and cleans them up after rot_group_cleanup().  A member
+ * must not be used on its own while a group call is in progress.
+ *
+ * \return A pointer to the new group, or NULL if \a rots is empty, holds a
+ * NULL or the same handle twice, or memory ran out.
+ *
+ * \sa rot_group_cleanup()
+ */
+ROT_GROUP *HAMLIB_API rot_group_init(ROT *const rots[], int n)
+{
+    ROT_GROUP *grp;
+    int i, j;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called, n=%d\n", __func__, n);
+
+    if (!rots || n < 1)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        if (!rots[i] || !rots[i]->caps)
+        {
+            return NULL;
+        }
+
+        for (j = 0; j < i; j++)
+        {
+            if (rots[j] == rots[i])
+            {
+                rot_debug(RIG_DEBUG_ERR, "%s: member %d given twice\n", __func__, i);
+                return NULL;
+            }
+        }
+    }
+
+    grp = calloc(1, sizeof(ROT_GROUP));
+
+    if (!grp)
+    {
+        return NULL;
+    }
+
+    grp->jobs = calloc(n, sizeof(struct rot_group_job));
+
+    if (!grp->jobs)
+    {
+        free(grp);
+        return NULL;
+    }
+
+    grp->n = n;
+
+    for (i = 0; i < n; i++)
+    {
+        grp->jobs[i].rot = rots[i];
+    }
+
+    return grp;
+}
+
+
+/**
+ * \brief Open the ports of all the rotators in a group.
+ *
+ * \param grp The #ROT_GROUP handle.
+ *
+ * Calls rot_open() on every member at the same time.  When a member fails to
+ * open, the ones that did are closed again.
+ *
+ * \return RIG_OK if every member opened, otherwise the error of the first
+ * member that failed, or -RIG_EINVAL if \a grp is NULL.
+ */
+int HAMLIB_API rot_group_open(ROT_GROUP *grp)
+{
+    int retval;
+    int i;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!grp)
+    {
+        return -RIG_EINVAL;
+    }
+
+    retval = rot_group_run(grp, ROT_GROUP_OPEN);
+
+    if (retval != RIG_OK)
+    {
+        for (i = 0; i < grp->n; i++)
+        {
+            if (grp->jobs[i].retval == RIG_OK)
+            {
+                rot_close(grp->jobs[i].rot);
+            }
+        }
+    }
+
+    return retval;
+}
+
+
+/**
+ * \brief Close the ports of all the rotators in a group.
+ *
+ * \param grp The #ROT_GROUP handle.
+ *
+ * \return RIG_OK if every member closed, otherwise the error of the first
+ * member that failed, or -RIG_EINVAL if \a grp is NULL.
+ */
+int HAMLIB_API rot_group_close(ROT_GROUP *grp)
+{
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!grp)
+    {
+        return -RIG_EINVAL;
+    }
+
+    return rot_group_run(grp, ROT_GROUP_CLOSE);
+}
+
+
+/**
+ * \brief Release a group.
+ *
+ * \param grp The #ROT_GROUP handle.
+ *
+ * Frees the group only.  The members are left as they are, for the caller to
+ * close and clean up.
+ *
+ * \return RIG_OK, or -RIG_EINVAL if \a grp is NULL.
+ */
+int HAMLIB_API rot_group_cleanup(ROT_GROUP *grp)
+{
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!grp)
+    {
+        return -RIG_EINVAL;
+    }
+
+    free(grp->jobs);
+    free(grp);
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Point all the rotators in a group.
+ *
+ * \param grp The #ROT_GROUP handle.
+ * \param azimuth The azimuth to set in decimal degrees.
+ * \param elevation The elevation to set in decimal degrees.
+ *
+ * Calls rot_set_position() on every member at the same time, so each one
+ * applies its own offsets and limits.  A member without an elevation axis
+ * is only given the azimuth and the other way around.
+ *
+ * \return RIG_OK if every member took the position, otherwise the error of
+ * the first member that failed, or -RIG_EINVAL if \a grp is NULL.
+ *
+ * \sa rot_group_get_position()
+ */
+int HAMLIB_API rot_group_set_position(ROT_GROUP *grp,
+                                      azimuth_t azimuth,
+                                      elevation_t elevation)
+{
+    int i;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called az=%.02f el=%.02f\n", __func__,
+              azimuth, elevation);
+
+    if (!grp)
+    {
+        return -RIG_EINVAL;
+    }
+
+    for (i = 0; i < grp->n; i++)
+    {
+        grp->jobs[i].az = azimuth;
+        grp->jobs[i].el = elevation;
+    }
+
+    return rot_group_run(grp, ROT_GROUP_SET_POSITION);
+}
+
+
+/**
+ * \brief Query the combined azimuth and elevation of a group.
+ *
+ * \param grp The #ROT_GROUP handle.
+ * \param azimuth The variable to store the azimuth.
+ * \param elevation The variable to store the elevation.
+ *
+ * Queries every member at the same time.  The azimuth is the mean over the
+ * members with an azimuth axis, taken around the circle from the first of
+ * them so 359 and 1 give 0, and the elevation is the mean over the members
+ * with an elevation axis.  An axis no member has reads 0.
+ *
+ * \return RIG_OK if every member answered, otherwise the error of the first
+ * member that failed, or -RIG_EINVAL if \a grp is NULL.
+ *
+ * \sa rot_group_set_position()
+ */
+int HAMLIB_API rot_group_get_position(ROT_GROUP *grp,
+                                      azimuth_t *azimuth,
+                                      elevation_t *elevation)
+{
+    double az_ref = 0, az_sum = 0, el_sum = 0;
+    int n_az = 0, n_el = 0;
+    int retval;
+    int i;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!grp || !azimuth || !elevation)
+    {
+        return -RIG_EINVAL;
+    }
+
+    retval = rot_group_run(grp, ROT_GROUP_GET_POSITION);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    for (i = 0; i < grp->n; i++)
+    {
+        const struct rot_group_job *job = &grp->jobs[i];
+
+        if (job->rot->caps->rot_type & ROT_FLAG_AZIMUTH)
+        {
+            double d;
+
+            if (!n_az)
+            {
+                az_ref = job->az;
+            }
+
+            d = fmod(job->az - az_ref, 360.0);
+            d += d > 180 ? -360 : d < -180 ? 360 : 0;
+            az_sum += d;
+            n_az++;
+        }
+
+        if (job->rot->caps->rot_type & ROT_FLAG_ELEVATION)
+        {
+            el_sum += job->el;
+            n_el++;
+        }
+    }
+
+    *azimuth = n_az ? az_ref + az_sum / n_az : 0;
+    *elevation = n_el ? el_sum / n_el : 0;
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Query the combined status flags of a group.
+ *
+ * \param grp The #ROT_GROUP handle.
+ * \param status The variable where the status flags will be stored.
+ *
+ * Queries every member that can report its status, at the same time, and
+ * stores the union of their flags, so the group shows as moving, or at a
+ * limit, while any member is.
+ *
+ * \return RIG_OK if the members that report status answered, otherwise the
+ * error of the first member that failed, -RIG_ENAVAIL if no member reports
+ * status, or -RIG_EINVAL if \a grp is NULL.
+ */
+int HAMLIB_API rot_group_get_status(ROT_GROUP *grp, rot_status_t *status)
+{
+    int retval = -RIG_ENAVAIL;
+    int i;
+
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!grp || !status)
+    {
+        return -RIG_EINVAL;
+    }
+
+    rot_group_run(grp, ROT_GROUP_GET_STATUS);
+
+    *status = ROT_STATUS_NONE;
+
+    for (i = 0; i < grp->n; i++)
+    {
+        const struct rot_group_job *job = &grp->jobs[i];
+
+        if (job->retval == -RIG_ENAVAIL)
+        {
+            continue;
+        }
+
+        if (job->retval != RIG_OK)
+        {
+            return job->retval;
+        }
+
+        *status |= job->status;
+        retval = RIG_OK;
+    }
+
+    return retval;
+}
+
+
+/**
+ * \brief Stop all the rotators in a group.
+ *
+ * \param grp The #ROT_GROUP handle.
+ *
+ * \return RIG_OK if every member stopped, otherwise the error of the first
+ * member that failed, or -RIG_EINVAL if \a grp is NULL.
+ */
+int HAMLIB_API rot_group_stop(ROT_GROUP *grp)
+{
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!grp)
+    {
+        return -RIG_EINVAL;
+    }
+
+    return rot_group_run(grp, ROT_GROUP_STOP);
+}
+
+
+/**
+ * \brief Park all the rotators in a group.
+ *
+ * \param grp The #ROT_GROUP handle.
+ *
+ * \return RIG_OK if every member parked, otherwise the error of the first
+ * member that failed, or -RIG_EINVAL if \a grp is NULL.
+ */
+int HAMLIB_API rot_group_park(ROT_GROUP *grp)
+{
+    rot_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (!grp)
+    {
+        return -RIG_EINVAL;
+    }
+
+    return rot_group_run(grp, ROT_GROUP_PARK);
 }
 
 /*! @} */
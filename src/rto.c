@@ -0,0 +1,218 @@
+/*
+ *  Hamlib Interface - adaptive rig port timeouts
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Adaptive timeouts on the rig port, the timeout_adaptive conf.
+ *
+ * rigport.timeout has to cover the slowest reply of the slowest rig a
+ * backend serves, so one reply lost to RF on the cable stalls the caller
+ * for a second or more although the rig answers in 15 ms.  As TCP does
+ * (RFC 6298), a smoothed round trip time and its mean deviation are kept,
+ * here per kind of read: the command written last, and whether it is the
+ * first, second... read after it, so a CI-V echo and the reply behind it
+ * are learnt apart.  A read then waits srtt + 4 * rttvar, doubled for
+ * every timeout in a row, never less than timeout_floor nor more than
+ * rigport.timeout.  A kind with too few samples yet gets rigport.timeout.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "rto.h"
+
+#define RTO_CLASSES 32
+#define RTO_MIN_SAMPLES 4
+#define RTO_MAX_BACKOFF 6
+
+struct rto_class
+{
+    unsigned int key;
+    int samples;
+    int backoff;        /* timeouts in a row */
+    double srtt;        /* ms */
+    double rttvar;      /* ms */
+};
+
+struct rig_rto
+{
+    unsigned int cmd;   /* command written last */
+    int reads;          /* reads since */
+    struct rto_class classes[RTO_CLASSES];
+};
+
+static struct rig_rto *port_rto(const hamlib_port_t *p)
+{
+    const RIG *rig = p->rig;
+
+    if (!rig || p != &rig->state.rigport || !rig->state.timeout_adaptive)
+    {
+        return NULL;
+    }
+
+    return rig->state.rto;
+}
+
+static struct rto_class *rto_class(struct rig_rto *rto)
+{
+    unsigned int key = rto->cmd | (rto->reads < 255 ? rto->reads : 255);
+    struct rto_class *c = &rto->classes[(key * 2654435761u) >> 27];
+
+    if (c->key != key)
+    {
+        memset(c, 0, sizeof(*c));
+        c->key = key;
+    }
+
+    return c;
+}
+
+void port_rto_command(hamlib_port_t *p, const unsigned char *txbuffer,
+                      size_t count)
+{
+    struct rig_state *rs;
+    unsigned int b0, b1;
+
+    if (!p->rig || p != &p->rig->state.rigport || count == 0)
+    {
+        return;
+    }
+
+    rs = &p->rig->state;
+
+    if (!rs->timeout_adaptive)
+    {
+        return;
+    }
+
+    if (!rs->rto && !(rs->rto = calloc(1, sizeof(struct rig_rto))))
+    {
+        return;
+    }
+
+    // CI-V frames start FE FE to from, the command and subcommand follow
+    if (count >= 6 && txbuffer[0] == 0xfe && txbuffer[1] == 0xfe)
+    {
+        b0 = txbuffer[4];
+        b1 = txbuffer[5];
+    }
+    else
+    {
+        b0 = txbuffer[0];
+        b1 = count > 1 ? txbuffer[1] : 0;
+    }
+
+    ((struct rig_rto *)rs->rto)->cmd = (b0 << 16) | (b1 << 8);
+    ((struct rig_rto *)rs->rto)->reads = 0;
+}
+
+int port_rto_begin(hamlib_port_t *p, struct timespec *start)
+{
+    struct rig_rto *rto = port_rto(p);
+    int timeout = p->timeout;
+    const struct rto_class *c;
+
+    if (!rto)
+    {
+        return timeout;
+    }
+
+    c = rto_class(rto);
+
+    if (c->samples >= RTO_MIN_SAMPLES)
+    {
+        // +1 ms for the clock granularity, as RFC 6298 adds G
+        double ms = (c->srtt + 4 * c->rttvar + 1) * (1 << c->backoff);
+        int floor_ms = p->rig->state.timeout_floor;
+
+        if (ms < floor_ms) { ms = floor_ms; }
+
+        if (ms < timeout) { p->timeout = (int) ms; }
+    }
+
+    elapsed_ms(start, HAMLIB_ELAPSED_SET);
+
+    return timeout;
+}
+
+void port_rto_end(hamlib_port_t *p, int timeout, const struct timespec *start,
+                  int retval)
+{
+    struct rig_rto *rto = port_rto(p);
+    struct rto_class *c;
+    double r;
+
+    p->timeout = timeout;
+
+    if (!rto)
+    {
+        return;
+    }
+
+    c = rto_class(rto);
+    rto->reads++;
+
+    if (retval == -RIG_ETIMEOUT)
+    {
+        // cut short by the caller's deadline says nothing about the rig
+        if (c->backoff < RTO_MAX_BACKOFF && rig_get_deadline() != 0) { c->backoff++; }
+
+        return;
+    }
+
+    if (retval < 0)
+    {
+        return;
+    }
+
+    // Karn: a reply after a timeout may answer the earlier try, don't learn from it
+    if (c->backoff > 0)
+    {
+        c->backoff = 0;
+        return;
+    }
+
+    r = elapsed_ms((struct timespec *) start, HAMLIB_ELAPSED_GET);
+
+    if (c->samples == 0)
+    {
+        c->srtt = r;
+        c->rttvar = r / 2;
+    }
+    else
+    {
+        double err = c->srtt > r ? c->srtt - r : r - c->srtt;
+
+        c->rttvar = 0.75 * c->rttvar + 0.25 * err;
+        c->srtt = 0.875 * c->srtt + 0.125 * r;
+    }
+
+    if (c->samples < RTO_MIN_SAMPLES) { c->samples++; }
+}
+
+void rig_rto_free(RIG *rig)
+{
+    free(rig->state.rto);
+    rig->state.rto = NULL;
+}
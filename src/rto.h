@@ -0,0 +1,45 @@
+/*
+ *  Hamlib Interface - adaptive rig port timeouts
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+
+#ifndef _RTO_H
+#define _RTO_H 1
+
+#include <hamlib/rig.h>
+
+#define RTO_DEFAULT_FLOOR 20
+
+/* write_block() on the rig port: the replies that follow belong to this command */
+void port_rto_command(hamlib_port_t *p, const unsigned char *txbuffer,
+                      size_t count);
+
+/*
+ * Around a read_string()/read_block() on the rig port: begin sets
+ * p->timeout to the estimate and returns the configured timeout, end
+ * puts it back and learns from how long the read took.
+ */
+int port_rto_begin(hamlib_port_t *p, struct timespec *start);
+void port_rto_end(hamlib_port_t *p, int timeout, const struct timespec *start,
+                  int retval);
+
+void rig_rto_free(RIG *rig);
+
+#endif /* _RTO_H */
@@ -53,6 +53,11 @@
 #  include <sys/param.h>
 #endif
 
+#ifdef HAVE_LINUX_SERIAL_H
+#  include <limits.h>
+#  include <linux/serial.h>
+#endif
+
 #ifdef HAVE_TERMIOS_H
 #  include <termios.h> /* POSIX terminal control definitions */
 #else
@@ -86,9 +91,6 @@
 
 #include "microham.h"
 
-static int uh_ptt_fd   = -1;
-static int uh_radio_fd = -1;
-
 //! @cond Doxygen_Suppress
 typedef struct term_options_backup
 {
@@ -99,6 +101,11 @@ typedef struct term_options_backup
     struct termio options;
 #elif defined(HAVE_SGTTY_H)
     struct sgttyb sg;
+#endif
+#ifdef HAVE_LINUX_SERIAL_H
+    int serial_flags;       /* ASYNC_* flags to put back, -1 for untouched */
+    int latency_timer;      /* USB latency timer to put back, -1 for untouched */
+    char latency_path[128]; /* its sysfs file */
 #endif
     struct term_options_backup *next;
 } term_options_backup_t;
@@ -107,23 +114,16 @@ static term_options_backup_t *term_options_backup_head = NULL;
 
 
 /*
- * This function simply returns TRUE if the argument matches uh_radio_fd and
- * is >= 0
+ * This function simply returns TRUE if the argument is the radio socket
+ * of an open microHam device
  *
  * This function is only used in the WIN32 case and implements access "from
- * outside" to uh_radio_fd.
+ * outside" to the microHam radio sockets.
  */
 //! @cond Doxygen_Suppress
 int is_uh_radio_fd(int fd)
 {
-    if (uh_radio_fd >= 0 && uh_radio_fd == fd)
-    {
-        return 1;
-    }
-    else
-    {
-        return 0;
-    }
+    return uh_is_radio(fd);
 }
 //! @endcond
 
@@ -150,7 +150,7 @@ int HAMLIB_API serial_open(hamlib_port_t *rp)
     if (!strncmp(rp->pathname, "uh-rig", 6))
     {
         /*
-         * If the pathname is EXACTLY "uh-rig", try to use a microHam device
+         * If the pathname is "uh-rig", try to use a microHam device
          * rather than a conventional serial port.
          * The microHam devices ALWAYS use "no parity", and can either use no handshake
          * or hardware handshake. Return with error if something else is requested.
@@ -171,6 +171,7 @@ int HAMLIB_API serial_open(hamlib_port_t *rp)
          * So we need to dig into serial_setup().
          */
         fd = uh_open_radio(
+                 rp->pathname + 6,                                      // "" or ":<device>"
                  rp->parm.serial.rate,                                  // baud
                  rp->parm.serial.data_bits,                              // databits
                  rp->parm.serial.stop_bits,                              // stopbits
@@ -183,7 +184,7 @@ int HAMLIB_API serial_open(hamlib_port_t *rp)
 
         rp->fd = fd;
         /*
-         * Remember the fd in a global variable. We can do read(), write() and select()
+         * microham.c knows the fd as a radio socket. We can do read(), write() and select()
          * on fd but whenever it is tried to do an ioctl(), we have to catch it
          * (e.g. setting DTR or tcflush on this fd does not work)
          * While this may look dirty, it is certainly easier and more efficient than
@@ -191,9 +192,8 @@ int HAMLIB_API serial_open(hamlib_port_t *rp)
          *
          * CAVEAT: for WIN32, it might be necessary to use win_serial_read() instead
          *         of read() for serial lines in iofunc.c. Therefore, we have to
-         *         export uh_radio_fd to iofunc.c because in the case of sockets,
+         *         export is_uh_radio_fd() to iofunc.c because in the case of sockets,
          *         read() must be used also in the WIN32 case.
-         *         This is why uh_radio_fd is declared globally in microham.h.
          * Notes from Joe Subich about microham behavior
          * Microham debug tags
          * A-RX ; Asynchronous data received (data not responsive to any
@@ -213,7 +213,6 @@ int HAMLIB_API serial_open(hamlib_port_t *rp)
          *    "auto-information" or CI-V enabled.  In that case asynchronous data
          *    from the transceiver will be returned to both applications.
          */
-        uh_radio_fd = fd;
         return (RIG_OK);
     }
 
@@ -263,6 +262,165 @@ int HAMLIB_API serial_open(hamlib_port_t *rp)
 }
 
 
+#ifdef HAVE_LINUX_SERIAL_H
+/*
+ * Every reply the rig sends waits in the driver until it is pushed up to
+ * the tty: by default a UART driver defers that to a workqueue, and an
+ * FTDI converter holds a short reply for its 16 ms latency timer.  Both
+ * floors go away with serial_low_latency, saving 5 to 15 ms on most CAT
+ * transactions.  CP210x and CH34x converters have no latency timer, for
+ * them only the ASYNC_LOW_LATENCY flag applies.
+ */
+static int serial_latency_timer_read(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    int ms = -1;
+
+    if (f)
+    {
+        if (fscanf(f, "%d", &ms) != 1)
+        {
+            ms = -1;
+        }
+
+        fclose(f);
+    }
+
+    return ms;
+}
+
+
+static int serial_latency_timer_write(const char *path, int ms)
+{
+    FILE *f = fopen(path, "w");
+    int ret;
+
+    if (!f)
+    {
+        return -1;
+    }
+
+    ret = fprintf(f, "%d\n", ms) < 0;
+
+    if (fclose(f) != 0)
+    {
+        ret = 1;
+    }
+
+    return ret ? -1 : 0;
+}
+
+
+static void serial_low_latency(hamlib_port_t *rp, term_options_backup_t *tb)
+{
+    struct rig_state *rs = &rp->rig->state;
+    struct serial_struct ss;
+    char dev[PATH_MAX];
+    const char *tty;
+    int ms;
+
+    rs->serial_async_low_latency = 0;
+    rs->serial_latency_timer = -1;
+
+    if (IOCTL(rp->fd, TIOCGSERIAL, &ss) == 0)
+    {
+        if (rs->serial_low_latency && !(ss.flags & ASYNC_LOW_LATENCY))
+        {
+            int flags = ss.flags;
+
+            ss.flags |= ASYNC_LOW_LATENCY;
+
+            if (IOCTL(rp->fd, TIOCSSERIAL, &ss) == 0)
+            {
+                tb->serial_flags = flags;
+            }
+            else
+            {
+                rig_debug(RIG_DEBUG_WARN, "%s: TIOCSSERIAL: %s\n", __func__,
+                          strerror(errno));
+            }
+        }
+
+        if (IOCTL(rp->fd, TIOCGSERIAL, &ss) == 0)
+        {
+            rs->serial_async_low_latency = (ss.flags & ASYNC_LOW_LATENCY) != 0;
+        }
+    }
+
+    /* /dev/serial/by-id and udev links point at the ttyUSBn node */
+    if (!realpath(rp->pathname, dev))
+    {
+        strncpy(dev, rp->pathname, sizeof(dev) - 1);
+        dev[sizeof(dev) - 1] = '\0';
+    }
+
+    tty = strrchr(dev, '/');
+    tty = tty ? tty + 1 : dev;
+
+    SNPRINTF(tb->latency_path, sizeof(tb->latency_path),
+             "/sys/bus/usb-serial/devices/%.64s/latency_timer", tty);
+
+    ms = serial_latency_timer_read(tb->latency_path);
+
+    if (ms > 1 && rs->serial_low_latency)
+    {
+        if (serial_latency_timer_write(tb->latency_path, 1) == 0)
+        {
+            tb->latency_timer = ms;
+            ms = serial_latency_timer_read(tb->latency_path);
+        }
+        else
+        {
+            rig_debug(RIG_DEBUG_WARN,
+                      "%s: %s not writable (%s), a udev rule can set it\n",
+                      __func__, tb->latency_path, strerror(errno));
+        }
+    }
+
+    rs->serial_latency_timer = ms;
+
+    if (ms < 0)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: %s low latency %s, no latency timer\n",
+                  __func__, rp->pathname, rs->serial_async_low_latency ? "on" : "off");
+    }
+    else
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: %s low latency %s, latency timer %d ms\n",
+                  __func__, rp->pathname, rs->serial_async_low_latency ? "on" : "off", ms);
+    }
+}
+
+
+static void serial_low_latency_restore(hamlib_port_t *p,
+                                       const term_options_backup_t *tb)
+{
+    if (tb->serial_flags != -1)
+    {
+        struct serial_struct ss;
+
+        if (IOCTL(p->fd, TIOCGSERIAL, &ss) == 0)
+        {
+            ss.flags = tb->serial_flags;
+
+            if (IOCTL(p->fd, TIOCSSERIAL, &ss) != 0)
+            {
+                rig_debug(RIG_DEBUG_WARN, "%s: TIOCSSERIAL: %s\n", __func__,
+                          strerror(errno));
+            }
+        }
+    }
+
+    if (tb->latency_timer != -1
+            && serial_latency_timer_write(tb->latency_path, tb->latency_timer) != 0)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: %s: %s\n", __func__, tb->latency_path,
+                  strerror(errno));
+    }
+}
+#endif
+
+
 /**
  * \brief Set up Serial port according to requests in port
  * \param rp
@@ -628,6 +786,17 @@ int HAMLIB_API serial_setup(hamlib_port_t *rp)
     memcpy(&term_backup->sg, &orig_sg, sizeof(orig_sg));
 #endif
 
+#ifdef HAVE_LINUX_SERIAL_H
+    term_backup->serial_flags = -1;
+    term_backup->latency_timer = -1;
+
+    if (rp->rig && rp == &rp->rig->state.rigport)
+    {
+        serial_low_latency(rp, term_backup);
+    }
+
+#endif
+
     // insert at head of list
     term_backup->next = term_options_backup_head;
     term_options_backup_head = term_backup;
@@ -636,10 +805,45 @@ int HAMLIB_API serial_setup(hamlib_port_t *rp)
 }
 
 
+/* what a flush threw away, at WARN since it means a reply went unread */
+static void serial_flush_log(const unsigned char *buf, int len)
+{
+    int i, binary = 0;
+
+    for (i = 0; i < len; ++i)
+    {
+        if (!isprint(buf[i])) { binary = 1; }
+    }
+
+    if (binary)
+    {
+        int bytes = len * 3 + 1;
+        char *hbuf = calloc(bytes, 1);
+
+        for (i = 0; i < len; ++i) { SNPRINTF(&hbuf[i * 3], bytes - (i * 3),  "%02X ", buf[i]); }
+
+        rig_debug(RIG_DEBUG_WARN, "%s: flush hex:%s\n", __func__, hbuf);
+        free(hbuf);
+    }
+    else
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: flush string:%s\n", __func__, buf);
+    }
+}
+
+
 /**
  * \brief Flush all characters waiting in RX buffer.
  * \param p
  * \return RIG_OK
+ *
+ * Most backends flush before every command, so the common case, nothing
+ * waiting, must cost no more than one ioctl.  With asyncio the reader
+ * thread owns the port and has already passed any unsolicited frames to
+ * the async data handler; only the stale replies it queued are dropped.
+ * Otherwise FIONREAD tells whether anything is there, and if so it is
+ * logged and the driver buffer cleared with tcflush().  Without FIONREAD
+ * the port is read with a 1 ms timeout until it stays quiet.
  */
 int HAMLIB_API serial_flush(hamlib_port_t *p)
 {
@@ -647,7 +851,9 @@ int HAMLIB_API serial_flush(hamlib_port_t *p)
     int timeout_save;
     unsigned char buf[4096];
 
-    if (p->fd == uh_ptt_fd || p->fd == uh_radio_fd || p->flushx)
+    port_rxbuf_discard(p);
+
+    if (uh_is_ptt(p->fd) || uh_is_radio(p->fd) || p->flushx)
     {
         /*
          * Catch microHam case:
@@ -674,6 +880,44 @@ int HAMLIB_API serial_flush(hamlib_port_t *p)
         return (RIG_OK);
     }
 
+    if (p->asyncio && (len = port_sync_discard(p)) >= 0)
+    {
+        if (len > 0)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: dropped %d unread reply bytes\n", __func__,
+                      len);
+        }
+
+        return (RIG_OK);
+    }
+
+#if defined(FIONREAD) && !defined(WIN32)
+
+    if (!p->asyncio)
+    {
+        int avail = 0;
+
+        if (IOCTL(p->fd, FIONREAD, &avail) == 0)
+        {
+            if (avail > 0)
+            {
+                len = read(p->fd, buf, avail < (int) sizeof(buf) ? avail : sizeof(buf) - 1);
+
+                if (len > 0)
+                {
+                    buf[len] = 0;
+                    serial_flush_log(buf, len);
+                }
+
+                tcflush(p->fd, TCIFLUSH);
+            }
+
+            return (RIG_OK);
+        }
+    }
+
+#endif
+
     timeout_save = p->timeout;
     p->timeout = 1;
 
@@ -686,34 +930,12 @@ int HAMLIB_API serial_flush(hamlib_port_t *p)
 
         if (len > 0)
         {
-            int i, binary = 0;
-
-            for (i = 0; i < len; ++i)
-            {
-                if (!isprint(buf[i])) { binary = 1; }
-            }
-
-            if (binary)
-            {
-                int bytes = len * 3 + 1;
-                char *hbuf = calloc(bytes, 1);
-
-                for (i = 0; i < len; ++i) { SNPRINTF(&hbuf[i * 3], bytes - (i * 3),  "%02X ", buf[i]); }
-
-                rig_debug(RIG_DEBUG_WARN, "%s: flush hex:%s\n", __func__, hbuf);
-                free(hbuf);
-            }
-            else
-            {
-                rig_debug(RIG_DEBUG_WARN, "%s: flush string:%s\n", __func__, buf);
-            }
+            serial_flush_log(buf, len);
         }
     }
     while (len > 0);
 
     p->timeout = timeout_save;
-    //rig_debug(RIG_DEBUG_VERBOSE, "tcflush%s\n", "");
-    //tcflush(p->fd, TCIFLUSH);
     return (RIG_OK);
 }
 
@@ -744,13 +966,12 @@ int ser_open(hamlib_port_t *p)
             /*
              * Use microHam device for doing PTT. Although a valid file
              * descriptor is returned, it is not used for anything
-             * but must be remembered in a global variable:
+             * but is known to microham.c as a PTT socket:
              * If it is tried later to set/unset DTR on this fd, we know
              * that we cannot use ioctl and must rather call our
              * PTT set/unset service routine.
              */
-            ret = uh_open_ptt();
-            uh_ptt_fd = ret;
+            ret = uh_open_ptt(p->pathname + 6);
         }
         else
         {
@@ -795,20 +1016,11 @@ int ser_close(hamlib_port_t *p)
      * For microHam devices, do not close the
      * socket via close but call a service routine
      * (which might decide to keep the socket open).
-     * However, unset p->fd and uh_ptt_fd/uh_radio_fd.
+     * However, unset p->fd.
      */
-    if (p->fd == uh_ptt_fd)
+    if (uh_is_ptt(p->fd) || uh_is_radio(p->fd))
     {
-        uh_close_ptt();
-        uh_ptt_fd = -1;
-        p->fd = -1;
-        return (0);
-    }
-
-    if (p->fd == uh_radio_fd)
-    {
-        uh_close_radio();
-        uh_radio_fd = -1;
+        uh_close(p->fd);
         p->fd = -1;
         return (0);
     }
@@ -842,6 +1054,9 @@ int ser_close(hamlib_port_t *p)
     if (term_backup)
     {
         rig_debug(RIG_DEBUG_VERBOSE, "%s: restoring options\n", __func__);
+#ifdef HAVE_LINUX_SERIAL_H
+        serial_low_latency_restore(p, term_backup);
+#endif
 #if defined(HAVE_TERMIOS_H)
 
         if (tcsetattr(p->fd, TCSANOW, &term_backup->options) == -1)
@@ -902,7 +1117,7 @@ int HAMLIB_API ser_set_rts(hamlib_port_t *p, int state)
     rig_debug(RIG_DEBUG_VERBOSE, "%s: RTS=%d\n", __func__, state);
 
     // ignore this for microHam ports
-    if (p->fd == uh_ptt_fd || p->fd == uh_radio_fd)
+    if (uh_is_ptt(p->fd) || uh_is_radio(p->fd))
     {
         return (RIG_OK);
     }
@@ -952,7 +1167,7 @@ int HAMLIB_API ser_get_rts(hamlib_port_t *p, int *state)
     unsigned int y;
 
     // cannot do this for microHam ports
-    if (p->fd == uh_ptt_fd || p->fd == uh_radio_fd)
+    if (uh_is_ptt(p->fd) || uh_is_radio(p->fd))
     {
         return (-RIG_ENIMPL);
     }
@@ -979,14 +1194,14 @@ int HAMLIB_API ser_set_dtr(hamlib_port_t *p, int state)
 
     // silently ignore on microHam RADIO channel,
     // but (un)set ptt on microHam PTT channel.
-    if (p->fd == uh_radio_fd)
+    if (uh_is_radio(p->fd))
     {
         return (RIG_OK);
     }
 
-    if (p->fd == uh_ptt_fd)
+    if (uh_is_ptt(p->fd))
     {
-        uh_set_ptt(state);
+        uh_set_ptt(p->fd, state);
         return (RIG_OK);
     }
 
@@ -1035,13 +1250,13 @@ int HAMLIB_API ser_get_dtr(hamlib_port_t *p, int *state)
     unsigned int y;
 
     // cannot do this for the RADIO port, return PTT state for the PTT port
-    if (p->fd == uh_ptt_fd)
+    if (uh_is_ptt(p->fd))
     {
-        *state = uh_get_ptt();
+        *state = uh_get_ptt(p->fd);
         return (RIG_OK);
     }
 
-    if (p->fd == uh_radio_fd)
+    if (uh_is_radio(p->fd))
     {
         return (-RIG_ENIMPL);
     }
@@ -1062,7 +1277,7 @@ int HAMLIB_API ser_get_dtr(hamlib_port_t *p, int *state)
 int HAMLIB_API ser_set_brk(hamlib_port_t *p, int state)
 {
     // ignore this for microHam ports
-    if (p->fd == uh_ptt_fd || p->fd == uh_radio_fd)
+    if (uh_is_ptt(p->fd) || uh_is_radio(p->fd))
     {
         return (RIG_OK);
     }
@@ -1087,7 +1302,7 @@ int HAMLIB_API ser_get_car(hamlib_port_t *p, int *state)
     unsigned int y;
 
     // cannot do this for microHam ports
-    if (p->fd == uh_ptt_fd || p->fd == uh_radio_fd)
+    if (uh_is_ptt(p->fd) || uh_is_radio(p->fd))
     {
         return (-RIG_ENIMPL);
     }
@@ -1110,7 +1325,7 @@ int HAMLIB_API ser_get_cts(hamlib_port_t *p, int *state)
     unsigned int y;
 
     // cannot do this for microHam ports
-    if (p->fd == uh_ptt_fd || p->fd == uh_radio_fd)
+    if (uh_is_ptt(p->fd) || uh_is_radio(p->fd))
     {
         return (-RIG_ENIMPL);
     }
@@ -1133,7 +1348,7 @@ int HAMLIB_API ser_get_dsr(hamlib_port_t *p, int *state)
     unsigned int y;
 
     // cannot do this for microHam ports
-    if (p->fd == uh_ptt_fd || p->fd == uh_radio_fd)
+    if (uh_is_ptt(p->fd) || uh_is_radio(p->fd))
     {
         return (-RIG_ENIMPL);
     }
@@ -43,6 +43,8 @@
 #include <hamlib/rig.h>
 #include "cal.h"
 #include "misc.h"
+#include "cache.h"
+#include "stats.h"
 
 
 #ifndef DOC_HIDDEN
@@ -51,6 +53,41 @@
 
 #endif /* !DOC_HIDDEN */
 
+/* meters change faster than a cached poll could follow them */
+#define LEVEL_METERS (RIG_LEVEL_READONLY_LIST | RIG_LEVEL_RFPOWER_METER_WATTS \
+                      | RIG_LEVEL_TEMP_METER)
+
+/*
+ * What the rig was set to or reported goes in the level/func cache.  After
+ * a failed set we no longer know what the rig holds.  Meters are only
+ * cached by backends that stream them.
+ */
+static void level_cache_update(RIG *rig, vfo_t vfo, setting_t level,
+                               const value_t *val, int retcode, int is_set)
+{
+    if (retcode == RIG_OK && (is_set || !(level & LEVEL_METERS)))
+    {
+        rig_set_cache_level(rig, vfo, level, *val);
+    }
+    else if (retcode != RIG_OK && is_set)
+    {
+        rig_clear_cache_level(rig, vfo, level);
+    }
+}
+
+static void func_cache_update(RIG *rig, vfo_t vfo, setting_t func,
+                              const int *status, int retcode, int is_set)
+{
+    if (retcode == RIG_OK)
+    {
+        rig_set_cache_func(rig, vfo, func, *status);
+    }
+    else if (is_set)
+    {
+        rig_clear_cache_func(rig, vfo, func);
+    }
+}
+
 
 /**
  * \brief set a radio level setting
@@ -89,11 +126,15 @@ int HAMLIB_API rig_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
         return -RIG_ENAVAIL;
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     if ((caps->targetable_vfo & RIG_TARGETABLE_LEVEL)
             || vfo == RIG_VFO_CURR
             || vfo == rig->state.current_vfo)
     {
-        return caps->set_level(rig, vfo, level, val);
+        retcode = caps->set_level(rig, vfo, level, val);
+        level_cache_update(rig, vfo, level, &val, retcode, 1);
+        return retcode;
     }
 
     if (!caps->set_vfo)
@@ -110,6 +151,7 @@ int HAMLIB_API rig_set_level(RIG *rig, vfo_t vfo, setting_t level, value_t val)
     }
 
     retcode = caps->set_level(rig, vfo, level, val);
+    level_cache_update(rig, vfo, level, &val, retcode, 1);
     caps->set_vfo(rig, curr_vfo);
     return retcode;
 }
@@ -160,6 +202,16 @@ int HAMLIB_API rig_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
         return -RIG_ENAVAIL;
     }
 
+    if (rig_get_cache_level(rig, vfo, level, val) == RIG_OK)
+    {
+        rig_stats_cache(rig, HAMLIB_CACHE_LEVEL, 1);
+        return RIG_OK;
+    }
+
+    rig_stats_cache(rig, HAMLIB_CACHE_LEVEL, 0);
+
+    RIG_LOCK_PRIO(rig, (level & LEVEL_METERS) ? RIG_PRIO_BACKGROUND : RIG_PRIO_GET);
+
     /*
      * Special case(frontend emulation): calibrated S-meter reading
      */
@@ -187,8 +239,9 @@ int HAMLIB_API rig_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
             || vfo == RIG_VFO_CURR
             || vfo == rig->state.current_vfo)
     {
-
-        return caps->get_level(rig, vfo, level, val);
+        retcode = caps->get_level(rig, vfo, level, val);
+        level_cache_update(rig, vfo, level, val, retcode, 0);
+        return retcode;
     }
 
     if (!caps->set_vfo)
@@ -205,6 +258,7 @@ int HAMLIB_API rig_get_level(RIG *rig, vfo_t vfo, setting_t level, value_t *val)
     }
 
     retcode = caps->get_level(rig, vfo, level, val);
+    level_cache_update(rig, vfo, level, val, retcode, 0);
     caps->set_vfo(rig, curr_vfo);
     return retcode;
 }
@@ -240,6 +294,8 @@ int HAMLIB_API rig_set_parm(RIG *rig, setting_t parm, value_t val)
         return -RIG_ENAVAIL;
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     return rig->caps->set_parm(rig, parm, val);
 }
 
@@ -274,6 +330,8 @@ int HAMLIB_API rig_get_parm(RIG *rig, setting_t parm, value_t *val)
         return -RIG_ENAVAIL;
     }
 
+    RIG_LOCK(rig);
+
     return rig->caps->get_parm(rig, parm, val);
 }
 
@@ -493,12 +551,15 @@ int HAMLIB_API rig_set_func(RIG *rig, vfo_t vfo, setting_t func, int status)
         return -RIG_ENAVAIL;
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     if ((caps->targetable_vfo & RIG_TARGETABLE_FUNC)
             || vfo == RIG_VFO_CURR
             || vfo == rig->state.current_vfo)
     {
-
-        return caps->set_func(rig, vfo, func, status);
+        retcode = caps->set_func(rig, vfo, func, status);
+        func_cache_update(rig, vfo, func, &status, retcode, 1);
+        return retcode;
     }
     else
     {
@@ -521,6 +582,7 @@ int HAMLIB_API rig_set_func(RIG *rig, vfo_t vfo, setting_t func, int status)
     }
 
     retcode = caps->set_func(rig, vfo, func, status);
+    func_cache_update(rig, vfo, func, &status, retcode, 1);
     caps->set_vfo(rig, curr_vfo);
 
     return retcode;
@@ -567,12 +629,23 @@ int HAMLIB_API rig_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
         return -RIG_ENAVAIL;
     }
 
+    if (rig_get_cache_func(rig, vfo, func, status) == RIG_OK)
+    {
+        rig_stats_cache(rig, HAMLIB_CACHE_FUNC, 1);
+        return RIG_OK;
+    }
+
+    rig_stats_cache(rig, HAMLIB_CACHE_FUNC, 0);
+
+    RIG_LOCK(rig);
+
     if ((caps->targetable_vfo & RIG_TARGETABLE_FUNC)
             || vfo == RIG_VFO_CURR
             || vfo == rig->state.current_vfo)
     {
-
-        return caps->get_func(rig, vfo, func, status);
+        retcode = caps->get_func(rig, vfo, func, status);
+        func_cache_update(rig, vfo, func, status, retcode, 0);
+        return retcode;
     }
 
     if (!caps->set_vfo)
@@ -589,12 +662,129 @@ int HAMLIB_API rig_get_func(RIG *rig, vfo_t vfo, setting_t func, int *status)
     }
 
     retcode = caps->get_func(rig, vfo, func, status);
+    func_cache_update(rig, vfo, func, status, retcode, 0);
     caps->set_vfo(rig, curr_vfo);
 
     return retcode;
 }
 
 
+/**
+ * \brief apply several levels and funcs at once
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param settings  The levels and funcs to set, with their values
+ * \param count The number of entries in \a settings
+ *
+ *  Sets each entry of \a settings as rig_set_level() or rig_set_func()
+ *  would, in order.  When the backend has a set_bulk routine it is given
+ *  the first chance to apply them in as few exchanges as possible (e.g.
+ *  the Kenwood commands chained in one write, with one verification
+ *  behind them).  Whatever it leaves is then set one call at a time.
+ *
+ *  settings[i].retval tells what became of each entry.
+ *
+ * \return RIG_OK if every entry was set, otherwise the first error seen.
+ *
+ * \sa rig_set_level(), rig_set_func()
+ */
+int HAMLIB_API rig_set_bulk(RIG *rig, vfo_t vfo, struct rig_setting *settings,
+                            int count)
+{
+    const struct rig_caps *caps;
+    int retcode = RIG_OK;
+    int i;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called, count=%d\n", __func__, count);
+
+    if (CHECK_RIG_ARG(rig) || !settings || count < 1)
+    {
+        return -RIG_EINVAL;
+    }
+
+    caps = rig->caps;
+
+    for (i = 0; i < count; i++)
+    {
+        struct rig_setting *s = &settings[i];
+
+        if (s->type == RIG_SETTING_FUNC)
+        {
+            s->retval = caps->set_func && rig_has_set_func(rig, s->setting) ?
+                        -RIG_ENIMPL : -RIG_ENAVAIL;
+        }
+        else if (s->type == RIG_SETTING_LEVEL)
+        {
+            s->retval = caps->set_level && rig_has_set_level(rig, s->setting) ?
+                        -RIG_ENIMPL : -RIG_ENAVAIL;
+        }
+        else
+        {
+            s->retval = -RIG_EINVAL;
+        }
+    }
+
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
+    // the backend only gets them when no VFO has to be switched in between
+    if (caps->set_bulk
+            && ((caps->targetable_vfo & RIG_TARGETABLE_LEVEL
+                 && caps->targetable_vfo & RIG_TARGETABLE_FUNC)
+                || vfo == RIG_VFO_CURR
+                || vfo == rig->state.current_vfo))
+    {
+        int rc = caps->set_bulk(rig, vfo, settings, count);
+
+        if (rc != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: backend set_bulk failed: %s\n", __func__,
+                      rigerror(rc));
+        }
+
+        for (i = 0; i < count; i++)
+        {
+            struct rig_setting *s = &settings[i];
+
+            if (s->retval == -RIG_ENIMPL || s->retval == -RIG_ENAVAIL
+                    || s->retval == -RIG_EINVAL)
+            {
+                continue;
+            }
+
+            if (s->type == RIG_SETTING_FUNC)
+            {
+                func_cache_update(rig, vfo, s->setting, &s->val.i, s->retval, 1);
+            }
+            else
+            {
+                level_cache_update(rig, vfo, s->setting, &s->val, s->retval, 1);
+            }
+        }
+    }
+
+    // generic fallback for whatever the backend left, one call each
+    for (i = 0; i < count; i++)
+    {
+        struct rig_setting *s = &settings[i];
+
+        if (s->retval == -RIG_ENIMPL)
+        {
+            s->retval = s->type == RIG_SETTING_FUNC ?
+                        rig_set_func(rig, vfo, s->setting, s->val.i) :
+                        rig_set_level(rig, vfo, s->setting, s->val);
+            rig_lock_preempt(rig);
+        }
+
+        if (s->retval != RIG_OK && retcode == RIG_OK)
+        {
+            retcode = s->retval;
+        }
+    }
+
+    return retcode;
+}
+
+
 /**
  * \brief set a radio level extra parameter
  * \param rig   The rig handle
@@ -633,6 +823,8 @@ int HAMLIB_API rig_set_ext_level(RIG *rig,
         return -RIG_ENAVAIL;
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     if ((caps->targetable_vfo & RIG_TARGETABLE_LEVEL)
             || vfo == RIG_VFO_CURR
             || vfo == rig->state.current_vfo)
@@ -699,6 +891,8 @@ int HAMLIB_API rig_get_ext_level(RIG *rig,
         return -RIG_ENAVAIL;
     }
 
+    RIG_LOCK(rig);
+
     if ((caps->targetable_vfo & RIG_TARGETABLE_LEVEL)
             || vfo == RIG_VFO_CURR
             || vfo == rig->state.current_vfo)
@@ -764,6 +958,8 @@ int HAMLIB_API rig_set_ext_func(RIG *rig,
         return -RIG_ENAVAIL;
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     if ((caps->targetable_vfo & RIG_TARGETABLE_FUNC)
             || vfo == RIG_VFO_CURR
             || vfo == rig->state.current_vfo)
@@ -830,6 +1026,8 @@ int HAMLIB_API rig_get_ext_func(RIG *rig,
         return -RIG_ENAVAIL;
     }
 
+    RIG_LOCK(rig);
+
     if ((caps->targetable_vfo & RIG_TARGETABLE_FUNC)
             || vfo == RIG_VFO_CURR
             || vfo == rig->state.current_vfo)
@@ -886,6 +1084,8 @@ int HAMLIB_API rig_set_ext_parm(RIG *rig, token_t token, value_t val)
         return -RIG_ENAVAIL;
     }
 
+    RIG_LOCK_PRIO(rig, RIG_PRIO_SET);
+
     return rig->caps->set_ext_parm(rig, token, val);
 }
 
@@ -918,6 +1118,8 @@ int HAMLIB_API rig_get_ext_parm(RIG *rig, token_t token, value_t *val)
         return -RIG_ENAVAIL;
     }
 
+    RIG_LOCK(rig);
+
     return rig->caps->get_ext_parm(rig, token, val);
 }
 
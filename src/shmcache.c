@@ -0,0 +1,652 @@
+/*
+ *  Hamlib Interface - shared memory rig state
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The shm_cache conf names a shared memory segment that rig_open()
+ * creates and rig_close() removes.  rig_cache_write_end() copies the
+ * cache into it while it is still the only cache writer, so the segment
+ * needs no lock of its own beyond the sequence counter readers check.
+ * See hamlib/rig_shm.h for the layout.
+ *
+ * A segment left behind by a process that died is taken over by the next
+ * owner of the same name.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#define SHM_SUPPORTED 1
+#elif defined(HAVE_SHM_OPEN) && defined(HAVE_SYS_MMAN_H)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define SHM_SUPPORTED 1
+#endif
+
+#include <hamlib/rig.h>
+#include <hamlib/rig_shm.h>
+
+#include "shmcache.h"
+#include "cache.h"
+#include "misc.h"
+
+#if defined(__GNUC__)
+#define SHM_LOAD(p)         __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define SHM_STORE(p, v)     __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define SHM_STORE_RELAXED(p, v) __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define SHM_FENCE_RELEASE() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define SHM_FENCE_ACQUIRE() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#else
+#define SHM_LOAD(p)         (*(volatile uint32_t *)(p))
+#define SHM_STORE(p, v)     (*(volatile uint32_t *)(p) = (v))
+#define SHM_STORE_RELAXED(p, v) (*(volatile uint32_t *)(p) = (v))
+#define SHM_FENCE_RELEASE()
+#define SHM_FENCE_ACQUIRE()
+#endif
+
+/* a writer holds the counter odd for a few hundred stores at most */
+#define SHM_READ_TRIES 100000
+
+#define SHM_NAME_LEN 64
+
+/* published in this order, see rig_shm_state.meters */
+static const setting_t shm_meters[RIG_SHM_METERS] =
+{
+    RIG_LEVEL_STRENGTH, RIG_LEVEL_RAWSTR, RIG_LEVEL_SWR, RIG_LEVEL_ALC,
+    RIG_LEVEL_RFPOWER_METER, RIG_LEVEL_RFPOWER_METER_WATTS,
+    RIG_LEVEL_COMP_METER, RIG_LEVEL_ID_METER, RIG_LEVEL_VD_METER,
+    RIG_LEVEL_TEMP_METER
+};
+
+struct shm_map
+{
+    struct rig_shm_state *seg;
+#if defined(_WIN32)
+    HANDLE map;
+#endif
+    char path[SHM_NAME_LEN + 8];
+};
+
+struct shm_pub
+{
+    char name[SHM_NAME_LEN];
+    struct shm_map m;
+};
+
+struct rig_shm
+{
+    struct shm_map m;
+};
+
+
+/* "rig1" and "/rig1" both become /rig1, or Local\rig1 on Windows */
+static int shm_path(const char *name, char *path, size_t len)
+{
+    while (*name == '/' || *name == '\\') { name++; }
+
+    if (*name == '\0' || strlen(name) >= SHM_NAME_LEN || strpbrk(name, "/\\"))
+    {
+        return -RIG_EINVAL;
+    }
+
+#if defined(_WIN32)
+    snprintf(path, len, "Local\\%s", name);
+#else
+    snprintf(path, len, "/%s", name);
+#endif
+
+    return RIG_OK;
+}
+
+#ifdef SHM_SUPPORTED
+
+static int shm_map_open(struct shm_map *m, int create)
+{
+    size_t size = sizeof(struct rig_shm_state);
+#if defined(_WIN32)
+
+    if (create)
+    {
+        m->map = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0,
+                                    (DWORD)size, m->path);
+    }
+    else
+    {
+        m->map = OpenFileMappingA(FILE_MAP_READ, FALSE, m->path);
+    }
+
+    if (!m->map)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s: error %lu\n", __func__, m->path,
+                  (unsigned long)GetLastError());
+        return -RIG_EIO;
+    }
+
+    m->seg = MapViewOfFile(m->map, create ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0,
+                           size);
+
+    if (!m->seg)
+    {
+        CloseHandle(m->map);
+        m->map = NULL;
+        return -RIG_EIO;
+    }
+
+#else
+    struct stat st;
+    void *p;
+    int fd;
+
+    fd = shm_open(m->path, create ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+
+    if (fd < 0)
+    {
+        rig_debug(create ? RIG_DEBUG_ERR : RIG_DEBUG_VERBOSE, "%s: %s: %s\n",
+                  __func__, m->path, strerror(errno));
+        return -RIG_EIO;
+    }
+
+    if (create && ftruncate(fd, size) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s: %s\n", __func__, m->path, strerror(errno));
+        close(fd);
+        shm_unlink(m->path);
+        return -RIG_EIO;
+    }
+
+    // an owner still setting up, or of an older layout
+    if (!create && (fstat(fd, &st) < 0 || (size_t)st.st_size < size))
+    {
+        close(fd);
+        return -RIG_EPROTO;
+    }
+
+    p = mmap(NULL, size, create ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED,
+             fd, 0);
+    close(fd);
+
+    if (p == MAP_FAILED)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: mmap %s: %s\n", __func__, m->path,
+                  strerror(errno));
+
+        if (create) { shm_unlink(m->path); }
+
+        return -RIG_EIO;
+    }
+
+    m->seg = p;
+#endif
+
+    return RIG_OK;
+}
+
+static void shm_map_close(struct shm_map *m, int remove)
+{
+    if (!m->seg)
+    {
+        return;
+    }
+
+#if defined(_WIN32)
+    UnmapViewOfFile(m->seg);
+    CloseHandle(m->map);
+    m->map = NULL;
+#else
+    munmap(m->seg, sizeof(struct rig_shm_state));
+
+    if (remove) { shm_unlink(m->path); }
+
+#endif
+    m->seg = NULL;
+}
+
+#endif /* SHM_SUPPORTED */
+
+
+int rig_shm_set_name(RIG *rig, const char *name)
+{
+    struct shm_pub *p = rig->state.shm_cache;
+    char path[SHM_NAME_LEN + 8];
+
+    if (!name || !*name)
+    {
+        if (p) { p->name[0] = '\0'; }
+
+        return RIG_OK;
+    }
+
+    if (shm_path(name, path, sizeof(path)) != RIG_OK)
+    {
+        return -RIG_EINVAL;
+    }
+
+#ifndef SHM_SUPPORTED
+    return -RIG_ENIMPL;
+#else
+
+    if (!p)
+    {
+        p = calloc(1, sizeof(*p));
+
+        if (!p)
+        {
+            return -RIG_ENOMEM;
+        }
+
+        rig->state.shm_cache = p;
+    }
+
+    strncpy(p->name, name, sizeof(p->name) - 1);
+
+    return RIG_OK;
+#endif
+}
+
+const char *rig_shm_get_name(RIG *rig)
+{
+    const struct shm_pub *p = rig->state.shm_cache;
+
+    return p ? p->name : "";
+}
+
+static int64_t shm_stamp(const struct timespec *t)
+{
+    // elapsed_ms() also takes a zero tv_nsec for never set
+    if (t->tv_nsec == 0)
+    {
+        return 0;
+    }
+
+    return (int64_t)t->tv_sec * 1000 + t->tv_nsec / 1000000;
+}
+
+/* a cache stamp, 0 as well when rig_cache_reset() made it stale */
+static int64_t shm_cache_stamp(RIG *rig, const struct timespec *t)
+{
+    return rig_cache_stale(rig, t) ? 0 : shm_stamp(t);
+}
+
+static void shm_vfo(RIG *rig, struct rig_shm_vfo *v, freq_t freq, rmode_t mode,
+                    pbwidth_t width, const struct timespec *time_freq,
+                    const struct timespec *time_mode,
+                    const struct timespec *time_width)
+{
+    v->freq = freq;
+    v->mode = mode;
+    v->width = width;
+    v->freq_ms = shm_cache_stamp(rig, time_freq);
+    v->mode_ms = shm_cache_stamp(rig, time_mode);
+    v->width_ms = shm_cache_stamp(rig, time_width);
+}
+
+#define SHM_VFO(seg, slot, c, name) \
+    shm_vfo(rig, &(seg)->vfos[slot], (c)->freq##name, (c)->mode##name, \
+            (c)->width##name, &(c)->time_freq##name, &(c)->time_mode##name, \
+            &(c)->time_width##name)
+
+void rig_shm_update(RIG *rig)
+{
+    const struct shm_pub *p = rig->state.shm_cache;
+    const struct rig_state *rs = &rig->state;
+    const struct rig_cache *c = &rs->cache;
+    struct rig_shm_state *seg;
+    struct timespec now;
+    uint32_t seq;
+    int i;
+
+    if (!p || !p->m.seg)
+    {
+        return;
+    }
+
+    seg = p->m.seg;
+    seq = seg->seq;
+
+    SHM_STORE_RELAXED(&seg->seq, seq + 1);
+    SHM_FENCE_RELEASE();
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    seg->updates++;
+    seg->update_ms = shm_stamp(&now);
+    seg->cache_timeout_ms = c->timeout_ms;
+    seg->cache_level_timeout_ms = rs->cache_level_timeout_ms;
+    seg->vfo = c->vfo;
+    seg->curr_vfo = rs->current_vfo;
+    seg->vfo_ms = shm_cache_stamp(rig, &c->time_vfo);
+    seg->ptt = c->ptt;
+    seg->ptt_ms = shm_cache_stamp(rig, &c->time_ptt);
+    seg->split = c->split;
+    seg->split_vfo = c->split_vfo;
+    seg->split_ms = shm_cache_stamp(rig, &c->time_split);
+    seg->satmode = c->satmode;
+
+    SHM_VFO(seg, RIG_SHM_CURR, c, Curr);
+    SHM_VFO(seg, RIG_SHM_OTHER, c, Other);
+    SHM_VFO(seg, RIG_SHM_MAIN_A, c, MainA);
+    SHM_VFO(seg, RIG_SHM_MAIN_B, c, MainB);
+    SHM_VFO(seg, RIG_SHM_MAIN_C, c, MainC);
+    SHM_VFO(seg, RIG_SHM_SUB_A, c, SubA);
+    SHM_VFO(seg, RIG_SHM_SUB_B, c, SubB);
+    SHM_VFO(seg, RIG_SHM_SUB_C, c, SubC);
+    SHM_VFO(seg, RIG_SHM_MEM, c, Mem);
+
+    for (i = 0; i < RIG_SHM_METERS; i++)
+    {
+        struct rig_shm_meter *m = &seg->meters[i];
+        struct timespec time;
+        value_t val;
+
+        m->level = shm_meters[i];
+
+        if (!rig_cache_level_peek(rig, RIG_VFO_CURR, shm_meters[i], &val, &time))
+        {
+            m->ms = 0;
+            continue;
+        }
+
+        m->value = RIG_LEVEL_IS_FLOAT(shm_meters[i]) ? val.f : val.i;
+        m->ms = shm_stamp(&time);
+    }
+
+    SHM_STORE(&seg->seq, seq + 2);
+}
+
+int rig_shm_publish_open(RIG *rig)
+{
+#ifdef SHM_SUPPORTED
+    struct shm_pub *p = rig->state.shm_cache;
+    struct shm_map m;
+    int retval;
+
+    if (!p || !p->name[0] || p->m.seg)
+    {
+        return RIG_OK;
+    }
+
+    memset(&m, 0, sizeof(m));
+    shm_path(p->name, m.path, sizeof(m.path));
+    retval = shm_map_open(&m, 1);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    memset(m.seg, 0, sizeof(*m.seg));
+    m.seg->version = RIG_SHM_VERSION;
+    m.seg->size = sizeof(*m.seg);
+#if defined(_WIN32)
+    m.seg->pid = (uint32_t)GetCurrentProcessId();
+#else
+    m.seg->pid = (uint32_t)getpid();
+#endif
+    m.seg->rig_model = rig->caps->rig_model;
+
+    // the first full copy, then readers may trust the segment
+    rig_cache_write_begin(rig);
+    p->m = m;
+    rig_cache_write_end(rig);
+
+    SHM_STORE(&m.seg->magic, RIG_SHM_MAGIC);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: publishing the cache in %s\n", __func__,
+              m.path);
+
+    return RIG_OK;
+#else
+    return RIG_OK;
+#endif
+}
+
+void rig_shm_publish_close(RIG *rig)
+{
+#ifdef SHM_SUPPORTED
+    struct shm_pub *p = rig->state.shm_cache;
+    struct shm_map m;
+
+    if (!p || !p->m.seg)
+    {
+        return;
+    }
+
+    // readers still attached see the segment go stale, not torn
+    rig_cache_write_begin(rig);
+    m = p->m;
+    p->m.seg = NULL;
+    rig_cache_write_end(rig);
+
+    SHM_STORE(&m.seg->magic, 0);
+    shm_map_close(&m, 1);
+#endif
+}
+
+void rig_shm_free(RIG *rig)
+{
+    rig_shm_publish_close(rig);
+    free(rig->state.shm_cache);
+    rig->state.shm_cache = NULL;
+}
+
+
+/**
+ * \brief map the rig state another process publishes
+ * \param name The owner's shm_cache conf
+ *
+ * \return a handle for rig_shm_read(), or NULL when no process publishes
+ * under \a name on this machine.
+ *
+ * \sa rig_shm_read(), rig_shm_detach()
+ */
+rig_shm_t *HAMLIB_API rig_shm_attach(const char *name)
+{
+#ifdef SHM_SUPPORTED
+    rig_shm_t *shm;
+
+    if (!name)
+    {
+        return NULL;
+    }
+
+    shm = calloc(1, sizeof(*shm));
+
+    if (!shm)
+    {
+        return NULL;
+    }
+
+    if (shm_path(name, shm->m.path, sizeof(shm->m.path)) != RIG_OK
+            || shm_map_open(&shm->m, 0) != RIG_OK)
+    {
+        free(shm);
+        return NULL;
+    }
+
+    return shm;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * \brief take a consistent copy of the published rig state
+ * \param shm   The handle from rig_shm_attach()
+ * \param state Where to copy the segment to
+ *
+ * Does not enter the kernel: the copy is retried while the owner is in
+ * the middle of an update.
+ *
+ * \return RIG_OK, -RIG_EPROTO if the segment is not set up (the owner has
+ * closed the rig, or publishes an other layout), -RIG_ETIMEOUT if it was
+ * being written all along.
+ */
+int HAMLIB_API rig_shm_read(rig_shm_t *shm, struct rig_shm_state *state)
+{
+    const struct rig_shm_state *seg;
+    int tries;
+
+    if (!shm || !shm->m.seg || !state)
+    {
+        return -RIG_EINVAL;
+    }
+
+    seg = shm->m.seg;
+
+    for (tries = 0; tries < SHM_READ_TRIES; tries++)
+    {
+        uint32_t seq = SHM_LOAD(&seg->seq);
+
+        if (seq & 1)
+        {
+            continue;
+        }
+
+        memcpy(state, seg, sizeof(*state));
+        SHM_FENCE_ACQUIRE();
+
+        if (SHM_LOAD(&seg->seq) != seq)
+        {
+            continue;
+        }
+
+        if (state->magic != RIG_SHM_MAGIC || state->version != RIG_SHM_VERSION)
+        {
+            return -RIG_EPROTO;
+        }
+
+        return RIG_OK;
+    }
+
+    return -RIG_ETIMEOUT;
+}
+
+/**
+ * \brief unmap a segment mapped by rig_shm_attach()
+ * \param shm The handle, freed here
+ */
+void HAMLIB_API rig_shm_detach(rig_shm_t *shm)
+{
+    if (!shm)
+    {
+        return;
+    }
+
+#ifdef SHM_SUPPORTED
+    shm_map_close(&shm->m, 0);
+#endif
+    free(shm);
+}
+
+/**
+ * \brief milliseconds since a rig_shm_state stamp
+ * \param stamp_ms The stamp
+ *
+ * \return the age, INT_MAX for a stamp of 0 (never set).
+ */
+int HAMLIB_API rig_shm_age(int64_t stamp_ms)
+{
+    struct timespec now;
+    int64_t age;
+
+    if (stamp_ms == 0)
+    {
+        return INT_MAX;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    age = (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000 - stamp_ms;
+
+    // a clock step backwards makes everything look new; call it stale
+    if (age < 0 || age > INT_MAX)
+    {
+        return INT_MAX;
+    }
+
+    return (int)age;
+}
+
+/**
+ * \brief rig_shm_state.vfos slot holding a VFO
+ * \param state A copy from rig_shm_read()
+ * \param vfo   The VFO, RIG_VFO_CURR, RIG_VFO_TX and RIG_VFO_RX included
+ *
+ * Resolves \a vfo the way the owner's cache lookup does.
+ *
+ * \return a #rig_shm_slot_e, or -RIG_EINVAL for a VFO the segment has no
+ * slot for.
+ */
+int HAMLIB_API rig_shm_slot(const struct rig_shm_state *state, vfo_t vfo)
+{
+    if (!state)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (vfo == RIG_VFO_TX)
+    {
+        vfo = state->split ? state->split_vfo : RIG_VFO_CURR;
+    }
+
+    if (vfo == RIG_VFO_CURR || vfo == RIG_VFO_RX)
+    {
+        vfo = state->curr_vfo;
+    }
+
+    // the owner's cache picks the same default
+    if (vfo == RIG_VFO_CURR || vfo == RIG_VFO_NONE) { vfo = RIG_VFO_A; }
+
+    if (vfo == RIG_VFO_SUB && state->satmode) { vfo = RIG_VFO_SUB_A; }
+
+    switch (vfo)
+    {
+    case RIG_VFO_OTHER: return RIG_SHM_OTHER;
+
+    case RIG_VFO_A:
+    case RIG_VFO_VFO:
+    case RIG_VFO_MAIN:
+    case RIG_VFO_MAIN_A: return RIG_SHM_MAIN_A;
+
+    case RIG_VFO_B:
+    case RIG_VFO_SUB:
+    case RIG_VFO_MAIN_B: return RIG_SHM_MAIN_B;
+
+    case RIG_VFO_C:
+    case RIG_VFO_MAIN_C: return RIG_SHM_MAIN_C;
+
+    case RIG_VFO_SUB_A: return RIG_SHM_SUB_A;
+
+    case RIG_VFO_SUB_B: return RIG_SHM_SUB_B;
+
+    case RIG_VFO_SUB_C: return RIG_SHM_SUB_C;
+
+    case RIG_VFO_MEM: return RIG_SHM_MEM;
+
+    default: return -RIG_EINVAL;
+    }
+}
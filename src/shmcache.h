@@ -0,0 +1,39 @@
+/*
+ *  Hamlib Interface - shared memory rig state
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _SHMCACHE_H
+#define _SHMCACHE_H 1
+
+#include <hamlib/rig.h>
+
+/* The shm_cache conf, taking effect at the next rig_open() */
+int rig_shm_set_name(RIG *rig, const char *name);
+const char *rig_shm_get_name(RIG *rig);
+
+/* Create the segment once the rig is open, remove it on close */
+int rig_shm_publish_open(RIG *rig);
+void rig_shm_publish_close(RIG *rig);
+void rig_shm_free(RIG *rig);
+
+/* Copy the cache into the segment, called inside rig_cache_write_begin() */
+void rig_shm_update(RIG *rig);
+
+#endif /* _SHMCACHE_H */
@@ -42,6 +42,10 @@
 #include "config.h"
 #include "sleep.h"
 
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
 #ifdef  __cplusplus
 extern "C" {
 #endif
@@ -65,6 +69,66 @@ int hl_usleep(rig_useconds_t usec)
     return usleep(usec);
 }
 
+/*
+ * Sleep until the CLOCK_MONOTONIC time *deadline.  An absolute deadline
+ * costs nothing when it has already passed and does not drift by however
+ * long the caller took to compute it.  Windows gets a waitable timer, high
+ * resolution where the SDK has it, instead of Sleep() and its 15.6 ms ticks.
+ */
+int hl_sleep_until(const struct timespec *deadline)
+{
+#if defined(_WIN32)
+    struct timespec now;
+    LARGE_INTEGER due;
+    HANDLE timer = NULL;
+    long long ns;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ns = (deadline->tv_sec - now.tv_sec) * 1000000000LL
+         + (deadline->tv_nsec - now.tv_nsec);
+
+    if (ns <= 0) { return 0; }
+
+    due.QuadPart = -(ns / 100);     // relative, in 100 ns units
+
+#ifdef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+    timer = CreateWaitableTimerExW(NULL, NULL,
+                                   CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+                                   TIMER_ALL_ACCESS);
+#endif
+
+    if (timer == NULL) { timer = CreateWaitableTimer(NULL, TRUE, NULL); }
+
+    if (timer == NULL || !SetWaitableTimer(timer, &due, 0, NULL, NULL, FALSE))
+    {
+        if (timer != NULL) { CloseHandle(timer); }
+
+        return hl_usleep(ns / 1000);
+    }
+
+    WaitForSingleObject(timer, INFINITE);
+    CloseHandle(timer);
+
+    return 0;
+#elif defined(HAVE_CLOCK_NANOSLEEP)
+    int retval;
+
+    while ((retval = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, deadline,
+                                     NULL)) == EINTR) { }
+
+    return retval;
+#else
+    struct timespec now;
+    long long us;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    us = (deadline->tv_sec - now.tv_sec) * 1000000LL
+         + (deadline->tv_nsec - now.tv_nsec) / 1000;
+
+    return us > 0 ? hl_usleep(us) : 0;
+#endif
+}
+
 #ifdef HAVE_NANOSLEEP
 #ifndef HAVE_SLEEP
 /**
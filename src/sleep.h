@@ -22,6 +22,7 @@
 #ifndef _HL_SLEEP_H
 #define _HL_SLEEP_H 1
 
+#include <time.h>
 #include <hamlib/rig.h>
 #include "iofunc.h"
 
@@ -29,6 +30,7 @@ __BEGIN_DECLS
 
 /* Hamlib internal use, see rig.c */
 int hl_usleep(rig_useconds_t usec);
+int hl_sleep_until(const struct timespec *deadline);
 
 __END_DECLS
 
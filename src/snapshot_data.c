@@ -1,176 +1,538 @@
 #include <hamlib/config.h>
 
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
 #include <hamlib/rig.h>
 #include "misc.h"
 #include "snapshot_data.h"
+#include "cache.h"
 #include "hamlibdatetime.h"
-
 #include "cJSON.h"
 
-#define MAX_VFO_COUNT 4
-
 #define SPECTRUM_MODE_FIXED "FIXED"
 #define SPECTRUM_MODE_CENTER "CENTER"
 
-static int snapshot_serialize_rig(cJSON *rig_node, RIG *rig)
+/*
+ * The snapshots are written straight into the caller's buffer, in the same
+ * unformatted layout and number format cJSON_PrintPreallocated() gave, so
+ * a snapshot costs no allocation and no tree.  Delta packets compare the
+ * values of struct snapshot_values instead of two trees.
+ */
+struct snapshot_writer
 {
-    cJSON *node;
+    char *p;
+    char *end;          /* one before the end, room for the NUL */
+    int first;          /* nothing written yet in the current object/array */
+    int overflow;
+};
 
-    // TODO: need to assign rig an ID, e.g. from command line
-    node = cJSON_AddStringToObject(rig_node, "id", "rig_id");
+static void sw_init(struct snapshot_writer *w, char *buffer, size_t length)
+{
+    w->p = buffer;
+    w->end = buffer + length - 1;
+    w->first = 1;
+    w->overflow = length == 0;
+}
 
-    if (node == NULL)
+static void sw_raw(struct snapshot_writer *w, const char *s, size_t n)
+{
+    if (w->overflow || n > (size_t)(w->end - w->p))
     {
-        goto error;
+        w->overflow = 1;
+        return;
     }
 
-    // TODO: what kind of status should this reflect?
-    node = cJSON_AddStringToObject(rig_node, "status",
-                                   rig->state.comm_state ? "OK" : "CLOSED");
+    memcpy(w->p, s, n);
+    w->p += n;
+}
 
-    if (node == NULL)
+static void sw_char(struct snapshot_writer *w, char c)
+{
+    if (w->overflow || w->p == w->end)
     {
-        goto error;
+        w->overflow = 1;
+        return;
     }
 
-    // TODO: need to store last error code
-    node = cJSON_AddStringToObject(rig_node, "errorMsg", "");
+    *w->p++ = c;
+}
+
+/* the comma before every member or element but the first */
+static void sw_sep(struct snapshot_writer *w)
+{
+    if (!w->first)
+    {
+        sw_char(w, ',');
+    }
+
+    w->first = 0;
+}
+
+static void sw_open(struct snapshot_writer *w, char c)
+{
+    sw_char(w, c);
+    w->first = 1;
+}
+
+static void sw_close(struct snapshot_writer *w, char c)
+{
+    sw_char(w, c);
+    w->first = 0;
+}
+
+/* member name, one without anything to escape */
+static void sw_key(struct snapshot_writer *w, const char *key)
+{
+    sw_sep(w);
+    sw_char(w, '"');
+    sw_raw(w, key, strlen(key));
+    sw_raw(w, "\":", 2);
+}
+
+static void sw_string(struct snapshot_writer *w, const char *s)
+{
+    static const char hex[] = "0123456789abcdef";
+    const char *run = s;
+
+    sw_char(w, '"');
+
+    for (; *s != '\0'; s++)
+    {
+        unsigned char c = *s;
+        char esc[6] = { '\\', 0, '0', '0', 0, 0 };
+        size_t n = 2;
+
+        if (c >= 32 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+
+        sw_raw(w, run, s - run);
+        run = s + 1;
+
+        switch (c)
+        {
+        case '"': esc[1] = '"'; break;
+
+        case '\\': esc[1] = '\\'; break;
+
+        case '\b': esc[1] = 'b'; break;
+
+        case '\f': esc[1] = 'f'; break;
+
+        case '\n': esc[1] = 'n'; break;
+
+        case '\r': esc[1] = 'r'; break;
+
+        case '\t': esc[1] = 't'; break;
+
+        default:
+            esc[1] = 'u';
+            esc[4] = hex[c >> 4];
+            esc[5] = hex[c & 15];
+            n = 6;
+        }
+
+        sw_raw(w, esc, n);
+    }
+
+    sw_raw(w, run, s - run);
+    sw_char(w, '"');
+}
+
+static void sw_bool(struct snapshot_writer *w, int b)
+{
+    if (b)
+    {
+        sw_raw(w, "true", 4);
+    }
+    else
+    {
+        sw_raw(w, "false", 5);
+    }
+}
+
+/* the equality cJSON_Compare() applies to numbers */
+static int snapshot_number_equal(double a, double b)
+{
+    double max = fabs(a) > fabs(b) ? fabs(a) : fabs(b);
+
+    return fabs(a - b) <= max * DBL_EPSILON;
+}
+
+/*
+ * As cJSON prints numbers: %1.15g, or %1.17g when that does not read back.
+ * Whole numbers below 1e15, which is nearly all of them here, are the
+ * same digits either way and skip the printf.
+ */
+static void sw_number(struct snapshot_writer *w, double d)
+{
+    char num[32];
+    char *s;
+    int len;
+
+    if (isnan(d) || isinf(d))
+    {
+        sw_raw(w, "null", 4);
+        return;
+    }
 
-    if (node == NULL)
+    if (fabs(d) < 1e15 && d == (double)(int64_t) d && !(d == 0 && signbit(d)))
     {
-        goto error;
+        sw_raw(w, num, num_fmt_int(num, (int64_t) d));
+        return;
     }
 
-    node = cJSON_AddStringToObject(rig_node, "name", rig->caps->model_name);
+    len = snprintf(num, sizeof(num), "%1.15g", d);
 
-    if (node == NULL)
+    if (!snapshot_number_equal(strtod(num, NULL), d))
     {
-        goto error;
+        len = snprintf(num, sizeof(num), "%1.17g", d);
     }
 
-    node = cJSON_AddBoolToObject(rig_node, "split",
-                                 rig->state.cache.split == RIG_SPLIT_ON ? 1 : 0);
+    if (len < 0 || len >= (int) sizeof(num))
+    {
+        w->overflow = 1;
+        return;
+    }
 
-    if (node == NULL)
+    for (s = num; *s != '\0'; s++)
     {
-        goto error;
+        if (*s == *localeconv()->decimal_point)
+        {
+            *s = '.';
+        }
     }
 
-    node = cJSON_AddStringToObject(rig_node, "splitVfo",
-                                   rig_strvfo(rig->state.cache.split_vfo));
+    sw_raw(w, num, len);
+}
 
-    if (node == NULL)
+static void sw_hex(struct snapshot_writer *w, const unsigned char *data,
+                   size_t length)
+{
+    static const char hex[] = "0123456789ABCDEF";
+    size_t i;
+
+    if (w->overflow || length * 2 > (size_t)(w->end - w->p))
     {
-        goto error;
+        w->overflow = 1;
+        return;
     }
 
-    node = cJSON_AddBoolToObject(rig_node, "satMode",
-                                 rig->state.cache.satmode ? 1 : 0);
+    for (i = 0; i < length; i++)
+    {
+        *w->p++ = hex[data[i] >> 4];
+        *w->p++ = hex[data[i] & 15];
+    }
+}
 
-    if (node == NULL)
+/* NUL terminate, -RIG_EINVAL if the buffer was too small */
+static int sw_finish(struct snapshot_writer *w)
+{
+    if (w->overflow)
     {
-        goto error;
+        return -RIG_EINVAL;
     }
 
-    RETURNFUNC2(RIG_OK);
+    *w->p = '\0';
+    return RIG_OK;
+}
+
+static const char *const snapshot_stats_keys[SNAPSHOT_STATS_HEAD] =
+{
+    "transactions", "errors", "timeouts", "retries", "bytesOut", "bytesIn",
+    "latencyMaxUs", "latencyAvgUs",
+};
+
+static const hamlib_cache_t snapshot_stats_caches[SNAPSHOT_STATS_CACHE / 2] =
+{
+    HAMLIB_CACHE_FREQ, HAMLIB_CACHE_MODE, HAMLIB_CACHE_VFO, HAMLIB_CACHE_PTT,
+    HAMLIB_CACHE_SPLIT, HAMLIB_CACHE_LEVEL, HAMLIB_CACHE_FUNC,
+};
+
+static const char *const snapshot_stats_cache_keys[SNAPSHOT_STATS_CACHE] =
+{
+    "cacheHitFreq", "cacheMissFreq", "cacheHitMode", "cacheMissMode",
+    "cacheHitVfo", "cacheMissVfo", "cacheHitPtt", "cacheMissPtt",
+    "cacheHitSplit", "cacheMissSplit", "cacheHitLevel", "cacheMissLevel",
+    "cacheHitFunc", "cacheMissFunc",
+};
+
+static void snapshot_get_stats(RIG *rig, struct snapshot_stats *s)
+{
+    struct rig_stats st;
+    int i;
+
+    rig_get_stats(rig, &st);
+
+    s->head[0] = st.transactions;
+    s->head[1] = st.errors;
+    s->head[2] = st.timeouts;
+    s->head[3] = st.retries;
+    s->head[4] = st.bytes_out;
+    s->head[5] = st.bytes_in;
+    s->head[6] = st.latency_max_us;
+    s->head[7] = st.transactions ? st.latency_total_us / st.transactions : 0;
+
+    // latencyHist[n] counts transactions of 2^n..2^(n+1)-1 us, trailing zeros trimmed
+    s->hist_length = SNAPSHOT_STATS_HIST;
 
-error:
-    RETURNFUNC2(-RIG_EINTERNAL);
+    while (s->hist_length > 0 && st.latency_hist[s->hist_length - 1] == 0)
+    {
+        s->hist_length--;
+    }
+
+    for (i = 0; i < s->hist_length; i++)
+    {
+        s->hist[i] = st.latency_hist[i];
+    }
+
+    for (i = 0; i < SNAPSHOT_STATS_CACHE / 2; i++)
+    {
+        s->cache[2 * i] = st.cache_hit[snapshot_stats_caches[i]];
+        s->cache[2 * i + 1] = st.cache_miss[snapshot_stats_caches[i]];
+    }
 }
 
-static int snapshot_serialize_vfo(cJSON *vfo_node, RIG *rig, vfo_t vfo)
+static int snapshot_stats_equal(const struct snapshot_stats *a,
+                                const struct snapshot_stats *b)
+{
+    int i;
+
+    for (i = 0; i < SNAPSHOT_STATS_HEAD; i++)
+    {
+        if (!snapshot_number_equal(a->head[i], b->head[i])) { return 0; }
+    }
+
+    if (a->hist_length != b->hist_length) { return 0; }
+
+    for (i = 0; i < a->hist_length; i++)
+    {
+        if (!snapshot_number_equal(a->hist[i], b->hist[i])) { return 0; }
+    }
+
+    for (i = 0; i < SNAPSHOT_STATS_CACHE; i++)
+    {
+        if (!snapshot_number_equal(a->cache[i], b->cache[i])) { return 0; }
+    }
+
+    return 1;
+}
+
+static void snapshot_write_stats(struct snapshot_writer *w,
+                                 const struct snapshot_stats *s)
+{
+    int i;
+
+    sw_open(w, '{');
+
+    for (i = 0; i < SNAPSHOT_STATS_HEAD; i++)
+    {
+        sw_key(w, snapshot_stats_keys[i]);
+        sw_number(w, s->head[i]);
+    }
+
+    sw_key(w, "latencyHist");
+    sw_open(w, '[');
+
+    for (i = 0; i < s->hist_length; i++)
+    {
+        sw_sep(w);
+        sw_number(w, s->hist[i]);
+    }
+
+    sw_close(w, ']');
+
+    for (i = 0; i < SNAPSHOT_STATS_CACHE; i++)
+    {
+        sw_key(w, snapshot_stats_cache_keys[i]);
+        sw_number(w, s->cache[i]);
+    }
+
+    sw_close(w, '}');
+}
+
+/* everything a state snapshot reports, read once */
+static void snapshot_get_values(RIG *rig, struct snapshot_values *v)
 {
-    freq_t freq;
-    int freq_ms, mode_ms, width_ms;
-    rmode_t mode;
-    pbwidth_t width;
     ptt_t ptt;
     split_t split;
     vfo_t split_vfo;
-    int result;
-    int is_rx, is_tx;
-    cJSON *node;
+    unsigned int seq;
+    int i;
 
-    // TODO: This data should match rig_get_info command response
+    do
+    {
+        seq = rig_cache_read_begin(rig);
+        ptt = rig->state.cache.ptt;
+        split = rig->state.cache.split;
+        split_vfo = rig->state.cache.split_vfo;
+    }
+    while (rig_cache_read_retry(rig, seq));
 
-    node = cJSON_AddStringToObject(vfo_node, "name", rig_strvfo(vfo));
+    // TODO: what kind of status should this reflect?
+    v->status = rig->state.comm_state ? "OK" : "CLOSED";
+    v->name = rig->caps->model_name;
+    v->split = split == RIG_SPLIT_ON;
+    v->split_vfo = split_vfo;
+    v->satmode = rig->state.cache.satmode ? 1 : 0;
+    snapshot_get_stats(rig, &v->stats);
+
+    v->vfo[0].vfo = RIG_VFO_A;
+    v->vfo[1].vfo = RIG_VFO_B;
 
-    if (node == NULL)
+    // TODO: This data should match rig_get_info command response
+    for (i = 0; i < SNAPSHOT_VFO_COUNT; i++)
     {
-        goto error;
+        struct snapshot_vfo_values *vv = &v->vfo[i];
+        vfo_t vfo = vv->vfo;
+        int freq_ms, mode_ms, width_ms;
+
+        vv->cached = rig_get_cache(rig, vfo, &vv->freq, &freq_ms, &vv->mode,
+                                   &mode_ms, &vv->width, &width_ms) == RIG_OK;
+        vv->ptt = ptt != RIG_PTT_OFF;
+        vv->rx = (split == RIG_SPLIT_OFF && vfo == rig->state.current_vfo)
+                 || (split == RIG_SPLIT_ON && vfo != split_vfo);
+        vv->tx = (split == RIG_SPLIT_OFF && vfo == rig->state.current_vfo)
+                 || (split == RIG_SPLIT_ON && vfo == split_vfo);
     }
+}
 
-    result = rig_get_cache(rig, vfo, &freq, &freq_ms, &mode, &mode_ms, &width,
-                           &width_ms);
+/* rig members, those that differ from last only if last is not NULL */
+static void snapshot_write_rig(struct snapshot_writer *w,
+                               const struct snapshot_values *v,
+                               const struct snapshot_values *last)
+{
+    sw_open(w, '{');
 
-    if (result == RIG_OK)
+    // TODO: need to assign rig an ID, e.g. from command line
+    sw_key(w, "id");
+    sw_string(w, "rig_id");
+
+    if (!last || strcmp(v->status, last->status) != 0)
     {
-        node = cJSON_AddNumberToObject(vfo_node, "freq", freq);
+        sw_key(w, "status");
+        sw_string(w, v->status);
+    }
 
-        if (node == NULL)
-        {
-            goto error;
-        }
+    // TODO: need to store last error code
+    if (!last)
+    {
+        sw_key(w, "errorMsg");
+        sw_string(w, "");
+    }
 
-        node = cJSON_AddStringToObject(vfo_node, "mode", rig_strrmode(mode));
+    if (!last || strcmp(v->name, last->name) != 0)
+    {
+        sw_key(w, "name");
+        sw_string(w, v->name);
+    }
 
-        if (node == NULL)
-        {
-            goto error;
-        }
+    if (!last || v->split != last->split)
+    {
+        sw_key(w, "split");
+        sw_bool(w, v->split);
+    }
 
-        node = cJSON_AddNumberToObject(vfo_node, "width", (double) width);
+    if (!last || v->split_vfo != last->split_vfo)
+    {
+        sw_key(w, "splitVfo");
+        sw_string(w, rig_strvfo(v->split_vfo));
+    }
 
-        if (node == NULL)
-        {
-            goto error;
-        }
+    if (!last || v->satmode != last->satmode)
+    {
+        sw_key(w, "satMode");
+        sw_bool(w, v->satmode);
     }
 
-    ptt = rig->state.cache.ptt;
-    node = cJSON_AddBoolToObject(vfo_node, "ptt", ptt == RIG_PTT_OFF ? 0 : 1);
+    if (!last || !snapshot_stats_equal(&v->stats, &last->stats))
+    {
+        sw_key(w, "stats");
+        snapshot_write_stats(w, &v->stats);
+    }
+
+    sw_close(w, '}');
+}
 
-    if (node == NULL)
+/*
+ * One element of "vfos", only the members that differ from last if last
+ * is not NULL, and nothing at all if that leaves just the name.
+ */
+static void snapshot_write_vfo(struct snapshot_writer *w,
+                               const struct snapshot_vfo_values *v,
+                               const struct snapshot_vfo_values *last)
+{
+    int freq = v->cached && (!last || !last->cached
+                             || !snapshot_number_equal(v->freq, last->freq));
+    int mode = v->cached && (!last || !last->cached || v->mode != last->mode);
+    int width = v->cached && (!last || !last->cached
+                              || !snapshot_number_equal(v->width, last->width));
+    int ptt = !last || v->ptt != last->ptt;
+    int rx = !last || v->rx != last->rx;
+    int tx = !last || v->tx != last->tx;
+
+    if (!(freq || mode || width || ptt || rx || tx))
     {
-        goto error;
+        return;
     }
 
-    split = rig->state.cache.split;
-    split_vfo = rig->state.cache.split_vfo;
+    sw_sep(w);
+    sw_open(w, '{');
+    sw_key(w, "name");
+    sw_string(w, rig_strvfo(v->vfo));
 
-    is_rx = (split == RIG_SPLIT_OFF && vfo == rig->state.current_vfo)
-            || (split == RIG_SPLIT_ON && vfo != split_vfo);
-    node = cJSON_AddBoolToObject(vfo_node, "rx", is_rx);
+    if (freq)
+    {
+        sw_key(w, "freq");
+        sw_number(w, v->freq);
+    }
 
-    if (node == NULL)
+    if (mode)
     {
-        goto error;
+        sw_key(w, "mode");
+        sw_string(w, rig_strrmode(v->mode));
     }
 
-    is_tx = (split == RIG_SPLIT_OFF && vfo == rig->state.current_vfo)
-            || (split == RIG_SPLIT_ON && vfo == split_vfo);
-    node = cJSON_AddBoolToObject(vfo_node, "tx", is_tx);
+    if (width)
+    {
+        sw_key(w, "width");
+        sw_number(w, (double) v->width);
+    }
+
+    if (ptt)
+    {
+        sw_key(w, "ptt");
+        sw_bool(w, v->ptt);
+    }
 
-    if (node == NULL)
+    if (rx)
     {
-        goto error;
+        sw_key(w, "rx");
+        sw_bool(w, v->rx);
     }
 
-    RETURNFUNC2(RIG_OK);
+    if (tx)
+    {
+        sw_key(w, "tx");
+        sw_bool(w, v->tx);
+    }
 
-error:
-    RETURNFUNC2(-RIG_EINTERNAL);
+    sw_close(w, '}');
 }
 
-static int snapshot_serialize_spectrum(cJSON *spectrum_node, RIG *rig,
-                                       struct rig_spectrum_line *spectrum_line)
+static void snapshot_write_spectrum(struct snapshot_writer *w, RIG *rig,
+                                    struct rig_spectrum_line *spectrum_line)
 {
-    // Spectrum data is represented as a hexadecimal ASCII string where each data byte is represented as 2 ASCII letters
-    char spectrum_data_string[HAMLIB_MAX_SPECTRUM_DATA * 2];
-    cJSON *node;
-    int i;
     struct rig_spectrum_scope *scopes = rig->caps->spectrum_scopes;
+    size_t length = spectrum_line->spectrum_data_length;
     char *name = "?";
+    int i;
 
     for (i = 0; scopes[i].name != NULL; i++)
     {
@@ -180,247 +542,883 @@ static int snapshot_serialize_spectrum(cJSON *spectrum_node, RIG *rig,
         }
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "id", spectrum_line->id);
-
-    if (node == NULL)
+    if (length > HAMLIB_MAX_SPECTRUM_DATA)
     {
-        goto error;
+        length = HAMLIB_MAX_SPECTRUM_DATA;
     }
 
-    node = cJSON_AddStringToObject(spectrum_node, "name", name);
+    sw_open(w, '{');
+    sw_key(w, "id");
+    sw_number(w, spectrum_line->id);
+    sw_key(w, "name");
+    sw_string(w, name);
+    sw_key(w, "type");
+    sw_string(w, spectrum_line->spectrum_mode == RIG_SPECTRUM_MODE_CENTER ?
+              SPECTRUM_MODE_CENTER : SPECTRUM_MODE_FIXED);
+    sw_key(w, "minLevel");
+    sw_number(w, spectrum_line->data_level_min);
+    sw_key(w, "maxLevel");
+    sw_number(w, spectrum_line->data_level_max);
+    sw_key(w, "minStrength");
+    sw_number(w, spectrum_line->signal_strength_min);
+    sw_key(w, "maxStrength");
+    sw_number(w, spectrum_line->signal_strength_max);
+    sw_key(w, "centerFreq");
+    sw_number(w, spectrum_line->center_freq);
+    sw_key(w, "span");
+    sw_number(w, spectrum_line->span_freq);
+    sw_key(w, "lowFreq");
+    sw_number(w, spectrum_line->low_edge_freq);
+    sw_key(w, "highFreq");
+    sw_number(w, spectrum_line->high_edge_freq);
+    sw_key(w, "length");
+    sw_number(w, (double) spectrum_line->spectrum_data_length);
+
+    // Spectrum data is represented as a hexadecimal ASCII string where each data byte is represented as 2 ASCII letters
+    sw_key(w, "data");
+    sw_char(w, '"');
+    sw_hex(w, spectrum_line->spectrum_data, length);
+    sw_char(w, '"');
+    sw_close(w, '}');
+}
 
-    if (node == NULL)
+/* the members before "rig" */
+static void snapshot_write_head(struct snapshot_writer *w, RIG *rig)
+{
+    sw_open(w, '{');
+    sw_key(w, "app");
+    sw_string(w, PACKAGE_NAME);
+    sw_key(w, "version");
+    sw_string(w, PACKAGE_VERSION " " HAMLIBDATETIME);
+    sw_key(w, "seq");
+    sw_number(w, rig->state.snapshot_packet_sequence_number);
+    // TODO: Calculate 32-bit CRC of the entire JSON record replacing the CRC value with 0
+    sw_key(w, "crc");
+    sw_number(w, 0);
+}
+
+/* the rest of the packet from "rig" on, a delta if last is not NULL */
+static void snapshot_write_state(struct snapshot_writer *w,
+                                 const struct snapshot_values *v,
+                                 const struct snapshot_values *last)
+{
+    int i;
+
+    sw_key(w, "rig");
+    snapshot_write_rig(w, v, last);
+
+    sw_key(w, "vfos");
+    sw_open(w, '[');
+
+    for (i = 0; i < SNAPSHOT_VFO_COUNT; i++)
     {
-        goto error;
+        snapshot_write_vfo(w, &v->vfo[i], last ? &last->vfo[i] : NULL);
     }
 
-    node = cJSON_AddStringToObject(spectrum_node, "type",
-                                   spectrum_line->spectrum_mode == RIG_SPECTRUM_MODE_CENTER ?
-                                   SPECTRUM_MODE_CENTER : SPECTRUM_MODE_FIXED);
+    sw_close(w, ']');
+}
 
-    if (node == NULL)
+int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig,
+                       struct rig_spectrum_line *spectrum_line)
+{
+    struct snapshot_writer w;
+    struct snapshot_values v;
+    int result;
+
+    snapshot_get_values(rig, &v);
+
+    sw_init(&w, buffer, buffer_length);
+    snapshot_write_head(&w, rig);
+    snapshot_write_state(&w, &v, NULL);
+
+    if (spectrum_line != NULL)
     {
-        goto error;
+        sw_key(&w, "spectra");
+        sw_open(&w, '[');
+        sw_sep(&w);
+        snapshot_write_spectrum(&w, rig, spectrum_line);
+        sw_close(&w, ']');
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "minLevel",
-                                   spectrum_line->data_level_min);
+    sw_close(&w, '}');
+
+    result = sw_finish(&w);
 
-    if (node == NULL)
+    if (result != RIG_OK)
     {
-        goto error;
+        return result;
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "maxLevel",
-                                   spectrum_line->data_level_max);
+    rig->state.snapshot_packet_sequence_number++;
+
+    return RIG_OK;
+}
 
-    if (node == NULL)
+/* nothing a delta against last would carry */
+static int snapshot_values_equal(const struct snapshot_values *v,
+                                 const struct snapshot_values *last)
+{
+    int i;
+
+    if (strcmp(v->status, last->status) != 0 || strcmp(v->name, last->name) != 0
+            || v->split != last->split || v->split_vfo != last->split_vfo
+            || v->satmode != last->satmode
+            || !snapshot_stats_equal(&v->stats, &last->stats))
     {
-        goto error;
+        return 0;
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "minStrength",
-                                   spectrum_line->signal_strength_min);
-
-    if (node == NULL)
+    for (i = 0; i < SNAPSHOT_VFO_COUNT; i++)
     {
-        goto error;
+        const struct snapshot_vfo_values *a = &v->vfo[i];
+        const struct snapshot_vfo_values *b = &last->vfo[i];
+
+        if (a->cached && (!b->cached || !snapshot_number_equal(a->freq, b->freq)
+                          || a->mode != b->mode
+                          || !snapshot_number_equal(a->width, b->width)))
+        {
+            return 0;
+        }
+
+        if (a->ptt != b->ptt || a->rx != b->rx || a->tx != b->tx)
+        {
+            return 0;
+        }
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "maxStrength",
-                                   spectrum_line->signal_strength_max);
+    return 1;
+}
+
+/*
+ * State snapshot for the multicast publisher.  Every keyframe_interval-th
+ * packet is the full snapshot_serialize() output, the ones in between
+ * carry "delta":true, "base":<seq of the previous state packet> and only
+ * the rig members and VFOs that changed since then (a VFO keeps its
+ * name, an unchanged VFO is left out).  A listener that did not see the
+ * base packet has to wait for the next keyframe.  keyframe_interval 0 or
+ * 1 sends full snapshots only.  With history->quiet a delta that would
+ * change nothing is not made: buffer gets "" and the sequence number
+ * stays.
+ */
+int snapshot_serialize_state(size_t buffer_length, char *buffer, RIG *rig,
+                             struct snapshot_state_history *history,
+                             int keyframe_interval)
+{
+    struct snapshot_writer w;
+    struct snapshot_values v;
+    unsigned int seq = rig->state.snapshot_packet_sequence_number;
+    int keyframe;
+    int result;
+
+    snapshot_get_values(rig, &v);
 
-    if (node == NULL)
+    keyframe = !history->valid || keyframe_interval <= 1
+               || history->since_key + 1 >= keyframe_interval;
+
+    if (!keyframe && history->quiet && snapshot_values_equal(&v, &history->last))
     {
-        goto error;
+        if (buffer_length > 0) { buffer[0] = '\0'; }
+
+        return RIG_OK;
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "centerFreq",
-                                   spectrum_line->center_freq);
+    sw_init(&w, buffer, buffer_length);
+    snapshot_write_head(&w, rig);
+    snapshot_write_state(&w, &v, keyframe ? NULL : &history->last);
 
-    if (node == NULL)
+    if (!keyframe)
     {
-        goto error;
+        sw_key(&w, "delta");
+        sw_bool(&w, 1);
+        sw_key(&w, "base");
+        sw_number(&w, history->last_seq);
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "span", spectrum_line->span_freq);
+    sw_close(&w, '}');
 
-    if (node == NULL)
+    result = sw_finish(&w);
+
+    if (result != RIG_OK)
     {
-        goto error;
+        return result;
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "lowFreq",
-                                   spectrum_line->low_edge_freq);
+    history->last = v;
+    history->valid = 1;
+    history->last_seq = seq;
+    history->since_key = keyframe ? 0 : history->since_key + 1;
+
+    rig->state.snapshot_packet_sequence_number++;
+
+    return RIG_OK;
+}
+
+void snapshot_state_history_free(struct snapshot_state_history *history)
+{
+    history->valid = 0;
+}
 
-    if (node == NULL)
+static unsigned char *put_be16(unsigned char *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v;
+    return p + 2;
+}
+
+static unsigned char *put_be32(unsigned char *p, uint32_t v)
+{
+    p = put_be16(p, v >> 16);
+    return put_be16(p, v);
+}
+
+static unsigned char *put_be64(unsigned char *p, uint64_t v)
+{
+    p = put_be32(p, v >> 32);
+    return put_be32(p, v);
+}
+
+/*
+ * Run length code the byte-wise difference to the previous line: 0x00 n
+ * stands for n (1-255) unchanged bytes, anything else is a difference
+ * taken modulo 256.  Returns the encoded length, or 0 if it would not be
+ * shorter than the raw data.
+ */
+static size_t spectrum_delta_rle(const unsigned char *cur,
+                                 const unsigned char *prev, size_t len,
+                                 unsigned char *out)
+{
+    size_t i = 0, n = 0;
+
+    while (i < len)
     {
-        goto error;
+        unsigned char d = cur[i] - prev[i];
+
+        if (d == 0)
+        {
+            unsigned char run = 0;
+
+            while (i < len && cur[i] == prev[i] && run < 255)
+            {
+                run++;
+                i++;
+            }
+
+            if (n + 2 >= len) { return 0; }
+
+            out[n++] = 0;
+            out[n++] = run;
+        }
+        else
+        {
+            if (n + 1 >= len) { return 0; }
+
+            out[n++] = d;
+            i++;
+        }
     }
 
-    node = cJSON_AddNumberToObject(spectrum_node, "highFreq",
-                                   spectrum_line->high_edge_freq);
+    return n;
+}
+
+/* a byte difference taken as signed, zigzag mapped: 0, -1, 1, -2 ... to 0, 1, 2, 3 ... */
+static unsigned int spectrum_zigzag(unsigned char d)
+{
+    int s = (signed char) d;
+
+    return s >= 0 ? 2 * s : -2 * s - 1;
+}
 
-    if (node == NULL)
+/*
+ * Rice code the differences of cur to ref, or to the previous byte of cur
+ * when ref is NULL: each zigzag mapped difference as its value >> k in
+ * unary, ones ended by a zero, then its low k bits, MSB first.  The first
+ * byte is k, whichever of 0-7 gives the shortest code.  Returns the encoded
+ * length, or 0 if it would not be shorter than limit.
+ */
+static size_t spectrum_rice(const unsigned char *cur,
+                            const unsigned char *ref, size_t len, size_t limit,
+                            unsigned char *out)
+{
+    size_t bits[8] = { 0 };
+    size_t i, n, pos = 8;
+    unsigned int k, best = 0;
+    unsigned char prev = 0;
+
+    for (i = 0; i < len; i++)
     {
-        goto error;
-    }
+        unsigned int z = spectrum_zigzag(cur[i] - (ref ? ref[i] : prev));
+
+        prev = cur[i];
 
-    node = cJSON_AddNumberToObject(spectrum_node, "length",
-                                   (double) spectrum_line->spectrum_data_length);
+        for (k = 0; k < 8; k++)
+        {
+            bits[k] += (z >> k) + 1 + k;
+        }
+    }
 
-    if (node == NULL)
+    for (k = 1; k < 8; k++)
     {
-        goto error;
+        if (bits[k] < bits[best]) { best = k; }
     }
 
-    to_hex(spectrum_line->spectrum_data_length, spectrum_line->spectrum_data,
-           sizeof(spectrum_data_string), spectrum_data_string);
-    node = cJSON_AddStringToObject(spectrum_node, "data", spectrum_data_string);
+    n = 1 + (bits[best] + 7) / 8;
 
-    if (node == NULL)
+    if (n >= limit) { return 0; }
+
+    memset(out, 0, n);
+    out[0] = best;
+    prev = 0;
+
+    for (i = 0; i < len; i++)
     {
-        goto error;
-    }
+        unsigned int z = spectrum_zigzag(cur[i] - (ref ? ref[i] : prev));
+        unsigned int q = z >> best;
 
-    RETURNFUNC2(RIG_OK);
+        prev = cur[i];
+
+        for (; q > 0; q--, pos++)
+        {
+            out[pos >> 3] |= 0x80 >> (pos & 7);
+        }
 
-error:
-    RETURNFUNC2(-RIG_EINTERNAL);
+        pos++;
+
+        for (k = best; k-- > 0; pos++)
+        {
+            if ((z >> k) & 1) { out[pos >> 3] |= 0x80 >> (pos & 7); }
+        }
+    }
+
+    return n;
 }
 
-int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig,
-                       struct rig_spectrum_line *spectrum_line)
+/* the reverse of spectrum_rice() into data, len bytes */
+static int spectrum_unrice(const unsigned char *in, size_t in_len,
+                           const unsigned char *ref, unsigned char *data, size_t len)
 {
-    cJSON *root_node;
-    cJSON *rig_node, *vfos_array, *vfo_node, *spectra_array, *spectrum_node;
-    cJSON *node;
-    cJSON_bool bool_result;
+    size_t i, pos = 8, end = in_len * 8;
+    unsigned int k;
+    unsigned char prev = 0;
 
-    int vfo_count = 2;
-    vfo_t vfos[MAX_VFO_COUNT];
-    int result;
-    int i;
+    if (in_len < 1 || in[0] > 7)
+    {
+        return -RIG_EPROTO;
+    }
+
+    k = in[0];
 
-    vfos[0] = RIG_VFO_A;
-    vfos[1] = RIG_VFO_B;
+    for (i = 0; i < len; i++)
+    {
+        unsigned int q = 0, z = 0, b;
+
+        while (pos < end && (in[pos >> 3] & (0x80 >> (pos & 7))))
+        {
+            q++;
+            pos++;
+        }
+
+        if (pos + 1 + k > end || (q << k) > 255)
+        {
+            return -RIG_EPROTO;
+        }
 
-    root_node = cJSON_CreateObject();
+        pos++;
+
+        for (b = 0; b < k; b++, pos++)
+        {
+            z = (z << 1) | ((in[pos >> 3] >> (7 - (pos & 7))) & 1);
+        }
+
+        z |= q << k;
+
+        data[i] = (ref ? ref[i] : prev) + (z & 1 ? -(int)((z + 1) / 2) : (int)(z / 2));
+        prev = data[i];
+    }
 
-    if (root_node == NULL)
+    return RIG_OK;
+}
+
+/*
+ * Binary alternative to the JSON "spectra" snapshot, selected with the
+ * multicast_spectrum conf.  One UDP packet per line, integers big-endian:
+ *
+ *    0  4  "HLSP"
+ *    4  1  version, 1 for encodings 0 and 1, 2 for encodings 2 and 3
+ *    5  1  encoding: 0 raw bytes, 1 delta to the base line, 2 Rice coded
+ *          difference to the base line, 3 Rice coded difference to the
+ *          previous byte, see above
+ *    6  1  scope id
+ *    7  1  enum rig_spectrum_mode_e
+ *    8  4  sequence number, shared with the JSON snapshots
+ *   12  4  sequence number of the base line for encodings 1 and 2, else 0
+ *   16  2  data length after decoding
+ *   18  2  payload length
+ *   20  2  data level min, signed
+ *   22  2  data level max, signed
+ *   24  2  signal strength min in 0.1 dB, signed
+ *   26  2  signal strength max in 0.1 dB, signed
+ *   28  8  center frequency in Hz
+ *   36  8  span in Hz
+ *   44  8  low edge frequency in Hz
+ *   52  8  high edge frequency in Hz
+ *   60     payload
+ *
+ * A receiver that missed the base line drops delta lines until the next raw
+ * one, sent at least every SNAPSHOT_SPECTRUM_KEY_INTERVAL lines.  Encodings
+ * 2 and 3 are only used with history->compress set, whichever of them is
+ * shortest; they go out as version 2, which receivers older than them drop.
+ */
+int snapshot_serialize_spectrum_binary(size_t buffer_length,
+                                       unsigned char *buffer, size_t *length, RIG *rig,
+                                       struct rig_spectrum_line *spectrum_line,
+                                       struct snapshot_spectrum_history *history)
+{
+    size_t data_length = spectrum_line->spectrum_data_length;
+    unsigned char *payload = buffer + SNAPSHOT_SPECTRUM_HEADER_SIZE;
+    unsigned int seq = rig->state.snapshot_packet_sequence_number;
+    unsigned int base_seq = 0;
+    size_t payload_length = 0;
+    int id = spectrum_line->id;
+    int encoding = 0;
+    int delta;
+    unsigned char *p = buffer;
+
+    if (data_length > HAMLIB_MAX_SPECTRUM_DATA
+            || buffer_length < SNAPSHOT_SPECTRUM_HEADER_SIZE + data_length)
     {
-        RETURNFUNC2(-RIG_EINTERNAL);
+        return -RIG_EINVAL;
     }
 
-    node = cJSON_AddStringToObject(root_node, "app", PACKAGE_NAME);
+    if (id >= 0 && id < HAMLIB_MAX_SPECTRUM_SCOPES
+            && history->length[id] == data_length
+            && history->since_key[id] < SNAPSHOT_SPECTRUM_KEY_INTERVAL)
+    {
+        payload_length = spectrum_delta_rle(spectrum_line->spectrum_data,
+                                            history->data[id], data_length, payload);
+        encoding = payload_length != 0;
+
+        if (history->compress)
+        {
+            unsigned char rice[HAMLIB_MAX_SPECTRUM_DATA];
+            size_t n = spectrum_rice(spectrum_line->spectrum_data, history->data[id],
+                                     data_length, encoding ? payload_length : data_length, rice);
+
+            if (n)
+            {
+                memcpy(payload, rice, n);
+                payload_length = n;
+                encoding = 2;
+            }
+        }
+    }
 
-    if (node == NULL)
+    if (!encoding && history->compress)
     {
-        goto error;
+        payload_length = spectrum_rice(spectrum_line->spectrum_data, NULL,
+                                       data_length, data_length, payload);
+        encoding = payload_length ? 3 : 0;
     }
 
-    node = cJSON_AddStringToObject(root_node, "version",
-                                   PACKAGE_VERSION " " HAMLIBDATETIME);
+    delta = encoding == 1 || encoding == 2;
 
-    if (node == NULL)
+    if (delta)
     {
-        goto error;
+        base_seq = history->seq[id];
+        history->since_key[id]++;
     }
+    else
+    {
+        if (!encoding)
+        {
+            memcpy(payload, spectrum_line->spectrum_data, data_length);
+            payload_length = data_length;
+        }
 
-    node = cJSON_AddNumberToObject(root_node, "seq",
-                                   rig->state.snapshot_packet_sequence_number);
+        if (id >= 0 && id < HAMLIB_MAX_SPECTRUM_SCOPES)
+        {
+            history->since_key[id] = 0;
+        }
+    }
 
-    if (node == NULL)
+    if (id >= 0 && id < HAMLIB_MAX_SPECTRUM_SCOPES)
     {
-        goto error;
+        memcpy(history->data[id], spectrum_line->spectrum_data, data_length);
+        history->length[id] = data_length;
+        history->seq[id] = seq;
     }
 
-    // TODO: Calculate 32-bit CRC of the entire JSON record replacing the CRC value with 0
-    node = cJSON_AddNumberToObject(root_node, "crc", 0);
+    memcpy(p, SNAPSHOT_SPECTRUM_MAGIC, 4);
+    p += 4;
+    *p++ = encoding >= 2 ? SNAPSHOT_SPECTRUM_VERSION_RICE : SNAPSHOT_SPECTRUM_VERSION;
+    *p++ = encoding;
+    *p++ = id;
+    *p++ = spectrum_line->spectrum_mode;
+    p = put_be32(p, seq);
+    p = put_be32(p, base_seq);
+    p = put_be16(p, data_length);
+    p = put_be16(p, payload_length);
+    p = put_be16(p, (int16_t) spectrum_line->data_level_min);
+    p = put_be16(p, (int16_t) spectrum_line->data_level_max);
+    p = put_be16(p, (int16_t)(spectrum_line->signal_strength_min * 10));
+    p = put_be16(p, (int16_t)(spectrum_line->signal_strength_max * 10));
+    p = put_be64(p, (uint64_t) spectrum_line->center_freq);
+    p = put_be64(p, (uint64_t) spectrum_line->span_freq);
+    p = put_be64(p, (uint64_t) spectrum_line->low_edge_freq);
+    put_be64(p, (uint64_t) spectrum_line->high_edge_freq);
+
+    *length = SNAPSHOT_SPECTRUM_HEADER_SIZE + payload_length;
+
+    rig->state.snapshot_packet_sequence_number++;
+
+    return RIG_OK;
+}
+
+/* a JSON string member copied to buf, left alone if there is none */
+static void snapshot_get_string(const cJSON *object, const char *key,
+                                char *buf, size_t len)
+{
+    const char *s = cJSON_GetStringValue(cJSON_GetObjectItem(object, key));
+
+    if (s) { snprintf(buf, len, "%s", s); }
+}
+
+/* a JSON bool member, *b left alone if there is none */
+static void snapshot_get_bool(const cJSON *object, const char *key, int *b)
+{
+    const cJSON *item = cJSON_GetObjectItem(object, key);
 
-    if (node == NULL)
+    if (cJSON_IsBool(item)) { *b = cJSON_IsTrue(item); }
+}
+
+static void snapshot_parse_rig(const cJSON *rig, struct snapshot_mirror *m)
+{
+    char vfo[16] = "";
+
+    snapshot_get_string(rig, "name", m->name, sizeof(m->name));
+    snapshot_get_string(rig, "status", m->status, sizeof(m->status));
+    snapshot_get_bool(rig, "split", &m->split);
+    snapshot_get_string(rig, "splitVfo", vfo, sizeof(vfo));
+    snapshot_get_bool(rig, "satMode", &m->satmode);
+
+    if (vfo[0]) { m->split_vfo = rig_parse_vfo(vfo); }
+}
+
+/* one element of "vfos", a delta one carries the members that changed */
+static void snapshot_parse_vfo(const cJSON *v, struct snapshot_mirror *m)
+{
+    const char *name = cJSON_GetStringValue(cJSON_GetObjectItem(v, "name"));
+    struct snapshot_vfo_values *vv = NULL;
+    const cJSON *item;
+    vfo_t vfo;
+    int i;
+
+    if (!name || (vfo = rig_parse_vfo(name)) == RIG_VFO_NONE)
     {
-        goto error;
+        return;
     }
 
-    rig_node = cJSON_CreateObject();
+    for (i = 0; i < SNAPSHOT_VFO_COUNT && !vv; i++)
+    {
+        if (m->vfo[i].vfo == vfo || m->vfo[i].vfo == RIG_VFO_NONE)
+        {
+            vv = &m->vfo[i];
+        }
+    }
 
-    if (rig_node == NULL)
+    if (!vv)
     {
-        goto error;
+        return;
     }
 
-    result = snapshot_serialize_rig(rig_node, rig);
+    vv->vfo = vfo;
 
-    if (result != RIG_OK)
+    // freq, mode and width come together the first time
+    item = cJSON_GetObjectItem(v, "freq");
+
+    if (cJSON_IsNumber(item))
     {
-        cJSON_Delete(rig_node);
-        goto error;
+        vv->freq = item->valuedouble;
+        vv->cached = 1;
     }
 
-    cJSON_AddItemToObject(root_node, "rig", rig_node);
+    item = cJSON_GetObjectItem(v, "mode");
+
+    if (cJSON_IsString(item)) { vv->mode = rig_parse_mode(item->valuestring); }
 
-    vfos_array = cJSON_CreateArray();
+    item = cJSON_GetObjectItem(v, "width");
+
+    if (cJSON_IsNumber(item)) { vv->width = (pbwidth_t) item->valuedouble; }
+
+    snapshot_get_bool(v, "ptt", &vv->ptt);
+    snapshot_get_bool(v, "rx", &vv->rx);
+    snapshot_get_bool(v, "tx", &vv->tx);
+}
+
+static double snapshot_get_number(const cJSON *object, const char *key)
+{
+    const cJSON *item = cJSON_GetObjectItem(object, key);
+
+    return cJSON_IsNumber(item) ? item->valuedouble : 0;
+}
+
+/* the first element of "spectra", line->spectrum_data gets the bytes */
+static int snapshot_parse_spectrum(const cJSON *s,
+                                   struct rig_spectrum_line *line)
+{
+    const char *type = cJSON_GetStringValue(cJSON_GetObjectItem(s, "type"));
+    const char *data = cJSON_GetStringValue(cJSON_GetObjectItem(s, "data"));
+    size_t length = (size_t) snapshot_get_number(s, "length");
+    size_t i;
 
-    if (vfos_array == NULL)
+    if (!data || length > HAMLIB_MAX_SPECTRUM_DATA || strlen(data) < 2 * length)
     {
-        goto error;
+        return -RIG_EPROTO;
     }
 
-    for (i = 0; i < vfo_count; i++)
+    for (i = 0; i < length; i++)
     {
-        vfo_node = cJSON_CreateObject();
-        result = snapshot_serialize_vfo(vfo_node, rig, vfos[i]);
+        unsigned int byte;
 
-        if (result != RIG_OK)
+        if (sscanf(data + 2 * i, "%2x", &byte) != 1)
         {
-            cJSON_Delete(vfo_node);
-            goto error;
+            return -RIG_EPROTO;
         }
 
-        cJSON_AddItemToArray(vfos_array, vfo_node);
+        line->spectrum_data[i] = byte;
     }
 
-    cJSON_AddItemToObject(root_node, "vfos", vfos_array);
+    line->id = (int) snapshot_get_number(s, "id");
+    line->spectrum_mode = type && strcmp(type, SPECTRUM_MODE_CENTER) == 0 ?
+                          RIG_SPECTRUM_MODE_CENTER : RIG_SPECTRUM_MODE_FIXED;
+    line->data_level_min = (int) snapshot_get_number(s, "minLevel");
+    line->data_level_max = (int) snapshot_get_number(s, "maxLevel");
+    line->signal_strength_min = snapshot_get_number(s, "minStrength");
+    line->signal_strength_max = snapshot_get_number(s, "maxStrength");
+    line->center_freq = snapshot_get_number(s, "centerFreq");
+    line->span_freq = snapshot_get_number(s, "span");
+    line->low_edge_freq = snapshot_get_number(s, "lowFreq");
+    line->high_edge_freq = snapshot_get_number(s, "highFreq");
+    line->spectrum_data_length = length;
+
+    return RIG_OK;
+}
 
-    if (spectrum_line != NULL)
+/*
+ * Apply a JSON packet of snapshot_serialize() or snapshot_serialize_state()
+ * to mirror.  A full snapshot replaces what mirror had, a delta is taken
+ * only on top of its base packet; one that is not gets -RIG_ENAVAIL and
+ * leaves mirror unsynced until the next keyframe.  The state of a spectrum
+ * packet is full but not what the next delta is based on.  With a
+ * spectrum line in the packet as well, it is put in line, whose
+ * spectrum_data must hold HAMLIB_MAX_SPECTRUM_DATA bytes, and the result
+ * is SNAPSHOT_PARSED_SPECTRUM.
+ */
+int snapshot_parse(const char *packet, size_t length,
+                   struct snapshot_mirror *mirror, struct rig_spectrum_line *line)
+{
+    cJSON *root = cJSON_ParseWithLength(packet, length);
+    const cJSON *seq, *rig, *vfos, *spectra, *v;
+    int result = RIG_OK;
+
+    if (!root)
     {
-        spectra_array = cJSON_CreateArray();
+        return -RIG_EPROTO;
+    }
 
-        if (spectra_array == NULL)
-        {
-            goto error;
-        }
+    seq = cJSON_GetObjectItem(root, "seq");
+    rig = cJSON_GetObjectItem(root, "rig");
+    vfos = cJSON_GetObjectItem(root, "vfos");
+    spectra = cJSON_GetObjectItem(root, "spectra");
+
+    if (!cJSON_IsNumber(seq) || !cJSON_IsObject(rig) || !cJSON_IsArray(vfos))
+    {
+        cJSON_Delete(root);
+        return -RIG_EPROTO;
+    }
 
-        spectrum_node = cJSON_CreateObject();
-        result = snapshot_serialize_spectrum(spectrum_node, rig, spectrum_line);
+    if (cJSON_IsTrue(cJSON_GetObjectItem(root, "delta")))
+    {
+        const cJSON *base = cJSON_GetObjectItem(root, "base");
 
-        if (result != RIG_OK)
+        if (!mirror->synced || !cJSON_IsNumber(base)
+                || (unsigned int) base->valuedouble != mirror->state_seq)
         {
-            cJSON_Delete(spectrum_node);
-            goto error;
+            mirror->synced = 0;
+            cJSON_Delete(root);
+            return -RIG_ENAVAIL;
         }
+    }
+    else
+    {
+        memset(mirror->vfo, 0, sizeof(mirror->vfo));
+        mirror->valid = 1;
+
+        if (!spectra) { mirror->synced = 1; }
+    }
+
+    if (!spectra) { mirror->state_seq = (unsigned int) seq->valuedouble; }
 
-        cJSON_AddItemToArray(spectra_array, spectrum_node);
+    mirror->packets++;
 
-        cJSON_AddItemToObject(root_node, "spectra", spectra_array);
+    snapshot_parse_rig(rig, mirror);
+
+    cJSON_ArrayForEach(v, vfos)
+    {
+        snapshot_parse_vfo(v, mirror);
     }
 
-    bool_result = cJSON_PrintPreallocated(root_node, buffer, (int) buffer_length,
-                                          0);
+    if (cJSON_GetArraySize(spectra) > 0
+            && snapshot_parse_spectrum(cJSON_GetArrayItem(spectra, 0), line) == RIG_OK)
+    {
+        result = SNAPSHOT_PARSED_SPECTRUM;
+    }
+
+    cJSON_Delete(root);
+
+    return result;
+}
 
-    cJSON_Delete(root_node);
+static unsigned int get_be16(const unsigned char *p)
+{
+    return (p[0] << 8) | p[1];
+}
 
-    if (!bool_result)
+static uint32_t get_be32(const unsigned char *p)
+{
+    return ((uint32_t) get_be16(p) << 16) | get_be16(p + 2);
+}
+
+static uint64_t get_be64(const unsigned char *p)
+{
+    return ((uint64_t) get_be32(p) << 32) | get_be32(p + 4);
+}
+
+/*
+ * Decode a packet of snapshot_serialize_spectrum_binary() into line, whose
+ * spectrum_data must hold HAMLIB_MAX_SPECTRUM_DATA bytes.  history keeps
+ * the last line of each scope for the delta coded ones; a delta line whose
+ * base line was missed gets -RIG_ENAVAIL.
+ */
+int snapshot_parse_spectrum_binary(const unsigned char *packet, size_t length,
+                                   struct rig_spectrum_line *line,
+                                   struct snapshot_spectrum_history *history)
+{
+    const unsigned char *payload = packet + SNAPSHOT_SPECTRUM_HEADER_SIZE;
+    unsigned char *data = line->spectrum_data;
+    size_t data_length, payload_length;
+    int id;
+
+    if (length < SNAPSHOT_SPECTRUM_HEADER_SIZE
+            || memcmp(packet, SNAPSHOT_SPECTRUM_MAGIC, 4) != 0
+            || (packet[4] != SNAPSHOT_SPECTRUM_VERSION
+                && packet[4] != SNAPSHOT_SPECTRUM_VERSION_RICE))
     {
-        RETURNFUNC2(-RIG_EINVAL);
+        return -RIG_EPROTO;
     }
 
-    rig->state.snapshot_packet_sequence_number++;
+    id = packet[6];
+    data_length = get_be16(packet + 16);
+    payload_length = get_be16(packet + 18);
+
+    if (id >= HAMLIB_MAX_SPECTRUM_SCOPES || data_length > HAMLIB_MAX_SPECTRUM_DATA
+            || length < SNAPSHOT_SPECTRUM_HEADER_SIZE + payload_length)
+    {
+        return -RIG_EPROTO;
+    }
+
+    if (packet[5] > (packet[4] == SNAPSHOT_SPECTRUM_VERSION ? 1 : 3))
+    {
+        return -RIG_EPROTO;
+    }
+
+    if (packet[5] == 0)
+    {
+        if (payload_length != data_length)
+        {
+            return -RIG_EPROTO;
+        }
+
+        memcpy(data, payload, data_length);
+    }
+    else if (packet[5] == 3)
+    {
+        if (spectrum_unrice(payload, payload_length, NULL, data, data_length) != RIG_OK)
+        {
+            return -RIG_EPROTO;
+        }
+    }
+    else
+    {
+        const unsigned char *base = history->data[id];
+        size_t i = 0, n = 0;
 
-    RETURNFUNC2(RIG_OK);
+        if (history->length[id] != data_length || data_length == 0
+                || history->seq[id] != get_be32(packet + 12))
+        {
+            return -RIG_ENAVAIL;
+        }
+
+        if (packet[5] == 2)
+        {
+            if (spectrum_unrice(payload, payload_length, base, data,
+                                data_length) != RIG_OK)
+            {
+                return -RIG_EPROTO;
+            }
+
+            n = payload_length;
+            i = data_length;
+        }
+
+        // see spectrum_delta_rle()
+        while (n < payload_length)
+        {
+            if (payload[n] == 0)
+            {
+                size_t run = n + 1 < payload_length ? payload[n + 1] : 0;
+
+                if (run == 0 || i + run > data_length)
+                {
+                    return -RIG_EPROTO;
+                }
+
+                memcpy(data + i, base + i, run);
+                i += run;
+                n += 2;
+            }
+            else
+            {
+                if (i >= data_length)
+                {
+                    return -RIG_EPROTO;
+                }
+
+                data[i] = base[i] + payload[n++];
+                i++;
+            }
+        }
+
+        if (i != data_length)
+        {
+            return -RIG_EPROTO;
+        }
+    }
 
-error:
-    cJSON_Delete(root_node);
-    RETURNFUNC2(-RIG_EINTERNAL);
+    memcpy(history->data[id], data, data_length);
+    history->length[id] = data_length;
+    history->seq[id] = get_be32(packet + 8);
+
+    line->id = id;
+    line->spectrum_mode = packet[7];
+    line->data_level_min = (int16_t) get_be16(packet + 20);
+    line->data_level_max = (int16_t) get_be16(packet + 22);
+    line->signal_strength_min = (int16_t) get_be16(packet + 24) / 10.0;
+    line->signal_strength_max = (int16_t) get_be16(packet + 26) / 10.0;
+    line->center_freq = (freq_t) get_be64(packet + 28);
+    line->span_freq = (freq_t) get_be64(packet + 36);
+    line->low_edge_freq = (freq_t) get_be64(packet + 44);
+    line->high_edge_freq = (freq_t) get_be64(packet + 52);
+    line->spectrum_data_length = data_length;
+
+    return RIG_OK;
 }
@@ -1,6 +1,111 @@
 #ifndef _SNAPSHOT_DATA_H
 #define _SNAPSHOT_DATA_H
 
+/* values of rig_state.multicast_spectrum, the "multicast_spectrum" conf */
+#define SNAPSHOT_SPECTRUM_JSON   0
+#define SNAPSHOT_SPECTRUM_BINARY 1
+#define SNAPSHOT_SPECTRUM_BOTH   2
+#define SNAPSHOT_SPECTRUM_COMPRESSED 3  /* binary, Rice coded where shorter */
+
+#define SNAPSHOT_SPECTRUM_MAGIC "HLSP"
+#define SNAPSHOT_SPECTRUM_VERSION 1         /* encodings 0 and 1 */
+#define SNAPSHOT_SPECTRUM_VERSION_RICE 2    /* encodings 2 and 3 */
+#define SNAPSHOT_SPECTRUM_HEADER_SIZE 60
+#define SNAPSHOT_SPECTRUM_KEY_INTERVAL 30   /* lines between raw key lines */
+
+/* what the last binary spectrum line of each scope was encoded against */
+struct snapshot_spectrum_history
+{
+    unsigned char data[HAMLIB_MAX_SPECTRUM_SCOPES][HAMLIB_MAX_SPECTRUM_DATA];
+    size_t length[HAMLIB_MAX_SPECTRUM_SCOPES];
+    unsigned int seq[HAMLIB_MAX_SPECTRUM_SCOPES];
+    int since_key[HAMLIB_MAX_SPECTRUM_SCOPES];
+    int compress;           /* encodings 2 and 3 may be sent */
+};
+
+#define SNAPSHOT_VFO_COUNT 2
+#define SNAPSHOT_STATS_HEAD 8   /* counters before "latencyHist" */
+#define SNAPSHOT_STATS_HIST 24
+#define SNAPSHOT_STATS_CACHE 14 /* cache hits and misses after it */
+
+/* the "stats" member of "rig", as the doubles the JSON carries */
+struct snapshot_stats
+{
+    double head[SNAPSHOT_STATS_HEAD];
+    int hist_length;        /* trailing zero buckets left out */
+    double hist[SNAPSHOT_STATS_HIST];
+    double cache[SNAPSHOT_STATS_CACHE];
+};
+
+struct snapshot_vfo_values
+{
+    vfo_t vfo;
+    int cached;             /* freq, mode and width are known */
+    freq_t freq;
+    rmode_t mode;
+    pbwidth_t width;
+    int ptt;
+    int rx;
+    int tx;
+};
+
+/* what a state snapshot reports */
+struct snapshot_values
+{
+    const char *status;
+    const char *name;
+    int split;
+    vfo_t split_vfo;
+    int satmode;
+    struct snapshot_stats stats;
+    struct snapshot_vfo_values vfo[SNAPSHOT_VFO_COUNT];
+};
+
+/* what the last multicast state packet was, for delta packets */
+struct snapshot_state_history
+{
+    int valid;              /* last holds a packet */
+    struct snapshot_values last;
+    unsigned int last_seq;
+    int since_key;          /* delta packets since the last keyframe */
+    int quiet;              /* a delta that would carry no change is not written */
+};
+
 int snapshot_serialize(size_t buffer_length, char *buffer, RIG *rig, struct rig_spectrum_line *spectrum_line);
+int snapshot_serialize_spectrum_binary(size_t buffer_length,
+                                       unsigned char *buffer, size_t *length, RIG *rig,
+                                       struct rig_spectrum_line *spectrum_line,
+                                       struct snapshot_spectrum_history *history);
+int snapshot_serialize_state(size_t buffer_length, char *buffer, RIG *rig,
+                             struct snapshot_state_history *history,
+                             int keyframe_interval);
+void snapshot_state_history_free(struct snapshot_state_history *history);
+
+/*
+ * The receiving end: what the state packets of one publisher said, kept
+ * by snapshot_parse().  VFOs are kept by name, in the order first heard.
+ */
+struct snapshot_mirror
+{
+    int valid;              /* a full snapshot has been applied */
+    int synced;             /* no state packet missed since, deltas apply */
+    unsigned int state_seq; /* of the last state packet applied */
+    unsigned int packets;   /* packets applied */
+    char name[32];
+    char status[16];
+    int split;
+    vfo_t split_vfo;
+    int satmode;
+    struct snapshot_vfo_values vfo[SNAPSHOT_VFO_COUNT];
+};
+
+/* snapshot_parse() result when the packet also carried a spectrum line */
+#define SNAPSHOT_PARSED_SPECTRUM 1
+
+int snapshot_parse(const char *packet, size_t length,
+                   struct snapshot_mirror *mirror, struct rig_spectrum_line *line);
+int snapshot_parse_spectrum_binary(const unsigned char *packet, size_t length,
+                                   struct rig_spectrum_line *line,
+                                   struct snapshot_spectrum_history *history);
 
 #endif
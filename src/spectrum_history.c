@@ -0,0 +1,305 @@
+/*
+ *  Hamlib Interface - spectrum line history
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * A fixed-size ring of the most recent spectrum lines per scope, filled by
+ * rig_fire_spectrum_event() once the spectrum_history conf is set, so that
+ * a client joining late can paint a whole waterfall at once with
+ * rig_get_spectrum_history() instead of waiting for it to fill up.
+ *
+ * Each ring is allocated on its scope's first line and never grows.  Lines
+ * are numbered as they are stored, line n living in slot n % lines, which
+ * lets a reader copy one entry at a time and drop the lock in between
+ * while the rig keeps adding lines: anything overwritten meanwhile is
+ * simply skipped.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include "spectrum_history.h"
+#include "misc.h"
+
+struct spectrum_history_entry
+{
+    struct timespec time;
+    struct rig_spectrum_line line;
+    unsigned char data[HAMLIB_MAX_SPECTRUM_DATA];
+};
+
+struct spectrum_history_ring
+{
+    struct spectrum_history_entry *entry;
+    unsigned long next;     /* number of the next line stored */
+};
+
+struct spectrum_history
+{
+    int lines;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_t lock;
+#endif
+    struct spectrum_history_ring scope[HAMLIB_MAX_SPECTRUM_SCOPES];
+};
+
+#ifdef HAVE_PTHREAD
+#define HISTORY_LOCK(h)   pthread_mutex_lock(&(h)->lock)
+#define HISTORY_UNLOCK(h) pthread_mutex_unlock(&(h)->lock)
+#else
+#define HISTORY_LOCK(h)
+#define HISTORY_UNLOCK(h)
+#endif
+
+static struct spectrum_history *history_get(RIG *rig)
+{
+    return __atomic_load_n((struct spectrum_history **)
+                           &rig->state.spectrum_history, __ATOMIC_ACQUIRE);
+}
+
+static void history_clear(struct spectrum_history *h)
+{
+    int i;
+
+    for (i = 0; i < HAMLIB_MAX_SPECTRUM_SCOPES; i++)
+    {
+        free(h->scope[i].entry);
+        h->scope[i].entry = NULL;
+        h->scope[i].next = 0;
+    }
+}
+
+int spectrum_history_init(RIG *rig, int lines)
+{
+    struct spectrum_history *h = history_get(rig);
+
+    if (lines < 0 || lines > SPECTRUM_HISTORY_MAX_LINES)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (h)
+    {
+        /* keep the struct, readers and the rig may be using its lock */
+        HISTORY_LOCK(h);
+        history_clear(h);
+        h->lines = lines;
+        HISTORY_UNLOCK(h);
+        return RIG_OK;
+    }
+
+    if (lines == 0)
+    {
+        return RIG_OK;
+    }
+
+    h = calloc(1, sizeof(*h));
+
+    if (!h)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    h->lines = lines;
+#ifdef HAVE_PTHREAD
+    pthread_mutex_init(&h->lock, NULL);
+#endif
+
+    __atomic_store_n((struct spectrum_history **)&rig->state.spectrum_history, h,
+                     __ATOMIC_RELEASE);
+
+    return RIG_OK;
+}
+
+void spectrum_history_add(RIG *rig, const struct rig_spectrum_line *line)
+{
+    struct spectrum_history *h = history_get(rig);
+    struct spectrum_history_ring *ring;
+    struct spectrum_history_entry *e;
+    size_t length;
+
+    if (!h || line->id < 0 || line->id >= HAMLIB_MAX_SPECTRUM_SCOPES)
+    {
+        return;
+    }
+
+    ring = &h->scope[line->id];
+    length = line->spectrum_data_length;
+
+    if (length > HAMLIB_MAX_SPECTRUM_DATA)
+    {
+        length = HAMLIB_MAX_SPECTRUM_DATA;
+    }
+
+    HISTORY_LOCK(h);
+
+    if (h->lines == 0)
+    {
+        HISTORY_UNLOCK(h);
+        return;
+    }
+
+    if (!ring->entry)
+    {
+        ring->entry = calloc(h->lines, sizeof(*ring->entry));
+
+        if (!ring->entry)
+        {
+            HISTORY_UNLOCK(h);
+            rig_debug(RIG_DEBUG_ERR, "%s: no memory for %d lines\n", __func__,
+                      h->lines);
+            return;
+        }
+    }
+
+    e = &ring->entry[ring->next % h->lines];
+    elapsed_ms(&e->time, HAMLIB_ELAPSED_SET);
+    e->line = *line;
+    e->line.spectrum_data_length = length;
+    e->line.spectrum_data = e->data;
+    memcpy(e->data, line->spectrum_data, length);
+    ring->next++;
+
+    HISTORY_UNLOCK(h);
+}
+
+void spectrum_history_free(RIG *rig)
+{
+    struct spectrum_history *h = rig->state.spectrum_history;
+
+    if (!h)
+    {
+        return;
+    }
+
+    history_clear(h);
+#ifdef HAVE_PTHREAD
+    pthread_mutex_destroy(&h->lock);
+#endif
+    free(h);
+    rig->state.spectrum_history = NULL;
+}
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \brief get the recent spectrum lines of a scope
+ * \param rig   The rig handle
+ * \param id    Spectrum scope ID, as in rig_spectrum_line.id
+ * \param max_age_ms Only lines at most this old, 0 for all that are kept
+ * \param cb    Called for each line, oldest first, with its age in ms
+ * \param arg   Passed through to \a cb
+ *
+ * Lines are kept once the "spectrum_history" conf gives the number to hold
+ * per scope.  Each one is copied out before \a cb is called, so \a cb may
+ * take its time and call other Hamlib functions, and the line it is given
+ * is only valid during the call.  As with rig_list_foreach(), \a cb returns
+ * 0 to stop early.
+ *
+ * \return the number of lines passed to \a cb, or a negative error code
+ */
+int HAMLIB_API rig_get_spectrum_history(RIG *rig, int id, int max_age_ms,
+                                        spectrum_history_cb_t cb, rig_ptr_t arg)
+{
+    struct spectrum_history *h;
+    struct spectrum_history_ring *ring;
+    struct spectrum_history_entry e;
+    unsigned long n, end;
+    int count = 0;
+
+    if (!rig || !cb || id < 0 || id >= HAMLIB_MAX_SPECTRUM_SCOPES)
+    {
+        return -RIG_EINVAL;
+    }
+
+    h = history_get(rig);
+
+    if (!h)
+    {
+        return 0;
+    }
+
+    ring = &h->scope[id];
+
+    HISTORY_LOCK(h);
+
+    /* the lines stored after this call started are left for next time */
+    end = ring->next;
+    n = end > (unsigned long)h->lines ? end - h->lines : 0;
+
+    if (max_age_ms > 0)
+    {
+        while (n < end && elapsed_ms(&ring->entry[n % h->lines].time,
+                                     HAMLIB_ELAPSED_GET) > max_age_ms)
+        {
+            n++;
+        }
+    }
+
+    while (n < end)
+    {
+        int age;
+
+        if (ring->next - n > (unsigned long)h->lines)
+        {
+            /* overwritten while the lock was dropped */
+            n = ring->next - h->lines;
+            continue;
+        }
+
+        e = ring->entry[n % h->lines];
+        age = (int)elapsed_ms(&e.time, HAMLIB_ELAPSED_GET);
+        n++;
+
+        HISTORY_UNLOCK(h);
+
+        e.line.spectrum_data = e.data;
+        count++;
+
+        if (cb(rig, &e.line, age, arg) == 0)
+        {
+            return count;
+        }
+
+        HISTORY_LOCK(h);
+
+        if (!ring->entry || ring->next < n)
+        {
+            /* resized meanwhile */
+            break;
+        }
+    }
+
+    HISTORY_UNLOCK(h);
+
+    return count;
+}
+
+/** @} */
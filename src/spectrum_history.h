@@ -0,0 +1,37 @@
+/*
+ *  Hamlib Interface - spectrum line history
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _SPECTRUM_HISTORY_H
+#define _SPECTRUM_HISTORY_H 1
+
+#include <hamlib/rig.h>
+
+#define SPECTRUM_HISTORY_MAX_LINES 4096
+
+/* (Re)size the history to lines per scope, 0 frees it */
+int spectrum_history_init(RIG *rig, int lines);
+
+/* Keep a copy of line, called from rig_fire_spectrum_event() */
+void spectrum_history_add(RIG *rig, const struct rig_spectrum_line *line);
+
+void spectrum_history_free(RIG *rig);
+
+#endif /* _SPECTRUM_HISTORY_H */
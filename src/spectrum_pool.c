@@ -0,0 +1,167 @@
+/*
+ *  Hamlib Interface - spectrum line pool
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Spectrum lines arrive at up to 30 per second and scope.  Backends that
+ * assemble a line straight into a pool buffer hand it through
+ * rig_fire_spectrum_event() to the multicast publisher by reference: the
+ * publisher takes a reference, gets the pointer through its pipe and drops
+ * the reference once the packet is out, so the data is never copied.
+ *
+ * The pool is fixed and shared by all rigs.  A slot is free while refs is
+ * 0; references are counted with atomics so no lock is taken per line.
+ */
+
+#include <hamlib/config.h>
+
+#include <stddef.h>
+#include <string.h>
+
+#include "spectrum_pool.h"
+
+static struct spectrum_pool_line pool[SPECTRUM_POOL_SIZE];
+
+struct spectrum_pool_line *spectrum_pool_get(void)
+{
+    int i;
+
+    for (i = 0; i < SPECTRUM_POOL_SIZE; i++)
+    {
+        int free_refs = 0;
+
+        if (__atomic_compare_exchange_n(&pool[i].refs, &free_refs, 1, 0,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            pool[i].line.spectrum_data = pool[i].data;
+            pool[i].line.spectrum_data_length = 0;
+            return &pool[i];
+        }
+    }
+
+    rig_debug(RIG_DEBUG_WARN, "%s: all %d spectrum lines in use\n", __func__,
+              SPECTRUM_POOL_SIZE);
+
+    return NULL;
+}
+
+void spectrum_pool_ref(struct spectrum_pool_line *pl)
+{
+    __atomic_add_fetch(&pl->refs, 1, __ATOMIC_RELAXED);
+}
+
+void spectrum_pool_put(struct spectrum_pool_line *pl)
+{
+    if (__atomic_sub_fetch(&pl->refs, 1, __ATOMIC_RELEASE) < 0)
+    {
+        rig_debug(RIG_DEBUG_BUG, "%s: spectrum line released too often\n", __func__);
+        __atomic_store_n(&pl->refs, 0, __ATOMIC_RELEASE);
+    }
+}
+
+struct spectrum_pool_line *spectrum_pool_from_line(const struct rig_spectrum_line
+        *line)
+{
+    const unsigned char *data = line->spectrum_data;
+    int i;
+
+    for (i = 0; i < SPECTRUM_POOL_SIZE; i++)
+    {
+        if (data == pool[i].data && __atomic_load_n(&pool[i].refs, __ATOMIC_ACQUIRE) > 0)
+        {
+            return &pool[i];
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \brief keep a spectrum line beyond its callback
+ * \param line  The line passed to a spectrum_cb_t
+ *
+ * The line given to a spectrum callback is only valid during the call.
+ * This takes a reference on the pool buffer holding it, so its header and
+ * data stay put until rig_spectrum_line_release(); bindings use it to hand
+ * the data to their language without copying.  A line that is not in the
+ * pool is copied into it once.  The pool is small and shared by all rigs,
+ * so hold lines for a few frames at most and copy anything kept longer.
+ *
+ * \return the held line, or NULL if the pool is exhausted
+ *
+ * \sa rig_spectrum_line_release(), rig_set_spectrum_callback()
+ */
+struct rig_spectrum_line *HAMLIB_API rig_spectrum_line_hold(
+    const struct rig_spectrum_line *line)
+{
+    struct spectrum_pool_line *pl;
+
+    if (!line || line->spectrum_data_length > HAMLIB_MAX_SPECTRUM_DATA)
+    {
+        return NULL;
+    }
+
+    pl = spectrum_pool_from_line(line);
+
+    if (pl)
+    {
+        spectrum_pool_ref(pl);
+        return &pl->line;
+    }
+
+    pl = spectrum_pool_get();
+
+    if (!pl)
+    {
+        return NULL;
+    }
+
+    pl->line = *line;
+    pl->line.spectrum_data = pl->data;
+    memcpy(pl->data, line->spectrum_data, line->spectrum_data_length);
+
+    return &pl->line;
+}
+
+/**
+ * \brief drop a line taken with rig_spectrum_line_hold()
+ * \param line  The line rig_spectrum_line_hold() returned
+ */
+void HAMLIB_API rig_spectrum_line_release(struct rig_spectrum_line *line)
+{
+    struct spectrum_pool_line *pl = (struct spectrum_pool_line *) line;
+
+    if (pl < pool || pl >= pool + SPECTRUM_POOL_SIZE
+            || (char *) pl != (char *) &pool[pl - pool])
+    {
+        rig_debug(RIG_DEBUG_BUG, "%s: line %p is not from the pool\n", __func__,
+                  (void *) line);
+        return;
+    }
+
+    spectrum_pool_put(pl);
+}
+
+/** @} */
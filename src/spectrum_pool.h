@@ -0,0 +1,50 @@
+/*
+ *  Hamlib Interface - spectrum line pool
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _SPECTRUM_POOL_H
+#define _SPECTRUM_POOL_H 1
+
+#include <hamlib/rig.h>
+
+#define SPECTRUM_POOL_SIZE 16
+
+/*
+ * A spectrum line with room for its data.  line.spectrum_data points at
+ * data[] and the buffer goes back to the pool when the last reference is
+ * dropped.
+ */
+struct spectrum_pool_line
+{
+    struct rig_spectrum_line line;
+    unsigned char data[HAMLIB_MAX_SPECTRUM_DATA];
+    int refs;
+};
+
+/* Take a free line with one reference, NULL if all are in use */
+struct spectrum_pool_line *spectrum_pool_get(void);
+void spectrum_pool_ref(struct spectrum_pool_line *pl);
+void spectrum_pool_put(struct spectrum_pool_line *pl);
+
+/* The pool line whose data \a line uses, NULL if it is not from the pool */
+struct spectrum_pool_line *spectrum_pool_from_line(const struct rig_spectrum_line
+        *line);
+
+#endif /* _SPECTRUM_POOL_H */
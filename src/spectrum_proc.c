@@ -0,0 +1,312 @@
+/*
+ *  Hamlib Interface - spectrum line processing
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Optional processing between rig_fire_spectrum_event() and everything
+ * downstream of it (callbacks, multicast), set with the confs
+ *
+ *   spectrum_lines   combine this many lines into one, by average or peak
+ *   spectrum_reduce  Average or Peak, for lines and bins alike
+ *   spectrum_width   reduce a line to at most this many bins
+ *   spectrum_db      rescale the data to 1 dB per step above signal_strength_min
+ *
+ * so a remote panadapter gets the smoothed, decimated line and not a copy
+ * of every raw one.  The per-line work is done by the SSE2/NEON kernels
+ * below; the rest runs once per output line.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "spectrum_proc.h"
+
+struct spectrum_proc_scope
+{
+    uint16_t sum[HAMLIB_MAX_SPECTRUM_DATA];
+    unsigned char peak[HAMLIB_MAX_SPECTRUM_DATA];
+    int count;
+    size_t length;
+    enum rig_spectrum_mode_e mode;
+    freq_t low_edge_freq;
+    freq_t high_edge_freq;
+};
+
+struct spectrum_proc
+{
+    struct spectrum_proc_scope scope[HAMLIB_MAX_SPECTRUM_SCOPES];
+};
+
+/* sum[i] += src[i] */
+static void spectrum_sum_u8(uint16_t *sum, const unsigned char *src, size_t n)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i lo = _mm_loadu_si128((const __m128i *)(sum + i));
+        __m128i hi = _mm_loadu_si128((const __m128i *)(sum + i + 8));
+
+        lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+        hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+        _mm_storeu_si128((__m128i *)(sum + i), lo);
+        _mm_storeu_si128((__m128i *)(sum + i + 8), hi);
+    }
+
+#elif defined(__ARM_NEON)
+
+    for (; i + 16 <= n; i += 16)
+    {
+        uint8x16_t v = vld1q_u8(src + i);
+
+        vst1q_u16(sum + i, vaddw_u8(vld1q_u16(sum + i), vget_low_u8(v)));
+        vst1q_u16(sum + i + 8, vaddw_u8(vld1q_u16(sum + i + 8), vget_high_u8(v)));
+    }
+
+#endif
+
+    for (; i < n; i++)
+    {
+        sum[i] += src[i];
+    }
+}
+
+/* peak[i] = max(peak[i], src[i]) */
+static void spectrum_peak_u8(unsigned char *peak, const unsigned char *src,
+                             size_t n)
+{
+    size_t i = 0;
+
+#if defined(__SSE2__)
+
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i *)(src + i));
+        __m128i p = _mm_loadu_si128((const __m128i *)(peak + i));
+
+        _mm_storeu_si128((__m128i *)(peak + i), _mm_max_epu8(p, v));
+    }
+
+#elif defined(__ARM_NEON)
+
+    for (; i + 16 <= n; i += 16)
+    {
+        vst1q_u8(peak + i, vmaxq_u8(vld1q_u8(peak + i), vld1q_u8(src + i)));
+    }
+
+#endif
+
+    for (; i < n; i++)
+    {
+        if (src[i] > peak[i]) { peak[i] = src[i]; }
+    }
+}
+
+int spectrum_proc_active(RIG *rig)
+{
+    const struct rig_state *rs = &rig->state;
+
+    return rs->spectrum_lines > 1 || rs->spectrum_width > 0 || rs->spectrum_db;
+}
+
+/* combine groups of bins, in place */
+static size_t spectrum_decimate(unsigned char *data, size_t length, int width,
+                                int peak)
+{
+    size_t factor = (length + width - 1) / width;
+    size_t i, j;
+
+    for (i = 0, j = 0; i < length; i += factor, j++)
+    {
+        size_t end = i + factor < length ? i + factor : length;
+        unsigned int acc = 0;
+        size_t k;
+
+        for (k = i; k < end; k++)
+        {
+            if (peak) { acc = data[k] > acc ? data[k] : acc; }
+            else { acc += data[k]; }
+        }
+
+        data[j] = peak ? acc : (acc + (end - i) / 2) / (end - i);
+    }
+
+    return j;
+}
+
+/* data levels to dB above signal_strength_min, in place */
+static void spectrum_rescale_db(struct rig_spectrum_line *line)
+{
+    int lmin = line->data_level_min;
+    int lmax = line->data_level_max;
+    int range = (int)(line->signal_strength_max - line->signal_strength_min + 0.5);
+    size_t i;
+
+    if (lmax <= lmin || range <= 0)
+    {
+        return;
+    }
+
+    if (range > 255) { range = 255; }
+
+    for (i = 0; i < line->spectrum_data_length; i++)
+    {
+        int v = line->spectrum_data[i];
+
+        if (v < lmin) { v = lmin; }
+
+        if (v > lmax) { v = lmax; }
+
+        line->spectrum_data[i] = ((v - lmin) * range + (lmax - lmin) / 2) /
+                                 (lmax - lmin);
+    }
+
+    line->data_level_min = 0;
+    line->data_level_max = range;
+}
+
+struct spectrum_pool_line *spectrum_proc_line(RIG *rig,
+        const struct rig_spectrum_line *line)
+{
+    struct rig_state *rs = &rig->state;
+    struct spectrum_proc *proc = rs->spectrum_proc;
+    struct spectrum_proc_scope *sc;
+    struct spectrum_pool_line *pl;
+    size_t length = line->spectrum_data_length;
+    int lines = rs->spectrum_lines > 1 ? rs->spectrum_lines : 1;
+    int peak = rs->spectrum_reduce == SPECTRUM_REDUCE_PEAK;
+    size_t i;
+
+    if (line->id < 0 || line->id >= HAMLIB_MAX_SPECTRUM_SCOPES
+            || length > HAMLIB_MAX_SPECTRUM_DATA)
+    {
+        return NULL;
+    }
+
+    if (!proc)
+    {
+        proc = calloc(1, sizeof(*proc));
+
+        if (!proc)
+        {
+            return NULL;
+        }
+
+        rs->spectrum_proc = proc;
+    }
+
+    sc = &proc->scope[line->id];
+
+    // a retuned scope starts a new group
+    if (sc->count && (sc->length != length || sc->mode != line->spectrum_mode
+                      || sc->low_edge_freq != line->low_edge_freq
+                      || sc->high_edge_freq != line->high_edge_freq))
+    {
+        sc->count = 0;
+    }
+
+    if (sc->count == 0)
+    {
+        sc->length = length;
+        sc->mode = line->spectrum_mode;
+        sc->low_edge_freq = line->low_edge_freq;
+        sc->high_edge_freq = line->high_edge_freq;
+
+        if (peak)
+        {
+            memcpy(sc->peak, line->spectrum_data, length);
+        }
+        else
+        {
+            for (i = 0; i < length; i++) { sc->sum[i] = line->spectrum_data[i]; }
+        }
+    }
+    else if (peak)
+    {
+        spectrum_peak_u8(sc->peak, line->spectrum_data, length);
+    }
+    else
+    {
+        spectrum_sum_u8(sc->sum, line->spectrum_data, length);
+    }
+
+    if (++sc->count < lines)
+    {
+        return NULL;
+    }
+
+    pl = spectrum_pool_get();
+
+    if (!pl)
+    {
+        // restart the group rather than overflow the sums
+        sc->count = 0;
+        return NULL;
+    }
+
+    pl->line = *line;
+    pl->line.spectrum_data = pl->data;
+
+    if (peak)
+    {
+        memcpy(pl->data, sc->peak, length);
+    }
+    else
+    {
+        for (i = 0; i < length; i++)
+        {
+            pl->data[i] = (sc->sum[i] + sc->count / 2) / sc->count;
+        }
+    }
+
+    sc->count = 0;
+
+    if (rs->spectrum_width > 0 && length > (size_t) rs->spectrum_width)
+    {
+        pl->line.spectrum_data_length = spectrum_decimate(pl->data, length,
+                                        rs->spectrum_width, peak);
+    }
+
+    if (rs->spectrum_db)
+    {
+        spectrum_rescale_db(&pl->line);
+    }
+
+    return pl;
+}
+
+void spectrum_proc_free(RIG *rig)
+{
+    free(rig->state.spectrum_proc);
+    rig->state.spectrum_proc = NULL;
+}
@@ -0,0 +1,47 @@
+/*
+ *  Hamlib Interface - spectrum line processing
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _SPECTRUM_PROC_H
+#define _SPECTRUM_PROC_H 1
+
+#include <hamlib/rig.h>
+#include "spectrum_pool.h"
+
+/* values of rig_state.spectrum_reduce */
+#define SPECTRUM_REDUCE_AVERAGE 0
+#define SPECTRUM_REDUCE_PEAK    1
+
+#define SPECTRUM_PROC_MAX_LINES 256 /* keeps the 16-bit sums from overflowing */
+
+/* Non-zero if any of the spectrum_* processing confs is set */
+int spectrum_proc_active(RIG *rig);
+
+/*
+ * Feed a scope line to the processing stage.  Returns a pool line holding
+ * one reference when a processed line is ready, NULL while lines are being
+ * accumulated.
+ */
+struct spectrum_pool_line *spectrum_proc_line(RIG *rig,
+        const struct rig_spectrum_line *line);
+
+void spectrum_proc_free(RIG *rig);
+
+#endif /* _SPECTRUM_PROC_H */
@@ -24,6 +24,7 @@
 
 #include <stdio.h>   /* Standard input/output definitions */
 #include <string.h>  /* String function definitions */
+#include <pthread.h>
 
 #include <hamlib/rig.h>
 #include <hamlib/rotator.h>
@@ -50,6 +51,107 @@ int check_buffer_overflow(char *str, int len, int nlen)
 }
 
 
+/*
+ * Append ms and a space at str + len, for the lists below.  Keeping the
+ * length instead of strcat()ing makes a 64 entry list linear, and an
+ * entry that does not fit is left out rather than run past nlen.
+ */
+static int sprintf_append(char *str, int nlen, int len, const char *ms)
+{
+    int n = strlen(ms);
+
+    if (len + n + 1 >= nlen)
+    {
+        return len;
+    }
+
+    memcpy(str + len, ms, n);
+    str[len + n] = ' ';
+    str[len + n + 1] = '\0';
+
+    return len + n + 1;
+}
+
+
+/*
+ * The *_gran lists run sprintf("%g") on every setting and are asked for
+ * the same caps each time a client connects and dumps them, so the last
+ * few results are kept, keyed by the kind of list, the setting bits and
+ * a copy of the granularity table.
+ */
+#define GRAN_MEMO_SIZE 8
+
+enum gran_memo_kind { GRAN_RIG_LEVEL, GRAN_ROT_LEVEL, GRAN_RIG_PARM, GRAN_ROT_PARM };
+
+static struct gran_memo
+{
+    int used;
+    enum gran_memo_kind kind;
+    setting_t setting;
+    gran_t gran[RIG_SETTING_MAX];
+    int len;
+    char str[SPRINTF_MAX_SIZE * 4];
+} gran_memo[GRAN_MEMO_SIZE];
+
+static int gran_memo_next;
+static pthread_mutex_t gran_memo_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* Copies the kept list to str and returns its length, or -1 */
+static int gran_memo_get(enum gran_memo_kind kind, setting_t setting,
+                         const gran_t *gran, char *str, int nlen)
+{
+    int i, len = -1;
+
+    pthread_mutex_lock(&gran_memo_lock);
+
+    for (i = 0; i < GRAN_MEMO_SIZE; i++)
+    {
+        const struct gran_memo *m = &gran_memo[i];
+
+        if (m->used && m->kind == kind && m->setting == setting
+                && m->len < nlen
+                && !memcmp(m->gran, gran, sizeof(m->gran)))
+        {
+            memcpy(str, m->str, m->len + 1);
+            len = m->len;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&gran_memo_lock);
+
+    return len;
+}
+
+
+/* A list that filled nlen may have been cut short and is not kept */
+static void gran_memo_put(enum gran_memo_kind kind, setting_t setting,
+                          const gran_t *gran, const char *str, int len, int nlen)
+{
+    struct gran_memo *m;
+
+    if (len < 0 || len + 1 >= nlen || len >= (int) sizeof(m->str))
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&gran_memo_lock);
+
+    m = &gran_memo[gran_memo_next];
+    gran_memo_next = (gran_memo_next + 1) % GRAN_MEMO_SIZE;
+
+    m->used = 1;
+    m->kind = kind;
+    m->setting = setting;
+    memcpy(m->gran, gran, sizeof(m->gran));
+    memcpy(m->str, str, len + 1);
+    m->len = len;
+
+    pthread_mutex_unlock(&gran_memo_lock);
+}
+
+
 int rig_sprintf_vfo(char *str, int nlen, vfo_t vfo)
 {
     unsigned int i, len = 0;
@@ -69,7 +171,7 @@ int rig_sprintf_vfo(char *str, int nlen, vfo_t vfo)
 
         if (sv && sv[0] && (strstr(sv, "None") == 0))
         {
-            len += sprintf(str + len, "%s ", sv);
+            len = sprintf_append(str, nlen, len, sv);
             check_buffer_overflow(str, len, nlen);
         }
     }
@@ -98,9 +200,7 @@ int rig_sprintf_mode(char *str, int nlen, rmode_t mode)
             continue;    /* unknown, FIXME! */
         }
 
-        strcat(str, ms);
-        strcat(str, " ");
-        len += strlen(ms) + 1;
+        len = sprintf_append(str, nlen, len, ms);
         check_buffer_overflow(str, len, nlen);
     }
 
@@ -147,7 +247,7 @@ int rig_sprintf_ant(char *str, int str_len, ant_t ant)
                 break;
             }
 
-            len += sprintf(str + len, "%s ", ant_name);
+            len = sprintf_append(str, str_len, len, ant_name);
             check_buffer_overflow(str, len, str_len);
         }
     }
@@ -176,9 +276,7 @@ int rig_sprintf_func(char *str, int nlen, setting_t func)
             continue;    /* unknown, FIXME! */
         }
 
-        strcat(str, ms);
-        strcat(str, " ");
-        len += strlen(ms) + 1;
+        len = sprintf_append(str, nlen, len, ms);
         check_buffer_overflow(str, len, nlen);
     }
 
@@ -206,9 +304,7 @@ int rot_sprintf_func(char *str, int nlen, setting_t func)
             continue;    /* unknown, FIXME! */
         }
 
-        strcat(str, ms);
-        strcat(str, " ");
-        len += strlen(ms) + 1;
+        len = sprintf_append(str, nlen, len, ms);
         check_buffer_overflow(str, len, nlen);
     }
 
@@ -236,9 +332,7 @@ int rig_sprintf_level(char *str, int nlen, setting_t level)
             continue;    /* unknown, FIXME! */
         }
 
-        strcat(str, ms);
-        strcat(str, " ");
-        len += strlen(ms) + 1;
+        len = sprintf_append(str, nlen, len, ms);
         check_buffer_overflow(str, len, nlen);
     }
 
@@ -266,9 +360,7 @@ int rot_sprintf_level(char *str, int nlen, setting_t level)
             continue;    /* unknown, FIXME! */
         }
 
-        strcat(str, ms);
-        strcat(str, " ");
-        len += strlen(ms) + 1;
+        len = sprintf_append(str, nlen, len, ms);
         check_buffer_overflow(str, len, nlen);
     }
 
@@ -296,9 +388,7 @@ int amp_sprintf_level(char *str, int nlen, setting_t level)
             continue;    /* unknown, FIXME! */
         }
 
-        strcat(str, ms);
-        strcat(str, " ");
-        len += strlen(ms) + 1;
+        len = sprintf_append(str, nlen, len, ms);
         check_buffer_overflow(str, len, nlen);
     }
 
@@ -331,9 +421,7 @@ int sprintf_level_ext(char *str, int nlen, const struct confparams *extlevels)
         case RIG_CONF_NUMERIC:
         case RIG_CONF_STRING:
         case RIG_CONF_BINARY:
-            strcat(str, extlevels->name);
-            strcat(str, " ");
-            len += strlen(extlevels->name) + 1;
+            len = sprintf_append(str, nlen, len, extlevels->name);
             break;
 
         case RIG_CONF_BUTTON:
@@ -360,6 +448,15 @@ int rig_sprintf_level_gran(char *str, int nlen, setting_t level,
         return 0;
     }
 
+    len = gran_memo_get(GRAN_RIG_LEVEL, level, gran, str, nlen);
+
+    if (len >= 0)
+    {
+        return len;
+    }
+
+    len = 0;
+
     for (i = 0; i < RIG_SETTING_MAX; i++)
     {
         const char *ms;
@@ -383,26 +480,34 @@ int rig_sprintf_level_gran(char *str, int nlen, setting_t level,
 
         if (RIG_LEVEL_IS_FLOAT(rig_idx2setting(i)))
         {
-            len += sprintf(str + len,
-                           "%s(%g..%g/%g) ",
-                           ms,
-                           gran[i].min.f,
-                           gran[i].max.f,
-                           gran[i].step.f);
+            len += snprintf(str + len, nlen - len,
+                            "%s(%g..%g/%g) ",
+                            ms,
+                            gran[i].min.f,
+                            gran[i].max.f,
+                            gran[i].step.f);
         }
         else
         {
-            len += sprintf(str + len,
-                           "%s(%d..%d/%d) ",
-                           ms,
-                           gran[i].min.i,
-                           gran[i].max.i,
-                           gran[i].step.i);
+            len += snprintf(str + len, nlen - len,
+                            "%s(%d..%d/%d) ",
+                            ms,
+                            gran[i].min.i,
+                            gran[i].max.i,
+                            gran[i].step.i);
         }
 
         check_buffer_overflow(str, len, nlen);
+
+        if (len >= nlen)
+        {
+            len = nlen - 1;     /* truncated */
+            break;
+        }
     }
 
+    gran_memo_put(GRAN_RIG_LEVEL, level, gran, str, len, nlen);
+
     return len;
 }
 
@@ -419,6 +524,15 @@ int rot_sprintf_level_gran(char *str, int nlen, setting_t level,
         return 0;
     }
 
+    len = gran_memo_get(GRAN_ROT_LEVEL, level, gran, str, nlen);
+
+    if (len >= 0)
+    {
+        return len;
+    }
+
+    len = 0;
+
     for (i = 0; i < RIG_SETTING_MAX; i++)
     {
         const char *ms;
@@ -442,26 +556,34 @@ int rot_sprintf_level_gran(char *str, int nlen, setting_t level,
 
         if (ROT_LEVEL_IS_FLOAT(rig_idx2setting(i)))
         {
-            len += sprintf(str + len,
-                           "%s(%g..%g/%g) ",
-                           ms,
-                           gran[i].min.f,
-                           gran[i].max.f,
-                           gran[i].step.f);
+            len += snprintf(str + len, nlen - len,
+                            "%s(%g..%g/%g) ",
+                            ms,
+                            gran[i].min.f,
+                            gran[i].max.f,
+                            gran[i].step.f);
         }
         else
         {
-            len += sprintf(str + len,
-                           "%s(%d..%d/%d) ",
-                           ms,
-                           gran[i].min.i,
-                           gran[i].max.i,
-                           gran[i].step.i);
+            len += snprintf(str + len, nlen - len,
+                            "%s(%d..%d/%d) ",
+                            ms,
+                            gran[i].min.i,
+                            gran[i].max.i,
+                            gran[i].step.i);
         }
 
         check_buffer_overflow(str, len, nlen);
+
+        if (len >= nlen)
+        {
+            len = nlen - 1;     /* truncated */
+            break;
+        }
     }
 
+    gran_memo_put(GRAN_ROT_LEVEL, level, gran, str, len, nlen);
+
     return len;
 }
 
@@ -486,9 +608,7 @@ int rig_sprintf_parm(char *str, int nlen, setting_t parm)
             continue;    /* unknown, FIXME! */
         }
 
-        strcat(str, ms);
-        strcat(str, " ");
-        len += strlen(ms) + 1;
+        len = sprintf_append(str, nlen, len, ms);
         check_buffer_overflow(str, len, nlen);
     }
 
@@ -516,9 +636,7 @@ int rot_sprintf_parm(char *str, int nlen, setting_t parm)
             continue;    /* unknown, FIXME! */
         }
 
-        strcat(str, ms);
-        strcat(str, " ");
-        len += strlen(ms) + 1;
+        len = sprintf_append(str, nlen, len, ms);
         check_buffer_overflow(str, len, nlen);
     }
 
@@ -538,6 +656,15 @@ int rig_sprintf_parm_gran(char *str, int nlen, setting_t parm,
         return 0;
     }
 
+    len = gran_memo_get(GRAN_RIG_PARM, parm, gran, str, nlen);
+
+    if (len >= 0)
+    {
+        return len;
+    }
+
+    len = 0;
+
     for (i = 0; i < RIG_SETTING_MAX; i++)
     {
         const char *ms;
@@ -561,26 +688,34 @@ int rig_sprintf_parm_gran(char *str, int nlen, setting_t parm,
 
         if (RIG_PARM_IS_FLOAT(rig_idx2setting(i)))
         {
-            len += sprintf(str + len,
-                           "%s(%g..%g/%g) ",
-                           ms,
-                           gran[i].min.f,
-                           gran[i].max.f,
-                           gran[i].step.f);
+            len += snprintf(str + len, nlen - len,
+                            "%s(%g..%g/%g) ",
+                            ms,
+                            gran[i].min.f,
+                            gran[i].max.f,
+                            gran[i].step.f);
         }
         else
         {
-            len += sprintf(str + len,
-                           "%s(%d..%d/%d) ",
-                           ms,
-                           gran[i].min.i,
-                           gran[i].max.i,
-                           gran[i].step.i);
+            len += snprintf(str + len, nlen - len,
+                            "%s(%d..%d/%d) ",
+                            ms,
+                            gran[i].min.i,
+                            gran[i].max.i,
+                            gran[i].step.i);
         }
 
         check_buffer_overflow(str, len, nlen);
+
+        if (len >= nlen)
+        {
+            len = nlen - 1;     /* truncated */
+            break;
+        }
     }
 
+    gran_memo_put(GRAN_RIG_PARM, parm, gran, str, len, nlen);
+
     return len;
 }
 
@@ -597,6 +732,15 @@ int rot_sprintf_parm_gran(char *str, int nlen, setting_t parm,
         return 0;
     }
 
+    len = gran_memo_get(GRAN_ROT_PARM, parm, gran, str, nlen);
+
+    if (len >= 0)
+    {
+        return len;
+    }
+
+    len = 0;
+
     for (i = 0; i < RIG_SETTING_MAX; i++)
     {
         const char *ms;
@@ -620,26 +764,34 @@ int rot_sprintf_parm_gran(char *str, int nlen, setting_t parm,
 
         if (ROT_PARM_IS_FLOAT(rig_idx2setting(i)))
         {
-            len += sprintf(str + len,
-                           "%s(%g..%g/%g) ",
-                           ms,
-                           gran[i].min.f,
-                           gran[i].max.f,
-                           gran[i].step.f);
+            len += snprintf(str + len, nlen - len,
+                            "%s(%g..%g/%g) ",
+                            ms,
+                            gran[i].min.f,
+                            gran[i].max.f,
+                            gran[i].step.f);
         }
         else
         {
-            len += sprintf(str + len,
-                           "%s(%d..%d/%d) ",
-                           ms,
-                           gran[i].min.i,
-                           gran[i].max.i,
-                           gran[i].step.i);
+            len += snprintf(str + len, nlen - len,
+                            "%s(%d..%d/%d) ",
+                            ms,
+                            gran[i].min.i,
+                            gran[i].max.i,
+                            gran[i].step.i);
         }
 
         check_buffer_overflow(str, len, nlen);
+
+        if (len >= nlen)
+        {
+            len = nlen - 1;     /* truncated */
+            break;
+        }
     }
 
+    gran_memo_put(GRAN_ROT_PARM, parm, gran, str, len, nlen);
+
     return len;
 }
 
@@ -664,9 +816,7 @@ int rig_sprintf_vfop(char *str, int nlen, vfo_op_t op)
             continue;    /* unknown, FIXME! */
         }
 
-        strcat(str, ms);
-        strcat(str, " ");
-        len += strlen(ms) + 1;
+        len = sprintf_append(str, nlen, len, ms);
         check_buffer_overflow(str, len, nlen);
     }
 
@@ -694,9 +844,7 @@ int rig_sprintf_scan(char *str, int nlen, scan_t rscan)
             continue;    /* unknown, FIXME! */
         }
 
-        strcat(str, ms);
-        strcat(str, " ");
-        len += strlen(ms) + 1;
+        len = sprintf_append(str, nlen, len, ms);
         check_buffer_overflow(str, len, nlen);
     }
 
@@ -717,14 +865,14 @@ int rot_sprintf_status(char *str, int nlen, rot_status_t status)
         return 0;
     }
 
-    for (i = 0; i < HAMLIB_MAX_ROTORS; i++)
+    for (i = 0; i < 8 * sizeof(rot_status_t); i++)
     {
         const char *sv;
         sv = rot_strstatus(status & ROT_STATUS_N(i));
 
         if (sv && sv[0] && (strstr(sv, "None") == 0))
         {
-            len += sprintf(str + len, "%s ", sv);
+            len = sprintf_append(str, nlen, len, sv);
         }
 
         check_buffer_overflow(str, len, nlen);
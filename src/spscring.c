@@ -0,0 +1,477 @@
+/*
+ *  Hamlib Interface - single producer, single consumer ring buffer
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * head only ever moves in the producer, tail only in the consumer, each
+ * published with a release store after the bytes it covers, so neither
+ * side takes a lock or makes a syscall to move data.  The size is a power
+ * of two and head/tail run free, head - tail is what is buffered.
+ *
+ * Waking the reader: every post bumps seq and the reader sleeps on seq
+ * not changing, a futex on Linux, a condition variable elsewhere.  The
+ * producer only makes the wake call when the reader has said it is
+ * waiting, so a reader that keeps up costs the producer two atomics.
+ * The reader sets waiting before it sleeps and the producer bumps seq
+ * before it looks at waiting, both sequentially consistent, so one of
+ * them always sees the other: a post cannot fall between the reader's
+ * last look and its sleep.
+ *
+ * spsc_ring_read_direct() lends the reader's own buffer to the producer.
+ * The next write, if it finds the ring empty, copies straight into that
+ * buffer instead of the ring, up to the first stop byte, and wakes the
+ * reader, which then has its reply without a second copy.  post_state
+ * says who owns the buffer: the reader moves it IDLE -> POSTED and can
+ * take it back with a CAS to IDLE, the producer claims it with a CAS to
+ * FILLING and hands it back as FILLED.  The producer only claims while
+ * the ring is empty, and the reader never reads the ring while posted,
+ * so bytes still come out in the order they went in.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include <hamlib/rig.h>
+#include "spscring.h"
+
+#ifdef HAVE_PTHREAD
+
+#if defined(__linux__) && defined(HAVE_LINUX_FUTEX_H) && defined(HAVE_SYS_SYSCALL_H)
+#  include <linux/futex.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#  define SPSC_FUTEX 1
+#else
+#  include <pthread.h>
+#endif
+
+//! @cond Doxygen_Suppress
+
+#define SPSC_CACHELINE 64
+
+enum spsc_post_e
+{
+    SPSC_IDLE,
+    SPSC_POSTED,
+    SPSC_FILLING,
+    SPSC_FILLED
+};
+
+struct spsc_ring
+{
+    unsigned char *buf;
+    size_t mask;
+
+    char pad0[SPSC_CACHELINE];
+    size_t head;            /* producer */
+    char pad1[SPSC_CACHELINE];
+    size_t tail;            /* consumer */
+    char pad2[SPSC_CACHELINE];
+
+    int error;
+    int error_set;
+    unsigned int seq;
+    int waiting;
+
+    int post_state;             /* enum spsc_post_e */
+    unsigned char *post_buf;
+    size_t post_len;
+    const char *post_stopset;
+    int post_stopset_len;
+    size_t post_filled;
+#ifndef SPSC_FUTEX
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+#endif
+};
+
+struct spsc_ring *spsc_ring_new(size_t size)
+{
+    struct spsc_ring *r;
+    size_t n = 1;
+
+    while (n < size) { n <<= 1; }
+
+    r = calloc(1, sizeof(*r));
+
+    if (!r)
+    {
+        return NULL;
+    }
+
+    r->buf = malloc(n);
+
+    if (!r->buf)
+    {
+        free(r);
+        return NULL;
+    }
+
+    r->mask = n - 1;
+#ifndef SPSC_FUTEX
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->cond, NULL);
+#endif
+
+    return r;
+}
+
+void spsc_ring_free(struct spsc_ring *r)
+{
+    if (!r)
+    {
+        return;
+    }
+
+#ifndef SPSC_FUTEX
+    pthread_cond_destroy(&r->cond);
+    pthread_mutex_destroy(&r->lock);
+#endif
+    free(r->buf);
+    free(r);
+}
+
+static void spsc_ring_kick(struct spsc_ring *r)
+{
+    __atomic_add_fetch(&r->seq, 1, __ATOMIC_SEQ_CST);
+
+    if (!__atomic_load_n(&r->waiting, __ATOMIC_SEQ_CST))
+    {
+        return;
+    }
+
+#ifdef SPSC_FUTEX
+    syscall(SYS_futex, &r->seq, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+#else
+    pthread_mutex_lock(&r->lock);
+    pthread_cond_signal(&r->cond);
+    pthread_mutex_unlock(&r->lock);
+#endif
+}
+
+/* how much of buf goes to the posted buffer: up to and with the first stop byte */
+static size_t spsc_post_span(const struct spsc_ring *r, const unsigned char *buf,
+                             size_t len)
+{
+    size_t n = len < r->post_len ? len : r->post_len;
+    size_t i;
+
+    if (r->post_stopset_len <= 0)
+    {
+        return n;
+    }
+
+    for (i = 0; i < n; i++)
+    {
+        if (memchr(r->post_stopset, buf[i], r->post_stopset_len))
+        {
+            return i + 1;
+        }
+    }
+
+    return n;
+}
+
+int spsc_ring_write(struct spsc_ring *r, const void *buf, size_t len)
+{
+    size_t head = r->head;
+    size_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    size_t off = head & r->mask;
+    size_t first;
+    int state = SPSC_POSTED;
+
+    if (head == tail
+            && __atomic_load_n(&r->post_state, __ATOMIC_ACQUIRE) == SPSC_POSTED
+            && __atomic_compare_exchange_n(&r->post_state, &state, SPSC_FILLING, 0,
+                                           __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+    {
+        size_t n = spsc_post_span(r, buf, len);
+
+        if (len - n > r->mask + 1)
+        {
+            __atomic_store_n(&r->post_state, SPSC_POSTED, __ATOMIC_RELEASE);
+            return -RIG_EIO;
+        }
+
+        memcpy(r->post_buf, buf, n);
+        r->post_filled = n;
+        __atomic_store_n(&r->post_state, SPSC_FILLED, __ATOMIC_RELEASE);
+
+        buf = (const unsigned char *) buf + n;
+        len -= n;
+
+        if (len == 0)
+        {
+            spsc_ring_kick(r);
+            return RIG_OK;
+        }
+    }
+
+    if (len > r->mask + 1 - (head - tail))
+    {
+        return -RIG_EIO;
+    }
+
+    first = r->mask + 1 - off;
+
+    if (first > len) { first = len; }
+
+    memcpy(r->buf + off, buf, first);
+    memcpy(r->buf, (const unsigned char *) buf + first, len - first);
+
+    __atomic_store_n(&r->head, head + len, __ATOMIC_RELEASE);
+    spsc_ring_kick(r);
+
+    return RIG_OK;
+}
+
+void spsc_ring_put_error(struct spsc_ring *r, int code)
+{
+    __atomic_store_n(&r->error, code, __ATOMIC_RELAXED);
+    __atomic_store_n(&r->error_set, 1, __ATOMIC_RELEASE);
+    spsc_ring_kick(r);
+}
+
+/* spsc_ring_read() stopping after the first byte in stopset */
+static size_t spsc_ring_read_until(struct spsc_ring *r, void *buf, size_t len,
+                                   const char *stopset, int stopset_len)
+{
+    size_t tail = r->tail;
+    size_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    size_t off = tail & r->mask;
+    size_t first;
+
+    if (len > head - tail) { len = head - tail; }
+
+    if (stopset_len > 0)
+    {
+        size_t i;
+
+        for (i = 0; i < len; i++)
+        {
+            if (memchr(stopset, r->buf[(tail + i) & r->mask], stopset_len))
+            {
+                len = i + 1;
+                break;
+            }
+        }
+    }
+
+    first = r->mask + 1 - off;
+
+    if (first > len) { first = len; }
+
+    memcpy(buf, r->buf + off, first);
+    memcpy((unsigned char *) buf + first, r->buf, len - first);
+
+    __atomic_store_n(&r->tail, tail + len, __ATOMIC_RELEASE);
+
+    return len;
+}
+
+size_t spsc_ring_read(struct spsc_ring *r, void *buf, size_t len)
+{
+    return spsc_ring_read_until(r, buf, len, NULL, 0);
+}
+
+int spsc_ring_get_error(struct spsc_ring *r, int *code)
+{
+    if (!__atomic_exchange_n(&r->error_set, 0, __ATOMIC_ACQ_REL))
+    {
+        return 0;
+    }
+
+    *code = __atomic_load_n(&r->error, __ATOMIC_RELAXED);
+
+    return 1;
+}
+
+static int spsc_ring_ready(struct spsc_ring *r)
+{
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) != r->tail
+           || __atomic_load_n(&r->error_set, __ATOMIC_ACQUIRE);
+}
+
+static long spsc_ms_since(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start->tv_sec) * 1000L
+           + (now.tv_nsec - start->tv_nsec) / 1000000L;
+}
+
+/* sleep until seq moves away from seen, at most left ms */
+static void spsc_ring_sleep(struct spsc_ring *r, unsigned int seen, long left)
+{
+    __atomic_store_n(&r->waiting, 1, __ATOMIC_SEQ_CST);
+
+#ifdef SPSC_FUTEX
+    {
+        struct timespec ts;
+
+        ts.tv_sec = left / 1000;
+        ts.tv_nsec = (left % 1000) * 1000000L;
+
+        // returns at once if seq has moved since we looked
+        syscall(SYS_futex, &r->seq, FUTEX_WAIT_PRIVATE, seen, &ts, NULL, 0);
+    }
+#else
+    {
+        struct timespec abstime;
+
+        // pthread_cond_timedwait() wants CLOCK_REALTIME
+        clock_gettime(CLOCK_REALTIME, &abstime);
+        abstime.tv_sec += left / 1000;
+        abstime.tv_nsec += (left % 1000) * 1000000L;
+
+        if (abstime.tv_nsec >= 1000000000L)
+        {
+            abstime.tv_sec++;
+            abstime.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&r->lock);
+
+        while (__atomic_load_n(&r->seq, __ATOMIC_SEQ_CST) == seen)
+        {
+            if (pthread_cond_timedwait(&r->cond, &r->lock, &abstime) == ETIMEDOUT)
+            {
+                break;
+            }
+        }
+
+        pthread_mutex_unlock(&r->lock);
+    }
+#endif
+
+    __atomic_store_n(&r->waiting, 0, __ATOMIC_SEQ_CST);
+}
+
+int spsc_ring_wait(struct spsc_ring *r, int timeout_ms)
+{
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (;;)
+    {
+        unsigned int seen = __atomic_load_n(&r->seq, __ATOMIC_SEQ_CST);
+        long left;
+
+        if (spsc_ring_ready(r))
+        {
+            return RIG_OK;
+        }
+
+        left = timeout_ms - spsc_ms_since(&start);
+
+        if (left <= 0)
+        {
+            return -RIG_ETIMEOUT;
+        }
+
+        spsc_ring_sleep(r, seen, left);
+    }
+}
+
+/* take the buffer back from the producer, 0 if it already has it */
+static int spsc_ring_unpost(struct spsc_ring *r)
+{
+    int state = SPSC_POSTED;
+
+    return __atomic_compare_exchange_n(&r->post_state, &state, SPSC_IDLE, 0,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+int spsc_ring_read_direct(struct spsc_ring *r, void *buf, size_t len,
+                          const char *stopset, int stopset_len, int timeout_ms)
+{
+    struct timespec start;
+    int code;
+
+    if (len == 0)
+    {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (;;)
+    {
+        long left;
+
+        if (spsc_ring_get_error(r, &code))
+        {
+            return code;
+        }
+
+        if (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) != r->tail)
+        {
+            return (int) spsc_ring_read_until(r, buf, len, stopset, stopset_len);
+        }
+
+        r->post_buf = buf;
+        r->post_len = len;
+        r->post_stopset = stopset;
+        r->post_stopset_len = stopset ? stopset_len : 0;
+        __atomic_store_n(&r->post_state, SPSC_POSTED, __ATOMIC_SEQ_CST);
+
+        for (;;)
+        {
+            unsigned int seen = __atomic_load_n(&r->seq, __ATOMIC_SEQ_CST);
+
+            if (__atomic_load_n(&r->post_state, __ATOMIC_ACQUIRE) == SPSC_FILLED)
+            {
+                __atomic_store_n(&r->post_state, SPSC_IDLE, __ATOMIC_RELAXED);
+                return (int) r->post_filled;
+            }
+
+            left = timeout_ms - spsc_ms_since(&start);
+
+            // something went to the ring or an error came: start over
+            if ((spsc_ring_ready(r) || left <= 0) && spsc_ring_unpost(r))
+            {
+                break;
+            }
+
+            if (left <= 0)
+            {
+                left = 1;   /* the producer is filling our buffer right now */
+            }
+
+            spsc_ring_sleep(r, seen, left);
+        }
+
+        if (left <= 0 && !spsc_ring_ready(r))
+        {
+            return -RIG_ETIMEOUT;
+        }
+    }
+}
+
+//! @endcond
+
+#endif /* HAVE_PTHREAD */
@@ -0,0 +1,56 @@
+/*
+ *  Hamlib Interface - single producer, single consumer ring buffer
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _SPSCRING_H
+#define _SPSCRING_H 1
+
+#include <stddef.h>
+
+/*
+ * A byte stream from one thread to another in the same process, standing
+ * in for a pipe where nobody needs a selectable fd -- see spscring.c.
+ * Besides the bytes the ring carries one error code, the latest one
+ * posted, which wakes the reader the same way.
+ */
+struct spsc_ring;
+
+struct spsc_ring *spsc_ring_new(size_t size);
+void spsc_ring_free(struct spsc_ring *r);
+
+/* Producer: all len bytes or none, -RIG_EIO when there is no room */
+int spsc_ring_write(struct spsc_ring *r, const void *buf, size_t len);
+void spsc_ring_put_error(struct spsc_ring *r, int code);
+
+/* Consumer: whatever is there up to len, 0 when empty */
+size_t spsc_ring_read(struct spsc_ring *r, void *buf, size_t len);
+/* 1 and the code in *code if an error was posted since the last call */
+int spsc_ring_get_error(struct spsc_ring *r, int *code);
+/* RIG_OK once bytes or an error are there, -RIG_ETIMEOUT after timeout_ms */
+int spsc_ring_wait(struct spsc_ring *r, int timeout_ms);
+/*
+ * Wait and read in one: bytes up to len, stopping after a byte from
+ * stopset, written by the producer straight into buf when the ring is
+ * empty.  A posted error code or -RIG_ETIMEOUT otherwise.
+ */
+int spsc_ring_read_direct(struct spsc_ring *r, void *buf, size_t len,
+                          const char *stopset, int stopset_len, int timeout_ms);
+
+#endif /* _SPSCRING_H */
@@ -0,0 +1,1022 @@
+/*
+ *  Hamlib Interface - station event bus
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \addtogroup station
+ * @{
+ */
+
+/**
+ * \file src/station.c
+ * \brief Station event bus
+ *
+ * One thread per station samples the rig, rotator and amplifier, keeps the
+ * last text line sent for every value, and sends a line only when its text
+ * changes.  The format therefore decides what counts as a change: a
+ * rotator moving by less than 0.1 degree, or an SWR by less than 0.01,
+ * sends nothing.
+ *
+ * The rig's freq, mode and PTT callbacks, when the application has not set
+ * them, wake the thread at once, so transceive updates go out without
+ * waiting for the next round.
+ *
+ * Every TCP subscriber has an output buffer.  One that falls behind by a
+ * full buffer skips the changes it missed and gets a fresh line for every
+ * value once it has drained, so a stalled client never holds up the others.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#include <hamlib/station.h>
+
+#include "network.h"
+#include "misc.h"
+#include "band_follow.h"
+
+#if defined(HAVE_PTHREAD) && defined(HAVE_POLL_H) && defined(HAVE_SYS_SOCKET_H) \
+    && defined(HAVE_NETINET_IN_H) && defined(HAVE_ARPA_INET_H)
+
+#include <pthread.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define STATION_MAX_CLIENTS 16
+#define STATION_LINE_LEN 80
+/* what fits in one multicast datagram */
+#define STATION_DATAGRAM 1400
+
+#ifndef MSG_NOSIGNAL
+#  define MSG_NOSIGNAL 0
+#endif
+
+/* one slot per value, holding the last line sent for it */
+enum
+{
+    SLOT_RIG_FREQ,
+    SLOT_RIG_MODE,
+    SLOT_RIG_PTT,
+    SLOT_ROT_POS,
+    SLOT_AMP_POWERSTAT,
+    SLOT_AMP_FREQ,
+    SLOT_AMP_LEVEL,
+    NSLOTS = SLOT_AMP_LEVEL + RIG_SETTING_MAX
+};
+
+struct station_client
+{
+    int fd;                 /* -1 when the slot is free */
+    int resync;             /* missed lines, send every value once drained */
+    size_t len;
+    char out[4096];
+};
+
+struct station
+{
+    RIG *rig;
+    ROT *rot;
+    AMP *amp;
+
+    station_cb_t cb;
+    rig_ptr_t cb_arg;
+    int follow;
+    int amp_band;           /* band last sent to the amplifier, -1 for none */
+
+    int listen_fd;
+    int mcast_fd;
+    struct sockaddr_in mcast_addr;
+
+    int interval_ms;
+    pthread_t thread;
+    int running;
+    int wake[2];
+    volatile int stop;
+    int hooked;             /* we installed the rig callbacks */
+
+    char last[NSLOTS][STATION_LINE_LEN];
+    struct station_client clients[STATION_MAX_CLIENTS];
+    size_t batch_len;
+    char batch[NSLOTS * STATION_LINE_LEN];
+};
+
+
+static void station_wake(STATION *st)
+{
+    if (write(st->wake[1], "w", 1) < 0 && errno != EAGAIN)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: %s\n", __func__, strerror(errno));
+    }
+}
+
+
+static int station_freq_cb(RIG *rig, vfo_t vfo, freq_t freq, rig_ptr_t arg)
+{
+    station_wake((STATION *) arg);
+    return RIG_OK;
+}
+
+
+static int station_mode_cb(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width,
+                           rig_ptr_t arg)
+{
+    station_wake((STATION *) arg);
+    return RIG_OK;
+}
+
+
+static int station_ptt_cb(RIG *rig, vfo_t vfo, ptt_t ptt, rig_ptr_t arg)
+{
+    station_wake((STATION *) arg);
+    return RIG_OK;
+}
+
+
+/* the rig callbacks are the application's if it set them */
+static void station_hook_rig(STATION *st)
+{
+    struct rig_callbacks *cb;
+
+    if (!st->rig)
+    {
+        return;
+    }
+
+    cb = &st->rig->callbacks;
+
+    if (cb->freq_event || cb->mode_event || cb->ptt_event)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE,
+                  "%s: rig callbacks in use, rig changes wait for the next round\n", __func__);
+        return;
+    }
+
+    rig_set_freq_callback(st->rig, station_freq_cb, st);
+    rig_set_mode_callback(st->rig, station_mode_cb, st);
+    rig_set_ptt_callback(st->rig, station_ptt_cb, st);
+    st->hooked = 1;
+}
+
+
+static void station_unhook_rig(STATION *st)
+{
+    if (!st->hooked)
+    {
+        return;
+    }
+
+    rig_set_freq_callback(st->rig, NULL, NULL);
+    rig_set_mode_callback(st->rig, NULL, NULL);
+    rig_set_ptt_callback(st->rig, NULL, NULL);
+    st->hooked = 0;
+}
+
+
+/*
+ * Format the line of a value, and publish the event if the line is not
+ * the one sent last time for that value.
+ */
+static void station_emit(STATION *st, int slot, struct station_event *ev,
+                         const char *fmt, ...)
+{
+    char line[STATION_LINE_LEN];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(line, sizeof(line), fmt, ap);
+    va_end(ap);
+
+    if (!strcmp(st->last[slot], line))
+    {
+        return;
+    }
+
+    strcpy(st->last[slot], line);
+    ev->line = st->last[slot];
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: %s\n", __func__, line);
+
+    if (st->cb)
+    {
+        st->cb(st, ev, st->cb_arg);
+    }
+
+    if (st->batch_len + strlen(line) + 1 < sizeof(st->batch))
+    {
+        st->batch_len += sprintf(st->batch + st->batch_len, "%s\n", line);
+    }
+
+    /* cross-device actions, in process and without a round trip */
+    if (ev->device == STATION_RIG && ev->item == STATION_FREQ
+            && (st->follow & STATION_FOLLOW_AMP_FREQ)
+            && st->amp && st->amp->state.comm_state)
+    {
+        int band = band_follow_band(ev->freq);
+
+        if (band >= 0 && band != st->amp_band
+                && amp_set_freq(st->amp, ev->freq) == RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: amplifier follows to %.0f Hz\n", __func__,
+                      ev->freq);
+            st->amp_band = band;
+        }
+    }
+}
+
+
+static void station_sample_rig(STATION *st)
+{
+    RIG *rig = st->rig;
+    struct station_event ev;
+    freq_t freq;
+    rmode_t mode;
+    pbwidth_t width;
+    ptt_t ptt;
+
+    if (!rig || !rig->state.comm_state)
+    {
+        return;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.device = STATION_RIG;
+
+    if (rig->caps->get_freq && rig_get_freq(rig, RIG_VFO_CURR, &freq) == RIG_OK)
+    {
+        ev.item = STATION_FREQ;
+        ev.freq = freq;
+        station_emit(st, SLOT_RIG_FREQ, &ev, "!rig freq %.0f", freq);
+    }
+
+    if (rig->caps->get_mode
+            && rig_get_mode(rig, RIG_VFO_CURR, &mode, &width) == RIG_OK)
+    {
+        ev.item = STATION_MODE;
+        ev.mode = mode;
+        ev.width = width;
+        station_emit(st, SLOT_RIG_MODE, &ev, "!rig mode %s %ld", rig_strrmode(mode),
+                     (long) width);
+    }
+
+    if (rig_get_ptt(rig, RIG_VFO_CURR, &ptt) == RIG_OK)
+    {
+        ev.item = STATION_PTT;
+        ev.ptt = ptt;
+        station_emit(st, SLOT_RIG_PTT, &ev, "!rig ptt %d", (int) ptt);
+    }
+}
+
+
+static void station_sample_rot(STATION *st)
+{
+    struct station_event ev;
+    azimuth_t az;
+    elevation_t el;
+
+    if (!st->rot || !st->rot->state.comm_state
+            || rot_get_position(st->rot, &az, &el) != RIG_OK)
+    {
+        return;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.device = STATION_ROT;
+    ev.item = STATION_POSITION;
+    ev.az = az;
+    ev.el = el;
+    station_emit(st, SLOT_ROT_POS, &ev, "!rot pos %.1f %.1f", az, el);
+}
+
+
+static void station_sample_amp(STATION *st)
+{
+    AMP *amp = st->amp;
+    struct station_event ev;
+    powerstat_t status;
+    freq_t freq;
+    int i;
+
+    if (!amp || !amp->state.comm_state)
+    {
+        return;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.device = STATION_AMP;
+
+    if (amp->caps->get_powerstat && amp_get_powerstat(amp, &status) == RIG_OK)
+    {
+        ev.item = STATION_POWERSTAT;
+        ev.powerstat = status;
+        station_emit(st, SLOT_AMP_POWERSTAT, &ev, "!amp powerstat %d", (int) status);
+    }
+
+    if (amp->caps->get_freq && amp_get_freq(amp, &freq) == RIG_OK)
+    {
+        ev.item = STATION_FREQ;
+        ev.freq = freq;
+        station_emit(st, SLOT_AMP_FREQ, &ev, "!amp freq %.0f", freq);
+    }
+
+    for (i = 0; amp->caps->get_level && i < RIG_SETTING_MAX; i++)
+    {
+        setting_t level = rig_idx2setting(i);
+        value_t val;
+
+        if (!(amp->state.has_get_level & level)
+                || amp_get_level(amp, level, &val) != RIG_OK)
+        {
+            continue;
+        }
+
+        ev.item = STATION_LEVEL;
+        ev.level = level;
+        ev.val = val;
+
+        if (AMP_LEVEL_IS_STRING(level))
+        {
+            station_emit(st, SLOT_AMP_LEVEL + i, &ev, "!amp %s %s", amp_strlevel(level),
+                         val.s ? val.s : "");
+        }
+        else if (AMP_LEVEL_IS_FLOAT(level))
+        {
+            station_emit(st, SLOT_AMP_LEVEL + i, &ev, "!amp %s %.2f", amp_strlevel(level),
+                         val.f);
+        }
+        else
+        {
+            station_emit(st, SLOT_AMP_LEVEL + i, &ev, "!amp %s %d", amp_strlevel(level),
+                         val.i);
+        }
+    }
+}
+
+
+static void station_client_close(struct station_client *c)
+{
+    close(c->fd);
+    c->fd = -1;
+    c->len = 0;
+}
+
+
+/* queue text for a client, or note it has to catch up later */
+static void station_client_queue(struct station_client *c, const char *text,
+                                 size_t len)
+{
+    if (c->resync || c->len + len > sizeof(c->out))
+    {
+        c->resync = 1;
+        return;
+    }
+
+    memcpy(c->out + c->len, text, len);
+    c->len += len;
+}
+
+
+static void station_client_snapshot(STATION *st, struct station_client *c)
+{
+    int i;
+
+    c->resync = 0;
+
+    for (i = 0; i < NSLOTS; i++)
+    {
+        if (st->last[i][0])
+        {
+            char line[STATION_LINE_LEN + 1];
+            int n = snprintf(line, sizeof(line), "%s\n", st->last[i]);
+
+            station_client_queue(c, line, n);
+        }
+    }
+}
+
+
+static void station_client_flush(struct station_client *c)
+{
+    ssize_t n;
+
+    if (c->len == 0)
+    {
+        return;
+    }
+
+    n = send(c->fd, c->out, c->len, MSG_DONTWAIT | MSG_NOSIGNAL);
+
+    if (n < 0)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            station_client_close(c);
+        }
+
+        return;
+    }
+
+    memmove(c->out, c->out + n, c->len - n);
+    c->len -= n;
+}
+
+
+static void station_accept(STATION *st)
+{
+    int fd = accept(st->listen_fd, NULL, NULL);
+    int i;
+
+    if (fd < 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < STATION_MAX_CLIENTS; i++)
+    {
+        struct station_client *c = &st->clients[i];
+
+        if (c->fd < 0)
+        {
+            c->fd = fd;
+            c->len = 0;
+            station_client_snapshot(st, c);
+            station_client_flush(c);
+            return;
+        }
+    }
+
+    rig_debug(RIG_DEBUG_WARN, "%s: too many subscribers\n", __func__);
+    close(fd);
+}
+
+
+/* send out what changed this round */
+static void station_publish(STATION *st)
+{
+    size_t start = 0;
+    int i;
+
+    for (i = 0; i < STATION_MAX_CLIENTS; i++)
+    {
+        struct station_client *c = &st->clients[i];
+
+        if (c->fd < 0)
+        {
+            continue;
+        }
+
+        if (c->resync && c->len == 0)
+        {
+            station_client_snapshot(st, c);
+        }
+        else if (st->batch_len)
+        {
+            station_client_queue(c, st->batch, st->batch_len);
+        }
+
+        station_client_flush(c);
+    }
+
+    /* whole lines per datagram */
+    while (st->mcast_fd >= 0 && start < st->batch_len)
+    {
+        size_t end = st->batch_len;
+
+        if (end - start > STATION_DATAGRAM)
+        {
+            end = start + STATION_DATAGRAM;
+
+            while (end > start && st->batch[end - 1] != '\n')
+            {
+                end--;
+            }
+        }
+
+        if (sendto(st->mcast_fd, st->batch + start, end - start, 0,
+                   (struct sockaddr *) &st->mcast_addr, sizeof(st->mcast_addr)) < 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: multicast: %s\n", __func__, strerror(errno));
+            break;
+        }
+
+        start = end;
+    }
+
+    st->batch_len = 0;
+}
+
+
+static void *station_thread(void *arg)
+{
+    STATION *st = (STATION *) arg;
+    struct pollfd fds[2 + STATION_MAX_CLIENTS];
+    struct timespec round;
+
+    elapsed_ms(&round, HAMLIB_ELAPSED_INVALIDATE);
+
+    while (!st->stop)
+    {
+        int nfds = 0, i, ret, wait_ms;
+        int woken = 0;
+
+        wait_ms = st->interval_ms - (int) elapsed_ms(&round, HAMLIB_ELAPSED_GET);
+
+        fds[nfds].fd = st->wake[0];
+        fds[nfds++].events = POLLIN;
+
+        if (st->listen_fd >= 0)
+        {
+            fds[nfds].fd = st->listen_fd;
+            fds[nfds++].events = POLLIN;
+        }
+
+        for (i = 0; i < STATION_MAX_CLIENTS; i++)
+        {
+            if (st->clients[i].fd >= 0)
+            {
+                fds[nfds].fd = st->clients[i].fd;
+                fds[nfds++].events = POLLIN | (st->clients[i].len ? POLLOUT : 0);
+            }
+        }
+
+        ret = poll(fds, nfds, wait_ms > 0 ? wait_ms : 0);
+
+        if (ret < 0 && errno != EINTR)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: poll: %s\n", __func__, strerror(errno));
+            break;
+        }
+
+        for (i = 0; ret > 0 && i < nfds; i++)
+        {
+            struct station_client *c = NULL;
+            int j;
+
+            if (!fds[i].revents)
+            {
+                continue;
+            }
+
+            if (fds[i].fd == st->wake[0])
+            {
+                char buf[64];
+
+                while (read(st->wake[0], buf, sizeof(buf)) > 0) {}
+
+                woken = 1;
+                continue;
+            }
+
+            if (fds[i].fd == st->listen_fd)
+            {
+                station_accept(st);
+                continue;
+            }
+
+            for (j = 0; j < STATION_MAX_CLIENTS && !c; j++)
+            {
+                if (st->clients[j].fd == fds[i].fd)
+                {
+                    c = &st->clients[j];
+                }
+            }
+
+            if (!c)
+            {
+                continue;
+            }
+
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+            {
+                char buf[256];
+                ssize_t n = recv(c->fd, buf, sizeof(buf), MSG_DONTWAIT);
+
+                /* subscribers have nothing to say, a read of 0 is a hangup */
+                if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+                {
+                    station_client_close(c);
+                    continue;
+                }
+            }
+
+            if (fds[i].revents & POLLOUT)
+            {
+                station_client_flush(c);
+
+                if (c->fd >= 0 && c->resync && c->len == 0)
+                {
+                    station_client_snapshot(st, c);
+                }
+            }
+        }
+
+        if (st->stop)
+        {
+            break;
+        }
+
+        if (woken || elapsed_ms(&round, HAMLIB_ELAPSED_GET) >= st->interval_ms)
+        {
+            elapsed_ms(&round, HAMLIB_ELAPSED_SET);
+            station_sample_rig(st);
+            station_sample_rot(st);
+            station_sample_amp(st);
+            station_publish(st);
+        }
+    }
+
+    return NULL;
+}
+
+
+/**
+ * \brief Create a station over a rig, a rotator and an amplifier.
+ *
+ * \param rig The #RIG handle, or NULL.
+ * \param rot The #ROT handle, or NULL.
+ * \param amp The #AMP handle, or NULL.
+ *
+ * The caller keeps owning the handles, opens them and closes them after
+ * station_stop().
+ *
+ * \return The #STATION handle, or NULL if out of memory.
+ *
+ * \sa station_start(), station_cleanup()
+ */
+STATION *HAMLIB_API station_init(RIG *rig, ROT *rot, AMP *amp)
+{
+    STATION *st = calloc(1, sizeof(*st));
+    int i;
+
+    if (!st)
+    {
+        return NULL;
+    }
+
+    st->rig = rig;
+    st->rot = rot;
+    st->amp = amp;
+    st->amp_band = -1;
+    st->listen_fd = -1;
+    st->mcast_fd = -1;
+    st->wake[0] = st->wake[1] = -1;
+
+    for (i = 0; i < STATION_MAX_CLIENTS; i++)
+    {
+        st->clients[i].fd = -1;
+    }
+
+    return st;
+}
+
+
+/**
+ * \brief Set the callback receiving every station event.
+ *
+ * \param st The #STATION handle.
+ * \param cb The callback, NULL for none.
+ * \param arg Passed to \a cb.
+ *
+ * \a cb is called from the station thread, before the event goes out to
+ * the subscribers.
+ *
+ * \return RIG_OK, or -RIG_EINVAL if \a st is NULL.
+ */
+int HAMLIB_API station_set_callback(STATION *st, station_cb_t cb, rig_ptr_t arg)
+{
+    if (!st)
+    {
+        return -RIG_EINVAL;
+    }
+
+    st->cb = cb;
+    st->cb_arg = arg;
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Choose the cross-device actions the station runs itself.
+ *
+ * \param st The #STATION handle.
+ * \param flags An OR of STATION_FOLLOW_* flags, 0 for none.
+ *
+ * With #STATION_FOLLOW_AMP_FREQ, the amplifier is given the rig frequency
+ * each time the rig moves to another amateur band.
+ *
+ * \return RIG_OK, or -RIG_EINVAL if \a st is NULL.
+ */
+int HAMLIB_API station_set_follow(STATION *st, int flags)
+{
+    if (!st)
+    {
+        return -RIG_EINVAL;
+    }
+
+    st->follow = flags;
+    st->amp_band = -1;
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Accept TCP subscribers.
+ *
+ * \param st The #STATION handle.
+ * \param addr IPv4 address to listen on, NULL for all.
+ * \param port TCP port.
+ *
+ * Must be called before station_start().
+ *
+ * \return RIG_OK, or a negative value on error.
+ */
+int HAMLIB_API station_listen(STATION *st, const char *addr, int port)
+{
+    struct sockaddr_in sa;
+    int fd, one = 1;
+
+    if (!st || st->running || st->listen_fd >= 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (network_init() != RIG_OK)
+    {
+        return -RIG_EIO;
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_port = htons(port);
+    sa.sin_addr.s_addr = addr ? inet_addr(addr) : htonl(INADDR_ANY);
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+
+    if (fd < 0)
+    {
+        return -RIG_EIO;
+    }
+
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    if (bind(fd, (struct sockaddr *) &sa, sizeof(sa)) < 0 || listen(fd, 4) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: port %d: %s\n", __func__, port, strerror(errno));
+        close(fd);
+        return -RIG_EIO;
+    }
+
+    st->listen_fd = fd;
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Send station events to a multicast group.
+ *
+ * \param st The #STATION handle.
+ * \param addr Multicast group, e.g. 224.0.0.1.
+ * \param port UDP port.
+ *
+ * The lines of each round go out together, as few datagrams as fit.
+ * Must be called before station_start().
+ *
+ * \return RIG_OK, or a negative value on error.
+ */
+int HAMLIB_API station_multicast(STATION *st, const char *addr, int port)
+{
+    int fd;
+
+    if (!st || !addr || st->running || st->mcast_fd >= 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (network_init() != RIG_OK)
+    {
+        return -RIG_EIO;
+    }
+
+    fd = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (fd < 0)
+    {
+        return -RIG_EIO;
+    }
+
+    memset(&st->mcast_addr, 0, sizeof(st->mcast_addr));
+    st->mcast_addr.sin_family = AF_INET;
+    st->mcast_addr.sin_addr.s_addr = inet_addr(addr);
+    st->mcast_addr.sin_port = htons(port);
+    st->mcast_fd = fd;
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Start watching the station.
+ *
+ * \param st The #STATION handle.
+ * \param interval_ms How often the devices are read, in ms.
+ *
+ * Rig changes reported through transceive are sent at once when the
+ * application has not set the rig's freq, mode and PTT callbacks.
+ *
+ * \return RIG_OK, or a negative value on error.
+ *
+ * \sa station_stop()
+ */
+int HAMLIB_API station_start(STATION *st, int interval_ms)
+{
+    if (!st || st->running || interval_ms <= 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (pipe(st->wake) < 0)
+    {
+        return -RIG_EIO;
+    }
+
+    fcntl(st->wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(st->wake[1], F_SETFL, O_NONBLOCK);
+
+    st->interval_ms = interval_ms;
+    st->stop = 0;
+    station_hook_rig(st);
+
+    if (pthread_create(&st->thread, NULL, station_thread, st))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create failed\n", __func__);
+        station_unhook_rig(st);
+        close(st->wake[0]);
+        close(st->wake[1]);
+        st->wake[0] = st->wake[1] = -1;
+        return -RIG_EINTERNAL;
+    }
+
+    st->running = 1;
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Stop watching the station.
+ *
+ * \param st The #STATION handle.
+ *
+ * The TCP subscribers are disconnected.
+ *
+ * \return RIG_OK, or -RIG_EINVAL if \a st is NULL.
+ */
+int HAMLIB_API station_stop(STATION *st)
+{
+    int i;
+
+    if (!st)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (!st->running)
+    {
+        return RIG_OK;
+    }
+
+    st->stop = 1;
+    station_wake(st);
+    pthread_join(st->thread, NULL);
+    st->running = 0;
+
+    station_unhook_rig(st);
+    close(st->wake[0]);
+    close(st->wake[1]);
+    st->wake[0] = st->wake[1] = -1;
+
+    for (i = 0; i < STATION_MAX_CLIENTS; i++)
+    {
+        if (st->clients[i].fd >= 0)
+        {
+            station_client_close(&st->clients[i]);
+        }
+    }
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Release a #STATION handle, stopping it first.
+ *
+ * \param st The #STATION handle.
+ *
+ * The rig, rotator and amplifier handles are left alone.
+ *
+ * \return RIG_OK, or -RIG_EINVAL if \a st is NULL.
+ */
+int HAMLIB_API station_cleanup(STATION *st)
+{
+    if (!st)
+    {
+        return -RIG_EINVAL;
+    }
+
+    station_stop(st);
+
+    if (st->listen_fd >= 0)
+    {
+        close(st->listen_fd);
+    }
+
+    if (st->mcast_fd >= 0)
+    {
+        close(st->mcast_fd);
+    }
+
+    free(st);
+
+    return RIG_OK;
+}
+
+#else /* no threads or sockets */
+
+STATION *HAMLIB_API station_init(RIG *rig, ROT *rot, AMP *amp)
+{
+    return NULL;
+}
+
+
+int HAMLIB_API station_set_callback(STATION *st, station_cb_t cb, rig_ptr_t arg)
+{
+    return -RIG_ENIMPL;
+}
+
+
+int HAMLIB_API station_set_follow(STATION *st, int flags)
+{
+    return -RIG_ENIMPL;
+}
+
+
+int HAMLIB_API station_listen(STATION *st, const char *addr, int port)
+{
+    return -RIG_ENIMPL;
+}
+
+
+int HAMLIB_API station_multicast(STATION *st, const char *addr, int port)
+{
+    return -RIG_ENIMPL;
+}
+
+
+int HAMLIB_API station_start(STATION *st, int interval_ms)
+{
+    return -RIG_ENIMPL;
+}
+
+
+int HAMLIB_API station_stop(STATION *st)
+{
+    return -RIG_ENIMPL;
+}
+
+
+int HAMLIB_API station_cleanup(STATION *st)
+{
+    return -RIG_ENIMPL;
+}
+
+#endif
+
+/** @} */
@@ -0,0 +1,320 @@
+/*
+ *  Hamlib Interface - CAT transaction statistics
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <hamlib/rig.h>
+#include "stats.h"
+#include "misc.h"
+#include "trace.h"
+
+/*
+ * Counters are bumped from the poll thread, the async handler and rigctld
+ * client threads without any lock, so use atomic adds where we have them.
+ */
+#if defined(__GNUC__)
+#define STATS_ADD(p, v)     __atomic_fetch_add((p), (v), __ATOMIC_RELAXED)
+#else
+#define STATS_ADD(p, v)     (*(p) += (v))
+#endif
+
+#define STATS_NBUCKETS \
+    ((int)(sizeof(((struct rig_stats *)0)->latency_hist) / sizeof(uint64_t)))
+
+static struct rig_stats *port_stats(hamlib_port_t *p)
+{
+    if (!p || !p->rig || p != &p->rig->state.rigport)
+    {
+        return NULL;
+    }
+
+    return &p->rig->state.stats;
+}
+
+void rig_stats_io(hamlib_port_t *p, int bytes_in, int bytes_out)
+{
+    struct rig_stats *st = port_stats(p);
+
+    if (bytes_in > 0) { TRACE_PORT_READ(p->fd, bytes_in); }
+
+    if (bytes_out > 0) { TRACE_PORT_WRITE(p->fd, bytes_out); }
+
+    if (!st) { return; }
+
+    if (bytes_in > 0) { STATS_ADD(&st->bytes_in, bytes_in); }
+
+    if (bytes_out > 0) { STATS_ADD(&st->bytes_out, bytes_out); }
+}
+
+void rig_stats_timeout(hamlib_port_t *p)
+{
+    struct rig_stats *st = port_stats(p);
+
+    TRACE_PORT_TIMEOUT(p ? p->fd : -1);
+
+    if (st) { STATS_ADD(&st->timeouts, 1); }
+}
+
+void rig_stats_begin(RIG *rig, struct timespec *start)
+{
+    TRACE_TRANSACTION_START(rig->caps->rig_model);
+
+    clock_gettime(CLOCK_MONOTONIC, start);
+}
+
+/*
+ * Record one backend transaction started at *start.  Latencies go into
+ * log2 buckets, bucket n counting transactions that took 2^n..2^(n+1)-1 us,
+ * which keeps the histogram small while covering 1us to several seconds.
+ */
+void rig_stats_end(RIG *rig, const struct timespec *start, int retval,
+                   int retries)
+{
+    struct rig_stats *st = &rig->state.stats;
+    struct timespec now;
+    uint64_t us, max;
+    int bucket = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    us = (uint64_t)(now.tv_sec - start->tv_sec) * 1000000
+         + (now.tv_nsec - start->tv_nsec) / 1000;
+
+    while (bucket < STATS_NBUCKETS - 1 && (us >> (bucket + 1)) != 0)
+    {
+        bucket++;
+    }
+
+    TRACE_TRANSACTION_END(rig->caps->rig_model, (long) us, retval, retries);
+
+    if (retries > 0) { TRACE_RETRY(rig->caps->rig_model, retries); }
+
+    STATS_ADD(&st->transactions, 1);
+    STATS_ADD(&st->latency_total_us, us);
+    STATS_ADD(&st->latency_hist[bucket], 1);
+
+    if (retval != RIG_OK) { STATS_ADD(&st->errors, 1); }
+
+    if (retries > 0) { STATS_ADD(&st->retries, retries); }
+
+    // a lost race here only loses a max that was microseconds apart
+    max = st->latency_max_us;
+
+    if (us > max) { st->latency_max_us = us; }
+}
+
+void rig_stats_cache(RIG *rig, hamlib_cache_t selection, int hit)
+{
+    struct rig_stats *st = &rig->state.stats;
+
+    if (selection < 0 || selection > HAMLIB_CACHE_FUNC) { return; }
+
+    if (hit)
+    {
+        TRACE_CACHE_HIT(selection);
+        STATS_ADD(&st->cache_hit[selection], 1);
+    }
+    else
+    {
+        TRACE_CACHE_MISS(selection);
+        STATS_ADD(&st->cache_miss[selection], 1);
+    }
+}
+
+void rig_stats_vfo_plan(RIG *rig, const char *op, vfo_t vfo,
+                        rig_vfo_plan_t plan)
+{
+    struct rig_stats *st = &rig->state.stats;
+
+    TRACE_VFO_PLAN(op, vfo, plan);
+
+    if (plan < RIG_VFO_PLAN_DIRECT || plan > RIG_VFO_PLAN_SWAP) { return; }
+
+    STATS_ADD(&st->vfo_plan[plan], 1);
+}
+
+void rig_stats_lock(RIG *rig, rig_prio_t prio, uint64_t wait_us)
+{
+    struct rig_stats *st = &rig->state.stats;
+    uint64_t max;
+
+    if (prio < RIG_PRIO_SAFETY || prio > RIG_PRIO_BACKGROUND) { return; }
+
+    STATS_ADD(&st->lock_calls[prio], 1);
+    STATS_ADD(&st->lock_wait_total_us[prio], wait_us);
+
+    max = st->lock_wait_max_us[prio];
+
+    if (wait_us > max) { st->lock_wait_max_us[prio] = wait_us; }
+}
+
+void rig_stats_preempt(RIG *rig)
+{
+    STATS_ADD(&rig->state.stats.lock_preemptions, 1);
+}
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \brief get a copy of the CAT transaction statistics
+ * \param rig   The rig handle
+ * \param stats Where to copy the counters
+ *
+ * \return RIG_OK or -RIG_EINVAL
+ *
+ * \sa rig_reset_stats(), rig_get_stats_info()
+ */
+int HAMLIB_API rig_get_stats(RIG *rig, struct rig_stats *stats)
+{
+    if (!rig || !stats)
+    {
+        return -RIG_EINVAL;
+    }
+
+    memcpy(stats, &rig->state.stats, sizeof(*stats));
+
+    return RIG_OK;
+}
+
+/**
+ * \brief clear the CAT transaction statistics
+ * \param rig   The rig handle
+ *
+ * \return RIG_OK or -RIG_EINVAL
+ */
+int HAMLIB_API rig_reset_stats(RIG *rig)
+{
+    if (!rig)
+    {
+        return -RIG_EINVAL;
+    }
+
+    memset(&rig->state.stats, 0, sizeof(rig->state.stats));
+
+    return RIG_OK;
+}
+
+/**
+ * \brief format the CAT transaction statistics as text
+ * \param rig   The rig handle
+ * \param response Buffer for the result, one "Name=value" pair per line
+ * \param max_response_len Size of \a response
+ *
+ * Only non-empty latency buckets are listed, as "Latency<N>us=count"
+ * where N is the upper bound of the bucket.
+ * API lock waits are listed for the rig_prio_t classes that took the
+ * lock, as "Lock<Class>Calls", "Lock<Class>WaitAvgUs" and
+ * "Lock<Class>WaitMaxUs".
+ *
+ * \return RIG_OK or -RIG_EINVAL
+ */
+int HAMLIB_API rig_get_stats_info(RIG *rig, char *response,
+                                  int max_response_len)
+{
+    static const char *cache_names[] =
+    {
+        "All", "Vfo", "Freq", "Mode", "Ptt", "Split", "Width", "Level", "Func"
+    };
+    static const char *prio_names[] =
+    {
+        "Safety", "Set", "Get", "Background"
+    };
+    struct rig_stats st;
+    size_t len;
+    int i;
+
+    if (!rig || !response || max_response_len < 1)
+    {
+        return -RIG_EINVAL;
+    }
+
+    rig_get_stats(rig, &st);
+
+    snprintf(response, max_response_len,
+             "Transactions=%" PRIu64 "\nErrors=%" PRIu64 "\nTimeouts=%" PRIu64
+             "\nRetries=%" PRIu64 "\nBytesOut=%" PRIu64 "\nBytesIn=%" PRIu64
+             "\nLatencyAvgUs=%" PRIu64 "\nLatencyMaxUs=%" PRIu64 "\n",
+             st.transactions, st.errors, st.timeouts, st.retries,
+             st.bytes_out, st.bytes_in,
+             st.transactions ? st.latency_total_us / st.transactions : 0,
+             st.latency_max_us);
+
+    for (i = 0; i < STATS_NBUCKETS; i++)
+    {
+        if (st.latency_hist[i] == 0) { continue; }
+
+        len = strlen(response);
+        snprintf(response + len, max_response_len - len,
+                 "Latency%" PRIu64 "us=%" PRIu64 "\n",
+                 ((uint64_t)2 << i) - 1, st.latency_hist[i]);
+    }
+
+    // width is checked together with mode, so it has no counters of its own
+    for (i = HAMLIB_CACHE_VFO; i <= HAMLIB_CACHE_FUNC; i++)
+    {
+        if (i == HAMLIB_CACHE_WIDTH) { continue; }
+
+        len = strlen(response);
+        snprintf(response + len, max_response_len - len,
+                 "Cache%sHit=%" PRIu64 "\nCache%sMiss=%" PRIu64 "\n",
+                 cache_names[i], st.cache_hit[i], cache_names[i], st.cache_miss[i]);
+    }
+
+    len = strlen(response);
+    snprintf(response + len, max_response_len - len,
+             "VfoPlanDirect=%" PRIu64 "\nVfoPlanTargeted=%" PRIu64
+             "\nVfoPlanSwap=%" PRIu64 "\n",
+             st.vfo_plan[RIG_VFO_PLAN_DIRECT], st.vfo_plan[RIG_VFO_PLAN_TARGETED],
+             st.vfo_plan[RIG_VFO_PLAN_SWAP]);
+
+    // only the classes that took the lock, a single threaded program has one
+    for (i = RIG_PRIO_SAFETY; i <= RIG_PRIO_BACKGROUND; i++)
+    {
+        if (st.lock_calls[i] == 0) { continue; }
+
+        len = strlen(response);
+        snprintf(response + len, max_response_len - len,
+                 "Lock%sCalls=%" PRIu64 "\nLock%sWaitAvgUs=%" PRIu64
+                 "\nLock%sWaitMaxUs=%" PRIu64 "\n",
+                 prio_names[i], st.lock_calls[i],
+                 prio_names[i], st.lock_wait_total_us[i] / st.lock_calls[i],
+                 prio_names[i], st.lock_wait_max_us[i]);
+    }
+
+    len = strlen(response);
+    snprintf(response + len, max_response_len - len,
+             "LockPreemptions=%" PRIu64 "\n", st.lock_preemptions);
+
+    // drop the trailing newline so callers can print it like rig_get_rig_info
+    len = strlen(response);
+
+    if (len > 0 && response[len - 1] == '\n') { response[len - 1] = '\0'; }
+
+    return RIG_OK;
+}
+
+/*! @} */
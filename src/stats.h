@@ -0,0 +1,47 @@
+/*
+ *  Hamlib Interface - CAT transaction statistics
+ *  Copyright (c) 2022 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _STATS_H
+#define _STATS_H 1
+
+#include <hamlib/rig.h>
+
+/*
+ * Counters behind rig_get_stats().  Only traffic on rig->state.rigport is
+ * counted, the PTT/DCD ports are ignored.
+ */
+void rig_stats_io(hamlib_port_t *p, int bytes_in, int bytes_out);
+void rig_stats_timeout(hamlib_port_t *p);
+
+void rig_stats_begin(RIG *rig, struct timespec *start);
+void rig_stats_end(RIG *rig, const struct timespec *start, int retval,
+                   int retries);
+
+void rig_stats_cache(RIG *rig, hamlib_cache_t selection, int hit);
+
+void rig_stats_vfo_plan(RIG *rig, const char *op, vfo_t vfo,
+                        rig_vfo_plan_t plan);
+
+/* Time a call waited for the API lock, and calls preempted, see rig_lock.c */
+void rig_stats_lock(RIG *rig, rig_prio_t prio, uint64_t wait_us);
+void rig_stats_preempt(RIG *rig);
+
+#endif /* _STATS_H */
@@ -0,0 +1,389 @@
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file src/sweep.c
+ * \brief Frequency sweeps reported as spectrum lines
+ */
+
+/*
+ *  Hamlib Interface - frequency sweep
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Receivers without a scope of their own can still draw a panorama by
+ * stepping through a range and reading the signal level at each step.
+ * rig_sweep_start() does that in a thread and hands every pass to
+ * rig_fire_spectrum_event() as one fixed-edge spectrum line, so the
+ * spectrum callback, history and multicast see it like scope data.
+ *
+ * A backend that can measure steps faster than a set_freq plus
+ * get_level pair sets caps->get_sweep; it is given the range a chunk at
+ * a time so that stopping does not wait for a whole pass.  Otherwise
+ * the sweep tunes and reads STRENGTH itself, the tuning command's own
+ * time counting towards the dwell.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "event.h"
+#include "rigqueue.h"
+#include "sweep.h"
+
+#define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+/* steps handed to caps->get_sweep at once */
+#define SWEEP_CHUNK 64
+
+struct sweep_run
+{
+    RIG *rig;
+    vfo_t vfo;
+    struct rig_sweep_cfg cfg;
+    size_t count;
+    int native;
+    volatile int stop;
+    unsigned char data[HAMLIB_MAX_SPECTRUM_DATA];
+};
+
+
+size_t rig_sweep_count(const struct rig_sweep_cfg *cfg)
+{
+    double steps;
+
+    if (!cfg || cfg->step <= 0 || cfg->stop < cfg->start)
+    {
+        return 0;
+    }
+
+    /* a stop a hair short of the last step through rounding still counts */
+    steps = floor((cfg->stop - cfg->start) / cfg->step + 1e-6);
+
+    if (steps >= HAMLIB_MAX_SPECTRUM_DATA)
+    {
+        return 0;
+    }
+
+    return (size_t)steps + 1;
+}
+
+
+unsigned char rig_sweep_level(int db)
+{
+    if (db <= RIG_SWEEP_DB_MIN)
+    {
+        return 0;
+    }
+
+    if (db >= RIG_SWEEP_DB_MAX)
+    {
+        return 255;
+    }
+
+    return (unsigned char)((db - RIG_SWEEP_DB_MIN) * 255
+                           / (RIG_SWEEP_DB_MAX - RIG_SWEEP_DB_MIN));
+}
+
+
+static int sweep_step(struct sweep_run *run, size_t idx)
+{
+    RIG *rig = run->rig;
+    struct timespec tuned;
+    value_t val;
+    double left;
+    int retval;
+
+    elapsed_ms(&tuned, HAMLIB_ELAPSED_SET);
+
+    retval = rig_set_freq(rig, run->vfo, run->cfg.start + idx * run->cfg.step);
+
+    /* a coalesced set_freq has not reached the rig yet */
+    if (retval == RIG_OK && rig_queue_coalescing(rig))
+    {
+        retval = rig_submit_wait(rig);
+    }
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    left = run->cfg.dwell_ms - elapsed_ms(&tuned, HAMLIB_ELAPSED_GET);
+
+    if (left > 0)
+    {
+        hl_usleep((rig_useconds_t)(left * 1000));
+    }
+
+    retval = rig_get_level(rig, run->vfo, RIG_LEVEL_STRENGTH, &val);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    run->data[idx] = rig_sweep_level(val.i);
+
+    return RIG_OK;
+}
+
+/* fill data[idx..idx+n), natively when the backend can */
+static int sweep_chunk(struct sweep_run *run, size_t idx, size_t n)
+{
+    RIG *rig = run->rig;
+    size_t i;
+    int retval;
+
+    if (run->native)
+    {
+        struct rig_sweep_cfg chunk = run->cfg;
+
+        chunk.start = run->cfg.start + idx * run->cfg.step;
+        chunk.stop = chunk.start + (n - 1) * run->cfg.step;
+
+        retval = rig->caps->get_sweep(rig, run->vfo, &chunk, &run->data[idx], n);
+
+        if (retval != -RIG_ENIMPL && retval != -RIG_ENAVAIL)
+        {
+            return retval;
+        }
+
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: no native sweep, stepping instead\n",
+                  __func__);
+        run->native = 0;
+    }
+
+    for (i = idx; i < idx + n && !run->stop; i++)
+    {
+        retval = sweep_step(run, i);
+
+        if (retval != RIG_OK)
+        {
+            return retval;
+        }
+    }
+
+    return RIG_OK;
+}
+
+static int sweep_loop(struct sweep_run *run)
+{
+    RIG *rig = run->rig;
+    struct rig_spectrum_line line;
+    freq_t saved;
+    int restore;
+    int pass;
+    int retval = RIG_OK;
+
+    restore = rig_get_freq(rig, run->vfo, &saved) == RIG_OK;
+
+    memset(&line, 0, sizeof(line));
+    line.id = run->cfg.id;
+    line.data_level_min = 0;
+    line.data_level_max = 255;
+    line.signal_strength_min = RIG_SWEEP_DB_MIN;
+    line.signal_strength_max = RIG_SWEEP_DB_MAX;
+    line.spectrum_mode = RIG_SPECTRUM_MODE_FIXED;
+    line.low_edge_freq = run->cfg.start;
+    line.high_edge_freq = run->cfg.start + (run->count - 1) * run->cfg.step;
+    line.center_freq = (line.low_edge_freq + line.high_edge_freq) / 2;
+    line.span_freq = line.high_edge_freq - line.low_edge_freq;
+    line.spectrum_data_length = run->count;
+    line.spectrum_data = run->data;
+
+    for (pass = 0; !run->stop
+            && (run->cfg.passes == 0 || pass < run->cfg.passes); pass++)
+    {
+        size_t idx;
+
+        for (idx = 0; !run->stop && idx < run->count; idx += SWEEP_CHUNK)
+        {
+            size_t n = run->count - idx;
+
+            retval = sweep_chunk(run, idx, n < SWEEP_CHUNK ? n : SWEEP_CHUNK);
+
+            if (retval != RIG_OK)
+            {
+                break;
+            }
+        }
+
+        /* a pass cut short by stop or an error is not worth drawing */
+        if (retval != RIG_OK || run->stop)
+        {
+            break;
+        }
+
+        rig_fire_spectrum_event(rig, &line);
+    }
+
+    if (restore)
+    {
+        rig_set_freq(rig, run->vfo, saved);
+    }
+
+    return retval;
+}
+
+
+#ifdef HAVE_PTHREAD
+
+struct rig_sweep
+{
+    struct sweep_run run;
+    pthread_t thread;
+    int retval;
+};
+
+static void *sweep_thread(void *arg)
+{
+    struct rig_sweep *sweep = arg;
+
+    sweep->retval = sweep_loop(&sweep->run);
+
+    return NULL;
+}
+
+#endif
+
+
+/**
+ * \brief sweep a frequency range in a thread, reporting spectrum lines
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param cfg   Range, step and dwell of the sweep
+ * \param sweep Set to the handle to give to rig_sweep_stop()
+ *
+ * Each completed pass goes to rig_fire_spectrum_event() as a
+ * RIG_SPECTRUM_MODE_FIXED line with one byte per step, 0 to 255 covering
+ * a STRENGTH of -60 to +60 dB relative to S9.  Backends with a faster way
+ * to measure the steps than rig_set_freq() and rig_get_level() use it.
+ * The frequency in use before the sweep is tuned again once it ends.
+ *
+ * The application must leave the rig alone until rig_sweep_stop(),
+ * except from inside the spectrum callback.
+ *
+ * \return RIG_OK if the sweep was started, otherwise a negative value
+ * if an error occurred (in which case, cause is set appropriately).
+ *
+ * \sa rig_set_spectrum_callback()
+ */
+int HAMLIB_API rig_sweep_start(RIG *rig, vfo_t vfo,
+                               const struct rig_sweep_cfg *cfg,
+                               rig_sweep_t **sweep)
+{
+#ifdef HAVE_PTHREAD
+    struct rig_sweep *s;
+    size_t count;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    if (CHECK_RIG_ARG(rig) || !cfg || !sweep || cfg->dwell_ms < 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    count = rig_sweep_count(cfg);
+
+    if (count == 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: range must hold 1 to %d steps\n",
+                  __func__, HAMLIB_MAX_SPECTRUM_DATA);
+        return -RIG_EINVAL;
+    }
+
+    if (!rig->caps->get_sweep && (!rig->caps->set_freq
+                                  || !rig_has_get_level(rig, RIG_LEVEL_STRENGTH)))
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    s = calloc(1, sizeof(*s));
+
+    if (!s)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    s->run.rig = rig;
+    s->run.vfo = vfo;
+    s->run.cfg = *cfg;
+    s->run.count = count;
+    s->run.native = rig->caps->get_sweep != NULL;
+
+    if (pthread_create(&s->thread, NULL, sweep_thread, s) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create error: %s\n", __func__,
+                  strerror(errno));
+        free(s);
+        return -RIG_EINTERNAL;
+    }
+
+    *sweep = s;
+
+    return RIG_OK;
+#else
+    return -RIG_ENIMPL;
+#endif
+}
+
+/**
+ * \brief stop a sweep started with rig_sweep_start()
+ * \param sweep The handle, freed here
+ *
+ * Waits for the step or backend chunk in progress; the unfinished pass
+ * is not reported.
+ *
+ * \return RIG_OK, or the error that ended the sweep early.
+ */
+int HAMLIB_API rig_sweep_stop(rig_sweep_t *sweep)
+{
+#ifdef HAVE_PTHREAD
+    int retval;
+
+    if (!sweep)
+    {
+        return -RIG_EINVAL;
+    }
+
+    sweep->run.stop = 1;
+    pthread_join(sweep->thread, NULL);
+    retval = sweep->retval;
+    free(sweep);
+
+    return retval;
+#else
+    return -RIG_ENIMPL;
+#endif
+}
+
+/** @} */
@@ -0,0 +1,37 @@
+/*
+ *  Hamlib Interface - frequency sweep
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _SWEEP_H
+#define _SWEEP_H 1
+
+#include <hamlib/rig.h>
+
+/* STRENGTH range, in dB relative to S9, that a sweep byte of 0..255 covers */
+#define RIG_SWEEP_DB_MIN (-60)
+#define RIG_SWEEP_DB_MAX 60
+
+/* Number of steps in cfg, 0 when it makes no sense */
+size_t rig_sweep_count(const struct rig_sweep_cfg *cfg);
+
+/* Sweep byte for a STRENGTH reading, for backends filling get_sweep data */
+unsigned char rig_sweep_level(int db);
+
+#endif /* _SWEEP_H */
@@ -0,0 +1,460 @@
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file src/swscan.c
+ * \brief Software scanning of a frequency or channel list
+ */
+
+/*
+ *  Hamlib Interface - software scan engine
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * For rigs whose own scan is missing or too limited, rig_sw_scan() steps
+ * through a list of frequencies or memory channels itself: tune, let the
+ * receiver settle, then look for a signal with rig_get_dcd(), or with the
+ * STRENGTH meter when the rig has no squelch status.  A busy entry is
+ * held while the signal lasts plus a hang time, and the application hears
+ * about each hit through a callback, once when it starts and once when
+ * it ends.
+ *
+ * The time the tuning command itself takes counts towards the settle
+ * time, so a slow CAT link costs no extra dwell, and nothing is read back
+ * that the scan does not need.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "misc.h"
+#include "rigqueue.h"
+
+#define CHECK_RIG_ARG(r) (!(r) || !(r)->caps || !(r)->state.comm_state)
+
+/* how often a busy entry is looked at again */
+#define SW_SCAN_POLL_MS 50
+
+enum sw_scan_detect
+{
+    SW_SCAN_DETECT_UNKNOWN,
+    SW_SCAN_DETECT_DCD,
+    SW_SCAN_DETECT_STRENGTH,
+};
+
+struct sw_scan_run
+{
+    RIG *rig;
+    vfo_t vfo;
+    struct rig_scan_cfg cfg;
+    rig_scan_hit_cb_t cb;
+    rig_ptr_t arg;
+    enum sw_scan_detect detect;
+    volatile int stop;
+};
+
+/* put the receiver on entry idx */
+static int sw_scan_tune(struct sw_scan_run *run, int idx)
+{
+    RIG *rig = run->rig;
+    int retval;
+
+    if (run->cfg.freqs)
+    {
+        retval = rig_set_freq(rig, run->vfo, run->cfg.freqs[idx]);
+
+        /* a coalesced set_freq has not reached the rig yet */
+        if (retval == RIG_OK && rig_queue_coalescing(rig))
+        {
+            retval = rig_submit_wait(rig);
+        }
+    }
+    else
+    {
+        retval = rig_set_mem(rig, run->vfo, run->cfg.channels[idx]);
+    }
+
+    return retval;
+}
+
+/* 1 when there is a signal, 0 when not, < 0 on error */
+static int sw_scan_busy(struct sw_scan_run *run, int *strength)
+{
+    RIG *rig = run->rig;
+    value_t val;
+    int retval;
+
+    *strength = 0;
+
+    if (run->detect != SW_SCAN_DETECT_STRENGTH)
+    {
+        dcd_t dcd;
+
+        retval = rig_get_dcd(rig, run->vfo, &dcd);
+
+        if (retval == RIG_OK)
+        {
+            run->detect = SW_SCAN_DETECT_DCD;
+            return dcd == RIG_DCD_ON;
+        }
+
+        if (run->detect == SW_SCAN_DETECT_DCD
+                || (retval != -RIG_ENIMPL && retval != -RIG_ENAVAIL
+                    && retval != -RIG_ENTARGET))
+        {
+            return retval;
+        }
+
+        if (!rig_has_get_level(rig, RIG_LEVEL_STRENGTH))
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: no DCD nor STRENGTH to detect signals\n",
+                      __func__);
+            return -RIG_ENAVAIL;
+        }
+
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: no DCD, using STRENGTH >= %d dB\n",
+                  __func__, run->cfg.threshold);
+        run->detect = SW_SCAN_DETECT_STRENGTH;
+    }
+
+    retval = rig_get_level(rig, run->vfo, RIG_LEVEL_STRENGTH, &val);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    *strength = val.i;
+
+    return val.i >= run->cfg.threshold;
+}
+
+static void sw_scan_sleep(struct timespec *since, int ms)
+{
+    double left = ms - elapsed_ms(since, HAMLIB_ELAPSED_GET);
+
+    if (left > 0)
+    {
+        hl_usleep((rig_useconds_t)(left * 1000));
+    }
+}
+
+static int sw_scan_loop(struct sw_scan_run *run)
+{
+    RIG *rig = run->rig;
+    const struct rig_scan_cfg *cfg = &run->cfg;
+    struct rig_scan_hit hit;
+    int pass, idx;
+    int retval;
+
+    if (!cfg->freqs && (rig->state.vfo_list & RIG_VFO_MEM))
+    {
+        retval = rig_set_vfo(rig, RIG_VFO_MEM);
+
+        if (retval != RIG_OK)
+        {
+            return retval;
+        }
+    }
+
+    for (pass = 0; !run->stop && (cfg->passes == 0 || pass < cfg->passes); pass++)
+    {
+        for (idx = 0; !run->stop && idx < cfg->count; idx++)
+        {
+            struct timespec tuned, started, last_busy;
+            int busy;
+
+            elapsed_ms(&tuned, HAMLIB_ELAPSED_SET);
+            retval = sw_scan_tune(run, idx);
+
+            if (retval != RIG_OK)
+            {
+                return retval;
+            }
+
+            sw_scan_sleep(&tuned, cfg->settle_ms);
+
+            memset(&hit, 0, sizeof(hit));
+            hit.index = idx;
+            hit.channel_num = cfg->freqs ? -1 : cfg->channels[idx];
+            hit.freq = cfg->freqs ? cfg->freqs[idx] : 0;
+
+            busy = sw_scan_busy(run, &hit.strength);
+
+            if (busy < 0)
+            {
+                return busy;
+            }
+
+            if (!busy)
+            {
+                continue;
+            }
+
+            hit.active = 1;
+
+            if (run->cb(rig, &hit, run->arg) != RIG_OK)
+            {
+                run->stop = 1;
+                break;
+            }
+
+            elapsed_ms(&started, HAMLIB_ELAPSED_SET);
+            last_busy = started;
+
+            /* hold on the signal, and hang_ms past its end for a reply */
+            while (!run->stop)
+            {
+                struct timespec poll;
+                int strength;
+
+                if (cfg->max_hold_ms > 0
+                        && elapsed_ms(&started, HAMLIB_ELAPSED_GET) >= cfg->max_hold_ms)
+                {
+                    break;
+                }
+
+                elapsed_ms(&poll, HAMLIB_ELAPSED_SET);
+                busy = sw_scan_busy(run, &strength);
+
+                if (busy < 0)
+                {
+                    return busy;
+                }
+
+                if (busy)
+                {
+                    elapsed_ms(&last_busy, HAMLIB_ELAPSED_SET);
+                    hit.strength = strength;
+                }
+                else if (elapsed_ms(&last_busy, HAMLIB_ELAPSED_GET) >= cfg->hang_ms)
+                {
+                    break;
+                }
+
+                sw_scan_sleep(&poll, SW_SCAN_POLL_MS);
+            }
+
+            hit.active = 0;
+            hit.duration_ms = (int)elapsed_ms(&started, HAMLIB_ELAPSED_GET);
+
+            if (run->cb(rig, &hit, run->arg) != RIG_OK)
+            {
+                run->stop = 1;
+            }
+        }
+    }
+
+    return RIG_OK;
+}
+
+static int sw_scan_check(RIG *rig, const struct rig_scan_cfg *cfg,
+                         rig_scan_hit_cb_t cb)
+{
+    if (CHECK_RIG_ARG(rig) || !cfg || !cb || cfg->count <= 0
+            || (!cfg->freqs && !cfg->channels))
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (cfg->freqs ? !rig->caps->set_freq : !rig->caps->set_mem)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief scan a list of frequencies or memory channels in software
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param cfg   What to scan and how long to stay on each entry
+ * \param cb    Called when a signal is found and when it goes away
+ * \param arg   Passed back to \a cb
+ *
+ * Blocks until cfg->passes passes are done, a rig call fails or \a cb
+ * returns something else than RIG_OK.  Entries are tuned with
+ * rig_set_freq() or, when cfg->freqs is NULL, rig_set_mem() after the
+ * rig is switched to its memory VFO.
+ *
+ * \return RIG_OK when the scan ended normally, otherwise a negative
+ * value if an error occurred (in which case, cause is set appropriately).
+ *
+ * \sa rig_sw_scan_start()
+ */
+int HAMLIB_API rig_sw_scan(RIG *rig, vfo_t vfo, const struct rig_scan_cfg *cfg,
+                           rig_scan_hit_cb_t cb, rig_ptr_t arg)
+{
+    struct sw_scan_run run;
+    int retval;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    retval = sw_scan_check(rig, cfg, cb);
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    memset(&run, 0, sizeof(run));
+    run.rig = rig;
+    run.vfo = vfo;
+    run.cfg = *cfg;
+    run.cb = cb;
+    run.arg = arg;
+
+    return sw_scan_loop(&run);
+}
+
+
+#ifdef HAVE_PTHREAD
+
+struct rig_sw_scan
+{
+    struct sw_scan_run run;
+    pthread_t thread;
+    int retval;
+};
+
+static void *sw_scan_thread(void *arg)
+{
+    struct rig_sw_scan *scan = arg;
+
+    scan->retval = sw_scan_loop(&scan->run);
+
+    return NULL;
+}
+
+#endif
+
+
+/**
+ * \brief run rig_sw_scan() in a thread of its own
+ * \param rig   The rig handle
+ * \param vfo   The target VFO
+ * \param cfg   As for rig_sw_scan(), the lists are copied
+ * \param cb    As for rig_sw_scan(), called from the scan thread
+ * \param arg   Passed back to \a cb
+ * \param scan  Set to the handle to give to rig_sw_scan_stop()
+ *
+ * The application must leave the rig alone until rig_sw_scan_stop(),
+ * except from inside \a cb.
+ *
+ * \return RIG_OK if the scan was started, otherwise a negative value
+ * if an error occurred (in which case, cause is set appropriately).
+ */
+int HAMLIB_API rig_sw_scan_start(RIG *rig, vfo_t vfo,
+                                 const struct rig_scan_cfg *cfg,
+                                 rig_scan_hit_cb_t cb, rig_ptr_t arg,
+                                 rig_sw_scan_t **scan)
+{
+#ifdef HAVE_PTHREAD
+    struct rig_sw_scan *s;
+    size_t len;
+    void *list;
+    int retval;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
+
+    retval = sw_scan_check(rig, cfg, cb);
+
+    if (retval != RIG_OK || !scan)
+    {
+        return retval != RIG_OK ? retval : -RIG_EINVAL;
+    }
+
+    len = cfg->count * (cfg->freqs ? sizeof(freq_t) : sizeof(int));
+    s = calloc(1, sizeof(*s) + len);
+
+    if (!s)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    list = s + 1;
+    memcpy(list, cfg->freqs ? (const void *)cfg->freqs : (const void *)cfg->channels,
+           len);
+
+    s->run.rig = rig;
+    s->run.vfo = vfo;
+    s->run.cfg = *cfg;
+    s->run.cfg.freqs = cfg->freqs ? list : NULL;
+    s->run.cfg.channels = cfg->freqs ? NULL : list;
+    s->run.cb = cb;
+    s->run.arg = arg;
+
+    if (pthread_create(&s->thread, NULL, sw_scan_thread, s) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create error: %s\n", __func__,
+                  strerror(errno));
+        free(s);
+        return -RIG_EINTERNAL;
+    }
+
+    *scan = s;
+
+    return RIG_OK;
+#else
+    return -RIG_ENIMPL;
+#endif
+}
+
+/**
+ * \brief stop a scan started with rig_sw_scan_start()
+ * \param scan  The handle, freed here
+ *
+ * Waits for the scan thread to finish the rig call in progress.
+ *
+ * \return what rig_sw_scan() would have returned.
+ */
+int HAMLIB_API rig_sw_scan_stop(rig_sw_scan_t *scan)
+{
+#ifdef HAVE_PTHREAD
+    int retval;
+
+    if (!scan)
+    {
+        return -RIG_EINVAL;
+    }
+
+    scan->run.stop = 1;
+    pthread_join(scan->thread, NULL);
+    retval = scan->retval;
+    free(scan);
+
+    return retval;
+#else
+    return -RIG_ENIMPL;
+#endif
+}
+
+/** @} */
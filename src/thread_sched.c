@@ -0,0 +1,239 @@
+/*
+ *  Hamlib Interface - CPU affinity and scheduling of library threads
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * The poll routine, the async data handler, the multicast publisher and
+ * the executor workers call hl_thread_sched_apply() first thing, so
+ * whatever rig_set_thread_affinity() and rig_set_thread_sched() asked for
+ * applies to every such thread started afterwards.  The settings are per
+ * process, like the scheduler itself; threads already running keep what
+ * they have.  Pinning to the CPUs of one NUMA node also keeps the
+ * threads' memory on that node, which is as far as NUMA support goes.
+ */
+
+#include <hamlib/config.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "thread_sched.h"
+
+#if defined(HAVE_PTHREAD) && defined(__linux__) && defined(CPU_SET)
+#define THREAD_AFFINITY 1
+#endif
+
+#if defined(HAVE_PTHREAD) && defined(SCHED_FIFO) && defined(SCHED_RR)
+#define THREAD_SCHED 1
+#endif
+
+//! @cond Doxygen_Suppress
+
+#ifdef THREAD_AFFINITY
+static cpu_set_t sched_cpus;
+static int sched_cpus_set;
+#endif
+
+#ifdef THREAD_SCHED
+static int sched_policy = SCHED_OTHER;
+static int sched_priority;
+#endif
+
+#ifdef THREAD_AFFINITY
+/* "2", "2,3" or "0-3,8-11" */
+static int parse_cpu_list(const char *s, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+
+    while (*s)
+    {
+        char *end;
+        long first = strtol(s, &end, 10);
+        long last = first;
+
+        if (end == s || first < 0) { return -RIG_EINVAL; }
+
+        s = end;
+
+        if (*s == '-')
+        {
+            last = strtol(s + 1, &end, 10);
+
+            if (end == s + 1 || last < first) { return -RIG_EINVAL; }
+
+            s = end;
+        }
+
+        if (last >= CPU_SETSIZE) { return -RIG_EINVAL; }
+
+        for (; first <= last; first++)
+        {
+            CPU_SET(first, set);
+        }
+
+        if (*s == ',') { s++; }
+        else if (*s) { return -RIG_EINVAL; }
+    }
+
+    return CPU_COUNT(set) > 0 ? RIG_OK : -RIG_EINVAL;
+}
+#endif
+
+void hl_thread_sched_apply(const char *who)
+{
+#ifdef THREAD_AFFINITY
+
+    if (sched_cpus_set)
+    {
+        int err = pthread_setaffinity_np(pthread_self(), sizeof(sched_cpus),
+                                         &sched_cpus);
+
+        if (err)
+        {
+            rig_debug(RIG_DEBUG_WARN, "%s: %s keeps its CPUs: %s\n", __func__, who,
+                      strerror(err));
+        }
+    }
+
+#endif
+#ifdef THREAD_SCHED
+
+    if (sched_policy != SCHED_OTHER)
+    {
+        struct sched_param param;
+        int err;
+
+        memset(&param, 0, sizeof(param));
+        param.sched_priority = sched_priority;
+
+        err = pthread_setschedparam(pthread_self(), sched_policy, &param);
+
+        if (err)
+        {
+            /* EPERM without CAP_SYS_NICE or an rtprio limit */
+            rig_debug(RIG_DEBUG_WARN, "%s: no realtime priority for %s: %s\n", __func__,
+                      who, strerror(err));
+        }
+        else
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: %s at %s %d\n", __func__, who,
+                      sched_policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR", sched_priority);
+        }
+    }
+
+#endif
+    (void) who;
+}
+
+//! @endcond
+
+/**
+ * \brief Pin the threads Hamlib starts to a set of CPUs
+ *
+ * \param cpus CPU numbers such as "2,3" or "0-3", NULL or "" for no pinning
+ *
+ * Applies to the poll routine, async data handler, multicast publisher
+ * and executor worker threads started after the call, for every rig of
+ * the process, so call it before rig_open().
+ *
+ * \return RIG_OK, -RIG_EINVAL for a bad list, or -RIG_ENIMPL where
+ * threads cannot be pinned.
+ */
+int HAMLIB_API rig_set_thread_affinity(const char *cpus)
+{
+#ifdef THREAD_AFFINITY
+    cpu_set_t set;
+    int retval;
+
+    if (!cpus || !*cpus)
+    {
+        sched_cpus_set = 0;
+        return RIG_OK;
+    }
+
+    retval = parse_cpu_list(cpus, &set);
+
+    if (retval != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: bad CPU list '%s'\n", __func__, cpus);
+        return retval;
+    }
+
+    sched_cpus = set;
+    sched_cpus_set = 1;
+
+    return RIG_OK;
+#else
+    return (cpus && *cpus) ? -RIG_ENIMPL : RIG_OK;
+#endif
+}
+
+/**
+ * \brief Run the threads Hamlib starts under a realtime scheduling policy
+ *
+ * \param policy "fifo", "rr", or "other" (or NULL) for the default
+ * \param priority realtime priority, clamped to what the policy allows
+ *
+ * Applies to the same threads as rig_set_thread_affinity().  Without
+ * CAP_SYS_NICE or an RLIMIT_RTPRIO the threads still start, at normal
+ * priority, and the failure is logged.
+ *
+ * \return RIG_OK, -RIG_EINVAL for an unknown policy, or -RIG_ENIMPL
+ * without realtime scheduling.
+ */
+int HAMLIB_API rig_set_thread_sched(const char *policy, int priority)
+{
+#ifdef THREAD_SCHED
+    int p;
+
+    if (!policy || !strcmp(policy, "other"))
+    {
+        sched_policy = SCHED_OTHER;
+        return RIG_OK;
+    }
+
+    if (!strcmp(policy, "fifo")) { p = SCHED_FIFO; }
+    else if (!strcmp(policy, "rr")) { p = SCHED_RR; }
+    else
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: unknown policy '%s'\n", __func__, policy);
+        return -RIG_EINVAL;
+    }
+
+    if (priority < sched_get_priority_min(p)) { priority = sched_get_priority_min(p); }
+
+    if (priority > sched_get_priority_max(p)) { priority = sched_get_priority_max(p); }
+
+    sched_priority = priority;
+    sched_policy = p;
+
+    return RIG_OK;
+#else
+    (void) priority;
+    return (!policy || !strcmp(policy, "other")) ? RIG_OK : -RIG_ENIMPL;
+#endif
+}
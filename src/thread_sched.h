@@ -0,0 +1,32 @@
+/*
+ *  Hamlib Interface - CPU affinity and scheduling of library threads
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _THREAD_SCHED_H
+#define _THREAD_SCHED_H 1
+
+/*
+ * Called by a library thread on itself as it starts: the CPUs and policy
+ * set with rig_set_thread_affinity() and rig_set_thread_sched().  who
+ * only names the thread in the debug output.
+ */
+void hl_thread_sched_apply(const char *who);
+
+#endif /* _THREAD_SCHED_H */
@@ -123,6 +123,72 @@
 #define TOK_TWIDDLE_TIMEOUT  TOKEN_FRONTEND(128)
 /** \brief rig: Supporess get_freq on VFOB for satellite RIT tuning */
 #define TOK_TWIDDLE_RIT  TOKEN_FRONTEND(129)
+/** \brief rig: Ceiling in milliseconds for adaptive cache timeouts */
+#define TOK_CACHE_ADAPTIVE  TOKEN_FRONTEND(130)
+/** \brief rig: Coalescing window in milliseconds for set_freq/set_mode */
+#define TOK_COALESCE  TOKEN_FRONTEND(131)
+/** \brief rig: Format of multicast spectrum lines */
+#define TOK_MULTICAST_SPECTRUM  TOKEN_FRONTEND(132)
+/** \brief rig: Number of spectrum lines combined into one */
+#define TOK_SPECTRUM_LINES  TOKEN_FRONTEND(133)
+/** \brief rig: How spectrum lines and bins are combined */
+#define TOK_SPECTRUM_REDUCE  TOKEN_FRONTEND(134)
+/** \brief rig: Maximum number of bins per spectrum line */
+#define TOK_SPECTRUM_WIDTH  TOKEN_FRONTEND(135)
+/** \brief rig: Rescale spectrum data to dB */
+#define TOK_SPECTRUM_DB  TOKEN_FRONTEND(136)
+/** \brief rig: Number of recent spectrum lines kept per scope */
+#define TOK_SPECTRUM_HISTORY  TOKEN_FRONTEND(137)
+/** \brief rig: How long cache entries pushed by the rig stay fresh */
+#define TOK_PUSH_TIMEOUT  TOKEN_FRONTEND(138)
+/** \brief rig: Window in ms for folding state updates into one multicast packet */
+#define TOK_MULTICAST_BATCH  TOKEN_FRONTEND(139)
+/** \brief rig: Multicast state packets between full snapshots */
+#define TOK_MULTICAST_KEYFRAME  TOKEN_FRONTEND(140)
+/** \brief rig: How long rig_get_level answers from the level cache */
+#define TOK_CACHE_LEVEL_TIMEOUT  TOKEN_FRONTEND(141)
+/** \brief rig: How long rig_get_func answers from the func cache */
+#define TOK_CACHE_FUNC_TIMEOUT  TOKEN_FRONTEND(142)
+/** \brief rig: Send write_delay paced output from a writer thread */
+#define TOK_PACED_WRITER  TOKEN_FRONTEND(143)
+/** \brief rig: Keep what rig_open discovers on disk and replay it next time */
+#define TOK_OPEN_CACHE  TOKEN_FRONTEND(144)
+/** \brief rig: Return from rig_open without priming the freq/mode cache */
+#define TOK_OPEN_FAST  TOKEN_FRONTEND(145)
+/** \brief rig: Line rig_send_morse keys CW on */
+#define TOK_CW_KEY  TOKEN_FRONTEND(146)
+/** \brief rig: Speed of the CW keyed by Hamlib */
+#define TOK_CW_WPM  TOKEN_FRONTEND(147)
+/** \brief rig: PTT lead time before keyed CW */
+#define TOK_CW_PTT_LEAD  TOKEN_FRONTEND(148)
+/** \brief rig: PTT hang time after keyed CW */
+#define TOK_CW_PTT_TAIL  TOKEN_FRONTEND(149)
+/** \brief rig: rig_set_ptt takes the rig_set_ptt_fast path */
+#define TOK_PTT_FAST  TOKEN_FRONTEND(150)
+/** \brief rig: low latency serial driver and USB latency timer */
+#define TOK_SERIAL_LOW_LATENCY  TOKEN_FRONTEND(151)
+/** \brief rig: file recording the rig port traffic */
+#define TOK_CAPTURE_FILE  TOKEN_FRONTEND(152)
+/** \brief rig: capture file played back in place of the rig */
+#define TOK_REPLAY_FILE  TOKEN_FRONTEND(153)
+/** \brief rig: Levels read by the poll routine */
+#define TOK_POLL_LEVELS  TOKEN_FRONTEND(154)
+/** \brief rig: Shared memory segment the cache is published in */
+#define TOK_SHM_CACHE  TOKEN_FRONTEND(155)
+/** \brief rig: rig_send_morse queues the message and a thread feeds the rig */
+#define TOK_MORSE_QUEUE  TOKEN_FRONTEND(156)
+/** \brief rig: File the cache changes are journalled in */
+#define TOK_JOURNAL_FILE  TOKEN_FRONTEND(157)
+/** \brief rig: Records the journal file holds */
+#define TOK_JOURNAL_SIZE  TOKEN_FRONTEND(158)
+/** \brief rig: Rig port timeout follows the measured round trip times */
+#define TOK_TIMEOUT_ADAPTIVE  TOKEN_FRONTEND(159)
+/** \brief rig: Shortest adaptive timeout */
+#define TOK_TIMEOUT_FLOOR  TOKEN_FRONTEND(160)
+/** \brief rig: Memory channels are cached */
+#define TOK_CHAN_CACHE  TOKEN_FRONTEND(161)
+/** \brief rig: Async data of all rigs read by one thread */
+#define TOK_ASYNC_SHARED  TOKEN_FRONTEND(162)
 /*
  * rotator specific tokens
  * (strictly, should be documented as rotator_internal)
@@ -137,6 +203,21 @@
 #define TOK_MAX_EL  TOKEN_FRONTEND(113)
 /** \brief rot: South is zero degrees */
 #define TOK_SOUTH_ZERO  TOKEN_FRONTEND(114)
+/** \brief rot: Position and status cache timeout in milliseconds */
+#define TOK_ROT_CACHE_TIMEOUT  TOKEN_FRONTEND(115)
+/** \brief rot: Degrees a target must move before it is sent */
+#define TOK_ROT_DEADBAND  TOKEN_FRONTEND(116)
+/** \brief rot: Degrees targets are rounded to */
+#define TOK_ROT_MIN_STEP  TOKEN_FRONTEND(117)
+/** \brief rot: Minimum milliseconds between two positions sent */
+#define TOK_ROT_MIN_INTERVAL  TOKEN_FRONTEND(118)
+/*
+ * amplifier specific tokens
+ */
+/** \brief amp: Level, frequency and power status cache timeout in milliseconds */
+#define TOK_AMP_CACHE_TIMEOUT  TOKEN_FRONTEND(120)
+/** \brief amp: Milliseconds between two queries of the background poller */
+#define TOK_AMP_POLL_INTERVAL  TOKEN_FRONTEND(121)
 
 
 #endif /* _TOKEN_H */
@@ -0,0 +1,48 @@
+/*
+ *  Hamlib Interface - static tracepoints
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * USDT probes need no code of their own, only the ETW provider has to be
+ * defined and registered, see trace.h.
+ */
+
+#include <hamlib/config.h>
+
+#include "trace.h"
+
+#ifdef HAVE_ETW
+
+/* {3717d6d4-fd6c-4e7f-aac4-5c56957cb17f} */
+TRACELOGGING_DEFINE_PROVIDER(hamlib_trace_provider, "Hamlib",
+                             (0x3717d6d4, 0xfd6c, 0x4e7f, 0xaa, 0xc4, 0x5c,
+                              0x56, 0x95, 0x7c, 0xb1, 0x7f));
+
+static LONG registered;
+
+void hamlib_trace_init(void)
+{
+    if (InterlockedCompareExchange(&registered, 1, 0) == 0)
+    {
+        TraceLoggingRegister(hamlib_trace_provider);
+    }
+}
+
+#endif
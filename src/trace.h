@@ -0,0 +1,150 @@
+/*
+ *  Hamlib Interface - static tracepoints
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H 1
+
+/*
+ * Static tracepoints for --enable-tracepoints builds: USDT probes of the
+ * "hamlib" provider where <sys/sdt.h> is available, TraceLogging events
+ * of the "Hamlib" ETW provider on Windows, and nothing otherwise.  A USDT
+ * probe is a single nop until a tracer attaches, an ETW event a test of
+ * the provider's enable flag, so they may stay in production builds.
+ *
+ *   func__entry(const char *func, int depth)         ENTERFUNC
+ *   func__return(const char *func, int depth, int rc) RETURNFUNC
+ *   transaction__start(int model)                    backend command sent
+ *   transaction__end(int model, long us, int rc, int retries)
+ *   retry(int model, int retries)                    transaction retried
+ *   cache__hit(int cache), cache__miss(int cache)    hamlib_cache_t
+ *   port__read(int fd, int bytes), port__write(int fd, int bytes)
+ *   port__timeout(int fd)
+ *   async__frame(int len), async__frame__done(int len, int rc)
+ *   vfo__plan(const char *op, int vfo, int plan)     rig_vfo_plan_t
+ *
+ * For example the time spent per backend function:
+ *
+ *   bpftrace -e 'usdt:/usr/lib/libhamlib.so.4:hamlib:func__entry
+ *       { @start[tid, arg1] = nsecs; }
+ *     usdt:/usr/lib/libhamlib.so.4:hamlib:func__return /@start[tid, arg1]/
+ *       { @us[str(arg0)] = hist((nsecs - @start[tid, arg1]) / 1000);
+ *         delete(@start[tid, arg1]); }'
+ */
+
+#if defined(HAVE_USDT)
+
+#include <sys/sdt.h>
+
+#define TRACE_FUNC_ENTRY(func, depth) \
+    DTRACE_PROBE2(hamlib, func__entry, func, depth)
+#define TRACE_FUNC_RETURN(func, depth, rc) \
+    DTRACE_PROBE3(hamlib, func__return, func, depth, rc)
+#define TRACE_TRANSACTION_START(model) \
+    DTRACE_PROBE1(hamlib, transaction__start, model)
+#define TRACE_TRANSACTION_END(model, us, rc, retries) \
+    DTRACE_PROBE4(hamlib, transaction__end, model, us, rc, retries)
+#define TRACE_RETRY(model, retries) \
+    DTRACE_PROBE2(hamlib, retry, model, retries)
+#define TRACE_CACHE_HIT(cache) \
+    DTRACE_PROBE1(hamlib, cache__hit, cache)
+#define TRACE_CACHE_MISS(cache) \
+    DTRACE_PROBE1(hamlib, cache__miss, cache)
+#define TRACE_PORT_READ(fd, bytes) \
+    DTRACE_PROBE2(hamlib, port__read, fd, bytes)
+#define TRACE_PORT_WRITE(fd, bytes) \
+    DTRACE_PROBE2(hamlib, port__write, fd, bytes)
+#define TRACE_PORT_TIMEOUT(fd) \
+    DTRACE_PROBE1(hamlib, port__timeout, fd)
+#define TRACE_ASYNC_FRAME(len) \
+    DTRACE_PROBE1(hamlib, async__frame, len)
+#define TRACE_ASYNC_FRAME_DONE(len, rc) \
+    DTRACE_PROBE2(hamlib, async__frame__done, len, rc)
+#define TRACE_VFO_PLAN(op, vfo, plan) \
+    DTRACE_PROBE3(hamlib, vfo__plan, op, vfo, plan)
+
+#elif defined(HAVE_ETW)
+
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+
+TRACELOGGING_DECLARE_PROVIDER(hamlib_trace_provider);
+
+/* registers the provider, called from rig_init() */
+void hamlib_trace_init(void);
+
+#define TRACE_EVENT(name, ...) \
+    TraceLoggingWrite(hamlib_trace_provider, name, __VA_ARGS__)
+
+#define TRACE_FUNC_ENTRY(func, depth) \
+    TRACE_EVENT("func_entry", TraceLoggingString(func, "func"), \
+                TraceLoggingInt32(depth, "depth"))
+#define TRACE_FUNC_RETURN(func, depth, rc) \
+    TRACE_EVENT("func_return", TraceLoggingString(func, "func"), \
+                TraceLoggingInt32(depth, "depth"), TraceLoggingInt32(rc, "rc"))
+#define TRACE_TRANSACTION_START(model) \
+    TRACE_EVENT("transaction_start", TraceLoggingInt32(model, "model"))
+#define TRACE_TRANSACTION_END(model, us, rc, retries) \
+    TRACE_EVENT("transaction_end", TraceLoggingInt32(model, "model"), \
+                TraceLoggingInt64(us, "us"), TraceLoggingInt32(rc, "rc"), \
+                TraceLoggingInt32(retries, "retries"))
+#define TRACE_RETRY(model, retries) \
+    TRACE_EVENT("retry", TraceLoggingInt32(model, "model"), \
+                TraceLoggingInt32(retries, "retries"))
+#define TRACE_CACHE_HIT(cache) \
+    TRACE_EVENT("cache_hit", TraceLoggingInt32(cache, "cache"))
+#define TRACE_CACHE_MISS(cache) \
+    TRACE_EVENT("cache_miss", TraceLoggingInt32(cache, "cache"))
+#define TRACE_PORT_READ(fd, bytes) \
+    TRACE_EVENT("port_read", TraceLoggingInt32(fd, "fd"), \
+                TraceLoggingInt32(bytes, "bytes"))
+#define TRACE_PORT_WRITE(fd, bytes) \
+    TRACE_EVENT("port_write", TraceLoggingInt32(fd, "fd"), \
+                TraceLoggingInt32(bytes, "bytes"))
+#define TRACE_PORT_TIMEOUT(fd) \
+    TRACE_EVENT("port_timeout", TraceLoggingInt32(fd, "fd"))
+#define TRACE_ASYNC_FRAME(len) \
+    TRACE_EVENT("async_frame", TraceLoggingInt32(len, "len"))
+#define TRACE_ASYNC_FRAME_DONE(len, rc) \
+    TRACE_EVENT("async_frame_done", TraceLoggingInt32(len, "len"), \
+                TraceLoggingInt32(rc, "rc"))
+#define TRACE_VFO_PLAN(op, vfo, plan) \
+    TRACE_EVENT("vfo_plan", TraceLoggingString(op, "op"), \
+                TraceLoggingUInt32(vfo, "vfo"), TraceLoggingInt32(plan, "plan"))
+
+#else
+
+#define TRACE_FUNC_ENTRY(func, depth)
+#define TRACE_FUNC_RETURN(func, depth, rc)
+#define TRACE_TRANSACTION_START(model)
+#define TRACE_TRANSACTION_END(model, us, rc, retries)
+#define TRACE_RETRY(model, retries)
+#define TRACE_CACHE_HIT(cache)
+#define TRACE_CACHE_MISS(cache)
+#define TRACE_PORT_READ(fd, bytes)
+#define TRACE_PORT_WRITE(fd, bytes)
+#define TRACE_PORT_TIMEOUT(fd)
+#define TRACE_ASYNC_FRAME(len)
+#define TRACE_ASYNC_FRAME_DONE(len, rc)
+#define TRACE_VFO_PLAN(op, vfo, plan)
+
+#endif
+
+#endif /* _TRACE_H */
@@ -0,0 +1,331 @@
+/*
+ *  Hamlib Interface - USB serial device identification
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/**
+ * \addtogroup rig
+ * @{
+ */
+
+/**
+ * \file src/usb_ident.c
+ * \brief Rig identification from USB descriptors
+ *
+ * Many radios carry their USB to serial bridge inside and name themselves
+ * in its descriptors: an IC-7300 shows up as a CP2102 whose serial number
+ * reads "IC-7300 03001234", an IC-705 with "IC-705" as its product.  Such
+ * a port is recognised from sysfs alone, without sending the rig a byte,
+ * and rig_probe() and rig_probe_all_ports() take it from there.  Anything
+ * not in the table is left to the serial probe.
+ *
+ * Only Linux is covered; the descriptors are read from /sys/class/tty.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include <hamlib/rig.h>
+#include "misc.h"
+
+#if defined(__linux__)
+#include <dirent.h>
+
+#ifndef PATH_MAX
+#  define PATH_MAX 1024
+#endif
+
+struct usb_rig_id
+{
+    unsigned short vid;     /* 0 for any */
+    unsigned short pid;     /* 0 for any */
+    const char *name;       /* prefix of the product or serial number string */
+    rig_model_t model;
+    int serial_rate;        /* 0 for the backend's default */
+    const char *data_port;  /* serial number suffix of a port that is not CI-V */
+};
+
+/*
+ * Icom puts the model in the serial number of its CP210x bridges, with
+ * " A" and " B" at the end on the dual port ones, B being the data/GPS
+ * port; the IC-705 has its own USB device with the model as product.
+ */
+static const struct usb_rig_id usb_rig_ids[] =
+{
+    { 0, 0, "IC-7300", RIG_MODEL_IC7300, 0, NULL },
+    { 0, 0, "IC-7610", RIG_MODEL_IC7610, 0, " B" },
+    { 0, 0, "IC-9700", RIG_MODEL_IC9700, 0, " B" },
+    { 0, 0, "IC-7100", RIG_MODEL_IC7100, 0, NULL },
+    { 0, 0, "IC-705", RIG_MODEL_IC705, 0, NULL },
+    { 0, 0, "IC-R8600", RIG_MODEL_ICR8600, 0, NULL },
+};
+
+#define USB_RIG_IDS (int)(sizeof(usb_rig_ids) / sizeof(usb_rig_ids[0]))
+
+static int usb_prefix(const char *s, const char *prefix)
+{
+    return strncmp(s, prefix, strlen(prefix)) == 0;
+}
+
+static int usb_suffix(const char *s, const char *suffix)
+{
+    size_t n = strlen(s), m = strlen(suffix);
+
+    return n >= m && strcmp(s + n - m, suffix) == 0;
+}
+
+/* fills in model, serial_rate and cat from the table */
+static void usb_match(struct rig_usb_device *dev)
+{
+    int i;
+
+    dev->model = RIG_MODEL_NONE;
+    dev->serial_rate = 0;
+    dev->cat = 1;
+
+    for (i = 0; i < USB_RIG_IDS; i++)
+    {
+        const struct usb_rig_id *id = &usb_rig_ids[i];
+
+        if ((id->vid && id->vid != dev->vid) || (id->pid && id->pid != dev->pid))
+        {
+            continue;
+        }
+
+        if (!usb_prefix(dev->product, id->name) && !usb_prefix(dev->serial, id->name))
+        {
+            continue;
+        }
+
+        dev->model = id->model;
+        dev->serial_rate = id->serial_rate;
+
+        if (id->data_port && usb_suffix(dev->serial, id->data_port))
+        {
+            dev->cat = 0;
+        }
+
+        return;
+    }
+}
+
+/* the first line of a sysfs attribute, -1 if there is none */
+static int usb_attr(const char *dir, const char *name, char *buf, size_t len)
+{
+    char path[PATH_MAX + 64];
+    FILE *f;
+    size_t n;
+
+    SNPRINTF(path, sizeof(path), "%s/%s", dir, name);
+
+    if (!(f = fopen(path, "r")))
+    {
+        return -1;
+    }
+
+    if (!fgets(buf, len, f))
+    {
+        buf[0] = '\0';
+    }
+
+    fclose(f);
+
+    n = strcspn(buf, "\r\n");
+    buf[n] = '\0';
+
+    return 0;
+}
+
+/*
+ * Walks up from the tty's device in sysfs: a usb-serial port, then the
+ * interface with bInterfaceNumber, then the device with idVendor.
+ */
+static int usb_describe(const char *tty, struct rig_usb_device *dev)
+{
+    char link[PATH_MAX], dir[PATH_MAX];
+    char val[16];
+
+    memset(dev, 0, sizeof(*dev));
+    dev->interface = -1;
+    SNPRINTF(dev->path, sizeof(dev->path), "/dev/%s", tty);
+    SNPRINTF(link, sizeof(link), "/sys/class/tty/%s/device", tty);
+
+    if (!realpath(link, dir))
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    while (strncmp(dir, "/sys/devices/", 13) == 0)
+    {
+        char *slash;
+
+        if (dev->interface < 0
+                && usb_attr(dir, "bInterfaceNumber", val, sizeof(val)) == 0)
+        {
+            dev->interface = (int) strtol(val, NULL, 16);
+        }
+
+        if (usb_attr(dir, "idVendor", val, sizeof(val)) == 0)
+        {
+            dev->vid = (unsigned short) strtol(val, NULL, 16);
+
+            if (usb_attr(dir, "idProduct", val, sizeof(val)) == 0)
+            {
+                dev->pid = (unsigned short) strtol(val, NULL, 16);
+            }
+
+            usb_attr(dir, "manufacturer", dev->manufacturer, sizeof(dev->manufacturer));
+            usb_attr(dir, "product", dev->product, sizeof(dev->product));
+            usb_attr(dir, "serial", dev->serial, sizeof(dev->serial));
+            usb_match(dev);
+
+            return RIG_OK;
+        }
+
+        if (!(slash = strrchr(dir, '/')))
+        {
+            break;
+        }
+
+        *slash = '\0';
+    }
+
+    return -RIG_ENAVAIL;
+}
+
+#endif
+
+
+/**
+ * \brief identify the rig behind a USB serial port from its descriptors
+ * \param pathname  The serial device, e.g. /dev/ttyUSB0 or a
+ * /dev/serial/by-id link to it
+ * \param dev       Filled in with what was found
+ *
+ *  Reads the USB descriptors of the bridge behind \a pathname and looks
+ *  them up in Hamlib's table of radios that name themselves there.  No
+ *  byte is sent to the port.
+ *
+ * \return RIG_OK when \a pathname is a USB serial device, dev->model being
+ * RIG_MODEL_NONE if the table does not know it; -RIG_ENAVAIL if it is not
+ * a USB device, -RIG_ENIMPL where USB descriptors cannot be read (anything
+ * but Linux for now).
+ *
+ * \sa rig_usb_identify(), rig_probe()
+ */
+int HAMLIB_API rig_usb_identify_port(const char *pathname,
+                                     struct rig_usb_device *dev)
+{
+#if defined(__linux__)
+    char path[PATH_MAX];
+    const char *tty;
+    int ret;
+
+    if (!pathname || !dev)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (!realpath(pathname, path))
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    tty = strrchr(path, '/');
+    tty = tty ? tty + 1 : path;
+
+    ret = usb_describe(tty, dev);
+
+    if (ret == RIG_OK)
+    {
+        /* the caller's name, a by-id link stays one */
+        SNPRINTF(dev->path, sizeof(dev->path), "%s", pathname);
+    }
+
+    return ret;
+#else
+    return -RIG_ENIMPL;
+#endif
+}
+
+
+/**
+ * \brief list the USB serial devices and the rigs they identify
+ * \param cfunc Function called with each USB serial device found
+ * \param data  Arbitrary data passed to cfunc
+ *
+ *  Lists every USB serial port with its descriptors, and the rig model
+ *  and rate to open it with where Hamlib's table knows them.  Takes a few
+ *  milliseconds and sends nothing to the ports; the ports whose model is
+ *  RIG_MODEL_NONE are the ones left for rig_probe_all_ports().  A port
+ *  with cat set to 0 is the data side of a rig whose CAT port is another.
+ *  The enumeration stops early if cfunc returns 0.
+ *
+ * \return the number of devices passed to cfunc, otherwise a negative
+ * value: -RIG_ENIMPL where USB descriptors cannot be read (anything but
+ * Linux for now).
+ *
+ * \sa rig_usb_identify_port(), rig_probe_all_ports()
+ */
+int HAMLIB_API rig_usb_identify(rig_usb_device_func_t cfunc, rig_ptr_t data)
+{
+#if defined(__linux__)
+    struct rig_usb_device dev;
+    struct dirent *d;
+    DIR *dir;
+    int count = 0;
+
+    if (!cfunc)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (!(dir = opendir("/sys/class/tty")))
+    {
+        return -RIG_EIO;
+    }
+
+    while ((d = readdir(dir)) != NULL)
+    {
+        if (d->d_name[0] == '.' || usb_describe(d->d_name, &dev) != RIG_OK)
+        {
+            continue;
+        }
+
+        count++;
+
+        if ((*cfunc)(&dev, data) == 0)
+        {
+            break;
+        }
+    }
+
+    closedir(dir);
+
+    return count;
+#else
+    return -RIG_ENIMPL;
+#endif
+}
+
+/** @} */
@@ -50,6 +50,10 @@
 #  include <libusb-1.0/libusb.h>
 #endif
 
+#ifdef HAVE_PTHREAD
+#  include <pthread.h>
+#endif
+
 #include "usb_port.h"
 
 /*
@@ -366,6 +370,414 @@ int usb_port_open(hamlib_port_t *port)
 }
 
 
+#ifdef HAVE_PTHREAD
+/*
+ * Asynchronous transfers.  All ports share the default libusb context, so
+ * one event thread is started by the first usb_async_start() and joined
+ * by the last usb_async_stop().
+ *
+ * A transfer queued in a slot replaces the one still waiting there: an SDR
+ * sweeping its LO at hundreds of steps per second only needs the newest
+ * frequency once the one on the wire completes, not every step in order.
+ */
+struct usb_async
+{
+    hamlib_port_t *port;
+    libusb_device_handle *udh;
+    pthread_mutex_t lock;
+    pthread_cond_t idle;
+    int outstanding;    /* submitted and not yet completed */
+    int busy[USB_ASYNC_SLOTS];
+    struct libusb_transfer *waiting[USB_ASYNC_SLOTS];
+    struct usb_async *next;
+};
+
+struct usb_async_req
+{
+    struct usb_async *a;
+    int slot;
+    usb_async_cb_t cb;
+    void *arg;
+};
+
+static pthread_mutex_t usb_async_list_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct usb_async *usb_async_head = NULL;
+static pthread_t usb_async_thread;
+static int usb_async_users = 0;
+static int usb_async_done = 0;
+
+
+static void *usb_async_events(void *arg)
+{
+    struct timeval tv = { 0, 100000 };
+
+    /* usb_async_done is checked by libusb under its event lock */
+    while (!usb_async_done)
+    {
+        libusb_handle_events_timeout_completed(NULL, &tv, &usb_async_done);
+    }
+
+    return NULL;
+}
+
+
+static struct usb_async *usb_async_find(const hamlib_port_t *port)
+{
+    struct usb_async *a;
+
+    pthread_mutex_lock(&usb_async_list_lock);
+
+    for (a = usb_async_head; a; a = a->next)
+    {
+        if (a->port == port)
+        {
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&usb_async_list_lock);
+
+    return a;
+}
+
+
+static void LIBUSB_CALL usb_async_complete(struct libusb_transfer *xfer)
+{
+    struct usb_async_req *req = (struct usb_async_req *) xfer->user_data;
+    struct usb_async *a = req->a;
+    int status;
+
+    switch (xfer->status)
+    {
+    case LIBUSB_TRANSFER_COMPLETED:
+        status = RIG_OK;
+        break;
+
+    case LIBUSB_TRANSFER_TIMED_OUT:
+        status = -RIG_ETIMEOUT;
+        break;
+
+    default:
+        status = -RIG_EIO;
+    }
+
+    if (status != RIG_OK)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: request 0x%02x failed: %s\n", __func__,
+                  libusb_control_transfer_get_setup(xfer)->bRequest,
+                  libusb_error_name(xfer->status));
+    }
+
+    if (req->cb)
+    {
+        req->cb(a->port, status, libusb_control_transfer_get_data(xfer),
+                xfer->actual_length, req->arg);
+    }
+
+    pthread_mutex_lock(&a->lock);
+    a->outstanding--;
+
+    if (req->slot >= 0)
+    {
+        struct libusb_transfer *next = a->waiting[req->slot];
+
+        a->waiting[req->slot] = NULL;
+        a->busy[req->slot] = 0;
+
+        if (next)
+        {
+            if (libusb_submit_transfer(next) == 0)
+            {
+                a->busy[req->slot] = 1;
+                a->outstanding++;
+            }
+            else
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: resubmit failed\n", __func__);
+                free(next->user_data);
+                libusb_free_transfer(next);
+            }
+        }
+    }
+
+    if (a->outstanding == 0)
+    {
+        pthread_cond_broadcast(&a->idle);
+    }
+
+    pthread_mutex_unlock(&a->lock);
+
+    /* the transfer and its buffer go with LIBUSB_TRANSFER_FREE_TRANSFER */
+    free(req);
+}
+
+
+/**
+ * \brief Start asynchronous transfers on an open USB port
+ * \param port
+ * \return RIG_OK or < 0
+ */
+int usb_async_start(hamlib_port_t *port)
+{
+    struct usb_async *a;
+
+    if (!port->handle)
+    {
+        return -RIG_EINVAL;
+    }
+
+    if (usb_async_find(port))
+    {
+        return RIG_OK;
+    }
+
+    a = calloc(1, sizeof(*a));
+
+    if (!a)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    a->port = port;
+    a->udh = port->handle;
+    pthread_mutex_init(&a->lock, NULL);
+    pthread_cond_init(&a->idle, NULL);
+
+    pthread_mutex_lock(&usb_async_list_lock);
+
+    if (usb_async_users++ == 0)
+    {
+        usb_async_done = 0;
+
+        if (pthread_create(&usb_async_thread, NULL, usb_async_events, NULL))
+        {
+            usb_async_users = 0;
+            pthread_mutex_unlock(&usb_async_list_lock);
+            rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                      strerror(errno));
+            pthread_cond_destroy(&a->idle);
+            pthread_mutex_destroy(&a->lock);
+            free(a);
+            return -RIG_EINTERNAL;
+        }
+    }
+
+    a->next = usb_async_head;
+    usb_async_head = a;
+    pthread_mutex_unlock(&usb_async_list_lock);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: asynchronous transfers on %04x:%04x\n",
+              __func__, port->parm.usb.vid, port->parm.usb.pid);
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Queue a control transfer without waiting for it
+ * \param port
+ * \param slot latest-wins slot below USB_ASYNC_SLOTS, or -1 to send every request
+ * \param request_type bmRequestType, the direction bit tells IN from OUT
+ * \param request
+ * \param value
+ * \param index
+ * \param data bytes sent by an OUT transfer, NULL for IN
+ * \param len bytes sent or expected
+ * \param cb completion callback, may be NULL
+ * \param arg passed to cb
+ * \return RIG_OK or < 0
+ *
+ * A request replaced in its slot before going out is dropped without a
+ * callback.
+ */
+int usb_async_control(hamlib_port_t *port, int slot, int request_type,
+                      int request, int value, int index,
+                      const unsigned char *data, int len,
+                      usb_async_cb_t cb, void *arg)
+{
+    struct usb_async *a = usb_async_find(port);
+    struct libusb_transfer *xfer;
+    struct usb_async_req *req;
+    unsigned char *buf;
+    int r;
+
+    if (!a || slot >= USB_ASYNC_SLOTS || len < 0 || len > 0xffff)
+    {
+        return -RIG_EINVAL;
+    }
+
+    xfer = libusb_alloc_transfer(0);
+    buf = malloc(LIBUSB_CONTROL_SETUP_SIZE + len);
+    req = malloc(sizeof(*req));
+
+    if (!xfer || !buf || !req)
+    {
+        libusb_free_transfer(xfer);
+        free(buf);
+        free(req);
+        return -RIG_ENOMEM;
+    }
+
+    libusb_fill_control_setup(buf, request_type, request, value, index, len);
+
+    if (!(request_type & LIBUSB_ENDPOINT_IN) && len > 0)
+    {
+        memcpy(buf + LIBUSB_CONTROL_SETUP_SIZE, data, len);
+    }
+
+    req->a = a;
+    req->slot = slot;
+    req->cb = cb;
+    req->arg = arg;
+
+    libusb_fill_control_transfer(xfer, a->udh, buf, usb_async_complete, req,
+                                 port->timeout);
+    xfer->flags = LIBUSB_TRANSFER_FREE_BUFFER | LIBUSB_TRANSFER_FREE_TRANSFER;
+
+    pthread_mutex_lock(&a->lock);
+
+    if (slot >= 0 && a->busy[slot])
+    {
+        struct libusb_transfer *old = a->waiting[slot];
+
+        a->waiting[slot] = xfer;
+        pthread_mutex_unlock(&a->lock);
+
+        if (old)
+        {
+            free(old->user_data);
+            libusb_free_transfer(old);
+        }
+
+        return RIG_OK;
+    }
+
+    r = libusb_submit_transfer(xfer);
+
+    if (r < 0)
+    {
+        pthread_mutex_unlock(&a->lock);
+        rig_debug(RIG_DEBUG_ERR, "%s: libusb_submit_transfer: %s\n", __func__,
+                  libusb_error_name(r));
+        free(req);
+        libusb_free_transfer(xfer);
+        return -RIG_EIO;
+    }
+
+    if (slot >= 0)
+    {
+        a->busy[slot] = 1;
+    }
+
+    a->outstanding++;
+    pthread_mutex_unlock(&a->lock);
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Wait until every queued transfer has completed
+ * \param port
+ * \return RIG_OK, or RIG_OK at once when the port has no asynchronous transfers
+ */
+int usb_async_flush(hamlib_port_t *port)
+{
+    struct usb_async *a = usb_async_find(port);
+
+    if (!a)
+    {
+        return RIG_OK;
+    }
+
+    pthread_mutex_lock(&a->lock);
+
+    while (a->outstanding > 0)
+    {
+        pthread_cond_wait(&a->idle, &a->lock);
+    }
+
+    pthread_mutex_unlock(&a->lock);
+
+    return RIG_OK;
+}
+
+
+/**
+ * \brief Complete what is queued and stop asynchronous transfers on a port
+ * \param port
+ */
+void usb_async_stop(hamlib_port_t *port)
+{
+    struct usb_async *a = usb_async_find(port);
+    struct usb_async **pp;
+    int last;
+
+    if (!a)
+    {
+        return;
+    }
+
+    usb_async_flush(port);
+
+    pthread_mutex_lock(&usb_async_list_lock);
+
+    for (pp = &usb_async_head; *pp; pp = &(*pp)->next)
+    {
+        if (*pp == a)
+        {
+            *pp = a->next;
+            break;
+        }
+    }
+
+    last = --usb_async_users == 0;
+    pthread_mutex_unlock(&usb_async_list_lock);
+
+    if (last)
+    {
+        usb_async_done = 1;
+#if defined(LIBUSB_API_VERSION) && LIBUSB_API_VERSION >= 0x01000105
+        libusb_interrupt_event_handler(NULL);
+#endif
+        /* otherwise the thread sees it within its 100 ms event timeout */
+        pthread_join(usb_async_thread, NULL);
+    }
+
+    pthread_cond_destroy(&a->idle);
+    pthread_mutex_destroy(&a->lock);
+    free(a);
+}
+
+#else
+
+//! @cond Doxygen_Suppress
+int usb_async_start(hamlib_port_t *port)
+{
+    return -RIG_ENAVAIL;
+}
+
+int usb_async_control(hamlib_port_t *port, int slot, int request_type,
+                      int request, int value, int index,
+                      const unsigned char *data, int len,
+                      usb_async_cb_t cb, void *arg)
+{
+    return -RIG_ENAVAIL;
+}
+
+int usb_async_flush(hamlib_port_t *port)
+{
+    return RIG_OK;
+}
+
+void usb_async_stop(hamlib_port_t *port)
+{
+}
+//! @endcond
+
+#endif
+
+
 /**
  * \brief Close hamlib_port of USB device
  * \param port
@@ -378,6 +790,8 @@ int usb_port_close(hamlib_port_t *port)
 
     rig_debug(RIG_DEBUG_VERBOSE, "%s called\n", __func__);
 
+    usb_async_stop(port);
+
     libusb_release_interface(udh, port->parm.usb.iface);
 
     libusb_close(udh);
@@ -408,6 +822,31 @@ int usb_port_close(hamlib_port_t *port)
 }
 //! @endcond
 
+
+//! @cond Doxygen_Suppress
+int usb_async_start(hamlib_port_t *port)
+{
+    return -RIG_ENAVAIL;
+}
+
+int usb_async_control(hamlib_port_t *port, int slot, int request_type,
+                      int request, int value, int index,
+                      const unsigned char *data, int len,
+                      usb_async_cb_t cb, void *arg)
+{
+    return -RIG_ENAVAIL;
+}
+
+int usb_async_flush(hamlib_port_t *port)
+{
+    return RIG_OK;
+}
+
+void usb_async_stop(hamlib_port_t *port)
+{
+}
+//! @endcond
+
 #endif  /* defined(HAVE_LIBUSB) && defined(HAVE_LIBUSB_H) */
 
 /** @} */
@@ -31,6 +31,26 @@ __BEGIN_DECLS
 int usb_port_open(hamlib_port_t *p);
 int usb_port_close(hamlib_port_t *p);
 
+/*
+ * Asynchronous control transfers, for backends that must not block the
+ * caller on every USB round trip.  The callback runs on the libusb event
+ * thread with status RIG_OK or a negative error, and for IN transfers the
+ * data received.
+ */
+typedef void (*usb_async_cb_t)(hamlib_port_t *p, int status,
+                               const unsigned char *data, int len, void *arg);
+
+/* Number of latest-wins slots usb_async_control() can coalesce into */
+#define USB_ASYNC_SLOTS 4
+
+int usb_async_start(hamlib_port_t *p);
+int usb_async_control(hamlib_port_t *p, int slot, int request_type,
+                      int request, int value, int index,
+                      const unsigned char *data, int len,
+                      usb_async_cb_t cb, void *arg);
+int usb_async_flush(hamlib_port_t *p);
+void usb_async_stop(hamlib_port_t *p);
+
 __END_DECLS
 
 #endif /* _USB_PORT_H */
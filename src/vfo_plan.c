@@ -0,0 +1,125 @@
+/*
+ *  Hamlib Interface - VFO access planning
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+/*
+ * Rigs that only have "current VFO" commands need set_vfo, the operation
+ * and set_vfo back to work on the other VFO, three transactions where one
+ * would do and a flicker on the display.  The generic layer asks here
+ * first: when the VFO is already the current one, or the backend can
+ * address it directly, no swap is needed.
+ *
+ * rig_state.targetable_vfo starts as caps->targetable_vfo and a backend
+ * may widen it in its rig_open once it knows what the rig at the other
+ * end supports, e.g. Icom rigs answering the 0x25 command.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <hamlib/rig.h>
+#include "vfo_plan.h"
+#include "stats.h"
+#include "misc.h"
+
+static const char *plan_names[] = { "direct", "targeted", "swap" };
+
+rig_vfo_plan_t vfo_plan(RIG *rig, vfo_t vfo, int targetable, const char *op)
+{
+    const struct rig_state *rs = &rig->state;
+    rig_vfo_plan_t plan;
+
+    if (vfo == RIG_VFO_CURR || vfo == rs->current_vfo)
+    {
+        plan = RIG_VFO_PLAN_DIRECT;
+    }
+    else if ((rs->targetable_vfo & targetable)
+             // in vfo mode rigctld does any VFO swapping we need
+             || (rs->vfo_opt == 1 && RIG_MODEL_IS_NETRIGCTL(rig->caps->rig_model)))
+    {
+        plan = RIG_VFO_PLAN_TARGETED;
+    }
+    else
+    {
+        plan = RIG_VFO_PLAN_SWAP;
+    }
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: %s vfo=%s curr_vfo=%s plan=%s\n", __func__,
+              op, rig_strvfo(vfo), rig_strvfo(rs->current_vfo), plan_names[plan]);
+
+    rig_stats_vfo_plan(rig, op, vfo, plan);
+
+    return plan;
+}
+
+void vfo_plan_audit(RIG *rig)
+{
+    static const struct
+    {
+        int bit;
+        const char *name;
+    } ops[] =
+    {
+        { RIG_TARGETABLE_FREQ, "freq" },
+        { RIG_TARGETABLE_MODE, "mode" },
+        { RIG_TARGETABLE_TONE, "tone" },
+        { RIG_TARGETABLE_FUNC, "func" },
+        { RIG_TARGETABLE_LEVEL, "level" },
+        { RIG_TARGETABLE_RITXIT, "ritxit" },
+        { RIG_TARGETABLE_PTT, "ptt" },
+        { RIG_TARGETABLE_ANT, "ant" },
+    };
+    const struct rig_state *rs = &rig->state;
+    const struct rig_caps *caps = rig->caps;
+    char buf[256] = "";
+    int can_swap;
+    int i;
+
+    can_swap = caps->set_vfo != NULL
+               || (caps->vfo_op && rig_has_vfo_op(rig, RIG_OP_TOGGLE));
+
+    for (i = 0; i < (int)(sizeof(ops) / sizeof(ops[0])); i++)
+    {
+        const char *how;
+        size_t len = strlen(buf);
+
+        if (rs->targetable_vfo & ops[i].bit)
+        {
+            how = (caps->targetable_vfo & ops[i].bit) ? "targeted" : "targeted(probed)";
+        }
+        else
+        {
+            how = can_swap ? "swap" : "none";
+        }
+
+        snprintf(buf + len, sizeof(buf) - len, " %s=%s", ops[i].name, how);
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: other VFO access:%s\n", __func__, buf);
+
+    if (!can_swap && (rs->targetable_vfo & RIG_TARGETABLE_FREQ) == 0)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE,
+                  "%s: no set_vfo and no targetable freq, only the current VFO can be used\n",
+                  __func__);
+    }
+}
@@ -0,0 +1,36 @@
+/*
+ *  Hamlib Interface - VFO access planning
+ *  Copyright (c) 2026 by The Hamlib Group
+ *
+ *
+ *   This library is free software; you can redistribute it and/or
+ *   modify it under the terms of the GNU Lesser General Public
+ *   License as published by the Free Software Foundation; either
+ *   version 2.1 of the License, or (at your option) any later version.
+ *
+ *   This library is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *   Lesser General Public License for more details.
+ *
+ *   You should have received a copy of the GNU Lesser General Public
+ *   License along with this library; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ */
+
+#ifndef _VFO_PLAN_H
+#define _VFO_PLAN_H 1
+
+#include <hamlib/rig.h>
+
+/*
+ * Pick the cheapest way to run op on vfo given the RIG_TARGETABLE_* bit
+ * the operation needs, and count the choice in the rig statistics
+ */
+rig_vfo_plan_t vfo_plan(RIG *rig, vfo_t vfo, int targetable, const char *op);
+
+/* Log at open time how each targetable operation will reach the other VFO */
+void vfo_plan_audit(RIG *rig);
+
+#endif /* _VFO_PLAN_H */
@@ -1332,10 +1332,18 @@ int ampctl_parse(AMP *my_amp, FILE *fin, FILE *fout, char *argv[], int argc)
 
     /*
      * mutex locking needed because ampctld is multithreaded
-     * and hamlib is not MT-safe
+     * and hamlib is not MT-safe.  A polled amplifier is: its port is
+     * serialized by the library and readings come from the cache, so
+     * clients are not held up behind each other.
      */
 #ifdef HAVE_PTHREAD
-    pthread_mutex_lock(&amp_mutex);
+    int amp_locked = my_amp->state.cache.poll_ms == 0;
+
+    if (amp_locked)
+    {
+        pthread_mutex_lock(&amp_mutex);
+    }
+
 #endif
 
     if (!prompt)
@@ -1385,7 +1393,12 @@ int ampctl_parse(AMP *my_amp, FILE *fin, FILE *fout, char *argv[], int argc)
 #endif
 
 #ifdef HAVE_PTHREAD
-    pthread_mutex_unlock(&amp_mutex);
+
+    if (amp_locked)
+    {
+        pthread_mutex_unlock(&amp_mutex);
+    }
+
 #endif
 
     if (retcode == RIG_EIO) { return retcode; }
@@ -59,10 +59,18 @@
 #  include <pthread.h>
 #endif
 
+#if defined(HAVE_POLL_H) && defined(HAVE_FMEMOPEN)
+#  include <poll.h>
+#  include <fcntl.h>
+#  define AMPCTLD_EVENT_LOOP 1
+#endif
+
 #include <hamlib/amplifier.h>
 #include "misc.h"
+#include "executor.h"
 
 #include "ampctl_parse.h"
+#include "metrics_http.h"
 
 struct handle_data
 {
@@ -74,6 +82,10 @@ struct handle_data
 
 void *handle_socket(void *arg);
 
+#ifdef AMPCTLD_EVENT_LOOP
+static int ampctld_event_loop(int sock_listen, AMP *my_amp);
+#endif
+
 void usage();
 
 /*
@@ -82,7 +94,7 @@ void usage();
  * NB: do NOT use -W since it's reserved by POSIX.
  * TODO: add an option to read from a file
  */
-#define SHORT_OPTIONS "m:r:s:C:t:T:LuvhVlZ"
+#define SHORT_OPTIONS "m:r:s:C:t:T:LuvhVlZEH:"
 static struct option long_options[] =
 {
     {"model",           1, 0, 'm'},
@@ -95,6 +107,8 @@ static struct option long_options[] =
     {"show-conf",       0, 0, 'L'},
     {"dump-caps",       0, 0, 'u'},
     {"debug-time-stamps", 0, 0, 'Z'},
+    {"event-loop",      0, 0, 'E'},
+    {"http",            1, 0, 'H'},
     {"verbose",         0, 0, 'v'},
     {"help",            0, 0, 'h'},
     {"version",         0, 0, 'V'},
@@ -148,6 +162,12 @@ static void handle_error(enum rig_debug_level_e lvl, const char *msg)
 }
 
 
+static int amp_metrics(void *handle, char *buf, int len)
+{
+    return amp_get_metrics((AMP *) handle, buf, len);
+}
+
+
 int main(int argc, char *argv[])
 {
     AMP *my_amp;        /* handle to amp (instance) */
@@ -167,6 +187,8 @@ int main(int argc, char *argv[])
     int reuseaddr = 1;
     char host[NI_MAXHOST];
     char serv[NI_MAXSERV];
+    int event_loop = 0;
+    const char *http_port = NULL;
 
 #ifdef HAVE_PTHREAD
     pthread_t thread;
@@ -299,6 +321,24 @@ int main(int argc, char *argv[])
             rig_set_debug_time_stamp(1);
             break;
 
+        case 'E':
+#ifdef AMPCTLD_EVENT_LOOP
+            event_loop = 1;
+#else
+            fprintf(stderr, "Event loop mode not available, using a thread per client\n");
+#endif
+            break;
+
+        case 'H':
+            if (!optarg)
+            {
+                usage();    /* wrong arg count */
+                exit(1);
+            }
+
+            http_port = optarg;
+            break;
+
         default:
             usage();    /* unknown option? */
             exit(1);
@@ -511,6 +551,12 @@ int main(int argc, char *argv[])
         exit(1);
     }
 
+    if (http_port
+            && metrics_http_start(src_addr, http_port, amp_metrics, my_amp) != RIG_OK)
+    {
+        fprintf(stderr, "Cannot serve metrics on port %s\n", http_port);
+    }
+
 #ifdef SIGPIPE
     /* Ignore SIGPIPE as we will handle it at the write()/send() calls
        that will consequently fail with EPIPE. All child threads will
@@ -535,6 +581,14 @@ int main(int argc, char *argv[])
 #endif
 #endif
 
+#ifdef AMPCTLD_EVENT_LOOP
+
+    if (event_loop)
+    {
+        retcode = ampctld_event_loop(sock_listen, my_amp);
+    }
+    else
+#endif
     /*
      * main loop accepting connections
      */
@@ -706,6 +760,369 @@ handle_exit:
 }
 
 
+#ifdef AMPCTLD_EVENT_LOOP
+/*
+ * -E/--event-loop: one thread polls the listening socket and every client
+ * and buffers what they send.  A complete line is posted to the amplifier's
+ * strand of the shared executor (src/executor.c), so the commands run one
+ * at a time and in order on a worker thread.  A client with a command in
+ * flight is left out of the poll set until the task has pinged the wake
+ * pipe.
+ */
+#define EVL_MAX_CLIENTS 64
+#define EVL_BUFSZ 4096
+
+struct evl_client
+{
+    struct handle_data h;
+    FILE *fsockout;
+    char buf[EVL_BUFSZ];
+    size_t len;
+    int need_more;  /* buffered command is incomplete, wait for more input */
+    int busy;       /* posted to the strand, only the task touches it */
+    int done;       /* the task has finished, set last */
+    int result;     /* what evl_run() returned */
+};
+
+static struct evl_client *evl_clients[EVL_MAX_CLIENTS];
+static int evl_wake[2] = { -1, -1 };
+
+static void evl_close(int i)
+{
+    struct evl_client *c = evl_clients[i];
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: connection closed, fd=%d\n", __func__,
+              c->h.sock);
+
+    /* closes the socket too */
+    fclose(c->fsockout);
+    free(c);
+    evl_clients[i] = NULL;
+}
+
+static void evl_accept(int sock_listen, AMP *my_amp)
+{
+    struct evl_client *c;
+    char host[NI_MAXHOST];
+    char serv[NI_MAXSERV];
+    int i;
+
+    c = calloc(1, sizeof(struct evl_client));
+
+    if (!c)
+    {
+        rig_debug(RIG_DEBUG_ERR, "calloc: %s\n", strerror(errno));
+        return;
+    }
+
+    c->h.amp = my_amp;
+    c->h.clilen = sizeof(c->h.cli_addr);
+    c->h.sock = accept(sock_listen, (struct sockaddr *)&c->h.cli_addr,
+                       &c->h.clilen);
+
+    if (c->h.sock < 0)
+    {
+        handle_error(RIG_DEBUG_ERR, "accept");
+        free(c);
+        return;
+    }
+
+    for (i = 0; i < EVL_MAX_CLIENTS && evl_clients[i]; i++) {}
+
+    if (i == EVL_MAX_CLIENTS)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: too many clients, max %d\n", __func__,
+                  EVL_MAX_CLIENTS);
+        close(c->h.sock);
+        free(c);
+        return;
+    }
+
+    c->fsockout = fdopen(c->h.sock, "wb");
+
+    if (!c->fsockout)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: fdopen out: %s\n", __func__, strerror(errno));
+        close(c->h.sock);
+        free(c);
+        return;
+    }
+
+    if (getnameinfo((struct sockaddr const *)&c->h.cli_addr, c->h.clilen,
+                    host, sizeof(host), serv, sizeof(serv),
+                    NI_NUMERICHOST | NI_NUMERICSERV) == 0)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "Connection opened from %s:%s\n", host, serv);
+    }
+
+    evl_clients[i] = c;
+}
+
+/* line ends between commands are no-ops for ampctl_parse(), drop them here */
+static void evl_skip_eol(struct evl_client *c)
+{
+    size_t n = 0;
+
+    while (n < c->len && (c->buf[n] == '\n' || c->buf[n] == '\r'))
+    {
+        n++;
+    }
+
+    c->len -= n;
+    memmove(c->buf, c->buf + n, c->len);
+}
+
+static int evl_runnable(const struct evl_client *c)
+{
+    if (!c || c->busy || c->len == 0 || c->need_more)
+    {
+        return 0;
+    }
+
+    return c->len == EVL_BUFSZ || memchr(c->buf, '\n', c->len)
+           || memchr(c->buf, '\r', c->len);
+}
+
+/* read what the client sent, returns -1 once it has gone away */
+static int evl_read(struct evl_client *c)
+{
+    ssize_t n;
+
+    if (c->len == EVL_BUFSZ)
+    {
+        return 0;
+    }
+
+    n = recv(c->h.sock, c->buf + c->len, EVL_BUFSZ - c->len, 0);
+
+    if (n <= 0)
+    {
+        return -1;
+    }
+
+    c->len += n;
+    c->need_more = 0;
+
+    return 0;
+}
+
+/* run the client's next buffered command, returns -1 to drop the client */
+static int evl_run(struct evl_client *c)
+{
+    FILE *fsockin;
+    long used;
+    int eof;
+    int retcode;
+
+    evl_skip_eol(c);
+
+    if (c->len == 0)
+    {
+        return 0;
+    }
+
+    fsockin = fmemopen(c->buf, c->len, "r");
+
+    if (!fsockin)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: fmemopen: %s\n", __func__, strerror(errno));
+        return -1;
+    }
+
+    retcode = ampctl_parse(c->h.amp, fsockin, c->fsockout, NULL, 0);
+
+    used = ftell(fsockin);
+    eof = feof(fsockin);
+    fclose(fsockin);
+
+    /* ran out of input before the command was complete, nothing done yet */
+    if ((retcode == -1 || retcode == 1) && eof)
+    {
+        if (c->len == EVL_BUFSZ)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: command too long\n", __func__);
+            return -1;
+        }
+
+        c->need_more = 1;
+        return 0;
+    }
+
+    if (used <= 0 || used > (long)c->len)
+    {
+        used = c->len;
+    }
+
+    c->len -= used;
+    memmove(c->buf, c->buf + used, c->len);
+    evl_skip_eol(c);
+
+    if (ferror(c->fsockout))
+    {
+        return -1;
+    }
+
+    return (retcode == 0 || retcode == 2) ? 0 : -1;
+}
+
+/* runs on the amplifier's strand */
+static void evl_task(void *arg)
+{
+    struct evl_client *c = arg;
+    char ping = 0;
+
+    c->result = evl_run(c);
+    __atomic_store_n(&c->done, 1, __ATOMIC_RELEASE);
+
+    if (write(evl_wake[1], &ping, 1) < 0 && errno != EAGAIN)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: wake pipe: %s\n", __func__, strerror(errno));
+    }
+}
+
+/* take back the clients whose command has finished */
+static void evl_reap(void)
+{
+    char drain[64];
+    int i;
+
+    while (read(evl_wake[0], drain, sizeof(drain)) > 0) {}
+
+    for (i = 0; i < EVL_MAX_CLIENTS; i++)
+    {
+        struct evl_client *c = evl_clients[i];
+
+        if (!c || !c->busy || !__atomic_load_n(&c->done, __ATOMIC_ACQUIRE))
+        {
+            continue;
+        }
+
+        c->busy = 0;
+        c->done = 0;
+
+        if (c->result < 0)
+        {
+            evl_close(i);
+        }
+    }
+}
+
+static int ampctld_event_loop(int sock_listen, AMP *my_amp)
+{
+    struct pollfd fds[EVL_MAX_CLIENTS + 2];
+    int slot[EVL_MAX_CLIENTS + 2];
+    hl_strand_t *strand;
+    int i;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: serving clients from one thread\n",
+              __func__);
+
+    strand = hl_strand_new(hl_executor_default(), "amplifier");
+
+    if (!strand || pipe(evl_wake) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: no executor or wake pipe\n", __func__);
+        hl_strand_free(strand);
+        return -1;
+    }
+
+    fcntl(evl_wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(evl_wake[1], F_SETFL, O_NONBLOCK);
+
+    /* clients arrive in bursts while we are busy with the amplifier, queue them all */
+    if (listen(sock_listen, EVL_MAX_CLIENTS) < 0)
+    {
+        handle_error(RIG_DEBUG_WARN, "listen");
+    }
+
+    while (1)
+    {
+        int nfds = 2;
+        int n;
+
+        fds[0].fd = sock_listen;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = evl_wake[0];
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+
+        for (i = 0; i < EVL_MAX_CLIENTS; i++)
+        {
+            if (!evl_clients[i] || evl_clients[i]->busy) { continue; }
+
+            fds[nfds].fd = evl_clients[i]->h.sock;
+            fds[nfds].events = POLLIN;
+            fds[nfds].revents = 0;
+            slot[nfds++] = i;
+        }
+
+        n = poll(fds, nfds, -1);
+
+        if (n < 0)
+        {
+            if (errno == EINTR) { continue; }
+
+            rig_debug(RIG_DEBUG_ERR, "%s: poll() failed: %s\n", __func__,
+                      strerror(errno));
+            break;
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            evl_reap();
+        }
+
+        for (i = 2; i < nfds; i++)
+        {
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+            {
+                if (evl_read(evl_clients[slot[i]]) < 0)
+                {
+                    evl_close(slot[i]);
+                }
+            }
+        }
+
+        /* take every pending connection, not just the first */
+        while (fds[0].revents & POLLIN)
+        {
+            evl_accept(sock_listen, my_amp);
+
+            if (poll(fds, 1, 0) <= 0) { break; }
+        }
+
+        for (i = 0; i < EVL_MAX_CLIENTS; i++)
+        {
+            struct evl_client *c = evl_clients[i];
+
+            if (!evl_runnable(c)) { continue; }
+
+            c->busy = 1;
+
+            if (hl_strand_post(strand, evl_task, c) != RIG_OK)
+            {
+                evl_close(i);
+            }
+        }
+    }
+
+    /* let the commands in flight finish before their clients go */
+    hl_strand_free(strand);
+
+    for (i = 0; i < EVL_MAX_CLIENTS; i++)
+    {
+        if (evl_clients[i]) { evl_close(i); }
+    }
+
+    close(evl_wake[0]);
+    close(evl_wake[1]);
+
+    return 0;
+}
+#endif /* AMPCTLD_EVENT_LOOP */
+
+
 void usage()
 {
     printf("Usage: ampctld [OPTION]... [COMMAND]...\n"
@@ -722,6 +1139,8 @@ void usage()
         "  -l, --list                    list all model numbers and exit\n"
         "  -u, --dump-caps               dump capabilities and exit\n"
         "  -v, --verbose                 set verbose mode, cumulative\n"
+        "  -E, --event-loop              poll all clients from one thread, run commands on a worker pool\n"
+        "  -H, --http=PORT               serve OpenMetrics for Prometheus at /metrics on PORT\n"
         "  -Z, --debug-time-stamps       enable time stamps for debug messages\n"
         "  -h, --help                    display this help and exit\n"
         "  -V, --version                 output version information and exit\n\n",
@@ -0,0 +1,60 @@
+#!/bin/sh
+
+# Runs sim_bench against every simulator and prints one JSON document.
+# Usage: bench.sh simulators_dir [count]
+# "make bench" in tests/ builds everything and writes bench.json.
+# SIM_* variables from the environment (see simulators/sim_io.h) reach
+# the simulators, e.g. SIM_BAUD=19200 SIM_LATENCY_MS=16 make bench
+
+simdir=${1:-../simulators}
+count=${2:-20}
+
+# simulator and the model whose backend talks to it
+pairs="simicom:3073 simkenwood:2041 simyaesu:1037 simft991:1035 simelecraft:2029"
+
+echo "{\"date\": \"$(date -u +%Y-%m-%dT%H:%M:%SZ)\", \"rigs\": ["
+
+first=1
+
+for pair in $pairs; do
+    sim=${pair%%:*}
+    model=${pair##*:}
+    log=bench-$sim.log
+
+    if [ ! -x "$simdir/$sim" ]; then
+        echo "$sim: not built, skipped" >&2
+        continue
+    fi
+
+    "$simdir/$sim" > "$log" 2>&1 &
+    pid=$!
+
+    # the simulator prints name=/dev/pts/N once its pty is ready
+    pty=
+    tries=0
+
+    while [ -z "$pty" ] && [ $tries -lt 50 ]; do
+        sleep 0.1
+        pty=$(sed -n 's/^name=//p' "$log" | head -n 1)
+        tries=$((tries + 1))
+    done
+
+    if [ -z "$pty" ]; then
+        echo "$sim: no pty, skipped" >&2
+        kill $pid 2>/dev/null
+        continue
+    fi
+
+    if out=$(./sim_bench "$model" "$pty" "$count"); then
+        [ $first = 1 ] || echo ","
+        echo "$out"
+        first=0
+    else
+        echo "$sim: sim_bench failed" >&2
+    fi
+
+    kill $pid 2>/dev/null
+    wait $pid 2>/dev/null
+done
+
+echo "]}"
@@ -0,0 +1,65 @@
+/*
+ * Hamlib cmd_bench program
+ * Times rigctl/rigctld command dispatch, short and long names.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <hamlib/rig.h>
+#include <sys/time.h>
+#include "rigctl_parse.h"
+
+#define LOOP_COUNT 1000000
+
+static const char *names[] =
+{
+    "f", "F", "m", "t", "l",
+    "get_freq", "set_freq", "get_mode", "get_ptt", "get_level",
+    "get_split_vfo", "send_morse", "get_powerstat", "dump_state",
+    NULL
+};
+
+
+int main(int argc, char *argv[])
+{
+    unsigned i, n;
+    struct timeval tv1, tv2;
+    float elapsed;
+    long found = 0;
+    unsigned loops = argc > 1 ? atoi(argv[1]) : LOOP_COUNT;
+
+    for (n = 0; names[n]; n++)
+    {
+        if (!rigctl_cmd_lookup(names[n]))
+        {
+            printf("command '%s' not found\n", names[n]);
+            return 1;
+        }
+    }
+
+    if (rigctl_cmd_lookup("no_such_command"))
+    {
+        printf("unknown command found\n");
+        return 1;
+    }
+
+    printf("Perform %u loops over %u names...\n", loops, n);
+
+    gettimeofday(&tv1, NULL);
+
+    for (i = 0; i < loops; i++)
+    {
+        found += rigctl_cmd_lookup(names[i % n]) != 0;
+    }
+
+    gettimeofday(&tv2, NULL);
+
+    elapsed = tv2.tv_sec - tv1.tv_sec + (tv2.tv_usec - tv1.tv_usec) / 1000000.0;
+    printf("Elapsed: %.3fs, Avg: %.1f ns/lookup (%ld found)\n",
+           elapsed,
+           elapsed * 1e9 / loops,
+           found);
+
+    return 0;
+}
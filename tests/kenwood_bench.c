@@ -0,0 +1,116 @@
+/*
+ * Hamlib kenwood_bench program
+ * Times a Kenwood polling cycle, which the IF; answer mostly covers.
+ * Run it against simulators/simkenwood:
+ *   ./simkenwood &      (prints name=/dev/pts/N)
+ *   ./kenwood_bench /dev/pts/N [loops] [ms between cycles]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <hamlib/rig.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#define LOOP_COUNT 20
+
+
+int main(int argc, char *argv[])
+{
+    RIG *my_rig;
+    int retcode;
+    unsigned i;
+    struct timeval tv1, tv2;
+    struct rig_stats stats1, stats2;
+    float elapsed;
+    unsigned loops = argc > 2 ? atoi(argv[2]) : LOOP_COUNT;
+    unsigned interval_ms = argc > 3 ? atoi(argv[3]) : 0;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s port [loops] [ms between cycles]\n", argv[0]);
+        return 1;
+    }
+
+    rig_set_debug(RIG_DEBUG_NONE);
+
+    my_rig = rig_init(RIG_MODEL_TS890S);
+
+    if (!my_rig)
+    {
+        fprintf(stderr, "Unknown rig num: %u\n", RIG_MODEL_TS890S);
+        return 1;
+    }
+
+    strncpy(my_rig->state.rigport.pathname, argv[1], HAMLIB_FILPATHLEN - 1);
+
+    retcode = rig_open(my_rig);
+
+    if (retcode != RIG_OK)
+    {
+        printf("rig_open: error = %s\n", rigerror(retcode));
+        return 2;
+    }
+
+    printf("Perform %u loops...\n", loops);
+
+    rig_get_stats(my_rig, &stats1);
+    gettimeofday(&tv1, NULL);
+
+    for (i = 0; i < loops; i++)
+    {
+        ptt_t ptt;
+        vfo_t vfo, tx_vfo;
+        split_t split;
+        shortfreq_t rit;
+        freq_t freq;
+
+        if (i && interval_ms)
+        {
+            usleep(interval_ms * 1000);
+        }
+
+        retcode = rig_get_ptt(my_rig, RIG_VFO_CURR, &ptt);
+
+        if (retcode == RIG_OK)
+        {
+            retcode = rig_get_vfo(my_rig, &vfo);
+        }
+
+        if (retcode == RIG_OK)
+        {
+            retcode = rig_get_split_vfo(my_rig, RIG_VFO_CURR, &split, &tx_vfo);
+        }
+
+        if (retcode == RIG_OK)
+        {
+            retcode = rig_get_rit(my_rig, RIG_VFO_CURR, &rit);
+        }
+
+        if (retcode == RIG_OK)
+        {
+            retcode = rig_get_freq(my_rig, RIG_VFO_A, &freq);
+        }
+
+        if (retcode != RIG_OK)
+        {
+            printf("poll: error = %s\n", rigerror(retcode));
+            return 1;
+        }
+    }
+
+    gettimeofday(&tv2, NULL);
+    rig_get_stats(my_rig, &stats2);
+
+    elapsed = tv2.tv_sec - tv1.tv_sec + (tv2.tv_usec - tv1.tv_usec) / 1000000.0;
+    printf("Elapsed: %.3fs, Avg: %.1f ms/cycle, %.2f transactions/cycle\n",
+           elapsed,
+           elapsed * 1e3 / loops,
+           (double)(stats2.transactions - stats1.transactions) / loops);
+
+    rig_close(my_rig);
+    rig_cleanup(my_rig);
+
+    return 0;
+}
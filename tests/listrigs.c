@@ -89,6 +89,20 @@ int main(int argc, char *argv[])
 {
     int status;
 
+    /* -j: the capabilities of every model as JSON, see rig_caps_export_json() */
+    if (argc > 1 && !strcmp(argv[1], "-j"))
+    {
+        status = rig_caps_export_json(stdout, 0);
+
+        if (status != RIG_OK)
+        {
+            fprintf(stderr, "rig_caps_export_json: error = %s\n", rigerror(status));
+            exit(3);
+        }
+
+        return 0;
+    }
+
     rig_load_all_backends();
 
     printf(" Rig#  \tMfg                    \tModel                  \tVersion    \tStatus   \tType         \tMacro\n");
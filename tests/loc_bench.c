@@ -0,0 +1,134 @@
+/*
+ * Hamlib loc_bench program
+ * Times locator decoding/encoding and qrb, one call at a time and batched.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <hamlib/rig.h>
+#include <hamlib/rotator.h>
+#include <sys/time.h>
+
+#define LOOP_COUNT 1000000
+#define BATCH 1000
+
+static const char *grids[] =
+{
+    "FN31", "JO62", "EM79", "PM95", "QF56", "IO91", "KP20", "GG66",
+    "FN31pr", "JO62qm", "EM79ut", "PM95vq", "QF56od", "IO91wm", "KP20le",
+    "GG66rb", NULL
+};
+
+
+static float elapsed_since(const struct timeval *tv1)
+{
+    struct timeval tv2;
+
+    gettimeofday(&tv2, NULL);
+
+    return tv2.tv_sec - tv1->tv_sec + (tv2.tv_usec - tv1->tv_usec) / 1000000.0;
+}
+
+
+int main(int argc, char *argv[])
+{
+    unsigned i, j, n;
+    struct timeval tv1;
+    float elapsed;
+    double lon[BATCH], lat[BATCH], dist[BATCH], az[BATCH];
+    double sum = 0;
+    char list[BATCH * 7 + 1], loc[13];
+    struct qrb_home home;
+    unsigned loops = argc > 1 ? atoi(argv[1]) : LOOP_COUNT;
+
+    rig_set_debug(RIG_DEBUG_NONE);
+
+    for (n = 0; grids[n]; n++)
+    {
+        if (locator2longlat(&lon[n], &lat[n], grids[n]) != RIG_OK)
+        {
+            printf("locator '%s' not decoded\n", grids[n]);
+            return 1;
+        }
+    }
+
+    printf("Perform %u loops over %u locators...\n", loops, n);
+
+    gettimeofday(&tv1, NULL);
+
+    for (i = 0; i < loops; i++)
+    {
+        double x, y;
+
+        locator2longlat(&x, &y, grids[i % n]);
+        sum += x;
+    }
+
+    elapsed = elapsed_since(&tv1);
+    printf("locator2longlat: %.3fs, Avg: %.1f ns/locator\n",
+           elapsed, elapsed * 1e9 / loops);
+
+    gettimeofday(&tv1, NULL);
+
+    for (i = 0; i < loops; i++)
+    {
+        longlat2locator(lon[i % n], lat[i % n], loc, 3);
+        sum += loc[0];
+    }
+
+    elapsed = elapsed_since(&tv1);
+    printf("longlat2locator: %.3fs, Avg: %.1f ns/locator\n",
+           elapsed, elapsed * 1e9 / loops);
+
+    gettimeofday(&tv1, NULL);
+
+    for (i = 0; i < loops; i++)
+    {
+        double d, a;
+
+        qrb(lon[0], lat[0], lon[i % n], lat[i % n], &d, &a);
+        sum += d;
+    }
+
+    elapsed = elapsed_since(&tv1);
+    printf("qrb:             %.3fs, Avg: %.1f ns/pair\n",
+           elapsed, elapsed * 1e9 / loops);
+
+    /* a batch of spots, as an ingestion service would see them */
+    list[0] = '\0';
+
+    for (j = 0; j < BATCH; j++)
+    {
+        strcat(list, grids[j % n]);
+        strcat(list, " ");
+    }
+
+    gettimeofday(&tv1, NULL);
+
+    for (i = 0; i < loops; i += BATCH)
+    {
+        locator2longlat_batch(list, lon, lat, BATCH);
+        sum += lon[i % BATCH];
+    }
+
+    elapsed = elapsed_since(&tv1);
+    printf("locator2longlat_batch: %.3fs, Avg: %.1f ns/locator\n",
+           elapsed, elapsed * 1e9 / loops);
+
+    qrb_home_init(&home, lon[0], lat[0]);
+
+    gettimeofday(&tv1, NULL);
+
+    for (i = 0; i < loops; i += BATCH)
+    {
+        qrb_home_batch(&home, lon, lat, BATCH, dist, az);
+        sum += dist[i % BATCH];
+    }
+
+    elapsed = elapsed_since(&tv1);
+    printf("qrb_home_batch:  %.3fs, Avg: %.1f ns/pair (%g)\n",
+           elapsed, elapsed * 1e9 / loops, sum);
+
+    return 0;
+}
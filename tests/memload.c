@@ -32,6 +32,7 @@
 #ifdef HAVE_XML2
 #  include <libxml/parser.h>
 #  include <libxml/tree.h>
+#  include <libxml/xmlreader.h>
 
 static int set_chan(RIG *rig, channel_t *chan, xmlNodePtr node);
 #endif
@@ -40,61 +41,84 @@ static int set_chan(RIG *rig, channel_t *chan, xmlNodePtr node);
 int xml_load(RIG *my_rig, const char *infilename)
 {
 #ifdef HAVE_XML2
-    xmlDocPtr Doc;
-    xmlNodePtr node;
-
-    /* load xlm Doc */
-    Doc = xmlParseFile(infilename);
-
-    if (Doc == NULL)
+    /*
+     * Walk the file with a reader rather than building the whole tree:
+     * only the channel element being written to the rig is expanded,
+     * so memory stays flat however many channels the file holds.
+     */
+    xmlTextReaderPtr reader;
+    int in_channels = 0;
+    int seen_hamlib = 0;
+    int seen_channels = 0;
+    int status = RIG_OK;
+    int ret;
+
+    reader = xmlReaderForFile(infilename, NULL, 0);
+
+    if (reader == NULL)
     {
         fprintf(stderr, "xmlParse failed\n");
         exit(2);
     }
 
-    node = xmlDocGetRootElement(Doc);
-
-    if (node == NULL)
-    {
-        fprintf(stderr, "get root failed\n");
-        exit(2);
-    }
+    ret = xmlTextReaderRead(reader);
 
-    if (strcmp((char *) node->name, "hamlib"))
+    while (ret == 1)
     {
-        fprintf(stderr, "no hamlib tag found\n");
-        exit(2);
-    }
+        const char *name = (const char *) xmlTextReaderConstName(reader);
+        int depth = xmlTextReaderDepth(reader);
+        channel_t chan;
+        xmlNodePtr node;
 
-    for (node = node->xmlChildrenNode; node != NULL; node = node->next)
-    {
-        if (xmlNodeIsText(node))
+        if (xmlTextReaderNodeType(reader) != XML_READER_TYPE_ELEMENT)
         {
+            ret = xmlTextReaderRead(reader);
             continue;
         }
 
-        if (strcmp((char *) node->name, "channels") == 0)
+        if (depth == 0)
         {
-            break;
+            if (strcmp(name, "hamlib"))
+            {
+                fprintf(stderr, "no hamlib tag found\n");
+                exit(2);
+            }
+
+            seen_hamlib = 1;
+            ret = xmlTextReaderRead(reader);
+            continue;
         }
-    }
 
-    if (node == NULL)
-    {
-        fprintf(stderr, "no channels\n");
-        exit(2);
-    }
+        if (depth == 1)
+        {
+            in_channels = !strcmp(name, "channels");
 
-    for (node = node->xmlChildrenNode; node != NULL; node = node->next)
-    {
-        channel_t chan;
-        int status;
+            if (in_channels)
+            {
+                seen_channels = 1;
+                ret = xmlTextReaderRead(reader);
+                continue;
+            }
+
+            /* some other section, skip all of it */
+            ret = xmlTextReaderNext(reader);
+            continue;
+        }
 
-        if (xmlNodeIsText(node))
+        if (depth != 2 || !in_channels)
         {
+            ret = xmlTextReaderNext(reader);
             continue;
         }
 
+        node = xmlTextReaderExpand(reader);
+
+        if (node == NULL)
+        {
+            ret = -1;
+            break;
+        }
+
         set_chan(my_rig, &chan, node);
 
         status = rig_set_channel(my_rig, RIG_VFO_NONE, &chan);
@@ -102,13 +126,39 @@ int xml_load(RIG *my_rig, const char *infilename)
         if (status != RIG_OK)
         {
             printf("rig_get_channel: error = %s \n", rigerror(status));
-            return status;
+            break;
         }
+
+        /* past this element, which lets the reader drop it */
+        ret = xmlTextReaderNext(reader);
     }
 
-    xmlFreeDoc(Doc);
+    xmlFreeTextReader(reader);
     xmlCleanupParser();
 
+    if (status != RIG_OK)
+    {
+        return status;
+    }
+
+    if (ret < 0)
+    {
+        fprintf(stderr, "xmlParse failed\n");
+        exit(2);
+    }
+
+    if (!seen_hamlib)
+    {
+        fprintf(stderr, "get root failed\n");
+        exit(2);
+    }
+
+    if (!seen_channels)
+    {
+        fprintf(stderr, "no channels\n");
+        exit(2);
+    }
+
     return 0;
 #else
     return -RIG_ENAVAIL;
@@ -33,8 +33,19 @@
 #  include <libxml/parser.h>
 #  include <libxml/tree.h>
 
+/*
+ * Each channel element is written out and freed as soon as the backend
+ * delivers it, so a dump needs the same memory for 10 or 10000 channels
+ * and the file fills up while the radio is still being read.
+ */
+struct xml_save_s
+{
+    xmlDocPtr doc;
+    xmlNodePtr root;
+    FILE *f;
+};
+
 static int dump_xml_chan(RIG *rig,
-                         vfo_t vfo,
                          channel_t **chan,
                          int channel_num,
                          const chan_t *chan_list,
@@ -46,35 +57,40 @@ int xml_save(RIG *rig, const char *outfilename)
 {
 #ifdef HAVE_XML2
     int retval;
-    xmlDocPtr Doc;
-    xmlNodePtr root;
+    struct xml_save_s save;
 
-    /* create xlm Doc */
-    Doc = xmlNewDoc((unsigned char *) "1.0");
-    root = xmlNewNode(NULL, (unsigned char *) "hamlib");
-    xmlDocSetRootElement(Doc, root);
-    root = xmlNewChild(root, NULL, (unsigned char *) "channels", NULL);
+    save.f = fopen(outfilename, "w");
 
+    if (!save.f)
+    {
+        return -1;
+    }
+
+    /* only a scratch parent for the channel element being written */
+    save.doc = xmlNewDoc((unsigned char *) "1.0");
+    save.root = xmlNewNode(NULL, (unsigned char *) "channels");
+    xmlDocSetRootElement(save.doc, save.root);
+
+    fprintf(save.f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<hamlib>\n  <channels>\n");
 
     if (rig->caps->clone_combo_get)
         printf("About to save data, enter cloning mode: %s\n",
                rig->caps->clone_combo_get);
 
-    retval = rig_get_chan_all_cb(rig, RIG_VFO_NONE, dump_xml_chan, root);
+    retval = rig_get_chan_all_cb(rig, RIG_VFO_NONE, dump_xml_chan, &save);
 
-    if (retval != RIG_OK)
+    fprintf(save.f, "  </channels>\n</hamlib>\n");
+
+    if (fclose(save.f) != 0 && retval == RIG_OK)
     {
-        return retval;
+        retval = -RIG_EIO;
     }
 
-    /* write xml File */
-
-    xmlSaveFormatFileEnc(outfilename, Doc, "UTF-8", 1);
-
-    xmlFreeDoc(Doc);
+    xmlFreeDoc(save.doc);
     xmlCleanupParser();
 
-    return 0;
+    return retval;
 #else
     return -RIG_ENAVAIL;
 #endif
@@ -89,14 +105,14 @@ int xml_parm_save(RIG *rig, const char *outfilename)
 
 #ifdef HAVE_XML2
 int dump_xml_chan(RIG *rig,
-                  vfo_t vfo,
                   channel_t **chan_pp,
                   int chan_num,
                   const chan_t *chan_list,
                   rig_ptr_t arg)
 {
     char attrbuf[20];
-    xmlNodePtr root = arg;
+    struct xml_save_s *save = arg;
+    xmlNodePtr root = save->root;
     xmlNodePtr node = NULL;
     int i;
     const char *mtype;
@@ -287,6 +303,13 @@ int dump_xml_chan(RIG *rig,
         xmlNewProp(node, (unsigned char *) "flags", (unsigned char *) attrbuf);
     }
 
-    return 0;
+    fputs("    ", save->f);
+    xmlElemDump(save->f, save->doc, node);
+    fputs("\n", save->f);
+
+    xmlUnlinkNode(node);
+    xmlFreeNode(node);
+
+    return ferror(save->f) ? -RIG_EIO : RIG_OK;
 }
 #endif
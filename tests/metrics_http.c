@@ -0,0 +1,260 @@
+/*
+ * metrics_http.c - (C) The Hamlib Group 2026
+ *
+ * OpenMetrics scrape endpoint for the rotctld and ampctld daemons.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/*
+ * Prometheus scrapes every few seconds and one request at a time, so a
+ * thread taking one connection after the other is all it needs.  What is
+ * served comes from the library's caches, see rig_get_metrics(); a scrape
+ * never waits for the rotator or amplifier.  rigctld answers /metrics on
+ * its -H port instead.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+#include <sys/types.h>
+
+#ifdef HAVE_SYS_TIME_H
+#  include <sys/time.h>
+#endif
+#ifdef HAVE_NETINET_IN_H
+#  include <netinet/in.h>
+#endif
+#ifdef HAVE_SYS_SOCKET_H
+#  include <sys/socket.h>
+#endif
+#ifdef HAVE_NETDB_H
+#  include <netdb.h>
+#endif
+#ifdef HAVE_PTHREAD
+#  include <pthread.h>
+#endif
+
+#include <hamlib/rig.h>
+#include "metrics_http.h"
+
+#define METRICS_MAX_REQUEST 2048
+#define METRICS_MAX_REPLY 65536
+
+static int metrics_sock = -1;
+static metrics_render_t metrics_render;
+static void *metrics_handle;
+
+static int metrics_listen(const char *src_addr, const char *portno)
+{
+    struct addrinfo hints, *result, *rp;
+    int reuseaddr = 1;
+    int sock = -1;
+    int retcode;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    retcode = getaddrinfo(src_addr, portno, &hints, &result);
+
+    if (retcode != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: getaddrinfo: %s\n", __func__,
+                  gai_strerror(retcode));
+        return -1;
+    }
+
+    for (rp = result; rp; rp = rp->ai_next)
+    {
+        sock = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+
+        if (sock < 0)
+        {
+            continue;
+        }
+
+        setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char *)&reuseaddr,
+                   sizeof(reuseaddr));
+
+#ifdef IPV6_V6ONLY
+
+        if (AF_INET6 == rp->ai_family)
+        {
+            int sockopt = 0;
+
+            setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, (char *)&sockopt,
+                       sizeof(sockopt));
+        }
+
+#endif
+
+        if (bind(sock, rp->ai_addr, rp->ai_addrlen) == 0 && listen(sock, 4) == 0)
+        {
+            break;
+        }
+
+        close(sock);
+        sock = -1;
+    }
+
+    freeaddrinfo(result);
+
+    return sock;
+}
+
+static void metrics_reply(int sock, const char *status, const char *type,
+                          const char *body)
+{
+    char head[256];
+    size_t len = strlen(body);
+    int n;
+
+    n = snprintf(head, sizeof(head), "HTTP/1.1 %s\r\n"
+                 "Content-Type: %s\r\n"
+                 "Content-Length: %u\r\n"
+                 "Connection: close\r\n\r\n", status, type, (unsigned) len);
+
+    if (write(sock, head, n) != n || write(sock, body, len) != (ssize_t) len)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: write: %s\n", __func__, strerror(errno));
+    }
+}
+
+static void metrics_serve(int sock, char *reply)
+{
+    char req[METRICS_MAX_REQUEST];
+    char method[8], target[128];
+    size_t len = 0;
+    struct timeval timeout;
+
+    // a client that says nothing does not hold up the next scrape
+    timeout.tv_sec = 2;
+    timeout.tv_usec = 0;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (char *)&timeout, sizeof(timeout));
+
+    while (len < sizeof(req) - 1)
+    {
+        ssize_t n = read(sock, req + len, sizeof(req) - 1 - len);
+
+        if (n <= 0) { return; }
+
+        len += n;
+        req[len] = '\0';
+
+        if (strstr(req, "\r\n\r\n")) { break; }
+    }
+
+    if (sscanf(req, "%7s %127s", method, target) != 2)
+    {
+        metrics_reply(sock, "400 Bad Request", "text/plain", "400 Bad Request\n");
+    }
+    else if (strcmp(method, "GET") != 0)
+    {
+        metrics_reply(sock, "405 Method Not Allowed", "text/plain",
+                      "405 Method Not Allowed\n");
+    }
+    else if (strncmp(target, "/metrics", 8) != 0
+             || (target[8] != '\0' && target[8] != '?'))
+    {
+        metrics_reply(sock, "404 Not Found", "text/plain", "404 Not Found\n");
+    }
+    else if (metrics_render(metrics_handle, reply, METRICS_MAX_REPLY) != RIG_OK)
+    {
+        metrics_reply(sock, "500 Internal Server Error", "text/plain",
+                      "500 Internal Server Error\n");
+    }
+    else
+    {
+        metrics_reply(sock, "200 OK", METRICS_CONTENT_TYPE, reply);
+    }
+}
+
+static void *metrics_server(void *arg)
+{
+    char *reply = malloc(METRICS_MAX_REPLY);
+
+    if (!reply)
+    {
+        return NULL;
+    }
+
+    for (;;)
+    {
+        int sock = accept(metrics_sock, NULL, NULL);
+
+        if (sock < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED) { continue; }
+
+            rig_debug(RIG_DEBUG_ERR, "%s: accept: %s\n", __func__, strerror(errno));
+            break;
+        }
+
+        metrics_serve(sock, reply);
+        close(sock);
+    }
+
+    free(reply);
+
+    return NULL;
+}
+
+int metrics_http_start(const char *src_addr, const char *portno,
+                       metrics_render_t render, void *handle)
+{
+#ifdef HAVE_PTHREAD
+    pthread_t thread;
+
+    metrics_sock = metrics_listen(src_addr, portno);
+
+    if (metrics_sock < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: cannot listen on port %s\n", __func__, portno);
+        return -RIG_EIO;
+    }
+
+    metrics_render = render;
+    metrics_handle = handle;
+
+    if (pthread_create(&thread, NULL, metrics_server, NULL) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        return -RIG_EINTERNAL;
+    }
+
+    pthread_detach(thread);
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: serving metrics on port %s\n", __func__,
+              portno);
+
+    return RIG_OK;
+#else
+    (void) src_addr;
+    (void) portno;
+    (void) render;
+    (void) handle;
+    return -RIG_ENIMPL;
+#endif
+}
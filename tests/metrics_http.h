@@ -0,0 +1,39 @@
+/*
+ * metrics_http.h - (C) The Hamlib Group 2026
+ *
+ * OpenMetrics scrape endpoint for the rotctld and ampctld daemons.
+ *
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License along
+ *   with this program; if not, write to the Free Software Foundation, Inc.,
+ *   51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef METRICS_HTTP_H
+#define METRICS_HTTP_H
+
+#define METRICS_CONTENT_TYPE \
+    "application/openmetrics-text; version=1.0.0; charset=utf-8"
+
+/* rot_get_metrics() or amp_get_metrics() on the daemon's handle */
+typedef int (*metrics_render_t)(void *handle, char *buf, int len);
+
+/*
+ * Answer GET /metrics on src_addr:portno from a thread of its own, one
+ * scrape at a time.  RIG_OK, or -RIG_EIO if the port cannot be had.
+ */
+int metrics_http_start(const char *src_addr, const char *portno,
+                       metrics_render_t render, void *handle);
+
+#endif /* METRICS_HTTP_H */
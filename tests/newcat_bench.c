@@ -0,0 +1,101 @@
+/*
+ * Hamlib newcat_bench program
+ * Times the newcat get/set command path, run it against simulators/simft991:
+ *   ./simft991 &      (prints name=/dev/pts/N)
+ *   ./newcat_bench /dev/pts/N [loops]
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <hamlib/rig.h>
+#include <sys/time.h>
+
+#define LOOP_COUNT 1000
+
+
+int main(int argc, char *argv[])
+{
+    RIG *my_rig;
+    int retcode;
+    unsigned i;
+    struct timeval tv1, tv2;
+    float elapsed;
+    unsigned loops = argc > 2 ? atoi(argv[2]) : LOOP_COUNT;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s port [loops]\n", argv[0]);
+        return 1;
+    }
+
+    rig_set_debug(RIG_DEBUG_NONE);
+
+    my_rig = rig_init(RIG_MODEL_FT991);
+
+    if (!my_rig)
+    {
+        fprintf(stderr, "Unknown rig num: %u\n", RIG_MODEL_FT991);
+        return 1;
+    }
+
+    strncpy(my_rig->state.rigport.pathname, argv[1], HAMLIB_FILPATHLEN - 1);
+
+    retcode = rig_open(my_rig);
+
+    if (retcode != RIG_OK)
+    {
+        printf("rig_open: error = %s\n", rigerror(retcode));
+        return 2;
+    }
+
+    /* every call has to go down to the backend */
+    rig_set_cache_timeout_ms(my_rig, HAMLIB_CACHE_ALL, 0);
+
+    printf("Perform %u loops...\n", loops);
+
+    gettimeofday(&tv1, NULL);
+
+    for (i = 0; i < loops; i++)
+    {
+        freq_t freq;
+
+        retcode = rig_get_freq(my_rig, RIG_VFO_A, &freq);
+
+        if (retcode != RIG_OK)
+        {
+            printf("rig_get_freq: error = %s\n", rigerror(retcode));
+            return 1;
+        }
+    }
+
+    gettimeofday(&tv2, NULL);
+
+    elapsed = tv2.tv_sec - tv1.tv_sec + (tv2.tv_usec - tv1.tv_usec) / 1000000.0;
+    printf("get_freq: %.3fs, Avg: %.1f us/call\n", elapsed,
+           elapsed * 1e6 / loops);
+
+    gettimeofday(&tv1, NULL);
+
+    for (i = 0; i < loops; i++)
+    {
+        retcode = rig_set_freq(my_rig, RIG_VFO_A, 14074000 + (i % 10) * 100);
+
+        if (retcode != RIG_OK)
+        {
+            printf("rig_set_freq: error = %s\n", rigerror(retcode));
+            return 1;
+        }
+    }
+
+    gettimeofday(&tv2, NULL);
+
+    elapsed = tv2.tv_sec - tv1.tv_sec + (tv2.tv_usec - tv1.tv_usec) / 1000000.0;
+    printf("set_freq: %.3fs, Avg: %.1f us/call\n", elapsed,
+           elapsed * 1e6 / loops);
+
+    rig_close(my_rig);
+    rig_cleanup(my_rig);
+
+    return 0;
+}
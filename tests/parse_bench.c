@@ -0,0 +1,518 @@
+/*
+ * Hamlib parse_bench program
+ * Runs the backend reply parsers on recorded replies, no rig or port
+ * involved: Kenwood IF answers and AI streams, newcat replies, Icom
+ * scope data frames and the rigctld dump_state lists.
+ *
+ *   ./parse_bench -c
+ *       checks what the replies decode to, then feeds every prefix and
+ *       a few thousand mutations of them to the parsers (make check)
+ *   ./parse_bench [-s seconds] [-b baseline.json] [-t tolerance]
+ *       prints the throughput of each parser in MB/s as JSON; with a
+ *       baseline, a previous run of it, fails if a parser got slower
+ *       than tolerance (default 0.8) times its baseline
+ *
+ * Built with -DPARSE_FUZZER it is a libFuzzer target instead, the first
+ * byte of an input picks the parser, see "make fuzz-parse".
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <hamlib/rig.h>
+
+#include "kenwood/kenwood.h"
+#include "yaesu/newcat.h"
+#undef BACKEND_VER
+#include "icom/icom.h"
+#include "icom/icom_defs.h"
+#include "dummy/dummy.h"
+
+/* IC-7300: 475 points, 50 to a CI-V frame */
+static const struct icom_spectrum_scope_caps scope_caps =
+{
+    .spectrum_line_length = 475,
+    .single_frame_data_length = 50,
+    .data_level_min = 0,
+    .data_level_max = 160,
+    .signal_strength_min = -80,
+    .signal_strength_max = 0,
+};
+
+#define MAX_ITEMS 64
+#define ITEM_LEN 600
+
+enum parser
+{
+    P_KENWOOD_IF,
+    P_KENWOOD_AI,
+    P_NEWCAT,
+    P_ICOM_SCOPE,
+    P_NET_INT,
+    P_NET_DOUBLE,
+    P_COUNT
+};
+
+static const char *parser_names[P_COUNT] =
+{
+    "kenwood_if", "kenwood_ai", "newcat_reply", "icom_scope",
+    "netrigctl_int", "netrigctl_double"
+};
+
+struct item
+{
+    const char *cmd;    /* newcat: the command the reply is for */
+    unsigned char data[ITEM_LEN];
+    size_t len;
+};
+
+static struct item corpus[P_COUNT][MAX_ITEMS];
+static int corpus_count[P_COUNT];
+
+static struct item *add(enum parser p, const void *data, size_t len)
+{
+    struct item *it = &corpus[p][corpus_count[p]++];
+
+    memcpy(it->data, data, len);
+    it->len = len;
+
+    return it;
+}
+
+static void add_str(enum parser p, const char *cmd, const char *s)
+{
+    add(p, s, strlen(s))->cmd = cmd;
+}
+
+static void add_if(freq_t freq, int rit, int rit_on, int xit_on, int mem_ch,
+                   int ptt, char mode, char function, char split)
+{
+    char buf[64];
+
+    snprintf(buf, sizeof(buf), "IF%011.0f     %+05d%d%d%03d%d%c%c0%c000 ;",
+             freq, rit, rit_on, xit_on, mem_ch, ptt, mode, function, split);
+    add_str(P_KENWOOD_IF, NULL, buf);
+}
+
+/* one scope line as an IC-7300 sends it, a header frame and 10 data frames */
+static void add_scope_line(int id, int mode, freq_t f1, freq_t f2, int seed)
+{
+    unsigned char frame[ITEM_LEN];
+    int div, i;
+
+    frame[0] = id;
+    to_bcd(frame + 1, 1, 2);
+    to_bcd(frame + 2, 11, 2);
+    frame[3] = mode;
+    to_bcd(frame + 4, (unsigned long long) f1, 10);
+    to_bcd(frame + 9, (unsigned long long) f2, 10);
+    frame[14] = 0;
+    add(P_ICOM_SCOPE, frame, 15);
+
+    for (div = 2; div <= 11; div++)
+    {
+        int n = div < 11 ? 50 : 25;
+
+        to_bcd(frame + 1, div, 2);
+
+        for (i = 0; i < n; i++)
+        {
+            frame[3 + i] = (seed + i * 7 + div * 13) % 161;
+        }
+
+        add(P_ICOM_SCOPE, frame, 3 + n);
+    }
+}
+
+static void build_corpus(void)
+{
+    unsigned char frame[ITEM_LEN];
+    int i;
+
+    add_if(14074000, 0, 0, 0, 0, 0, '2', '0', '0');
+    add_if(7074000, -50, 1, 0, 5, 0, '1', '1', '1');
+    add_if(146520000, 120, 0, 1, 99, 1, '4', '2', '0');
+    add_if(3573000, 0, 0, 0, 12, 0, '9', '0', '1');
+
+    add_str(P_KENWOOD_AI, NULL, "FA00014074000;");
+    add_str(P_KENWOOD_AI, NULL, "FB00007074000;");
+    add_str(P_KENWOOD_AI, NULL, "MD2;");
+    add_str(P_KENWOOD_AI, NULL, "MD$3;");
+    add_str(P_KENWOOD_AI, NULL, "OM01;");
+    add_str(P_KENWOOD_AI, NULL, "TX0;");
+    add_str(P_KENWOOD_AI, NULL, "RX;");
+    add_str(P_KENWOOD_AI, NULL, (const char *) corpus[P_KENWOOD_IF][0].data);
+
+    add_str(P_NEWCAT, "FA;", "FA014074000;");
+    add_str(P_NEWCAT, "FB;", "FB007074000;");
+    add_str(P_NEWCAT, "MD0;", "MD02;");
+    add_str(P_NEWCAT, "IF;", "IF001014074000+000000200000;");
+    add_str(P_NEWCAT, "SM0;", "SM0012;");
+    add_str(P_NEWCAT, "RM1;", "RM1100000;");
+    add_str(P_NEWCAT, "FA;", "?;");
+    add_str(P_NEWCAT, "FA;", "N;");
+    add_str(P_NEWCAT, "FA;", "FB014074000;");
+    add_str(P_NEWCAT, "FA;", "FA0140740");
+
+    add_scope_line(0, SCOPE_MODE_CENTER, 14074000, 25000, 3);
+    add_scope_line(1, SCOPE_MODE_FIXED, 14000000, 14350000, 40);
+
+    /* rigs sending a whole line in one frame, over the LAN */
+    frame[0] = 0;
+    to_bcd(frame + 1, 1, 2);
+    to_bcd(frame + 2, 1, 2);
+    frame[3] = SCOPE_MODE_SCROLL_F;
+    to_bcd(frame + 4, 7000000, 10);
+    to_bcd(frame + 9, 7300000, 10);
+    frame[14] = 1;
+
+    for (i = 0; i < 475; i++) { frame[15 + i] = i % 161; }
+
+    add(P_ICOM_SCOPE, frame, 15 + 475);
+
+    add_str(P_NET_DOUBLE, NULL,
+            "67.0 69.3 71.9 74.4 77.0 79.7 82.5 85.4 88.5 91.5 94.8 97.4 100.0 "
+            "103.5 107.2 110.9 114.8 118.8 123.0 127.3 131.8 136.5 141.3 146.2 "
+            "151.4 156.7 162.2 167.9 173.8 179.9 186.2 192.8 203.5 210.7 218.1 "
+            "225.7 233.6 241.8 250.3\n");
+    add_str(P_NET_INT, NULL,
+            "23 25 26 31 32 36 43 47 51 53 54 65 71 72 73 74 114 115 116 122 "
+            "125 131 132 134 143 145 152 155 156 162 165 172 174 205 212 223 "
+            "225 226 243 244 245 246 251 252 255 261 263 265 266 271 274 306\n");
+}
+
+/* runs item it of parser p, returns RIG_OK or the parser's error */
+static int run(enum parser p, const unsigned char *data, size_t len,
+               const char *cmd)
+{
+    static unsigned char line[ITEM_LEN];
+    char buf[ITEM_LEN + 1];
+    struct kenwood_if_data ifd;
+    struct kenwood_report report;
+    struct icom_spectrum_frame f;
+    int ints[MAX_ITEMS];
+    double doubles[MAX_ITEMS];
+    int ret;
+
+    switch (p)
+    {
+    case P_KENWOOD_IF:
+        return kenwood_parse_if((const char *) data, len, kenwood_mode_table, &ifd);
+
+    case P_KENWOOD_AI:
+        return kenwood_parse_report((const char *) data, len, kenwood_mode_table,
+                                    &report);
+
+    case P_NEWCAT:
+        memcpy(buf, data, len);
+        buf[len] = '\0';
+        return newcat_parse_reply(cmd ? cmd : "FA;", buf);
+
+    case P_ICOM_SCOPE:
+        ret = icom_decode_spectrum_frame(&scope_caps, len, data, &f);
+
+        if (ret == RIG_OK && f.data_length > 0)
+        {
+            /* where icom_parse_spectrum_frame() would put it */
+            memcpy(line + f.offset, f.data, f.data_length);
+        }
+
+        return ret;
+
+    case P_NET_INT:
+        memcpy(buf, data, len);
+        buf[len] = '\0';
+        return parse_array_int(buf, " \n\r", ints, MAX_ITEMS) > 0 ? RIG_OK :
+               -RIG_EPROTO;
+
+    case P_NET_DOUBLE:
+        memcpy(buf, data, len);
+        buf[len] = '\0';
+        return parse_array_double(buf, " \n\r", doubles, MAX_ITEMS) > 0 ? RIG_OK :
+               -RIG_EPROTO;
+
+    default:
+        return -RIG_EINVAL;
+    }
+}
+
+#ifdef PARSE_FUZZER
+
+int LLVMFuzzerTestOneInput(const unsigned char *data, size_t size)
+{
+    if (size < 1 || size - 1 > ITEM_LEN)
+    {
+        return 0;
+    }
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    run(data[0] % P_COUNT, data + 1, size - 1, NULL);
+
+    return 0;
+}
+
+#else
+
+static int failures;
+
+#define CHECK(cond) \
+    do { if (!(cond)) { printf("%s:%d: %s\n", __FILE__, __LINE__, #cond); \
+            failures++; } } while (0)
+
+static void check_decodes(void)
+{
+    struct kenwood_if_data ifd;
+    struct kenwood_report r;
+    struct icom_spectrum_frame f;
+    int ints[MAX_ITEMS];
+    double doubles[MAX_ITEMS];
+    struct item *it;
+    int i;
+
+    it = &corpus[P_KENWOOD_IF][1];
+    CHECK(kenwood_parse_if((char *) it->data, it->len, kenwood_mode_table,
+                           &ifd) == RIG_OK);
+    CHECK(ifd.freq == 7074000);
+    CHECK(ifd.rit == -50 && ifd.rit_on && !ifd.xit_on);
+    CHECK(ifd.mem_ch == 5);
+    CHECK(ifd.ptt == RIG_PTT_OFF && ifd.mode == RIG_MODE_LSB);
+    CHECK(ifd.function == '1' && ifd.split == RIG_SPLIT_ON);
+
+    it = &corpus[P_KENWOOD_IF][2];
+    CHECK(kenwood_parse_if((char *) it->data, it->len, kenwood_mode_table,
+                           &ifd) == RIG_OK);
+    CHECK(ifd.freq == 146520000 && ifd.ptt == RIG_PTT_ON);
+    CHECK(ifd.mode == RIG_MODE_FM && ifd.xit_on && ifd.mem_ch == 99);
+
+    CHECK(kenwood_parse_if("IF00014074000;", 14, kenwood_mode_table,
+                           &ifd) == -RIG_EPROTO);
+
+    CHECK(kenwood_parse_report("FB00007074000;", 14, kenwood_mode_table,
+                               &r) == RIG_OK);
+    CHECK(r.have_freq && r.freq == 7074000 && r.freq_vfo == RIG_VFO_B);
+    CHECK(kenwood_parse_report("MD$3;", 5, kenwood_mode_table, &r) == RIG_OK);
+    CHECK(r.have_mode && r.mode == RIG_MODE_CW && r.mode_vfo == RIG_VFO_B);
+    CHECK(kenwood_parse_report("OM01;", 5, kenwood_mode_table, &r) == RIG_OK);
+    CHECK(r.mode == RIG_MODE_LSB && r.mode_vfo == RIG_VFO_MAIN);
+    CHECK(kenwood_parse_report("RX;", 3, kenwood_mode_table, &r) == RIG_OK);
+    CHECK(r.have_ptt && r.ptt == RIG_PTT_OFF && !r.have_freq);
+    it = &corpus[P_KENWOOD_IF][0];
+    CHECK(kenwood_parse_report((char *) it->data, it->len, kenwood_mode_table,
+                               &r) == RIG_OK);
+    CHECK(r.freq == 14074000 && r.freq_vfo == RIG_VFO_A && r.mode == RIG_MODE_USB);
+    CHECK(kenwood_parse_report("FAx;", 4, kenwood_mode_table, &r) == -RIG_EPROTO);
+
+    CHECK(newcat_parse_reply("FA;", "FA014074000;") == RIG_OK);
+    CHECK(newcat_parse_reply("FA;", "?;") == -RIG_ERJCTED);
+    CHECK(newcat_parse_reply("FA;", "N;") == -RIG_ENAVAIL);
+    CHECK(newcat_parse_reply("FA;", "E;") == -RIG_EIO);
+    CHECK(newcat_parse_reply("FA;", "FB014074000;") == -RIG_EPROTO);
+    CHECK(newcat_parse_reply("FA;", "FA0140740") == -RIG_EPROTO);
+    CHECK(newcat_parse_reply("FA;", "") == -RIG_EPROTO);
+
+    it = &corpus[P_ICOM_SCOPE][0];
+    CHECK(icom_decode_spectrum_frame(&scope_caps, it->len, it->data,
+                                     &f) == RIG_OK);
+    CHECK(f.id == 0 && f.division == 1 && f.max_division == 11);
+    CHECK(f.mode == RIG_SPECTRUM_MODE_CENTER && f.center_freq == 14074000);
+    CHECK(f.span_freq == 50000 && f.low_edge_freq == 14049000);
+    CHECK(f.data_length == 0);
+
+    it = &corpus[P_ICOM_SCOPE][10];
+    CHECK(icom_decode_spectrum_frame(&scope_caps, it->len, it->data,
+                                     &f) == RIG_OK);
+    CHECK(f.division == 11 && f.offset == 450 && f.data_length == 25);
+
+    it = &corpus[P_ICOM_SCOPE][11];
+    CHECK(icom_decode_spectrum_frame(&scope_caps, it->len, it->data,
+                                     &f) == RIG_OK);
+    CHECK(f.id == 1 && f.mode == RIG_SPECTRUM_MODE_FIXED);
+    CHECK(f.span_freq == 350000 && f.center_freq == 14175000);
+
+    it = &corpus[P_ICOM_SCOPE][corpus_count[P_ICOM_SCOPE] - 1];
+    CHECK(icom_decode_spectrum_frame(&scope_caps, it->len, it->data,
+                                     &f) == RIG_OK);
+    CHECK(f.mode == RIG_SPECTRUM_MODE_FIXED_SCROLL && f.out_of_range == 1);
+    CHECK(f.offset == 0 && f.data_length == 475 && f.data[474] == 474 % 161);
+
+    /* data past the end of the line, and a data frame numbered 0 */
+    it = &corpus[P_ICOM_SCOPE][5];
+    it->data[1] = 0x12;
+    it->data[2] = 0x12;
+    CHECK(icom_decode_spectrum_frame(&scope_caps, it->len, it->data,
+                                     &f) == -RIG_EPROTO);
+    it->data[1] = 0x00;
+    CHECK(icom_decode_spectrum_frame(&scope_caps, it->len, it->data,
+                                     &f) == -RIG_EPROTO);
+    to_bcd(it->data + 1, 6, 2);
+    to_bcd(it->data + 2, 11, 2);
+
+    CHECK(parse_array_int((char *) corpus[P_NET_INT][0].data, " \n\r", ints,
+                          MAX_ITEMS) == 52);
+    CHECK(ints[0] == 23 && ints[51] == 306);
+    CHECK(parse_array_int("1 2 3 4 5", " ", ints, 3) == 3 && ints[2] == 3);
+    CHECK(parse_array_int("  \n", " \n", ints, 3) == 0);
+    CHECK(parse_array_double((char *) corpus[P_NET_DOUBLE][0].data, " \n\r",
+                             doubles, MAX_ITEMS) == 39);
+    CHECK(doubles[0] == 67.0 && doubles[38] == 250.3);
+
+    for (i = 0; i < P_COUNT; i++)
+    {
+        CHECK(corpus_count[i] > 0);
+    }
+}
+
+/* every prefix of every reply, then random byte changes, must not crash */
+static void check_robustness(void)
+{
+    unsigned long rnd = 1;
+    unsigned char buf[ITEM_LEN];
+    int p, i, n;
+    size_t len;
+
+    for (p = 0; p < P_COUNT; p++)
+    {
+        for (i = 0; i < corpus_count[p]; i++)
+        {
+            const struct item *it = &corpus[p][i];
+
+            for (len = 0; len <= it->len; len++)
+            {
+                run(p, it->data, len, it->cmd);
+            }
+
+            for (n = 0; n < 500; n++)
+            {
+                int changes = 1 + n % 4;
+
+                memcpy(buf, it->data, it->len);
+
+                while (changes--)
+                {
+                    rnd = rnd * 1103515245 + 12345;
+                    buf[(rnd >> 8) % it->len] = rnd >> 20;
+                }
+
+                run(p, buf, it->len, it->cmd);
+            }
+        }
+    }
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double bench(enum parser p, double seconds)
+{
+    double start = now(), elapsed;
+    size_t bytes = 0;
+    int i;
+
+    do
+    {
+        int loop;
+
+        for (loop = 0; loop < 64; loop++)
+        {
+            for (i = 0; i < corpus_count[p]; i++)
+            {
+                run(p, corpus[p][i].data, corpus[p][i].len, corpus[p][i].cmd);
+                bytes += corpus[p][i].len;
+            }
+        }
+
+        elapsed = now() - start;
+    }
+    while (elapsed < seconds);
+
+    return bytes / elapsed / 1e6;
+}
+
+static double baseline_of(const char *file, const char *name)
+{
+    FILE *f = fopen(file, "r");
+    char line[256], parser[32];
+    double mb_s, found = 0;
+
+    if (!f)
+    {
+        return 0;
+    }
+
+    while (fgets(line, sizeof(line), f))
+    {
+        if (sscanf(line, " {\"parser\": \"%31[^\"]\", \"mb_s\": %lf", parser,
+                   &mb_s) == 2 && !strcmp(parser, name))
+        {
+            found = mb_s;
+        }
+    }
+
+    fclose(f);
+
+    return found;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *baseline = NULL;
+    double seconds = 0.5, tolerance = 0.8;
+    int check = 0, slower = 0;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "-c")) { check = 1; }
+        else if (!strcmp(argv[i], "-s") && i + 1 < argc) { seconds = atof(argv[++i]); }
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) { baseline = argv[++i]; }
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) { tolerance = atof(argv[++i]); }
+        else
+        {
+            fprintf(stderr, "Usage: %s [-c] [-s seconds] [-b baseline.json] "
+                    "[-t tolerance]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    rig_set_debug(RIG_DEBUG_NONE);
+    build_corpus();
+
+    if (check)
+    {
+        check_decodes();
+        check_robustness();
+        printf("%s\n", failures ? "FAILED" : "OK");
+        return failures ? 1 : 0;
+    }
+
+    printf("{\"parsers\": [\n");
+
+    for (i = 0; i < P_COUNT; i++)
+    {
+        double mb_s = bench(i, seconds / P_COUNT);
+        double base = baseline ? baseline_of(baseline, parser_names[i]) : 0;
+
+        printf("  {\"parser\": \"%s\", \"mb_s\": %.2f}%s\n", parser_names[i], mb_s,
+               i + 1 < P_COUNT ? "," : "");
+
+        if (base > 0 && mb_s < base * tolerance)
+        {
+            fprintf(stderr, "%s: %.2f MB/s, baseline %.2f MB/s\n", parser_names[i],
+                    mb_s, base);
+            slower++;
+        }
+    }
+
+    printf("]}\n");
+
+    return slower ? 2 : 0;
+}
+
+#endif /* PARSE_FUZZER */
@@ -82,9 +82,8 @@ static void usage(void);
  * Reminder: when adding long options,
  *      keep up to date SHORT_OPTIONS, usage()'s output and man page. thanks.
  * NB: do NOT use -W since it's reserved by POSIX.
- * TODO: add an option to read from a file
  */
-#define SHORT_OPTIONS "+m:r:p:d:P:D:s:c:t:lC:LuonvhVYZ!"
+#define SHORT_OPTIONS "+m:r:p:d:P:D:s:c:t:b:lUC:LuonvhVYZ!"
 static struct option long_options[] =
 {
     {"model",           1, 0, 'm'},
@@ -96,7 +95,9 @@ static struct option long_options[] =
     {"serial-speed",    1, 0, 's'},
     {"civaddr",         1, 0, 'c'},
     {"send-cmd-term",   1, 0, 't'},
+    {"batch",           1, 0, 'b'},
     {"list",            0, 0, 'l'},
+    {"list-usb",        0, 0, 'U'},
     {"set-conf",        1, 0, 'C'},
     {"show-conf",       0, 0, 'L'},
     {"dump-caps",       0, 0, 'u'},
@@ -151,6 +152,7 @@ int main(int argc, char *argv[])
     int prompt = 1;         /* Print prompt in rigctl */
     int vfo_opt = 0;       /* vfo_opt = 0 means target VFO is 'currVFO' */
     char send_cmd_term = '\r';  /* send_cmd termination char */
+    const char *batch_file = NULL;
     int ext_resp = 0;
     int i;
     char rigstartup[1024];
@@ -352,6 +354,20 @@ int main(int argc, char *argv[])
 
             break;
 
+        case 'b':
+            if (!optarg)
+            {
+                usage();    /* wrong arg count */
+                exit(1);
+            }
+
+#ifndef RIGCTL_PARSE_BUF
+            fprintf(stderr, "Batch mode is not available on this platform\n");
+            exit(1);
+#endif
+            batch_file = optarg;
+            break;
+
         case 's':
             if (!optarg)
             {
@@ -420,6 +436,11 @@ int main(int argc, char *argv[])
             list_models();
             exit(0);
 
+        case 'U':
+            rig_set_debug(verbose);
+            list_usb();
+            exit(0);
+
         case 'u':
             dump_caps_opt++;
             break;
@@ -539,7 +560,7 @@ int main(int argc, char *argv[])
     {
 
         // if rigctld then we need to open to get the rig caps
-        if (my_model == RIG_MODEL_NETRIGCTL)
+        if (RIG_MODEL_IS_NETRIGCTL(my_model))
         {
             int ret;
             rig_set_debug(verbose);
@@ -576,7 +597,7 @@ int main(int argc, char *argv[])
                my_rig->caps->model_name);
     }
 
-    if (my_rig->caps->rig_model == RIG_MODEL_NETRIGCTL)
+    if (RIG_MODEL_IS_NETRIGCTL(my_rig->caps->rig_model))
     {
         /* We automatically detect if we need to be in vfo mode or not */
         int rigctld_vfo_opt = netrigctl_get_vfo_mode(my_rig);
@@ -591,6 +612,31 @@ int main(int argc, char *argv[])
 
     exitcode = 0;
 
+#ifdef RIGCTL_PARSE_BUF
+
+    if (batch_file)
+    {
+        FILE *fin = strcmp(batch_file, "-") ? fopen(batch_file, "r") : stdin;
+
+        if (!fin)
+        {
+            fprintf(stderr, "%s: %s\n", batch_file, strerror(errno));
+            exitcode = 1;
+        }
+        else
+        {
+            exitcode = rigctl_batch(my_rig, fin, stdout, &vfo_opt, send_cmd_term) ? 1 : 0;
+
+            if (fin != stdin) { fclose(fin); }
+        }
+
+        rig_close(my_rig);
+        rig_cleanup(my_rig);
+
+        return exitcode;
+    }
+
+#endif
 #ifdef HAVE_LIBREADLINE
 
     if (interactive && prompt)
@@ -718,9 +764,11 @@ void usage(void)
         "  -s, --serial-speed=BAUD       set serial speed of the serial port\n"
         "  -c, --civaddr=ID              set CI-V address, decimal (for Icom rigs only)\n"
         "  -t, --send-cmd-term=CHAR      set send_cmd command termination char\n"
+        "  -b, --batch=FILE              run the commands in FILE (- for stdin) as a batch\n"
         "  -C, --set-conf=PARM=VAL       set config parameters\n"
         "  -L, --show-conf               list all config parameters\n"
         "  -l, --list                    list all model numbers and exit\n"
+        "  -U, --list-usb                list USB serial ports and the rigs they name, and exit\n"
         "  -u, --dump-caps               dump capabilities and exit\n"
         "  -o, --vfo                     do not default to VFO_CURR, require extra vfo arg\n"
         "  -n, --no-restore-ai           do not restore auto information mode on rig\n"
@@ -33,6 +33,7 @@
 #include <unistd.h>
 #include <ctype.h>
 #include <errno.h>
+#include <time.h>
 
 // If true adds some debug statements to see flow of rigctl parsing
 int debugflow = 0;
@@ -62,11 +63,21 @@ extern int read_history();
 /* no history */
 #endif                              /* HAVE_READLINE_HISTORY */
 
+#ifdef HAVE_PTHREAD
+#  include <pthread.h>
+#endif
+
+#if defined(HAVE_PTHREAD) && defined(HAVE_OPEN_MEMSTREAM)
+#  define RIGCTL_SINGLEFLIGHT 1
+#endif
+
 
 #include <hamlib/rig.h>
+#include <hamlib/rig_journal.h>
 #include "misc.h"
 #include "iofunc.h"
 #include "sprintflst.h"
+#include "cache.h"
 
 #include "rigctl_parse.h"
 
@@ -178,6 +189,7 @@ declare_proto_rig(get_mode_bandwidths);
 declare_proto_rig(set_vfo);
 declare_proto_rig(get_vfo);
 declare_proto_rig(get_rig_info);
+declare_proto_rig(wait_rig_info);
 declare_proto_rig(get_vfo_info);
 declare_proto_rig(get_vfo_list);
 declare_proto_rig(set_ptt);
@@ -256,6 +268,14 @@ declare_proto_rig(set_separator);
 declare_proto_rig(get_separator);
 declare_proto_rig(set_lock_mode);
 declare_proto_rig(get_lock_mode);
+declare_proto_rig(get_stats);
+declare_proto_rig(reset_stats);
+declare_proto_rig(subscribe);
+declare_proto_rig(get_spectrum_history);
+declare_proto_rig(set_doppler);
+declare_proto_rig(add_doppler);
+declare_proto_rig(dump_state_hash);
+declare_proto_rig(get_journal);
 
 
 /*
@@ -368,29 +388,483 @@ static struct test_table test_list[] =
     { 0xa1, "get_separator",     ACTION(get_separator), ARG_NOVFO, "Separator" },
     { 0xa2, "set_lock_mode",     ACTION(set_lock_mode), ARG_IN | ARG_NOVFO, "Locked" },
     { 0xa3, "get_lock_mode",     ACTION(get_lock_mode), ARG_NOVFO, "Locked" },
+    { 0xa4, "get_stats",         ACTION(get_stats),     ARG_NOVFO },
+    { 0xa5, "reset_stats",       ACTION(reset_stats),   ARG_NOVFO },
+    { 0xa6, "subscribe",         ACTION(subscribe),     ARG_IN | ARG_NOVFO, "Events" },
+    { 0xa7, "get_spectrum_history", ACTION(get_spectrum_history), ARG_IN | ARG_NOVFO, "Scope ID", "Age ms" },
+    { 0xa8, "set_doppler",       ACTION(set_doppler),   ARG_IN | ARG_NOVFO, "Downlink", "Uplink" },
+    { 0xa9, "add_doppler",       ACTION(add_doppler),   ARG_IN | ARG_NOVFO, "Time", "Range rate" },
+    { 0xaa, "dump_state_hash",   ACTION(dump_state_hash), ARG_OUT | ARG_NOVFO, "Hash" },
+    { 0xab, "wait_rig_info",     ACTION(wait_rig_info), ARG_IN | ARG_NOVFO, "Generation", "Timeout ms" },
+    { 0xac, "get_journal",       ACTION(get_journal),   ARG_IN | ARG_NOVFO, "Since ms", "Until ms" },
     { 0x00, "", NULL },
 };
 
 
-static struct test_table *find_cmd_entry(int cmd)
+/*
+ * Command dispatch: a direct index on the command byte and an open
+ * addressing hash on the long names, both filled from test_list[] on first
+ * use so they cannot drift from it.  First entry wins, as with the old scan.
+ */
+#define CMD_HASH_SIZE 512   /* power of two, over twice the number of names */
+
+static struct test_table *cmd_index[256];
+static struct test_table *cmd_hash[CMD_HASH_SIZE];
+
+static unsigned int cmd_name_hash(const char *name)
+{
+    unsigned int h = 2166136261u;   /* FNV-1a */
+    int i;
+
+    for (i = 0; i < MAXNAMSIZ && name[i]; i++)
+    {
+        h = (h ^ (unsigned char)name[i]) * 16777619u;
+    }
+
+    return h;
+}
+
+static void cmd_index_build(void)
 {
     int i;
 
     for (i = 0; test_list[i].cmd != 0x00; i++)
     {
-        if (test_list[i].cmd == cmd)
+        struct test_table *entry = &test_list[i];
+        unsigned int h = cmd_name_hash(entry->name);
+
+        if (!cmd_index[entry->cmd])
         {
-            break;
+            cmd_index[entry->cmd] = entry;
+        }
+
+        while (cmd_hash[h & (CMD_HASH_SIZE - 1)]
+                && strncmp(cmd_hash[h & (CMD_HASH_SIZE - 1)]->name, entry->name,
+                           MAXNAMSIZ))
+        {
+            h++;
+        }
+
+        if (!cmd_hash[h & (CMD_HASH_SIZE - 1)])
+        {
+            cmd_hash[h & (CMD_HASH_SIZE - 1)] = entry;
         }
     }
+}
+
+static void cmd_index_init(void)
+{
+#ifdef HAVE_PTHREAD
+    static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+    pthread_once(&once, cmd_index_build);
+#else
+    static int built;
+
+    if (!built)
+    {
+        cmd_index_build();
+        built = 1;
+    }
+
+#endif
+}
 
-    if (test_list[i].cmd == 0x00)
+static struct test_table *find_cmd_entry(int cmd)
+{
+    cmd_index_init();
+
+    if (cmd <= 0 || cmd > 0xff)
     {
         return NULL;
     }
 
-    return &test_list[i];
+    return cmd_index[cmd];
+}
+
+
+/*
+ * A value and its separator in one write, the digits from num_fmt_int()
+ * and num_fmt_float() rather than printf.
+ */
+static void print_int(FILE *fout, int64_t val, char sep)
+{
+    char buf[24];
+    int len = num_fmt_int(buf, val);
+
+    buf[len++] = sep;
+    fwrite(buf, 1, len, fout);
+}
+
+static void print_float(FILE *fout, double val, char sep)
+{
+    char buf[40];
+    int len = num_fmt_float(buf, val);
+
+    buf[len++] = sep;
+    fwrite(buf, 1, len, fout);
+}
+
+
+/*
+ * rigctld fast path for the getters pollers hammer: if the cache can answer
+ * right now, print exactly what get_freq/get_mode/get_vfo/get_ptt/
+ * get_split_vfo would have and return 1, all without the rig lock.
+ * Returns 0 when the command has to go to the rig.
+ */
+static int rigctl_cache_answer(RIG *rig, FILE *fout,
+                               const struct test_table *cmd, vfo_t vfo,
+                               int vfo_opt, int *ext_resp_ptr,
+                               char *resp_sep_ptr)
+{
+    struct rig_cache_snapshot snap;
+    char sep = *resp_sep_ptr;
+    int ext = *ext_resp_ptr;
+
+    switch (cmd->cmd)
+    {
+    case 'f':
+    case 'm':
+    case 'v':
+    case 't':
+    case 's':
+        break;
+
+    default:
+        return 0;
+    }
+
+    rig_cache_snapshot(rig, vfo, &snap);
+
+    if ((cmd->cmd == 'f' && !snap.freq_ok) || (cmd->cmd == 'm' && !snap.mode_ok)
+            || (cmd->cmd == 'v' && !snap.vfo_ok) || (cmd->cmd == 't' && !snap.ptt_ok)
+            || (cmd->cmd == 's' && !snap.split_ok))
+    {
+        return 0;
+    }
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: '%c' answered from cache\n", __func__,
+              cmd->cmd);
+
+    if (ext)
+    {
+        fprintf(fout, "%s:%s%s%c", cmd->name, vfo_opt ? " " : "",
+                vfo_opt ? rig_strvfo(vfo) : "", sep);
+    }
+
+    switch (cmd->cmd)
+    {
+    case 'f':
+        if (ext) { fprintf(fout, "%s: ", cmd->arg1); }
+
+        print_int(fout, (int64_t)snap.freq, sep);
+        break;
+
+    case 'm':
+        if (ext) { fprintf(fout, "%s: ", cmd->arg1); }
+
+        fprintf(fout, "%s%c", rig_strrmode(snap.mode), sep);
+
+        if (ext) { fprintf(fout, "%s: ", cmd->arg2); }
+
+        print_int(fout, snap.width, sep);
+        break;
+
+    case 'v':
+        if (ext) { fprintf(fout, "%s: ", cmd->arg1); }
+
+        fprintf(fout, "%s%c", rig_strvfo(snap.vfo), sep);
+        break;
+
+    case 't':
+        if (ext) { fprintf(fout, "%s: ", cmd->arg1); }
+
+        print_int(fout, snap.ptt, sep);
+        break;
+
+    case 's':
+        if (ext) { fprintf(fout, "%s: ", cmd->arg1); }
+
+        print_int(fout, snap.split, sep);
+
+        if (ext) { fprintf(fout, "%s: ", cmd->arg2); }
+
+        fprintf(fout, "%s%c", rig_strvfo(snap.tx_vfo), sep);
+        break;
+    }
+
+    if (ext)
+    {
+        fprintf(fout, NETRIGCTL_RET "0\n");
+        *ext_resp_ptr = 0;
+        *resp_sep_ptr = '\n';
+    }
+
+    fflush(fout);
+
+    return 1;
+}
+
+
+static rigctl_pending_cb_t pl_pending;
+static rigctl_defer_cb_t pl_defer;
+
+void rigctl_set_pipeline(rigctl_pending_cb_t pending, rigctl_defer_cb_t defer)
+{
+    pl_pending = pending;
+    pl_defer = defer;
+}
+
+/*
+ * Called with fin just past a leading '#'.  Reads "<digits> " into tag and
+ * returns 1, otherwise returns 0 and leaves the rest to the comment code.
+ */
+static int rigctl_scan_tag(FILE *fin, char *tag, size_t tagsz)
+{
+    size_t n = 0;
+    int c;
+
+    while ((c = fgetc(fin)) != EOF && isdigit(c) && n < tagsz - 1)
+    {
+        tag[n++] = c;
+    }
+
+    tag[n] = '\0';
+
+    if (n > 0 && c == ' ')
+    {
+        return 1;
+    }
+
+    if (c != EOF) { ungetc(c, fin); }
+
+    tag[0] = '\0';
+    return 0;
+}
+
+/*
+ * rigctld pipelining, see rigctl_set_pipeline().  Returns 1 if the command
+ * has been answered or deferred, 0 if the caller runs it now as usual.
+ */
+static int rigctl_pipelined(RIG *rig, FILE *fout,
+                            const struct test_table *cmd, const char *tag,
+                            vfo_t vfo, int vfo_opt, const char *p1,
+                            const char *p2, const char *p3,
+                            int *ext_resp_ptr, char *resp_sep_ptr,
+                            int use_password)
+{
+    int setter = strncmp(cmd->name, "get_", 4) != 0;
+    int queued = pl_pending ? pl_pending(fout, 0) : 0;
+    char line[3 * MAXARGSZ + MAXNAMSIZ + 32];
+    char prefix[2] = "";
+
+    if (!tag[0] && !queued)
+    {
+        return 0;
+    }
+
+#if defined(HAVE_OPEN_MEMSTREAM) && defined(HAVE_FLOCKFILE)
+
+    // a tagged cache hit may overtake queued reads, never a queued set
+    if (tag[0] && !setter && rig->state.comm_state
+            && !(use_password && !is_passwordOK)
+            && !(queued && pl_pending(fout, 1)))
+    {
+        char *buf = NULL;
+        size_t len = 0;
+        FILE *capture = open_memstream(&buf, &len);
+
+        if (capture)
+        {
+            int hit = rigctl_cache_answer(rig, capture, cmd, vfo, vfo_opt,
+                                          ext_resp_ptr, resp_sep_ptr);
+            fclose(capture);
+
+            if (hit)
+            {
+                flockfile(fout);
+                fprintf(fout, "#%s ", tag);
+                fwrite(buf, 1, len, fout);
+                fflush(fout);
+                funlockfile(fout);
+            }
+
+            free(buf);
+
+            if (hit)
+            {
+                return 1;
+            }
+        }
+    }
+
+#endif
+
+    if (pl_defer)
+    {
+        if (*ext_resp_ptr)
+        {
+            prefix[0] = *resp_sep_ptr != '\n' ? *resp_sep_ptr : '+';
+        }
+
+        SNPRINTF(line, sizeof(line), "%s\\%s%s%s%s%s%s%s%s%s\n", prefix,
+                 cmd->name, vfo_opt ? " " : "", vfo_opt ? rig_strvfo(vfo) : "",
+                 p1 && p1[0] != ' ' ? " " : "", p1 ? p1 : "",
+                 p2 ? " " : "", p2 ? p2 : "", p3 ? " " : "", p3 ? p3 : "");
+
+        if (pl_defer(fout, tag, line, setter))
+        {
+            // the deferred line carries its own response format
+            *ext_resp_ptr = 0;
+            *resp_sep_ptr = '\n';
+            return 1;
+        }
+    }
+
+    // nobody to hand it to, answer in order
+    if (tag[0])
+    {
+        fprintf(fout, "#%s ", tag);
+    }
+
+    return 0;
+}
+
+
+#ifdef RIGCTL_SINGLEFLIGHT
+/*
+ * Single-flight for rigctld: when several clients send the same get_
+ * command while one copy is already waiting on the rig, the later ones
+ * wait for it and replay its output instead of running it again.  The
+ * first caller (leader) captures its reply in a memstream for that.
+ */
+#define SF_MAX_CALLS 16
+
+struct sf_call
+{
+    char key[3 * MAXARGSZ + 64];
+    int in_flight;          /* leader still running */
+    int waiters;
+    int retcode;
+    char *out;              /* leader's reply */
+    size_t outlen;
+    pthread_cond_t done;
+};
+
+static struct sf_call *sf_calls[SF_MAX_CALLS];
+static pthread_mutex_t sf_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void sf_release(struct sf_call *call)
+{
+    int i;
+
+    for (i = 0; i < SF_MAX_CALLS; i++)
+    {
+        if (sf_calls[i] == call) { sf_calls[i] = NULL; }
+    }
+
+    pthread_cond_destroy(&call->done);
+    free(call->out);
+    free(call);
+}
+
+/*
+ * Returns 1 if an identical call was in flight and its reply has been
+ * written to fout, with *retcode set.  Otherwise returns 0 and sets *leader
+ * to the entry this caller must finish with sf_end(), or NULL if the table
+ * is full and the command simply runs on its own.
+ */
+static int sf_begin(const char *key, FILE *fout, struct sf_call **leader,
+                    int *retcode)
+{
+    struct sf_call *call = NULL;
+    int i, free_slot = -1;
+
+    *leader = NULL;
+
+    pthread_mutex_lock(&sf_lock);
+
+    for (i = 0; i < SF_MAX_CALLS; i++)
+    {
+        if (!sf_calls[i])
+        {
+            if (free_slot < 0) { free_slot = i; }
+        }
+        else if (sf_calls[i]->in_flight && !strcmp(sf_calls[i]->key, key))
+        {
+            call = sf_calls[i];
+            break;
+        }
+    }
+
+    if (call)
+    {
+        call->waiters++;
+
+        while (call->in_flight)
+        {
+            pthread_cond_wait(&call->done, &sf_lock);
+        }
+
+        *retcode = call->retcode;
+        fwrite(call->out, 1, call->outlen, fout);
+        fflush(fout);
+
+        if (--call->waiters == 0) { sf_release(call); }
+
+        pthread_mutex_unlock(&sf_lock);
+        rig_debug(RIG_DEBUG_TRACE, "%s: shared reply for '%s'\n", __func__, key);
+        return 1;
+    }
+
+    if (free_slot >= 0 && (call = calloc(1, sizeof(struct sf_call))))
+    {
+        SNPRINTF(call->key, sizeof(call->key), "%s", key);
+        call->in_flight = 1;
+        pthread_cond_init(&call->done, NULL);
+        sf_calls[free_slot] = call;
+        *leader = call;
+    }
+
+    pthread_mutex_unlock(&sf_lock);
+    return 0;
+}
+
+/* publish the leader's reply, out is handed over to the entry */
+static void sf_end(struct sf_call *call, char *out, size_t outlen, int retcode)
+{
+    pthread_mutex_lock(&sf_lock);
+
+    call->out = out;
+    call->outlen = out ? outlen : 0;
+    call->retcode = retcode;
+    call->in_flight = 0;
+
+    if (call->waiters == 0)
+    {
+        sf_release(call);
+    }
+    else
+    {
+        pthread_cond_broadcast(&call->done);
+    }
+
+    pthread_mutex_unlock(&sf_lock);
+}
+
+/* leader done: send the captured reply on and share it, returns the real fout */
+static FILE *sf_finish(struct sf_call *call, FILE *capture, FILE *fout,
+                       char **buf, size_t *len, int retcode)
+{
+    fclose(capture);
+    fwrite(*buf, 1, *len, fout);
+    fflush(fout);
+    sf_end(call, *buf, *len, retcode);
+    *buf = NULL;
+
+    return fout;
 }
+#endif
 
 
 /* Structure for hash table provided by uthash.h
@@ -504,20 +978,50 @@ static void rp_getline(const char *s)
  */
 static char parse_arg(const char *arg)
 {
-    int i;
+    unsigned int h = cmd_name_hash(arg);
+    struct test_table *entry;
 
-    for (i = 0; test_list[i].cmd != 0x00; i++)
+    cmd_index_init();
+
+    while ((entry = cmd_hash[h & (CMD_HASH_SIZE - 1)]) != NULL)
     {
-        if (!strncmp(arg, test_list[i].name, MAXNAMSIZ))
+        if (!strncmp(arg, entry->name, MAXNAMSIZ))
         {
-            return test_list[i].cmd;
+            return entry->cmd;
         }
+
+        h++;
     }
 
     return 0;
 }
 
 
+int rigctl_cmd_lookup(const char *name)
+{
+    struct test_table *entry;
+
+    if (name[0] && !name[1])
+    {
+        entry = find_cmd_entry((unsigned char)name[0]);
+    }
+    else
+    {
+        entry = find_cmd_entry((unsigned char)parse_arg(name));
+    }
+
+    return entry ? entry->cmd : 0;
+}
+
+
+const char *rigctl_cmd_name(int cmd)
+{
+    struct test_table *entry = find_cmd_entry(cmd);
+
+    return entry ? entry->name : NULL;
+}
+
+
 /*
  * This scanf works even in presence of signals (timer, SIGIO, ..)
  */
@@ -656,22 +1160,325 @@ static int next_word(char *buffer, int argc, char *argv[], int newline)
     })
 
 
-int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
-                 sync_cb_t sync_cb,
-                 int interactive, int prompt, int *vfo_opt, char send_cmd_term,
-                 int *ext_resp_ptr, char *resp_sep_ptr, int use_password)
-{
-    int retcode;        /* generic return code from functions */
-    unsigned char cmd;
-    struct test_table *cmd_entry = NULL;
+/* sync_cb of the command running on this thread, for commands that sleep */
+#if defined(HAVE_PTHREAD) && defined(__GNUC__)
+static __thread sync_cb_t cmd_sync_cb;
+#else
+static sync_cb_t cmd_sync_cb;
+#endif
 
-    char command[MAXARGSZ + 1];
-    char arg1[MAXARGSZ + 1], *p1 = NULL;
-    char arg2[MAXARGSZ + 1], *p2 = NULL;
-    char arg3[MAXARGSZ + 1], *p3 = NULL;
-    vfo_t vfo = RIG_VFO_CURR;
+/* deadline every command runs under, see rigctl_set_deadline() */
+static int deadline_ms;
 
-    rig_debug(RIG_DEBUG_TRACE, "%s: called, interactive=%d\n", __func__,
+void rigctl_set_deadline(int ms)
+{
+    deadline_ms = ms;
+}
+
+/*
+ * Everything after parsing: the rigctld shortcuts, locking, running the
+ * command and the RPRT/extended response trailer.  fin is only handed on to
+ * the commands that read further arguments themselves and may be NULL.
+ */
+static int rigctl_run(RIG *my_rig, FILE *fin, FILE *fout,
+                      struct test_table *cmd_entry, const char *tag,
+                      vfo_t vfo, const char *p1, const char *p2,
+                      const char *p3, sync_cb_t sync_cb, int interactive,
+                      int prompt, int *vfo_opt, char send_cmd_term,
+                      int *ext_resp_ptr, char *resp_sep_ptr, int use_password)
+{
+    unsigned char cmd = cmd_entry->cmd;
+    int retcode;
+    int deadline_hit = 0;
+
+    if (interactive && !prompt
+            && rigctl_pipelined(my_rig, fout, cmd_entry, tag, vfo, *vfo_opt,
+                                p1, p2, p3, ext_resp_ptr, resp_sep_ptr,
+                                use_password))
+    {
+        return (RIG_OK);
+    }
+
+    // rigctld pollers get cache hits without queueing behind the rig lock
+    if (interactive && !prompt && sync_cb && my_rig->state.comm_state
+            && !(use_password && !is_passwordOK)
+            && rigctl_cache_answer(my_rig, fout, cmd_entry, vfo, *vfo_opt,
+                                   ext_resp_ptr, resp_sep_ptr))
+    {
+        return (RIG_OK);
+    }
+
+#ifdef RIGCTL_SINGLEFLIGHT
+    struct sf_call *sf = NULL;
+    FILE *sf_fout = NULL;   /* the client's stream while fout is the capture */
+    char *sf_buf = NULL;
+    size_t sf_len = 0;
+
+    // identical reads from other clients already waiting on the rig share their answer
+    if (interactive && !prompt && sync_cb
+            && strncmp(cmd_entry->name, "get_", 4) == 0)
+    {
+        char sf_key[sizeof(sf->key)];
+
+        SNPRINTF(sf_key, sizeof(sf_key), "%c|%d|%s|%s|%s|%s|%d|%c", cmd,
+                 *vfo_opt, rig_strvfo(vfo), p1 ? p1 : "", p2 ? p2 : "",
+                 p3 ? p3 : "", *ext_resp_ptr, *resp_sep_ptr);
+
+        if (sf_begin(sf_key, fout, &sf, &retcode))
+        {
+            // the leader reset these after replying, so do we
+            if (retcode != -RIG_EIO)
+            {
+                *ext_resp_ptr = 0;
+                *resp_sep_ptr = '\n';
+            }
+
+            return (retcode);
+        }
+
+        FILE *sf_capture;
+
+        if (sf && (sf_capture = open_memstream(&sf_buf, &sf_len)) != NULL)
+        {
+            // reply goes to the capture until sf_finish() passes it on
+            sf_fout = fout;
+            fout = sf_capture;
+        }
+        else if (sf)
+        {
+            sf_end(sf, NULL, 0, -RIG_EINTERNAL);
+            sf = NULL;
+        }
+    }
+
+#endif
+
+    cmd_sync_cb = sync_cb;
+
+    if (sync_cb) { sync_cb(1); }    /* lock if necessary */
+
+    if (!prompt)
+    {
+        rig_debug(RIG_DEBUG_TRACE,
+                  "rigctl(d): %c '%s' '%s' '%s' '%s'\n",
+                  cmd,
+                  rig_strvfo(vfo),
+                  p1 ? p1 : "",
+                  p2 ? p2 : "",
+                  p3 ? p3 : "");
+    }
+
+    /*
+     * Extended Response protocol: output received command name and arguments
+     * response.  Don't send command header on '\chk_vfo' command.
+     */
+    if (interactive && *ext_resp_ptr && !prompt && cmd != 0xf0)
+    {
+        char a1[MAXARGSZ + 2];
+        char a2[MAXARGSZ + 2];
+        char a3[MAXARGSZ + 2];
+        char vfo_str[MAXARGSZ + 2];
+
+        *vfo_opt == 0 ? vfo_str[0] = '\0' : snprintf(vfo_str,
+                                     sizeof(vfo_str),
+                                     " %s",
+                                     rig_strvfo(vfo));
+
+        p1 == NULL ? a1[0] = '\0' : snprintf(a1, sizeof(a1), " %s", p1);
+        p2 == NULL ? a2[0] = '\0' : snprintf(a2, sizeof(a2), " %s", p2);
+        p3 == NULL ? a3[0] = '\0' : snprintf(a3, sizeof(a3), " %s", p3);
+
+        fprintf(fout,
+                "%s:%s%s%s%s%c",
+                cmd_entry->name,
+                vfo_str,
+                a1,
+                a2,
+                a3,
+                *resp_sep_ptr);
+    }
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: vfo_opt=%d\n", __func__, *vfo_opt);
+
+    if (my_rig->state.comm_state == 0)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: %p rig not open...trying to reopen\n", __func__,
+                  &my_rig->state.comm_state);
+        rig_open(my_rig);
+    }
+
+    // chk_vfo is the one command we'll allow without a password
+    // since it's in the initial handshake
+    int preCmd =
+        0;  // some command are allowed without passoword to satisfy rigctld initialization from rigctl -m 2
+
+    if (cmd_entry->arg1 != NULL)
+    {
+        if (strcmp(cmd_entry->arg1, "ChkVFO") == 0) { preCmd = 1; }
+        else if (strcmp(cmd_entry->arg1, "VFO") == 0) { preCmd = 1; }
+        else if (strcmp(cmd_entry->arg1, "Password") == 0) { preCmd = 1; }
+    }
+
+    if (use_password && !is_passwordOK && (cmd_entry->arg1 != NULL) && !preCmd)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: password has not been provided\n", __func__);
+        if (fin) { fflush(fin); }
+
+        retcode = -RIG_ESECURITY;
+    }
+
+    else
+    {
+        if (deadline_ms > 0) { rig_set_deadline(deadline_ms); }
+
+        retcode = (*cmd_entry->rig_routine)(my_rig,
+                                            fout,
+                                            fin,
+                                            interactive,
+                                            prompt,
+                                            vfo_opt,
+                                            send_cmd_term,
+                                            *ext_resp_ptr,
+                                            *resp_sep_ptr,
+                                            cmd_entry,
+                                            vfo,
+                                            p1,
+                                            p2 ? p2 : "",
+                                            p3 ? p3 : "");
+
+        if (deadline_ms > 0)
+        {
+            deadline_hit = retcode == -RIG_ETIMEOUT && rig_get_deadline() == 0;
+            rig_set_deadline(0);
+        }
+    }
+
+
+    if (retcode == -RIG_EIO)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: RIG_EIO?\n", __func__);
+
+        if (sync_cb) { sync_cb(0); }    /* unlock if necessary */
+
+#ifdef RIGCTL_SINGLEFLIGHT
+
+        if (sf) { fout = sf_finish(sf, fout, sf_fout, &sf_buf, &sf_len, retcode); }
+
+#endif
+        return (retcode);
+    }
+
+    if (retcode != RIG_OK)
+    {
+        /* only for rigctld */
+        if (interactive && !prompt)
+        {
+            rig_debug(RIG_DEBUG_TRACE, "%s: return#1 "NETRIGCTL_RET "%d\n", __func__,
+                      retcode);
+            fprintf(fout, NETRIGCTL_RET "%d\n", retcode);
+            *ext_resp_ptr = 0;
+            *resp_sep_ptr = '\n';
+        }
+        else
+        {
+            fprintf(fout,
+                    "%s: error = %s\n",
+                    cmd_entry->name,
+                    rigerror(retcode));
+        }
+    }
+    else
+    {
+        /* only for rigctld */
+        if (interactive && !prompt)
+        {
+            /* netrigctl RIG_OK */
+            if (!(cmd_entry->flags & ARG_OUT)
+                    && !*ext_resp_ptr && cmd != 0xf0)
+            {
+                rig_debug(RIG_DEBUG_TRACE, "%s: return#2 "NETRIGCTL_RET "0\n", __func__);
+                fprintf(fout, NETRIGCTL_RET "0\n");
+            }
+
+            /* Extended Response protocol */
+            else if (*ext_resp_ptr && cmd != 0xf0)
+            {
+                rig_debug(RIG_DEBUG_TRACE, "%s: return#3 "NETRIGCTL_RET "0\n", __func__);
+                fprintf(fout, NETRIGCTL_RET "0\n");
+                *ext_resp_ptr = 0;
+                *resp_sep_ptr = '\n';
+            }
+        }
+    }
+
+    if (*resp_sep_ptr != '\n') { fprintf(fout, "\n"); }
+
+    fflush(fout);
+
+    if (sync_cb) { sync_cb(0); }    /* unlock if necessary */
+
+#ifdef RIGCTL_SINGLEFLIGHT
+
+    if (sf) { fout = sf_finish(sf, fout, sf_fout, &sf_buf, &sf_len, retcode); }
+
+#endif
+
+    // the client has its RPRT; a command cut short by the deadline is no
+    // reason for rigctld to reopen the rig
+    return (deadline_hit ? RIG_OK : retcode);
+}
+
+
+/*
+ * rigctld holds the client stream for the whole reply, so pushed events
+ * and pipelined replies written by other threads never land inside it.
+ */
+static int rigctl_exec(RIG *my_rig, FILE *fin, FILE *fout,
+                       struct test_table *cmd_entry, const char *tag,
+                       vfo_t vfo, const char *p1, const char *p2,
+                       const char *p3, sync_cb_t sync_cb, int interactive,
+                       int prompt, int *vfo_opt, char send_cmd_term,
+                       int *ext_resp_ptr, char *resp_sep_ptr, int use_password)
+{
+    int retcode;
+
+#ifdef HAVE_FLOCKFILE
+
+    if (interactive && !prompt) { flockfile(fout); }
+
+#endif
+
+    retcode = rigctl_run(my_rig, fin, fout, cmd_entry, tag, vfo, p1, p2, p3,
+                         sync_cb, interactive, prompt, vfo_opt, send_cmd_term,
+                         ext_resp_ptr, resp_sep_ptr, use_password);
+
+#ifdef HAVE_FLOCKFILE
+
+    if (interactive && !prompt) { funlockfile(fout); }
+
+#endif
+
+    return retcode;
+}
+
+
+int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
+                 sync_cb_t sync_cb,
+                 int interactive, int prompt, int *vfo_opt, char send_cmd_term,
+                 int *ext_resp_ptr, char *resp_sep_ptr, int use_password)
+{
+    int retcode;        /* generic return code from functions */
+    unsigned char cmd;
+    struct test_table *cmd_entry = NULL;
+
+    char command[MAXARGSZ + 1];
+    char arg1[MAXARGSZ + 1], *p1 = NULL;
+    char arg2[MAXARGSZ + 1], *p2 = NULL;
+    char arg3[MAXARGSZ + 1], *p3 = NULL;
+    char tag[16] = "";
+    vfo_t vfo = RIG_VFO_CURR;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: called, interactive=%d\n", __func__,
               interactive);
 
     /* cmd, internal, rigctld */
@@ -704,6 +1511,18 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
                               isprint(cmd) ? cmd : ' ', cmd, fileno(fin));
                 }
 
+                /* Pipelined command tagged with leading "#<id> "--rigctld only!
+                 */
+                if (cmd == '#' && !prompt
+                        && rigctl_scan_tag(fin, tag, sizeof(tag)))
+                {
+                    if (scanfc(fin, "%c", &cmd) < 1)
+                    {
+                        rig_debug(RIG_DEBUG_WARN, "%s: nothing to scan#1a?\n", __func__);
+                        return (RIGCTL_PARSE_ERROR);
+                    }
+                }
+
                 /* Extended response protocol requested with leading '+' on command
                  * string--rigctld only!
                  */
@@ -820,7 +1639,15 @@ int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc,
             {
                 rig_debug(RIG_DEBUG_TRACE, "%s: quit returning NETRIGCTL_RET 0\n", __func__);
 
-                if (interactive && !prompt) { fprintf(fout, "%s0\n", NETRIGCTL_RET); }
+                // after whatever is still queued for this client
+                if (interactive && !prompt
+                        && !(pl_pending && pl_pending(fout, 0)
+                             && pl_defer(fout, tag, "q\n", 0)))
+                {
+                    if (tag[0]) { fprintf(fout, "#%s ", tag); }
+
+                    fprintf(fout, "%s0\n", NETRIGCTL_RET);
+                }
 
                 fflush(fout);
                 return (RIGCTL_PARSE_END);
@@ -1651,162 +2478,1024 @@ readline_repeat:
 
 #endif // HAVE_LIBREADLINE
 
-    if (sync_cb) { sync_cb(1); }    /* lock if necessary */
+    retcode = rigctl_exec(my_rig, fin, fout, cmd_entry, tag, vfo, p1, p2, p3,
+                          sync_cb, interactive, prompt, vfo_opt, send_cmd_term,
+                          ext_resp_ptr, resp_sep_ptr, use_password);
 
-    if (!prompt)
+#ifdef HAVE_LIBREADLINE
+
+    if (retcode != -RIG_EIO && input_line != NULL
+            && (result = strtok(NULL, " ")))
     {
-        rig_debug(RIG_DEBUG_TRACE,
-                  "rigctl(d): %c '%s' '%s' '%s' '%s'\n",
-                  cmd,
-                  rig_strvfo(vfo),
-                  p1 ? p1 : "",
-                  p2 ? p2 : "",
-                  p3 ? p3 : "");
+        goto readline_repeat;
     }
 
-    /*
-     * Extended Response protocol: output received command name and arguments
-     * response.  Don't send command header on '\chk_vfo' command.
-     */
-    if (interactive && *ext_resp_ptr && !prompt && cmd != 0xf0)
+#endif
+
+    return (retcode);
+}
+
+#ifdef RIGCTL_PARSE_BUF
+/* next blank separated word of *pp, NUL terminated in place */
+static char *buf_token(char **pp)
+{
+    char *p = *pp;
+    char *tok;
+
+    while (*p == ' ' || *p == '\t')
     {
-        char a1[MAXARGSZ + 2];
-        char a2[MAXARGSZ + 2];
-        char a3[MAXARGSZ + 2];
-        char vfo_str[MAXARGSZ + 2];
+        p++;
+    }
 
-        *vfo_opt == 0 ? vfo_str[0] = '\0' : snprintf(vfo_str,
-                                     sizeof(vfo_str),
-                                     " %s",
-                                     rig_strvfo(vfo));
+    if (!*p)
+    {
+        *pp = p;
+        return NULL;
+    }
 
-        p1 == NULL ? a1[0] = '\0' : snprintf(a1, sizeof(a1), " %s", p1);
-        p2 == NULL ? a2[0] = '\0' : snprintf(a2, sizeof(a2), " %s", p2);
-        p3 == NULL ? a3[0] = '\0' : snprintf(a3, sizeof(a3), " %s", p3);
+    tok = p;
 
-        fprintf(fout,
-                "%s:%s%s%s%s%c",
-                cmd_entry->name,
-                vfo_str,
-                a1,
-                a2,
-                a3,
-                *resp_sep_ptr);
+    while (*p && *p != ' ' && *p != '\t')
+    {
+        p++;
     }
 
-    rig_debug(RIG_DEBUG_TRACE, "%s: vfo_opt=%d\n", __func__, *vfo_opt);
+    if (*p) { *p++ = '\0'; }
 
-    if (my_rig->state.comm_state == 0)
+    *pp = p;
+
+    return tok;
+}
+
+/*
+ * rigctld command from one line in memory, see rigctl_parse.h.  Mirrors
+ * the interactive, non-prompt branch of rigctl_parse() token for token.
+ */
+int rigctl_parse_buf(RIG *my_rig, const char *line, size_t len,
+                     struct rigctl_out *out, sync_cb_t sync_cb, int *vfo_opt,
+                     char send_cmd_term, int *ext_resp_ptr,
+                     char *resp_sep_ptr, int use_password)
+{
+    char work[4 * MAXARGSZ + 64];
+    char *p = work;
+    char *tok;
+    char *p1 = NULL, *p2 = NULL, *p3 = NULL;
+    char tag[16] = "";
+    struct test_table *cmd_entry;
+    unsigned char cmd;
+    vfo_t vfo = RIG_VFO_CURR;
+    int ext_resp = *ext_resp_ptr;
+    char resp_sep = *resp_sep_ptr;
+    FILE *fout;
+    long used;
+    int retcode;
+
+    out->len = 0;
+
+    if (len >= sizeof(work))
     {
-        rig_debug(RIG_DEBUG_WARN, "%s: %p rig not open...trying to reopen\n", __func__,
-                  &my_rig->state.comm_state);
-        rig_open(my_rig);
+        return (RIGCTL_PARSE_INCOMPLETE);
     }
 
-    // chk_vfo is the one command we'll allow without a password
-    // since it's in the initial handshake
-    int preCmd =
-        0;  // some command are allowed without passoword to satisfy rigctld initialization from rigctl -m 2
+    memcpy(work, line, len);
+    work[len] = '\0';
+    work[strcspn(work, "\r\n")] = '\0';
 
-    if (cmd_entry->arg1 != NULL)
+    if (!work[0])
     {
-        if (strcmp(cmd_entry->arg1, "ChkVFO") == 0) { preCmd = 1; }
-        else if (strcmp(cmd_entry->arg1, "VFO") == 0) { preCmd = 1; }
-        else if (strcmp(cmd_entry->arg1, "Password") == 0) { preCmd = 1; }
+        return (RIG_OK);
     }
 
-    if (use_password && !is_passwordOK && (cmd_entry->arg1 != NULL) && !preCmd)
+    if (work[0] == '#')
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: password has not been provided\n", __func__);
-        fflush(fin);
-        retcode = -RIG_ESECURITY;
+        size_t n = 1;
+
+        while (isdigit((unsigned char)work[n]) && n < sizeof(tag))
+        {
+            n++;
+        }
+
+        if (n == 1 || n == sizeof(tag) || work[n] != ' ')
+        {
+            return (RIG_OK);    /* comment line */
+        }
+
+        memcpy(tag, work + 1, n - 1);
+        tag[n - 1] = '\0';
+        p = work + n + 1;
+    }
+
+    if (*p == '+')
+    {
+        ext_resp = 1;
+        p++;
+    }
+
+    if (*p != '\\' && *p != '_' && *p != '#' && *p != '(' && *p != ')'
+            && ispunct((unsigned char)*p))
+    {
+        ext_resp = 1;
+        resp_sep = *p++;
     }
 
+    if (*p == '\\')
+    {
+        p++;
+        tok = buf_token(&p);
+        cmd = tok ? parse_arg(tok) : 0;
+    }
     else
     {
-        retcode = (*cmd_entry->rig_routine)(my_rig,
-                                            fout,
-                                            fin,
-                                            interactive,
-                                            prompt,
-                                            vfo_opt,
-                                            send_cmd_term,
-                                            *ext_resp_ptr,
-                                            *resp_sep_ptr,
-                                            cmd_entry,
-                                            vfo,
-                                            p1,
-                                            p2 ? p2 : "",
-                                            p3 ? p3 : "");
+        cmd = *p;
+
+        if (*p) { p++; }
     }
 
+    if (cmd == 'Q' || cmd == 'q' || cmd == '?')
+    {
+        cmd_entry = NULL;
+    }
+    else if (!(cmd_entry = find_cmd_entry(cmd)))
+    {
+        if (cmd != ' ')
+        {
+            fprintf(stderr, "Command '%c' not found!\n", cmd);
+        }
 
-    if (retcode == -RIG_EIO)
+        return (RIG_OK);
+    }
+    else
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: RIG_EIO?\n", __func__);
+        if (!(cmd_entry->flags & ARG_NOVFO) && *vfo_opt)
+        {
+            if (!(tok = buf_token(&p)))
+            {
+                return (RIGCTL_PARSE_INCOMPLETE);
+            }
 
-        if (sync_cb) { sync_cb(0); }    /* unlock if necessary */
+            vfo = rig_parse_vfo(tok);
+        }
 
-        return (retcode);
+        if ((cmd_entry->flags & ARG_IN_LINE)
+                && (cmd_entry->flags & ARG_IN1)
+                && cmd_entry->arg1)
+        {
+            // the stream parser's fgets() starts at the separator, so do we
+            if (p > work && p[-1] == '\0') { *--p = ' '; }
+
+            if (!*p)
+            {
+                return (RIGCTL_PARSE_INCOMPLETE);
+            }
+
+            p1 = cmd == 'b' || p[0] != ' ' ? p : p + 1;
+        }
+        else if ((cmd_entry->flags & ARG_IN1) && cmd_entry->arg1)
+        {
+            if (!(p1 = buf_token(&p)))
+            {
+                return (RIGCTL_PARSE_INCOMPLETE);
+            }
+        }
+
+        if (p1 && p1[0] != '?' && (cmd_entry->flags & ARG_IN2)
+                && cmd_entry->arg2 && !(p2 = buf_token(&p)))
+        {
+            return (RIGCTL_PARSE_INCOMPLETE);
+        }
+
+        if (p1 && p1[0] != '?' && (cmd_entry->flags & ARG_IN3)
+                && cmd_entry->arg3 && !(p3 = buf_token(&p)))
+        {
+            return (RIGCTL_PARSE_INCOMPLETE);
+        }
+
+        // reads its fields from the stream itself
+        if (cmd_entry->rig_routine == ACTION(set_channel))
+        {
+            return (RIGCTL_PARSE_INCOMPLETE);
+        }
     }
 
-    if (retcode != RIG_OK)
+    fout = fmemopen(out->buf, out->size, "w");
+
+    if (!fout)
     {
-        /* only for rigctld */
-        if (interactive && !prompt)
+        rig_debug(RIG_DEBUG_ERR, "%s: fmemopen: %s\n", __func__, strerror(errno));
+        return (RIGCTL_PARSE_ERROR);
+    }
+
+    *ext_resp_ptr = ext_resp;
+    *resp_sep_ptr = resp_sep;
+    my_rig->state.vfo_opt = *vfo_opt;
+
+    if (!cmd_entry && cmd == '?')
+    {
+        usage_rig(fout);
+        retcode = RIG_OK;
+    }
+    else if (!cmd_entry)
+    {
+        if (tag[0]) { fprintf(fout, "#%s ", tag); }
+
+        fprintf(fout, "%s0\n", NETRIGCTL_RET);
+        retcode = RIGCTL_PARSE_END;
+    }
+    else
+    {
+        retcode = rigctl_exec(my_rig, NULL, fout, cmd_entry, tag, vfo, p1, p2, p3,
+                              sync_cb, 1, 0, vfo_opt, send_cmd_term,
+                              ext_resp_ptr, resp_sep_ptr, use_password);
+    }
+
+    fflush(fout);
+    used = ftell(fout);
+    fclose(fout);
+
+    out->len = used > 0 ? (size_t)used : 0;
+
+    if (out->len >= out->size)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: reply truncated to %d bytes\n", __func__,
+                  (int)out->size);
+        out->len = out->size;
+    }
+
+    return (retcode);
+}
+
+/*
+ * rigctl -b: run a whole script and report at the end.  Setters the
+ * request queue knows (F M V T S I L U, plain numeric arguments) go to
+ * rig_submit() and are not waited for, so a later setter of the same
+ * kind supersedes one still queued and the parsing of the script
+ * overlaps the CAT traffic.  A run of consecutive reads of frequency,
+ * mode, PTT, split or the STRENGTH/RFPOWER/SWR meters becomes one
+ * rig_get_bulk() call, which backends with get_bulk answer in a single
+ * exchange.  Anything else runs through rigctl_parse_buf() in order, after
+ * what was queued before it.
+ */
+enum batch_kind_e
+{
+    BATCH_SKIP = 0,
+    BATCH_QUEUE,
+    BATCH_BULK,
+    BATCH_SYNC
+};
+
+struct batch_cmd
+{
+    char *line;
+    int lineno;
+    int kind;
+    unsigned char cmd;
+    vfo_t vfo;
+    setting_t level;
+    struct rig_request req;
+    int retcode;
+    char *out;          /* reply text of BATCH_SYNC and BATCH_BULK */
+};
+
+#define BATCH_MAX_LINES 10000
+#define BATCH_REPLY_SIZE 65536
+
+/* sort a script line into what can be queued, bulk read or must run alone */
+static void batch_classify(RIG *rig, struct batch_cmd *b, int vfo_opt)
+{
+    char work[4 * MAXARGSZ + 64];
+    char *p = work;
+    char *tok, *a1, *a2;
+    struct test_table *entry;
+    struct rig_request *req = &b->req;
+    int i;
+
+    b->kind = BATCH_SYNC;
+    b->vfo = RIG_VFO_CURR;
+
+    strncpy(work, b->line, sizeof(work) - 1);
+    work[sizeof(work) - 1] = '\0';
+
+    while (*p == ' ' || *p == '\t') { p++; }
+
+    if (!*p || (*p == '#' && !isdigit((unsigned char)p[1])))
+    {
+        b->kind = BATCH_SKIP;
+        return;
+    }
+
+    // long names, single letters; tags and response separators run as they are
+    if (*p == '\\')
+    {
+        p++;
+        tok = buf_token(&p);
+        b->cmd = tok ? parse_arg(tok) : 0;
+    }
+    else if (isalpha((unsigned char)p[0]) && (!p[1] || p[1] == ' ' || p[1] == '\t'))
+    {
+        b->cmd = *p++;
+    }
+    else
+    {
+        return;
+    }
+
+    if (!(entry = find_cmd_entry(b->cmd)))
+    {
+        return;
+    }
+
+    if (!(entry->flags & ARG_NOVFO) && vfo_opt)
+    {
+        if (!(tok = buf_token(&p))) { return; }
+
+        b->vfo = rig_parse_vfo(tok);
+    }
+
+    a1 = buf_token(&p);
+    a2 = buf_token(&p);
+
+    if (a1 && a1[0] == '?') { return; }
+
+    memset(req, 0, sizeof(*req));
+    req->vfo = b->vfo;
+
+    switch (b->cmd)
+    {
+    case 'F':
+    case 'I':
+        if (!a1 || sscanf(a1, "%"SCNfreq, &req->freq) != 1) { return; }
+
+        req->type = b->cmd == 'F' ? RIG_REQ_SET_FREQ : RIG_REQ_SET_SPLIT_FREQ;
+        break;
+
+    case 'M':
+        if (!a1 || !a2 || (req->mode = rig_parse_mode(a1)) == RIG_MODE_NONE
+                || sscanf(a2, "%ld", &req->width) != 1)
         {
-            rig_debug(RIG_DEBUG_TRACE, "%s: return#1 "NETRIGCTL_RET "%d\n", __func__,
-                      retcode);
-            fprintf(fout, NETRIGCTL_RET "%d\n", retcode);
-            *ext_resp_ptr = 0;
-            *resp_sep_ptr = '\n';
+            return;
         }
-        else
+
+        req->type = RIG_REQ_SET_MODE;
+        break;
+
+    case 'V':
+        if (!a1 || (req->vfo = rig_parse_vfo(a1)) == RIG_VFO_NONE) { return; }
+
+        req->type = RIG_REQ_SET_VFO;
+        break;
+
+    case 'T':
+        if (!a1 || num_scan_int(a1, &i) != 1) { return; }
+
+        req->ptt = (ptt_t) i;
+        req->type = RIG_REQ_SET_PTT;
+        break;
+
+    case 'S':
+        if (!a1 || !a2 || num_scan_int(a1, &i) != 1
+                || (req->tx_vfo = rig_parse_vfo(a2)) == RIG_VFO_NONE)
         {
-            fprintf(fout,
-                    "%s: error = %s\n",
-                    cmd_entry->name,
-                    rigerror(retcode));
+            return;
+        }
+
+        req->split = (split_t) i;
+        req->type = RIG_REQ_SET_SPLIT_VFO;
+        break;
+
+    case 'L':
+        if (!a1 || !a2 || !(req->setting = rig_parse_level(a1))
+                || !rig_has_set_level(rig, req->setting))
+        {
+            return;
+        }
+
+        if (RIG_LEVEL_IS_FLOAT(req->setting)
+                ? num_scan_float(a2, &req->val.f) != 1 : num_scan_int(a2, &req->val.i) != 1)
+        {
+            return;
+        }
+
+        req->type = RIG_REQ_SET_LEVEL;
+        break;
+
+    case 'U':
+        if (!a1 || !a2 || !(req->setting = rig_parse_func(a1))
+                || !rig_has_set_func(rig, req->setting)
+                || num_scan_int(a2, &req->status) != 1)
+        {
+            return;
+        }
+
+        req->type = RIG_REQ_SET_FUNC;
+        break;
+
+    case 'l':
+        if (!a1) { return; }
+
+        b->level = rig_parse_level(a1);
+
+        if (b->level != RIG_LEVEL_STRENGTH && b->level != RIG_LEVEL_RFPOWER
+                && b->level != RIG_LEVEL_SWR)
+        {
+            return;
         }
+
+    // fall through
+    case 'f':
+    case 'm':
+    case 't':
+    case 's':
+        b->kind = BATCH_BULK;
+        return;
+
+    default:
+        return;
+    }
+
+    b->kind = BATCH_QUEUE;
+}
+
+/* the bulk bit answering b, 0 if the VFO is not one rig_get_bulk() reads */
+static rig_bulk_t batch_bulk_bit(RIG *rig, const struct batch_cmd *b)
+{
+    vfo_t vfo = b->vfo;
+    int b_side;
+
+    switch (b->cmd)
+    {
+    case 't': return RIG_BULK_PTT;
+
+    case 's': return RIG_BULK_SPLIT;
+
+    case 'l':
+        return b->level == RIG_LEVEL_STRENGTH ? RIG_BULK_STRENGTH
+               : b->level == RIG_LEVEL_RFPOWER ? RIG_BULK_RFPOWER : RIG_BULK_SWR;
+    }
+
+    if (vfo == RIG_VFO_CURR) { vfo = rig->state.current_vfo; }
+
+    switch (vfo)
+    {
+    case RIG_VFO_A:
+    case RIG_VFO_MAIN:
+    case RIG_VFO_MAIN_A:
+        b_side = 0;
+        break;
+
+    case RIG_VFO_B:
+    case RIG_VFO_SUB:
+    case RIG_VFO_MAIN_B:
+        b_side = 1;
+        break;
+
+    default:
+        return 0;
+    }
+
+    if (b->cmd == 'f') { return b_side ? RIG_BULK_FREQ_B : RIG_BULK_FREQ_A; }
+
+    return b_side ? RIG_BULK_MODE_B : RIG_BULK_MODE_A;
+}
+
+static void batch_sync(RIG *rig, struct batch_cmd *b, int *vfo_opt,
+                       char send_cmd_term, int *ext_resp, char *resp_sep)
+{
+    struct rigctl_out out;
+    int ret;
+
+    rig_submit_wait(rig);
+
+    out.buf = malloc(BATCH_REPLY_SIZE);
+    out.size = BATCH_REPLY_SIZE - 1;
+
+    if (!out.buf)
+    {
+        b->retcode = -RIG_ENOMEM;
+        return;
+    }
+
+    ret = rigctl_parse_buf(rig, b->line, strlen(b->line), &out, NULL, vfo_opt,
+                           send_cmd_term, ext_resp, resp_sep, 0);
+    out.buf[out.len] = '\0';
+    b->out = out.buf;
+
+    if (ret == RIGCTL_PARSE_INCOMPLETE)
+    {
+        b->retcode = -RIG_EINVAL;   // set_channel and friends read more lines
+    }
+    else if (ret == RIGCTL_PARSE_END)
+    {
+        b->retcode = RIGCTL_PARSE_END;
     }
     else
     {
-        /* only for rigctld */
-        if (interactive && !prompt)
+        const char *rprt = strstr(out.buf, NETRIGCTL_RET);
+
+        b->retcode = rprt ? atoi(rprt + strlen(NETRIGCTL_RET)) : RIG_OK;
+    }
+}
+
+static void batch_bulk_reply(struct batch_cmd *b, const struct rig_bulk *bulk,
+                             rig_bulk_t bit)
+{
+    char buf[128];
+
+    if (!(bulk->valid & bit))
+    {
+        return;
+    }
+
+    switch (bit)
+    {
+    case RIG_BULK_FREQ_A:
+    case RIG_BULK_FREQ_B:
+        SNPRINTF(buf, sizeof(buf), "%.0f\n",
+                 bit == RIG_BULK_FREQ_A ? bulk->freqA : bulk->freqB);
+        break;
+
+    case RIG_BULK_MODE_A:
+        SNPRINTF(buf, sizeof(buf), "%s\n%ld\n", rig_strrmode(bulk->modeA),
+                 bulk->widthA);
+        break;
+
+    case RIG_BULK_MODE_B:
+        SNPRINTF(buf, sizeof(buf), "%s\n%ld\n", rig_strrmode(bulk->modeB),
+                 bulk->widthB);
+        break;
+
+    case RIG_BULK_PTT:
+        SNPRINTF(buf, sizeof(buf), "%d\n", bulk->ptt);
+        break;
+
+    case RIG_BULK_SPLIT:
+        SNPRINTF(buf, sizeof(buf), "%d\n%s\n", bulk->split,
+                 rig_strvfo(bulk->split_vfo));
+        break;
+
+    case RIG_BULK_STRENGTH:
+        SNPRINTF(buf, sizeof(buf), "%d\n", bulk->strength.i);
+        break;
+
+    case RIG_BULK_RFPOWER:
+        SNPRINTF(buf, sizeof(buf), "%f\n", bulk->rfpower.f);
+        break;
+
+    default:
+        SNPRINTF(buf, sizeof(buf), "%f\n", bulk->swr.f);
+    }
+
+    b->out = strdup(buf);
+    b->retcode = RIG_OK;
+}
+
+/* cmds[first..last) are BATCH_BULK, read in one rig_get_bulk() */
+static void batch_bulk(RIG *rig, struct batch_cmd *cmds, int first, int last,
+                       int *vfo_opt, char send_cmd_term, int *ext_resp,
+                       char *resp_sep)
+{
+    struct rig_bulk bulk;
+    int retval;
+    int i;
+
+    rig_submit_wait(rig);
+
+    memset(&bulk, 0, sizeof(bulk));
+
+    for (i = first; i < last; i++)
+    {
+        bulk.mask |= batch_bulk_bit(rig, &cmds[i]);
+    }
+
+    retval = bulk.mask ? rig_get_bulk(rig, &bulk) : RIG_OK;
+
+    for (i = first; i < last; i++)
+    {
+        rig_bulk_t bit = batch_bulk_bit(rig, &cmds[i]);
+
+        if (!bit)
         {
-            /* netrigctl RIG_OK */
-            if (!(cmd_entry->flags & ARG_OUT)
-                    && !*ext_resp_ptr && cmd != 0xf0)
-            {
-                rig_debug(RIG_DEBUG_TRACE, "%s: return#2 "NETRIGCTL_RET "0\n", __func__);
-                fprintf(fout, NETRIGCTL_RET "0\n");
-            }
+            // a VFO rig_get_bulk() does not cover
+            batch_sync(rig, &cmds[i], vfo_opt, send_cmd_term, ext_resp, resp_sep);
+            continue;
+        }
 
-            /* Extended Response protocol */
-            else if (*ext_resp_ptr && cmd != 0xf0)
+        cmds[i].retcode = retval != RIG_OK ? retval : -RIG_ENAVAIL;
+        batch_bulk_reply(&cmds[i], &bulk, bit);
+    }
+}
+
+/*
+ * Batch mode for rigctl, see above.  Returns the number of commands that
+ * failed, or a negative Hamlib status if the script could not be read.
+ */
+int rigctl_batch(RIG *rig, FILE *fin, FILE *fout, int *vfo_opt,
+                 char send_cmd_term)
+{
+    struct batch_cmd *cmds;
+    char line[4 * MAXARGSZ + 64];
+    struct timespec t0, t1;
+    int ext_resp = 0;
+    char resp_sep = '\n';
+    int n = 0, ran = 0, failed = 0, coalesced = 0, stop = 0;
+    int i;
+
+    cmds = calloc(BATCH_MAX_LINES, sizeof(*cmds));
+
+    if (!cmds)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    while (n < BATCH_MAX_LINES && fgets(line, sizeof(line), fin))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+        cmds[n].line = strdup(line);
+        cmds[n].lineno = n + 1;
+
+        if (!cmds[n].line) { break; }
+
+        batch_classify(rig, &cmds[n], *vfo_opt);
+        n++;
+    }
+
+    if (n == BATCH_MAX_LINES && !feof(fin))
+    {
+        fprintf(stderr, "Batch truncated to %d lines\n", BATCH_MAX_LINES);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (i = 0; i < n && !stop; i++)
+    {
+        struct batch_cmd *b = &cmds[i];
+        int last;
+
+        switch (b->kind)
+        {
+        case BATCH_QUEUE:
+            // req.retcode is all we need, no callback
+            if ((b->retcode = rig_submit(rig, &b->req, NULL, NULL)) != RIG_OK)
             {
-                rig_debug(RIG_DEBUG_TRACE, "%s: return#3 "NETRIGCTL_RET "0\n", __func__);
-                fprintf(fout, NETRIGCTL_RET "0\n");
-                *ext_resp_ptr = 0;
-                *resp_sep_ptr = '\n';
+                b->req.retcode = b->retcode;
             }
+
+            break;
+
+        case BATCH_BULK:
+            for (last = i + 1; last < n && cmds[last].kind == BATCH_BULK; last++) { }
+
+            batch_bulk(rig, cmds, i, last, vfo_opt, send_cmd_term, &ext_resp,
+                       &resp_sep);
+            i = last - 1;
+            break;
+
+        case BATCH_SYNC:
+            batch_sync(rig, b, vfo_opt, send_cmd_term, &ext_resp, &resp_sep);
+            stop = b->retcode == RIGCTL_PARSE_END;
+            break;
+        }
+    }
+
+    rig_submit_wait(rig);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    // nothing after a quit ran
+    for (; i < n; i++) { cmds[i].kind = BATCH_SKIP; }
+
+    for (i = 0; i < n; i++)
+    {
+        struct batch_cmd *b = &cmds[i];
+
+        if (b->kind == BATCH_SKIP)
+        {
+            free(b->line);
+            continue;
+        }
+
+        fprintf(fout, "%d: %s\n", b->lineno, b->line);
+        ran++;
+
+        if (b->kind == BATCH_QUEUE)
+        {
+            b->retcode = b->req.retcode;
+            coalesced += b->req.coalesced;
+            fprintf(fout, "%s%d\n", NETRIGCTL_RET, b->retcode);
+        }
+        else if (b->out)
+        {
+            fputs(b->out, fout);
+        }
+        else if (b->retcode != RIGCTL_PARSE_END)
+        {
+            fprintf(fout, "%s%d\n", NETRIGCTL_RET, b->retcode);
+        }
+
+        if (b->retcode < 0) { failed++; }
+
+        free(b->out);
+        free(b->line);
+    }
+
+    fflush(fout);
+    fprintf(stderr, "Batch: %d commands, %d failed, %d superseded, %.0f ms\n",
+            ran, failed, coalesced,
+            (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+
+    free(cmds);
+
+    return failed;
+}
+#endif
+
+#ifdef RIGCTL_BINARY
+/*
+ * Binary framed protocol for rigctld, negotiated by the client sending
+ * RIGCTL_BIN_MAGIC as its first bytes (see rigctld(1)).  All integers are
+ * big-endian.
+ *
+ *   request:  u32 len | u32 id | u8 cmd | payload     (len counts id..end)
+ *   reply:    u32 len | u32 id | i32 retcode | payload
+ *
+ * cmd is the test_list[] command byte.  f/F/m/M/v/V/t/T/s/S use the fixed
+ * layouts below, with vfo 0 meaning RIG_VFO_CURR; every other command takes
+ * its arguments as text and answers with the text reply minus the RPRT
+ * line.  Replies come back in request order, so a client may pipeline.
+ */
+#define BIN_MAX_REQUEST 1024
+#define BIN_MAX_REPLY 16384
+
+static uint32_t bin_get32(const unsigned char *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16)
+           | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t bin_get64(const unsigned char *p)
+{
+    return ((uint64_t)bin_get32(p) << 32) | bin_get32(p + 4);
+}
+
+static unsigned char *bin_put32(unsigned char *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+    return p + 4;
+}
+
+static unsigned char *bin_put64(unsigned char *p, uint64_t v)
+{
+    return bin_put32(bin_put32(p, v >> 32), (uint32_t)v);
+}
+
+static vfo_t bin_vfo(const unsigned char *p)
+{
+    vfo_t vfo = bin_get32(p);
+
+    return vfo ? vfo : RIG_VFO_CURR;
+}
+
+/* run a command through rigctl_parse() and keep its text reply */
+static int bin_text_cmd(RIG *my_rig, const struct test_table *cmd_entry,
+                        const unsigned char *args, size_t args_len,
+                        int *vfo_opt, unsigned char *out, size_t *out_len,
+                        int use_password)
+{
+    char line[MAXARGSZ * 3 + MAXNAMSIZ + 8];
+    char *reply = NULL;
+    size_t reply_len = 0;
+    char resp_sep = '\n';
+    int ext_resp = 0;
+    FILE *fin, *fout;
+    char *rprt;
+    int retcode;
+
+    if (args_len > MAXARGSZ * 3)
+    {
+        return -RIG_EINVAL;
+    }
+
+    SNPRINTF(line, sizeof(line), "\\%s %.*s\n", cmd_entry->name, (int)args_len,
+             (const char *)args);
+
+    fin = fmemopen(line, strlen(line), "r");
+
+    if (!fin)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    fout = open_memstream(&reply, &reply_len);
+
+    if (!fout)
+    {
+        fclose(fin);
+        return -RIG_ENOMEM;
+    }
+
+    retcode = rigctl_parse(my_rig, fin, fout, NULL, 0, NULL, 1, 0, vfo_opt, '\r',
+                           &ext_resp, &resp_sep, use_password);
+    fclose(fin);
+    fclose(fout);
+
+    if (retcode == RIGCTL_PARSE_END || retcode == RIGCTL_PARSE_ERROR)
+    {
+        retcode = -RIG_EINVAL;
+    }
+
+    /* the status travels in the frame header */
+    rprt = reply_len ? strstr(reply, NETRIGCTL_RET) : NULL;
+
+    if (rprt) { reply_len = rprt - reply; }
+
+    if (reply_len > *out_len) { reply_len = *out_len; }
+
+    memcpy(out, reply, reply_len);
+    *out_len = reply_len;
+    free(reply);
+
+    return retcode;
+}
+
+/*
+ * Read one request frame from fin, execute it and write the reply frame to
+ * fout.  Returns RIG_OK, or RIGCTL_PARSE_ERROR if fin ran out or carried a
+ * malformed frame.
+ */
+int rigctl_parse_bin(RIG *my_rig, FILE *fin, FILE *fout, sync_cb_t sync_cb,
+                     int *vfo_opt, int use_password)
+{
+    unsigned char req[BIN_MAX_REQUEST];
+    unsigned char reply[BIN_MAX_REPLY + 12];
+    unsigned char *body = reply + 12;
+    unsigned char *p = body;
+    const unsigned char *arg;
+    const struct test_table *cmd_entry;
+    size_t out_len;
+    uint32_t len, id;
+    size_t plen;
+    int retcode = RIG_OK;
+
+    if (fread(req, 1, 4, fin) != 4)
+    {
+        return RIGCTL_PARSE_ERROR;
+    }
+
+    len = bin_get32(req);
+
+    if (len < 5 || len > BIN_MAX_REQUEST)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: bad frame length %u\n", __func__,
+                  (unsigned)len);
+        return RIGCTL_PARSE_ERROR;
+    }
+
+    if (fread(req, 1, len, fin) != len)
+    {
+        return RIGCTL_PARSE_ERROR;
+    }
+
+    id = bin_get32(req);
+    arg = req + 5;
+    plen = len - 5;
+    cmd_entry = find_cmd_entry(req[4]);
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: id=%u cmd=0x%02x len=%u\n", __func__,
+              (unsigned)id, req[4], (unsigned)len);
+
+    if (!cmd_entry)
+    {
+        retcode = -RIG_EINVAL;
+    }
+    else if (use_password && !is_passwordOK && cmd_entry->arg1
+             && strcmp(cmd_entry->arg1, "Password") != 0)
+    {
+        retcode = -RIG_ESECURITY;
+    }
+
+    cmd_sync_cb = sync_cb;
+
+    if (retcode == RIG_OK && sync_cb) { sync_cb(1); }
+
+    if (retcode == RIG_OK)
+    {
+        switch (cmd_entry->cmd)
+        {
+        case 'F':
+            if (plen < 12) { retcode = -RIG_EINVAL; break; }
+
+            retcode = rig_set_freq(my_rig, bin_vfo(arg),
+                                   (freq_t)(int64_t)bin_get64(arg + 4));
+            break;
+
+        case 'f':
+        {
+            freq_t freq = 0;
+
+            if (plen < 4) { retcode = -RIG_EINVAL; break; }
+
+            retcode = rig_get_freq(my_rig, bin_vfo(arg), &freq);
+            p = bin_put64(p, (uint64_t)(int64_t)freq);
+            break;
+        }
+
+        case 'M':
+            if (plen < 16) { retcode = -RIG_EINVAL; break; }
+
+            retcode = rig_set_mode(my_rig, bin_vfo(arg), bin_get64(arg + 4),
+                                   (int32_t)bin_get32(arg + 12));
+            break;
+
+        case 'm':
+        {
+            rmode_t mode = RIG_MODE_NONE;
+            pbwidth_t width = 0;
+
+            if (plen < 4) { retcode = -RIG_EINVAL; break; }
+
+            retcode = rig_get_mode(my_rig, bin_vfo(arg), &mode, &width);
+            p = bin_put64(p, mode);
+            p = bin_put32(p, (uint32_t)(int32_t)width);
+            break;
+        }
+
+        case 'V':
+            if (plen < 4) { retcode = -RIG_EINVAL; break; }
+
+            retcode = rig_set_vfo(my_rig, bin_vfo(arg));
+            break;
+
+        case 'v':
+        {
+            vfo_t vfo = RIG_VFO_NONE;
+
+            retcode = rig_get_vfo(my_rig, &vfo);
+            p = bin_put32(p, vfo);
+            break;
+        }
+
+        case 'T':
+            if (plen < 8) { retcode = -RIG_EINVAL; break; }
+
+            retcode = rig_set_ptt(my_rig, bin_vfo(arg), bin_get32(arg + 4));
+            break;
+
+        case 't':
+        {
+            ptt_t ptt = RIG_PTT_OFF;
+
+            if (plen < 4) { retcode = -RIG_EINVAL; break; }
+
+            retcode = rig_get_ptt(my_rig, bin_vfo(arg), &ptt);
+            p = bin_put32(p, ptt);
+            break;
         }
-    }
 
-    if (*resp_sep_ptr != '\n') { fprintf(fout, "\n"); }
+        case 'S':
+            if (plen < 12) { retcode = -RIG_EINVAL; break; }
 
-    fflush(fout);
+            retcode = rig_set_split_vfo(my_rig, bin_vfo(arg), bin_get32(arg + 4),
+                                        bin_vfo(arg + 8));
+            break;
 
-#ifdef HAVE_LIBREADLINE
+        case 's':
+        {
+            split_t split = RIG_SPLIT_OFF;
+            vfo_t tx_vfo = RIG_VFO_NONE;
 
-    if (input_line != NULL && (result = strtok(NULL, " "))) { goto readline_repeat; }
+            if (plen < 4) { retcode = -RIG_EINVAL; break; }
 
-#endif
+            retcode = rig_get_split_vfo(my_rig, bin_vfo(arg), &split, &tx_vfo);
+            p = bin_put32(p, split);
+            p = bin_put32(p, tx_vfo);
+            break;
+        }
 
-    if (sync_cb) { sync_cb(0); }    /* unlock if necessary */
+        default:
+            out_len = BIN_MAX_REPLY;
+            retcode = bin_text_cmd(my_rig, cmd_entry, arg, plen, vfo_opt, body,
+                                   &out_len, use_password);
+            p = body + out_len;
+            break;
+        }
 
-    return (retcode);
+        if (sync_cb) { sync_cb(0); }
+    }
+
+    /* getters that failed carry no payload */
+    if (retcode != RIG_OK) { p = body; }
+
+    bin_put32(reply, (uint32_t)(p - body) + 8);
+    bin_put32(reply + 4, id);
+    bin_put32(reply + 8, (uint32_t)retcode);
+
+    fwrite(reply, 1, p - reply, fout);
+    fflush(fout);
+
+    return RIG_OK;
 }
+#endif /* RIGCTL_BINARY */
 
 
 void version()
@@ -1974,6 +3663,45 @@ void list_models()
 }
 
 
+static int print_usb_device(const struct rig_usb_device *dev, rig_ptr_t data)
+{
+    const struct rig_caps *caps = rig_get_caps(dev->model);
+    char rig[64] = "";
+
+    if (!dev->cat)
+    {
+        SNPRINTF(rig, sizeof(rig), "data port");
+    }
+    else if (caps)
+    {
+        SNPRINTF(rig, sizeof(rig), "%d %s %s", caps->rig_model, caps->mfg_name,
+                 caps->model_name);
+    }
+
+    printf("%-20s %04x:%04x  %-32.32s %-24.24s %s\n", dev->path, dev->vid,
+           dev->pid, dev->product, dev->serial, rig[0] ? rig : "-");
+
+    return 1;
+}
+
+
+void list_usb()
+{
+    int status;
+
+    rig_load_all_backends();
+
+    printf("Device               USB id     Product                          Serial                   Rig\n");
+    status = rig_usb_identify(print_usb_device, NULL);
+
+    if (status < 0)
+    {
+        printf("rig_usb_identify: error = %s \n", rigerror(status));
+        exit(2);
+    }
+}
+
+
 int set_conf(RIG *my_rig, char *conf_parms)
 {
     char *p, *n;
@@ -2030,7 +3758,7 @@ declare_proto_rig(set_freq)
 
     ENTERFUNC;
 
-    CHKSCN1ARG(sscanf(arg1, "%"SCNfreq, &freq));
+    CHKSCN1ARG(num_scan_double(arg1, &freq));
     retval = rig_set_freq(rig, vfo, freq);
 
     if (retval == RIG_OK)
@@ -2045,16 +3773,39 @@ declare_proto_rig(set_freq)
 
 
 /* 'f' */
+static int serve_stale;
+
+void rigctl_set_serve_stale(int stale)
+{
+    serve_stale = stale;
+}
+
+/* The extended response of a stale answer carries its age */
+static void print_stale(FILE *fout, int interactive, int prompt, int ext_resp,
+                        char resp_sep, int stale, int age_ms)
+{
+    if (stale && ((interactive && prompt) || (interactive && !prompt && ext_resp)))
+    {
+        fprintf(fout, "Stale: %d%c", age_ms, resp_sep);
+    }
+}
+
 declare_proto_rig(get_freq)
 {
     int status;
     freq_t freq;
-    // cppcheck-suppress *
-    char *fmt = "%"PRIll"%c";
+    int age_ms = 0, stale = 0;
 
     ENTERFUNC;
 
-    status = rig_get_freq(rig, vfo, &freq);
+    if (serve_stale)
+    {
+        status = rig_get_freq_swr(rig, vfo, &freq, &age_ms, &stale);
+    }
+    else
+    {
+        status = rig_get_freq(rig, vfo, &freq);
+    }
 
     if (status != RIG_OK)
     {
@@ -2066,7 +3817,8 @@ declare_proto_rig(get_freq)
         fprintf(fout, "%s: ", cmd->arg1);    /* i.e. "Frequency" */
     }
 
-    fprintf(fout, fmt, (int64_t)freq, resp_sep);
+    print_int(fout, (int64_t)freq, resp_sep);
+    print_stale(fout, interactive, prompt, ext_resp, resp_sep, stale, age_ms);
 
 #if 0 // this extra VFO being returned was confusing Log4OM
 
@@ -2089,7 +3841,7 @@ declare_proto_rig(set_rit)
 
     ENTERFUNC;
 
-    CHKSCN1ARG(sscanf(arg1, "%ld", &rit));
+    CHKSCN1ARG(num_scan_long(arg1, &rit));
 
     RETURNFUNC(rig_set_rit(rig, vfo, rit));
 }
@@ -2115,7 +3867,7 @@ declare_proto_rig(get_rit)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%ld%c", rit, resp_sep);
+    print_int(fout, rit, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -2128,7 +3880,7 @@ declare_proto_rig(set_xit)
 
     ENTERFUNC;
 
-    CHKSCN1ARG(sscanf(arg1, "%ld", &xit));
+    CHKSCN1ARG(num_scan_long(arg1, &xit));
 
     RETURNFUNC(rig_set_xit(rig, vfo, xit));
 }
@@ -2154,7 +3906,7 @@ declare_proto_rig(get_xit)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%ld%c", xit, resp_sep);
+    print_int(fout, xit, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -2179,7 +3931,7 @@ declare_proto_rig(set_mode)
     }
 
     mode = rig_parse_mode(arg1);
-    CHKSCN1ARG(sscanf(arg2, "%ld", &width));
+    CHKSCN1ARG(num_scan_long(arg2, &width));
 
     if (rig->state.lock_mode) { RETURNFUNC(RIG_OK); }
 
@@ -2193,10 +3945,18 @@ declare_proto_rig(get_mode)
     int status;
     rmode_t mode;
     pbwidth_t width;
+    int age_ms = 0, stale = 0;
 
     ENTERFUNC;
 
-    status = rig_get_mode(rig, vfo, &mode, &width);
+    if (serve_stale)
+    {
+        status = rig_get_mode_swr(rig, vfo, &mode, &width, &age_ms, &stale);
+    }
+    else
+    {
+        status = rig_get_mode(rig, vfo, &mode, &width);
+    }
 
     if (status != RIG_OK)
     {
@@ -2215,7 +3975,8 @@ declare_proto_rig(get_mode)
         fprintf(fout, "%s: ", cmd->arg2);
     }
 
-    fprintf(fout, "%ld%c", width, resp_sep);
+    print_int(fout, width, resp_sep);
+    print_stale(fout, interactive, prompt, ext_resp, resp_sep, stale, age_ms);
 
     RETURNFUNC(status);
 }
@@ -2300,6 +4061,33 @@ declare_proto_rig(get_rig_info)
     RETURNFUNC(RIG_OK);
 }
 
+/* '0xab' */
+declare_proto_rig(wait_rig_info)
+{
+    char buf[1024];
+    unsigned int generation;
+    int timeout_ms;
+    int ret;
+
+    ENTERFUNC;
+
+    CHKSCN1ARG(sscanf(arg1, "%u", &generation));
+    CHKSCN1ARG(sscanf(arg2, "%d", &timeout_ms));
+
+    // other clients get the rig while this one waits
+    if (cmd_sync_cb) { cmd_sync_cb(0); }
+
+    ret = rig_wait_rig_info(rig, buf, sizeof(buf), &generation, timeout_ms);
+
+    if (cmd_sync_cb) { cmd_sync_cb(1); }
+
+    if (ret != RIG_OK && ret != -RIG_ETIMEOUT) { RETURNFUNC(ret); }
+
+    // an unchanged generation says it timed out
+    fprintf(fout, "%sGeneration=%u\n", buf, generation);
+    RETURNFUNC(RIG_OK);
+}
+
 /* '\get_vfo_info' */
 declare_proto_rig(get_vfo_info)
 {
@@ -2465,7 +4253,7 @@ declare_proto_rig(set_ptt)
 
     ENTERFUNC;
 
-    CHKSCN1ARG(sscanf(arg1, "%d", &scr));
+    CHKSCN1ARG(num_scan_int(arg1, &scr));
     ptt = scr;
     rig_debug(RIG_DEBUG_VERBOSE, "%s: set_ptt ptt=%d\n", __func__, ptt);
 
@@ -2520,10 +4308,18 @@ declare_proto_rig(get_ptt)
 {
     int status;
     ptt_t ptt = 0;
+    int age_ms = 0, stale = 0;
 
     ENTERFUNC;
 
-    status = rig_get_ptt(rig, vfo, &ptt);
+    if (serve_stale)
+    {
+        status = rig_get_ptt_swr(rig, vfo, &ptt, &age_ms, &stale);
+    }
+    else
+    {
+        status = rig_get_ptt(rig, vfo, &ptt);
+    }
 
     if (status != RIG_OK)
     {
@@ -2536,7 +4332,8 @@ declare_proto_rig(get_ptt)
     }
 
     /* TODO MICDATA */
-    fprintf(fout, "%d%c", ptt, resp_sep);
+    print_int(fout, ptt, resp_sep);
+    print_stale(fout, interactive, prompt, ext_resp, resp_sep, stale, age_ms);
 
     RETURNFUNC(status);
 }
@@ -2562,7 +4359,7 @@ declare_proto_rig(get_dcd)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%d%c", dcd, resp_sep);
+    print_int(fout, dcd, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -2640,7 +4437,7 @@ declare_proto_rig(get_rptr_offs)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%ld%c", rptr_offs, resp_sep);
+    print_int(fout, rptr_offs, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -2679,7 +4476,7 @@ declare_proto_rig(get_ctcss_tone)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%d%c", tone, resp_sep);
+    print_int(fout, tone, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -2718,7 +4515,7 @@ declare_proto_rig(get_dcs_code)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%d%c", code, resp_sep);
+    print_int(fout, code, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -2757,7 +4554,7 @@ declare_proto_rig(get_ctcss_sql)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%d%c", tone, resp_sep);
+    print_int(fout, tone, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -2796,7 +4593,7 @@ declare_proto_rig(get_dcs_sql)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%d%c", code, resp_sep);
+    print_int(fout, code, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -2810,7 +4607,7 @@ declare_proto_rig(set_split_freq)
 
     ENTERFUNC;
 
-    CHKSCN1ARG(sscanf(arg1, "%"SCNfreq, &txfreq));
+    CHKSCN1ARG(num_scan_double(arg1, &txfreq));
 
     RETURNFUNC(rig_set_split_freq(rig, txvfo, txfreq));
 }
@@ -2837,7 +4634,7 @@ declare_proto_rig(get_split_freq)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%"PRIll"%c", (int64_t)txfreq, resp_sep);
+    print_int(fout, (int64_t)txfreq, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -2864,7 +4661,7 @@ declare_proto_rig(set_split_mode)
     // we treat it as non-fatal
     // rig_parse_mode will spit out error msg
     mode = rig_parse_mode(arg1);
-    CHKSCN1ARG(sscanf(arg2, "%d", &width));
+    CHKSCN1ARG(num_scan_int(arg2, &width));
     RETURNFUNC(rig_set_split_mode(rig, txvfo, mode, (pbwidth_t) width));
 }
 
@@ -2898,7 +4695,7 @@ declare_proto_rig(get_split_mode)
         fprintf(fout, "%s: ", cmd->arg2);
     }
 
-    fprintf(fout, "%ld%c", width, resp_sep);
+    print_int(fout, width, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -2922,9 +4719,9 @@ declare_proto_rig(set_split_freq_mode)
         RETURNFUNC(RIG_OK);
     }
 
-    CHKSCN1ARG(sscanf(arg1, "%"SCNfreq, &freq));
+    CHKSCN1ARG(num_scan_double(arg1, &freq));
     mode = rig_parse_mode(arg2);
-    CHKSCN1ARG(sscanf(arg3, "%d", &width));
+    CHKSCN1ARG(num_scan_int(arg3, &width));
     RETURNFUNC(rig_set_split_freq_mode(rig, txvfo, freq, mode, (pbwidth_t) width));
 }
 
@@ -2952,7 +4749,7 @@ declare_proto_rig(get_split_freq_mode)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%"PRIll"%c", (int64_t)freq, resp_sep);
+    print_int(fout, (int64_t)freq, resp_sep);
 
     if ((interactive && prompt) || (interactive && !prompt && ext_resp))
     {
@@ -2966,7 +4763,7 @@ declare_proto_rig(get_split_freq_mode)
         fprintf(fout, "%s: ", cmd->arg3);
     }
 
-    fprintf(fout, "%ld%c", width, resp_sep);
+    print_int(fout, width, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -3025,7 +4822,7 @@ declare_proto_rig(get_split_vfo)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%d%c", split, resp_sep);
+    print_int(fout, split, resp_sep);
 
     if ((interactive && prompt) || (interactive && !prompt && ext_resp))
     {
@@ -3071,7 +4868,7 @@ declare_proto_rig(get_ts)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%ld%c", ts, resp_sep);
+    print_int(fout, ts, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -3137,7 +4934,7 @@ declare_proto_rig(mW2power)
         fprintf(fout, "%s: ", cmd->arg4);
     }
 
-    fprintf(fout, "%f%c", power, resp_sep);
+    print_float(fout, power, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -3202,11 +4999,11 @@ declare_proto_rig(set_level)
 
         case RIG_CONF_CHECKBUTTON:
         case RIG_CONF_COMBO:
-            CHKSCN1ARG(sscanf(arg2, "%d", &val.i));
+            CHKSCN1ARG(num_scan_int(arg2, &val.i));
             break;
 
         case RIG_CONF_NUMERIC:
-            CHKSCN1ARG(sscanf(arg2, "%f", &val.f));
+            CHKSCN1ARG(num_scan_float(arg2, &val.f));
             break;
 
         case RIG_CONF_STRING:
@@ -3222,11 +5019,11 @@ declare_proto_rig(set_level)
 
     if (RIG_LEVEL_IS_FLOAT(level))
     {
-        CHKSCN1ARG(sscanf(arg2, "%f", &val.f));
+        CHKSCN1ARG(num_scan_float(arg2, &val.f));
     }
     else
     {
-        CHKSCN1ARG(sscanf(arg2, "%d", &val.i));
+        CHKSCN1ARG(num_scan_int(arg2, &val.i));
     }
 
     RETURNFUNC(rig_set_level(rig, vfo, level, val));
@@ -3292,11 +5089,11 @@ declare_proto_rig(get_level)
 
         case RIG_CONF_CHECKBUTTON:
         case RIG_CONF_COMBO:
-            fprintf(fout, "%d\n", val.i);
+            print_int(fout, val.i, '\n');
             break;
 
         case RIG_CONF_NUMERIC:
-            fprintf(fout, "%f\n", val.f);
+            print_float(fout, val.f, '\n');
             break;
 
         case RIG_CONF_STRING:
@@ -3324,11 +5121,11 @@ declare_proto_rig(get_level)
 
     if (RIG_LEVEL_IS_FLOAT(level))
     {
-        fprintf(fout, "%f%c", val.f, resp_sep);
+        print_float(fout, val.f, resp_sep);
     }
     else
     {
-        fprintf(fout, "%d%c", val.i, resp_sep);
+        print_int(fout, val.i, resp_sep);
     }
 
     RETURNFUNC(status);
@@ -3364,12 +5161,12 @@ declare_proto_rig(set_func)
             RETURNFUNC(-RIG_ENAVAIL);    /* no such parameter */
         }
 
-        CHKSCN1ARG(sscanf(arg2, "%d", &func_stat));
+        CHKSCN1ARG(num_scan_int(arg2, &func_stat));
 
         RETURNFUNC(rig_set_ext_func(rig, vfo, cfp->token, func_stat));
     }
 
-    CHKSCN1ARG(sscanf(arg2, "%d", &func_stat));
+    CHKSCN1ARG(num_scan_int(arg2, &func_stat));
     RETURNFUNC(rig_set_func(rig, vfo, func, func_stat));
 }
 
@@ -3416,7 +5213,7 @@ declare_proto_rig(get_func)
             fprintf(fout, "%s: ", cmd->arg2);
         }
 
-        fprintf(fout, "%d\n", func_stat);
+        print_int(fout, func_stat, '\n');
 
         RETURNFUNC(status);
     }
@@ -3433,7 +5230,7 @@ declare_proto_rig(get_func)
         fprintf(fout, "%s: ", cmd->arg2);
     }
 
-    fprintf(fout, "%d\n", func_stat);
+    print_int(fout, func_stat, '\n');
 
     RETURNFUNC(status);
 }
@@ -3477,11 +5274,11 @@ declare_proto_rig(set_parm)
 
         case RIG_CONF_CHECKBUTTON:
         case RIG_CONF_COMBO:
-            CHKSCN1ARG(sscanf(arg2, "%d", &val.i));
+            CHKSCN1ARG(num_scan_int(arg2, &val.i));
             break;
 
         case RIG_CONF_NUMERIC:
-            CHKSCN1ARG(sscanf(arg2, "%f", &val.f));
+            CHKSCN1ARG(num_scan_float(arg2, &val.f));
             break;
 
         case RIG_CONF_STRING:
@@ -3501,11 +5298,11 @@ declare_proto_rig(set_parm)
 
     if (RIG_PARM_IS_FLOAT(parm))
     {
-        CHKSCN1ARG(sscanf(arg2, "%f", &val.f));
+        CHKSCN1ARG(num_scan_float(arg2, &val.f));
     }
     else
     {
-        CHKSCN1ARG(sscanf(arg2, "%d", &val.i));
+        CHKSCN1ARG(num_scan_int(arg2, &val.i));
     }
 
     RETURNFUNC(rig_set_parm(rig, parm, val));
@@ -3581,11 +5378,11 @@ declare_proto_rig(get_parm)
 
         case RIG_CONF_CHECKBUTTON:
         case RIG_CONF_COMBO:
-            fprintf(fout, "%d\n", val.i);
+            print_int(fout, val.i, '\n');
             break;
 
         case RIG_CONF_NUMERIC:
-            fprintf(fout, "%f\n", val.f);
+            print_float(fout, val.f, '\n');
             break;
 
         case RIG_CONF_STRING:
@@ -3617,11 +5414,11 @@ declare_proto_rig(get_parm)
 
     if (RIG_PARM_IS_FLOAT(parm))
     {
-        fprintf(fout, "%f\n", val.f);
+        print_float(fout, val.f, '\n');
     }
     else
     {
-        fprintf(fout, "%d\n", val.i);
+        print_int(fout, val.i, '\n');
     }
 
     RETURNFUNC(status);
@@ -3674,7 +5471,7 @@ declare_proto_rig(get_mem)
         fprintf(fout, "%s: ", cmd->arg1);
     }
 
-    fprintf(fout, "%d%c", ch, resp_sep);
+    print_int(fout, ch, resp_sep);
 
     RETURNFUNC(status);
 }
@@ -4535,7 +6332,7 @@ declare_proto_rig(get_ant)
         fprintf(fout, "%s: ", cmd->arg2);
     }
 
-    fprintf(fout, "%d%c", option.i, resp_sep);
+    print_int(fout, option.i, resp_sep);
 
     if ((interactive && prompt) || (interactive && !prompt && ext_resp))
     {
@@ -4745,7 +6542,7 @@ declare_proto_rig(send_cmd)
             || backend_num == RIG_ICOM
             || backend_num == RIG_KACHINA
             || backend_num == RIG_MICROTUNE
-            || (strstr(arg1, "\\0x") && (rig->caps->rig_model != RIG_MODEL_NETRIGCTL))
+            || (strstr(arg1, "\\0x") && (!RIG_MODEL_IS_NETRIGCTL(rig->caps->rig_model)))
        )
     {
 
@@ -4771,7 +6568,7 @@ declare_proto_rig(send_cmd)
         /* no End Of Message chars */
         eom_buf[0] = '\0';
     }
-    else if (rig->caps->rig_model == RIG_MODEL_NETRIGCTL)
+    else if (RIG_MODEL_IS_NETRIGCTL(rig->caps->rig_model))
     {
         rig_debug(RIG_DEBUG_TRACE, "%s: we're netrigctl#2\n", __func__);
 
@@ -5278,3 +7075,335 @@ declare_proto_rig(get_lock_mode)
     fprintf(fout, "%d\n", lock);
     return RIG_OK;
 }
+
+static rigctl_stats_cb_t stats_cb;
+
+void rigctl_set_stats(rigctl_stats_cb_t stats)
+{
+    stats_cb = stats;
+}
+
+/* '0xa4' */
+declare_proto_rig(get_stats)
+{
+    char buf[2048];
+    int retval;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s:\n", __func__);
+
+    retval = rig_get_stats_info(rig, buf, sizeof(buf));
+
+    if (retval != RIG_OK)
+    {
+        return retval;
+    }
+
+    fprintf(fout, "%s\n", buf);
+
+    if (stats_cb) { stats_cb(rig, fout); }
+
+    return RIG_OK;
+}
+
+/* '0xa5' */
+declare_proto_rig(reset_stats)
+{
+    rig_debug(RIG_DEBUG_TRACE, "%s:\n", __func__);
+
+    if (stats_cb) { stats_cb(rig, NULL); }
+
+    return rig_reset_stats(rig);
+}
+
+
+static rigctl_subscribe_cb_t subscribe_cb;
+
+void rigctl_set_subscribe(rigctl_subscribe_cb_t subscribe)
+{
+    subscribe_cb = subscribe;
+}
+
+/* '0xa6' */
+declare_proto_rig(subscribe)
+{
+    static const struct
+    {
+        const char *name;
+        unsigned int event;
+    } events[] =
+    {
+        { "freq", RIGCTL_EV_FREQ },
+        { "mode", RIGCTL_EV_MODE },
+        { "ptt", RIGCTL_EV_PTT },
+        { "vfo", RIGCTL_EV_VFO },
+        { "split", RIGCTL_EV_SPLIT },
+        { "dtmf", RIGCTL_EV_DTMF },
+        { "all", RIGCTL_EV_ALL },
+        { "none", 0 },
+    };
+    unsigned int mask = 0;
+    const char *p = arg1;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: %s\n", __func__, arg1);
+
+    if (!subscribe_cb)
+    {
+        return -RIG_ENAVAIL;    /* only rigctld can push */
+    }
+
+    while (*p)
+    {
+        size_t len = strcspn(p, ",");
+        int i, n = sizeof(events) / sizeof(events[0]);
+
+        for (i = 0; i < n; i++)
+        {
+            if (strlen(events[i].name) == len && !strncasecmp(p, events[i].name, len))
+            {
+                mask |= events[i].event;
+                break;
+            }
+        }
+
+        if (i == n)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: unknown event '%.*s'\n", __func__, (int)len,
+                      p);
+            return -RIG_EINVAL;
+        }
+
+        p += len;
+
+        if (*p == ',') { p++; }
+    }
+
+    return subscribe_cb(fout, mask);
+}
+
+
+static int print_spectrum_history(RIG *rig, struct rig_spectrum_line *line,
+                                  int age_ms, rig_ptr_t arg)
+{
+    FILE *fout = arg;
+    freq_t low = line->low_edge_freq;
+    freq_t high = line->high_edge_freq;
+    size_t i;
+
+    if (line->spectrum_mode == RIG_SPECTRUM_MODE_CENTER)
+    {
+        low = line->center_freq - line->span_freq / 2;
+        high = line->center_freq + line->span_freq / 2;
+    }
+
+    fprintf(fout, "%d %.0f %.0f %d %d ", age_ms, low, high,
+            line->data_level_min, line->data_level_max);
+
+    for (i = 0; i < line->spectrum_data_length; i++)
+    {
+        fprintf(fout, "%02x", line->spectrum_data[i]);
+    }
+
+    fputc('\n', fout);
+
+    return 1;
+}
+
+/* '0xa7' */
+declare_proto_rig(get_spectrum_history)
+{
+    int id, age_ms;
+    int retval;
+
+    ENTERFUNC;
+
+    CHKSCN1ARG(sscanf(arg1, "%d", &id));
+    CHKSCN1ARG(sscanf(arg2, "%d", &age_ms));
+
+    retval = rig_get_spectrum_history(rig, id, age_ms, print_spectrum_history,
+                                      fout);
+
+    RETURNFUNC(retval < 0 ? retval : RIG_OK);
+}
+
+
+/* '0xa8' */
+declare_proto_rig(set_doppler)
+{
+    struct rig_doppler conf;
+
+    ENTERFUNC;
+
+    memset(&conf, 0, sizeof(conf));
+    CHKSCN1ARG(sscanf(arg1, "%"SCNfreq, &conf.downlink));
+    CHKSCN1ARG(sscanf(arg2, "%"SCNfreq, &conf.uplink));
+
+    if (conf.downlink == 0 && conf.uplink == 0)
+    {
+        RETURNFUNC(rig_set_doppler(rig, NULL));
+    }
+
+    RETURNFUNC(rig_set_doppler(rig, &conf));
+}
+
+
+/* '0xa9' */
+declare_proto_rig(add_doppler)
+{
+    struct rig_doppler_sample sample;
+
+    ENTERFUNC;
+
+    CHKSCN1ARG(sscanf(arg1, "%lf", &sample.time));
+    CHKSCN1ARG(sscanf(arg2, "%lf", &sample.range_rate));
+
+    /* 0 for now */
+    if (sample.time == 0)
+    {
+        struct timespec ts;
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        sample.time = ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+
+    RETURNFUNC(rig_add_doppler(rig, &sample, 1));
+}
+
+
+/* '0xaa' */
+/*
+ * FNV-1a hash of what \dump_state answers, so netrigctl can tell whether
+ * a dump_state it kept from an earlier connect still holds and skip
+ * reading it.  Only clients that go on with chk_vfo ask, so the hash is
+ * of the protocol 1 answer.
+ */
+declare_proto_rig(dump_state_hash)
+{
+    ENTERFUNC;
+
+#ifdef HAVE_OPEN_MEMSTREAM
+    {
+        char *buf = NULL;
+        size_t len = 0, i;
+        unsigned long long h = 14695981039346656037ULL;
+        FILE *mem;
+        int ret;
+
+        mem = open_memstream(&buf, &len);
+
+        if (!mem)
+        {
+            RETURNFUNC(-RIG_ENOMEM);
+        }
+
+        chk_vfo_executed = 1;
+        ret = ACTION(dump_state)(rig, mem, fin, interactive, prompt, vfo_opt,
+                                 send_cmd_term, ext_resp, resp_sep, cmd, vfo,
+                                 arg1, arg2, arg3);
+        fclose(mem);
+
+        for (i = 0; i < len; i++)
+        {
+            h ^= (unsigned char) buf[i];
+            h *= 1099511628211ULL;
+        }
+
+        free(buf);
+
+        if (ret != RIG_OK)
+        {
+            RETURNFUNC(ret);
+        }
+
+        if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+        {
+            fprintf(fout, "%s: ", cmd->arg1);
+        }
+
+        fprintf(fout, "%016llx%c", h, resp_sep);
+    }
+
+    RETURNFUNC(RIG_OK);
+#else
+    RETURNFUNC(-RIG_ENIMPL);
+#endif
+}
+
+
+/* '0xac' */
+/*
+ * One line per journal record: stamp, record number, field, VFO, value.
+ * Stamps below zero count back from now, an end of 0 is now.
+ */
+declare_proto_rig(get_journal)
+{
+    struct rig_journal_record recs[256];
+    long long since, until;
+    uint32_t last_seq = 0;
+    int first = 1;
+    int n, i;
+
+    ENTERFUNC;
+
+    CHKSCN1ARG(sscanf(arg1, "%lld", &since));
+    CHKSCN1ARG(sscanf(arg2, "%lld", &until));
+
+    if (since < 0 || until < 0)
+    {
+        struct timespec now;
+        long long now_ms;
+
+        clock_gettime(CLOCK_REALTIME, &now);
+        now_ms = (long long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+
+        if (since < 0) { since += now_ms; }
+
+        if (until < 0) { until += now_ms; }
+    }
+
+    do
+    {
+        n = rig_get_journal(rig, since, until, recs, 256);
+
+        if (n < 0) { RETURNFUNC(n); }
+
+        for (i = 0; i < n; i++)
+        {
+            const struct rig_journal_record *r = &recs[i];
+
+            // records at the stamp we started again from came already
+            if (!first && (int32_t)(r->seq - last_seq) <= 0) { continue; }
+
+            fprintf(fout, "%lld %u %s %s ", (long long) r->ms, r->seq,
+                    rig_strjournal(r->field), rig_strvfo(r->vfo));
+
+            switch (r->field)
+            {
+            case RIG_JOURNAL_FREQ:
+                fprintf(fout, "%.0f\n", r->value.f);
+                break;
+
+            case RIG_JOURNAL_MODE:
+                fprintf(fout, "%s\n", rig_strrmode(r->value.i));
+                break;
+
+            case RIG_JOURNAL_VFO:
+                fprintf(fout, "%s\n", rig_strvfo(r->value.i));
+                break;
+
+            default:
+                fprintf(fout, "%lld\n", (long long) r->value.i);
+            }
+        }
+
+        if (n > 0)
+        {
+            // a whole batch in one ms would come back for ever
+            since = recs[n - 1].ms + (recs[0].ms == recs[n - 1].ms);
+            last_seq = recs[n - 1].seq;
+            first = 0;
+        }
+    }
+    while (n == 256);
+
+    RETURNFUNC(RIG_OK);
+}
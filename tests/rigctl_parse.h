@@ -44,13 +44,114 @@ int dumpconf(RIG *, FILE *);
 void usage_rig(FILE *);
 void version();
 void list_models();
+void list_usb();
 int dump_chan(FILE *, RIG *, channel_t *);
 int print_conf_list(const struct confparams *cfp, rig_ptr_t data);
 int set_conf(RIG *my_rig, char *conf_parms);
 
+/* command byte for a short or long command name, 0 if unknown */
+int rigctl_cmd_lookup(const char *name);
+/* long name for a command byte, NULL if unknown */
+const char *rigctl_cmd_name(int cmd);
+
 typedef void (*sync_cb_t)(int);
 int rigctl_parse(RIG *my_rig, FILE *fin, FILE *fout, char *argv[], int argc, sync_cb_t sync_cb,
                  int interactive, int prompt, int * vfo_mode, char send_cmd_term,
                  int * ext_resp_ptr, char * resp_sep_ptr, int use_password);
 
+/*
+ * Pipelining for rigctld: a command sent as "#<id> cmd" gets its reply
+ * prefixed with "#<id> ".  With hooks installed, tagged reads the cache can
+ * answer are replied at once and everything else is handed to defer() to be
+ * run later, in order, by the caller.  pending() reports how many deferred
+ * commands (or only setters) are still outstanding for that client stream.
+ */
+typedef int (*rigctl_pending_cb_t)(FILE *fout, int setters_only);
+typedef int (*rigctl_defer_cb_t)(FILE *fout, const char *tag,
+                                 const char *line, int setter);
+void rigctl_set_pipeline(rigctl_pending_cb_t pending, rigctl_defer_cb_t defer);
+
+/*
+ * Push subscriptions for rigctld: after "\subscribe freq,ptt" the daemon
+ * writes "!freq ..." style lines to that connection whenever the state
+ * changes.  subscribe() is given the connection's stream and the event mask,
+ * 0 to stop, and returns a Hamlib status.
+ */
+#define RIGCTL_EV_FREQ  0x01
+#define RIGCTL_EV_MODE  0x02
+#define RIGCTL_EV_PTT   0x04
+#define RIGCTL_EV_VFO   0x08
+#define RIGCTL_EV_SPLIT 0x10
+#define RIGCTL_EV_DTMF  0x20
+#define RIGCTL_EV_ALL   0x3f
+
+typedef int (*rigctl_subscribe_cb_t)(FILE *fout, unsigned int events);
+void rigctl_set_subscribe(rigctl_subscribe_cb_t subscribe);
+
+/*
+ * rigctld adds its per-connection counters to \get_stats through this,
+ * "Name=value" lines written to fout; \reset_stats calls it with fout NULL.
+ */
+typedef void (*rigctl_stats_cb_t)(RIG *rig, FILE *fout);
+void rigctl_set_stats(rigctl_stats_cb_t stats);
+
+/*
+ * Non-zero makes get_freq, get_mode and get_ptt answer through
+ * rig_get_*_swr(): the cached value at once, a "Stale: <ms>" line in the
+ * extended response when it is past the cache timeout.
+ */
+void rigctl_set_serve_stale(int stale);
+
+/*
+ * Non-zero runs every command under rig_set_deadline(ms): reads give up
+ * and retries stop when it passes, get_freq, get_mode and get_ptt then
+ * answer from the cache.
+ */
+void rigctl_set_deadline(int ms);
+
+/*
+ * Buffer based entry point for rigctld: parses one command line in memory,
+ * without stdio on the way in, and leaves the reply in out->buf.  Returns
+ * as rigctl_parse() or, having done nothing, RIGCTL_PARSE_INCOMPLETE when
+ * the command needs more than the line holds (arguments on later lines,
+ * set_channel) so the caller can fall back to rigctl_parse().
+ */
+#ifdef HAVE_FMEMOPEN
+#define RIGCTL_PARSE_BUF 1
+#define RIGCTL_PARSE_INCOMPLETE 3
+
+struct rigctl_out
+{
+    char *buf;          /* preallocated by the caller */
+    size_t size;
+    size_t len;         /* reply length, at most size */
+};
+
+int rigctl_parse_buf(RIG *my_rig, const char *line, size_t len,
+                     struct rigctl_out *out, sync_cb_t sync_cb, int *vfo_mode,
+                     char send_cmd_term, int *ext_resp_ptr, char *resp_sep_ptr,
+                     int use_password);
+
+/*
+ * rigctl -b: run the script read from fin, queueing setters and reading
+ * consecutive gets in one rig_get_bulk(), then write every command's reply
+ * to fout in script order.  Returns the number of failed commands.
+ */
+int rigctl_batch(RIG *rig, FILE *fin, FILE *fout, int *vfo_mode,
+                 char send_cmd_term);
+#endif
+
+/*
+ * Binary rigctld protocol, see rigctl_parse_bin() and rigctld(1).  A client
+ * opts in by sending RIGCTL_BIN_MAGIC first; rigctld echoes it back.
+ */
+#if defined(HAVE_FMEMOPEN) && defined(HAVE_OPEN_MEMSTREAM)
+#define RIGCTL_BINARY 1
+#define RIGCTL_BIN_MAGIC "\0HLB\1"
+#define RIGCTL_BIN_MAGIC_LEN 5
+
+int rigctl_parse_bin(RIG *my_rig, FILE *fin, FILE *fout, sync_cb_t sync_cb,
+                     int *vfo_mode, int use_password);
+#endif
+
 #endif  /* RIGCTL_PARSE_H */
@@ -9,6 +9,9 @@
  *   on the -r comport.  The -R port speed can be set with -S and always runs 8N1
  *   This allows programs that can do a TS-2000-over-serial-port to talk
  *   to any rig that hamlib supports.
+ *   -R may be given several times, one legacy program per virtual port, all
+ *   sharing the one rig.  Queries are answered from the Hamlib cache, which
+ *   the poll routine (-i) keeps fresh, so they add no load on the rig.
  *   Also supports rigctld or flrig for multiple connections (i.e. rig sharing).
  *
  *   This program is free software; you can redistribute it and/or modify
@@ -56,6 +59,11 @@
 // cppcheck-suppress *
 #include <sys/types.h>
 
+#ifdef HAVE_PTHREAD
+// cppcheck-suppress *
+#  include <pthread.h>
+#endif
+
 #ifdef HAVE_NETINET_IN_H
 // cppcheck-suppress *
 #  include <netinet/in.h>
@@ -83,6 +91,7 @@
 #include "serial.h"
 #include "sprintflst.h"
 #include "rigctl_parse.h"
+#include "event.h"
 
 /*
  * Reminder: when adding long options,
@@ -90,7 +99,7 @@
  * NB: do NOT use -W since it's reserved by POSIX.
  * TODO: add an option to read from a file
  */
-#define SHORT_OPTIONS "B:m:r:R:p:d:P:D:s:S:c:C:lLuvhVZ"
+#define SHORT_OPTIONS "B:m:r:R:p:d:P:D:s:S:c:C:i:lLuvhVZ"
 static struct option long_options[] =
 {
     {"mapa2b",          0, 0, 'B'},
@@ -105,6 +114,7 @@ static struct option long_options[] =
     {"serial-speed2",   1, 0, 'S'},
     {"civaddr",         1, 0, 'c'},
     {"set-conf",        1, 0, 'C'},
+    {"poll-interval",   1, 0, 'i'},
     {"list",            0, 0, 'l'},
     {"show-conf",       0, 0, 'L'},
     {"dump-caps",       0, 0, 'u'},
@@ -116,10 +126,14 @@ static struct option long_options[] =
 };
 
 void usage();
-static int handle_ts2000(void *arg);
+static int handle_ts2000(hamlib_port_t *com, void *arg);
+
+/* one legacy program per virtual COM port, each served by its own thread */
+#define MAX_COM_PORTS 8
 
 static RIG *my_rig;             /* handle to rig */
-static hamlib_port_t my_com;    /* handle to virtual COM port */
+static hamlib_port_t my_com[MAX_COM_PORTS]; /* handles to virtual COM ports */
+static int n_com;
 static int verbose;
 /* CW Skimmer can only set VFOA */
 /* IC7300 for example can run VFOA on FM and VFOB on CW */
@@ -207,6 +221,55 @@ static void handle_error(enum rig_debug_level_e lvl, const char *msg)
 #endif  /* if 0 */
 
 
+/*
+ * Serve the legacy program on one virtual COM port until ^C.  The rig
+ * calls take the per-RIG lock, so the ports share the rig safely.
+ */
+static void com_loop(hamlib_port_t *com)
+{
+    do
+    {
+        char ts2000[1024];
+        char *stop_set = ";\n\r";
+        int status;
+
+        memset(ts2000, 0, sizeof(ts2000));
+
+        status = read_string(com,
+                             (unsigned char *) ts2000,
+                             sizeof(ts2000),
+                             stop_set,
+                             strlen(stop_set),
+                             0,
+                             1);
+
+        rig_debug(RIG_DEBUG_TRACE, "%s: %s status=%d\n", __func__, com->pathname,
+                  status);
+
+        if (strlen(ts2000) > 0)
+        {
+            int retval = handle_ts2000(com, ts2000);
+
+            if (retval != RIG_OK)
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: %s\n", __func__, rigerror(retval));
+            }
+        }
+
+    }
+    while (!ctrl_c);
+}
+
+#ifdef HAVE_PTHREAD
+static void *com_thread(void *arg)
+{
+    com_loop((hamlib_port_t *)arg);
+
+    return NULL;
+}
+#endif
+
+
 int main(int argc, char *argv[])
 {
     rig_model_t my_model = RIG_MODEL_DUMMY;
@@ -215,15 +278,15 @@ int main(int argc, char *argv[])
 
     int show_conf = 0;
     int dump_caps_opt = 0;
-    const char *rig_file = NULL, *rig_file2 = NULL, *ptt_file = NULL,
-                *dcd_file = NULL;
+    const char *rig_file = NULL, *ptt_file = NULL, *dcd_file = NULL;
     ptt_type_t ptt_type = RIG_PTT_NONE;
     dcd_type_t dcd_type = RIG_DCD_NONE;
     int serial_rate = 0;
     int serial_rate2 = 115200;  /* virtual com port default speed */
     char *civaddr = NULL;       /* NULL means no need to set conf */
     char conf_parms[MAXCONFLEN] = "";
-    int status;
+    int poll_interval = 500;    /* ms, 0 answers every query from the rig */
+    int i;
 
     printf("rigctlcom Version 1.3\n");
 
@@ -285,7 +348,13 @@ int main(int argc, char *argv[])
                 exit(1);
             }
 
-            rig_file2 = optarg;
+            if (n_com == MAX_COM_PORTS)
+            {
+                fprintf(stderr, "At most %d -R com ports\n", MAX_COM_PORTS);
+                exit(1);
+            }
+
+            strncpy(my_com[n_com++].pathname, optarg, HAMLIB_FILPATHLEN - 1);
             break;
 
 
@@ -420,6 +489,16 @@ int main(int argc, char *argv[])
             serial_rate2 = atoi(optarg);
             break;
 
+        case 'i':
+            if (!optarg)
+            {
+                usage();        /* wrong arg count */
+                exit(1);
+            }
+
+            poll_interval = atoi(optarg);
+            break;
+
 
         case 'C':
             if (!optarg)
@@ -494,6 +573,9 @@ int main(int argc, char *argv[])
         exit(2);
     }
 
+    // before set_conf so -C poll_interval= still wins
+    my_rig->state.poll_interval = poll_interval;
+
     retcode = set_conf(my_rig, conf_parms);
 
     if (retcode != RIG_OK)
@@ -513,13 +595,21 @@ int main(int argc, char *argv[])
         strncpy(my_rig->state.rigport.pathname, rig_file, HAMLIB_FILPATHLEN - 1);
     }
 
-    if (!rig_file2)
+    if (n_com == 0)
     {
         fprintf(stderr, "-R com port not provided\n");
         exit(2);
     }
 
-    strncpy(my_com.pathname, rig_file2, HAMLIB_FILPATHLEN - 1);
+#ifndef HAVE_PTHREAD
+
+    if (n_com > 1)
+    {
+        fprintf(stderr, "Several -R com ports need thread support\n");
+        exit(2);
+    }
+
+#endif
 
     /*
      * ex: RIG_PTT_PARALLEL and /dev/parport0
@@ -550,9 +640,12 @@ int main(int argc, char *argv[])
         my_rig->state.rigport.parm.serial.rate = serial_rate;
     }
 
-    if (serial_rate2 != 0)
+    for (i = 0; i < n_com; i++)
     {
-        my_com.parm.serial.rate = serial_rate2;
+        if (serial_rate2 != 0)
+        {
+            my_com[i].parm.serial.rate = serial_rate2;
+        }
     }
 
 
@@ -602,55 +695,68 @@ int main(int argc, char *argv[])
     /*
      * main loop
      */
-    my_com.type.rig = RIG_PORT_SERIAL;
-    my_com.parm.serial.data_bits = 8;
-    my_com.parm.serial.stop_bits = 1;
-    my_com.timeout = 5000;
-    my_com.parm.serial.parity = RIG_PARITY_NONE;
-    my_com.parm.serial.handshake = RIG_HANDSHAKE_NONE;
+    for (i = 0; i < n_com; i++)
+    {
+        int status;
 
-    status = port_open(&my_com);
+        my_com[i].type.rig = RIG_PORT_SERIAL;
+        my_com[i].parm.serial.data_bits = 8;
+        my_com[i].parm.serial.stop_bits = 1;
+        my_com[i].timeout = 5000;
+        my_com[i].parm.serial.parity = RIG_PARITY_NONE;
+        my_com[i].parm.serial.handshake = RIG_HANDSHAKE_NONE;
 
-    if (status != RIG_OK)
-    {
-        rig_debug(RIG_DEBUG_ERR, "Unable to open %s\n", my_com.pathname);
-        exit(2);
-    }
+        status = port_open(&my_com[i]);
 
-    if (verbose > 0)
-    {
-        fprintf(stderr, " %s opened for application program\n", my_com.pathname);
+        if (status != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_ERR, "Unable to open %s\n", my_com[i].pathname);
+            exit(2);
+        }
+
+        if (verbose > 0)
+        {
+            fprintf(stderr, " %s opened for application program\n", my_com[i].pathname);
+        }
     }
 
-    do
+#ifdef HAVE_PTHREAD
     {
-        char ts2000[1024];
-        char *stop_set = ";\n\r";
-
-        memset(ts2000, 0, sizeof(ts2000));
+        pthread_t com_threads[MAX_COM_PORTS];
 
-        status = read_string(&my_com,
-                             (unsigned char *) ts2000,
-                             sizeof(ts2000),
-                             stop_set,
-                             strlen(stop_set),
-                             0,
-                             1);
+        // one poller fills the cache for all the ports
+        if (my_rig->state.poll_interval > 0)
+        {
+            retcode = rig_poll_routine_start(my_rig);
 
-        rig_debug(RIG_DEBUG_TRACE, "%s: status=%d\n", __func__, status);
+            if (retcode != RIG_OK)
+            {
+                fprintf(stderr, "rig_poll_routine_start: error = %s \n", rigerror(retcode));
+                exit(2);
+            }
+        }
 
-        if (strlen(ts2000) > 0)
+        for (i = 1; i < n_com; i++)
         {
-            int retval = handle_ts2000(ts2000);
-
-            if (retval != RIG_OK)
+            if (pthread_create(&com_threads[i], NULL, com_thread, &my_com[i]) != 0)
             {
-                rig_debug(RIG_DEBUG_ERR, "%s: %s\n", __func__, rigerror(retval));
+                fprintf(stderr, "pthread_create: %s\n", strerror(errno));
+                exit(2);
             }
         }
 
+        com_loop(&my_com[0]);
+
+        for (i = 1; i < n_com; i++)
+        {
+            pthread_join(com_threads[i], NULL);
+        }
+
+        rig_poll_routine_stop(my_rig);
     }
-    while (retcode == 0 && !ctrl_c);
+#else
+    com_loop(&my_com[0]);
+#endif
 
     rig_close(my_rig);          /* close port */
     rig_cleanup(my_rig);        /* if you care about memory */
@@ -718,7 +824,7 @@ static int write_block2(void *func,
 /*
  * This handles the TS-2000 emulation
  */
-static int handle_ts2000(void *arg)
+static int handle_ts2000(hamlib_port_t *com, void *arg)
 {
     rig_debug(RIG_DEBUG_VERBOSE, "%s: cmd=%s\n", __func__, (char *)arg);
 
@@ -726,13 +832,13 @@ static int handle_ts2000(void *arg)
     if (strcmp(arg, "ID;") == 0)
     {
         char *reply = "ID019;";
-        return write_block2((void *)__func__, &my_com, reply, strlen(reply));
+        return write_block2((void *)__func__, com, reply, strlen(reply));
     }
 
     if (strcmp(arg, "AI;") == 0)
     {
         char *reply = "AI0;";
-        return write_block2((void *)__func__, &my_com, reply, strlen(reply));
+        return write_block2((void *)__func__, com, reply, strlen(reply));
     }
     else if (strcmp(arg, "IF;") == 0)
     {
@@ -825,7 +931,7 @@ static int handle_ts2000(void *arg)
                  p14,
                  p15);
 
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strcmp(arg, "MD;") == 0)
     {
@@ -833,14 +939,14 @@ static int handle_ts2000(void *arg)
         char response[32];
 
         SNPRINTF(response, sizeof(response), "MD%1d;", (int)mode);
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strcmp(arg, "AG0;") == 0)
     {
         char response[32];
 
         SNPRINTF(response, sizeof(response), "AG0000;");
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strcmp(arg, "FA;") == 0)
     {
@@ -858,7 +964,7 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "FA%011"PRIll";", (uint64_t)freq);
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strcmp(arg, "FB;") == 0)
     {
@@ -875,14 +981,14 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "FB%011"PRIll";", (uint64_t)freq);
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strcmp(arg, "SA;") == 0)
     {
         char response[32];
 
         SNPRINTF(response, sizeof(response), "SA0;");
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strcmp(arg, "RX;") == 0)
     {
@@ -890,7 +996,7 @@ static int handle_ts2000(void *arg)
 
         rig_set_ptt(my_rig, vfo_fixup(my_rig, RIG_VFO_A, my_rig->state.cache.split), 0);
         SNPRINTF(response, sizeof(response), "RX0;");
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     // Now some commands to set things
     else if (strncmp(arg, "SA", 2) == 0)
@@ -966,7 +1072,7 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "FR%c;", nvfo + '0');
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
 
         return retval;
     }
@@ -995,7 +1101,7 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "FT%c;", nvfo + '0');
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
 
         return retval;
     }
@@ -1013,7 +1119,7 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "TN%02d;", val);
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strncmp(arg, "TN", 2) == 0)
     {
@@ -1049,7 +1155,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *responsetmp = "?;";
-                return write_block2((void *)__func__, &my_com, responsetmp,
+                return write_block2((void *)__func__, com, responsetmp,
                                     strlen(responsetmp));
             }
 
@@ -1068,7 +1174,7 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "PA%c%c;", valA + '0', valB + '0');
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strncmp(arg, "PA", 2) == 0)
     {
@@ -1119,7 +1225,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *responsetmp = "?;";
-                return write_block2((void *)__func__, &my_com, responsetmp,
+                return write_block2((void *)__func__, com, responsetmp,
                                     strlen(responsetmp));
             }
 
@@ -1127,7 +1233,7 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "XT%c;", val + '0');
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strncmp(arg, "XT", 2) == 0)
     {
@@ -1144,7 +1250,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *response = "?;";
-                return write_block2((void *)__func__, &my_com, response, strlen(response));
+                return write_block2((void *)__func__, com, response, strlen(response));
             }
         }
 
@@ -1163,7 +1269,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *responsetmp = "?;";
-                return write_block2((void *)__func__, &my_com, responsetmp,
+                return write_block2((void *)__func__, com, responsetmp,
                                     strlen(responsetmp));
             }
 
@@ -1171,7 +1277,7 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "NR%c;", val + '0');
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strncmp(arg, "NR", 2) == 0)
     {
@@ -1187,7 +1293,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *responsetmp = "?;";
-                return write_block2((void *)__func__, &my_com, responsetmp,
+                return write_block2((void *)__func__, com, responsetmp,
                                     strlen(responsetmp));
             }
         }
@@ -1208,7 +1314,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *responsetmp = "?;";
-                return write_block2((void *)__func__, &my_com, responsetmp,
+                return write_block2((void *)__func__, com, responsetmp,
                                     strlen(responsetmp));
             }
 
@@ -1216,7 +1322,7 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "NB%c;", val + '0');
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strncmp(arg, "NB", 2) == 0)
     {
@@ -1232,7 +1338,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *responsetmp = "?;";
-                return write_block2((void *)__func__, &my_com, responsetmp,
+                return write_block2((void *)__func__, com, responsetmp,
                                     strlen(responsetmp));
             }
         }
@@ -1254,7 +1360,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *responsetmp = "?;";
-                return write_block2((void *)__func__, &my_com, responsetmp,
+                return write_block2((void *)__func__, com, responsetmp,
                                     strlen(responsetmp));
             }
 
@@ -1263,7 +1369,7 @@ static int handle_ts2000(void *arg)
 
         level = val.f * 255;
         SNPRINTF(response, sizeof(response), "AG0%03d;", level);
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strncmp(arg, "AG", 2) == 0)
     {
@@ -1305,7 +1411,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *responsetmp = "?;";
-                return write_block2((void *)__func__, &my_com, responsetmp,
+                return write_block2((void *)__func__, com, responsetmp,
                                     strlen(responsetmp));
             }
 
@@ -1314,7 +1420,7 @@ static int handle_ts2000(void *arg)
 
         speechLevel = val.f * 255;
         SNPRINTF(response, sizeof(response), "PR%03d;", speechLevel);
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strncmp(arg, "PR", 2) == 0)
     {
@@ -1342,7 +1448,7 @@ static int handle_ts2000(void *arg)
         if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
         {
             char *responsetmp = "?;";
-            return write_block2((void *)__func__, &my_com, responsetmp,
+            return write_block2((void *)__func__, com, responsetmp,
                                 strlen(responsetmp));
         }
 
@@ -1363,7 +1469,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *responsetmp = "?;";
-                return write_block2((void *)__func__, &my_com, responsetmp,
+                return write_block2((void *)__func__, com, responsetmp,
                                     strlen(responsetmp));
             }
 
@@ -1372,7 +1478,7 @@ static int handle_ts2000(void *arg)
 
         agcLevel = val.f * 255;
         SNPRINTF(response, sizeof(response), "GT%03d;", agcLevel);
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strncmp(arg, "GT", 2) == 0)
     {
@@ -1414,7 +1520,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *responsetmp = "?;";
-                return write_block2((void *)__func__, &my_com, responsetmp,
+                return write_block2((void *)__func__, com, responsetmp,
                                     strlen(responsetmp));
             }
 
@@ -1423,7 +1529,7 @@ static int handle_ts2000(void *arg)
 
         sqlev = val.f * 255;
         SNPRINTF(response, sizeof(response), "SQ%03d;", sqlev);
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strncmp(arg, "SQ", 2) == 0)
     {
@@ -1450,7 +1556,7 @@ static int handle_ts2000(void *arg)
             if (retval == -RIG_ENIMPL || retval == -RIG_ENAVAIL)
             {
                 char *responsetmp = "?;";
-                return write_block2((void *)__func__, &my_com, responsetmp,
+                return write_block2((void *)__func__, com, responsetmp,
                                     strlen(responsetmp));
             }
         }
@@ -1472,7 +1578,7 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "DC%c;", split + '0');
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
 
         return retval;
     }
@@ -1503,7 +1609,7 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "DC%c;", split + '0');
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
 
         return retval;
     }
@@ -1570,7 +1676,7 @@ static int handle_ts2000(void *arg)
         }
 
         SNPRINTF(response, sizeof(response), "MD%c;", mode + '0');
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strcmp(arg, "PS1;") == 0)
     {
@@ -1585,7 +1691,7 @@ static int handle_ts2000(void *arg)
         char response[32];
 
         SNPRINTF(response, sizeof(response), "PS1;");
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else if (strncmp(arg, "SB", 2) == 0
              || strncmp(arg, "AC", 2) == 0
@@ -1618,7 +1724,7 @@ static int handle_ts2000(void *arg)
         char response[32];
 
         SNPRINTF(response, sizeof(response), "?;");
-        return write_block2((void *)__func__, &my_com, response, strlen(response));
+        return write_block2((void *)__func__, com, response, strlen(response));
     }
     else
     {
@@ -1650,7 +1756,8 @@ void usage()
     printf(
         "  -m, --model=ID                select radio model number. See model list (-l)\n"
         "  -r, --rig-file=DEVICE         set device of the radio to operate on\n"
-        "  -R, --rig-file2=DEVICE        set device of the virtual com port to operate on\n"
+        "  -R, --rig-file2=DEVICE        set device of the virtual com port to operate on,\n"
+        "                                repeat for up to 8 ports sharing the rig\n"
         "  -p, --ptt-file=DEVICE         set device of the PTT device to operate on\n"
         "  -d, --dcd-file=DEVICE         set device of the DCD device to operate on\n"
         "  -P, --ptt-type=TYPE           set type of the PTT device to operate on\n"
@@ -1659,6 +1766,8 @@ void usage()
         "  -S, --serial-speed2=BAUD      set serial speed of the virtual com port [default=115200]\n"
         "  -c, --civaddr=ID              set CI-V address, decimal (for Icom rigs only)\n"
         "  -C, --set-conf=PARM=VAL       set config parameters\n"
+        "  -i, --poll-interval=MS        poll the rig every MS ms, queries are answered\n"
+        "                                from the cache [default=500], 0 to disable\n"
         "  -B, --mapa2b                  maps set_freq on VFOA to VFOB -- useful for CW Skimmer\n"
         "  -L, --show-conf               list all config parameters\n"
         "  -l, --list                    list all model numbers and exit\n"
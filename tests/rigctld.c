@@ -34,6 +34,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <inttypes.h>
+#include <time.h>
 #include <ctype.h>
 #include <errno.h>
 #include <signal.h>
@@ -64,10 +66,41 @@
 #  include <netdb.h>
 #endif
 
+#ifdef HAVE_NETINET_TCP_H
+#  include <netinet/tcp.h>
+#endif
+
 #ifdef HAVE_PTHREAD
 #  include <pthread.h>
 #endif
 
+#ifdef HAVE_SYS_MMAN_H
+#  include <sys/mman.h>
+#endif
+
+#if defined(HAVE_POLL_H) && defined(HAVE_FMEMOPEN)
+#  include <poll.h>
+#  include <fcntl.h>
+#  define RIGCTLD_EVENT_LOOP 1
+#endif
+
+#if defined(HAVE_PTHREAD) && defined(HAVE_FMEMOPEN) && defined(HAVE_OPEN_MEMSTREAM) \
+    && defined(HAVE_FLOCKFILE)
+#  define RIGCTLD_PIPELINE 1
+#endif
+
+#if defined(RIGCTLD_PIPELINE) && defined(HAVE_POLL_H)
+#  define RIGCTLD_SUBSCRIBE 1
+#endif
+
+#if defined(HAVE_PTHREAD) && defined(HAVE_FMEMOPEN)
+#  define RIGCTLD_UDP 1
+#endif
+
+#if defined(HAVE_PTHREAD) && defined(RIGCTLD_EVENT_LOOP)
+#  define RIGCTLD_HTTP 1
+#endif
+
 #include <hamlib/rig.h>
 #include <hamlibdatetime.h>
 #include "misc.h"
@@ -75,8 +108,13 @@
 #include "serial.h"
 #include "sprintflst.h"
 #include "network.h"
+#include "event.h"
 
 #include "rigctl_parse.h"
+#include "executor.h"
+#include "snapshot_data.h"
+#include "sha1.h"
+#include "metrics_http.h"
 
 
 /*
@@ -84,7 +122,7 @@
  *      keep up to date SHORT_OPTIONS, usage()'s output and man page. thanks.
  * TODO: add an option to read from a file
  */
-#define SHORT_OPTIONS "m:r:p:d:P:D:s:S:c:T:t:C:W:w:x:z:lLuovhVZMA:n:"
+#define SHORT_OPTIONS "m:r:p:d:P:D:s:S:c:T:t:C:W:w:x:z:lLuovhVZYEUMA:n:R:K:O:kq:Q:GH:J:F:"
 static struct option long_options[] =
 {
     {"model",           1, 0, 'm'},
@@ -110,16 +148,34 @@ static struct option long_options[] =
     {"twiddle_rit",     1, 0, 'w'},
     {"uplink",          1, 0, 'x'},
     {"debug-time-stamps", 0, 0, 'Z'},
+    {"debug-async",     0, 0, 'Y'},
+    {"event-loop",      0, 0, 'E'},
+    {"udp",             0, 0, 'U'},
     {"multicast-addr",  1, 0, 'M'},
     {"multicast-port",  1, 0, 'n'},
     {"password",        1, 0, 'A'},
+    {"add-rig",         1, 0, 'R'},
+    {"cpu-affinity",    1, 0, 'K'},
+    {"sched",           1, 0, 'O'},
+    {"mlock",           0, 0, 'k'},
+    {"rate-limit",      1, 0, 'q'},
+    {"client-weight",   1, 0, 'Q'},
+    {"serve-stale",     0, 0, 'G'},
+    {"http",            1, 0, 'H'},
+    {"deadline",        1, 0, 'J'},
+    {"replica",         1, 0, 'F'},
     {0, 0, 0, 0}
 };
 
 
+struct rigctld_rig;
+struct rigctld_client;
+
 struct handle_data
 {
     RIG *rig;
+    struct rigctld_rig *served;
+    struct rigctld_client *client;
     int sock;
     struct sockaddr_storage cli_addr;
     socklen_t clilen;
@@ -131,13 +187,84 @@ struct handle_data
 void *handle_socket(void *arg);
 void usage(void);
 
+#ifdef RIGCTLD_EVENT_LOOP
+static int rigctld_event_loop(int vfo_mode);
+#endif
+
+#ifdef RIGCTLD_PIPELINE
+static int pipe_pending(FILE *fout, int setters_only);
+static int pipe_defer(FILE *fout, const char *tag, const char *line,
+                      int setter);
+#endif
+
+#ifdef RIGCTLD_SUBSCRIBE
+static int sub_subscribe(FILE *fout, unsigned int events);
+#endif
+
+#ifdef RIGCTLD_UDP
+static int udp_start(const char *src_addr, const char *portno, int vfo_mode);
+#endif
+
+#ifdef RIGCTLD_HTTP
+static int http_start(const char *src_addr, const char *portno);
+#endif
+
+static void set_nodelay(int sock);
+
 
 #ifdef HAVE_PTHREAD
 static unsigned client_count;
 #endif
 
-static RIG *my_rig;             /* handle to rig (instance) */
-static volatile int rig_opened = 0;
+/*
+ * Every rig the daemon serves, with its own listener and lock so clients
+ * of different rigs never wait on each other.  The first one is the rig
+ * -m and -r describe; UDP, multicast and subscriptions serve only that
+ * one.  Under -E a rig's commands run on its strand of the executor.
+ */
+#define RIGCTLD_MAX_RIGS 8
+
+#ifdef HAVE_PTHREAD
+struct fq_waiter
+{
+    struct fq_waiter *next;
+    double vstart;
+};
+#endif
+
+struct rigctld_rig
+{
+    RIG *rig;                   /* handle to rig (instance) */
+    volatile int opened;
+    const char *portno;
+    int sock_listen;
+#ifdef HAVE_PTHREAD
+    /* the rig itself is busy, see mutex_rigctld(); lock guards the rest */
+    pthread_mutex_t lock;
+    pthread_cond_t turn;
+    int busy;
+    double vtime;
+    double held_vstart;
+    struct rigctld_client *holder;
+    struct timespec held_since;
+    struct fq_waiter *waiters;
+    struct rigctld_client *clients;
+#endif
+#ifdef RIGCTLD_EVENT_LOOP
+    hl_strand_t *strand;
+#endif
+};
+
+static struct rigctld_rig rigs[RIGCTLD_MAX_RIGS];
+static int rig_count = 1;
+
+#define my_rig (rigs[0].rig)
+#define rig_opened (rigs[0].opened)
+
+#ifdef HAVE_PTHREAD
+static pthread_key_t served_key;    /* the rigctld_rig a client thread serves */
+#endif
+
 static int verbose;
 
 #ifdef HAVE_SIG_ATOMIC_T
@@ -157,20 +284,351 @@ extern int lock_mode;
 #define MAXCONFLEN 1024
 
 
+#ifdef HAVE_PTHREAD
+/*
+ * Fair dispatch between connections.  Every command takes its rig through
+ * mutex_rigctld(), and a plain mutex goes to whichever thread the OS wakes
+ * first, so one script polling in a tight loop could keep every other
+ * client waiting.  The rig is handed out by start-time fair queuing
+ * instead: a client's virtual finish time grows by the time it held the
+ * rig divided by its weight (-Q), and of the waiters the one with the
+ * earliest virtual start goes next.  A client back from being idle starts
+ * at the rig's current virtual time, so it cannot bank credit.  Callers
+ * without a client, the main thread, UDP and subscriptions, start at the
+ * current virtual time and so are served first.
+ *
+ * -q puts a token bucket in front of each connection on top of that.  It
+ * is charged for every command as it is taken off the socket, cache hits
+ * included, so a throttled client is held back by TCP rather than by
+ * sitting on the rig.
+ */
+struct rigctld_client
+{
+    struct rigctld_client *next;    /* on its rig's list */
+    unsigned id;
+    char peer[NI_MAXHOST + NI_MAXSERV + 1];
+    int weight;
+    int deferred;               /* the command waiting has been counted */
+    double tokens;
+    struct timespec refilled;
+    double vfinish;
+    /* for \get_stats */
+    uint64_t commands;
+    uint64_t throttled;
+    uint64_t rig_calls;
+    uint64_t wait_total_us;
+    uint64_t wait_max_us;
+    uint64_t held_us;
+};
+
+#define RIGCTLD_MAX_WEIGHTS 16
+
+static double rate_limit;       /* commands per second per connection, 0 for none */
+static double rate_burst;
+static struct
+{
+    char addr[NI_MAXHOST];
+    int weight;
+} client_weights[RIGCTLD_MAX_WEIGHTS];
+static int client_weight_count;
+static unsigned client_ids;
+static pthread_key_t client_key;    /* the rigctld_client a thread works for */
+
+static void served_init(struct rigctld_rig *r)
+{
+    pthread_mutex_init(&r->lock, NULL);
+    pthread_cond_init(&r->turn, NULL);
+}
+
+static uint64_t us_since(const struct timespec *t)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)(now.tv_sec - t->tv_sec) * 1000000
+           + (now.tv_nsec - t->tv_nsec) / 1000;
+}
+
+/* takes a token, or returns the ms until there is one; served->lock held */
+static long client_token(struct rigctld_client *cl)
+{
+    struct timespec now;
+
+    if (rate_limit <= 0)
+    {
+        cl->commands++;
+        return 0;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    cl->tokens += ((now.tv_sec - cl->refilled.tv_sec)
+                   + (now.tv_nsec - cl->refilled.tv_nsec) / 1e9) * rate_limit;
+    cl->refilled = now;
+
+    if (cl->tokens > rate_burst) { cl->tokens = rate_burst; }
+
+    if (cl->tokens >= 1)
+    {
+        cl->tokens -= 1;
+        cl->deferred = 0;
+        cl->commands++;
+        return 0;
+    }
+
+    if (!cl->deferred)
+    {
+        cl->throttled++;
+        cl->deferred = 1;
+    }
+
+    return (long)((1 - cl->tokens) * 1000 / rate_limit) + 1;
+}
+
+/* waits for a token before cl's next command */
+static void client_throttle(struct rigctld_rig *served, struct rigctld_client *cl)
+{
+    long ms;
+
+    if (!cl)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&served->lock);
+
+    while ((ms = client_token(cl)) > 0)
+    {
+        pthread_mutex_unlock(&served->lock);
+        hl_usleep(ms * 1000);
+        pthread_mutex_lock(&served->lock);
+    }
+
+    pthread_mutex_unlock(&served->lock);
+}
+
+/* the waiter to go next: earliest virtual start, then first come */
+static struct fq_waiter *fq_next(const struct rigctld_rig *served)
+{
+    struct fq_waiter *w, *best = served->waiters;
+
+    for (w = best; w; w = w->next)
+    {
+        if (w->vstart < best->vstart) { best = w; }
+    }
+
+    return best;
+}
+
+static void served_lock(struct rigctld_rig *served, struct rigctld_client *cl)
+{
+    struct fq_waiter w, **tail;
+    struct timespec asked;
+    uint64_t waited;
+
+    pthread_mutex_lock(&served->lock);
+
+    clock_gettime(CLOCK_MONOTONIC, &asked);
+
+    w.next = NULL;
+    w.vstart = served->vtime;
+
+    if (cl && cl->vfinish > w.vstart) { w.vstart = cl->vfinish; }
+
+    for (tail = &served->waiters; *tail; tail = &(*tail)->next) {}
+
+    *tail = &w;
+
+    while (served->busy || fq_next(served) != &w)
+    {
+        pthread_cond_wait(&served->turn, &served->lock);
+    }
+
+    for (tail = &served->waiters; *tail != &w; tail = &(*tail)->next) {}
+
+    *tail = w.next;
+
+    served->busy = 1;
+    served->holder = cl;
+    served->held_vstart = w.vstart;
+    served->vtime = w.vstart;
+    clock_gettime(CLOCK_MONOTONIC, &served->held_since);
+
+    if (cl)
+    {
+        waited = us_since(&asked);
+        cl->rig_calls++;
+        cl->wait_total_us += waited;
+
+        if (waited > cl->wait_max_us) { cl->wait_max_us = waited; }
+    }
+
+    pthread_mutex_unlock(&served->lock);
+}
+
+static void served_unlock(struct rigctld_rig *served)
+{
+    struct rigctld_client *cl;
+
+    pthread_mutex_lock(&served->lock);
+
+    cl = served->holder;
+
+    if (cl)
+    {
+        uint64_t held = us_since(&served->held_since);
+
+        cl->vfinish = served->held_vstart + (double) held / cl->weight;
+        cl->held_us += held;
+    }
+
+    served->busy = 0;
+    served->holder = NULL;
+    pthread_cond_broadcast(&served->turn);
+    pthread_mutex_unlock(&served->lock);
+}
+
+static struct rigctld_client *client_new(struct rigctld_rig *served,
+        const struct sockaddr *addr, socklen_t addrlen)
+{
+    struct rigctld_client *cl = calloc(1, sizeof(*cl));
+    char host[NI_MAXHOST] = "";
+    char serv[NI_MAXSERV] = "";
+    int i;
+
+    if (!cl)
+    {
+        return NULL;
+    }
+
+    getnameinfo(addr, addrlen, host, sizeof(host), serv, sizeof(serv),
+                NI_NUMERICHOST | NI_NUMERICSERV);
+    SNPRINTF(cl->peer, sizeof(cl->peer), "%s:%s", host, serv);
+
+    cl->weight = 1;
+
+    for (i = 0; i < client_weight_count; i++)
+    {
+        if (!strcmp(client_weights[i].addr, host))
+        {
+            cl->weight = client_weights[i].weight;
+        }
+    }
+
+    cl->tokens = rate_burst;
+    clock_gettime(CLOCK_MONOTONIC, &cl->refilled);
+
+    pthread_mutex_lock(&served->lock);
+    cl->id = ++client_ids;
+    cl->vfinish = served->vtime;
+    cl->next = served->clients;
+    served->clients = cl;
+    pthread_mutex_unlock(&served->lock);
+
+    return cl;
+}
+
+static void client_free(struct rigctld_rig *served, struct rigctld_client *cl)
+{
+    struct rigctld_client **p;
+
+    if (!cl)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&served->lock);
+
+    for (p = &served->clients; *p && *p != cl; p = &(*p)->next) {}
+
+    if (*p) { *p = cl->next; }
+
+    pthread_mutex_unlock(&served->lock);
+
+    free(cl);
+}
+
+/* \get_stats lines for the clients of rig, or reset them with fout NULL */
+static void client_stats(RIG *rig, FILE *fout)
+{
+    struct rigctld_client *cl;
+    int i;
+
+    for (i = 0; i < rig_count && rigs[i].rig != rig; i++) {}
+
+    if (i == rig_count)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&rigs[i].lock);
+
+    for (cl = rigs[i].clients; cl; cl = cl->next)
+    {
+        if (!fout)
+        {
+            cl->commands = cl->throttled = cl->rig_calls = cl->held_us = 0;
+            cl->wait_total_us = cl->wait_max_us = 0;
+            continue;
+        }
+
+        fprintf(fout, "Client%uPeer=%s\nClient%uWeight=%d\nClient%uCommands=%"
+                PRIu64 "\nClient%uThrottled=%" PRIu64 "\nClient%uRigCalls=%" PRIu64
+                "\nClient%uWaitAvgUs=%" PRIu64 "\nClient%uWaitMaxUs=%" PRIu64
+                "\nClient%uBusyUs=%" PRIu64 "\n",
+                cl->id, cl->peer, cl->id, cl->weight, cl->id, cl->commands,
+                cl->id, cl->throttled, cl->id, cl->rig_calls,
+                cl->id, cl->rig_calls ? cl->wait_total_us / cl->rig_calls : 0,
+                cl->id, cl->wait_max_us, cl->id, cl->held_us);
+    }
+
+    pthread_mutex_unlock(&rigs[i].lock);
+}
+#endif
+
+/* locks the rig the calling thread serves, the first rig by default */
 void mutex_rigctld(int lock)
 {
 #ifdef HAVE_PTHREAD
-    static pthread_mutex_t client_lock = PTHREAD_MUTEX_INITIALIZER;
+    struct rigctld_rig *served = pthread_getspecific(served_key);
+
+    if (!served)
+    {
+        served = &rigs[0];
+    }
 
     if (lock)
     {
-        pthread_mutex_lock(&client_lock);
+        served_lock(served, pthread_getspecific(client_key));
         rig_debug(RIG_DEBUG_VERBOSE, "%s: client lock engaged\n", __func__);
     }
     else
     {
         rig_debug(RIG_DEBUG_VERBOSE, "%s: client lock disengaged\n", __func__);
-        pthread_mutex_unlock(&client_lock);
+        served_unlock(served);
+    }
+
+#endif
+}
+
+/* mutex_rigctld() for the daemon's own bookkeeping, not charged to the client */
+static void mutex_rigctld_own(int lock)
+{
+#ifdef HAVE_PTHREAD
+    struct rigctld_rig *served = pthread_getspecific(served_key);
+
+    if (!served)
+    {
+        served = &rigs[0];
+    }
+
+    if (lock)
+    {
+        served_lock(served, NULL);
+    }
+    else
+    {
+        served_unlock(served);
     }
 
 #endif
@@ -240,73 +698,277 @@ static void handle_error(enum rig_debug_level_e lvl, const char *msg)
 #endif
 }
 
-int main(int argc, char *argv[])
+/*
+ * --add-rig=PORT,MODEL[,RIG_FILE[,PARM=VAL...]]: another rig served on its
+ * own port by this process
+ */
+static int add_rig(const char *spec)
 {
-    rig_model_t my_model = RIG_MODEL_DUMMY;
-
-    int retcode;        /* generic return code from functions */
-
-    int show_conf = 0;
-    int dump_caps_opt = 0;
-    const char *rig_file = NULL, *ptt_file = NULL, *dcd_file = NULL;
-    ptt_type_t ptt_type = RIG_PTT_NONE;
-    dcd_type_t dcd_type = RIG_DCD_NONE;
-    int serial_rate = 0;
-    char *civaddr = NULL;   /* NULL means no need to set conf */
-    char conf_parms[MAXCONFLEN] = "";
+    struct rigctld_rig *r;
+    char buf[MAXCONFLEN];
+    char conf[MAXCONFLEN] = "";
+    char *model, *file = NULL;
+    char *p;
+    int retcode;
+
+    if (rig_count == RIGCTLD_MAX_RIGS)
+    {
+        fprintf(stderr, "At most %d rigs per rigctld\n", RIGCTLD_MAX_RIGS);
+        return -RIG_EINVAL;
+    }
 
-    struct addrinfo hints, *result, *saved_result;
-    int sock_listen;
-    int reuseaddr = 1;
-    int twiddle_timeout = 0;
-    int twiddle_rit = 0;
-    int uplink = 0;
-    char host[NI_MAXHOST];
-    char serv[NI_MAXSERV];
-    char rigstartup[1024];
-#if HAVE_SIGACTION
-    struct sigaction act;
-#endif
+    SNPRINTF(buf, sizeof(buf), "%s", spec);
 
-#ifdef HAVE_PTHREAD
-    pthread_t thread;
-    pthread_attr_t attr;
-#endif
-    struct handle_data *arg;
-    int vfo_mode = 0; /* vfo_mode=0 means target VFO is current VFO */
-    int i;
-    extern int is_rigctld;
+    if (!(model = strchr(buf, ',')))
+    {
+        fprintf(stderr, "--add-rig=%s: need at least PORT,MODEL\n", spec);
+        return -RIG_EINVAL;
+    }
 
-    is_rigctld = 1;
+    *model++ = '\0';
 
-    while (1)
+    if ((p = strchr(model, ',')))
     {
-        int c;
-        int option_index = 0;
-        char dummy[2];
-
-        c = getopt_long(argc,
-                        argv,
-                        SHORT_OPTIONS,
-                        long_options,
-                        &option_index);
+        *p++ = '\0';
+        file = p;
 
-        if (c == -1)
+        if ((p = strchr(file, ',')))
         {
-            break;
+            *p++ = '\0';
+            SNPRINTF(conf, sizeof(conf), "%s", p);
         }
+    }
 
-        switch (c)
-        {
-        case 'h':
-            usage();
-            exit(0);
+    r = &rigs[rig_count];
+    r->rig = rig_init(atoi(model));
 
-        case 'V':
-            printf("rigctl %s\n", hamlib_version2);
-            exit(0);
+    if (!r->rig)
+    {
+        fprintf(stderr, "--add-rig=%s: unknown rig num %s, or initialization error.\n",
+                spec, model);
+        return -RIG_EINVAL;
+    }
 
-        case 'A':
+    retcode = set_conf(r->rig, conf);
+
+    if (retcode != RIG_OK)
+    {
+        fprintf(stderr, "--add-rig=%s: config parameter error: %s\n", spec,
+                rigerror(retcode));
+        rig_cleanup(r->rig);
+        return retcode;
+    }
+
+    if (file && *file)
+    {
+        strncpy(r->rig->state.rigport.pathname, file, HAMLIB_FILPATHLEN - 1);
+    }
+
+    r->portno = strdup(buf);
+#ifdef HAVE_PTHREAD
+    served_init(r);
+#endif
+    rig_count++;
+
+    return RIG_OK;
+}
+
+/* listening socket on src_addr:portno, -1 on failure */
+static int rigctld_listen(const char *src_addr, const char *portno)
+{
+    struct addrinfo hints, *result, *saved_result;
+    int sock_listen = -1;
+    int reuseaddr = 1;
+    int retcode;
+
+    memset(&hints, 0, sizeof(struct addrinfo));
+    hints.ai_family = AF_UNSPEC;    /* Allow IPv4 or IPv6 */
+    hints.ai_socktype = SOCK_STREAM;/* TCP socket */
+    hints.ai_flags = AI_PASSIVE;    /* For wildcard IP address */
+    hints.ai_protocol = 0;          /* Any protocol */
+
+    retcode = getaddrinfo(src_addr, portno, &hints, &result);
+
+    if (retcode == 0 && result->ai_family == AF_INET6)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: Using IPV6\n", __func__);
+    }
+    else if (retcode == 0)
+    {
+        rig_debug(RIG_DEBUG_TRACE, "%s: Using IPV4\n", __func__);
+    }
+    else
+    {
+        fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(retcode));
+        return -1;
+    }
+
+    saved_result = result;
+
+    do
+    {
+        sock_listen = socket(result->ai_family,
+                             result->ai_socktype,
+                             result->ai_protocol);
+
+        if (sock_listen < 0)
+        {
+            handle_error(RIG_DEBUG_ERR, "socket");
+            freeaddrinfo(saved_result);     /* No longer needed */
+            return -1;
+        }
+
+        if (setsockopt(sock_listen,
+                       SOL_SOCKET,
+                       SO_REUSEADDR,
+                       (char *)&reuseaddr,
+                       sizeof(reuseaddr))
+                < 0)
+        {
+
+            handle_error(RIG_DEBUG_ERR, "setsockopt");
+            freeaddrinfo(saved_result);     /* No longer needed */
+            return -1;
+        }
+
+#ifdef IPV6_V6ONLY
+
+        if (AF_INET6 == result->ai_family)
+        {
+            /* allow IPv4 mapped to IPv6 clients Windows and BSD default
+               this to 1 (i.e. disallowed) and we prefer it off */
+            int sockopt = 0;
+
+            if (setsockopt(sock_listen,
+                           IPPROTO_IPV6,
+                           IPV6_V6ONLY,
+                           (char *)&sockopt,
+                           sizeof(sockopt))
+                    < 0)
+            {
+
+                handle_error(RIG_DEBUG_ERR, "setsockopt");
+                freeaddrinfo(saved_result);     /* No longer needed */
+                return -1;
+            }
+        }
+
+#endif
+
+        if (0 == bind(sock_listen, result->ai_addr, result->ai_addrlen))
+        {
+            break;
+        }
+
+        handle_error(RIG_DEBUG_WARN, "binding failed (trying next interface)");
+#ifdef __MINGW32__
+        closesocket(sock_listen);
+#else
+        close(sock_listen);
+#endif
+    }
+    while ((result = result->ai_next) != NULL);
+
+    freeaddrinfo(saved_result);     /* No longer needed */
+
+    if (NULL == result)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: bind error - no available interface on port %s\n",
+                  __func__, portno);
+        return -1;
+    }
+
+    if (listen(sock_listen, 4) < 0)
+    {
+        handle_error(RIG_DEBUG_ERR, "listening");
+        return -1;
+    }
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: rigctld listening on port %s\n", __func__,
+              portno);
+
+    return sock_listen;
+}
+
+int main(int argc, char *argv[])
+{
+    rig_model_t my_model = RIG_MODEL_DUMMY;
+
+    int retcode;        /* generic return code from functions */
+
+    int show_conf = 0;
+    int dump_caps_opt = 0;
+    const char *rig_file = NULL, *ptt_file = NULL, *dcd_file = NULL;
+    ptt_type_t ptt_type = RIG_PTT_NONE;
+    dcd_type_t dcd_type = RIG_DCD_NONE;
+    int serial_rate = 0;
+    char *civaddr = NULL;   /* NULL means no need to set conf */
+    char conf_parms[MAXCONFLEN] = "";
+
+    int twiddle_timeout = 0;
+    int twiddle_rit = 0;
+    int uplink = 0;
+    char host[NI_MAXHOST];
+    char serv[NI_MAXSERV];
+    char rigstartup[1024];
+#if HAVE_SIGACTION
+    struct sigaction act;
+#endif
+
+#ifdef HAVE_PTHREAD
+    pthread_t thread;
+    pthread_attr_t attr;
+#endif
+    struct handle_data *arg;
+    int vfo_mode = 0; /* vfo_mode=0 means target VFO is current VFO */
+#ifdef RIGCTLD_EVENT_LOOP
+    int event_loop = 0;
+#endif
+    int udp = 0;
+    const char *http_port = NULL;
+    int i;
+    const char *add_rig_specs[RIGCTLD_MAX_RIGS];
+    int add_rig_count = 0;
+    int mlock_opt = 0;
+    int replica = 0;
+    extern int is_rigctld;
+
+    is_rigctld = 1;
+
+#ifdef HAVE_PTHREAD
+    served_init(&rigs[0]);
+    pthread_key_create(&served_key, NULL);
+    pthread_key_create(&client_key, NULL);
+#endif
+
+    while (1)
+    {
+        int c;
+        int option_index = 0;
+        char dummy[2];
+
+        c = getopt_long(argc,
+                        argv,
+                        SHORT_OPTIONS,
+                        long_options,
+                        &option_index);
+
+        if (c == -1)
+        {
+            break;
+        }
+
+        switch (c)
+        {
+        case 'h':
+            usage();
+            exit(0);
+
+        case 'V':
+            printf("rigctl %s\n", hamlib_version2);
+            exit(0);
+
+        case 'A':
             strncpy(rigctld_password, optarg, sizeof(rigctld_password) - 1);
             //char *md5 = rig_make_m d5(rigctld_password);
             char md5[HAMLIB_SECRET_LENGTH + 1];
@@ -592,6 +1254,26 @@ int main(int argc, char *argv[])
             rig_set_debug_time_stamp(1);
             break;
 
+        case 'Y':
+            if (rig_set_debug_async(1) != RIG_OK)
+            {
+                fprintf(stderr, "Asynchronous debug output not available\n");
+            }
+
+            break;
+
+        case 'E':
+#ifdef RIGCTLD_EVENT_LOOP
+            event_loop = 1;
+#else
+            fprintf(stderr, "Event loop mode not available, using a thread per client\n");
+#endif
+            break;
+
+        case 'U':
+            udp = 1;
+            break;
+
         case 'M':
             if (!optarg)
             {
@@ -619,49 +1301,191 @@ int main(int argc, char *argv[])
 
             break;
 
-        default:
-            usage();    /* unknown option? */
-            exit(1);
-        }
-    }
+        case 'R':
+            if (!optarg)
+            {
+                usage();    /* wrong arg count */
+                exit(1);
+            }
 
-#if 0
+            if (add_rig_count == RIGCTLD_MAX_RIGS - 1)
+            {
+                fprintf(stderr, "At most %d rigs per rigctld\n", RIGCTLD_MAX_RIGS);
+                exit(1);
+            }
 
-    if (!vfo_mode)
-    {
-        printf("Recommend using --vfo switch for rigctld if client supports it\n");
-        printf("rigctl and netrigctl will automatically detect vfo mode\n");
-    }
+            add_rig_specs[add_rig_count++] = optarg;
+            break;
 
-#endif
+        case 'K':
+            if (!optarg)
+            {
+                usage();    /* wrong arg count */
+                exit(1);
+            }
 
-    rig_set_debug(verbose);
+            if (rig_set_thread_affinity(optarg) != RIG_OK)
+            {
+                fprintf(stderr, "--cpu-affinity=%s: bad CPU list or not available\n",
+                        optarg);
+                exit(1);
+            }
 
-    SNPRINTF(rigstartup, sizeof(rigstartup), "%s(%d) Startup:", __FILE__, __LINE__);
+            break;
 
-    for (i = 0; i < argc; ++i) { strcat(rigstartup, " "); strcat(rigstartup, argv[i]); }
+        case 'O':
+        {
+            char policy[16];
+            int prio = 0;
 
-    rig_debug(RIG_DEBUG_VERBOSE, "%s\n", rigstartup);
+            if (!optarg)
+            {
+                usage();    /* wrong arg count */
+                exit(1);
+            }
 
-    rig_debug(RIG_DEBUG_VERBOSE, "rigctld %s\n", hamlib_version2);
-    rig_debug(RIG_DEBUG_VERBOSE, "%s",
-              "Report bugs to <hamlib-developer@lists.sourceforge.net>\n\n");
-    rig_debug(RIG_DEBUG_VERBOSE, "Max# of rigctld client services=%d\n",
-              NI_MAXSERV);
+            // POLICY[:PRIO]
+            if (sscanf(optarg, "%15[a-z]:%d", policy, &prio) < 1
+                    || rig_set_thread_sched(policy, prio) != RIG_OK)
+            {
+                fprintf(stderr, "--sched=%s: want fifo, rr or other[:PRIO]\n", optarg);
+                exit(1);
+            }
 
-    my_rig = rig_init(my_model);
+            break;
+        }
 
-    if (!my_rig)
-    {
-        fprintf(stderr,
-                "Unknown rig num %u, or initialization error.\n",
-                my_model);
+        case 'k':
+            mlock_opt = 1;
+            break;
 
-        fprintf(stderr, "Please check with --list option.\n");
-        exit(2);
-    }
+        case 'G':
+            rigctl_set_serve_stale(1);
+            break;
 
-    retcode = set_conf(my_rig, conf_parms);
+        case 'J':
+            if (!optarg || atoi(optarg) < 1)
+            {
+                fprintf(stderr, "--deadline: want milliseconds\n");
+                exit(1);
+            }
+
+            rigctl_set_deadline(atoi(optarg));
+            break;
+
+        case 'F':
+            if (!optarg)
+            {
+                usage();    /* wrong arg count */
+                exit(1);
+            }
+
+            // netmcast reads what the primary multicasts and sends it the rest
+            my_model = RIG_MODEL_NETMCAST;
+            rig_file = optarg;
+            replica = 1;
+            break;
+
+        case 'H':
+            if (!optarg)
+            {
+                usage();    /* wrong arg count */
+                exit(1);
+            }
+
+            http_port = optarg;
+            break;
+
+#ifdef HAVE_PTHREAD
+
+        case 'q':
+            if (!optarg)
+            {
+                usage();    /* wrong arg count */
+                exit(1);
+            }
+
+            // RATE[:BURST]
+            rate_burst = 0;
+
+            if (sscanf(optarg, "%lf:%lf", &rate_limit, &rate_burst) < 1 || rate_limit < 0)
+            {
+                fprintf(stderr, "--rate-limit=%s: want commands per second[:burst]\n",
+                        optarg);
+                exit(1);
+            }
+
+            if (rate_burst < 1) { rate_burst = rate_limit < 1 ? 1 : rate_limit; }
+
+            break;
+
+        case 'Q':
+        {
+            char *eq;
+
+            if (!optarg || !(eq = strrchr(optarg, '=')) || atoi(eq + 1) < 1
+                    || eq - optarg >= NI_MAXHOST)
+            {
+                fprintf(stderr, "--client-weight: want IPADDR=WEIGHT\n");
+                exit(1);
+            }
+
+            if (client_weight_count == RIGCTLD_MAX_WEIGHTS)
+            {
+                fprintf(stderr, "At most %d client weights\n", RIGCTLD_MAX_WEIGHTS);
+                exit(1);
+            }
+
+            memcpy(client_weights[client_weight_count].addr, optarg, eq - optarg);
+            client_weights[client_weight_count++].weight = atoi(eq + 1);
+            break;
+        }
+
+#endif
+
+        default:
+            usage();    /* unknown option? */
+            exit(1);
+        }
+    }
+
+#if 0
+
+    if (!vfo_mode)
+    {
+        printf("Recommend using --vfo switch for rigctld if client supports it\n");
+        printf("rigctl and netrigctl will automatically detect vfo mode\n");
+    }
+
+#endif
+
+    rig_set_debug(verbose);
+
+    SNPRINTF(rigstartup, sizeof(rigstartup), "%s(%d) Startup:", __FILE__, __LINE__);
+
+    for (i = 0; i < argc; ++i) { strcat(rigstartup, " "); strcat(rigstartup, argv[i]); }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s\n", rigstartup);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "rigctld %s\n", hamlib_version2);
+    rig_debug(RIG_DEBUG_VERBOSE, "%s",
+              "Report bugs to <hamlib-developer@lists.sourceforge.net>\n\n");
+    rig_debug(RIG_DEBUG_VERBOSE, "Max# of rigctld client services=%d\n",
+              NI_MAXSERV);
+
+    my_rig = rig_init(my_model);
+
+    if (!my_rig)
+    {
+        fprintf(stderr,
+                "Unknown rig num %u, or initialization error.\n",
+                my_model);
+
+        fprintf(stderr, "Please check with --list option.\n");
+        exit(2);
+    }
+
+    retcode = set_conf(my_rig, conf_parms);
 
     if (retcode != RIG_OK)
     {
@@ -722,6 +1546,24 @@ int main(int argc, char *argv[])
         rig_set_conf(my_rig, rig_token_lookup(my_rig, "civaddr"), civaddr);
     }
 
+    if (replica && strcmp(multicast_addr, "0.0.0.0") != 0)
+    {
+        char group[64] = "", group_port[16] = "";
+
+        // a replica may publish too, but not into the group it reads
+        rig_get_conf(my_rig, rig_token_lookup(my_rig, "multicast_addr"), group);
+        rig_get_conf(my_rig, rig_token_lookup(my_rig, "multicast_port"), group_port);
+
+        if (strcmp(group, multicast_addr) == 0
+                && atoi(group_port) == multicast_port)
+        {
+            fprintf(stderr,
+                    "Replica would publish to %s:%d, the group it reads; use another -M or -n\n",
+                    multicast_addr, multicast_port);
+            exit(1);
+        }
+    }
+
     /*
      * print out conf parameters
      */
@@ -741,6 +1583,21 @@ int main(int argc, char *argv[])
         exit(0);
     }
 
+    if (mlock_opt)
+    {
+        /* before rig_open() so the library threads' stacks are locked too */
+#if defined(HAVE_SYS_MMAN_H) && defined(MCL_FUTURE)
+
+        if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        {
+            fprintf(stderr, "--mlock: %s, continuing unlocked\n", strerror(errno));
+        }
+
+#else
+        fprintf(stderr, "--mlock: memory locking not available\n");
+#endif
+    }
+
     /* attempt to open rig to check early for issues */
     retcode = rig_open(my_rig);
     rig_opened = retcode == RIG_OK ? 1 : 0;
@@ -762,6 +1619,33 @@ int main(int argc, char *argv[])
     rig_debug(RIG_DEBUG_VERBOSE, "Backend version: %s, Status: %s\n",
               my_rig->caps->version, rig_strstatus(my_rig->caps->status));
 
+    for (i = 0; i < add_rig_count; i++)
+    {
+        struct rigctld_rig *r;
+
+        if (add_rig(add_rig_specs[i]) != RIG_OK)
+        {
+            exit(2);
+        }
+
+        r = &rigs[rig_count - 1];
+        retcode = rig_open(r->rig);
+        r->opened = retcode == RIG_OK ? 1 : 0;
+
+        if (retcode != RIG_OK)
+        {
+            fprintf(stderr, "rig_open: error = %s %s on port %s\n", rigerror(retcode),
+                    r->rig->state.rigport.pathname, r->portno);
+            // as above, clients reopen it
+        }
+        else if (verbose > RIG_DEBUG_ERR)
+        {
+            printf("Opened rig model %u, '%s' on port %s\n",
+                   r->rig->caps->rig_model,
+                   r->rig->caps->model_name, r->portno);
+        }
+    }
+
 #if 0
     rig_close(my_rig);          /* we will reopen for clients */
 
@@ -801,33 +1685,6 @@ int main(int argc, char *argv[])
 
 #endif
 
-    /*
-     * Prepare listening socket
-     */
-    memset(&hints, 0, sizeof(struct addrinfo));
-    hints.ai_family = AF_UNSPEC;    /* Allow IPv4 or IPv6 */
-    hints.ai_socktype = SOCK_STREAM;/* TCP socket */
-    hints.ai_flags = AI_PASSIVE;    /* For wildcard IP address */
-    hints.ai_protocol = 0;          /* Any protocol */
-
-    retcode = getaddrinfo(src_addr, portno, &hints, &result);
-
-    if (retcode == 0 && result->ai_family == AF_INET6)
-    {
-        rig_debug(RIG_DEBUG_TRACE, "%s: Using IPV6\n", __func__);
-    }
-    else if (retcode == 0)
-    {
-        rig_debug(RIG_DEBUG_TRACE, "%s: Using IPV4\n", __func__);
-    }
-    else
-    {
-        fprintf(stderr, "getaddrinfo: %s\n", gai_strerror(retcode));
-        exit(2);
-    }
-
-    saved_result = result;
-
     enum multicast_item_e items = RIG_MULTICAST_POLL | RIG_MULTICAST_TRANSCEIVE |
                                   RIG_MULTICAST_SPECTRUM;
     retcode = network_multicast_publisher_start(my_rig, multicast_addr,
@@ -839,83 +1696,34 @@ int main(int argc, char *argv[])
                   rigerror(retcode));
         // we will consider this non-fatal for now
     }
-
-    do
+#ifdef HAVE_PTHREAD
+    else if (strcmp(multicast_addr, "0.0.0.0") != 0
+             && my_rig->state.poll_interval > 0)
     {
-        sock_listen = socket(result->ai_family,
-                             result->ai_socktype,
-                             result->ai_protocol);
-
-        if (sock_listen < 0)
-        {
-            handle_error(RIG_DEBUG_ERR, "socket");
-            freeaddrinfo(saved_result);     /* No longer needed */
-            exit(2);
-        }
-
-        if (setsockopt(sock_listen,
-                       SOL_SOCKET,
-                       SO_REUSEADDR,
-                       (char *)&reuseaddr,
-                       sizeof(reuseaddr))
-                < 0)
-        {
-
-            handle_error(RIG_DEBUG_ERR, "setsockopt");
-            freeaddrinfo(saved_result);     /* No longer needed */
-            exit(1);
-        }
-
-#ifdef IPV6_V6ONLY
-
-        if (AF_INET6 == result->ai_family)
-        {
-            /* allow IPv4 mapped to IPv6 clients Windows and BSD default
-               this to 1 (i.e. disallowed) and we prefer it off */
-            int sockopt = 0;
-
-            if (setsockopt(sock_listen,
-                           IPPROTO_IPV6,
-                           IPV6_V6ONLY,
-                           (char *)&sockopt,
-                           sizeof(sockopt))
-                    < 0)
-            {
-
-                handle_error(RIG_DEBUG_ERR, "setsockopt");
-                freeaddrinfo(saved_result);     /* No longer needed */
-                exit(1);
-            }
-        }
-
-#endif
+        // state packets go out when the poll routine sees a change
+        retcode = rig_poll_routine_start(my_rig);
 
-        if (0 == bind(sock_listen, result->ai_addr, result->ai_addrlen))
+        if (retcode != RIG_OK)
         {
-            break;
+            rig_debug(RIG_DEBUG_ERR, "%s: rig_poll_routine_start failed: %s\n",
+                      __FILE__, rigerror(retcode));
         }
-
-        handle_error(RIG_DEBUG_WARN, "binding failed (trying next interface)");
-#ifdef __MINGW32__
-        closesocket(sock_listen);
-#else
-        close(sock_listen);
-#endif
     }
-    while ((result = result->ai_next) != NULL);
+#endif
 
-    freeaddrinfo(saved_result);     /* No longer needed */
+    /*
+     * Prepare listening sockets
+     */
+    rigs[0].portno = portno;
 
-    if (NULL == result)
+    for (i = 0; i < rig_count; i++)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: bind error - no available interface\n", __func__);
-        exit(1);
-    }
+        rigs[i].sock_listen = rigctld_listen(src_addr, rigs[i].portno);
 
-    if (listen(sock_listen, 4) < 0)
-    {
-        handle_error(RIG_DEBUG_ERR, "listening");
-        exit(1);
+        if (rigs[i].sock_listen < 0)
+        {
+            exit(1);
+        }
     }
 
 #if HAVE_SIGACTION
@@ -974,36 +1782,88 @@ int main(int argc, char *argv[])
     /*
      * main loop accepting connections
      */
-    rig_debug(RIG_DEBUG_TRACE, "%s: rigctld listening on port %s\n", __func__, portno);
-    do
-    {
-        fd_set set;
-        struct timeval timeout;
+#ifdef RIGCTLD_PIPELINE
+    rigctl_set_pipeline(pipe_pending, pipe_defer);
+#endif
+#ifdef RIGCTLD_SUBSCRIBE
+    rigctl_set_subscribe(sub_subscribe);
+#endif
+#ifdef HAVE_PTHREAD
+    rigctl_set_stats(client_stats);
+#endif
 
-        arg = calloc(1, sizeof(struct handle_data));
+    if (udp)
+    {
+#ifdef RIGCTLD_UDP
 
-        if (!arg)
+        if (rigctld_password[0] != 0)
         {
-            rig_debug(RIG_DEBUG_ERR, "calloc: %s\n", strerror(errno));
-            exit(1);
+            fprintf(stderr, "UDP requests cannot be password protected, not starting UDP\n");
+        }
+        else if (udp_start(src_addr, portno, vfo_mode) != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: UDP listener failed, TCP only\n", __func__);
         }
 
-        if (rigctld_password[0] != 0) { arg->use_password = 1; }
+#else
+        fprintf(stderr, "UDP requests not available, TCP only\n");
+#endif
+    }
 
-        /* use select to allow for periodic checks for CTRL+C */
-        FD_ZERO(&set);
-        FD_SET(sock_listen, &set);
-        timeout.tv_sec = 5;
-        timeout.tv_usec = 0;
-        retcode = select(sock_listen + 1, &set, NULL, NULL, &timeout);
+    if (http_port)
+    {
+#ifdef RIGCTLD_HTTP
 
-        if (retcode == -1)
+        if (rigctld_password[0] != 0)
         {
-            int errno_stored = errno;
-            rig_debug(RIG_DEBUG_ERR, "%s: select() failed: %s\n", __func__,
-                      strerror(errno_stored));
+            fprintf(stderr, "HTTP requests cannot be password protected, not starting HTTP\n");
+        }
+        else if (http_start(src_addr, http_port) != RIG_OK)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: HTTP listener failed\n", __func__);
+        }
 
-            if (ctrl_c)
+#else
+        fprintf(stderr, "HTTP not available in this build\n");
+#endif
+    }
+
+#ifdef RIGCTLD_EVENT_LOOP
+
+    if (event_loop)
+    {
+        retcode = rigctld_event_loop(vfo_mode);
+    }
+    else
+#endif
+    do
+    {
+        fd_set set;
+        struct timeval timeout;
+        int maxfd = 0;
+        int n;
+
+        /* use select to allow for periodic checks for CTRL+C */
+        FD_ZERO(&set);
+
+        for (n = 0; n < rig_count; n++)
+        {
+            FD_SET(rigs[n].sock_listen, &set);
+
+            if (rigs[n].sock_listen > maxfd) { maxfd = rigs[n].sock_listen; }
+        }
+
+        timeout.tv_sec = 5;
+        timeout.tv_usec = 0;
+        retcode = select(maxfd + 1, &set, NULL, NULL, &timeout);
+
+        if (retcode == -1)
+        {
+            int errno_stored = errno;
+            rig_debug(RIG_DEBUG_ERR, "%s: select() failed: %s\n", __func__,
+                      strerror(errno_stored));
+
+            if (ctrl_c)
             {
                 rig_debug(RIG_DEBUG_VERBOSE, "%s: ctrl_c when retcode==-1\n", __func__);
                 break;
@@ -1026,53 +1886,77 @@ int main(int argc, char *argv[])
         }
         else
         {
-            arg->rig = my_rig;
-            arg->clilen = sizeof(arg->cli_addr);
-            arg->vfo_mode = vfo_mode;
-            arg->sock = accept(sock_listen,
-                               (struct sockaddr *)&arg->cli_addr,
-                               &arg->clilen);
-
-            if (arg->sock < 0)
+            for (n = 0, retcode = 0; n < rig_count && retcode == 0; n++)
             {
-                handle_error(RIG_DEBUG_ERR, "accept");
-                break;
-            }
+                if (!FD_ISSET(rigs[n].sock_listen, &set))
+                {
+                    continue;
+                }
 
-            if ((retcode = getnameinfo((struct sockaddr const *)&arg->cli_addr,
-                                       arg->clilen,
-                                       host,
-                                       sizeof(host),
-                                       serv,
-                                       sizeof(serv),
-                                       NI_NUMERICHOST | NI_NUMERICSERV))
-                    < 0)
-            {
-                rig_debug(RIG_DEBUG_WARN,
-                          "Peer lookup error: %s",
-                          gai_strerror(retcode));
-            }
+                arg = calloc(1, sizeof(struct handle_data));
+
+                if (!arg)
+                {
+                    rig_debug(RIG_DEBUG_ERR, "calloc: %s\n", strerror(errno));
+                    exit(1);
+                }
+
+                if (rigctld_password[0] != 0) { arg->use_password = 1; }
+
+                arg->rig = rigs[n].rig;
+                arg->served = &rigs[n];
+                arg->clilen = sizeof(arg->cli_addr);
+                arg->vfo_mode = vfo_mode;
+                arg->sock = accept(rigs[n].sock_listen,
+                                   (struct sockaddr *)&arg->cli_addr,
+                                   &arg->clilen);
+
+                if (arg->sock < 0)
+                {
+                    handle_error(RIG_DEBUG_ERR, "accept");
+                    free(arg);
+                    retcode = -1;
+                    break;
+                }
+
+                set_nodelay(arg->sock);
 
-            rig_debug(RIG_DEBUG_VERBOSE,
-                      "Connection opened from %s:%s\n",
-                      host,
-                      serv);
+                if ((retcode = getnameinfo((struct sockaddr const *)&arg->cli_addr,
+                                           arg->clilen,
+                                           host,
+                                           sizeof(host),
+                                           serv,
+                                           sizeof(serv),
+                                           NI_NUMERICHOST | NI_NUMERICSERV))
+                        < 0)
+                {
+                    rig_debug(RIG_DEBUG_WARN,
+                              "Peer lookup error: %s",
+                              gai_strerror(retcode));
+                }
+
+                rig_debug(RIG_DEBUG_VERBOSE,
+                          "Connection opened from %s:%s for port %s\n",
+                          host,
+                          serv, rigs[n].portno);
 
 #ifdef HAVE_PTHREAD
-            pthread_attr_init(&attr);
-            pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+                pthread_attr_init(&attr);
+                pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
 
-            retcode = pthread_create(&thread, &attr, handle_socket, arg);
+                retcode = pthread_create(&thread, &attr, handle_socket, arg);
 
-            if (retcode != 0)
-            {
-                rig_debug(RIG_DEBUG_ERR, "pthread_create: %s\n", strerror(retcode));
-                break;
-            }
+                if (retcode != 0)
+                {
+                    rig_debug(RIG_DEBUG_ERR, "pthread_create: %s\n", strerror(retcode));
+                    break;
+                }
 
 #else
-            handle_socket(arg);
+                handle_socket(arg);
+                retcode = 0;
 #endif
+            }
         }
     }
     while (retcode == 0 && !ctrl_c);
@@ -1080,28 +1964,43 @@ int main(int argc, char *argv[])
     rig_debug(RIG_DEBUG_VERBOSE, "%s: while loop done\n", __func__);
 
 #ifdef HAVE_PTHREAD
-    /* allow threads to finish current action */
-    mutex_rigctld(1);
-    TRACE;
 
     if (client_count)
     {
         rig_debug(RIG_DEBUG_WARN, "%u outstanding client(s)\n", client_count);
     }
 
-    rig_close(my_rig);
-    TRACE;
-    mutex_rigctld(0);
-    TRACE;
+    // before the rig closes under it
+    if (my_rig->state.poll_routine_priv_data != NULL)
+    {
+        rig_poll_routine_stop(my_rig);
+    }
+
+#endif
+
+    for (i = rig_count - 1; i >= 0; i--)
+    {
+#ifdef HAVE_PTHREAD
+        /* allow threads to finish current action */
+        served_lock(&rigs[i], NULL);
+        TRACE;
+        rig_close(rigs[i].rig);
+        TRACE;
+        served_unlock(&rigs[i]);
+        TRACE;
 #else
-    rig_close(my_rig); /* close port */
+        rig_close(rigs[i].rig); /* close port */
 #endif
 
-    TRACE;
-    network_multicast_publisher_stop(my_rig);
+        if (i == 0)
+        {
+            TRACE;
+            network_multicast_publisher_stop(my_rig);
+        }
 
-    TRACE;
-    rig_cleanup(my_rig); /* if you care about memory */
+        TRACE;
+        rig_cleanup(rigs[i].rig); /* if you care about memory */
+    }
 
 #ifdef __MINGW32__
     WSACleanup();
@@ -1110,14 +2009,41 @@ int main(int argc, char *argv[])
     return 0;
 }
 
+/*
+ * With Nagle off every flush goes out at once, so replies are collected in a
+ * fully buffered stream and leave in a single write when rigctl_parse()
+ * flushes at the end of the command.
+ */
+static void set_nodelay(int sock)
+{
+#ifdef TCP_NODELAY
+    int nodelay = 1;
+
+    if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *)&nodelay,
+                   sizeof(nodelay)) < 0)
+    {
+        handle_error(RIG_DEBUG_WARN, "setsockopt TCP_NODELAY");
+    }
+
+#endif
+}
+
 static FILE *get_fsockout(struct handle_data *handle_data_arg)
 {
+    FILE *fout;
 #ifdef __MINGW32__
     int sock_osfhandle = _open_osfhandle(handle_data_arg->sock, _O_RDONLY);
-    return _fdopen(sock_osfhandle, "wb");
+    fout = _fdopen(sock_osfhandle, "wb");
 #else
-    return fdopen(handle_data_arg->sock, "wb");
+    fout = fdopen(handle_data_arg->sock, "wb");
 #endif
+
+    if (fout)
+    {
+        setvbuf(fout, NULL, _IOFBF, BUFSIZ);
+    }
+
+    return fout;
 }
 
 static FILE *get_fsockin(struct handle_data *handle_data_arg)
@@ -1137,216 +2063,2535 @@ static FILE *get_fsockin(struct handle_data *handle_data_arg)
 #endif
 }
 
+#ifdef RIGCTL_BINARY
 /*
- * This is the function run by the threads
+ * A client that opens with RIGCTL_BIN_MAGIC speaks the binary protocol.
+ * Returns 1 for binary, 0 for text, -1 if the client went away or sent a
+ * magic we do not understand.
  */
-void *handle_socket(void *arg)
+static int negotiate_binary(FILE *fsockin, FILE *fsockout)
 {
-    struct handle_data *handle_data_arg = (struct handle_data *)arg;
-    FILE *fsockin = NULL;
-    FILE *fsockout = NULL;
-    int retcode = RIG_OK;
-    char host[NI_MAXHOST];
-    char serv[NI_MAXSERV];
-    char send_cmd_term = '\r';  /* send_cmd termination char */
-    int ext_resp = 0;
+    char magic[RIGCTL_BIN_MAGIC_LEN];
+    int c = fgetc(fsockin);
 
-    fsockin = get_fsockin(handle_data_arg);
+    if (c == EOF)
+    {
+        return -1;
+    }
 
-    if (!fsockin)
+    if (c != RIGCTL_BIN_MAGIC[0])
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: fdopen(0x%d) in: %s\n", __func__,
-                  handle_data_arg->sock,
-                  strerror(errno));
-        goto handle_exit;
+        ungetc(c, fsockin);
+        return 0;
     }
 
-    fsockout = get_fsockout(handle_data_arg);
+    magic[0] = c;
 
-    if (!fsockout)
+    if (fread(magic + 1, 1, RIGCTL_BIN_MAGIC_LEN - 1, fsockin)
+            != RIGCTL_BIN_MAGIC_LEN - 1
+            || memcmp(magic, RIGCTL_BIN_MAGIC, RIGCTL_BIN_MAGIC_LEN) != 0)
     {
-        rig_debug(RIG_DEBUG_ERR, "%s: fdopen out: %s\n", __func__, strerror(errno));
-        fclose(fsockin);
-
-        goto handle_exit;
+        rig_debug(RIG_DEBUG_ERR, "%s: unknown binary protocol version\n", __func__);
+        return -1;
     }
 
-#ifdef HAVE_PTHREAD
-    mutex_rigctld(1);
+    fwrite(RIGCTL_BIN_MAGIC, 1, RIGCTL_BIN_MAGIC_LEN, fsockout);
+    fflush(fsockout);
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: client speaks binary protocol\n", __func__);
 
-//    ++client_count;
-#if 0
+    return 1;
+}
+#endif
 
-    if (!client_count++)
-    {
-        retcode = rig_open(my_rig);
+#ifdef RIGCTLD_PIPELINE
+/*
+ * Pipelined clients, see rigctl_set_pipeline().  Each connection gets a
+ * worker that runs its deferred commands in order while handle_socket()
+ * keeps reading, so tagged cache hits are answered ahead of them.
+ */
+struct pipe_cmd
+{
+    struct pipe_cmd *next;
+    int setter;
+    char tag[16];
+    char line[];
+};
 
-        if (RIG_OK == retcode && verbose > RIG_DEBUG_ERR)
-        {
-            printf("Opened rig model %d, '%s'\n",
-                   my_rig->caps->rig_model,
-                   my_rig->caps->model_name);
-        }
-    }
+struct pipe_client
+{
+    struct pipe_client *next;
+    struct handle_data *h;
+    FILE *fout;
+    pthread_t thread;
+    int started;
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct pipe_cmd *head, *tail;
+    int pending;            /* queued or running */
+    int pending_setters;
+    unsigned int sub_events;    /* RIGCTL_EV_* pushed to this client */
+    unsigned int sub_dirty;     /* changed since last pushed */
+    unsigned long sub_dtmf;     /* DTMF digits received before the next to push */
+};
 
-#endif
+#define PIPE_REPLYSZ 16384
 
-    mutex_rigctld(0);
-#else
-    retcode = rig_open(my_rig);
+static struct pipe_client *pipe_clients;
+static pthread_mutex_t pipe_clients_lock = PTHREAD_MUTEX_INITIALIZER;
 
-    if (RIG_OK == retcode && verbose > RIG_DEBUG_ERR)
+/* returns the client locked, or NULL */
+static struct pipe_client *pipe_find(FILE *fout)
+{
+    struct pipe_client *pc;
+
+    pthread_mutex_lock(&pipe_clients_lock);
+
+    for (pc = pipe_clients; pc && pc->fout != fout; pc = pc->next);
+
+    if (pc) { pthread_mutex_lock(&pc->lock); }
+
+    pthread_mutex_unlock(&pipe_clients_lock);
+
+    return pc;
+}
+
+static int pipe_pending(FILE *fout, int setters_only)
+{
+    struct pipe_client *pc = pipe_find(fout);
+    int n;
+
+    if (!pc)
     {
-        printf("Opened rig model %d, '%s'\n",
-               my_rig->caps->rig_model,
-               my_rig->caps->model_name);
+        return 0;
     }
 
-#endif
+    n = setters_only ? pc->pending_setters : pc->pending;
+    pthread_mutex_unlock(&pc->lock);
 
-    do
-    {
-        mutex_rigctld(1);
+    return n;
+}
 
-        if (!rig_opened)
-        {
-            retcode = rig_open(my_rig);
-            rig_opened = retcode == RIG_OK ? 1 : 0;
-            rig_debug(RIG_DEBUG_ERR, "%s: rig_open reopened retcode=%d\n", __func__,
-                      retcode);
-        }
+static void *pipe_worker(void *arg)
+{
+    struct pipe_client *pc = (struct pipe_client *)arg;
+    char reply[PIPE_REPLYSZ];
+    struct rigctl_out out = { reply, sizeof(reply), 0 };
 
-        mutex_rigctld(0);
+    pthread_setspecific(served_key, pc->h->served);
+    pthread_setspecific(client_key, pc->h->client);
+    pthread_mutex_lock(&pc->lock);
 
-        if (rig_opened) // only do this if rig is open
+    for (;;)
+    {
+        struct pipe_cmd *pcmd;
+        FILE *fin, *capture;
+        char *buf = NULL;
+        size_t len = 0;
+        int ext_resp = 0;
+        char sep = resp_sep;
+        char send_cmd_term = '\r';
+
+        while (!pc->head && !pc->stop)
         {
-            rig_debug(RIG_DEBUG_TRACE, "%s: doing rigctl_parse vfo_mode=%d, secure=%d\n",
-                      __func__,
-                      handle_data_arg->vfo_mode, handle_data_arg->use_password);
-            retcode = rigctl_parse(handle_data_arg->rig, fsockin, fsockout, NULL, 0,
-                                   mutex_rigctld,
-                                   1, 0, &handle_data_arg->vfo_mode, send_cmd_term, &ext_resp, &resp_sep,
-                                   handle_data_arg->use_password);
-
-            if (retcode != 0) { rig_debug(RIG_DEBUG_VERBOSE, "%s: rigctl_parse retcode=%d\n", __func__, retcode); }
+            pthread_cond_wait(&pc->cond, &pc->lock);
         }
-        else
+
+        if (!pc->head)
         {
-            retcode = -RIG_EIO;
+            break;
         }
 
-        // if we get a hard error we try to reopen the rig again
-        // this should cover short dropouts that can occur
-        if (retcode < 0 && !RIG_IS_SOFT_ERRCODE(-retcode))
-        {
-            int retry = 3;
-            rig_debug(RIG_DEBUG_ERR, "%s: i/o error\n", __func__);
+        pcmd = pc->head;
+        pc->head = pcmd->next;
 
-            do
-            {
-                mutex_rigctld(1);
-                retcode = rig_close(my_rig);
-                rig_opened = 0;
-                mutex_rigctld(0);
-                rig_debug(RIG_DEBUG_ERR, "%s: rig_close retcode=%d\n", __func__, retcode);
+        if (!pc->head) { pc->tail = NULL; }
 
-                hl_usleep(1000 * 1000);
+        pthread_mutex_unlock(&pc->lock);
 
-                mutex_rigctld(1);
+        out.len = 0;
 
-                if (!rig_opened)
-                {
-                    retcode = rig_open(my_rig);
-                    rig_opened = retcode == RIG_OK ? 1 : 0;
-                    rig_debug(RIG_DEBUG_ERR, "%s: rig_open retcode=%d, opened=%d\n", __func__,
-                              retcode, rig_opened);
-                }
+        if (rigctl_parse_buf(pc->h->rig, pcmd->line, strlen(pcmd->line), &out,
+                             mutex_rigctld, &pc->h->vfo_mode, send_cmd_term,
+                             &ext_resp, &sep, pc->h->use_password)
+                == RIGCTL_PARSE_INCOMPLETE)
+        {
+            fin = fmemopen(pcmd->line, strlen(pcmd->line), "r");
+            capture = open_memstream(&buf, &len);
 
-                mutex_rigctld(0);
+            if (fin && capture)
+            {
+                rigctl_parse(pc->h->rig, fin, capture, NULL, 0, mutex_rigctld,
+                             1, 0, &pc->h->vfo_mode, send_cmd_term, &ext_resp, &sep,
+                             pc->h->use_password);
             }
-            while (!ctrl_c && !rig_opened && retry-- > 0 && retcode != RIG_OK);
+
+            if (fin) { fclose(fin); }
+
+            if (capture) { fclose(capture); }
         }
-    }
-    while (!ctrl_c && (retcode == RIG_OK || RIG_IS_SOFT_ERRCODE(-retcode)));
 
-#ifdef HAVE_PTHREAD
-#if 0
-    mutex_rigctld(1);
+        flockfile(pc->fout);
 
-    /* Release rig if there are no clients */
-    if (!--client_count)
-    {
-        rig_close(my_rig);
+        if (pcmd->tag[0]) { fprintf(pc->fout, "#%s ", pcmd->tag); }
 
-        if (verbose > RIG_DEBUG_ERR)
-        {
-            printf("Closed rig model %d, '%s - no clients, will reopen for new clients'\n",
-                   my_rig->caps->rig_model,
-                   my_rig->caps->model_name);
-        }
+        fwrite(out.buf, 1, out.len, pc->fout);
+
+        if (buf) { fwrite(buf, 1, len, pc->fout); }
+
+        fflush(pc->fout);
+        funlockfile(pc->fout);
+        free(buf);
+
+        pthread_mutex_lock(&pc->lock);
+        pc->pending--;
+
+        if (pcmd->setter) { pc->pending_setters--; }
+
+        free(pcmd);
     }
 
-    mutex_rigctld(0);
-#endif
-#else
-    rig_close(my_rig);
+    pthread_mutex_unlock(&pc->lock);
 
-    if (verbose > RIG_DEBUG_ERR)
+    return NULL;
+}
+
+static int pipe_defer(FILE *fout, const char *tag, const char *line,
+                      int setter)
+{
+    struct pipe_client *pc;
+    struct pipe_cmd *pcmd;
+    size_t len = strlen(line) + 1;
+
+    pcmd = calloc(1, sizeof(*pcmd) + len);
+
+    if (!pcmd)
     {
-        printf("Closed rig model %d, '%s - will reopen for new clients'\n",
-               my_rig->caps->rig_model,
-               my_rig->caps->model_name);
+        return 0;
     }
 
-#endif
+    if (!(pc = pipe_find(fout)))
+    {
+        free(pcmd);
+        return 0;
+    }
 
-    if ((retcode = getnameinfo((struct sockaddr const *)&handle_data_arg->cli_addr,
-                               handle_data_arg->clilen,
-                               host,
-                               sizeof(host),
-                               serv,
-                               sizeof(serv),
-                               NI_NUMERICHOST | NI_NUMERICSERV))
-            < 0)
+    if (!pc->started)
     {
+        if (pthread_create(&pc->thread, NULL, pipe_worker, pc) != 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                      strerror(errno));
+            pthread_mutex_unlock(&pc->lock);
+            free(pcmd);
+            return 0;
+        }
 
-        rig_debug(RIG_DEBUG_WARN, "Peer lookup error: %s", gai_strerror(retcode));
+        pc->started = 1;
     }
 
-    rig_debug(RIG_DEBUG_VERBOSE,
-              "Connection closed from %s:%s\n",
-              host,
-              serv);
+    strncpy(pcmd->tag, tag ? tag : "", sizeof(pcmd->tag) - 1);
+    memcpy(pcmd->line, line, len);
+    pcmd->setter = setter;
 
-handle_exit:
+    if (pc->tail) { pc->tail->next = pcmd; }
+    else { pc->head = pcmd; }
 
-// for MINGW we close the handle before fclose
-#ifdef __MINGW32__
-    retcode = closesocket(handle_data_arg->sock);
+    pc->tail = pcmd;
+    pc->pending++;
 
-    if (retcode != 0) { rig_debug(RIG_DEBUG_ERR, "%s: fclose(fsockin) %s\n", __func__, strerror(retcode)); }
+    if (setter) { pc->pending_setters++; }
 
-#endif
+    pthread_cond_signal(&pc->cond);
+    pthread_mutex_unlock(&pc->lock);
 
-    if (fsockin) { fclose(fsockin); }
+    rig_debug(RIG_DEBUG_TRACE, "%s: deferred #%s %s", __func__,
+              tag ? tag : "", line);
 
-    if (fsockout) { fclose(fsockout); }
+    return 1;
+}
 
-// for everybody else we close the handle after fclose
-#ifndef __MINGW32__
-    retcode = close(handle_data_arg->sock);
+static struct pipe_client *pipe_register(struct handle_data *h, FILE *fout)
+{
+    struct pipe_client *pc = calloc(1, sizeof(*pc));
 
-    if (retcode != 0 && errno != EBADF) { rig_debug(RIG_DEBUG_ERR, "%s: close(handle_data_arg->sock) %s\n", __func__, strerror(errno)); }
+    if (!pc)
+    {
+        return NULL;
+    }
 
-#endif
+    pc->h = h;
+    pc->fout = fout;
+    pthread_mutex_init(&pc->lock, NULL);
+    pthread_cond_init(&pc->cond, NULL);
 
-    free(arg);
+    pthread_mutex_lock(&pipe_clients_lock);
+    pc->next = pipe_clients;
+    pipe_clients = pc;
+    pthread_mutex_unlock(&pipe_clients_lock);
 
-#ifdef HAVE_PTHREAD
-    pthread_exit(NULL);
-#endif
-    return NULL;
+    return pc;
+}
+
+/* lets the worker finish what the client already sent, then frees it */
+static void pipe_unregister(struct pipe_client *pc)
+{
+    struct pipe_client **pp;
+
+    pthread_mutex_lock(&pipe_clients_lock);
+
+    for (pp = &pipe_clients; *pp && *pp != pc; pp = &(*pp)->next);
+
+    if (*pp) { *pp = pc->next; }
+
+    pthread_mutex_unlock(&pipe_clients_lock);
+
+    pthread_mutex_lock(&pc->lock);
+    pc->stop = 1;
+    pthread_cond_signal(&pc->cond);
+    pthread_mutex_unlock(&pc->lock);
+
+    if (pc->started)
+    {
+        pthread_join(pc->thread, NULL);
+    }
+
+    pthread_mutex_destroy(&pc->lock);
+    pthread_cond_destroy(&pc->cond);
+    free(pc);
+}
+#endif
+
+#ifdef RIGCTLD_SUBSCRIBE
+/*
+ * \subscribe: one watcher thread samples the state every SUB_POLL_MS, or
+ * sooner when the rig reports a change, through the normal cached getters,
+ * so the rig sees one poller however many clients listen.  Each client only
+ * keeps dirty bits and is sent the latest values when its socket can take
+ * them; a slow reader just misses the values in between.  DTMF digits are
+ * the exception, kept in a ring the rig's callback fills and pushed to each
+ * client from where it left off.
+ */
+#define SUB_POLL_MS 100
+
+static struct
+{
+    freq_t freq;
+    rmode_t mode;
+    pbwidth_t width;
+    ptt_t ptt;
+    vfo_t vfo;
+    split_t split;
+    vfo_t tx_vfo;
+} sub_state;
+static unsigned int sub_known;  /* RIGCTL_EV_* present in sub_state */
+/* DTMF digits are a stream, not a state: every client is sent all of them */
+#define SUB_DTMF_MAX 256
+static char sub_dtmf[SUB_DTMF_MAX];
+static unsigned long sub_dtmf_count;    /* digits received so far */
+static int sub_started;
+static pthread_cond_t sub_cond = PTHREAD_COND_INITIALIZER;
+
+static void sub_wake(void)
+{
+    pthread_mutex_lock(&pipe_clients_lock);
+    pthread_cond_signal(&sub_cond);
+    pthread_mutex_unlock(&pipe_clients_lock);
+}
+
+static int sub_freq_event(RIG *rig, vfo_t vfo, freq_t freq, rig_ptr_t arg)
+{
+    sub_wake();
+    return RIG_OK;
+}
+
+static int sub_mode_event(RIG *rig, vfo_t vfo, rmode_t mode, pbwidth_t width,
+                          rig_ptr_t arg)
+{
+    sub_wake();
+    return RIG_OK;
+}
+
+static int sub_vfo_event(RIG *rig, vfo_t vfo, rig_ptr_t arg)
+{
+    sub_wake();
+    return RIG_OK;
+}
+
+static int sub_ptt_event(RIG *rig, vfo_t vfo, ptt_t ptt, rig_ptr_t arg)
+{
+    sub_wake();
+    return RIG_OK;
+}
+
+static int sub_dtmf_event(RIG *rig, vfo_t vfo, const char *digits,
+                          rig_ptr_t arg)
+{
+    pthread_mutex_lock(&pipe_clients_lock);
+
+    for (; *digits; digits++)
+    {
+        sub_dtmf[sub_dtmf_count++ % SUB_DTMF_MAX] = *digits;
+    }
+
+    pthread_cond_signal(&sub_cond);
+    pthread_mutex_unlock(&pipe_clients_lock);
+
+    return RIG_OK;
+}
+
+/* samples what somebody wants, returns the RIGCTL_EV_* that changed */
+static unsigned int sub_refresh(unsigned int want)
+{
+    unsigned int changed = 0;
+    freq_t freq;
+    rmode_t mode;
+    pbwidth_t width;
+    ptt_t ptt;
+    vfo_t vfo, tx_vfo;
+    split_t split;
+
+    if (!rig_opened)
+    {
+        return 0;
+    }
+
+    mutex_rigctld(1);
+
+    if ((want & RIGCTL_EV_FREQ)
+            && rig_get_freq(my_rig, RIG_VFO_CURR, &freq) == RIG_OK
+            && (!(sub_known & RIGCTL_EV_FREQ) || freq != sub_state.freq))
+    {
+        sub_state.freq = freq;
+        changed |= RIGCTL_EV_FREQ;
+    }
+
+    if ((want & RIGCTL_EV_MODE)
+            && rig_get_mode(my_rig, RIG_VFO_CURR, &mode, &width) == RIG_OK
+            && (!(sub_known & RIGCTL_EV_MODE) || mode != sub_state.mode
+                || width != sub_state.width))
+    {
+        sub_state.mode = mode;
+        sub_state.width = width;
+        changed |= RIGCTL_EV_MODE;
+    }
+
+    if ((want & RIGCTL_EV_PTT)
+            && rig_get_ptt(my_rig, RIG_VFO_CURR, &ptt) == RIG_OK
+            && (!(sub_known & RIGCTL_EV_PTT) || ptt != sub_state.ptt))
+    {
+        sub_state.ptt = ptt;
+        changed |= RIGCTL_EV_PTT;
+    }
+
+    if ((want & RIGCTL_EV_VFO)
+            && rig_get_vfo(my_rig, &vfo) == RIG_OK
+            && (!(sub_known & RIGCTL_EV_VFO) || vfo != sub_state.vfo))
+    {
+        sub_state.vfo = vfo;
+        changed |= RIGCTL_EV_VFO;
+    }
+
+    if ((want & RIGCTL_EV_SPLIT)
+            && rig_get_split_vfo(my_rig, RIG_VFO_CURR, &split, &tx_vfo) == RIG_OK
+            && (!(sub_known & RIGCTL_EV_SPLIT) || split != sub_state.split
+                || tx_vfo != sub_state.tx_vfo))
+    {
+        sub_state.split = split;
+        sub_state.tx_vfo = tx_vfo;
+        changed |= RIGCTL_EV_SPLIT;
+    }
+
+    mutex_rigctld(0);
+
+    sub_known |= changed;
+
+    return changed;
+}
+
+/* pushes what is dirty to one client, if it can take it right now */
+static void sub_push(struct pipe_client *pc)
+{
+    struct pollfd pfd;
+    unsigned int send = pc->sub_dirty & pc->sub_events
+                        & (sub_known | RIGCTL_EV_DTMF);
+
+    if (!send)
+    {
+        return;
+    }
+
+    pfd.fd = fileno(pc->fout);
+    pfd.events = POLLOUT;
+
+    // busy replying or not draining its socket, try again next round
+    if (poll(&pfd, 1, 0) != 1 || !(pfd.revents & POLLOUT)
+            || ftrylockfile(pc->fout) != 0)
+    {
+        return;
+    }
+
+    if (send & RIGCTL_EV_FREQ)
+    {
+        fprintf(pc->fout, "!freq %"PRIll"\n", (int64_t)sub_state.freq);
+    }
+
+    if (send & RIGCTL_EV_MODE)
+    {
+        fprintf(pc->fout, "!mode %s %ld\n", rig_strrmode(sub_state.mode),
+                sub_state.width);
+    }
+
+    if (send & RIGCTL_EV_PTT)
+    {
+        fprintf(pc->fout, "!ptt %d\n", sub_state.ptt);
+    }
+
+    if (send & RIGCTL_EV_VFO)
+    {
+        fprintf(pc->fout, "!vfo %s\n", rig_strvfo(sub_state.vfo));
+    }
+
+    if (send & RIGCTL_EV_SPLIT)
+    {
+        fprintf(pc->fout, "!split %d %s\n", sub_state.split,
+                rig_strvfo(sub_state.tx_vfo));
+    }
+
+    if ((send & RIGCTL_EV_DTMF) && pc->sub_dtmf != sub_dtmf_count)
+    {
+        // a client that far behind loses the oldest digits
+        if (sub_dtmf_count - pc->sub_dtmf > SUB_DTMF_MAX)
+        {
+            pc->sub_dtmf = sub_dtmf_count - SUB_DTMF_MAX;
+        }
+
+        fputs("!dtmf ", pc->fout);
+
+        while (pc->sub_dtmf != sub_dtmf_count)
+        {
+            fputc(sub_dtmf[pc->sub_dtmf++ % SUB_DTMF_MAX], pc->fout);
+        }
+
+        fputc('\n', pc->fout);
+    }
+
+    fflush(pc->fout);
+    funlockfile(pc->fout);
+
+    pc->sub_dirty &= ~send;
+}
+
+static void *sub_watcher(void *arg)
+{
+    while (!ctrl_c)
+    {
+        struct pipe_client *pc;
+        struct timespec ts;
+        unsigned int want = 0, changed;
+
+        pthread_mutex_lock(&pipe_clients_lock);
+
+        for (pc = pipe_clients; pc; pc = pc->next)
+        {
+            pthread_mutex_lock(&pc->lock);
+            want |= pc->sub_events;
+            pthread_mutex_unlock(&pc->lock);
+        }
+
+        if (!want)
+        {
+            pthread_cond_wait(&sub_cond, &pipe_clients_lock);
+            pthread_mutex_unlock(&pipe_clients_lock);
+            continue;
+        }
+
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_nsec += SUB_POLL_MS * 1000000L;
+        ts.tv_sec += ts.tv_nsec / 1000000000L;
+        ts.tv_nsec %= 1000000000L;
+        pthread_cond_timedwait(&sub_cond, &pipe_clients_lock, &ts);
+        pthread_mutex_unlock(&pipe_clients_lock);
+
+        changed = sub_refresh(want);
+
+        pthread_mutex_lock(&pipe_clients_lock);
+
+        for (pc = pipe_clients; pc; pc = pc->next)
+        {
+            pthread_mutex_lock(&pc->lock);
+            pc->sub_dirty |= changed;
+
+            if (pc->sub_dtmf != sub_dtmf_count)
+            {
+                pc->sub_dirty |= RIGCTL_EV_DTMF;
+            }
+
+            sub_push(pc);
+            pthread_mutex_unlock(&pc->lock);
+        }
+
+        pthread_mutex_unlock(&pipe_clients_lock);
+    }
+
+    return NULL;
+}
+
+static int sub_subscribe(FILE *fout, unsigned int events)
+{
+    struct pipe_client *pc = pipe_find(fout);
+    pthread_t thread;
+
+    if (!pc)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    if (pc->h->rig != my_rig)
+    {
+        pthread_mutex_unlock(&pc->lock);
+        return -RIG_ENAVAIL;    /* only the first rig is watched */
+    }
+
+    pc->sub_events = events;
+    pc->sub_dirty = events;     /* current state first */
+    pthread_mutex_unlock(&pc->lock);
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: events=0x%02x\n", __func__, events);
+
+    pthread_mutex_lock(&pipe_clients_lock);
+
+    pc->sub_dtmf = sub_dtmf_count;  /* only digits from now on */
+
+    if (!sub_started && events)
+    {
+        if (pthread_create(&thread, NULL, sub_watcher, NULL) != 0)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                      strerror(errno));
+            pthread_mutex_unlock(&pipe_clients_lock);
+            return -RIG_EINTERNAL;
+        }
+
+        pthread_detach(thread);
+        sub_started = 1;
+
+        rig_set_freq_callback(my_rig, sub_freq_event, NULL);
+        rig_set_mode_callback(my_rig, sub_mode_event, NULL);
+        rig_set_vfo_callback(my_rig, sub_vfo_event, NULL);
+        rig_set_ptt_callback(my_rig, sub_ptt_event, NULL);
+        rig_set_dtmf_callback(my_rig, sub_dtmf_event, NULL);
+    }
+
+    pthread_cond_signal(&sub_cond);
+    pthread_mutex_unlock(&pipe_clients_lock);
+
+    return RIG_OK;
+}
+#endif
+
+/*
+ * This is the function run by the threads
+ */
+void *handle_socket(void *arg)
+{
+    struct handle_data *handle_data_arg = (struct handle_data *)arg;
+    struct rigctld_rig *served = handle_data_arg->served;
+    FILE *fsockin = NULL;
+    FILE *fsockout = NULL;
+    int retcode = RIG_OK;
+    char host[NI_MAXHOST];
+    char serv[NI_MAXSERV];
+    char send_cmd_term = '\r';  /* send_cmd termination char */
+    int ext_resp = 0;
+#ifdef RIGCTL_BINARY
+    int binary = 0;
+#endif
+#ifdef RIGCTLD_PIPELINE
+    struct pipe_client *pipe = NULL;
+#endif
+
+#ifdef HAVE_PTHREAD
+    pthread_setspecific(served_key, served);
+    handle_data_arg->client = client_new(served,
+                                         (struct sockaddr *)&handle_data_arg->cli_addr,
+                                         handle_data_arg->clilen);
+    pthread_setspecific(client_key, handle_data_arg->client);
+#endif
+
+    fsockin = get_fsockin(handle_data_arg);
+
+    if (!fsockin)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: fdopen(0x%d) in: %s\n", __func__,
+                  handle_data_arg->sock,
+                  strerror(errno));
+        goto handle_exit;
+    }
+
+    fsockout = get_fsockout(handle_data_arg);
+
+    if (!fsockout)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: fdopen out: %s\n", __func__, strerror(errno));
+        fclose(fsockin);
+
+        goto handle_exit;
+    }
+
+#ifdef RIGCTL_BINARY
+    binary = negotiate_binary(fsockin, fsockout);
+
+    if (binary < 0)
+    {
+        goto handle_exit;
+    }
+
+#endif
+
+#ifdef RIGCTLD_PIPELINE
+#ifdef RIGCTL_BINARY
+
+    if (!binary)
+#endif
+        pipe = pipe_register(handle_data_arg, fsockout);
+
+#endif
+
+#ifdef HAVE_PTHREAD
+    mutex_rigctld_own(1);
+
+//    ++client_count;
+#if 0
+
+    if (!client_count++)
+    {
+        retcode = rig_open(served->rig);
+
+        if (RIG_OK == retcode && verbose > RIG_DEBUG_ERR)
+        {
+            printf("Opened rig model %d, '%s'\n",
+                   served->rig->caps->rig_model,
+                   served->rig->caps->model_name);
+        }
+    }
+
+#endif
+
+    mutex_rigctld_own(0);
+#else
+    retcode = rig_open(served->rig);
+
+    if (RIG_OK == retcode && verbose > RIG_DEBUG_ERR)
+    {
+        printf("Opened rig model %d, '%s'\n",
+               served->rig->caps->rig_model,
+               served->rig->caps->model_name);
+    }
+
+#endif
+
+    do
+    {
+        mutex_rigctld_own(1);
+
+        if (!served->opened)
+        {
+            retcode = rig_open(served->rig);
+            served->opened = retcode == RIG_OK ? 1 : 0;
+            rig_debug(RIG_DEBUG_ERR, "%s: rig_open reopened retcode=%d\n", __func__,
+                      retcode);
+        }
+
+        mutex_rigctld_own(0);
+
+        if (served->opened) // only do this if rig is open
+        {
+#ifdef HAVE_PTHREAD
+            client_throttle(served, handle_data_arg->client);
+#endif
+            rig_debug(RIG_DEBUG_TRACE, "%s: doing rigctl_parse vfo_mode=%d, secure=%d\n",
+                      __func__,
+                      handle_data_arg->vfo_mode, handle_data_arg->use_password);
+#ifdef RIGCTL_BINARY
+
+            if (binary)
+            {
+                retcode = rigctl_parse_bin(handle_data_arg->rig, fsockin, fsockout,
+                                           mutex_rigctld, &handle_data_arg->vfo_mode,
+                                           handle_data_arg->use_password);
+            }
+            else
+#endif
+                retcode = rigctl_parse(handle_data_arg->rig, fsockin, fsockout, NULL, 0,
+                                       mutex_rigctld,
+                                       1, 0, &handle_data_arg->vfo_mode, send_cmd_term, &ext_resp, &resp_sep,
+                                       handle_data_arg->use_password);
+
+            if (retcode != 0) { rig_debug(RIG_DEBUG_VERBOSE, "%s: rigctl_parse retcode=%d\n", __func__, retcode); }
+        }
+        else
+        {
+            retcode = -RIG_EIO;
+        }
+
+        // if we get a hard error we try to reopen the rig again
+        // this should cover short dropouts that can occur
+        if (retcode < 0 && !RIG_IS_SOFT_ERRCODE(-retcode))
+        {
+            int retry = 3;
+            rig_debug(RIG_DEBUG_ERR, "%s: i/o error\n", __func__);
+
+            do
+            {
+                mutex_rigctld_own(1);
+                retcode = rig_close(served->rig);
+                served->opened = 0;
+                mutex_rigctld_own(0);
+                rig_debug(RIG_DEBUG_ERR, "%s: rig_close retcode=%d\n", __func__, retcode);
+
+                hl_usleep(1000 * 1000);
+
+                mutex_rigctld_own(1);
+
+                if (!served->opened)
+                {
+                    retcode = rig_open(served->rig);
+                    served->opened = retcode == RIG_OK ? 1 : 0;
+                    rig_debug(RIG_DEBUG_ERR, "%s: rig_open retcode=%d, opened=%d\n", __func__,
+                              retcode, served->opened);
+                }
+
+                mutex_rigctld_own(0);
+            }
+            while (!ctrl_c && !served->opened && retry-- > 0 && retcode != RIG_OK);
+        }
+    }
+    while (!ctrl_c && (retcode == RIG_OK || RIG_IS_SOFT_ERRCODE(-retcode)));
+
+#ifdef HAVE_PTHREAD
+#if 0
+    mutex_rigctld_own(1);
+
+    /* Release rig if there are no clients */
+    if (!--client_count)
+    {
+        rig_close(served->rig);
+
+        if (verbose > RIG_DEBUG_ERR)
+        {
+            printf("Closed rig model %d, '%s - no clients, will reopen for new clients'\n",
+                   served->rig->caps->rig_model,
+                   served->rig->caps->model_name);
+        }
+    }
+
+    mutex_rigctld_own(0);
+#endif
+#else
+    rig_close(served->rig);
+
+    if (verbose > RIG_DEBUG_ERR)
+    {
+        printf("Closed rig model %d, '%s - will reopen for new clients'\n",
+               served->rig->caps->rig_model,
+               served->rig->caps->model_name);
+    }
+
+#endif
+
+    if ((retcode = getnameinfo((struct sockaddr const *)&handle_data_arg->cli_addr,
+                               handle_data_arg->clilen,
+                               host,
+                               sizeof(host),
+                               serv,
+                               sizeof(serv),
+                               NI_NUMERICHOST | NI_NUMERICSERV))
+            < 0)
+    {
+
+        rig_debug(RIG_DEBUG_WARN, "Peer lookup error: %s", gai_strerror(retcode));
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE,
+              "Connection closed from %s:%s\n",
+              host,
+              serv);
+
+handle_exit:
+
+#ifdef RIGCTLD_PIPELINE
+
+    if (pipe) { pipe_unregister(pipe); }
+
+#endif
+#ifdef HAVE_PTHREAD
+    client_free(served, handle_data_arg->client);
+#endif
+
+// for MINGW we close the handle before fclose
+#ifdef __MINGW32__
+    retcode = closesocket(handle_data_arg->sock);
+
+    if (retcode != 0) { rig_debug(RIG_DEBUG_ERR, "%s: fclose(fsockin) %s\n", __func__, strerror(retcode)); }
+
+#endif
+
+    if (fsockin) { fclose(fsockin); }
+
+    if (fsockout) { fclose(fsockout); }
+
+// for everybody else we close the handle after fclose
+#ifndef __MINGW32__
+    retcode = close(handle_data_arg->sock);
+
+    if (retcode != 0 && errno != EBADF) { rig_debug(RIG_DEBUG_ERR, "%s: close(handle_data_arg->sock) %s\n", __func__, strerror(errno)); }
+
+#endif
+
+    free(arg);
+
+#ifdef HAVE_PTHREAD
+    pthread_exit(NULL);
+#endif
+    return NULL;
+}
+
+
+#ifdef RIGCTLD_EVENT_LOOP
+/*
+ * -E/--event-loop: one thread polls the listening sockets and every client
+ * and buffers what they send.  A complete command is posted to the strand
+ * of the client's rig on the shared executor (src/executor.c), so the
+ * commands for one rig run one at a time and in order while different
+ * rigs run on different workers.  A client with a command in flight is
+ * left out of the poll set until the task has written its reply and
+ * pinged the wake pipe, which also means one command per client in the
+ * strand at a time so a chatty client cannot starve the others.
+ */
+#define EVL_MAX_CLIENTS 64
+#define EVL_BUFSZ 4096
+#define EVL_REPLYSZ 16384
+
+struct evl_client
+{
+    struct handle_data h;
+    FILE *fsockout;
+    char buf[EVL_BUFSZ];
+    size_t len;
+    int need_more;  /* buffered command is incomplete, wait for more input */
+    int ext_resp;
+    int binary;     /* 0 text, 1 binary frames, -1 not known yet */
+    int busy;       /* posted to the strand, only the task touches it */
+    int done;       /* the task has finished, set last */
+    int result;     /* what evl_run() returned */
+    char reply[EVL_REPLYSZ];
+};
+
+static struct evl_client *evl_clients[EVL_MAX_CLIENTS];
+static int evl_wake[2] = { -1, -1 };
+
+static void evl_close(int i)
+{
+    struct evl_client *c = evl_clients[i];
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: connection closed, fd=%d\n", __func__,
+              c->h.sock);
+
+    /* closes the socket too */
+    fclose(c->fsockout);
+#ifdef HAVE_PTHREAD
+    client_free(c->h.served, c->h.client);
+#endif
+    free(c);
+    evl_clients[i] = NULL;
+}
+
+static void evl_accept(struct rigctld_rig *r, int vfo_mode)
+{
+    struct evl_client *c;
+    char host[NI_MAXHOST];
+    char serv[NI_MAXSERV];
+    int i;
+
+    c = calloc(1, sizeof(struct evl_client));
+
+    if (!c)
+    {
+        rig_debug(RIG_DEBUG_ERR, "calloc: %s\n", strerror(errno));
+        return;
+    }
+
+    c->h.rig = r->rig;
+    c->h.served = r;
+    c->h.vfo_mode = vfo_mode;
+#ifdef RIGCTL_BINARY
+    c->binary = -1;
+#endif
+    c->h.use_password = rigctld_password[0] != 0;
+    c->h.clilen = sizeof(c->h.cli_addr);
+    c->h.sock = accept(r->sock_listen, (struct sockaddr *)&c->h.cli_addr,
+                       &c->h.clilen);
+
+    if (c->h.sock < 0)
+    {
+        handle_error(RIG_DEBUG_ERR, "accept");
+        free(c);
+        return;
+    }
+
+    set_nodelay(c->h.sock);
+
+    for (i = 0; i < EVL_MAX_CLIENTS && evl_clients[i]; i++) {}
+
+    if (i == EVL_MAX_CLIENTS)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: too many clients, max %d\n", __func__,
+                  EVL_MAX_CLIENTS);
+        close(c->h.sock);
+        free(c);
+        return;
+    }
+
+    c->fsockout = get_fsockout(&c->h);
+
+    if (!c->fsockout)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: fdopen out: %s\n", __func__, strerror(errno));
+        close(c->h.sock);
+        free(c);
+        return;
+    }
+
+    if (getnameinfo((struct sockaddr const *)&c->h.cli_addr, c->h.clilen,
+                    host, sizeof(host), serv, sizeof(serv),
+                    NI_NUMERICHOST | NI_NUMERICSERV) == 0)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "Connection opened from %s:%s\n", host, serv);
+    }
+
+#ifdef HAVE_PTHREAD
+    // the bucket is charged when a command is posted, see evl_dispatch()
+    c->h.client = client_new(r, (struct sockaddr *)&c->h.cli_addr, c->h.clilen);
+#endif
+    evl_clients[i] = c;
+}
+
+static int evl_runnable(const struct evl_client *c)
+{
+    if (!c || c->busy || c->len == 0 || c->need_more)
+    {
+        return 0;
+    }
+
+    if (c->binary != 0)
+    {
+        return 1;   /* evl_run() works out whether the frame is complete */
+    }
+
+    return c->len == EVL_BUFSZ || memchr(c->buf, '\n', c->len)
+           || memchr(c->buf, '\r', c->len);
+}
+
+/* read what the client sent, returns -1 once it has gone away */
+static int evl_read(struct evl_client *c)
+{
+    ssize_t n;
+
+    if (c->len == EVL_BUFSZ)
+    {
+        return 0;
+    }
+
+    n = recv(c->h.sock, c->buf + c->len, EVL_BUFSZ - c->len, 0);
+
+    if (n <= 0)
+    {
+        return -1;
+    }
+
+    c->len += n;
+    c->need_more = 0;
+
+    return 0;
+}
+
+#ifdef RIGCTL_PARSE_BUF
+/*
+ * Text command on a complete line: parse it straight from the client's
+ * buffer and send the reply with no stdio in between.  Returns
+ * RIGCTL_PARSE_INCOMPLETE if evl_run() has to use rigctl_parse() instead.
+ */
+static int evl_parse_line(struct evl_client *c, long *used)
+{
+    struct rigctl_out out = { c->reply, sizeof(c->reply), 0 };
+    const char *eol = memchr(c->buf, '\n', c->len);
+    const char *cr = memchr(c->buf, '\r', eol ? (size_t)(eol - c->buf) : c->len);
+    size_t sent = 0;
+    int retcode;
+
+    if (cr) { eol = cr; }
+
+    if (!eol)
+    {
+        return (RIGCTL_PARSE_INCOMPLETE);
+    }
+
+    retcode = rigctl_parse_buf(c->h.rig, c->buf, eol - c->buf + 1, &out,
+                               mutex_rigctld, &c->h.vfo_mode, '\r',
+                               &c->ext_resp, &resp_sep, c->h.use_password);
+
+    if (retcode == RIGCTL_PARSE_INCOMPLETE)
+    {
+        return retcode;
+    }
+
+    *used = eol - c->buf + 1;
+
+    while (sent < out.len)
+    {
+        ssize_t n = send(c->h.sock, c->reply + sent, out.len - sent, 0);
+
+        if (n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (n <= 0)
+        {
+            handle_error(RIG_DEBUG_WARN, "send");
+            return (RIGCTL_PARSE_END);
+        }
+
+        sent += n;
+    }
+
+    return retcode;
+}
+#endif
+
+/* run the client's next buffered command, returns -1 to drop the client */
+static int evl_run(struct evl_client *c)
+{
+    struct rigctld_rig *served = c->h.served;
+    FILE *fsockin;
+    long used;
+    int eof;
+    int retcode;
+
+    if (!served->opened)
+    {
+        retcode = rig_open(served->rig);
+        served->opened = retcode == RIG_OK ? 1 : 0;
+        rig_debug(RIG_DEBUG_ERR, "%s: rig_open reopened retcode=%d\n", __func__,
+                  retcode);
+
+        if (!served->opened)
+        {
+            return -1;
+        }
+    }
+
+    fsockin = fmemopen(c->buf, c->len, "r");
+
+    if (!fsockin)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: fmemopen: %s\n", __func__, strerror(errno));
+        return -1;
+    }
+
+#ifdef RIGCTL_BINARY
+
+    if (c->binary < 0)
+    {
+        if (c->buf[0] == RIGCTL_BIN_MAGIC[0] && c->len < RIGCTL_BIN_MAGIC_LEN)
+        {
+            fclose(fsockin);
+            c->need_more = 1;
+            return 0;
+        }
+
+        c->binary = negotiate_binary(fsockin, c->fsockout);
+
+        if (c->binary < 0)
+        {
+            fclose(fsockin);
+            return -1;
+        }
+
+        if (c->binary)
+        {
+            c->len -= RIGCTL_BIN_MAGIC_LEN;
+            memmove(c->buf, c->buf + RIGCTL_BIN_MAGIC_LEN, c->len);
+            fclose(fsockin);
+            return 0;
+        }
+    }
+
+#endif
+#ifdef RIGCTL_PARSE_BUF
+    retcode = c->binary == 0 ? evl_parse_line(c, &used) : RIGCTL_PARSE_INCOMPLETE;
+
+    if (retcode != RIGCTL_PARSE_INCOMPLETE)
+    {
+        eof = 0;
+        fclose(fsockin);
+    }
+    else
+#endif
+    {
+#ifdef RIGCTL_BINARY
+
+        if (c->binary)
+        {
+            retcode = rigctl_parse_bin(c->h.rig, fsockin, c->fsockout, mutex_rigctld,
+                                       &c->h.vfo_mode, c->h.use_password);
+        }
+        else
+#endif
+            retcode = rigctl_parse(c->h.rig, fsockin, c->fsockout, NULL, 0,
+                                   mutex_rigctld, 1, 0, &c->h.vfo_mode, '\r',
+                                   &c->ext_resp, &resp_sep, c->h.use_password);
+
+        used = ftell(fsockin);
+        eof = feof(fsockin);
+        fclose(fsockin);
+    }
+
+    /* ran out of input before the command was complete, nothing done yet */
+    if (retcode == RIGCTL_PARSE_ERROR && eof)
+    {
+        if (c->len == EVL_BUFSZ)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: command too long\n", __func__);
+            return -1;
+        }
+
+        c->need_more = 1;
+        return 0;
+    }
+
+    if (retcode == RIGCTL_PARSE_ERROR && c->binary > 0)
+    {
+        return -1;  /* malformed frame, we cannot resync */
+    }
+
+    if (used <= 0 || used > (long)c->len)
+    {
+        used = c->len;
+    }
+
+    c->len -= used;
+    memmove(c->buf, c->buf + used, c->len);
+
+    if (retcode == RIGCTL_PARSE_END)
+    {
+        return -1;
+    }
+
+    // same recovery as handle_socket(), minus the sleep which would stall everyone
+    if (retcode < 0 && !RIG_IS_SOFT_ERRCODE(-retcode))
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: i/o error\n", __func__);
+        rig_close(served->rig);
+        retcode = rig_open(served->rig);
+        served->opened = retcode == RIG_OK ? 1 : 0;
+        rig_debug(RIG_DEBUG_ERR, "%s: rig_open retcode=%d, opened=%d\n", __func__,
+                  retcode, served->opened);
+
+        if (!served->opened)
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* runs on the strand of the client's rig */
+static void evl_task(void *arg)
+{
+    struct evl_client *c = arg;
+    char ping = 0;
+
+#ifdef HAVE_PTHREAD
+    // mutex_rigctld() and friends look up the rig of the calling thread
+    pthread_setspecific(served_key, c->h.served);
+    pthread_setspecific(client_key, c->h.client);
+#endif
+    c->result = evl_run(c);
+    __atomic_store_n(&c->done, 1, __ATOMIC_RELEASE);
+
+    if (write(evl_wake[1], &ping, 1) < 0 && errno != EAGAIN)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: wake pipe: %s\n", __func__, strerror(errno));
+    }
+}
+
+/* take back the clients whose command has finished */
+static void evl_reap(void)
+{
+    char drain[64];
+    int i;
+
+    while (read(evl_wake[0], drain, sizeof(drain)) > 0) {}
+
+    for (i = 0; i < EVL_MAX_CLIENTS; i++)
+    {
+        struct evl_client *c = evl_clients[i];
+
+        if (!c || !c->busy || !__atomic_load_n(&c->done, __ATOMIC_ACQUIRE))
+        {
+            continue;
+        }
+
+        c->busy = 0;
+        c->done = 0;
+
+        if (c->result < 0)
+        {
+            evl_close(i);
+        }
+    }
+}
+
+/*
+ * Post the clients with a complete command, least served first so the
+ * strand runs them in fair queuing order.  A client out of tokens stays
+ * put; returns how many ms until the first of those may go, else -1.
+ */
+static int evl_dispatch(void)
+{
+    int order[EVL_MAX_CLIENTS];
+    double vfinish[EVL_MAX_CLIENTS];
+    int n = 0;
+    int timeout = -1;
+    int i, j;
+
+    for (i = 0; i < EVL_MAX_CLIENTS; i++)
+    {
+        struct evl_client *c = evl_clients[i];
+        double vf = 0;
+
+        if (!evl_runnable(c)) { continue; }
+
+#ifdef HAVE_PTHREAD
+
+        if (c->h.client)
+        {
+            struct rigctld_rig *r = c->h.served;
+            long ms;
+
+            pthread_mutex_lock(&r->lock);
+            ms = client_token(c->h.client);
+            vf = c->h.client->vfinish;
+            pthread_mutex_unlock(&r->lock);
+
+            if (ms > 0)
+            {
+                if (timeout < 0 || ms < timeout) { timeout = (int) ms; }
+
+                continue;
+            }
+        }
+
+#endif
+
+        for (j = n; j > 0 && vfinish[j - 1] > vf; j--)
+        {
+            order[j] = order[j - 1];
+            vfinish[j] = vfinish[j - 1];
+        }
+
+        order[j] = i;
+        vfinish[j] = vf;
+        n++;
+    }
+
+    for (j = 0; j < n; j++)
+    {
+        struct evl_client *c = evl_clients[order[j]];
+
+        c->busy = 1;
+
+        if (hl_strand_post(c->h.served->strand, evl_task, c) != RIG_OK)
+        {
+            evl_close(order[j]);
+        }
+    }
+
+    return timeout;
+}
+
+static int rigctld_event_loop(int vfo_mode)
+{
+    struct pollfd fds[RIGCTLD_MAX_RIGS + 1 + EVL_MAX_CLIENTS];
+    int slot[RIGCTLD_MAX_RIGS + 1 + EVL_MAX_CLIENTS];
+    hl_executor_t *ex = hl_executor_default();
+    int nlisten = rig_count + 1;
+    int timeout = -1;
+    int i;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: serving clients from one thread\n",
+              __func__);
+
+    if (pipe(evl_wake) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pipe: %s\n", __func__, strerror(errno));
+        return -1;
+    }
+
+    fcntl(evl_wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(evl_wake[1], F_SETFL, O_NONBLOCK);
+
+    for (i = 0; i < rig_count; i++)
+    {
+        rigs[i].strand = hl_strand_new(ex, rigs[i].portno);
+
+        if (!rigs[i].strand)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: no executor\n", __func__);
+            return -1;
+        }
+
+        /* clients arrive in bursts while we are busy with the rig, queue them all */
+        if (listen(rigs[i].sock_listen, EVL_MAX_CLIENTS) < 0)
+        {
+            handle_error(RIG_DEBUG_WARN, "listen");
+        }
+    }
+
+    while (!ctrl_c)
+    {
+        int nfds = nlisten;
+        int n;
+
+        for (i = 0; i < rig_count; i++)
+        {
+            fds[i].fd = rigs[i].sock_listen;
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+
+        fds[rig_count].fd = evl_wake[0];
+        fds[rig_count].events = POLLIN;
+        fds[rig_count].revents = 0;
+
+        for (i = 0; i < EVL_MAX_CLIENTS; i++)
+        {
+            // a full buffer waits for the rig, leaving the rest in the socket
+            if (!evl_clients[i] || evl_clients[i]->busy
+                    || evl_clients[i]->len == EVL_BUFSZ) { continue; }
+
+            fds[nfds].fd = evl_clients[i]->h.sock;
+            fds[nfds].events = POLLIN;
+            fds[nfds].revents = 0;
+            slot[nfds++] = i;
+        }
+
+        /* wake up now and then to notice CTRL+C, sooner for a throttled client */
+        n = poll(fds, nfds, timeout >= 0 && timeout < 1000 ? timeout : 1000);
+
+        if (n < 0)
+        {
+            if (errno == EINTR) { continue; }
+
+            rig_debug(RIG_DEBUG_ERR, "%s: poll() failed: %s\n", __func__,
+                      strerror(errno));
+            break;
+        }
+
+        if (fds[rig_count].revents & POLLIN)
+        {
+            evl_reap();
+        }
+
+        for (i = nlisten; i < nfds; i++)
+        {
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+            {
+                if (evl_read(evl_clients[slot[i]]) < 0)
+                {
+                    evl_close(slot[i]);
+                }
+            }
+        }
+
+        /* take every pending connection, not just the first */
+        for (i = 0; i < rig_count; i++)
+        {
+            while (fds[i].revents & POLLIN)
+            {
+                evl_accept(&rigs[i], vfo_mode);
+
+                if (poll(&fds[i], 1, 0) <= 0) { break; }
+            }
+        }
+
+        timeout = evl_dispatch();
+    }
+
+    /* let the commands in flight finish before their clients go */
+    for (i = 0; i < rig_count; i++)
+    {
+        hl_strand_free(rigs[i].strand);
+        rigs[i].strand = NULL;
+    }
+
+    for (i = 0; i < EVL_MAX_CLIENTS; i++)
+    {
+        if (evl_clients[i]) { evl_close(i); }
+    }
+
+    close(evl_wake[0]);
+    close(evl_wake[1]);
+
+    return 0;
+}
+#endif /* RIGCTLD_EVENT_LOOP */
+
+
+#ifdef RIGCTLD_UDP
+/*
+ * -U/--udp: one thread answers single datagram requests on the TCP port
+ * number.  A datagram holds one command line, best tagged "#<seq> cmd", and
+ * gets one datagram back with the same tag, so a client can retry on loss
+ * and drop duplicate replies.  Only commands that are safe to repeat are
+ * taken: the getters, set_freq and set_ptt.
+ */
+#define UDP_MAX_DATAGRAM 1472
+
+static int udp_sock = -1;
+static int udp_vfo_mode;
+
+/* tag and command policy check, the line itself is parsed by rigctl_parse_buf() */
+static int udp_allowed(const char *line, char *tag, size_t tagsz)
+{
+    const char *p = line;
+    const char *name;
+    char word[32];
+    size_t n = 0;
+    int cmd;
+
+    tag[0] = '\0';
+
+    if (*p == '#')
+    {
+        for (p++; isdigit((unsigned char)*p) && n < tagsz - 1; p++)
+        {
+            tag[n++] = *p;
+        }
+
+        tag[n] = '\0';
+
+        if (!n || *p != ' ')
+        {
+            tag[0] = '\0';
+            return 0;
+        }
+
+        p++;
+    }
+
+    if (*p == '+' || (*p != '\\' && ispunct((unsigned char)*p)))
+    {
+        p++;
+    }
+
+    if (*p == '\\')
+    {
+        for (p++, n = 0; *p && !isspace((unsigned char)*p) && n < sizeof(word) - 1;
+                p++)
+        {
+            word[n++] = *p;
+        }
+
+        word[n] = '\0';
+        cmd = rigctl_cmd_lookup(word);
+    }
+    else
+    {
+        cmd = (unsigned char) * p;
+    }
+
+    name = rigctl_cmd_name(cmd);
+
+    return name && (strncmp(name, "get_", 4) == 0
+                    || strcmp(name, "set_freq") == 0
+                    || strcmp(name, "set_ptt") == 0);
+}
+
+static size_t udp_error(char *reply, size_t size, const char *tag, int code)
+{
+    return snprintf(reply, size, "%s%s%s" NETRIGCTL_RET "%d\n",
+                    tag[0] ? "#" : "", tag, tag[0] ? " " : "", code);
+}
+
+static void *udp_server(void *arg)
+{
+    char req[UDP_MAX_DATAGRAM + 1];
+    char reply[UDP_MAX_DATAGRAM];
+    char tag[16];
+
+    while (!ctrl_c)
+    {
+        struct rigctl_out out = { reply, sizeof(reply), 0 };
+        struct sockaddr_storage from;
+        socklen_t fromlen = sizeof(from);
+        struct timeval timeout;
+        fd_set set;
+        ssize_t n;
+
+        /* wake up now and then for CTRL+C */
+        FD_ZERO(&set);
+        FD_SET(udp_sock, &set);
+        timeout.tv_sec = 1;
+        timeout.tv_usec = 0;
+
+        if (select(udp_sock + 1, &set, NULL, NULL, &timeout) <= 0)
+        {
+            continue;
+        }
+
+        n = recvfrom(udp_sock, req, sizeof(req) - 1, 0, (struct sockaddr *)&from,
+                     &fromlen);
+
+        if (n <= 0)
+        {
+            if (n < 0 && errno != EINTR) { handle_error(RIG_DEBUG_WARN, "recvfrom"); }
+
+            continue;
+        }
+
+        req[n] = '\0';
+
+        if (!udp_allowed(req, tag, sizeof(tag)))
+        {
+            rig_debug(RIG_DEBUG_VERBOSE, "%s: refused '%s'\n", __func__,
+                      strtok(req, "\r\n"));
+            out.len = udp_error(reply, sizeof(reply), tag, -RIG_ENAVAIL);
+        }
+        else if (!rig_opened)
+        {
+            out.len = udp_error(reply, sizeof(reply), tag, -RIG_EIO);
+        }
+        else
+        {
+            int vfo_mode = udp_vfo_mode;
+            int ext_resp = 0;
+            char sep = resp_sep;
+
+            if (rigctl_parse_buf(my_rig, req, n, &out, mutex_rigctld, &vfo_mode, '\r',
+                                 &ext_resp, &sep, 0) == RIGCTL_PARSE_INCOMPLETE)
+            {
+                // no second datagram to read the rest from
+                out.len = udp_error(reply, sizeof(reply), tag, -RIG_EINVAL);
+            }
+        }
+
+        if (out.len > 0
+                && sendto(udp_sock, reply, out.len, 0, (struct sockaddr *)&from,
+                          fromlen) < 0)
+        {
+            handle_error(RIG_DEBUG_WARN, "sendto");
+        }
+    }
+
+    return NULL;
+}
+
+static int udp_start(const char *src_addr, const char *portno, int vfo_mode)
+{
+    struct addrinfo hints, *result, *rp;
+    pthread_t thread;
+    int retcode;
+
+    memset(&hints, 0, sizeof(struct addrinfo));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE;
+
+    retcode = getaddrinfo(src_addr, portno, &hints, &result);
+
+    if (retcode != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: getaddrinfo: %s\n", __func__,
+                  gai_strerror(retcode));
+        return -RIG_EINVAL;
+    }
+
+    for (rp = result; rp; rp = rp->ai_next)
+    {
+        udp_sock = socket(rp->ai_family, rp->ai_socktype, rp->ai_protocol);
+
+        if (udp_sock < 0)
+        {
+            continue;
+        }
+
+#ifdef IPV6_V6ONLY
+
+        if (AF_INET6 == rp->ai_family)
+        {
+            int sockopt = 0;
+
+            setsockopt(udp_sock, IPPROTO_IPV6, IPV6_V6ONLY, (char *)&sockopt,
+                       sizeof(sockopt));
+        }
+
+#endif
+
+        if (0 == bind(udp_sock, rp->ai_addr, rp->ai_addrlen))
+        {
+            break;
+        }
+
+        handle_error(RIG_DEBUG_WARN, "UDP binding failed (trying next interface)");
+#ifdef __MINGW32__
+        closesocket(udp_sock);
+#else
+        close(udp_sock);
+#endif
+        udp_sock = -1;
+    }
+
+    freeaddrinfo(result);
+
+    if (udp_sock < 0)
+    {
+        return -RIG_EIO;
+    }
+
+    udp_vfo_mode = vfo_mode;
+
+    if (pthread_create(&thread, NULL, udp_server, NULL) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        return -RIG_EINTERNAL;
+    }
+
+    pthread_detach(thread);
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: rigctld listening on UDP port %s\n", __func__,
+              portno);
+
+    return RIG_OK;
+}
+#endif /* RIGCTLD_UDP */
+
+#ifdef RIGCTLD_HTTP
+/*
+ * -H/--http: a read-only HTTP/1.1 front end for web dashboards, on a port
+ * and a thread of its own, answered from the cache so that no browser
+ * ever waits for the rig or makes rigctld poll it:
+ *
+ *   GET /state[?rig=N]     the snapshot_serialize() JSON of the multicast
+ *                          publisher
+ *   GET /spectrum[?rig=N]  the same with the latest spectrum line
+ *   GET /metrics[?rig=N]   rig_get_metrics(), for a Prometheus scrape
+ *   GET /ws[?rig=N]        a WebSocket: a full state snapshot first, then
+ *                          a multicast style delta of each change as a
+ *                          text message, and spectrum lines in the binary
+ *                          multicast format as binary messages; a client
+ *                          offering the WS_COMPRESSED subprotocol gets them
+ *                          entropy coded, see snapshot_data.c
+ *
+ * One poll() loop serves every client.  The state is looked at every
+ * HTTP_TICK_MS and one delta made per rig for all its WebSocket clients.
+ * A client that falls behind loses spectrum lines first; one that cannot
+ * take a state message gets a full snapshot again once it has caught up.
+ * N counts the rigs in -R order, the -m rig being 0.
+ */
+#define HTTP_MAX_CLIENTS 64
+#define HTTP_INSZ 4096
+#define HTTP_OUTSZ (128 * 1024)
+#define HTTP_TICK_MS 100
+#define HTTP_KEYFRAME 1000      /* deltas between full state messages */
+#define WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_COMPRESSED "hamlib.spectrum.compressed"
+#define WS_TEXT 0x1
+#define WS_BINARY 0x2
+#define WS_CLOSE 0x8
+#define WS_PING 0x9
+#define WS_PONG 0xa
+
+struct http_client
+{
+    int sock;
+    int rig;                /* index into rigs[] */
+    int ws;                 /* upgraded to a WebSocket */
+    int compress;           /* negotiated WS_COMPRESSED */
+    int resync;             /* owes the client a full state message */
+    int closing;            /* close once out is sent */
+    size_t in_len;
+    char in[HTTP_INSZ];
+    size_t out_off;
+    size_t out_len;         /* bytes waiting in out from out_off */
+    unsigned char *out;
+};
+
+struct http_rig
+{
+    int ws_clients;
+    struct snapshot_state_history history;
+    struct snapshot_spectrum_history spectrum_history;
+    int ws_compressed;      /* of ws_clients */
+    struct snapshot_spectrum_history compressed_history;
+    int have_line;
+    struct rig_spectrum_line line;
+    unsigned char line_data[HAMLIB_MAX_SPECTRUM_DATA];
+};
+
+/* the lock guards both, the spectrum callback runs on the rig's thread */
+static struct http_client *http_clients[HTTP_MAX_CLIENTS];
+static struct http_rig *http_rigs[RIGCTLD_MAX_RIGS];
+static pthread_mutex_t http_lock = PTHREAD_MUTEX_INITIALIZER;
+static int http_sock = -1;
+static int http_wake[2] = { -1, -1 };
+
+static void http_base64(const unsigned char *in, size_t len, char *out)
+{
+    static const char b64[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i;
+
+    for (i = 0; i < len; i += 3)
+    {
+        unsigned long v = in[i] << 16;
+
+        if (i + 1 < len) { v |= in[i + 1] << 8; }
+
+        if (i + 2 < len) { v |= in[i + 2]; }
+
+        *out++ = b64[(v >> 18) & 63];
+        *out++ = b64[(v >> 12) & 63];
+        *out++ = i + 1 < len ? b64[(v >> 6) & 63] : '=';
+        *out++ = i + 2 < len ? b64[v & 63] : '=';
+    }
+
+    *out = '\0';
+}
+
+/* all of head and data or nothing, -1 when they do not fit */
+static int http_queue(struct http_client *c, const void *head, size_t head_len,
+                      const void *data, size_t len)
+{
+    if (c->out_len + head_len + len > HTTP_OUTSZ)
+    {
+        return -1;
+    }
+
+    if (c->out_off + c->out_len + head_len + len > HTTP_OUTSZ)
+    {
+        memmove(c->out, c->out + c->out_off, c->out_len);
+        c->out_off = 0;
+    }
+
+    memcpy(c->out + c->out_off + c->out_len, head, head_len);
+    c->out_len += head_len;
+    memcpy(c->out + c->out_off + c->out_len, data, len);
+    c->out_len += len;
+
+    return 0;
+}
+
+static int ws_send(struct http_client *c, int opcode, const void *data,
+                   size_t len)
+{
+    unsigned char head[10];
+    size_t n = 2;
+    int i;
+
+    head[0] = 0x80 | opcode;
+
+    if (len < 126)
+    {
+        head[1] = len;
+    }
+    else if (len < 65536)
+    {
+        head[1] = 126;
+        head[2] = len >> 8;
+        head[3] = len & 0xff;
+        n = 4;
+    }
+    else
+    {
+        head[1] = 127;
+
+        for (i = 0; i < 8; i++)
+        {
+            head[2 + i] = (unsigned char)((uint64_t) len >> (56 - 8 * i));
+        }
+
+        n = 10;
+    }
+
+    return http_queue(c, head, n, data, len);
+}
+
+static int http_reply(struct http_client *c, const char *status,
+                      const char *type, const char *body, size_t len)
+{
+    char head[256];
+    int n;
+
+    n = snprintf(head, sizeof(head), "HTTP/1.1 %s\r\n"
+                 "Content-Type: %s\r\n"
+                 "Content-Length: %u\r\n"
+                 "Cache-Control: no-cache\r\n"
+                 "Access-Control-Allow-Origin: *\r\n"
+                 "%s\r\n", status, type, (unsigned) len,
+                 c->closing ? "Connection: close\r\n" : "");
+
+    return http_queue(c, head, n, body, len);
+}
+
+static int http_error(struct http_client *c, const char *status)
+{
+    char body[64];
+
+    snprintf(body, sizeof(body), "%s\n", status);
+
+    return http_reply(c, status, "text/plain", body, strlen(body));
+}
+
+/* the value of header name in head, "" if it is not there */
+static void http_header(const char *head, const char *name, char *value,
+                        size_t size)
+{
+    size_t name_len = strlen(name);
+    const char *p = strstr(head, "\r\n");
+
+    value[0] = '\0';
+
+    while (p && p[2] != '\r' && p[2] != '\0')
+    {
+        p += 2;
+
+        if (strncasecmp(p, name, name_len) == 0 && p[name_len] == ':')
+        {
+            size_t n = 0;
+
+            for (p += name_len + 1; *p == ' ' || *p == '\t'; p++) {}
+
+            while (*p && *p != '\r' && n < size - 1)
+            {
+                value[n++] = *p++;
+            }
+
+            value[n] = '\0';
+            return;
+        }
+
+        p = strstr(p, "\r\n");
+    }
+}
+
+static int http_upgrade(struct http_client *c, const char *head, int rig)
+{
+    char key[64];
+    char upgrade[32];
+    char accept[32];
+    char protocols[256];
+    char reply[320];
+    unsigned char digest[20];
+    sha1_context ctx;
+    const char *p;
+    int compress = 0;
+    int n;
+
+    http_header(head, "Upgrade", upgrade, sizeof(upgrade));
+    http_header(head, "Sec-WebSocket-Key", key, sizeof(key));
+    http_header(head, "Sec-WebSocket-Protocol", protocols, sizeof(protocols));
+
+    // a comma separated list, the client's preference first
+    for (p = protocols; (p = strstr(p, WS_COMPRESSED)) != NULL; p++)
+    {
+        char after = p[strlen(WS_COMPRESSED)];
+
+        if ((p == protocols || p[-1] == ' ' || p[-1] == ',')
+                && (after == '\0' || after == ',' || after == ' '))
+        {
+            compress = 1;
+            break;
+        }
+    }
+
+    if (strcasecmp(upgrade, "websocket") != 0 || !key[0])
+    {
+        return http_error(c, "426 Upgrade Required");
+    }
+
+    sha1_starts(&ctx);
+    sha1_update(&ctx, (const unsigned char *) key, strlen(key));
+    sha1_update(&ctx, (const unsigned char *) WS_GUID, strlen(WS_GUID));
+    sha1_finish(&ctx, digest);
+    http_base64(digest, sizeof(digest), accept);
+
+    n = snprintf(reply, sizeof(reply), "HTTP/1.1 101 Switching Protocols\r\n"
+                 "Upgrade: websocket\r\n"
+                 "Connection: Upgrade\r\n"
+                 "Sec-WebSocket-Accept: %s\r\n%s\r\n", accept,
+                 compress ? "Sec-WebSocket-Protocol: " WS_COMPRESSED "\r\n" : "");
+
+    if (http_queue(c, reply, n, NULL, 0) < 0)
+    {
+        return -1;
+    }
+
+    // the next tick sends the first, full, state message
+    c->ws = 1;
+    c->resync = 1;
+    c->rig = rig;
+    c->compress = compress;
+    http_rigs[rig]->ws_clients++;
+    http_rigs[rig]->ws_compressed += compress;
+
+    return 0;
+}
+
+/* one request, head NUL terminated after its blank line */
+static int http_request(struct http_client *c, char *head)
+{
+    static char json[HAMLIB_MAX_SNAPSHOT_PACKET_SIZE];
+    char method[8], target[128], version[16];
+    char connection[32];
+    const char *query;
+    size_t path_len;
+    int rig = 0;
+
+    if (sscanf(head, "%7s %127s %15s", method, target, version) != 3
+            || strncmp(version, "HTTP/1.", 7) != 0)
+    {
+        c->closing = 1;
+        return http_error(c, "400 Bad Request");
+    }
+
+    http_header(head, "Connection", connection, sizeof(connection));
+
+    if (strcmp(version, "HTTP/1.0") == 0 || strcasecmp(connection, "close") == 0)
+    {
+        c->closing = 1;
+    }
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: %s %s\n", __func__, method, target);
+
+    if (strcmp(method, "GET") != 0)
+    {
+        return http_error(c, "405 Method Not Allowed");
+    }
+
+    query = strchr(target, '?');
+    path_len = query ? (size_t)(query - target) : strlen(target);
+
+    if (query && strncmp(query, "?rig=", 5) == 0)
+    {
+        rig = atoi(query + 5);
+    }
+
+    if (rig < 0 || rig >= rig_count)
+    {
+        return http_error(c, "404 Not Found");
+    }
+
+    if (path_len == 3 && strncmp(target, "/ws", 3) == 0)
+    {
+        return http_upgrade(c, head, rig);
+    }
+
+    if (path_len == 6 && strncmp(target, "/state", 6) == 0)
+    {
+        if (snapshot_serialize(sizeof(json), json, rigs[rig].rig, NULL) != RIG_OK)
+        {
+            return http_error(c, "500 Internal Server Error");
+        }
+    }
+    else if (path_len == 9 && strncmp(target, "/spectrum", 9) == 0)
+    {
+        if (!http_rigs[rig]->have_line)
+        {
+            return http_error(c, "404 Not Found");
+        }
+
+        if (snapshot_serialize(sizeof(json), json, rigs[rig].rig,
+                               &http_rigs[rig]->line) != RIG_OK)
+        {
+            return http_error(c, "500 Internal Server Error");
+        }
+    }
+    else if (path_len == 8 && strncmp(target, "/metrics", 8) == 0)
+    {
+        static char metrics[32768];
+
+        if (rig_get_metrics(rigs[rig].rig, metrics, sizeof(metrics)) != RIG_OK)
+        {
+            return http_error(c, "500 Internal Server Error");
+        }
+
+        return http_reply(c, "200 OK", METRICS_CONTENT_TYPE, metrics,
+                          strlen(metrics));
+    }
+    else
+    {
+        return http_error(c, "404 Not Found");
+    }
+
+    return http_reply(c, "200 OK", "application/json", json, strlen(json));
+}
+
+/* frames from the browser: close and ping are answered, the rest ignored */
+static int ws_input(struct http_client *c)
+{
+    while (c->in_len >= 2 && !c->closing)
+    {
+        unsigned char *p = (unsigned char *) c->in;
+        int opcode = p[0] & 0x0f;
+        size_t len = p[1] & 0x7f;
+        size_t head = 2;
+        unsigned char *payload;
+        size_t i;
+
+        if (!(p[1] & 0x80) || len == 127)
+        {
+            return -1;      /* unmasked, or bigger than anything we take */
+        }
+
+        if (len == 126)
+        {
+            if (c->in_len < 4) { return 0; }
+
+            len = p[2] << 8 | p[3];
+            head = 4;
+        }
+
+        if (head + 4 + len >= HTTP_INSZ)
+        {
+            return -1;
+        }
+
+        if (c->in_len < head + 4 + len)
+        {
+            return 0;
+        }
+
+        payload = p + head + 4;
+
+        for (i = 0; i < len; i++)
+        {
+            payload[i] ^= p[head + i % 4];
+        }
+
+        if (opcode == WS_CLOSE)
+        {
+            ws_send(c, WS_CLOSE, payload, len >= 2 ? 2 : 0);
+            c->closing = 1;
+        }
+        else if (opcode == WS_PING)
+        {
+            ws_send(c, WS_PONG, payload, len);
+        }
+
+        c->in_len -= head + 4 + len;
+        memmove(c->in, payload + len, c->in_len);
+    }
+
+    return 0;
+}
+
+static int http_read(struct http_client *c)
+{
+    char *end;
+    ssize_t n = recv(c->sock, c->in + c->in_len, HTTP_INSZ - 1 - c->in_len, 0);
+
+    if (n == 0)
+    {
+        return -1;
+    }
+
+    if (n < 0)
+    {
+        return errno == EAGAIN || errno == EINTR ? 0 : -1;
+    }
+
+    if (c->closing)
+    {
+        return 0;           /* whatever comes after a close */
+    }
+
+    c->in_len += n;
+    c->in[c->in_len] = '\0';
+
+    while (!c->ws && !c->closing && (end = strstr(c->in, "\r\n\r\n")))
+    {
+        size_t used = end + 4 - c->in;
+
+        end[2] = '\0';
+
+        if (http_request(c, c->in) < 0)
+        {
+            return -1;      /* pipelining faster than it reads */
+        }
+
+        c->in_len -= used;
+        memmove(c->in, c->in + used, c->in_len + 1);
+    }
+
+    if (c->ws)
+    {
+        return ws_input(c);
+    }
+
+    // a request head that fills the buffer is not one of ours
+    return c->in_len < HTTP_INSZ - 1 ? 0 : -1;
+}
+
+static int http_flush(struct http_client *c)
+{
+    while (c->out_len > 0)
+    {
+        ssize_t n = send(c->sock, c->out + c->out_off, c->out_len, 0);
+
+        if (n < 0)
+        {
+            return errno == EAGAIN || errno == EINTR ? 0 : -1;
+        }
+
+        c->out_off += n;
+        c->out_len -= n;
+    }
+
+    c->out_off = 0;
+
+    return c->closing ? -1 : 0;
+}
+
+static void http_accept(void)
+{
+    struct http_client *c;
+    int sock = accept(http_sock, NULL, NULL);
+    int i;
+
+    if (sock < 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < HTTP_MAX_CLIENTS && http_clients[i]; i++) {}
+
+    c = i < HTTP_MAX_CLIENTS ? calloc(1, sizeof(struct http_client)) : NULL;
+
+    if (c)
+    {
+        c->out = malloc(HTTP_OUTSZ);
+    }
+
+    if (!c || !c->out)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: no room for another HTTP client\n", __func__);
+
+        if (c) { free(c); }
+
+        close(sock);
+        return;
+    }
+
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+    set_nodelay(sock);
+    c->sock = sock;
+    http_clients[i] = c;
+}
+
+static void http_close(int i)
+{
+    struct http_client *c = http_clients[i];
+
+    if (c->ws)
+    {
+        http_rigs[c->rig]->ws_clients--;
+        http_rigs[c->rig]->ws_compressed -= c->compress;
+    }
+
+    close(c->sock);
+    free(c->out);
+    free(c);
+    http_clients[i] = NULL;
+}
+
+static void http_tick(void)
+{
+    static char full[HAMLIB_MAX_SNAPSHOT_PACKET_SIZE];
+    static char delta[HAMLIB_MAX_SNAPSHOT_PACKET_SIZE];
+    int r, i;
+
+    for (r = 0; r < rig_count; r++)
+    {
+        struct http_rig *hr = http_rigs[r];
+        int have_full = 0;
+
+        if (!hr->ws_clients)
+        {
+            continue;
+        }
+
+        if (snapshot_serialize_state(sizeof(delta), delta, rigs[r].rig, &hr->history,
+                                     HTTP_KEYFRAME) != RIG_OK)
+        {
+            delta[0] = '\0';
+        }
+
+        for (i = 0; i < HTTP_MAX_CLIENTS; i++)
+        {
+            struct http_client *c = http_clients[i];
+
+            if (!c || !c->ws || c->closing || c->rig != r)
+            {
+                continue;
+            }
+
+            if (c->resync)
+            {
+                if (!have_full)
+                {
+                    have_full = snapshot_serialize(sizeof(full), full, rigs[r].rig,
+                                                   NULL) == RIG_OK ? 1 : -1;
+                }
+
+                if (have_full > 0 && ws_send(c, WS_TEXT, full, strlen(full)) == 0)
+                {
+                    c->resync = 0;
+                }
+            }
+            else if (delta[0] && ws_send(c, WS_TEXT, delta, strlen(delta)) < 0)
+            {
+                c->resync = 1;
+            }
+        }
+    }
+}
+
+static int http_spectrum(RIG *rig, struct rig_spectrum_line *line,
+                         rig_ptr_t arg)
+{
+    static unsigned char frame[SNAPSHOT_SPECTRUM_HEADER_SIZE
+                               + HAMLIB_MAX_SPECTRUM_DATA];
+    static unsigned char compressed[SNAPSHOT_SPECTRUM_HEADER_SIZE
+                                    + HAMLIB_MAX_SPECTRUM_DATA];
+    struct http_rig *hr = http_rigs[(intptr_t) arg];
+    int queued = 0;
+    size_t len = 0, compressed_len = 0;
+    unsigned int seq;
+    int i;
+
+    if (line->spectrum_data_length > HAMLIB_MAX_SPECTRUM_DATA)
+    {
+        return RIG_OK;
+    }
+
+    pthread_mutex_lock(&http_lock);
+
+    hr->line = *line;
+    hr->line.spectrum_data = hr->line_data;
+    memcpy(hr->line_data, line->spectrum_data, line->spectrum_data_length);
+    hr->have_line = 1;
+
+    // both flavours of the line carry the same sequence number
+    seq = rig->state.snapshot_packet_sequence_number;
+    hr->compressed_history.compress = 1;
+
+    if (hr->ws_compressed > 0
+            && snapshot_serialize_spectrum_binary(sizeof(compressed), compressed,
+                    &compressed_len, rig, line, &hr->compressed_history) != RIG_OK)
+    {
+        compressed_len = 0;
+    }
+
+    if (hr->ws_clients > hr->ws_compressed)
+    {
+        rig->state.snapshot_packet_sequence_number = seq;
+
+        if (snapshot_serialize_spectrum_binary(sizeof(frame), frame, &len, rig, line,
+                                               &hr->spectrum_history) != RIG_OK)
+        {
+            len = 0;
+        }
+    }
+
+    for (i = 0; i < HTTP_MAX_CLIENTS; i++)
+    {
+        struct http_client *c = http_clients[i];
+        size_t n = !c ? 0 : c->compress ? compressed_len : len;
+
+        // a client that is behind misses the line, see the format
+        if (n && c->ws && !c->closing && c->rig == (intptr_t) arg
+                && ws_send(c, WS_BINARY, c->compress ? compressed : frame, n) == 0)
+        {
+            queued = 1;
+        }
+    }
+
+    pthread_mutex_unlock(&http_lock);
+
+    if (queued && write(http_wake[1], "", 1) < 0 && errno != EAGAIN)
+    {
+        rig_debug(RIG_DEBUG_WARN, "%s: wake: %s\n", __func__, strerror(errno));
+    }
+
+    return RIG_OK;
+}
+
+static void *http_server(void *arg)
+{
+    struct pollfd fds[2 + HTTP_MAX_CLIENTS];
+    int slot[2 + HTTP_MAX_CLIENTS];
+    struct timespec next;
+
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (!ctrl_c)
+    {
+        struct timespec now;
+        char drain[64];
+        long timeout;
+        int nfds = 2;
+        int i;
+
+        fds[0].fd = http_sock;
+        fds[0].events = POLLIN;
+        fds[1].fd = http_wake[0];
+        fds[1].events = POLLIN;
+
+        pthread_mutex_lock(&http_lock);
+
+        for (i = 0; i < HTTP_MAX_CLIENTS; i++)
+        {
+            struct http_client *c = http_clients[i];
+
+            if (!c) { continue; }
+
+            fds[nfds].fd = c->sock;
+            fds[nfds].events = POLLIN | (c->out_len ? POLLOUT : 0);
+            slot[nfds++] = i;
+        }
+
+        pthread_mutex_unlock(&http_lock);
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        timeout = (next.tv_sec - now.tv_sec) * 1000
+                  + (next.tv_nsec - now.tv_nsec) / 1000000;
+
+        /* the tick doubles as the CTRL+C check */
+        if (poll(fds, nfds, timeout > 0 ? (int) timeout : 0) < 0 && errno != EINTR)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: poll() failed: %s\n", __func__,
+                      strerror(errno));
+            break;
+        }
+
+        pthread_mutex_lock(&http_lock);
+
+        if (fds[1].revents & POLLIN)
+        {
+            while (read(http_wake[0], drain, sizeof(drain)) > 0) {}
+        }
+
+        for (i = 2; i < nfds; i++)
+        {
+            struct http_client *c = http_clients[slot[i]];
+
+            if ((fds[i].revents & (POLLERR | POLLNVAL))
+                    || ((fds[i].revents & POLLIN) && http_read(c) < 0)
+                    || (c->out_len && http_flush(c) < 0)
+                    || (c->closing && !c->out_len))
+            {
+                http_close(slot[i]);
+            }
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            http_accept();
+        }
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        if (now.tv_sec > next.tv_sec
+                || (now.tv_sec == next.tv_sec && now.tv_nsec >= next.tv_nsec))
+        {
+            http_tick();
+
+            next = now;
+            next.tv_nsec += HTTP_TICK_MS * 1000000L;
+
+            if (next.tv_nsec >= 1000000000L)
+            {
+                next.tv_sec++;
+                next.tv_nsec -= 1000000000L;
+            }
+        }
+
+        pthread_mutex_unlock(&http_lock);
+    }
+
+    return NULL;
+}
+
+static int http_start(const char *src_addr, const char *portno)
+{
+    pthread_t thread;
+    int i;
+
+    http_sock = rigctld_listen(src_addr, portno);
+
+    if (http_sock < 0)
+    {
+        return -RIG_EIO;
+    }
+
+    if (listen(http_sock, HTTP_MAX_CLIENTS) < 0)
+    {
+        handle_error(RIG_DEBUG_WARN, "listen");
+    }
+
+    if (pipe(http_wake) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pipe: %s\n", __func__, strerror(errno));
+        return -RIG_EINTERNAL;
+    }
+
+    fcntl(http_sock, F_SETFL, O_NONBLOCK);
+    fcntl(http_wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(http_wake[1], F_SETFL, O_NONBLOCK);
+
+    for (i = 0; i < rig_count; i++)
+    {
+        http_rigs[i] = calloc(1, sizeof(struct http_rig));
+
+        if (!http_rigs[i])
+        {
+            return -RIG_ENOMEM;
+        }
+
+        http_rigs[i]->history.quiet = 1;
+        rig_set_spectrum_callback(rigs[i].rig, http_spectrum, (rig_ptr_t)(intptr_t) i);
+    }
+
+    if (pthread_create(&thread, NULL, http_server, NULL) != 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: pthread_create: %s\n", __func__,
+                  strerror(errno));
+        return -RIG_EINTERNAL;
+    }
+
+    pthread_detach(thread);
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: rigctld serving HTTP on port %s\n", __func__,
+              portno);
+
+    return RIG_OK;
 }
+#endif /* RIGCTLD_HTTP */
 
 
 void usage(void)
@@ -1377,9 +4622,23 @@ void usage(void)
         "  -w, --twiddle_rit             suppress VFOB getfreq so RIT can be twiddled\n"
         "  -x, --uplink                  set uplink get_freq ignore, 1=Sub, 2=Main\n"
         "  -Z, --debug-time-stamps       enable time stamps for debug messages\n"
+        "  -Y, --debug-async             write debug messages from a background thread\n"
+        "  -E, --event-loop              poll all clients from one thread, run commands on a worker pool\n"
+        "  -U, --udp                     also answer get_*, set_freq and set_ptt over UDP on the same port\n"
         "  -M, --multicast-addr=addr     set multicast UDP address, default 0.0.0.0 (off), recommend 224.0.1.1\n"
         "  -n, --multicast-port=port     set multicast UDP port, default 4532\n"
         "  -A, --password                set password for rigctld access\n"
+        "  -R, --add-rig=PORT,MODEL[,RIG_FILE[,PARM=VAL...]]\n"
+        "                                also serve another rig on its own port, repeatable\n"
+        "  -K, --cpu-affinity=LIST       pin Hamlib's poll, async and multicast threads to CPUs, e.g. 2,3\n"
+        "  -O, --sched=POLICY[:PRIO]     run those threads at fifo or rr realtime priority PRIO\n"
+        "  -k, --mlock                   lock all memory with mlockall() before opening the rig\n"
+        "  -q, --rate-limit=RATE[:BURST] at most RATE commands per second per connection\n"
+        "  -Q, --client-weight=IPADDR=W  give clients from IPADDR W times the rig time, repeatable\n"
+        "  -G, --serve-stale             answer frequency, mode and PTT from the cache at once, refreshing it behind\n"
+        "  -H, --http=PORT               serve state as JSON over HTTP and WebSocket on PORT\n"
+        "  -J, --deadline=MS             give every command MS milliseconds, then answer from the cache\n"
+        "  -F, --replica=HOST[:PORT]     serve the rig of the rigctld at HOST from its multicast packets\n"
         "  -h, --help                    display this help and exit\n"
         "  -V, --version                 output version information and exit\n\n",
         portno);
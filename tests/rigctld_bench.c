@@ -0,0 +1,563 @@
+/*
+ * Hamlib rigctld_bench program
+ * Opens a number of concurrent client connections to a running rigctld,
+ * keeps each of them busy with a mix of commands for a while, and prints
+ * the throughput, the latencies of every client and how evenly the
+ * daemon served them as one JSON object.  rigctld_bench.sh runs it
+ * against rigctld on the dummy rig ("make bench-rigctld"), or by hand:
+ *   ./rigctld -m 1 &
+ *   ./rigctld_bench -c 50 -d 5 -x f=4,m=2,t=2,F=1,v=1
+ *
+ * Every command goes out with the '+' extended response prefix, so each
+ * answer, whatever it holds, ends on its RPRT line.
+ */
+
+#include <hamlib/config.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+
+#define DEFAULT_CLIENTS 10
+#define DEFAULT_SECONDS 5
+#define DEFAULT_MIX "f=4,m=2,t=2,F=1,v=1"
+#define MAX_CLIENTS 1000
+#define CONNECT_WAIT_MS 5000    /* rigctld may still be opening the rig */
+#define REPLY_TIMEOUT_S 5
+
+enum bench_cmd_e
+{
+    CMD_GET_FREQ,
+    CMD_GET_MODE,
+    CMD_GET_PTT,
+    CMD_SET_FREQ,
+    CMD_GET_VFO_INFO,
+    CMD_COUNT
+};
+
+static const struct
+{
+    char key;
+    const char *name;
+} bench_cmds[CMD_COUNT] =
+{
+    { 'f', "get_freq" },
+    { 'm', "get_mode" },
+    { 't', "get_ptt" },
+    { 'F', "set_freq" },
+    { 'v', "get_vfo_info" },
+};
+
+struct bench_client
+{
+    int id;
+    int fd;
+    pthread_t thread;
+    unsigned int seed;
+    long n;
+    long errors;
+    long n_cmd[CMD_COUNT];
+    long err_cmd[CMD_COUNT];
+    double *lat_us;         /* every request, grown as needed */
+    long lat_size;
+    char rbuf[1024];        /* unread reply bytes */
+    int rlen;
+};
+
+static const char *host = "127.0.0.1";
+static const char *port = "4532";
+static int weight[CMD_COUNT];
+static int weight_total;
+static double run_seconds = DEFAULT_SECONDS;
+
+static pthread_mutex_t start_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t start_cond = PTHREAD_COND_INITIALIZER;
+static int started;
+static struct timespec stop_at;
+
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+
+/* v must be sorted */
+static double percentile(const double *v, long n, double p)
+{
+    long i;
+
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    i = (long)(p / 100 * (n - 1) + 0.5);
+
+    return v[i];
+}
+
+
+static int parse_mix(const char *mix)
+{
+    char *s = strdup(mix), *tok, *save = NULL;
+    int i;
+
+    memset(weight, 0, sizeof(weight));
+    weight_total = 0;
+
+    for (tok = strtok_r(s, ",", &save); tok; tok = strtok_r(NULL, ",", &save))
+    {
+        int w = 1;
+
+        if (tok[0] == '\0' || (tok[1] != '\0' && tok[1] != '='))
+        {
+            free(s);
+            return -1;
+        }
+
+        if (tok[1] == '=')
+        {
+            w = atoi(tok + 2);
+        }
+
+        for (i = 0; i < CMD_COUNT; i++)
+        {
+            if (bench_cmds[i].key == tok[0])
+            {
+                break;
+            }
+        }
+
+        if (i == CMD_COUNT || w < 0)
+        {
+            free(s);
+            return -1;
+        }
+
+        weight[i] += w;
+        weight_total += w;
+    }
+
+    free(s);
+
+    return weight_total > 0 ? 0 : -1;
+}
+
+
+static int bench_connect(void)
+{
+    struct addrinfo hints, *res, *ai;
+    double give_up = now_us() + CONNECT_WAIT_MS * 1000.0;
+    int fd = -1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(host, port, &hints, &res) != 0)
+    {
+        fprintf(stderr, "cannot resolve %s:%s\n", host, port);
+        return -1;
+    }
+
+    while (fd < 0 && now_us() < give_up)
+    {
+        for (ai = res; ai; ai = ai->ai_next)
+        {
+            fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+
+            if (fd < 0)
+            {
+                continue;
+            }
+
+            if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0)
+            {
+                break;
+            }
+
+            close(fd);
+            fd = -1;
+        }
+
+        if (fd < 0)
+        {
+            usleep(100 * 1000);
+        }
+    }
+
+    freeaddrinfo(res);
+
+    if (fd >= 0)
+    {
+        struct timeval tv = { REPLY_TIMEOUT_S, 0 };
+        int one = 1;
+
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+
+    return fd;
+}
+
+
+/* reads one extended response, returns its RPRT code or 1 on I/O trouble */
+static int bench_reply(struct bench_client *c)
+{
+    while (1)
+    {
+        char *nl;
+
+        while ((nl = memchr(c->rbuf, '\n', c->rlen)) != NULL)
+        {
+            int len = nl - c->rbuf + 1;
+            int rprt = 1;
+            int is_rprt = strncmp(c->rbuf, "RPRT ", 5) == 0;
+
+            if (is_rprt)
+            {
+                rprt = atoi(c->rbuf + 5);
+            }
+
+            memmove(c->rbuf, c->rbuf + len, c->rlen - len);
+            c->rlen -= len;
+
+            if (is_rprt)
+            {
+                return rprt;
+            }
+        }
+
+        if (c->rlen == sizeof(c->rbuf))
+        {
+            /* a line longer than any rigctld answer; drop it */
+            c->rlen = 0;
+        }
+
+        {
+            ssize_t n = recv(c->fd, c->rbuf + c->rlen, sizeof(c->rbuf) - c->rlen, 0);
+
+            if (n <= 0)
+            {
+                return 1;
+            }
+
+            c->rlen += n;
+        }
+    }
+}
+
+
+static int pick_cmd(struct bench_client *c)
+{
+    int r = rand_r(&c->seed) % weight_total;
+    int i;
+
+    for (i = 0; i < CMD_COUNT - 1; i++)
+    {
+        if (r < weight[i])
+        {
+            break;
+        }
+
+        r -= weight[i];
+    }
+
+    return i;
+}
+
+
+static void *bench_client_thread(void *arg)
+{
+    struct bench_client *c = (struct bench_client *) arg;
+    struct timespec now;
+
+    pthread_mutex_lock(&start_lock);
+
+    while (!started)
+    {
+        pthread_cond_wait(&start_cond, &start_lock);
+    }
+
+    pthread_mutex_unlock(&start_lock);
+
+    while (1)
+    {
+        char cmd[64];
+        int k = pick_cmd(c);
+        double t0;
+        int len, rc;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+
+        if (now.tv_sec > stop_at.tv_sec
+                || (now.tv_sec == stop_at.tv_sec && now.tv_nsec >= stop_at.tv_nsec))
+        {
+            break;
+        }
+
+        switch (k)
+        {
+        case CMD_GET_FREQ: len = snprintf(cmd, sizeof(cmd), "+f\n"); break;
+
+        case CMD_GET_MODE: len = snprintf(cmd, sizeof(cmd), "+m\n"); break;
+
+        case CMD_GET_PTT: len = snprintf(cmd, sizeof(cmd), "+t\n"); break;
+
+        case CMD_SET_FREQ:
+            /* each client tunes its own 1 kHz slot so the writes differ */
+            len = snprintf(cmd, sizeof(cmd), "+F %d\n",
+                           14000000 + c->id * 1000 + (int)(c->n % 1000));
+            break;
+
+        default:
+            len = snprintf(cmd, sizeof(cmd), "+\\get_vfo_info VFOA\n");
+            break;
+        }
+
+        t0 = now_us();
+
+        if (send(c->fd, cmd, len, 0) != len)
+        {
+            c->errors++;
+            break;
+        }
+
+        rc = bench_reply(c);
+
+        if (rc == 1)
+        {
+            /* timed out or closed, the connection is of no more use */
+            c->errors++;
+            break;
+        }
+
+        if (c->n == c->lat_size)
+        {
+            long size = c->lat_size ? c->lat_size * 2 : 4096;
+            double *lat = realloc(c->lat_us, size * sizeof(double));
+
+            if (!lat)
+            {
+                break;
+            }
+
+            c->lat_us = lat;
+            c->lat_size = size;
+        }
+
+        c->lat_us[c->n++] = now_us() - t0;
+        c->n_cmd[k]++;
+
+        if (rc != 0)
+        {
+            c->errors++;
+            c->err_cmd[k]++;
+        }
+    }
+
+    return NULL;
+}
+
+
+static void usage(const char *name)
+{
+    printf("Usage: %s [-h host] [-p port] [-c clients] [-d seconds] [-x mix]\n\n"
+           "  -h host     rigctld address, default 127.0.0.1\n"
+           "  -p port     rigctld port, default 4532\n"
+           "  -c clients  concurrent connections, default %d\n"
+           "  -d seconds  how long to run, default %d\n"
+           "  -x mix      command weights, default %s\n"
+           "              f get_freq, m get_mode, t get_ptt, F set_freq,\n"
+           "              v get_vfo_info\n",
+           name, DEFAULT_CLIENTS, DEFAULT_SECONDS, DEFAULT_MIX);
+}
+
+
+int main(int argc, char *argv[])
+{
+    struct bench_client *clients;
+    int nclients = DEFAULT_CLIENTS;
+    const char *mix = DEFAULT_MIX;
+    double t_start, elapsed, *all;
+    double sum_rate = 0, sum_rate2 = 0;
+    long total = 0, errors = 0, k;
+    int i, c, j;
+
+    while ((c = getopt(argc, argv, "h:p:c:d:x:")) != -1)
+    {
+        switch (c)
+        {
+        case 'h': host = optarg; break;
+
+        case 'p': port = optarg; break;
+
+        case 'c': nclients = atoi(optarg); break;
+
+        case 'd': run_seconds = atof(optarg); break;
+
+        case 'x': mix = optarg; break;
+
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (nclients < 1 || nclients > MAX_CLIENTS || run_seconds <= 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (parse_mix(mix) < 0)
+    {
+        fprintf(stderr, "bad command mix '%s'\n", mix);
+        return 1;
+    }
+
+    clients = calloc(nclients, sizeof(*clients));
+
+    if (!clients)
+    {
+        return 1;
+    }
+
+    /* every client is connected before the clock starts */
+    for (i = 0; i < nclients; i++)
+    {
+        clients[i].id = i;
+        clients[i].seed = i + 1;
+        clients[i].fd = bench_connect();
+
+        if (clients[i].fd < 0)
+        {
+            fprintf(stderr, "client %d: cannot connect to %s:%s\n", i, host, port);
+            return 1;
+        }
+
+        if (pthread_create(&clients[i].thread, NULL, bench_client_thread,
+                           &clients[i]))
+        {
+            fprintf(stderr, "client %d: pthread_create: %s\n", i, strerror(errno));
+            return 1;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &stop_at);
+    stop_at.tv_sec += (time_t) run_seconds;
+    stop_at.tv_nsec += (long)((run_seconds - floor(run_seconds)) * 1e9);
+
+    if (stop_at.tv_nsec >= 1000000000L)
+    {
+        stop_at.tv_sec++;
+        stop_at.tv_nsec -= 1000000000L;
+    }
+
+    t_start = now_us();
+
+    pthread_mutex_lock(&start_lock);
+    started = 1;
+    pthread_cond_broadcast(&start_cond);
+    pthread_mutex_unlock(&start_lock);
+
+    for (i = 0; i < nclients; i++)
+    {
+        pthread_join(clients[i].thread, NULL);
+        close(clients[i].fd);
+        total += clients[i].n;
+        errors += clients[i].errors;
+    }
+
+    elapsed = (now_us() - t_start) / 1e6;
+
+    all = malloc((total ? total : 1) * sizeof(double));
+
+    if (!all)
+    {
+        return 1;
+    }
+
+    for (i = 0, k = 0; i < nclients; i++)
+    {
+        double rate = clients[i].n / elapsed;
+
+        memcpy(all + k, clients[i].lat_us, clients[i].n * sizeof(double));
+        k += clients[i].n;
+        qsort(clients[i].lat_us, clients[i].n, sizeof(double), cmp_double);
+        sum_rate += rate;
+        sum_rate2 += rate * rate;
+    }
+
+    qsort(all, total, sizeof(double), cmp_double);
+
+    printf("{\"host\": \"%s\", \"port\": \"%s\", \"clients\": %d, \"mix\": \"%s\",\n",
+           host, port, nclients, mix);
+    printf(" \"seconds\": %.2f, \"requests\": %ld, \"errors\": %ld,"
+           " \"requests_per_s\": %.1f,\n", elapsed, total, errors, total / elapsed);
+    printf(" \"p50_us\": %.0f, \"p90_us\": %.0f, \"p99_us\": %.0f,"
+           " \"max_us\": %.0f,\n", percentile(all, total, 50),
+           percentile(all, total, 90), percentile(all, total, 99),
+           total ? all[total - 1] : 0);
+    /* Jain's index over the per-client rates: 1 when all were served alike */
+    printf(" \"fairness\": %.3f,\n \"commands\": {\n  ",
+           sum_rate2 > 0 ? sum_rate * sum_rate / (nclients * sum_rate2) : 0);
+
+    for (j = 0; j < CMD_COUNT; j++)
+    {
+        long n = 0, e = 0;
+
+        for (i = 0; i < nclients; i++)
+        {
+            n += clients[i].n_cmd[j];
+            e += clients[i].err_cmd[j];
+        }
+
+        printf("%s\"%s\": {\"requests\": %ld, \"errors\": %ld}", j ? ",\n  " : "",
+               bench_cmds[j].name, n, e);
+    }
+
+    printf("},\n \"per_client\": [\n");
+
+    for (i = 0; i < nclients; i++)
+    {
+        struct bench_client *bc = &clients[i];
+
+        printf("  {\"client\": %d, \"requests\": %ld, \"errors\": %ld,"
+               " \"p50_us\": %.0f, \"p99_us\": %.0f}%s\n", i, bc->n, bc->errors,
+               percentile(bc->lat_us, bc->n, 50), percentile(bc->lat_us, bc->n, 99),
+               i < nclients - 1 ? "," : "");
+        free(bc->lat_us);
+    }
+
+    printf(" ]}\n");
+
+    free(all);
+    free(clients);
+
+    return errors ? 2 : 0;
+}
@@ -0,0 +1,48 @@
+#!/bin/sh
+
+# Starts rigctld on a rig and runs rigctld_bench with growing numbers of
+# clients, printing one JSON document.
+# Usage: rigctld_bench.sh [model [rig_path]]
+# The dummy rig (model 1) is the default; a simulator pty works as well.
+# BENCH_CLIENTS, BENCH_SECONDS, BENCH_MIX and BENCH_PORT override the
+# defaults below.
+
+model=${1:-1}
+rig_path=$2
+clients=${BENCH_CLIENTS:-"1 10 50"}
+seconds=${BENCH_SECONDS:-3}
+mix=${BENCH_MIX:-"f=4,m=2,t=2,F=1,v=1"}
+port=${BENCH_PORT:-4599}
+
+if [ -n "$rig_path" ]; then
+    ./rigctld -m "$model" -r "$rig_path" -T 127.0.0.1 -t "$port" > rigctld_bench.log 2>&1 &
+else
+    ./rigctld -m "$model" -T 127.0.0.1 -t "$port" > rigctld_bench.log 2>&1 &
+fi
+
+pid=$!
+
+echo "{\"date\": \"$(date -u +%Y-%m-%dT%H:%M:%SZ)\", \"model\": $model, \"runs\": ["
+
+first=1
+
+for n in $clients; do
+    # rigctld_bench waits for the port to open
+    if out=$(./rigctld_bench -p "$port" -c "$n" -d "$seconds" -x "$mix"); then
+        :
+    else
+        echo "$n clients: errors, see rigctld_bench.log" >&2
+    fi
+
+    if [ -n "$out" ]; then
+        [ $first = 1 ] || echo ","
+        echo "$out"
+        first=0
+    fi
+done
+
+echo "]}"
+
+kill $pid 2>/dev/null
+wait $pid 2>/dev/null
+exit 0
@@ -634,6 +634,15 @@ int main(int argc, char *argv[])
     int i, nbytes, nbytes_total = 0;
     char *pbuf, prntbuf[4096];
 
+    /*
+     * -j: the same capabilities as JSON, without the tables and range
+     * images, for pages rendered from data rather than from this HTML
+     */
+    if (argc > 1 && !strcmp(argv[1], "-j"))
+    {
+        return rig_caps_export_json(stdout, 0) == RIG_OK ? 0 : 1;
+    }
+
     rig_load_all_backends();
 
 
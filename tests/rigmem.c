@@ -63,6 +63,8 @@ void version();
 int set_conf(RIG *rig, char *conf_parms);
 
 int clear_chans(RIG *rig, const char *infilename);
+int image_save(RIG *rig, const char *outfilename);
+int image_load(RIG *rig, const char *infilename);
 
 /*
  * Reminder: when adding long options,
@@ -383,6 +385,14 @@ int main(int argc, char *argv[])
     {
         retcode = clear_chans(rig, argv[optind + 1]);
     }
+    else if (!strcmp(argv[optind], "save_image"))
+    {
+        retcode = image_save(rig, argv[optind + 1]);
+    }
+    else if (!strcmp(argv[optind], "load_image"))
+    {
+        retcode = image_load(rig, argv[optind + 1]);
+    }
     else
     {
         usage();
@@ -437,6 +447,8 @@ void usage()
         "  save\n"
         "  load_parm\n"
         "  save_parm\n"
+        "  save_image\n"
+        "  load_image\n"
         "  clear\n\n"
     );
 
@@ -518,3 +530,89 @@ int clear_chans(RIG *rig, const char *infilename)
 
     return 0;
 }
+
+
+/* raw clone mode memory image to/from a file, byte for byte */
+int image_save(RIG *rig, const char *outfilename)
+{
+    size_t size = rig_clone_size(rig);
+    unsigned char *image;
+    FILE *f;
+    int ret;
+
+    if (size == 0)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    image = malloc(size);
+
+    if (!image)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    ret = rig_clone_read(rig, image, size);
+
+    if (ret == RIG_OK)
+    {
+        f = fopen(outfilename, "wb");
+
+        if (!f || fwrite(image, 1, size, f) != size)
+        {
+            ret = -RIG_EIO;
+        }
+
+        if (f && fclose(f) != 0)
+        {
+            ret = -RIG_EIO;
+        }
+    }
+
+    free(image);
+
+    return ret;
+}
+
+
+int image_load(RIG *rig, const char *infilename)
+{
+    size_t size = rig_clone_size(rig);
+    unsigned char *image;
+    FILE *f;
+    int ret = RIG_OK;
+
+    if (size == 0)
+    {
+        return -RIG_ENAVAIL;
+    }
+
+    image = malloc(size + 1);
+
+    if (!image)
+    {
+        return -RIG_ENOMEM;
+    }
+
+    f = fopen(infilename, "rb");
+
+    /* the file has to be exactly one image, as saved by save_image */
+    if (!f || fread(image, 1, size + 1, f) != size)
+    {
+        ret = -RIG_EINVAL;
+    }
+
+    if (f)
+    {
+        fclose(f);
+    }
+
+    if (ret == RIG_OK)
+    {
+        ret = rig_clone_write(rig, image, size);
+    }
+
+    free(image);
+
+    return ret;
+}
@@ -178,6 +178,8 @@ declare_proto_rot(stop);
 declare_proto_rot(park);
 declare_proto_rot(reset);
 declare_proto_rot(move);
+declare_proto_rot(set_trajectory);
+declare_proto_rot(add_trajectory);
 declare_proto_rot(set_level);
 declare_proto_rot(get_level);
 declare_proto_rot(set_func);
@@ -186,6 +188,7 @@ declare_proto_rot(set_parm);
 declare_proto_rot(get_parm);
 declare_proto_rot(get_info);
 declare_proto_rot(get_status);
+declare_proto_rot(get_state);
 declare_proto_rot(inter_set_conf);  /* interactive mode set_conf */
 declare_proto_rot(send_cmd);
 declare_proto_rot(dump_state);
@@ -201,6 +204,7 @@ declare_proto_rot(coord2qrb);
 declare_proto_rot(az_sp2az_lp);
 declare_proto_rot(dist_sp2dist_lp);
 declare_proto_rot(pause);
+declare_proto_rot(subscribe);
 
 /*
  * convention: upper case cmd is set, lowercase is get
@@ -215,6 +219,8 @@ struct test_table test_list[] =
     { 'S', "stop",          ACTION(stop),               ARG_NONE, },
     { 'R', "reset",         ACTION(reset),              ARG_IN, "Reset" },
     { 'M', "move",          ACTION(move),               ARG_IN, "Direction", "Speed" },
+    { 0x8d, "set_trajectory", ACTION(set_trajectory),   ARG_IN1 | ARG_IN2 | ARG_IN3, "Time", "Azimuth", "Elevation" },
+    { 0x8e, "add_trajectory", ACTION(add_trajectory),   ARG_IN1 | ARG_IN2 | ARG_IN3, "Time", "Azimuth", "Elevation" },
     { 'V',  "set_level",    ACTION(set_level),          ARG_IN, "Level", "Level Value" },
     { 'v',  "get_level",    ACTION(get_level),          ARG_IN1 | ARG_OUT2, "Level", "Level Value" },
     { 'U',  "set_func",     ACTION(set_func),           ARG_IN, "Func", "Func Status" },
@@ -224,6 +230,7 @@ struct test_table test_list[] =
     { 'C', "set_conf",      ACTION(inter_set_conf),     ARG_IN, "Token", "Value" },
     { '_', "get_info",      ACTION(get_info),           ARG_OUT, "Info" },
     { 's', "get_status",    ACTION(get_status),         ARG_OUT, "Status flags" },
+    { 0x90, "get_state",    ACTION(get_state),          ARG_OUT, "Azimuth", "Elevation", "Status flags" },
     { 'w', "send_cmd",      ACTION(send_cmd),           ARG_IN1 | ARG_IN_LINE | ARG_OUT2, "Cmd", "Reply" },
     { '1', "dump_caps",     ACTION(dump_caps), },
     { 0x8f, "dump_state",   ACTION(dump_state),         ARG_OUT },
@@ -237,6 +244,7 @@ struct test_table test_list[] =
     { 'A', "a_sp2a_lp",     ACTION(az_sp2az_lp),        ARG_IN1 | ARG_OUT1, "Short Path Deg", "Long Path Deg" },
     { 'a', "d_sp2d_lp",     ACTION(dist_sp2dist_lp),    ARG_IN1 | ARG_OUT1, "Short Path km", "Long Path km" },
     { 0x8c, "pause",        ACTION(pause),              ARG_IN, "Seconds" },
+    { 0x8b, "subscribe",    ACTION(subscribe),          ARG_IN, "Threshold" },
     { 0x00, "", NULL },
 
 };
@@ -1833,6 +1841,48 @@ declare_proto_rot(get_status)
 }
 
 
+/* '0x90' */
+declare_proto_rot(get_state)
+{
+    int result;
+    azimuth_t az;
+    elevation_t el;
+    rot_status_t status;
+    char s[SPRINTF_MAX_SIZE];
+
+    result = rot_get_state(rot, &az, &el, &status);
+
+    if (result != RIG_OK)
+    {
+        return result;
+    }
+
+    if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+    {
+        fprintf(fout, "%s: ", cmd->arg1);
+    }
+
+    fprintf(fout, "%.2f%c", az, resp_sep);
+
+    if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+    {
+        fprintf(fout, "%s: ", cmd->arg2);
+    }
+
+    fprintf(fout, "%.2f%c", el, resp_sep);
+
+    if ((interactive && prompt) || (interactive && !prompt && ext_resp))
+    {
+        fprintf(fout, "%s: ", cmd->arg3);
+    }
+
+    rot_sprintf_status(s, sizeof(s), status);
+    fprintf(fout, "%s%c", s, resp_sep);
+
+    return RIG_OK;
+}
+
+
 /* 'M' */
 declare_proto_rot(move)
 {
@@ -1865,6 +1915,30 @@ declare_proto_rot(move)
 }
 
 
+/* '0x8d' */
+declare_proto_rot(set_trajectory)
+{
+    struct rot_point pt;
+
+    CHKSCN1ARG(sscanf(arg1, "%lf", &pt.time));
+    CHKSCN1ARG(sscanf(arg2, "%f", &pt.az));
+    CHKSCN1ARG(sscanf(arg3, "%f", &pt.el));
+    return rot_set_trajectory(rot, &pt, 1);
+}
+
+
+/* '0x8e' */
+declare_proto_rot(add_trajectory)
+{
+    struct rot_point pt;
+
+    CHKSCN1ARG(sscanf(arg1, "%lf", &pt.time));
+    CHKSCN1ARG(sscanf(arg2, "%f", &pt.az));
+    CHKSCN1ARG(sscanf(arg3, "%f", &pt.el));
+    return rot_add_trajectory(rot, &pt, 1);
+}
+
+
 /*
  * 'V'
  */
@@ -2363,7 +2437,7 @@ declare_proto_rot(dump_state)
     /*
      * - Protocol version
      */
-#define ROTCTLD_PROT_VER 0
+#define ROTCTLD_PROT_VER 1
 
     if ((interactive && prompt) || (interactive && !prompt && ext_resp))
     {
@@ -2816,3 +2890,38 @@ declare_proto_rot(pause)
     sleep(seconds);
     return RIG_OK;
 }
+
+
+static rotctl_subscribe_cb_t subscribe_cb;
+
+void rotctl_set_subscribe(rotctl_subscribe_cb_t subscribe)
+{
+    subscribe_cb = subscribe;
+}
+
+/* '0x8b' */
+declare_proto_rot(subscribe)
+{
+    float threshold;
+
+    rig_debug(RIG_DEBUG_TRACE, "%s: %s\n", __func__, arg1);
+
+    if (!subscribe_cb)
+    {
+        return -RIG_ENAVAIL;    /* only rotctld can push */
+    }
+
+    if (!strcasecmp(arg1, "none"))
+    {
+        return subscribe_cb(fout, -1);
+    }
+
+    CHKSCN1ARG(sscanf(arg1, "%f", &threshold));
+
+    if (threshold < 0)
+    {
+        return -RIG_EINVAL;
+    }
+
+    return subscribe_cb(fout, threshold);
+}
@@ -47,4 +47,13 @@ int set_conf(ROT *my_rot, char *conf_parms);
 int rotctl_parse(ROT *my_rot, FILE *fin, FILE *fout, char *argv[], int argc,
                  int interactive, int prompt, char send_cmd_term);
 
+/*
+ * Position pushes for rotctld: after "\subscribe 1.5" the daemon writes
+ * "!pos <az> <el>" to that connection whenever the rotator has moved more
+ * than 1.5 degrees.  subscribe() is given the connection's stream and the
+ * threshold in degrees, negative to stop, and returns a Hamlib status.
+ */
+typedef int (*rotctl_subscribe_cb_t)(FILE *fout, float threshold);
+void rotctl_set_subscribe(rotctl_subscribe_cb_t subscribe);
+
 #endif  /* ROTCTL_PARSE_H */
@@ -33,6 +33,7 @@
 #include <getopt.h>
 #include <errno.h>
 #include <signal.h>
+#include <math.h>
 
 #include <sys/types.h>          /* See NOTES */
 
@@ -59,10 +60,18 @@
 #  include <pthread.h>
 #endif
 
+#if defined(HAVE_POLL_H) && defined(HAVE_FMEMOPEN)
+#  include <poll.h>
+#  include <fcntl.h>
+#  define ROTCTLD_EVENT_LOOP 1
+#endif
+
 #include <hamlib/rotator.h>
 #include "misc.h"
+#include "executor.h"
 
 #include "rotctl_parse.h"
+#include "metrics_http.h"
 
 struct handle_data
 {
@@ -74,6 +83,10 @@ struct handle_data
 
 void *handle_socket(void *arg);
 
+#ifdef ROTCTLD_EVENT_LOOP
+static int rotctld_event_loop(int sock_listen, ROT *my_rot);
+#endif
+
 void usage();
 
 /*
@@ -82,7 +95,7 @@ void usage();
  * NB: do NOT use -W since it's reserved by POSIX.
  * TODO: add an option to read from a file
  */
-#define SHORT_OPTIONS "m:r:R:s:C:o:O:t:T:LuvhVlZ"
+#define SHORT_OPTIONS "m:r:R:s:C:o:O:t:T:LuvhVlZEH:"
 static struct option long_options[] =
 {
     {"model",           1, 0, 'm'},
@@ -98,6 +111,8 @@ static struct option long_options[] =
     {"show-conf",       0, 0, 'L'},
     {"dump-caps",       0, 0, 'u'},
     {"debug-time-stamps", 0, 0, 'Z'},
+    {"event-loop",      0, 0, 'E'},
+    {"http",            1, 0, 'H'},
     {"verbose",         0, 0, 'v'},
     {"help",            0, 0, 'h'},
     {"version",         0, 0, 'V'},
@@ -148,6 +163,12 @@ static void handle_error(enum rig_debug_level_e lvl, const char *msg)
 }
 
 
+static int rot_metrics(void *handle, char *buf, int len)
+{
+    return rot_get_metrics((ROT *) handle, buf, len);
+}
+
+
 int main(int argc, char *argv[])
 {
     ROT *my_rot;        /* handle to rot (instance) */
@@ -168,6 +189,8 @@ int main(int argc, char *argv[])
     int reuseaddr = 1;
     char host[NI_MAXHOST];
     char serv[NI_MAXSERV];
+    int event_loop = 0;
+    const char *http_port = NULL;
 
 #ifdef HAVE_PTHREAD
     pthread_t thread;
@@ -324,6 +347,24 @@ int main(int argc, char *argv[])
             rig_set_debug_time_stamp(1);
             break;
 
+        case 'E':
+#ifdef ROTCTLD_EVENT_LOOP
+            event_loop = 1;
+#else
+            fprintf(stderr, "Event loop mode not available, using a thread per client\n");
+#endif
+            break;
+
+        case 'H':
+            if (!optarg)
+            {
+                usage();    /* wrong arg count */
+                exit(1);
+            }
+
+            http_port = optarg;
+            break;
+
         default:
             usage();    /* unknown option? */
             exit(1);
@@ -538,6 +579,12 @@ int main(int argc, char *argv[])
         exit(1);
     }
 
+    if (http_port
+            && metrics_http_start(src_addr, http_port, rot_metrics, my_rot) != RIG_OK)
+    {
+        fprintf(stderr, "Cannot serve metrics on port %s\n", http_port);
+    }
+
 #ifdef SIGPIPE
     /* Ignore SIGPIPE as we will handle it at the write()/send() calls
        that will consequently fail with EPIPE. All child threads will
@@ -565,6 +612,14 @@ int main(int argc, char *argv[])
 #endif
 #endif
 
+#ifdef ROTCTLD_EVENT_LOOP
+
+    if (event_loop)
+    {
+        retcode = rotctld_event_loop(sock_listen, my_rot);
+    }
+    else
+#endif
     /*
      * main loop accepting connections
      */
@@ -743,6 +798,499 @@ handle_exit:
 }
 
 
+#ifdef ROTCTLD_EVENT_LOOP
+/*
+ * -E/--event-loop: one thread polls the listening socket and every client
+ * and buffers their input.  A round -- one command per client, then the
+ * \subscribe push -- runs as a task on the rotator's strand of the shared
+ * executor (src/executor.c), which keeps everything that talks to the
+ * controller on one serial queue.  While a round is in flight it owns the
+ * clients: the loop thread only waits on the wake pipe for it to finish.
+ *
+ * \subscribe: while anybody is subscribed the rounds read the position
+ * every SUB_POLL_MS and send "!pos" to each client the rotator has moved
+ * far enough for, so the controller is polled at one rate however many
+ * clients are watching.
+ */
+#define EVL_MAX_CLIENTS 64
+#define EVL_BUFSZ 4096
+#define SUB_POLL_MS 250
+
+struct evl_client
+{
+    struct handle_data h;
+    FILE *fsockout;
+    char buf[EVL_BUFSZ];
+    size_t len;
+    int need_more;          /* buffered command is incomplete, wait for more input */
+    float sub_threshold;    /* degrees, negative when not subscribed */
+    int sub_sent;           /* sub_az/sub_el are what the client was last sent */
+    azimuth_t sub_az;
+    elevation_t sub_el;
+};
+
+static struct evl_client *evl_clients[EVL_MAX_CLIENTS];
+static int sub_count;       /* clients with sub_threshold >= 0 */
+static struct timespec sub_time;
+static int evl_wake[2] = { -1, -1 };
+static int evl_next;        /* client the next round starts with */
+static int evl_round_done;
+
+static void evl_close(int i)
+{
+    struct evl_client *c = evl_clients[i];
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: connection closed, fd=%d\n", __func__,
+              c->h.sock);
+
+    if (c->sub_threshold >= 0)
+    {
+        sub_count--;
+    }
+
+    /* closes the socket too */
+    fclose(c->fsockout);
+    free(c);
+    evl_clients[i] = NULL;
+}
+
+static void evl_accept(int sock_listen, ROT *my_rot)
+{
+    struct evl_client *c;
+    char host[NI_MAXHOST];
+    char serv[NI_MAXSERV];
+    int i;
+
+    c = calloc(1, sizeof(struct evl_client));
+
+    if (!c)
+    {
+        rig_debug(RIG_DEBUG_ERR, "calloc: %s\n", strerror(errno));
+        return;
+    }
+
+    c->h.rot = my_rot;
+    c->sub_threshold = -1;
+    c->h.clilen = sizeof(c->h.cli_addr);
+    c->h.sock = accept(sock_listen, (struct sockaddr *)&c->h.cli_addr,
+                       &c->h.clilen);
+
+    if (c->h.sock < 0)
+    {
+        handle_error(RIG_DEBUG_ERR, "accept");
+        free(c);
+        return;
+    }
+
+    for (i = 0; i < EVL_MAX_CLIENTS && evl_clients[i]; i++) {}
+
+    if (i == EVL_MAX_CLIENTS)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: too many clients, max %d\n", __func__,
+                  EVL_MAX_CLIENTS);
+        close(c->h.sock);
+        free(c);
+        return;
+    }
+
+    c->fsockout = fdopen(c->h.sock, "wb");
+
+    if (!c->fsockout)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: fdopen out: %s\n", __func__, strerror(errno));
+        close(c->h.sock);
+        free(c);
+        return;
+    }
+
+    if (getnameinfo((struct sockaddr const *)&c->h.cli_addr, c->h.clilen,
+                    host, sizeof(host), serv, sizeof(serv),
+                    NI_NUMERICHOST | NI_NUMERICSERV) == 0)
+    {
+        rig_debug(RIG_DEBUG_VERBOSE, "Connection opened from %s:%s\n", host, serv);
+    }
+
+    evl_clients[i] = c;
+}
+
+/* line ends between commands are no-ops for rotctl_parse(), drop them here */
+static void evl_skip_eol(struct evl_client *c)
+{
+    size_t n = 0;
+
+    while (n < c->len && (c->buf[n] == '\n' || c->buf[n] == '\r'))
+    {
+        n++;
+    }
+
+    c->len -= n;
+    memmove(c->buf, c->buf + n, c->len);
+}
+
+static int evl_runnable(const struct evl_client *c)
+{
+    if (!c || c->len == 0 || c->need_more)
+    {
+        return 0;
+    }
+
+    return c->len == EVL_BUFSZ || memchr(c->buf, '\n', c->len)
+           || memchr(c->buf, '\r', c->len);
+}
+
+/* read what the client sent, returns -1 once it has gone away */
+static int evl_read(struct evl_client *c)
+{
+    ssize_t n;
+
+    if (c->len == EVL_BUFSZ)
+    {
+        return 0;
+    }
+
+    n = recv(c->h.sock, c->buf + c->len, EVL_BUFSZ - c->len, 0);
+
+    if (n <= 0)
+    {
+        return -1;
+    }
+
+    c->len += n;
+    c->need_more = 0;
+
+    return 0;
+}
+
+/* run the client's next buffered command, returns -1 to drop the client */
+static int evl_run(struct evl_client *c)
+{
+    FILE *fsockin;
+    long used;
+    int eof;
+    int retcode;
+
+    evl_skip_eol(c);
+
+    if (c->len == 0)
+    {
+        return 0;
+    }
+
+    fsockin = fmemopen(c->buf, c->len, "r");
+
+    if (!fsockin)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: fmemopen: %s\n", __func__, strerror(errno));
+        return -1;
+    }
+
+    retcode = rotctl_parse(c->h.rot, fsockin, c->fsockout, NULL, 0, 1, 0, '\r');
+
+    used = ftell(fsockin);
+    eof = feof(fsockin);
+    fclose(fsockin);
+
+    /* ran out of input before the command was complete, nothing done yet */
+    if (retcode == -1 && eof)
+    {
+        if (c->len == EVL_BUFSZ)
+        {
+            rig_debug(RIG_DEBUG_ERR, "%s: command too long\n", __func__);
+            return -1;
+        }
+
+        c->need_more = 1;
+        return 0;
+    }
+
+    if (used <= 0 || used > (long)c->len)
+    {
+        used = c->len;
+    }
+
+    c->len -= used;
+    memmove(c->buf, c->buf + used, c->len);
+    evl_skip_eol(c);
+
+    if (ferror(c->fsockout))
+    {
+        return -1;
+    }
+
+    return (retcode == 0 || retcode == 2) ? 0 : -1;
+}
+
+static int sub_subscribe(FILE *fout, float threshold)
+{
+    int i;
+
+    for (i = 0; i < EVL_MAX_CLIENTS; i++)
+    {
+        struct evl_client *c = evl_clients[i];
+
+        if (!c || c->fsockout != fout)
+        {
+            continue;
+        }
+
+        if (threshold >= 0 && c->sub_threshold < 0)
+        {
+            sub_count++;
+        }
+        else if (threshold < 0 && c->sub_threshold >= 0)
+        {
+            sub_count--;
+        }
+
+        rig_debug(RIG_DEBUG_VERBOSE, "%s: fd=%d threshold=%g, %d subscribed\n",
+                  __func__, c->h.sock, threshold, sub_count);
+
+        c->sub_threshold = threshold;
+        c->sub_sent = 0;    /* current position first */
+
+        /* sample at the next round */
+        elapsed_ms(&sub_time, HAMLIB_ELAPSED_INVALIDATE);
+
+        return RIG_OK;
+    }
+
+    return -RIG_ENAVAIL;
+}
+
+/* ms until the position is due, -1 when nobody is subscribed */
+static int sub_due(void)
+{
+    double ms;
+
+    if (!sub_count)
+    {
+        return -1;
+    }
+
+    ms = elapsed_ms(&sub_time, HAMLIB_ELAPSED_GET);
+
+    return ms >= SUB_POLL_MS ? 0 : (int)(SUB_POLL_MS - ms);
+}
+
+/* one position read for all subscribers */
+static void sub_push(ROT *my_rot)
+{
+    azimuth_t az;
+    elevation_t el;
+    int i;
+
+    elapsed_ms(&sub_time, HAMLIB_ELAPSED_SET);
+
+    if (rot_get_position(my_rot, &az, &el) != RIG_OK)
+    {
+        return;
+    }
+
+    for (i = 0; i < EVL_MAX_CLIENTS; i++)
+    {
+        struct evl_client *c = evl_clients[i];
+        struct pollfd pfd;
+
+        if (!c || c->sub_threshold < 0)
+        {
+            continue;
+        }
+
+        if (c->sub_sent && fabs(az - c->sub_az) <= c->sub_threshold
+                && fabs(el - c->sub_el) <= c->sub_threshold)
+        {
+            continue;
+        }
+
+        pfd.fd = c->h.sock;
+        pfd.events = POLLOUT;
+
+        // not draining its socket, it gets the latest position later
+        if (poll(&pfd, 1, 0) != 1 || !(pfd.revents & POLLOUT))
+        {
+            continue;
+        }
+
+        fprintf(c->fsockout, "!pos %f %f\n", az, el);
+        fflush(c->fsockout);
+
+        c->sub_az = az;
+        c->sub_el = el;
+        c->sub_sent = 1;
+    }
+}
+
+/* runs on the rotator's strand */
+static void evl_round(void *arg)
+{
+    ROT *my_rot = arg;
+    char ping = 0;
+    int i;
+
+    /* one command per client per round, starting one further each time */
+    for (i = 0; i < EVL_MAX_CLIENTS; i++)
+    {
+        int k = (evl_next + i) % EVL_MAX_CLIENTS;
+
+        if (evl_runnable(evl_clients[k]) && evl_run(evl_clients[k]) < 0)
+        {
+            evl_close(k);
+        }
+    }
+
+    evl_next = (evl_next + 1) % EVL_MAX_CLIENTS;
+
+    if (sub_due() == 0)
+    {
+        sub_push(my_rot);
+    }
+
+    __atomic_store_n(&evl_round_done, 1, __ATOMIC_RELEASE);
+
+    if (write(evl_wake[1], &ping, 1) < 0 && errno != EAGAIN)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: wake pipe: %s\n", __func__, strerror(errno));
+    }
+}
+
+static int rotctld_event_loop(int sock_listen, ROT *my_rot)
+{
+    struct pollfd fds[EVL_MAX_CLIENTS + 1];
+    int slot[EVL_MAX_CLIENTS + 1];
+    hl_strand_t *strand;
+    int in_round = 0;
+    int i;
+
+    rig_debug(RIG_DEBUG_VERBOSE, "%s: serving clients from one thread\n",
+              __func__);
+
+    rotctl_set_subscribe(sub_subscribe);
+
+    strand = hl_strand_new(hl_executor_default(), "rotator");
+
+    if (!strand || pipe(evl_wake) < 0)
+    {
+        rig_debug(RIG_DEBUG_ERR, "%s: no executor or wake pipe\n", __func__);
+        hl_strand_free(strand);
+        return -1;
+    }
+
+    fcntl(evl_wake[0], F_SETFL, O_NONBLOCK);
+    fcntl(evl_wake[1], F_SETFL, O_NONBLOCK);
+
+    /* clients arrive in bursts while we are busy with the rotator, queue them all */
+    if (listen(sock_listen, EVL_MAX_CLIENTS) < 0)
+    {
+        handle_error(RIG_DEBUG_WARN, "listen");
+    }
+
+    while (1)
+    {
+        int nfds = 1;
+        int busy = 0;
+        int timeout;
+        int n;
+
+        if (in_round)
+        {
+            struct pollfd wake = { evl_wake[0], POLLIN, 0 };
+            char drain[64];
+
+            if (poll(&wake, 1, 1000) < 0 && errno != EINTR)
+            {
+                rig_debug(RIG_DEBUG_ERR, "%s: poll() failed: %s\n", __func__,
+                          strerror(errno));
+                break;
+            }
+
+            while (read(evl_wake[0], drain, sizeof(drain)) > 0) {}
+
+            if (__atomic_load_n(&evl_round_done, __ATOMIC_ACQUIRE))
+            {
+                evl_round_done = 0;
+                in_round = 0;
+            }
+
+            continue;
+        }
+
+        fds[0].fd = sock_listen;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+
+        for (i = 0; i < EVL_MAX_CLIENTS; i++)
+        {
+            if (!evl_clients[i]) { continue; }
+
+            fds[nfds].fd = evl_clients[i]->h.sock;
+            fds[nfds].events = POLLIN;
+            fds[nfds].revents = 0;
+            slot[nfds++] = i;
+
+            if (evl_runnable(evl_clients[i])) { busy = 1; }
+        }
+
+        timeout = busy ? 0 : sub_due();
+        n = poll(fds, nfds, timeout);
+
+        if (n < 0)
+        {
+            if (errno == EINTR) { continue; }
+
+            rig_debug(RIG_DEBUG_ERR, "%s: poll() failed: %s\n", __func__,
+                      strerror(errno));
+            break;
+        }
+
+        for (i = 1; i < nfds; i++)
+        {
+            if (fds[i].revents & (POLLIN | POLLHUP | POLLERR))
+            {
+                if (evl_read(evl_clients[slot[i]]) < 0)
+                {
+                    evl_close(slot[i]);
+                }
+            }
+        }
+
+        /* take every pending connection, not just the first */
+        while (fds[0].revents & POLLIN)
+        {
+            evl_accept(sock_listen, my_rot);
+
+            if (poll(fds, 1, 0) <= 0) { break; }
+        }
+
+        busy = 0;
+
+        for (i = 0; i < EVL_MAX_CLIENTS && !busy; i++)
+        {
+            busy = evl_runnable(evl_clients[i]);
+        }
+
+        if ((busy || sub_due() == 0)
+                && hl_strand_post(strand, evl_round, my_rot) == RIG_OK)
+        {
+            in_round = 1;
+        }
+    }
+
+    /* waits for the round in flight */
+    hl_strand_free(strand);
+
+    for (i = 0; i < EVL_MAX_CLIENTS; i++)
+    {
+        if (evl_clients[i]) { evl_close(i); }
+    }
+
+    close(evl_wake[0]);
+    close(evl_wake[1]);
+
+    return 0;
+}
+#endif /* ROTCTLD_EVENT_LOOP */
+
+
 void usage()
 {
     printf("Usage: rotctld [OPTION]... [COMMAND]...\n"
@@ -763,6 +1311,8 @@ void usage()
         "  -u, --dump-caps               dump capabilities and exit\n"
         "  -v, --verbose                 set verbose mode, cumulative\n"
         "  -Z, --debug-time-stamps       enable time stamps for debug messages\n"
+        "  -E, --event-loop              serve all clients from one thread, allows subscribe\n"
+        "  -H, --http=PORT               serve OpenMetrics for Prometheus at /metrics on PORT\n"
         "  -h, --help                    display this help and exit\n"
         "  -V, --version                 output version information and exit\n\n",
         portno);
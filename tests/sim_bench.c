@@ -0,0 +1,493 @@
+/*
+ * Hamlib sim_bench program
+ * Drives a matrix of operations through a real backend against one of the
+ * simulators and prints the latencies as one JSON object, for tracking
+ * regressions release to release.  bench.sh runs it against every
+ * simulator ("make bench"), or by hand:
+ *   ../simulators/simkenwood &      (prints name=/dev/pts/N)
+ *   ./sim_bench 2041 /dev/pts/N [count]
+ *
+ * Each operation is timed three ways:
+ *   cold       caching off, every call goes to the rig
+ *   warm       default cache timeouts, a steady poll served from memory
+ *   pipelined  caching off, count requests queued at once with rig_submit()
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+#include <hamlib/rig.h>
+
+#define DEFAULT_COUNT 20
+#define MAX_COUNT 1000
+#define OP_BUDGET_MS 2000   /* stop an operation early past this much time */
+#define OP_GIVE_UP 3        /* stop after this many failures in a row from the start */
+
+enum bench_op_e
+{
+    OP_GET_FREQ,
+    OP_SET_FREQ,
+    OP_GET_MODE,
+    OP_SET_MODE,
+    OP_GET_PTT,
+    OP_SET_PTT,
+    OP_GET_SPLIT,
+    OP_SET_SPLIT,
+    OP_GET_LEVEL,
+    OP_SET_LEVEL,
+    OP_GET_MEM,
+    OP_SET_MEM,
+    OP_COUNT
+};
+
+static const struct
+{
+    const char *name;
+    rig_request_t req;      /* 0 when rig_submit() has no such request */
+} bench_ops[OP_COUNT] =
+{
+    { "get_freq", RIG_REQ_GET_FREQ },
+    { "set_freq", RIG_REQ_SET_FREQ },
+    { "get_mode", RIG_REQ_GET_MODE },
+    { "set_mode", RIG_REQ_SET_MODE },
+    { "get_ptt", RIG_REQ_GET_PTT },
+    { "set_ptt", RIG_REQ_SET_PTT },
+    { "get_split_vfo", RIG_REQ_GET_SPLIT_VFO },
+    { "set_split_vfo", RIG_REQ_SET_SPLIT_VFO },
+    { "get_level", RIG_REQ_GET_LEVEL },
+    { "set_level", RIG_REQ_SET_LEVEL },
+    { "get_mem", 0 },
+    { "set_mem", 0 },
+};
+
+struct bench_result
+{
+    int n;
+    int errors;
+    int coalesced;
+    double lat_us[MAX_COUNT];
+    double total_us;
+};
+
+static freq_t base_freq;
+static rmode_t base_mode;
+static pbwidth_t base_width;
+static setting_t get_level_setting, set_level_setting;
+static int first_json = 1;
+static pthread_mutex_t done_lock = PTHREAD_MUTEX_INITIALIZER;
+
+
+static double now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+
+static void bench_request(enum bench_op_e op, int i, struct rig_request *req)
+{
+    memset(req, 0, sizeof(*req));
+    req->type = bench_ops[op].req;
+    req->vfo = RIG_VFO_CURR;
+
+    switch (op)
+    {
+    case OP_SET_FREQ:
+        /* on distinct frequencies, so nothing is skipped as unchanged */
+        req->freq = base_freq + (i % 2 ? 1000 : 0) + 10 * i;
+        break;
+
+    case OP_SET_MODE:
+        req->mode = i % 2 ? RIG_MODE_CW : base_mode;
+        req->width = RIG_PASSBAND_NOCHANGE;
+        break;
+
+    case OP_SET_PTT:
+        req->ptt = i % 2 ? RIG_PTT_OFF : RIG_PTT_ON;
+        break;
+
+    case OP_SET_SPLIT:
+        req->split = i % 2 ? RIG_SPLIT_OFF : RIG_SPLIT_ON;
+        req->tx_vfo = RIG_VFO_B;
+        break;
+
+    case OP_GET_LEVEL:
+        req->setting = get_level_setting;
+        break;
+
+    case OP_SET_LEVEL:
+        req->setting = set_level_setting;
+
+        if (RIG_LEVEL_IS_FLOAT(set_level_setting))
+        {
+            req->val.f = i % 2 ? 0.5f : 0.25f;
+        }
+        else
+        {
+            req->val.i = i % 2 ? 50 : 25;
+        }
+
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+static int bench_call(RIG *rig, enum bench_op_e op, int i)
+{
+    struct rig_request req;
+    int ch;
+
+    bench_request(op, i, &req);
+
+    switch (op)
+    {
+    case OP_GET_FREQ:
+        return rig_get_freq(rig, req.vfo, &req.freq);
+
+    case OP_SET_FREQ:
+        return rig_set_freq(rig, req.vfo, req.freq);
+
+    case OP_GET_MODE:
+        return rig_get_mode(rig, req.vfo, &req.mode, &req.width);
+
+    case OP_SET_MODE:
+        return rig_set_mode(rig, req.vfo, req.mode, req.width);
+
+    case OP_GET_PTT:
+        return rig_get_ptt(rig, req.vfo, &req.ptt);
+
+    case OP_SET_PTT:
+        return rig_set_ptt(rig, req.vfo, req.ptt);
+
+    case OP_GET_SPLIT:
+        return rig_get_split_vfo(rig, req.vfo, &req.split, &req.tx_vfo);
+
+    case OP_SET_SPLIT:
+        return rig_set_split_vfo(rig, req.vfo, req.split, req.tx_vfo);
+
+    case OP_GET_LEVEL:
+        return req.setting ? rig_get_level(rig, req.vfo, req.setting,
+                                           &req.val) : -RIG_ENAVAIL;
+
+    case OP_SET_LEVEL:
+        return req.setting ? rig_set_level(rig, req.vfo, req.setting,
+                                           req.val) : -RIG_ENAVAIL;
+
+    case OP_GET_MEM:
+        return rig_get_mem(rig, req.vfo, &ch);
+
+    case OP_SET_MEM:
+        return rig_set_mem(rig, req.vfo, 1 + i % 2);
+
+    default:
+        return -RIG_EINTERNAL;
+    }
+}
+
+
+static int bench_unsupported(int retcode)
+{
+    return retcode == -RIG_ENAVAIL || retcode == -RIG_ENIMPL
+           || retcode == -RIG_ENTARGET;
+}
+
+
+/* put back what a set operation changed before the next run */
+static void bench_restore(RIG *rig, enum bench_op_e op)
+{
+    switch (op)
+    {
+    case OP_SET_FREQ:
+        rig_set_freq(rig, RIG_VFO_CURR, base_freq);
+        break;
+
+    case OP_SET_MODE:
+        rig_set_mode(rig, RIG_VFO_CURR, base_mode, RIG_PASSBAND_NOCHANGE);
+        break;
+
+    case OP_SET_PTT:
+        rig_set_ptt(rig, RIG_VFO_CURR, RIG_PTT_OFF);
+        break;
+
+    case OP_SET_SPLIT:
+        rig_set_split_vfo(rig, RIG_VFO_CURR, RIG_SPLIT_OFF, RIG_VFO_A);
+        break;
+
+    default:
+        break;
+    }
+}
+
+
+/* returns 0 when the operation is not supported */
+static int bench_serial(RIG *rig, enum bench_op_e op, int count,
+                        struct bench_result *r)
+{
+    double start = now_us();
+    int i;
+
+    memset(r, 0, sizeof(*r));
+
+    for (i = 0; i < count; i++)
+    {
+        double t0 = now_us();
+        int retcode = bench_call(rig, op, i);
+
+        r->lat_us[r->n++] = now_us() - t0;
+
+        if (i == 0 && bench_unsupported(retcode))
+        {
+            return 0;
+        }
+
+        if (retcode != RIG_OK)
+        {
+            r->errors++;
+        }
+
+        /* the simulator does not answer this one, each try is a timeout */
+        if (r->errors == OP_GIVE_UP && r->n == OP_GIVE_UP)
+        {
+            break;
+        }
+
+        if ((now_us() - start) / 1000 > OP_BUDGET_MS)
+        {
+            break;
+        }
+    }
+
+    r->total_us = now_us() - start;
+
+    return 1;
+}
+
+
+struct bench_pending
+{
+    struct rig_request req;
+    double submitted;
+    struct bench_result *r;
+};
+
+
+static void bench_done(RIG *rig, struct rig_request *req, rig_ptr_t arg)
+{
+    struct bench_pending *p = (struct bench_pending *) arg;
+
+    /* coalesced requests complete from rig_submit(), the rest from the I/O thread */
+    pthread_mutex_lock(&done_lock);
+    p->r->lat_us[p->r->n++] = now_us() - p->submitted;
+
+    if (req->coalesced)
+    {
+        p->r->coalesced++;
+    }
+    else if (req->retcode != RIG_OK)
+    {
+        p->r->errors++;
+    }
+
+    pthread_mutex_unlock(&done_lock);
+}
+
+
+static int bench_pipelined(RIG *rig, enum bench_op_e op, int count,
+                           struct bench_result *r)
+{
+    static struct bench_pending pending[MAX_COUNT];
+    double start;
+    int i;
+
+    if (!bench_ops[op].req
+            || (op == OP_GET_LEVEL && !get_level_setting)
+            || (op == OP_SET_LEVEL && !set_level_setting))
+    {
+        return 0;
+    }
+
+    memset(r, 0, sizeof(*r));
+    start = now_us();
+
+    for (i = 0; i < count; i++)
+    {
+        bench_request(op, i, &pending[i].req);
+        pending[i].r = r;
+        pending[i].submitted = now_us();
+
+        if (rig_submit(rig, &pending[i].req, bench_done, &pending[i]) != RIG_OK)
+        {
+            r->errors++;
+        }
+    }
+
+    rig_submit_wait(rig);
+    r->total_us = now_us() - start;
+
+    return 1;
+}
+
+
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *) a, y = *(const double *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+
+static void bench_print(enum bench_op_e op, const char *how,
+                        struct bench_result *r)
+{
+    int p50, p99;
+
+    if (r->n == 0)
+    {
+        return;
+    }
+
+    qsort(r->lat_us, r->n, sizeof(r->lat_us[0]), cmp_double);
+    p50 = (r->n - 1) * 50 / 100;
+    p99 = (r->n - 1) * 99 / 100;
+
+    printf("%s\n    {\"op\": \"%s\", \"case\": \"%s\", \"n\": %d, \"errors\": %d, "
+           "\"coalesced\": %d, \"p50_us\": %.0f, \"p99_us\": %.0f, "
+           "\"ops_per_s\": %.1f}",
+           first_json ? "" : ",", bench_ops[op].name, how, r->n, r->errors,
+           r->coalesced, r->lat_us[p50], r->lat_us[p99],
+           r->total_us > 0 ? r->n * 1e6 / r->total_us : 0.0);
+
+    first_json = 0;
+}
+
+
+static setting_t bench_pick_level(setting_t has, const setting_t *prefs)
+{
+    for (; *prefs; prefs++)
+    {
+        if (has & *prefs)
+        {
+            return *prefs;
+        }
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char *argv[])
+{
+    static const setting_t get_prefs[] = { RIG_LEVEL_STRENGTH, RIG_LEVEL_RAWSTR, RIG_LEVEL_AF, RIG_LEVEL_RFPOWER, 0 };
+    static const setting_t set_prefs[] = { RIG_LEVEL_AF, RIG_LEVEL_RFPOWER, RIG_LEVEL_RF, 0 };
+    static struct bench_result r;
+    RIG *my_rig;
+    rig_model_t model;
+    int count, retcode, op;
+
+    if (argc < 3)
+    {
+        fprintf(stderr, "Usage: %s model port [count]\n", argv[0]);
+        return 1;
+    }
+
+    model = atoi(argv[1]);
+    count = argc > 3 ? atoi(argv[3]) : DEFAULT_COUNT;
+
+    if (count < 1 || count > MAX_COUNT)
+    {
+        fprintf(stderr, "%s: count must be 1..%d\n", argv[0], MAX_COUNT);
+        return 1;
+    }
+
+    rig_set_debug(RIG_DEBUG_NONE);
+
+    my_rig = rig_init(model);
+
+    if (!my_rig)
+    {
+        fprintf(stderr, "Unknown rig num: %u\n", model);
+        return 1;
+    }
+
+    strncpy(my_rig->state.rigport.pathname, argv[2], HAMLIB_FILPATHLEN - 1);
+    /* a simulator that ignores a command should cost one timeout, not three */
+    rig_set_conf(my_rig, rig_token_lookup(my_rig, "retry"), "0");
+
+    retcode = rig_open(my_rig);
+
+    if (retcode != RIG_OK)
+    {
+        fprintf(stderr, "rig_open: error = %s\n", rigerror(retcode));
+        return 2;
+    }
+
+    if (rig_get_freq(my_rig, RIG_VFO_CURR, &base_freq) != RIG_OK || base_freq == 0)
+    {
+        base_freq = MHz(14.074);
+    }
+
+    if (rig_get_mode(my_rig, RIG_VFO_CURR, &base_mode, &base_width) != RIG_OK
+            || base_mode == RIG_MODE_NONE)
+    {
+        base_mode = RIG_MODE_USB;
+    }
+
+    get_level_setting = bench_pick_level(my_rig->state.has_get_level, get_prefs);
+    set_level_setting = bench_pick_level(my_rig->state.has_set_level, set_prefs);
+
+    printf("{\"model\": %u, \"name\": \"%s %s\", \"backend_version\": \"%s\", "
+           "\"hamlib\": \"%s\", \"count\": %d, \"results\": [",
+           model, my_rig->caps->mfg_name, my_rig->caps->model_name, my_rig->caps->version,
+           rig_version(), count);
+
+    for (op = 0; op < OP_COUNT; op++)
+    {
+        rig_set_cache_timeout_ms(my_rig, HAMLIB_CACHE_ALL, 0);
+
+        if (!bench_serial(my_rig, op, count, &r))
+        {
+            continue;   /* not supported, no point in the other two */
+        }
+
+        bench_print(op, "cold", &r);
+        bench_restore(my_rig, op);
+
+        if (r.errors == r.n)
+        {
+            continue;
+        }
+
+        rig_set_cache_timeout_ms(my_rig, HAMLIB_CACHE_ALL, 500);
+
+        if (bench_serial(my_rig, op, count, &r))
+        {
+            bench_print(op, "warm", &r);
+        }
+
+        bench_restore(my_rig, op);
+
+        rig_set_cache_timeout_ms(my_rig, HAMLIB_CACHE_ALL, 0);
+
+        if (bench_pipelined(my_rig, op, count, &r))
+        {
+            bench_print(op, "pipelined", &r);
+        }
+
+        bench_restore(my_rig, op);
+    }
+
+    printf("\n]}\n");
+
+    rig_close(my_rig);
+    rig_cleanup(my_rig);
+
+    return 0;
+}
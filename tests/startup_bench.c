@@ -0,0 +1,141 @@
+/*
+ * Hamlib startup_bench program
+ * What the build profile costs at startup, no rig or port involved: the
+ * first rig_init() of a model, which loads its backend, later
+ * rig_init()/rig_cleanup() pairs, rig_load_all_backends(), the number of
+ * models compiled in and the resident set size after each step.
+ *
+ *   ./startup_bench [-m model] [-n count] [-l library]
+ *       prints the figures as JSON; with -l, the size of that file too,
+ *       see "make bench-startup"
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <hamlib/rig.h>
+#include "misc.h"
+
+/* resident set size in kB, -1 where /proc is not there */
+static long rss_kb(void)
+{
+    FILE *fp = fopen("/proc/self/statm", "r");
+    long pages, resident;
+
+    if (!fp)
+    {
+        return -1;
+    }
+
+    if (fscanf(fp, "%ld %ld", &pages, &resident) != 2)
+    {
+        resident = -1;
+    }
+
+    fclose(fp);
+
+    return resident < 0 ? -1 : resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static int count_model(const struct rig_caps *caps, rig_ptr_t data)
+{
+    (*(int *)data)++;
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    rig_model_t model = RIG_MODEL_DUMMY;
+    const char *library = NULL;
+    struct timespec start;
+    double first_ms, init_ms, load_ms;
+    long rss_start, rss_first, rss_all;
+    int count = 1000, models_first = 0, models_all = 0;
+    long library_size = -1;
+    RIG *rig;
+    int c, i;
+
+    while ((c = getopt(argc, argv, "m:n:l:")) != -1)
+    {
+        switch (c)
+        {
+        case 'm':
+            model = atoi(optarg);
+            break;
+
+        case 'n':
+            count = atoi(optarg);
+            break;
+
+        case 'l':
+            library = optarg;
+            break;
+
+        default:
+            fprintf(stderr, "Usage: %s [-m model] [-n count] [-l library]\n",
+                    argv[0]);
+            return 2;
+        }
+    }
+
+    rig_set_debug(RIG_DEBUG_NONE);
+
+    rss_start = rss_kb();
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    rig = rig_init(model);
+    first_ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+
+    if (!rig)
+    {
+        fprintf(stderr, "%s: model %u is not in this build\n", argv[0], model);
+        return 1;
+    }
+
+    rig_cleanup(rig);
+    rss_first = rss_kb();
+    rig_list_foreach(count_model, &models_first);
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+
+    for (i = 0; i < count; i++)
+    {
+        rig = rig_init(model);
+        rig_cleanup(rig);
+    }
+
+    init_ms = count > 0 ? elapsed_ms(&start, HAMLIB_ELAPSED_GET) / count : 0;
+
+    elapsed_ms(&start, HAMLIB_ELAPSED_SET);
+    rig_load_all_backends();
+    load_ms = elapsed_ms(&start, HAMLIB_ELAPSED_GET);
+    rss_all = rss_kb();
+    rig_list_foreach(count_model, &models_all);
+
+    if (library)
+    {
+        FILE *fp = fopen(library, "rb");
+
+        if (fp)
+        {
+            if (fseek(fp, 0, SEEK_END) == 0)
+            {
+                library_size = ftell(fp);
+            }
+
+            fclose(fp);
+        }
+    }
+
+    printf("{\"model\": %u, \"first_rig_init_ms\": %.3f, \"rig_init_cleanup_ms\": %.4f,\n",
+           model, first_ms, init_ms);
+    printf(" \"load_all_backends_ms\": %.3f, \"models_first\": %d, \"models_all\": %d,\n",
+           load_ms, models_first, models_all);
+    printf(" \"rss_start_kb\": %ld, \"rss_first_kb\": %ld, \"rss_all_kb\": %ld,\n",
+           rss_start, rss_first, rss_all);
+    printf(" \"library\": \"%s\", \"library_bytes\": %ld}\n",
+           library ? library : "", library_size);
+
+    return 0;
+}
@@ -2,16 +2,253 @@
 /*
  * Very simple test program to check BCD conversion against some other --SF
  * This is mainly to test freq2bcd and bcd2freq functions.
+ *
+ * The table driven codec is also checked against the digit at a time
+ * references below, both byte orders, and with a loop count it times both.
  */
 
 #include <hamlib/config.h>
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
 #include <hamlib/rig.h>
 #include "misc.h"
 
 #define MAXDIGITS 32
+#define CHECKDIGITS 19  /* what fits an unsigned long long */
+
+
+/* the codec as it was, one digit per step */
+static void ref_to_bcd(unsigned char bcd_data[], unsigned long long freq,
+                       unsigned bcd_len)
+{
+    unsigned i;
+
+    for (i = 0; i < bcd_len / 2; i++)
+    {
+        unsigned char a = freq % 10;
+        freq /= 10;
+        a |= (freq % 10) << 4;
+        freq /= 10;
+        bcd_data[i] = a;
+    }
+
+    if (bcd_len & 1)
+    {
+        bcd_data[i] &= 0xf0;
+        bcd_data[i] |= freq % 10;
+    }
+}
+
+
+static unsigned long long ref_from_bcd(const unsigned char bcd_data[],
+                                       unsigned bcd_len)
+{
+    int i;
+    unsigned long long f = 0;
+
+    if (bcd_len & 1)
+    {
+        f = bcd_data[bcd_len / 2] & 0x0f;
+    }
+
+    for (i = (bcd_len / 2) - 1; i >= 0; i--)
+    {
+        f *= 10;
+        f += bcd_data[i] >> 4;
+        f *= 10;
+        f += bcd_data[i] & 0x0f;
+    }
+
+    return f;
+}
+
+
+static void ref_to_bcd_be(unsigned char bcd_data[], unsigned long long freq,
+                          unsigned bcd_len)
+{
+    int i;
+
+    if (bcd_len & 1)
+    {
+        bcd_data[bcd_len / 2] &= 0x0f;
+        bcd_data[bcd_len / 2] |= (freq % 10) << 4;
+        freq /= 10;
+    }
+
+    for (i = (bcd_len / 2) - 1; i >= 0; i--)
+    {
+        unsigned char a = freq % 10;
+        freq /= 10;
+        a |= (freq % 10) << 4;
+        freq /= 10;
+        bcd_data[i] = a;
+    }
+}
+
+
+/* as it was but in unsigned long long, the old freq_t lost digits past 2^53 */
+static unsigned long long ref_from_bcd_be(const unsigned char bcd_data[],
+        unsigned bcd_len)
+{
+    unsigned i;
+    unsigned long long f = 0;
+
+    for (i = 0; i < bcd_len / 2; i++)
+    {
+        f *= 10;
+        f += bcd_data[i] >> 4;
+        f *= 10;
+        f += bcd_data[i] & 0x0f;
+    }
+
+    if (bcd_len & 1)
+    {
+        f *= 10;
+        f += bcd_data[bcd_len / 2] >> 4;
+    }
+
+    return f;
+}
+
+
+static int check(unsigned long long f, unsigned digits)
+{
+    /* room for the two fields of the list test */
+    unsigned char a[CHECKDIGITS + 1], b[CHECKDIGITS + 1];
+    unsigned long long lst[2];
+
+    memset(a, 0xa5, sizeof(a));
+    memset(b, 0xa5, sizeof(b));
+    to_bcd(a, f, digits);
+    ref_to_bcd(b, f, digits);
+
+    if (memcmp(a, b, sizeof(a)) || from_bcd(a, digits) != ref_from_bcd(b, digits))
+    {
+        return 1;
+    }
+
+    memset(a, 0xa5, sizeof(a));
+    memset(b, 0xa5, sizeof(b));
+    to_bcd_be(a, f, digits);
+    ref_to_bcd_be(b, f, digits);
+
+    if (memcmp(a, b, sizeof(a))
+            || from_bcd_be(a, digits) != ref_from_bcd_be(b, digits))
+    {
+        return 1;
+    }
+
+    /* the little-endian encoding of f is as good as any other octets */
+    ref_to_bcd(b, f, digits);
+
+    if (from_bcd_be(b, digits) != ref_from_bcd_be(b, digits))
+    {
+        return 1;
+    }
+
+    if (!(digits & 1))
+    {
+        lst[0] = f;
+        lst[1] = f / 7;
+        to_bcd_list(a, lst, digits, 2);
+        from_bcd_list(a, digits, lst, 2);
+
+        if (lst[0] != ref_from_bcd(b, digits)
+                || lst[1] != from_bcd(a + digits / 2, digits))
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+static int self_check(void)
+{
+    unsigned long long f = 1;
+    unsigned digits;
+    int i, fails = 0;
+
+    for (i = 0; i < 100000; i++)
+    {
+        /* xorshift, all the digit patterns without a fixed list */
+        f ^= f << 13;
+        f ^= f >> 7;
+        f ^= f << 17;
+
+        for (digits = 1; digits <= CHECKDIGITS; digits++)
+        {
+            fails += check(f, digits);
+            fails += check(i, digits);
+        }
+    }
+
+    for (i = 0; i < 256; i++)
+    {
+        unsigned char c = i;
+
+        /* every octet, BCD or not, decodes as before */
+        if (from_bcd(&c, 2) != ref_from_bcd(&c, 2)
+                || from_bcd_be(&c, 2) != ref_from_bcd_be(&c, 2)
+                || from_bcd_be(&c, 1) != ref_from_bcd_be(&c, 1))
+        {
+            fails++;
+        }
+    }
+
+    printf("\nSelf check: %d mismatches\n", fails);
+
+    return fails;
+}
+
+
+static float elapsed_since(const struct timeval *tv1)
+{
+    struct timeval tv2;
+
+    gettimeofday(&tv2, NULL);
+
+    return tv2.tv_sec - tv1->tv_sec + (tv2.tv_usec - tv1->tv_usec) / 1000000.0;
+}
+
+
+static void bench(unsigned long long f, unsigned digits, unsigned loops)
+{
+    unsigned char b[(MAXDIGITS + 1) / 2];
+    unsigned long long sum = 0;
+    struct timeval tv1;
+    float t_ref, t_lut;
+    unsigned i;
+
+    gettimeofday(&tv1, NULL);
+
+    for (i = 0; i < loops; i++)
+    {
+        ref_to_bcd(b, f + i, digits);
+        sum += ref_from_bcd(b, digits);
+    }
+
+    t_ref = elapsed_since(&tv1);
+
+    gettimeofday(&tv1, NULL);
+
+    for (i = 0; i < loops; i++)
+    {
+        to_bcd(b, f + i, digits);
+        sum += from_bcd(b, digits);
+    }
+
+    t_lut = elapsed_since(&tv1);
+
+    printf("\n%u loops of encode+decode, %u digits\n", loops, digits);
+    printf("digit at a time: %.1f ns\n", t_ref * 1e9 / loops);
+    printf("table driven:    %.1f ns\n", t_lut * 1e9 / loops);
+    printf("(checksum %llu)\n", sum);
+}
 
 int main(int argc, char *argv[])
 {
@@ -20,9 +257,9 @@ int main(int argc, char *argv[])
     int digits = 10;
     int i;
 
-    if (argc != 2 && argc != 3)
+    if (argc < 2 || argc > 4)
     {
-        fprintf(stderr, "Usage: %s <freq> [digits]\n", argv[0]);
+        fprintf(stderr, "Usage: %s <freq> [digits [loops]]\n", argv[0]);
         exit(1);
     }
 
@@ -64,5 +301,10 @@ int main(int argc, char *argv[])
     printf("\nResult after recoding: %"PRIll"\n",
            (int64_t)from_bcd_be(b, digits));
 
-    return 0;
+    if (argc > 3)
+    {
+        bench(f, digits, atoi(argv[3]));
+    }
+
+    return self_check() ? 1 : 0;
 }
@@ -14,6 +14,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <hamlib/rig.h>
 #include <hamlib/rotator.h>
 
@@ -23,6 +24,8 @@ int main(int argc, char *argv[])
     char recodedloc[13], *loc1, *loc2, sign;
     double lon1, lat1, lon2, lat2;
     double distance, az, mmm, sec;
+    double b_lon[2], b_lat[2], b_dist, b_az;
+    struct qrb_home home;
     int  deg, min, retcode, loc_len, nesw = 0;
 
     if (argc < 2)
@@ -48,6 +51,23 @@ int main(int argc, char *argv[])
         exit(2);
     }
 
+    /* the batch version must agree, and flag a bad locator with NAN */
+    retcode = locator2longlat_batch(loc1, b_lon, b_lat, 1);
+
+    if (retcode != 1 || b_lon[0] != lon1 || b_lat[0] != lat1)
+    {
+        fprintf(stderr, "locator2longlat_batch() does not match.\n");
+        exit(2);
+    }
+
+    retcode = locator2longlat_batch(" ZZ99 ", b_lon, b_lat, 2);
+
+    if (retcode != 1 || !isnan(b_lon[0]) || !isnan(b_lat[0]))
+    {
+        fprintf(stderr, "locator2longlat_batch() took a malformed locator.\n");
+        exit(2);
+    }
+
     /* hamlib function to convert decimal degrees to deg, min, sec */
     retcode = dec2dms(lon1, &deg, &min, &sec, &nesw);
 
@@ -286,6 +306,23 @@ int main(int argc, char *argv[])
         exit(2);
     }
 
+    qrb_batch(&lon1, &lat1, &lon2, &lat2, 1, &b_dist, &b_az);
+
+    if (b_dist != distance || b_az != az)
+    {
+        fprintf(stderr, "qrb_batch() does not match qrb().\n");
+        exit(2);
+    }
+
+    qrb_home_init(&home, lon1, lat1);
+    qrb_home_batch(&home, &lon2, &lat2, 1, &b_dist, &b_az);
+
+    if (b_dist != distance || b_az != az)
+    {
+        fprintf(stderr, "qrb_home_batch() does not match qrb().\n");
+        exit(2);
+    }
+
     dec2dms(az, &deg, &min, &sec, &nesw);
     printf("\nDistance: %.6fkm\n", distance);
 